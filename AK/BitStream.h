@@ -26,7 +26,7 @@
 
 #pragma once
 
-#include <AK/Optional.h>
+#include <AK/Assertions.h>
 #include <AK/Stream.h>
 
 namespace AK {
@@ -43,14 +43,13 @@ public:
         if (has_any_error())
             return 0;
 
-        size_t nread = 0;
-        if (bytes.size() >= 1) {
-            if (m_next_byte.has_value()) {
-                bytes[0] = m_next_byte.value();
-                m_next_byte.clear();
+        // Bytes are read starting at the next byte boundary, bits left over from a partially read byte are dropped.
+        align_to_byte_boundary();
 
-                ++nread;
-            }
+        size_t nread = 0;
+        while (nread < bytes.size() && m_bit_count >= 8) {
+            bytes[nread++] = static_cast<u8>(m_bit_buffer);
+            discard_bits(8);
         }
 
         return nread + m_stream.read(bytes.slice(nread));
@@ -66,15 +65,15 @@ public:
         return true;
     }
 
-    bool unreliable_eof() const override { return !m_next_byte.has_value() && m_stream.unreliable_eof(); }
+    bool unreliable_eof() const override { return m_bit_count == 0 && m_stream.unreliable_eof(); }
 
     bool discard_or_error(size_t count) override
     {
-        if (count >= 1) {
-            if (m_next_byte.has_value()) {
-                m_next_byte.clear();
-                --count;
-            }
+        align_to_byte_boundary();
+
+        while (count > 0 && m_bit_count >= 8) {
+            discard_bits(8);
+            --count;
         }
 
         return m_stream.discard_or_error(count);
@@ -82,45 +81,142 @@ public:
 
     u32 read_bits(size_t count)
     {
-        u32 result = 0;
+        VERIFY(count <= 32);
 
-        size_t nread = 0;
-        while (nread < count) {
-            if (m_stream.has_any_error()) {
+        if (m_bit_count < count) {
+            refill();
+            if (m_bit_count < count) {
                 set_fatal_error();
                 return 0;
             }
-
-            if (m_next_byte.has_value()) {
-                const auto bit = (m_next_byte.value() >> m_bit_offset) & 1;
-                result |= bit << nread;
-                ++nread;
-
-                if (m_bit_offset++ == 7)
-                    m_next_byte.clear();
-            } else {
-                m_stream >> m_next_byte;
-                m_bit_offset = 0;
-            }
         }
 
+        const auto result = peek_bits(count);
+        discard_bits(count);
         return result;
     }
 
     bool read_bit() { return static_cast<bool>(read_bits(1)); }
 
-    void align_to_byte_boundary()
+    void align_to_byte_boundary() { discard_bits(m_bit_count % 8); }
+
+    // The following allow reading variable length codes (e.g. Huffman codes) many bits at a time: refill,
+    // peek at the buffered bits, then discard exactly as many bits as were used.
+    //
+    // Refilling reads ahead up to a whole word from the underlying stream, so once a reader is done with the
+    // bits, anything that follows them has to be read through this stream as well (see read().)
+
+    size_t buffered_bit_count() const { return m_bit_count; }
+
+    // Returns the next `count` buffered bits, bits that haven't been buffered yet read as zero.
+    u32 peek_bits(size_t count) const
+    {
+        VERIFY(count <= 32);
+        return static_cast<u32>(m_bit_buffer & ((static_cast<u64>(1) << count) - 1));
+    }
+
+    void discard_bits(size_t count)
     {
-        if (m_next_byte.has_value())
-            m_next_byte.clear();
+        VERIFY(count <= m_bit_count);
+        m_bit_buffer >>= count;
+        m_bit_count -= count;
+    }
+
+    // Fills the buffer with as many whole bytes as fit, using a single read from the underlying stream.
+    // Returns false if no bits could be added.
+    bool refill()
+    {
+        const size_t byte_count = (64 - m_bit_count) / 8;
+        if (byte_count == 0 || m_stream.has_any_error())
+            return false;
+
+        u8 bytes[8];
+        const auto nread = m_stream.read({ bytes, byte_count });
+        for (size_t i = 0; i < nread; ++i)
+            m_bit_buffer |= static_cast<u64>(bytes[i]) << (m_bit_count + i * 8);
+        m_bit_count += nread * 8;
+        return nread > 0;
     }
 
 private:
-    Optional<u8> m_next_byte;
-    size_t m_bit_offset { 0 };
+    u64 m_bit_buffer { 0 };
+    size_t m_bit_count { 0 };
     InputStream& m_stream;
 };
 
+class OutputBitStream final : public OutputStream {
+public:
+    explicit OutputBitStream(OutputStream& stream)
+        : m_stream(stream)
+    {
+    }
+
+    // Bytes are written starting at the next byte boundary, the current byte is padded with zero bits.
+    size_t write(ReadonlyBytes bytes) override
+    {
+        if (has_any_error())
+            return 0;
+
+        align_to_byte_boundary();
+        if (has_any_error())
+            return 0;
+
+        return m_stream.write(bytes);
+    }
+
+    bool write_or_error(ReadonlyBytes bytes) override
+    {
+        if (write(bytes) != bytes.size()) {
+            set_fatal_error();
+            return false;
+        }
+
+        return true;
+    }
+
+    // Bits are written starting at the least significant bit of `value`.
+    void write_bits(u32 value, size_t count)
+    {
+        VERIFY(count <= 32);
+
+        m_bit_buffer |= static_cast<u64>(value & ((static_cast<u64>(1) << count) - 1)) << m_bit_count;
+        m_bit_count += count;
+
+        if (m_bit_count >= 32)
+            flush_bytes(4);
+    }
+
+    void write_bit(bool bit) { write_bits(bit, 1); }
+
+    void align_to_byte_boundary()
+    {
+        m_bit_count = (m_bit_count + 7) / 8 * 8;
+        flush_bytes(m_bit_count / 8);
+    }
+
+    // The number of bits written into the current byte so far.
+    size_t bit_offset() const { return m_bit_count % 8; }
+
+private:
+    void flush_bytes(size_t count)
+    {
+        u8 bytes[4];
+        for (size_t i = 0; i < count; ++i)
+            bytes[i] = static_cast<u8>(m_bit_buffer >> (i * 8));
+
+        m_bit_buffer >>= count * 8;
+        m_bit_count -= count * 8;
+
+        if (!m_stream.write_or_error({ bytes, count }))
+            set_fatal_error();
+    }
+
+    u64 m_bit_buffer { 0 };
+    size_t m_bit_count { 0 };
+    OutputStream& m_stream;
+};
+
 }
 
 using AK::InputBitStream;
+using AK::OutputBitStream;
@@ -54,8 +54,9 @@ public:
     Buffered(Buffered&& other)
         : m_stream(move(other.m_stream))
     {
-        other.buffer().copy_to(buffer());
+        other.buffered_bytes().copy_to(buffer());
         m_buffered = exchange(other.m_buffered, 0);
+        other.m_offset = 0;
     }
 
     bool has_recoverable_error() const override { return m_stream.has_recoverable_error(); }
@@ -74,12 +75,17 @@ public:
         if (has_any_error())
             return 0;
 
-        auto nread = buffer().trim(m_buffered).copy_trimmed_to(bytes);
-
+        // Consume from the front of the buffer, so small reads don't have to move what's left over.
+        auto nread = buffered_bytes().copy_trimmed_to(bytes);
+        m_offset += nread;
         m_buffered -= nread;
-        buffer().slice(nread, m_buffered).copy_to(buffer());
 
         if (nread < bytes.size()) {
+            // Large reads wouldn't gain anything from a trip through the buffer.
+            if (bytes.size() - nread >= Size)
+                return nread + m_stream.read(bytes.slice(nread));
+
+            m_offset = 0;
             m_buffered = m_stream.read(buffer());
 
             if (m_buffered == 0)
@@ -108,6 +114,7 @@ public:
         if (m_buffered > 0)
             return false;
 
+        m_offset = 0;
         m_buffered = m_stream.read(buffer());
 
         return m_buffered == 0;
@@ -130,9 +137,11 @@ public:
 
 private:
     Bytes buffer() const { return { m_buffer, Size }; }
+    Bytes buffered_bytes() const { return { m_buffer + m_offset, m_buffered }; }
 
     mutable StreamType m_stream;
     mutable u8 m_buffer[Size];
+    mutable size_t m_offset { 0 };
     mutable size_t m_buffered { 0 };
 };
 
@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Assertions.h>
+#include <AK/Atomic.h>
+#include <AK/Noncopyable.h>
+#include <AK/StdLibExtras.h>
+#include <AK/Types.h>
+#include <AK/kmalloc.h>
+#include <sys/mman.h>
+
+namespace AK {
+
+// Hands out memory by bumping a pointer through large, chunk-aligned blocks, so objects that are
+// allocated together end up next to each other and allocating costs a few instructions.
+// Each chunk counts the allocations that are still alive in it, and goes back to the system as a
+// whole once they're all gone, which makes tearing down a big tree of objects cheap, too.
+// Allocations may be deallocated from any thread.
+//
+// This is trivially destructible, so that it can live in a thread_local. Call release_current_chunk()
+// before dropping one, otherwise its last chunk is never unmapped.
+class BumpAllocator {
+    AK_MAKE_NONCOPYABLE(BumpAllocator);
+    AK_MAKE_NONMOVABLE(BumpAllocator);
+
+public:
+    static constexpr size_t chunk_size = 64 * KiB;
+
+    constexpr BumpAllocator() = default;
+
+    [[nodiscard]] void* allocate(size_t size, size_t alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+    {
+        VERIFY(alignment && alignment <= chunk_size / 2 && !(alignment & (alignment - 1)));
+        if (!size)
+            size = 1;
+        FlatPtr aligned = (m_next + alignment - 1) & ~(alignment - 1);
+        if (!m_current_chunk || aligned + size > m_end) {
+            start_new_chunk(size, alignment);
+            aligned = (m_next + alignment - 1) & ~(alignment - 1);
+        }
+        m_next = aligned + size;
+        ++m_allocations_in_current_chunk;
+        // Nothing else may start past the first chunk_size bytes of an oversized chunk.
+        if (m_next > (FlatPtr)m_current_chunk + chunk_size)
+            release_current_chunk();
+        return (void*)aligned;
+    }
+
+    template<typename T, typename... Args>
+    [[nodiscard]] T* allocate_object(Args&&... args)
+    {
+        return new (allocate(sizeof(T), alignof(T))) T(forward<Args>(args)...);
+    }
+
+    static void deallocate(void* ptr)
+    {
+        if (!ptr)
+            return;
+        auto* chunk = (ChunkHeader*)((FlatPtr)ptr & ~(chunk_size - 1));
+        // Until its allocator lets go of it, a chunk's count hovers at or below zero.
+        if (chunk->live_allocations.fetch_sub(1, AK::memory_order_acq_rel) == 1)
+            unmap_chunk(chunk);
+    }
+
+    // Destroys an object made with allocate_object().
+    template<typename T>
+    static void deallocate_object(T* object)
+    {
+        if (!object)
+            return;
+        object->~T();
+        deallocate(object);
+    }
+
+    void release_current_chunk()
+    {
+        if (!m_current_chunk)
+            return;
+        auto* chunk = exchange(m_current_chunk, nullptr);
+        auto allocations = exchange(m_allocations_in_current_chunk, 0);
+        m_next = 0;
+        m_end = 0;
+        if (chunk->live_allocations.fetch_add(allocations, AK::memory_order_acq_rel) + allocations == 0)
+            unmap_chunk(chunk);
+    }
+
+    // The allocator behind AK_MAKE_BUMP_ALLOCATED. Every thread bumps through its own chunks.
+    static BumpAllocator& for_current_thread()
+    {
+        static thread_local BumpAllocator s_allocator;
+        return s_allocator;
+    }
+
+private:
+    struct ChunkHeader {
+        Atomic<size_t> live_allocations;
+        size_t mapped_size;
+    };
+
+    void start_new_chunk(size_t size, size_t alignment)
+    {
+        release_current_chunk();
+        // deallocate() finds the header by rounding down to chunk_size, so every allocation has to start
+        // in the first chunk_size bytes of its chunk. Allocations that don't fit get a bigger chunk.
+        size_t needed = sizeof(ChunkHeader) + alignment + size;
+        size_t mapped_size = (needed + chunk_size - 1) & ~(chunk_size - 1);
+        ChunkHeader* chunk = nullptr;
+        if (mapped_size == chunk_size)
+            chunk = take_cached_chunk();
+        if (!chunk)
+            chunk = (ChunkHeader*)map_chunk(mapped_size);
+        VERIFY(chunk);
+        new (chunk) ChunkHeader { 0, mapped_size };
+        m_current_chunk = chunk;
+        m_next = (FlatPtr)chunk + sizeof(ChunkHeader);
+        m_end = (FlatPtr)chunk + mapped_size;
+    }
+
+    static void* map_chunk(size_t size)
+    {
+#ifdef __serenity__
+        void* ptr = serenity_mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0, chunk_size, "BumpAllocator chunk");
+        return ptr == MAP_FAILED ? nullptr : ptr;
+#else
+        // Map a bit more than needed, and trim it down to an aligned chunk.
+        void* ptr = mmap(nullptr, size + chunk_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+        if (ptr == MAP_FAILED)
+            return nullptr;
+        FlatPtr start = (FlatPtr)ptr;
+        FlatPtr aligned_start = (start + chunk_size - 1) & ~(chunk_size - 1);
+        if (aligned_start != start)
+            munmap(ptr, aligned_start - start);
+        FlatPtr end = start + size + chunk_size;
+        if (end != aligned_start + size)
+            munmap((void*)(aligned_start + size), end - (aligned_start + size));
+        return (void*)aligned_start;
+#endif
+    }
+
+    // Keeping a few empty chunks around saves mapping (and faulting in) fresh ones whenever a tree is
+    // torn down and another one is built, e.g. when a parser runs over and over.
+    static constexpr size_t cached_chunk_count = 16;
+
+    static ChunkHeader* take_cached_chunk()
+    {
+        for (auto& slot : s_cached_chunks) {
+            if (auto* chunk = slot.exchange(nullptr, AK::memory_order_acquire))
+                return chunk;
+        }
+        return nullptr;
+    }
+
+    static void unmap_chunk(ChunkHeader* chunk)
+    {
+        if (chunk->mapped_size == chunk_size) {
+            for (auto& slot : s_cached_chunks) {
+                ChunkHeader* expected = nullptr;
+                if (slot.compare_exchange_strong(expected, chunk, AK::memory_order_release))
+                    return;
+            }
+        }
+        munmap(chunk, chunk->mapped_size);
+    }
+
+    inline static Atomic<ChunkHeader*> s_cached_chunks[cached_chunk_count];
+
+    ChunkHeader* m_current_chunk { nullptr };
+    FlatPtr m_next { 0 };
+    FlatPtr m_end { 0 };
+    size_t m_allocations_in_current_chunk { 0 };
+};
+
+}
+
+// Makes `new` allocate the class (and everything derived from it) from the current thread's
+// BumpAllocator. `delete` still runs destructors as usual, and only gives the memory back
+// once the rest of its chunk is gone as well.
+#define AK_MAKE_BUMP_ALLOCATED(c)                                                       \
+public:                                                                                 \
+    [[nodiscard]] void* operator new(size_t size)                                       \
+    {                                                                                   \
+        return AK::BumpAllocator::for_current_thread().allocate(size);                  \
+    }                                                                                   \
+    void operator delete(void* ptr) { AK::BumpAllocator::deallocate(ptr); }             \
+                                                                                        \
+private:
+
+using AK::BumpAllocator;
@@ -31,8 +31,6 @@
 
 namespace AK {
 
-// FIXME: There are a lot of raw loops here, that's not necessary an issue but it
-//        has to be verified that the optimizer is able to insert memcpy instead.
 template<size_t Capacity>
 class CircularDuplexStream : public AK::DuplexStream {
 public:
@@ -40,10 +38,13 @@ public:
     {
         const auto nwritten = min(bytes.size(), Capacity - m_queue.size());
 
-        for (size_t idx = 0; idx < nwritten; ++idx)
-            m_queue.enqueue(bytes[idx]);
+        size_t offset = 0;
+        while (offset < nwritten) {
+            const auto chunk_size = min(nwritten - offset, remaining_contigous_space());
+            bytes.slice(offset, chunk_size).copy_to(reserve_contigous_space(chunk_size));
+            offset += chunk_size;
+        }
 
-        m_total_written += nwritten;
         return nwritten;
     }
 
@@ -66,8 +67,13 @@ public:
 
         const auto nread = min(bytes.size(), m_queue.size());
 
-        for (size_t idx = 0; idx < nread; ++idx)
-            bytes[idx] = m_queue.dequeue();
+        size_t offset = 0;
+        while (offset < nread) {
+            const auto chunk_size = min(nread - offset, Capacity - m_queue.m_head);
+            __builtin_memcpy(bytes.offset(offset), m_queue.m_storage + m_queue.m_head, chunk_size);
+            dequeue_without_copying(chunk_size);
+            offset += chunk_size;
+        }
 
         return nread;
     }
@@ -81,9 +87,12 @@ public:
 
         const auto nread = min(bytes.size(), seekback);
 
-        for (size_t idx = 0; idx < nread; ++idx) {
-            const auto index = (m_total_written - seekback + idx) % Capacity;
-            bytes[idx] = m_queue.m_storage[index];
+        size_t offset = 0;
+        while (offset < nread) {
+            const auto index = (m_total_written - seekback + offset) % Capacity;
+            const auto chunk_size = min(nread - offset, Capacity - index);
+            __builtin_memcpy(bytes.offset(offset), m_queue.m_storage + index, chunk_size);
+            offset += chunk_size;
         }
 
         return nread;
@@ -107,9 +116,7 @@ public:
             return false;
         }
 
-        for (size_t idx = 0; idx < count; ++idx)
-            m_queue.dequeue();
-
+        dequeue_without_copying(count);
         return true;
     }
 
@@ -134,6 +141,12 @@ public:
     }
 
 private:
+    void dequeue_without_copying(size_t count)
+    {
+        m_queue.m_head = (m_queue.m_head + count) % Capacity;
+        m_queue.m_size -= count;
+    }
+
     CircularQueue<u8, Capacity> m_queue;
     size_t m_total_written { 0 };
 };
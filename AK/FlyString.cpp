@@ -24,9 +24,12 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Array.h>
+#include <AK/Atomic.h>
 #include <AK/FlyString.h>
 #include <AK/HashTable.h>
 #include <AK/Optional.h>
+#include <AK/Platform.h>
 #include <AK/Singleton.h>
 #include <AK/String.h>
 #include <AK/StringUtils.h>
@@ -44,16 +47,47 @@ struct FlyStringImplTraits : public Traits<StringImpl*> {
     }
 };
 
-static AK::Singleton<HashTable<StringImpl*, FlyStringImplTraits>> s_table;
+// The intern table is split into shards by hash, each with its own lock, so that threads
+// interning different strings rarely wait for each other. The locks are only ever held
+// for a single hash table operation, so spinning is cheaper than going to sleep.
+class FlyStringTableShard {
+public:
+    void lock()
+    {
+        while (m_locked.exchange(true, AK::memory_order_acquire)) {
+            while (m_locked.load(AK::memory_order_relaxed)) {
+#if ARCH(I386) || ARCH(X86_64)
+                __builtin_ia32_pause();
+#endif
+            }
+        }
+    }
+    void unlock() { m_locked.store(false, AK::memory_order_release); }
+
+    HashTable<StringImpl*, FlyStringImplTraits> impls;
+
+private:
+    Atomic<bool> m_locked { false };
+};
 
-static HashTable<StringImpl*, FlyStringImplTraits>& fly_impls()
+static constexpr size_t fly_string_table_shard_count = 16;
+static AK::Singleton<Array<FlyStringTableShard, fly_string_table_shard_count>> s_table;
+
+static FlyStringTableShard& shard_for_hash(unsigned hash)
 {
-    return *s_table;
+    // The low bits pick the bucket within the shard, so use the high ones here.
+    return (*s_table)[hash >> 28];
 }
 
 void FlyString::did_destroy_impl(Badge<StringImpl>, StringImpl& impl)
 {
-    fly_impls().remove(&impl);
+    auto& shard = shard_for_hash(impl.hash());
+    shard.lock();
+    // Another thread may have replaced us with an equal impl while we were dying.
+    auto it = shard.impls.find(&impl);
+    if (it != shard.impls.end() && *it == &impl)
+        shard.impls.remove(it);
+    shard.unlock();
 }
 
 FlyString::FlyString(const String& string)
@@ -64,15 +98,23 @@ FlyString::FlyString(const String& string)
         m_impl = string.impl();
         return;
     }
-    auto it = fly_impls().find(const_cast<StringImpl*>(string.impl()));
-    if (it == fly_impls().end()) {
-        fly_impls().set(const_cast<StringImpl*>(string.impl()));
-        string.impl()->set_fly({}, true);
-        m_impl = string.impl();
-    } else {
+
+    auto* impl = const_cast<StringImpl*>(string.impl());
+    // Computed (and cached in the impl) before taking the lock.
+    auto& shard = shard_for_hash(impl->hash());
+    shard.lock();
+    auto it = shard.impls.find(impl);
+    // An impl whose last reference is already gone is about to remove itself from the table,
+    // so it can't be handed out anymore; ours takes its place.
+    if (it != shard.impls.end() && (*it)->try_ref()) {
         VERIFY((*it)->is_fly());
-        m_impl = *it;
+        m_impl = adopt(**it);
+    } else {
+        shard.impls.set(impl);
+        impl->set_fly({}, true);
+        m_impl = impl;
     }
+    shard.unlock();
 }
 
 FlyString::FlyString(const StringView& string)
@@ -45,54 +45,301 @@ constexpr size_t use_next_index = NumericLimits<size_t>::max();
 
 // The worst case is that we have the largest 64-bit value formatted as binary number, this would take
 // 65 bytes. Choosing a larger power of two won't hurt and is a bit of mitigation against out-of-bounds accesses.
-inline size_t convert_unsigned_to_string(u64 value, Array<u8, 128>& buffer, u8 base, bool upper_case)
+// The digits are written to the end of the buffer, and a view of them is returned.
+inline StringView convert_unsigned_to_string(u64 value, Array<u8, 128>& buffer, u8 base, bool upper_case)
 {
     VERIFY(base >= 2 && base <= 16);
 
     static constexpr const char* lowercase_lookup = "0123456789abcdef";
     static constexpr const char* uppercase_lookup = "0123456789ABCDEF";
-
-    if (value == 0) {
-        buffer[0] = '0';
-        return 1;
+    const char* lookup = upper_case ? uppercase_lookup : lowercase_lookup;
+
+    char* end = reinterpret_cast<char*>(buffer.data()) + buffer.size();
+    char* begin = end;
+
+    if (base == 10) {
+        begin = Detail::write_decimal_digits_backwards(value, end);
+    } else if ((base & (base - 1)) == 0) {
+        const auto shift = __builtin_ctz(base);
+        do {
+            *--begin = lookup[value & (base - 1)];
+            value >>= shift;
+        } while (value > 0);
+    } else {
+        do {
+            *--begin = lookup[value % base];
+            value /= base;
+        } while (value > 0);
     }
 
-    size_t used = 0;
-    while (value > 0) {
-        if (upper_case)
-            buffer[used++] = uppercase_lookup[value % base];
-        else
-            buffer[used++] = lowercase_lookup[value % base];
+    return { begin, static_cast<size_t>(end - begin) };
+}
 
-        value /= base;
-    }
+#ifndef KERNEL
+// Shortest round-trip conversion of doubles, using the Grisu2 algorithm from Florian Loitsch,
+// "Printing Floating-Point Numbers Quickly and Accurately with Integers" (PLDI 2010).
+// The digits always read back as the same double; in rare cases there is a shorter string that would too.
 
-    for (size_t i = 0; i < used / 2; ++i)
-        swap(buffer[i], buffer[used - i - 1]);
+struct DiyFp {
+    u64 f;
+    int e;
+};
 
-    return used;
+DiyFp diyfp_multiply(DiyFp x, DiyFp y)
+{
+    // The upper 64 bits of the 128-bit product, rounded.
+    const u64 a = x.f >> 32;
+    const u64 b = x.f & 0xffffffff;
+    const u64 c = y.f >> 32;
+    const u64 d = y.f & 0xffffffff;
+    const u64 middle = ((b * d) >> 32) + ((a * d) & 0xffffffff) + ((b * c) & 0xffffffff) + (1u << 31);
+    return { a * c + ((a * d) >> 32) + ((b * c) >> 32) + (middle >> 32), x.e + y.e + 64 };
 }
 
-void vformat_impl(TypeErasedFormatParams& params, FormatBuilder& builder, FormatParser& parser)
+DiyFp diyfp_normalize(DiyFp x)
 {
-    const auto literal = parser.consume_literal();
-    builder.put_literal(literal);
+    const auto shift = __builtin_clzll(x.f);
+    return { x.f << shift, x.e - shift };
+}
 
-    FormatParser::FormatSpecifier specifier;
-    if (!parser.consume_specifier(specifier)) {
-        VERIFY(parser.is_eof());
-        return;
+struct Boundaries {
+    DiyFp value;
+    DiyFp minus;
+    DiyFp plus;
+};
+
+// Returns the value and the midpoints to its neighbours, all normalized to the same exponent.
+Boundaries compute_boundaries(double value)
+{
+    constexpr int significand_bits = 52;
+    constexpr int exponent_bias = 1023 + significand_bits;
+    constexpr u64 hidden_bit = 1ull << significand_bits;
+
+    u64 bits;
+    __builtin_memcpy(&bits, &value, sizeof(bits));
+    const u64 fraction = bits & (hidden_bit - 1);
+    const int biased_exponent = (bits >> significand_bits) & 0x7ff;
+
+    const DiyFp v = biased_exponent == 0
+        ? DiyFp { fraction, 1 - exponent_bias }
+        : DiyFp { fraction + hidden_bit, biased_exponent - exponent_bias };
+
+    // For powers of two the next lower double is only half as far away as the next higher one.
+    const bool lower_boundary_is_closer = fraction == 0 && biased_exponent > 1;
+    const DiyFp plus = diyfp_normalize({ 2 * v.f + 1, v.e - 1 });
+    const DiyFp minus = lower_boundary_is_closer ? DiyFp { 4 * v.f - 1, v.e - 2 } : DiyFp { 2 * v.f - 1, v.e - 1 };
+
+    return { diyfp_normalize(v), { minus.f << (minus.e - plus.e), plus.e }, plus };
+}
+
+struct CachedPower {
+    u64 f;
+    int e;
+    int k;
+};
+
+// Normalized approximations of 10^k for every 8th k from -300 to 324, correctly rounded.
+constexpr CachedPower cached_powers[] = {
+    { 0xAB70FE17C79AC6CA, -1060, -300 },
+    { 0xFF77B1FCBEBCDC4F, -1034, -292 },
+    { 0xBE5691EF416BD60C, -1007, -284 },
+    { 0x8DD01FAD907FFC3C, -980, -276 },
+    { 0xD3515C2831559A83, -954, -268 },
+    { 0x9D71AC8FADA6C9B5, -927, -260 },
+    { 0xEA9C227723EE8BCB, -901, -252 },
+    { 0xAECC49914078536D, -874, -244 },
+    { 0x823C12795DB6CE57, -847, -236 },
+    { 0xC21094364DFB5637, -821, -228 },
+    { 0x9096EA6F3848984F, -794, -220 },
+    { 0xD77485CB25823AC7, -768, -212 },
+    { 0xA086CFCD97BF97F4, -741, -204 },
+    { 0xEF340A98172AACE5, -715, -196 },
+    { 0xB23867FB2A35B28E, -688, -188 },
+    { 0x84C8D4DFD2C63F3B, -661, -180 },
+    { 0xC5DD44271AD3CDBA, -635, -172 },
+    { 0x936B9FCEBB25C996, -608, -164 },
+    { 0xDBAC6C247D62A584, -582, -156 },
+    { 0xA3AB66580D5FDAF6, -555, -148 },
+    { 0xF3E2F893DEC3F126, -529, -140 },
+    { 0xB5B5ADA8AAFF80B8, -502, -132 },
+    { 0x87625F056C7C4A8B, -475, -124 },
+    { 0xC9BCFF6034C13053, -449, -116 },
+    { 0x964E858C91BA2655, -422, -108 },
+    { 0xDFF9772470297EBD, -396, -100 },
+    { 0xA6DFBD9FB8E5B88F, -369, -92 },
+    { 0xF8A95FCF88747D94, -343, -84 },
+    { 0xB94470938FA89BCF, -316, -76 },
+    { 0x8A08F0F8BF0F156B, -289, -68 },
+    { 0xCDB02555653131B6, -263, -60 },
+    { 0x993FE2C6D07B7FAC, -236, -52 },
+    { 0xE45C10C42A2B3B06, -210, -44 },
+    { 0xAA242499697392D3, -183, -36 },
+    { 0xFD87B5F28300CA0E, -157, -28 },
+    { 0xBCE5086492111AEB, -130, -20 },
+    { 0x8CBCCC096F5088CC, -103, -12 },
+    { 0xD1B71758E219652C, -77, -4 },
+    { 0x9C40000000000000, -50, 4 },
+    { 0xE8D4A51000000000, -24, 12 },
+    { 0xAD78EBC5AC620000, 3, 20 },
+    { 0x813F3978F8940984, 30, 28 },
+    { 0xC097CE7BC90715B3, 56, 36 },
+    { 0x8F7E32CE7BEA5C70, 83, 44 },
+    { 0xD5D238A4ABE98068, 109, 52 },
+    { 0x9F4F2726179A2245, 136, 60 },
+    { 0xED63A231D4C4FB27, 162, 68 },
+    { 0xB0DE65388CC8ADA8, 189, 76 },
+    { 0x83C7088E1AAB65DB, 216, 84 },
+    { 0xC45D1DF942711D9A, 242, 92 },
+    { 0x924D692CA61BE758, 269, 100 },
+    { 0xDA01EE641A708DEA, 295, 108 },
+    { 0xA26DA3999AEF774A, 322, 116 },
+    { 0xF209787BB47D6B85, 348, 124 },
+    { 0xB454E4A179DD1877, 375, 132 },
+    { 0x865B86925B9BC5C2, 402, 140 },
+    { 0xC83553C5C8965D3D, 428, 148 },
+    { 0x952AB45CFA97A0B3, 455, 156 },
+    { 0xDE469FBD99A05FE3, 481, 164 },
+    { 0xA59BC234DB398C25, 508, 172 },
+    { 0xF6C69A72A3989F5C, 534, 180 },
+    { 0xB7DCBF5354E9BECE, 561, 188 },
+    { 0x88FCF317F22241E2, 588, 196 },
+    { 0xCC20CE9BD35C78A5, 614, 204 },
+    { 0x98165AF37B2153DF, 641, 212 },
+    { 0xE2A0B5DC971F303A, 667, 220 },
+    { 0xA8D9D1535CE3B396, 694, 228 },
+    { 0xFB9B7CD9A4A7443C, 720, 236 },
+    { 0xBB764C4CA7A44410, 747, 244 },
+    { 0x8BAB8EEFB6409C1A, 774, 252 },
+    { 0xD01FEF10A657842C, 800, 260 },
+    { 0x9B10A4E5E9913129, 827, 268 },
+    { 0xE7109BFBA19C0C9D, 853, 276 },
+    { 0xAC2820D9623BF429, 880, 284 },
+    { 0x80444B5E7AA7CF85, 907, 292 },
+    { 0xBF21E44003ACDD2D, 933, 300 },
+    { 0x8E679C2F5E44FF8F, 960, 308 },
+    { 0xD433179D9C8CB841, 986, 316 },
+    { 0x9E19DB92B4E31BA9, 1013, 324 },
+};
+constexpr int cached_powers_min_decimal_exponent = -300;
+constexpr int cached_powers_decimal_exponent_step = 8;
+
+// The products with the cached power are scaled so that their binary exponent lands in this range,
+// which lets digit generation work on 32-bit integer and 64-bit fractional parts.
+constexpr int min_target_exponent = -60;
+constexpr int max_target_exponent = -32;
+
+CachedPower cached_power_for_binary_exponent(int e)
+{
+    const int f = min_target_exponent - e - 1;
+    // ceil(f * log10(2))
+    const int k = (f * 78913) / (1 << 18) + (f > 0);
+    const int index = (-cached_powers_min_decimal_exponent + k + (cached_powers_decimal_exponent_step - 1)) / cached_powers_decimal_exponent_step;
+    VERIFY(index >= 0 && static_cast<size_t>(index) < array_size(cached_powers));
+
+    const auto cached = cached_powers[index];
+    VERIFY(min_target_exponent <= cached.e + e + 64 && cached.e + e + 64 <= max_target_exponent);
+    return cached;
+}
+
+int find_largest_power_of_ten(u32 n, u32& power_of_ten)
+{
+    power_of_ten = 1;
+    int digits = 1;
+    while (digits < 10 && n / power_of_ten >= 10) {
+        power_of_ten *= 10;
+        ++digits;
+    }
+    return digits;
+}
+
+// Moves the last digit closer to the exact value while it stays within the rounding interval.
+void grisu2_round(char* digits, int length, u64 distance, u64 delta, u64 rest, u64 ten_k)
+{
+    while (rest < distance && delta - rest >= ten_k
+        && (rest + ten_k < distance || distance - rest > rest + ten_k - distance)) {
+        --digits[length - 1];
+        rest += ten_k;
+    }
+}
+
+void grisu2_generate_digits(char* digits, int& length, int& decimal_exponent, DiyFp low, DiyFp value, DiyFp high)
+{
+    u64 delta = high.f - low.f;
+    u64 distance = high.f - value.f;
+
+    const DiyFp one { 1ull << -high.e, high.e };
+    u32 integral = static_cast<u32>(high.f >> -one.e);
+    u64 fractional = high.f & (one.f - 1);
+
+    u32 power_of_ten;
+    int remaining = find_largest_power_of_ten(integral, power_of_ten);
+    while (remaining > 0) {
+        digits[length++] = '0' + integral / power_of_ten;
+        integral %= power_of_ten;
+        --remaining;
+
+        const u64 rest = (static_cast<u64>(integral) << -one.e) + fractional;
+        if (rest <= delta) {
+            decimal_exponent += remaining;
+            grisu2_round(digits, length, distance, delta, rest, static_cast<u64>(power_of_ten) << -one.e);
+            return;
+        }
+        power_of_ten /= 10;
     }
 
-    if (specifier.index == use_next_index)
-        specifier.index = params.take_next_index();
+    int fractional_digits = 0;
+    for (;;) {
+        fractional *= 10;
+        digits[length++] = '0' + static_cast<char>(fractional >> -one.e);
+        fractional &= one.f - 1;
+        ++fractional_digits;
+        delta *= 10;
+        distance *= 10;
+        if (fractional <= delta)
+            break;
+    }
+    decimal_exponent -= fractional_digits;
+    grisu2_round(digits, length, distance, delta, fractional, one.f);
+}
+
+// Writes up to 17 digits such that `value` == digits * 10^decimal_exponent once read back.
+void grisu2(double value, char* digits, int& length, int& decimal_exponent)
+{
+    const auto boundaries = compute_boundaries(value);
+    const auto cached = cached_power_for_binary_exponent(boundaries.plus.e);
+    const DiyFp power { cached.f, cached.e };
+
+    const auto scaled_value = diyfp_multiply(boundaries.value, power);
+    const auto scaled_minus = diyfp_multiply(boundaries.minus, power);
+    const auto scaled_plus = diyfp_multiply(boundaries.plus, power);
+
+    // The products may be off by one unit, so narrow the interval to stay on the safe side.
+    length = 0;
+    decimal_exponent = -cached.k;
+    grisu2_generate_digits(digits, length, decimal_exponent, { scaled_minus.f + 1, scaled_minus.e }, scaled_value, { scaled_plus.f - 1, scaled_plus.e });
+}
+#endif
+
+void vformat_impl(TypeErasedFormatParams& params, FormatBuilder& builder, FormatParser& parser)
+{
+    for (;;) {
+        const auto literal = parser.consume_literal();
+        builder.put_literal(literal);
+
+        FormatParser::FormatSpecifier specifier;
+        if (!parser.consume_specifier(specifier)) {
+            VERIFY(parser.is_eof());
+            return;
+        }
 
-    auto& parameter = params.parameters().at(specifier.index);
+        if (specifier.index == use_next_index)
+            specifier.index = params.take_next_index();
 
-    FormatParser argparser { specifier.flags };
-    parameter.formatter(params, builder, argparser, parameter.value);
+        auto& parameter = params.parameters().at(specifier.index);
 
-    vformat_impl(params, builder, parser);
+        FormatParser argparser { specifier.flags };
+        parameter.formatter(params, builder, argparser, parameter.value);
+    }
 }
 
 } // namespace AK::{anonymous}
@@ -134,19 +381,16 @@ StringView FormatParser::consume_literal()
     const auto begin = tell();
 
     while (!is_eof()) {
-        if (consume_specific("{{"))
-            continue;
-
-        if (consume_specific("}}"))
-            continue;
-
-        if (next_is(is_any_of("{}")))
-            return m_input.substring_view(begin, tell() - begin);
-
-        consume();
+        const char ch = m_input[m_index];
+        if (ch == '{' || ch == '}') {
+            if (peek(1) != ch)
+                break;
+            ++m_index;
+        }
+        ++m_index;
     }
 
-    return m_input.substring_view(begin);
+    return m_input.substring_view(begin, tell() - begin);
 }
 bool FormatParser::consume_number(size_t& value)
 {
@@ -222,11 +466,16 @@ void FormatBuilder::put_padding(char fill, size_t amount)
 }
 void FormatBuilder::put_literal(StringView value)
 {
+    // Braces are escaped by doubling them, so append up to and including the first of each pair and skip the second.
+    size_t run_start = 0;
     for (size_t i = 0; i < value.length(); ++i) {
-        m_builder.append(value[i]);
-        if (value[i] == '{' || value[i] == '}')
-            ++i;
+        if (value[i] == '{' || value[i] == '}') {
+            m_builder.append(value.substring_view(run_start, i + 1 - run_start));
+            run_start = ++i + 1;
+        }
     }
+    if (run_start < value.length())
+        m_builder.append(value.substring_view(run_start));
 }
 void FormatBuilder::put_string(
     StringView value,
@@ -273,7 +522,8 @@ void FormatBuilder::put_u64(
 
     Array<u8, 128> buffer;
 
-    const auto used_by_digits = convert_unsigned_to_string(value, buffer, base, upper_case);
+    const auto digits = convert_unsigned_to_string(value, buffer, base, upper_case);
+    const auto used_by_digits = digits.length();
 
     size_t used_by_prefix = 0;
     if (align == Align::Right && zero_pad) {
@@ -322,8 +572,7 @@ void FormatBuilder::put_u64(
         }
     };
     const auto put_digits = [&]() {
-        for (size_t i = 0; i < used_by_digits; ++i)
-            m_builder.append(buffer[i]);
+        m_builder.append(digits);
     };
 
     if (align == Align::Left) {
@@ -366,9 +615,9 @@ void FormatBuilder::put_i64(
     SignMode sign_mode)
 {
     const auto is_negative = value < 0;
-    value = is_negative ? -value : value;
+    const u64 magnitude = is_negative ? 0 - static_cast<u64>(value) : static_cast<u64>(value);
 
-    put_u64(static_cast<u64>(value), base, prefix, upper_case, zero_pad, align, min_width, fill, sign_mode, is_negative);
+    put_u64(magnitude, base, prefix, upper_case, zero_pad, align, min_width, fill, sign_mode, is_negative);
 }
 
 #ifndef KERNEL
@@ -407,6 +656,82 @@ void FormatBuilder::put_f64(
 
     put_string(string_builder.string_view(), align, min_width, NumericLimits<size_t>::max(), fill);
 }
+
+void FormatBuilder::put_f64_shortest(
+    double value,
+    Align align,
+    size_t min_width,
+    char fill,
+    SignMode sign_mode)
+{
+    char buffer[32];
+    size_t used = 0;
+    const auto put = [&](char ch) { buffer[used++] = ch; };
+    const auto put_digits = [&](const char* digits, int count) {
+        for (int i = 0; i < count; ++i)
+            put(digits[i]);
+    };
+    const auto put_zeroes = [&](int count) {
+        for (int i = 0; i < count; ++i)
+            put('0');
+    };
+
+    if (__builtin_signbit(value)) {
+        put('-');
+        value = -value;
+    } else if (sign_mode == SignMode::Always) {
+        put('+');
+    } else if (sign_mode == SignMode::Reserved) {
+        put(' ');
+    }
+
+    if (__builtin_isnan(value)) {
+        put_digits("nan", 3);
+    } else if (__builtin_isinf(value)) {
+        put_digits("inf", 3);
+    } else if (value == 0) {
+        put_digits("0.0", 3);
+    } else {
+        char digits[17];
+        int length;
+        int decimal_exponent;
+        grisu2(value, digits, length, decimal_exponent);
+
+        // Like JavaScript and Python, use fixed notation for moderately sized values and scientific
+        // notation otherwise. A ".0" is kept on integral values so they still read back as floating point.
+        const int decimal_point = length + decimal_exponent;
+        if (decimal_point > -4 && decimal_point <= 16) {
+            if (decimal_point <= 0) {
+                put_digits("0.", 2);
+                put_zeroes(-decimal_point);
+                put_digits(digits, length);
+            } else if (decimal_point >= length) {
+                put_digits(digits, length);
+                put_zeroes(decimal_point - length);
+                put_digits(".0", 2);
+            } else {
+                put_digits(digits, decimal_point);
+                put('.');
+                put_digits(digits + decimal_point, length - decimal_point);
+            }
+        } else {
+            put(digits[0]);
+            if (length > 1) {
+                put('.');
+                put_digits(digits + 1, length - 1);
+            }
+            const int exponent = decimal_point - 1;
+            put('e');
+            put(exponent < 0 ? '-' : '+');
+            char exponent_buffer[4];
+            char* exponent_end = exponent_buffer + sizeof(exponent_buffer);
+            char* exponent_begin = Detail::write_decimal_digits_backwards(static_cast<u32>(exponent < 0 ? -exponent : exponent), exponent_end);
+            put_digits(exponent_begin, exponent_end - exponent_begin);
+        }
+    }
+
+    put_string({ buffer, used }, align, min_width, NumericLimits<size_t>::max(), fill);
+}
 #endif
 
 void vformat(StringBuilder& builder, StringView fmtstr, TypeErasedFormatParams params)
@@ -425,6 +750,10 @@ void vformat(const LogStream& stream, StringView fmtstr, TypeErasedFormatParams
 
 void StandardFormatter::parse(TypeErasedFormatParams& params, FormatParser& parser)
 {
+    // Most replacement fields are a plain "{}".
+    if (parser.is_eof())
+        return;
+
     if (StringView { "<^>" }.contains(parser.peek(1))) {
         VERIFY(!parser.next_is(is_any_of("{}")));
         m_fill = parser.consume();
@@ -490,6 +819,8 @@ void StandardFormatter::parse(TypeErasedFormatParams& params, FormatParser& pars
         m_mode = Mode::Pointer;
     else if (parser.consume_specific('f'))
         m_mode = Mode::Float;
+    else if (parser.consume_specific('g'))
+        m_mode = Mode::GeneralFloat;
     else if (parser.consume_specific('a'))
         m_mode = Mode::Hexfloat;
     else if (parser.consume_specific('A'))
@@ -611,7 +942,12 @@ void Formatter<double>::format(FormatBuilder& builder, double value)
 {
     u8 base;
     bool upper_case;
-    if (m_mode == Mode::Default || m_mode == Mode::Float) {
+    if (m_mode == Mode::GeneralFloat && !m_precision.has_value()) {
+        builder.put_f64_shortest(value, m_align, m_width.value_or(0), m_fill, m_sign_mode);
+        return;
+    }
+
+    if (m_mode == Mode::Default || m_mode == Mode::Float || m_mode == Mode::GeneralFloat) {
         base = 10;
         upper_case = false;
     } else if (m_mode == Mode::Hexfloat) {
@@ -108,6 +108,45 @@ struct TypeErasedParameter {
     void (*formatter)(TypeErasedFormatParams&, FormatBuilder&, FormatParser&, const void* value);
 };
 
+namespace Detail {
+
+// "00", "01", ..., "99" back to back, so decimal numbers can be converted two digits per division.
+inline constexpr char two_digit_lookup[] = "00010203040506070809101112131415161718192021222324252627282930313233343536373839404142434445464748495051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+
+// Writes the decimal digits of `value` so that they end right before `end`, and returns where they start.
+template<typename T>
+ALWAYS_INLINE char* write_decimal_digits_backwards(T value, char* end)
+{
+    static_assert(IsUnsigned<T>::value);
+    if constexpr (sizeof(T) > sizeof(u32)) {
+        // 64-bit division is a libgcc call on 32-bit targets, so only use it until the rest fits in 32 bits.
+        while (value > NumericLimits<u32>::max()) {
+            auto pair = static_cast<u32>(value % 100) * 2;
+            value /= 100;
+            *--end = two_digit_lookup[pair + 1];
+            *--end = two_digit_lookup[pair];
+        }
+        return write_decimal_digits_backwards(static_cast<u32>(value), end);
+    } else {
+        u32 remaining = value;
+        while (remaining >= 100) {
+            auto pair = (remaining % 100) * 2;
+            remaining /= 100;
+            *--end = two_digit_lookup[pair + 1];
+            *--end = two_digit_lookup[pair];
+        }
+        if (remaining >= 10) {
+            *--end = two_digit_lookup[remaining * 2 + 1];
+            *--end = two_digit_lookup[remaining * 2];
+        } else {
+            *--end = '0' + remaining;
+        }
+        return end;
+    }
+}
+
+}
+
 class FormatParser : public GenericLexer {
 public:
     struct FormatSpecifier {
@@ -187,6 +226,14 @@ public:
         size_t precision = 6,
         char fill = ' ',
         SignMode sign_mode = SignMode::OnlyIfNeeded);
+
+    // Puts the shortest decimal representation that reads back as exactly `value`.
+    void put_f64_shortest(
+        double value,
+        Align align = Align::Right,
+        size_t min_width = 0,
+        char fill = ' ',
+        SignMode sign_mode = SignMode::OnlyIfNeeded);
 #endif
 
     const StringBuilder& builder() const
@@ -252,6 +299,7 @@ struct StandardFormatter {
         String,
         Pointer,
         Float,
+        GeneralFloat,
         Hexfloat,
         HexfloatUppercase,
     };
@@ -52,6 +52,7 @@ class InputMemoryStream;
 class DuplexMemoryStream;
 class OutputStream;
 class InputBitStream;
+class OutputBitStream;
 class OutputMemoryStream;
 
 template<size_t Capacity>
@@ -151,6 +152,7 @@ using AK::HashMap;
 using AK::HashTable;
 using AK::InlineLinkedList;
 using AK::InputBitStream;
+using AK::OutputBitStream;
 using AK::InputMemoryStream;
 using AK::InputStream;
 using AK::IPv4Address;
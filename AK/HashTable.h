@@ -39,6 +39,49 @@ enum class HashSetResult {
     ReplacedExistingEntry
 };
 
+// The table is laid out like Abseil's SwissTable: next to the slots there is an array with one
+// control byte per slot, which is either one of the values below, or (for a used slot) the low
+// 7 bits of the hash of what's in it. Lookups scan the control bytes eight at a time, and only
+// look at slots whose control byte matches.
+namespace HashTableControl {
+
+static constexpr u8 Empty = 0x80;
+static constexpr u8 Deleted = 0xfe;
+// Marks the end of the table, so that iterators know where to stop.
+static constexpr u8 Sentinel = 0xff;
+
+inline bool is_used(u8 control) { return !(control & 0x80); }
+
+// A group of control bytes, loaded into one word so that it can be searched with
+// bit tricks rather than SIMD instructions, which we can't use in the kernel.
+class Group {
+public:
+    static constexpr size_t width = 8;
+
+    explicit Group(const u8* control) { __builtin_memcpy(&m_bytes, control, sizeof(m_bytes)); }
+
+    // Each of these returns a mask with the high bit set in every matching byte. match()
+    // may rarely report a byte right after a real match as matching too, which is harmless
+    // since callers compare the actual values anyway.
+    u64 match(u8 hash_bits) const
+    {
+        u64 x = m_bytes ^ (lsbs * hash_bits);
+        return (x - lsbs) & ~x & msbs;
+    }
+    u64 match_empty() const { return m_bytes & (~m_bytes << 6) & msbs; }
+    u64 match_empty_or_deleted() const { return m_bytes & (~m_bytes << 7) & msbs; }
+
+    static size_t first_index(u64 mask) { return __builtin_ctzll(mask) / 8; }
+    static size_t leading_index(u64 mask) { return __builtin_clzll(mask) / 8; }
+
+private:
+    static constexpr u64 lsbs = 0x0101010101010101ull;
+    static constexpr u64 msbs = 0x8080808080808080ull;
+    u64 m_bytes;
+};
+
+}
+
 template<typename HashTableType, typename T, typename BucketType>
 class HashTableIterator {
     friend HashTableType;
@@ -48,38 +91,48 @@ public:
     bool operator!=(const HashTableIterator& other) const { return m_bucket != other.m_bucket; }
     T& operator*() { return *m_bucket->slot(); }
     T* operator->() { return m_bucket->slot(); }
-    void operator++() { skip_to_next(); }
+    void operator++()
+    {
+        ++m_control;
+        ++m_bucket;
+        skip_to_used();
+    }
 
 private:
-    void skip_to_next()
+    void skip_to_used()
     {
         if (!m_bucket)
             return;
-        do {
-            ++m_bucket;
-            if (m_bucket->used)
+        while (!HashTableControl::is_used(*m_control)) {
+            if (*m_control == HashTableControl::Sentinel) {
+                m_bucket = nullptr;
                 return;
-        } while (!m_bucket->end);
-        if (m_bucket->end)
-            m_bucket = nullptr;
+            }
+            ++m_control;
+            ++m_bucket;
+        }
     }
 
-    explicit HashTableIterator(BucketType* bucket)
-        : m_bucket(bucket)
+    HashTableIterator(const u8* control, BucketType* bucket)
+        : m_control(control)
+        , m_bucket(bucket)
     {
+        skip_to_used();
     }
 
+    const u8* m_control { nullptr };
     BucketType* m_bucket { nullptr };
 };
 
 template<typename T, typename TraitsForT>
 class HashTable {
-    static constexpr size_t load_factor_in_percent = 60;
+    using Group = HashTableControl::Group;
+
+    // We grow once more than 7/8 of the slots are used or deleted.
+    static constexpr size_t max_load_numerator = 7;
+    static constexpr size_t max_load_denominator = 8;
 
     struct Bucket {
-        bool used;
-        bool deleted;
-        bool end;
         alignas(T) u8 storage[sizeof(T)];
 
         T* slot() { return reinterpret_cast<T*>(storage); }
@@ -88,7 +141,7 @@ class HashTable {
 
 public:
     HashTable() = default;
-    HashTable(size_t capacity) { rehash(capacity); }
+    HashTable(size_t capacity) { rehash(capacity_for(capacity)); }
 
     ~HashTable()
     {
@@ -96,7 +149,7 @@ public:
             return;
 
         for (size_t i = 0; i < m_capacity; ++i) {
-            if (m_buckets[i].used)
+            if (HashTableControl::is_used(m_control[i]))
                 m_buckets[i].slot()->~T();
         }
 
@@ -119,6 +172,7 @@ public:
 
     HashTable(HashTable&& other) noexcept
         : m_buckets(other.m_buckets)
+        , m_control(other.m_control)
         , m_size(other.m_size)
         , m_capacity(other.m_capacity)
         , m_deleted_count(other.m_deleted_count)
@@ -127,6 +181,7 @@ public:
         other.m_capacity = 0;
         other.m_deleted_count = 0;
         other.m_buckets = nullptr;
+        other.m_control = nullptr;
     }
 
     HashTable& operator=(HashTable&& other) noexcept
@@ -138,6 +193,7 @@ public:
     friend void swap(HashTable& a, HashTable& b) noexcept
     {
         swap(a.m_buckets, b.m_buckets);
+        swap(a.m_control, b.m_control);
         swap(a.m_size, b.m_size);
         swap(a.m_capacity, b.m_capacity);
         swap(a.m_deleted_count, b.m_deleted_count);
@@ -158,7 +214,9 @@ public:
     void ensure_capacity(size_t capacity)
     {
         VERIFY(capacity >= size());
-        rehash(capacity * 2);
+        auto new_capacity = capacity_for(capacity);
+        if (new_capacity > m_capacity)
+            rehash(new_capacity);
     }
 
     bool contains(const T& value) const
@@ -170,32 +228,28 @@ public:
 
     Iterator begin()
     {
-        for (size_t i = 0; i < m_capacity; ++i) {
-            if (m_buckets[i].used)
-                return Iterator(&m_buckets[i]);
-        }
-        return end();
+        if (!m_buckets)
+            return end();
+        return Iterator(m_control, m_buckets);
     }
 
     Iterator end()
     {
-        return Iterator(nullptr);
+        return Iterator(nullptr, nullptr);
     }
 
     using ConstIterator = HashTableIterator<const HashTable, const T, const Bucket>;
 
     ConstIterator begin() const
     {
-        for (size_t i = 0; i < m_capacity; ++i) {
-            if (m_buckets[i].used)
-                return ConstIterator(&m_buckets[i]);
-        }
-        return end();
+        if (!m_buckets)
+            return end();
+        return ConstIterator(m_control, m_buckets);
     }
 
     ConstIterator end() const
     {
-        return ConstIterator(nullptr);
+        return ConstIterator(nullptr, nullptr);
     }
 
     void clear()
@@ -206,18 +260,17 @@ public:
     template<typename U = T>
     HashSetResult set(U&& value)
     {
-        auto& bucket = lookup_for_writing(value);
-        if (bucket.used) {
-            (*bucket.slot()) = forward<U>(value);
+        auto hash = mix_hash(TraitsForT::hash(value));
+        if (auto* bucket = lookup_with_mixed_hash(hash, [&value](auto& entry) { return TraitsForT::equals(entry, value); })) {
+            (*bucket->slot()) = forward<U>(value);
             return HashSetResult::ReplacedExistingEntry;
         }
 
-        new (bucket.slot()) T(forward<U>(value));
-        bucket.used = true;
-        if (bucket.deleted) {
-            bucket.deleted = false;
+        auto index = find_slot_for_insertion(hash);
+        if (m_control[index] == HashTableControl::Deleted)
             --m_deleted_count;
-        }
+        set_control(index, hash_bits(hash));
+        new (m_buckets[index].slot()) T(forward<U>(value));
         ++m_size;
         return HashSetResult::InsertedNewEntry;
     }
@@ -225,7 +278,10 @@ public:
     template<typename Finder>
     Iterator find(unsigned hash, Finder finder)
     {
-        return Iterator(lookup_with_hash(hash, move(finder)));
+        auto* bucket = lookup_with_mixed_hash(mix_hash(hash), move(finder));
+        if (!bucket)
+            return end();
+        return Iterator(&m_control[bucket - m_buckets], bucket);
     }
 
     Iterator find(const T& value)
@@ -236,7 +292,10 @@ public:
     template<typename Finder>
     ConstIterator find(unsigned hash, Finder finder) const
     {
-        return ConstIterator(lookup_with_hash(hash, move(finder)));
+        auto* bucket = lookup_with_mixed_hash(mix_hash(hash), move(finder));
+        if (!bucket)
+            return end();
+        return ConstIterator(&m_control[bucket - m_buckets], bucket);
     }
 
     ConstIterator find(const T& value) const
@@ -257,113 +316,150 @@ public:
     void remove(Iterator iterator)
     {
         VERIFY(iterator.m_bucket);
-        auto& bucket = *iterator.m_bucket;
-        VERIFY(bucket.used);
-        VERIFY(!bucket.end);
-        VERIFY(!bucket.deleted);
-        bucket.slot()->~T();
-        bucket.used = false;
-        bucket.deleted = true;
+        size_t index = iterator.m_bucket - m_buckets;
+        VERIFY(index < m_capacity);
+        VERIFY(HashTableControl::is_used(m_control[index]));
+        iterator.m_bucket->slot()->~T();
         --m_size;
-        ++m_deleted_count;
+
+        // If every group this slot is part of still has an empty slot, no lookup can ever have
+        // probed past it, so it can go straight back to being empty instead of becoming a tombstone.
+        size_t index_before = (index - Group::width) & m_capacity;
+        auto empty_after = Group(&m_control[index]).match_empty();
+        auto empty_before = Group(&m_control[index_before]).match_empty();
+        bool was_never_full = empty_before && empty_after
+            && Group::first_index(empty_after) + Group::leading_index(empty_before) < Group::width;
+        if (was_never_full) {
+            set_control(index, HashTableControl::Empty);
+        } else {
+            set_control(index, HashTableControl::Deleted);
+            ++m_deleted_count;
+        }
     }
 
 private:
-    void insert_during_rehash(T&& value)
+    // Capacities are always one less than a power of two (so that they double as masks for probing)
+    // and at least one group wide less one, so that the cloned control bytes never overlap.
+    static constexpr size_t min_capacity = Group::width - 1;
+
+    static size_t capacity_for(size_t entry_count)
+    {
+        size_t capacity = min_capacity;
+        while (capacity * max_load_numerator / max_load_denominator < entry_count)
+            capacity = capacity * 2 + 1;
+        return capacity;
+    }
+
+    // Quite a few hash functions are weak in their low bits, which pick the bucket, and the top bits
+    // end up in the control bytes. Run whatever the traits give us through murmur3's fmix32 finalizer,
+    // which makes every bit of the result depend on every bit of the input.
+    static u32 mix_hash(unsigned hash)
+    {
+        hash ^= hash >> 16;
+        hash *= 0x85ebca6bu;
+        hash ^= hash >> 13;
+        hash *= 0xc2b2ae35u;
+        hash ^= hash >> 16;
+        return hash;
+    }
+    static u8 hash_bits(u32 mixed_hash) { return mixed_hash >> 25; }
+
+    void set_control(size_t index, u8 control)
     {
-        auto& bucket = lookup_for_writing(value);
-        new (bucket.slot()) T(move(value));
-        bucket.used = true;
+        m_control[index] = control;
+        // The first group's worth of control bytes is mirrored after the sentinel, so that
+        // groups can be loaded starting from any slot without wrapping around.
+        if (index < Group::width - 1)
+            m_control[m_capacity + 1 + index] = control;
     }
 
     void rehash(size_t new_capacity)
     {
-        new_capacity = max(new_capacity, static_cast<size_t>(4));
+        new_capacity = max(new_capacity, min_capacity);
 
         auto* old_buckets = m_buckets;
+        auto* old_control = m_control;
         auto old_capacity = m_capacity;
 
-        m_buckets = (Bucket*)kmalloc(sizeof(Bucket) * (new_capacity + 1));
-        __builtin_memset(m_buckets, 0, sizeof(Bucket) * (new_capacity + 1));
+        size_t control_size = new_capacity + Group::width;
+        m_buckets = (Bucket*)kmalloc(sizeof(Bucket) * new_capacity + control_size);
+        m_control = reinterpret_cast<u8*>(m_buckets + new_capacity);
+        __builtin_memset(m_control, HashTableControl::Empty, control_size);
+        m_control[new_capacity] = HashTableControl::Sentinel;
         m_capacity = new_capacity;
         m_deleted_count = 0;
 
-        m_buckets[m_capacity].end = true;
-
         if (!old_buckets)
             return;
 
+        // Only live entries are carried over, so this also gets rid of all the tombstones.
         for (size_t i = 0; i < old_capacity; ++i) {
+            if (!HashTableControl::is_used(old_control[i]))
+                continue;
             auto& old_bucket = old_buckets[i];
-            if (old_bucket.used) {
-                insert_during_rehash(move(*old_bucket.slot()));
-                old_bucket.slot()->~T();
-            }
+            auto hash = mix_hash(TraitsForT::hash(*old_bucket.slot()));
+            auto index = find_empty_slot(hash);
+            set_control(index, hash_bits(hash));
+            new (m_buckets[index].slot()) T(move(*old_bucket.slot()));
+            old_bucket.slot()->~T();
         }
 
         kfree(old_buckets);
     }
 
     template<typename Finder>
-    Bucket* lookup_with_hash(unsigned hash, Finder finder, Bucket** usable_bucket_for_writing = nullptr) const
+    Bucket* lookup_with_mixed_hash(u32 hash, Finder finder) const
     {
         if (is_empty())
             return nullptr;
-        size_t bucket_index = hash % m_capacity;
+        u8 bits = hash_bits(hash);
+        size_t position = hash & m_capacity;
+        size_t stride = 0;
         for (;;) {
-            auto& bucket = m_buckets[bucket_index];
-
-            if (usable_bucket_for_writing && !*usable_bucket_for_writing && !bucket.used) {
-                *usable_bucket_for_writing = &bucket;
+            Group group(&m_control[position]);
+            for (auto mask = group.match(bits); mask; mask &= mask - 1) {
+                size_t index = (position + Group::first_index(mask)) & m_capacity;
+                if (finder(*m_buckets[index].slot()))
+                    return &m_buckets[index];
             }
-
-            if (bucket.used && finder(*bucket.slot()))
-                return &bucket;
-
-            if (!bucket.used && !bucket.deleted)
+            if (group.match_empty())
                 return nullptr;
-
-            hash = double_hash(hash);
-            bucket_index = hash % m_capacity;
+            // Triangular probing over groups, which visits every group once the
+            // capacity is one less than a power of two.
+            stride += Group::width;
+            position = (position + stride) & m_capacity;
         }
     }
 
-    const Bucket* lookup_for_reading(const T& value) const
+    size_t find_empty_slot(u32 hash) const
     {
-        return lookup_with_hash(TraitsForT::hash(value), [&value](auto& entry) { return TraitsForT::equals(entry, value); });
+        size_t position = hash & m_capacity;
+        size_t stride = 0;
+        for (;;) {
+            auto mask = Group(&m_control[position]).match_empty_or_deleted();
+            if (mask)
+                return (position + Group::first_index(mask)) & m_capacity;
+            stride += Group::width;
+            position = (position + stride) & m_capacity;
+        }
     }
 
-    Bucket& lookup_for_writing(const T& value)
+    size_t find_slot_for_insertion(u32 hash)
     {
-        auto hash = TraitsForT::hash(value);
-        Bucket* usable_bucket_for_writing = nullptr;
-        if (auto* bucket_for_reading = lookup_with_hash(
-                hash,
-                [&value](auto& entry) { return TraitsForT::equals(entry, value); },
-                &usable_bucket_for_writing)) {
-            return *const_cast<Bucket*>(bucket_for_reading);
-        }
-
-        if (should_grow())
-            rehash(capacity() * 2);
-        else if (usable_bucket_for_writing)
-            return *usable_bucket_for_writing;
-
-        size_t bucket_index = hash % m_capacity;
-
-        for (;;) {
-            auto& bucket = m_buckets[bucket_index];
-            if (!bucket.used)
-                return bucket;
-            hash = double_hash(hash);
-            bucket_index = hash % m_capacity;
+        if (!m_buckets) {
+            rehash(min_capacity);
+        } else if ((m_size + m_deleted_count + 1) * max_load_denominator > m_capacity * max_load_numerator) {
+            // If it's mostly tombstones that fill the table, clearing them out is enough.
+            if (m_size * 2 < m_capacity)
+                rehash(m_capacity);
+            else
+                rehash(m_capacity * 2 + 1);
         }
+        return find_empty_slot(hash);
     }
 
-    size_t used_bucket_count() const { return m_size + m_deleted_count; }
-    bool should_grow() const { return ((used_bucket_count() + 1) * 100) >= (m_capacity * load_factor_in_percent); }
-
     Bucket* m_buckets { nullptr };
+    u8* m_control { nullptr };
     size_t m_size { 0 };
     size_t m_capacity { 0 };
     size_t m_deleted_count { 0 };
@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <AK/JsonArray.h>
+#include <AK/JsonDocument.h>
+#include <AK/JsonObject.h>
+#include <AK/NumericLimits.h>
+
+#ifndef KERNEL
+#    include <stdlib.h>
+#endif
+
+namespace AK {
+
+class JsonDocumentBuilder final : public JsonStreamVisitor {
+public:
+    JsonDocumentBuilder(JsonDocument& document)
+        : m_document(document)
+    {
+    }
+
+    virtual bool on_object_start() override { return open(JsonElement::Type::Object); }
+    virtual bool on_object_end() override { return close(); }
+    virtual bool on_array_start() override { return open(JsonElement::Type::Array); }
+    virtual bool on_array_end() override { return close(); }
+
+    virtual bool on_object_key(const JsonRawString& key) override
+    {
+        ++m_document.m_nodes[m_open_containers.last()].length;
+        append_text(JsonElement::Type::String, key.raw(), key.has_escapes());
+        return true;
+    }
+
+    virtual bool on_string(const JsonRawString& string) override
+    {
+        did_add_value();
+        append_text(JsonElement::Type::String, string.raw(), string.has_escapes());
+        return true;
+    }
+
+    virtual bool on_number(const StringView& literal) override
+    {
+        did_add_value();
+        append_text(JsonElement::Type::Number, literal, false);
+        return true;
+    }
+
+    virtual bool on_bool(bool value) override
+    {
+        did_add_value();
+        append({ 0, value, 0, JsonElement::Type::Bool, false });
+        return true;
+    }
+
+    virtual bool on_null() override
+    {
+        did_add_value();
+        append({ 0, 0, 0, JsonElement::Type::Null, false });
+        return true;
+    }
+
+private:
+    using Node = JsonDocument::Node;
+    static_assert(sizeof(Node) == 16);
+
+    void did_add_value()
+    {
+        if (m_open_containers.is_empty())
+            return;
+        auto& container = m_document.m_nodes[m_open_containers.last()];
+        if (container.type == JsonElement::Type::Array)
+            ++container.length;
+    }
+
+    void append(Node node)
+    {
+        node.end = m_document.m_nodes.size() + 1;
+        m_document.m_nodes.append(node);
+    }
+
+    void append_text(JsonElement::Type type, const StringView& text, bool has_escapes)
+    {
+        u32 offset = text.characters_without_null_termination() - m_document.m_input.characters_without_null_termination();
+        append({ offset, static_cast<u32>(text.length()), 0, type, has_escapes });
+    }
+
+    bool open(JsonElement::Type type)
+    {
+        did_add_value();
+        m_open_containers.append(m_document.m_nodes.size());
+        append({ 0, 0, 0, type, false });
+        return true;
+    }
+
+    bool close()
+    {
+        m_document.m_nodes[m_open_containers.take_last()].end = m_document.m_nodes.size();
+        return true;
+    }
+
+    JsonDocument& m_document;
+    Vector<u32, 32> m_open_containers;
+};
+
+Optional<JsonDocument> JsonDocument::parse(const StringView& input)
+{
+    if (input.length() > NumericLimits<u32>::max())
+        return {};
+
+    JsonDocument document;
+    document.m_input = input;
+
+    JsonDocumentBuilder builder(document);
+    if (!JsonStreamParser(input).parse(builder))
+        return {};
+    return document;
+}
+
+Optional<JsonDocument> JsonDocument::from_mapped_file(NonnullRefPtr<MappedFile> file)
+{
+    auto document = parse(StringView { static_cast<const char*>(file->data()), file->size() });
+    if (!document.has_value())
+        return {};
+    document.value().m_file = move(file);
+    return document;
+}
+
+bool JsonElement::as_bool() const
+{
+    VERIFY(is_bool());
+    return m_document->m_nodes[m_index].length;
+}
+
+JsonRawString JsonElement::as_raw_string() const
+{
+    VERIFY(is_string());
+    auto& node = m_document->m_nodes[m_index];
+    return { m_document->text_of(node), node.has_escapes };
+}
+
+StringView JsonElement::number_literal() const
+{
+    VERIFY(is_number());
+    return m_document->text_of(m_document->m_nodes[m_index]);
+}
+
+#ifndef KERNEL
+double JsonElement::to_double() const
+{
+    auto literal = number_literal();
+    char buffer[64];
+    if (literal.length() >= sizeof(buffer))
+        return strtod(String(literal).characters(), nullptr);
+    memcpy(buffer, literal.characters_without_null_termination(), literal.length());
+    buffer[literal.length()] = '\0';
+    return strtod(buffer, nullptr);
+}
+#endif
+
+size_t JsonElement::size() const
+{
+    VERIFY(is_array() || is_object());
+    return m_document->m_nodes[m_index].length;
+}
+
+Optional<JsonElement> JsonElement::get(const StringView& key) const
+{
+    VERIFY(is_object());
+    for (u32 index = m_index + 1; index < end_index(); index = end_index_of(index + 1)) {
+        if (JsonElement(*m_document, index).as_raw_string() == key)
+            return JsonElement(*m_document, index + 1);
+    }
+    return {};
+}
+
+JsonElement JsonElement::at(size_t index) const
+{
+    VERIFY(index < size());
+    u32 element_index = m_index + 1;
+    while (index--)
+        element_index = end_index_of(element_index);
+    return JsonElement(*m_document, element_index);
+}
+
+JsonValue JsonElement::to_json_value() const
+{
+    switch (type()) {
+    case Type::Null:
+        return JsonValue();
+    case Type::Bool:
+        return JsonValue(as_bool());
+    case Type::String:
+        return JsonValue(as_string());
+    case Type::Number: {
+        auto literal = number_literal();
+#ifndef KERNEL
+        for (char ch : literal) {
+            if (ch == '.' || ch == 'e' || ch == 'E')
+                return JsonValue(to_double());
+        }
+#endif
+        // Pick the same representations as JsonParser does.
+        if (auto number = literal.to_uint(); number.has_value())
+            return JsonValue(number.value());
+        auto number = literal.to_int<i64>();
+        if (!number.has_value())
+            return JsonValue();
+        if (number.value() <= NumericLimits<i32>::max())
+            return JsonValue(static_cast<i32>(number.value()));
+        return JsonValue(number.value());
+    }
+    case Type::Array: {
+        JsonArray array;
+        for_each([&](auto element) {
+            array.append(element.to_json_value());
+        });
+        return array;
+    }
+    case Type::Object: {
+        JsonObject object;
+        for_each_member([&](auto& key, auto value) {
+            object.set(key.to_string(), value.to_json_value());
+        });
+        return object;
+    }
+    }
+    VERIFY_NOT_REACHED();
+}
+
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <AK/JsonStreamParser.h>
+#include <AK/MappedFile.h>
+#include <AK/Noncopyable.h>
+#include <AK/Optional.h>
+#include <AK/RefPtr.h>
+#include <AK/Vector.h>
+
+namespace AK {
+
+class JsonDocument;
+
+// A lightweight handle to one value inside a JsonDocument. It is only valid
+// while the document it came from is alive and hasn't been moved.
+class JsonElement {
+public:
+    enum class Type : u8 {
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object,
+    };
+
+    Type type() const;
+
+    bool is_null() const { return type() == Type::Null; }
+    bool is_bool() const { return type() == Type::Bool; }
+    bool is_number() const { return type() == Type::Number; }
+    bool is_string() const { return type() == Type::String; }
+    bool is_array() const { return type() == Type::Array; }
+    bool is_object() const { return type() == Type::Object; }
+
+    bool as_bool() const;
+    JsonRawString as_raw_string() const;
+    String as_string() const { return as_raw_string().to_string(); }
+    StringView number_literal() const;
+
+    Optional<i64> to_i64() const { return number_literal().to_int<i64>(); }
+    Optional<u64> to_u64() const { return number_literal().to_uint<u64>(); }
+#ifndef KERNEL
+    double to_double() const;
+#endif
+
+    // The number of elements of an array or members of an object.
+    size_t size() const;
+
+    // Looks up a member of an object. This is a linear scan; prefer
+    // for_each_member() when visiting many members.
+    Optional<JsonElement> get(const StringView& key) const;
+
+    // Returns the element at `index` of an array. This is a linear scan.
+    JsonElement at(size_t index) const;
+
+    template<typename Callback>
+    void for_each(Callback callback) const
+    {
+        VERIFY(is_array());
+        for (u32 index = m_index + 1; index < end_index(); index = end_index_of(index))
+            callback(JsonElement(*m_document, index));
+    }
+
+    template<typename Callback>
+    void for_each_member(Callback callback) const
+    {
+        VERIFY(is_object());
+        for (u32 index = m_index + 1; index < end_index(); index = end_index_of(index + 1)) {
+            const auto key = JsonElement(*m_document, index).as_raw_string();
+            callback(key, JsonElement(*m_document, index + 1));
+        }
+    }
+
+    // Materializes this element and everything below it.
+    JsonValue to_json_value() const;
+
+private:
+    friend class JsonDocument;
+
+    JsonElement(const JsonDocument& document, u32 index)
+        : m_document(&document)
+        , m_index(index)
+    {
+    }
+
+    u32 end_index() const { return end_index_of(m_index); }
+    u32 end_index_of(u32 index) const;
+
+    const JsonDocument* m_document { nullptr };
+    u32 m_index { 0 };
+};
+
+// A read-only DOM over a JSON text that doesn't copy it. Parsing produces a
+// flat array of 16-byte nodes in document order, where strings and numbers
+// refer back into the input and containers know where their subtree ends.
+// The input must outlive the document; from_mapped_file() keeps the mapping
+// alive for as long as the document is.
+class JsonDocument {
+    AK_MAKE_NONCOPYABLE(JsonDocument);
+
+public:
+    static Optional<JsonDocument> parse(const StringView& input);
+    static Optional<JsonDocument> from_mapped_file(NonnullRefPtr<MappedFile>);
+
+    JsonDocument(JsonDocument&&) = default;
+    JsonDocument& operator=(JsonDocument&&) = default;
+
+    JsonElement root() const { return JsonElement(*this, 0); }
+
+    size_t node_count() const { return m_nodes.size(); }
+    size_t memory_usage() const { return m_nodes.capacity() * sizeof(Node); }
+
+private:
+    friend class JsonElement;
+    friend class JsonDocumentBuilder;
+
+    struct Node {
+        // For strings and numbers, the text in the input. For containers,
+        // `length` is the number of elements or members, and for bools it is the value.
+        u32 offset { 0 };
+        u32 length { 0 };
+        // The index of the first node after this node's subtree.
+        u32 end { 0 };
+        JsonElement::Type type { JsonElement::Type::Null };
+        bool has_escapes { false };
+    };
+
+    JsonDocument() = default;
+
+    StringView text_of(const Node& node) const { return m_input.substring_view(node.offset, node.length); }
+
+    StringView m_input;
+    RefPtr<MappedFile> m_file;
+    Vector<Node> m_nodes;
+};
+
+inline JsonElement::Type JsonElement::type() const
+{
+    return m_document->m_nodes[m_index].type;
+}
+
+inline u32 JsonElement::end_index_of(u32 index) const
+{
+    return m_document->m_nodes[index].end;
+}
+
+}
+
+using AK::JsonDocument;
+using AK::JsonElement;
@@ -124,7 +124,7 @@ public:
     void add(const StringView& key, double value)
     {
         begin_item(key);
-        m_builder.appendff("{}", value);
+        m_builder.appendff("{:g}", value);
     }
 
     JsonArraySerializer<Builder> add_array(const StringView& key)
@@ -27,75 +27,38 @@
 #include <AK/JsonArray.h>
 #include <AK/JsonObject.h>
 #include <AK/JsonParser.h>
+#include <AK/JsonStreamParser.h>
 #include <ctype.h>
 
+#ifndef KERNEL
+#    include <stdlib.h>
+#endif
+
 namespace AK {
 
 String JsonParser::consume_and_unescape_string()
 {
     if (!consume_specific('"'))
         return {};
-    StringBuilder final_sb;
 
+    size_t start = m_index;
+    bool has_escapes = false;
     for (;;) {
-        size_t peek_index = m_index;
-        char ch = 0;
-        for (;;) {
-            if (peek_index == m_input.length())
-                break;
-            ch = m_input[peek_index];
-            if (ch == '"' || ch == '\\')
-                break;
-            ++peek_index;
-        }
-
-        while (peek_index != m_index) {
-            final_sb.append(m_input[m_index]);
-            m_index++;
-        }
-
-        if (m_index == m_input.length())
-            break;
+        if (is_eof())
+            return {};
+        char ch = m_input[m_index];
         if (ch == '"')
             break;
-        if (ch != '\\') {
-            final_sb.append(consume());
-            continue;
-        }
-        ignore();
-        char escaped_ch = consume();
-        switch (escaped_ch) {
-        case 'n':
-            final_sb.append('\n');
-            break;
-        case 'r':
-            final_sb.append('\r');
-            break;
-        case 't':
-            final_sb.append('\t');
-            break;
-        case 'b':
-            final_sb.append('\b');
-            break;
-        case 'f':
-            final_sb.append('\f');
-            break;
-        case 'u': {
-            auto code_point = AK::StringUtils::convert_to_uint_from_hex(consume(4));
-            if (code_point.has_value())
-                final_sb.append_code_point(code_point.value());
-            else
-                final_sb.append('?');
-        } break;
-        default:
-            final_sb.append(escaped_ch);
-            break;
+        if (ch == '\\') {
+            has_escapes = true;
+            ++m_index;
         }
+        ++m_index;
     }
-    if (!consume_specific('"'))
-        return {};
+    auto raw = m_input.substring_view(start, m_index - start);
+    ignore();
 
-    return final_sb.to_string();
+    return JsonRawString(raw, has_escapes).to_string();
 }
 
 Optional<JsonValue> JsonParser::parse_object()
@@ -173,21 +136,18 @@ Optional<JsonValue> JsonParser::parse_number()
 {
     JsonValue value;
     Vector<char, 128> number_buffer;
-    Vector<char, 128> fraction_buffer;
 
     bool is_double = false;
     for (;;) {
         char ch = peek();
-        if (ch == '.') {
+        if (ch == '.' || ch == 'e' || ch == 'E' || (ch == '+' && is_double)) {
             is_double = true;
+            number_buffer.append(ch);
             ++m_index;
             continue;
         }
         if (ch == '-' || (ch >= '0' && ch <= '9')) {
-            if (is_double)
-                fraction_buffer.append(ch);
-            else
-                number_buffer.append(ch);
+            number_buffer.append(ch);
             ++m_index;
             continue;
         }
@@ -195,33 +155,16 @@ Optional<JsonValue> JsonParser::parse_number()
     }
 
     StringView number_string(number_buffer.data(), number_buffer.size());
-    StringView fraction_string(fraction_buffer.data(), fraction_buffer.size());
 
 #ifndef KERNEL
     if (is_double) {
-        // FIXME: This logic looks shaky.
-        int whole = 0;
-        auto to_signed_result = number_string.to_uint();
-        if (to_signed_result.has_value()) {
-            whole = to_signed_result.value();
-        } else {
-            auto number = number_string.to_int();
-            if (!number.has_value())
-                return {};
-            whole = number.value();
-        }
-
-        auto fraction_string_uint = fraction_string.to_uint();
-        if (!fraction_string_uint.has_value())
+        size_t length = number_buffer.size();
+        number_buffer.append('\0');
+        char* end = nullptr;
+        double number = strtod(number_buffer.data(), &end);
+        if (end != number_buffer.data() + length)
             return {};
-        int fraction = fraction_string_uint.value();
-        fraction *= (whole < 0) ? -1 : 1;
-
-        auto divider = 1;
-        for (size_t i = 0; i < fraction_buffer.size(); ++i) {
-            divider *= 10;
-        }
-        value = JsonValue((double)whole + ((double)fraction / divider));
+        value = JsonValue(number);
     } else {
 #endif
         auto to_unsigned_result = number_string.to_uint();
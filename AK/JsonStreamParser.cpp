@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <AK/JsonStreamParser.h>
+#include <AK/StringUtils.h>
+
+namespace AK {
+
+void JsonRawString::unescape(const StringView& raw, StringBuilder& builder)
+{
+    for (size_t i = 0; i < raw.length();) {
+        size_t run_start = i;
+        while (i < raw.length() && raw[i] != '\\')
+            ++i;
+        builder.append(raw.substring_view(run_start, i - run_start));
+        if (i >= raw.length())
+            break;
+
+        ++i;
+        if (i >= raw.length())
+            break;
+        char escaped_ch = raw[i++];
+        switch (escaped_ch) {
+        case 'n':
+            builder.append('\n');
+            break;
+        case 'r':
+            builder.append('\r');
+            break;
+        case 't':
+            builder.append('\t');
+            break;
+        case 'b':
+            builder.append('\b');
+            break;
+        case 'f':
+            builder.append('\f');
+            break;
+        case 'u': {
+            auto digits = raw.substring_view(i, min(static_cast<size_t>(4), raw.length() - i));
+            i += digits.length();
+            auto code_point = AK::StringUtils::convert_to_uint_from_hex(digits);
+            if (code_point.has_value())
+                builder.append_code_point(code_point.value());
+            else
+                builder.append('?');
+        } break;
+        default:
+            builder.append(escaped_ch);
+            break;
+        }
+    }
+}
+
+StringView JsonRawString::unescaped(StringBuilder& buffer) const
+{
+    if (!m_has_escapes)
+        return m_raw;
+    buffer.clear();
+    unescape(m_raw, buffer);
+    return buffer.string_view();
+}
+
+String JsonRawString::to_string() const
+{
+    if (!m_has_escapes)
+        return m_raw;
+    StringBuilder builder(m_raw.length());
+    unescape(m_raw, builder);
+    return builder.to_string();
+}
+
+bool JsonRawString::operator==(const StringView& other) const
+{
+    if (!m_has_escapes)
+        return m_raw == other;
+    // Unescaping never makes a string longer.
+    if (m_raw.length() < other.length())
+        return false;
+    StringBuilder builder(m_raw.length());
+    unescape(m_raw, builder);
+    return builder.string_view() == other;
+}
+
+static inline bool is_json_whitespace(char ch)
+{
+    return ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t';
+}
+
+static inline bool is_digit(char ch)
+{
+    return ch >= '0' && ch <= '9';
+}
+
+void JsonStreamParser::skip_whitespace()
+{
+    while (m_index < m_input.length() && is_json_whitespace(m_input[m_index]))
+        ++m_index;
+}
+
+bool JsonStreamParser::consume_string(JsonRawString& string)
+{
+    if (!consume_specific('"'))
+        return false;
+    size_t start = m_index;
+    bool has_escapes = false;
+    for (;;) {
+        if (m_index >= m_input.length())
+            return false;
+        char ch = m_input[m_index];
+        if (ch == '"')
+            break;
+        if (ch == '\\') {
+            has_escapes = true;
+            ++m_index;
+        }
+        ++m_index;
+    }
+    string = JsonRawString(m_input.substring_view(start, m_index - start), has_escapes);
+    ++m_index;
+    return true;
+}
+
+bool JsonStreamParser::consume_number(StringView& literal)
+{
+    size_t start = m_index;
+    auto consume_digits = [&] {
+        size_t digits_start = m_index;
+        while (m_index < m_input.length() && is_digit(m_input[m_index]))
+            ++m_index;
+        return m_index != digits_start;
+    };
+
+    consume_specific('-');
+    if (!consume_digits())
+        return false;
+    if (consume_specific('.') && !consume_digits())
+        return false;
+    if (next_is('e') || next_is('E')) {
+        ++m_index;
+        if (!consume_specific('+'))
+            consume_specific('-');
+        if (!consume_digits())
+            return false;
+    }
+    literal = m_input.substring_view(start, m_index - start);
+    return true;
+}
+
+bool JsonStreamParser::parse_value(JsonStreamVisitor& visitor)
+{
+    skip_whitespace();
+    m_container_just_opened = false;
+    switch (peek()) {
+    case '{':
+        ignore();
+        m_open_containers.append('{');
+        m_container_just_opened = true;
+        return visitor.on_object_start();
+    case '[':
+        ignore();
+        m_open_containers.append('[');
+        m_container_just_opened = true;
+        return visitor.on_array_start();
+    case '"': {
+        JsonRawString string;
+        if (!consume_string(string))
+            return false;
+        return visitor.on_string(string);
+    }
+    case '-':
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9': {
+        StringView literal;
+        if (!consume_number(literal))
+            return false;
+        return visitor.on_number(literal);
+    }
+    case 't':
+        return consume_specific("true") && visitor.on_bool(true);
+    case 'f':
+        return consume_specific("false") && visitor.on_bool(false);
+    case 'n':
+        return consume_specific("null") && visitor.on_null();
+    }
+    return false;
+}
+
+bool JsonStreamParser::parse(JsonStreamVisitor& visitor)
+{
+    m_open_containers.clear();
+    if (!parse_value(visitor))
+        return false;
+
+    while (!m_open_containers.is_empty()) {
+        skip_whitespace();
+        bool in_object = m_open_containers.last() == '{';
+        if (consume_specific(in_object ? '}' : ']')) {
+            m_open_containers.take_last();
+            m_container_just_opened = false;
+            if (!(in_object ? visitor.on_object_end() : visitor.on_array_end()))
+                return false;
+            continue;
+        }
+        if (!m_container_just_opened && !consume_specific(','))
+            return false;
+        if (in_object) {
+            skip_whitespace();
+            JsonRawString key;
+            if (!consume_string(key))
+                return false;
+            if (!visitor.on_object_key(key))
+                return false;
+            skip_whitespace();
+            if (!consume_specific(':'))
+                return false;
+        }
+        if (!parse_value(visitor))
+            return false;
+    }
+
+    skip_whitespace();
+    return is_eof();
+}
+
+}
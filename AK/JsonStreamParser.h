@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <AK/GenericLexer.h>
+#include <AK/String.h>
+#include <AK/StringBuilder.h>
+#include <AK/StringView.h>
+#include <AK/Vector.h>
+
+namespace AK {
+
+// A JSON string as it appears in the input, without the surrounding quotes.
+// Nothing is copied until the caller asks for the unescaped contents.
+class JsonRawString {
+public:
+    JsonRawString() = default;
+    JsonRawString(const StringView& raw, bool has_escapes)
+        : m_raw(raw)
+        , m_has_escapes(has_escapes)
+    {
+    }
+
+    const StringView& raw() const { return m_raw; }
+    bool has_escapes() const { return m_has_escapes; }
+
+    // Returns a view of the input when there is nothing to unescape, otherwise
+    // unescapes into `buffer` and returns a view of that.
+    StringView unescaped(StringBuilder& buffer) const;
+    String to_string() const;
+
+    bool operator==(const StringView&) const;
+    bool operator!=(const StringView& other) const { return !(*this == other); }
+
+    static void unescape(const StringView& raw, StringBuilder&);
+
+private:
+    StringView m_raw;
+    bool m_has_escapes { false };
+};
+
+// Receives the tokens of a JSON document in order. Returning false from any
+// callback stops the parse.
+class JsonStreamVisitor {
+public:
+    virtual ~JsonStreamVisitor() = default;
+
+    virtual bool on_object_start() { return true; }
+    virtual bool on_object_key(const JsonRawString&) { return true; }
+    virtual bool on_object_end() { return true; }
+    virtual bool on_array_start() { return true; }
+    virtual bool on_array_end() { return true; }
+    virtual bool on_string(const JsonRawString&) { return true; }
+    virtual bool on_number(const StringView&) { return true; }
+    virtual bool on_bool(bool) { return true; }
+    virtual bool on_null() { return true; }
+};
+
+// An event-based JSON parser. Unlike JsonParser it doesn't build any values,
+// and strings and numbers are handed out as views into the input, so memory
+// use doesn't grow with the size of the document. Nesting is tracked on an
+// explicit stack rather than by recursion.
+class JsonStreamParser : private GenericLexer {
+public:
+    explicit JsonStreamParser(const StringView& input)
+        : GenericLexer(input)
+    {
+    }
+
+    // Returns false if the input is malformed or the visitor stopped the parse.
+    bool parse(JsonStreamVisitor&);
+
+    size_t offset() const { return tell(); }
+
+private:
+    bool parse_value(JsonStreamVisitor&);
+    bool consume_string(JsonRawString&);
+    bool consume_number(StringView&);
+    void skip_whitespace();
+
+    Vector<char, 32> m_open_containers;
+    bool m_container_just_opened { false };
+};
+
+}
+
+using AK::JsonRawString;
+using AK::JsonStreamParser;
+using AK::JsonStreamVisitor;
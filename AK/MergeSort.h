@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <AK/QuickSort.h>
+#include <AK/Span.h>
+#include <AK/Vector.h>
+
+namespace AK {
+
+namespace Detail {
+
+// Merges the two sorted runs items[0, middle) and items[middle, size) in place, using
+// buffer to hold the left run. Ties are taken from the left run, which keeps the merge stable.
+template<typename T, typename LessThan>
+void merge_sorted_runs(AK::Span<T> items, size_t middle, Vector<T>& buffer, LessThan& less_than)
+{
+    if (middle == 0 || middle == items.size() || !less_than(items[middle], items[middle - 1]))
+        return;
+
+    buffer.clear_with_capacity();
+    buffer.ensure_capacity(middle);
+    for (size_t i = 0; i < middle; ++i)
+        buffer.unchecked_append(move(items[i]));
+
+    size_t left = 0;
+    size_t right = middle;
+    size_t out = 0;
+    while (left < buffer.size() && right < items.size()) {
+        if (less_than(items[right], buffer[left]))
+            items[out++] = move(items[right++]);
+        else
+            items[out++] = move(buffer[left++]);
+    }
+    while (left < buffer.size())
+        items[out++] = move(buffer[left++]);
+}
+
+template<typename T, typename LessThan>
+void merge_sort(AK::Span<T> items, Vector<T>& buffer, LessThan& less_than)
+{
+    if (items.size() <= (size_t)insertion_sort_threshold) {
+        insertion_sort(items, 0, (int)items.size() - 1, less_than);
+        return;
+    }
+    size_t middle = items.size() / 2;
+    merge_sort(items.slice(0, middle), buffer, less_than);
+    merge_sort(items.slice(middle), buffer, less_than);
+    merge_sorted_runs(items, middle, buffer, less_than);
+}
+
+}
+
+// A stable sort: elements that compare equal keep their relative order.
+// It needs a temporary buffer for half of the elements.
+template<typename T, typename LessThan>
+void merge_sort(Span<T> items, LessThan less_than)
+{
+    Vector<T> buffer;
+    Detail::merge_sort(items, buffer, less_than);
+}
+
+template<typename T>
+void merge_sort(Span<T> items)
+{
+    merge_sort(items, [](auto& a, auto& b) { return a < b; });
+}
+
+template<typename Collection, typename LessThan>
+void merge_sort(Collection& collection, LessThan less_than)
+{
+    merge_sort(collection.span(), move(less_than));
+}
+
+template<typename Collection>
+void merge_sort(Collection& collection)
+{
+    merge_sort(collection.span());
+}
+
+}
+
+using AK::merge_sort;
@@ -99,25 +99,11 @@ ALWAYS_INLINE int print_hex(PutChFunc putch, char*& bufptr, T number, bool upper
 template<typename PutChFunc>
 ALWAYS_INLINE int print_number(PutChFunc putch, char*& bufptr, u32 number, bool left_pad, bool zero_pad, u32 field_width)
 {
-    u32 divisor = 1000000000;
-    char ch;
-    char padding = 1;
-    char buf[16];
-    char* p = buf;
-
-    for (;;) {
-        ch = '0' + (number / divisor);
-        number %= divisor;
-        if (ch != '0')
-            padding = 0;
-        if (!padding || divisor == 1)
-            *(p++) = ch;
-        if (divisor == 1)
-            break;
-        divisor /= 10;
-    }
+    char buf[10];
+    char* end = buf + sizeof(buf);
+    char* p = AK::Detail::write_decimal_digits_backwards(number, end);
 
-    size_t numlen = p - buf;
+    size_t numlen = end - p;
     if (!field_width || field_width < numlen)
         field_width = numlen;
     if (!left_pad) {
@@ -126,7 +112,7 @@ ALWAYS_INLINE int print_number(PutChFunc putch, char*& bufptr, u32 number, bool
         }
     }
     for (unsigned i = 0; i < numlen; ++i) {
-        putch(bufptr, buf[i]);
+        putch(bufptr, p[i]);
     }
     if (left_pad) {
         for (unsigned i = 0; i < field_width - numlen; ++i) {
@@ -140,25 +126,11 @@ ALWAYS_INLINE int print_number(PutChFunc putch, char*& bufptr, u32 number, bool
 template<typename PutChFunc>
 ALWAYS_INLINE int print_u64(PutChFunc putch, char*& bufptr, u64 number, bool left_pad, bool zero_pad, u32 field_width)
 {
-    u64 divisor = 10000000000000000000LLU;
-    char ch;
-    char padding = 1;
-    char buf[16];
-    char* p = buf;
-
-    for (;;) {
-        ch = '0' + (number / divisor);
-        number %= divisor;
-        if (ch != '0')
-            padding = 0;
-        if (!padding || divisor == 1)
-            *(p++) = ch;
-        if (divisor == 1)
-            break;
-        divisor /= 10;
-    }
+    char buf[20];
+    char* end = buf + sizeof(buf);
+    char* p = AK::Detail::write_decimal_digits_backwards(number, end);
 
-    size_t numlen = p - buf;
+    size_t numlen = end - p;
     if (!field_width || field_width < numlen)
         field_width = numlen;
     if (!left_pad) {
@@ -167,7 +139,7 @@ ALWAYS_INLINE int print_u64(PutChFunc putch, char*& bufptr, u64 number, bool lef
         }
     }
     for (unsigned i = 0; i < numlen; ++i) {
-        putch(bufptr, buf[i]);
+        putch(bufptr, p[i]);
     }
     if (left_pad) {
         for (unsigned i = 0; i < field_width - numlen; ++i) {
@@ -30,18 +30,80 @@
 
 namespace AK {
 
-/* This is a dual pivot quick sort. It is quite a bit faster than the single
- * pivot quick_sort below. The other quick_sort below should only be used when
- * you are stuck with simple iterators to a container and you don't have access
- * to the container itself.
- */
+namespace Detail {
+
+// Ranges this small are sorted faster by insertion sort than by partitioning them further.
+static constexpr int insertion_sort_threshold = 16;
+
+// Quick sort gives up and falls back to heap sort after this many levels of bad partitions,
+// which bounds both the running time and the stack depth at O(n log n) and O(log n).
+inline int introsort_depth_limit(int size)
+{
+    return size > 1 ? 2 * (32 - __builtin_clz(size)) : 0;
+}
+
+template<typename Iterator>
+struct IteratorAsCollection {
+    Iterator begin;
+    decltype(auto) operator[](int index) { return *(begin + index); }
+};
+
+// Stable: elements are only ever swapped with a neighbour that is strictly greater.
 template<typename Collection, typename LessThan>
-void dual_pivot_quick_sort(Collection& col, int start, int end, LessThan less_than)
+void insertion_sort(Collection& col, int start, int end, LessThan& less_than)
 {
-    if (start >= end) {
+    for (int i = start + 1; i <= end; ++i) {
+        for (int j = i; j > start && less_than(col[j], col[j - 1]); --j)
+            swap(col[j], col[j - 1]);
+    }
+}
+
+template<typename Collection, typename LessThan>
+void sift_down(Collection& col, int start, int root, int count, LessThan& less_than)
+{
+    for (;;) {
+        int child = 2 * root + 1;
+        if (child >= count)
+            return;
+        if (child + 1 < count && less_than(col[start + child], col[start + child + 1]))
+            ++child;
+        if (!less_than(col[start + root], col[start + child]))
+            return;
+        swap(col[start + root], col[start + child]);
+        root = child;
+    }
+}
+
+template<typename Collection, typename LessThan>
+void heap_sort(Collection& col, int start, int end, LessThan& less_than)
+{
+    int count = end - start + 1;
+    for (int i = count / 2 - 1; i >= 0; --i)
+        sift_down(col, start, i, count, less_than);
+    for (int i = count - 1; i > 0; --i) {
+        swap(col[start], col[start + i]);
+        sift_down(col, start, 0, i, less_than);
+    }
+}
+
+template<typename Collection, typename LessThan>
+void dual_pivot_introsort(Collection& col, int start, int end, int depth_limit, LessThan& less_than)
+{
+    if (end - start < insertion_sort_threshold) {
+        insertion_sort(col, start, end, less_than);
+        return;
+    }
+    if (depth_limit-- == 0) {
+        heap_sort(col, start, end, less_than);
         return;
     }
 
+    // Take the pivots from the tertiles rather than the ends, so that (reverse) sorted
+    // input gets split evenly instead of peeling off one element per level.
+    int third = (end - start + 1) / 3;
+    swap(col[start], col[start + third]);
+    swap(col[end], col[end - third]);
+
     int left_pointer, right_pointer;
     if (!less_than(col[start], col[end])) {
         swap(col[start], col[end]);
@@ -80,18 +142,26 @@ void dual_pivot_quick_sort(Collection& col, int start, int end, LessThan less_th
     left_pointer = j;
     right_pointer = g;
 
-    dual_pivot_quick_sort(col, start, left_pointer - 1, less_than);
-    dual_pivot_quick_sort(col, left_pointer + 1, right_pointer - 1, less_than);
-    dual_pivot_quick_sort(col, right_pointer + 1, end, less_than);
+    dual_pivot_introsort(col, start, left_pointer - 1, depth_limit, less_than);
+    dual_pivot_introsort(col, left_pointer + 1, right_pointer - 1, depth_limit, less_than);
+    dual_pivot_introsort(col, right_pointer + 1, end, depth_limit, less_than);
 }
 
 template<typename Iterator, typename LessThan>
-void single_pivot_quick_sort(Iterator start, Iterator end, LessThan less_than)
+void single_pivot_introsort(Iterator start, Iterator end, int depth_limit, LessThan less_than)
 {
     for (;;) {
         int size = end - start;
-        if (size <= 1)
+        if (size <= insertion_sort_threshold) {
+            IteratorAsCollection<Iterator> col { start };
+            insertion_sort(col, 0, size - 1, less_than);
+            return;
+        }
+        if (depth_limit-- == 0) {
+            IteratorAsCollection<Iterator> col { start };
+            heap_sort(col, 0, size - 1, less_than);
             return;
+        }
 
         int pivot_point = size / 2;
         if (pivot_point)
@@ -111,15 +181,40 @@ void single_pivot_quick_sort(Iterator start, Iterator end, LessThan less_than)
         // Recur into the shorter part of the remaining data
         // to ensure a stack depth of at most log(n).
         if (i > size / 2) {
-            single_pivot_quick_sort(start + i, end, less_than);
+            single_pivot_introsort(start + i, end, depth_limit, less_than);
             end = start + i - 1;
         } else {
-            single_pivot_quick_sort(start, start + i - 1, less_than);
+            single_pivot_introsort(start, start + i - 1, depth_limit, less_than);
             start = start + i;
         }
     }
 }
 
+}
+
+/* This is a dual pivot quick sort. It is quite a bit faster than the single
+ * pivot quick_sort below. The other quick_sort below should only be used when
+ * you are stuck with simple iterators to a container and you don't have access
+ * to the container itself.
+ *
+ * Both are introsorts: small ranges are finished off with insertion sort, and
+ * ranges that keep partitioning badly are handed to heap sort, so neither can
+ * go quadratic. Neither is stable; use merge_sort() from AK/MergeSort.h for that.
+ */
+template<typename Collection, typename LessThan>
+void dual_pivot_quick_sort(Collection& col, int start, int end, LessThan less_than)
+{
+    if (start >= end)
+        return;
+    Detail::dual_pivot_introsort(col, start, end, Detail::introsort_depth_limit(end - start + 1), less_than);
+}
+
+template<typename Iterator, typename LessThan>
+void single_pivot_quick_sort(Iterator start, Iterator end, LessThan less_than)
+{
+    Detail::single_pivot_introsort(start, end, Detail::introsort_depth_limit(end - start), move(less_than));
+}
+
 template<typename Iterator>
 void quick_sort(Iterator start, Iterator end)
 {
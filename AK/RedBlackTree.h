@@ -0,0 +1,477 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Noncopyable.h>
+#include <AK/StdLibExtras.h>
+#include <AK/Types.h>
+#include <AK/kmalloc.h>
+
+namespace AK {
+
+template<typename TreeType, typename ElementType>
+class RedBlackTreeIterator;
+
+// A self-balancing binary search tree mapping unique keys to values.
+// Keys are kept in sorted order, so besides exact lookups this also
+// supports "closest key" queries (e.g. "the region starting at or below
+// this address") in O(log n).
+template<typename K, typename V>
+class RedBlackTree {
+    AK_MAKE_NONCOPYABLE(RedBlackTree);
+
+public:
+    struct Node {
+        Node(K key, V value)
+            : key(key)
+            , value(move(value))
+        {
+        }
+
+        Node* left { nullptr };
+        Node* right { nullptr };
+        Node* parent { nullptr };
+        bool is_red { true };
+        K key;
+        V value;
+    };
+
+    RedBlackTree() = default;
+    RedBlackTree(RedBlackTree&& other)
+        : m_root(exchange(other.m_root, nullptr))
+        , m_size(exchange(other.m_size, 0))
+    {
+    }
+    RedBlackTree& operator=(RedBlackTree&& other)
+    {
+        if (this != &other) {
+            clear();
+            m_root = exchange(other.m_root, nullptr);
+            m_size = exchange(other.m_size, 0);
+        }
+        return *this;
+    }
+    ~RedBlackTree() { clear(); }
+
+    [[nodiscard]] size_t size() const { return m_size; }
+    [[nodiscard]] bool is_empty() const { return m_size == 0; }
+
+    // Returns false (and leaves the tree untouched) if the key is already present.
+    bool try_insert(K key, V value)
+    {
+        Node* parent = nullptr;
+        Node** link = &m_root;
+        while (*link) {
+            parent = *link;
+            if (key == parent->key)
+                return false;
+            link = key < parent->key ? &parent->left : &parent->right;
+        }
+        auto* node = new Node(key, move(value));
+        node->parent = parent;
+        *link = node;
+        ++m_size;
+        insert_fixups(node);
+        return true;
+    }
+
+    void insert(K key, V value)
+    {
+        auto success = try_insert(key, move(value));
+        VERIFY(success);
+    }
+
+    [[nodiscard]] V* find(K key)
+    {
+        auto* node = find_node(key);
+        return node ? &node->value : nullptr;
+    }
+    [[nodiscard]] const V* find(K key) const { return const_cast<RedBlackTree&>(*this).find(key); }
+
+    [[nodiscard]] bool contains(K key) const { return find_node(key) != nullptr; }
+
+    // Finds the value with the largest key that is <= the given key.
+    [[nodiscard]] V* find_largest_not_above(K key)
+    {
+        Node* candidate = nullptr;
+        for (auto* node = m_root; node;) {
+            if (node->key == key)
+                return &node->value;
+            if (node->key < key) {
+                candidate = node;
+                node = node->right;
+            } else {
+                node = node->left;
+            }
+        }
+        return candidate ? &candidate->value : nullptr;
+    }
+    [[nodiscard]] const V* find_largest_not_above(K key) const { return const_cast<RedBlackTree&>(*this).find_largest_not_above(key); }
+
+    // Finds the value with the smallest key that is >= the given key.
+    [[nodiscard]] V* find_smallest_not_below(K key)
+    {
+        Node* candidate = nullptr;
+        for (auto* node = m_root; node;) {
+            if (node->key == key)
+                return &node->value;
+            if (key < node->key) {
+                candidate = node;
+                node = node->left;
+            } else {
+                node = node->right;
+            }
+        }
+        return candidate ? &candidate->value : nullptr;
+    }
+    [[nodiscard]] const V* find_smallest_not_below(K key) const { return const_cast<RedBlackTree&>(*this).find_smallest_not_below(key); }
+
+    bool remove(K key)
+    {
+        auto* node = find_node(key);
+        if (!node)
+            return false;
+        remove_node(node);
+        delete node;
+        return true;
+    }
+
+    // Removes the given key from the tree and hands its value to the caller.
+    V take(K key)
+    {
+        auto* node = find_node(key);
+        VERIFY(node);
+        remove_node(node);
+        V value = move(node->value);
+        delete node;
+        return value;
+    }
+
+    void clear()
+    {
+        // Tear the tree down iteratively by rotating left children up, so
+        // that we don't need any recursion (or extra memory) to do it.
+        auto* node = m_root;
+        while (node) {
+            if (node->left) {
+                auto* left = node->left;
+                node->left = left->right;
+                left->right = node;
+                node = left;
+                continue;
+            }
+            auto* next = node->right;
+            delete node;
+            node = next;
+        }
+        m_root = nullptr;
+        m_size = 0;
+    }
+
+    using Iterator = RedBlackTreeIterator<RedBlackTree, V>;
+    friend Iterator;
+    Iterator begin() { return Iterator(leftmost(m_root)); }
+    Iterator end() { return Iterator(nullptr); }
+
+    using ConstIterator = RedBlackTreeIterator<const RedBlackTree, const V>;
+    friend ConstIterator;
+    ConstIterator begin() const { return ConstIterator(leftmost(m_root)); }
+    ConstIterator end() const { return ConstIterator(nullptr); }
+
+    // Returns an iterator positioned at the given key, or end() if it's not in the tree.
+    Iterator find_iterator(K key) { return Iterator(find_node(key)); }
+    // Returns an iterator positioned at the first key that is >= the given key.
+    Iterator lower_bound(K key)
+    {
+        Node* candidate = nullptr;
+        for (auto* node = m_root; node;) {
+            if (!(node->key < key)) {
+                candidate = node;
+                node = node->left;
+            } else {
+                node = node->right;
+            }
+        }
+        return Iterator(candidate);
+    }
+
+private:
+    Node* find_node(K key) const
+    {
+        auto* node = m_root;
+        while (node && node->key != key)
+            node = key < node->key ? node->left : node->right;
+        return node;
+    }
+
+    static Node* leftmost(Node* node)
+    {
+        if (!node)
+            return nullptr;
+        while (node->left)
+            node = node->left;
+        return node;
+    }
+
+    static Node* successor(Node* node)
+    {
+        if (node->right)
+            return leftmost(node->right);
+        auto* parent = node->parent;
+        while (parent && node == parent->right) {
+            node = parent;
+            parent = parent->parent;
+        }
+        return parent;
+    }
+
+    static bool is_red(const Node* node) { return node && node->is_red; }
+
+    void rotate_left(Node* node)
+    {
+        auto* pivot = node->right;
+        node->right = pivot->left;
+        if (pivot->left)
+            pivot->left->parent = node;
+        pivot->parent = node->parent;
+        if (!node->parent)
+            m_root = pivot;
+        else if (node == node->parent->left)
+            node->parent->left = pivot;
+        else
+            node->parent->right = pivot;
+        pivot->left = node;
+        node->parent = pivot;
+    }
+
+    void rotate_right(Node* node)
+    {
+        auto* pivot = node->left;
+        node->left = pivot->right;
+        if (pivot->right)
+            pivot->right->parent = node;
+        pivot->parent = node->parent;
+        if (!node->parent)
+            m_root = pivot;
+        else if (node == node->parent->right)
+            node->parent->right = pivot;
+        else
+            node->parent->left = pivot;
+        pivot->right = node;
+        node->parent = pivot;
+    }
+
+    void insert_fixups(Node* node)
+    {
+        while (is_red(node->parent)) {
+            auto* parent = node->parent;
+            auto* grandparent = parent->parent;
+            if (parent == grandparent->left) {
+                auto* uncle = grandparent->right;
+                if (is_red(uncle)) {
+                    parent->is_red = false;
+                    uncle->is_red = false;
+                    grandparent->is_red = true;
+                    node = grandparent;
+                    continue;
+                }
+                if (node == parent->right) {
+                    node = parent;
+                    rotate_left(node);
+                    parent = node->parent;
+                }
+                parent->is_red = false;
+                grandparent->is_red = true;
+                rotate_right(grandparent);
+            } else {
+                auto* uncle = grandparent->left;
+                if (is_red(uncle)) {
+                    parent->is_red = false;
+                    uncle->is_red = false;
+                    grandparent->is_red = true;
+                    node = grandparent;
+                    continue;
+                }
+                if (node == parent->left) {
+                    node = parent;
+                    rotate_right(node);
+                    parent = node->parent;
+                }
+                parent->is_red = false;
+                grandparent->is_red = true;
+                rotate_left(grandparent);
+            }
+        }
+        m_root->is_red = false;
+    }
+
+    void transplant(Node* old_node, Node* new_node)
+    {
+        if (!old_node->parent)
+            m_root = new_node;
+        else if (old_node == old_node->parent->left)
+            old_node->parent->left = new_node;
+        else
+            old_node->parent->right = new_node;
+        if (new_node)
+            new_node->parent = old_node->parent;
+    }
+
+    void remove_node(Node* node)
+    {
+        VERIFY(m_size > 0);
+        --m_size;
+
+        Node* child;
+        Node* child_parent;
+        bool removed_black = !node->is_red;
+
+        if (!node->left) {
+            child = node->right;
+            child_parent = node->parent;
+            transplant(node, node->right);
+        } else if (!node->right) {
+            child = node->left;
+            child_parent = node->parent;
+            transplant(node, node->left);
+        } else {
+            auto* replacement = leftmost(node->right);
+            removed_black = !replacement->is_red;
+            child = replacement->right;
+            if (replacement->parent == node) {
+                child_parent = replacement;
+            } else {
+                child_parent = replacement->parent;
+                transplant(replacement, replacement->right);
+                replacement->right = node->right;
+                replacement->right->parent = replacement;
+            }
+            transplant(node, replacement);
+            replacement->left = node->left;
+            replacement->left->parent = replacement;
+            replacement->is_red = node->is_red;
+        }
+
+        if (removed_black)
+            remove_fixups(child, child_parent);
+    }
+
+    void remove_fixups(Node* node, Node* parent)
+    {
+        while (node != m_root && !is_red(node)) {
+            if (node == parent->left) {
+                auto* sibling = parent->right;
+                if (is_red(sibling)) {
+                    sibling->is_red = false;
+                    parent->is_red = true;
+                    rotate_left(parent);
+                    sibling = parent->right;
+                }
+                if (!is_red(sibling->left) && !is_red(sibling->right)) {
+                    sibling->is_red = true;
+                    node = parent;
+                    parent = node->parent;
+                    continue;
+                }
+                if (!is_red(sibling->right)) {
+                    sibling->left->is_red = false;
+                    sibling->is_red = true;
+                    rotate_right(sibling);
+                    sibling = parent->right;
+                }
+                sibling->is_red = parent->is_red;
+                parent->is_red = false;
+                sibling->right->is_red = false;
+                rotate_left(parent);
+                node = m_root;
+            } else {
+                auto* sibling = parent->left;
+                if (is_red(sibling)) {
+                    sibling->is_red = false;
+                    parent->is_red = true;
+                    rotate_right(parent);
+                    sibling = parent->left;
+                }
+                if (!is_red(sibling->left) && !is_red(sibling->right)) {
+                    sibling->is_red = true;
+                    node = parent;
+                    parent = node->parent;
+                    continue;
+                }
+                if (!is_red(sibling->left)) {
+                    sibling->right->is_red = false;
+                    sibling->is_red = true;
+                    rotate_left(sibling);
+                    sibling = parent->left;
+                }
+                sibling->is_red = parent->is_red;
+                parent->is_red = false;
+                sibling->left->is_red = false;
+                rotate_right(parent);
+                node = m_root;
+            }
+        }
+        if (node)
+            node->is_red = false;
+    }
+
+    Node* m_root { nullptr };
+    size_t m_size { 0 };
+};
+
+template<typename TreeType, typename ElementType>
+class RedBlackTreeIterator {
+public:
+    RedBlackTreeIterator() = default;
+
+    bool operator!=(const RedBlackTreeIterator& other) const { return m_node != other.m_node; }
+    bool operator==(const RedBlackTreeIterator& other) const { return m_node == other.m_node; }
+    RedBlackTreeIterator& operator++()
+    {
+        m_node = TreeType::successor(m_node);
+        return *this;
+    }
+    ElementType& operator*() { return m_node->value; }
+    ElementType* operator->() { return &m_node->value; }
+    [[nodiscard]] bool is_end() const { return !m_node; }
+    [[nodiscard]] auto key() const { return m_node->key; }
+
+private:
+    using MutableTreeType = typename RemoveConst<TreeType>::Type;
+    using NodeType = typename MutableTreeType::Node;
+    friend MutableTreeType;
+    explicit RedBlackTreeIterator(NodeType* node)
+        : m_node(node)
+    {
+    }
+
+    NodeType* m_node { nullptr };
+};
+
+}
+
+using AK::RedBlackTree;
@@ -24,6 +24,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Atomic.h>
 #include <AK/Debug.h>
 #include <AK/FlyString.h>
 #include <AK/HashTable.h>
@@ -86,6 +87,41 @@ static inline size_t allocation_size_for_stringimpl(size_t length)
     return sizeof(StringImpl) + (sizeof(char) * length) + sizeof(char);
 }
 
+// Short strings (identifiers, keywords, JSON keys, single characters...) tend to be created
+// over and over again, so the most recently created ones are kept in a small direct-mapped
+// cache, and we hand out another reference instead of allocating a copy. The cache owns one
+// reference to each entry. Slots are only accessed with atomic exchanges, so no lock is needed.
+static constexpr size_t max_short_string_length = 15;
+static constexpr size_t short_string_cache_size = 512;
+static Atomic<StringImpl*> s_short_string_cache[short_string_cache_size];
+
+NonnullRefPtr<StringImpl> StringImpl::create_short(const char* cstring, size_t length)
+{
+    auto hash = string_hash(cstring, length);
+    auto& slot = s_short_string_cache[hash % short_string_cache_size];
+
+    auto* cached = slot.exchange(nullptr, AK::memory_order_acquire);
+    if (cached && cached->length() == length && !__builtin_memcmp(cached->characters(), cstring, length)) {
+        NonnullRefPtr<StringImpl> result = *cached;
+        if (auto* replaced = slot.exchange(cached, AK::memory_order_acq_rel))
+            replaced->unref();
+        return result;
+    }
+
+    char* buffer;
+    auto new_stringimpl = create_uninitialized(length, buffer);
+    memcpy(buffer, cstring, length * sizeof(char));
+    new_stringimpl->m_hash = hash;
+    new_stringimpl->m_has_hash = true;
+
+    new_stringimpl->ref();
+    if (auto* replaced = slot.exchange(new_stringimpl.ptr(), AK::memory_order_acq_rel))
+        replaced->unref();
+    if (cached)
+        cached->unref();
+    return new_stringimpl;
+}
+
 NonnullRefPtr<StringImpl> StringImpl::create_uninitialized(size_t length, char*& buffer)
 {
     VERIFY(length);
@@ -115,6 +151,9 @@ RefPtr<StringImpl> StringImpl::create(const char* cstring, size_t length, Should
     if (!length)
         return the_empty_stringimpl();
 
+    if (length <= max_short_string_length)
+        return create_short(cstring, length);
+
     char* buffer;
     auto new_stringimpl = create_uninitialized(length, buffer);
     memcpy(buffer, cstring, length * sizeof(char));
@@ -193,11 +232,9 @@ slow_path:
 
 void StringImpl::compute_hash() const
 {
-    if (!length())
-        m_hash = 0;
-    else
-        m_hash = string_hash(characters(), m_length);
-    m_has_hash = true;
+    unsigned hash = length() ? string_hash(characters(), m_length) : 0;
+    AK::atomic_store(&m_hash, hash, AK::memory_order_relaxed);
+    AK::atomic_store(&m_has_hash, true, AK::memory_order_release);
 }
 
 }
@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <AK/Atomic.h>
 #include <AK/Badge.h>
 #include <AK/RefCounted.h>
 #include <AK/RefPtr.h>
@@ -77,20 +78,22 @@ public:
         return !__builtin_memcmp(characters(), other.characters(), length());
     }
 
+    // The hash and the fly flag may be looked at by several threads at once (see FlyString),
+    // so they are accessed atomically. Racing to compute the hash is harmless.
     unsigned hash() const
     {
-        if (!m_has_hash)
+        if (!AK::atomic_load(&m_has_hash, AK::memory_order_acquire))
             compute_hash();
-        return m_hash;
+        return AK::atomic_load(&m_hash, AK::memory_order_relaxed);
     }
 
     unsigned existing_hash() const
     {
-        return m_hash;
+        return AK::atomic_load(&m_hash, AK::memory_order_relaxed);
     }
 
-    bool is_fly() const { return m_fly; }
-    void set_fly(Badge<FlyString>, bool fly) const { m_fly = fly; }
+    bool is_fly() const { return AK::atomic_load(&m_fly, AK::memory_order_relaxed); }
+    void set_fly(Badge<FlyString>, bool fly) const { AK::atomic_store(&m_fly, fly, AK::memory_order_relaxed); }
 
 private:
     enum ConstructTheEmptyStringImplTag {
@@ -107,6 +110,8 @@ private:
     };
     StringImpl(ConstructWithInlineBufferTag, size_t length);
 
+    static NonnullRefPtr<StringImpl> create_short(const char* cstring, size_t length);
+
     void compute_hash() const;
 
     size_t m_length { 0 };
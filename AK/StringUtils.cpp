@@ -296,10 +296,8 @@ bool contains(const StringView& str, const StringView& needle, CaseSensitivity c
         if (to_lowercase(str_chars[si]) != needle_first)
             continue;
         for (size_t ni = 0; si + ni < str.length(); ni++) {
-            if (to_lowercase(str_chars[si + ni]) != to_lowercase(needle_chars[ni])) {
-                si += ni;
+            if (to_lowercase(str_chars[si + ni]) != to_lowercase(needle_chars[ni]))
                 break;
-            }
             if (ni + 1 == needle.length())
                 return true;
         }
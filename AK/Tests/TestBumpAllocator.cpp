@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/TestSuite.h>
+
+#include <AK/BumpAllocator.h>
+#include <AK/RefCounted.h>
+#include <AK/RefPtr.h>
+#include <AK/Vector.h>
+#include <string.h>
+
+TEST_CASE(allocations_are_aligned_and_disjoint)
+{
+    BumpAllocator allocator;
+    Vector<u8*> allocations;
+    for (size_t i = 0; i < 10000; ++i) {
+        size_t alignment = 1 << (i % 6);
+        auto* ptr = (u8*)allocator.allocate(i % 100 + 1, alignment);
+        EXPECT_EQ((FlatPtr)ptr % alignment, 0u);
+        memset(ptr, (u8)i, i % 100 + 1);
+        allocations.append(ptr);
+    }
+    for (size_t i = 0; i < allocations.size(); ++i) {
+        for (size_t j = 0; j < i % 100 + 1; ++j)
+            EXPECT_EQ(allocations[i][j], (u8)i);
+        BumpAllocator::deallocate(allocations[i]);
+    }
+    allocator.release_current_chunk();
+}
+
+TEST_CASE(large_allocations)
+{
+    BumpAllocator allocator;
+    auto* small = (u8*)allocator.allocate(16);
+    auto* large = (u8*)allocator.allocate(3 * BumpAllocator::chunk_size);
+    auto* after = (u8*)allocator.allocate(16);
+    memset(large, 0xaa, 3 * BumpAllocator::chunk_size);
+    memset(small, 0x55, 16);
+    memset(after, 0x55, 16);
+    EXPECT_EQ(large[0], 0xaa);
+    EXPECT_EQ(large[3 * BumpAllocator::chunk_size - 1], 0xaa);
+    BumpAllocator::deallocate(large);
+    BumpAllocator::deallocate(small);
+    BumpAllocator::deallocate(after);
+    allocator.release_current_chunk();
+}
+
+static int s_live_objects;
+
+struct Object {
+    explicit Object(int value)
+        : value(value)
+    {
+        ++s_live_objects;
+    }
+    ~Object() { --s_live_objects; }
+    int value { 0 };
+};
+
+TEST_CASE(typed_allocation)
+{
+    BumpAllocator allocator;
+    Vector<Object*> objects;
+    for (int i = 0; i < 50000; ++i)
+        objects.append(allocator.allocate_object<Object>(i));
+    EXPECT_EQ(s_live_objects, 50000);
+    allocator.release_current_chunk();
+    for (int i = 0; i < 50000; ++i) {
+        EXPECT_EQ(objects[i]->value, i);
+        BumpAllocator::deallocate_object(objects[i]);
+    }
+    EXPECT_EQ(s_live_objects, 0);
+}
+
+class Node : public RefCounted<Node> {
+    AK_MAKE_BUMP_ALLOCATED(Node)
+public:
+    explicit Node(RefPtr<Node> next)
+        : m_next(move(next))
+    {
+        ++s_live_objects;
+    }
+    virtual ~Node() { --s_live_objects; }
+
+private:
+    RefPtr<Node> m_next;
+};
+
+class BigNode final : public Node {
+public:
+    using Node::Node;
+
+private:
+    u8 m_payload[200] {};
+};
+
+TEST_CASE(bump_allocated_class)
+{
+    RefPtr<Node> list;
+    for (int i = 0; i < 10000; ++i) {
+        if (i % 3)
+            list = adopt(*new Node(move(list)));
+        else
+            list = adopt(*new BigNode(move(list)));
+    }
+    EXPECT_EQ(s_live_objects, 10000);
+    // Keep one node alive past the rest of its chunk.
+    RefPtr<Node> survivor = adopt(*new Node(nullptr));
+    list = nullptr;
+    EXPECT_EQ(s_live_objects, 1);
+    survivor = nullptr;
+    EXPECT_EQ(s_live_objects, 0);
+}
+
+TEST_MAIN(BumpAllocator)
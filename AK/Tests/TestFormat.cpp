@@ -263,6 +263,34 @@ TEST_CASE(floating_point_numbers)
     EXPECT_EQ(String::formatted("{:x>5.1}", 1.12), "xx1.1");
 }
 
+TEST_CASE(shortest_floating_point_numbers)
+{
+    EXPECT_EQ(String::formatted("{:g}", 0.1), "0.1");
+    EXPECT_EQ(String::formatted("{:g}", 0.3), "0.3");
+    EXPECT_EQ(String::formatted("{:g}", 1.), "1.0");
+    EXPECT_EQ(String::formatted("{:g}", -0.), "-0.0");
+    EXPECT_EQ(String::formatted("{:g}", 123456.789), "123456.789");
+    EXPECT_EQ(String::formatted("{:g}", 1e15), "1000000000000000.0");
+    EXPECT_EQ(String::formatted("{:g}", 1e16), "1e+16");
+    EXPECT_EQ(String::formatted("{:g}", 0.0001), "0.0001");
+    EXPECT_EQ(String::formatted("{:g}", 1.2345e-5), "1.2345e-5");
+    EXPECT_EQ(String::formatted("{:g}", 5e-324), "5e-324");
+    EXPECT_EQ(String::formatted("{:g}", 1.7976931348623157e308), "1.7976931348623157e+308");
+    EXPECT_EQ(String::formatted("{:g}", __builtin_inf()), "inf");
+    EXPECT_EQ(String::formatted("{:+g}", 2.5), "+2.5");
+    EXPECT_EQ(String::formatted("{:>6g}", 2.5), "   2.5");
+    EXPECT_EQ(String::formatted("{:.2g}", 2.5), "2.50");
+}
+
+TEST_CASE(integer_extremes)
+{
+    EXPECT_EQ(String::formatted("{}", NumericLimits<u64>::max()), "18446744073709551615");
+    EXPECT_EQ(String::formatted("{}", NumericLimits<i64>::min()), "-9223372036854775808");
+    EXPECT_EQ(String::formatted("{:o}", NumericLimits<u32>::max()), "37777777777");
+    EXPECT_EQ(String::formatted("{:X}", 0xdeadbeefcafeull), "DEADBEEFCAFE");
+    EXPECT_EQ(String::formatted("{:b}", 0), "0");
+}
+
 TEST_CASE(no_precision_no_trailing_number)
 {
     EXPECT_EQ(String::formatted("{:.0}", 0.1), "0.");
@@ -28,7 +28,9 @@
 
 #include <AK/HashMap.h>
 #include <AK/JsonArray.h>
+#include <AK/JsonDocument.h>
 #include <AK/JsonObject.h>
+#include <AK/JsonStreamParser.h>
 #include <AK/JsonValue.h>
 #include <AK/String.h>
 #include <AK/StringBuilder.h>
@@ -142,4 +144,127 @@ TEST_CASE(json_duplicate_keys)
     EXPECT_EQ(json.to_string(), "{\"test\":\"baz\"}");
 }
 
+TEST_CASE(json_double_round_trip)
+{
+    for (double value : { 0.1, -0.5, 1.0, 2.5e-300, 1.7976931348623157e308, -123456.789 }) {
+        JsonValue json(value);
+        auto parsed = JsonValue::from_string(json.to_string());
+        EXPECT(parsed.has_value());
+        EXPECT(parsed->is_double());
+        EXPECT_EQ(parsed->as_double(), value);
+    }
+}
+
+TEST_CASE(json_stream_events)
+{
+    class Recorder final : public JsonStreamVisitor {
+    public:
+        virtual bool on_object_start() override { return append("{"); }
+        virtual bool on_object_key(const JsonRawString& key) override { return append(String::formatted("{}:", key.to_string())); }
+        virtual bool on_object_end() override { return append("}"); }
+        virtual bool on_array_start() override { return append("["); }
+        virtual bool on_array_end() override { return append("]"); }
+        virtual bool on_string(const JsonRawString& string) override { return append(String::formatted("'{}'", string.to_string())); }
+        virtual bool on_number(const StringView& literal) override { return append(literal); }
+        virtual bool on_bool(bool value) override { return append(value ? "true" : "false"); }
+        virtual bool on_null() override { return append("null"); }
+
+        StringBuilder events;
+
+    private:
+        bool append(const StringView& event)
+        {
+            events.append(event);
+            events.append(' ');
+            return true;
+        }
+    };
+
+    Recorder recorder;
+    EXPECT(JsonStreamParser(" { \"a\" : [1, -2.5e3, true, null], \"b\\n\": { }, \"c\": \"x\\u0041\" } ").parse(recorder));
+    EXPECT_EQ(recorder.events.to_string(), "{ a: [ 1 -2.5e3 true null ] b\n: { } c: 'xA' } ");
+}
+
+TEST_CASE(json_stream_rejects_malformed_input)
+{
+    JsonStreamVisitor visitor;
+    EXPECT(!JsonStreamParser("[1,]").parse(visitor));
+    EXPECT(!JsonStreamParser("{\"a\" 1}").parse(visitor));
+    EXPECT(!JsonStreamParser("[1 2]").parse(visitor));
+    EXPECT(!JsonStreamParser("[1").parse(visitor));
+    EXPECT(!JsonStreamParser("\"abc").parse(visitor));
+    EXPECT(!JsonStreamParser("1 2").parse(visitor));
+    EXPECT(!JsonStreamParser("-").parse(visitor));
+    EXPECT(JsonStreamParser("[[[[]]]]").parse(visitor));
+}
+
+TEST_CASE(json_stream_visitor_can_stop)
+{
+    class FirstNumber final : public JsonStreamVisitor {
+    public:
+        virtual bool on_number(const StringView& literal) override
+        {
+            number = literal;
+            return false;
+        }
+        StringView number;
+    };
+
+    FirstNumber visitor;
+    JsonStreamParser parser("[\"x\", 42, 43]");
+    EXPECT(!parser.parse(visitor));
+    EXPECT_EQ(visitor.number, "42");
+    EXPECT_EQ(parser.offset(), 8u);
+}
+
+TEST_CASE(json_document)
+{
+    StringView input = "{\"name\": \"Form1\", \"size\": [640, 480], \"ratio\": 1.5, \"big\": 5000000000, \"escaped\\\"key\": \"a\\tb\", \"nested\": {\"ok\": true, \"none\": null}}";
+    auto document = JsonDocument::parse(input);
+    EXPECT(document.has_value());
+
+    auto root = document->root();
+    EXPECT(root.is_object());
+    EXPECT_EQ(root.size(), 6u);
+
+    auto name = root.get("name");
+    EXPECT(name.has_value());
+    EXPECT(!name->as_raw_string().has_escapes());
+    EXPECT_EQ(name->as_raw_string().raw().characters_without_null_termination(), input.characters_without_null_termination() + 10);
+    EXPECT_EQ(name->as_string(), "Form1");
+
+    auto size = root.get("size").value();
+    EXPECT(size.is_array());
+    EXPECT_EQ(size.size(), 2u);
+    EXPECT_EQ(size.at(1).to_i64().value(), 480);
+    EXPECT_EQ(root.get("ratio")->to_double(), 1.5);
+    EXPECT_EQ(root.get("big")->to_u64().value(), 5000000000ull);
+    EXPECT_EQ(root.get("escaped\"key")->as_string(), "a\tb");
+    EXPECT(root.get("nested")->get("ok")->as_bool());
+    EXPECT(root.get("nested")->get("none")->is_null());
+    EXPECT(!root.get("missing").has_value());
+
+    size_t members = 0;
+    root.for_each_member([&](auto& key, auto value) {
+        ++members;
+        if (key == "size")
+            EXPECT(value.is_array());
+    });
+    EXPECT_EQ(members, 6u);
+
+    auto value = root.to_json_value();
+    EXPECT_EQ(value.as_object().get("name").as_string(), "Form1");
+    EXPECT_EQ(value.as_object().get("size").as_array().at(0).as_u32(), 640u);
+    EXPECT_EQ(value.as_object().get("big").as_i64(), 5000000000ll);
+}
+
+TEST_CASE(json_document_matches_json_parser)
+{
+    StringView input = "[{\"pid\": 1, \"name\": \"Init\\u00e9\", \"cpu\": -3, \"flags\": [false, true]}, [], {}, \"\", 0]";
+    auto document = JsonDocument::parse(input);
+    EXPECT(document.has_value());
+    EXPECT_EQ(document->root().to_json_value().to_string(), JsonValue::from_string(input).value().to_string());
+    EXPECT(!JsonDocument::parse("[1,]").has_value());
+}
+
 TEST_MAIN(JSON)
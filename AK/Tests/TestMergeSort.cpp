@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/TestSuite.h>
+
+#include <AK/MergeSort.h>
+#include <AK/Noncopyable.h>
+#include <AK/Vector.h>
+
+TEST_CASE(sorts)
+{
+    Vector<int> data;
+    for (int i = 0; i < 1000; i++)
+        data.append((i * 7919) % 1000);
+    merge_sort(data);
+    for (int i = 0; i < 1000; i++)
+        EXPECT_EQ(data[i], i);
+}
+
+TEST_CASE(is_stable)
+{
+    struct Item {
+        int key;
+        int original_index;
+    };
+    Vector<Item> data;
+    for (int i = 0; i < 1000; i++)
+        data.append({ (i * 31) % 10, i });
+    merge_sort(data, [](auto& a, auto& b) { return a.key < b.key; });
+    for (int i = 0; i < 999; i++) {
+        EXPECT(data[i].key <= data[i + 1].key);
+        if (data[i].key == data[i + 1].key)
+            EXPECT(data[i].original_index < data[i + 1].original_index);
+    }
+}
+
+TEST_CASE(sorts_without_copy)
+{
+    struct NoCopy {
+        AK_MAKE_NONCOPYABLE(NoCopy);
+
+    public:
+        NoCopy(int value)
+            : value(value)
+        {
+        }
+        NoCopy(NoCopy&&) = default;
+
+        NoCopy& operator=(NoCopy&&) = default;
+
+        int value { 0 };
+    };
+
+    Vector<NoCopy> data;
+    for (int i = 0; i < 100; i++)
+        data.append(NoCopy { 100 - i });
+    merge_sort(data, [](auto& a, auto& b) { return a.value < b.value; });
+    for (int i = 0; i < 99; i++)
+        EXPECT(data[i].value < data[i + 1].value);
+}
+
+TEST_MAIN(MergeSort)
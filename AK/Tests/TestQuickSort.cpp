@@ -30,6 +30,7 @@
 #include <AK/Noncopyable.h>
 #include <AK/QuickSort.h>
 #include <AK/StdLibExtras.h>
+#include <AK/Vector.h>
 
 TEST_CASE(sorts_without_copy)
 {
@@ -119,4 +120,47 @@ TEST_CASE(maximum_stack_depth)
     delete[] data;
 }
 
+TEST_CASE(sorted_and_adversarial_inputs)
+{
+    const int size = 10000;
+    Vector<int> data;
+    auto check_sorted = [&] {
+        for (int i = 0; i < size - 1; i++)
+            EXPECT(data[i] <= data[i + 1]);
+    };
+
+    // Already sorted, reverse sorted and all equal inputs used to make the dual pivot
+    // quick sort go quadratic and recurse once per element.
+    data.clear();
+    for (int i = 0; i < size; i++)
+        data.append(i);
+    quick_sort(data);
+    check_sorted();
+
+    data.clear();
+    for (int i = 0; i < size; i++)
+        data.append(size - i);
+    quick_sort(data);
+    check_sorted();
+
+    data.clear();
+    for (int i = 0; i < size; i++)
+        data.append(7);
+    quick_sort(data);
+    check_sorted();
+
+    // Organ pipe, sorted with both the collection and the iterator variant.
+    data.clear();
+    for (int i = 0; i < size; i++)
+        data.append(i < size / 2 ? i : size - i);
+    quick_sort(data);
+    check_sorted();
+
+    data.clear();
+    for (int i = 0; i < size; i++)
+        data.append(i < size / 2 ? i : size - i);
+    quick_sort(data.begin(), data.end());
+    check_sorted();
+}
+
 TEST_MAIN(QuickSort)
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/TestSuite.h>
+
+#include <AK/Array.h>
+#include <AK/OwnPtr.h>
+#include <AK/Random.h>
+#include <AK/RedBlackTree.h>
+#include <AK/Vector.h>
+
+TEST_CASE(construct)
+{
+    RedBlackTree<int, int> empty;
+    EXPECT(empty.is_empty());
+    EXPECT_EQ(empty.size(), 0u);
+    EXPECT(empty.begin() == empty.end());
+}
+
+TEST_CASE(insert_and_find)
+{
+    RedBlackTree<int, int> tree;
+    for (int i = 0; i < 100; ++i)
+        tree.insert(i * 2, i);
+    EXPECT_EQ(tree.size(), 100u);
+    for (int i = 0; i < 100; ++i) {
+        auto* value = tree.find(i * 2);
+        EXPECT(value);
+        EXPECT_EQ(*value, i);
+        EXPECT(!tree.find(i * 2 + 1));
+    }
+    EXPECT(!tree.try_insert(10, 1234));
+    EXPECT_EQ(*tree.find(10), 5);
+}
+
+TEST_CASE(iterates_in_key_order)
+{
+    RedBlackTree<u32, u32> tree;
+    for (u32 i = 0; i < 1000; ++i) {
+        u32 key = get_random<u32>();
+        tree.try_insert(key, key);
+    }
+    bool first = true;
+    u32 previous = 0;
+    size_t count = 0;
+    for (auto it = tree.begin(); it != tree.end(); ++it) {
+        EXPECT_EQ(*it, it.key());
+        if (!first)
+            EXPECT(previous < it.key());
+        previous = it.key();
+        first = false;
+        ++count;
+    }
+    EXPECT_EQ(count, tree.size());
+}
+
+TEST_CASE(closest_key_lookups)
+{
+    RedBlackTree<int, int> tree;
+    tree.insert(10, 1);
+    tree.insert(20, 2);
+    tree.insert(30, 3);
+
+    EXPECT(!tree.find_largest_not_above(9));
+    EXPECT_EQ(*tree.find_largest_not_above(10), 1);
+    EXPECT_EQ(*tree.find_largest_not_above(25), 2);
+    EXPECT_EQ(*tree.find_largest_not_above(1000), 3);
+
+    EXPECT_EQ(*tree.find_smallest_not_below(0), 1);
+    EXPECT_EQ(*tree.find_smallest_not_below(11), 2);
+    EXPECT_EQ(*tree.find_smallest_not_below(30), 3);
+    EXPECT(!tree.find_smallest_not_below(31));
+
+    EXPECT_EQ(tree.lower_bound(15).key(), 20);
+    EXPECT(tree.lower_bound(31).is_end());
+}
+
+TEST_CASE(remove)
+{
+    RedBlackTree<int, int> tree;
+    Vector<int> keys;
+    for (int i = 0; i < 512; ++i) {
+        tree.insert(i, i);
+        keys.append(i);
+    }
+    // Remove in a scrambled order to exercise all the rebalancing cases.
+    for (size_t i = keys.size() - 1; i > 0; --i)
+        swap(keys[i], keys[get_random<u32>() % (i + 1)]);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        EXPECT(tree.remove(keys[i]));
+        EXPECT(!tree.find(keys[i]));
+        EXPECT(!tree.remove(keys[i]));
+        EXPECT_EQ(tree.size(), keys.size() - i - 1);
+    }
+    EXPECT(tree.is_empty());
+}
+
+TEST_CASE(take_move_only_values)
+{
+    RedBlackTree<int, OwnPtr<int>> tree;
+    tree.insert(1, make<int>(100));
+    tree.insert(2, make<int>(200));
+    auto value = tree.take(1);
+    EXPECT_EQ(*value, 100);
+    EXPECT_EQ(tree.size(), 1u);
+    EXPECT_EQ(**tree.find(2), 200);
+    tree.clear();
+    EXPECT(tree.is_empty());
+}
+
+TEST_CASE(random_inserts_and_removes)
+{
+    RedBlackTree<u32, u32> tree;
+    Array<bool, 256> present {};
+    size_t expected_size = 0;
+    for (size_t i = 0; i < 10000; ++i) {
+        u32 key = get_random<u32>() % 256;
+        if (get_random<u32>() % 2) {
+            bool inserted = tree.try_insert(key, key);
+            EXPECT_EQ(inserted, !present[key]);
+            if (!present[key])
+                ++expected_size;
+            present[key] = true;
+        } else {
+            bool removed = tree.remove(key);
+            EXPECT_EQ(removed, present[key]);
+            if (present[key])
+                --expected_size;
+            present[key] = false;
+        }
+        EXPECT_EQ(tree.size(), expected_size);
+    }
+    u32 expected_key = 0;
+    for (auto it = tree.begin(); it != tree.end(); ++it) {
+        while (!present[expected_key])
+            ++expected_key;
+        EXPECT_EQ(it.key(), expected_key);
+        ++expected_key;
+    }
+}
+
+TEST_MAIN(RedBlackTree)
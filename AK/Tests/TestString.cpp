@@ -256,4 +256,28 @@ TEST_CASE(sprintf)
     EXPECT_EQ(String(buf2), String("-12"));
 }
 
+TEST_CASE(short_strings_are_shared)
+{
+    StringBuilder builder;
+    builder.append("col");
+    builder.append("or");
+    String built = builder.build();
+    String literal = "color";
+    EXPECT_EQ(built, literal);
+    EXPECT_EQ(built.impl(), literal.impl());
+
+    // Long strings still get an impl of their own.
+    String long_string = "a string that is too long to be shared";
+    String other_long_string = "a string that is too long to be shared";
+    EXPECT_EQ(long_string, other_long_string);
+    EXPECT(long_string.impl() != other_long_string.impl());
+
+    // Dropping every String must not free a shared impl from under the cache.
+    {
+        String temporary = "temporary";
+    }
+    String again = "temporary";
+    EXPECT_EQ(again, "temporary");
+}
+
 TEST_MAIN(String)
@@ -286,6 +286,7 @@ TEST_CASE(contains)
     EXPECT(!AK::StringUtils::contains("", test_string, CaseSensitivity::CaseInsensitive));
     EXPECT(!AK::StringUtils::contains(test_string, "L", CaseSensitivity::CaseSensitive));
     EXPECT(!AK::StringUtils::contains(test_string, "L", CaseSensitivity::CaseInsensitive));
+    EXPECT(AK::StringUtils::contains("AAB", "ab", CaseSensitivity::CaseInsensitive));
 }
 
 TEST_CASE(is_whitespace)
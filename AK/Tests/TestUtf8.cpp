@@ -88,4 +88,43 @@ TEST_CASE(validate_invalid_ut8)
     EXPECT(valid_bytes == 0);
 }
 
+TEST_CASE(validate_around_ascii_runs)
+{
+    // Put a multi-byte sequence (valid or broken) at every offset of a long ASCII string, so that it shows up
+    // at every position within the blocks of ASCII that are checked at once.
+    for (size_t offset = 0; offset < 40; ++offset) {
+        char buffer[64];
+        __builtin_memset(buffer, 'a', sizeof(buffer) - 1);
+        buffer[sizeof(buffer) - 1] = 0;
+
+        buffer[offset] = (char)0xc3;
+        buffer[offset + 1] = (char)0xa9;
+        Utf8View valid { buffer };
+        size_t valid_bytes;
+        EXPECT(valid.validate(valid_bytes));
+        EXPECT_EQ(valid_bytes, sizeof(buffer) - 1);
+        EXPECT_EQ(valid.length(), sizeof(buffer) - 2);
+
+        size_t code_points = 0;
+        for (auto code_point : valid) {
+            EXPECT_EQ(code_point, code_points == offset ? 0xe9u : 'a');
+            ++code_points;
+        }
+        EXPECT_EQ(code_points, sizeof(buffer) - 2);
+
+        buffer[offset + 1] = 'a';
+        Utf8View invalid { buffer };
+        EXPECT(!invalid.validate(valid_bytes));
+        EXPECT_EQ(valid_bytes, offset);
+    }
+}
+
+TEST_CASE(validate_truncated_sequence)
+{
+    size_t valid_bytes;
+    Utf8View utf8 { "0123456789abcdef0123456789\xe2\x82" };
+    EXPECT(!utf8.validate(valid_bytes));
+    EXPECT_EQ(valid_bytes, 26u);
+}
+
 TEST_MAIN(UTF8)
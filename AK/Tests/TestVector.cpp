@@ -420,4 +420,50 @@ TEST_CASE(should_find_index)
     EXPECT(!v.find_first_index(42).has_value());
 }
 
+TEST_CASE(unchecked_append_and_empend)
+{
+    struct Point {
+        int x;
+        int y;
+    };
+    Vector<Point> points;
+    points.ensure_capacity(100);
+    for (int i = 0; i < 50; ++i) {
+        points.unchecked_append({ i, -i });
+        points.unchecked_empend(-i, i);
+    }
+    EXPECT_EQ(points.size(), 100u);
+    EXPECT_EQ(points.capacity(), 100u);
+    EXPECT_EQ(points[98].x, 49);
+    EXPECT_EQ(points[99].y, 49);
+}
+
+TEST_CASE(try_append)
+{
+    Vector<String, 2> strings;
+    for (int i = 0; i < 100; ++i)
+        EXPECT(strings.try_append(String::number(i)));
+    EXPECT_EQ(strings.size(), 100u);
+    EXPECT_EQ(strings[99], "99");
+
+    Vector<u8> bytes;
+    EXPECT(!bytes.try_ensure_capacity(NumericLimits<size_t>::max()));
+    EXPECT(bytes.is_empty());
+}
+
+TEST_CASE(trivial_elements_survive_growth)
+{
+    Vector<u32> numbers;
+    for (u32 i = 0; i < 100000; ++i)
+        numbers.append(i);
+    for (u32 i = 0; i < 100000; ++i)
+        EXPECT_EQ(numbers[i], i);
+
+    Vector<u32, 4> inline_numbers;
+    for (u32 i = 0; i < 1000; ++i)
+        inline_numbers.append(i);
+    for (u32 i = 0; i < 1000; ++i)
+        EXPECT_EQ(inline_numbers[i], i);
+}
+
 TEST_MAIN(Vector)
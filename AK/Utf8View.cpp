@@ -28,8 +28,37 @@
 #include <AK/LogStream.h>
 #include <AK/Utf8View.h>
 
+#if defined(__SSE2__)
+#    include <emmintrin.h>
+#endif
+
 namespace AK {
 
+// Returns how many bytes at the start of [ptr, end) are ASCII. Most text is, so this checks 16 bytes
+// (or 8, without SSE2) at a time.
+static size_t ascii_run_length(const unsigned char* ptr, const unsigned char* end)
+{
+    auto* start = ptr;
+#if defined(__SSE2__)
+    while (end - ptr >= 16) {
+        u32 mask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)ptr));
+        if (mask != 0)
+            return ptr - start + __builtin_ctz(mask);
+        ptr += 16;
+    }
+#endif
+    while (end - ptr >= 8) {
+        u64 word;
+        __builtin_memcpy(&word, ptr, sizeof(word));
+        if (word & 0x8080808080808080ull)
+            break;
+        ptr += 8;
+    }
+    while (ptr < end && *ptr < 0x80)
+        ++ptr;
+    return ptr - start;
+}
+
 Utf8View::Utf8View(const String& string)
     : m_string(string)
 {
@@ -114,21 +143,29 @@ static inline bool decode_first_byte(
 bool Utf8View::validate(size_t& valid_bytes) const
 {
     valid_bytes = 0;
-    for (auto ptr = begin_ptr(); ptr < end_ptr(); ptr++) {
+    auto* ptr = begin_ptr();
+    auto* end = end_ptr();
+    while (ptr < end) {
+        if (*ptr < 0x80) {
+            ptr += ascii_run_length(ptr, end);
+            valid_bytes = ptr - begin_ptr();
+            continue;
+        }
+
         size_t code_point_length_in_bytes;
         u32 value;
         bool first_byte_makes_sense = decode_first_byte(*ptr, code_point_length_in_bytes, value);
         if (!first_byte_makes_sense)
             return false;
 
+        if ((size_t)(end - ptr) < code_point_length_in_bytes)
+            return false;
         for (size_t i = 1; i < code_point_length_in_bytes; i++) {
-            ptr++;
-            if (ptr >= end_ptr())
-                return false;
-            if (*ptr >> 6 != 2)
+            if (ptr[i] >> 6 != 2)
                 return false;
         }
 
+        ptr += code_point_length_in_bytes;
         valid_bytes += code_point_length_in_bytes;
     }
 
@@ -138,7 +175,22 @@ bool Utf8View::validate(size_t& valid_bytes) const
 size_t Utf8View::calculate_length() const
 {
     size_t length = 0;
-    for ([[maybe_unused]] auto code_point : *this) {
+    auto* ptr = begin_ptr();
+    auto* end = end_ptr();
+    while (ptr < end) {
+        if (*ptr < 0x80) {
+            auto run_length = ascii_run_length(ptr, end);
+            ptr += run_length;
+            length += run_length;
+            continue;
+        }
+
+        size_t code_point_length_in_bytes = 0;
+        u32 value;
+        bool first_byte_makes_sense = decode_first_byte(*ptr, code_point_length_in_bytes, value);
+        VERIFY(first_byte_makes_sense);
+        VERIFY(code_point_length_in_bytes <= (size_t)(end - ptr));
+        ptr += code_point_length_in_bytes;
         ++length;
     }
     return length;
@@ -150,31 +202,16 @@ Utf8CodepointIterator::Utf8CodepointIterator(const unsigned char* ptr, size_t le
 {
 }
 
-bool Utf8CodepointIterator::operator==(const Utf8CodepointIterator& other) const
+size_t Utf8CodepointIterator::multibyte_code_point_length(const unsigned char* ptr, size_t length)
 {
-    return m_ptr == other.m_ptr && m_length == other.m_length;
-}
-
-bool Utf8CodepointIterator::operator!=(const Utf8CodepointIterator& other) const
-{
-    return !(*this == other);
-}
-
-Utf8CodepointIterator& Utf8CodepointIterator::operator++()
-{
-    VERIFY(m_length > 0);
-
     size_t code_point_length_in_bytes = 0;
     u32 value;
-    bool first_byte_makes_sense = decode_first_byte(*m_ptr, code_point_length_in_bytes, value);
+    bool first_byte_makes_sense = decode_first_byte(*ptr, code_point_length_in_bytes, value);
 
     VERIFY(first_byte_makes_sense);
 
-    VERIFY(code_point_length_in_bytes <= m_length);
-    m_ptr += code_point_length_in_bytes;
-    m_length -= code_point_length_in_bytes;
-
-    return *this;
+    VERIFY(code_point_length_in_bytes <= length);
+    return code_point_length_in_bytes;
 }
 
 size_t Utf8CodepointIterator::code_point_length_in_bytes() const
@@ -187,25 +224,23 @@ size_t Utf8CodepointIterator::code_point_length_in_bytes() const
     return code_point_length_in_bytes;
 }
 
-u32 Utf8CodepointIterator::operator*() const
+u32 Utf8CodepointIterator::decode_multibyte_code_point(const unsigned char* ptr, size_t length)
 {
-    VERIFY(m_length > 0);
-
     u32 code_point_value_so_far = 0;
     size_t code_point_length_in_bytes = 0;
 
-    bool first_byte_makes_sense = decode_first_byte(m_ptr[0], code_point_length_in_bytes, code_point_value_so_far);
+    bool first_byte_makes_sense = decode_first_byte(ptr[0], code_point_length_in_bytes, code_point_value_so_far);
     if (!first_byte_makes_sense)
-        dbgln("First byte doesn't make sense, bytes: {}", StringView { (const char*)m_ptr, m_length });
+        dbgln("First byte doesn't make sense, bytes: {}", StringView { (const char*)ptr, length });
     VERIFY(first_byte_makes_sense);
-    if (code_point_length_in_bytes > m_length)
-        dbgln("Not enough bytes (need {}, have {}), first byte is: {:#02x}, '{}'", code_point_length_in_bytes, m_length, m_ptr[0], (const char*)m_ptr);
-    VERIFY(code_point_length_in_bytes <= m_length);
+    if (code_point_length_in_bytes > length)
+        dbgln("Not enough bytes (need {}, have {}), first byte is: {:#02x}, '{}'", code_point_length_in_bytes, length, ptr[0], (const char*)ptr);
+    VERIFY(code_point_length_in_bytes <= length);
 
     for (size_t offset = 1; offset < code_point_length_in_bytes; offset++) {
-        VERIFY(m_ptr[offset] >> 6 == 2);
+        VERIFY(ptr[offset] >> 6 == 2);
         code_point_value_so_far <<= 6;
-        code_point_value_so_far |= m_ptr[offset] & 63;
+        code_point_value_so_far |= ptr[offset] & 63;
     }
 
     return code_point_value_so_far;
@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <AK/Assertions.h>
 #include <AK/StringView.h>
 #include <AK/Types.h>
 
@@ -40,10 +41,37 @@ public:
     Utf8CodepointIterator() = default;
     ~Utf8CodepointIterator() = default;
 
-    bool operator==(const Utf8CodepointIterator&) const;
-    bool operator!=(const Utf8CodepointIterator&) const;
-    Utf8CodepointIterator& operator++();
-    u32 operator*() const;
+    bool operator==(const Utf8CodepointIterator& other) const
+    {
+        return m_ptr == other.m_ptr && m_length == other.m_length;
+    }
+
+    bool operator!=(const Utf8CodepointIterator& other) const
+    {
+        return !(*this == other);
+    }
+
+    Utf8CodepointIterator& operator++()
+    {
+        VERIFY(m_length > 0);
+        if (*m_ptr < 0x80) {
+            ++m_ptr;
+            --m_length;
+        } else {
+            auto code_point_length_in_bytes = multibyte_code_point_length(m_ptr, m_length);
+            m_ptr += code_point_length_in_bytes;
+            m_length -= code_point_length_in_bytes;
+        }
+        return *this;
+    }
+
+    u32 operator*() const
+    {
+        VERIFY(m_length > 0);
+        if (*m_ptr < 0x80)
+            return *m_ptr;
+        return decode_multibyte_code_point(m_ptr, m_length);
+    }
 
     ssize_t operator-(const Utf8CodepointIterator& other) const
     {
@@ -55,6 +83,12 @@ public:
 
 private:
     Utf8CodepointIterator(const unsigned char*, size_t);
+
+    // Out of line and without access to the iterator itself, so that it can stay in registers while
+    // iterating over ASCII.
+    static size_t multibyte_code_point_length(const unsigned char*, size_t length);
+    static u32 decode_multibyte_code_point(const unsigned char*, size_t length);
+
     const unsigned char* m_ptr { nullptr };
     size_t m_length;
 };
@@ -30,6 +30,7 @@
 #include <AK/Find.h>
 #include <AK/Forward.h>
 #include <AK/Iterator.h>
+#include <AK/NumericLimits.h>
 #include <AK/Optional.h>
 #include <AK/Span.h>
 #include <AK/StdLibExtras.h>
@@ -48,8 +49,21 @@
 #    include <new>
 #endif
 
+// Almost everything includes this header, so it doesn't pull in AK/Debug.h and its pile of macros.
+// This has to be the same in every translation unit, so turn it on for the whole build instead.
+#ifndef VECTOR_GROWTH_DEBUG
+#    define VECTOR_GROWTH_DEBUG 0
+#endif
+
 namespace AK {
 
+#if VECTOR_GROWTH_DEBUG && !defined(KERNEL)
+namespace Detail {
+// Counts how often the code at call_site had to reallocate a vector's buffer, see VectorGrowthStatistics.cpp.
+void note_vector_reallocation(const void* call_site, size_t new_capacity, size_t element_size);
+}
+#endif
+
 template<typename T, size_t inline_capacity>
 class Vector {
 public:
@@ -408,6 +422,14 @@ public:
         ++m_size;
     }
 
+    template<class... Args>
+    ALWAYS_INLINE void unchecked_empend(Args&&... args)
+    {
+        VERIFY((size() + 1) <= capacity());
+        new (slot(m_size)) T { forward<Args>(args)... };
+        ++m_size;
+    }
+
     template<class... Args>
     void empend(Args&&... args)
     {
@@ -428,6 +450,21 @@ public:
         append(T(value));
     }
 
+    // Like append(), but returns false instead of crashing if the buffer can't grow.
+    [[nodiscard]] ALWAYS_INLINE bool try_append(T&& value)
+    {
+        if (!try_grow_capacity(size() + 1))
+            return false;
+        new (slot(m_size)) T(move(value));
+        ++m_size;
+        return true;
+    }
+
+    [[nodiscard]] ALWAYS_INLINE bool try_append(const T& value)
+    {
+        return try_append(T(value));
+    }
+
     template<typename U = T>
     void prepend(U&& value)
     {
@@ -476,32 +513,34 @@ public:
         m_size += count;
     }
 
-    void grow_capacity(size_t needed_capacity)
+    ALWAYS_INLINE void grow_capacity(size_t needed_capacity)
     {
         if (m_capacity >= needed_capacity)
             return;
-        ensure_capacity(padded_capacity(needed_capacity));
+        if (!try_reallocate(padded_capacity(needed_capacity)))
+            VERIFY_NOT_REACHED();
     }
 
-    void ensure_capacity(size_t needed_capacity)
+    ALWAYS_INLINE void ensure_capacity(size_t needed_capacity)
     {
         if (m_capacity >= needed_capacity)
             return;
-        size_t new_capacity = needed_capacity;
-        auto* new_buffer = (T*)kmalloc(new_capacity * sizeof(T));
+        if (!try_reallocate(needed_capacity))
+            VERIFY_NOT_REACHED();
+    }
 
-        if constexpr (Traits<T>::is_trivial()) {
-            TypedTransfer<T>::copy(new_buffer, data(), m_size);
-        } else {
-            for (size_t i = 0; i < m_size; ++i) {
-                new (&new_buffer[i]) T(move(at(i)));
-                at(i).~T();
-            }
-        }
-        if (m_outline_buffer)
-            kfree(m_outline_buffer);
-        m_outline_buffer = new_buffer;
-        m_capacity = new_capacity;
+    [[nodiscard]] ALWAYS_INLINE bool try_grow_capacity(size_t needed_capacity)
+    {
+        if (m_capacity >= needed_capacity)
+            return true;
+        return try_reallocate(padded_capacity(needed_capacity));
+    }
+
+    [[nodiscard]] ALWAYS_INLINE bool try_ensure_capacity(size_t needed_capacity)
+    {
+        if (m_capacity >= needed_capacity)
+            return true;
+        return try_reallocate(needed_capacity);
     }
 
     void shrink(size_t new_size, bool keep_capacity = false)
@@ -590,6 +629,49 @@ private:
         return max(static_cast<size_t>(4), capacity + (capacity / 4) + 4);
     }
 
+    // Growing is the slow path of every append, so it's kept out of line to leave the fast path small.
+    // This also makes the return address point into the function that grew the vector.
+    NEVER_INLINE bool try_reallocate(size_t new_capacity)
+    {
+#if VECTOR_GROWTH_DEBUG && !defined(KERNEL)
+        Detail::note_vector_reallocation(__builtin_return_address(0), new_capacity, sizeof(T));
+#endif
+        if (new_capacity > NumericLimits<size_t>::max() / sizeof(T))
+            return false;
+
+        if constexpr (Traits<T>::is_trivial()) {
+            // Trivial elements can be moved by realloc(), which can often grow the buffer in place.
+            if (m_outline_buffer) {
+                auto* new_buffer = (T*)krealloc(m_outline_buffer, new_capacity * sizeof(T));
+                if (!new_buffer)
+                    return false;
+                m_outline_buffer = new_buffer;
+                m_capacity = new_capacity;
+                return true;
+            }
+        }
+
+        auto* new_buffer = (T*)kmalloc(new_capacity * sizeof(T));
+        if (!new_buffer)
+            return false;
+
+        if constexpr (Traits<T>::is_trivial()) {
+            // Outline buffers were realloc()ed above, so whatever is left to move is in the inline buffer.
+            if constexpr (inline_capacity > 0)
+                TypedTransfer<T>::copy(new_buffer, inline_buffer(), m_size);
+        } else {
+            for (size_t i = 0; i < m_size; ++i) {
+                new (&new_buffer[i]) T(move(at(i)));
+                at(i).~T();
+            }
+        }
+        if (m_outline_buffer)
+            kfree(m_outline_buffer);
+        m_outline_buffer = new_buffer;
+        m_capacity = new_capacity;
+        return true;
+    }
+
     T* slot(size_t i) { return &data()[i]; }
     const T* slot(size_t i) const { return &data()[i]; }
 
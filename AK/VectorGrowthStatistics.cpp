@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Atomic.h>
+#include <AK/Debug.h>
+#include <AK/Format.h>
+#include <AK/HashFunctions.h>
+#include <AK/Vector.h>
+#include <stdlib.h>
+
+// With VECTOR_GROWTH_DEBUG, every process logs the places in its code that reallocated vector buffers
+// most often when it exits. Feed the addresses to addr2line (or look them up in Profiler) to find
+// vectors that would benefit from an inline capacity, or from an ensure_capacity() up front.
+
+#if VECTOR_GROWTH_DEBUG && !defined(KERNEL)
+
+namespace AK::Detail {
+
+struct VectorGrowthCallSite {
+    const void* address { nullptr };
+    size_t reallocations { 0 };
+    size_t bytes { 0 };
+};
+
+static constexpr size_t max_call_sites = 4096;
+static constexpr size_t call_sites_to_dump = 50;
+
+// This can't use any containers of its own, since they would grow vectors while we're busy with one.
+static VectorGrowthCallSite s_call_sites[max_call_sites];
+static size_t s_untracked_reallocations;
+static Atomic<bool> s_lock;
+static bool s_dump_registered;
+
+static void lock()
+{
+    while (s_lock.exchange(true, AK::memory_order_acquire))
+        ;
+}
+
+static void unlock()
+{
+    s_lock.store(false, AK::memory_order_release);
+}
+
+static void dump_vector_growth_statistics()
+{
+    VectorGrowthCallSite top_call_sites[call_sites_to_dump];
+    size_t top_count = 0;
+    size_t untracked_reallocations;
+
+    lock();
+    for (auto& call_site : s_call_sites) {
+        if (!call_site.address)
+            continue;
+        if (top_count == call_sites_to_dump && top_call_sites[top_count - 1].reallocations >= call_site.reallocations)
+            continue;
+        size_t i = min(top_count, call_sites_to_dump - 1);
+        for (; i > 0 && top_call_sites[i - 1].reallocations < call_site.reallocations; --i)
+            top_call_sites[i] = top_call_sites[i - 1];
+        top_call_sites[i] = call_site;
+        top_count = min(top_count + 1, call_sites_to_dump);
+    }
+    untracked_reallocations = s_untracked_reallocations;
+    unlock();
+
+    dbgln("Vector growth: top {} call sites by reallocations", top_count);
+    for (size_t i = 0; i < top_count; ++i)
+        dbgln("{:>10} reallocations, {:>12} bytes allocated: {:p}", top_call_sites[i].reallocations, top_call_sites[i].bytes, top_call_sites[i].address);
+    if (untracked_reallocations)
+        dbgln("{} reallocations at call sites that didn't fit in the table", untracked_reallocations);
+}
+
+void note_vector_reallocation(const void* call_site, size_t new_capacity, size_t element_size)
+{
+    lock();
+    if (!s_dump_registered) {
+        s_dump_registered = true;
+        atexit(dump_vector_growth_statistics);
+    }
+
+    size_t index = ptr_hash(call_site) % max_call_sites;
+    for (size_t probe = 0; probe < max_call_sites; ++probe) {
+        auto& entry = s_call_sites[(index + probe) % max_call_sites];
+        if (entry.address && entry.address != call_site)
+            continue;
+        entry.address = call_site;
+        ++entry.reallocations;
+        entry.bytes += new_capacity * element_size;
+        unlock();
+        return;
+    }
+    ++s_untracked_reallocations;
+    unlock();
+}
+
+}
+
+#endif
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+
+namespace Kernel {
+
+// The compact binary form of a perfcore file, as written by PerformanceEventBuffer::to_binary().
+//
+// The file starts with perfcore_magic and perfcore_version (both little-endian u32), followed
+// by a stream of records. Every record starts with a PerfcoreRecord byte; all integers after that
+// are unsigned LEB128. Strings and stacks are interned: each String or Stack record implicitly gets
+// the next id (counting from 0) and later records refer to it by that id. A record only ever
+// refers to ids defined before it, so the file can be consumed as a stream.
+//
+// String:  length, bytes
+// Process: pid, executable path (string id)
+// SampleSource: what the samples were taken on, e.g. "timer" or "cache-misses" (string id), since version 2
+// Region:  base, size, name (string id)
+// Stack:   frame count, then every frame address as the zigzag-encoded, pointer-sized wrapping
+//          difference from the previous one (the first one relative to 0)
+// Event:   type (PERF_EVENT_*), tid, timestamp (difference from the previous event), stack id,
+//          followed by ptr and size for PERF_EVENT_MALLOC, by ptr for PERF_EVENT_FREE and by
+//          arg1 and arg2 for the tracepoint events (see Kernel/Tracepoint.h)
+
+static constexpr u32 perfcore_magic = 0x46524550; // "PERF"
+static constexpr u32 perfcore_version = 2;
+
+enum class PerfcoreRecord : u8 {
+    String = 1,
+    Process,
+    Region,
+    Stack,
+    Event,
+    SampleSource,
+};
+
+// A sample of whatever was running on a processor, as read from /dev/profile.
+struct [[gnu::packed]] SystemProfileSample {
+    u64 timestamp_ns;
+    u32 pid;
+    u32 tid;
+    u32 cpu;
+    // Samples this processor had to drop since the previous one, because its buffer was full.
+    u32 lost_samples;
+    u32 stack_size;
+    static constexpr size_t max_stack_frame_count = 32;
+    FlatPtr stack[max_stack_frame_count];
+};
+
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+
+namespace Kernel {
+
+// The binary form of /proc/all, as read from /proc/stats.
+//
+// It's meant for tools that poll statistics for every thread in the system, like top and
+// SystemMonitor, and saves both the kernel and them from formatting and parsing JSON.
+//
+// The file starts with a ProcessStatisticsHeader, followed by header.process_count records.
+// Every process record is a ProcessStatisticsRecord, followed by its name, executable, tty,
+// pledge and veil strings (not null-terminated), followed by thread_count thread records.
+// Every thread record is a ThreadStatisticsRecord, followed by its name and state strings.
+// All integers are in host byte order.
+
+static constexpr u32 process_statistics_magic = 0x54415453; // "STAT"
+static constexpr u32 process_statistics_version = 2;
+
+struct [[gnu::packed]] ProcessStatisticsHeader {
+    u32 magic;
+    u32 version;
+    u32 process_count;
+};
+
+struct [[gnu::packed]] ProcessStatisticsRecord {
+    u32 pid;
+    u32 pgid;
+    u32 pgp;
+    u32 sid;
+    u32 uid;
+    u32 gid;
+    u32 ppid;
+    u32 nfds;
+    u64 amount_virtual;
+    u64 amount_resident;
+    u64 amount_dirty_private;
+    u64 amount_clean_inode;
+    u64 amount_shared;
+    u64 amount_purgeable_volatile;
+    u64 amount_purgeable_nonvolatile;
+    u8 dumpable;
+    u16 name_length;
+    u16 executable_length;
+    u16 tty_length;
+    u16 pledge_length;
+    u16 veil_length;
+    u32 thread_count;
+};
+
+struct [[gnu::packed]] ThreadStatisticsRecord {
+    u32 tid;
+    u32 times_scheduled;
+    u32 ticks_user;
+    u32 ticks_kernel;
+    u32 cpu;
+    u32 priority;
+    u32 syscall_count;
+    u32 inode_faults;
+    u32 zero_faults;
+    u32 cow_faults;
+    u32 file_read_bytes;
+    u32 file_write_bytes;
+    u32 unix_socket_read_bytes;
+    u32 unix_socket_write_bytes;
+    u32 ipv4_socket_read_bytes;
+    u32 ipv4_socket_write_bytes;
+    u32 minor_faults;
+    u32 major_faults;
+    u32 voluntary_context_switches;
+    u32 involuntary_context_switches;
+    u64 block_io_wait_us;
+    u64 scheduler_latency_us;
+    u16 name_length;
+    u16 state_length;
+};
+
+}
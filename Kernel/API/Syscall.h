@@ -37,6 +37,9 @@ constexpr int syscall_vector = 0x82;
 
 extern "C" {
 struct pollfd;
+struct epoll_event;
+struct io_ring_params;
+struct mmsghdr;
 struct timeval;
 struct timespec;
 struct sockaddr;
@@ -192,7 +195,17 @@ namespace Kernel {
     S(abort)                  \
     S(anon_create)            \
     S(msyscall)               \
-    S(readv)
+    S(readv)                  \
+    S(epoll_create)           \
+    S(epoll_ctl)              \
+    S(epoll_wait)             \
+    S(sendfile)               \
+    S(sendmmsg)               \
+    S(recvmmsg)               \
+    S(io_ring_create)         \
+    S(io_ring_enter)          \
+    S(reserve_shared_image)   \
+    S(copy_file_range)
 
 namespace Syscall {
 
@@ -277,6 +290,65 @@ struct SC_poll_params {
     const u32* sigmask;
 };
 
+struct SC_epoll_ctl_params {
+    int epoll_fd;
+    int op;
+    int fd;
+    struct epoll_event* event;
+};
+
+struct SC_epoll_wait_params {
+    int epoll_fd;
+    struct epoll_event* events;
+    int max_events;
+    const struct timespec* timeout;
+    const u32* sigmask;
+};
+
+struct SC_sendfile_params {
+    int out_fd;
+    int in_fd;
+    ssize_t* offset;
+    size_t count;
+};
+
+struct SC_copy_file_range_params {
+    int in_fd;
+    ssize_t* in_offset;
+    int out_fd;
+    ssize_t* out_offset;
+    size_t count;
+    unsigned flags;
+};
+
+struct SC_sendmmsg_params {
+    int sockfd;
+    struct mmsghdr* msgvec;
+    unsigned vlen;
+    int flags;
+};
+
+struct SC_recvmmsg_params {
+    int sockfd;
+    struct mmsghdr* msgvec;
+    unsigned vlen;
+    int flags;
+    const struct timespec* timeout;
+};
+
+struct SC_io_ring_create_params {
+    unsigned entries;
+    int flags;
+    struct io_ring_params* params;
+};
+
+struct SC_io_ring_enter_params {
+    int ring_fd;
+    unsigned to_submit;
+    unsigned min_complete;
+    const struct timespec* timeout;
+};
+
 struct SC_clock_nanosleep_params {
     int clock_id;
     int flags;
@@ -430,6 +502,7 @@ struct SC_waitid_params {
 };
 
 struct SC_stat_params {
+    int dirfd;
     StringArgument path;
     struct stat* statbuf;
     bool follow_symlinks;
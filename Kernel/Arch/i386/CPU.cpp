@@ -45,6 +45,7 @@
 #include <Kernel/Process.h>
 #include <Kernel/Random.h>
 #include <Kernel/Thread.h>
+#include <Kernel/Tracepoint.h>
 #include <Kernel/VM/MemoryManager.h>
 #include <Kernel/VM/PageDirectory.h>
 #include <Kernel/VM/ProcessPagingScope.h>
@@ -73,6 +74,7 @@ extern "C" void exit_kernel_thread(void);
 extern "C" void pre_init_finished(void);
 extern "C" void post_init_finished(void);
 extern "C" void handle_interrupt(TrapFrame*);
+extern "C" void sysenter_asm_entry();
 
 // clang-format off
 
@@ -263,6 +265,10 @@ void page_fault_handler(TrapFrame* trap)
         PANIC("Attempt to access UNMAP_AFTER_INIT section");
     }
 
+    // Kernel faults may come from the tracepoint's own backtrace, so only userspace faults are traced.
+    if (!faulted_in_kernel)
+        TRACEPOINT(PageFault, fault_address, regs.exception_code);
+
     auto response = MM.handle_page_fault(PageFault(regs.exception_code, VirtualAddress(fault_address)));
 
     if (response == PageFaultResponse::ShouldCrash || response == PageFaultResponse::OutOfMemory) {
@@ -325,6 +331,12 @@ void debug_handler(TrapFrame* trap)
     auto current_thread = Thread::current();
     auto& process = current_thread->process();
     if ((regs.cs & 3) == 0) {
+        if (regs.eip == (FlatPtr)&sysenter_asm_entry) {
+            // SYSENTER does not clear TF, so a single-stepped SYSENTER traps on the first
+            // kernel instruction. Clear TF and let the syscall run; the step is lost.
+            regs.eflags &= ~(1u << 8);
+            return;
+        }
         PANIC("Debug exception in ring 0");
     }
     constexpr u8 REASON_SINGLESTEP = 14;
@@ -975,6 +987,13 @@ UNMAP_AFTER_INIT void Processor::cpu_setup()
     if (has_feature(CPUFeature::TSC)) {
         write_cr4(read_cr4() | 0x4);
     }
+
+    if (has_feature(CPUFeature::SEP)) {
+        // IA32_SYSENTER_ESP is pointed at the current thread's kernel stack in switch_context().
+        MSR(MSR_IA32_SYSENTER_CS).set(GDT_SELECTOR_CODE0, 0);
+        MSR(MSR_IA32_SYSENTER_ESP).set(0, 0);
+        MSR(MSR_IA32_SYSENTER_EIP).set((FlatPtr)&sysenter_asm_entry, 0);
+    }
 }
 
 String Processor::features_string() const
@@ -1069,6 +1088,12 @@ UNMAP_AFTER_INIT void Processor::early_initialize(u32 cpu)
     m_info = nullptr;
 
     m_halt_requested = false;
+
+    m_loaded_cr3 = read_cr3();
+    m_tlb_flush_batch_depth = 0;
+    m_tlb_flush_batch_page_directory = nullptr;
+    m_tlb_flush_batch_count = 0;
+
     if (cpu == 0) {
         s_smp_enabled = false;
         atomic_store(&g_total_processors, 1u, AK::MemoryOrder::memory_order_release);
@@ -1304,7 +1329,7 @@ extern "C" void enter_thread_context(Thread* from_thread, Thread* to_thread)
     tls_descriptor.set_limit(to_thread->thread_specific_region_size());
 
     if (from_tss.cr3 != to_tss.cr3)
-        write_cr3(to_tss.cr3);
+        Processor::load_page_directory(to_tss.cr3);
 
     to_thread->set_cpu(processor.get_id());
     processor.restore_in_critical(to_thread->saved_critical());
@@ -1326,6 +1351,9 @@ void Processor::switch_context(Thread*& from_thread, Thread*& to_thread)
     dbgln_if(CONTEXT_SWITCH_DEBUG, "switch_context --> switching out of: {} {}", VirtualAddress(from_thread), *from_thread);
     from_thread->save_critical(m_in_critical);
 
+    if (has_feature(CPUFeature::SEP))
+        MSR(MSR_IA32_SYSENTER_ESP).set(to_thread->tss().esp0, 0);
+
 #if ARCH(I386)
     // clang-format off
     // Switch to new thread context, passing from_thread and to_thread
@@ -1722,10 +1750,49 @@ void Processor::flush_tlb_local(VirtualAddress vaddr, size_t page_count)
 
 void Processor::flush_tlb(const PageDirectory* page_directory, VirtualAddress vaddr, size_t page_count)
 {
-    if (s_smp_enabled && (!is_user_address(vaddr) || Process::current()->thread_count() > 1))
-        smp_broadcast_flush_tlb(page_directory, vaddr, page_count);
-    else
+    if (!s_smp_enabled) {
         flush_tlb_local(vaddr, page_count);
+        return;
+    }
+
+    auto& processor = Processor::current();
+    if (processor.m_tlb_flush_batch_depth > 0 && is_user_address(vaddr)) {
+        if (processor.m_tlb_flush_batch_count == max_batched_tlb_flush_ranges
+            || (processor.m_tlb_flush_batch_count > 0 && processor.m_tlb_flush_batch_page_directory != page_directory)) {
+            smp_flush_tlb(processor.m_tlb_flush_batch_page_directory, processor.m_tlb_flush_batch, processor.m_tlb_flush_batch_count);
+            processor.m_tlb_flush_batch_count = 0;
+        }
+        processor.m_tlb_flush_batch_page_directory = page_directory;
+        processor.m_tlb_flush_batch[processor.m_tlb_flush_batch_count++] = { vaddr.as_ptr(), page_count };
+        return;
+    }
+
+    TLBFlushRange range { vaddr.as_ptr(), page_count };
+    smp_flush_tlb(page_directory, &range, 1);
+}
+
+void Processor::begin_tlb_flush_batch()
+{
+    VERIFY(in_critical());
+    m_tlb_flush_batch_depth++;
+}
+
+void Processor::end_tlb_flush_batch()
+{
+    VERIFY(in_critical());
+    VERIFY(m_tlb_flush_batch_depth > 0);
+    if (--m_tlb_flush_batch_depth > 0 || m_tlb_flush_batch_count == 0)
+        return;
+    smp_flush_tlb(m_tlb_flush_batch_page_directory, m_tlb_flush_batch, m_tlb_flush_batch_count);
+    m_tlb_flush_batch_count = 0;
+}
+
+void Processor::load_page_directory(FlatPtr cr3)
+{
+    // This has to be visible before the new page directory is used, otherwise a concurrent
+    // shootdown could skip us while we're already caching translations from it.
+    current().m_loaded_cr3.store(cr3, AK::MemoryOrder::memory_order_seq_cst);
+    write_cr3(cr3);
 }
 
 static volatile ProcessorMessage* s_message_pool;
@@ -1817,6 +1884,20 @@ u32 Processor::smp_wake_n_idle_processors(u32 wake_count)
     return did_wake_count;
 }
 
+bool Processor::smp_wake_idle_processor(u32 cpu)
+{
+    VERIFY(Processor::current().in_critical());
+    if (!s_smp_enabled || cpu == Processor::current().id())
+        return false;
+
+    // Flip it to busy first, so that only one of us sends the IPI
+    u32 cpu_mask = 1u << cpu;
+    if (!(s_idle_cpu_mask.fetch_and(~cpu_mask, AK::MemoryOrder::memory_order_acq_rel) & cpu_mask))
+        return false;
+    APIC::the().send_ipi(cpu);
+    return true;
+}
+
 UNMAP_AFTER_INIT void Processor::smp_enable()
 {
     size_t msg_pool_size = Processor::count() * 100u;
@@ -1888,19 +1969,27 @@ bool Processor::smp_process_pending_messages()
             case ProcessorMessage::CallbackWithData:
                 msg->callback_with_data.handler(msg->callback_with_data.data);
                 break;
-            case ProcessorMessage::FlushTlb:
-                if (is_user_address(VirtualAddress(msg->flush_tlb.ptr))) {
-                    // We assume that we don't cross into kernel land!
-                    VERIFY(is_user_range(VirtualAddress(msg->flush_tlb.ptr), msg->flush_tlb.page_count * PAGE_SIZE));
+            case ProcessorMessage::FlushTlb: {
+                auto& first_range = msg->flush_tlb.ranges[0];
+                if (is_user_address(VirtualAddress(first_range.ptr))) {
                     if (read_cr3() != msg->flush_tlb.page_directory->cr3()) {
-                        // This processor isn't using this page directory right now, we can ignore this request
-                        dbgln_if(SMP_DEBUG, "SMP[{}]: No need to flush {} pages at {}", id(), msg->flush_tlb.page_count, VirtualAddress(msg->flush_tlb.ptr));
+                        // We switched away from this page directory since the shootdown was sent,
+                        // which already dropped its translations.
+                        dbgln_if(SMP_DEBUG, "SMP[{}]: No need to flush {} ranges at {}", id(), msg->flush_tlb.range_count, VirtualAddress(first_range.ptr));
+                        break;
+                    }
+                    if (msg->flush_tlb.flush_all_user_pages) {
+                        flush_entire_tlb_local();
                         break;
                     }
                 }
-                flush_tlb_local(VirtualAddress(msg->flush_tlb.ptr), msg->flush_tlb.page_count);
+                for (size_t i = 0; i < msg->flush_tlb.range_count; ++i) {
+                    auto& range = msg->flush_tlb.ranges[i];
+                    flush_tlb_local(VirtualAddress(range.ptr), range.page_count);
+                }
                 break;
             }
+            }
 
             bool is_async = msg->async; // Need to cache this value *before* dropping the ref count!
             auto prev_refs = atomic_fetch_sub(&msg->refs, 1u, AK::MemoryOrder::memory_order_acq_rel);
@@ -1963,6 +2052,26 @@ void Processor::smp_broadcast_message(ProcessorMessage& msg)
         APIC::the().broadcast_ipi();
 }
 
+void Processor::smp_multicast_message(u32 cpu_mask, ProcessorMessage& msg)
+{
+    auto& cur_proc = Processor::current();
+    VERIFY(cpu_mask != 0);
+    VERIFY(!(cpu_mask & (1u << cur_proc.get_id())));
+
+    dbgln_if(SMP_DEBUG, "SMP[{}]: Multicast message {} to cpu mask {:08x}", cur_proc.get_id(), VirtualAddress(&msg), cpu_mask);
+
+    atomic_store(&msg.refs, (u32)__builtin_popcount(cpu_mask), AK::MemoryOrder::memory_order_release);
+    for_each(
+        [&](Processor& proc) -> IterationDecision {
+            if (!(cpu_mask & (1u << proc.get_id())))
+                return IterationDecision::Continue;
+            // Only send an IPI if the target didn't already have messages pending
+            if (proc.smp_queue_message(msg))
+                APIC::the().send_ipi(proc.get_id());
+            return IterationDecision::Continue;
+        });
+}
+
 void Processor::smp_broadcast_wait_sync(ProcessorMessage& msg)
 {
     auto& cur_proc = Processor::current();
@@ -2055,17 +2164,68 @@ void Processor::smp_unicast(u32 cpu, void (*callback)(), bool async)
     smp_unicast_message(cpu, msg, async);
 }
 
-void Processor::smp_broadcast_flush_tlb(const PageDirectory* page_directory, VirtualAddress vaddr, size_t page_count)
+void Processor::smp_flush_tlb(const PageDirectory* page_directory, const TLBFlushRange* ranges, size_t range_count)
 {
+    VERIFY(range_count > 0);
+    bool is_user = is_user_address(VirtualAddress(ranges[0].ptr));
+
+    size_t total_page_count = 0;
+    for (size_t i = 0; i < range_count; ++i) {
+        // We assume that user ranges don't cross into kernel land!
+        VERIFY(!is_user || is_user_range(VirtualAddress(ranges[i].ptr), ranges[i].page_count * PAGE_SIZE));
+        total_page_count += ranges[i].page_count;
+    }
+    // Past this point invalidating page by page costs more than refilling the TLB.
+    // Kernel mappings are global and survive a CR3 reload, so this only works for user pages.
+    constexpr size_t max_pages_to_invalidate = 32;
+    bool flush_all_user_pages = is_user && total_page_count > max_pages_to_invalidate;
+
+    auto flush_local = [&] {
+        if (flush_all_user_pages) {
+            flush_entire_tlb_local();
+            return;
+        }
+        for (size_t i = 0; i < range_count; ++i)
+            flush_tlb_local(VirtualAddress(ranges[i].ptr), ranges[i].page_count);
+    };
+
+    auto& cur_proc = Processor::current();
+    u32 cpu_mask = 0;
+    if (is_user) {
+        // Our page table updates must be visible before we look at which processors have the page directory
+        // loaded, see load_page_directory().
+        AK::atomic_thread_fence(AK::MemoryOrder::memory_order_seq_cst);
+        FlatPtr cr3 = page_directory->cr3();
+        for_each(
+            [&](Processor& proc) -> IterationDecision {
+                if (&proc != &cur_proc && proc.m_loaded_cr3.load(AK::MemoryOrder::memory_order_seq_cst) == cr3)
+                    cpu_mask |= 1u << proc.get_id();
+                return IterationDecision::Continue;
+            });
+    } else {
+        for_each(
+            [&](Processor& proc) -> IterationDecision {
+                if (&proc != &cur_proc)
+                    cpu_mask |= 1u << proc.get_id();
+                return IterationDecision::Continue;
+            });
+    }
+
+    if (!cpu_mask) {
+        flush_local();
+        return;
+    }
+
     auto& msg = smp_get_from_pool();
     msg.async = false;
     msg.type = ProcessorMessage::FlushTlb;
     msg.flush_tlb.page_directory = page_directory;
-    msg.flush_tlb.ptr = vaddr.as_ptr();
-    msg.flush_tlb.page_count = page_count;
-    smp_broadcast_message(msg);
+    msg.flush_tlb.ranges = ranges;
+    msg.flush_tlb.range_count = range_count;
+    msg.flush_tlb.flush_all_user_pages = flush_all_user_pages;
+    smp_multicast_message(cpu_mask, msg);
     // While the other processors handle this request, we'll flush ours
-    flush_tlb_local(vaddr, page_count);
+    flush_local();
     // Now wait until everybody is done as well
     smp_broadcast_wait_sync(msg);
 }
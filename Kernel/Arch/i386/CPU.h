@@ -38,6 +38,8 @@
 #define UNMAP_AFTER_INIT NEVER_INLINE __attribute__((section(".unmap_after_init")))
 
 #define PAGE_SIZE 4096
+// With PAE, a page directory entry with the Huge bit set maps 2 MiB directly.
+#define HUGE_PAGE_SIZE 0x200000
 #define GENERIC_INTERRUPT_HANDLERS_COUNT (256 - IRQ_VECTOR_BASE)
 #define PAGE_MASK ((FlatPtr)0xfffff000u)
 
@@ -219,6 +221,7 @@ public:
         UserSupervisor = 1 << 2,
         WriteThrough = 1 << 3,
         CacheDisabled = 1 << 4,
+        Accessed = 1 << 5,
         Global = 1 << 8,
         NoExecute = 0x8000000000000000ULL,
     };
@@ -226,6 +229,9 @@ public:
     bool is_present() const { return raw() & Present; }
     void set_present(bool b) { set_bit(Present, b); }
 
+    bool is_accessed() const { return raw() & Accessed; }
+    void set_accessed(bool b) { set_bit(Accessed, b); }
+
     bool is_user_allowed() const { return raw() & UserSupervisor; }
     void set_user_allowed(bool b) { set_bit(UserSupervisor, b); }
 
@@ -595,11 +601,23 @@ static_assert(GDT_SELECTOR_CODE0 + 8 == GDT_SELECTOR_DATA0); // SS0 = CS0 + 8
 static_assert(GDT_SELECTOR_CODE0 + 16 == GDT_SELECTOR_CODE3); // CS3 = CS0 + 16
 static_assert(GDT_SELECTOR_CODE0 + 24 == GDT_SELECTOR_DATA3); // SS3 = CS0 + 32
 
+// Frames built by the SYSENTER entry point use this (otherwise unused) isr_number.
+#define SYSENTER_ISR_NUMBER 0x100
+
+#define MSR_IA32_SYSENTER_CS 0x174
+#define MSR_IA32_SYSENTER_ESP 0x175
+#define MSR_IA32_SYSENTER_EIP 0x176
+
 class ProcessorInfo;
 class SchedulerPerProcessorData;
 struct MemoryManagerData;
 struct ProcessorMessageEntry;
 
+struct TLBFlushRange {
+    u8* ptr;
+    size_t page_count;
+};
+
 struct ProcessorMessage {
     enum Type {
         FlushTlb,
@@ -620,8 +638,9 @@ struct ProcessorMessage {
         } callback_with_data;
         struct {
             const PageDirectory* page_directory;
-            u8* ptr;
-            size_t page_count;
+            const TLBFlushRange* ranges;
+            size_t range_count;
+            bool flush_all_user_pages;
         } flush_tlb;
     };
 
@@ -686,6 +705,16 @@ class Processor {
     bool m_scheduler_initialized;
     Atomic<bool> m_halt_requested;
 
+    // The page directory this processor has loaded, so that TLB shootdowns
+    // for user addresses only interrupt the processors that can be affected.
+    Atomic<FlatPtr> m_loaded_cr3;
+
+    static constexpr size_t max_batched_tlb_flush_ranges = 8;
+    u32 m_tlb_flush_batch_depth;
+    const PageDirectory* m_tlb_flush_batch_page_directory;
+    size_t m_tlb_flush_batch_count;
+    TLBFlushRange m_tlb_flush_batch[max_batched_tlb_flush_ranges];
+
     DeferredCallEntry* m_pending_deferred_calls; // in reverse order
     DeferredCallEntry* m_free_deferred_call_pool_entry;
     DeferredCallEntry m_deferred_call_pool[5];
@@ -700,6 +729,7 @@ class Processor {
     static void smp_cleanup_message(ProcessorMessage& msg);
     bool smp_queue_message(ProcessorMessage& msg);
     static void smp_unicast_message(u32 cpu, ProcessorMessage& msg, bool async);
+    static void smp_multicast_message(u32 cpu_mask, ProcessorMessage& msg);
     static void smp_broadcast_message(ProcessorMessage& msg);
     static void smp_broadcast_wait_sync(ProcessorMessage& msg);
     static void smp_broadcast_halt();
@@ -754,6 +784,12 @@ public:
     static void flush_tlb_local(VirtualAddress vaddr, size_t page_count);
     static void flush_tlb(const PageDirectory*, VirtualAddress, size_t);
 
+    // Use this rather than write_cr3() when switching address spaces, see m_loaded_cr3.
+    static void load_page_directory(FlatPtr cr3);
+
+    void begin_tlb_flush_batch();
+    void end_tlb_flush_batch();
+
     Descriptor& get_gdt_entry(u16 selector);
     void flush_gdt();
     const DescriptorTablePointer& get_gdtr();
@@ -977,8 +1013,9 @@ public:
     }
     static void smp_unicast(u32 cpu, void (*callback)(), bool async);
     static void smp_unicast(u32 cpu, void (*callback)(void*), void* data, void (*free_data)(void*), bool async);
-    static void smp_broadcast_flush_tlb(const PageDirectory*, VirtualAddress, size_t);
+    static void smp_flush_tlb(const PageDirectory*, const TLBFlushRange*, size_t range_count);
     static u32 smp_wake_n_idle_processors(u32 wake_count);
+    static bool smp_wake_idle_processor(u32 cpu);
 
     template<typename Callback>
     static void deferred_call_queue(Callback callback)
@@ -1066,6 +1103,29 @@ private:
     bool m_valid { false };
 };
 
+// Collects the TLB flushes for user pages made by this processor while in scope
+// and sends them to the other processors as a single shootdown when it ends.
+// Only use this where nothing is freed before the scope ends, since other
+// processors may keep using stale translations until then.
+class ScopedTLBFlushBatch {
+    AK_MAKE_NONCOPYABLE(ScopedTLBFlushBatch);
+    AK_MAKE_NONMOVABLE(ScopedTLBFlushBatch);
+
+public:
+    ScopedTLBFlushBatch()
+    {
+        Processor::current().begin_tlb_flush_batch();
+    }
+
+    ~ScopedTLBFlushBatch()
+    {
+        Processor::current().end_tlb_flush_batch();
+    }
+
+private:
+    ScopedCritical m_critical;
+};
+
 struct TrapFrame {
     u32 prev_irq_level;
     TrapFrame* next_trap;
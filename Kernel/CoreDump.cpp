@@ -29,6 +29,7 @@
 #include <AK/ByteBuffer.h>
 #include <AK/JsonArray.h>
 #include <AK/JsonObject.h>
+#include <Kernel/CommandLine.h>
 #include <Kernel/CoreDump.h>
 #include <Kernel/FileSystem/Custody.h>
 #include <Kernel/FileSystem/FileDescription.h>
@@ -36,7 +37,9 @@
 #include <Kernel/Process.h>
 #include <Kernel/RTC.h>
 #include <Kernel/SpinLock.h>
+#include <Kernel/VM/MemoryManager.h>
 #include <Kernel/VM/ProcessPagingScope.h>
+#include <LibCompress/Gzip.h>
 #include <LibELF/CoreDump.h>
 #include <LibELF/exec_elf.h>
 
@@ -58,7 +61,10 @@ OwnPtr<CoreDump> CoreDump::create(NonnullRefPtr<Process> process, const String&
 CoreDump::CoreDump(NonnullRefPtr<Process> process, NonnullRefPtr<FileDescription>&& fd)
     : m_process(move(process))
     , m_fd(move(fd))
+    , m_file_stream(*m_fd)
     , m_num_program_headers(m_process->space().region_count() + 1) // +1 for NOTE segment
+    , m_dump_all_pages(kernel_command_line().lookup("full_coredumps").value_or("off") == "on")
+    , m_compress(kernel_command_line().lookup("compressed_coredumps").value_or("on") == "on")
 {
 }
 
@@ -95,6 +101,68 @@ RefPtr<FileDescription> CoreDump::create_target_file(const Process& process, con
     return fd_or_error.value();
 }
 
+size_t CoreDump::FileOutputStream::write(ReadonlyBytes bytes)
+{
+    if (has_any_error())
+        return 0;
+
+    auto result = m_fd.write(UserOrKernelBuffer::for_kernel_buffer(const_cast<u8*>(bytes.data())), bytes.size());
+    if (result.is_error()) {
+        m_result = result.error();
+        set_fatal_error();
+        return 0;
+    }
+    return result.value();
+}
+
+bool CoreDump::FileOutputStream::write_or_error(ReadonlyBytes bytes)
+{
+    if (write(bytes) < bytes.size()) {
+        if (!m_result.is_error())
+            m_result = ENOSPC;
+        set_fatal_error();
+        return false;
+    }
+    return true;
+}
+
+CoreDump::DumpedRange CoreDump::dumped_range(const Region& region) const
+{
+    if (region.is_kernel())
+        return {};
+    if (m_dump_all_pages)
+        return { 0, region.page_count() };
+
+    // Read-only file mappings (mostly program and library text) can be found in the files themselves.
+    if (region.vmobject().is_inode() && !region.is_writable())
+        return {};
+
+    // Pages that were never touched read as zeroes, so we leave out the ones at either end of the region.
+    // That's where stacks and heap blocks keep their unused pages.
+    auto is_touched = [&](size_t page_index) {
+        auto* page = region.physical_page(page_index);
+        return page && !page->is_shared_zero_page() && !page->is_lazy_committed_page();
+    };
+    size_t first_page = 0;
+    while (first_page < region.page_count() && !is_touched(first_page))
+        ++first_page;
+    if (first_page == region.page_count())
+        return {};
+    size_t end_page = region.page_count();
+    while (!is_touched(end_page - 1))
+        --end_page;
+    return { first_page, end_page - first_page };
+}
+
+KResult CoreDump::write_to_output(ReadonlyBytes bytes)
+{
+    if (m_output->write_or_error(bytes))
+        return KSuccess;
+    if (m_file_stream.result().is_error())
+        return m_file_stream.result();
+    return EIO;
+}
+
 KResult CoreDump::write_elf_header()
 {
     Elf32_Ehdr elf_file_header;
@@ -127,41 +195,44 @@ KResult CoreDump::write_elf_header()
     elf_file_header.e_shnum = 0;
     elf_file_header.e_shstrndx = SHN_UNDEF;
 
-    auto result = m_fd->write(UserOrKernelBuffer::for_kernel_buffer(reinterpret_cast<uint8_t*>(&elf_file_header)), sizeof(Elf32_Ehdr));
-    if (result.is_error())
-        return result.error();
-    return KSuccess;
+    return write_to_output({ &elf_file_header, sizeof(elf_file_header) });
 }
 
 KResult CoreDump::write_program_headers(size_t notes_size)
 {
-    size_t offset = sizeof(Elf32_Ehdr) + m_num_program_headers * sizeof(Elf32_Phdr);
+    // The notes come right after the headers, so readers can get at them without going through (or decompressing) the memory.
+    size_t notes_offset = sizeof(Elf32_Ehdr) + m_num_program_headers * sizeof(Elf32_Phdr);
+    size_t offset = notes_offset + notes_size;
     for (auto& region : m_process->space().regions()) {
         Elf32_Phdr phdr {};
+        auto range = dumped_range(*region);
 
+        // Only [p_vaddr, p_vaddr + p_filesz) is in the file; the rest of the region (up to p_memsz) was left out.
         phdr.p_type = PT_LOAD;
         phdr.p_offset = offset;
-        phdr.p_vaddr = region.vaddr().get();
+        phdr.p_vaddr = region->vaddr().offset(range.first_page * PAGE_SIZE).get();
         phdr.p_paddr = 0;
 
-        phdr.p_filesz = region.page_count() * PAGE_SIZE;
-        phdr.p_memsz = region.page_count() * PAGE_SIZE;
+        phdr.p_filesz = range.page_count * PAGE_SIZE;
+        phdr.p_memsz = (region->page_count() - range.first_page) * PAGE_SIZE;
         phdr.p_align = 0;
 
-        phdr.p_flags = region.is_readable() ? PF_R : 0;
-        if (region.is_writable())
+        phdr.p_flags = region->is_readable() ? PF_R : 0;
+        if (region->is_writable())
             phdr.p_flags |= PF_W;
-        if (region.is_executable())
+        if (region->is_executable())
             phdr.p_flags |= PF_X;
 
         offset += phdr.p_filesz;
 
-        [[maybe_unused]] auto rc = m_fd->write(UserOrKernelBuffer::for_kernel_buffer(reinterpret_cast<uint8_t*>(&phdr)), sizeof(Elf32_Phdr));
+        auto result = write_to_output({ &phdr, sizeof(phdr) });
+        if (result.is_error())
+            return result;
     }
 
     Elf32_Phdr notes_pheader {};
     notes_pheader.p_type = PT_NOTE;
-    notes_pheader.p_offset = offset;
+    notes_pheader.p_offset = notes_offset;
     notes_pheader.p_vaddr = 0;
     notes_pheader.p_paddr = 0;
     notes_pheader.p_filesz = notes_size;
@@ -169,38 +240,36 @@ KResult CoreDump::write_program_headers(size_t notes_size)
     notes_pheader.p_align = 0;
     notes_pheader.p_flags = 0;
 
-    auto result = m_fd->write(UserOrKernelBuffer::for_kernel_buffer(reinterpret_cast<uint8_t*>(&notes_pheader)), sizeof(Elf32_Phdr));
-    if (result.is_error())
-        return result.error();
-    return KSuccess;
+    return write_to_output({ &notes_pheader, sizeof(notes_pheader) });
 }
 
 KResult CoreDump::write_regions()
 {
+    u8 page_buffer[PAGE_SIZE];
     for (auto& region : m_process->space().regions()) {
-        if (region.is_kernel())
+        auto range = dumped_range(*region);
+        if (!range.page_count)
             continue;
 
-        region.set_readable(true);
-        region.remap();
+        region->set_readable(true);
+        region->remap();
 
-        for (size_t i = 0; i < region.page_count(); i++) {
-            auto* page = region.physical_page(i);
-
-            uint8_t zero_buffer[PAGE_SIZE] = {};
-            Optional<UserOrKernelBuffer> src_buffer;
+        for (size_t i = range.first_page; i < range.first_page + range.page_count; i++) {
+            auto* page = region->physical_page(i);
 
             if (page) {
-                src_buffer = UserOrKernelBuffer::for_user_buffer(reinterpret_cast<uint8_t*>((region.vaddr().as_ptr() + (i * PAGE_SIZE))), PAGE_SIZE);
+                auto src_buffer = UserOrKernelBuffer::for_user_buffer(region->vaddr().offset(i * PAGE_SIZE).as_ptr(), PAGE_SIZE);
+                if (!src_buffer.has_value() || !src_buffer->read(page_buffer, PAGE_SIZE))
+                    return EFAULT;
             } else {
                 // If the current page is not backed by a physical page, we zero it in the coredump file.
                 // TODO: Do we want to include the contents of pages that have not been faulted-in in the coredump?
                 //       (A page may not be backed by a physical page because it has never been faulted in when the process ran).
-                src_buffer = UserOrKernelBuffer::for_kernel_buffer(zero_buffer);
+                __builtin_memset(page_buffer, 0, PAGE_SIZE);
             }
-            auto result = m_fd->write(src_buffer.value(), PAGE_SIZE);
+            auto result = write_to_output({ page_buffer, PAGE_SIZE });
             if (result.is_error())
-                return result.error();
+                return result;
         }
     }
     return KSuccess;
@@ -208,10 +277,7 @@ KResult CoreDump::write_regions()
 
 KResult CoreDump::write_notes_segment(ByteBuffer& notes_segment)
 {
-    auto result = m_fd->write(UserOrKernelBuffer::for_kernel_buffer(notes_segment.data()), notes_segment.size());
-    if (result.is_error())
-        return result.error();
-    return KSuccess;
+    return write_to_output(notes_segment);
 }
 
 ByteBuffer CoreDump::create_notes_process_data() const
@@ -257,16 +323,17 @@ ByteBuffer CoreDump::create_notes_threads_data() const
 ByteBuffer CoreDump::create_notes_regions_data() const
 {
     ByteBuffer regions_data;
-    for (size_t region_index = 0; region_index < m_process->space().region_count(); ++region_index) {
+    size_t region_index = 0;
+    for (auto& region_ptr : m_process->space().regions()) {
+        auto& region = *region_ptr;
 
         ByteBuffer memory_region_info_buffer;
         ELF::Core::MemoryRegionInfo info {};
         info.header.type = ELF::Core::NotesEntryHeader::Type::MemoryRegionInfo;
 
-        auto& region = m_process->space().regions()[region_index];
         info.region_start = region.vaddr().get();
         info.region_end = region.vaddr().offset(region.size()).get();
-        info.program_header_index = region_index;
+        info.program_header_index = region_index++;
 
         memory_region_info_buffer.append((void*)&info, sizeof(info));
 
@@ -320,20 +387,43 @@ KResult CoreDump::write()
 
     ByteBuffer notes_segment = create_notes_segment_data();
 
-    auto result = write_elf_header();
+    // The whole file goes through gzip as it's written, so a dump never takes its uncompressed size on disk.
+    // Most of a dump is zeroes and repeated heap patterns, which even the fast level squeezes well.
+    OwnPtr<Compress::GzipCompressor> compressor;
+    if (m_compress) {
+        compressor = make<Compress::GzipCompressor>(m_file_stream, Compress::DeflateCompressor::CompressionLevel::Fast);
+        m_output = compressor.ptr();
+    } else {
+        m_output = &m_file_stream;
+    }
+
+    auto result = write_elf(notes_segment);
+    if (compressor) {
+        compressor->final_flush();
+        if (!result.is_error() && compressor->has_any_error())
+            result = m_file_stream.result().is_error() ? m_file_stream.result() : KResult(EIO);
+        compressor->handle_any_error();
+    }
+    m_file_stream.handle_any_error();
+    m_output = nullptr;
     if (result.is_error())
         return result;
-    result = write_program_headers(notes_segment.size());
+
+    return m_fd->chmod(0400); // Make coredump file readable
+}
+
+KResult CoreDump::write_elf(ByteBuffer& notes_segment)
+{
+    auto result = write_elf_header();
     if (result.is_error())
         return result;
-    result = write_regions();
+    result = write_program_headers(notes_segment.size());
     if (result.is_error())
         return result;
     result = write_notes_segment(notes_segment);
     if (result.is_error())
         return result;
-
-    return m_fd->chmod(0400); // Make coredump file readable
+    return write_regions();
 }
 
 }
@@ -30,7 +30,9 @@
 #include <AK/LexicalPath.h>
 #include <AK/NonnullRefPtr.h>
 #include <AK/OwnPtr.h>
+#include <AK/Stream.h>
 #include <Kernel/Forward.h>
+#include <Kernel/KResult.h>
 #include <LibELF/exec_elf.h>
 
 namespace Kernel {
@@ -45,9 +47,37 @@ public:
     [[nodiscard]] KResult write();
 
 private:
+    // Feeds everything we write into the file, remembering the first error since streams can't return one.
+    class FileOutputStream final : public OutputStream {
+    public:
+        explicit FileOutputStream(FileDescription& fd)
+            : m_fd(fd)
+        {
+        }
+
+        size_t write(ReadonlyBytes) override;
+        bool write_or_error(ReadonlyBytes) override;
+
+        KResult result() const { return m_result; }
+
+    private:
+        FileDescription& m_fd;
+        KResult m_result { KSuccess };
+    };
+
+    // The part of a region that ends up in the file: the pages from first_page on, or none at all.
+    struct DumpedRange {
+        size_t first_page { 0 };
+        size_t page_count { 0 };
+    };
+
     CoreDump(NonnullRefPtr<Process>, NonnullRefPtr<FileDescription>&&);
     static RefPtr<FileDescription> create_target_file(const Process&, const String& output_path);
 
+    DumpedRange dumped_range(const Region&) const;
+    [[nodiscard]] KResult write_to_output(ReadonlyBytes);
+
+    [[nodiscard]] KResult write_elf(ByteBuffer& notes_segment);
     [[nodiscard]] KResult write_elf_header();
     [[nodiscard]] KResult write_program_headers(size_t notes_size);
     [[nodiscard]] KResult write_regions();
@@ -61,7 +91,11 @@ private:
 
     NonnullRefPtr<Process> m_process;
     NonnullRefPtr<FileDescription> m_fd;
+    FileOutputStream m_file_stream;
+    OutputStream* m_output { nullptr };
     const size_t m_num_program_headers;
+    bool m_dump_all_pages { false };
+    bool m_compress { false };
 };
 
 }
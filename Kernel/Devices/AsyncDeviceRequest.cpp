@@ -26,6 +26,7 @@
 
 #include <Kernel/Devices/AsyncDeviceRequest.h>
 #include <Kernel/Devices/Device.h>
+#include <Kernel/Time/TimeManagement.h>
 
 namespace Kernel {
 
@@ -74,7 +75,9 @@ auto AsyncDeviceRequest::wait(timeval* timeout) -> RequestWaitResult
     auto request_result = get_request_result();
     if (is_completed_result(request_result))
         return { request_result, Thread::BlockResult::NotBlocked };
+    auto wait_start_us = TimeManagement::the().uptime_us();
     auto wait_result = m_queue.wait_on(Thread::BlockTimeout(false, timeout), name());
+    Thread::current()->did_block_io_wait(TimeManagement::the().uptime_us() - wait_start_us);
     return { get_request_result(), wait_result };
 }
 
@@ -58,6 +58,13 @@ namespace Kernel {
 #define VBE_DISPI_ENABLED 0x01
 #define VBE_DISPI_LFB_ENABLED 0x40
 
+#define VGA_INPUT_STATUS_1 0x3DA
+#define VGA_INPUT_STATUS_1_VERTICAL_RETRACE 0x08
+
+// Enough polls to cover a full frame at refresh rates down to ~30 Hz, in case
+// the card doesn't emulate the retrace bit at all.
+#define MAX_VERTICAL_RETRACE_POLLS 30000
+
 static AK::Singleton<BXVGADevice> s_the;
 
 UNMAP_AFTER_INIT void BXVGADevice::initialize()
@@ -150,10 +157,26 @@ bool BXVGADevice::validate_setup_resolution(size_t width, size_t height)
     return true;
 }
 
+void BXVGADevice::wait_for_vertical_retrace()
+{
+    // If we're in the middle of a retrace already, there may not be enough of it
+    // left to switch buffers, so wait for the next one.
+    for (int i = 0; i < MAX_VERTICAL_RETRACE_POLLS; ++i) {
+        if (!(IO::in8(VGA_INPUT_STATUS_1) & VGA_INPUT_STATUS_1_VERTICAL_RETRACE))
+            break;
+    }
+    for (int i = 0; i < MAX_VERTICAL_RETRACE_POLLS; ++i) {
+        if (IO::in8(VGA_INPUT_STATUS_1) & VGA_INPUT_STATUS_1_VERTICAL_RETRACE)
+            break;
+    }
+}
+
 void BXVGADevice::set_y_offset(size_t y_offset)
 {
     VERIFY(y_offset == 0 || y_offset == m_framebuffer_height);
     m_y_offset = y_offset;
+    // Flip between frames, so that the screen never shows half of each buffer.
+    wait_for_vertical_retrace();
     set_register(VBE_DISPI_INDEX_Y_OFFSET, (u16)y_offset);
 }
 
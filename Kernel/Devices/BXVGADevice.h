@@ -68,6 +68,7 @@ private:
     bool set_resolution(size_t width, size_t height);
     void set_resolution_registers(size_t width, size_t height);
     void set_y_offset(size_t);
+    void wait_for_vertical_retrace();
 
     PhysicalAddress m_framebuffer_address;
     size_t m_framebuffer_pitch { 0 };
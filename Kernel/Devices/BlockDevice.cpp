@@ -25,6 +25,7 @@
  */
 
 #include <Kernel/Devices/BlockDevice.h>
+#include <Kernel/Tracepoint.h>
 
 namespace Kernel {
 
@@ -37,6 +38,9 @@ AsyncBlockDeviceRequest::AsyncBlockDeviceRequest(Device& block_device, RequestTy
     , m_buffer(buffer)
     , m_buffer_size(buffer_size)
 {
+    // Only trace requests that actually reach a disk, so forwarded partition requests aren't counted twice.
+    if (!m_block_device.is_partition())
+        TRACEPOINT(DiskRequest, block_index, block_count | (request_type == Write ? disk_request_write_flag : 0));
 }
 
 void AsyncBlockDeviceRequest::start()
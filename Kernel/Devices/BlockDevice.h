@@ -82,6 +82,9 @@ public:
 
     virtual void start_request(AsyncBlockDeviceRequest&) = 0;
 
+    // Requests on a partition are forwarded to the device it's on.
+    virtual bool is_partition() const { return false; }
+
 protected:
     BlockDevice(unsigned major, unsigned minor, size_t block_size = PAGE_SIZE)
         : Device(major, minor)
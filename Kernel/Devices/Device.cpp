@@ -87,10 +87,24 @@ void Device::process_next_queued_request(Badge<AsyncDeviceRequest>, const AsyncD
     {
         ScopedSpinLock lock(m_requests_lock);
         VERIFY(!m_requests.is_empty());
-        VERIFY(m_requests.first().ptr() == &completed_request);
-        m_requests.remove(m_requests.begin());
-        if (!m_requests.is_empty())
-            next_request = m_requests.first().ptr();
+        VERIFY(m_requests_in_flight > 0);
+        // With more than one request in flight, requests may complete out of order.
+        auto it = m_requests.begin();
+        while (it != m_requests.end() && (*it).ptr() != &completed_request)
+            ++it;
+        VERIFY(it != m_requests.end());
+        m_requests.remove(it);
+        --m_requests_in_flight;
+
+        // Start the first request that hasn't been started yet, if there is one.
+        size_t index = 0;
+        for (auto& request : m_requests) {
+            if (index++ == m_requests_in_flight) {
+                next_request = request.ptr();
+                ++m_requests_in_flight;
+                break;
+            }
+        }
     }
 
     if (next_request)
@@ -68,17 +68,23 @@ public:
 
     void process_next_queued_request(Badge<AsyncDeviceRequest>, const AsyncDeviceRequest&);
 
+    // How many requests may be started before the first one has completed.
+    // Devices that can have multiple commands in flight can override this.
+    virtual size_t max_concurrent_requests() const { return 1; }
+
     template<typename AsyncRequestType, typename... Args>
     NonnullRefPtr<AsyncRequestType> make_request(Args&&... args)
     {
         auto request = adopt(*new AsyncRequestType(*this, forward<Args>(args)...));
-        bool was_empty;
+        bool should_start;
         {
             ScopedSpinLock lock(m_requests_lock);
-            was_empty = m_requests.is_empty();
+            should_start = m_requests_in_flight < max_concurrent_requests();
+            if (should_start)
+                ++m_requests_in_flight;
             m_requests.append(request);
         }
-        if (was_empty)
+        if (should_start)
             request->do_start({});
         return request;
     }
@@ -97,7 +103,9 @@ private:
     gid_t m_gid { 0 };
 
     SpinLock<u8> m_requests_lock;
+    // The first m_requests_in_flight requests in this list have been started.
     DoublyLinkedList<RefPtr<AsyncDeviceRequest>> m_requests;
+    size_t m_requests_in_flight { 0 };
 };
 
 }
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Kernel/Devices/MemoryPressureDevice.h>
+#include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/VM/MemoryManager.h>
+
+namespace Kernel {
+
+static MemoryPressureDevice* s_the;
+
+struct MemoryPressureDescriptionData : public FileDescriptionData {
+    // Nothing has been reported yet, so the first read never blocks.
+    Optional<MemoryPressureLevel> last_reported_level;
+};
+
+static MemoryPressureDescriptionData& description_data(const FileDescription& description)
+{
+    auto& data = const_cast<FileDescription&>(description).data();
+    VERIFY(data);
+    return static_cast<MemoryPressureDescriptionData&>(*data);
+}
+
+void MemoryPressureDevice::did_change_level()
+{
+    if (s_the)
+        s_the->evaluate_block_conditions();
+}
+
+UNMAP_AFTER_INIT MemoryPressureDevice::MemoryPressureDevice()
+    : CharacterDevice(1, 10)
+{
+    s_the = this;
+}
+
+UNMAP_AFTER_INIT MemoryPressureDevice::~MemoryPressureDevice()
+{
+}
+
+KResult MemoryPressureDevice::attach(FileDescription& description)
+{
+    description.data() = make<MemoryPressureDescriptionData>();
+    return KSuccess;
+}
+
+bool MemoryPressureDevice::can_read(const FileDescription& description, size_t) const
+{
+    auto& last_reported_level = description_data(description).last_reported_level;
+    return !last_reported_level.has_value() || last_reported_level.value() != MM.memory_pressure_level();
+}
+
+KResultOr<size_t> MemoryPressureDevice::read(FileDescription& description, size_t, UserOrKernelBuffer& buffer, size_t size)
+{
+    auto level = MM.memory_pressure_level();
+    auto line = String::formatted("{}\n", to_string(level));
+    if (size < line.length())
+        return EINVAL;
+    if (!buffer.write(line.characters(), line.length()))
+        return EFAULT;
+    description_data(description).last_reported_level = level;
+    return line.length();
+}
+
+}
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Kernel/Arch/i386/CPU.h>
+#include <Kernel/Devices/ProfileDevice.h>
+#include <Kernel/PerformanceEventBuffer.h>
+#include <Kernel/Process.h>
+#include <Kernel/Thread.h>
+#include <Kernel/Time/TimeManagement.h>
+
+namespace Kernel {
+
+static ProfileDevice* s_the;
+Atomic<bool> ProfileDevice::s_sampling { false };
+
+ProfileDevice& ProfileDevice::the()
+{
+    VERIFY(s_the);
+    return *s_the;
+}
+
+UNMAP_AFTER_INIT ProfileDevice::ProfileDevice()
+    : CharacterDevice(1, 9)
+{
+    s_the = this;
+}
+
+UNMAP_AFTER_INIT ProfileDevice::~ProfileDevice()
+{
+}
+
+KResult ProfileDevice::attach(FileDescription&)
+{
+    Locker locker(m_lock);
+    if (m_buffers.is_empty()) {
+        // All processors are up by the time anyone can open us.
+        for (u32 cpu = 0; cpu < Processor::count(); ++cpu) {
+            auto buffer = KBuffer::try_create_with_size(samples_per_processor * sizeof(SystemProfileSample), Region::Access::Read | Region::Access::Write, "Profile samples", AllocationStrategy::AllocateNow);
+            if (!buffer) {
+                m_buffers.clear();
+                return ENOMEM;
+            }
+            m_buffers.append(make<ProcessorBuffer>(buffer.release_nonnull()));
+        }
+    }
+
+    if (m_open_count++ == 0) {
+        // Don't hand out leftovers from whoever had us open before.
+        for (auto& buffer : m_buffers)
+            buffer.tail.store(buffer.head.load(AK::MemoryOrder::memory_order_acquire), AK::MemoryOrder::memory_order_release);
+        s_sampling.store(true, AK::MemoryOrder::memory_order_release);
+    }
+    return KSuccess;
+}
+
+void ProfileDevice::detach(FileDescription&)
+{
+    Locker locker(m_lock);
+    VERIFY(m_open_count > 0);
+    if (--m_open_count == 0)
+        s_sampling.store(false, AK::MemoryOrder::memory_order_release);
+}
+
+void ProfileDevice::sample(Thread& thread, const RegisterState& regs)
+{
+    VERIFY_INTERRUPTS_DISABLED();
+
+    auto cpu = Processor::id();
+    if (cpu >= m_buffers.size())
+        return;
+    auto& buffer = m_buffers[cpu];
+
+    u32 head = buffer.head.load(AK::MemoryOrder::memory_order_relaxed);
+    u32 tail = buffer.tail.load(AK::MemoryOrder::memory_order_acquire);
+    if (head - tail >= samples_per_processor) {
+        ++buffer.lost_samples;
+        return;
+    }
+
+    auto& sample = buffer.at(head);
+    auto now = TimeManagement::the().monotonic_time(TimePrecision::Coarse);
+    sample.timestamp_ns = (u64)now.tv_sec * 1'000'000'000ull + now.tv_nsec;
+    sample.pid = thread.pid().value();
+    sample.tid = thread.tid().value();
+    sample.cpu = cpu;
+    sample.lost_samples = buffer.lost_samples;
+    buffer.lost_samples = 0;
+
+    auto backtrace = PerformanceEventBuffer::raw_backtrace(regs.ebp, regs.eip);
+    sample.stack_size = min(backtrace.size(), SystemProfileSample::max_stack_frame_count);
+    memcpy(sample.stack, backtrace.data(), sample.stack_size * sizeof(FlatPtr));
+
+    buffer.head.store(head + 1, AK::MemoryOrder::memory_order_release);
+
+    // Readers only ever block when every buffer is empty.
+    if (head == tail)
+        evaluate_block_conditions();
+}
+
+bool ProfileDevice::can_read(const FileDescription&, size_t) const
+{
+    for (auto& buffer : m_buffers) {
+        if (buffer.head.load(AK::MemoryOrder::memory_order_acquire) != buffer.tail.load(AK::MemoryOrder::memory_order_relaxed))
+            return true;
+    }
+    return false;
+}
+
+KResultOr<size_t> ProfileDevice::read(FileDescription&, size_t, UserOrKernelBuffer& user_buffer, size_t size)
+{
+    if (size < sizeof(SystemProfileSample))
+        return EINVAL;
+
+    Locker locker(m_lock);
+    size_t nread = 0;
+    // Take turns between processors, so a busy one can't starve the others
+    // when reading in small chunks.
+    for (size_t i = 0; i < m_buffers.size(); ++i) {
+        auto& buffer = m_buffers[(m_next_buffer + i) % m_buffers.size()];
+        u32 tail = buffer.tail.load(AK::MemoryOrder::memory_order_relaxed);
+        u32 head = buffer.head.load(AK::MemoryOrder::memory_order_acquire);
+        while (tail != head && size - nread >= sizeof(SystemProfileSample)) {
+            if (!user_buffer.write(&buffer.at(tail), nread, sizeof(SystemProfileSample)))
+                return EFAULT;
+            nread += sizeof(SystemProfileSample);
+            ++tail;
+        }
+        buffer.tail.store(tail, AK::MemoryOrder::memory_order_release);
+    }
+    if (!m_buffers.is_empty())
+        m_next_buffer = (m_next_buffer + 1) % m_buffers.size();
+    return nread;
+}
+
+}
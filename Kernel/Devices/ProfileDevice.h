@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/NonnullOwnPtrVector.h>
+#include <Kernel/API/Perfcore.h>
+#include <Kernel/Devices/CharacterDevice.h>
+#include <Kernel/KBuffer.h>
+#include <Kernel/Lock.h>
+
+namespace Kernel {
+
+// /dev/profile samples every processor on each timer tick for as long as it is open, so a
+// collector can keep it open and drain SystemProfileSample records whenever it likes.
+// Every processor only ever appends to its own ring buffer, from its timer interrupt,
+// so recording a sample doesn't need any locks.
+class ProfileDevice final : public CharacterDevice {
+    AK_MAKE_ETERNAL
+public:
+    static ProfileDevice& the();
+    static bool is_sampling() { return s_sampling.load(AK::MemoryOrder::memory_order_acquire); }
+
+    ProfileDevice();
+    virtual ~ProfileDevice() override;
+
+    // Called from the timer interrupt of the current processor.
+    void sample(Thread&, const RegisterState&);
+
+    // ^Device
+    virtual mode_t required_mode() const override { return 0400; }
+    virtual String device_name() const override { return "profile"; }
+
+private:
+    static constexpr size_t samples_per_processor = 1024;
+
+    struct ProcessorBuffer {
+        explicit ProcessorBuffer(NonnullOwnPtr<KBuffer> buffer)
+            : buffer(move(buffer))
+        {
+        }
+
+        NonnullOwnPtr<KBuffer> buffer;
+        // head is only advanced by the owning processor, tail only by readers.
+        Atomic<u32> head { 0 };
+        Atomic<u32> tail { 0 };
+        u32 lost_samples { 0 };
+
+        SystemProfileSample& at(u32 index)
+        {
+            return reinterpret_cast<SystemProfileSample*>(buffer->data())[index % samples_per_processor];
+        }
+    };
+
+    // ^CharacterDevice
+    virtual KResult attach(FileDescription&) override;
+    virtual void detach(FileDescription&) override;
+    virtual KResultOr<size_t> read(FileDescription&, size_t, UserOrKernelBuffer&, size_t) override;
+    virtual KResultOr<size_t> write(FileDescription&, size_t, const UserOrKernelBuffer&, size_t) override { return EINVAL; }
+    virtual bool can_read(const FileDescription&, size_t) const override;
+    virtual bool can_write(const FileDescription&, size_t) const override { return false; }
+    virtual const char* class_name() const override { return "ProfileDevice"; }
+
+    static Atomic<bool> s_sampling;
+
+    Lock m_lock { "ProfileDevice" };
+    size_t m_open_count { 0 };
+    size_t m_next_buffer { 0 };
+    // Allocated once for all processors on the first open, then kept around.
+    NonnullOwnPtrVector<ProcessorBuffer> m_buffers;
+};
+
+}
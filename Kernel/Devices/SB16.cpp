@@ -30,9 +30,11 @@
 #include <Kernel/Debug.h>
 #include <Kernel/Devices/SB16.h>
 #include <Kernel/IO.h>
+#include <Kernel/StdLib.h>
 #include <Kernel/Thread.h>
-#include <Kernel/VM/AnonymousVMObject.h>
 #include <Kernel/VM/MemoryManager.h>
+#include <LibC/errno_numbers.h>
+#include <LibC/sys/ioctl_numbers.h>
 
 namespace Kernel {
 #define SB16_DEFAULT_IRQ 5
@@ -47,6 +49,11 @@ const u16 DSP_WRITE = 0x22C;
 const u16 DSP_STATUS = 0x22E;
 const u16 DSP_R_ACK = 0x22F;
 
+// The DMA buffer holds 4096 16-bit stereo samples (about 93 ms at 44.1 kHz), split into blocks
+// of 512 samples (about 12 ms), which is how often the card interrupts us.
+static constexpr size_t dma_buffer_size = 4 * PAGE_SIZE;
+static constexpr size_t block_size = 2048;
+
 /* Write a value to the DSP write register */
 void SB16::dsp_write(u8 value)
 {
@@ -115,6 +122,7 @@ SB16& SB16::the()
 UNMAP_AFTER_INIT void SB16::initialize()
 {
     disable_irq();
+    m_queue_limit = dma_buffer_size;
 
     IO::out8(0x226, 1);
     IO::delay(32);
@@ -194,11 +202,47 @@ KResultOr<size_t> SB16::read(FileDescription&, size_t, UserOrKernelBuffer&, size
     return 0;
 }
 
-void SB16::dma_start(uint32_t length)
+size_t SB16::queued_bytes() const
+{
+    ScopedSpinLock lock(m_position_lock);
+    if (m_written_bytes <= m_played_bytes)
+        return 0;
+    return m_written_bytes - m_played_bytes;
+}
+
+bool SB16::can_write(const FileDescription&, size_t) const
+{
+    return queued_bytes() < m_queue_limit;
+}
+
+int SB16::ioctl(FileDescription&, unsigned request, FlatPtr arg)
+{
+    switch (request) {
+    case SOUNDCARD_IOCTL_GET_QUEUED_BYTES: {
+        auto* out = (size_t*)arg;
+        size_t value = queued_bytes();
+        if (!copy_to_user(out, &value))
+            return -EFAULT;
+        return 0;
+    }
+    case SOUNDCARD_IOCTL_SET_QUEUE_LIMIT: {
+        // At least two blocks, so there's always one to fill while the other one plays.
+        size_t limit = (size_t)arg;
+        limit = min(max(limit, 2 * block_size), dma_buffer_size);
+        m_queue_limit = limit;
+        evaluate_block_conditions();
+        return 0;
+    }
+    default:
+        return -EINVAL;
+    };
+}
+
+void SB16::start_playback()
 {
     const auto addr = m_dma_region->physical_page(0)->paddr().get();
     const u8 channel = 5; // 16-bit samples use DMA channel 5 (on the master DMA controller)
-    const u8 mode = 0x48;
+    const u8 mode = 0x58; // Single transfers, auto-initialized, reading from memory
 
     // Disable the DMA channel
     IO::out8(0xd4, 4 + (channel % 4));
@@ -209,89 +253,120 @@ void SB16::dma_start(uint32_t length)
     // Write the DMA mode for the transfer
     IO::out8(0xd6, (channel % 4) | mode);
 
-    // Write the offset of the buffer
+    // Write the offset of the buffer, in 16-bit words
     u16 offset = (addr / 2) % 65536;
     IO::out8(0xc4, (u8)offset);
     IO::out8(0xc4, (u8)(offset >> 8));
 
-    // Write the transfer length
-    IO::out8(0xc6, (u8)(length - 1));
-    IO::out8(0xc6, (u8)((length - 1) >> 8));
+    // Write the length of the whole buffer, in 16-bit words, so the controller wraps around at its end.
+    u16 word_count = dma_buffer_size / sizeof(i16);
+    IO::out8(0xc6, (u8)(word_count - 1));
+    IO::out8(0xc6, (u8)((word_count - 1) >> 8));
 
     // Write the buffer
     IO::out8(0x8b, addr >> 16);
 
     // Enable the DMA channel
     IO::out8(0xd4, (channel % 4));
+
+    set_sample_rate(44100);
+
+    // 16-bit auto-initialized output, interrupting after every block.
+    u8 command = 0xb6;
+    u8 format = (u8)SampleFormat::Signed | (u8)SampleFormat::Stereo;
+    u16 sample_count = block_size / sizeof(i16) / 2 - 1;
+
+    enable_irq();
+    dsp_write(command);
+    dsp_write(format);
+    dsp_write((u8)sample_count);
+    dsp_write((u8)(sample_count >> 8));
 }
 
-void SB16::handle_irq(const RegisterState&)
+void SB16::stop_playback()
 {
-    // Stop sound output ready for the next block.
+    // Pause 16-bit output.
     dsp_write(0xd5);
+    disable_irq();
+}
 
+void SB16::handle_irq(const RegisterState&)
+{
     IO::in8(DSP_STATUS); // 8 bit interrupt
     if (m_major_version >= 4)
         IO::in8(DSP_R_ACK); // 16 bit interrupt
 
-    m_irq_queue.wake_all();
-}
+    {
+        ScopedSpinLock lock(m_position_lock);
+        if (!m_playing)
+            return;
+
+        // Silence the block that was just played, so that it doesn't get played again if it isn't refilled in time.
+        size_t finished_block_offset = m_played_bytes % dma_buffer_size;
+        memset(m_dma_region->vaddr().offset(finished_block_offset).as_ptr(), 0, block_size);
+        m_played_bytes += block_size;
+
+        // Once everything has been played, there's only silence left, so stop until there's more.
+        if (m_written_bytes <= m_played_bytes) {
+            m_playing = false;
+            stop_playback();
+        }
+    }
 
-void SB16::wait_for_irq()
-{
-    m_irq_queue.wait_forever("SB16");
-    disable_irq();
+    evaluate_block_conditions();
 }
 
 KResultOr<size_t> SB16::write(FileDescription&, size_t, const UserOrKernelBuffer& data, size_t length)
 {
+    LOCKER(m_write_lock);
+
     if (!m_dma_region) {
-        auto page = MM.allocate_supervisor_physical_page();
-        if (!page)
-            return ENOMEM;
-        auto vmobject = AnonymousVMObject::create_with_physical_page(*page);
-        m_dma_region = MM.allocate_kernel_region_with_vmobject(*vmobject, PAGE_SIZE, "SB16 DMA buffer", Region::Access::Write);
+        // ISA DMA can't cross a 128 KiB boundary, which the alignment makes sure of.
+        m_dma_region = MM.allocate_contiguous_kernel_region(dma_buffer_size, "SB16 DMA buffer", Region::Access::Read | Region::Access::Write, dma_buffer_size);
         if (!m_dma_region)
             return ENOMEM;
     }
 
-#if SB16_DEBUG
-    klog() << "SB16: Writing buffer of " << length << " bytes";
-#endif
-    VERIFY(length <= PAGE_SIZE);
-    const int BLOCK_SIZE = 32 * 1024;
-    if (length > BLOCK_SIZE) {
-        return ENOSPC;
+    size_t write_offset;
+    size_t nwritten;
+    bool should_start = false;
+    {
+        ScopedSpinLock lock(m_position_lock);
+        if (!m_playing) {
+            // Playback always starts at the beginning of the buffer.
+            memset(m_dma_region->vaddr().as_ptr(), 0, dma_buffer_size);
+            m_written_bytes = 0;
+            m_played_bytes = 0;
+            should_start = true;
+        } else if (m_written_bytes < m_played_bytes) {
+            // We didn't keep up and some blocks were played as silence, so continue after them.
+            m_written_bytes = m_played_bytes;
+        }
+        size_t space = m_queue_limit - min((size_t)(m_written_bytes - m_played_bytes), m_queue_limit);
+        nwritten = min(length, space);
+        write_offset = m_written_bytes % dma_buffer_size;
     }
 
-    u8 mode = (u8)SampleFormat::Signed | (u8)SampleFormat::Stereo;
+#if SB16_DEBUG
+    klog() << "SB16: Writing buffer of " << nwritten << " bytes";
+#endif
+    if (nwritten == 0)
+        return EAGAIN;
 
-    const int sample_rate = 44100;
-    set_sample_rate(sample_rate);
-    if (!data.read(m_dma_region->vaddr().as_ptr(), length))
+    // The space after the write position may wrap around to the start of the buffer.
+    size_t first_part = min(nwritten, dma_buffer_size - write_offset);
+    if (!data.read(m_dma_region->vaddr().offset(write_offset).as_ptr(), first_part))
+        return EFAULT;
+    if (first_part < nwritten && !data.read(m_dma_region->vaddr().as_ptr(), first_part, nwritten - first_part))
         return EFAULT;
-    dma_start(length);
-
-    // 16-bit single-cycle output.
-    // FIXME: Implement auto-initialized output.
-    u8 command = 0xb0;
-
-    u16 sample_count = length / sizeof(i16);
-    if (mode & (u8)SampleFormat::Stereo)
-        sample_count /= 2;
-
-    sample_count -= 1;
-
-    cli();
-    enable_irq();
-
-    dsp_write(command);
-    dsp_write(mode);
-    dsp_write((u8)sample_count);
-    dsp_write((u8)(sample_count >> 8));
 
-    wait_for_irq();
-    return length;
+    ScopedSpinLock lock(m_position_lock);
+    m_written_bytes += nwritten;
+    if (should_start) {
+        m_playing = true;
+        start_playback();
+    }
+    return nwritten;
 }
 
 }
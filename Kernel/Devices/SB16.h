@@ -28,9 +28,10 @@
 
 #include <Kernel/Devices/CharacterDevice.h>
 #include <Kernel/Interrupts/IRQHandler.h>
+#include <Kernel/Lock.h>
 #include <Kernel/PhysicalAddress.h>
+#include <Kernel/SpinLock.h>
 #include <Kernel/VM/PhysicalPage.h>
-#include <Kernel/WaitQueue.h>
 
 namespace Kernel {
 
@@ -50,7 +51,8 @@ public:
     virtual bool can_read(const FileDescription&, size_t) const override;
     virtual KResultOr<size_t> read(FileDescription&, size_t, UserOrKernelBuffer&, size_t) override;
     virtual KResultOr<size_t> write(FileDescription&, size_t, const UserOrKernelBuffer&, size_t) override;
-    virtual bool can_write(const FileDescription&, size_t) const override { return true; }
+    virtual bool can_write(const FileDescription&, size_t) const override;
+    virtual int ioctl(FileDescription&, unsigned request, FlatPtr arg) override;
 
     virtual const char* purpose() const override { return class_name(); }
 
@@ -66,8 +68,8 @@ private:
     virtual const char* class_name() const override { return "SB16"; }
 
     void initialize();
-    void wait_for_irq();
-    void dma_start(uint32_t length);
+    void start_playback();
+    void stop_playback();
     void set_sample_rate(uint16_t hz);
     void dsp_write(u8 value);
     static u8 dsp_read();
@@ -75,9 +77,20 @@ private:
     void set_irq_register(u8 irq_number);
     void set_irq_line(u8 irq_number);
 
+    size_t queued_bytes() const;
+
+    // The card plays the DMA buffer in a loop and interrupts us after every block, which is when
+    // that block can be refilled. The positions below count bytes since playback started, so their
+    // offset in the buffer is the position modulo its size.
     OwnPtr<Region> m_dma_region;
-    int m_major_version { 0 };
+    u64 m_written_bytes { 0 };
+    u64 m_played_bytes { 0 };
+    bool m_playing { false };
+    // How much may be queued up ahead of what's playing, which bounds the latency.
+    size_t m_queue_limit { 0 };
+    mutable SpinLock<u8> m_position_lock;
+    Lock m_write_lock { "SB16" };
 
-    WaitQueue m_irq_queue;
+    int m_major_version { 0 };
 };
 }
@@ -26,14 +26,21 @@
 
 #include <AK/StringView.h>
 #include <Kernel/DoubleBuffer.h>
+#include <Kernel/Process.h>
+#include <Kernel/VM/AnonymousVMObject.h>
+#include <Kernel/VM/MemoryManager.h>
 
 namespace Kernel {
 
+// Writes of at least this much page-aligned user memory lend their pages to the
+// reader instead of being copied into the buffer.
+static constexpr size_t min_lend_size = 4 * PAGE_SIZE;
+
 inline void DoubleBuffer::compute_lockfree_metadata()
 {
     InterruptDisabler disabler;
-    m_empty = m_read_buffer_index >= m_read_buffer->size && m_write_buffer->size == 0;
-    m_space_for_writing = m_capacity - m_write_buffer->size;
+    m_empty = !m_lent_pages && m_read_buffer_index >= m_read_buffer->size && m_write_buffer->size == 0;
+    m_space_for_writing = m_lent_pages ? 0 : m_capacity - m_write_buffer->size;
 }
 
 DoubleBuffer::DoubleBuffer(size_t capacity)
@@ -49,6 +56,10 @@ DoubleBuffer::DoubleBuffer(size_t capacity)
     m_space_for_writing = capacity;
 }
 
+DoubleBuffer::~DoubleBuffer()
+{
+}
+
 void DoubleBuffer::flip()
 {
     if (m_storage.is_null())
@@ -60,12 +71,126 @@ void DoubleBuffer::flip()
     compute_lockfree_metadata();
 }
 
+KResult DoubleBuffer::try_set_capacity(size_t capacity)
+{
+    LOCKER(m_lock);
+    auto result = try_resize(capacity);
+    if (result.is_error())
+        return result;
+    m_capacity_is_fixed = true;
+    return KSuccess;
+}
+
+KResult DoubleBuffer::try_resize(size_t capacity)
+{
+    VERIFY(m_lock.is_locked());
+    if (capacity == m_capacity)
+        return KSuccess;
+    size_t unread_in_read_buffer = m_read_buffer->size - m_read_buffer_index;
+    if (unread_in_read_buffer + m_write_buffer->size > capacity)
+        return EBUSY;
+
+    auto storage = KBuffer::try_create_with_size(capacity * 2, Region::Access::Read | Region::Access::Write, "DoubleBuffer");
+    if (!storage)
+        return ENOMEM;
+
+    // Everything that's still unread goes into the new write buffer, in order.
+    memcpy(storage->data(), m_read_buffer->data + m_read_buffer_index, unread_in_read_buffer);
+    memcpy(storage->data() + unread_in_read_buffer, m_write_buffer->data, m_write_buffer->size);
+
+    m_storage = move(*storage);
+    m_buffer1.data = m_storage.data();
+    m_buffer1.size = unread_in_read_buffer + m_write_buffer->size;
+    m_buffer2.data = m_storage.data() + capacity;
+    m_buffer2.size = 0;
+    m_write_buffer = &m_buffer1;
+    m_read_buffer = &m_buffer2;
+    m_read_buffer_index = 0;
+    m_capacity = capacity;
+    compute_lockfree_metadata();
+    if (m_unblock_callback && m_space_for_writing > 0)
+        m_unblock_callback();
+    return KSuccess;
+}
+
+size_t DoubleBuffer::try_lend_pages(const UserOrKernelBuffer& data, size_t size)
+{
+    VERIFY(m_lock.is_locked());
+    auto base = VirtualAddress(data.user_or_kernel_ptr());
+    if (data.is_kernel_buffer() || !base.is_page_aligned())
+        return 0;
+    size_t page_count = min(size, m_capacity) / PAGE_SIZE;
+    if (page_count * PAGE_SIZE < min_lend_size)
+        return 0;
+    // The writer will likely reuse its buffer right away, and every page we hold on to
+    // then has to be copied. Don't do that if it could run us out of memory.
+    if (MM.user_physical_pages_uncommitted() < page_count * 4)
+        return 0;
+
+    NonnullRefPtrVector<PhysicalPage> pages;
+    {
+        auto& space = Process::current()->space();
+        ScopedSpinLock lock(space.get_lock());
+        for (size_t i = 0; i < page_count; ++i) {
+            auto vaddr = base.offset(i * PAGE_SIZE);
+            auto* region = space.find_region_containing({ vaddr, PAGE_SIZE });
+            if (!region || !region->is_user() || region->is_shared() || !region->is_readable() || !region->vmobject().is_anonymous())
+                break;
+            if (region->is_volatile(vaddr, PAGE_SIZE))
+                break;
+            auto page_index = region->page_index_from_address(vaddr);
+            auto* page = region->physical_page(page_index);
+            // Pages that haven't been touched (or were evicted) are cheaper to just copy.
+            if (!page || page->is_shared_zero_page() || page->is_lazy_committed_page() || page->is_compressed_page())
+                break;
+            pages.append(*page);
+            // From now on, the writer gets its own copy of the page when it writes to it.
+            region->set_should_cow(page_index, true);
+            region->remap_vmobject_page_range(region->translate_to_vmobject_page(page_index), 1);
+        }
+    }
+    if (pages.size() * PAGE_SIZE < min_lend_size)
+        return 0;
+
+    auto vmobject = AnonymousVMObject::create_with_physical_pages(pages);
+    auto region = MM.allocate_kernel_region_with_vmobject(*vmobject, pages.size() * PAGE_SIZE, "DoubleBuffer", Region::Access::Read);
+    if (!region)
+        return 0;
+
+    m_lent_pages = move(region);
+    m_lent_size = pages.size() * PAGE_SIZE;
+    m_lent_read_offset = 0;
+    compute_lockfree_metadata();
+    return m_lent_size;
+}
+
 ssize_t DoubleBuffer::write(const UserOrKernelBuffer& data, size_t size)
 {
     if (!size || m_storage.is_null())
         return 0;
     VERIFY(size > 0);
     LOCKER(m_lock);
+    if (m_lent_pages)
+        return 0;
+
+    // If nothing is buffered, a large enough write can hand its pages over without
+    // any copying here; the reader copies straight out of them.
+    if (m_empty && size >= min_lend_size) {
+        if (auto nlent = try_lend_pages(data, size)) {
+            if (m_unblock_callback)
+                m_unblock_callback();
+            return (ssize_t)nlent;
+        }
+    }
+
+    if (size > m_space_for_writing && !m_capacity_is_fixed && m_capacity < max_automatic_capacity) {
+        size_t new_capacity = m_capacity;
+        while (new_capacity < max_automatic_capacity && new_capacity - m_write_buffer->size < size)
+            new_capacity *= 2;
+        // Not being able to grow is fine, we'll just buffer less.
+        (void)try_resize(min(new_capacity, (size_t)max_automatic_capacity));
+    }
+
     size_t bytes_to_write = min(size, m_space_for_writing);
     u8* write_ptr = m_write_buffer->data + m_write_buffer->size;
     m_write_buffer->size += bytes_to_write;
@@ -83,6 +208,18 @@ ssize_t DoubleBuffer::read(UserOrKernelBuffer& data, size_t size)
         return 0;
     VERIFY(size > 0);
     LOCKER(m_lock);
+    if (m_lent_pages) {
+        size_t nread = min(m_lent_size - m_lent_read_offset, size);
+        if (!data.write(m_lent_pages->vaddr().offset(m_lent_read_offset).as_ptr(), nread))
+            return -EFAULT;
+        m_lent_read_offset += nread;
+        if (m_lent_read_offset == m_lent_size)
+            m_lent_pages = nullptr;
+        compute_lockfree_metadata();
+        if (m_unblock_callback && m_space_for_writing > 0)
+            m_unblock_callback();
+        return (ssize_t)nread;
+    }
     if (m_read_buffer_index >= m_read_buffer->size && m_write_buffer->size != 0)
         flip();
     if (m_read_buffer_index >= m_read_buffer->size)
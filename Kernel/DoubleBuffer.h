@@ -26,8 +26,10 @@
 
 #pragma once
 
+#include <AK/OwnPtr.h>
 #include <AK/Types.h>
 #include <Kernel/KBuffer.h>
+#include <Kernel/KResult.h>
 #include <Kernel/Lock.h>
 #include <Kernel/Thread.h>
 #include <Kernel/UserOrKernelBuffer.h>
@@ -36,7 +38,12 @@ namespace Kernel {
 
 class DoubleBuffer {
 public:
-    explicit DoubleBuffer(size_t capacity = 65536);
+    static constexpr size_t default_capacity = 64 * KiB;
+    // Unless the capacity was set explicitly, writes that don't fit grow the buffer up to this size.
+    static constexpr size_t max_automatic_capacity = 1 * MiB;
+
+    explicit DoubleBuffer(size_t capacity = default_capacity);
+    ~DoubleBuffer();
 
     [[nodiscard]] ssize_t write(const UserOrKernelBuffer&, size_t);
     [[nodiscard]] ssize_t write(const u8* data, size_t size)
@@ -52,6 +59,9 @@ public:
 
     bool is_empty() const { return m_empty; }
 
+    size_t capacity() const { return m_capacity; }
+    KResult try_set_capacity(size_t);
+
     size_t space_for_writing() const { return m_space_for_writing; }
 
     void set_unblock_callback(Function<void()> callback)
@@ -63,6 +73,8 @@ public:
 private:
     void flip();
     void compute_lockfree_metadata();
+    KResult try_resize(size_t);
+    size_t try_lend_pages(const UserOrKernelBuffer&, size_t);
 
     struct InnerBuffer {
         u8* data { nullptr };
@@ -77,6 +89,14 @@ private:
     KBuffer m_storage;
     Function<void()> m_unblock_callback;
     size_t m_capacity { 0 };
+    bool m_capacity_is_fixed { false };
+
+    // Pages lent to us by a large write, mapped into the kernel so readers can copy straight
+    // out of them. While there are any, nothing else is buffered and writers have to wait.
+    OwnPtr<Region> m_lent_pages;
+    size_t m_lent_size { 0 };
+    size_t m_lent_read_offset { 0 };
+
     size_t m_read_buffer_index { 0 };
     size_t m_space_for_writing { 0 };
     bool m_empty { true };
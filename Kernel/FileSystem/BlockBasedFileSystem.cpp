@@ -25,9 +25,13 @@
  */
 
 #include <AK/IntrusiveList.h>
+#include <AK/QuickSort.h>
+#include <AK/ScopeGuard.h>
 #include <Kernel/Debug.h>
 #include <Kernel/FileSystem/BlockBasedFileSystem.h>
 #include <Kernel/Process.h>
+#include <Kernel/VM/MemoryManager.h>
+#include <Kernel/WaitQueue.h>
 
 namespace Kernel {
 
@@ -36,19 +40,35 @@ struct CacheEntry {
     BlockBasedFS::BlockIndex block_index { 0 };
     u8* data { nullptr };
     bool has_data { false };
+    bool is_hashed { false };
 };
 
+// The cache grows on demand in segments of this many bytes of block data.
+static constexpr size_t cache_segment_size = 1 * MiB;
+
+// Once this percentage of the cache is dirty, the file system's flusher thread is woken up.
+static constexpr size_t dirty_background_ratio = 10;
+// Once this percentage of the cache is dirty, writers have to write back dirty blocks themselves
+// before they can dirty any more, so they can't outrun the disk indefinitely.
+static constexpr size_t dirty_ratio = 20;
+
+// Runs of adjacent dirty blocks are written back with requests of up to this many bytes.
+static constexpr size_t max_write_back_request_size = 128 * KiB;
+
+// All flusher threads wait here; each one checks whether its own file system asked for write-back.
+static WaitQueue s_flusher_wait_queue;
+
 class DiskCache {
 public:
     explicit DiskCache(BlockBasedFS& fs)
         : m_fs(fs)
-        , m_cached_block_data(KBuffer::create_with_size(m_entry_count * m_fs.block_size()))
-        , m_entries(KBuffer::create_with_size(m_entry_count * sizeof(CacheEntry)))
+        , m_entries_per_segment(cache_segment_size / fs.block_size())
     {
-        for (size_t i = 0; i < m_entry_count; ++i) {
-            entries()[i].data = m_cached_block_data.data() + i * m_fs.block_size();
-            m_clean_list.append(entries()[i]);
-        }
+        // Never let the cache take up more than a quarter of user physical memory.
+        size_t max_memory_for_cache = (size_t)MM.user_physical_pages() * PAGE_SIZE / 4;
+        m_max_segment_count = max((size_t)1, max_memory_for_cache / cache_segment_size);
+        bool did_grow = try_grow();
+        VERIFY(did_grow);
     }
 
     ~DiskCache() { }
@@ -56,32 +76,57 @@ public:
     bool is_dirty() const { return m_dirty; }
     void set_dirty(bool b) { m_dirty = b; }
 
+    size_t dirty_count() const { return m_dirty_count; }
+    size_t max_entry_count() const { return m_max_segment_count * m_entries_per_segment; }
+
     void mark_all_clean()
     {
         while (auto* entry = m_dirty_list.first())
             m_clean_list.prepend(*entry);
         m_dirty = false;
+        m_dirty_count = 0;
     }
 
     void mark_dirty(CacheEntry& entry)
     {
+        if (!m_dirty_list.contains(entry))
+            ++m_dirty_count;
         m_dirty_list.prepend(entry);
         m_dirty = true;
     }
 
     void mark_clean(CacheEntry& entry)
     {
+        if (m_dirty_list.contains(entry))
+            --m_dirty_count;
         m_clean_list.prepend(entry);
     }
 
-    CacheEntry& get(BlockBasedFS::BlockIndex block_index) const
+    CacheEntry* find(BlockBasedFS::BlockIndex block_index) const
+    {
+        if (auto it = m_hash.find(block_index); it != m_hash.end())
+            return it->value;
+        return nullptr;
+    }
+
+    CacheEntry& get(BlockBasedFS::BlockIndex block_index)
     {
         if (auto it = m_hash.find(block_index); it != m_hash.end()) {
-            auto& entry = const_cast<CacheEntry&>(*it->value);
+            auto& entry = *it->value;
             VERIFY(entry.block_index == block_index);
+            // Keep the clean list in least recently used order.
+            if (m_clean_list.contains(entry))
+                m_clean_list.prepend(entry);
             return entry;
         }
 
+        if (is_under_memory_pressure()) {
+            try_shrink();
+        } else if (m_clean_list.is_empty() || m_clean_list.last()->is_hashed) {
+            // We'd have to evict a cached block, so try to make room instead.
+            try_grow();
+        }
+
         if (m_clean_list.is_empty()) {
             // Not a single clean entry! Flush writes and try again.
             // NOTE: We want to make sure we only call FileBackedFS flush here,
@@ -94,18 +139,17 @@ public:
         auto& new_entry = *m_clean_list.last();
         m_clean_list.prepend(new_entry);
 
-        m_hash.remove(new_entry.block_index);
+        if (new_entry.is_hashed)
+            m_hash.remove(new_entry.block_index);
         m_hash.set(block_index, &new_entry);
 
         new_entry.block_index = block_index;
         new_entry.has_data = false;
+        new_entry.is_hashed = true;
 
         return new_entry;
     }
 
-    const CacheEntry* entries() const { return (const CacheEntry*)m_entries.data(); }
-    CacheEntry* entries() { return (CacheEntry*)m_entries.data(); }
-
     template<typename Callback>
     void for_each_dirty_entry(Callback callback)
     {
@@ -114,13 +158,75 @@ public:
     }
 
 private:
+    struct Segment {
+        NonnullOwnPtr<KBuffer> cached_block_data;
+        NonnullOwnPtr<KBuffer> entries_buffer;
+
+        CacheEntry* entries() { return (CacheEntry*)entries_buffer->data(); }
+    };
+
+    static bool is_under_memory_pressure()
+    {
+        // Consider less than 1/8 of user physical memory still being available as pressure.
+        auto available_pages = MM.user_physical_pages() - MM.user_physical_pages_used() - MM.user_physical_pages_committed();
+        return available_pages < MM.user_physical_pages() / 8;
+    }
+
+    bool try_grow()
+    {
+        if (m_segments.size() >= m_max_segment_count)
+            return false;
+        auto cached_block_data = KBuffer::try_create_with_size(m_entries_per_segment * m_fs.block_size(), Region::Access::Read | Region::Access::Write, "DiskCache");
+        if (!cached_block_data)
+            return false;
+        auto entries_buffer = KBuffer::try_create_with_size(m_entries_per_segment * sizeof(CacheEntry), Region::Access::Read | Region::Access::Write, "DiskCache");
+        if (!entries_buffer)
+            return false;
+
+        m_segments.append({ cached_block_data.release_nonnull(), entries_buffer.release_nonnull() });
+        auto& segment = m_segments.last();
+        for (size_t i = 0; i < m_entries_per_segment; ++i) {
+            auto* entry = new (&segment.entries()[i]) CacheEntry;
+            entry->data = segment.cached_block_data->data() + i * m_fs.block_size();
+            // Unused entries go to the end of the clean list so they're handed out first.
+            m_clean_list.append(*entry);
+        }
+        dbgln_if(BBFS_DEBUG, "DiskCache: Grew to {} segments ({} entries)", m_segments.size(), m_segments.size() * m_entries_per_segment);
+        return true;
+    }
+
+    bool try_shrink()
+    {
+        // Always keep at least one segment around.
+        if (m_segments.size() <= 1)
+            return false;
+
+        // We can only give back the most recently added segment, and only if none of its blocks are dirty.
+        auto& segment = m_segments.last();
+        for (size_t i = 0; i < m_entries_per_segment; ++i) {
+            if (m_dirty_list.contains(segment.entries()[i]))
+                return false;
+        }
+        for (size_t i = 0; i < m_entries_per_segment; ++i) {
+            auto& entry = segment.entries()[i];
+            if (entry.is_hashed)
+                m_hash.remove(entry.block_index);
+            m_clean_list.remove(entry);
+            entry.~CacheEntry();
+        }
+        m_segments.take_last();
+        dbgln_if(BBFS_DEBUG, "DiskCache: Shrunk to {} segments ({} entries)", m_segments.size(), m_segments.size() * m_entries_per_segment);
+        return true;
+    }
+
     BlockBasedFS& m_fs;
-    size_t m_entry_count { 10000 };
-    mutable HashMap<BlockBasedFS::BlockIndex, CacheEntry*> m_hash;
-    mutable IntrusiveList<CacheEntry, &CacheEntry::list_node> m_clean_list;
-    mutable IntrusiveList<CacheEntry, &CacheEntry::list_node> m_dirty_list;
-    KBuffer m_cached_block_data;
-    KBuffer m_entries;
+    size_t m_entries_per_segment { 0 };
+    size_t m_max_segment_count { 0 };
+    Vector<Segment> m_segments;
+    HashMap<BlockBasedFS::BlockIndex, CacheEntry*> m_hash;
+    IntrusiveList<CacheEntry, &CacheEntry::list_node> m_clean_list;
+    IntrusiveList<CacheEntry, &CacheEntry::list_node> m_dirty_list;
+    size_t m_dirty_count { 0 };
     bool m_dirty { false };
 };
 
@@ -164,6 +270,7 @@ KResult BlockBasedFS::write_block(BlockIndex index, const UserOrKernelBuffer& da
 
     cache().mark_dirty(entry);
     entry.has_data = true;
+    balance_dirty_blocks();
     return KSuccess;
 }
 
@@ -279,26 +386,102 @@ KResult BlockBasedFS::read_blocks(BlockIndex index, unsigned count, UserOrKernel
     return KSuccess;
 }
 
+void BlockBasedFS::read_ahead_blocks(BlockIndex index, size_t count) const
+{
+    LOCKER(m_lock);
+    VERIFY(m_logical_block_size);
+
+    auto is_cached = [&](BlockIndex block_index) {
+        auto* entry = cache().find(block_index);
+        return entry && entry->has_data;
+    };
+
+    // Trim blocks we already have from both ends, and fetch the rest with a single request.
+    while (count && is_cached(index)) {
+        index = index.value() + 1;
+        --count;
+    }
+    while (count && is_cached(index.value() + count - 1))
+        --count;
+    if (count <= 1)
+        return;
+
+    dbgln_if(BBFS_DEBUG, "BlockBasedFileSystem::read_ahead_blocks {}, count={}", index, count);
+
+    auto* data = static_cast<u8*>(kmalloc(count * block_size()));
+    ScopeGuard free_data = [&] { kfree(data); };
+    file_description().seek(index.value() * block_size(), SEEK_SET);
+    auto data_buffer = UserOrKernelBuffer::for_kernel_buffer(data);
+    auto nread = file_description().read(data_buffer, count * block_size());
+    // This is only a hint, so the actual reads will surface the error if there is one.
+    if (nread.is_error() || nread.value() != count * block_size())
+        return;
+
+    for (size_t i = 0; i < count; ++i) {
+        // Don't clobber blocks that have been cached (and maybe written to) in the meantime.
+        auto& entry = cache().get(index.value() + i);
+        if (entry.has_data)
+            continue;
+        memcpy(entry.data, data + i * block_size(), block_size());
+        entry.has_data = true;
+    }
+}
+
 void BlockBasedFS::flush_specific_block_if_needed(BlockIndex index)
 {
     LOCKER(m_lock);
     if (!cache().is_dirty())
         return;
-    Vector<CacheEntry*, 32> cleaned_entries;
+    write_back_dirty_blocks(index);
+}
+
+size_t BlockBasedFS::write_back_dirty_blocks(Optional<BlockIndex> except_index)
+{
+    VERIFY(m_lock.is_locked());
+    Vector<CacheEntry*, 32> entries;
     cache().for_each_dirty_entry([&](CacheEntry& entry) {
-        if (entry.block_index != index) {
-            size_t base_offset = entry.block_index.value() * block_size();
-            file_description().seek(base_offset, SEEK_SET);
-            // FIXME: Should this error path be surfaced somehow?
-            auto entry_data_buffer = UserOrKernelBuffer::for_kernel_buffer(entry.data);
-            [[maybe_unused]] auto rc = file_description().write(entry_data_buffer, block_size());
-            cleaned_entries.append(&entry);
-        }
+        if (!except_index.has_value() || entry.block_index != except_index.value())
+            entries.append(&entry);
     });
+    if (entries.is_empty())
+        return 0;
+
+    // Write back in ascending block order, and merge adjacent blocks into one request,
+    // so the device sees a few large sweeps instead of many scattered small writes.
+    quick_sort(entries, [](auto* a, auto* b) { return a->block_index < b->block_index; });
+
+    size_t max_blocks_per_request = max((size_t)1, max_write_back_request_size / block_size());
+    auto* run_data = static_cast<u8*>(kmalloc(max_blocks_per_request * block_size()));
+    ScopeGuard free_run_data = [&] { kfree(run_data); };
+
+    for (size_t i = 0; i < entries.size();) {
+        size_t run_length = 1;
+        if (run_data) {
+            while (i + run_length < entries.size()
+                && run_length < max_blocks_per_request
+                && entries[i + run_length]->block_index.value() == entries[i]->block_index.value() + run_length)
+                ++run_length;
+        }
+
+        u8* data = entries[i]->data;
+        if (run_length > 1) {
+            for (size_t j = 0; j < run_length; ++j)
+                memcpy(run_data + j * block_size(), entries[i + j]->data, block_size());
+            data = run_data;
+        }
+
+        file_description().seek(entries[i]->block_index.value() * block_size(), SEEK_SET);
+        // FIXME: Should this error path be surfaced somehow?
+        auto data_buffer = UserOrKernelBuffer::for_kernel_buffer(data);
+        [[maybe_unused]] auto rc = file_description().write(data_buffer, run_length * block_size());
+        i += run_length;
+    }
+
     // NOTE: We make a separate pass to mark entries clean since marking them clean
     //       moves them out of the dirty list which would disturb the iteration above.
-    for (auto* entry : cleaned_entries)
+    for (auto* entry : entries)
         cache().mark_clean(*entry);
+    return entries.size();
 }
 
 void BlockBasedFS::flush_writes_impl()
@@ -306,15 +489,7 @@ void BlockBasedFS::flush_writes_impl()
     LOCKER(m_lock);
     if (!cache().is_dirty())
         return;
-    u32 count = 0;
-    cache().for_each_dirty_entry([&](CacheEntry& entry) {
-        u32 base_offset = entry.block_index.value() * block_size();
-        file_description().seek(base_offset, SEEK_SET);
-        // FIXME: Should this error path be surfaced somehow?
-        auto entry_data_buffer = UserOrKernelBuffer::for_kernel_buffer(entry.data);
-        [[maybe_unused]] auto rc = file_description().write(entry_data_buffer, block_size());
-        ++count;
-    });
+    auto count = write_back_dirty_blocks();
     cache().mark_all_clean();
     dbgln("{}: Flushed {} blocks to disk", class_name(), count);
 }
@@ -324,6 +499,77 @@ void BlockBasedFS::flush_writes()
     flush_writes_impl();
 }
 
+void BlockBasedFS::balance_dirty_blocks()
+{
+    VERIFY(m_lock.is_locked());
+    size_t dirty_percentage = cache().dirty_count() * 100 / cache().max_entry_count();
+    if (dirty_percentage >= dirty_ratio) {
+        dbgln_if(BBFS_DEBUG, "{}: {}% of the cache is dirty, writing back synchronously", class_name(), dirty_percentage);
+        flush_writes_impl();
+    } else if (dirty_percentage >= dirty_background_ratio) {
+        write_back();
+    }
+}
+
+void BlockBasedFS::write_back()
+{
+    m_write_back_requested = true;
+    wake_background_thread();
+}
+
+void BlockBasedFS::read_ahead_blocks_in_background(BlockIndex index, size_t count) const
+{
+    if (count <= 1)
+        return;
+    LOCKER(m_lock);
+    // If the background thread can't keep up, the reader is better off without our help.
+    if (m_pending_read_aheads.size() >= max_pending_read_aheads)
+        return;
+    m_pending_read_aheads.append({ index, count });
+    wake_background_thread();
+}
+
+void BlockBasedFS::run_pending_read_aheads()
+{
+    Vector<PendingReadAhead, max_pending_read_aheads> read_aheads;
+    {
+        LOCKER(m_lock);
+        swap(read_aheads, m_pending_read_aheads);
+    }
+    for (auto& read_ahead : read_aheads)
+        read_ahead_blocks(read_ahead.index, read_ahead.count);
+}
+
+void BlockBasedFS::wake_background_thread() const
+{
+    if (!m_flusher_thread) {
+        // Every file system gets its own flusher, so a slow device can't hold up write-back to the others.
+        // It also does the read-ahead, so sequential readers don't have to wait for blocks they haven't asked for yet.
+        Process::create_kernel_process(m_flusher_thread, String::formatted("{} flusher ({})", class_name(), fsid()), [fsid = fsid()] {
+            for (;;) {
+                RefPtr<FS> fs;
+                {
+                    InterruptDisabler disabler;
+                    fs = FS::from_fsid(fsid);
+                }
+                // The file system is gone, and so is our job.
+                if (!fs)
+                    return;
+                auto& block_based_fs = static_cast<BlockBasedFS&>(*fs);
+                if (block_based_fs.m_write_back_requested.exchange(false))
+                    block_based_fs.flush_writes();
+                block_based_fs.run_pending_read_aheads();
+                fs = nullptr;
+
+                timeval timeout { 1, 0 };
+                [[maybe_unused]] auto result = s_flusher_wait_queue.wait_on(Thread::BlockTimeout(false, &timeout), "BlockBasedFS");
+            }
+        });
+        return;
+    }
+    s_flusher_wait_queue.wake_all();
+}
+
 DiskCache& BlockBasedFS::cache() const
 {
     if (!m_cache)
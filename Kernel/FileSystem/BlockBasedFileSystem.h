@@ -26,6 +26,9 @@
 
 #pragma once
 
+#include <AK/Atomic.h>
+#include <AK/Optional.h>
+#include <AK/Vector.h>
 #include <Kernel/FileSystem/FileBackedFileSystem.h>
 
 namespace Kernel {
@@ -41,11 +44,17 @@ public:
     virtual void flush_writes() override;
     void flush_writes_impl();
 
+    // Hands write-back to this file system's flusher thread instead of doing it in the caller.
+    virtual void write_back() override;
+
 protected:
     explicit BlockBasedFS(FileDescription&);
 
     KResult read_block(BlockIndex, UserOrKernelBuffer*, size_t count, size_t offset = 0, bool allow_cache = true) const;
     KResult read_blocks(BlockIndex, unsigned count, UserOrKernelBuffer&, bool allow_cache = true) const;
+    void read_ahead_blocks(BlockIndex, size_t count) const;
+    // Like read_ahead_blocks(), but done by the flusher thread, so the caller doesn't wait for it.
+    void read_ahead_blocks_in_background(BlockIndex, size_t count) const;
 
     bool raw_read(BlockIndex, UserOrKernelBuffer&);
     bool raw_write(BlockIndex, const UserOrKernelBuffer&);
@@ -61,8 +70,22 @@ protected:
 private:
     DiskCache& cache() const;
     void flush_specific_block_if_needed(BlockIndex index);
+    size_t write_back_dirty_blocks(Optional<BlockIndex> except_index = {});
+    void balance_dirty_blocks();
+    void run_pending_read_aheads();
+    void wake_background_thread() const;
 
     mutable OwnPtr<DiskCache> m_cache;
+
+    mutable RefPtr<Thread> m_flusher_thread;
+    Atomic<bool> m_write_back_requested { false };
+
+    struct PendingReadAhead {
+        BlockIndex index;
+        size_t count { 0 };
+    };
+    static constexpr size_t max_pending_read_aheads = 16;
+    mutable Vector<PendingReadAhead, max_pending_read_aheads> m_pending_read_aheads;
 };
 
 }
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Singleton.h>
+#include <Kernel/Debug.h>
+#include <Kernel/FileSystem/DentryCache.h>
+#include <Kernel/FileSystem/Inode.h>
+
+namespace Kernel {
+
+static AK::Singleton<DentryCache> s_the;
+
+DentryCache& DentryCache::the()
+{
+    return *s_the;
+}
+
+DentryCache::DentryCache()
+{
+}
+
+size_t DentryCache::entry_count() const
+{
+    LOCKER(m_lock, Lock::Mode::Shared);
+    return m_entries.size();
+}
+
+RefPtr<Inode> DentryCache::lookup(Inode& parent, const StringView& name)
+{
+    if (!parent.fs().supports_dentry_cache())
+        return parent.lookup(name);
+
+    Key key { parent.identifier(), name };
+    u64 generation;
+    {
+        LOCKER(m_lock);
+        auto it = m_entries.find(key);
+        if (it != m_entries.end()) {
+            auto& entry = *it->value;
+            m_lru_list.remove(entry);
+            m_lru_list.append(entry);
+            ++m_hit_count;
+            return entry.inode;
+        }
+        ++m_miss_count;
+        generation = m_generation;
+    }
+
+    // The lookup may block on I/O, so don't hold the lock across it.
+    auto inode = parent.lookup(name);
+
+    // Destroyed after the lock has been released, dropping the last reference to an inode may call back into the file system.
+    OwnPtr<Entry> evicted_entry;
+    LOCKER(m_lock);
+    if (generation != m_generation || m_entries.contains(key))
+        return inode;
+
+    if (m_entries.size() >= max_entry_count) {
+        auto* victim = m_lru_list.first();
+        VERIFY(victim);
+        m_lru_list.remove(*victim);
+        auto it = m_entries.find(victim->key);
+        evicted_entry = move(it->value);
+        m_entries.remove(it);
+    }
+
+    auto entry = make<Entry>();
+    entry->key = key;
+    entry->inode = inode;
+    m_lru_list.append(*entry);
+    m_entries.set(move(key), move(entry));
+    dbgln_if(DENTRY_CACHE_DEBUG, "DentryCache: Cached {} '{}' in {}", inode ? "positive" : "negative", name, parent.identifier());
+    return inode;
+}
+
+template<typename Callback>
+void DentryCache::remove_entries_matching(Callback callback)
+{
+    Vector<NonnullOwnPtr<Entry>> removed_entries;
+    {
+        LOCKER(m_lock);
+        ++m_generation;
+        Vector<Key> keys;
+        for (auto& it : m_entries) {
+            if (callback(it.key))
+                keys.append(it.key);
+        }
+        for (auto& key : keys) {
+            auto it = m_entries.find(key);
+            m_lru_list.remove(*it->value);
+            removed_entries.append(move(it->value));
+            m_entries.remove(it);
+        }
+    }
+}
+
+void DentryCache::invalidate(const InodeIdentifier& parent, const StringView& name)
+{
+    Key key { parent, name };
+    OwnPtr<Entry> removed_entry;
+    LOCKER(m_lock);
+    ++m_generation;
+    auto it = m_entries.find(key);
+    if (it == m_entries.end())
+        return;
+    m_lru_list.remove(*it->value);
+    removed_entry = move(it->value);
+    m_entries.remove(it);
+    dbgln_if(DENTRY_CACHE_DEBUG, "DentryCache: Invalidated '{}' in {}", name, parent);
+}
+
+void DentryCache::invalidate_directory(const InodeIdentifier& parent)
+{
+    remove_entries_matching([&](auto& key) { return key.parent == parent; });
+}
+
+void DentryCache::invalidate_fs(unsigned fsid)
+{
+    remove_entries_matching([&](auto& key) { return key.parent.fsid() == fsid; });
+}
+
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/HashMap.h>
+#include <AK/IntrusiveList.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/String.h>
+#include <Kernel/FileSystem/FileSystem.h>
+#include <Kernel/Lock.h>
+
+namespace Kernel {
+
+// A global cache of directory lookups, keyed by the directory's InodeIdentifier and the name
+// looked up. Failed lookups are cached too, so repeatedly probing for files that don't exist
+// (e.g. header search paths) doesn't hit the file system every time.
+//
+// Only file systems that return true from FS::supports_dentry_cache() are cached. They must
+// call Inode::did_add_child() and Inode::did_remove_child() whenever a directory changes.
+class DentryCache {
+    AK_MAKE_ETERNAL;
+
+public:
+    static DentryCache& the();
+
+    DentryCache();
+
+    // Looks up name in parent, returning (and remembering) the result of parent.lookup(name) on a miss.
+    RefPtr<Inode> lookup(Inode& parent, const StringView& name);
+
+    void invalidate(const InodeIdentifier& parent, const StringView& name);
+    void invalidate_directory(const InodeIdentifier& parent);
+    void invalidate_fs(unsigned fsid);
+
+    size_t hit_count() const { return m_hit_count; }
+    size_t miss_count() const { return m_miss_count; }
+    size_t entry_count() const;
+
+private:
+    struct Key {
+        InodeIdentifier parent;
+        String name;
+
+        bool operator==(const Key& other) const { return parent == other.parent && name == other.name; }
+    };
+
+    struct KeyTraits : public GenericTraits<Key> {
+        static unsigned hash(const Key& key) { return pair_int_hash(Traits<InodeIdentifier>::hash(key.parent), key.name.hash()); }
+        static bool equals(const Key& a, const Key& b) { return a == b; }
+    };
+
+    struct Entry {
+        Key key;
+        // Null for a negative entry.
+        RefPtr<Inode> inode;
+        IntrusiveListNode m_lru_node;
+    };
+
+    template<typename Callback>
+    void remove_entries_matching(Callback);
+
+    static constexpr size_t max_entry_count = 8192;
+
+    mutable Lock m_lock { "DentryCache" };
+    HashMap<Key, NonnullOwnPtr<Entry>, KeyTraits> m_entries;
+    // Least recently used entries first.
+    IntrusiveList<Entry, &Entry::m_lru_node> m_lru_list;
+    // Bumped by every invalidation, so that a lookup racing with one doesn't cache a stale result.
+    u64 m_generation { 0 };
+    size_t m_hit_count { 0 };
+    size_t m_miss_count { 0 };
+};
+
+}
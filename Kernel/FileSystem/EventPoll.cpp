@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Kernel/FileSystem/EventPoll.h>
+#include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+NonnullRefPtr<EventPoll> EventPoll::create()
+{
+    return adopt(*new EventPoll);
+}
+
+EventPoll::EventPoll()
+{
+}
+
+EventPoll::~EventPoll()
+{
+    for (auto& it : m_watches)
+        it.value->stop();
+    ScopedSpinLock lock(m_ready_lock);
+    while (m_ready_list.take_first())
+        ;
+}
+
+bool EventPoll::can_read(const FileDescription&, size_t) const
+{
+    ScopedSpinLock lock(m_ready_lock);
+    return !m_ready_list.is_empty();
+}
+
+KResult EventPoll::add(int fd, FileDescription& description, const epoll_event& event)
+{
+    // Nesting would take block condition locks in both orders.
+    if (description.file().is_event_poll())
+        return EINVAL;
+
+    LOCKER(m_lock);
+    auto it = m_watches.find(fd);
+    if (it != m_watches.end()) {
+        if (it->value->m_description.ptr() == &description)
+            return EEXIST;
+        // The fd was closed and reused since it was added, so the old watch is stale.
+        remove_watch(*it->value);
+    }
+
+    auto watch = make<Watch>(*this, fd, description, event);
+    auto& watch_ref = *watch;
+    m_watches.set(fd, move(watch));
+    watch_ref.start();
+    return KSuccess;
+}
+
+KResult EventPoll::modify(int fd, FileDescription& description, const epoll_event& event)
+{
+    if (description.file().is_event_poll())
+        return EINVAL;
+
+    LOCKER(m_lock);
+    auto it = m_watches.find(fd);
+    if (it == m_watches.end())
+        return ENOENT;
+
+    auto& watch = *it->value;
+    watch.stop();
+    {
+        ScopedSpinLock lock(m_ready_lock);
+        if (watch.m_ready_list_node.is_in_list())
+            m_ready_list.remove(watch);
+    }
+    watch.set_event(description, event);
+    watch.start();
+    return KSuccess;
+}
+
+KResult EventPoll::remove(int fd)
+{
+    LOCKER(m_lock);
+    auto it = m_watches.find(fd);
+    if (it == m_watches.end())
+        return ENOENT;
+    remove_watch(*it->value);
+    return KSuccess;
+}
+
+void EventPoll::remove_watch(Watch& watch)
+{
+    VERIFY(m_lock.is_locked());
+    // Once the watch has left the block condition, nothing else can put it back on the ready list.
+    watch.stop();
+    {
+        ScopedSpinLock lock(m_ready_lock);
+        if (watch.m_ready_list_node.is_in_list())
+            m_ready_list.remove(watch);
+    }
+    m_watches.remove(watch.m_fd);
+}
+
+void EventPoll::did_become_ready(Watch& watch)
+{
+    {
+        ScopedSpinLock lock(m_ready_lock);
+        if (watch.m_ready_list_node.is_in_list())
+            return;
+        m_ready_list.append(watch);
+    }
+    evaluate_block_conditions();
+}
+
+Vector<epoll_event> EventPoll::collect_ready_events(Process& process, size_t max_events)
+{
+    Vector<epoll_event> events;
+    LOCKER(m_lock);
+
+    // Only look at what's ready right now; level-triggered watches get requeued behind it.
+    size_t ready_count = 0;
+    {
+        ScopedSpinLock lock(m_ready_lock);
+        for (auto it = m_ready_list.begin(); it != m_ready_list.end(); ++it)
+            ++ready_count;
+    }
+
+    for (size_t i = 0; i < ready_count && events.size() < max_events; ++i) {
+        Watch* watch;
+        {
+            ScopedSpinLock lock(m_ready_lock);
+            watch = m_ready_list.take_first();
+        }
+        if (!watch)
+            break;
+
+        if (process.file_description(watch->m_fd).ptr() != watch->m_description.ptr()) {
+            remove_watch(*watch);
+            continue;
+        }
+        if (watch->m_disabled)
+            continue;
+
+        auto unblock_flags = watch->m_description->should_unblock(watch->block_flags());
+        if (unblock_flags == Thread::FileBlocker::BlockFlags::None)
+            continue;
+
+        events.append({ watch->events_from_block_flags(unblock_flags), watch->m_data });
+
+        if (watch->m_events & EPOLLONESHOT) {
+            watch->m_disabled = true;
+            continue;
+        }
+        if (watch->m_events & EPOLLET)
+            continue;
+
+        ScopedSpinLock lock(m_ready_lock);
+        if (!watch->m_ready_list_node.is_in_list())
+            m_ready_list.append(*watch);
+    }
+    return events;
+}
+
+EventPoll::Watch::Watch(EventPoll& event_poll, int fd, FileDescription& description, const epoll_event& event)
+    : m_event_poll(event_poll)
+    , m_fd(fd)
+    , m_description(description)
+    , m_events(event.events)
+    , m_data(event.data)
+{
+}
+
+EventPoll::Watch::~Watch()
+{
+}
+
+void EventPoll::Watch::start()
+{
+    // Our unblock() never asks to be removed, so this always registers us.
+    [[maybe_unused]] bool added = m_description->block_condition().add_blocker(*this, this);
+    VERIFY(added);
+}
+
+void EventPoll::Watch::stop()
+{
+    m_description->block_condition().remove_blocker(*this, this);
+}
+
+void EventPoll::Watch::set_event(FileDescription& description, const epoll_event& event)
+{
+    m_description = description;
+    m_events = event.events;
+    m_data = event.data;
+    m_disabled = false;
+}
+
+bool EventPoll::Watch::unblock(bool, void*)
+{
+    if (m_disabled)
+        return false;
+    if (m_description->should_unblock(block_flags()) != BlockFlags::None)
+        m_event_poll.did_become_ready(*this);
+    return false;
+}
+
+Thread::FileBlocker::BlockFlags EventPoll::Watch::block_flags() const
+{
+    u32 flags = (u32)BlockFlags::None;
+    if (m_events & EPOLLIN)
+        flags |= (u32)BlockFlags::Read;
+    if (m_events & EPOLLOUT)
+        flags |= (u32)BlockFlags::Write;
+    if (m_events & EPOLLPRI)
+        flags |= (u32)BlockFlags::ReadPriority;
+    return (BlockFlags)flags;
+}
+
+u32 EventPoll::Watch::events_from_block_flags(BlockFlags block_flags) const
+{
+    u32 events = 0;
+    if ((u32)block_flags & (u32)BlockFlags::Read)
+        events |= EPOLLIN;
+    if ((u32)block_flags & (u32)BlockFlags::Write)
+        events |= EPOLLOUT;
+    if ((u32)block_flags & (u32)BlockFlags::ReadPriority)
+        events |= EPOLLPRI;
+    return events;
+}
+
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/HashMap.h>
+#include <AK/IntrusiveList.h>
+#include <AK/NonnullOwnPtr.h>
+#include <Kernel/FileSystem/File.h>
+#include <Kernel/Lock.h>
+#include <Kernel/SpinLock.h>
+#include <Kernel/Thread.h>
+
+namespace Kernel {
+
+// EventPoll is the File behind an epoll file descriptor. Descriptors are registered
+// once, and each registration watches its File's block condition, so that a wait
+// only has to look at the descriptors that became ready instead of at all of them.
+class EventPoll final : public File {
+public:
+    static NonnullRefPtr<EventPoll> create();
+    virtual ~EventPoll() override;
+
+    KResult add(int fd, FileDescription&, const epoll_event&);
+    KResult modify(int fd, FileDescription&, const epoll_event&);
+    KResult remove(int fd);
+
+    // Reports up to max_events ready descriptors of the given process. Level-triggered
+    // watches that are still ready go to the back of the ready list for the next wait.
+    Vector<epoll_event> collect_ready_events(Process&, size_t max_events);
+
+    virtual bool can_read(const FileDescription&, size_t) const override;
+    virtual bool can_write(const FileDescription&, size_t) const override { return false; }
+    virtual KResultOr<size_t> read(FileDescription&, size_t, UserOrKernelBuffer&, size_t) override { return EINVAL; }
+    virtual KResultOr<size_t> write(FileDescription&, size_t, const UserOrKernelBuffer&, size_t) override { return EINVAL; }
+    virtual String absolute_path(const FileDescription&) const override { return "epoll"; }
+    virtual const char* class_name() const override { return "EventPoll"; }
+    virtual bool is_event_poll() const override { return true; }
+
+private:
+    // A Watch stays registered with the watched File's block condition for as long as it
+    // exists. Its unblock() never lets go; it only moves the watch onto the ready list.
+    class Watch final : public Thread::FileBlocker {
+    public:
+        Watch(EventPoll&, int fd, FileDescription&, const epoll_event&);
+        virtual ~Watch() override;
+
+        virtual bool unblock(bool from_add_blocker, void*) override;
+        virtual void not_blocking(bool) override { VERIFY_NOT_REACHED(); }
+        virtual const char* state_string() const override { return "EventPoll"; }
+
+        void start();
+        void stop();
+        void set_event(FileDescription&, const epoll_event&);
+
+        Thread::FileBlocker::BlockFlags block_flags() const;
+        u32 events_from_block_flags(Thread::FileBlocker::BlockFlags) const;
+
+        EventPoll& m_event_poll;
+        const int m_fd;
+        NonnullRefPtr<FileDescription> m_description;
+        u32 m_events { 0 };
+        epoll_data_t m_data {};
+        bool m_disabled { false };
+        IntrusiveListNode m_ready_list_node;
+    };
+
+    EventPoll();
+
+    void did_become_ready(Watch&);
+    void remove_watch(Watch&);
+
+    Lock m_lock { "EventPoll" };
+    HashMap<int, NonnullOwnPtr<Watch>> m_watches;
+
+    mutable SpinLock<u8> m_ready_lock;
+    IntrusiveList<Watch, &Watch::m_ready_list_node> m_ready_list;
+};
+
+}
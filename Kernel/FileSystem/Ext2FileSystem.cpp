@@ -27,6 +27,7 @@
 #include <AK/Bitmap.h>
 #include <AK/HashMap.h>
 #include <AK/MemoryStream.h>
+#include <AK/QuickSort.h>
 #include <AK/StdLibExtras.h>
 #include <AK/StringView.h>
 #include <Kernel/Debug.h>
@@ -36,6 +37,7 @@
 #include <Kernel/FileSystem/ext2_fs.h>
 #include <Kernel/Process.h>
 #include <Kernel/UnixTypes.h>
+#include <Kernel/VM/MemoryManager.h>
 #include <LibC/errno_numbers.h>
 
 namespace Kernel {
@@ -74,6 +76,157 @@ static unsigned divide_rounded_up(unsigned a, unsigned b)
     return (a / b) + (a % b != 0);
 }
 
+// Directory entry hashing for indexed directories, compatible with the ext2/3/4 "dx" hashes.
+
+static void str_to_hash_buffer(const u8* name, size_t length, u32* buffer, size_t word_count, bool is_unsigned)
+{
+    u32 pad = (u32)length | ((u32)length << 8);
+    pad |= pad << 16;
+
+    u32 value = pad;
+    if (length > word_count * 4)
+        length = word_count * 4;
+    for (size_t i = 0; i < length; ++i) {
+        int c = is_unsigned ? (int)name[i] : (int)(i8)name[i];
+        value = (u32)c + (value << 8);
+        if ((i % 4) == 3) {
+            *buffer++ = value;
+            value = pad;
+            --word_count;
+        }
+    }
+    if (word_count > 0) {
+        *buffer++ = value;
+        --word_count;
+    }
+    while (word_count-- > 0)
+        *buffer++ = pad;
+}
+
+static u32 legacy_directory_hash(const u8* name, size_t length, bool is_unsigned)
+{
+    u32 hash0 = 0x12a3fe2d;
+    u32 hash1 = 0x37abe8f9;
+    for (size_t i = 0; i < length; ++i) {
+        int c = is_unsigned ? (int)name[i] : (int)(i8)name[i];
+        u32 hash = hash1 + (hash0 ^ (u32)(c * 7152373));
+        if (hash & 0x80000000)
+            hash -= 0x7fffffff;
+        hash1 = hash0;
+        hash0 = hash;
+    }
+    return hash0 << 1;
+}
+
+static inline u32 rotate_left(u32 value, unsigned shift)
+{
+    return (value << shift) | (value >> (32 - shift));
+}
+
+static void half_md4_transform(u32 buffer[4], const u32 in[8])
+{
+    u32 a = buffer[0], b = buffer[1], c = buffer[2], d = buffer[3];
+
+    auto f = [](u32 x, u32 y, u32 z) { return z ^ (x & (y ^ z)); };
+    auto g = [](u32 x, u32 y, u32 z) { return (x & y) + ((x ^ y) & z); };
+    auto h = [](u32 x, u32 y, u32 z) { return x ^ y ^ z; };
+    constexpr u32 k2 = 013240474631u;
+    constexpr u32 k3 = 015666365641u;
+
+#define ROUND(fn, a, b, c, d, x, s) a = rotate_left(a + fn(b, c, d) + (x), s)
+    ROUND(f, a, b, c, d, in[0], 3);
+    ROUND(f, d, a, b, c, in[1], 7);
+    ROUND(f, c, d, a, b, in[2], 11);
+    ROUND(f, b, c, d, a, in[3], 19);
+    ROUND(f, a, b, c, d, in[4], 3);
+    ROUND(f, d, a, b, c, in[5], 7);
+    ROUND(f, c, d, a, b, in[6], 11);
+    ROUND(f, b, c, d, a, in[7], 19);
+
+    ROUND(g, a, b, c, d, in[1] + k2, 3);
+    ROUND(g, d, a, b, c, in[3] + k2, 5);
+    ROUND(g, c, d, a, b, in[5] + k2, 9);
+    ROUND(g, b, c, d, a, in[7] + k2, 13);
+    ROUND(g, a, b, c, d, in[0] + k2, 3);
+    ROUND(g, d, a, b, c, in[2] + k2, 5);
+    ROUND(g, c, d, a, b, in[4] + k2, 9);
+    ROUND(g, b, c, d, a, in[6] + k2, 13);
+
+    ROUND(h, a, b, c, d, in[3] + k3, 3);
+    ROUND(h, d, a, b, c, in[7] + k3, 9);
+    ROUND(h, c, d, a, b, in[2] + k3, 11);
+    ROUND(h, b, c, d, a, in[6] + k3, 15);
+    ROUND(h, a, b, c, d, in[1] + k3, 3);
+    ROUND(h, d, a, b, c, in[5] + k3, 9);
+    ROUND(h, c, d, a, b, in[0] + k3, 11);
+    ROUND(h, b, c, d, a, in[4] + k3, 15);
+#undef ROUND
+
+    buffer[0] += a;
+    buffer[1] += b;
+    buffer[2] += c;
+    buffer[3] += d;
+}
+
+static void tea_transform(u32 buffer[4], const u32 in[4])
+{
+    u32 sum = 0;
+    u32 b0 = buffer[0], b1 = buffer[1];
+    u32 a = in[0], b = in[1], c = in[2], d = in[3];
+    for (int n = 0; n < 16; ++n) {
+        sum += 0x9e3779b9;
+        b0 += ((b1 << 4) + a) ^ (b1 + sum) ^ ((b1 >> 5) + b);
+        b1 += ((b0 << 4) + c) ^ (b0 + sum) ^ ((b0 >> 5) + d);
+    }
+    buffer[0] += b0;
+    buffer[1] += b1;
+}
+
+static u32 compute_directory_hash(const StringView& name, u8 hash_version, const u32 seed[4])
+{
+    u32 buffer[4] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 };
+    if (seed[0] || seed[1] || seed[2] || seed[3]) {
+        for (size_t i = 0; i < 4; ++i)
+            buffer[i] = seed[i];
+    }
+
+    auto* characters = reinterpret_cast<const u8*>(name.characters_without_null_termination());
+    size_t length = name.length();
+    u32 hash = 0;
+    u32 in[8];
+
+    switch (hash_version) {
+    case EXT2_HASH_LEGACY:
+    case EXT2_HASH_LEGACY_UNSIGNED:
+        hash = legacy_directory_hash(characters, length, hash_version == EXT2_HASH_LEGACY_UNSIGNED);
+        break;
+    case EXT2_HASH_HALF_MD4:
+    case EXT2_HASH_HALF_MD4_UNSIGNED:
+        for (size_t offset = 0; offset < length; offset += 32) {
+            str_to_hash_buffer(characters + offset, length - offset, in, 8, hash_version == EXT2_HASH_HALF_MD4_UNSIGNED);
+            half_md4_transform(buffer, in);
+        }
+        hash = buffer[1];
+        break;
+    case EXT2_HASH_TEA:
+    case EXT2_HASH_TEA_UNSIGNED:
+        for (size_t offset = 0; offset < length; offset += 16) {
+            str_to_hash_buffer(characters + offset, length - offset, in, 4, hash_version == EXT2_HASH_TEA_UNSIGNED);
+            tea_transform(buffer, in);
+        }
+        hash = buffer[0];
+        break;
+    default:
+        VERIFY_NOT_REACHED();
+    }
+
+    // The lowest bit is used to mark hash collisions that continue in the next block.
+    hash &= ~1u;
+    if (hash == (0x7fffffffu << 1))
+        hash = (0x7fffffffu - 1) << 1;
+    return hash;
+}
+
 NonnullRefPtr<Ext2FS> Ext2FS::create(FileDescription& file_description)
 {
     return adopt(*new Ext2FS(file_description));
@@ -595,6 +748,7 @@ void Ext2FS::flush_block_group_descriptor_table()
 
 void Ext2FS::flush_writes()
 {
+    Vector<RefPtr<Ext2FSInode>> evicted_inodes;
     LOCKER(m_lock);
     if (m_super_block_dirty) {
         flush_super_block();
@@ -618,22 +772,57 @@ void Ext2FS::flush_writes()
 
     BlockBasedFS::flush_writes();
 
-    // Uncache Inodes that are only kept alive by the index-to-inode lookup cache.
-    // We don't uncache Inodes that are being watched by at least one InodeWatcher.
+    // Catch up with memory pressure that came up since the cache last grew.
+    evict_unused_inodes(inode_cache_limit(), evicted_inodes);
+}
 
-    // FIXME: It would be better to keep a capped number of Inodes around.
-    //        The problem is that they are quite heavy objects, and use a lot of heap memory
-    //        for their (child name lookup) and (block list) caches.
-    Vector<InodeIndex> unused_inodes;
+size_t Ext2FS::inode_cache_limit() const
+{
+    // Inodes are quite heavy objects, they use a lot of heap memory for their
+    // (child name lookup) and (block list) caches. Keep fewer of them around when memory gets tight.
+    switch (MM.memory_pressure_level()) {
+    case MemoryPressureLevel::Low:
+        return max_cached_inodes;
+    case MemoryPressureLevel::Medium:
+        return max_cached_inodes / 8;
+    case MemoryPressureLevel::Critical:
+        return max_cached_inodes / 64;
+    }
+    VERIFY_NOT_REACHED();
+}
+
+void Ext2FS::evict_unused_inodes(size_t count, Vector<RefPtr<Ext2FSInode>>& evicted_inodes) const
+{
+    VERIFY(m_lock.is_locked());
+    if (m_inode_cache.size() <= count)
+        return;
+
+    // Inodes only kept alive by the cache can go, unless they're being watched by an InodeWatcher.
+    // Entries for inodes that don't exist are the cheapest to get back, so they go first.
+    struct Candidate {
+        u64 last_used;
+        InodeIndex index;
+    };
+    Vector<Candidate> candidates;
     for (auto& it : m_inode_cache) {
-        if (it.value->ref_count() != 1)
+        if (!it.value) {
+            candidates.append({ 0, it.key });
             continue;
-        if (it.value->has_watchers())
+        }
+        if (it.value->ref_count() != 1 || it.value->has_watchers())
             continue;
-        unused_inodes.append(it.key);
+        candidates.append({ it.value->m_last_used, it.key });
+    }
+    quick_sort(candidates, [](auto& a, auto& b) { return a.last_used < b.last_used; });
+
+    size_t evict_count = min(candidates.size(), m_inode_cache.size() - count);
+    dbgln_if(EXT2_DEBUG, "Ext2FS: Evicting {} of {} cached inodes", evict_count, m_inode_cache.size());
+    for (size_t i = 0; i < evict_count; ++i) {
+        auto it = m_inode_cache.find(candidates[i].index);
+        if (it->value)
+            evicted_inodes.append(move(it->value));
+        m_inode_cache.remove(it);
     }
-    for (auto index : unused_inodes)
-        uncache_inode(index);
 }
 
 Ext2FSInode::Ext2FSInode(Ext2FS& fs, InodeIndex index)
@@ -691,15 +880,24 @@ void Ext2FSInode::flush_metadata()
 
 RefPtr<Inode> Ext2FS::get_inode(InodeIdentifier inode) const
 {
+    Vector<RefPtr<Ext2FSInode>> evicted_inodes;
     LOCKER(m_lock);
     VERIFY(inode.fsid() == fsid());
 
     {
         auto it = m_inode_cache.find(inode.index());
-        if (it != m_inode_cache.end())
+        if (it != m_inode_cache.end()) {
+            if ((*it).value)
+                (*it).value->m_last_used = ++m_inode_cache_clock;
             return (*it).value;
+        }
     }
 
+    // Room for the new entry, leaving some slack so we don't have to do this for every miss.
+    auto cache_limit = inode_cache_limit();
+    if (m_inode_cache.size() >= cache_limit)
+        evict_unused_inodes(cache_limit * 3 / 4, evicted_inodes);
+
     auto state_or_error = get_inode_allocation_state(inode.index());
     if (state_or_error.is_error())
         return {};
@@ -714,7 +912,19 @@ RefPtr<Inode> Ext2FS::get_inode(InodeIdentifier inode) const
     if (!find_block_containing_inode(inode.index(), block_index, offset))
         return {};
 
+    // Listing a directory stats inodes that were mostly allocated together, so once misses
+    // come close to each other, fetch the following inode table blocks along with this one.
+    auto group_index = group_index_from_inode(inode.index());
+    auto distance_from_last_miss = max(inode.index().value(), m_last_missed_inode.value()) - min(inode.index().value(), m_last_missed_inode.value());
+    if (group_index == group_index_from_inode(m_last_missed_inode) && distance_from_last_miss <= inodes_per_block() * inode_table_read_ahead_blocks) {
+        auto& bgd = group_descriptor(group_index);
+        u64 inode_table_end = bgd.bg_inode_table + ceil_div((size_t)inodes_per_group() * inode_size(), block_size());
+        read_ahead_blocks(block_index, min((u64)inode_table_read_ahead_blocks, inode_table_end - block_index.value()));
+    }
+    m_last_missed_inode = inode.index();
+
     auto new_inode = adopt(*new Ext2FSInode(const_cast<Ext2FS&>(*this), inode.index()));
+    new_inode->m_last_used = ++m_inode_cache_clock;
     auto buffer = UserOrKernelBuffer::for_kernel_buffer(reinterpret_cast<u8*>(&new_inode->m_raw_inode));
     auto result = read_block(block_index, &buffer, sizeof(ext2_inode), offset);
     if (result.is_error()) {
@@ -764,6 +974,17 @@ ssize_t Ext2FSInode::read_bytes(off_t offset, ssize_t count, UserOrKernelBuffer&
     ssize_t nread = 0;
     size_t remaining_count = min((off_t)count, (off_t)size() - offset);
 
+    if (allow_cache && offset < (off_t)size()) {
+        // Fetch all the blocks we are about to read in as few requests as possible. If this description
+        // is being read sequentially, have the blocks past the end fetched while the caller works on these.
+        read_ahead(first_block_logical_index, last_block_logical_index, false);
+        size_t read_ahead_block_count = 0;
+        if (description)
+            read_ahead_block_count = ceil_div(description->update_read_ahead_window(offset, remaining_count), (size_t)block_size);
+        if (read_ahead_block_count && last_block_logical_index + 1 < m_block_list.size())
+            read_ahead(last_block_logical_index + 1, min(last_block_logical_index + read_ahead_block_count, m_block_list.size() - 1), true);
+    }
+
     dbgln_if(EXT2_VERY_DEBUG, "Ext2FS: Reading up to {} bytes, {} bytes into inode {} to {}", count, offset, index(), buffer.user_or_kernel_ptr());
 
     for (size_t bi = first_block_logical_index; remaining_count && bi <= last_block_logical_index; ++bi) {
@@ -784,6 +1005,21 @@ ssize_t Ext2FSInode::read_bytes(off_t offset, ssize_t count, UserOrKernelBuffer&
     return nread;
 }
 
+void Ext2FSInode::read_ahead(size_t first_block_logical_index, size_t last_block_logical_index, bool in_background) const
+{
+    // Issue one read for every run of blocks that are contiguous on disk.
+    size_t run_start = first_block_logical_index;
+    for (size_t bi = first_block_logical_index + 1; bi <= last_block_logical_index + 1; ++bi) {
+        if (bi <= last_block_logical_index && m_block_list[bi].value() == m_block_list[bi - 1].value() + 1)
+            continue;
+        if (in_background)
+            fs().read_ahead_blocks_in_background(m_block_list[run_start], bi - run_start);
+        else
+            fs().read_ahead_blocks(m_block_list[run_start], bi - run_start);
+        run_start = bi;
+    }
+}
+
 KResult Ext2FSInode::resize(u64 new_size)
 {
     u64 old_size = size();
@@ -812,7 +1048,11 @@ KResult Ext2FSInode::resize(u64 new_size)
         block_list = this->compute_block_list();
 
     if (blocks_needed_after > blocks_needed_before) {
-        auto blocks_or_error = fs().allocate_blocks(fs().group_index_from_inode(index()), blocks_needed_after - blocks_needed_before);
+        // Try to place the new blocks right behind the current last block of the file.
+        Ext2FS::BlockIndex goal = 0;
+        if (!block_list.is_empty() && block_list.last().value())
+            goal = block_list.last().value() + 1;
+        auto blocks_or_error = fs().allocate_blocks(fs().group_index_from_inode(index()), blocks_needed_after - blocks_needed_before, goal);
         if (blocks_or_error.is_error())
             return blocks_or_error.error();
         block_list.append(blocks_or_error.release_value());
@@ -1036,6 +1276,609 @@ KResult Ext2FSInode::write_directory(const Vector<Ext2FSDirectoryEntry>& entries
     return KSuccess;
 }
 
+// In an indexed directory, block 0 holds "." and "..", and the root of the index hides behind
+// the record of "..". Interior index nodes are blocks holding a single unused record that spans
+// the whole block, followed by the node's entries. Either way, the directory stays readable as
+// a plain linear directory.
+static constexpr size_t dx_root_info_offset = 24;
+static constexpr size_t dx_node_entries_offset = 8;
+static constexpr u8 dx_max_indirect_levels = 1;
+static constexpr u32 dx_hash_continued = 1;
+
+struct Ext2FSInode::DirectoryIndexFrame {
+    size_t block_index { 0 };
+    ByteBuffer block;
+    size_t entries_offset { 0 };
+    size_t position { 0 };
+
+    // The count and limit of a node share their space with the (unused) hash of its first entry.
+    ext2_dx_countlimit& countlimit() { return *reinterpret_cast<ext2_dx_countlimit*>(block.data() + entries_offset); }
+    ext2_dx_entry* entries() { return reinterpret_cast<ext2_dx_entry*>(block.data() + entries_offset); }
+    ext2_dx_entry& current() { return entries()[position]; }
+
+    bool is_valid()
+    {
+        auto& countlimit = this->countlimit();
+        return countlimit.limit == (block.size() - entries_offset) / sizeof(ext2_dx_entry) && countlimit.count > 0 && countlimit.count <= countlimit.limit;
+    }
+
+    void insert(size_t new_position, u32 hash, u32 block_index)
+    {
+        auto& countlimit = this->countlimit();
+        VERIFY(new_position > 0 && new_position <= countlimit.count);
+        VERIFY(countlimit.count < countlimit.limit);
+        auto* entries = this->entries();
+        memmove(&entries[new_position + 1], &entries[new_position], (countlimit.count - new_position) * sizeof(ext2_dx_entry));
+        entries[new_position] = { hash, block_index };
+        ++countlimit.count;
+    }
+};
+
+static ext2_dx_root_info& dx_root_info(ByteBuffer& root_block)
+{
+    return *reinterpret_cast<ext2_dx_root_info*>(root_block.data() + dx_root_info_offset);
+}
+
+template<typename Callback>
+static bool for_each_record_in_directory_block(const ByteBuffer& block, Callback callback)
+{
+    size_t offset = 0;
+    while (offset < block.size()) {
+        if (block.size() - offset < 8)
+            return false;
+        auto& record = *reinterpret_cast<const ext2_dir_entry_2*>(block.data() + offset);
+        if (record.rec_len < 8 || record.rec_len % 4 != 0 || record.rec_len > block.size() - offset || record.name_len + 8u > record.rec_len)
+            return false;
+        if (callback(offset, record) == IterationDecision::Break)
+            return true;
+        offset += record.rec_len;
+    }
+    return true;
+}
+
+static void write_directory_record(ByteBuffer& block, size_t offset, size_t record_length, InodeIndex inode_index, u8 file_type, const StringView& name)
+{
+    VERIFY(offset + record_length <= block.size());
+    VERIFY(EXT2_DIR_REC_LEN(name.length()) <= record_length);
+    auto& record = *reinterpret_cast<ext2_dir_entry_2*>(block.data() + offset);
+    record.inode = inode_index.value();
+    record.rec_len = record_length;
+    record.name_len = name.length();
+    record.file_type = file_type;
+    memcpy(record.name, name.characters_without_null_termination(), name.length());
+    memset(record.name + name.length(), 0, EXT2_DIR_REC_LEN(name.length()) - 8 - name.length());
+}
+
+// Tries to fit a new record into a directory block, either by reusing an unused record or by
+// splitting off the slack space at the end of a used one.
+static KResultOr<bool> try_insert_directory_record(ByteBuffer& block, const StringView& name, InodeIndex inode_index, u8 file_type)
+{
+    size_t needed_length = EXT2_DIR_REC_LEN(name.length());
+    Optional<size_t> found_offset;
+    size_t used_length = 0;
+    bool valid = for_each_record_in_directory_block(block, [&](size_t offset, auto& record) {
+        used_length = record.inode == 0 ? 0 : EXT2_DIR_REC_LEN(record.name_len);
+        if (record.rec_len < used_length + needed_length)
+            return IterationDecision::Continue;
+        found_offset = offset;
+        return IterationDecision::Break;
+    });
+    if (!valid)
+        return EIO;
+    if (!found_offset.has_value())
+        return false;
+
+    auto offset = found_offset.value();
+    auto& record = *reinterpret_cast<ext2_dir_entry_2*>(block.data() + offset);
+    if (used_length == 0) {
+        write_directory_record(block, offset, record.rec_len, inode_index, file_type, name);
+        return true;
+    }
+    size_t record_length = record.rec_len - used_length;
+    record.rec_len = used_length;
+    write_directory_record(block, offset + used_length, record_length, inode_index, file_type, name);
+    return true;
+}
+
+bool Ext2FSInode::is_indexed_directory() const
+{
+    return fs().has_directory_index_feature() && (m_raw_inode.i_flags & EXT2_INDEX_FL);
+}
+
+size_t Ext2FSInode::directory_block_count() const
+{
+    return size() / fs().block_size();
+}
+
+KResultOr<ByteBuffer> Ext2FSInode::read_directory_block(size_t block_index) const
+{
+    size_t block_size = fs().block_size();
+    auto block = ByteBuffer::create_uninitialized(block_size);
+    auto buffer = UserOrKernelBuffer::for_kernel_buffer(block.data());
+    ssize_t nread = read_bytes(block_index * block_size, block_size, buffer, nullptr);
+    if (nread < 0)
+        return KResult((ErrnoCode)-nread);
+    if (static_cast<size_t>(nread) != block_size)
+        return EIO;
+    return block;
+}
+
+KResult Ext2FSInode::write_directory_block(size_t block_index, const ByteBuffer& block)
+{
+    size_t block_size = fs().block_size();
+    VERIFY(block.size() == block_size);
+    auto buffer = UserOrKernelBuffer::for_kernel_buffer(const_cast<u8*>(block.data()));
+    ssize_t nwritten = write_bytes(block_index * block_size, block_size, buffer, nullptr);
+    if (nwritten < 0)
+        return KResult((ErrnoCode)-nwritten);
+    set_metadata_dirty(true);
+    if (static_cast<size_t>(nwritten) != block_size)
+        return EIO;
+    return KSuccess;
+}
+
+KResultOr<Ext2FSInode::DirectoryEntryLocation> Ext2FSInode::find_entry_in_directory_block(size_t block_index, const StringView& name) const
+{
+    auto block_or_error = read_directory_block(block_index);
+    if (block_or_error.is_error())
+        return block_or_error.error();
+    auto block = block_or_error.release_value();
+
+    Optional<size_t> found_offset;
+    Optional<size_t> previous_offset;
+    InodeIndex inode_index = 0;
+    bool valid = for_each_record_in_directory_block(block, [&](size_t offset, auto& record) {
+        if (record.inode != 0 && name == StringView(record.name, record.name_len)) {
+            found_offset = offset;
+            inode_index = record.inode;
+            return IterationDecision::Break;
+        }
+        previous_offset = offset;
+        return IterationDecision::Continue;
+    });
+    if (!valid) {
+        dbgln("Ext2FSInode: Corrupt block {} in directory {}", block_index, index());
+        return EIO;
+    }
+    if (!found_offset.has_value())
+        return ENOENT;
+    return DirectoryEntryLocation { block_index, move(block), found_offset.value(), previous_offset, inode_index };
+}
+
+KResultOr<Ext2FSInode::DirectoryEntryLocation> Ext2FSInode::find_directory_entry(const StringView& name) const
+{
+    // "." and ".." are always at the start of the first block, which a linear scan reaches right away.
+    if (is_indexed_directory() && name != "." && name != "..") {
+        auto location_or_error = find_indexed_directory_entry(name);
+        if (!location_or_error.is_error() || location_or_error.error().error() != -EINVAL)
+            return location_or_error;
+        dbgln("Ext2FSInode: Unusable index in directory {}, falling back to a linear scan", index());
+    }
+
+    size_t block_count = directory_block_count();
+    for (size_t block_index = 0; block_index < block_count; ++block_index) {
+        auto location_or_error = find_entry_in_directory_block(block_index, name);
+        if (!location_or_error.is_error() || location_or_error.error().error() != -ENOENT)
+            return location_or_error;
+    }
+    return ENOENT;
+}
+
+u32 Ext2FSInode::directory_hash(const StringView& name, u8 hash_version) const
+{
+    auto& super_block = fs().super_block();
+    if (hash_version <= EXT2_HASH_TEA && (super_block.s_flags & EXT2_FLAGS_UNSIGNED_HASH))
+        hash_version += EXT2_HASH_LEGACY_UNSIGNED;
+    return compute_directory_hash(name, hash_version, super_block.s_hash_seed);
+}
+
+KResultOr<Vector<Ext2FSInode::DirectoryIndexFrame>> Ext2FSInode::probe_directory_index(const StringView& name, u32& hash) const
+{
+    auto root_block_or_error = read_directory_block(0);
+    if (root_block_or_error.is_error())
+        return root_block_or_error.error();
+    auto root_block = root_block_or_error.release_value();
+
+    auto& info = dx_root_info(root_block);
+    if (info.reserved_zero != 0 || info.hash_version > EXT2_HASH_TEA || info.info_length < sizeof(ext2_dx_root_info) || info.indirect_levels > dx_max_indirect_levels || (info.unused_flags & EXT2_HASH_FLAG_INCOMPAT)) {
+        dbgln_if(EXT2_DEBUG, "Ext2FSInode: Unsupported index root in directory {}", index());
+        return EINVAL;
+    }
+    hash = directory_hash(name, info.hash_version);
+    size_t indirect_levels = info.indirect_levels;
+    size_t block_count = directory_block_count();
+
+    Vector<DirectoryIndexFrame> frames;
+    DirectoryIndexFrame frame { 0, move(root_block), dx_root_info_offset + info.info_length, 0 };
+    for (;;) {
+        if (!frame.is_valid()) {
+            dbgln_if(EXT2_DEBUG, "Ext2FSInode: Invalid index block {} in directory {}", frame.block_index, index());
+            return EINVAL;
+        }
+
+        // Find the last entry whose hash is not above ours. The first entry has no hash of its own,
+        // and covers everything below the hash of the second one.
+        auto* entries = frame.entries();
+        size_t low = 1;
+        size_t high = frame.countlimit().count;
+        while (low < high) {
+            size_t middle = low + (high - low) / 2;
+            if (entries[middle].hash > hash)
+                high = middle;
+            else
+                low = middle + 1;
+        }
+        frame.position = low - 1;
+
+        size_t child_block_index = frame.current().block;
+        if (child_block_index == 0 || child_block_index >= block_count)
+            return EINVAL;
+        frames.append(move(frame));
+        if (frames.size() > indirect_levels)
+            return frames;
+
+        auto node_or_error = read_directory_block(child_block_index);
+        if (node_or_error.is_error())
+            return node_or_error.error();
+        frame = { child_block_index, node_or_error.release_value(), dx_node_entries_offset, 0 };
+    }
+}
+
+// Entries whose hashes collide can spill over into the following leaves, which is marked by
+// setting the lowest bit of the hash that leads to those leaves.
+KResultOr<bool> Ext2FSInode::advance_to_next_directory_leaf(Vector<DirectoryIndexFrame>& frames, u32 hash) const
+{
+    size_t level = frames.size() - 1;
+    for (;;) {
+        auto& frame = frames[level];
+        if (++frame.position < frame.countlimit().count)
+            break;
+        if (level == 0)
+            return false;
+        --level;
+    }
+
+    u32 next_hash = frames[level].current().hash;
+    if (!(next_hash & dx_hash_continued) || (next_hash & ~dx_hash_continued) != hash)
+        return false;
+
+    for (++level; level < frames.size(); ++level) {
+        size_t node_block_index = frames[level - 1].current().block;
+        if (node_block_index == 0 || node_block_index >= directory_block_count())
+            return EIO;
+        auto node_or_error = read_directory_block(node_block_index);
+        if (node_or_error.is_error())
+            return node_or_error.error();
+        frames[level] = { node_block_index, node_or_error.release_value(), dx_node_entries_offset, 0 };
+        if (!frames[level].is_valid())
+            return EIO;
+    }
+    return true;
+}
+
+KResultOr<Ext2FSInode::DirectoryEntryLocation> Ext2FSInode::find_indexed_directory_entry(const StringView& name) const
+{
+    u32 hash = 0;
+    auto frames_or_error = probe_directory_index(name, hash);
+    if (frames_or_error.is_error())
+        return frames_or_error.error();
+    auto& frames = frames_or_error.value();
+
+    for (;;) {
+        auto location_or_error = find_entry_in_directory_block(frames.last().current().block, name);
+        if (!location_or_error.is_error() || location_or_error.error().error() != -ENOENT)
+            return location_or_error;
+        auto advanced_or_error = advance_to_next_directory_leaf(frames, hash);
+        if (advanced_or_error.is_error())
+            return advanced_or_error.error();
+        if (!advanced_or_error.value())
+            return ENOENT;
+    }
+}
+
+KResult Ext2FSInode::add_directory_entry(const StringView& name, InodeIndex inode_index, u8 file_type)
+{
+    if (is_indexed_directory()) {
+        auto result = add_indexed_directory_entry(name, inode_index, file_type);
+        if (result.error() != -EINVAL)
+            return result;
+        dbgln("Ext2FSInode: Dropping unusable index of directory {}", index());
+        drop_directory_index();
+    }
+    return add_linear_directory_entry(name, inode_index, file_type);
+}
+
+KResult Ext2FSInode::add_linear_directory_entry(const StringView& name, InodeIndex inode_index, u8 file_type)
+{
+    // Adding entries behind the back of an index would make it go stale.
+    if (m_raw_inode.i_flags & EXT2_INDEX_FL)
+        drop_directory_index();
+
+    size_t block_count = directory_block_count();
+    for (size_t block_index = 0; block_index < block_count; ++block_index) {
+        auto block_or_error = read_directory_block(block_index);
+        if (block_or_error.is_error())
+            return block_or_error.error();
+        auto& block = block_or_error.value();
+        auto inserted_or_error = try_insert_directory_record(block, name, inode_index, file_type);
+        if (inserted_or_error.is_error())
+            return inserted_or_error.error();
+        if (inserted_or_error.value())
+            return write_directory_block(block_index, block);
+    }
+
+    // Once a directory outgrows its first block, index it so that it can keep growing cheaply.
+    if (block_count == 1 && fs().has_directory_index_feature()) {
+        auto result = make_indexed_directory();
+        if (result.is_error())
+            return result;
+        return add_indexed_directory_entry(name, inode_index, file_type);
+    }
+
+    size_t block_size = fs().block_size();
+    auto block = ByteBuffer::create_zeroed(block_size);
+    write_directory_record(block, 0, block_size, inode_index, file_type, name);
+    return write_directory_block(block_count, block);
+}
+
+KResult Ext2FSInode::make_indexed_directory()
+{
+    VERIFY(directory_block_count() == 1);
+    size_t block_size = fs().block_size();
+
+    auto block_or_error = read_directory_block(0);
+    if (block_or_error.is_error())
+        return block_or_error.error();
+    auto& block = block_or_error.value();
+
+    // Everything but "." and ".." moves over to the first leaf.
+    auto leaf = ByteBuffer::create_zeroed(block_size);
+    size_t leaf_size = 0;
+    size_t last_leaf_offset = 0;
+    InodeIndex dot_inode_index = 0;
+    InodeIndex dot_dot_inode_index = 0;
+    bool valid = for_each_record_in_directory_block(block, [&](size_t, auto& record) {
+        if (record.inode == 0)
+            return IterationDecision::Continue;
+        StringView name { record.name, record.name_len };
+        if (name == ".") {
+            dot_inode_index = record.inode;
+        } else if (name == "..") {
+            dot_dot_inode_index = record.inode;
+        } else {
+            last_leaf_offset = leaf_size;
+            write_directory_record(leaf, leaf_size, EXT2_DIR_REC_LEN(record.name_len), record.inode, record.file_type, name);
+            leaf_size += EXT2_DIR_REC_LEN(record.name_len);
+        }
+        return IterationDecision::Continue;
+    });
+    if (!valid || dot_inode_index == 0 || dot_dot_inode_index == 0) {
+        dbgln("Ext2FSInode: Corrupt first block in directory {}", index());
+        return EIO;
+    }
+    if (leaf_size == 0)
+        write_directory_record(leaf, 0, block_size, 0, EXT2_FT_UNKNOWN, {});
+    else
+        reinterpret_cast<ext2_dir_entry_2*>(leaf.data() + last_leaf_offset)->rec_len += block_size - leaf_size;
+
+    auto root = ByteBuffer::create_zeroed(block_size);
+    write_directory_record(root, 0, EXT2_DIR_REC_LEN(1), dot_inode_index, EXT2_FT_DIR, ".");
+    write_directory_record(root, EXT2_DIR_REC_LEN(1), block_size - EXT2_DIR_REC_LEN(1), dot_dot_inode_index, EXT2_FT_DIR, "..");
+    auto& info = dx_root_info(root);
+    info.hash_version = fs().super_block().s_def_hash_version;
+    if (info.hash_version > EXT2_HASH_TEA)
+        info.hash_version = EXT2_HASH_HALF_MD4;
+    info.info_length = sizeof(ext2_dx_root_info);
+    DirectoryIndexFrame frame { 0, move(root), dx_root_info_offset + sizeof(ext2_dx_root_info), 0 };
+    frame.countlimit() = { static_cast<u16>((block_size - frame.entries_offset) / sizeof(ext2_dx_entry)), 1 };
+    frame.entries()[0].block = 1;
+
+    auto result = write_directory_block(1, leaf);
+    if (result.is_error())
+        return result;
+    result = write_directory_block(0, frame.block);
+    if (result.is_error())
+        return result;
+
+    dbgln_if(EXT2_DEBUG, "Ext2FSInode: Indexing directory {}", index());
+    m_raw_inode.i_flags |= EXT2_INDEX_FL;
+    set_metadata_dirty(true);
+    // Lookups in indexed directories go through the index, so don't keep the cache around.
+    m_lookup_cache.clear();
+    return KSuccess;
+}
+
+void Ext2FSInode::drop_directory_index()
+{
+    m_raw_inode.i_flags &= ~EXT2_INDEX_FL;
+    set_metadata_dirty(true);
+}
+
+KResult Ext2FSInode::add_indexed_directory_entry(const StringView& name, InodeIndex inode_index, u8 file_type)
+{
+    u32 hash = 0;
+    auto frames_or_error = probe_directory_index(name, hash);
+    if (frames_or_error.is_error())
+        return frames_or_error.error();
+    auto& frames = frames_or_error.value();
+
+    size_t leaf_block_index = frames.last().current().block;
+    auto leaf_or_error = read_directory_block(leaf_block_index);
+    if (leaf_or_error.is_error())
+        return leaf_or_error.error();
+    auto& leaf = leaf_or_error.value();
+
+    auto inserted_or_error = try_insert_directory_record(leaf, name, inode_index, file_type);
+    if (inserted_or_error.is_error())
+        return inserted_or_error.error();
+    if (inserted_or_error.value())
+        return write_directory_block(leaf_block_index, leaf);
+
+    auto result = split_directory_leaf(frames, leaf_block_index, leaf);
+    if (result.is_error())
+        return result;
+    // The leaf that is responsible for our hash now has room to spare.
+    return add_indexed_directory_entry(name, inode_index, file_type);
+}
+
+// Makes sure that the index node pointing at a leaf that is about to be split has room for one more entry.
+KResult Ext2FSInode::make_room_in_directory_index(Vector<DirectoryIndexFrame>& frames)
+{
+    auto& parent = frames.last();
+    if (parent.countlimit().count < parent.countlimit().limit)
+        return KSuccess;
+
+    size_t block_size = fs().block_size();
+    auto& root = frames.first();
+
+    if (frames.size() == 1) {
+        // The root is full, so move all of its entries down into a new node. Nodes can hold more
+        // entries than the root, so that node has room as well.
+        DirectoryIndexFrame node { directory_block_count(), ByteBuffer::create_zeroed(block_size), dx_node_entries_offset, root.position };
+        write_directory_record(node.block, 0, block_size, 0, EXT2_FT_UNKNOWN, {});
+        u16 count = root.countlimit().count;
+        memcpy(node.entries(), root.entries(), count * sizeof(ext2_dx_entry));
+        node.countlimit() = { static_cast<u16>((block_size - dx_node_entries_offset) / sizeof(ext2_dx_entry)), count };
+        auto result = write_directory_block(node.block_index, node.block);
+        if (result.is_error())
+            return result;
+
+        root.countlimit().count = 1;
+        root.entries()[0].block = node.block_index;
+        root.position = 0;
+        dx_root_info(root.block).indirect_levels = 1;
+        result = write_directory_block(0, root.block);
+        if (result.is_error())
+            return result;
+        frames.append(move(node));
+        return KSuccess;
+    }
+
+    VERIFY(frames.size() == 2);
+    if (root.countlimit().count >= root.countlimit().limit) {
+        dbgln("Ext2FSInode: Index of directory {} is full", index());
+        return ENOSPC;
+    }
+
+    // Move the upper half of the full node into a new node next to it.
+    auto& node = frames[1];
+    u16 count = node.countlimit().count;
+    u16 split = count / 2;
+    DirectoryIndexFrame new_node { directory_block_count(), ByteBuffer::create_zeroed(block_size), dx_node_entries_offset, 0 };
+    write_directory_record(new_node.block, 0, block_size, 0, EXT2_FT_UNKNOWN, {});
+    u32 split_hash = node.entries()[split].hash;
+    memcpy(new_node.entries(), &node.entries()[split], (count - split) * sizeof(ext2_dx_entry));
+    new_node.countlimit() = node.countlimit();
+    new_node.countlimit().count = count - split;
+    node.countlimit().count = split;
+
+    auto result = write_directory_block(new_node.block_index, new_node.block);
+    if (result.is_error())
+        return result;
+    result = write_directory_block(node.block_index, node.block);
+    if (result.is_error())
+        return result;
+    root.insert(root.position + 1, split_hash, new_node.block_index);
+    result = write_directory_block(0, root.block);
+    if (result.is_error())
+        return result;
+
+    if (node.position >= split) {
+        new_node.position = node.position - split;
+        ++root.position;
+        frames[1] = move(new_node);
+    }
+    return KSuccess;
+}
+
+// Splits a full leaf in two halves of roughly equal size, by hash.
+KResult Ext2FSInode::split_directory_leaf(Vector<DirectoryIndexFrame>& frames, size_t leaf_block_index, const ByteBuffer& leaf)
+{
+    auto result = make_room_in_directory_index(frames);
+    if (result.is_error())
+        return result;
+
+    struct Record {
+        u32 hash { 0 };
+        size_t offset { 0 };
+    };
+    Vector<Record> records;
+    size_t total_size = 0;
+    u8 hash_version = dx_root_info(frames.first().block).hash_version;
+    bool valid = for_each_record_in_directory_block(leaf, [&](size_t offset, auto& record) {
+        if (record.inode != 0) {
+            records.append({ directory_hash({ record.name, record.name_len }, hash_version), offset });
+            total_size += EXT2_DIR_REC_LEN(record.name_len);
+        }
+        return IterationDecision::Continue;
+    });
+    if (!valid || records.size() < 2) {
+        dbgln("Ext2FSInode: Corrupt block {} in directory {}", leaf_block_index, index());
+        return EIO;
+    }
+    quick_sort(records, [](auto& a, auto& b) { return a.hash < b.hash; });
+
+    size_t split = 0;
+    for (size_t low_size = 0; split < records.size() - 1 && low_size < total_size / 2; ++split) {
+        auto& record = *reinterpret_cast<const ext2_dir_entry_2*>(leaf.data() + records[split].offset);
+        low_size += EXT2_DIR_REC_LEN(record.name_len);
+    }
+    split = max(split, (size_t)1);
+
+    size_t block_size = fs().block_size();
+    auto pack_records = [&](size_t first, size_t last) {
+        auto block = ByteBuffer::create_zeroed(block_size);
+        size_t size = 0;
+        for (size_t i = first; i < last; ++i) {
+            auto& record = *reinterpret_cast<const ext2_dir_entry_2*>(leaf.data() + records[i].offset);
+            size_t record_length = EXT2_DIR_REC_LEN(record.name_len);
+            if (i == last - 1)
+                record_length = block_size - size;
+            write_directory_record(block, size, record_length, record.inode, record.file_type, { record.name, record.name_len });
+            size += record_length;
+        }
+        return block;
+    };
+
+    u32 split_hash = records[split].hash;
+    if (records[split - 1].hash == split_hash)
+        split_hash |= dx_hash_continued;
+
+    size_t new_leaf_block_index = directory_block_count();
+    dbgln_if(EXT2_DEBUG, "Ext2FSInode: Splitting block {} of directory {} into block {} at hash {:#x}", leaf_block_index, index(), new_leaf_block_index, split_hash);
+    result = write_directory_block(new_leaf_block_index, pack_records(split, records.size()));
+    if (result.is_error())
+        return result;
+    result = write_directory_block(leaf_block_index, pack_records(0, split));
+    if (result.is_error())
+        return result;
+
+    auto& parent = frames.last();
+    parent.insert(parent.position + 1, split_hash, new_leaf_block_index);
+    return write_directory_block(parent.block_index, parent.block);
+}
+
+KResultOr<InodeIndex> Ext2FSInode::remove_directory_entry(const StringView& name)
+{
+    auto location_or_error = find_directory_entry(name);
+    if (location_or_error.is_error())
+        return location_or_error.error();
+    auto& location = location_or_error.value();
+
+    auto& record = *reinterpret_cast<ext2_dir_entry_2*>(location.block.data() + location.offset);
+    if (location.previous_offset.has_value()) {
+        auto& previous_record = *reinterpret_cast<ext2_dir_entry_2*>(location.block.data() + location.previous_offset.value());
+        previous_record.rec_len += record.rec_len;
+    } else {
+        record.inode = 0;
+    }
+
+    auto result = write_directory_block(location.block_index, location.block);
+    if (result.is_error())
+        return result;
+    return location.inode_index;
+}
+
 KResultOr<NonnullRefPtr<Inode>> Ext2FSInode::create_child(const String& name, mode_t mode, dev_t dev, uid_t uid, gid_t gid)
 {
     if (::is_directory(mode))
@@ -1053,36 +1896,26 @@ KResult Ext2FSInode::add_child(Inode& child, const StringView& name, mode_t mode
 
     dbgln_if(EXT2_DEBUG, "Ext2FSInode::add_child: Adding inode {} with name '{}' and mode {:o} to directory {}", child.index(), name, mode, index());
 
-    Vector<Ext2FSDirectoryEntry> entries;
-    bool name_already_exists = false;
-    KResult result = traverse_as_directory([&](auto& entry) {
-        if (name == entry.name) {
-            name_already_exists = true;
-            return false;
-        }
-        entries.append({ entry.name, entry.inode.index(), entry.file_type });
-        return true;
-    });
-
-    if (result.is_error())
-        return result;
-
-    if (name_already_exists) {
+    auto existing_entry_or_error = find_directory_entry(name);
+    if (!existing_entry_or_error.is_error()) {
         dbgln("Ext2FSInode::add_child: Name '{}' already exists in inode {}", name, index());
         return EEXIST;
     }
+    if (existing_entry_or_error.error().error() != -ENOENT)
+        return existing_entry_or_error.error();
 
-    result = child.increment_link_count();
+    auto result = child.increment_link_count();
     if (result.is_error())
         return result;
 
-    entries.empend(name, child.index(), to_ext2_file_type(mode));
-    result = write_directory(entries);
+    result = add_directory_entry(name, child.index(), to_ext2_file_type(mode));
     if (result.is_error())
         return result;
 
-    m_lookup_cache.set(name, child.index());
-    did_add_child(child.identifier());
+    // Only keep the lookup cache up to date if it has been populated, a single entry would look like a complete cache.
+    if (!m_lookup_cache.is_empty())
+        m_lookup_cache.set(name, child.index());
+    did_add_child(child.identifier(), name);
     return KSuccess;
 }
 
@@ -1092,36 +1925,20 @@ KResult Ext2FSInode::remove_child(const StringView& name)
     dbgln_if(EXT2_DEBUG, "Ext2FSInode::remove_child('{}') in inode {}", name, index());
     VERIFY(is_directory());
 
-    auto it = m_lookup_cache.find(name);
-    if (it == m_lookup_cache.end())
-        return ENOENT;
-    auto child_inode_index = (*it).value;
-
-    InodeIdentifier child_id { fsid(), child_inode_index };
-
-    dbgln_if(EXT2_DEBUG, "Ext2FSInode::remove_child(): Removing '{}' in directory {}", name, index());
-
-    Vector<Ext2FSDirectoryEntry> entries;
-    KResult result = traverse_as_directory([&](auto& entry) {
-        if (name != entry.name)
-            entries.append({ entry.name, entry.inode.index(), entry.file_type });
-        return true;
-    });
-    if (result.is_error())
-        return result;
+    auto child_inode_index_or_error = remove_directory_entry(name);
+    if (child_inode_index_or_error.is_error())
+        return child_inode_index_or_error.error();
 
-    result = write_directory(entries);
-    if (result.is_error())
-        return result;
+    InodeIdentifier child_id { fsid(), child_inode_index_or_error.value() };
 
     m_lookup_cache.remove(name);
 
     auto child_inode = fs().get_inode(child_id);
-    result = child_inode->decrement_link_count();
+    auto result = child_inode->decrement_link_count();
     if (result.is_error())
         return result;
 
-    did_remove_child(child_id);
+    did_remove_child(child_id, name);
     return KSuccess;
 }
 
@@ -1154,10 +1971,40 @@ bool Ext2FS::write_ext2_inode(InodeIndex inode, const ext2_inode& e2inode)
     return write_block(block_index, buffer, inode_size(), offset) >= 0;
 }
 
-auto Ext2FS::allocate_blocks(GroupIndex preferred_group_index, size_t count) -> KResultOr<Vector<BlockIndex>>
+KResult Ext2FS::allocate_block_run(GroupIndex group_index, CachedBitmap& cached_bitmap, size_t first_bit_index, size_t count, Vector<BlockIndex>& blocks)
+{
+    auto block_bitmap = cached_bitmap.bitmap(blocks_per_group());
+    BlockIndex first_block_in_group = (group_index.value() - 1) * blocks_per_group() + first_block_index().value();
+    auto& bgd = const_cast<ext2_group_desc&>(group_descriptor(group_index));
+    VERIFY(bgd.bg_free_blocks_count >= count);
+
+    for (size_t i = 0; i < count; ++i) {
+        if (block_bitmap.get(first_bit_index + i)) {
+            dbgln("Ext2FS: Bit {} in bitmap block {} had unexpected state true", first_bit_index + i, cached_bitmap.bitmap_block_index);
+            return EIO;
+        }
+    }
+
+    // Update the bitmap and the counters for the whole run at once. They'll all be
+    // written out together on the next flush.
+    for (size_t i = 0; i < count; ++i) {
+        block_bitmap.set(first_bit_index + i, true);
+        BlockIndex block_index = first_block_in_group.value() + first_bit_index + i;
+        blocks.unchecked_append(block_index);
+        dbgln_if(EXT2_DEBUG, "  allocated > {}", block_index);
+    }
+    cached_bitmap.dirty = true;
+    m_super_block.s_free_blocks_count -= count;
+    bgd.bg_free_blocks_count -= count;
+    m_super_block_dirty = true;
+    m_block_group_descriptors_dirty = true;
+    return KSuccess;
+}
+
+auto Ext2FS::allocate_blocks(GroupIndex preferred_group_index, size_t count, BlockIndex goal) -> KResultOr<Vector<BlockIndex>>
 {
     LOCKER(m_lock);
-    dbgln_if(EXT2_DEBUG, "Ext2FS: allocate_blocks(preferred group: {}, count {})", preferred_group_index, count);
+    dbgln_if(EXT2_DEBUG, "Ext2FS: allocate_blocks(preferred group: {}, count {}, goal {})", preferred_group_index, count, goal);
     if (count == 0)
         return Vector<BlockIndex> {};
 
@@ -1165,6 +2012,32 @@ auto Ext2FS::allocate_blocks(GroupIndex preferred_group_index, size_t count) ->
     dbgln_if(EXT2_DEBUG, "Ext2FS: allocate_blocks:");
     blocks.ensure_capacity(count);
 
+    int blocks_in_group = min(blocks_per_group(), super_block().s_blocks_count);
+
+    // First, try to continue right where the caller's last block left off, so that appending
+    // to a file keeps it contiguous on disk.
+    if (goal.value() >= first_block_index().value() && goal.value() < super_block().s_blocks_count) {
+        GroupIndex goal_group_index = (goal.value() - first_block_index().value()) / blocks_per_group() + 1;
+        size_t goal_bit_index = (goal.value() - first_block_index().value()) % blocks_per_group();
+        if (goal_group_index <= m_block_group_count && group_descriptor(goal_group_index).bg_free_blocks_count) {
+            auto cached_bitmap_or_error = get_bitmap_block(group_descriptor(goal_group_index).bg_block_bitmap);
+            if (cached_bitmap_or_error.is_error())
+                return cached_bitmap_or_error.error();
+            auto& cached_bitmap = *cached_bitmap_or_error.value();
+            auto block_bitmap = cached_bitmap.bitmap(blocks_per_group());
+
+            size_t run_length = 0;
+            while (run_length < count && goal_bit_index + run_length < (size_t)blocks_in_group && !block_bitmap.get(goal_bit_index + run_length))
+                ++run_length;
+            if (run_length) {
+                dbgln_if(EXT2_DEBUG, "Ext2FS: allocating {} blocks at goal {} [{}]", run_length, goal, goal_group_index);
+                auto result = allocate_block_run(goal_group_index, cached_bitmap, goal_bit_index, run_length, blocks);
+                if (result.is_error())
+                    return result;
+            }
+        }
+    }
+
     auto group_index = preferred_group_index;
 
     if (!group_descriptor(preferred_group_index).bg_free_blocks_count) {
@@ -1195,23 +2068,20 @@ auto Ext2FS::allocate_blocks(GroupIndex preferred_group_index, size_t count) ->
             return cached_bitmap_or_error.error();
         auto& cached_bitmap = *cached_bitmap_or_error.value();
 
-        int blocks_in_group = min(blocks_per_group(), super_block().s_blocks_count);
         auto block_bitmap = Bitmap::wrap(cached_bitmap.buffer.data(), blocks_in_group);
 
-        BlockIndex first_block_in_group = (group_index.value() - 1) * blocks_per_group() + first_block_index().value();
+        // Look for a free region with some room to spare behind what we need right now,
+        // so that the next allocations for the same file can be placed right after it.
+        size_t remaining_count = count - blocks.size();
         size_t free_region_size = 0;
-        auto first_unset_bit_index = block_bitmap.find_longest_range_of_unset_bits(count - blocks.size(), free_region_size);
+        auto first_unset_bit_index = block_bitmap.find_longest_range_of_unset_bits(remaining_count + allocation_reservation_window, free_region_size);
         VERIFY(first_unset_bit_index.has_value());
+        free_region_size = min(free_region_size, remaining_count);
         dbgln_if(EXT2_DEBUG, "Ext2FS: allocating free region of size: {} [{}]", free_region_size, group_index);
-        for (size_t i = 0; i < free_region_size; ++i) {
-            BlockIndex block_index = (first_unset_bit_index.value() + i) + first_block_in_group.value();
-            auto result = set_block_allocation_state(block_index, true);
-            if (result.is_error()) {
-                dbgln("Ext2FS: Failed to allocate block {} in allocate_blocks()", block_index);
-                return result;
-            }
-            blocks.unchecked_append(block_index);
-            dbgln_if(EXT2_DEBUG, "  allocated > {}", block_index);
+        auto result = allocate_block_run(group_index, cached_bitmap, first_unset_bit_index.value(), free_region_size, blocks);
+        if (result.is_error()) {
+            dbgln("Ext2FS: Failed to allocate blocks in allocate_blocks()");
+            return result;
         }
     }
 
@@ -1490,6 +2360,15 @@ bool Ext2FSInode::populate_lookup_cache() const
 RefPtr<Inode> Ext2FSInode::lookup(StringView name)
 {
     VERIFY(is_directory());
+    {
+        LOCKER(m_lock);
+        if (is_indexed_directory()) {
+            auto location_or_error = find_directory_entry(name);
+            if (location_or_error.is_error())
+                return {};
+            return fs().get_inode({ fsid(), location_or_error.value().inode_index });
+        }
+    }
     if (!populate_lookup_cache())
         return {};
     LOCKER(m_lock);
@@ -1569,6 +2448,17 @@ KResultOr<size_t> Ext2FSInode::directory_entry_count() const
 {
     VERIFY(is_directory());
     LOCKER(m_lock);
+    if (is_indexed_directory()) {
+        // Indexed directories can be huge, so count their entries without caching all of them.
+        size_t count = 0;
+        auto result = traverse_as_directory([&count](auto&) {
+            ++count;
+            return true;
+        });
+        if (result.is_error())
+            return result;
+        return count;
+    }
     populate_lookup_cache();
     return m_lookup_cache.size();
 }
@@ -27,6 +27,7 @@
 #pragma once
 
 #include <AK/Bitmap.h>
+#include <AK/ByteBuffer.h>
 #include <AK/HashMap.h>
 #include <Kernel/FileSystem/BlockBasedFileSystem.h>
 #include <Kernel/FileSystem/Inode.h>
@@ -80,9 +81,41 @@ private:
 
     KResult write_directory(const Vector<Ext2FSDirectoryEntry>&);
     bool populate_lookup_cache() const;
+
+    // Directories are modified one block at a time. Directories with EXT2_INDEX_FL set are
+    // indexed by a tree of name hashes (an "htree"), which makes lookups and insertions cheap.
+    struct DirectoryEntryLocation {
+        size_t block_index { 0 };
+        ByteBuffer block;
+        size_t offset { 0 };
+        Optional<size_t> previous_offset;
+        InodeIndex inode_index { 0 };
+    };
+    struct DirectoryIndexFrame;
+
+    bool is_indexed_directory() const;
+    size_t directory_block_count() const;
+    KResultOr<ByteBuffer> read_directory_block(size_t block_index) const;
+    KResult write_directory_block(size_t block_index, const ByteBuffer&);
+    KResultOr<DirectoryEntryLocation> find_directory_entry(const StringView& name) const;
+    KResultOr<DirectoryEntryLocation> find_entry_in_directory_block(size_t block_index, const StringView& name) const;
+    KResultOr<DirectoryEntryLocation> find_indexed_directory_entry(const StringView& name) const;
+    KResult add_directory_entry(const StringView& name, InodeIndex, u8 file_type);
+    KResult add_linear_directory_entry(const StringView& name, InodeIndex, u8 file_type);
+    KResult add_indexed_directory_entry(const StringView& name, InodeIndex, u8 file_type);
+    KResultOr<InodeIndex> remove_directory_entry(const StringView& name);
+    KResult make_indexed_directory();
+    void drop_directory_index();
+    u32 directory_hash(const StringView& name, u8 hash_version) const;
+    KResultOr<Vector<DirectoryIndexFrame>> probe_directory_index(const StringView& name, u32& hash) const;
+    KResultOr<bool> advance_to_next_directory_leaf(Vector<DirectoryIndexFrame>&, u32 hash) const;
+    KResult make_room_in_directory_index(Vector<DirectoryIndexFrame>&);
+    KResult split_directory_leaf(Vector<DirectoryIndexFrame>&, size_t leaf_block_index, const ByteBuffer& leaf);
+
     KResult resize(u64);
     KResult flush_block_list();
     Vector<BlockBasedFS::BlockIndex> compute_block_list() const;
+    void read_ahead(size_t first_block_logical_index, size_t last_block_logical_index, bool in_background) const;
     Vector<BlockBasedFS::BlockIndex> compute_block_list_with_meta_blocks() const;
     Vector<BlockBasedFS::BlockIndex> compute_block_list_impl(bool include_block_list_blocks) const;
     Vector<BlockBasedFS::BlockIndex> compute_block_list_impl_internal(const ext2_inode& e2inode, bool include_block_list_blocks) const;
@@ -94,6 +127,8 @@ private:
     mutable Vector<BlockBasedFS::BlockIndex> m_block_list;
     mutable HashMap<String, InodeIndex> m_lookup_cache;
     ext2_inode m_raw_inode;
+    // When Ext2FS last handed out this inode, in ticks of its inode cache clock.
+    u64 m_last_used { 0 };
 };
 
 class Ext2FS final : public BlockBasedFS {
@@ -113,6 +148,7 @@ public:
     virtual KResult prepare_to_unmount() const override;
 
     virtual bool supports_watchers() const override { return true; }
+    virtual bool supports_dentry_cache() const override { return true; }
 
     virtual u8 internal_file_type_to_directory_entry_type(const DirectoryEntryView& entry) const override;
 
@@ -130,6 +166,7 @@ private:
     unsigned inodes_per_group() const;
     unsigned blocks_per_group() const;
     unsigned inode_size() const;
+    bool has_directory_index_feature() const { return m_super_block.s_feature_compat & EXT2_FEATURE_COMPAT_DIR_INDEX; }
 
     bool write_ext2_inode(InodeIndex, const ext2_inode&);
     bool find_block_containing_inode(InodeIndex, BlockIndex& block_index, unsigned& offset) const;
@@ -145,7 +182,7 @@ private:
 
     BlockIndex first_block_index() const;
     KResultOr<InodeIndex> allocate_inode(GroupIndex preferred_group = 0);
-    KResultOr<Vector<BlockIndex>> allocate_blocks(GroupIndex preferred_group_index, size_t count);
+    KResultOr<Vector<BlockIndex>> allocate_blocks(GroupIndex preferred_group_index, size_t count, BlockIndex goal = 0);
     GroupIndex group_index_from_inode(InodeIndex) const;
     GroupIndex group_index_from_block_index(BlockIndex) const;
 
@@ -155,6 +192,10 @@ private:
 
     void uncache_inode(InodeIndex);
     void free_inode(Ext2FSInode&);
+    size_t inode_cache_limit() const;
+    // Drops the least recently used inodes that only the cache refers to, until at most `count` are cached.
+    // They're handed to the caller, so they can be destroyed after letting go of the lock.
+    void evict_unused_inodes(size_t count, Vector<RefPtr<Ext2FSInode>>& evicted_inodes) const;
 
     struct BlockListShape {
         unsigned direct_blocks { 0 };
@@ -172,6 +213,10 @@ private:
     mutable OwnPtr<KBuffer> m_cached_group_descriptor_table;
 
     mutable HashMap<InodeIndex, RefPtr<Ext2FSInode>> m_inode_cache;
+    mutable u64 m_inode_cache_clock { 0 };
+    mutable InodeIndex m_last_missed_inode { 0 };
+    static constexpr size_t max_cached_inodes = 4096;
+    static constexpr size_t inode_table_read_ahead_blocks = 8;
 
     bool m_super_block_dirty { false };
     bool m_block_group_descriptors_dirty { false };
@@ -191,6 +236,12 @@ private:
     KResultOr<CachedBitmap*> get_bitmap_block(BlockIndex);
     KResult update_bitmap_block(BlockIndex bitmap_block, size_t bit_index, bool new_state, u32& super_block_counter, u16& group_descriptor_counter);
 
+    KResult allocate_block_run(GroupIndex, CachedBitmap&, size_t first_bit_index, size_t count, Vector<BlockIndex>&);
+
+    // Number of free blocks allocate_blocks() tries to leave behind a newly allocated run,
+    // so that subsequent appends to the same file can stay contiguous.
+    static constexpr size_t allocation_reservation_window = 32;
+
     Vector<OwnPtr<CachedBitmap>> m_cached_bitmaps;
 };
 
@@ -55,6 +55,13 @@ public:
     void attach(Direction);
     void detach(Direction);
 
+    // Capacities above max_unprivileged_capacity can only be set by the superuser.
+    static constexpr size_t max_unprivileged_capacity = 1 * MiB;
+    static constexpr size_t max_capacity = 16 * MiB;
+
+    size_t capacity() const { return m_buffer.capacity(); }
+    KResult set_capacity(size_t capacity) { return m_buffer.try_set_capacity(capacity); }
+
 private:
     // ^File
     virtual KResultOr<size_t> write(FileDescription&, size_t, const UserOrKernelBuffer&, size_t) override;
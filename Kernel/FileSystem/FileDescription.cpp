@@ -43,6 +43,8 @@
 
 namespace Kernel {
 
+static constexpr size_t max_dir_entries_buffer_size = 16 * MiB;
+
 KResultOr<NonnullRefPtr<FileDescription>> FileDescription::create(Custody& custody)
 {
     auto description = adopt(*new FileDescription(InodeFile::create(custody.inode())));
@@ -125,6 +127,24 @@ KResult FileDescription::stat(::stat& buffer)
     return m_file->stat(buffer);
 }
 
+size_t FileDescription::update_read_ahead_window(off_t offset, size_t count)
+{
+    static constexpr size_t initial_read_ahead_window = 16 * KiB;
+    static constexpr size_t max_read_ahead_window = 128 * KiB;
+
+    // pread() and io_ring reads get here without going through read(), which holds the lock already.
+    LOCKER(m_lock);
+
+    // Start reading ahead once we have seen two back-to-back reads, and double
+    // the window for every further one.
+    if (offset == m_next_sequential_read_offset)
+        m_read_ahead_window = m_read_ahead_window ? min(m_read_ahead_window * 2, max_read_ahead_window) : initial_read_ahead_window;
+    else
+        m_read_ahead_window = 0;
+    m_next_sequential_read_offset = offset + count;
+    return m_read_ahead_window;
+}
+
 off_t FileDescription::seek(off_t offset, int whence)
 {
     LOCKER(m_lock);
@@ -223,7 +243,8 @@ ssize_t FileDescription::get_dir_entries(UserOrKernelBuffer& buffer, ssize_t siz
     if (size < 0)
         return -EINVAL;
 
-    size_t size_to_allocate = max(static_cast<size_t>(PAGE_SIZE), static_cast<size_t>(metadata.size));
+    // Userspace picks the buffer size, and tries again with a bigger buffer if the entries don't fit.
+    size_t size_to_allocate = min(static_cast<size_t>(size), max_dir_entries_buffer_size);
 
     auto temp_buffer = ByteBuffer::create_uninitialized(size_to_allocate);
     OutputMemoryStream stream { temp_buffer };
@@ -135,6 +135,10 @@ public:
 
     off_t offset() const { return m_current_offset; }
 
+    // Called by file systems for every cached read. Returns how many bytes past the
+    // end of this read should be read ahead, or 0 if the access doesn't look sequential.
+    size_t update_read_ahead_window(off_t offset, size_t count);
+
     KResult chown(uid_t, gid_t);
 
     FileBlockCondition& block_condition();
@@ -156,6 +160,9 @@ private:
 
     off_t m_current_offset { 0 };
 
+    off_t m_next_sequential_read_offset { -1 };
+    size_t m_read_ahead_window { 0 };
+
     OwnPtr<FileDescriptionData> m_data;
 
     u32 m_file_flags { 0 };
@@ -54,12 +54,14 @@ public:
     unsigned fsid() const { return m_fsid; }
     static FS* from_fsid(u32);
     static void sync();
+    static void write_back_all();
     static void lock_all();
 
     virtual bool initialize() = 0;
     virtual const char* class_name() const = 0;
     virtual NonnullRefPtr<Inode> root_inode() const = 0;
     virtual bool supports_watchers() const { return false; }
+    virtual bool supports_dentry_cache() const { return false; }
 
     bool is_readonly() const { return m_readonly; }
 
@@ -80,6 +82,9 @@ public:
 
     virtual void flush_writes() { }
 
+    // Like flush_writes(), but file systems that can write back in the background only need to start doing so.
+    virtual void write_back() { flush_writes(); }
+
     size_t block_size() const { return m_block_size; }
 
     virtual bool is_file_backed() const { return false; }
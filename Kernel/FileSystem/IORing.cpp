@@ -0,0 +1,406 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Atomic.h>
+#include <AK/NumericLimits.h>
+#include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/FileSystem/FileSystem.h>
+#include <Kernel/FileSystem/IORing.h>
+#include <Kernel/FileSystem/Inode.h>
+#include <Kernel/Net/Socket.h>
+#include <Kernel/Process.h>
+#include <Kernel/VM/MemoryManager.h>
+
+namespace Kernel {
+
+static constexpr size_t queue_alignment = 64;
+
+KResultOr<NonnullRefPtr<IORing>> IORing::create(unsigned entries)
+{
+    if (entries == 0 || entries > IO_RING_MAX_ENTRIES)
+        return EINVAL;
+
+    unsigned sq_entries = 1;
+    while (sq_entries < entries)
+        sq_entries <<= 1;
+    // Twice as many completion slots as submission slots, so a full SQ can be submitted
+    // again while the previous batch of completions hasn't been reaped yet.
+    unsigned cq_entries = sq_entries * 2;
+
+    size_t sqes_offset = round_up_to_power_of_two(sizeof(io_ring_header), queue_alignment);
+    size_t cqes_offset = round_up_to_power_of_two(sqes_offset + sq_entries * sizeof(io_ring_sqe), queue_alignment);
+    size_t size = page_round_up(cqes_offset + cq_entries * sizeof(io_ring_cqe));
+
+    auto vmobject = AnonymousVMObject::create_with_size(size, AllocationStrategy::AllocateNow);
+    if (!vmobject)
+        return ENOMEM;
+    auto region = MM.allocate_kernel_region_with_vmobject(*vmobject, size, "IORing", Region::Access::Read | Region::Access::Write);
+    if (!region)
+        return ENOMEM;
+    memset(region->vaddr().as_ptr(), 0, size);
+
+    return adopt(*new IORing(vmobject.release_nonnull(), region.release_nonnull(), sq_entries, cq_entries));
+}
+
+IORing::IORing(NonnullRefPtr<AnonymousVMObject> vmobject, NonnullOwnPtr<Region> region, unsigned sq_entries, unsigned cq_entries)
+    : m_vmobject(move(vmobject))
+    , m_region(move(region))
+    , m_sq_entries(sq_entries)
+    , m_cq_entries(cq_entries)
+    , m_sq_mask(sq_entries - 1)
+    , m_cq_mask(cq_entries - 1)
+    , m_sqes_offset(round_up_to_power_of_two(sizeof(io_ring_header), queue_alignment))
+    , m_cqes_offset(round_up_to_power_of_two(m_sqes_offset + sq_entries * sizeof(io_ring_sqe), queue_alignment))
+{
+    header().sq_mask = m_sq_mask;
+    header().cq_mask = m_cq_mask;
+}
+
+IORing::~IORing()
+{
+    for (auto& it : m_operations)
+        it.value->stop();
+    ScopedSpinLock lock(m_ready_lock);
+    while (m_ready_list.take_first())
+        ;
+}
+
+io_ring_params IORing::params() const
+{
+    io_ring_params params {};
+    params.sq_entries = m_sq_entries;
+    params.cq_entries = m_cq_entries;
+    params.sqes_offset = m_sqes_offset;
+    params.cqes_offset = m_cqes_offset;
+    params.ring_size = m_vmobject->size();
+    return params;
+}
+
+bool IORing::can_read(const FileDescription&, size_t) const
+{
+    ScopedSpinLock lock(m_ready_lock);
+    return !m_ready_list.is_empty();
+}
+
+KResultOr<Region*> IORing::mmap(Process& process, FileDescription&, const Range& range, size_t offset, int prot, bool shared)
+{
+    // A private mapping would never see the kernel's side of the queues.
+    if (!shared)
+        return EINVAL;
+    if (offset != 0)
+        return EINVAL;
+    if (range.size() != m_vmobject->size())
+        return EINVAL;
+
+    return process.space().allocate_region_with_vmobject(range, m_vmobject, offset, {}, prot, true);
+}
+
+unsigned IORing::unreaped_completions()
+{
+    u32 cq_head = AK::atomic_load(&header().cq_head, AK::memory_order_acquire);
+    // A cq_head that's ahead of us (or too far behind) is userspace's bug; treat the queue as full.
+    return min(m_cq_tail - cq_head, m_cq_entries);
+}
+
+void IORing::post_completion(u64 user_data, int result)
+{
+    VERIFY(m_lock.is_locked());
+    auto& cqe = cqe_at(m_cq_tail);
+    cqe.user_data = user_data;
+    cqe.result = result;
+    cqe.reserved = 0;
+    AK::atomic_store(&header().cq_tail, ++m_cq_tail, AK::memory_order_release);
+}
+
+KResultOr<unsigned> IORing::enter(Process& process, FileDescription& description, unsigned to_submit, unsigned min_complete, const Thread::BlockTimeout& timeout)
+{
+    min_complete = min(min_complete, m_cq_entries);
+
+    unsigned submitted = 0;
+    {
+        LOCKER(m_lock);
+        u32 sq_tail = AK::atomic_load(&header().sq_tail, AK::memory_order_acquire);
+        to_submit = min(to_submit, min(sq_tail - m_sq_head, m_sq_entries));
+
+        // Every submitted SQE owns a CQ slot until it has been reaped, so the CQ can never overflow.
+        // Whatever doesn't fit stays in the SQ for the next io_ring_enter().
+        while (submitted < to_submit && m_operations.size() + unreaped_completions() < m_cq_entries) {
+            io_ring_sqe sqe;
+            memcpy(&sqe, &sqe_at(m_sq_head), sizeof(sqe));
+            AK::atomic_store(&header().sq_head, ++m_sq_head, AK::memory_order_release);
+            ++submitted;
+            submit(process, sqe);
+        }
+    }
+
+    for (;;) {
+        {
+            LOCKER(m_lock);
+            run_ready_operations(process);
+            if (unreaped_completions() >= min_complete || m_operations.is_empty() || !timeout.should_block())
+                break;
+        }
+
+        auto unblock_flags = Thread::FileBlocker::BlockFlags::None;
+        auto result = Thread::current()->block<Thread::ReadBlocker>(timeout, description, unblock_flags);
+        if (result.was_interrupted()) {
+            // Consumed SQEs can't be handed back, so only report the signal if there weren't any.
+            if (submitted == 0)
+                return EINTR;
+            break;
+        }
+        if (result.timed_out()) {
+            LOCKER(m_lock);
+            run_ready_operations(process);
+            break;
+        }
+    }
+    return submitted;
+}
+
+void IORing::submit(Process& process, const io_ring_sqe& sqe)
+{
+    VERIFY(m_lock.is_locked());
+    if (sqe.opcode == IO_RING_OP_NOP) {
+        post_completion(sqe.user_data, 0);
+        return;
+    }
+    if (sqe.opcode > IO_RING_OP_FSYNC) {
+        post_completion(sqe.user_data, -EINVAL);
+        return;
+    }
+
+    auto description = process.file_description(sqe.fd);
+    if (!description) {
+        post_completion(sqe.user_data, -EBADF);
+        return;
+    }
+    // Waiting on a ring or an epoll would take block condition locks in both orders.
+    if (description->file().is_io_ring() || description->file().is_event_poll()) {
+        post_completion(sqe.user_data, -EINVAL);
+        return;
+    }
+
+    auto result = execute(process, *description, sqe);
+    if (!result.is_error() || result.error() != -EAGAIN) {
+        post_completion(sqe.user_data, result.is_error() ? result.error().error() : (int)result.value());
+        return;
+    }
+
+    u32 id = m_next_operation_id++;
+    auto operation = make<Operation>(*this, id, sqe, *description);
+    auto& operation_ref = *operation;
+    m_operations.set(id, move(operation));
+    // If the File became ready since execute(), registering puts us straight onto the ready list.
+    operation_ref.start();
+}
+
+void IORing::run_ready_operations(Process& process)
+{
+    VERIFY(m_lock.is_locked());
+
+    size_t ready_count = 0;
+    {
+        ScopedSpinLock lock(m_ready_lock);
+        for (auto it = m_ready_list.begin(); it != m_ready_list.end(); ++it)
+            ++ready_count;
+    }
+
+    for (size_t i = 0; i < ready_count; ++i) {
+        Operation* operation;
+        {
+            ScopedSpinLock lock(m_ready_lock);
+            operation = m_ready_list.take_first();
+        }
+        if (!operation)
+            break;
+
+        auto result = execute(process, *operation->m_description, operation->m_sqe);
+        // Someone else got to the data first; the block condition will tell us when to retry.
+        if (result.is_error() && result.error() == -EAGAIN)
+            continue;
+
+        post_completion(operation->m_sqe.user_data, result.is_error() ? result.error().error() : (int)result.value());
+        remove_operation(*operation);
+    }
+}
+
+void IORing::did_become_ready(Operation& operation)
+{
+    {
+        ScopedSpinLock lock(m_ready_lock);
+        if (operation.m_ready_list_node.is_in_list())
+            return;
+        m_ready_list.append(operation);
+    }
+    evaluate_block_conditions();
+}
+
+void IORing::remove_operation(Operation& operation)
+{
+    VERIFY(m_lock.is_locked());
+    operation.stop();
+    {
+        ScopedSpinLock lock(m_ready_lock);
+        if (operation.m_ready_list_node.is_in_list())
+            m_ready_list.remove(operation);
+    }
+    m_operations.remove(operation.m_id);
+}
+
+KResultOr<size_t> IORing::execute(Process& process, FileDescription& description, const io_ring_sqe& sqe)
+{
+    if (sqe.len > NumericLimits<i32>::max())
+        return EINVAL;
+
+    switch (sqe.opcode) {
+    case IO_RING_OP_READ:
+    case IO_RING_OP_WRITE: {
+        bool is_read = sqe.opcode == IO_RING_OP_READ;
+        if (is_read ? !description.is_readable() : !description.is_writable())
+            return EBADF;
+        if (description.is_directory())
+            return EISDIR;
+        auto buffer = UserOrKernelBuffer::for_user_buffer((u8*)(FlatPtr)sqe.addr, sqe.len);
+        if (!buffer.has_value())
+            return EFAULT;
+
+        if (sqe.offset != IO_RING_CURRENT_OFFSET) {
+            // Positioned I/O goes straight to the inode, like pread()/pwrite().
+            if (!description.inode())
+                return ESPIPE;
+            if (sqe.offset > (u64)NumericLimits<off_t>::max())
+                return EINVAL;
+            if (is_read)
+                return description.file().read(description, sqe.offset, buffer.value(), sqe.len);
+            return description.file().write(description, sqe.offset, buffer.value(), sqe.len);
+        }
+
+        // Submissions never block, but the fd is shared with the rest of the process, so its blocking
+        // mode has to stay as it is. Only sockets wait inside read(), and they can be told not to.
+        if (is_read ? !description.can_read() : !description.can_write())
+            return EAGAIN;
+        if (is_read && description.is_socket()) {
+            timeval timestamp = { 0, 0 };
+            return description.socket()->recvfrom(description, buffer.value(), sqe.len, MSG_DONTWAIT, {}, {}, timestamp);
+        }
+        if (is_read)
+            return description.read(buffer.value(), sqe.len);
+        return description.write(buffer.value(), sqe.len);
+    }
+    case IO_RING_OP_RECV:
+    case IO_RING_OP_SEND: {
+        if (!description.is_socket())
+            return ENOTSOCK;
+        auto& socket = *description.socket();
+        auto buffer = UserOrKernelBuffer::for_user_buffer((u8*)(FlatPtr)sqe.addr, sqe.len);
+        if (!buffer.has_value())
+            return EFAULT;
+        if (sqe.opcode == IO_RING_OP_RECV) {
+            timeval timestamp = { 0, 0 };
+            return socket.recvfrom(description, buffer.value(), sqe.len, sqe.msg_flags | MSG_DONTWAIT, {}, {}, timestamp);
+        }
+        // Same as for IO_RING_OP_WRITE, the send paths would otherwise wait for room in the send buffer.
+        if (!description.can_write())
+            return EAGAIN;
+        return socket.sendto(description, buffer.value(), sqe.len, sqe.msg_flags | MSG_DONTWAIT, {}, 0);
+    }
+    case IO_RING_OP_ACCEPT: {
+        REQUIRE_PROMISE(accept);
+        if (!description.is_socket())
+            return ENOTSOCK;
+        // do_accept() works on fds, so make sure the fd still refers to what was submitted.
+        if (process.file_description(sqe.fd).ptr() != &description)
+            return EBADF;
+        if (!description.socket()->can_accept())
+            return EAGAIN;
+        int accepted_fd = process.do_accept(sqe.fd, Userspace<sockaddr*>((FlatPtr)sqe.addr), Userspace<socklen_t*>((FlatPtr)sqe.offset), false);
+        if (accepted_fd < 0)
+            return KResult((ErrnoCode)-accepted_fd);
+        return (size_t)accepted_fd;
+    }
+    case IO_RING_OP_FSYNC: {
+        auto* inode = description.inode();
+        if (!inode)
+            return EINVAL;
+        if (inode->is_metadata_dirty())
+            inode->flush_metadata();
+        inode->fs().flush_writes();
+        return 0;
+    }
+    default:
+        return EINVAL;
+    }
+}
+
+IORing::Operation::Operation(IORing& ring, u32 id, const io_ring_sqe& sqe, FileDescription& description)
+    : m_ring(ring)
+    , m_id(id)
+    , m_sqe(sqe)
+    , m_description(description)
+{
+}
+
+IORing::Operation::~Operation()
+{
+}
+
+void IORing::Operation::start()
+{
+    // Our unblock() never asks to be removed, so this always registers us.
+    [[maybe_unused]] bool added = m_description->block_condition().add_blocker(*this, this);
+    VERIFY(added);
+}
+
+void IORing::Operation::stop()
+{
+    m_description->block_condition().remove_blocker(*this, this);
+}
+
+bool IORing::Operation::unblock(bool, void*)
+{
+    if (m_description->should_unblock(block_flags()) != BlockFlags::None)
+        m_ring.did_become_ready(*this);
+    return false;
+}
+
+Thread::FileBlocker::BlockFlags IORing::Operation::block_flags() const
+{
+    switch (m_sqe.opcode) {
+    case IO_RING_OP_READ:
+    case IO_RING_OP_RECV:
+        return BlockFlags::Read;
+    case IO_RING_OP_WRITE:
+    case IO_RING_OP_SEND:
+        return BlockFlags::Write;
+    case IO_RING_OP_ACCEPT:
+        return BlockFlags::Accept;
+    default:
+        return BlockFlags::None;
+    }
+}
+
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/HashMap.h>
+#include <AK/IntrusiveList.h>
+#include <AK/NonnullOwnPtr.h>
+#include <Kernel/FileSystem/File.h>
+#include <Kernel/Lock.h>
+#include <Kernel/SpinLock.h>
+#include <Kernel/Thread.h>
+#include <Kernel/UnixTypes.h>
+#include <Kernel/VM/AnonymousVMObject.h>
+#include <Kernel/VM/Region.h>
+
+namespace Kernel {
+
+// IORing is the File behind an io_ring file descriptor. Userspace maps its queues with mmap(),
+// queues submission entries (SQEs) and picks up completion entries (CQEs) without a syscall per
+// operation; io_ring_enter() hands new SQEs to the kernel and optionally waits for completions.
+//
+// The shared memory starts with an io_ring_header, followed by the SQ and the CQ arrays at the
+// offsets reported in io_ring_params. Userspace produces sq_tail and consumes cq_head, the kernel
+// produces cq_tail and consumes sq_head.
+class IORing final : public File {
+public:
+    static KResultOr<NonnullRefPtr<IORing>> create(unsigned entries);
+    virtual ~IORing() override;
+
+    io_ring_params params() const;
+
+    // Consumes up to to_submit SQEs, then runs operations until at least min_complete CQEs are
+    // waiting to be reaped (or the timeout expires). Returns the number of SQEs consumed.
+    KResultOr<unsigned> enter(Process&, FileDescription&, unsigned to_submit, unsigned min_complete, const Thread::BlockTimeout&);
+
+    virtual bool can_read(const FileDescription&, size_t) const override;
+    virtual bool can_write(const FileDescription&, size_t) const override { return false; }
+    virtual KResultOr<size_t> read(FileDescription&, size_t, UserOrKernelBuffer&, size_t) override { return EINVAL; }
+    virtual KResultOr<size_t> write(FileDescription&, size_t, const UserOrKernelBuffer&, size_t) override { return EINVAL; }
+    virtual KResultOr<Region*> mmap(Process&, FileDescription&, const Range&, size_t offset, int prot, bool shared) override;
+    virtual String absolute_path(const FileDescription&) const override { return "io_ring"; }
+    virtual const char* class_name() const override { return "IORing"; }
+    virtual bool is_io_ring() const override { return true; }
+
+private:
+    // An Operation is an SQE that couldn't complete right away. Like an EventPoll watch, it sits on
+    // its File's block condition and only moves itself onto the ready list; the operation itself is
+    // retried by whoever enters the ring next.
+    class Operation final : public Thread::FileBlocker {
+    public:
+        Operation(IORing&, u32 id, const io_ring_sqe&, FileDescription&);
+        virtual ~Operation() override;
+
+        virtual bool unblock(bool from_add_blocker, void*) override;
+        virtual void not_blocking(bool) override { VERIFY_NOT_REACHED(); }
+        virtual const char* state_string() const override { return "IORing"; }
+
+        void start();
+        void stop();
+
+        BlockFlags block_flags() const;
+
+        IORing& m_ring;
+        const u32 m_id;
+        const io_ring_sqe m_sqe;
+        NonnullRefPtr<FileDescription> m_description;
+        IntrusiveListNode m_ready_list_node;
+    };
+
+    IORing(NonnullRefPtr<AnonymousVMObject>, NonnullOwnPtr<Region>, unsigned sq_entries, unsigned cq_entries);
+
+    io_ring_header& header() { return *reinterpret_cast<io_ring_header*>(m_region->vaddr().as_ptr()); }
+    io_ring_sqe& sqe_at(u32 index) { return reinterpret_cast<io_ring_sqe*>(m_region->vaddr().offset(m_sqes_offset).as_ptr())[index & m_sq_mask]; }
+    io_ring_cqe& cqe_at(u32 index) { return reinterpret_cast<io_ring_cqe*>(m_region->vaddr().offset(m_cqes_offset).as_ptr())[index & m_cq_mask]; }
+
+    unsigned unreaped_completions();
+    void post_completion(u64 user_data, int result);
+
+    void submit(Process&, const io_ring_sqe&);
+    void run_ready_operations(Process&);
+    void did_become_ready(Operation&);
+    void remove_operation(Operation&);
+
+    // Returns EAGAIN if the operation has to wait for its File.
+    KResultOr<size_t> execute(Process&, FileDescription&, const io_ring_sqe&);
+
+    NonnullRefPtr<AnonymousVMObject> m_vmobject;
+    NonnullOwnPtr<Region> m_region;
+    const unsigned m_sq_entries;
+    const unsigned m_cq_entries;
+    const u32 m_sq_mask;
+    const u32 m_cq_mask;
+    const u32 m_sqes_offset;
+    const u32 m_cqes_offset;
+
+    // Private copies of the indices the kernel produces or consumes, so userspace scribbling
+    // over the shared header can't make us read or write outside the queues.
+    u32 m_sq_head { 0 };
+    u32 m_cq_tail { 0 };
+
+    Lock m_lock { "IORing" };
+    u32 m_next_operation_id { 0 };
+    HashMap<u32, NonnullOwnPtr<Operation>> m_operations;
+
+    mutable SpinLock<u8> m_ready_lock;
+    IntrusiveList<Operation, &Operation::m_ready_list_node> m_ready_list;
+};
+
+}
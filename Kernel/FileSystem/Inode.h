@@ -87,6 +87,10 @@ public:
 
     virtual KResultOr<int> get_block_address(int) { return -ENOTSUP; }
 
+    // Inodes that keep their contents in physical pages (e.g. TmpFS) can hand those pages
+    // straight to shared mappings of themselves, instead of having them copied.
+    virtual RefPtr<PhysicalPage> shared_physical_page(size_t page_index);
+
     LocalSocket* socket() { return m_socket.ptr(); }
     const LocalSocket* socket() const { return m_socket.ptr(); }
     bool bind_socket(LocalSocket&);
@@ -133,8 +137,8 @@ protected:
     void inode_size_changed(size_t old_size, size_t new_size);
     KResult prepare_to_write_data();
 
-    void did_add_child(const InodeIdentifier&);
-    void did_remove_child(const InodeIdentifier&);
+    void did_add_child(const InodeIdentifier& child_id, const StringView& name);
+    void did_remove_child(const InodeIdentifier& child_id, const StringView& name);
 
     mutable Lock m_lock { "Inode" };
 
@@ -51,7 +51,13 @@ KResultOr<size_t> InodeFile::read(FileDescription& description, size_t offset, U
     if (Checked<off_t>::addition_would_overflow(offset, count))
         return EOVERFLOW;
 
-    ssize_t nread = m_inode->read_bytes(offset, count, buffer, &description);
+    ssize_t nread;
+    // If the inode is mapped somewhere, read out of the pages cached by its shared VMObject
+    // instead of keeping a second copy of the same data in the file system's block cache.
+    if (auto shared_vmobject = m_inode->shared_vmobject(); shared_vmobject && m_inode->fs().is_file_backed())
+        nread = shared_vmobject->read_bytes(offset, count, buffer, &description);
+    else
+        nread = m_inode->read_bytes(offset, count, buffer, &description);
     if (nread > 0) {
         Thread::current()->did_file_read(nread);
         evaluate_block_conditions();
@@ -29,6 +29,12 @@
 
 namespace Kernel {
 
+// How many Tread or Twrite requests a single read or write keeps in flight at once.
+static constexpr size_t max_requests_in_flight = 8;
+
+// How much data small sequential reads fetch ahead of time.
+static constexpr size_t read_ahead_size = 1 * MiB;
+
 NonnullRefPtr<Plan9FS> Plan9FS::create(FileDescription& file_description)
 {
     return adopt(*new Plan9FS(file_description));
@@ -615,12 +621,46 @@ KResult Plan9FS::post_message_and_explicitly_ignore_reply(Message& message)
 
 KResult Plan9FS::post_message_and_wait_for_a_reply(Message& message)
 {
-    auto request_type = message.type();
-    auto tag = message.tag();
-    auto completion = adopt(*new ReceiveCompletion(tag));
+    auto request_type = (u8)message.type();
+    auto completion = adopt(*new ReceiveCompletion(message.tag()));
     auto result = post_message(message, completion);
     if (result.is_error())
         return result;
+    return wait_for_reply(message, request_type, move(completion));
+}
+
+KResultOr<size_t> Plan9FS::post_messages_and_wait_for_replies(NonnullOwnPtrVector<Message>& messages)
+{
+    // Send all of the requests before waiting for any reply, so that they are all in flight at once.
+    Vector<u8> request_types;
+    Vector<NonnullRefPtr<ReceiveCompletion>> completions;
+    for (auto& message : messages) {
+        auto request_type = (u8)message.type();
+        auto completion = adopt(*new ReceiveCompletion(message.tag()));
+        auto result = post_message(message, completion);
+        if (result.is_error()) {
+            if (completions.is_empty())
+                return result;
+            break;
+        }
+        request_types.append(request_type);
+        completions.append(move(completion));
+    }
+
+    // Any replies we don't wait for are dropped when they arrive.
+    for (size_t i = 0; i < completions.size(); ++i) {
+        auto result = wait_for_reply(messages[i], request_types[i], completions[i]);
+        if (result.is_error()) {
+            if (i == 0)
+                return result;
+            return i;
+        }
+    }
+    return completions.size();
+}
+
+KResult Plan9FS::wait_for_reply(Message& message, u8 request_type, NonnullRefPtr<ReceiveCompletion> completion)
+{
     if (Thread::current()->block<Plan9FS::Blocker>({}, *this, message, completion).was_interrupted())
         return EINTR;
 
@@ -644,10 +684,10 @@ KResult Plan9FS::post_message_and_wait_for_a_reply(Message& message)
         message >> error_name;
         dbgln("Plan9FS: Received error name {}", error_name);
         return EIO;
-    } else if ((u8)reply_type != (u8)request_type + 1) {
+    } else if ((u8)reply_type != request_type + 1) {
         // Other than those error messages. we only expect the matching reply
         // message type.
-        dbgln("Plan9FS: Received unexpected message type {} in response to {}", (u8)reply_type, (u8)request_type);
+        dbgln("Plan9FS: Received unexpected message type {} in response to {}", (u8)reply_type, request_type);
         return EIO;
     } else {
         return KSuccess;
@@ -656,8 +696,12 @@ KResult Plan9FS::post_message_and_wait_for_a_reply(Message& message)
 
 ssize_t Plan9FS::adjust_buffer_size(ssize_t size) const
 {
-    ssize_t max_size = m_max_message_size - Message::max_header_size;
-    return min(size, max_size);
+    return min(size, (ssize_t)max_io_size());
+}
+
+size_t Plan9FS::max_io_size() const
+{
+    return m_max_message_size - Message::max_header_size;
 }
 
 void Plan9FS::thread_main()
@@ -748,42 +792,104 @@ KResult Plan9FSInode::ensure_open_for_mode(int mode)
     }
 }
 
+KResultOr<size_t> Plan9FSInode::read_data(off_t offset, size_t size, UserOrKernelBuffer& buffer) const
+{
+    size_t max_io_size = fs().max_io_size();
+    size_t nread = 0;
+    while (nread < size) {
+        NonnullOwnPtrVector<Plan9FS::Message> messages;
+        for (size_t batch_offset = nread; batch_offset < size && messages.size() < max_requests_in_flight; batch_offset += max_io_size) {
+            auto message = make<Plan9FS::Message>(fs(), Plan9FS::Message::Type::Tread);
+            *message << fid() << (u64)(offset + batch_offset) << (u32)min(size - batch_offset, max_io_size);
+            messages.append(move(message));
+        }
+
+        auto replied_count_or_error = fs().post_messages_and_wait_for_replies(messages);
+        if (replied_count_or_error.is_error()) {
+            if (nread == 0)
+                return replied_count_or_error.error();
+            return nread;
+        }
+
+        for (size_t i = 0; i < replied_count_or_error.value(); ++i) {
+            auto data = messages[i].read_data();
+            // Guard against the server returning more data than requested.
+            size_t chunk_size = min(data.length(), min(size - nread, max_io_size));
+            if (!buffer.write(data.characters_without_null_termination(), nread, chunk_size))
+                return EFAULT;
+            nread += chunk_size;
+            // A short read means that we have reached the end of the file.
+            if (chunk_size < max_io_size)
+                return nread;
+        }
+        if (replied_count_or_error.value() < messages.size())
+            return nread;
+    }
+    return nread;
+}
+
 ssize_t Plan9FSInode::read_bytes(off_t offset, ssize_t size, UserOrKernelBuffer& buffer, FileDescription*) const
 {
     auto result = const_cast<Plan9FSInode&>(*this).ensure_open_for_mode(O_RDONLY);
     if (result.is_error())
         return result;
 
-    size = fs().adjust_buffer_size(size);
-
-    Plan9FS::Message message { fs(), Plan9FS::Message::Type::Treadlink };
-    StringView data;
-
     // Try readlink first.
-    bool readlink_succeded = false;
     if (fs().m_remote_protocol_version >= Plan9FS::ProtocolVersion::v9P2000L && offset == 0) {
+        Plan9FS::Message message { fs(), Plan9FS::Message::Type::Treadlink };
         message << fid();
         result = fs().post_message_and_wait_for_a_reply(message);
         if (result.is_success()) {
-            readlink_succeded = true;
+            StringView data;
             message >> data;
+            size_t nread = min(data.length(), (size_t)size);
+            if (!buffer.write(data.characters_without_null_termination(), nread))
+                return -EFAULT;
+            return nread;
         }
     }
 
-    if (!readlink_succeded) {
-        message = Plan9FS::Message { fs(), Plan9FS::Message::Type::Tread };
-        message << fid() << (u64)offset << (u32)size;
-        result = fs().post_message_and_wait_for_a_reply(message);
-        if (result.is_error())
-            return result.error();
-        data = message.read_data();
+    LOCKER(m_lock);
+
+    if (m_read_ahead_buffer && offset >= m_read_ahead_offset && offset < m_read_ahead_offset + (off_t)m_read_ahead_buffer->size()) {
+        size_t offset_in_buffer = offset - m_read_ahead_offset;
+        size_t nread = min((size_t)size, m_read_ahead_buffer->size() - offset_in_buffer);
+        if (!buffer.write(m_read_ahead_buffer->data() + offset_in_buffer, nread))
+            return -EFAULT;
+        if (offset_in_buffer + nread == m_read_ahead_buffer->size())
+            m_read_ahead_buffer = nullptr;
+        m_next_sequential_read_offset = offset + nread;
+        return nread;
     }
+    m_read_ahead_buffer = nullptr;
 
-    // Guard against the server returning more data than requested.
-    size_t nread = min(data.length(), (size_t)size);
-    if (!buffer.write(data.characters_without_null_termination(), nread))
-        return -EFAULT;
+    // Small sequential reads fetch a larger chunk in one go, and keep the rest around for the reads that follow.
+    bool is_sequential = offset == m_next_sequential_read_offset;
+    if (!is_sequential || (size_t)size >= read_ahead_size) {
+        auto nread_or_error = read_data(offset, size, buffer);
+        if (nread_or_error.is_error())
+            return nread_or_error.error();
+        m_next_sequential_read_offset = offset + nread_or_error.value();
+        return nread_or_error.value();
+    }
+
+    auto read_ahead_buffer = KBuffer::try_create_with_size(read_ahead_size, Region::Access::Read | Region::Access::Write, "Plan9FS read-ahead");
+    if (!read_ahead_buffer)
+        return -ENOMEM;
+    auto read_ahead_user_or_kernel_buffer = UserOrKernelBuffer::for_kernel_buffer(read_ahead_buffer->data());
+    auto nread_or_error = read_data(offset, read_ahead_size, read_ahead_user_or_kernel_buffer);
+    if (nread_or_error.is_error())
+        return nread_or_error.error();
 
+    size_t nread = min((size_t)size, nread_or_error.value());
+    if (!buffer.write(read_ahead_buffer->data(), nread))
+        return -EFAULT;
+    m_next_sequential_read_offset = offset + nread;
+    if (nread_or_error.value() > nread) {
+        read_ahead_buffer->set_size(nread_or_error.value());
+        m_read_ahead_buffer = move(read_ahead_buffer);
+        m_read_ahead_offset = offset;
+    }
     return nread;
 }
 
@@ -793,22 +899,41 @@ ssize_t Plan9FSInode::write_bytes(off_t offset, ssize_t size, const UserOrKernel
     if (result.is_error())
         return result;
 
-    size = fs().adjust_buffer_size(size);
-
-    auto data_copy = data.copy_into_string(size); // FIXME: this seems ugly
-    if (data_copy.is_null())
-        return -EFAULT;
-
-    Plan9FS::Message message { fs(), Plan9FS::Message::Type::Twrite };
-    message << fid() << (u64)offset;
-    message.append_data(data_copy);
-    result = fs().post_message_and_wait_for_a_reply(message);
-    if (result.is_error())
-        return result.error();
+    LOCKER(m_lock);
+    m_read_ahead_buffer = nullptr;
+
+    size_t max_io_size = fs().max_io_size();
+    size = min((size_t)size, max_requests_in_flight * max_io_size);
+
+    NonnullOwnPtrVector<Plan9FS::Message> messages;
+    Vector<size_t> chunk_sizes;
+    for (ssize_t data_offset = 0; data_offset < size; data_offset += max_io_size) {
+        size_t chunk_size = min((size_t)(size - data_offset), max_io_size);
+        auto data_copy = data.offset(data_offset).copy_into_string(chunk_size); // FIXME: this seems ugly
+        if (data_copy.is_null())
+            return -EFAULT;
+
+        auto message = make<Plan9FS::Message>(fs(), Plan9FS::Message::Type::Twrite);
+        *message << fid() << (u64)(offset + data_offset);
+        message->append_data(data_copy);
+        messages.append(move(message));
+        chunk_sizes.append(chunk_size);
+    }
 
-    u32 nwritten;
-    message >> nwritten;
-    return nwritten;
+    auto replied_count_or_error = fs().post_messages_and_wait_for_replies(messages);
+    if (replied_count_or_error.is_error())
+        return replied_count_or_error.error();
+
+    size_t total_nwritten = 0;
+    for (size_t i = 0; i < replied_count_or_error.value(); ++i) {
+        u32 nwritten;
+        messages[i] >> nwritten;
+        total_nwritten += min((size_t)nwritten, chunk_sizes[i]);
+        // Whatever follows a short write did not end up where it should have.
+        if (nwritten < chunk_sizes[i])
+            break;
+    }
+    return total_nwritten;
 }
 
 InodeMetadata Plan9FSInode::metadata() const
@@ -993,6 +1118,11 @@ KResult Plan9FSInode::chown(uid_t, gid_t)
 
 KResult Plan9FSInode::truncate(u64 new_size)
 {
+    {
+        LOCKER(m_lock);
+        m_read_ahead_buffer = nullptr;
+    }
+
     if (fs().m_remote_protocol_version >= Plan9FS::ProtocolVersion::v9P2000L) {
         Plan9FS::Message message { fs(), Plan9FS::Message::Type::Tsetattr };
         SetAttrMask valid = SetAttrMask::Size;
@@ -27,6 +27,7 @@
 #pragma once
 
 #include <AK/Atomic.h>
+#include <AK/NonnullOwnPtrVector.h>
 #include <Kernel/FileSystem/FileBackedFileSystem.h>
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/KBufferBuilder.h>
@@ -141,9 +142,12 @@ private:
     KResult read_and_dispatch_one_message();
     KResult post_message_and_wait_for_a_reply(Message&);
     KResult post_message_and_explicitly_ignore_reply(Message&);
+    KResultOr<size_t> post_messages_and_wait_for_replies(NonnullOwnPtrVector<Message>&);
+    KResult wait_for_reply(Message&, u8 request_type, NonnullRefPtr<ReceiveCompletion>);
 
     ProtocolVersion parse_protocol_version(const StringView&) const;
     ssize_t adjust_buffer_size(ssize_t size) const;
+    size_t max_io_size() const;
 
     void thread_main();
     void ensure_thread();
@@ -153,7 +157,8 @@ private:
     Atomic<u32> m_next_fid { 1 };
 
     ProtocolVersion m_remote_protocol_version { ProtocolVersion::v9P2000 };
-    size_t m_max_message_size { 4 * KiB };
+    // This is what we ask for, the server may settle on less.
+    size_t m_max_message_size { 512 * KiB };
 
     Lock m_send_lock { "Plan9FS send" };
     Plan9FSBlockCondition m_completion_blocker;
@@ -229,6 +234,13 @@ private:
     int m_open_mode { 0 };
     KResult ensure_open_for_mode(int mode);
 
+    KResultOr<size_t> read_data(off_t, size_t, UserOrKernelBuffer&) const;
+
+    // Data that sequential reads have fetched ahead of time, starting at m_read_ahead_offset.
+    mutable OwnPtr<KBuffer> m_read_ahead_buffer;
+    mutable off_t m_read_ahead_offset { 0 };
+    mutable off_t m_next_sequential_read_offset { 0 };
+
     Plan9FS& fs() { return reinterpret_cast<Plan9FS&>(Inode::fs()); }
     Plan9FS& fs() const
     {
@@ -29,6 +29,7 @@
 #include <AK/JsonObjectSerializer.h>
 #include <AK/JsonValue.h>
 #include <AK/ScopeGuard.h>
+#include <Kernel/API/ProcessStatistics.h>
 #include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/Arch/i386/ProcessorInfo.h>
 #include <Kernel/CommandLine.h>
@@ -38,6 +39,7 @@
 #include <Kernel/Devices/BlockDevice.h>
 #include <Kernel/Devices/KeyboardDevice.h>
 #include <Kernel/FileSystem/Custody.h>
+#include <Kernel/FileSystem/DentryCache.h>
 #include <Kernel/FileSystem/FileBackedFileSystem.h>
 #include <Kernel/FileSystem/FileDescription.h>
 #include <Kernel/FileSystem/ProcFS.h>
@@ -60,7 +62,9 @@
 #include <Kernel/StdLib.h>
 #include <Kernel/TTY/TTY.h>
 #include <Kernel/VM/AnonymousVMObject.h>
+#include <Kernel/VM/CompressedPageStore.h>
 #include <Kernel/VM/MemoryManager.h>
+#include <Kernel/VM/SharedImageCache.h>
 #include <LibC/errno_numbers.h>
 
 namespace Kernel {
@@ -84,7 +88,9 @@ enum ProcFileType {
     __FI_Root_Start,
     FI_Root_df,
     FI_Root_all,
+    FI_Root_stats,
     FI_Root_memstat,
+    FI_Root_lockstat,
     FI_Root_cpuinfo,
     FI_Root_dmesg,
     FI_Root_interrupts,
@@ -320,35 +326,37 @@ static bool procfs$pid_vm(InodeIdentifier identifier, KBufferBuilder& builder)
     {
         ScopedSpinLock lock(process->space().get_lock());
         for (auto& region : process->space().regions()) {
-            if (!region.is_user() && !Process::current()->is_superuser())
+            if (!region->is_user() && !Process::current()->is_superuser())
                 continue;
             auto region_object = array.add_object();
-            region_object.add("readable", region.is_readable());
-            region_object.add("writable", region.is_writable());
-            region_object.add("executable", region.is_executable());
-            region_object.add("stack", region.is_stack());
-            region_object.add("shared", region.is_shared());
-            region_object.add("syscall", region.is_syscall_region());
-            region_object.add("purgeable", region.vmobject().is_anonymous());
-            if (region.vmobject().is_anonymous()) {
-                region_object.add("volatile", static_cast<const AnonymousVMObject&>(region.vmobject()).is_any_volatile());
+            region_object.add("readable", region->is_readable());
+            region_object.add("writable", region->is_writable());
+            region_object.add("executable", region->is_executable());
+            region_object.add("stack", region->is_stack());
+            region_object.add("shared", region->is_shared());
+            region_object.add("syscall", region->is_syscall_region());
+            region_object.add("purgeable", region->vmobject().is_anonymous());
+            if (region->vmobject().is_anonymous()) {
+                region_object.add("volatile", static_cast<const AnonymousVMObject&>(region->vmobject()).is_any_volatile());
             }
-            region_object.add("cacheable", region.is_cacheable());
-            region_object.add("address", region.vaddr().get());
-            region_object.add("size", region.size());
-            region_object.add("amount_resident", region.amount_resident());
-            region_object.add("amount_dirty", region.amount_dirty());
-            region_object.add("cow_pages", region.cow_pages());
-            region_object.add("name", region.name());
-            region_object.add("vmobject", region.vmobject().class_name());
+            region_object.add("cacheable", region->is_cacheable());
+            region_object.add("address", region->vaddr().get());
+            region_object.add("size", region->size());
+            region_object.add("amount_resident", region->amount_resident());
+            region_object.add("amount_dirty", region->amount_dirty());
+            region_object.add("cow_pages", region->cow_pages());
+            region_object.add("name", region->name());
+            region_object.add("vmobject", region->vmobject().class_name());
 
             StringBuilder pagemap_builder;
-            for (size_t i = 0; i < region.page_count(); ++i) {
-                auto* page = region.physical_page(i);
+            for (size_t i = 0; i < region->page_count(); ++i) {
+                auto* page = region->physical_page(i);
                 if (!page)
                     pagemap_builder.append('N');
                 else if (page->is_shared_zero_page() || page->is_lazy_committed_page())
                     pagemap_builder.append('Z');
+                else if (page->is_compressed_page())
+                    pagemap_builder.append('C');
                 else
                     pagemap_builder.append('P');
             }
@@ -406,7 +414,7 @@ static bool procfs$interrupts(InodeIdentifier, KBufferBuilder& builder)
         obj.add("purpose", handler.purpose());
         obj.add("interrupt_line", handler.interrupt_number());
         obj.add("controller", handler.controller());
-        obj.add("cpu_handler", 0); // FIXME: Determine the responsible CPU for each interrupt handler.
+        obj.add("cpu_handler", handler.target_processor());
         obj.add("device_sharing", (unsigned)handler.sharing_devices_count());
         obj.add("call_count", (unsigned)handler.get_invoking_count());
     });
@@ -414,6 +422,38 @@ static bool procfs$interrupts(InodeIdentifier, KBufferBuilder& builder)
     return true;
 }
 
+// Writing "<interrupt_line> <cpu>" delivers that interrupt to the given processor from now on.
+static ssize_t write_interrupts(InodeIdentifier, const UserOrKernelBuffer& buffer, size_t size)
+{
+    if (size > 32)
+        return -EINVAL;
+    auto string_copy = buffer.copy_into_string(size);
+    if (string_copy.is_null())
+        return -EFAULT;
+
+    auto parts = string_copy.split_view(' ');
+    if (parts.size() != 2)
+        return -EINVAL;
+    auto interrupt_line = parts[0].to_uint();
+    auto cpu = parts[1].trim_whitespace().to_uint();
+    if (!interrupt_line.has_value() || !cpu.has_value())
+        return -EINVAL;
+
+    bool found = false;
+    bool routed = false;
+    InterruptManagement::the().enumerate_interrupt_handlers([&](GenericInterruptHandler& handler) {
+        if (found || handler.interrupt_number() != interrupt_line.value())
+            return;
+        found = true;
+        routed = handler.set_target_processor(cpu.value());
+    });
+    if (!found)
+        return -ENOENT;
+    if (!routed)
+        return -ENOTSUP;
+    return (ssize_t)size;
+}
+
 static bool procfs$keymap(InodeIdentifier, KBufferBuilder& builder)
 {
     JsonObjectSerializer<KBufferBuilder> json { builder };
@@ -519,12 +559,13 @@ static bool procfs$net_adapters(InodeIdentifier, KBufferBuilder& builder)
 static bool procfs$net_arp(InodeIdentifier, KBufferBuilder& builder)
 {
     JsonArraySerializer array { builder };
-    LOCKER(arp_table().lock(), Lock::Mode::Shared);
-    for (auto& it : arp_table().resource()) {
+    arp_table().for_each([&](auto& ip_address, auto& entry) {
+        if (!entry.is_resolved())
+            return;
         auto obj = array.add_object();
-        obj.add("mac_address", it.value.to_string());
-        obj.add("ip_address", it.key.to_string());
-    }
+        obj.add("mac_address", entry.mac_address.to_string());
+        obj.add("ip_address", ip_address.to_string());
+    });
     array.finish();
     return true;
 }
@@ -545,6 +586,11 @@ static bool procfs$net_tcp(InodeIdentifier, KBufferBuilder& builder)
         obj.add("bytes_in", socket.bytes_in());
         obj.add("packets_out", socket.packets_out());
         obj.add("bytes_out", socket.bytes_out());
+        obj.add("mss", socket.send_maximum_segment_size());
+        obj.add("congestion_window", socket.congestion_window());
+        obj.add("send_window", socket.send_window());
+        obj.add("srtt_ms", socket.smoothed_round_trip_time_ms());
+        obj.add("rto_ms", socket.retransmission_timeout_ms());
     });
     array.finish();
     return true;
@@ -720,6 +766,25 @@ static bool procfs$cpuinfo(InodeIdentifier, KBufferBuilder& builder)
     return true;
 }
 
+static bool procfs$lockstat(InodeIdentifier, KBufferBuilder& builder)
+{
+    JsonArraySerializer array { builder };
+    Lock::for_each_statistics([&](auto& statistics) {
+        auto obj = array.add_object();
+        obj.add("name", statistics.name);
+        obj.add("contended", statistics.contended_count.load());
+        obj.add("spin_acquired", statistics.spin_acquired_count.load());
+        obj.add("blocked", statistics.blocked_count.load());
+        obj.add("acquired", statistics.acquired_count.load());
+        auto histogram = obj.add_array("wait_time_histogram");
+        for (auto& bucket : statistics.wait_time_histogram)
+            histogram.add(bucket.load());
+        histogram.finish();
+    });
+    array.finish();
+    return true;
+}
+
 static bool procfs$memstat(InodeIdentifier, KBufferBuilder& builder)
 {
     InterruptDisabler disabler;
@@ -735,6 +800,13 @@ static bool procfs$memstat(InodeIdentifier, KBufferBuilder& builder)
 
     auto super_physical_total = MM.super_physical_pages();
     auto super_physical_used = MM.super_physical_pages_used();
+
+    size_t compressed_pages = 0;
+    size_t compressed_storage_pages = 0;
+    if (CompressedPageStore::is_initialized()) {
+        compressed_pages = CompressedPageStore::the().stored_page_count();
+        compressed_storage_pages = CompressedPageStore::the().storage_page_count();
+    }
     mm_lock.unlock();
 
     JsonObjectSerializer<KBufferBuilder> json { builder };
@@ -747,6 +819,12 @@ static bool procfs$memstat(InodeIdentifier, KBufferBuilder& builder)
     json.add("user_physical_uncommitted", user_physical_pages_uncommitted);
     json.add("super_physical_allocated", super_physical_used);
     json.add("super_physical_available", super_physical_total - super_physical_used);
+    json.add("compressed_pages", compressed_pages);
+    json.add("compressed_storage_pages", compressed_storage_pages);
+    json.add("shared_image_pages", SharedImageCache::the().page_count());
+    json.add("dentry_cache_entries", DentryCache::the().entry_count());
+    json.add("dentry_cache_hits", DentryCache::the().hit_count());
+    json.add("dentry_cache_misses", DentryCache::the().miss_count());
     json.add("kmalloc_call_count", stats.kmalloc_call_count);
     json.add("kfree_call_count", stats.kfree_call_count);
     slab_alloc_stats([&json](size_t slab_size, size_t num_allocated, size_t num_free) {
@@ -758,42 +836,47 @@ static bool procfs$memstat(InodeIdentifier, KBufferBuilder& builder)
     return true;
 }
 
-static bool procfs$all(InodeIdentifier, KBufferBuilder& builder)
+static String pledge_string(const Process& process)
 {
-    JsonArraySerializer array { builder };
-
-    // Keep this in sync with CProcessStatistics.
-    auto build_process = [&](const Process& process) {
-        auto process_object = array.add_object();
-
-        if (process.is_user_process()) {
-            StringBuilder pledge_builder;
+    if (!process.is_user_process())
+        return {};
+    StringBuilder pledge_builder;
 
 #define __ENUMERATE_PLEDGE_PROMISE(promise)      \
     if (process.has_promised(Pledge::promise)) { \
         pledge_builder.append(#promise " ");     \
     }
-            ENUMERATE_PLEDGE_PROMISES
+    ENUMERATE_PLEDGE_PROMISES
 #undef __ENUMERATE_PLEDGE_PROMISE
 
-            process_object.add("pledge", pledge_builder.to_string());
+    return pledge_builder.to_string();
+}
 
-            switch (process.veil_state()) {
-            case VeilState::None:
-                process_object.add("veil", "None");
-                break;
-            case VeilState::Dropped:
-                process_object.add("veil", "Dropped");
-                break;
-            case VeilState::Locked:
-                process_object.add("veil", "Locked");
-                break;
-            }
-        } else {
-            process_object.add("pledge", String());
-            process_object.add("veil", String());
-        }
+static StringView veil_string(const Process& process)
+{
+    if (!process.is_user_process())
+        return {};
+    switch (process.veil_state()) {
+    case VeilState::None:
+        return "None";
+    case VeilState::Dropped:
+        return "Dropped";
+    case VeilState::Locked:
+        return "Locked";
+    }
+    VERIFY_NOT_REACHED();
+}
 
+static bool procfs$all(InodeIdentifier, KBufferBuilder& builder)
+{
+    JsonArraySerializer array { builder };
+
+    // Keep this in sync with CProcessStatistics and procfs$stats.
+    auto build_process = [&](const Process& process) {
+        auto process_object = array.add_object();
+
+        process_object.add("pledge", pledge_string(process));
+        process_object.add("veil", veil_string(process));
         process_object.add("pid", process.pid().value());
         process_object.add("pgid", process.tty() ? process.tty()->pgid().value() : 0);
         process_object.add("pgp", process.pgid().value());
@@ -834,6 +917,12 @@ static bool procfs$all(InodeIdentifier, KBufferBuilder& builder)
             thread_object.add("unix_socket_write_bytes", thread.unix_socket_write_bytes());
             thread_object.add("ipv4_socket_read_bytes", thread.ipv4_socket_read_bytes());
             thread_object.add("ipv4_socket_write_bytes", thread.ipv4_socket_write_bytes());
+            thread_object.add("minor_faults", thread.minor_faults());
+            thread_object.add("major_faults", thread.major_faults());
+            thread_object.add("block_io_wait_us", thread.block_io_wait_us());
+            thread_object.add("voluntary_context_switches", thread.voluntary_context_switches());
+            thread_object.add("involuntary_context_switches", thread.involuntary_context_switches());
+            thread_object.add("scheduler_latency_us", thread.scheduler_latency_us());
             return IterationDecision::Continue;
         });
     };
@@ -847,12 +936,113 @@ static bool procfs$all(InodeIdentifier, KBufferBuilder& builder)
     return true;
 }
 
+static bool procfs$stats(InodeIdentifier, KBufferBuilder& builder)
+{
+    // See Kernel/API/ProcessStatistics.h for the format. Keep this in sync with procfs$all.
+    auto append_record = [&](const auto& record) {
+        builder.append_bytes(ReadonlyBytes { &record, sizeof(record) });
+    };
+    auto clamped_length = [](const StringView& string) -> u16 {
+        return min(string.length(), (size_t)NumericLimits<u16>::max());
+    };
+    auto append_string = [&](const StringView& string) {
+        builder.append(string.characters_without_null_termination(), clamped_length(string));
+    };
+
+    auto build_process = [&](const Process& process) {
+        auto pledge = pledge_string(process);
+        auto veil = veil_string(process);
+        auto executable = process.executable() ? process.executable()->absolute_path() : String::empty();
+        StringView tty = process.tty() ? process.tty()->tty_name() : "notty";
+
+        ProcessStatisticsRecord record {};
+        record.pid = process.pid().value();
+        record.pgid = process.tty() ? process.tty()->pgid().value() : 0;
+        record.pgp = process.pgid().value();
+        record.sid = process.sid().value();
+        record.uid = process.uid();
+        record.gid = process.gid();
+        record.ppid = process.ppid().value();
+        record.nfds = process.number_of_open_file_descriptors();
+        record.amount_virtual = process.space().amount_virtual();
+        record.amount_resident = process.space().amount_resident();
+        record.amount_dirty_private = process.space().amount_dirty_private();
+        record.amount_clean_inode = process.space().amount_clean_inode();
+        record.amount_shared = process.space().amount_shared();
+        record.amount_purgeable_volatile = process.space().amount_purgeable_volatile();
+        record.amount_purgeable_nonvolatile = process.space().amount_purgeable_nonvolatile();
+        record.dumpable = process.is_dumpable();
+        record.name_length = clamped_length(process.name());
+        record.executable_length = clamped_length(executable);
+        record.tty_length = clamped_length(tty);
+        record.pledge_length = clamped_length(pledge);
+        record.veil_length = clamped_length(veil);
+        process.for_each_thread([&](const Thread&) {
+            ++record.thread_count;
+            return IterationDecision::Continue;
+        });
+        append_record(record);
+        append_string(process.name());
+        append_string(executable);
+        append_string(tty);
+        append_string(pledge);
+        append_string(veil);
+
+        process.for_each_thread([&](const Thread& thread) {
+            auto name = thread.name();
+            StringView state = thread.state_string();
+            ThreadStatisticsRecord thread_record {};
+            thread_record.tid = thread.tid().value();
+            thread_record.times_scheduled = thread.times_scheduled();
+            thread_record.ticks_user = thread.ticks_in_user();
+            thread_record.ticks_kernel = thread.ticks_in_kernel();
+            thread_record.cpu = thread.cpu();
+            thread_record.priority = thread.priority();
+            thread_record.syscall_count = thread.syscall_count();
+            thread_record.inode_faults = thread.inode_faults();
+            thread_record.zero_faults = thread.zero_faults();
+            thread_record.cow_faults = thread.cow_faults();
+            thread_record.file_read_bytes = thread.file_read_bytes();
+            thread_record.file_write_bytes = thread.file_write_bytes();
+            thread_record.unix_socket_read_bytes = thread.unix_socket_read_bytes();
+            thread_record.unix_socket_write_bytes = thread.unix_socket_write_bytes();
+            thread_record.ipv4_socket_read_bytes = thread.ipv4_socket_read_bytes();
+            thread_record.ipv4_socket_write_bytes = thread.ipv4_socket_write_bytes();
+            thread_record.minor_faults = thread.minor_faults();
+            thread_record.major_faults = thread.major_faults();
+            thread_record.voluntary_context_switches = thread.voluntary_context_switches();
+            thread_record.involuntary_context_switches = thread.involuntary_context_switches();
+            thread_record.block_io_wait_us = thread.block_io_wait_us();
+            thread_record.scheduler_latency_us = thread.scheduler_latency_us();
+            thread_record.name_length = clamped_length(name);
+            thread_record.state_length = clamped_length(state);
+            append_record(thread_record);
+            append_string(name);
+            append_string(state);
+            return IterationDecision::Continue;
+        });
+    };
+
+    ScopedSpinLock lock(g_scheduler_lock);
+    auto processes = Process::all_processes();
+    ProcessStatisticsHeader header {};
+    header.magic = process_statistics_magic;
+    header.version = process_statistics_version;
+    header.process_count = processes.size() + 1;
+    append_record(header);
+    build_process(*Scheduler::colonel());
+    for (auto& process : processes)
+        build_process(process);
+    return true;
+}
+
 struct SysVariable {
     String name;
     enum class Type : u8 {
         Invalid,
         Boolean,
         String,
+        Integer,
     };
     Type type { Type::Invalid };
     Function<void()> notify_callback;
@@ -962,6 +1152,38 @@ static ssize_t write_sys_string(InodeIdentifier inode_id, const UserOrKernelBuff
     return (ssize_t)size;
 }
 
+static bool read_sys_integer(InodeIdentifier inode_id, KBufferBuilder& builder)
+{
+    auto& variable = SysVariable::for_inode(inode_id);
+    VERIFY(variable.type == SysVariable::Type::Integer);
+
+    auto* lockable_integer = reinterpret_cast<Lockable<u32>*>(variable.address);
+    LOCKER(lockable_integer->lock(), Lock::Mode::Shared);
+    builder.appendff("{}\n", lockable_integer->resource());
+    return true;
+}
+
+static ssize_t write_sys_integer(InodeIdentifier inode_id, const UserOrKernelBuffer& buffer, size_t size)
+{
+    auto& variable = SysVariable::for_inode(inode_id);
+    VERIFY(variable.type == SysVariable::Type::Integer);
+
+    auto string_copy = buffer.copy_into_string(size);
+    if (string_copy.is_null())
+        return -EFAULT;
+    auto value = string_copy.view().trim_whitespace().to_uint();
+    if (!value.has_value())
+        return -EINVAL;
+
+    {
+        auto* lockable_integer = reinterpret_cast<Lockable<u32>*>(variable.address);
+        LOCKER(lockable_integer->lock());
+        lockable_integer->resource() = value.value();
+    }
+    variable.notify();
+    return (ssize_t)size;
+}
+
 void ProcFS::add_sys_bool(String&& name, Lockable<bool>& var, Function<void()>&& notify_callback)
 {
     InterruptDisabler disabler;
@@ -988,6 +1210,19 @@ void ProcFS::add_sys_string(String&& name, Lockable<String>& var, Function<void(
     sys_variables().append(move(variable));
 }
 
+void ProcFS::add_sys_integer(String&& name, Lockable<u32>& var, Function<void()>&& notify_callback)
+{
+    InterruptDisabler disabler;
+
+    SysVariable variable;
+    variable.name = move(name);
+    variable.type = SysVariable::Type::Integer;
+    variable.notify_callback = move(notify_callback);
+    variable.address = &var;
+
+    sys_variables().append(move(variable));
+}
+
 bool ProcFS::initialize()
 {
     static Lockable<bool>* kmalloc_stack_helper;
@@ -999,6 +1234,24 @@ bool ProcFS::initialize()
             g_dump_kmalloc_stacks = kmalloc_stack_helper->resource();
         });
     }
+
+    static Lockable<u32>* inode_fault_around_helper;
+
+    if (inode_fault_around_helper == nullptr) {
+        inode_fault_around_helper = new Lockable<u32>(g_inode_fault_around_page_count);
+        ProcFS::add_sys_integer("inode_fault_around", *inode_fault_around_helper, [] {
+            g_inode_fault_around_page_count = clamp(inode_fault_around_helper->resource(), 1u, max_inode_fault_page_count);
+        });
+    }
+
+    static Lockable<u32>* inode_sequential_read_ahead_helper;
+
+    if (inode_sequential_read_ahead_helper == nullptr) {
+        inode_sequential_read_ahead_helper = new Lockable<u32>(g_inode_sequential_read_ahead_page_count);
+        ProcFS::add_sys_integer("inode_sequential_read_ahead", *inode_sequential_read_ahead_helper, [] {
+            g_inode_sequential_read_ahead_page_count = clamp(inode_sequential_read_ahead_helper->resource(), 1u, max_inode_fault_page_count);
+        });
+    }
     return true;
 }
 
@@ -1100,6 +1353,9 @@ KResult ProcFSInode::refresh_data(FileDescription& description) const
             case SysVariable::Type::String:
                 read_callback = read_sys_string;
                 break;
+            case SysVariable::Type::Integer:
+                read_callback = read_sys_integer;
+                break;
             }
             break;
         default:
@@ -1213,6 +1469,9 @@ InodeMetadata ProcFSInode::metadata() const
         metadata.mode = S_IFREG | S_IRUSR | S_IRGRP | S_IROTH;
         metadata.size = DMIExpose::the().structure_table_length();
         break;
+    case FI_Root_interrupts:
+        metadata.mode = S_IFREG | S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+        break;
     default:
         metadata.mode = S_IFREG | S_IRUSR | S_IRGRP | S_IROTH;
         break;
@@ -1497,6 +1756,9 @@ ssize_t ProcFSInode::write_bytes(off_t offset, ssize_t size, const UserOrKernelB
             case SysVariable::Type::String:
                 write_callback = write_sys_string;
                 break;
+            case SysVariable::Type::Integer:
+                write_callback = write_sys_integer;
+                break;
             }
         } else
             return -EPERM;
@@ -1506,7 +1768,7 @@ ssize_t ProcFSInode::write_bytes(off_t offset, ssize_t size, const UserOrKernelB
         write_callback = directory_entry->write_callback;
     }
 
-    VERIFY(is_persistent_inode(identifier()));
+    VERIFY(directory_entry || is_persistent_inode(identifier()));
     // FIXME: Being able to write into ProcFS at a non-zero offset seems like something we should maybe support..
     VERIFY(offset == 0);
     ssize_t nwritten = write_callback(identifier(), buffer, (size_t)size);
@@ -1690,12 +1952,14 @@ ProcFS::ProcFS()
     m_entries.resize(FI_MaxStaticFileIndex);
     m_entries[FI_Root_df] = { "df", FI_Root_df, false, procfs$df };
     m_entries[FI_Root_all] = { "all", FI_Root_all, false, procfs$all };
+    m_entries[FI_Root_stats] = { "stats", FI_Root_stats, false, procfs$stats };
     m_entries[FI_Root_memstat] = { "memstat", FI_Root_memstat, false, procfs$memstat };
+    m_entries[FI_Root_lockstat] = { "lockstat", FI_Root_lockstat, true, procfs$lockstat };
     m_entries[FI_Root_cpuinfo] = { "cpuinfo", FI_Root_cpuinfo, false, procfs$cpuinfo };
     m_entries[FI_Root_dmesg] = { "dmesg", FI_Root_dmesg, true, procfs$dmesg };
     m_entries[FI_Root_self] = { "self", FI_Root_self, false, procfs$self };
     m_entries[FI_Root_pci] = { "pci", FI_Root_pci, false, procfs$pci };
-    m_entries[FI_Root_interrupts] = { "interrupts", FI_Root_interrupts, false, procfs$interrupts };
+    m_entries[FI_Root_interrupts] = { "interrupts", FI_Root_interrupts, false, procfs$interrupts, write_interrupts };
     m_entries[FI_Root_dmi] = { "DMI", FI_Root_dmi, false, procfs$dmi };
     m_entries[FI_Root_smbios_entry_point] = { "smbios_entry_point", FI_Root_smbios_entry_point, false, procfs$smbios_entry_point };
     m_entries[FI_Root_keymap] = { "keymap", FI_Root_keymap, false, procfs$keymap };
@@ -53,6 +53,7 @@ public:
 
     static void add_sys_bool(String&&, Lockable<bool>&, Function<void()>&& notify_callback = nullptr);
     static void add_sys_string(String&&, Lockable<String>&, Function<void()>&& notify_callback = nullptr);
+    static void add_sys_integer(String&&, Lockable<u32>&, Function<void()>&& notify_callback = nullptr);
 
 private:
     ProcFS();
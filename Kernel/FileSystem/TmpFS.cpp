@@ -27,6 +27,7 @@
 #include <Kernel/FileSystem/TmpFS.h>
 #include <Kernel/Process.h>
 #include <Kernel/Thread.h>
+#include <Kernel/VM/MemoryManager.h>
 #include <LibC/limits.h>
 
 namespace Kernel {
@@ -153,18 +154,67 @@ ssize_t TmpFSInode::read_bytes(off_t offset, ssize_t size, UserOrKernelBuffer& b
     VERIFY(size >= 0);
     VERIFY(offset >= 0);
 
-    if (!m_content)
-        return 0;
-
     if (offset >= m_metadata.size)
         return 0;
 
     if (static_cast<off_t>(size) > m_metadata.size - offset)
         size = m_metadata.size - offset;
 
-    if (!buffer.write(m_content->data() + offset, size))
-        return -EFAULT;
-    return size;
+    u8 page_buffer[PAGE_SIZE];
+    ssize_t nread = 0;
+    while (nread < size) {
+        size_t page_index = (offset + nread) / PAGE_SIZE;
+        size_t offset_in_page = (offset + nread) % PAGE_SIZE;
+        size_t chunk_size = min(PAGE_SIZE - offset_in_page, static_cast<size_t>(size - nread));
+
+        RefPtr<PhysicalPage> page = m_pages[page_index];
+        if (!page) {
+            if (!buffer.memset(0, nread, chunk_size))
+                return -EFAULT;
+            nread += chunk_size;
+            continue;
+        }
+
+        // Copy through a bounce buffer, since writing to a userspace buffer may
+        // fault and we can't take faults while holding the quickmap.
+        {
+            InterruptDisabler disabler;
+            u8* src_ptr = MM.quickmap_page(*page);
+            memcpy(page_buffer, src_ptr + offset_in_page, chunk_size);
+            MM.unquickmap_page();
+        }
+        if (!buffer.write(page_buffer, nread, chunk_size))
+            return -EFAULT;
+        nread += chunk_size;
+    }
+    return nread;
+}
+
+void TmpFSInode::resize_content(size_t old_size, size_t new_size)
+{
+    VERIFY(m_lock.is_locked());
+
+    size_t new_page_count = ceil_div(new_size, static_cast<size_t>(PAGE_SIZE));
+    if (new_size <= old_size) {
+        m_pages.shrink(new_page_count);
+        return;
+    }
+
+    // Whatever lies past the old end of the file in its last page (e.g. from a shared
+    // mapping or an earlier truncation) has to read back as zeroes now.
+    size_t offset_in_page = old_size % PAGE_SIZE;
+    if (offset_in_page != 0) {
+        if (auto page = m_pages[old_size / PAGE_SIZE]) {
+            InterruptDisabler disabler;
+            u8* dest_ptr = MM.quickmap_page(*page);
+            memset(dest_ptr + offset_in_page, 0, PAGE_SIZE - offset_in_page);
+            MM.unquickmap_page();
+        }
+    }
+
+    // Grow geometrically, so that appending to a file doesn't keep reallocating the page list.
+    m_pages.grow_capacity(new_page_count);
+    m_pages.resize(new_page_count);
 }
 
 ssize_t TmpFSInode::write_bytes(off_t offset, ssize_t size, const UserOrKernelBuffer& buffer, FileDescription*)
@@ -177,41 +227,59 @@ ssize_t TmpFSInode::write_bytes(off_t offset, ssize_t size, const UserOrKernelBu
     if (result.is_error())
         return result;
 
-    off_t old_size = m_metadata.size;
-    off_t new_size = m_metadata.size;
-    if ((offset + size) > new_size)
-        new_size = offset + size;
-
-    if (new_size > old_size) {
-        if (m_content && m_content->capacity() >= (size_t)new_size) {
-            m_content->set_size(new_size);
-        } else {
-            // Grow the content buffer 2x the new sizeto accommodate repeating write() calls.
-            // Note that we're not actually committing physical memory to the buffer
-            // until it's needed. We only grow VM here.
-
-            // FIXME: Fix this so that no memcpy() is necessary, and we can just grow the
-            //        KBuffer and it will add physical pages as needed while keeping the
-            //        existing ones.
-            auto tmp = KBuffer::try_create_with_size(new_size * 2);
-            if (!tmp)
-                return -ENOMEM;
-            tmp->set_size(new_size);
-            if (m_content)
-                memcpy(tmp->data(), m_content->data(), old_size);
-            m_content = move(tmp);
+    size_t old_size = m_metadata.size;
+    if (static_cast<size_t>(offset + size) > old_size)
+        resize_content(old_size, offset + size);
+
+    u8 page_buffer[PAGE_SIZE];
+    ssize_t nwritten = 0;
+    int error = 0;
+    while (nwritten < size) {
+        size_t page_index = (offset + nwritten) / PAGE_SIZE;
+        size_t offset_in_page = (offset + nwritten) % PAGE_SIZE;
+        size_t chunk_size = min(PAGE_SIZE - offset_in_page, static_cast<size_t>(size - nwritten));
+
+        auto& page = m_pages[page_index];
+        if (!page) {
+            page = MM.allocate_user_physical_page(MemoryManager::ShouldZeroFill::Yes);
+            if (!page) {
+                error = -ENOMEM;
+                break;
+            }
+        }
+
+        // Copy through a bounce buffer, since reading from a userspace buffer may
+        // fault and we can't take faults while holding the quickmap.
+        if (!buffer.read(page_buffer, nwritten, chunk_size)) {
+            error = -EFAULT;
+            break;
         }
+        {
+            InterruptDisabler disabler;
+            u8* dest_ptr = MM.quickmap_page(*page);
+            memcpy(dest_ptr + offset_in_page, page_buffer, chunk_size);
+            MM.unquickmap_page();
+        }
+        nwritten += chunk_size;
+    }
+
+    // Only grow the file as far as we actually got.
+    size_t new_size = max(old_size, static_cast<size_t>(offset + nwritten));
+    if (m_pages.size() > ceil_div(new_size, static_cast<size_t>(PAGE_SIZE)))
+        resize_content(offset + size, new_size);
+
+    if (new_size != old_size) {
         m_metadata.size = new_size;
         set_metadata_dirty(true);
         set_metadata_dirty(false);
         inode_size_changed(old_size, new_size);
     }
 
-    if (!buffer.read(m_content->data() + offset, size)) // TODO: partial reads?
-        return -EFAULT;
-    inode_contents_changed(offset, size, buffer);
-
-    return size;
+    if (nwritten == 0 && error)
+        return error;
+    if (nwritten)
+        inode_contents_changed(offset, nwritten, buffer);
+    return nwritten;
 }
 
 RefPtr<Inode> TmpFSInode::lookup(StringView name)
@@ -308,7 +376,7 @@ KResult TmpFSInode::add_child(Inode& child, const StringView& name, mode_t)
         return ENAMETOOLONG;
 
     m_children.set(name, { name, static_cast<TmpFSInode&>(child) });
-    did_add_child(child.identifier());
+    did_add_child(child.identifier(), name);
     return KSuccess;
 }
 
@@ -325,7 +393,7 @@ KResult TmpFSInode::remove_child(const StringView& name)
         return ENOENT;
     auto child_id = it->value.inode->identifier();
     m_children.remove(it);
-    did_remove_child(child_id);
+    did_remove_child(child_id, name);
     return KSuccess;
 }
 
@@ -334,39 +402,28 @@ KResult TmpFSInode::truncate(u64 size)
     LOCKER(m_lock);
     VERIFY(!is_directory());
 
-    if (size == 0)
-        m_content.clear();
-    else if (!m_content) {
-        m_content = KBuffer::try_create_with_size(size);
-        if (!m_content)
-            return ENOMEM;
-    } else if (static_cast<size_t>(size) < m_content->capacity()) {
-        size_t prev_size = m_metadata.size;
-        m_content->set_size(size);
-        if (prev_size < static_cast<size_t>(size))
-            memset(m_content->data() + prev_size, 0, size - prev_size);
-    } else {
-        size_t prev_size = m_metadata.size;
-        auto tmp = KBuffer::try_create_with_size(size);
-        if (!tmp)
-            return ENOMEM;
-        memcpy(tmp->data(), m_content->data(), prev_size);
-        m_content = move(tmp);
-    }
-
     size_t old_size = m_metadata.size;
+    if (old_size == size)
+        return KSuccess;
+
+    resize_content(old_size, size);
     m_metadata.size = size;
     notify_watchers();
+    inode_size_changed(old_size, size);
+    return KSuccess;
+}
 
-    if (old_size != (size_t)size) {
-        inode_size_changed(old_size, size);
-        if (m_content) {
-            auto buffer = UserOrKernelBuffer::for_kernel_buffer(m_content->data());
-            inode_contents_changed(0, size, buffer);
-        }
-    }
+RefPtr<PhysicalPage> TmpFSInode::shared_physical_page(size_t page_index)
+{
+    LOCKER(m_lock);
+    VERIFY(!is_directory());
 
-    return KSuccess;
+    if (page_index >= m_pages.size())
+        return nullptr;
+    auto& page = m_pages[page_index];
+    if (!page)
+        page = MM.allocate_user_physical_page(MemoryManager::ShouldZeroFill::Yes);
+    return page;
 }
 
 int TmpFSInode::set_atime(time_t time)
@@ -30,7 +30,7 @@
 #include <AK/Optional.h>
 #include <Kernel/FileSystem/FileSystem.h>
 #include <Kernel/FileSystem/Inode.h>
-#include <Kernel/KBuffer.h>
+#include <Kernel/VM/PhysicalPage.h>
 
 namespace Kernel {
 
@@ -47,6 +47,7 @@ public:
     virtual const char* class_name() const override { return "TmpFS"; }
 
     virtual bool supports_watchers() const override { return true; }
+    virtual bool supports_dentry_cache() const override { return true; }
 
     virtual NonnullRefPtr<Inode> root_inode() const override;
 
@@ -87,6 +88,7 @@ public:
     virtual KResult chmod(mode_t) override;
     virtual KResult chown(uid_t, gid_t) override;
     virtual KResult truncate(u64) override;
+    virtual RefPtr<PhysicalPage> shared_physical_page(size_t page_index) override;
     virtual int set_atime(time_t) override;
     virtual int set_ctime(time_t) override;
     virtual int set_mtime(time_t) override;
@@ -98,11 +100,14 @@ private:
     static NonnullRefPtr<TmpFSInode> create_root(TmpFS&);
 
     void notify_watchers();
+    void resize_content(size_t old_size, size_t new_size);
 
     InodeMetadata m_metadata;
     InodeIdentifier m_parent;
 
-    OwnPtr<KBuffer> m_content;
+    // File contents, one physical page per PAGE_SIZE bytes. Pages that were never
+    // written to are null, and read back as zeroes.
+    Vector<RefPtr<PhysicalPage>> m_pages;
     struct Child {
         String name;
         NonnullRefPtr<TmpFSInode> inode;
@@ -30,6 +30,7 @@
 #include <Kernel/Debug.h>
 #include <Kernel/Devices/BlockDevice.h>
 #include <Kernel/FileSystem/Custody.h>
+#include <Kernel/FileSystem/DentryCache.h>
 #include <Kernel/FileSystem/FileBackedFileSystem.h>
 #include <Kernel/FileSystem/FileDescription.h>
 #include <Kernel/FileSystem/FileSystem.h>
@@ -120,6 +121,8 @@ KResult VFS::unmount(Inode& guest_inode)
     for (size_t i = 0; i < m_mounts.size(); ++i) {
         auto& mount = m_mounts.at(i);
         if (&mount.guest() == &guest_inode) {
+            // The dentry cache keeps inodes alive, drop them so the file system doesn't think they're in use.
+            DentryCache::the().invalidate_fs(mount.guest_fs().fsid());
             auto result = mount.guest_fs().prepare_to_unmount();
             if (result.is_error()) {
                 dbgln("VFS: Failed to unmount!");
@@ -159,6 +162,7 @@ bool VFS::mount_root(FS& file_system)
 
 auto VFS::find_mount_for_host(Inode& inode) -> Mount*
 {
+    LOCKER(m_lock, Lock::Mode::Shared);
     for (auto& mount : m_mounts) {
         if (mount.host() == &inode)
             return &mount;
@@ -168,6 +172,7 @@ auto VFS::find_mount_for_host(Inode& inode) -> Mount*
 
 auto VFS::find_mount_for_host(InodeIdentifier id) -> Mount*
 {
+    LOCKER(m_lock, Lock::Mode::Shared);
     for (auto& mount : m_mounts) {
         if (mount.host() && mount.host()->identifier() == id)
             return &mount;
@@ -177,6 +182,7 @@ auto VFS::find_mount_for_host(InodeIdentifier id) -> Mount*
 
 auto VFS::find_mount_for_guest(Inode& inode) -> Mount*
 {
+    LOCKER(m_lock, Lock::Mode::Shared);
     for (auto& mount : m_mounts) {
         if (&mount.guest() == &inode)
             return &mount;
@@ -186,6 +192,7 @@ auto VFS::find_mount_for_guest(Inode& inode) -> Mount*
 
 auto VFS::find_mount_for_guest(InodeIdentifier id) -> Mount*
 {
+    LOCKER(m_lock, Lock::Mode::Shared);
     for (auto& mount : m_mounts) {
         if (mount.guest().identifier() == id)
             return &mount;
@@ -797,7 +804,13 @@ KResult VFS::rmdir(StringView path, Custody& base)
     if (result.is_error())
         return result;
 
-    return parent_inode.remove_child(LexicalPath(path).basename());
+    result = parent_inode.remove_child(LexicalPath(path).basename());
+    if (result.is_error())
+        return result;
+
+    // Forget about any failed lookups in the directory, its inode may get reused.
+    DentryCache::the().invalidate_directory(inode.identifier());
+    return KSuccess;
 }
 
 VFS::Mount::Mount(FS& guest_fs, Custody* host_custody, int flags)
@@ -839,6 +852,7 @@ const Inode* VFS::Mount::host() const
 
 void VFS::for_each_mount(Function<void(const Mount&)> callback) const
 {
+    LOCKER(m_lock, Lock::Mode::Shared);
     for (auto& mount : m_mounts) {
         callback(mount);
     }
@@ -998,7 +1012,7 @@ KResultOr<NonnullRefPtr<Custody>> VFS::resolve_path_without_veil(StringView path
         }
 
         // Okay, let's look up this part.
-        auto child_inode = parent.inode().lookup(part);
+        auto child_inode = DentryCache::the().lookup(parent.inode(), part);
         if (!child_inode) {
             if (out_parent) {
                 // ENOENT with a non-null parent custody signals to caller that
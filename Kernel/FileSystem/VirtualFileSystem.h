@@ -134,7 +134,8 @@ private:
     Mount* find_mount_for_guest(Inode&);
     Mount* find_mount_for_guest(InodeIdentifier);
 
-    Lock m_lock { "VFSLock" };
+    // Taken exclusively to modify the mount table, and shared to look things up in it.
+    mutable Lock m_lock { "VFSLock" };
 
     RefPtr<Inode> m_root_inode;
     Vector<Mount, 16> m_mounts;
@@ -51,6 +51,13 @@
 #define POOL_SIZE (2 * MiB)
 #define ETERNAL_RANGE_SIZE (2 * MiB)
 
+// Small allocations are served from per-processor magazines of recently
+// freed blocks, so that the common case doesn't need to take s_lock.
+#define MAGAZINE_MAX_CHUNKS 4
+#define MAGAZINE_CAPACITY 32
+#define MAGAZINE_BATCH_SIZE (MAGAZINE_CAPACITY / 2)
+#define MAGAZINE_MAX_PROCESSORS 32
+
 static RecursiveSpinLock s_lock; // needs to be recursive because of dump_backtrace()
 
 static void kmalloc_allocate_backup_memory();
@@ -187,6 +194,20 @@ struct KmallocGlobalHeap {
 };
 
 READONLY_AFTER_INIT static KmallocGlobalHeap* g_kmalloc_global;
+
+using KmallocChunkHeap = KmallocGlobalHeap::HeapType::HeapType;
+
+struct KmallocMagazine {
+    size_t count { 0 };
+    void* blocks[MAGAZINE_CAPACITY];
+};
+
+struct KmallocPerProcessorCache {
+    // Indexed by the allocation size in chunks, minus one.
+    KmallocMagazine magazines[MAGAZINE_MAX_CHUNKS];
+};
+
+static KmallocPerProcessorCache s_per_processor_caches[MAGAZINE_MAX_PROCESSORS];
 static u8 g_kmalloc_global_heap[sizeof(KmallocGlobalHeap)];
 
 // Treat the heap as logically separate from .bss
@@ -194,8 +215,8 @@ __attribute__((section(".heap"))) static u8 kmalloc_eternal_heap[ETERNAL_RANGE_S
 __attribute__((section(".heap"))) static u8 kmalloc_pool_heap[POOL_SIZE];
 
 static size_t g_kmalloc_bytes_eternal = 0;
-static size_t g_kmalloc_call_count;
-static size_t g_kfree_call_count;
+static Atomic<size_t, AK::MemoryOrder::memory_order_relaxed> g_kmalloc_call_count;
+static Atomic<size_t, AK::MemoryOrder::memory_order_relaxed> g_kfree_call_count;
 bool g_dump_kmalloc_stacks;
 
 static u8* s_next_eternal_ptr;
@@ -236,16 +257,88 @@ void* kmalloc_eternal(size_t size)
     return ptr;
 }
 
+static inline bool can_use_magazines()
+{
+    // Before the Processor structures are set up we can't tell which
+    // processor we're on, so everything goes straight to the global heap.
+    return Processor::is_initialized() && Processor::id() < MAGAZINE_MAX_PROCESSORS;
+}
+
+static void* kmalloc_from_magazine(size_t chunks)
+{
+    VERIFY(chunks > 0 && chunks <= MAGAZINE_MAX_CHUNKS);
+    InterruptDisabler disabler;
+    auto& magazine = s_per_processor_caches[Processor::id()].magazines[chunks - 1];
+    if (magazine.count == 0) {
+        // Refill a batch of blocks from the global heap in one go, so that
+        // we only bounce s_lock once for every MAGAZINE_BATCH_SIZE allocations.
+        ScopedSpinLock lock(s_lock);
+        size_t usable_size = KmallocChunkHeap::usable_size_for_chunks(chunks);
+        while (magazine.count < MAGAZINE_BATCH_SIZE) {
+            void* ptr = g_kmalloc_global->m_heap.allocate(usable_size);
+            if (!ptr)
+                break;
+            magazine.blocks[magazine.count++] = ptr;
+        }
+        if (magazine.count == 0)
+            return nullptr;
+    }
+    void* ptr = magazine.blocks[--magazine.count];
+#ifdef SANITIZE_KMALLOC
+    __builtin_memset(ptr, KMALLOC_SCRUB_BYTE, KmallocChunkHeap::usable_size_for_chunks(chunks));
+#endif
+    return ptr;
+}
+
+static void kfree_to_magazine(void* ptr, size_t chunks)
+{
+    VERIFY(chunks > 0 && chunks <= MAGAZINE_MAX_CHUNKS);
+#ifdef SANITIZE_KMALLOC
+    __builtin_memset(ptr, KFREE_SCRUB_BYTE, KmallocChunkHeap::usable_size_for_chunks(chunks));
+#endif
+    InterruptDisabler disabler;
+    auto& magazine = s_per_processor_caches[Processor::id()].magazines[chunks - 1];
+    if (magazine.count == MAGAZINE_CAPACITY) {
+        // The magazine is full, return the oldest half to the global heap.
+        ScopedSpinLock lock(s_lock);
+        for (size_t i = 0; i < MAGAZINE_BATCH_SIZE; ++i)
+            g_kmalloc_global->m_heap.deallocate(magazine.blocks[i]);
+        magazine.count -= MAGAZINE_BATCH_SIZE;
+        __builtin_memmove(magazine.blocks, magazine.blocks + MAGAZINE_BATCH_SIZE, magazine.count * sizeof(void*));
+    }
+    magazine.blocks[magazine.count++] = ptr;
+}
+
+static size_t magazine_cached_bytes()
+{
+    // NOTE: This is only used for statistics, so we don't care about
+    //       magazines changing underneath us.
+    size_t bytes = 0;
+    for (auto& cache : s_per_processor_caches) {
+        for (size_t i = 0; i < MAGAZINE_MAX_CHUNKS; ++i)
+            bytes += cache.magazines[i].count * (i + 1) * CHUNK_SIZE;
+    }
+    return bytes;
+}
+
 void* kmalloc_impl(size_t size)
 {
-    ScopedSpinLock lock(s_lock);
     ++g_kmalloc_call_count;
 
     if (g_dump_kmalloc_stacks && Kernel::g_kernel_symbols_available) {
+        ScopedSpinLock lock(s_lock);
         dbgln("kmalloc({})", size);
         Kernel::dump_backtrace();
     }
 
+    size_t chunks = KmallocChunkHeap::chunks_needed_for(size);
+    if (chunks <= MAGAZINE_MAX_CHUNKS && can_use_magazines()) {
+        if (void* ptr = kmalloc_from_magazine(chunks))
+            return ptr;
+        PANIC("kmalloc: Out of memory (requested size: {})", size);
+    }
+
+    ScopedSpinLock lock(s_lock);
     void* ptr = g_kmalloc_global->m_heap.allocate(size);
     if (!ptr) {
         PANIC("kmalloc: Out of memory (requested size: {})", size);
@@ -259,9 +352,15 @@ void kfree(void* ptr)
     if (!ptr)
         return;
 
-    ScopedSpinLock lock(s_lock);
     ++g_kfree_call_count;
 
+    size_t chunks = KmallocChunkHeap::allocation_size_in_chunks(ptr);
+    if (chunks <= MAGAZINE_MAX_CHUNKS && can_use_magazines()) {
+        kfree_to_magazine(ptr, chunks);
+        return;
+    }
+
+    ScopedSpinLock lock(s_lock);
     g_kmalloc_global->m_heap.deallocate(ptr);
 }
 
@@ -284,8 +383,11 @@ void* operator new[](size_t size)
 void get_kmalloc_stats(kmalloc_stats& stats)
 {
     ScopedSpinLock lock(s_lock);
-    stats.bytes_allocated = g_kmalloc_global->m_heap.allocated_bytes();
-    stats.bytes_free = g_kmalloc_global->m_heap.free_bytes() + g_kmalloc_global->backup_memory_bytes();
+    // Blocks sitting in the per-processor magazines are free as far as
+    // the rest of the kernel is concerned.
+    auto cached_bytes = magazine_cached_bytes();
+    stats.bytes_allocated = g_kmalloc_global->m_heap.allocated_bytes() - cached_bytes;
+    stats.bytes_free = g_kmalloc_global->m_heap.free_bytes() + g_kmalloc_global->backup_memory_bytes() + cached_bytes;
     stats.bytes_eternal = g_kmalloc_bytes_eternal;
     stats.kmalloc_call_count = g_kmalloc_call_count;
     stats.kfree_call_count = g_kfree_call_count;
@@ -43,6 +43,7 @@
 #include <Kernel/VM/PageDirectory.h>
 #include <Kernel/VM/TypedMapping.h>
 
+#define IRQ_APIC_PERFORMANCE_COUNTER (0xfb - IRQ_VECTOR_BASE)
 #define IRQ_APIC_TIMER (0xfc - IRQ_VECTOR_BASE)
 #define IRQ_APIC_IPI (0xfd - IRQ_VECTOR_BASE)
 #define IRQ_APIC_ERR (0xfe - IRQ_VECTOR_BASE)
@@ -54,6 +55,7 @@
 
 #define APIC_BASE_MSR 0x1b
 
+#define APIC_REG_ID 0x20
 #define APIC_REG_EOI 0xb0
 #define APIC_REG_LD 0xd0
 #define APIC_REG_DF 0xe0
@@ -229,6 +231,21 @@ u8 APIC::spurious_interrupt_vector()
     return IRQ_APIC_SPURIOUS;
 }
 
+u8 APIC::performance_counter_interrupt_vector()
+{
+    return IRQ_APIC_PERFORMANCE_COUNTER;
+}
+
+void APIC::enable_performance_counter_interrupt()
+{
+    write_register(APIC_REG_LVT_PERFORMANCE_COUNTER, APIC_LVT(IRQ_APIC_PERFORMANCE_COUNTER + IRQ_VECTOR_BASE, 0));
+}
+
+void APIC::disable_performance_counter_interrupt()
+{
+    write_register(APIC_REG_LVT_PERFORMANCE_COUNTER, APIC_LVT(0, 0) | APIC_LVT_MASKED);
+}
+
 #define APIC_INIT_VAR_PTR(tpe, vaddr, varname)                         \
     reinterpret_cast<volatile tpe*>(reinterpret_cast<ptrdiff_t>(vaddr) \
         + reinterpret_cast<ptrdiff_t>(&varname)                        \
@@ -435,6 +452,7 @@ UNMAP_AFTER_INIT void APIC::enable(u32 cpu)
     // read it back to make sure it's actually set
     auto apic_id = read_register(APIC_REG_LD) >> 24;
     Processor::current().info().set_apic_id(apic_id);
+    m_physical_apic_ids[cpu] = read_register(APIC_REG_ID) >> 24;
 
 #if APIC_DEBUG
     klog() << "Enabling local APIC for cpu #" << cpu << " logical apic id: " << apic_id;
@@ -472,6 +490,12 @@ Thread* APIC::get_idle_thread(u32 cpu) const
     return m_ap_idle_threads[cpu - 1];
 }
 
+u8 APIC::physical_apic_id(u32 cpu) const
+{
+    VERIFY(cpu < m_physical_apic_ids.size());
+    return m_physical_apic_ids[cpu];
+}
+
 UNMAP_AFTER_INIT void APIC::init_finished(u32 cpu)
 {
     // This method is called once the boot stack is no longer needed
@@ -587,7 +611,7 @@ void APIC::setup_local_timer(u32 ticks, TimerMode timer_mode, bool enable)
     }
     write_register(APIC_REG_TIMER_CONFIGURATION, config);
 
-    if (timer_mode == TimerMode::Periodic)
+    if (timer_mode == TimerMode::Periodic || timer_mode == TimerMode::OneShot)
         write_register(APIC_REG_TIMER_INITIAL_COUNT, ticks / get_timer_divisor());
 }
 
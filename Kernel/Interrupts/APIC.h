@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <AK/Array.h>
 #include <AK/Types.h>
 #include <Kernel/Time/HardwareTimer.h>
 #include <Kernel/VM/MemoryManager.h>
@@ -52,7 +53,13 @@ public:
     void broadcast_ipi();
     void send_ipi(u32 cpu);
     static u8 spurious_interrupt_vector();
+    static u8 performance_counter_interrupt_vector();
+    // Only affect the current processor, see PerformanceCounters.
+    void enable_performance_counter_interrupt();
+    void disable_performance_counter_interrupt();
     Thread* get_idle_thread(u32 cpu) const;
+    // For routing device interrupts (I/O APIC entries and MSIs) to a given processor.
+    u8 physical_apic_id(u32 cpu) const;
     u32 enabled_processor_count() const { return m_processor_enabled_cnt; }
 
     APICTimer* initialize_timers(HardwareTimerBase&);
@@ -116,6 +123,7 @@ private:
     Atomic<u8> m_apic_ap_continue { 0 };
     u32 m_processor_cnt { 0 };
     u32 m_processor_enabled_cnt { 0 };
+    Array<u8, 8> m_physical_apic_ids {};
     APICTimer* m_apic_timer { nullptr };
 
     static PhysicalAddress get_base();
@@ -63,4 +63,29 @@ void GenericInterruptHandler::change_interrupt_number(u8 number)
     register_generic_interrupt_handler(InterruptManagement::acquire_mapped_interrupt_number(interrupt_number()), *this);
 }
 
+void GenericInterruptHandler::change_to_unmapped_interrupt_number(u8 number)
+{
+    VERIFY_INTERRUPTS_DISABLED();
+    if (m_disable_remap)
+        unregister_generic_interrupt_handler(interrupt_number(), *this);
+    else
+        unregister_generic_interrupt_handler(InterruptManagement::acquire_mapped_interrupt_number(interrupt_number()), *this);
+    m_interrupt_number = number;
+    m_disable_remap = true;
+    register_generic_interrupt_handler(interrupt_number(), *this);
+}
+
+bool GenericInterruptHandler::set_target_processor(u32 cpu)
+{
+    if (cpu >= Processor::count())
+        return false;
+    InterruptDisabler disabler;
+    if (cpu == m_target_processor)
+        return true;
+    if (!route_to_processor(cpu))
+        return false;
+    m_target_processor = cpu;
+    return true;
+}
+
 }
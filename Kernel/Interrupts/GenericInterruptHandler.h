@@ -50,6 +50,10 @@ public:
 
     size_t get_invoking_count() const { return m_invoking_count; }
 
+    // The processor this interrupt is delivered to.
+    u32 target_processor() const { return m_target_processor; }
+    bool set_target_processor(u32 cpu);
+
     virtual size_t sharing_devices_count() const = 0;
     virtual bool is_shared_handler() const = 0;
     virtual bool is_sharing_with_others() const = 0;
@@ -59,6 +63,7 @@ public:
     virtual const char* controller() const = 0;
 
     virtual bool eoi() = 0;
+    virtual bool route_to_processor(u32) { return false; }
     ALWAYS_INLINE void increment_invoking_counter()
     {
         m_invoking_count++;
@@ -66,12 +71,14 @@ public:
 
 protected:
     void change_interrupt_number(u8 number);
+    void change_to_unmapped_interrupt_number(u8 number);
     GenericInterruptHandler(u8 interrupt_number, bool disable_remap = false);
 
     void disable_remap() { m_disable_remap = true; }
 
 private:
     Atomic<u32, AK::MemoryOrder::memory_order_relaxed> m_invoking_count { 0 };
+    u32 m_target_processor { 0 };
     u8 m_interrupt_number { 0 };
     bool m_disable_remap { false };
 };
@@ -293,6 +293,26 @@ void IOAPIC::enable(const GenericInterruptHandler& handler)
     unmask_redirection_entry(found_index.value());
 }
 
+bool IOAPIC::set_target_processor(const GenericInterruptHandler& handler, u32 cpu)
+{
+    InterruptDisabler disabler;
+    VERIFY(!is_hard_disabled());
+    u8 interrupt_vector = handler.interrupt_number();
+    VERIFY(interrupt_vector >= gsi_base() && interrupt_vector < interrupt_vectors_count());
+    auto found_index = find_redirection_entry_by_vector(interrupt_vector);
+    if (!found_index.has_value()) {
+        map_interrupt_redirection(interrupt_vector);
+        found_index = find_redirection_entry_by_vector(interrupt_vector);
+    }
+    VERIFY(found_index.has_value());
+    u32 index = found_index.value();
+    // In physical destination mode, the destination is simply the APIC id.
+    if (read_register((index << 1) + IOAPIC_REDIRECTION_ENTRY_OFFSET) & (1 << 11))
+        return false;
+    write_register((index << 1) + IOAPIC_REDIRECTION_ENTRY_OFFSET + 1, (u32)APIC::the().physical_apic_id(cpu) << 24);
+    return true;
+}
+
 void IOAPIC::eoi(const GenericInterruptHandler& handler) const
 {
     InterruptDisabler disabler;
@@ -62,6 +62,7 @@ public:
     IOAPIC(PhysicalAddress, u32 gsi_base);
     virtual void enable(const GenericInterruptHandler&) override;
     virtual void disable(const GenericInterruptHandler&) override;
+    virtual bool set_target_processor(const GenericInterruptHandler&, u32 cpu) override;
     virtual void hard_disable() override;
     virtual void eoi(const GenericInterruptHandler&) const override;
     virtual void spurious_eoi(const GenericInterruptHandler&) const override;
@@ -43,6 +43,8 @@ public:
 
     virtual void enable(const GenericInterruptHandler&) = 0;
     virtual void disable(const GenericInterruptHandler&) = 0;
+    // Returns false if the controller can only deliver interrupts to the boot processor.
+    virtual bool set_target_processor(const GenericInterruptHandler&, u32) { return false; }
     virtual void hard_disable() { m_hard_disabled = true; }
     virtual bool is_vector_enabled(u8 number) const = 0;
     virtual bool is_enabled() const = 0;
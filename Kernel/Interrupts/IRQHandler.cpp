@@ -26,8 +26,10 @@
 
 #include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/Debug.h>
+#include <Kernel/Interrupts/APIC.h>
 #include <Kernel/Interrupts/IRQHandler.h>
 #include <Kernel/Interrupts/InterruptManagement.h>
+#include <Kernel/PCI/MessageSignalledInterrupt.h>
 
 namespace Kernel {
 
@@ -42,9 +44,20 @@ IRQHandler::~IRQHandler()
 {
 }
 
+const char* IRQHandler::controller() const
+{
+    if (m_message_signalled_interrupt)
+        return m_message_signalled_interrupt->is_extended() ? "MSI-X" : "MSI";
+    return m_responsible_irq_controller->model();
+}
+
 bool IRQHandler::eoi()
 {
     dbgln_if(IRQ_DEBUG, "EOI IRQ {}", interrupt_number());
+    if (m_message_signalled_interrupt) {
+        APIC::the().eoi();
+        return true;
+    }
     if (!m_shared_with_others) {
         VERIFY(!m_responsible_irq_controller.is_null());
         m_responsible_irq_controller->eoi(*this);
@@ -57,7 +70,9 @@ void IRQHandler::enable_irq()
 {
     dbgln_if(IRQ_DEBUG, "Enable IRQ {}", interrupt_number());
     m_enabled = true;
-    if (!m_shared_with_others)
+    if (m_message_signalled_interrupt)
+        m_message_signalled_interrupt->unmask();
+    else if (!m_shared_with_others)
         m_responsible_irq_controller->enable(*this);
 }
 
@@ -65,13 +80,65 @@ void IRQHandler::disable_irq()
 {
     dbgln_if(IRQ_DEBUG, "Disable IRQ {}", interrupt_number());
     m_enabled = false;
-    if (!m_shared_with_others)
+    if (m_message_signalled_interrupt)
+        m_message_signalled_interrupt->mask();
+    else if (!m_shared_with_others)
         m_responsible_irq_controller->disable(*this);
 }
 
+bool IRQHandler::enable_message_signalled_interrupts(PCI::Address address)
+{
+    VERIFY(!m_message_signalled_interrupt);
+    // Messages are written straight into a local APIC, so there has to be one.
+    if (!APIC::initialized() || !InterruptManagement::the().smp_enabled())
+        return false;
+    auto message_signalled_interrupt = PCI::MessageSignalledInterrupt::try_create(address);
+    if (!message_signalled_interrupt)
+        return false;
+
+    InterruptDisabler disabler;
+    auto free_interrupt_number = InterruptManagement::the().find_free_message_signalled_interrupt_number();
+    if (!free_interrupt_number.has_value()) {
+        dbgln("IRQHandler: Out of vectors for message signalled interrupts of {}", address);
+        return false;
+    }
+
+    PCI::disable_interrupt_line(address);
+    // Leave the line alone if other devices still use it.
+    if (&GenericInterruptHandler::from(InterruptManagement::acquire_mapped_interrupt_number(interrupt_number())) == this)
+        m_responsible_irq_controller->disable(*this);
+    change_to_unmapped_interrupt_number(free_interrupt_number.value());
+    m_responsible_irq_controller = nullptr;
+    m_shared_with_others = false;
+
+    message_signalled_interrupt->route(free_interrupt_number.value() + IRQ_VECTOR_BASE, APIC::the().physical_apic_id(target_processor()));
+    m_message_signalled_interrupt = move(message_signalled_interrupt);
+    if (m_enabled)
+        m_message_signalled_interrupt->unmask();
+    else
+        m_message_signalled_interrupt->mask();
+    dmesgln("IRQHandler: {} uses {} on vector {:#02x}", address, controller(), free_interrupt_number.value() + IRQ_VECTOR_BASE);
+    return true;
+}
+
+bool IRQHandler::route_to_processor(u32 cpu)
+{
+    VERIFY_INTERRUPTS_DISABLED();
+    if (m_message_signalled_interrupt) {
+        m_message_signalled_interrupt->route(interrupt_number() + IRQ_VECTOR_BASE, APIC::the().physical_apic_id(cpu));
+        if (!m_enabled)
+            m_message_signalled_interrupt->mask();
+        return true;
+    }
+    if (m_shared_with_others)
+        return false;
+    return m_responsible_irq_controller->set_target_processor(*this, cpu);
+}
+
 void IRQHandler::change_irq_number(u8 irq)
 {
     InterruptDisabler disabler;
+    VERIFY(!m_message_signalled_interrupt);
     change_interrupt_number(irq);
     m_responsible_irq_controller = InterruptManagement::the().get_responsible_irq_controller(irq);
 }
@@ -26,12 +26,14 @@
 
 #pragma once
 
+#include <AK/OwnPtr.h>
 #include <AK/RefPtr.h>
 #include <AK/String.h>
 #include <AK/Types.h>
 #include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/Interrupts/GenericInterruptHandler.h>
 #include <Kernel/Interrupts/IRQController.h>
+#include <Kernel/PCI/Definitions.h>
 
 namespace Kernel {
 
@@ -45,11 +47,18 @@ public:
     void enable_irq();
     void disable_irq();
 
+    // Moves this handler off its interrupt line and onto a vector of its own, signalled by
+    // the given PCI function. Returns false (and leaves everything as it was) if the
+    // function or the interrupt controllers don't support that.
+    bool enable_message_signalled_interrupts(PCI::Address);
+    bool is_message_signalled() const { return m_message_signalled_interrupt; }
+
     virtual bool eoi() override;
+    virtual bool route_to_processor(u32 cpu) override;
 
     virtual HandlerType type() const override { return HandlerType::IRQHandler; }
     virtual const char* purpose() const override { return "IRQ Handler"; }
-    virtual const char* controller() const override { return m_responsible_irq_controller->model(); }
+    virtual const char* controller() const override;
 
     virtual size_t sharing_devices_count() const override { return 0; }
     virtual bool is_shared_handler() const override { return false; }
@@ -63,6 +72,7 @@ private:
     bool m_shared_with_others { false };
     bool m_enabled { false };
     RefPtr<IRQController> m_responsible_irq_controller;
+    OwnPtr<PCI::MessageSignalledInterrupt> m_message_signalled_interrupt;
 };
 
 }
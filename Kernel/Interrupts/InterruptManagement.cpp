@@ -76,6 +76,18 @@ void InterruptManagement::enumerate_interrupt_handlers(Function<void(GenericInte
     }
 }
 
+Optional<u8> InterruptManagement::find_free_message_signalled_interrupt_number() const
+{
+    VERIFY_INTERRUPTS_DISABLED();
+    // Message signalled interrupts use vectors 0x90 to 0xef, which are above everything
+    // the I/O APIC entries are mapped to and below the vectors of the local APIC.
+    for (u8 interrupt_number = 0x90 - IRQ_VECTOR_BASE; interrupt_number < 0xf0 - IRQ_VECTOR_BASE; interrupt_number++) {
+        if (get_interrupt_handler(interrupt_number).type() == HandlerType::UnhandledInterruptHandler)
+            return interrupt_number;
+    }
+    return {};
+}
+
 IRQController& InterruptManagement::get_interrupt_controller(int index)
 {
     VERIFY(index >= 0);
@@ -81,6 +81,7 @@ public:
     u8 get_irq_vector(u8 mapped_interrupt_vector);
 
     void enumerate_interrupt_handlers(Function<void(GenericInterruptHandler&)>);
+    Optional<u8> find_free_message_signalled_interrupt_number() const;
     IRQController& get_interrupt_controller(int index);
 
 private:
@@ -45,6 +45,7 @@ public:
     void unregister_handler(GenericInterruptHandler&);
 
     virtual bool eoi() override;
+    virtual bool route_to_processor(u32 cpu) override { return m_responsible_irq_controller->set_target_processor(*this, cpu); }
 
     virtual size_t sharing_devices_count() const override { return m_handlers.size(); }
     virtual bool is_shared_handler() const override { return true; }
@@ -25,13 +25,50 @@
  */
 
 #include <AK/TemporaryChange.h>
+#include <AK/Time.h>
 #include <Kernel/Debug.h>
 #include <Kernel/KSyms.h>
 #include <Kernel/Lock.h>
+#include <Kernel/StdLib.h>
 #include <Kernel/Thread.h>
+#include <Kernel/Time/TimeManagement.h>
 
 namespace Kernel {
 
+static constexpr size_t max_lock_statistics = 128;
+static LockStatistics s_lock_statistics[max_lock_statistics];
+static size_t s_lock_statistics_count;
+static SpinLock<u8> s_lock_statistics_lock;
+
+LockStatistics& Lock::statistics_for(const char* name)
+{
+    if (!name)
+        name = "(unnamed)";
+    ScopedSpinLock lock(s_lock_statistics_lock);
+    for (size_t i = 0; i < s_lock_statistics_count; ++i) {
+        auto& statistics = s_lock_statistics[i];
+        if (statistics.name == name || !strcmp(statistics.name, name))
+            return statistics;
+    }
+    // Once the table is full, everything else gets lumped into the last entry.
+    if (s_lock_statistics_count == max_lock_statistics) {
+        auto& statistics = s_lock_statistics[max_lock_statistics - 1];
+        statistics.name = "(other)";
+        return statistics;
+    }
+    auto& statistics = s_lock_statistics[s_lock_statistics_count];
+    statistics.name = name;
+    // Publish the entry only after its name has been set, see statistics_table().
+    AK::atomic_store(&s_lock_statistics_count, s_lock_statistics_count + 1, AK::memory_order_release);
+    return statistics;
+}
+
+LockStatistics* Lock::statistics_table(size_t& count)
+{
+    count = AK::atomic_load(&s_lock_statistics_count, AK::memory_order_acquire);
+    return s_lock_statistics;
+}
+
 #if LOCK_DEBUG
 void Lock::lock(Mode mode)
 {
@@ -49,6 +86,10 @@ void Lock::lock(Mode mode)
     VERIFY(mode != Mode::Unlocked);
     auto current_thread = Thread::current();
     ScopedCritical critical; // in case we're not in a critical section already
+    size_t spin_rounds = 0;
+    bool contended = false;
+    bool blocked = false;
+    timespec wait_start {};
     for (;;) {
         if (m_lock.exchange(true, AK::memory_order_acq_rel) != false) {
             // I don't know *who* is using "m_lock", so just yield.
@@ -56,7 +97,6 @@ void Lock::lock(Mode mode)
             continue;
         }
 
-        // FIXME: Do not add new readers if writers are queued.
         Mode current_mode = m_mode;
         switch (current_mode) {
         case Mode::Unlocked: {
@@ -75,7 +115,8 @@ void Lock::lock(Mode mode)
 #if LOCK_DEBUG
             current_thread->holding_lock(*this, 1, file, line);
 #endif
-            m_queue.should_block(true);
+            did_acquire(contended, blocked, wait_start);
+            set_should_block(true);
             m_lock.store(false, AK::memory_order_release);
             return;
         }
@@ -98,6 +139,7 @@ void Lock::lock(Mode mode)
 #if LOCK_DEBUG
             current_thread->holding_lock(*this, 1, file, line);
 #endif
+            did_acquire(contended, blocked, wait_start);
             m_lock.store(false, AK::memory_order_release);
             return;
         }
@@ -105,6 +147,10 @@ void Lock::lock(Mode mode)
             VERIFY(!m_holder);
             if (mode != Mode::Shared)
                 break;
+            // Don't let a steady stream of new readers starve queued writers. Threads that
+            // already hold the lock in shared mode still get in, or they'd deadlock the writer.
+            if (m_exclusive_waiter_count > 0 && !m_shared_holders.contains(current_thread))
+                break;
 
             dbgln_if(LOCK_TRACE_DEBUG, "Lock::lock @ {} ({}): acquire {}, currently shared, locks held {}", this, m_name, mode_to_string(mode), m_times_locked);
 
@@ -119,19 +165,92 @@ void Lock::lock(Mode mode)
 #if LOCK_DEBUG
             current_thread->holding_lock(*this, 1, file, line);
 #endif
+            did_acquire(contended, blocked, wait_start);
             m_lock.store(false, AK::memory_order_release);
             return;
         }
         default:
             VERIFY_NOT_REACHED();
         }
+        if (!contended) {
+            contended = true;
+            statistics().contended_count++;
+            if (TimeManagement::initialized())
+                wait_start = TimeManagement::the().monotonic_time(TimePrecision::Precise);
+        }
+        bool should_spin = spin_rounds < max_spin_rounds
+            && m_holder
+            && m_holder->state() == Thread::Running
+            && m_holder->cpu() != Processor::id();
+
+        if (should_spin) {
+            m_lock.store(false, AK::memory_order_release);
+            ++spin_rounds;
+            for (size_t i = 0; i < spin_iterations_per_round && m_mode.load() != Mode::Unlocked; ++i)
+                Processor::wait_check();
+            continue;
+        }
+
+        blocked = true;
+        statistics().blocked_count++;
+        // Writers and readers wait on separate queues, so that unlock() can wake writers first.
+        if (mode == Mode::Exclusive)
+            m_exclusive_waiter_count++;
         m_lock.store(false, AK::memory_order_release);
         dbgln_if(LOCK_TRACE_DEBUG, "Lock::lock @ {} ({}) waiting...", this, m_name);
-        m_queue.wait_forever(m_name);
+        if (mode == Mode::Exclusive) {
+            m_queue.wait_forever(m_name);
+            m_exclusive_waiter_count--;
+        } else {
+            m_shared_queue.wait_forever(m_name);
+        }
         dbgln_if(LOCK_TRACE_DEBUG, "Lock::lock @ {} ({}) waited", this, m_name);
     }
 }
 
+LockStatistics& Lock::statistics()
+{
+    VERIFY(m_lock.load(AK::memory_order_relaxed));
+    if (!m_statistics)
+        m_statistics = &statistics_for(m_name);
+    return *m_statistics;
+}
+
+void Lock::did_acquire(bool contended, bool blocked, const timespec& wait_start)
+{
+    auto& statistics = this->statistics();
+    statistics.acquired_count++;
+    if (!contended)
+        return;
+    if (!blocked)
+        statistics.spin_acquired_count++;
+    if (!TimeManagement::initialized())
+        return;
+
+    timespec wait_time;
+    timespec_sub(TimeManagement::the().monotonic_time(TimePrecision::Precise), wait_start, wait_time);
+    u64 wait_time_us = (u64)wait_time.tv_sec * 1'000'000 + wait_time.tv_nsec / 1'000;
+    // Bucket N counts waits shorter than 2^N microseconds, the last one everything else.
+    size_t bucket = 0;
+    while (bucket < LockStatistics::wait_time_histogram_buckets - 1 && wait_time_us >= (1ull << bucket))
+        ++bucket;
+    statistics.wait_time_histogram[bucket]++;
+}
+
+void Lock::set_should_block(bool should_block)
+{
+    m_queue.should_block(should_block);
+    m_shared_queue.should_block(should_block);
+}
+
+u32 Lock::wake_waiters()
+{
+    // Prefer writers, readers get their turn once no writer is queued anymore.
+    if (m_exclusive_waiter_count > 0)
+        return m_queue.wake_one();
+    return m_shared_queue.wake_all();
+}
+
 void Lock::unlock()
 {
     // NOTE: This may be called from an interrupt handler (not an IRQ handler)
@@ -181,7 +300,7 @@ void Lock::unlock()
             if (unlocked_last) {
                 VERIFY(current_mode == Mode::Exclusive ? !m_holder : m_shared_holders.is_empty());
                 m_mode = Mode::Unlocked;
-                m_queue.should_block(false);
+                set_should_block(false);
             }
 
 #if LOCK_DEBUG
@@ -190,7 +309,7 @@ void Lock::unlock()
 
             m_lock.store(false, AK::memory_order_release);
             if (unlocked_last) {
-                u32 did_wake = m_queue.wake_one();
+                u32 did_wake = wake_waiters();
                 dbgln_if(LOCK_TRACE_DEBUG, "Lock::unlock @ {} ({})  wake one ({})", this, m_name, did_wake);
             }
             return;
@@ -228,7 +347,7 @@ auto Lock::force_unlock_if_locked(u32& lock_count_to_restore) -> Mode
                 lock_count_to_restore = m_times_locked;
                 m_times_locked = 0;
                 m_mode = Mode::Unlocked;
-                m_queue.should_block(false);
+                set_should_block(false);
                 m_lock.store(false, AK::memory_order_release);
                 previous_mode = Mode::Exclusive;
                 break;
@@ -256,7 +375,7 @@ auto Lock::force_unlock_if_locked(u32& lock_count_to_restore) -> Mode
                 m_times_locked -= lock_count_to_restore;
                 if (m_times_locked == 0) {
                     m_mode = Mode::Unlocked;
-                    m_queue.should_block(false);
+                    set_should_block(false);
                 }
                 m_lock.store(false, AK::memory_order_release);
                 previous_mode = Mode::Shared;
@@ -271,7 +390,7 @@ auto Lock::force_unlock_if_locked(u32& lock_count_to_restore) -> Mode
             default:
                 VERIFY_NOT_REACHED();
             }
-            m_queue.wake_one();
+            wake_waiters();
             return previous_mode;
         }
         // I don't know *who* is using "m_lock", so just yield.
@@ -310,7 +429,7 @@ void Lock::restore_lock(Mode mode, u32 lock_count)
                 VERIFY(!m_holder);
                 VERIFY(m_shared_holders.is_empty());
                 m_holder = current_thread;
-                m_queue.should_block(true);
+                set_should_block(true);
                 m_lock.store(false, AK::memory_order_release);
 #if LOCK_DEBUG
                 m_holder->holding_lock(*this, (int)lock_count, file, line);
@@ -332,7 +451,7 @@ void Lock::restore_lock(Mode mode, u32 lock_count)
                 auto set_result = m_shared_holders.set(current_thread, lock_count);
                 // There may be other shared lock holders already, but we should not have an entry yet
                 VERIFY(set_result == AK::HashSetResult::InsertedNewEntry);
-                m_queue.should_block(true);
+                set_should_block(true);
                 m_lock.store(false, AK::memory_order_release);
 #if LOCK_DEBUG
                 m_holder->holding_lock(*this, (int)lock_count, file, line);
@@ -354,6 +473,7 @@ void Lock::clear_waiters()
 {
     VERIFY(m_mode != Mode::Shared);
     m_queue.wake_all();
+    m_shared_queue.wake_all();
 }
 
 }
@@ -37,6 +37,19 @@
 
 namespace Kernel {
 
+// Usage and contention counters, shared by all locks with the same name and exposed in /proc/lockstat.
+struct LockStatistics {
+    const char* name { nullptr };
+    Atomic<u32, AK::MemoryOrder::memory_order_relaxed> contended_count { 0 };
+    Atomic<u32, AK::MemoryOrder::memory_order_relaxed> spin_acquired_count { 0 };
+    Atomic<u32, AK::MemoryOrder::memory_order_relaxed> blocked_count { 0 };
+    Atomic<u32, AK::MemoryOrder::memory_order_relaxed> acquired_count { 0 };
+
+    // Time spent waiting for contended acquisitions, bucket N counts waits < 2^N microseconds.
+    static constexpr size_t wait_time_histogram_buckets = 16;
+    Atomic<u32, AK::MemoryOrder::memory_order_relaxed> wait_time_histogram[wait_time_histogram_buckets] {};
+};
+
 class Lock {
     AK_MAKE_NONCOPYABLE(Lock);
     AK_MAKE_NONMOVABLE(Lock);
@@ -77,10 +90,30 @@ public:
         }
     }
 
+    template<typename Callback>
+    static void for_each_statistics(Callback);
+
 private:
+    // While the exclusive holder is running on another CPU, spin for a bit before blocking,
+    // since it will likely release the lock before a context switch would even complete.
+    static constexpr size_t max_spin_rounds = 10;
+    static constexpr size_t spin_iterations_per_round = 1000;
+
+    static LockStatistics& statistics_for(const char* name);
+    static LockStatistics* statistics_table(size_t& count);
+    LockStatistics& statistics();
+    void did_acquire(bool contended, bool blocked, const timespec& wait_start);
+
+    void set_should_block(bool);
+    u32 wake_waiters();
+
     Atomic<bool> m_lock { false };
     const char* m_name { nullptr };
+    LockStatistics* m_statistics { nullptr };
+    // Exclusive waiters block on m_queue and shared waiters on m_shared_queue.
     WaitQueue m_queue;
+    WaitQueue m_shared_queue;
+    Atomic<u32> m_exclusive_waiter_count { 0 };
     Atomic<Mode, AK::MemoryOrder::memory_order_relaxed> m_mode { Mode::Unlocked };
 
     // When locked exclusively, only the thread already holding the lock can
@@ -96,6 +129,15 @@ private:
     HashMap<Thread*, u32> m_shared_holders;
 };
 
+template<typename Callback>
+void Lock::for_each_statistics(Callback callback)
+{
+    size_t count = 0;
+    auto* statistics = statistics_table(count);
+    for (size_t i = 0; i < count; ++i)
+        callback(const_cast<const LockStatistics&>(statistics[i]));
+}
+
 class Locker {
 public:
 #if LOCK_DEBUG
@@ -28,7 +28,9 @@
 #include <Kernel/Debug.h>
 #include <Kernel/IO.h>
 #include <Kernel/Net/E1000NetworkAdapter.h>
+#include <Kernel/Net/EthernetFrameHeader.h>
 #include <Kernel/Thread.h>
+#include <Kernel/WorkQueue.h>
 
 namespace Kernel {
 
@@ -109,6 +111,22 @@ namespace Kernel {
 #define TCTL_SWXOFF (1 << 22) // Software XOFF Transmission
 #define TCTL_RTLC (1 << 24)   // Re-transmit on Late Collision
 
+// Extended TX descriptors, used for checksum and segmentation offload
+#define TDESC_DTYP_CONTEXT (0 << 20)
+#define TDESC_DTYP_DATA (1 << 20)
+#define TUCMD_TCP (1 << 24)     // Context is for TCP
+#define TUCMD_IP (1 << 25)      // Context is for IPv4
+#define TUCMD_TSE (1 << 26)     // TCP Segmentation Enable
+#define TUCMD_RS (1 << 27)      // Report Status
+#define TUCMD_DEXT (1 << 29)    // Extended descriptor
+#define DCMD_EOP (1 << 24)      // End of Packet
+#define DCMD_IFCS (1 << 25)     // Insert FCS
+#define DCMD_TSE (1 << 26)      // TCP Segmentation Enable
+#define DCMD_RS (1 << 27)       // Report Status
+#define DCMD_DEXT (1 << 29)     // Extended descriptor
+#define POPTS_IXSM (1 << 0)     // Insert IP Checksum
+#define POPTS_TXSM (1 << 1)     // Insert TCP/UDP Checksum
+
 #define TSTA_DD (1 << 0) // Descriptor Done
 #define TSTA_EC (1 << 1) // Excess Collisions
 #define TSTA_LC (1 << 2) // Late Collision
@@ -223,15 +241,17 @@ UNMAP_AFTER_INIT E1000NetworkAdapter::E1000NetworkAdapter(PCI::Address address,
     u32 flags = in32(REG_CTRL);
     out32(REG_CTRL, flags | ECTRL_SLU);
 
-    out32(REG_INTERRUPT_RATE, 6000); // Interrupt rate of 1.536 milliseconds
+    out32(REG_INTERRUPT_RATE, interrupt_throttle_interval);
 
     initialize_rx_descriptors();
     initialize_tx_descriptors();
+    set_offloads(NetworkOffload::TransmitChecksum | NetworkOffload::TCPSegmentation, max_segmentation_size);
 
     out32(REG_INTERRUPT_MASK_SET, 0x1f6dc);
-    out32(REG_INTERRUPT_MASK_SET, INTERRUPT_LSC | INTERRUPT_RXT0);
+    out32(REG_INTERRUPT_MASK_SET, INTERRUPT_LSC | INTERRUPT_RXT0 | INTERRUPT_RXDMT0 | INTERRUPT_RXO | INTERRUPT_TXDW);
     in32(REG_INTERRUPT_CAUSE_READ);
 
+    enable_message_signalled_interrupts(pci_address());
     enable_irq();
 }
 
@@ -247,20 +267,25 @@ void E1000NetworkAdapter::handle_irq(const RegisterState&)
 
     m_entropy_source.add_random_event(status);
 
-    if (status & 4) {
+    if (status & INTERRUPT_LSC) {
         u32 flags = in32(REG_CTRL);
         out32(REG_CTRL, flags | ECTRL_SLU);
     }
-    if (status & 0x80) {
-        receive();
-    }
-    if (status & 0x10) {
-        // Threshold OK?
+    if (status & INTERRUPT_TXDW)
+        m_wait_queue.wake_all();
+
+    // With interrupt throttling, a single interrupt usually covers a whole batch of frames.
+    // Copying them out happens in a work queue, and receive interrupts stay masked until then.
+    if (status & (INTERRUPT_RXT0 | INTERRUPT_RXDMT0 | INTERRUPT_RXO)) {
+        out32(REG_INTERRUPT_MASK_SET, INTERRUPT_LSC | INTERRUPT_TXDW);
+        WorkQueue::queue([this] {
+            receive();
+            out32(REG_INTERRUPT_MASK_SET, INTERRUPT_RXT0 | INTERRUPT_RXDMT0 | INTERRUPT_RXO);
+        });
+        return;
     }
 
-    m_wait_queue.wake_all();
-
-    out32(REG_INTERRUPT_MASK_SET, INTERRUPT_LSC | INTERRUPT_RXT0 | INTERRUPT_RXO);
+    out32(REG_INTERRUPT_MASK_SET, INTERRUPT_LSC | INTERRUPT_RXT0 | INTERRUPT_RXDMT0 | INTERRUPT_RXO | INTERRUPT_TXDW);
 }
 
 UNMAP_AFTER_INIT void E1000NetworkAdapter::detect_eeprom()
@@ -319,13 +344,12 @@ bool E1000NetworkAdapter::link_up()
 
 UNMAP_AFTER_INIT void E1000NetworkAdapter::initialize_rx_descriptors()
 {
-    auto* rx_descriptors = (e1000_tx_desc*)m_rx_descriptors_region->vaddr().as_ptr();
+    auto* rx_descriptors = (e1000_rx_desc*)m_rx_descriptors_region->vaddr().as_ptr();
+    m_rx_buffers_region = MM.allocate_contiguous_kernel_region(page_round_up(rx_buffer_size * number_of_rx_descriptors), "E1000 RX buffers", Region::Access::Read | Region::Access::Write);
+    VERIFY(m_rx_buffers_region);
     for (size_t i = 0; i < number_of_rx_descriptors; ++i) {
         auto& descriptor = rx_descriptors[i];
-        auto region = MM.allocate_contiguous_kernel_region(8192, "E1000 RX buffer", Region::Access::Read | Region::Access::Write);
-        VERIFY(region);
-        m_rx_buffers_regions.append(region.release_nonnull());
-        descriptor.addr = m_rx_buffers_regions[i].physical_page(0)->paddr().get();
+        descriptor.addr = m_rx_buffers_region->physical_page(0)->paddr().offset(i * rx_buffer_size).get();
         descriptor.status = 0;
     }
 
@@ -335,19 +359,20 @@ UNMAP_AFTER_INIT void E1000NetworkAdapter::initialize_rx_descriptors()
     out32(REG_RXDESCHEAD, 0);
     out32(REG_RXDESCTAIL, number_of_rx_descriptors - 1);
 
-    out32(REG_RCTRL, RCTL_EN | RCTL_SBP | RCTL_UPE | RCTL_MPE | RCTL_LBM_NONE | RTCL_RDMTS_HALF | RCTL_BAM | RCTL_SECRC | RCTL_BSIZE_8192);
+    out32(REG_RCTRL, RCTL_EN | RCTL_SBP | RCTL_UPE | RCTL_MPE | RCTL_LBM_NONE | RTCL_RDMTS_HALF | RCTL_BAM | RCTL_SECRC | RCTL_BSIZE_2048);
 }
 
 UNMAP_AFTER_INIT void E1000NetworkAdapter::initialize_tx_descriptors()
 {
     auto* tx_descriptors = (e1000_tx_desc*)m_tx_descriptors_region->vaddr().as_ptr();
+    m_tx_buffers_region = MM.allocate_contiguous_kernel_region(page_round_up(tx_buffer_size * number_of_tx_descriptors), "E1000 TX buffers", Region::Access::Read | Region::Access::Write);
+    VERIFY(m_tx_buffers_region);
     for (size_t i = 0; i < number_of_tx_descriptors; ++i) {
         auto& descriptor = tx_descriptors[i];
-        auto region = MM.allocate_contiguous_kernel_region(8192, "E1000 TX buffer", Region::Access::Read | Region::Access::Write);
-        VERIFY(region);
-        m_tx_buffers_regions.append(region.release_nonnull());
-        descriptor.addr = m_tx_buffers_regions[i].physical_page(0)->paddr().get();
+        descriptor.addr = m_tx_buffers_region->physical_page(0)->paddr().offset(i * tx_buffer_size).get();
         descriptor.cmd = 0;
+        // Mark the descriptor as done, so send_raw() knows it's free to use.
+        descriptor.status = TSTA_DD;
     }
 
     out32(REG_TXDESCLO, m_tx_descriptors_region->physical_page(0)->paddr().get());
@@ -417,61 +442,120 @@ u32 E1000NetworkAdapter::in32(u16 address)
     return m_io_base.offset(address).in<u32>();
 }
 
+E1000NetworkAdapter::e1000_tx_desc& E1000NetworkAdapter::wait_for_tx_descriptor(size_t index)
+{
+    VERIFY(m_tx_lock.is_locked());
+    auto& descriptor = ((e1000_tx_desc*)m_tx_descriptors_region->vaddr().as_ptr())[index];
+
+    // We only have to wait when the ring is full, i.e. the descriptor we're about to reuse
+    // hasn't been written back yet. A wakeup that comes in before we block is not lost.
+    while (!(descriptor.status & TSTA_DD)) {
+        dbgln_if(E1000_DEBUG, "E1000: TX ring is full, waiting for descriptor {}", index);
+        m_wait_queue.wait_forever("E1000NetworkAdapter");
+    }
+    return descriptor;
+}
+
+PhysicalAddress E1000NetworkAdapter::copy_to_tx_buffer(size_t index, ReadonlyBytes data)
+{
+    VERIFY(data.size() <= tx_buffer_size);
+    memcpy(m_tx_buffers_region->vaddr().offset(index * tx_buffer_size).as_ptr(), data.data(), data.size());
+    return m_tx_buffers_region->physical_page(0)->paddr().offset(index * tx_buffer_size);
+}
+
 void E1000NetworkAdapter::send_raw(ReadonlyBytes payload)
 {
-    disable_irq();
+    send_raw_with_offload(payload, {});
+}
+
+void E1000NetworkAdapter::send_raw_with_offload(ReadonlyBytes payload, const TransmitOffload& offload)
+{
+    LOCKER(m_tx_lock);
+    if (offload.segment_size) {
+        send_segmented(payload, offload);
+        return;
+    }
+
     size_t tx_current = in32(REG_TXDESCTAIL) % number_of_tx_descriptors;
-#if E1000_DEBUG
-    klog() << "E1000: Sending packet (" << payload.size() << " bytes)";
-#endif
-    auto* tx_descriptors = (e1000_tx_desc*)m_tx_descriptors_region->vaddr().as_ptr();
-    auto& descriptor = tx_descriptors[tx_current];
-    VERIFY(payload.size() <= 8192);
-    auto* vptr = (void*)m_tx_buffers_regions[tx_current].vaddr().as_ptr();
-    memcpy(vptr, payload.data(), payload.size());
+    dbgln_if(E1000_DEBUG, "E1000: Sending packet ({} bytes)", payload.size());
+    auto& descriptor = wait_for_tx_descriptor(tx_current);
+
+    // A context descriptor may have used this slot last, so the buffer address has to be set again.
+    descriptor.addr = copy_to_tx_buffer(tx_current, payload).get();
     descriptor.length = payload.size();
     descriptor.status = 0;
     descriptor.cmd = CMD_EOP | CMD_IFCS | CMD_RS;
-#if E1000_DEBUG
-    klog() << "E1000: Using tx descriptor " << tx_current << " (head is at " << in32(REG_TXDESCHEAD) << ")";
-#endif
+    descriptor.cso = 0;
+    descriptor.css = 0;
+    if (offload.needs_checksum) {
+        // The legacy descriptor can checksum from css to the end of the packet, which is all TCP needs.
+        descriptor.css = offload.checksum_start;
+        descriptor.cso = offload.checksum_start + offload.checksum_offset;
+        descriptor.cmd = descriptor.cmd | CMD_IC;
+    }
+    dbgln_if(E1000_DEBUG, "E1000: Using tx descriptor {} (head is at {})", tx_current, in32(REG_TXDESCHEAD));
+    out32(REG_TXDESCTAIL, (tx_current + 1) % number_of_tx_descriptors);
+}
+
+void E1000NetworkAdapter::send_segmented(ReadonlyBytes payload, const TransmitOffload& offload)
+{
+    VERIFY(payload.size() <= sizeof(EthernetFrameHeader) + max_segmentation_size);
+    VERIFY(offload.header_size < payload.size());
+    dbgln_if(E1000_DEBUG, "E1000: Sending {} bytes in segments of {}", payload.size(), offload.segment_size);
+
+    constexpr u8 ip_header_start = sizeof(EthernetFrameHeader);
+    size_t tx_current = in32(REG_TXDESCTAIL) % number_of_tx_descriptors;
+
+    // The context descriptor tells the hardware where the headers are, and how to cut the payload.
+    auto& context = (e1000_tx_context_desc&)wait_for_tx_descriptor(tx_current);
+    context.ipcss = ip_header_start;
+    context.ipcso = ip_header_start + 10;
+    context.ipcse = ip_header_start + sizeof(IPv4Packet) - 1;
+    context.tucss = offload.checksum_start;
+    context.tucso = offload.checksum_start + offload.checksum_offset;
+    context.tucse = 0;
+    context.paylen_dtyp_tucmd = (payload.size() - offload.header_size) | TDESC_DTYP_CONTEXT | TUCMD_DEXT | TUCMD_TSE | TUCMD_IP | TUCMD_TCP | TUCMD_RS;
+    context.hdrlen = offload.header_size;
+    context.mss = offload.segment_size;
+    context.status = 0;
     tx_current = (tx_current + 1) % number_of_tx_descriptors;
-    cli();
-    enable_irq();
-    out32(REG_TXDESCTAIL, tx_current);
-    for (;;) {
-        if (descriptor.status) {
-            sti();
-            break;
-        }
-        m_wait_queue.wait_forever("E1000NetworkAdapter");
+
+    for (size_t offset = 0; offset < payload.size(); offset += tx_buffer_size) {
+        auto chunk = payload.slice(offset, min(tx_buffer_size, payload.size() - offset));
+        bool is_last = offset + chunk.size() == payload.size();
+        auto& descriptor = (e1000_tx_data_desc&)wait_for_tx_descriptor(tx_current);
+        descriptor.addr = copy_to_tx_buffer(tx_current, chunk).get();
+        descriptor.length_dtyp_dcmd = chunk.size() | TDESC_DTYP_DATA | DCMD_DEXT | DCMD_IFCS | DCMD_TSE | DCMD_RS | (is_last ? DCMD_EOP : 0);
+        descriptor.popts = POPTS_IXSM | POPTS_TXSM;
+        descriptor.status = 0;
+        tx_current = (tx_current + 1) % number_of_tx_descriptors;
     }
-#if E1000_DEBUG
-    dbgln("E1000: Sent packet, status is now {:#02x}!", (u8)descriptor.status);
-#endif
+
+    // Hand the whole chain to the hardware at once.
+    out32(REG_TXDESCTAIL, tx_current);
 }
 
 void E1000NetworkAdapter::receive()
 {
-    auto* rx_descriptors = (e1000_tx_desc*)m_rx_descriptors_region->vaddr().as_ptr();
-    u32 rx_current;
+    auto* rx_descriptors = (e1000_rx_desc*)m_rx_descriptors_region->vaddr().as_ptr();
+    u32 rx_current = in32(REG_RXDESCTAIL) % number_of_rx_descriptors;
+    size_t received_count = 0;
     for (;;) {
-        rx_current = in32(REG_RXDESCTAIL) % number_of_rx_descriptors;
-        if (rx_current == (in32(REG_RXDESCHEAD) % number_of_rx_descriptors))
-            return;
-        rx_current = (rx_current + 1) % number_of_rx_descriptors;
-        if (!(rx_descriptors[rx_current].status & 1))
+        u32 rx_next = (rx_current + 1) % number_of_rx_descriptors;
+        if (!(rx_descriptors[rx_next].status & 1))
             break;
-        auto* buffer = m_rx_buffers_regions[rx_current].vaddr().as_ptr();
+        rx_current = rx_next;
+        auto* buffer = m_rx_buffers_region->vaddr().offset(rx_current * rx_buffer_size).as_ptr();
         u16 length = rx_descriptors[rx_current].length;
-        VERIFY(length <= 8192);
-#if E1000_DEBUG
-        klog() << "E1000: Received 1 packet @ " << buffer << " (" << length << ") bytes!";
-#endif
+        VERIFY(length <= rx_buffer_size);
+        dbgln_if(E1000_DEBUG, "E1000: Received 1 packet @ {} ({} bytes)", buffer, length);
         did_receive({ buffer, length });
         rx_descriptors[rx_current].status = 0;
-        out32(REG_RXDESCTAIL, rx_current);
+        ++received_count;
     }
+    // Hand the whole batch of descriptors back to the hardware with a single register write.
+    if (received_count)
+        out32(REG_RXDESCTAIL, rx_current);
 }
 
 }
@@ -26,10 +26,10 @@
 
 #pragma once
 
-#include <AK/NonnullOwnPtrVector.h>
 #include <AK/OwnPtr.h>
 #include <Kernel/IO.h>
 #include <Kernel/Interrupts/IRQHandler.h>
+#include <Kernel/Lock.h>
 #include <Kernel/Net/NetworkAdapter.h>
 #include <Kernel/PCI/Access.h>
 #include <Kernel/PCI/Device.h>
@@ -46,6 +46,7 @@ public:
     virtual ~E1000NetworkAdapter() override;
 
     virtual void send_raw(ReadonlyBytes) override;
+    virtual void send_raw_with_offload(ReadonlyBytes, const TransmitOffload&) override;
     virtual bool link_up() override;
 
     virtual const char* purpose() const override { return class_name(); }
@@ -73,6 +74,32 @@ private:
         volatile uint16_t special { 0 };
     };
 
+    // Overlays on e1000_tx_desc for the extended descriptors used by checksum and segmentation offload.
+    // All of them keep the status byte at the same place as the legacy descriptor.
+    struct [[gnu::packed]] e1000_tx_context_desc {
+        volatile uint8_t ipcss { 0 };
+        volatile uint8_t ipcso { 0 };
+        volatile uint16_t ipcse { 0 };
+        volatile uint8_t tucss { 0 };
+        volatile uint8_t tucso { 0 };
+        volatile uint16_t tucse { 0 };
+        volatile uint32_t paylen_dtyp_tucmd { 0 };
+        volatile uint8_t status { 0 };
+        volatile uint8_t hdrlen { 0 };
+        volatile uint16_t mss { 0 };
+    };
+
+    struct [[gnu::packed]] e1000_tx_data_desc {
+        volatile uint64_t addr { 0 };
+        volatile uint32_t length_dtyp_dcmd { 0 };
+        volatile uint8_t status { 0 };
+        volatile uint8_t popts { 0 };
+        volatile uint16_t special { 0 };
+    };
+
+    static_assert(sizeof(e1000_tx_context_desc) == sizeof(e1000_tx_desc));
+    static_assert(sizeof(e1000_tx_data_desc) == sizeof(e1000_tx_desc));
+
     void detect_eeprom();
     u32 read_eeprom(u8 address);
     void read_mac_address();
@@ -83,6 +110,10 @@ private:
     void initialize_rx_descriptors();
     void initialize_tx_descriptors();
 
+    e1000_tx_desc& wait_for_tx_descriptor(size_t index);
+    PhysicalAddress copy_to_tx_buffer(size_t index, ReadonlyBytes);
+    void send_segmented(ReadonlyBytes, const TransmitOffload&);
+
     void out8(u16 address, u8);
     void out16(u16 address, u16);
     void out32(u16 address, u32);
@@ -96,17 +127,31 @@ private:
     VirtualAddress m_mmio_base;
     OwnPtr<Region> m_rx_descriptors_region;
     OwnPtr<Region> m_tx_descriptors_region;
-    NonnullOwnPtrVector<Region> m_rx_buffers_regions;
-    NonnullOwnPtrVector<Region> m_tx_buffers_regions;
+    OwnPtr<Region> m_rx_buffers_region;
+    OwnPtr<Region> m_tx_buffers_region;
     OwnPtr<Region> m_mmio_region;
     u8 m_interrupt_line { 0 };
     bool m_has_eeprom { false };
     bool m_use_mmio { false };
     EntropySource m_entropy_source;
 
-    static const size_t number_of_rx_descriptors = 32;
-    static const size_t number_of_tx_descriptors = 8;
+    // The descriptor rings must be a multiple of 128 bytes long, i.e. hold a multiple of 8 descriptors.
+    static constexpr size_t number_of_rx_descriptors = 256;
+    static constexpr size_t number_of_tx_descriptors = 256;
+    static_assert(number_of_rx_descriptors % 8 == 0 && number_of_tx_descriptors % 8 == 0);
+
+    // Long packet reception is off, so no frame is larger than 1522 bytes.
+    static constexpr size_t rx_buffer_size = 2048;
+    static constexpr size_t tx_buffer_size = 2048;
+
+    // A segmentation offload frame takes a context descriptor, plus a data descriptor per TX buffer.
+    static constexpr size_t max_segmentation_size = 32 * KiB;
+    static_assert(max_segmentation_size / tx_buffer_size + 2 < number_of_tx_descriptors);
+
+    // Interrupt throttling interval in units of 256 ns, limiting us to about 8000 interrupts per second.
+    static constexpr u32 interrupt_throttle_interval = 488;
 
+    Lock m_tx_lock { "E1000NetworkAdapter TX" };
     WaitQueue m_wait_queue;
 };
 }
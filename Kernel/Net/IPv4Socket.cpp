@@ -68,9 +68,6 @@ IPv4Socket::IPv4Socket(int type, int protocol)
 {
     dbgln_if(IPV4_SOCKET_DEBUG, "IPv4Socket({}) created with type={}, protocol={}", this, type, protocol);
     m_buffer_mode = type == SOCK_STREAM ? BufferMode::Bytes : BufferMode::Packets;
-    if (m_buffer_mode == BufferMode::Bytes) {
-        m_scratch_buffer = KBuffer::create_with_size(65536);
-    }
     LOCKER(all_sockets().lock());
     all_sockets().resource().set(this);
 }
@@ -237,13 +234,13 @@ KResultOr<size_t> IPv4Socket::sendto(FileDescription&, const UserOrKernelBuffer&
     return nsent_or_error;
 }
 
-KResultOr<size_t> IPv4Socket::receive_byte_buffered(FileDescription& description, UserOrKernelBuffer& buffer, size_t buffer_length, int, Userspace<sockaddr*>, Userspace<socklen_t*>)
+KResultOr<size_t> IPv4Socket::receive_byte_buffered(FileDescription& description, UserOrKernelBuffer& buffer, size_t buffer_length, int flags, Userspace<sockaddr*>, Userspace<socklen_t*>)
 {
     Locker locker(lock());
     if (m_receive_buffer.is_empty()) {
         if (protocol_is_disconnected())
             return 0;
-        if (!description.is_blocking())
+        if (!description.is_blocking() || (flags & MSG_DONTWAIT))
             return EAGAIN;
 
         locker.unlock();
@@ -262,8 +259,10 @@ KResultOr<size_t> IPv4Socket::receive_byte_buffered(FileDescription& description
 
     VERIFY(!m_receive_buffer.is_empty());
     int nreceived = m_receive_buffer.read(buffer, buffer_length);
-    if (nreceived > 0)
+    if (nreceived > 0) {
         Thread::current()->did_ipv4_socket_read((size_t)nreceived);
+        protocol_did_read_from_receive_buffer();
+    }
 
     set_can_read(!m_receive_buffer.is_empty());
     return nreceived;
@@ -279,7 +278,7 @@ KResultOr<size_t> IPv4Socket::receive_packet_buffered(FileDescription& descripti
             //        But if so, we still need to deliver at least one EOF read to userspace.. right?
             if (protocol_is_disconnected())
                 return 0;
-            if (!description.is_blocking())
+            if (!description.is_blocking() || (flags & MSG_DONTWAIT))
                 return EAGAIN;
         }
 
@@ -289,11 +288,11 @@ KResultOr<size_t> IPv4Socket::receive_packet_buffered(FileDescription& descripti
 
             dbgln_if(IPV4_SOCKET_DEBUG, "IPv4Socket({}): recvfrom without blocking {} bytes, packets in queue: {}",
                 this,
-                packet.data.value().size(),
+                packet.data->size(),
                 m_receive_queue.size());
         }
     }
-    if (!packet.data.has_value()) {
+    if (!packet.data) {
         if (protocol_is_disconnected()) {
             dbgln("IPv4Socket({}) is protocol-disconnected, returning 0 in recvfrom!", this);
             return 0;
@@ -318,10 +317,10 @@ KResultOr<size_t> IPv4Socket::receive_packet_buffered(FileDescription& descripti
 
         dbgln_if(IPV4_SOCKET_DEBUG, "IPv4Socket({}): recvfrom with blocking {} bytes, packets in queue: {}",
             this,
-            packet.data.value().size(),
+            packet.data->size(),
             m_receive_queue.size());
     }
-    VERIFY(packet.data.has_value());
+    VERIFY(packet.data);
 
     packet_timestamp = packet.timestamp;
 
@@ -343,13 +342,13 @@ KResultOr<size_t> IPv4Socket::receive_packet_buffered(FileDescription& descripti
     }
 
     if (type() == SOCK_RAW) {
-        size_t bytes_written = min(packet.data.value().size(), buffer_length);
-        if (!buffer.write(packet.data.value().data(), bytes_written))
+        size_t bytes_written = min(packet.data->size(), buffer_length);
+        if (!buffer.write(packet.data->data(), bytes_written))
             return EFAULT;
         return bytes_written;
     }
 
-    return protocol_receive(ReadonlyBytes { packet.data.value().data(), packet.data.value().size() }, buffer, buffer_length, flags);
+    return protocol_receive(packet.data->bytes(), buffer, buffer_length, flags);
 }
 
 KResultOr<size_t> IPv4Socket::recvfrom(FileDescription& description, UserOrKernelBuffer& buffer, size_t buffer_length, int flags, Userspace<sockaddr*> user_addr, Userspace<socklen_t*> user_addr_length, timeval& packet_timestamp)
@@ -377,27 +376,25 @@ KResultOr<size_t> IPv4Socket::recvfrom(FileDescription& description, UserOrKerne
     return nreceived;
 }
 
-bool IPv4Socket::did_receive(const IPv4Address& source_address, u16 source_port, KBuffer&& packet, const timeval& packet_timestamp)
+bool IPv4Socket::did_receive(const IPv4Address& source_address, u16 source_port, NonnullRefPtr<PacketBuffer> packet, const timeval& packet_timestamp)
 {
     LOCKER(lock());
 
     if (is_shut_down_for_reading())
         return false;
 
-    auto packet_size = packet.size();
+    auto packet_size = packet->size();
 
     if (buffer_mode() == BufferMode::Bytes) {
+        // Append the payload to the stream straight from the packet buffer.
+        auto payload = protocol_payload(packet->bytes());
         size_t space_in_receive_buffer = m_receive_buffer.space_for_writing();
-        if (packet_size > space_in_receive_buffer) {
+        if (payload.size() > space_in_receive_buffer) {
             dbgln("IPv4Socket({}): did_receive refusing packet since buffer is full.", this);
             VERIFY(m_can_read);
             return false;
         }
-        auto scratch_buffer = UserOrKernelBuffer::for_kernel_buffer(m_scratch_buffer.value().data());
-        auto nreceived_or_error = protocol_receive(ReadonlyBytes { packet.data(), packet.size() }, scratch_buffer, m_scratch_buffer.value().size(), 0);
-        if (nreceived_or_error.is_error())
-            return false;
-        ssize_t nwritten = m_receive_buffer.write(scratch_buffer, nreceived_or_error.value());
+        ssize_t nwritten = m_receive_buffer.write(payload.data(), payload.size());
         if (nwritten < 0)
             return false;
         set_can_read(!m_receive_buffer.is_empty());
@@ -425,6 +422,24 @@ bool IPv4Socket::did_receive(const IPv4Address& source_address, u16 source_port,
     return true;
 }
 
+KResultOr<size_t> IPv4Socket::receive_bytes_directly(const UserOrKernelBuffer& data, size_t data_length)
+{
+    VERIFY(lock().is_locked());
+    VERIFY(buffer_mode() == BufferMode::Bytes);
+
+    if (is_shut_down_for_reading())
+        return 0;
+    ssize_t nwritten = m_receive_buffer.write(data, data_length);
+    if (nwritten < 0)
+        return KResult((ErrnoCode)-nwritten);
+    if (nwritten == 0)
+        return 0;
+    m_bytes_received += nwritten;
+    set_can_read(true);
+    dbgln_if(IPV4_SOCKET_DEBUG, "IPv4Socket({}): received {} bytes directly, total_received={}", this, nwritten, m_bytes_received);
+    return (size_t)nwritten;
+}
+
 String IPv4Socket::absolute_path(const FileDescription&) const
 {
     if (m_role == Role::None)
@@ -29,10 +29,10 @@
 #include <AK/HashMap.h>
 #include <AK/SinglyLinkedListWithCount.h>
 #include <Kernel/DoubleBuffer.h>
-#include <Kernel/KBuffer.h>
 #include <Kernel/Lock.h>
 #include <Kernel/Net/IPv4.h>
 #include <Kernel/Net/IPv4SocketTuple.h>
+#include <Kernel/Net/PacketBuffer.h>
 #include <Kernel/Net/Socket.h>
 
 namespace Kernel {
@@ -63,7 +63,7 @@ public:
 
     virtual int ioctl(FileDescription&, unsigned request, FlatPtr arg) override;
 
-    bool did_receive(const IPv4Address& peer_address, u16 peer_port, KBuffer&&, const timeval&);
+    bool did_receive(const IPv4Address& peer_address, u16 peer_port, NonnullRefPtr<PacketBuffer>, const timeval&);
 
     const IPv4Address& local_address() const { return m_local_address; }
     u16 local_port() const { return m_local_port; }
@@ -95,10 +95,19 @@ protected:
     virtual KResult protocol_bind() { return KSuccess; }
     virtual KResult protocol_listen() { return KSuccess; }
     virtual KResultOr<size_t> protocol_receive(ReadonlyBytes /* raw_ipv4_packet */, UserOrKernelBuffer&, size_t, int) { return -ENOTIMPL; }
+    // The part of a raw IPv4 packet that's appended to the stream of a byte-buffered socket.
+    virtual ReadonlyBytes protocol_payload(ReadonlyBytes /* raw_ipv4_packet */) const { return {}; }
     virtual KResultOr<size_t> protocol_send(const UserOrKernelBuffer&, size_t) { return -ENOTIMPL; }
     virtual KResult protocol_connect(FileDescription&, ShouldBlock) { return KSuccess; }
     virtual int protocol_allocate_local_port() { return 0; }
     virtual bool protocol_is_disconnected() const { return false; }
+    virtual void protocol_did_read_from_receive_buffer() { }
+
+    size_t receive_buffer_capacity() const { return m_receive_buffer.capacity(); }
+    size_t receive_buffer_space() const { return m_receive_buffer.space_for_writing(); }
+
+    // Appends to the byte stream directly, for data that never went through a packet.
+    KResultOr<size_t> receive_bytes_directly(const UserOrKernelBuffer&, size_t);
 
     virtual void shut_down_for_reading() override;
 
@@ -120,7 +129,7 @@ private:
         IPv4Address peer_address;
         u16 peer_port;
         timeval timestamp;
-        Optional<KBuffer> data;
+        RefPtr<PacketBuffer> data;
     };
 
     SinglyLinkedListWithCount<ReceivedPacket> m_receive_queue;
@@ -137,8 +146,6 @@ private:
     bool m_can_read { false };
 
     BufferMode m_buffer_mode { BufferMode::Packets };
-
-    Optional<KBuffer> m_scratch_buffer;
 };
 
 }
@@ -307,12 +307,12 @@ DoubleBuffer* LocalSocket::send_buffer_for(FileDescription& description)
     return nullptr;
 }
 
-KResultOr<size_t> LocalSocket::recvfrom(FileDescription& description, UserOrKernelBuffer& buffer, size_t buffer_size, int, Userspace<sockaddr*>, Userspace<socklen_t*>, timeval&)
+KResultOr<size_t> LocalSocket::recvfrom(FileDescription& description, UserOrKernelBuffer& buffer, size_t buffer_size, int flags, Userspace<sockaddr*>, Userspace<socklen_t*>, timeval&)
 {
     auto* socket_buffer = receive_buffer_for(description);
     if (!socket_buffer)
         return EINVAL;
-    if (!description.is_blocking()) {
+    if (!description.is_blocking() || (flags & MSG_DONTWAIT)) {
         if (socket_buffer->is_empty()) {
             if (!has_attached_peer(description))
                 return 0;
@@ -375,9 +375,20 @@ KResult LocalSocket::getsockopt(FileDescription& description, int level, int opt
 
     switch (option) {
     case SO_SNDBUF:
-        TODO();
-    case SO_RCVBUF:
-        TODO();
+    case SO_RCVBUF: {
+        if (size < sizeof(int))
+            return EINVAL;
+        auto* buffer = option == SO_SNDBUF ? send_buffer_for(description) : receive_buffer_for(description);
+        if (!buffer)
+            return ENOTCONN;
+        int capacity = buffer->capacity();
+        if (!copy_to_user(static_ptr_cast<int*>(value), &capacity))
+            return EFAULT;
+        size = sizeof(int);
+        if (!copy_to_user(value_size, &size))
+            return EFAULT;
+        return KSuccess;
+    }
     case SO_PEERCRED: {
         if (size < sizeof(ucred))
             return EINVAL;
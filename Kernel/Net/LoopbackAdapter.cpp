@@ -25,6 +25,7 @@
  */
 
 #include <AK/Singleton.h>
+#include <Kernel/Debug.h>
 #include <Kernel/Net/LoopbackAdapter.h>
 
 namespace Kernel {
@@ -41,6 +42,8 @@ LoopbackAdapter::LoopbackAdapter()
     set_interface_name("loop");
     set_mtu(65536);
     set_mac_address({ 19, 85, 2, 9, 0x55, 0xaa });
+    // Nothing on the receiving side verifies checksums, so there's no reason to compute them.
+    set_offloads(NetworkOffload::TransmitChecksum);
 }
 
 LoopbackAdapter::~LoopbackAdapter()
@@ -49,8 +52,13 @@ LoopbackAdapter::~LoopbackAdapter()
 
 void LoopbackAdapter::send_raw(ReadonlyBytes payload)
 {
-    dbgln("LoopbackAdapter: Sending {} byte(s) to myself.", payload.size());
+    dbgln_if(LOOPBACK_DEBUG, "LoopbackAdapter: Sending {} byte(s) to myself.", payload.size());
     did_receive(payload);
 }
 
+void LoopbackAdapter::send_raw_with_offload(ReadonlyBytes payload, const TransmitOffload&)
+{
+    send_raw(payload);
+}
+
 }
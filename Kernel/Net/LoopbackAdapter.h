@@ -39,6 +39,7 @@ public:
     virtual ~LoopbackAdapter() override;
 
     virtual void send_raw(ReadonlyBytes) override;
+    virtual void send_raw_with_offload(ReadonlyBytes, const TransmitOffload&) override;
     virtual const char* class_name() const override { return "LoopbackAdapter"; }
 };
 
@@ -33,6 +33,7 @@
 #include <Kernel/Net/EthernetFrameHeader.h>
 #include <Kernel/Net/LoopbackAdapter.h>
 #include <Kernel/Net/NetworkAdapter.h>
+#include <Kernel/Net/Routing.h>
 #include <Kernel/Process.h>
 #include <Kernel/Random.h>
 #include <Kernel/StdLib.h>
@@ -79,12 +80,14 @@ NetworkAdapter::NetworkAdapter()
 {
     // FIXME: I wanna lock :(
     all_adapters().resource().set(this);
+    invalidate_route_cache();
 }
 
 NetworkAdapter::~NetworkAdapter()
 {
     // FIXME: I wanna lock :(
     all_adapters().resource().remove(this);
+    invalidate_route_cache();
 }
 
 void NetworkAdapter::send(const MACAddress& destination, const ARPPacket& packet)
@@ -101,19 +104,31 @@ void NetworkAdapter::send(const MACAddress& destination, const ARPPacket& packet
     send_raw({ (const u8*)eth, size_in_bytes });
 }
 
-KResult NetworkAdapter::send_ipv4(const MACAddress& destination_mac, const IPv4Address& destination_ipv4, IPv4Protocol protocol, const UserOrKernelBuffer& payload, size_t payload_size, u8 ttl)
+KResult NetworkAdapter::send_ipv4(const MACAddress& destination_mac, const IPv4Address& destination_ipv4, IPv4Protocol protocol, const UserOrKernelBuffer& payload, size_t payload_size, u8 ttl, const TransmitOffload& offload)
 {
+    VERIFY(!offload.needs_checksum || has_offload(NetworkOffload::TransmitChecksum) || offload.segment_size);
+    VERIFY(!offload.segment_size || has_offload(NetworkOffload::TCPSegmentation));
+
     size_t ipv4_packet_size = sizeof(IPv4Packet) + payload_size;
-    if (ipv4_packet_size > mtu())
+    if (offload.segment_size) {
+        if (ipv4_packet_size > max_segmentation_size())
+            return EMSGSIZE;
+    } else if (ipv4_packet_size > mtu()) {
+        // The fragments would each need a checksum over the reassembled payload.
+        VERIFY(!offload.needs_checksum);
         return send_ipv4_fragmented(destination_mac, destination_ipv4, protocol, payload, payload_size, ttl);
+    }
 
-    size_t ethernet_frame_size = sizeof(EthernetFrameHeader) + sizeof(IPv4Packet) + payload_size;
-    auto buffer = ByteBuffer::create_zeroed(ethernet_frame_size);
-    auto& eth = *(EthernetFrameHeader*)buffer.data();
-    eth.set_source(mac_address());
-    eth.set_destination(destination_mac);
-    eth.set_ether_type(EtherType::IPv4);
-    auto& ipv4 = *(IPv4Packet*)eth.payload();
+    // Read the payload straight into place and prepend the headers into the headroom.
+    auto packet = PacketBuffer::try_create(payload_size, sizeof(EthernetFrameHeader) + sizeof(IPv4Packet));
+    if (!packet)
+        return ENOMEM;
+    if (!payload.read(packet->data(), payload_size))
+        return EFAULT;
+
+    auto* ipv4_bytes = packet->push(sizeof(IPv4Packet));
+    memset(ipv4_bytes, 0, sizeof(IPv4Packet));
+    auto& ipv4 = *(IPv4Packet*)ipv4_bytes;
     ipv4.set_version(4);
     ipv4.set_internet_header_length(5);
     ipv4.set_source(ipv4_address());
@@ -123,12 +138,27 @@ KResult NetworkAdapter::send_ipv4(const MACAddress& destination_mac, const IPv4A
     ipv4.set_ident(1);
     ipv4.set_ttl(ttl);
     ipv4.set_checksum(ipv4.compute_checksum());
+
+    auto* eth_bytes = packet->push(sizeof(EthernetFrameHeader));
+    memset(eth_bytes, 0, sizeof(EthernetFrameHeader));
+    auto& eth = *(EthernetFrameHeader*)eth_bytes;
+    eth.set_source(mac_address());
+    eth.set_destination(destination_mac);
+    eth.set_ether_type(EtherType::IPv4);
     m_packets_out++;
-    m_bytes_out += ethernet_frame_size;
+    m_bytes_out += packet->size();
 
-    if (!payload.read(ipv4.payload(), payload_size))
-        return EFAULT;
-    send_raw({ (const u8*)&eth, ethernet_frame_size });
+    if (!offload.needs_checksum && !offload.segment_size) {
+        send_raw(packet->bytes());
+        return KSuccess;
+    }
+
+    constexpr u16 headers_size = sizeof(EthernetFrameHeader) + sizeof(IPv4Packet);
+    TransmitOffload frame_offload = offload;
+    frame_offload.checksum_start += headers_size;
+    if (frame_offload.segment_size)
+        frame_offload.header_size += headers_size;
+    send_raw_with_offload(packet->bytes(), frame_offload);
     return KSuccess;
 }
 
@@ -174,62 +204,56 @@ KResult NetworkAdapter::send_ipv4_fragmented(const MACAddress& destination_mac,
 
 void NetworkAdapter::did_receive(ReadonlyBytes payload)
 {
-    InterruptDisabler disabler;
-    m_packets_in++;
-    m_bytes_in += payload.size();
-
-    Optional<KBuffer> buffer;
-
-    if (m_unused_packet_buffers.is_empty()) {
-        buffer = KBuffer::copy(payload.data(), payload.size());
-    } else {
-        buffer = m_unused_packet_buffers.take_first();
-        --m_unused_packet_buffers_count;
-        if (payload.size() <= buffer.value().capacity()) {
-            memcpy(buffer.value().data(), payload.data(), payload.size());
-            buffer.value().set_size(payload.size());
-        } else {
-            buffer = KBuffer::copy(payload.data(), payload.size());
-        }
+    // This is the only time the frame gets copied on its way to the sockets.
+    auto packet = PacketBuffer::try_create(payload.size());
+    if (!packet) {
+        dbgln("NetworkAdapter: Dropping packet of {} bytes, no memory for a packet buffer", payload.size());
+        return;
     }
+    memcpy(packet->data(), payload.data(), payload.size());
+
+    bool was_empty;
+    {
+        ScopedSpinLock lock(m_packet_queue_lock);
+        m_packets_in++;
+        m_bytes_in += payload.size();
 
-    m_packet_queue.append({ buffer.value(), kgettimeofday() });
+        // Only notify when the queue goes from empty to non-empty: the consumer drains all
+        // queued packets per wakeup, so a burst of frames costs a single wakeup.
+        was_empty = m_packet_queue.is_empty();
+        m_packet_queue.append({ packet.release_nonnull(), kgettimeofday() });
+    }
 
-    if (on_receive)
+    if (was_empty && on_receive)
         on_receive();
 }
 
-size_t NetworkAdapter::dequeue_packet(u8* buffer, size_t buffer_size, timeval& packet_timestamp)
+RefPtr<PacketBuffer> NetworkAdapter::dequeue_packet(timeval& packet_timestamp)
 {
-    InterruptDisabler disabler;
+    ScopedSpinLock lock(m_packet_queue_lock);
     if (m_packet_queue.is_empty())
-        return 0;
+        return {};
     auto packet_with_timestamp = m_packet_queue.take_first();
     packet_timestamp = packet_with_timestamp.timestamp;
-    auto packet = move(packet_with_timestamp.packet);
-    size_t packet_size = packet.size();
-    VERIFY(packet_size <= buffer_size);
-    memcpy(buffer, packet.data(), packet_size);
-    if (m_unused_packet_buffers_count < 100) {
-        m_unused_packet_buffers.append(packet);
-        ++m_unused_packet_buffers_count;
-    }
-    return packet_size;
+    return move(packet_with_timestamp.packet);
 }
 
 void NetworkAdapter::set_ipv4_address(const IPv4Address& address)
 {
     m_ipv4_address = address;
+    invalidate_route_cache();
 }
 
 void NetworkAdapter::set_ipv4_netmask(const IPv4Address& netmask)
 {
     m_ipv4_netmask = netmask;
+    invalidate_route_cache();
 }
 
 void NetworkAdapter::set_ipv4_gateway(const IPv4Address& gateway)
 {
     m_ipv4_gateway = gateway;
+    invalidate_route_cache();
 }
 
 void NetworkAdapter::set_interface_name(const StringView& basename)
@@ -33,16 +33,39 @@
 #include <AK/Types.h>
 #include <AK/WeakPtr.h>
 #include <AK/Weakable.h>
-#include <Kernel/KBuffer.h>
 #include <Kernel/Net/ARP.h>
 #include <Kernel/Net/ICMP.h>
 #include <Kernel/Net/IPv4.h>
+#include <Kernel/Net/PacketBuffer.h>
+#include <Kernel/SpinLock.h>
 #include <Kernel/UserOrKernelBuffer.h>
 
 namespace Kernel {
 
 class NetworkAdapter;
 
+struct NetworkOffload {
+    enum : u32 {
+        None = 0,
+        // The adapter fills in the TCP checksum, starting from the pseudo-header sum we leave in the checksum field.
+        TransmitChecksum = 1 << 0,
+        // The adapter cuts one large TCP packet into MSS-sized segments, fixing up the IPv4 and TCP
+        // headers of each. The checksum field holds the pseudo-header sum without the length.
+        TCPSegmentation = 1 << 1,
+    };
+};
+
+// Work left to the adapter for a single outgoing frame. Offsets are from the start of the frame,
+// except when passed to send_ipv4(), which takes them relative to the IPv4 payload.
+struct TransmitOffload {
+    bool needs_checksum { false };
+    u16 checksum_start { 0 };
+    u16 checksum_offset { 0 };
+    // Non-zero for TCP segmentation: everything after the first header_size bytes is cut into segments of this size.
+    u16 segment_size { 0 };
+    u16 header_size { 0 };
+};
+
 class NetworkAdapter : public RefCounted<NetworkAdapter> {
 public:
     static void for_each(Function<void(NetworkAdapter&)>);
@@ -64,16 +87,20 @@ public:
     void set_ipv4_gateway(const IPv4Address&);
 
     void send(const MACAddress&, const ARPPacket&);
-    KResult send_ipv4(const MACAddress&, const IPv4Address&, IPv4Protocol, const UserOrKernelBuffer& payload, size_t payload_size, u8 ttl);
+    KResult send_ipv4(const MACAddress&, const IPv4Address&, IPv4Protocol, const UserOrKernelBuffer& payload, size_t payload_size, u8 ttl, const TransmitOffload& = {});
     KResult send_ipv4_fragmented(const MACAddress&, const IPv4Address&, IPv4Protocol, const UserOrKernelBuffer& payload, size_t payload_size, u8 ttl);
 
-    size_t dequeue_packet(u8* buffer, size_t buffer_size, timeval& packet_timestamp);
+    RefPtr<PacketBuffer> dequeue_packet(timeval& packet_timestamp);
 
     bool has_queued_packets() const { return !m_packet_queue.is_empty(); }
 
     u32 mtu() const { return m_mtu; }
     void set_mtu(u32 mtu) { m_mtu = mtu; }
 
+    bool has_offload(u32 offload) const { return (m_offloads & offload) == offload; }
+    // The largest IPv4 packet the adapter accepts for TCP segmentation.
+    size_t max_segmentation_size() const { return m_max_segmentation_size; }
+
     u32 packets_in() const { return m_packets_in; }
     u32 bytes_in() const { return m_bytes_in; }
     u32 packets_out() const { return m_packets_out; }
@@ -86,6 +113,14 @@ protected:
     void set_interface_name(const StringView& basename);
     void set_mac_address(const MACAddress& mac_address) { m_mac_address = mac_address; }
     virtual void send_raw(ReadonlyBytes) = 0;
+    // Only called with the offloads the adapter enabled through set_offloads().
+    virtual void send_raw_with_offload(ReadonlyBytes, const TransmitOffload&) { VERIFY_NOT_REACHED(); }
+    void set_offloads(u32 offloads, size_t max_segmentation_size = 0)
+    {
+        VERIFY(!(offloads & NetworkOffload::TCPSegmentation) || max_segmentation_size > mtu());
+        m_offloads = offloads;
+        m_max_segmentation_size = max_segmentation_size;
+    }
     void did_receive(ReadonlyBytes);
 
 private:
@@ -95,19 +130,21 @@ private:
     IPv4Address m_ipv4_gateway;
 
     struct PacketWithTimestamp {
-        KBuffer packet;
+        NonnullRefPtr<PacketBuffer> packet;
         timeval timestamp;
     };
 
+    // Packets may be received on any processor, see WorkQueue.
+    SpinLock<u8> m_packet_queue_lock;
     SinglyLinkedList<PacketWithTimestamp> m_packet_queue;
-    SinglyLinkedList<KBuffer> m_unused_packet_buffers;
-    size_t m_unused_packet_buffers_count { 0 };
     String m_name;
     u32 m_packets_in { 0 };
     u32 m_bytes_in { 0 };
     u32 m_packets_out { 0 };
     u32 m_bytes_out { 0 };
     u32 m_mtu { 1500 };
+    u32 m_offloads { NetworkOffload::None };
+    size_t m_max_segmentation_size { 0 };
 };
 
 }
@@ -25,6 +25,7 @@
  */
 
 #include <Kernel/Debug.h>
+#include <Kernel/FileSystem/ProcFS.h>
 #include <Kernel/Lock.h>
 #include <Kernel/Net/ARP.h>
 #include <Kernel/Net/EtherType.h>
@@ -40,17 +41,20 @@
 #include <Kernel/Net/UDP.h>
 #include <Kernel/Net/UDPSocket.h>
 #include <Kernel/Process.h>
+#include <Kernel/Time/TimeManagement.h>
 
 namespace Kernel {
 
 static void handle_arp(const EthernetFrameHeader&, size_t frame_size);
-static void handle_ipv4(const EthernetFrameHeader&, size_t frame_size, const timeval& packet_timestamp);
-static void handle_icmp(const EthernetFrameHeader&, const IPv4Packet&, const timeval& packet_timestamp);
-static void handle_udp(const IPv4Packet&, const timeval& packet_timestamp);
-static void handle_tcp(const IPv4Packet&, const timeval& packet_timestamp);
+static void handle_ipv4(const EthernetFrameHeader&, PacketBuffer&, const timeval& packet_timestamp);
+static void handle_icmp(const EthernetFrameHeader&, const IPv4Packet&, PacketBuffer&, const timeval& packet_timestamp);
+static void handle_udp(const IPv4Packet&, PacketBuffer&, const timeval& packet_timestamp);
+static void handle_tcp(const IPv4Packet&, PacketBuffer&, const timeval& packet_timestamp);
 
 [[noreturn]] static void NetworkTask_main(void*);
 
+static constexpr u64 retransmit_check_interval_ms = 100;
+
 void NetworkTask::spawn()
 {
     RefPtr<Thread> thread;
@@ -59,9 +63,11 @@ void NetworkTask::spawn()
 
 void NetworkTask_main(void*)
 {
+    ProcFS::add_sys_integer("somaxconn", Socket::max_backlog());
+    ProcFS::add_sys_integer("tcp_max_syn_backlog", TCPSocket::max_syn_backlog());
+
     WaitQueue packet_wait_queue;
     u8 octet = 15;
-    int pending_packets = 0;
     NetworkAdapter::for_each([&](auto& adapter) {
         if (String(adapter.class_name()) == "LoopbackAdapter") {
             adapter.set_ipv4_address({ 127, 0, 0, 1 });
@@ -76,51 +82,56 @@ void NetworkTask_main(void*)
         klog() << "NetworkTask: " << adapter.class_name() << " network adapter found: hw=" << adapter.mac_address().to_string().characters() << " address=" << adapter.ipv4_address().to_string().characters() << " netmask=" << adapter.ipv4_netmask().to_string().characters() << " gateway=" << adapter.ipv4_gateway().to_string().characters();
 
         adapter.on_receive = [&]() {
-            pending_packets++;
             packet_wait_queue.wake_all();
         };
     });
 
-    auto dequeue_packet = [&pending_packets](u8* buffer, size_t buffer_size, timeval& packet_timestamp) -> size_t {
-        if (pending_packets == 0)
-            return 0;
-        size_t packet_size = 0;
+    auto dequeue_packet = [](timeval& packet_timestamp) -> RefPtr<PacketBuffer> {
+        RefPtr<PacketBuffer> packet;
         NetworkAdapter::for_each([&](auto& adapter) {
-            if (packet_size || !adapter.has_queued_packets())
+            if (packet || !adapter.has_queued_packets())
                 return;
-            packet_size = adapter.dequeue_packet(buffer, buffer_size, packet_timestamp);
-            pending_packets--;
+            packet = adapter.dequeue_packet(packet_timestamp);
 #if NETWORK_TASK_DEBUG
-            klog() << "NetworkTask: Dequeued packet from " << adapter.name().characters() << " (" << packet_size << " bytes)";
+            if (packet)
+                klog() << "NetworkTask: Dequeued packet from " << adapter.name().characters() << " (" << packet->size() << " bytes)";
 #endif
         });
-        return packet_size;
+        return packet;
     };
 
-    size_t buffer_size = 64 * KiB;
-    auto buffer_region = MM.allocate_kernel_region(buffer_size, "Kernel Packet Buffer", Region::Access::Read | Region::Access::Write);
-    auto buffer = (u8*)buffer_region->vaddr().get();
     timeval packet_timestamp;
+    u64 last_retransmit_check_ms = 0;
 
     klog() << "NetworkTask: Enter main loop.";
     for (;;) {
-        size_t packet_size = dequeue_packet(buffer, buffer_size, packet_timestamp);
-        if (!packet_size) {
-            packet_wait_queue.wait_forever("NetworkTask");
+        // TCP retransmission timers have a granularity of one check interval.
+        auto now_ms = TimeManagement::the().uptime_ms();
+        if (now_ms - last_retransmit_check_ms >= retransmit_check_interval_ms) {
+            last_retransmit_check_ms = now_ms;
+            TCPSocket::retransmit_timed_out_packets();
+        }
+
+        // Adapters only notify us when their queue was empty, so keep going until all of them are drained.
+        auto packet = dequeue_packet(packet_timestamp);
+        if (!packet) {
+            timeval timeout { 0, retransmit_check_interval_ms * 1000 };
+            [[maybe_unused]] auto result = packet_wait_queue.wait_on(Thread::BlockTimeout(false, &timeout), "NetworkTask");
             continue;
         }
+        size_t packet_size = packet->size();
         if (packet_size < sizeof(EthernetFrameHeader)) {
             klog() << "NetworkTask: Packet is too small to be an Ethernet packet! (" << packet_size << ")";
             continue;
         }
-        auto& eth = *(const EthernetFrameHeader*)buffer;
+        auto& eth = *(const EthernetFrameHeader*)packet->data();
 #if ETHERNET_DEBUG
         dbgln("NetworkTask: From {} to {}, ether_type={:#04x}, packet_size={}", eth.source().to_string(), eth.destination().to_string(), eth.ether_type(), packet_size);
 #endif
 
 #if ETHERNET_VERY_DEBUG
         for (size_t i = 0; i < packet_size; i++) {
-            klog() << String::format("%#02x", buffer[i]);
+            klog() << String::format("%#02x", packet->data()[i]);
 
             switch (i % 16) {
             case 7:
@@ -143,7 +154,7 @@ void NetworkTask_main(void*)
             handle_arp(eth, packet_size);
             break;
         case EtherType::IPv4:
-            handle_ipv4(eth, packet_size, packet_timestamp);
+            handle_ipv4(eth, *packet, packet_timestamp);
             break;
         case EtherType::IPv6:
             // ignore
@@ -205,8 +216,9 @@ void handle_arp(const EthernetFrameHeader& eth, size_t frame_size)
     }
 }
 
-void handle_ipv4(const EthernetFrameHeader& eth, size_t frame_size, const timeval& packet_timestamp)
+void handle_ipv4(const EthernetFrameHeader& eth, PacketBuffer& frame, const timeval& packet_timestamp)
 {
+    size_t frame_size = frame.size();
     constexpr size_t minimum_ipv4_frame_size = sizeof(EthernetFrameHeader) + sizeof(IPv4Packet);
     if (frame_size < minimum_ipv4_frame_size) {
         klog() << "handle_ipv4: Frame too small (" << frame_size << ", need " << minimum_ipv4_frame_size << ")";
@@ -229,20 +241,24 @@ void handle_ipv4(const EthernetFrameHeader& eth, size_t frame_size, const timeva
     klog() << "handle_ipv4: source=" << packet.source().to_string().characters() << ", target=" << packet.destination().to_string().characters();
 #endif
 
+    // From here on, the buffer holds just the IPv4 packet. This is what gets queued on the sockets.
+    frame.pull(sizeof(EthernetFrameHeader));
+    frame.trim(packet.length());
+
     switch ((IPv4Protocol)packet.protocol()) {
     case IPv4Protocol::ICMP:
-        return handle_icmp(eth, packet, packet_timestamp);
+        return handle_icmp(eth, packet, frame, packet_timestamp);
     case IPv4Protocol::UDP:
-        return handle_udp(packet, packet_timestamp);
+        return handle_udp(packet, frame, packet_timestamp);
     case IPv4Protocol::TCP:
-        return handle_tcp(packet, packet_timestamp);
+        return handle_tcp(packet, frame, packet_timestamp);
     default:
         klog() << "handle_ipv4: Unhandled protocol " << packet.protocol();
         break;
     }
 }
 
-void handle_icmp(const EthernetFrameHeader& eth, const IPv4Packet& ipv4_packet, const timeval& packet_timestamp)
+void handle_icmp(const EthernetFrameHeader& eth, const IPv4Packet& ipv4_packet, PacketBuffer& packet, const timeval& packet_timestamp)
 {
     auto& icmp_header = *static_cast<const ICMPHeader*>(ipv4_packet.payload());
 #if ICMP_DEBUG
@@ -260,7 +276,7 @@ void handle_icmp(const EthernetFrameHeader& eth, const IPv4Packet& ipv4_packet,
             }
         }
         for (auto& socket : icmp_sockets)
-            socket.did_receive(ipv4_packet.source(), 0, KBuffer::copy(&ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size()), packet_timestamp);
+            socket.did_receive(ipv4_packet.source(), 0, packet, packet_timestamp);
     }
 
     auto adapter = NetworkAdapter::from_ipv4_address(ipv4_packet.destination());
@@ -290,7 +306,7 @@ void handle_icmp(const EthernetFrameHeader& eth, const IPv4Packet& ipv4_packet,
     }
 }
 
-void handle_udp(const IPv4Packet& ipv4_packet, const timeval& packet_timestamp)
+void handle_udp(const IPv4Packet& ipv4_packet, PacketBuffer& packet, const timeval& packet_timestamp)
 {
     if (ipv4_packet.payload_size() < sizeof(UDPPacket)) {
         klog() << "handle_udp: Packet too small (" << ipv4_packet.payload_size() << ", need " << sizeof(UDPPacket) << ")";
@@ -316,10 +332,10 @@ void handle_udp(const IPv4Packet& ipv4_packet, const timeval& packet_timestamp)
 
     VERIFY(socket->type() == SOCK_DGRAM);
     VERIFY(socket->local_port() == udp_packet.destination_port());
-    socket->did_receive(ipv4_packet.source(), udp_packet.source_port(), KBuffer::copy(&ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size()), packet_timestamp);
+    socket->did_receive(ipv4_packet.source(), udp_packet.source_port(), packet, packet_timestamp);
 }
 
-void handle_tcp(const IPv4Packet& ipv4_packet, const timeval& packet_timestamp)
+void handle_tcp(const IPv4Packet& ipv4_packet, PacketBuffer& packet, const timeval& packet_timestamp)
 {
     if (ipv4_packet.payload_size() < sizeof(TCPPacket)) {
         klog() << "handle_tcp: IPv4 payload is too small to be a TCP packet (" << ipv4_packet.payload_size() << ", need " << sizeof(TCPPacket) << ")";
@@ -417,6 +433,11 @@ void handle_tcp(const IPv4Packet& ipv4_packet, const timeval& packet_timestamp)
 #if TCP_DEBUG
             klog() << "handle_tcp: incoming connection";
 #endif
+            if (!socket->can_queue_connection_request()) {
+                // The peer will try again, hopefully once there's room.
+                dbgln_if(TCP_DEBUG, "handle_tcp: backlog is full, dropping SYN from {}:{}", ipv4_packet.source().to_string(), tcp_packet.source_port());
+                return;
+            }
             auto& local_address = ipv4_packet.destination();
             auto& peer_address = ipv4_packet.source();
             auto client = socket->create_client(local_address, tcp_packet.destination_port(), peer_address, tcp_packet.source_port());
@@ -430,6 +451,7 @@ void handle_tcp(const IPv4Packet& ipv4_packet, const timeval& packet_timestamp)
 #endif
             client->set_sequence_number(1000);
             client->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
+            client->negotiate_options(tcp_packet);
             [[maybe_unused]] auto rc2 = client->send_tcp_packet(TCPFlags::SYN | TCPFlags::ACK);
             client->set_state(TCPSocket::State::SynReceived);
             return;
@@ -491,7 +513,11 @@ void handle_tcp(const IPv4Packet& ipv4_packet, const timeval& packet_timestamp)
 
                 socket->set_state(TCPSocket::State::Established);
                 socket->set_setup_state(Socket::SetupState::Completed);
-                socket->release_to_originator();
+                if (socket->release_to_originator().is_error()) {
+                    klog() << "handle_tcp: accept queue of the originating socket is full";
+                    unused_rc = socket->send_tcp_packet(TCPFlags::RST);
+                    socket->set_state(TCPSocket::State::Closed);
+                }
                 return;
             case TCPSocket::Direction::Outgoing:
                 socket->set_state(TCPSocket::State::Established);
@@ -576,27 +602,12 @@ void handle_tcp(const IPv4Packet& ipv4_packet, const timeval& packet_timestamp)
             return;
         }
     case TCPSocket::State::Established:
-        if (tcp_packet.has_fin()) {
-            if (payload_size != 0)
-                socket->did_receive(ipv4_packet.source(), tcp_packet.source_port(), KBuffer::copy(&ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size()), packet_timestamp);
-
-            socket->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
-            unused_rc = socket->send_tcp_packet(TCPFlags::ACK);
+        // The socket puts segments back in order and ACKs them; we only need to know when the FIN is reached.
+        if (socket->receive_tcp_segment(tcp_packet, packet, payload_size, packet_timestamp)) {
             socket->set_state(TCPSocket::State::CloseWait);
             socket->set_connected(false);
-            return;
-        }
-
-        socket->set_ack_number(tcp_packet.sequence_number() + payload_size);
-
-#if TCP_DEBUG
-        klog() << "Got packet with ack_no=" << tcp_packet.ack_number() << ", seq_no=" << tcp_packet.sequence_number() << ", payload_size=" << payload_size << ", acking it with new ack_no=" << socket->ack_number() << ", seq_no=" << socket->sequence_number();
-#endif
-
-        if (payload_size) {
-            if (socket->did_receive(ipv4_packet.source(), tcp_packet.source_port(), KBuffer::copy(&ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size()), packet_timestamp))
-                unused_rc = socket->send_tcp_packet(TCPFlags::ACK);
         }
+        return;
     }
 }
 
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Singleton.h>
+#include <Kernel/Net/PacketBuffer.h>
+#include <Kernel/SpinLock.h>
+
+namespace Kernel {
+
+static constexpr size_t pooled_storage_size = PAGE_SIZE;
+static constexpr size_t max_pooled_storage_count = 256;
+
+class PacketBufferPool {
+public:
+    PacketBufferPool()
+    {
+        // Returning storage to the pool may happen in IRQ context, so never grow the vector there.
+        m_free_storage.ensure_capacity(max_pooled_storage_count);
+    }
+
+    OwnPtr<KBuffer> take()
+    {
+        ScopedSpinLock lock(m_lock);
+        if (m_free_storage.is_empty())
+            return {};
+        return m_free_storage.take_last();
+    }
+
+    void give_back(NonnullOwnPtr<KBuffer> storage)
+    {
+        ScopedSpinLock lock(m_lock);
+        if (m_free_storage.size() < max_pooled_storage_count)
+            m_free_storage.unchecked_append(move(storage));
+    }
+
+private:
+    SpinLock<u8> m_lock;
+    Vector<NonnullOwnPtr<KBuffer>> m_free_storage;
+};
+
+static AK::Singleton<PacketBufferPool> s_pool;
+
+RefPtr<PacketBuffer> PacketBuffer::try_create(size_t size, size_t headroom)
+{
+    size_t capacity = headroom + size;
+    OwnPtr<KBuffer> storage;
+    if (capacity <= pooled_storage_size)
+        storage = s_pool->take();
+    if (!storage) {
+        // Packets may be created in IRQ context, so don't leave any page faults for later.
+        storage = KBuffer::try_create_with_size(max(capacity, pooled_storage_size), Region::Access::Read | Region::Access::Write, "Packet Buffer", AllocationStrategy::AllocateNow);
+        if (!storage)
+            return {};
+    }
+    return adopt(*new PacketBuffer(storage.release_nonnull(), headroom, size));
+}
+
+PacketBuffer::PacketBuffer(NonnullOwnPtr<KBuffer> storage, size_t headroom, size_t size)
+    : m_storage(move(storage))
+    , m_offset(headroom)
+    , m_size(size)
+{
+}
+
+PacketBuffer::~PacketBuffer()
+{
+    if (m_storage->capacity() == pooled_storage_size)
+        s_pool->give_back(m_storage.release_nonnull());
+}
+
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+// PacketBuffer: A refcounted network packet with headroom.
+//
+// A frame is copied into a PacketBuffer once, when the adapter receives it. From there
+// it's passed by reference through NetworkTask into the receive queues of all sockets
+// interested in it. Protocol layers strip their headers with pull() instead of copying
+// the remainder, and on the way out, headers are prepended into the headroom with push().
+//
+// Page-sized storage is recycled through a pool, so the common case doesn't have to
+// allocate a new kernel region for every packet.
+
+#include <AK/OwnPtr.h>
+#include <AK/RefCounted.h>
+#include <AK/RefPtr.h>
+#include <AK/Span.h>
+#include <Kernel/KBuffer.h>
+
+namespace Kernel {
+
+class PacketBuffer : public RefCounted<PacketBuffer> {
+public:
+    // Enough for an Ethernet and an IPv4 header, with some room to spare.
+    static constexpr size_t default_headroom = 64;
+
+    static RefPtr<PacketBuffer> try_create(size_t size, size_t headroom = default_headroom);
+    ~PacketBuffer();
+
+    u8* data() { return m_storage->data() + m_offset; }
+    const u8* data() const { return m_storage->data() + m_offset; }
+    size_t size() const { return m_size; }
+    size_t headroom() const { return m_offset; }
+    ReadonlyBytes bytes() const { return { data(), m_size }; }
+
+    // Grows the packet at the front, e.g. to prepend a protocol header. Returns the new start.
+    u8* push(size_t length)
+    {
+        VERIFY(length <= m_offset);
+        m_offset -= length;
+        m_size += length;
+        return data();
+    }
+
+    // Strips a header from the front of the packet.
+    void pull(size_t length)
+    {
+        VERIFY(length <= m_size);
+        m_offset += length;
+        m_size -= length;
+    }
+
+    // Cuts the packet off after the given number of bytes, e.g. to drop link-layer padding.
+    void trim(size_t size)
+    {
+        VERIFY(size <= m_size);
+        m_size = size;
+    }
+
+private:
+    PacketBuffer(NonnullOwnPtr<KBuffer>, size_t headroom, size_t size);
+
+    OwnPtr<KBuffer> m_storage;
+    size_t m_offset { 0 };
+    size_t m_size { 0 };
+};
+
+}
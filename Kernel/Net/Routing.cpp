@@ -24,26 +24,74 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Atomic.h>
 #include <AK/HashMap.h>
 #include <AK/Singleton.h>
 #include <Kernel/Debug.h>
 #include <Kernel/Net/LoopbackAdapter.h>
 #include <Kernel/Net/Routing.h>
 #include <Kernel/Thread.h>
+#include <Kernel/Time/TimeManagement.h>
 
 namespace Kernel {
 
-static AK::Singleton<Lockable<HashMap<IPv4Address, MACAddress>>> s_arp_table;
+struct RouteCacheKey {
+    IPv4Address target;
+    IPv4Address source;
+    const NetworkAdapter* through { nullptr };
+
+    bool operator==(const RouteCacheKey& other) const
+    {
+        return target == other.target && source == other.source && through == other.through;
+    }
+};
+
+}
+
+namespace AK {
+
+template<>
+struct Traits<Kernel::RouteCacheKey> : public GenericTraits<Kernel::RouteCacheKey> {
+    static unsigned hash(const Kernel::RouteCacheKey& key) { return pair_int_hash(pair_int_hash(key.target.to_u32(), key.source.to_u32()), ptr_hash(key.through)); }
+};
+
+}
+
+namespace Kernel {
+
+// Resolved entries are used as they are for a while, then refreshed in the background
+// while they're in use, and only dropped if the neighbor stops answering.
+static constexpr u64 arp_refresh_after_ms = 60000;
+static constexpr u64 arp_entry_lifetime_ms = 90000;
+static constexpr u64 arp_request_interval_ms = 1000;
+static constexpr u64 arp_request_timeout_ms = 3000;
+
+static AK::Singleton<ARPTable> s_arp_table;
+
+// Bumped on every ARP table update, so waiters can tell they missed one without looking at the table.
+static Atomic<u32> s_arp_table_generation;
+
+struct NextHop {
+    RefPtr<NetworkAdapter> adapter;
+    IPv4Address address;
+    // Known up front for our own addresses and broadcasts, otherwise it comes from the ARP table.
+    MACAddress mac_address;
+    u32 generation { 0 };
+};
+
+static constexpr size_t max_cached_routes_per_shard = 64;
+static AK::Singleton<SocketTable<RouteCacheKey, NextHop, 16>> s_route_cache;
+static Atomic<u32> s_route_cache_generation { 1 };
 
 class ARPTableBlocker : public Thread::Blocker {
 public:
-    ARPTableBlocker(IPv4Address ip_addr, Optional<MACAddress>& addr);
+    ARPTableBlocker(IPv4Address ip_addr, u32 table_generation, Optional<MACAddress>& addr);
 
     virtual const char* state_string() const override { return "Routing (ARP)"; }
     virtual Type blocker_type() const override { return Type::Routing; }
     virtual bool should_block() override { return m_should_block; }
 
-    virtual void not_blocking(bool) override;
+    virtual void not_blocking(bool) override { }
 
     bool unblock(bool from_add_blocker, const IPv4Address& ip_addr, const MACAddress& addr)
     {
@@ -64,9 +112,11 @@ public:
     }
 
     const IPv4Address& ip_addr() const { return m_ip_addr; }
+    u32 table_generation() const { return m_table_generation; }
 
 private:
     const IPv4Address m_ip_addr;
+    const u32 m_table_generation;
     Optional<MACAddress>& m_addr;
     bool m_did_unblock { false };
     bool m_should_block { true };
@@ -86,52 +136,129 @@ public:
 protected:
     virtual bool should_add_blocker(Thread::Blocker& b, void*) override
     {
+        // If the table changed since the waiter looked at it, it has to look again.
         VERIFY(b.blocker_type() == Thread::Blocker::Type::Routing);
         auto& blocker = static_cast<ARPTableBlocker&>(b);
-        auto val = s_arp_table->resource().get(blocker.ip_addr());
-        if (!val.has_value())
-            return true;
-        return blocker.unblock(true, blocker.ip_addr(), val.value());
+        return blocker.table_generation() == s_arp_table_generation.load();
     }
 };
 
 static AK::Singleton<ARPTableBlockCondition> s_arp_table_block_condition;
 
-ARPTableBlocker::ARPTableBlocker(IPv4Address ip_addr, Optional<MACAddress>& addr)
+ARPTableBlocker::ARPTableBlocker(IPv4Address ip_addr, u32 table_generation, Optional<MACAddress>& addr)
     : m_ip_addr(ip_addr)
+    , m_table_generation(table_generation)
     , m_addr(addr)
 {
     if (!set_block_condition(*s_arp_table_block_condition))
         m_should_block = false;
 }
 
-void ARPTableBlocker::not_blocking(bool timeout_in_past)
+ARPTable& arp_table()
 {
-    VERIFY(timeout_in_past || !m_should_block);
-    auto addr = s_arp_table->resource().get(ip_addr());
+    return *s_arp_table;
+}
 
-    ScopedSpinLock lock(m_lock);
-    if (!m_did_unblock) {
-        m_did_unblock = true;
-        m_addr = move(addr);
-    }
+void update_arp_table(const IPv4Address& ip_addr, const MACAddress& addr)
+{
+    auto now = TimeManagement::the().uptime_ms();
+    arp_table().with_shard_locked(ip_addr, [&](auto& table) {
+        // Clean up after neighbors that went away while we're here anyway.
+        Vector<IPv4Address> expired_addresses;
+        for (auto& it : table) {
+            if (it.value.is_resolved() && now - it.value.updated_ms >= arp_entry_lifetime_ms)
+                expired_addresses.append(it.key);
+        }
+        for (auto& expired_address : expired_addresses)
+            table.remove(expired_address);
+
+        table.set(ip_addr, { addr, now, 0 });
+    });
+    ++s_arp_table_generation;
+    s_arp_table_block_condition->unblock(ip_addr, addr);
+
+    dbgln_if(ARP_DEBUG, "ARP table: {} is at {}", ip_addr.to_string(), addr.to_string());
 }
 
-Lockable<HashMap<IPv4Address, MACAddress>>& arp_table()
+static void send_arp_request(NetworkAdapter& adapter, const IPv4Address& ip_addr)
 {
-    return *s_arp_table;
+#if ROUTING_DEBUG
+    klog() << "Routing: Sending ARP request via adapter " << adapter.name().characters() << " for IPv4 address " << ip_addr.to_string().characters();
+#endif
+
+    ARPPacket request;
+    request.set_operation(ARPOperation::Request);
+    request.set_target_hardware_address({ 0xff, 0xff, 0xff, 0xff, 0xff, 0xff });
+    request.set_target_protocol_address(ip_addr);
+    request.set_sender_hardware_address(adapter.mac_address());
+    request.set_sender_protocol_address(adapter.ipv4_address());
+    adapter.send({ 0xff, 0xff, 0xff, 0xff, 0xff, 0xff }, request);
 }
 
-void update_arp_table(const IPv4Address& ip_addr, const MACAddress& addr)
+static Optional<MACAddress> resolve_mac_address(NetworkAdapter& adapter, const IPv4Address& ip_addr)
 {
-    LOCKER(arp_table().lock());
-    arp_table().resource().set(ip_addr, addr);
-    s_arp_table_block_condition->unblock(ip_addr, addr);
+    auto now = TimeManagement::the().uptime_ms();
+    auto cached_entry = arp_table().get(ip_addr);
+    if (cached_entry.has_value() && cached_entry.value().is_resolved() && now - cached_entry.value().updated_ms < arp_entry_lifetime_ms) {
+        auto& entry = cached_entry.value();
+        if (now - entry.updated_ms < arp_refresh_after_ms || now - entry.request_sent_ms < arp_request_interval_ms)
+            return entry.mac_address;
+
+        // Keep using the entry, but ask whether it's still valid before it expires.
+        bool should_send_request = arp_table().with_shard_locked(ip_addr, [&](auto& table) {
+            auto it = table.find(ip_addr);
+            if (it == table.end() || now - it->value.request_sent_ms < arp_request_interval_ms)
+                return false;
+            it->value.request_sent_ms = now;
+            return true;
+        });
+        if (should_send_request)
+            send_arp_request(adapter, ip_addr);
+        return entry.mac_address;
+    }
 
-    klog() << "ARP table (" << arp_table().resource().size() << " entries):";
-    for (auto& it : arp_table().resource()) {
-        klog() << it.value.to_string().characters() << " :: " << it.key.to_string().characters();
+    // Everyone who needs this address waits for the same request, which is repeated
+    // once in a while until the neighbor answers or we give up.
+    auto deadline = now + arp_request_timeout_ms;
+    while (now < deadline) {
+        u32 table_generation = s_arp_table_generation.load();
+        Optional<MACAddress> addr;
+        bool should_send_request = arp_table().with_shard_locked(ip_addr, [&](auto& table) {
+            auto it = table.find(ip_addr);
+            if (it == table.end()) {
+                table.set(ip_addr, { {}, 0, now });
+                return true;
+            }
+            auto& entry = it->value;
+            if (entry.is_resolved() && now - entry.updated_ms < arp_entry_lifetime_ms) {
+                addr = entry.mac_address;
+                return false;
+            }
+            if (now - entry.request_sent_ms < arp_request_interval_ms)
+                return false;
+            entry.request_sent_ms = now;
+            return true;
+        });
+        if (addr.has_value())
+            return addr;
+        if (should_send_request)
+            send_arp_request(adapter, ip_addr);
+
+        timeval timeout { 0, (suseconds_t)(min(arp_request_interval_ms, deadline - now) * 1000) };
+        if (Thread::current()->block<ARPTableBlocker>(Thread::BlockTimeout(false, &timeout), ip_addr, table_generation, addr).was_interrupted())
+            return {};
+        if (addr.has_value())
+            return addr;
+        now = TimeManagement::the().uptime_ms();
     }
+
+    // Let the next sender start over with a new request.
+    arp_table().with_shard_locked(ip_addr, [&](auto& table) {
+        auto it = table.find(ip_addr);
+        if (it != table.end() && !it->value.is_resolved())
+            table.remove(it);
+    });
+    return {};
 }
 
 bool RoutingDecision::is_zero() const
@@ -139,7 +266,12 @@ bool RoutingDecision::is_zero() const
     return adapter.is_null() || next_hop.is_zero();
 }
 
-RoutingDecision route_to(const IPv4Address& target, const IPv4Address& source, const RefPtr<NetworkAdapter> through)
+void invalidate_route_cache()
+{
+    ++s_route_cache_generation;
+}
+
+static NextHop find_next_hop(const IPv4Address& target, const IPv4Address& source, const RefPtr<NetworkAdapter> through)
 {
     auto matches = [&](auto& adapter) {
         if (!through)
@@ -147,14 +279,6 @@ RoutingDecision route_to(const IPv4Address& target, const IPv4Address& source, c
 
         return through == adapter;
     };
-    auto if_matches = [&](auto& adapter, const auto& mac) -> RoutingDecision {
-        if (!matches(adapter))
-            return { nullptr, {} };
-        return { adapter, mac };
-    };
-
-    if (target[0] == 127)
-        return if_matches(LoopbackAdapter::the(), LoopbackAdapter::the().mac_address());
 
     auto target_addr = target.to_u32();
     auto source_addr = source.to_u32();
@@ -177,78 +301,77 @@ RoutingDecision route_to(const IPv4Address& target, const IPv4Address& source, c
     });
 
     if (local_adapter && target == local_adapter->ipv4_address())
-        return { local_adapter, local_adapter->mac_address() };
-
-    if (!local_adapter && !gateway_adapter) {
-#if ROUTING_DEBUG
-        klog() << "Routing: Couldn't find a suitable adapter for route to " << target.to_string().characters();
-#endif
-        return { nullptr, {} };
-    }
-
-    RefPtr<NetworkAdapter> adapter = nullptr;
-    IPv4Address next_hop_ip;
+        return { local_adapter, target, local_adapter->mac_address() };
 
     if (local_adapter) {
 #if ROUTING_DEBUG
         klog() << "Routing: Got adapter for route (direct): " << local_adapter->name().characters() << " (" << local_adapter->ipv4_address().to_string().characters() << "/" << local_adapter->ipv4_netmask().to_string().characters() << ") for " << target.to_string().characters();
 #endif
-        adapter = local_adapter;
-        next_hop_ip = target;
-    } else if (gateway_adapter) {
-#if ROUTING_DEBUG
-        klog() << "Routing: Got adapter for route (using gateway " << gateway_adapter->ipv4_gateway().to_string().characters() << "): " << gateway_adapter->name().characters() << " (" << gateway_adapter->ipv4_address().to_string().characters() << "/" << gateway_adapter->ipv4_netmask().to_string().characters() << ") for " << target.to_string().characters();
-#endif
-        adapter = gateway_adapter;
-        next_hop_ip = gateway_adapter->ipv4_gateway();
-    } else {
-        return { nullptr, {} };
+        // If it's a broadcast, we already know everything we need to know.
+        // FIXME: We should also deal with the case where `target_addr` is
+        //        a broadcast to a subnet rather than a full broadcast.
+        if (target_addr == 0xffffffff)
+            return { local_adapter, target, { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff } };
+        return { local_adapter, target, {} };
     }
 
-    // If it's a broadcast, we already know everything we need to know.
-    // FIXME: We should also deal with the case where `target_addr` is
-    //        a broadcast to a subnet rather than a full broadcast.
-    if (target_addr == 0xffffffff && matches(adapter))
-        return { adapter, { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff } };
-
-    {
-        LOCKER(arp_table().lock());
-        auto addr = arp_table().resource().get(next_hop_ip);
-        if (addr.has_value()) {
+    if (gateway_adapter) {
 #if ROUTING_DEBUG
-            klog() << "Routing: Using cached ARP entry for " << next_hop_ip.to_string().characters() << " (" << addr.value().to_string().characters() << ")";
+        klog() << "Routing: Got adapter for route (using gateway " << gateway_adapter->ipv4_gateway().to_string().characters() << "): " << gateway_adapter->name().characters() << " (" << gateway_adapter->ipv4_address().to_string().characters() << "/" << gateway_adapter->ipv4_netmask().to_string().characters() << ") for " << target.to_string().characters();
 #endif
-            return { adapter, addr.value() };
-        }
+        if (target_addr == 0xffffffff)
+            return { gateway_adapter, target, { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff } };
+        return { gateway_adapter, gateway_adapter->ipv4_gateway(), {} };
     }
 
 #if ROUTING_DEBUG
-    klog() << "Routing: Sending ARP request via adapter " << adapter->name().characters() << " for IPv4 address " << next_hop_ip.to_string().characters();
+    klog() << "Routing: Couldn't find a suitable adapter for route to " << target.to_string().characters();
 #endif
+    return {};
+}
 
-    ARPPacket request;
-    request.set_operation(ARPOperation::Request);
-    request.set_target_hardware_address({ 0xff, 0xff, 0xff, 0xff, 0xff, 0xff });
-    request.set_target_protocol_address(next_hop_ip);
-    request.set_sender_hardware_address(adapter->mac_address());
-    request.set_sender_protocol_address(adapter->ipv4_address());
-    adapter->send({ 0xff, 0xff, 0xff, 0xff, 0xff, 0xff }, request);
-
-    Optional<MACAddress> addr;
-    if (!Thread::current()->block<ARPTableBlocker>({}, next_hop_ip, addr).was_interrupted()) {
-        if (addr.has_value()) {
-#if ROUTING_DEBUG
-            klog() << "Routing: Got ARP response using adapter " << adapter->name().characters() << " for " << next_hop_ip.to_string().characters() << " (" << addr.value().to_string().characters() << ")";
-#endif
-            return { adapter, addr.value() };
-        }
+static NextHop cached_next_hop(const IPv4Address& target, const IPv4Address& source, const RefPtr<NetworkAdapter> through)
+{
+    RouteCacheKey key { target, source, through.ptr() };
+    u32 generation = s_route_cache_generation.load();
+    auto cached = s_route_cache->get(key);
+    if (cached.has_value() && cached.value().generation == generation)
+        return cached.release_value();
+
+    auto next_hop = find_next_hop(target, source, through);
+    if (!next_hop.adapter)
+        return next_hop;
+    next_hop.generation = generation;
+    s_route_cache->with_shard_locked(key, [&](auto& routes) {
+        if (routes.size() >= max_cached_routes_per_shard)
+            routes.clear();
+        routes.set(key, next_hop);
+    });
+    return next_hop;
+}
+
+RoutingDecision route_to(const IPv4Address& target, const IPv4Address& source, const RefPtr<NetworkAdapter> through)
+{
+    if (target[0] == 127) {
+        if (through && through != &LoopbackAdapter::the())
+            return { nullptr, {} };
+        return { LoopbackAdapter::the(), LoopbackAdapter::the().mac_address() };
     }
 
+    auto next_hop = cached_next_hop(target, source, through);
+    if (!next_hop.adapter)
+        return { nullptr, {} };
+    if (!next_hop.mac_address.is_zero())
+        return { next_hop.adapter, next_hop.mac_address };
+
+    auto mac_address = resolve_mac_address(*next_hop.adapter, next_hop.address);
+    if (!mac_address.has_value()) {
 #if ROUTING_DEBUG
-    klog() << "Routing: Couldn't find route using adapter " << adapter->name().characters() << " for " << target.to_string().characters();
+        klog() << "Routing: Couldn't find route using adapter " << next_hop.adapter->name().characters() << " for " << target.to_string().characters();
 #endif
-
-    return { nullptr, {} };
+        return { nullptr, {} };
+    }
+    return { next_hop.adapter, mac_address.value() };
 }
 
 }
@@ -27,6 +27,7 @@
 #pragma once
 
 #include <Kernel/Net/NetworkAdapter.h>
+#include <Kernel/Net/SocketTable.h>
 #include <Kernel/Thread.h>
 
 namespace Kernel {
@@ -38,9 +39,24 @@ struct RoutingDecision {
     bool is_zero() const;
 };
 
+struct ARPTableEntry {
+    // Zero while we're still waiting for the first reply.
+    MACAddress mac_address;
+    // When the neighbor last told us its address.
+    u64 updated_ms { 0 };
+    // When we last asked, so that there's only one request in flight per address.
+    u64 request_sent_ms { 0 };
+
+    bool is_resolved() const { return !mac_address.is_zero(); }
+};
+
+using ARPTable = SocketTable<IPv4Address, ARPTableEntry, 16>;
+
 void update_arp_table(const IPv4Address&, const MACAddress&);
 RoutingDecision route_to(const IPv4Address& target, const IPv4Address& source, const RefPtr<NetworkAdapter> through = nullptr);
+// Forgets all cached routes, for when adapters or their addresses change.
+void invalidate_route_cache();
 
-Lockable<HashMap<IPv4Address, MACAddress>>& arp_table();
+ARPTable& arp_table();
 
 }
@@ -24,6 +24,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Singleton.h>
 #include <AK/StringBuilder.h>
 #include <AK/StringView.h>
 #include <Kernel/Debug.h>
@@ -49,6 +50,18 @@ KResultOr<NonnullRefPtr<Socket>> Socket::create(int domain, int type, int protoc
     }
 }
 
+static Lockable<u32>* create_max_backlog()
+{
+    return new Lockable<u32>(128);
+}
+
+static AK::Singleton<Lockable<u32>, create_max_backlog> s_max_backlog;
+
+Lockable<u32>& Socket::max_backlog()
+{
+    return *s_max_backlog;
+}
+
 Socket::Socket(int domain, int type, int protocol)
     : m_domain(domain)
     , m_type(type)
@@ -86,6 +99,12 @@ RefPtr<Socket> Socket::accept()
     return client;
 }
 
+void Socket::set_backlog(size_t backlog)
+{
+    // Like elsewhere, a backlog of 0 still lets a connection wait to be accepted.
+    m_backlog = max((size_t)1, min(backlog, (size_t)max_backlog().lock_and_copy()));
+}
+
 KResult Socket::queue_connection_from(NonnullRefPtr<Socket> peer)
 {
     dbgln_if(SOCKET_DEBUG, "Socket({}) queueing connection", this);
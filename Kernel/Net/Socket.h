@@ -96,6 +96,9 @@ public:
     bool can_accept() const { return !m_pending.is_empty(); }
     RefPtr<Socket> accept();
 
+    // System-wide limit on listen() backlogs, tunable through /proc/sys/somaxconn.
+    static Lockable<u32>& max_backlog();
+
     KResult shutdown(int how);
 
     virtual KResult bind(Userspace<const sockaddr*>, socklen_t) = 0;
@@ -141,7 +144,8 @@ protected:
     KResult queue_connection_from(NonnullRefPtr<Socket>);
 
     size_t backlog() const { return m_backlog; }
-    void set_backlog(size_t backlog) { m_backlog = backlog; }
+    void set_backlog(size_t);
+    size_t pending_connection_count() const { return m_pending.size(); }
 
     virtual const char* class_name() const override { return "Socket"; }
 
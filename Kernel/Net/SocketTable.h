@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/HashFunctions.h>
+#include <AK/HashMap.h>
+#include <AK/Optional.h>
+#include <Kernel/Lock.h>
+
+namespace Kernel {
+
+// A lookup table split into independently locked shards, so that packet demultiplexing
+// on one connection doesn't contend with lookups or updates on others. Besides sockets,
+// it also holds the ARP table and the route cache.
+template<typename K, typename V, size_t shard_count = 64>
+class SocketTable {
+public:
+    using Map = HashMap<K, V>;
+
+    Optional<V> get(const K& key)
+    {
+        auto& shard = shard_for(key);
+        LOCKER(shard.lock(), Lock::Mode::Shared);
+        return shard.resource().get(key);
+    }
+
+    bool contains(const K& key)
+    {
+        auto& shard = shard_for(key);
+        LOCKER(shard.lock(), Lock::Mode::Shared);
+        return shard.resource().contains(key);
+    }
+
+    // Adds the entry unless the key is already taken; returns whether it was added.
+    bool try_add(const K& key, const V& value)
+    {
+        auto& shard = shard_for(key);
+        LOCKER(shard.lock());
+        if (shard.resource().contains(key))
+            return false;
+        shard.resource().set(key, value);
+        return true;
+    }
+
+    // Only removes the entry if it still maps to the given value, so that a socket
+    // that never made it into the table can't evict the one that did.
+    void remove(const K& key, const V& value)
+    {
+        auto& shard = shard_for(key);
+        LOCKER(shard.lock());
+        auto existing = shard.resource().get(key);
+        if (existing.has_value() && existing.value() == value)
+            shard.resource().remove(key);
+    }
+
+    // Runs the callback with the key's shard locked exclusively, for check-and-insert
+    // sequences that need more than try_add().
+    template<typename Callback>
+    decltype(auto) with_shard_locked(const K& key, Callback callback)
+    {
+        auto& shard = shard_for(key);
+        LOCKER(shard.lock());
+        return callback(shard.resource());
+    }
+
+    // Visits every entry, holding one shard lock at a time. The view across shards
+    // isn't atomic, which is fine for enumeration and timer scans.
+    template<typename Callback>
+    void for_each(Callback callback)
+    {
+        for (auto& shard : m_shards) {
+            LOCKER(shard.lock(), Lock::Mode::Shared);
+            for (auto& it : shard.resource())
+                callback(it.key, it.value);
+        }
+    }
+
+private:
+    Lockable<Map>& shard_for(const K& key)
+    {
+        // Rehash so that the shard index doesn't correlate with the bucket index inside the shard.
+        return m_shards[int_hash(Traits<K>::hash(key)) % shard_count];
+    }
+
+    Lockable<Map> m_shards[shard_count];
+};
+
+}
@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <AK/Span.h>
 #include <Kernel/Net/IPv4.h>
 
 namespace Kernel {
@@ -41,6 +42,22 @@ struct TCPFlags {
     };
 };
 
+struct TCPOptionKind {
+    enum : u8 {
+        End = 0,
+        NoOperation = 1,
+        MaximumSegmentSize = 2,
+        WindowScale = 3,
+        SACKPermitted = 4,
+        SACK = 5,
+        Timestamp = 8,
+    };
+};
+
+// Sequence numbers wrap around, so they have to be compared modulo 2^32 (RFC 793, section 3.3).
+inline bool tcp_sequence_less_than(u32 a, u32 b) { return (i32)(a - b) < 0; }
+inline bool tcp_sequence_less_or_equal(u32 a, u32 b) { return (i32)(a - b) <= 0; }
+
 class [[gnu::packed]] TCPPacket {
 public:
     TCPPacket() = default;
@@ -83,6 +100,9 @@ public:
     const void* payload() const { return ((const u8*)this) + header_size(); }
     void* payload() { return ((u8*)this) + header_size(); }
 
+    ReadonlyBytes options() const { return { ((const u8*)this) + sizeof(TCPPacket), header_size() - sizeof(TCPPacket) }; }
+    u8* options() { return ((u8*)this) + sizeof(TCPPacket); }
+
 private:
     NetworkOrdered<u16> m_source_port;
     NetworkOrdered<u16> m_destination_port;
@@ -97,4 +117,80 @@ private:
 
 static_assert(sizeof(TCPPacket) == 20);
 
+struct TCPSACKBlock {
+    u32 left_edge { 0 };
+    u32 right_edge { 0 };
+};
+
+// The options we understand, as found in a single segment.
+struct TCPOptions {
+    static constexpr size_t max_options_size = 40;
+    static constexpr size_t max_sack_blocks = 4;
+
+    u16 maximum_segment_size { 0 };
+    bool has_window_scale { false };
+    u8 window_scale { 0 };
+    bool sack_permitted { false };
+    bool has_timestamp { false };
+    u32 timestamp_value { 0 };
+    u32 timestamp_echo_reply { 0 };
+    size_t sack_block_count { 0 };
+    TCPSACKBlock sack_blocks[max_sack_blocks];
+
+    static TCPOptions parse(ReadonlyBytes options)
+    {
+        auto read_u16 = [](const u8* p) -> u16 { return (p[0] << 8) | p[1]; };
+        auto read_u32 = [](const u8* p) -> u32 { return ((u32)p[0] << 24) | ((u32)p[1] << 16) | ((u32)p[2] << 8) | p[3]; };
+
+        TCPOptions result;
+        size_t offset = 0;
+        while (offset < options.size()) {
+            u8 kind = options[offset];
+            if (kind == TCPOptionKind::End)
+                break;
+            if (kind == TCPOptionKind::NoOperation) {
+                ++offset;
+                continue;
+            }
+            if (offset + 1 >= options.size())
+                break;
+            u8 length = options[offset + 1];
+            if (length < 2 || offset + length > options.size())
+                break;
+            auto* data = options.offset(offset + 2);
+            switch (kind) {
+            case TCPOptionKind::MaximumSegmentSize:
+                if (length == 4)
+                    result.maximum_segment_size = read_u16(data);
+                break;
+            case TCPOptionKind::WindowScale:
+                if (length == 3) {
+                    result.has_window_scale = true;
+                    result.window_scale = data[0];
+                }
+                break;
+            case TCPOptionKind::SACKPermitted:
+                if (length == 2)
+                    result.sack_permitted = true;
+                break;
+            case TCPOptionKind::SACK:
+                for (size_t i = 0; i + 8 <= (size_t)length - 2 && result.sack_block_count < max_sack_blocks; i += 8)
+                    result.sack_blocks[result.sack_block_count++] = { read_u32(data + i), read_u32(data + i + 4) };
+                break;
+            case TCPOptionKind::Timestamp:
+                if (length == 10) {
+                    result.has_timestamp = true;
+                    result.timestamp_value = read_u32(data);
+                    result.timestamp_echo_reply = read_u32(data + 4);
+                }
+                break;
+            default:
+                break;
+            }
+            offset += length;
+        }
+        return result;
+    }
+};
+
 }
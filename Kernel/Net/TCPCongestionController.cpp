@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/NumericLimits.h>
+#include <Kernel/Debug.h>
+#include <Kernel/Net/TCP.h>
+#include <Kernel/Net/TCPCongestionController.h>
+
+namespace Kernel {
+
+NonnullOwnPtr<TCPCongestionController> TCPCongestionController::create(u32 maximum_segment_size)
+{
+    return make<TCPNewRenoCongestionController>(maximum_segment_size);
+}
+
+TCPCongestionController::TCPCongestionController(u32 maximum_segment_size)
+    : m_maximum_segment_size(maximum_segment_size)
+    , m_slow_start_threshold(NumericLimits<u32>::max())
+{
+    // RFC 6928 initial window.
+    m_congestion_window = min(10 * maximum_segment_size, max(2 * maximum_segment_size, 14600u));
+}
+
+TCPNewRenoCongestionController::TCPNewRenoCongestionController(u32 maximum_segment_size)
+    : TCPCongestionController(maximum_segment_size)
+{
+}
+
+void TCPNewRenoCongestionController::reduce_slow_start_threshold(u32 bytes_in_flight)
+{
+    m_slow_start_threshold = max(bytes_in_flight / 2, 2 * m_maximum_segment_size);
+}
+
+TCPCongestionController::Action TCPNewRenoCongestionController::did_receive_ack(u32 ack_number, u32 bytes_acked, u32 bytes_in_flight)
+{
+    m_duplicate_ack_count = 0;
+
+    if (m_in_recovery) {
+        if (tcp_sequence_less_or_equal(m_recover, ack_number)) {
+            // Full acknowledgement: deflate the window and leave fast recovery.
+            m_congestion_window = min(m_slow_start_threshold, max(bytes_in_flight, m_maximum_segment_size) + m_maximum_segment_size);
+            m_in_recovery = false;
+            dbgln_if(TCP_SOCKET_DEBUG, "TCPNewReno: full ACK {}, leaving fast recovery with cwnd={}", ack_number, m_congestion_window);
+            return Action::None;
+        }
+
+        // Partial acknowledgement: the next segment was lost too, so retransmit it right away.
+        if (bytes_acked < m_congestion_window)
+            m_congestion_window -= bytes_acked;
+        else
+            m_congestion_window = 0;
+        if (bytes_acked >= m_maximum_segment_size)
+            m_congestion_window += m_maximum_segment_size;
+        m_congestion_window = max(m_congestion_window, m_maximum_segment_size);
+        return Action::RetransmitFirstUnacknowledged;
+    }
+
+    if (m_congestion_window < m_slow_start_threshold) {
+        m_congestion_window += min(bytes_acked, m_maximum_segment_size);
+    } else {
+        m_congestion_window += max(1u, m_maximum_segment_size * m_maximum_segment_size / m_congestion_window);
+    }
+    return Action::None;
+}
+
+TCPCongestionController::Action TCPNewRenoCongestionController::did_receive_duplicate_ack(u32 highest_sequence_sent, u32 bytes_in_flight, bool sacked_new_data)
+{
+    if (m_in_recovery) {
+        // Every duplicate ACK means another segment has left the network. Without SACK, the
+        // window has to be inflated to account for it.
+        if (!sacked_new_data)
+            m_congestion_window += m_maximum_segment_size;
+        return Action::None;
+    }
+
+    if (++m_duplicate_ack_count < duplicate_ack_threshold)
+        return Action::None;
+
+    m_duplicate_ack_count = 0;
+    reduce_slow_start_threshold(bytes_in_flight);
+    m_congestion_window = m_slow_start_threshold + duplicate_ack_threshold * m_maximum_segment_size;
+    m_recover = highest_sequence_sent;
+    m_in_recovery = true;
+    dbgln_if(TCP_SOCKET_DEBUG, "TCPNewReno: entering fast recovery, ssthresh={}, cwnd={}", m_slow_start_threshold, m_congestion_window);
+    return Action::RetransmitFirstUnacknowledged;
+}
+
+void TCPNewRenoCongestionController::did_time_out(u32 bytes_in_flight)
+{
+    reduce_slow_start_threshold(bytes_in_flight);
+    m_congestion_window = m_maximum_segment_size;
+    m_duplicate_ack_count = 0;
+    m_in_recovery = false;
+}
+
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Types.h>
+
+namespace Kernel {
+
+// Decides how much unacknowledged data a TCPSocket may have in flight.
+// The socket reports ACK events and timeouts; the controller adjusts the congestion window.
+class TCPCongestionController {
+public:
+    enum class Action {
+        None,
+        RetransmitFirstUnacknowledged,
+    };
+
+    static NonnullOwnPtr<TCPCongestionController> create(u32 maximum_segment_size);
+    virtual ~TCPCongestionController() = default;
+
+    virtual const char* name() const = 0;
+
+    u32 congestion_window() const { return m_congestion_window; }
+    u32 slow_start_threshold() const { return m_slow_start_threshold; }
+    bool is_in_recovery() const { return m_in_recovery; }
+
+    // Called when the cumulative ACK advances by bytes_acked.
+    virtual Action did_receive_ack(u32 ack_number, u32 bytes_acked, u32 bytes_in_flight) = 0;
+    // Called for an ACK that acknowledges nothing new while data is outstanding. If it carried
+    // new SACK information, the socket has already taken the departed data out of bytes_in_flight.
+    virtual Action did_receive_duplicate_ack(u32 highest_sequence_sent, u32 bytes_in_flight, bool sacked_new_data) = 0;
+    virtual void did_time_out(u32 bytes_in_flight) = 0;
+
+protected:
+    explicit TCPCongestionController(u32 maximum_segment_size);
+
+    u32 m_maximum_segment_size { 0 };
+    u32 m_congestion_window { 0 };
+    u32 m_slow_start_threshold { 0 };
+    bool m_in_recovery { false };
+};
+
+// RFC 5681 slow start and congestion avoidance, with the RFC 6582 NewReno fast recovery.
+class TCPNewRenoCongestionController final : public TCPCongestionController {
+public:
+    explicit TCPNewRenoCongestionController(u32 maximum_segment_size);
+
+    virtual const char* name() const override { return "NewReno"; }
+
+    virtual Action did_receive_ack(u32 ack_number, u32 bytes_acked, u32 bytes_in_flight) override;
+    virtual Action did_receive_duplicate_ack(u32 highest_sequence_sent, u32 bytes_in_flight, bool sacked_new_data) override;
+    virtual void did_time_out(u32 bytes_in_flight) override;
+
+private:
+    static constexpr u32 duplicate_ack_threshold = 3;
+
+    void reduce_slow_start_threshold(u32 bytes_in_flight);
+
+    u32 m_duplicate_ack_count { 0 };
+    u32 m_recover { 0 };
+};
+
+}
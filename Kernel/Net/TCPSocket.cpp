@@ -24,25 +24,27 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/NumericLimits.h>
 #include <AK/Singleton.h>
 #include <AK/Time.h>
 #include <Kernel/Debug.h>
 #include <Kernel/Devices/RandomDevice.h>
 #include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/Net/LoopbackAdapter.h>
 #include <Kernel/Net/NetworkAdapter.h>
 #include <Kernel/Net/Routing.h>
 #include <Kernel/Net/TCP.h>
 #include <Kernel/Net/TCPSocket.h>
 #include <Kernel/Process.h>
 #include <Kernel/Random.h>
+#include <Kernel/Time/TimeManagement.h>
 
 namespace Kernel {
 
 void TCPSocket::for_each(Function<void(const TCPSocket&)> callback)
 {
-    LOCKER(sockets_by_tuple().lock(), Lock::Mode::Shared);
-    for (auto& it : sockets_by_tuple().resource())
-        callback(*it.value);
+    listening_sockets().for_each([&](auto&, auto* socket) { callback(*socket); });
+    sockets_by_tuple().for_each([&](auto&, auto* socket) { callback(*socket); });
 }
 
 void TCPSocket::set_state(State new_state)
@@ -73,28 +75,33 @@ Lockable<HashMap<IPv4SocketTuple, RefPtr<TCPSocket>>>& TCPSocket::closing_socket
     return *s_socket_closing;
 }
 
-static AK::Singleton<Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>> s_socket_tuples;
+static AK::Singleton<SocketTable<IPv4SocketTuple, TCPSocket*>> s_socket_tuples;
 
-Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>& TCPSocket::sockets_by_tuple()
+SocketTable<IPv4SocketTuple, TCPSocket*>& TCPSocket::sockets_by_tuple()
 {
     return *s_socket_tuples;
 }
 
-RefPtr<TCPSocket> TCPSocket::from_tuple(const IPv4SocketTuple& tuple)
+static AK::Singleton<SocketTable<IPv4SocketTuple, TCPSocket*>> s_listening_sockets;
+
+SocketTable<IPv4SocketTuple, TCPSocket*>& TCPSocket::listening_sockets()
 {
-    LOCKER(sockets_by_tuple().lock(), Lock::Mode::Shared);
+    return *s_listening_sockets;
+}
 
-    auto exact_match = sockets_by_tuple().resource().get(tuple);
+RefPtr<TCPSocket> TCPSocket::from_tuple(const IPv4SocketTuple& tuple)
+{
+    auto exact_match = sockets_by_tuple().get(tuple);
     if (exact_match.has_value())
         return { *exact_match.value() };
 
     auto address_tuple = IPv4SocketTuple(tuple.local_address(), tuple.local_port(), IPv4Address(), 0);
-    auto address_match = sockets_by_tuple().resource().get(address_tuple);
+    auto address_match = listening_sockets().get(address_tuple);
     if (address_match.has_value())
         return { *address_match.value() };
 
     auto wildcard_tuple = IPv4SocketTuple(IPv4Address(), tuple.local_port(), IPv4Address(), 0);
-    auto wildcard_match = sockets_by_tuple().resource().get(wildcard_tuple);
+    auto wildcard_match = listening_sockets().get(wildcard_tuple);
     if (wildcard_match.has_value())
         return { *wildcard_match.value() };
 
@@ -106,53 +113,99 @@ RefPtr<TCPSocket> TCPSocket::from_endpoints(const IPv4Address& local_address, u1
     return from_tuple(IPv4SocketTuple(local_address, local_port, peer_address, peer_port));
 }
 
+static Lockable<u32>* create_max_syn_backlog()
+{
+    return new Lockable<u32>(256);
+}
+
+static AK::Singleton<Lockable<u32>, create_max_syn_backlog> s_max_syn_backlog;
+
+Lockable<u32>& TCPSocket::max_syn_backlog()
+{
+    return *s_max_syn_backlog;
+}
+
+bool TCPSocket::can_queue_connection_request()
+{
+    VERIFY(m_state == State::Listen);
+
+    // Half-open connections that gave up are only dropped from the SYN queue here. They're
+    // released after letting go of the lock, since destroying them takes the socket table locks.
+    Vector<NonnullRefPtr<TCPSocket>> closed_connections;
+    size_t syn_queue_size = 0;
+    {
+        LOCKER(m_pending_release_for_accept.lock());
+        auto& pending = m_pending_release_for_accept.resource();
+        for (auto& it : pending) {
+            if (it.value->state() == State::Closed)
+                closed_connections.append(it.value);
+        }
+        for (auto& client : closed_connections)
+            pending.remove(client->tuple());
+        syn_queue_size = pending.size();
+    }
+
+    if (pending_connection_count() >= backlog())
+        return false;
+    return syn_queue_size < min(backlog(), (size_t)max_syn_backlog().lock_and_copy());
+}
+
 RefPtr<TCPSocket> TCPSocket::create_client(const IPv4Address& new_local_address, u16 new_local_port, const IPv4Address& new_peer_address, u16 new_peer_port)
 {
     auto tuple = IPv4SocketTuple(new_local_address, new_local_port, new_peer_address, new_peer_port);
 
-    LOCKER(sockets_by_tuple().lock());
-    if (sockets_by_tuple().resource().contains(tuple))
-        return {};
-
-    auto client = TCPSocket::create(protocol());
+    return sockets_by_tuple().with_shard_locked(tuple, [&](auto& sockets) -> RefPtr<TCPSocket> {
+        if (sockets.contains(tuple))
+            return {};
 
-    client->set_setup_state(SetupState::InProgress);
-    client->set_local_address(new_local_address);
-    client->set_local_port(new_local_port);
-    client->set_peer_address(new_peer_address);
-    client->set_peer_port(new_peer_port);
-    client->set_direction(Direction::Incoming);
-    client->set_originator(*this);
+        auto client = TCPSocket::create(protocol());
 
-    m_pending_release_for_accept.set(tuple, client);
-    sockets_by_tuple().resource().set(tuple, client);
+        client->set_setup_state(SetupState::InProgress);
+        client->set_local_address(new_local_address);
+        client->set_local_port(new_local_port);
+        client->set_peer_address(new_peer_address);
+        client->set_peer_port(new_peer_port);
+        client->set_direction(Direction::Incoming);
+        client->set_originator(*this);
 
-    return from_tuple(tuple);
+        {
+            LOCKER(m_pending_release_for_accept.lock());
+            m_pending_release_for_accept.resource().set(tuple, client);
+        }
+        sockets.set(tuple, client);
+        return client;
+    });
 }
 
-void TCPSocket::release_to_originator()
+KResult TCPSocket::release_to_originator()
 {
     VERIFY(!!m_originator);
-    m_originator.strong_ref()->release_for_accept(this);
+    return m_originator.strong_ref()->release_for_accept(this);
 }
 
-void TCPSocket::release_for_accept(RefPtr<TCPSocket> socket)
+KResult TCPSocket::release_for_accept(RefPtr<TCPSocket> socket)
 {
-    VERIFY(m_pending_release_for_accept.contains(socket->tuple()));
-    m_pending_release_for_accept.remove(socket->tuple());
-    // FIXME: Should we observe this error somehow?
-    [[maybe_unused]] auto rc = queue_connection_from(*socket);
+    {
+        LOCKER(m_pending_release_for_accept.lock());
+        VERIFY(m_pending_release_for_accept.resource().contains(socket->tuple()));
+        m_pending_release_for_accept.resource().remove(socket->tuple());
+    }
+    return queue_connection_from(*socket);
 }
 
 TCPSocket::TCPSocket(int protocol)
     : IPv4Socket(SOCK_STREAM, protocol)
+    , m_congestion_controller(TCPCongestionController::create(default_maximum_segment_size))
 {
+    // Scale our window far enough that the whole receive buffer can be advertised.
+    while (m_receive_window_shift < 14 && (receive_buffer_capacity() >> m_receive_window_shift) > NumericLimits<u16>::max())
+        ++m_receive_window_shift;
 }
 
 TCPSocket::~TCPSocket()
 {
-    LOCKER(sockets_by_tuple().lock());
-    sockets_by_tuple().resource().remove(tuple());
+    sockets_by_tuple().remove(tuple(), this);
+    listening_sockets().remove(tuple(), this);
 
     dbgln_if(TCP_SOCKET_DEBUG, "~TCPSocket in state {}", to_string(state()));
 }
@@ -162,141 +215,845 @@ NonnullRefPtr<TCPSocket> TCPSocket::create(int protocol)
     return adopt(*new TCPSocket(protocol));
 }
 
-KResultOr<size_t> TCPSocket::protocol_receive(ReadonlyBytes raw_ipv4_packet, UserOrKernelBuffer& buffer, size_t buffer_size, [[maybe_unused]] int flags)
+ReadonlyBytes TCPSocket::protocol_payload(ReadonlyBytes raw_ipv4_packet) const
 {
     auto& ipv4_packet = *reinterpret_cast<const IPv4Packet*>(raw_ipv4_packet.data());
     auto& tcp_packet = *static_cast<const TCPPacket*>(ipv4_packet.payload());
     size_t payload_size = raw_ipv4_packet.size() - sizeof(IPv4Packet) - tcp_packet.header_size();
+    return { tcp_packet.payload(), payload_size };
+}
+
+KResultOr<size_t> TCPSocket::protocol_receive(ReadonlyBytes raw_ipv4_packet, UserOrKernelBuffer& buffer, size_t buffer_size, [[maybe_unused]] int flags)
+{
+    auto payload = protocol_payload(raw_ipv4_packet);
 #if TCP_SOCKET_DEBUG
-    klog() << "payload_size " << payload_size << ", will it fit in " << buffer_size << "?";
+    klog() << "payload_size " << payload.size() << ", will it fit in " << buffer_size << "?";
 #endif
-    VERIFY(buffer_size >= payload_size);
-    if (!buffer.write(tcp_packet.payload(), payload_size))
+    VERIFY(buffer_size >= payload.size());
+    if (!buffer.write(payload.data(), payload.size()))
         return EFAULT;
-    return payload_size;
+    return payload.size();
 }
 
 KResultOr<size_t> TCPSocket::protocol_send(const UserOrKernelBuffer& data, size_t data_length)
 {
-    int err = send_tcp_packet(TCPFlags::PUSH | TCPFlags::ACK, &data, data_length);
-    if (err < 0)
-        return KResult((ErrnoCode)-err);
-    return data_length;
+    auto nsent_directly_or_error = send_to_loopback_peer(data, data_length);
+    if (nsent_directly_or_error.is_error() || nsent_directly_or_error.value() > 0)
+        return nsent_directly_or_error;
+
+    size_t segment_size = send_segment_size();
+
+    LOCKER(m_not_acked_lock);
+    // Small writes in a row end up in the same segment, as long as it hasn't been sent yet.
+    auto nappended_or_error = append_to_last_unsent_packet(data, data_length, segment_size);
+    if (nappended_or_error.is_error())
+        return nappended_or_error;
+    size_t nqueued = nappended_or_error.value();
+    while (nqueued < data_length) {
+        size_t chunk_size = min(data_length - nqueued, segment_size);
+        auto chunk = data.offset(nqueued);
+        auto result = queue_packet(TCPFlags::PUSH | TCPFlags::ACK, &chunk, chunk_size);
+        if (result.is_error()) {
+            if (nqueued == 0)
+                return result;
+            break;
+        }
+        nqueued += chunk_size;
+    }
+    send_queued_packets();
+    return nqueued;
+}
+
+// When both ends of a connection are on this machine, there's no need to wrap the data into segments
+// and have NetworkTask unwrap them again: it goes straight into the peer's receive buffer, and both
+// sides account for it as if it had been sent and acknowledged. Returns 0 whenever that isn't possible
+// right now, in which case the data takes the regular path.
+KResultOr<size_t> TCPSocket::send_to_loopback_peer(const UserOrKernelBuffer& data, size_t data_length)
+{
+    auto can_send_directly = [&](TCPSocket& peer) {
+        if (m_state != State::Established || peer.m_state != State::Established)
+            return false;
+        {
+            LOCKER(m_not_acked_lock);
+            if (!m_unsent.is_empty() || !m_not_acked.is_empty())
+                return false;
+        }
+        // Anything the peer hasn't received in order yet has to be sorted out by the regular path first.
+        return peer.m_ack_number == m_send_next && peer.m_out_of_order_segments.is_empty();
+    };
+
+    if (data_length == 0 || m_state != State::Established)
+        return 0;
+    auto routing_decision = route_to(peer_address(), local_address(), bound_interface());
+    if (routing_decision.is_zero() || routing_decision.adapter.ptr() != &LoopbackAdapter::the())
+        return 0;
+    auto peer = from_endpoints(peer_address(), peer_port(), local_address(), local_port());
+    if (!peer || peer == this)
+        return 0;
+
+    // Both ends may be sending to each other at the same time, so take the two socket locks in
+    // address order. That means briefly letting go of our own if the peer's comes first.
+    u32 lock_count_to_restore = 0;
+    auto previous_lock_mode = Lock::Mode::Unlocked;
+    if (peer.ptr() < this)
+        previous_lock_mode = lock().force_unlock_if_locked(lock_count_to_restore);
+    Locker peer_locker(peer->lock());
+    if (previous_lock_mode != Lock::Mode::Unlocked)
+        lock().restore_lock(previous_lock_mode, lock_count_to_restore);
+
+    if (!can_send_directly(*peer))
+        return 0;
+
+    auto nwritten_or_error = peer->receive_bytes_directly(data, data_length);
+    if (nwritten_or_error.is_error() || nwritten_or_error.value() == 0)
+        return nwritten_or_error;
+    size_t nwritten = nwritten_or_error.value();
+
+    m_sequence_number += nwritten;
+    m_send_next += nwritten;
+    m_send_unacknowledged += nwritten;
+    peer->m_ack_number += nwritten;
+
+    // The peer tells us about its window as soon as it reads from the buffer again.
+    peer->m_last_advertised_window = peer->receive_buffer_space();
+    m_send_window = peer->m_last_advertised_window;
+
+    ++m_packets_out;
+    m_bytes_out += nwritten;
+    ++peer->m_packets_in;
+    peer->m_bytes_in += nwritten;
+
+    dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}) handed {} bytes directly to {}", this, nwritten, peer.ptr());
+    return nwritten;
 }
 
 KResult TCPSocket::send_tcp_packet(u16 flags, const UserOrKernelBuffer* payload, size_t payload_size)
 {
-    const size_t buffer_size = sizeof(TCPPacket) + payload_size;
+    // Anything that occupies sequence space is kept around until the peer acknowledges it.
+    if ((flags & (TCPFlags::SYN | TCPFlags::FIN)) || payload_size > 0) {
+        LOCKER(m_not_acked_lock);
+        auto result = queue_packet(flags, payload, payload_size);
+        if (result.is_error())
+            return result;
+        send_queued_packets();
+        return KSuccess;
+    }
+
+    return transmit_packet(m_send_next, flags, {});
+}
+
+KResult TCPSocket::queue_packet(u16 flags, const UserOrKernelBuffer* payload, size_t payload_size)
+{
+    OutgoingPacket packet;
+    packet.sequence_number = m_sequence_number;
+    packet.flags = flags;
+    if (payload_size > 0) {
+        packet.payload = ByteBuffer::create_uninitialized(payload_size);
+        if (!payload->read(packet.payload.data(), payload_size))
+            return EFAULT;
+    }
+    m_sequence_number = packet.end_sequence_number();
+    m_unsent.append(move(packet));
+    return KSuccess;
+}
+
+KResultOr<size_t> TCPSocket::append_to_last_unsent_packet(const UserOrKernelBuffer& payload, size_t payload_size, size_t segment_size)
+{
+    if (m_unsent.is_empty())
+        return 0;
+    // Anything that has been transmitted before has to be retransmitted as it was.
+    auto& packet = m_unsent.last();
+    if (packet.flags != (TCPFlags::PUSH | TCPFlags::ACK) || packet.tx_counter > 0 || packet.payload.size() >= segment_size)
+        return 0;
+
+    size_t old_size = packet.payload.size();
+    size_t nappended = min(payload_size, segment_size - old_size);
+    packet.payload.grow(old_size + nappended);
+    if (!payload.read(packet.payload.data() + old_size, nappended)) {
+        packet.payload.trim(old_size);
+        return EFAULT;
+    }
+    m_sequence_number += nappended;
+    return nappended;
+}
+
+u32 TCPSocket::send_segment_size() const
+{
+    // Leave room for the timestamp option, which every segment carries once it's been negotiated.
+    return m_send_maximum_segment_size - (m_timestamps_enabled ? 12 : 0);
+}
+
+bool TCPSocket::should_hold_back(const OutgoingPacket& packet, u64 now)
+{
+    // Only the last queued segment can be short, everything before it was filled up.
+    if (packet.flags != (TCPFlags::PUSH | TCPFlags::ACK) || packet.tx_counter > 0 || packet.payload.size() >= send_segment_size() || &packet != &m_unsent.last())
+        return false;
+    if (!m_cork && (m_no_delay || m_not_acked.is_empty()))
+        return false;
+
+    if (!m_held_back_since_ms)
+        m_held_back_since_ms = now;
+    // Nagle lets go once everything in flight has been acknowledged, a cork only after a while.
+    return !m_cork || now - m_held_back_since_ms < cork_timeout_ms;
+}
+
+KResult TCPSocket::transmit_packet(u32 sequence_number, u16 flags, ReadonlyBytes payload, u16 segment_size)
+{
+    auto routing_decision = route_to(peer_address(), local_address(), bound_interface());
+    if (routing_decision.is_zero())
+        return EHOSTUNREACH;
+    auto& adapter = *routing_decision.adapter;
+
+    u8 options[TCPOptions::max_options_size];
+    size_t options_size = build_tcp_options(flags, options);
+    VERIFY(options_size % sizeof(u32) == 0);
+
+    const size_t header_size = sizeof(TCPPacket) + options_size;
+    const size_t buffer_size = header_size + payload.size();
     auto buffer = ByteBuffer::create_zeroed(buffer_size);
     auto& tcp_packet = *(TCPPacket*)(buffer.data());
     VERIFY(local_port());
     tcp_packet.set_source_port(local_port());
     tcp_packet.set_destination_port(peer_port());
-    tcp_packet.set_window_size(1024);
-    tcp_packet.set_sequence_number(m_sequence_number);
-    tcp_packet.set_data_offset(sizeof(TCPPacket) / sizeof(u32));
+    tcp_packet.set_window_size(window_to_advertise(flags));
+    tcp_packet.set_sequence_number(sequence_number);
+    tcp_packet.set_data_offset(header_size / sizeof(u32));
     tcp_packet.set_flags(flags);
 
-    if (flags & TCPFlags::ACK)
+    if (flags & TCPFlags::ACK) {
         tcp_packet.set_ack_number(m_ack_number);
-
-    if (payload && !payload->read(tcp_packet.payload(), payload_size))
-        return EFAULT;
-
-    if (flags & TCPFlags::SYN) {
-        ++m_sequence_number;
-    } else {
-        m_sequence_number += payload_size;
+        // Whatever ACK we were holding back goes along with this segment.
+        m_delayed_ack_deadline_ms = 0;
+        m_segments_received_since_ack = 0;
     }
 
-    tcp_packet.set_checksum(compute_tcp_checksum(local_address(), peer_address(), tcp_packet, payload_size));
-
-    if (tcp_packet.has_syn() || payload_size > 0) {
-        LOCKER(m_not_acked_lock);
-        m_not_acked.append({ m_sequence_number, move(buffer) });
-        send_outgoing_packets();
-        return KSuccess;
+    memcpy(tcp_packet.options(), options, options_size);
+    if (!payload.is_empty())
+        memcpy(tcp_packet.payload(), payload.data(), payload.size());
+
+    // With checksum offload (which segmentation offload implies), the adapter only needs the
+    // pseudo-header sum to finish the job. For segmentation, that sum leaves out the length,
+    // since the adapter adds in that of each segment it cuts.
+    TransmitOffload offload;
+    if (segment_size) {
+        VERIFY(adapter.has_offload(NetworkOffload::TCPSegmentation));
+        offload.segment_size = segment_size;
+        offload.header_size = header_size;
+    }
+    if (segment_size || adapter.has_offload(NetworkOffload::TransmitChecksum)) {
+        offload.needs_checksum = true;
+        offload.checksum_offset = tcp_checksum_offset;
+        tcp_packet.set_checksum(compute_tcp_pseudo_header_checksum(local_address(), peer_address(), segment_size ? 0 : buffer_size));
+    } else {
+        tcp_packet.set_checksum(compute_tcp_checksum(local_address(), peer_address(), tcp_packet, payload.size()));
     }
 
-    auto routing_decision = route_to(peer_address(), local_address(), bound_interface());
-    VERIFY(!routing_decision.is_zero());
+    dbgln_if(TCP_SOCKET_DEBUG, "sending tcp packet from {}:{} to {}:{} with ({}{}{}{}) seq_no={}, ack_no={}, window={}, payload_size={}",
+        local_address(), local_port(), peer_address(), peer_port(),
+        tcp_packet.has_syn() ? "SYN " : "",
+        tcp_packet.has_ack() ? "ACK " : "",
+        tcp_packet.has_fin() ? "FIN " : "",
+        tcp_packet.has_rst() ? "RST " : "",
+        sequence_number, tcp_packet.ack_number(), tcp_packet.window_size(), payload.size());
 
     auto packet_buffer = UserOrKernelBuffer::for_kernel_buffer(buffer.data());
-    auto result = routing_decision.adapter->send_ipv4(
+    auto result = adapter.send_ipv4(
         routing_decision.next_hop, peer_address(), IPv4Protocol::TCP,
-        packet_buffer, buffer_size, ttl());
-    if (result.is_error())
+        packet_buffer, buffer_size, ttl(), offload);
+    if (result.is_error()) {
+        dbgln("TCPSocket({}): Error ({}) sending tcp packet to {}:{}, seq_no={}", this, result.error(), peer_address(), peer_port(), sequence_number);
         return result;
+    }
 
     m_packets_out++;
     m_bytes_out += buffer_size;
     return KSuccess;
 }
 
-void TCPSocket::send_outgoing_packets()
+size_t TCPSocket::build_tcp_options(u16 flags, u8* options)
+{
+    size_t size = 0;
+    auto append_u8 = [&](u8 value) { options[size++] = value; };
+    auto append_u16 = [&](u16 value) {
+        append_u8(value >> 8);
+        append_u8(value & 0xff);
+    };
+    auto append_u32 = [&](u32 value) {
+        append_u16(value >> 16);
+        append_u16(value & 0xffff);
+    };
+    auto append_timestamp = [&] {
+        append_u8(TCPOptionKind::NoOperation);
+        append_u8(TCPOptionKind::NoOperation);
+        append_u8(TCPOptionKind::Timestamp);
+        append_u8(10);
+        append_u32((u32)TimeManagement::the().uptime_ms());
+        append_u32(m_timestamp_recent);
+    };
+
+    if (flags & TCPFlags::SYN) {
+        // A SYN offers everything we support, a SYN-ACK only agrees to what the peer offered.
+        bool is_offer = !(flags & TCPFlags::ACK);
+        append_u8(TCPOptionKind::MaximumSegmentSize);
+        append_u8(4);
+        append_u16(local_maximum_segment_size());
+        if (is_offer || m_sack_permitted) {
+            append_u8(TCPOptionKind::NoOperation);
+            append_u8(TCPOptionKind::NoOperation);
+            append_u8(TCPOptionKind::SACKPermitted);
+            append_u8(2);
+        }
+        if (is_offer || m_timestamps_enabled)
+            append_timestamp();
+        if (is_offer || m_window_scaling_enabled) {
+            append_u8(TCPOptionKind::NoOperation);
+            append_u8(TCPOptionKind::WindowScale);
+            append_u8(3);
+            append_u8(m_receive_window_shift);
+        }
+        return size;
+    }
+
+    if (m_timestamps_enabled)
+        append_timestamp();
+
+    if (m_sack_permitted && (flags & TCPFlags::ACK) && !m_out_of_order_segments.is_empty()) {
+        TCPSACKBlock blocks[TCPOptions::max_sack_blocks];
+        size_t max_blocks = min((TCPOptions::max_options_size - size - 4) / 8, TCPOptions::max_sack_blocks);
+        size_t block_count = collect_sack_blocks(blocks, max_blocks);
+        append_u8(TCPOptionKind::NoOperation);
+        append_u8(TCPOptionKind::NoOperation);
+        append_u8(TCPOptionKind::SACK);
+        append_u8(2 + block_count * 8);
+        for (size_t i = 0; i < block_count; ++i) {
+            append_u32(blocks[i].left_edge);
+            append_u32(blocks[i].right_edge);
+        }
+    }
+
+    return size;
+}
+
+u16 TCPSocket::window_to_advertise(u16 flags)
 {
+    // The window in a SYN is never scaled (RFC 7323, section 2.2).
+    u8 shift = (flags & TCPFlags::SYN) ? 0 : m_receive_window_shift;
+    size_t window = min(receive_buffer_space() >> shift, (size_t)NumericLimits<u16>::max());
+    m_last_advertised_window = window << shift;
+    return window;
+}
+
+u32 TCPSocket::local_maximum_segment_size() const
+{
+    constexpr size_t headers_size = sizeof(IPv4Packet) + sizeof(TCPPacket);
     auto routing_decision = route_to(peer_address(), local_address(), bound_interface());
-    VERIFY(!routing_decision.is_zero());
+    if (routing_decision.is_zero())
+        return default_maximum_segment_size;
+    return min((size_t)routing_decision.adapter->mtu(), (size_t)NumericLimits<u16>::max()) - headers_size;
+}
 
-    auto now = kgettimeofday();
+void TCPSocket::negotiate_options(const TCPPacket& syn_packet)
+{
+    auto options = TCPOptions::parse(syn_packet.options());
 
-    LOCKER(m_not_acked_lock, Lock::Mode::Shared);
-    for (auto& packet : m_not_acked) {
-        timeval diff;
-        timeval_sub(packet.tx_time, now, diff);
-        if (diff.tv_sec == 0 && diff.tv_usec <= 500000)
-            continue;
-        packet.tx_time = now;
-        packet.tx_counter++;
+    u32 peer_maximum_segment_size = options.maximum_segment_size ? options.maximum_segment_size : default_maximum_segment_size;
+    m_send_maximum_segment_size = min(peer_maximum_segment_size, local_maximum_segment_size());
 
-#if TCP_SOCKET_DEBUG
-        auto& tcp_packet = *(TCPPacket*)(packet.buffer.data());
-        klog() << "sending tcp packet from " << local_address().to_string().characters() << ":" << local_port() << " to " << peer_address().to_string().characters() << ":" << peer_port() << " with (" << (tcp_packet.has_syn() ? "SYN " : "") << (tcp_packet.has_ack() ? "ACK " : "") << (tcp_packet.has_fin() ? "FIN " : "") << (tcp_packet.has_rst() ? "RST " : "") << ") seq_no=" << tcp_packet.sequence_number() << ", ack_no=" << tcp_packet.ack_number() << ", tx_counter=" << packet.tx_counter;
-#endif
-        auto packet_buffer = UserOrKernelBuffer::for_kernel_buffer(packet.buffer.data());
-        int err = routing_decision.adapter->send_ipv4(
-            routing_decision.next_hop, peer_address(), IPv4Protocol::TCP,
-            packet_buffer, packet.buffer.size(), ttl());
-        if (err < 0) {
-            auto& tcp_packet = *(TCPPacket*)(packet.buffer.data());
-            klog() << "Error (" << err << ") sending tcp packet from " << local_address().to_string().characters() << ":" << local_port() << " to " << peer_address().to_string().characters() << ":" << peer_port() << " with (" << (tcp_packet.has_syn() ? "SYN " : "") << (tcp_packet.has_ack() ? "ACK " : "") << (tcp_packet.has_fin() ? "FIN " : "") << (tcp_packet.has_rst() ? "RST " : "") << ") seq_no=" << tcp_packet.sequence_number() << ", ack_no=" << tcp_packet.ack_number() << ", tx_counter=" << packet.tx_counter;
+    // Window scaling only applies if both sides ask for it.
+    m_window_scaling_enabled = options.has_window_scale;
+    if (m_window_scaling_enabled) {
+        m_send_window_shift = min(options.window_scale, (u8)14);
+    } else {
+        m_send_window_shift = 0;
+        m_receive_window_shift = 0;
+    }
+
+    m_sack_permitted = options.sack_permitted;
+    m_timestamps_enabled = options.has_timestamp;
+    if (m_timestamps_enabled)
+        m_timestamp_recent = options.timestamp_value;
+
+    m_send_window = syn_packet.window_size();
+    m_congestion_controller = TCPCongestionController::create(m_send_maximum_segment_size);
+
+    dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}): negotiated mss={}, window_scale={}/{}, sack={}, timestamps={}, congestion_control={}",
+        this, m_send_maximum_segment_size, m_send_window_shift, m_receive_window_shift, m_sack_permitted, m_timestamps_enabled, m_congestion_controller->name());
+}
+
+void TCPSocket::send_outgoing_packets()
+{
+    LOCKER(m_not_acked_lock);
+
+    if (m_state == State::Closed) {
+        m_not_acked.clear();
+        m_unsent.clear();
+        return;
+    }
+
+    auto now = TimeManagement::the().uptime_ms();
+    if (m_delayed_ack_deadline_ms && now >= m_delayed_ack_deadline_ms)
+        [[maybe_unused]] auto rc = send_tcp_packet(TCPFlags::ACK);
+    if (m_cork && m_held_back_since_ms && now - m_held_back_since_ms >= cork_timeout_ms)
+        send_queued_packets();
+
+    if (!m_not_acked.is_empty()) {
+        if (now - m_not_acked.first().tx_time_ms < m_retransmission_timeout_ms)
+            return;
+        int retransmission_limit = m_state == State::SynReceived ? max_syn_ack_retransmissions : max_retransmissions;
+        if (m_not_acked.first().tx_counter > retransmission_limit) {
+            dbgln("TCPSocket({}): Giving up on {}:{} after {} retransmissions", this, peer_address(), peer_port(), retransmission_limit);
+            m_not_acked.clear();
+            m_unsent.clear();
+            set_state(State::Closed);
+            return;
+        }
+        handle_retransmission_timeout();
+        send_queued_packets();
+        return;
+    }
+
+    // Nothing is in flight, so anything still queued was held back by the peer's window.
+    // Send it anyway once in a while, so we learn when the window opens again.
+    if (!m_unsent.is_empty() && now - m_last_window_probe_ms >= m_retransmission_timeout_ms) {
+        m_last_window_probe_ms = now;
+        send_queued_packets(true);
+    }
+}
+
+bool TCPSocket::fits_send_windows(const OutgoingPacket& packet, u32 bytes_in_flight) const
+{
+    u32 size = packet.payload.size();
+    if (bytes_in_flight + size > congestion_window())
+        return false;
+    return (packet.sequence_number - m_send_unacknowledged) + size <= m_send_window;
+}
+
+void TCPSocket::send_queued_packets(bool force_first)
+{
+    // With segmentation offload, runs of data packets go to the adapter as one large packet.
+    size_t max_batch_size = 0;
+    auto routing_decision = route_to(peer_address(), local_address(), bound_interface());
+    if (!routing_decision.is_zero() && routing_decision.adapter->has_offload(NetworkOffload::TCPSegmentation))
+        max_batch_size = routing_decision.adapter->max_segmentation_size() - sizeof(IPv4Packet) - sizeof(TCPPacket) - TCPOptions::max_options_size;
+
+    auto now = TimeManagement::the().uptime_ms();
+    while (!m_unsent.is_empty()) {
+        auto& packet = m_unsent.first();
+        if (!force_first && (!fits_send_windows(packet, bytes_in_flight()) || should_hold_back(packet, now)))
+            break;
+        force_first = false;
+        m_held_back_since_ms = 0;
+
+        // The adapter cuts at segment_size boundaries, so only the last packet of a batch may be
+        // shorter, and all of them have to be plain data packets with the same flags.
+        size_t segment_size = packet.payload.size();
+        size_t batch_count = 1;
+        size_t batch_size = segment_size;
+        if (max_batch_size && segment_size > 0 && !(packet.flags & (TCPFlags::SYN | TCPFlags::FIN | TCPFlags::RST))) {
+            u32 projected_bytes_in_flight = bytes_in_flight() + segment_size;
+            size_t previous_size = segment_size;
+            bool is_first = true;
+            for (auto& next : m_unsent) {
+                if (is_first) {
+                    is_first = false;
+                    continue;
+                }
+                if (previous_size != segment_size || next.flags != packet.flags || next.payload.is_empty() || next.payload.size() > segment_size)
+                    break;
+                if (batch_size + next.payload.size() > max_batch_size || !fits_send_windows(next, projected_bytes_in_flight))
+                    break;
+                projected_bytes_in_flight += next.payload.size();
+                batch_size += next.payload.size();
+                previous_size = next.payload.size();
+                ++batch_count;
+            }
+        }
+
+        KResult result = KSuccess;
+        if (batch_count == 1) {
+            result = transmit_packet(packet.sequence_number, packet.flags, packet.payload.bytes());
         } else {
-            m_packets_out++;
-            m_bytes_out += packet.buffer.size();
+            auto batch = ByteBuffer::create_uninitialized(batch_size);
+            size_t offset = 0;
+            size_t index = 0;
+            for (auto& batched_packet : m_unsent) {
+                if (index++ == batch_count)
+                    break;
+                memcpy(batch.data() + offset, batched_packet.payload.data(), batched_packet.payload.size());
+                offset += batched_packet.payload.size();
+            }
+            result = transmit_packet(packet.sequence_number, packet.flags, batch.bytes(), segment_size);
         }
+
+        // Even if the adapter refused them, the packets now wait for their retransmission timer.
+        for (size_t i = 0; i < batch_count; ++i) {
+            auto& sent_packet = m_unsent.first();
+            sent_packet.tx_counter++;
+            sent_packet.tx_time_ms = now;
+            u32 end_sequence_number = sent_packet.end_sequence_number();
+            m_not_acked.append(m_unsent.take_first());
+            if (tcp_sequence_less_than(m_send_next, end_sequence_number))
+                m_send_next = end_sequence_number;
+            if (tcp_sequence_less_than(m_send_max, end_sequence_number))
+                m_send_max = end_sequence_number;
+        }
+        if (result.is_error())
+            break;
+    }
+}
+
+void TCPSocket::retransmit_packet(OutgoingPacket& packet)
+{
+    dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}): retransmitting seq_no={}, tx_counter={}", this, packet.sequence_number, packet.tx_counter);
+    [[maybe_unused]] auto result = transmit_packet(packet.sequence_number, packet.flags, packet.payload.bytes());
+    packet.tx_counter++;
+    packet.tx_time_ms = TimeManagement::the().uptime_ms();
+}
+
+void TCPSocket::handle_retransmission_timeout()
+{
+    dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}): retransmission timeout after {}ms, seq_no={}", this, m_retransmission_timeout_ms, m_send_unacknowledged);
+
+    m_congestion_controller->did_time_out(bytes_in_flight());
+    m_retransmission_timeout_ms = min(m_retransmission_timeout_ms * 2, maximum_retransmission_timeout_ms);
+
+    // Everything in flight is presumed lost and goes back to the front of the send queue.
+    // SACK information is discarded as well, the peer is allowed to renege on it (RFC 2018, section 8).
+    while (!m_unsent.is_empty())
+        m_not_acked.append(m_unsent.take_first());
+    while (!m_not_acked.is_empty()) {
+        auto packet = m_not_acked.take_first();
+        packet.sacked = false;
+        packet.retransmitted_in_recovery = false;
+        m_unsent.append(move(packet));
+    }
+    m_send_next = m_send_unacknowledged;
+    m_sacked_bytes = 0;
+    m_highest_sacked = m_send_unacknowledged;
+}
+
+void TCPSocket::update_round_trip_time(u32 sample_ms)
+{
+    // RFC 6298, section 2.
+    if (!m_has_round_trip_time_sample) {
+        m_smoothed_round_trip_time_ms = sample_ms;
+        m_round_trip_time_variance_ms = sample_ms / 2;
+        m_has_round_trip_time_sample = true;
+    } else {
+        u32 delta = sample_ms > m_smoothed_round_trip_time_ms ? sample_ms - m_smoothed_round_trip_time_ms : m_smoothed_round_trip_time_ms - sample_ms;
+        m_round_trip_time_variance_ms = (3 * m_round_trip_time_variance_ms + delta) / 4;
+        m_smoothed_round_trip_time_ms = (7 * m_smoothed_round_trip_time_ms + sample_ms) / 8;
     }
+    u32 retransmission_timeout_ms = m_smoothed_round_trip_time_ms + max(1u, 4 * m_round_trip_time_variance_ms);
+    m_retransmission_timeout_ms = min(max(retransmission_timeout_ms, minimum_retransmission_timeout_ms), maximum_retransmission_timeout_ms);
 }
 
 void TCPSocket::receive_tcp_packet(const TCPPacket& packet, u16 size)
 {
-    if (packet.has_ack()) {
-        u32 ack_number = packet.ack_number();
+    auto options = TCPOptions::parse(packet.options());
+    size_t payload_size = size - packet.header_size();
 
-        dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: receive_tcp_packet: {}", ack_number);
+    if (packet.has_syn() && m_state == State::SynSent)
+        negotiate_options(packet);
 
-        int removed = 0;
-        LOCKER(m_not_acked_lock);
-        while (!m_not_acked.is_empty()) {
-            auto& packet = m_not_acked.first();
+    // Remember the peer's clock from segments at the left edge of our window, so we echo the right one (RFC 7323, section 4.3).
+    if (m_timestamps_enabled && options.has_timestamp && tcp_sequence_less_or_equal(packet.sequence_number(), m_ack_number))
+        m_timestamp_recent = options.timestamp_value;
+
+    if (packet.has_ack())
+        process_ack(packet, options, payload_size);
+
+    m_packets_in++;
+    m_bytes_in += packet.header_size() + size;
+}
+
+void TCPSocket::process_ack(const TCPPacket& packet, const TCPOptions& options, size_t payload_size)
+{
+    u32 ack_number = packet.ack_number();
 
-            dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: iterate: {}", packet.ack_number);
+    dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: receive_tcp_packet: {}", ack_number);
 
-            if (packet.ack_number <= ack_number) {
-                m_not_acked.take_first();
+    LOCKER(m_not_acked_lock);
+
+    // Ignore stale ACKs, and ones for data we never sent.
+    if (tcp_sequence_less_than(m_send_max, ack_number) || tcp_sequence_less_than(ack_number, m_send_unacknowledged))
+        return;
+
+    u32 previous_send_window = m_send_window;
+    m_send_window = (u32)packet.window_size() << (packet.has_syn() ? 0 : m_send_window_shift);
+
+    bool sacked_new_data = m_sack_permitted && process_sack_blocks(options);
+
+    auto now = TimeManagement::the().uptime_ms();
+    auto action = TCPCongestionController::Action::None;
+
+    if (ack_number == m_send_unacknowledged) {
+        bool is_duplicate = payload_size == 0 && !packet.has_syn() && !packet.has_fin() && m_send_window == previous_send_window && !m_not_acked.is_empty();
+        if (is_duplicate)
+            action = m_congestion_controller->did_receive_duplicate_ack(m_send_next, bytes_in_flight(), sacked_new_data);
+    } else {
+        u32 bytes_acked = ack_number - m_send_unacknowledged;
+        Optional<u32> round_trip_time_sample;
+
+        int removed = 0;
+        auto remove_acknowledged_packets = [&](auto& list) {
+            while (!list.is_empty() && tcp_sequence_less_or_equal(list.first().end_sequence_number(), ack_number)) {
+                auto acknowledged_packet = list.take_first();
+                if (acknowledged_packet.sacked)
+                    m_sacked_bytes -= acknowledged_packet.payload.size();
+                // Karn's algorithm: a retransmitted packet doesn't tell us which transmission was acknowledged.
+                if (acknowledged_packet.tx_counter == 1)
+                    round_trip_time_sample = now - acknowledged_packet.tx_time_ms;
+                else
+                    round_trip_time_sample.clear();
                 removed++;
-            } else {
-                break;
             }
+        };
+        remove_acknowledged_packets(m_not_acked);
+        // After a timeout, the peer may acknowledge packets we had put back into the send queue.
+        if (m_not_acked.is_empty())
+            remove_acknowledged_packets(m_unsent);
+
+        m_send_unacknowledged = ack_number;
+        if (tcp_sequence_less_than(m_send_next, ack_number))
+            m_send_next = ack_number;
+        if (tcp_sequence_less_than(m_highest_sacked, ack_number))
+            m_highest_sacked = ack_number;
+
+        // Timestamps give a sample even for retransmitted packets.
+        if (m_timestamps_enabled && options.has_timestamp && options.timestamp_echo_reply != 0)
+            round_trip_time_sample = (u32)now - options.timestamp_echo_reply;
+        if (round_trip_time_sample.has_value())
+            update_round_trip_time(round_trip_time_sample.value());
+
+        bool was_in_recovery = m_congestion_controller->is_in_recovery();
+        action = m_congestion_controller->did_receive_ack(ack_number, bytes_acked, bytes_in_flight());
+        if (was_in_recovery && !m_congestion_controller->is_in_recovery()) {
+            for (auto& outgoing_packet : m_not_acked)
+                outgoing_packet.retransmitted_in_recovery = false;
         }
 
-        dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: receive_tcp_packet acknowledged {} packets", removed);
+        dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: receive_tcp_packet acknowledged {} packets, cwnd={}, rto={}ms", removed, congestion_window(), m_retransmission_timeout_ms);
     }
 
-    m_packets_in++;
-    m_bytes_in += packet.header_size() + size;
+    if (action == TCPCongestionController::Action::RetransmitFirstUnacknowledged) {
+        for (auto& outgoing_packet : m_not_acked) {
+            if (outgoing_packet.sacked)
+                continue;
+            retransmit_packet(outgoing_packet);
+            outgoing_packet.retransmitted_in_recovery = true;
+            break;
+        }
+    } else if (m_sack_permitted && m_congestion_controller->is_in_recovery()) {
+        retransmit_next_sack_hole();
+    }
+
+    send_queued_packets();
 }
 
-NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(const IPv4Address& source, const IPv4Address& destination, const TCPPacket& packet, u16 payload_size)
+bool TCPSocket::process_sack_blocks(const TCPOptions& options)
+{
+    bool sacked_new_data = false;
+    for (size_t i = 0; i < options.sack_block_count; ++i) {
+        auto& block = options.sack_blocks[i];
+        if (!tcp_sequence_less_than(block.left_edge, block.right_edge))
+            continue;
+        if (tcp_sequence_less_or_equal(block.right_edge, m_send_unacknowledged) || tcp_sequence_less_than(m_send_max, block.right_edge))
+            continue;
+
+        for (auto& packet : m_not_acked) {
+            if (tcp_sequence_less_or_equal(block.right_edge, packet.sequence_number))
+                break;
+            if (packet.sacked || tcp_sequence_less_than(packet.sequence_number, block.left_edge) || tcp_sequence_less_than(block.right_edge, packet.end_sequence_number()))
+                continue;
+            packet.sacked = true;
+            m_sacked_bytes += packet.payload.size();
+            sacked_new_data = true;
+            if (tcp_sequence_less_than(m_highest_sacked, packet.end_sequence_number()))
+                m_highest_sacked = packet.end_sequence_number();
+        }
+    }
+    return sacked_new_data;
+}
+
+void TCPSocket::retransmit_next_sack_hole()
+{
+    // Anything below the highest SACKed packet that hasn't been SACKed itself was most likely lost.
+    for (auto& packet : m_not_acked) {
+        if (!tcp_sequence_less_than(packet.sequence_number, m_highest_sacked))
+            return;
+        if (packet.sacked || packet.retransmitted_in_recovery)
+            continue;
+        if (bytes_in_flight() + packet.payload.size() > congestion_window())
+            return;
+        retransmit_packet(packet);
+        packet.retransmitted_in_recovery = true;
+        return;
+    }
+}
+
+bool TCPSocket::receive_tcp_segment(const TCPPacket& tcp_packet, PacketBuffer& packet, size_t payload_size, const timeval& packet_timestamp)
+{
+    u32 sequence_number = tcp_packet.sequence_number();
+    size_t header_size = sizeof(IPv4Packet) + tcp_packet.header_size();
+    bool has_fin = tcp_packet.has_fin();
+
+    if (payload_size == 0 && !has_fin)
+        return false;
+
+    [[maybe_unused]] KResult rc = KSuccess;
+    u32 end_sequence_number = sequence_number + payload_size + (has_fin ? 1 : 0);
+    if (tcp_sequence_less_or_equal(end_sequence_number, m_ack_number)) {
+        // We already have all of this, so our ACK must have gotten lost.
+        rc = send_tcp_packet(TCPFlags::ACK);
+        return false;
+    }
+
+    if (tcp_sequence_less_than(m_ack_number, sequence_number)) {
+        // Something before this segment is missing. Hold on to it, and let the duplicate ACK
+        // (with SACK blocks, if the peer understands them) tell the peer what we're missing.
+        queue_out_of_order_segment(packet, header_size, sequence_number, payload_size, has_fin, packet_timestamp);
+        rc = send_tcp_packet(TCPFlags::ACK);
+        return false;
+    }
+
+    bool fills_hole = !m_out_of_order_segments.is_empty();
+    bool delivered = deliver_in_order_segment(packet, header_size, sequence_number, payload_size, packet_timestamp);
+    bool fin_reached = false;
+    if (delivered) {
+        fin_reached = has_fin;
+        // This may have filled a hole, so see how many of the queued segments follow now.
+        while (!fin_reached && !m_out_of_order_segments.is_empty()) {
+            if (tcp_sequence_less_than(m_ack_number, m_out_of_order_segments.first().sequence_number))
+                break;
+            auto segment = m_out_of_order_segments.take_first();
+            if (tcp_sequence_less_or_equal(segment.end_sequence_number(), m_ack_number))
+                continue;
+            if (!deliver_in_order_segment(*segment.packet, segment.header_size, segment.sequence_number, segment.payload_size, segment.timestamp))
+                break;
+            fin_reached = segment.has_fin;
+        }
+    }
+
+    if (fin_reached) {
+        ++m_ack_number;
+        m_out_of_order_segments.clear();
+    }
+
+#if TCP_DEBUG
+    klog() << "Got packet with seq_no=" << sequence_number << ", payload_size=" << payload_size << ", acking it with new ack_no=" << m_ack_number << ", seq_no=" << m_send_next;
+#endif
+
+    // The peer is waiting to hear about a filled hole, and about data we had to drop.
+    send_ack_now_or_later(fin_reached || fills_hole || !delivered);
+    return fin_reached;
+}
+
+void TCPSocket::send_ack_now_or_later(bool immediately)
+{
+    if (immediately || ++m_segments_received_since_ack >= 2) {
+        [[maybe_unused]] auto rc = send_tcp_packet(TCPFlags::ACK);
+        return;
+    }
+    if (!m_delayed_ack_deadline_ms)
+        m_delayed_ack_deadline_ms = TimeManagement::the().uptime_ms() + delayed_ack_timeout_ms;
+}
+
+bool TCPSocket::deliver_in_order_segment(PacketBuffer& packet, size_t header_size, u32 sequence_number, size_t payload_size, const timeval& packet_timestamp)
+{
+    VERIFY(tcp_sequence_less_or_equal(sequence_number, m_ack_number));
+    size_t overlap = m_ack_number - sequence_number;
+    if (overlap >= payload_size)
+        return true;
+
+    if (overlap > 0) {
+        // Slide the headers over the bytes we already have, so only new data reaches the receive buffer.
+        memmove(packet.data() + overlap, packet.data(), header_size);
+        packet.pull(overlap);
+        payload_size -= overlap;
+    }
+
+    if (!did_receive(peer_address(), peer_port(), packet, packet_timestamp))
+        return false;
+    m_ack_number += payload_size;
+    return true;
+}
+
+void TCPSocket::queue_out_of_order_segment(PacketBuffer& packet, size_t header_size, u32 sequence_number, size_t payload_size, bool has_fin, const timeval& packet_timestamp)
+{
+    if (sequence_number - m_ack_number >= receive_buffer_capacity())
+        return;
+
+    size_t index = 0;
+    for (; index < m_out_of_order_segments.size(); ++index) {
+        auto& segment = m_out_of_order_segments[index];
+        if (segment.sequence_number == sequence_number)
+            return;
+        if (tcp_sequence_less_than(sequence_number, segment.sequence_number))
+            break;
+    }
+    m_last_out_of_order_sequence = sequence_number;
+    if (m_out_of_order_segments.size() >= max_out_of_order_segments)
+        return;
+    m_out_of_order_segments.insert(index, { sequence_number, header_size, payload_size, has_fin, packet, packet_timestamp });
+}
+
+size_t TCPSocket::collect_sack_blocks(TCPSACKBlock* blocks, size_t max_blocks) const
+{
+    VERIFY(!m_out_of_order_segments.is_empty());
+
+    // Merge the queued segments into contiguous ranges.
+    TCPSACKBlock ranges[max_out_of_order_segments];
+    size_t range_count = 0;
+    for (auto& segment : m_out_of_order_segments) {
+        if (range_count > 0 && tcp_sequence_less_or_equal(segment.sequence_number, ranges[range_count - 1].right_edge)) {
+            if (tcp_sequence_less_than(ranges[range_count - 1].right_edge, segment.end_sequence_number()))
+                ranges[range_count - 1].right_edge = segment.end_sequence_number();
+            continue;
+        }
+        ranges[range_count++] = { segment.sequence_number, segment.end_sequence_number() };
+    }
+
+    // The first block has to be the one containing the most recently received segment (RFC 2018, section 4).
+    size_t most_recent = 0;
+    for (size_t i = 0; i < range_count; ++i) {
+        if (tcp_sequence_less_or_equal(ranges[i].left_edge, m_last_out_of_order_sequence) && tcp_sequence_less_than(m_last_out_of_order_sequence, ranges[i].right_edge))
+            most_recent = i;
+    }
+
+    size_t block_count = 0;
+    blocks[block_count++] = ranges[most_recent];
+    for (size_t i = 0; i < range_count && block_count < max_blocks; ++i) {
+        if (i != most_recent)
+            blocks[block_count++] = ranges[i];
+    }
+    return block_count;
+}
+
+void TCPSocket::protocol_did_read_from_receive_buffer()
+{
+    if (m_state != State::Established && m_state != State::FinWait1 && m_state != State::FinWait2)
+        return;
+
+    // Receiver-side silly window avoidance (RFC 1122, section 4.2.3.3): only tell the peer
+    // about the window once it has opened up by a meaningful amount.
+    size_t threshold = min(receive_buffer_capacity() / 2, 2 * (size_t)m_send_maximum_segment_size);
+    if (receive_buffer_space() >= m_last_advertised_window + threshold)
+        [[maybe_unused]] auto rc = send_tcp_packet(TCPFlags::ACK);
+}
+
+void TCPSocket::retransmit_timed_out_packets()
+{
+    Vector<NonnullRefPtr<TCPSocket>> sockets;
+    sockets_by_tuple().for_each([&](auto&, auto* socket) { sockets.append(*socket); });
+
+    for (auto& socket : sockets) {
+        LOCKER(socket->lock());
+        socket->send_outgoing_packets();
+    }
+}
+
+u16 TCPSocket::compute_tcp_pseudo_header_checksum(const IPv4Address& source, const IPv4Address& destination, u16 tcp_length)
 {
     struct [[gnu::packed]] PseudoHeader {
         IPv4Address source;
@@ -306,7 +1063,7 @@ NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(const IPv4Address& source, c
         NetworkOrdered<u16> payload_size;
     };
 
-    PseudoHeader pseudo_header { source, destination, 0, (u8)IPv4Protocol::TCP, sizeof(TCPPacket) + payload_size };
+    PseudoHeader pseudo_header { source, destination, 0, (u8)IPv4Protocol::TCP, tcp_length };
 
     u32 checksum = 0;
     auto* w = (const NetworkOrdered<u16>*)&pseudo_header;
@@ -315,13 +1072,20 @@ NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(const IPv4Address& source, c
         if (checksum > 0xffff)
             checksum = (checksum >> 16) + (checksum & 0xffff);
     }
-    w = (const NetworkOrdered<u16>*)&packet;
-    for (size_t i = 0; i < sizeof(packet) / sizeof(u16); ++i) {
+    return checksum;
+}
+
+NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(const IPv4Address& source, const IPv4Address& destination, const TCPPacket& packet, u16 payload_size)
+{
+    u32 checksum = compute_tcp_pseudo_header_checksum(source, destination, packet.header_size() + payload_size);
+
+    // The header includes any options, which are always padded to a multiple of 4 bytes.
+    auto* w = (const NetworkOrdered<u16>*)&packet;
+    for (size_t i = 0; i < packet.header_size() / sizeof(u16); ++i) {
         checksum += w[i];
         if (checksum > 0xffff)
             checksum = (checksum >> 16) + (checksum & 0xffff);
     }
-    VERIFY(packet.data_offset() * 4 == sizeof(TCPPacket));
     w = (const NetworkOrdered<u16>*)packet.payload();
     for (size_t i = 0; i < payload_size / sizeof(u16); ++i) {
         checksum += w[i];
@@ -337,6 +1101,61 @@ NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(const IPv4Address& source, c
     return ~(checksum & 0xffff);
 }
 
+KResult TCPSocket::setsockopt(int level, int option, Userspace<const void*> user_value, socklen_t user_value_size)
+{
+    if (level != IPPROTO_TCP)
+        return IPv4Socket::setsockopt(level, option, user_value, user_value_size);
+
+    switch (option) {
+    case TCP_NODELAY:
+    case TCP_CORK: {
+        if (user_value_size < sizeof(int))
+            return EINVAL;
+        int value;
+        if (!copy_from_user(&value, static_ptr_cast<const int*>(user_value)))
+            return EFAULT;
+        Locker locker(lock());
+        if (option == TCP_NODELAY)
+            m_no_delay = value != 0;
+        else
+            m_cork = value != 0;
+        // Anything that was held back may be allowed to go now.
+        Locker not_acked_locker(m_not_acked_lock);
+        send_queued_packets();
+        return KSuccess;
+    }
+    default:
+        return ENOPROTOOPT;
+    }
+}
+
+KResult TCPSocket::getsockopt(FileDescription& description, int level, int option, Userspace<void*> value, Userspace<socklen_t*> value_size)
+{
+    if (level != IPPROTO_TCP)
+        return IPv4Socket::getsockopt(description, level, option, value, value_size);
+
+    socklen_t size;
+    if (!copy_from_user(&size, value_size.unsafe_userspace_ptr()))
+        return EFAULT;
+
+    switch (option) {
+    case TCP_NODELAY:
+    case TCP_CORK: {
+        if (size < sizeof(int))
+            return EINVAL;
+        int enabled = option == TCP_NODELAY ? m_no_delay : m_cork;
+        if (!copy_to_user(static_ptr_cast<int*>(value), &enabled))
+            return EFAULT;
+        size = sizeof(int);
+        if (!copy_to_user(value_size, &size))
+            return EFAULT;
+        return KSuccess;
+    }
+    default:
+        return ENOPROTOOPT;
+    }
+}
+
 KResult TCPSocket::protocol_bind()
 {
     if (has_specific_local_address() && !m_adapter) {
@@ -350,10 +1169,8 @@ KResult TCPSocket::protocol_bind()
 
 KResult TCPSocket::protocol_listen()
 {
-    LOCKER(sockets_by_tuple().lock());
-    if (sockets_by_tuple().resource().contains(tuple()))
+    if (!listening_sockets().try_add(tuple(), this))
         return EADDRINUSE;
-    sockets_by_tuple().resource().set(tuple(), this);
     set_direction(Direction::Passive);
     set_state(State::Listen);
     set_setup_state(SetupState::Completed);
@@ -372,7 +1189,7 @@ KResult TCPSocket::protocol_connect(FileDescription& description, ShouldBlock sh
 
     allocate_local_port_if_needed();
 
-    m_sequence_number = get_good_random<u32>();
+    set_sequence_number(get_good_random<u32>());
     m_ack_number = 0;
 
     set_setup_state(SetupState::InProgress);
@@ -409,14 +1226,10 @@ int TCPSocket::protocol_allocate_local_port()
     static const u16 ephemeral_port_range_size = last_ephemeral_port - first_ephemeral_port;
     u16 first_scan_port = first_ephemeral_port + get_good_random<u16>() % ephemeral_port_range_size;
 
-    LOCKER(sockets_by_tuple().lock());
     for (u16 port = first_scan_port;;) {
         IPv4SocketTuple proposed_tuple(local_address(), port, peer_address(), peer_port());
-
-        auto it = sockets_by_tuple().resource().find(proposed_tuple);
-        if (it == sockets_by_tuple().resource().end()) {
+        if (sockets_by_tuple().try_add(proposed_tuple, this)) {
             set_local_port(port);
-            sockets_by_tuple().resource().set(proposed_tuple, this);
             return port;
         }
         ++port;
@@ -29,8 +29,13 @@
 #include <AK/Function.h>
 #include <AK/HashMap.h>
 #include <AK/SinglyLinkedList.h>
+#include <AK/Vector.h>
 #include <AK/WeakPtr.h>
 #include <Kernel/Net/IPv4Socket.h>
+#include <Kernel/Net/PacketBuffer.h>
+#include <Kernel/Net/SocketTable.h>
+#include <Kernel/Net/TCP.h>
+#include <Kernel/Net/TCPCongestionController.h>
 
 namespace Kernel {
 
@@ -140,7 +145,14 @@ public:
     void set_error(Error error) { m_error = error; }
 
     void set_ack_number(u32 n) { m_ack_number = n; }
-    void set_sequence_number(u32 n) { m_sequence_number = n; }
+    void set_sequence_number(u32 n)
+    {
+        m_sequence_number = n;
+        m_send_unacknowledged = n;
+        m_send_next = n;
+        m_send_max = n;
+        m_highest_sacked = n;
+    }
     u32 ack_number() const { return m_ack_number; }
     u32 sequence_number() const { return m_sequence_number; }
     u32 packets_in() const { return m_packets_in; }
@@ -148,22 +160,43 @@ public:
     u32 packets_out() const { return m_packets_out; }
     u32 bytes_out() const { return m_bytes_out; }
 
+    u32 send_maximum_segment_size() const { return m_send_maximum_segment_size; }
+    u32 congestion_window() const { return m_congestion_controller->congestion_window(); }
+    u32 send_window() const { return m_send_window; }
+    u32 smoothed_round_trip_time_ms() const { return m_smoothed_round_trip_time_ms; }
+    u32 retransmission_timeout_ms() const { return m_retransmission_timeout_ms; }
+
     KResult send_tcp_packet(u16 flags, const UserOrKernelBuffer* = nullptr, size_t = 0);
     void send_outgoing_packets();
     void receive_tcp_packet(const TCPPacket&, u16 size);
+    // Delivers the payload of an Established segment in sequence order. Returns true once the peer's FIN has been reached.
+    bool receive_tcp_segment(const TCPPacket&, PacketBuffer&, size_t payload_size, const timeval& packet_timestamp);
+    void negotiate_options(const TCPPacket& syn_packet);
 
-    static Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>& sockets_by_tuple();
+    static void retransmit_timed_out_packets();
+
+    // Connected and connecting sockets, keyed by their full tuple.
+    static SocketTable<IPv4SocketTuple, TCPSocket*>& sockets_by_tuple();
+    // Listening sockets, keyed by local address and port with an unspecified peer.
+    static SocketTable<IPv4SocketTuple, TCPSocket*>& listening_sockets();
     static RefPtr<TCPSocket> from_tuple(const IPv4SocketTuple& tuple);
     static RefPtr<TCPSocket> from_endpoints(const IPv4Address& local_address, u16 local_port, const IPv4Address& peer_address, u16 peer_port);
 
     static Lockable<HashMap<IPv4SocketTuple, RefPtr<TCPSocket>>>& closing_sockets();
 
+    // System-wide limit on half-open connections per listening socket, tunable through /proc/sys/tcp_max_syn_backlog.
+    static Lockable<u32>& max_syn_backlog();
+
+    // Whether a listening socket has room in its SYN and accept queues for another connection.
+    bool can_queue_connection_request();
     RefPtr<TCPSocket> create_client(const IPv4Address& local_address, u16 local_port, const IPv4Address& peer_address, u16 peer_port);
     void set_originator(TCPSocket& originator) { m_originator = originator; }
     bool has_originator() { return !!m_originator; }
-    void release_to_originator();
-    void release_for_accept(RefPtr<TCPSocket>);
+    KResult release_to_originator();
+    KResult release_for_accept(RefPtr<TCPSocket>);
 
+    virtual KResult setsockopt(int level, int option, Userspace<const void*>, socklen_t) override;
+    virtual KResult getsockopt(FileDescription&, int level, int option, Userspace<void*>, Userspace<socklen_t*>) override;
     virtual KResult close() override;
 
 protected:
@@ -174,11 +207,53 @@ private:
     virtual const char* class_name() const override { return "TCPSocket"; }
 
     static NetworkOrdered<u16> compute_tcp_checksum(const IPv4Address& source, const IPv4Address& destination, const TCPPacket&, u16 payload_size);
+    static u16 compute_tcp_pseudo_header_checksum(const IPv4Address& source, const IPv4Address& destination, u16 tcp_length);
+    static constexpr u16 tcp_checksum_offset = 16;
+
+    struct OutgoingPacket {
+        u32 sequence_number { 0 };
+        u16 flags { 0 };
+        ByteBuffer payload;
+        int tx_counter { 0 };
+        u64 tx_time_ms { 0 };
+        bool sacked { false };
+        bool retransmitted_in_recovery { false };
+
+        // SYN and FIN occupy a sequence number of their own.
+        u32 end_sequence_number() const { return sequence_number + payload.size() + ((flags & (TCPFlags::SYN | TCPFlags::FIN)) ? 1 : 0); }
+    };
+
+    KResult queue_packet(u16 flags, const UserOrKernelBuffer* payload, size_t payload_size);
+    KResultOr<size_t> append_to_last_unsent_packet(const UserOrKernelBuffer& payload, size_t payload_size, size_t segment_size);
+    u32 send_segment_size() const;
+    bool should_hold_back(const OutgoingPacket&, u64 now);
+    KResult transmit_packet(u32 sequence_number, u16 flags, ReadonlyBytes payload, u16 segment_size = 0);
+    void retransmit_packet(OutgoingPacket&);
+    size_t build_tcp_options(u16 flags, u8* options);
+    u16 window_to_advertise(u16 flags);
+    u32 local_maximum_segment_size() const;
+    u32 bytes_in_flight() const { return m_send_next - m_send_unacknowledged - m_sacked_bytes; }
+
+    void process_ack(const TCPPacket&, const TCPOptions&, size_t payload_size);
+    bool process_sack_blocks(const TCPOptions&);
+    void retransmit_next_sack_hole();
+    void update_round_trip_time(u32 sample_ms);
+    void handle_retransmission_timeout();
+    void send_queued_packets(bool force_first = false);
+    void send_ack_now_or_later(bool immediately);
+    KResultOr<size_t> send_to_loopback_peer(const UserOrKernelBuffer&, size_t);
+    bool fits_send_windows(const OutgoingPacket&, u32 bytes_in_flight) const;
+
+    bool deliver_in_order_segment(PacketBuffer&, size_t header_size, u32 sequence_number, size_t payload_size, const timeval& packet_timestamp);
+    void queue_out_of_order_segment(PacketBuffer&, size_t header_size, u32 sequence_number, size_t payload_size, bool has_fin, const timeval& packet_timestamp);
+    size_t collect_sack_blocks(TCPSACKBlock*, size_t max_blocks) const;
 
     virtual void shut_down_for_writing() override;
 
     virtual KResultOr<size_t> protocol_receive(ReadonlyBytes raw_ipv4_packet, UserOrKernelBuffer& buffer, size_t buffer_size, int flags) override;
+    virtual ReadonlyBytes protocol_payload(ReadonlyBytes raw_ipv4_packet) const override;
     virtual KResultOr<size_t> protocol_send(const UserOrKernelBuffer&, size_t) override;
+    virtual void protocol_did_read_from_receive_buffer() override;
     virtual KResult protocol_connect(FileDescription&, ShouldBlock) override;
     virtual int protocol_allocate_local_port() override;
     virtual bool protocol_is_disconnected() const override;
@@ -186,7 +261,8 @@ private:
     virtual KResult protocol_listen() override;
 
     WeakPtr<TCPSocket> m_originator;
-    HashMap<IPv4SocketTuple, NonnullRefPtr<TCPSocket>> m_pending_release_for_accept;
+    // Our SYN queue, the incoming connections that haven't completed their handshake yet.
+    Lockable<HashMap<IPv4SocketTuple, NonnullRefPtr<TCPSocket>>> m_pending_release_for_accept;
     Direction m_direction { Direction::Unspecified };
     Error m_error { Error::None };
     RefPtr<NetworkAdapter> m_adapter;
@@ -198,15 +274,73 @@ private:
     u32 m_packets_out { 0 };
     u32 m_bytes_out { 0 };
 
-    struct OutgoingPacket {
-        u32 ack_number { 0 };
-        ByteBuffer buffer;
-        int tx_counter { 0 };
-        timeval tx_time { 0, 0 };
-    };
+    // Our view of the send sequence space: everything below m_send_unacknowledged has been
+    // acknowledged, everything below m_send_next has been transmitted (m_send_max is the
+    // furthest we ever got, which only differs after a timeout), and m_sequence_number is
+    // where the next queued byte goes.
+    u32 m_send_unacknowledged { 0 };
+    u32 m_send_next { 0 };
+    u32 m_send_max { 0 };
+    u32 m_send_window { 0 };
+    u32 m_sacked_bytes { 0 };
+    u32 m_highest_sacked { 0 };
+    u32 m_send_maximum_segment_size { default_maximum_segment_size };
+    u8 m_send_window_shift { 0 };
+    u8 m_receive_window_shift { 0 };
+    bool m_window_scaling_enabled { false };
+    bool m_sack_permitted { false };
+    bool m_timestamps_enabled { false };
+    u32 m_timestamp_recent { 0 };
+    u32 m_last_advertised_window { 0 };
+    u64 m_last_window_probe_ms { 0 };
+
+    // Delayed ACKs (RFC 1122, section 4.2.3.2): at least every second full-sized segment is
+    // acknowledged right away, the others once the timer runs out, unless a segment of ours
+    // carries the ACK along before that.
+    static constexpr u32 delayed_ack_timeout_ms = 200;
+    u64 m_delayed_ack_deadline_ms { 0 };
+    u32 m_segments_received_since_ack { 0 };
+
+    // Nagle's algorithm (RFC 896) holds back a small segment while data is in flight, unless
+    // TCP_NODELAY is set. TCP_CORK holds it back regardless, but only for so long.
+    static constexpr u32 cork_timeout_ms = 200;
+    bool m_no_delay { false };
+    bool m_cork { false };
+    u64 m_held_back_since_ms { 0 };
+
+    // RFC 6298 retransmission timer state.
+    static constexpr u32 initial_retransmission_timeout_ms = 1000;
+    static constexpr u32 minimum_retransmission_timeout_ms = 200;
+    static constexpr u32 maximum_retransmission_timeout_ms = 60000;
+    static constexpr int max_retransmissions = 12;
+    // Half-open connections give up sooner, so they can't fill the SYN queue for long.
+    static constexpr int max_syn_ack_retransmissions = 5;
+    bool m_has_round_trip_time_sample { false };
+    u32 m_smoothed_round_trip_time_ms { 0 };
+    u32 m_round_trip_time_variance_ms { 0 };
+    u32 m_retransmission_timeout_ms { initial_retransmission_timeout_ms };
+
+    static constexpr u32 default_maximum_segment_size = 536;
+    NonnullOwnPtr<TCPCongestionController> m_congestion_controller;
 
     Lock m_not_acked_lock { "TCPSocket unacked packets" };
     SinglyLinkedList<OutgoingPacket> m_not_acked;
+    SinglyLinkedList<OutgoingPacket> m_unsent;
+
+    struct OutOfOrderSegment {
+        u32 sequence_number { 0 };
+        size_t header_size { 0 };
+        size_t payload_size { 0 };
+        bool has_fin { false };
+        NonnullRefPtr<PacketBuffer> packet;
+        timeval timestamp;
+
+        u32 end_sequence_number() const { return sequence_number + payload_size + (has_fin ? 1 : 0); }
+    };
+
+    static constexpr size_t max_out_of_order_segments = 64;
+    Vector<OutOfOrderSegment> m_out_of_order_segments;
+    u32 m_last_out_of_order_sequence { 0 };
 };
 
 }
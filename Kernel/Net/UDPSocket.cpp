@@ -37,30 +37,23 @@ namespace Kernel {
 
 void UDPSocket::for_each(Function<void(const UDPSocket&)> callback)
 {
-    LOCKER(sockets_by_port().lock(), Lock::Mode::Shared);
-    for (auto it : sockets_by_port().resource())
-        callback(*it.value);
+    sockets_by_port().for_each([&](auto, auto* socket) { callback(*socket); });
 }
 
-static AK::Singleton<Lockable<HashMap<u16, UDPSocket*>>> s_map;
+static AK::Singleton<SocketTable<u16, UDPSocket*>> s_map;
 
-Lockable<HashMap<u16, UDPSocket*>>& UDPSocket::sockets_by_port()
+SocketTable<u16, UDPSocket*>& UDPSocket::sockets_by_port()
 {
     return *s_map;
 }
 
 SocketHandle<UDPSocket> UDPSocket::from_port(u16 port)
 {
-    RefPtr<UDPSocket> socket;
-    {
-        LOCKER(sockets_by_port().lock(), Lock::Mode::Shared);
-        auto it = sockets_by_port().resource().find(port);
-        if (it == sockets_by_port().resource().end())
-            return {};
-        socket = (*it).value;
-        VERIFY(socket);
-    }
-    return { *socket };
+    auto socket = sockets_by_port().get(port);
+    if (!socket.has_value())
+        return {};
+    VERIFY(socket.value());
+    return { *socket.value() };
 }
 
 UDPSocket::UDPSocket(int protocol)
@@ -70,8 +63,7 @@ UDPSocket::UDPSocket(int protocol)
 
 UDPSocket::~UDPSocket()
 {
-    LOCKER(sockets_by_port().lock());
-    sockets_by_port().resource().remove(local_port());
+    sockets_by_port().remove(local_port(), this);
 }
 
 NonnullRefPtr<UDPSocket> UDPSocket::create(int protocol)
@@ -124,12 +116,9 @@ int UDPSocket::protocol_allocate_local_port()
     static const u16 ephemeral_port_range_size = last_ephemeral_port - first_ephemeral_port;
     u16 first_scan_port = first_ephemeral_port + get_good_random<u16>() % ephemeral_port_range_size;
 
-    LOCKER(sockets_by_port().lock());
     for (u16 port = first_scan_port;;) {
-        auto it = sockets_by_port().resource().find(port);
-        if (it == sockets_by_port().resource().end()) {
+        if (sockets_by_port().try_add(port, this)) {
             set_local_port(port);
-            sockets_by_port().resource().set(port, this);
             return port;
         }
         ++port;
@@ -143,10 +132,8 @@ int UDPSocket::protocol_allocate_local_port()
 
 KResult UDPSocket::protocol_bind()
 {
-    LOCKER(sockets_by_port().lock());
-    if (sockets_by_port().resource().contains(local_port()))
+    if (!sockets_by_port().try_add(local_port(), this))
         return EADDRINUSE;
-    sockets_by_port().resource().set(local_port(), this);
     return KSuccess;
 }
 
@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/MACAddress.h>
+#include <Kernel/CommandLine.h>
+#include <Kernel/Debug.h>
+#include <Kernel/Net/VirtIONetworkAdapter.h>
+#include <Kernel/VM/MemoryManager.h>
+
+namespace Kernel {
+
+namespace VirtIONet {
+
+namespace Feature {
+enum : u32 {
+    Checksum = 1 << 0,
+    MACAddress = 1 << 5,
+    Status = 1 << 16,
+};
+}
+
+namespace ConfigurationOffset {
+enum : u16 {
+    MACAddress = 0,
+    Status = 6,
+};
+}
+
+static constexpr u16 status_link_up = 1 << 0;
+static constexpr u8 header_flag_needs_checksum = 1 << 0;
+
+// The header in front of every frame, as long as mergeable receive buffers aren't negotiated.
+struct [[gnu::packed]] PacketHeader {
+    u8 flags;
+    u8 gso_type;
+    u16 header_length;
+    u16 gso_size;
+    u16 checksum_start;
+    u16 checksum_offset;
+};
+
+}
+
+UNMAP_AFTER_INIT void VirtIONetworkAdapter::detect()
+{
+    if (kernel_command_line().contains("disable_virtio"))
+        return;
+    PCI::enumerate([&](const PCI::Address& address, PCI::ID id) {
+        if (address.is_null())
+            return;
+        if (id.vendor_id != VirtIO::pci_vendor_id || id.device_id != VirtIO::PCIDeviceID::Network)
+            return;
+        auto adapter = adopt(*new VirtIONetworkAdapter(address));
+        if (!adapter->initialize())
+            return;
+        [[maybe_unused]] auto& unused = adapter.leak_ref();
+    });
+}
+
+UNMAP_AFTER_INIT VirtIONetworkAdapter::VirtIONetworkAdapter(PCI::Address address)
+    : VirtIODevice(address, "VirtIO Network")
+{
+    set_interface_name("vio");
+}
+
+UNMAP_AFTER_INIT VirtIONetworkAdapter::~VirtIONetworkAdapter()
+{
+}
+
+UNMAP_AFTER_INIT bool VirtIONetworkAdapter::initialize()
+{
+    begin_initialization(VirtIONet::Feature::Checksum | VirtIONet::Feature::MACAddress | VirtIONet::Feature::Status);
+    if (!setup_queue(receive_queue) || !setup_queue(transmit_queue)) {
+        fail_initialization();
+        return false;
+    }
+
+    m_receive_buffer_count = min(max_receive_buffers, (size_t)queue(receive_queue).size() / 2);
+    m_transmit_buffer_count = min(max_transmit_buffers, (size_t)queue(transmit_queue).size() / 2);
+    m_receive_buffers_region = MM.allocate_contiguous_kernel_region(page_round_up(m_receive_buffer_count * buffer_size), "VirtIO Network RX", Region::Access::Read | Region::Access::Write);
+    m_transmit_buffers_region = MM.allocate_contiguous_kernel_region(page_round_up(m_transmit_buffer_count * buffer_size), "VirtIO Network TX", Region::Access::Read | Region::Access::Write);
+    if (!m_receive_buffers_region || !m_transmit_buffers_region) {
+        fail_initialization();
+        return false;
+    }
+
+    if (is_feature_accepted(VirtIONet::Feature::MACAddress)) {
+        MACAddress mac {};
+        for (u16 i = 0; i < 6; ++i)
+            mac[i] = config_read<u8>(VirtIONet::ConfigurationOffset::MACAddress + i);
+        set_mac_address(mac);
+    }
+
+    // Our transmit buffers only hold a single frame, so the segmentation offloads aren't worth negotiating.
+    if (is_feature_accepted(VirtIONet::Feature::Checksum))
+        set_offloads(NetworkOffload::TransmitChecksum);
+
+    for (size_t i = 0; i < m_receive_buffer_count; ++i)
+        supply_receive_buffer(i);
+    for (size_t i = 0; i < m_transmit_buffer_count; ++i)
+        m_free_transmit_buffers.append(i);
+
+    klog() << "VirtIONetworkAdapter: Found @ " << pci_address() << ", MAC address " << mac_address().to_string();
+
+    finish_initialization();
+    notify_queue(receive_queue);
+    return true;
+}
+
+bool VirtIONetworkAdapter::link_up()
+{
+    if (!is_feature_accepted(VirtIONet::Feature::Status))
+        return true;
+    return config_read<u16>(VirtIONet::ConfigurationOffset::Status) & VirtIONet::status_link_up;
+}
+
+void VirtIONetworkAdapter::supply_receive_buffer(size_t buffer_index)
+{
+    auto address = buffer_physical_address(*m_receive_buffers_region, buffer_index);
+    VirtIOQueue::BufferSegment segments[] = {
+        { address, sizeof(VirtIONet::PacketHeader), true },
+        { address.offset(frame_offset), buffer_size - frame_offset, true },
+    };
+    bool supplied = queue(receive_queue).supply_buffer(segments, reinterpret_cast<void*>(buffer_index));
+    VERIFY(supplied);
+}
+
+void VirtIONetworkAdapter::receive()
+{
+    void* token;
+    u32 written_length;
+    bool did_receive_any = false;
+    while (queue(receive_queue).get_used_buffer(token, written_length)) {
+        size_t buffer_index = reinterpret_cast<FlatPtr>(token);
+        VERIFY(buffer_index < m_receive_buffer_count);
+        if (written_length > sizeof(VirtIONet::PacketHeader)) {
+            size_t frame_length = min((size_t)written_length - sizeof(VirtIONet::PacketHeader), buffer_size - frame_offset);
+            dbgln_if(VIRTIO_DEBUG, "VirtIONetworkAdapter: Received {} bytes in buffer {}", frame_length, buffer_index);
+            did_receive({ buffer(*m_receive_buffers_region, buffer_index) + frame_offset, frame_length });
+        }
+        supply_receive_buffer(buffer_index);
+        did_receive_any = true;
+    }
+    if (did_receive_any)
+        notify_queue(receive_queue);
+}
+
+void VirtIONetworkAdapter::reclaim_transmit_buffers()
+{
+    VERIFY(m_lock.is_locked());
+    void* token;
+    u32 written_length;
+    while (queue(transmit_queue).get_used_buffer(token, written_length))
+        m_free_transmit_buffers.append(reinterpret_cast<FlatPtr>(token));
+}
+
+void VirtIONetworkAdapter::send_raw(ReadonlyBytes payload)
+{
+    send_raw_with_offload(payload, {});
+}
+
+void VirtIONetworkAdapter::send_raw_with_offload(ReadonlyBytes payload, const TransmitOffload& offload)
+{
+    VERIFY(payload.size() <= buffer_size - frame_offset);
+    VERIFY(!offload.segment_size);
+    for (;;) {
+        {
+            ScopedSpinLock lock(m_lock);
+            reclaim_transmit_buffers();
+            if (!m_free_transmit_buffers.is_empty()) {
+                size_t buffer_index = m_free_transmit_buffers.take_last();
+                auto* data = buffer(*m_transmit_buffers_region, buffer_index);
+                auto& header = *(VirtIONet::PacketHeader*)data;
+                memset(&header, 0, sizeof(VirtIONet::PacketHeader));
+                if (offload.needs_checksum) {
+                    header.flags = VirtIONet::header_flag_needs_checksum;
+                    header.checksum_start = offload.checksum_start;
+                    header.checksum_offset = offload.checksum_offset;
+                }
+                memcpy(data + frame_offset, payload.data(), payload.size());
+
+                auto address = buffer_physical_address(*m_transmit_buffers_region, buffer_index);
+                VirtIOQueue::BufferSegment segments[] = {
+                    { address, sizeof(VirtIONet::PacketHeader), false },
+                    { address.offset(frame_offset), (u32)payload.size(), false },
+                };
+                bool supplied = queue(transmit_queue).supply_buffer(segments, reinterpret_cast<void*>(buffer_index));
+                VERIFY(supplied);
+                notify_queue(transmit_queue);
+                dbgln_if(VIRTIO_DEBUG, "VirtIONetworkAdapter: Sending {} bytes from buffer {}", payload.size(), buffer_index);
+                return;
+            }
+        }
+        // All transmit buffers are in flight; wait for the device to hand one back.
+        m_transmit_wait_queue.wait_forever("VirtIONetworkAdapter");
+    }
+}
+
+void VirtIONetworkAdapter::handle_queue_update(u16 queue_index)
+{
+    if (queue_index == receive_queue) {
+        receive();
+        return;
+    }
+    VERIFY(queue_index == transmit_queue);
+    ScopedSpinLock lock(m_lock);
+    bool had_free_buffers = !m_free_transmit_buffers.is_empty();
+    reclaim_transmit_buffers();
+    if (!had_free_buffers && !m_free_transmit_buffers.is_empty())
+        m_transmit_wait_queue.wake_one();
+}
+
+void VirtIONetworkAdapter::handle_device_configuration_change()
+{
+    dbgln_if(VIRTIO_DEBUG, "VirtIONetworkAdapter: Link is {}", link_up() ? "up" : "down");
+}
+
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/OwnPtr.h>
+#include <AK/Vector.h>
+#include <Kernel/Net/NetworkAdapter.h>
+#include <Kernel/SpinLock.h>
+#include <Kernel/VirtIO/VirtIO.h>
+#include <Kernel/WaitQueue.h>
+
+namespace Kernel {
+
+class VirtIONetworkAdapter final : public NetworkAdapter
+    , public VirtIODevice {
+public:
+    static void detect();
+
+    virtual ~VirtIONetworkAdapter() override;
+
+    virtual bool link_up() override;
+    virtual const char* class_name() const override { return "VirtIONetworkAdapter"; }
+
+private:
+    explicit VirtIONetworkAdapter(PCI::Address);
+
+    bool initialize();
+
+    // ^NetworkAdapter
+    virtual void send_raw(ReadonlyBytes) override;
+    virtual void send_raw_with_offload(ReadonlyBytes, const TransmitOffload&) override;
+
+    // ^VirtIODevice
+    virtual void handle_queue_update(u16 queue_index) override;
+    virtual void handle_device_configuration_change() override;
+
+    void supply_receive_buffer(size_t buffer_index);
+    void receive();
+    void reclaim_transmit_buffers();
+
+    u8* buffer(const Region& region, size_t buffer_index) const { return region.vaddr().offset(buffer_index * buffer_size).as_ptr(); }
+    PhysicalAddress buffer_physical_address(const Region& region, size_t buffer_index) const { return region.physical_page(0)->paddr().offset(buffer_index * buffer_size); }
+
+    static constexpr u16 receive_queue = 0;
+    static constexpr u16 transmit_queue = 1;
+
+    // Every buffer starts with the virtio-net header, followed by the frame at a fixed
+    // offset. Legacy devices want the header in a descriptor of its own, so each
+    // packet is a chain of two descriptors.
+    static constexpr size_t buffer_size = 2048;
+    static constexpr size_t frame_offset = 16;
+    static constexpr size_t max_receive_buffers = 64;
+    static constexpr size_t max_transmit_buffers = 32;
+
+    size_t m_receive_buffer_count { 0 };
+    size_t m_transmit_buffer_count { 0 };
+    OwnPtr<Region> m_receive_buffers_region;
+    OwnPtr<Region> m_transmit_buffers_region;
+
+    SpinLock<u8> m_lock;
+    Vector<size_t, max_transmit_buffers> m_free_transmit_buffers;
+    WaitQueue m_transmit_wait_queue;
+};
+
+}
@@ -180,12 +180,22 @@ Vector<Capability> get_capabilities(Address address)
         dbgln_if(PCI_DEBUG, "PCI: Reading in capability at {:#02x} for {}", capability_pointer, address);
         u16 capability_header = PCI::read16(address, capability_pointer);
         u8 capability_id = capability_header & 0xff;
+        u8 capability_offset = capability_pointer;
         capability_pointer = capability_header >> 8;
-        capabilities.append({ capability_id, capability_pointer });
+        capabilities.append({ capability_id, capability_offset, capability_pointer });
     }
     return capabilities;
 }
 
+Optional<Capability> find_capability(Address address, u8 id)
+{
+    for (auto& capability : get_physical_id(address).capabilities()) {
+        if (capability.m_id == id)
+            return capability;
+    }
+    return {};
+}
+
 void raw_access(Address address, u32 field, size_t access_size, u32 value)
 {
     VERIFY(access_size != 0);
@@ -59,6 +59,8 @@ namespace Kernel {
 #define PCI_CAPABILITIES_POINTER 0x34 // u8
 #define PCI_INTERRUPT_LINE 0x3C       // byte
 #define PCI_SECONDARY_BUS 0x19        // byte
+#define PCI_CAPABILITY_MSI 0x05
+#define PCI_CAPABILITY_MSIX 0x11
 #define PCI_HEADER_TYPE_DEVICE 0
 #define PCI_HEADER_TYPE_BRIDGE 1
 #define PCI_TYPE_BRIDGE 0x0604
@@ -184,6 +186,7 @@ struct ChangeableAddress : public Address {
 
 struct Capability {
     u8 m_id;
+    u8 m_offset;
     u8 m_next_pointer;
 };
 
@@ -231,6 +234,7 @@ u16 get_subsystem_vendor_id(Address);
 size_t get_BAR_space_size(Address, u8);
 Optional<u8> get_capabilities_pointer(Address);
 Vector<Capability> get_capabilities(Address);
+Optional<Capability> find_capability(Address, u8 id);
 void enable_bus_mastering(Address);
 void disable_bus_mastering(Address);
 PhysicalID get_physical_id(Address address);
@@ -241,6 +245,7 @@ class IOAccess;
 class MMIOSegment;
 class DeviceController;
 class Device;
+class MessageSignalledInterrupt;
 
 }
 
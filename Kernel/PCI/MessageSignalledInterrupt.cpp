@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Kernel/Debug.h>
+#include <Kernel/PCI/Access.h>
+#include <Kernel/PCI/MessageSignalledInterrupt.h>
+#include <Kernel/VM/MemoryManager.h>
+
+namespace Kernel {
+namespace PCI {
+
+static constexpr u16 msi_control_enable = 1 << 0;
+static constexpr u16 msi_control_64bit = 1 << 7;
+static constexpr u16 msi_control_per_vector_masking = 1 << 8;
+
+static constexpr u16 msix_control_function_mask = 1 << 14;
+static constexpr u16 msix_control_enable = 1 << 15;
+static constexpr u32 msix_vector_control_masked = 1 << 0;
+
+static constexpr u32 message_address_base = 0xfee00000;
+
+OwnPtr<MessageSignalledInterrupt> MessageSignalledInterrupt::try_create(Address address)
+{
+    if (auto msix = find_capability(address, PCI_CAPABILITY_MSIX); msix.has_value()) {
+        u32 table = Access::the().read32_field(address, msix.value().m_offset + 4);
+        u8 bar_index = table & 0b111;
+        u32 table_offset = table & ~0b111;
+        u32 bar = bar_index <= 5 ? Access::the().read32_field(address, PCI_BAR0 + bar_index * 4) : 0;
+        // The table has to live in a memory BAR that we can reach from a 32-bit kernel.
+        bool bar_is_usable = bar && !(bar & 1) && (((bar >> 1) & 0b11) != 0b10 || !Access::the().read32_field(address, PCI_BAR0 + (bar_index + 1) * 4));
+        if (bar_is_usable) {
+            auto table_address = PhysicalAddress((bar & 0xfffffff0) + table_offset);
+            auto region = MM.allocate_kernel_region(table_address.page_base(), page_round_up(table_address.offset_in_page() + 16), "MSI-X Table", Region::Access::Read | Region::Access::Write, Region::Cacheable::No);
+            if (region)
+                return adopt_own(*new MessageSignalledInterrupt(address, msix.value(), move(region), table_address.offset_in_page()));
+        }
+        dbgln_if(PCI_DEBUG, "PCI: Can't map the MSI-X table of {}, trying MSI", address);
+    }
+    if (auto msi = find_capability(address, PCI_CAPABILITY_MSI); msi.has_value())
+        return adopt_own(*new MessageSignalledInterrupt(address, msi.value(), {}, 0));
+    return {};
+}
+
+MessageSignalledInterrupt::MessageSignalledInterrupt(Address address, const Capability& capability, OwnPtr<Region>&& msix_table_region, size_t msix_table_offset_in_region)
+    : m_address(address)
+    , m_capability_offset(capability.m_offset)
+    , m_extended(capability.m_id == PCI_CAPABILITY_MSIX)
+    , m_msix_table_region(move(msix_table_region))
+    , m_msix_table_offset_in_region(msix_table_offset_in_region)
+{
+}
+
+MessageSignalledInterrupt::~MessageSignalledInterrupt()
+{
+    mask();
+    if (m_extended)
+        set_control(control() & ~msix_control_enable);
+    else
+        set_control(control() & ~msi_control_enable);
+}
+
+u16 MessageSignalledInterrupt::control() const
+{
+    return Access::the().read16_field(m_address, m_capability_offset + 2);
+}
+
+void MessageSignalledInterrupt::set_control(u16 value)
+{
+    Access::the().write16_field(m_address, m_capability_offset + 2, value);
+}
+
+volatile u32* MessageSignalledInterrupt::msix_table_entry()
+{
+    VERIFY(m_extended);
+    return reinterpret_cast<volatile u32*>(m_msix_table_region->vaddr().offset(m_msix_table_offset_in_region).as_ptr());
+}
+
+void MessageSignalledInterrupt::route(u8 interrupt_vector, u8 apic_id)
+{
+    InterruptDisabler disabler;
+    // Physical destination mode, fixed delivery and edge triggered.
+    u32 message_address = message_address_base | (u32)apic_id << 12;
+    u16 message_data = interrupt_vector;
+    dbgln_if(PCI_DEBUG, "PCI: Routing {} of {} to vector {:#02x} on APIC {}", m_extended ? "MSI-X" : "MSI", m_address, interrupt_vector, apic_id);
+
+    if (m_extended) {
+        auto* entry = msix_table_entry();
+        // Entries may only be changed while they are masked.
+        u32 vector_control = entry[3];
+        entry[3] = vector_control | msix_vector_control_masked;
+        entry[0] = message_address;
+        entry[1] = 0;
+        entry[2] = message_data;
+        entry[3] = vector_control;
+        set_control((control() | msix_control_enable) & ~msix_control_function_mask);
+        return;
+    }
+
+    u16 msi_control = control();
+    // Request a single message, and keep the function quiet while we reprogram it.
+    set_control(msi_control & ~(msi_control_enable | (0b111 << 4)));
+    Access::the().write32_field(m_address, m_capability_offset + 4, message_address);
+    if (msi_control & msi_control_64bit) {
+        Access::the().write32_field(m_address, m_capability_offset + 8, 0);
+        Access::the().write16_field(m_address, m_capability_offset + 12, message_data);
+    } else {
+        Access::the().write16_field(m_address, m_capability_offset + 8, message_data);
+    }
+    set_control((msi_control & ~(0b111 << 4)) | msi_control_enable);
+}
+
+void MessageSignalledInterrupt::mask()
+{
+    InterruptDisabler disabler;
+    if (m_extended) {
+        auto* entry = msix_table_entry();
+        entry[3] = entry[3] | msix_vector_control_masked;
+        return;
+    }
+    u16 msi_control = control();
+    if (msi_control & msi_control_per_vector_masking) {
+        u8 mask_bits_offset = m_capability_offset + ((msi_control & msi_control_64bit) ? 0x10 : 0xc);
+        Access::the().write32_field(m_address, mask_bits_offset, Access::the().read32_field(m_address, mask_bits_offset) | 1);
+        return;
+    }
+    // Without per-vector masking, the best we can do is turning the messages off entirely.
+    set_control(msi_control & ~msi_control_enable);
+}
+
+void MessageSignalledInterrupt::unmask()
+{
+    InterruptDisabler disabler;
+    if (m_extended) {
+        auto* entry = msix_table_entry();
+        entry[3] = entry[3] & ~msix_vector_control_masked;
+        return;
+    }
+    u16 msi_control = control();
+    if (msi_control & msi_control_per_vector_masking) {
+        u8 mask_bits_offset = m_capability_offset + ((msi_control & msi_control_64bit) ? 0x10 : 0xc);
+        Access::the().write32_field(m_address, mask_bits_offset, Access::the().read32_field(m_address, mask_bits_offset) & ~1);
+        return;
+    }
+    set_control(msi_control | msi_control_enable);
+}
+
+}
+}
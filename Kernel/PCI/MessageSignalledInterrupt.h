@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/OwnPtr.h>
+#include <AK/Types.h>
+#include <Kernel/PCI/Definitions.h>
+#include <Kernel/VM/Region.h>
+
+namespace Kernel {
+
+// Delivers a PCI function's interrupts as memory writes straight to a local APIC,
+// rather than through a (possibly shared) pin on the I/O APIC. MSI-X is preferred
+// when a function supports both; either way only a single vector is used.
+class PCI::MessageSignalledInterrupt {
+    AK_MAKE_NONCOPYABLE(MessageSignalledInterrupt);
+    AK_MAKE_NONMOVABLE(MessageSignalledInterrupt);
+
+public:
+    static OwnPtr<MessageSignalledInterrupt> try_create(Address);
+    ~MessageSignalledInterrupt();
+
+    Address pci_address() const { return m_address; }
+    bool is_extended() const { return m_extended; }
+
+    // Points the message at the local APIC with the given (physical) id.
+    void route(u8 interrupt_vector, u8 apic_id);
+
+    void mask();
+    void unmask();
+
+private:
+    MessageSignalledInterrupt(Address, const Capability&, OwnPtr<Region>&& msix_table_region, size_t msix_table_offset_in_region);
+
+    u16 control() const;
+    void set_control(u16);
+    volatile u32* msix_table_entry();
+
+    Address m_address;
+    u8 m_capability_offset { 0 };
+    bool m_extended { false };
+    OwnPtr<Region> m_msix_table_region;
+    size_t m_msix_table_offset_in_region { 0 };
+};
+
+}
@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Singleton.h>
+#include <Kernel/Arch/i386/CPU.h>
+#include <Kernel/Interrupts/APIC.h>
+#include <Kernel/Interrupts/GenericInterruptHandler.h>
+#include <Kernel/Lock.h>
+#include <Kernel/PerformanceCounters.h>
+#include <Kernel/PerformanceEventBuffer.h>
+#include <Kernel/Process.h>
+#include <Kernel/Thread.h>
+
+#define IA32_PMC0 0xc1
+#define IA32_PERFEVTSEL0 0x186
+#define IA32_PERF_GLOBAL_CTRL 0x38f
+#define IA32_PERF_GLOBAL_OVF_CTRL 0x390
+
+#define PERFEVTSEL_USR (1 << 16)
+#define PERFEVTSEL_OS (1 << 17)
+#define PERFEVTSEL_INT (1 << 20)
+#define PERFEVTSEL_EN (1 << 22)
+
+namespace Kernel {
+
+struct HardwareEvent {
+    const char* name;
+    u8 event_select;
+    u8 unit_mask;
+    // The bit in CPUID.0AH:EBX that is set if the processor *can't* count this event.
+    u8 unavailable_bit;
+    // How many events to let pass between two samples.
+    u32 period;
+};
+
+// These are all architectural events, so their encodings are the same on every processor that has them.
+static constexpr HardwareEvent s_hardware_events[] = {
+    { "timer", 0, 0, 0, 0 },
+    { "cycles", 0x3c, 0x00, 0, 2'000'000 },
+    { "instructions", 0xc0, 0x00, 1, 2'000'000 },
+    { "cache-misses", 0x2e, 0x41, 4, 10'000 },
+    { "branch-misses", 0xc5, 0x00, 6, 10'000 },
+};
+
+static AK::Singleton<Lock> s_lock;
+static Atomic<int> s_active_sample_source { PROFILING_SAMPLE_TIMER };
+static size_t s_user_count;
+static bool s_handler_registered;
+
+class PerformanceCounterInterruptHandler final : public GenericInterruptHandler {
+public:
+    explicit PerformanceCounterInterruptHandler(u8 interrupt_vector)
+        : GenericInterruptHandler(interrupt_vector, true)
+    {
+    }
+    virtual ~PerformanceCounterInterruptHandler()
+    {
+    }
+
+    virtual void handle_interrupt(const RegisterState&) override;
+
+    virtual bool eoi() override
+    {
+        APIC::the().eoi();
+        return true;
+    }
+
+    virtual HandlerType type() const override { return HandlerType::IRQHandler; }
+    virtual const char* purpose() const override { return "Performance counter overflow"; }
+    virtual const char* controller() const override { return nullptr; }
+
+    virtual size_t sharing_devices_count() const override { return 0; }
+    virtual bool is_shared_handler() const override { return false; }
+    virtual bool is_sharing_with_others() const override { return false; }
+};
+
+struct PerformanceMonitoringInfo {
+    u8 version { 0 };
+    u8 counter_count { 0 };
+    u8 counter_width { 0 };
+    u32 unavailable_events { 0 };
+};
+
+static PerformanceMonitoringInfo performance_monitoring_info()
+{
+    PerformanceMonitoringInfo info;
+    if (!MSR::have())
+        return info;
+    CPUID vendor(0);
+    if (vendor.eax() < 0xa)
+        return info;
+    CPUID leaf(0xa);
+    info.version = leaf.eax() & 0xff;
+    info.counter_count = (leaf.eax() >> 8) & 0xff;
+    info.counter_width = (leaf.eax() >> 16) & 0xff;
+    info.unavailable_events = leaf.ebx();
+    return info;
+}
+
+// Looked up once when the counters are started, CPUID is too slow to run on every overflow.
+static PerformanceMonitoringInfo s_info;
+
+bool PerformanceCounters::is_valid_sample_source(int sample_source)
+{
+    return sample_source >= 0 && (size_t)sample_source < array_size(s_hardware_events);
+}
+
+const char* PerformanceCounters::sample_source_name(int sample_source)
+{
+    VERIFY(is_valid_sample_source(sample_source));
+    return s_hardware_events[sample_source].name;
+}
+
+bool PerformanceCounters::is_supported(int sample_source)
+{
+    VERIFY(is_valid_sample_source(sample_source));
+    if (sample_source == PROFILING_SAMPLE_TIMER)
+        return true;
+    // The overflow interrupt is delivered by the local APIC.
+    if (!APIC::initialized())
+        return false;
+    auto info = performance_monitoring_info();
+    if (info.version == 0 || info.counter_count == 0)
+        return false;
+    return !(info.unavailable_events & (1 << s_hardware_events[sample_source].unavailable_bit));
+}
+
+int PerformanceCounters::active_sample_source()
+{
+    return s_active_sample_source.load(AK::MemoryOrder::memory_order_relaxed);
+}
+
+static void reset_counter()
+{
+    // Counting up from -period makes the counter overflow after period events.
+    u64 mask = s_info.counter_width >= 64 ? ~(u64)0 : ((u64)1 << s_info.counter_width) - 1;
+    u64 value = (0 - (u64)s_hardware_events[PerformanceCounters::active_sample_source()].period) & mask;
+    MSR(IA32_PMC0).set(value & 0xffffffff, value >> 32);
+    if (s_info.version >= 2)
+        MSR(IA32_PERF_GLOBAL_OVF_CTRL).set(1, 0);
+}
+
+static void start_counting_on_this_processor()
+{
+    auto& event = s_hardware_events[PerformanceCounters::active_sample_source()];
+    MSR event_select(IA32_PERFEVTSEL0);
+    event_select.set(0, 0);
+    reset_counter();
+    if (s_info.version >= 2) {
+        MSR global_control(IA32_PERF_GLOBAL_CTRL);
+        u32 low, high;
+        global_control.get(low, high);
+        global_control.set(low | 1, high);
+    }
+    APIC::the().enable_performance_counter_interrupt();
+    event_select.set(event.event_select | (event.unit_mask << 8) | PERFEVTSEL_USR | PERFEVTSEL_OS | PERFEVTSEL_INT | PERFEVTSEL_EN, 0);
+}
+
+static void stop_counting_on_this_processor()
+{
+    MSR(IA32_PERFEVTSEL0).set(0, 0);
+    APIC::the().disable_performance_counter_interrupt();
+}
+
+static void on_every_processor(void (*callback)())
+{
+    if (Processor::count() > 1)
+        Processor::smp_broadcast(callback, false);
+    ScopedCritical critical;
+    callback();
+}
+
+KResult PerformanceCounters::acquire(int sample_source)
+{
+    VERIFY(is_valid_sample_source(sample_source));
+    if (sample_source == PROFILING_SAMPLE_TIMER)
+        return KSuccess;
+    if (!is_supported(sample_source))
+        return ENOTSUP;
+
+    Locker locker(*s_lock);
+    if (s_user_count > 0) {
+        if (active_sample_source() != sample_source)
+            return EBUSY;
+        ++s_user_count;
+        return KSuccess;
+    }
+
+    if (!s_handler_registered) {
+        new PerformanceCounterInterruptHandler(APIC::performance_counter_interrupt_vector());
+        s_handler_registered = true;
+    }
+    s_info = performance_monitoring_info();
+    s_user_count = 1;
+    s_active_sample_source = sample_source;
+    on_every_processor(start_counting_on_this_processor);
+    return KSuccess;
+}
+
+void PerformanceCounters::release(int sample_source)
+{
+    if (sample_source == PROFILING_SAMPLE_TIMER)
+        return;
+
+    Locker locker(*s_lock);
+    VERIFY(s_user_count > 0);
+    VERIFY(active_sample_source() == sample_source);
+    if (--s_user_count > 0)
+        return;
+    on_every_processor(stop_counting_on_this_processor);
+    s_active_sample_source = PROFILING_SAMPLE_TIMER;
+}
+
+void PerformanceCounterInterruptHandler::handle_interrupt(const RegisterState& regs)
+{
+    // NOTE: This is an ordinary interrupt rather than an NMI, so samples that fall into code
+    //       running with interrupts disabled get attributed to where they are enabled again.
+    auto sample_source = PerformanceCounters::active_sample_source();
+    if (sample_source == PROFILING_SAMPLE_TIMER)
+        return;
+
+    auto* current_thread = Processor::current_thread();
+    if (current_thread && current_thread != Processor::current().idle_thread()) {
+        auto& process = current_thread->process();
+        if (process.is_profiling() && process.profiling_sample_source() == sample_source) {
+            VERIFY(process.perf_events());
+            [[maybe_unused]] auto rc = process.perf_events()->append_with_eip_and_ebp(regs.eip, regs.ebp, PERF_EVENT_SAMPLE, 0, 0);
+        }
+    }
+
+    reset_counter();
+    // The local APIC masks the interrupt every time it delivers it.
+    APIC::the().enable_performance_counter_interrupt();
+}
+
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+#include <Kernel/KResult.h>
+#include <Kernel/UnixTypes.h>
+
+namespace Kernel {
+
+// Samples profiled processes whenever a hardware performance counter overflows, rather than on
+// timer ticks. This uses the first general-purpose counter of the architectural performance
+// monitoring interface (CPUID leaf 0xA) on every processor, with the local APIC raising an
+// interrupt on overflow. Only one hardware sample source can be in use at a time, but any
+// number of processes can be profiled with it.
+class PerformanceCounters {
+public:
+    static bool is_valid_sample_source(int);
+    static const char* sample_source_name(int);
+
+    // Whether the processor can count the given event, always true for PROFILING_SAMPLE_TIMER.
+    static bool is_supported(int sample_source);
+
+    // Counted per profiled process, the counters run for as long as anyone holds on to them.
+    static KResult acquire(int sample_source);
+    static void release(int sample_source);
+
+    static int active_sample_source();
+};
+
+}
@@ -24,11 +24,14 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/HashMap.h>
 #include <AK/JsonArraySerializer.h>
 #include <AK/JsonObject.h>
 #include <AK/JsonObjectSerializer.h>
+#include <Kernel/API/Perfcore.h>
 #include <Kernel/Arch/x86/SmapDisabler.h>
 #include <Kernel/KBufferBuilder.h>
+#include <Kernel/PerformanceCounters.h>
 #include <Kernel/PerformanceEventBuffer.h>
 #include <Kernel/Process.h>
 
@@ -49,7 +52,7 @@ KResult PerformanceEventBuffer::append(int type, FlatPtr arg1, FlatPtr arg2)
     return append_with_eip_and_ebp(eip, ebp, type, arg1, arg2);
 }
 
-static Vector<FlatPtr, PerformanceEvent::max_stack_frame_count> raw_backtrace(FlatPtr ebp, FlatPtr eip)
+Vector<FlatPtr, PerformanceEvent::max_stack_frame_count> PerformanceEventBuffer::raw_backtrace(FlatPtr ebp, FlatPtr eip)
 {
     Vector<FlatPtr, PerformanceEvent::max_stack_frame_count> backtrace;
     backtrace.append(eip);
@@ -90,10 +93,21 @@ KResult PerformanceEventBuffer::append_with_eip_and_ebp(u32 eip, u32 ebp, int ty
     case PERF_EVENT_FREE:
         event.data.free.ptr = arg1;
         break;
+    case PERF_EVENT_CONTEXT_SWITCH:
+    case PERF_EVENT_PAGE_FAULT:
+    case PERF_EVENT_DISK_REQUEST:
+    case PERF_EVENT_SYSCALL_ENTRY:
+    case PERF_EVENT_SYSCALL_EXIT:
+        event.data.tracepoint.arg1 = arg1;
+        event.data.tracepoint.arg2 = arg2;
+        break;
     default:
         return EINVAL;
     }
 
+    if (auto* current_thread = Thread::current())
+        event.tid = current_thread->tid().value();
+
     auto backtrace = raw_backtrace(ebp, eip);
     event.stack_size = min(sizeof(event.stack) / sizeof(FlatPtr), static_cast<size_t>(backtrace.size()));
     memcpy(event.stack, backtrace.data(), event.stack_size * sizeof(FlatPtr));
@@ -110,6 +124,24 @@ PerformanceEvent& PerformanceEventBuffer::at(size_t index)
     return events[index];
 }
 
+static const char* perf_event_type_name(u8 type)
+{
+    switch (type) {
+    case PERF_EVENT_CONTEXT_SWITCH:
+        return "context_switch";
+    case PERF_EVENT_PAGE_FAULT:
+        return "page_fault";
+    case PERF_EVENT_DISK_REQUEST:
+        return "disk_request";
+    case PERF_EVENT_SYSCALL_ENTRY:
+        return "syscall_entry";
+    case PERF_EVENT_SYSCALL_EXIT:
+        return "syscall_exit";
+    default:
+        VERIFY_NOT_REACHED();
+    }
+}
+
 OwnPtr<KBuffer> PerformanceEventBuffer::to_json(ProcessID pid, const String& executable_path) const
 {
     KBufferBuilder builder;
@@ -127,14 +159,15 @@ bool PerformanceEventBuffer::to_json(KBufferBuilder& builder, ProcessID pid, con
     JsonObjectSerializer object(builder);
     object.add("pid", pid.value());
     object.add("executable", executable_path);
+    object.add("sample_source", PerformanceCounters::sample_source_name(m_sample_source));
 
     {
         auto region_array = object.add_array("regions");
         for (const auto& region : process->space().regions()) {
             auto region_object = region_array.add_object();
-            region_object.add("base", region.vaddr().get());
-            region_object.add("size", region.size());
-            region_object.add("name", region.name());
+            region_object.add("base", region->vaddr().get());
+            region_object.add("size", region->size());
+            region_object.add("name", region->name());
         }
         region_array.finish();
     }
@@ -156,6 +189,11 @@ bool PerformanceEventBuffer::to_json(KBufferBuilder& builder, ProcessID pid, con
             event_object.add("type", "free");
             event_object.add("ptr", static_cast<u64>(event.data.free.ptr));
             break;
+        default:
+            event_object.add("type", perf_event_type_name(event.type));
+            event_object.add("arg1", static_cast<u64>(event.data.tracepoint.arg1));
+            event_object.add("arg2", static_cast<u64>(event.data.tracepoint.arg2));
+            break;
         }
         event_object.add("tid", event.tid);
         event_object.add("timestamp", event.timestamp);
@@ -171,4 +209,138 @@ bool PerformanceEventBuffer::to_json(KBufferBuilder& builder, ProcessID pid, con
     return true;
 }
 
+
+static void append_leb128(KBufferBuilder& builder, u64 value)
+{
+    do {
+        u8 byte = value & 0x7f;
+        value >>= 7;
+        if (value)
+            byte |= 0x80;
+        builder.append((char)byte);
+    } while (value);
+}
+
+static void append_record(KBufferBuilder& builder, PerfcoreRecord record)
+{
+    builder.append((char)record);
+}
+
+static u32 stack_hash(const PerformanceEvent& event)
+{
+    u32 hash = event.stack_size;
+    for (size_t i = 0; i < event.stack_size; ++i)
+        hash = pair_int_hash(hash, ptr_hash(event.stack[i]));
+    return hash;
+}
+
+static bool stacks_equal(const PerformanceEvent& a, const PerformanceEvent& b)
+{
+    if (a.stack_size != b.stack_size)
+        return false;
+    return !memcmp(a.stack, b.stack, a.stack_size * sizeof(FlatPtr));
+}
+
+OwnPtr<KBuffer> PerformanceEventBuffer::to_binary(ProcessID pid, const String& executable_path) const
+{
+    KBufferBuilder builder;
+    if (!to_binary(builder, pid, executable_path))
+        return {};
+    return builder.build();
+}
+
+bool PerformanceEventBuffer::to_binary(KBufferBuilder& builder, ProcessID pid, const String& executable_path) const
+{
+    auto process = Process::from_pid(pid);
+    VERIFY(process);
+    ScopedSpinLock locker(process->space().get_lock());
+
+    u32 header[2] = { perfcore_magic, perfcore_version };
+    builder.append(reinterpret_cast<const char*>(header), sizeof(header));
+
+    u64 string_count = 0;
+    auto append_string = [&](const StringView& string) {
+        append_record(builder, PerfcoreRecord::String);
+        append_leb128(builder, string.length());
+        builder.append(string);
+        return string_count++;
+    };
+
+    auto executable_id = append_string(executable_path);
+    append_record(builder, PerfcoreRecord::Process);
+    append_leb128(builder, pid.value());
+    append_leb128(builder, executable_id);
+
+    auto sample_source_id = append_string(PerformanceCounters::sample_source_name(m_sample_source));
+    append_record(builder, PerfcoreRecord::SampleSource);
+    append_leb128(builder, sample_source_id);
+
+    for (const auto& region : process->space().regions()) {
+        auto name_id = append_string(region->name());
+        append_record(builder, PerfcoreRecord::Region);
+        append_leb128(builder, region->vaddr().get());
+        append_leb128(builder, region->size());
+        append_leb128(builder, name_id);
+    }
+
+    // Samples taken in a loop tend to repeat the exact same stack, so every distinct stack is
+    // only written once. Each stack id remembers the first event it was seen in.
+    HashMap<u32, Vector<u64, 1>> stack_ids_by_hash;
+    Vector<size_t> first_event_for_stack;
+    u64 previous_timestamp = 0;
+
+    for (size_t i = 0; i < m_count; ++i) {
+        auto& event = at(i);
+
+        auto hash = stack_hash(event);
+        auto& candidates = stack_ids_by_hash.ensure(hash);
+        Optional<u64> stack_id;
+        for (auto candidate : candidates) {
+            if (stacks_equal(at(first_event_for_stack[candidate]), event)) {
+                stack_id = candidate;
+                break;
+            }
+        }
+        if (!stack_id.has_value()) {
+            stack_id = first_event_for_stack.size();
+            first_event_for_stack.append(i);
+            candidates.append(stack_id.value());
+
+            append_record(builder, PerfcoreRecord::Stack);
+            append_leb128(builder, event.stack_size);
+            FlatPtr previous_frame = 0;
+            for (size_t j = 0; j < event.stack_size; ++j) {
+                // The difference wraps around, so it always fits into a FlatPtr.
+                auto delta = (FlatPtr)(event.stack[j] - previous_frame);
+                auto sign = (FlatPtr)((ssize_t)delta >> (sizeof(FlatPtr) * 8 - 1));
+                append_leb128(builder, (FlatPtr)(delta << 1) ^ sign);
+                previous_frame = event.stack[j];
+            }
+        }
+
+        append_record(builder, PerfcoreRecord::Event);
+        append_leb128(builder, event.type);
+        append_leb128(builder, event.tid);
+        append_leb128(builder, event.timestamp - previous_timestamp);
+        append_leb128(builder, stack_id.value());
+        switch (event.type) {
+        case PERF_EVENT_MALLOC:
+            append_leb128(builder, event.data.malloc.ptr);
+            append_leb128(builder, event.data.malloc.size);
+            break;
+        case PERF_EVENT_FREE:
+            append_leb128(builder, event.data.free.ptr);
+            break;
+        case PERF_EVENT_SAMPLE:
+            break;
+        default:
+            append_leb128(builder, event.data.tracepoint.arg1);
+            append_leb128(builder, event.data.tracepoint.arg2);
+            break;
+        }
+        previous_timestamp = event.timestamp;
+    }
+    return true;
+}
+
 }
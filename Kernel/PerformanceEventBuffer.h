@@ -28,6 +28,7 @@
 
 #include <Kernel/KBuffer.h>
 #include <Kernel/KResult.h>
+#include <Kernel/UnixTypes.h>
 
 namespace Kernel {
 
@@ -43,6 +44,12 @@ struct [[gnu::packed]] FreePerformanceEvent {
     FlatPtr ptr;
 };
 
+// Recorded by the kernel's tracepoints, see Kernel/Tracepoint.h.
+struct [[gnu::packed]] TracepointPerformanceEvent {
+    FlatPtr arg1;
+    FlatPtr arg2;
+};
+
 struct [[gnu::packed]] PerformanceEvent {
     u8 type { 0 };
     u8 stack_size { 0 };
@@ -51,6 +58,7 @@ struct [[gnu::packed]] PerformanceEvent {
     union {
         MallocPerformanceEvent malloc;
         FreePerformanceEvent free;
+        TracepointPerformanceEvent tracepoint;
     } data;
     static constexpr size_t max_stack_frame_count = 32;
     FlatPtr stack[max_stack_frame_count];
@@ -68,6 +76,10 @@ public:
         m_count = 0;
     }
 
+    // What the PERF_EVENT_SAMPLE events were taken on, one of PROFILING_SAMPLE_*.
+    int sample_source() const { return m_sample_source; }
+    void set_sample_source(int sample_source) { m_sample_source = sample_source; }
+
     size_t capacity() const
     {
         if (!m_buffer)
@@ -83,10 +95,19 @@ public:
     OwnPtr<KBuffer> to_json(ProcessID, const String& executable_path) const;
     bool to_json(KBufferBuilder&, ProcessID, const String& executable_path) const;
 
+    // Walks the frame pointer chain starting at ebp, returning eip and at most
+    // max_stack_frame_count - 1 return addresses.
+    static Vector<FlatPtr, PerformanceEvent::max_stack_frame_count> raw_backtrace(FlatPtr ebp, FlatPtr eip);
+
+    // The compact format described in Kernel/API/Perfcore.h, used for perfcore files.
+    OwnPtr<KBuffer> to_binary(ProcessID, const String& executable_path) const;
+    bool to_binary(KBufferBuilder&, ProcessID, const String& executable_path) const;
+
 private:
     PerformanceEvent& at(size_t index);
 
     size_t m_count { 0 };
+    int m_sample_source { PROFILING_SAMPLE_TIMER };
     OwnPtr<KBuffer> m_buffer;
 };
 
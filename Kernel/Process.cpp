@@ -453,12 +453,12 @@ bool Process::dump_perfcore()
     if (description_or_error.is_error())
         return false;
     auto& description = description_or_error.value();
-    auto json = m_perf_event_buffer->to_json(m_pid, m_executable ? m_executable->absolute_path() : "");
-    if (!json)
+    auto perfcore = m_perf_event_buffer->to_binary(m_pid, m_executable ? m_executable->absolute_path() : "");
+    if (!perfcore)
         return false;
 
-    auto json_buffer = UserOrKernelBuffer::for_kernel_buffer(json->data());
-    return !description->write(json_buffer, json->size()).is_error();
+    auto perfcore_buffer = UserOrKernelBuffer::for_kernel_buffer(perfcore->data());
+    return !description->write(perfcore_buffer, perfcore->size()).is_error();
 }
 
 void Process::finalize()
@@ -473,6 +473,7 @@ void Process::finalize()
         if (m_perf_event_buffer)
             dump_perfcore();
     }
+    disable_profiling();
 
     m_threads_for_coredump.clear();
 
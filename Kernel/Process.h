@@ -154,7 +154,10 @@ public:
     RefPtr<Thread> create_kernel_thread(void (*entry)(void*), void* entry_data, u32 priority, const String& name, u32 affinity = THREAD_AFFINITY_DEFAULT, bool joinable = true);
 
     bool is_profiling() const { return m_profiling; }
-    void set_profiling(bool profiling) { m_profiling = profiling; }
+    KResult enable_profiling(int sample_source);
+    void disable_profiling();
+    // One of PROFILING_SAMPLE_*, only meaningful while profiling.
+    int profiling_sample_source() const { return m_profiling_sample_source; }
     bool should_core_dump() const { return m_should_dump_core; }
     void set_dump_core(bool dump_core) { m_should_dump_core = dump_core; }
 
@@ -258,9 +261,17 @@ public:
     int sys$mprotect(void*, size_t, int prot);
     int sys$madvise(void*, size_t, int advice);
     int sys$msyscall(void*);
+    FlatPtr sys$reserve_shared_image(int fd, size_t);
     int sys$purge(int mode);
     int sys$select(const Syscall::SC_select_params*);
     int sys$poll(Userspace<const Syscall::SC_poll_params*>);
+    int sys$epoll_create(int flags);
+    int sys$epoll_ctl(Userspace<const Syscall::SC_epoll_ctl_params*>);
+    int sys$epoll_wait(Userspace<const Syscall::SC_epoll_wait_params*>);
+    ssize_t sys$sendfile(Userspace<const Syscall::SC_sendfile_params*>);
+    ssize_t sys$copy_file_range(Userspace<const Syscall::SC_copy_file_range_params*>);
+    int sys$io_ring_create(Userspace<const Syscall::SC_io_ring_create_params*>);
+    int sys$io_ring_enter(Userspace<const Syscall::SC_io_ring_enter_params*>);
     ssize_t sys$get_dir_entries(int fd, void*, ssize_t);
     int sys$getcwd(Userspace<char*>, size_t);
     int sys$chdir(Userspace<const char*>, size_t);
@@ -313,10 +324,14 @@ public:
     int sys$bind(int sockfd, Userspace<const sockaddr*> addr, socklen_t);
     int sys$listen(int sockfd, int backlog);
     int sys$accept(int sockfd, Userspace<sockaddr*>, Userspace<socklen_t*>);
+    // sys$accept() on behalf of an io_ring, which must not block regardless of the fd's mode.
+    int do_accept(int accepting_socket_fd, Userspace<sockaddr*>, Userspace<socklen_t*>, bool should_block);
     int sys$connect(int sockfd, Userspace<const sockaddr*>, socklen_t);
     int sys$shutdown(int sockfd, int how);
     ssize_t sys$sendmsg(int sockfd, Userspace<const struct msghdr*>, int flags);
     ssize_t sys$recvmsg(int sockfd, Userspace<struct msghdr*>, int flags);
+    int sys$sendmmsg(Userspace<const Syscall::SC_sendmmsg_params*>);
+    int sys$recvmmsg(Userspace<const Syscall::SC_recvmmsg_params*>);
     int sys$getsockopt(Userspace<const Syscall::SC_getsockopt_params*>);
     int sys$setsockopt(Userspace<const Syscall::SC_setsockopt_params*>);
     int sys$getsockname(Userspace<const Syscall::SC_getsockname_params*>);
@@ -339,7 +354,7 @@ public:
     int sys$setkeymap(Userspace<const Syscall::SC_setkeymap_params*>);
     int sys$module_load(Userspace<const char*> path, size_t path_length);
     int sys$module_unload(Userspace<const char*> name, size_t name_length);
-    int sys$profiling_enable(pid_t);
+    int sys$profiling_enable(pid_t, int sample_source);
     int sys$profiling_disable(pid_t);
     int sys$futex(Userspace<const Syscall::SC_futex_params*>);
     int sys$chroot(Userspace<const char*> path, size_t path_length, int mount_flags);
@@ -480,6 +495,8 @@ private:
 
     KResult do_exec(NonnullRefPtr<FileDescription> main_program_description, Vector<String> arguments, Vector<String> environment, RefPtr<FileDescription> interpreter_description, Thread*& new_main_thread, u32& prev_flags, const Elf32_Ehdr& main_program_header);
     ssize_t do_write(FileDescription&, const UserOrKernelBuffer&, size_t);
+    ssize_t do_sendmsg(FileDescription&, const struct msghdr&, int flags);
+    ssize_t do_recvmsg(FileDescription&, Userspace<struct msghdr*>, int flags);
 
     KResultOr<RefPtr<FileDescription>> find_elf_interpreter_for_executable(const String& path, const Elf32_Ehdr& elf_header, int nread, size_t file_size);
 
@@ -492,6 +509,8 @@ private:
 
     KResultOr<siginfo_t> do_waitid(idtype_t idtype, int id, int options);
 
+    int do_madvise(const Range&, int advice);
+
     KResultOr<String> get_syscall_path_argument(const char* user_path, size_t path_length) const;
     KResultOr<String> get_syscall_path_argument(Userspace<const char*> user_path, size_t path_length) const
     {
@@ -554,6 +573,7 @@ private:
     const bool m_is_kernel_process;
     bool m_dead { false };
     bool m_profiling { false };
+    int m_profiling_sample_source { PROFILING_SAMPLE_TIMER };
     Atomic<bool, AK::MemoryOrder::memory_order_relaxed> m_is_stopped { false };
     bool m_should_dump_core { false };
 
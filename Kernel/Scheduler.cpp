@@ -29,6 +29,7 @@
 #include <AK/TemporaryChange.h>
 #include <AK/Time.h>
 #include <Kernel/Debug.h>
+#include <Kernel/Devices/ProfileDevice.h>
 #include <Kernel/Panic.h>
 #include <Kernel/PerformanceEventBuffer.h>
 #include <Kernel/Process.h>
@@ -36,6 +37,7 @@
 #include <Kernel/Scheduler.h>
 #include <Kernel/Time/TimeManagement.h>
 #include <Kernel/TimerQueue.h>
+#include <Kernel/Tracepoint.h>
 
 // Remove this once SMP is stable and can be enabled by default
 #define SCHEDULE_ON_ALL_PROCESSORS 0
@@ -51,6 +53,7 @@ public:
 
     WeakPtr<Thread> m_pending_beneficiary;
     const char* m_pending_donate_reason { nullptr };
+    u32 m_ticks_until_load_balance { 0 };
     bool m_in_scheduler { true };
 };
 
@@ -72,15 +75,32 @@ READONLY_AFTER_INIT static Process* s_colonel_process;
 struct ThreadReadyQueue {
     IntrusiveList<Thread, &Thread::m_ready_queue_node> thread_list;
 };
-static SpinLock<u8> g_ready_queues_lock;
-static u32 g_ready_queues_mask;
-static constexpr u32 g_ready_queue_buckets = sizeof(g_ready_queues_mask) * 8;
-READONLY_AFTER_INIT static ThreadReadyQueue* g_ready_queues; // g_ready_queue_buckets entries
+static constexpr u32 g_ready_queue_buckets = sizeof(u32) * 8;
+
+// Every processor owns a set of priority ready queues, protected by its
+// own lock. Threads are queued on the processor they last ran on (if their
+// affinity allows it), and idle processors steal work from the busiest one.
+struct ProcessorReadyQueues {
+    SpinLock<u8> lock;
+    u32 mask { 0 };
+    u32 runnable_count { 0 };
+    ThreadReadyQueue queues[g_ready_queue_buckets];
+};
+static constexpr u32 g_max_processors = sizeof(u32) * 8; // Limited by the width of the affinity mask
+READONLY_AFTER_INIT static ProcessorReadyQueues* g_ready_queues; // g_max_processors entries
+static Atomic<u32> g_scheduling_processors_mask { 0 };
+
+// Only move a thread away from the processor it last ran on if that
+// processor has at least this many more runnable threads queued.
+static constexpr u32 g_load_balance_imbalance_threshold = 2;
+
+// How often a processor that is still taking timer ticks evens out the ready queues, see balance_ready_queues().
+static constexpr u32 g_load_balance_interval_ticks = 25;
 
 static inline u32 thread_priority_to_priority_index(u32 thread_priority)
 {
     // Converts the priority in the range of THREAD_PRIORITY_MIN...THREAD_PRIORITY_MAX
-    // to a index into g_ready_queues where 0 is the highest priority bucket
+    // to a index into the ready queues where 0 is the highest priority bucket
     VERIFY(thread_priority >= THREAD_PRIORITY_MIN && thread_priority <= THREAD_PRIORITY_MAX);
     constexpr u32 thread_priority_count = THREAD_PRIORITY_MAX - THREAD_PRIORITY_MIN + 1;
     static_assert(thread_priority_count > 0);
@@ -89,41 +109,120 @@ static inline u32 thread_priority_to_priority_index(u32 thread_priority)
     return priority_bucket;
 }
 
+static inline u32 runnable_count_for(u32 cpu)
+{
+    // NOTE: This is only used as a load hint, so we don't bother taking the lock.
+    return AK::atomic_load(&g_ready_queues[cpu].runnable_count, AK::MemoryOrder::memory_order_relaxed);
+}
+
+static u32 pick_processor_for(const Thread& thread)
+{
+    u32 affinity = thread.affinity();
+    u32 candidates = affinity & g_scheduling_processors_mask.load(AK::MemoryOrder::memory_order_acquire);
+    if (candidates == 0) {
+        // None of the processors this thread may run on are scheduling yet.
+        // Park it on the first one it's allowed on, it will get picked
+        // up (or stolen) once that processor starts scheduling.
+        if (affinity == 0)
+            return 0;
+        return __builtin_ffs(affinity) - 1;
+    }
+
+    u32 least_loaded_cpu = 0;
+    u32 least_load = NumericLimits<u32>::max();
+    for (u32 mask = candidates; mask != 0; mask &= mask - 1) {
+        u32 cpu = __builtin_ffs(mask) - 1;
+        u32 load = runnable_count_for(cpu);
+        if (load < least_load) {
+            least_load = load;
+            least_loaded_cpu = cpu;
+        }
+    }
+
+    // Prefer the processor the thread last ran on to keep caches warm,
+    // unless it's noticeably busier than the least loaded one.
+    u32 last_cpu = thread.cpu();
+    if (last_cpu < g_max_processors && (candidates & (1u << last_cpu))) {
+        if (runnable_count_for(last_cpu) < least_load + g_load_balance_imbalance_threshold)
+            return last_cpu;
+    }
+    return least_loaded_cpu;
+}
+
 Thread& Scheduler::pull_next_runnable_thread()
 {
-    auto affinity_mask = 1u << Processor::current().id();
+    auto cpu = Processor::id();
+    auto affinity_mask = 1u << cpu;
+
+    auto pull_runnable_thread_from = [&](ProcessorReadyQueues& ready_queues) -> Thread* {
+        ScopedSpinLock lock(ready_queues.lock);
+        auto priority_mask = ready_queues.mask;
+        while (priority_mask != 0) {
+            auto priority = __builtin_ffsl(priority_mask);
+            VERIFY(priority > 0);
+            auto& ready_queue = ready_queues.queues[--priority];
+            for (auto& thread : ready_queue.thread_list) {
+                VERIFY(thread.m_runnable_priority == (int)priority);
+                if (thread.is_active())
+                    continue;
+                if (!(thread.affinity() & affinity_mask))
+                    continue;
+                thread.m_runnable_priority = -1;
+                thread.m_runnable_cpu = -1;
+                ready_queue.thread_list.remove(thread);
+                ready_queues.runnable_count--;
+                if (ready_queue.thread_list.is_empty())
+                    ready_queues.mask &= ~(1u << priority);
+                // Mark it as active because we are using this thread. This is similar
+                // to comparing it with Processor::current_thread, but when there are
+                // multiple processors there's no easy way to check whether the thread
+                // is actually still needed. This prevents accidental finalization when
+                // a thread is no longer in Running state, but running on another core.
+
+                // We need to mark it active here so that this thread won't be
+                // scheduled on another core if it were to be queued before actually
+                // switching to it.
+                // FIXME: Figure out a better way maybe?
+                thread.set_active(true);
+                return &thread;
+            }
+            priority_mask &= ~(1u << priority);
+        }
+        return nullptr;
+    };
+
+    if (auto* thread = pull_runnable_thread_from(g_ready_queues[cpu]))
+        return *thread;
+
+    // Our own queues are empty, try to steal work from the busiest processor
+    // first, then from anyone else that has something we're allowed to run.
+    u32 busiest_cpu = cpu;
+    u32 busiest_load = 0;
+    for (u32 other_cpu = 0; other_cpu < g_max_processors; other_cpu++) {
+        if (other_cpu == cpu)
+            continue;
+        u32 load = runnable_count_for(other_cpu);
+        if (load > busiest_load) {
+            busiest_load = load;
+            busiest_cpu = other_cpu;
+        }
+    }
+    if (busiest_cpu == cpu)
+        return *Processor::current().idle_thread();
 
-    ScopedSpinLock lock(g_ready_queues_lock);
-    auto priority_mask = g_ready_queues_mask;
-    while (priority_mask != 0) {
-        auto priority = __builtin_ffsl(priority_mask);
-        VERIFY(priority > 0);
-        auto& ready_queue = g_ready_queues[--priority];
-        for (auto& thread : ready_queue.thread_list) {
-            VERIFY(thread.m_runnable_priority == (int)priority);
-            if (thread.is_active())
-                continue;
-            if (!(thread.affinity() & affinity_mask))
-                continue;
-            thread.m_runnable_priority = -1;
-            ready_queue.thread_list.remove(thread);
-            if (ready_queue.thread_list.is_empty())
-                g_ready_queues_mask &= ~(1u << priority);
-            // Mark it as active because we are using this thread. This is similar
-            // to comparing it with Processor::current_thread, but when there are
-            // multiple processors there's no easy way to check whether the thread
-            // is actually still needed. This prevents accidental finalization when
-            // a thread is no longer in Running state, but running on another core.
-
-            // We need to mark it active here so that this thread won't be
-            // scheduled on another core if it were to be queued before actually
-            // switching to it.
-            // FIXME: Figure out a better way maybe?
-            thread.set_active(true);
-            return thread;
+    if (auto* thread = pull_runnable_thread_from(g_ready_queues[busiest_cpu])) {
+        dbgln_if(SCHEDULER_DEBUG, "Scheduler[{}]: Stole {} from processor {}", cpu, *thread, busiest_cpu);
+        return *thread;
+    }
+    for (u32 other_cpu = 0; other_cpu < g_max_processors; other_cpu++) {
+        if (other_cpu == cpu || other_cpu == busiest_cpu || runnable_count_for(other_cpu) == 0)
+            continue;
+        if (auto* thread = pull_runnable_thread_from(g_ready_queues[other_cpu])) {
+            dbgln_if(SCHEDULER_DEBUG, "Scheduler[{}]: Stole {} from processor {}", cpu, *thread, other_cpu);
+            return *thread;
         }
-        priority_mask &= ~(1u << priority);
     }
+
     return *Processor::current().idle_thread();
 }
 
@@ -131,23 +230,35 @@ bool Scheduler::dequeue_runnable_thread(Thread& thread, bool check_affinity)
 {
     if (&thread == Processor::current().idle_thread())
         return true;
-    ScopedSpinLock lock(g_ready_queues_lock);
-    auto priority = thread.m_runnable_priority;
-    if (priority < 0) {
-        VERIFY(!thread.m_ready_queue_node.is_in_list());
-        return false;
-    }
 
     if (check_affinity && !(thread.affinity() & (1 << Processor::current().id())))
         return false;
 
-    VERIFY(g_ready_queues_mask & (1u << priority));
-    auto& ready_queue = g_ready_queues[priority];
-    thread.m_runnable_priority = -1;
-    ready_queue.thread_list.remove(thread);
-    if (ready_queue.thread_list.is_empty())
-        g_ready_queues_mask &= ~(1u << priority);
-    return true;
+    for (;;) {
+        auto queue_cpu = thread.m_runnable_cpu;
+        if (queue_cpu < 0) {
+            VERIFY(!thread.m_ready_queue_node.is_in_list());
+            return false;
+        }
+
+        auto& ready_queues = g_ready_queues[queue_cpu];
+        ScopedSpinLock lock(ready_queues.lock);
+        if (thread.m_runnable_cpu != queue_cpu) {
+            // Someone moved the thread while we were acquiring the lock, try again.
+            continue;
+        }
+        auto priority = thread.m_runnable_priority;
+        VERIFY(priority >= 0);
+        VERIFY(ready_queues.mask & (1u << priority));
+        auto& ready_queue = ready_queues.queues[priority];
+        thread.m_runnable_priority = -1;
+        thread.m_runnable_cpu = -1;
+        ready_queue.thread_list.remove(thread);
+        ready_queues.runnable_count--;
+        if (ready_queue.thread_list.is_empty())
+            ready_queues.mask &= ~(1u << priority);
+        return true;
+    }
 }
 
 void Scheduler::queue_runnable_thread(Thread& thread)
@@ -156,16 +267,91 @@ void Scheduler::queue_runnable_thread(Thread& thread)
     if (&thread == Processor::current().idle_thread())
         return;
     auto priority = thread_priority_to_priority_index(thread.priority());
+    auto cpu = pick_processor_for(thread);
+
+    auto& ready_queues = g_ready_queues[cpu];
+    {
+        ScopedSpinLock lock(ready_queues.lock);
+        VERIFY(thread.m_runnable_priority < 0);
+        VERIFY(thread.m_runnable_cpu < 0);
+        thread.m_runnable_priority = (int)priority;
+        thread.m_runnable_cpu = (int)cpu;
+        VERIFY(!thread.m_ready_queue_node.is_in_list());
+        auto& ready_queue = ready_queues.queues[priority];
+        bool was_empty = ready_queue.thread_list.is_empty();
+        ready_queue.thread_list.append(thread);
+        ready_queues.runnable_count++;
+        if (was_empty)
+            ready_queues.mask |= (1u << priority);
+    }
+
+    // The processor we queued the thread on may be halted in its idle loop, and
+    // with tickless idle nothing else is going to wake it up. If it's busy,
+    // give an idle processor the chance to steal the thread instead.
+    if (!Processor::smp_wake_idle_processor(cpu))
+        Processor::smp_wake_n_idle_processors(1);
+}
+
+static bool migrate_runnable_thread(u32 from_cpu, u32 to_cpu)
+{
+    auto& from_queues = g_ready_queues[from_cpu];
+    auto& to_queues = g_ready_queues[to_cpu];
+    // Always take the locks in the same order, we may be racing another processor doing the same.
+    ScopedSpinLock first_lock(from_cpu < to_cpu ? from_queues.lock : to_queues.lock);
+    ScopedSpinLock second_lock(from_cpu < to_cpu ? to_queues.lock : from_queues.lock);
 
-    ScopedSpinLock lock(g_ready_queues_lock);
-    VERIFY(thread.m_runnable_priority < 0);
-    thread.m_runnable_priority = (int)priority;
-    VERIFY(!thread.m_ready_queue_node.is_in_list());
-    auto& ready_queue = g_ready_queues[priority];
-    bool was_empty = ready_queue.thread_list.is_empty();
-    ready_queue.thread_list.append(thread);
-    if (was_empty)
-        g_ready_queues_mask |= (1u << priority);
+    auto priority_mask = from_queues.mask;
+    while (priority_mask != 0) {
+        auto priority = __builtin_ffsl(priority_mask) - 1;
+        auto& ready_queue = from_queues.queues[priority];
+        for (auto& thread : ready_queue.thread_list) {
+            if (thread.is_active() || !(thread.affinity() & (1u << to_cpu)))
+                continue;
+            ready_queue.thread_list.remove(thread);
+            from_queues.runnable_count--;
+            if (ready_queue.thread_list.is_empty())
+                from_queues.mask &= ~(1u << priority);
+
+            auto& new_ready_queue = to_queues.queues[priority];
+            if (new_ready_queue.thread_list.is_empty())
+                to_queues.mask |= (1u << priority);
+            new_ready_queue.thread_list.append(thread);
+            to_queues.runnable_count++;
+            thread.m_runnable_cpu = (int)to_cpu;
+            return true;
+        }
+        priority_mask &= ~(1u << priority);
+    }
+    return false;
+}
+
+static void balance_ready_queues()
+{
+    // Processors only steal work once their own queues run dry, and idle processors
+    // may not be taking timer ticks at all, so every now and then the ones that still
+    // tick make sure queued threads don't wait behind a busy processor for too long.
+    auto cpu = Processor::id();
+    u32 own_load = runnable_count_for(cpu);
+    if (own_load > 0) {
+        // We have threads waiting, let any idle processor come and steal them.
+        ScopedCritical critical;
+        Processor::smp_wake_n_idle_processors(own_load);
+        return;
+    }
+
+    u32 busiest_cpu = cpu;
+    u32 busiest_load = 0;
+    for (u32 other_cpu = 0; other_cpu < g_max_processors; other_cpu++) {
+        u32 load = runnable_count_for(other_cpu);
+        if (other_cpu != cpu && load > busiest_load) {
+            busiest_load = load;
+            busiest_cpu = other_cpu;
+        }
+    }
+    if (busiest_cpu == cpu || busiest_load < g_load_balance_imbalance_threshold)
+        return;
+    if (migrate_runnable_thread(busiest_cpu, cpu))
+        dbgln_if(SCHEDULER_DEBUG, "Scheduler[{}]: Pulled a thread from processor {}", cpu, busiest_cpu);
 }
 
 UNMAP_AFTER_INIT void Scheduler::start()
@@ -188,6 +374,10 @@ UNMAP_AFTER_INIT void Scheduler::start()
     processor.init_context(idle_thread, false);
     idle_thread.set_state(Thread::Running);
     VERIFY(idle_thread.affinity() == (1u << processor.get_id()));
+#if !SCHEDULE_ON_ALL_PROCESSORS
+    if (processor.get_id() == 0)
+#endif
+        g_scheduling_processors_mask.fetch_or(1u << processor.get_id(), AK::MemoryOrder::memory_order_acq_rel);
     processor.initialize_context_switching(idle_thread);
     VERIFY_NOT_REACHED();
 }
@@ -393,9 +583,13 @@ bool Scheduler::context_switch(Thread* thread)
     if (from_thread) {
         // If the last process hasn't blocked (still marked as running),
         // mark it as runnable for the next round.
-        if (from_thread->state() == Thread::Running)
+        bool voluntary = from_thread->state() != Thread::Running;
+        from_thread->did_context_switch_away(voluntary);
+        if (!voluntary)
             from_thread->set_state(Thread::Runnable);
 
+        TRACEPOINT(ContextSwitch, thread->tid().value(), 0);
+
 #ifdef LOG_EVERY_CONTEXT_SWITCH
         dbgln("Scheduler[{}]: {} -> {} [prio={}] {:04x}:{:08x}", Processor::id(), from_thread->tid().value(), thread->tid().value(), thread->priority(), thread->tss().cs, thread->tss().eip);
 #endif
@@ -494,7 +688,7 @@ UNMAP_AFTER_INIT void Scheduler::initialize()
 
     RefPtr<Thread> idle_thread;
     g_finalizer_wait_queue = new WaitQueue;
-    g_ready_queues = new ThreadReadyQueue[g_ready_queue_buckets];
+    g_ready_queues = new ProcessorReadyQueues[g_max_processors];
 
     g_finalizer_has_work.store(false, AK::MemoryOrder::memory_order_release);
     s_colonel_process = Process::create_kernel_process(idle_thread, "colonel", idle_loop, nullptr, 1).leak_ref();
@@ -537,17 +731,26 @@ void Scheduler::timer_tick(const RegisterState& regs)
     VERIFY(current_thread->current_trap());
     VERIFY(current_thread->current_trap()->regs == &regs);
 
+    if (ProfileDevice::is_sampling() && current_thread != Processor::current().idle_thread())
+        ProfileDevice::the().sample(*current_thread, regs);
+
 #if !SCHEDULE_ON_ALL_PROCESSORS
     bool is_bsp = Processor::id() == 0;
     if (!is_bsp)
         return; // TODO: This prevents scheduling on other CPUs!
 #endif
-    if (current_thread->process().is_profiling()) {
+    if (current_thread->process().is_profiling() && current_thread->process().profiling_sample_source() == PROFILING_SAMPLE_TIMER) {
         VERIFY(current_thread->process().perf_events());
         auto& perf_events = *current_thread->process().perf_events();
         [[maybe_unused]] auto rc = perf_events.append_with_eip_and_ebp(regs.eip, regs.ebp, PERF_EVENT_SAMPLE, 0, 0);
     }
 
+    auto& scheduler_data = Processor::current().get_scheduler_data();
+    if (scheduler_data.m_ticks_until_load_balance-- == 0) {
+        scheduler_data.m_ticks_until_load_balance = g_load_balance_interval_ticks;
+        balance_ready_queues();
+    }
+
     if (current_thread->tick())
         return;
 
@@ -596,9 +799,19 @@ void Scheduler::idle_loop(void*)
     dbgln("Scheduler[{}]: idle loop running", proc.get_id());
     VERIFY(are_interrupts_enabled());
 
+    bool tickless = TimeManagement::the().tick_mode() == TickMode::TicklessIdle;
     for (;;) {
         proc.idle_begin();
-        asm("hlt");
+        if (tickless) {
+            // Interrupts stay disabled until the hlt, so we can't miss a
+            // wakeup between computing the deadline and halting.
+            cli();
+            TimeManagement::the().stop_tick_for_idle();
+            asm volatile("sti; hlt");
+            TimeManagement::the().restart_tick_after_idle();
+        } else {
+            asm("hlt");
+        }
 
         proc.idle_end();
         VERIFY_INTERRUPTS_ENABLED();
@@ -51,6 +51,15 @@ public:
         return prev_flags;
     }
 
+    [[nodiscard]] ALWAYS_INLINE bool try_lock(u32& prev_flags)
+    {
+        Processor::current().enter_critical(prev_flags);
+        if (m_lock.exchange(1, AK::memory_order_acquire) == 0)
+            return true;
+        Processor::current().leave_critical(prev_flags);
+        return false;
+    }
+
     ALWAYS_INLINE void unlock(u32 prev_flags)
     {
         VERIFY(is_locked());
@@ -201,15 +201,19 @@ void* memcpy(void* dest_ptr, const void* src_ptr, size_t n)
 {
     size_t dest = (size_t)dest_ptr;
     size_t src = (size_t)src_ptr;
-    // FIXME: Support starting at an unaligned address.
-    if (!(dest & 0x3) && !(src & 0x3) && n >= 12) {
+    // NOTE: The kernel is built without SSE and doesn't preserve FPU state for its own code,
+    //       so the best we can do is to move whole words with aligned stores.
+    if (n >= 12) {
+        size_t head = (sizeof(size_t) - (dest & 0x3)) & 0x3;
+        n -= head;
+        asm volatile(
+            "rep movsb\n"
+            : "+S"(src), "+D"(dest), "+c"(head)::"memory");
         size_t size_ts = n / sizeof(size_t);
         asm volatile(
             "rep movsl\n"
-            : "=S"(src), "=D"(dest)
-            : "S"(src), "D"(dest), "c"(size_ts)
-            : "memory");
-        n -= size_ts * sizeof(size_t);
+            : "+S"(src), "+D"(dest), "+c"(size_ts)::"memory");
+        n &= sizeof(size_t) - 1;
         if (n == 0)
             return dest_ptr;
     }
@@ -253,18 +257,24 @@ const void* memmem(const void* haystack, size_t haystack_length, const void* nee
 void* memset(void* dest_ptr, int c, size_t n)
 {
     size_t dest = (size_t)dest_ptr;
-    // FIXME: Support starting at an unaligned address.
-    if (!(dest & 0x3) && n >= 12) {
+    if (n >= 12) {
+        size_t head = (sizeof(size_t) - (dest & 0x3)) & 0x3;
+        n -= head;
+        asm volatile(
+            "rep stosb\n"
+            : "+D"(dest), "+c"(head)
+            : "a"(c)
+            : "memory");
         size_t size_ts = n / sizeof(size_t);
         size_t expanded_c = (u8)c;
         expanded_c |= expanded_c << 8;
         expanded_c |= expanded_c << 16;
         asm volatile(
             "rep stosl\n"
-            : "=D"(dest)
-            : "D"(dest), "c"(size_ts), "a"(expanded_c)
+            : "+D"(dest), "+c"(size_ts)
+            : "a"(expanded_c)
             : "memory");
-        n -= size_ts * sizeof(size_t);
+        n &= sizeof(size_t) - 1;
         if (n == 0)
             return dest_ptr;
     }
@@ -278,10 +288,24 @@ void* memset(void* dest_ptr, int c, size_t n)
 
 size_t strlen(const char* str)
 {
-    size_t len = 0;
-    while (*(str++))
-        ++len;
-    return len;
+    const char* s = str;
+    while ((FlatPtr)s & (sizeof(size_t) - 1)) {
+        if (!*s)
+            return s - str;
+        ++s;
+    }
+    // Check a whole word at a time. An aligned word never straddles a page boundary,
+    // so reading past the terminator can't fault.
+    constexpr size_t low_bits = explode_byte(0x01);
+    constexpr size_t high_bits = explode_byte(0x80);
+    using AliasingWord [[gnu::may_alias]] = size_t;
+    auto* word = (const AliasingWord*)s;
+    while (!((*word - low_bits) & ~*word & high_bits))
+        ++word;
+    s = (const char*)word;
+    while (*s)
+        ++s;
+    return s - str;
 }
 
 size_t strnlen(const char* str, size_t maxlen)
@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//
+// Advanced Host Controller Interface (AHCI) definitions
+//
+// More information about AHCI can be found here:
+//      https://www.intel.com/content/dam/www/public/us/en/documents/technical-specifications/serial-ata-ahci-spec-rev1-3-1.pdf
+//
+
+#pragma once
+
+#include <AK/Types.h>
+
+namespace Kernel::AHCI {
+
+namespace HBA {
+
+enum GlobalHostControl : u32 {
+    HBAReset = 1 << 0,
+    InterruptEnable = 1 << 1,
+    AHCIEnable = 1u << 31,
+};
+
+enum Capabilities : u32 {
+    SupportsNativeCommandQueuing = 1 << 30,
+    Supports64BitAddressing = 1u << 31,
+};
+
+}
+
+namespace Port {
+
+enum Command : u32 {
+    Start = 1 << 0,
+    SpinUpDevice = 1 << 1,
+    PowerOnDevice = 1 << 2,
+    FISReceiveEnable = 1 << 4,
+    FISReceiveRunning = 1 << 14,
+    CommandListRunning = 1 << 15,
+};
+
+enum InterruptStatus : u32 {
+    DeviceToHostRegisterFIS = 1 << 0,
+    PIOSetupFIS = 1 << 1,
+    DMASetupFIS = 1 << 2,
+    SetDeviceBitsFIS = 1 << 3,
+    InterfaceFatalError = 1 << 27,
+    HostBusDataError = 1 << 28,
+    HostBusFatalError = 1 << 29,
+    TaskFileError = 1 << 30,
+};
+
+constexpr u32 error_interrupts = InterruptStatus::InterfaceFatalError | InterruptStatus::HostBusDataError | InterruptStatus::HostBusFatalError | InterruptStatus::TaskFileError;
+
+enum TaskFileData : u32 {
+    Error = 1 << 0,
+    DataRequest = 1 << 3,
+    Busy = 1 << 7,
+};
+
+// Values of the SStatus register's device detection field.
+constexpr u32 device_present_and_phy_established = 3;
+// Value of the signature register for a plain SATA drive.
+constexpr u32 sata_drive_signature = 0x00000101;
+
+}
+
+struct [[gnu::packed]] PortRegisters {
+    u32 clb;       // Command list base address
+    u32 clbu;      // Command list base address, upper 32 bits
+    u32 fb;        // FIS base address
+    u32 fbu;       // FIS base address, upper 32 bits
+    u32 is;        // Interrupt status
+    u32 ie;        // Interrupt enable
+    u32 cmd;       // Command and status
+    u32 reserved0;
+    u32 tfd;       // Task file data
+    u32 sig;       // Signature
+    u32 ssts;      // Serial ATA status (SStatus)
+    u32 sctl;      // Serial ATA control (SControl)
+    u32 serr;      // Serial ATA error (SError)
+    u32 sact;      // Serial ATA active (SActive)
+    u32 ci;        // Command issue
+    u32 sntf;      // Serial ATA notification
+    u32 fbs;       // FIS-based switching control
+    u32 reserved1[11];
+    u32 vendor[4];
+};
+static_assert(sizeof(PortRegisters) == 0x80);
+
+struct [[gnu::packed]] HBARegisters {
+    u32 cap;       // Host capabilities
+    u32 ghc;       // Global host control
+    u32 is;        // Interrupt status
+    u32 pi;        // Ports implemented
+    u32 vs;        // Version
+    u32 ccc_ctl;   // Command completion coalescing control
+    u32 ccc_ports; // Command completion coalescing ports
+    u32 em_loc;    // Enclosure management location
+    u32 em_ctl;    // Enclosure management control
+    u32 cap2;      // Host capabilities extended
+    u32 bohc;      // BIOS/OS handoff control and status
+    u8 reserved[0xa0 - 0x2c];
+    u8 vendor[0x100 - 0xa0];
+    PortRegisters ports[32];
+};
+static_assert(sizeof(HBARegisters) == 0x1100);
+
+struct [[gnu::packed]] CommandHeader {
+    u16 attributes; // Command FIS length in dwords, write bit, etc.
+    u16 prdtl;      // Number of entries in the physical region descriptor table
+    u32 prdbc;      // Number of bytes transferred
+    u32 ctba;       // Command table base address
+    u32 ctbau;      // Command table base address, upper 32 bits
+    u32 reserved[4];
+};
+static_assert(sizeof(CommandHeader) == 32);
+
+namespace CommandHeaderAttributes {
+constexpr u16 Write = 1 << 6;
+constexpr u16 ClearBusyUponOk = 1 << 10;
+}
+
+struct [[gnu::packed]] PhysicalRegionDescriptor {
+    u32 base_low;
+    u32 base_high;
+    u32 reserved;
+    u32 byte_count; // Bits 0-21 hold the byte count minus one, bit 31 requests an interrupt.
+};
+static_assert(sizeof(PhysicalRegionDescriptor) == 16);
+
+namespace FIS {
+
+enum class Type : u8 {
+    RegisterHostToDevice = 0x27,
+    RegisterDeviceToHost = 0x34,
+};
+
+struct [[gnu::packed]] RegisterHostToDevice {
+    Type fis_type;
+    u8 flags; // Bit 7 is set for commands, clear for control updates.
+    u8 command;
+    u8 features_low;
+    u8 lba_low[3];
+    u8 device;
+    u8 lba_high[3];
+    u8 features_high;
+    u8 count_low;
+    u8 count_high;
+    u8 icc;
+    u8 control;
+    u32 reserved;
+};
+static_assert(sizeof(RegisterHostToDevice) == 20);
+
+}
+
+template<size_t descriptor_count>
+struct [[gnu::packed]] CommandTable {
+    u8 command_fis[64];
+    u8 atapi_command[16];
+    u8 reserved[48];
+    PhysicalRegionDescriptor descriptors[descriptor_count];
+};
+
+}
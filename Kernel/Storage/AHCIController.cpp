@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/OwnPtr.h>
+#include <AK/RefPtr.h>
+#include <AK/Types.h>
+#include <Kernel/Debug.h>
+#include <Kernel/Storage/AHCIController.h>
+#include <Kernel/VM/MemoryManager.h>
+
+namespace Kernel {
+
+UNMAP_AFTER_INIT AHCIInterruptHandler::AHCIInterruptHandler(AHCIController& controller, u8 irq)
+    : IRQHandler(irq)
+    , m_controller(controller)
+{
+}
+
+AHCIInterruptHandler::~AHCIInterruptHandler()
+{
+}
+
+void AHCIInterruptHandler::handle_irq(const RegisterState&)
+{
+    m_controller.handle_interrupt();
+}
+
+UNMAP_AFTER_INIT NonnullRefPtr<AHCIController> AHCIController::initialize(PCI::Address address)
+{
+    return adopt(*new AHCIController(address));
+}
+
+bool AHCIController::reset()
+{
+    TODO();
+}
+
+bool AHCIController::shutdown()
+{
+    TODO();
+}
+
+size_t AHCIController::devices_count() const
+{
+    size_t count = 0;
+    for (auto& port : m_ports) {
+        if (port && port->device())
+            count++;
+    }
+    return count;
+}
+
+void AHCIController::start_request(const StorageDevice&, AsyncBlockDeviceRequest&)
+{
+    VERIFY_NOT_REACHED();
+}
+
+void AHCIController::complete_current_request(AsyncDeviceRequest::RequestResult)
+{
+    VERIFY_NOT_REACHED();
+}
+
+UNMAP_AFTER_INIT AHCIController::AHCIController(PCI::Address address)
+    : StorageController()
+    , PCI::DeviceController(address)
+{
+    initialize();
+}
+
+UNMAP_AFTER_INIT AHCIController::~AHCIController()
+{
+}
+
+UNMAP_AFTER_INIT void AHCIController::initialize()
+{
+    // The HBA's registers live in the memory space pointed to by BAR5 (ABAR).
+    auto abar = PhysicalAddress(PCI::get_BAR5(pci_address()) & 0xfffffff0);
+    m_hba_offset_in_page = abar.offset_in_page();
+    m_hba_region = MM.allocate_kernel_region(abar.page_base(), page_round_up(m_hba_offset_in_page + sizeof(AHCI::HBARegisters)), "AHCI HBA", Region::Access::Read | Region::Access::Write, Region::Cacheable::No);
+    VERIFY(m_hba_region);
+
+    PCI::enable_bus_mastering(pci_address());
+    hba().ghc = hba().ghc | AHCI::HBA::GlobalHostControl::AHCIEnable;
+
+    u32 capabilities = hba().cap;
+    bool supports_ncq = capabilities & AHCI::HBA::Capabilities::SupportsNativeCommandQueuing;
+    u32 ports_implemented = hba().pi;
+    dbgln("AHCIController: {} at {}, ports implemented {:#08x}, native command queuing {}", pci_address(), abar, ports_implemented, supports_ncq ? "supported" : "not supported");
+
+    for (u32 port_index = 0; port_index < 32; ++port_index) {
+        if (!(ports_implemented & (1u << port_index)))
+            continue;
+        m_ports[port_index] = AHCIPort::create(*this, hba().ports[port_index], port_index, supports_ncq);
+    }
+
+    // Clear anything that came in while we were setting up the ports.
+    hba().is = 0xffffffff;
+    m_interrupt_handler = make<AHCIInterruptHandler>(*this, PCI::get_interrupt_line(pci_address()));
+    m_interrupt_handler->enable_message_signalled_interrupts(pci_address());
+    hba().ghc = hba().ghc | AHCI::HBA::GlobalHostControl::InterruptEnable;
+    m_interrupt_handler->enable_irq();
+}
+
+void AHCIController::handle_interrupt()
+{
+    u32 pending_ports = hba().is;
+    dbgln_if(AHCI_DEBUG, "AHCIController: Interrupt, pending ports {:#08x}", pending_ports);
+    for (u32 port_index = 0; port_index < 32; ++port_index) {
+        if (!(pending_ports & (1u << port_index)))
+            continue;
+        if (m_ports[port_index])
+            m_ports[port_index]->handle_interrupt();
+    }
+    // The per-port interrupt status has to be cleared before the global one.
+    hba().is = pending_ports;
+}
+
+RefPtr<StorageDevice> AHCIController::device(u32 index) const
+{
+    for (auto& port : m_ports) {
+        if (!port || !port->device())
+            continue;
+        if (index-- == 0)
+            return port->device();
+    }
+    return nullptr;
+}
+
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Array.h>
+#include <AK/OwnPtr.h>
+#include <AK/RefPtr.h>
+#include <Kernel/Interrupts/IRQHandler.h>
+#include <Kernel/PCI/DeviceController.h>
+#include <Kernel/Storage/AHCI.h>
+#include <Kernel/Storage/AHCIPort.h>
+#include <Kernel/Storage/StorageController.h>
+#include <Kernel/Storage/StorageDevice.h>
+
+namespace Kernel {
+
+class AsyncBlockDeviceRequest;
+class AHCIController;
+
+class AHCIInterruptHandler final : public IRQHandler {
+    AK_MAKE_ETERNAL
+public:
+    AHCIInterruptHandler(AHCIController&, u8 irq);
+    virtual ~AHCIInterruptHandler() override;
+
+    virtual const char* purpose() const override { return "AHCI Controller"; }
+
+private:
+    //^ IRQHandler
+    virtual void handle_irq(const RegisterState&) override;
+
+    AHCIController& m_controller;
+};
+
+class AHCIController final : public StorageController
+    , public PCI::DeviceController {
+    friend class AHCIInterruptHandler;
+    AK_MAKE_ETERNAL
+public:
+    static NonnullRefPtr<AHCIController> initialize(PCI::Address address);
+    virtual ~AHCIController() override;
+
+    virtual Type type() const override { return Type::AHCI; }
+    virtual RefPtr<StorageDevice> device(u32 index) const override;
+    virtual bool reset() override;
+    virtual bool shutdown() override;
+    virtual size_t devices_count() const override;
+    virtual void start_request(const StorageDevice&, AsyncBlockDeviceRequest&) override;
+    virtual void complete_current_request(AsyncDeviceRequest::RequestResult) override;
+
+private:
+    explicit AHCIController(PCI::Address address);
+
+    void initialize();
+    void handle_interrupt();
+
+    volatile AHCI::HBARegisters& hba() { return *reinterpret_cast<volatile AHCI::HBARegisters*>(m_hba_region->vaddr().offset(m_hba_offset_in_page).as_ptr()); }
+
+    OwnPtr<Region> m_hba_region;
+    size_t m_hba_offset_in_page { 0 };
+    Array<OwnPtr<AHCIPort>, 32> m_ports;
+    OwnPtr<AHCIInterruptHandler> m_interrupt_handler;
+};
+}
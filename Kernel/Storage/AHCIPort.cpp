@@ -0,0 +1,377 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/ByteBuffer.h>
+#include <Kernel/Debug.h>
+#include <Kernel/Devices/BlockDevice.h>
+#include <Kernel/IO.h>
+#include <Kernel/Storage/AHCIController.h>
+#include <Kernel/Storage/AHCIPort.h>
+#include <Kernel/Storage/SATADiskDevice.h>
+#include <Kernel/VM/MemoryManager.h>
+#include <Kernel/WorkQueue.h>
+
+namespace Kernel {
+
+#define ATA_CMD_READ_DMA_EXT 0x25
+#define ATA_CMD_WRITE_DMA_EXT 0x35
+#define ATA_CMD_READ_FPDMA_QUEUED 0x60
+#define ATA_CMD_WRITE_FPDMA_QUEUED 0x61
+#define ATA_CMD_IDENTIFY 0xEC
+
+#define ATA_IDENT_MODEL 54
+#define ATA_IDENT_QUEUE_DEPTH 150
+#define ATA_IDENT_SATA_CAPABILITIES 152
+#define ATA_IDENT_COMMANDSETS 166
+#define ATA_IDENT_MAX_LBA_EXT 200
+
+#define ATA_SATA_CAP_NCQ (1 << 8)
+#define ATA_CMDSET_LBA48 (1 << 10)
+
+#define ATA_DEVICE_LBA 0x40
+#define ATA_DEVICE_FUA 0x80
+
+static constexpr size_t command_list_size = 32 * sizeof(AHCI::CommandHeader);
+static constexpr size_t command_table_stride = 512;
+static constexpr size_t descriptors_per_command = AHCIPort::max_sectors_per_command * 512 / PAGE_SIZE;
+static_assert(sizeof(AHCI::CommandTable<descriptors_per_command>) <= command_table_stride);
+static_assert(AHCIPort::max_outstanding_commands * command_table_stride <= PAGE_SIZE);
+
+template<typename Predicate>
+static bool wait_for(Predicate predicate, size_t milliseconds)
+{
+    for (size_t i = 0; i < milliseconds; ++i) {
+        if (predicate())
+            return true;
+        IO::delay(1000);
+    }
+    return predicate();
+}
+
+UNMAP_AFTER_INIT OwnPtr<AHCIPort> AHCIPort::create(const AHCIController& controller, volatile AHCI::PortRegisters& registers, u32 port_index, bool hba_supports_ncq)
+{
+    auto port = adopt_own(*new AHCIPort(controller, registers, port_index, hba_supports_ncq));
+    if (!port->initialize())
+        return {};
+    return port;
+}
+
+UNMAP_AFTER_INIT AHCIPort::AHCIPort(const AHCIController& controller, volatile AHCI::PortRegisters& registers, u32 port_index, bool hba_supports_ncq)
+    : m_parent_controller(controller)
+    , m_registers(registers)
+    , m_port_index(port_index)
+    , m_hba_supports_ncq(hba_supports_ncq)
+{
+}
+
+AHCIPort::~AHCIPort()
+{
+}
+
+volatile AHCI::CommandHeader& AHCIPort::command_header(size_t slot)
+{
+    VERIFY(slot < max_outstanding_commands);
+    return reinterpret_cast<volatile AHCI::CommandHeader*>(m_command_list_page->paddr().offset(0xc0000000).as_ptr())[slot];
+}
+
+volatile AHCI::CommandTable<descriptors_per_command>& AHCIPort::command_table(size_t slot)
+{
+    VERIFY(slot < max_outstanding_commands);
+    auto* base = m_command_table_page->paddr().offset(0xc0000000 + slot * command_table_stride).as_ptr();
+    return *reinterpret_cast<volatile AHCI::CommandTable<descriptors_per_command>*>(base);
+}
+
+UNMAP_AFTER_INIT bool AHCIPort::stop_command_engine()
+{
+    m_registers.cmd = m_registers.cmd & ~AHCI::Port::Command::Start;
+    if (!wait_for([&] { return !(m_registers.cmd & AHCI::Port::Command::CommandListRunning); }, 500))
+        return false;
+    m_registers.cmd = m_registers.cmd & ~AHCI::Port::Command::FISReceiveEnable;
+    return wait_for([&] { return !(m_registers.cmd & AHCI::Port::Command::FISReceiveRunning); }, 500);
+}
+
+bool AHCIPort::start_command_engine()
+{
+    m_registers.cmd = m_registers.cmd | AHCI::Port::Command::FISReceiveEnable;
+    if (!wait_for([&] { return !(m_registers.tfd & (AHCI::Port::TaskFileData::Busy | AHCI::Port::TaskFileData::DataRequest)); }, 1000))
+        return false;
+    m_registers.cmd = m_registers.cmd | AHCI::Port::Command::Start;
+    return true;
+}
+
+UNMAP_AFTER_INIT bool AHCIPort::initialize()
+{
+    u32 device_detection = m_registers.ssts & 0xf;
+    if (device_detection != AHCI::Port::device_present_and_phy_established) {
+        dbgln_if(AHCI_DEBUG, "AHCIPort {}: No device attached", m_port_index);
+        return false;
+    }
+    if (m_registers.sig != AHCI::Port::sata_drive_signature) {
+        dbgln("AHCIPort {}: Ignoring device with signature {:#08x}", m_port_index, (u32)m_registers.sig);
+        return false;
+    }
+
+    if (!stop_command_engine()) {
+        dbgln("AHCIPort {}: Timed out stopping the command engine", m_port_index);
+        return false;
+    }
+
+    m_command_list_page = MM.allocate_supervisor_physical_page();
+    m_command_table_page = MM.allocate_supervisor_physical_page();
+    if (!m_command_list_page || !m_command_table_page)
+        return false;
+
+    for (size_t slot = 0; slot < max_outstanding_commands; ++slot) {
+        auto& header = command_header(slot);
+        header.ctba = m_command_table_page->paddr().offset(slot * command_table_stride).get();
+        header.ctbau = 0;
+        m_slots[slot].dma_buffer = MM.allocate_kernel_region(max_sectors_per_command * 512, "AHCI DMA buffer", Region::Access::Read | Region::Access::Write, AllocationStrategy::AllocateNow);
+        if (!m_slots[slot].dma_buffer)
+            return false;
+    }
+
+    m_registers.clb = m_command_list_page->paddr().get();
+    m_registers.clbu = 0;
+    m_registers.fb = m_command_list_page->paddr().offset(command_list_size).get();
+    m_registers.fbu = 0;
+
+    // Clear any stale errors and interrupts before bringing the port up.
+    m_registers.serr = 0xffffffff;
+    m_registers.is = 0xffffffff;
+    m_registers.cmd = m_registers.cmd | AHCI::Port::Command::SpinUpDevice | AHCI::Port::Command::PowerOnDevice;
+
+    if (!start_command_engine()) {
+        dbgln("AHCIPort {}: Timed out waiting for the device to become ready", m_port_index);
+        return false;
+    }
+
+    if (!identify_device())
+        return false;
+
+    m_registers.ie = AHCI::Port::InterruptStatus::DeviceToHostRegisterFIS | AHCI::Port::InterruptStatus::SetDeviceBitsFIS | AHCI::Port::error_interrupts;
+    return true;
+}
+
+UNMAP_AFTER_INIT bool AHCIPort::identify_device()
+{
+    // Interrupts are not enabled yet, so we poll for the IDENTIFY command to complete.
+    prepare_command(0, ATA_CMD_IDENTIFY, 0, 0, false);
+    m_registers.ci = 1;
+    if (!wait_for([&] { return !(m_registers.ci & 1) || (m_registers.is & AHCI::Port::InterruptStatus::TaskFileError); }, 1000) || (m_registers.ci & 1)) {
+        dbgln("AHCIPort {}: IDENTIFY DEVICE failed", m_port_index);
+        return false;
+    }
+    m_registers.is = 0xffffffff;
+
+    auto* identify_data = m_slots[0].dma_buffer->vaddr().as_ptr();
+    auto identify_word = [&](size_t offset) { return *reinterpret_cast<const u16*>(identify_data + offset); };
+
+    if (!(identify_word(ATA_IDENT_COMMANDSETS) & ATA_CMDSET_LBA48)) {
+        dbgln("AHCIPort {}: Device doesn't support 48-bit LBA, ignoring it", m_port_index);
+        return false;
+    }
+    m_sector_count = *reinterpret_cast<const u64*>(identify_data + ATA_IDENT_MAX_LBA_EXT);
+
+    m_uses_ncq = m_hba_supports_ncq && (identify_word(ATA_IDENT_SATA_CAPABILITIES) & ATA_SATA_CAP_NCQ);
+    if (m_uses_ncq)
+        m_queue_depth = min((size_t)(identify_word(ATA_IDENT_QUEUE_DEPTH) & 0x1f) + 1, max_outstanding_commands);
+
+    // The model string is stored with each pair of characters swapped.
+    char model[41] {};
+    for (size_t i = 0; i < 40; i += 2) {
+        model[i] = identify_data[ATA_IDENT_MODEL + i + 1];
+        model[i + 1] = identify_data[ATA_IDENT_MODEL + i];
+    }
+    for (int i = 39; i >= 0 && model[i] == ' '; --i)
+        model[i] = 0;
+
+    dbgln("AHCIPort {}: SATA device found: Name={}, Sectors={}, NCQ={}, Queue depth={}", m_port_index, (const char*)model, m_sector_count, m_uses_ncq, m_queue_depth);
+    m_device = SATADiskDevice::create(m_parent_controller, *this, m_sector_count);
+    return true;
+}
+
+void AHCIPort::prepare_command(size_t slot, u8 command, u64 lba, u16 sector_count, bool write)
+{
+    auto& table = command_table(slot);
+    auto& fis = *reinterpret_cast<volatile AHCI::FIS::RegisterHostToDevice*>(table.command_fis);
+    fis.fis_type = AHCI::FIS::Type::RegisterHostToDevice;
+    fis.flags = 0x80;
+    fis.command = command;
+    fis.device = ATA_DEVICE_LBA;
+    fis.lba_low[0] = lba & 0xff;
+    fis.lba_low[1] = (lba >> 8) & 0xff;
+    fis.lba_low[2] = (lba >> 16) & 0xff;
+    fis.lba_high[0] = (lba >> 24) & 0xff;
+    fis.lba_high[1] = (lba >> 32) & 0xff;
+    fis.lba_high[2] = (lba >> 40) & 0xff;
+    fis.icc = 0;
+    fis.control = 0;
+    fis.reserved = 0;
+
+    if (command == ATA_CMD_READ_FPDMA_QUEUED || command == ATA_CMD_WRITE_FPDMA_QUEUED) {
+        // With NCQ, the sector count goes into the features registers and the count register holds the tag.
+        fis.features_low = sector_count & 0xff;
+        fis.features_high = sector_count >> 8;
+        fis.count_low = slot << 3;
+        fis.count_high = 0;
+        // Have writes go straight to the medium, like the PATA driver flushing the cache after each write.
+        if (write)
+            fis.device = ATA_DEVICE_LBA | ATA_DEVICE_FUA;
+    } else {
+        fis.features_low = 0;
+        fis.features_high = 0;
+        fis.count_low = sector_count & 0xff;
+        fis.count_high = sector_count >> 8;
+    }
+
+    size_t bytes = max((size_t)sector_count * 512, (size_t)512);
+    size_t descriptor_count = ceil_div(bytes, PAGE_SIZE);
+    VERIFY(descriptor_count <= descriptors_per_command);
+    for (size_t i = 0; i < descriptor_count; ++i) {
+        auto& descriptor = table.descriptors[i];
+        descriptor.base_low = m_slots[slot].dma_buffer->physical_page(i)->paddr().get();
+        descriptor.base_high = 0;
+        descriptor.reserved = 0;
+        descriptor.byte_count = min(bytes - i * PAGE_SIZE, (size_t)PAGE_SIZE) - 1;
+    }
+
+    auto& header = command_header(slot);
+    header.attributes = (sizeof(AHCI::FIS::RegisterHostToDevice) / sizeof(u32)) | (write ? AHCI::CommandHeaderAttributes::Write : 0);
+    header.prdtl = descriptor_count;
+    header.prdbc = 0;
+}
+
+void AHCIPort::issue_command(size_t slot)
+{
+    VERIFY(m_lock.is_locked());
+    u32 bit = 1u << slot;
+    m_issued_slots |= bit;
+    if (m_uses_ncq)
+        m_registers.sact = bit;
+    m_registers.ci = bit;
+}
+
+void AHCIPort::start_request(AsyncBlockDeviceRequest& request)
+{
+    ScopedSpinLock lock(m_lock);
+
+    // The device layer never has more requests in flight than our queue depth.
+    size_t slot = 0;
+    while (slot < m_queue_depth && (m_busy_slots & (1u << slot)))
+        ++slot;
+    VERIFY(slot < m_queue_depth);
+    VERIFY(request.block_count() <= max_sectors_per_command);
+
+    dbgln_if(AHCI_DEBUG, "AHCIPort {}: start_request in slot {} ({} x {})", m_port_index, slot, request.block_index(), request.block_count());
+
+    bool is_write = request.request_type() == AsyncBlockDeviceRequest::Write;
+    if (is_write) {
+        if (!request.read_from_buffer(request.buffer(), m_slots[slot].dma_buffer->vaddr().as_ptr(), 512 * request.block_count())) {
+            request.complete(AsyncDeviceRequest::MemoryFault);
+            return;
+        }
+    }
+
+    m_busy_slots |= 1u << slot;
+    m_slots[slot].request = &request;
+
+    u8 command;
+    if (m_uses_ncq)
+        command = is_write ? ATA_CMD_WRITE_FPDMA_QUEUED : ATA_CMD_READ_FPDMA_QUEUED;
+    else
+        command = is_write ? ATA_CMD_WRITE_DMA_EXT : ATA_CMD_READ_DMA_EXT;
+    prepare_command(slot, command, request.block_index(), request.block_count(), is_write);
+    issue_command(slot);
+}
+
+void AHCIPort::complete_slot(size_t slot, AsyncDeviceRequest::RequestResult result)
+{
+    // NOTE: This is called from the interrupt handler!
+    VERIFY(m_lock.is_locked());
+    VERIFY(m_busy_slots & (1u << slot));
+
+    // Copy the data out in a work queue, since writing to the request's buffer
+    // may cause page faults.
+    WorkQueue::queue([this, slot, result]() {
+        AsyncBlockDeviceRequest* request;
+        auto final_result = result;
+        {
+            ScopedSpinLock lock(m_lock);
+            request = m_slots[slot].request;
+            VERIFY(request);
+            if (final_result == AsyncDeviceRequest::Success && request->request_type() == AsyncBlockDeviceRequest::Read) {
+                if (!request->write_to_buffer(request->buffer(), m_slots[slot].dma_buffer->vaddr().as_ptr(), 512 * request->block_count()))
+                    final_result = AsyncDeviceRequest::MemoryFault;
+            }
+            m_slots[slot].request = nullptr;
+            m_busy_slots &= ~(1u << slot);
+        }
+        dbgln_if(AHCI_DEBUG, "AHCIPort {}: Slot {} completed with result {}", m_port_index, slot, (int)final_result);
+        request->complete(final_result);
+    });
+}
+
+void AHCIPort::fail_all_issued_commands()
+{
+    for (size_t slot = 0; slot < max_outstanding_commands; ++slot) {
+        if (m_issued_slots & (1u << slot))
+            complete_slot(slot, AsyncDeviceRequest::Failure);
+    }
+    m_issued_slots = 0;
+}
+
+void AHCIPort::handle_interrupt()
+{
+    ScopedSpinLock lock(m_lock);
+    u32 status = m_registers.is;
+    m_registers.is = status;
+
+    if (status & AHCI::Port::error_interrupts) {
+        dbgln("AHCIPort {}: Error interrupt {:#08x}, task file {:#08x}, SError {:#08x}", m_port_index, status, (u32)m_registers.tfd, (u32)m_registers.serr);
+        // FIXME: With NCQ, we could read the NCQ error log to find out which command failed
+        //        and retry the others, but for now we just fail everything in flight.
+        fail_all_issued_commands();
+        // Restarting the command engine clears the command issue and active registers.
+        m_registers.cmd = m_registers.cmd & ~AHCI::Port::Command::Start;
+        wait_for([&] { return !(m_registers.cmd & AHCI::Port::Command::CommandListRunning); }, 500);
+        m_registers.serr = 0xffffffff;
+        m_registers.is = 0xffffffff;
+        start_command_engine();
+        return;
+    }
+
+    u32 still_active = m_uses_ncq ? (m_registers.sact | m_registers.ci) : m_registers.ci;
+    u32 completed = m_issued_slots & ~still_active;
+    for (size_t slot = 0; completed; ++slot) {
+        if (!(completed & (1u << slot)))
+            continue;
+        completed &= ~(1u << slot);
+        m_issued_slots &= ~(1u << slot);
+        complete_slot(slot, AsyncDeviceRequest::Success);
+    }
+}
+
+}
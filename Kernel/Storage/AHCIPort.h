@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Array.h>
+#include <AK/OwnPtr.h>
+#include <AK/RefPtr.h>
+#include <Kernel/Devices/AsyncDeviceRequest.h>
+#include <Kernel/SpinLock.h>
+#include <Kernel/Storage/AHCI.h>
+#include <Kernel/VM/PhysicalPage.h>
+#include <Kernel/VM/Region.h>
+
+namespace Kernel {
+
+class AHCIController;
+class AsyncBlockDeviceRequest;
+class StorageDevice;
+
+class AHCIPort {
+    AK_MAKE_ETERNAL
+public:
+    // Number of command slots we use per port. Each slot has its own command table and
+    // DMA buffer, so with native command queuing this many commands can be in flight.
+    static constexpr size_t max_outstanding_commands = 8;
+    static constexpr size_t max_sectors_per_command = 128;
+
+    static OwnPtr<AHCIPort> create(const AHCIController&, volatile AHCI::PortRegisters&, u32 port_index, bool hba_supports_ncq);
+    ~AHCIPort();
+
+    RefPtr<StorageDevice> device() const { return m_device; }
+    u32 port_index() const { return m_port_index; }
+
+    bool uses_native_command_queuing() const { return m_uses_ncq; }
+    size_t queue_depth() const { return m_queue_depth; }
+
+    void start_request(AsyncBlockDeviceRequest&);
+
+    // Called by the controller's IRQ handler when this port has pending interrupts.
+    void handle_interrupt();
+
+private:
+    AHCIPort(const AHCIController&, volatile AHCI::PortRegisters&, u32 port_index, bool hba_supports_ncq);
+
+    bool initialize();
+    bool identify_device();
+    bool stop_command_engine();
+    bool start_command_engine();
+
+    void prepare_command(size_t slot, u8 command, u64 lba, u16 sector_count, bool write);
+    void issue_command(size_t slot);
+    void complete_slot(size_t slot, AsyncDeviceRequest::RequestResult);
+    void fail_all_issued_commands();
+
+    volatile AHCI::CommandHeader& command_header(size_t slot);
+    volatile AHCI::CommandTable<max_sectors_per_command * 512 / PAGE_SIZE>& command_table(size_t slot);
+
+    struct Slot {
+        AsyncBlockDeviceRequest* request { nullptr };
+        OwnPtr<Region> dma_buffer;
+    };
+
+    NonnullRefPtr<AHCIController> m_parent_controller;
+    volatile AHCI::PortRegisters& m_registers;
+    u32 m_port_index { 0 };
+    bool m_hba_supports_ncq { false };
+    bool m_uses_ncq { false };
+    size_t m_queue_depth { 1 };
+    u64 m_sector_count { 0 };
+
+    // Holds the command list in the first 1 KiB, followed by the received FIS area.
+    RefPtr<PhysicalPage> m_command_list_page;
+    RefPtr<PhysicalPage> m_command_table_page;
+    Array<Slot, max_outstanding_commands> m_slots;
+
+    // Slots that have a request assigned to them, and the subset of those the HBA is working on.
+    u32 m_busy_slots { 0 };
+    u32 m_issued_slots { 0 };
+    SpinLock<u8> m_lock;
+
+    RefPtr<StorageDevice> m_device;
+};
+
+}
@@ -34,6 +34,7 @@
 #include <Kernel/Storage/IDEController.h>
 #include <Kernel/Storage/PATADiskDevice.h>
 #include <Kernel/VM/MemoryManager.h>
+#include <Kernel/WorkQueue.h>
 
 namespace Kernel {
 
@@ -187,11 +188,11 @@ void IDEChannel::complete_current_request(AsyncDeviceRequest::RequestResult resu
     VERIFY(m_current_request);
     VERIFY(m_request_lock.is_locked());
 
-    // Now schedule reading back the buffer as soon as we leave the irq handler.
+    // Now schedule reading back the buffer in a work queue.
     // This is important so that we can safely write the buffer back,
     // which could cause page faults. Note that this may be called immediately
-    // before Processor::deferred_call_queue returns!
-    Processor::deferred_call_queue([this, result]() {
+    // before WorkQueue::queue returns!
+    WorkQueue::queue([this, result]() {
         dbgln_if(PATA_DEBUG, "IDEChannel::complete_current_request result: {}", (int)result);
         VERIFY(m_current_request);
         auto& request = *m_current_request;
@@ -200,7 +201,7 @@ void IDEChannel::complete_current_request(AsyncDeviceRequest::RequestResult resu
         if (m_current_request_uses_dma) {
             if (result == AsyncDeviceRequest::Success) {
                 if (request.request_type() == AsyncBlockDeviceRequest::Read) {
-                    if (!request.write_to_buffer(request.buffer(), m_dma_buffer_page->paddr().offset(0xc0000000).as_ptr(), 512 * request.block_count())) {
+                    if (!request.write_to_buffer(request.buffer(), dma_buffer(), 512 * request.block_count())) {
                         request.complete(AsyncDeviceRequest::MemoryFault);
                         return;
                     }
@@ -232,7 +233,8 @@ UNMAP_AFTER_INIT void IDEChannel::initialize(bool force_pio)
     PCI::enable_bus_mastering(m_parent_controller->pci_address());
     m_prdt_page = MM.allocate_supervisor_physical_page();
     prdt().end_of_table = 0x8000;
-    m_dma_buffer_page = MM.allocate_supervisor_physical_page();
+    // The buffer must not cross a 64 KiB boundary, so align it to its size.
+    m_dma_buffer_pages = MM.allocate_contiguous_supervisor_physical_pages(dma_buffer_size, dma_buffer_size);
 }
 
 static void print_ide_status(u8 status)
@@ -314,10 +316,10 @@ void IDEChannel::handle_irq(const RegisterState&)
         return;
     }
 
-    // Now schedule reading/writing the buffer as soon as we leave the irq handler.
+    // Now schedule reading/writing the buffer in a work queue.
     // This is important so that we can safely access the buffers, which could
     // trigger page faults
-    Processor::deferred_call_queue([this]() {
+    WorkQueue::queue([this]() {
         ScopedSpinLock lock(m_request_lock);
         if (m_current_request->request_type() == AsyncBlockDeviceRequest::Read) {
             dbgln_if(PATA_DEBUG, "IDEChannel: Read block {}/{}", m_current_request_block_index, m_current_request->block_count());
@@ -529,10 +531,10 @@ void IDEChannel::ata_read_sectors_with_dma(bool slave_request, u16 capabilities)
     u32 lba = request.block_index();
     dbgln_if(PATA_DEBUG, "IDEChannel::ata_read_sectors_with_dma ({} x {})", lba, request.block_count());
 
-    prdt().offset = m_dma_buffer_page->paddr();
-    prdt().size = 512 * request.block_count();
-
-    VERIFY(prdt().size <= PAGE_SIZE);
+    VERIFY(request.block_count() <= max_sectors_per_request);
+    prdt().offset = m_dma_buffer_pages.first().paddr();
+    // NOTE: A size of 0 means 64 KiB.
+    prdt().size = (512 * request.block_count()) & 0xffff;
 
     // Stop bus master
     m_io_group.bus_master_base().out<u8>(0);
@@ -589,16 +591,16 @@ void IDEChannel::ata_write_sectors_with_dma(bool slave_request, u16 capabilities
     u32 lba = request.block_index();
     dbgln_if(PATA_DEBUG, "IDEChannel::ata_write_sectors_with_dma ({} x {})", lba, request.block_count());
 
-    prdt().offset = m_dma_buffer_page->paddr();
-    prdt().size = 512 * request.block_count();
+    VERIFY(request.block_count() <= max_sectors_per_request);
+    prdt().offset = m_dma_buffer_pages.first().paddr();
+    // NOTE: A size of 0 means 64 KiB.
+    prdt().size = (512 * request.block_count()) & 0xffff;
 
-    if (!request.read_from_buffer(request.buffer(), m_dma_buffer_page->paddr().offset(0xc0000000).as_ptr(), 512 * request.block_count())) {
+    if (!request.read_from_buffer(request.buffer(), dma_buffer(), 512 * request.block_count())) {
         complete_current_request(AsyncDeviceRequest::MemoryFault);
         return;
     }
 
-    VERIFY(prdt().size <= PAGE_SIZE);
-
     // Stop bus master
     m_io_group.bus_master_base().out<u8>(0);
 
@@ -113,6 +113,10 @@ public:
 
     virtual const char* purpose() const override { return "PATA Channel"; }
 
+    // A single PRD entry can describe up to 64 KiB, which is what we use as our DMA buffer.
+    static constexpr size_t dma_buffer_size = 64 * KiB;
+    static constexpr size_t max_sectors_per_request = dma_buffer_size / 512;
+
 private:
     //^ IRQHandler
     virtual void handle_irq(const RegisterState&) override;
@@ -155,7 +159,8 @@ private:
 
     PhysicalRegionDescriptor& prdt() { return *reinterpret_cast<PhysicalRegionDescriptor*>(m_prdt_page->paddr().offset(0xc0000000).as_ptr()); }
     RefPtr<PhysicalPage> m_prdt_page;
-    RefPtr<PhysicalPage> m_dma_buffer_page;
+    NonnullRefPtrVector<PhysicalPage> m_dma_buffer_pages;
+    u8* dma_buffer() { return m_dma_buffer_pages.first().paddr().offset(0xc0000000).as_ptr(); }
     Lockable<bool> m_dma_enabled;
     EntropySource m_entropy_source;
 
@@ -75,6 +75,11 @@ size_t PATADiskDevice::max_addressable_block() const
     return m_cylinders * m_heads * m_sectors_per_track;
 }
 
+size_t PATADiskDevice::max_blocks_per_request() const
+{
+    return IDEChannel::max_sectors_per_request;
+}
+
 bool PATADiskDevice::is_slave() const
 {
     return m_drive_type == DriveType::Slave;
@@ -63,6 +63,7 @@ public:
     // ^StorageDevice
     virtual Type type() const override { return StorageDevice::Type::IDE; }
     virtual size_t max_addressable_block() const override;
+    virtual size_t max_blocks_per_request() const override;
 
     // ^BlockDevice
     virtual void start_request(AsyncBlockDeviceRequest&) override;
@@ -51,6 +51,7 @@ public:
     // ^DiskDevice
     virtual const char* class_name() const override;
     virtual String device_name() const override;
+    virtual size_t max_blocks_per_request() const override { return 256; }
 
     bool is_slave() const;
 
@@ -48,7 +48,9 @@ public:
     enum class Type : u8 {
         Ramdisk,
         IDE,
-        NVMe
+        AHCI,
+        NVMe,
+        VirtIO
     };
 
     virtual ~StorageController() = default;
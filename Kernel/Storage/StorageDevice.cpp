@@ -52,24 +52,17 @@ NonnullRefPtr<StorageController> StorageDevice::controller() const
 KResultOr<size_t> StorageDevice::read(FileDescription&, size_t offset, UserOrKernelBuffer& outbuf, size_t len)
 {
     unsigned index = offset / block_size();
-    u16 whole_blocks = len / block_size();
+    size_t whole_blocks = len / block_size();
     ssize_t remaining = len % block_size();
 
-    unsigned blocks_per_page = PAGE_SIZE / block_size();
-
-    // PATAChannel will chuck a wobbly if we try to read more than PAGE_SIZE
-    // at a time, because it uses a single page for its DMA buffer.
-    if (whole_blocks >= blocks_per_page) {
-        whole_blocks = blocks_per_page;
-        remaining = 0;
-    }
-
 #if STORAGE_DEVICE_DEBUG
     klog() << "StorageDevice::read() index=" << index << " whole_blocks=" << whole_blocks << " remaining=" << remaining;
 #endif
 
-    if (whole_blocks > 0) {
-        auto read_request = make_request<AsyncBlockDeviceRequest>(AsyncBlockDeviceRequest::Read, index, whole_blocks, outbuf, whole_blocks * block_size());
+    // Split the read into the largest requests the device can handle.
+    for (size_t blocks_read = 0; blocks_read < whole_blocks;) {
+        size_t block_count = min(whole_blocks - blocks_read, max_blocks_per_request());
+        auto read_request = make_request<AsyncBlockDeviceRequest>(AsyncBlockDeviceRequest::Read, index + blocks_read, block_count, outbuf.offset(blocks_read * block_size()), block_count * block_size());
         auto result = read_request->wait();
         if (result.wait_result().was_interrupted())
             return EINTR;
@@ -82,6 +75,7 @@ KResultOr<size_t> StorageDevice::read(FileDescription&, size_t offset, UserOrKer
         default:
             break;
         }
+        blocks_read += block_count;
     }
 
     off_t pos = whole_blocks * block_size();
@@ -119,24 +113,17 @@ bool StorageDevice::can_read(const FileDescription&, size_t offset) const
 KResultOr<size_t> StorageDevice::write(FileDescription&, size_t offset, const UserOrKernelBuffer& inbuf, size_t len)
 {
     unsigned index = offset / block_size();
-    u16 whole_blocks = len / block_size();
+    size_t whole_blocks = len / block_size();
     ssize_t remaining = len % block_size();
 
-    unsigned blocks_per_page = PAGE_SIZE / block_size();
-
-    // PATAChannel will chuck a wobbly if we try to write more than PAGE_SIZE
-    // at a time, because it uses a single page for its DMA buffer.
-    if (whole_blocks >= blocks_per_page) {
-        whole_blocks = blocks_per_page;
-        remaining = 0;
-    }
-
 #if STORAGE_DEVICE_DEBUG
     klog() << "StorageDevice::write() index=" << index << " whole_blocks=" << whole_blocks << " remaining=" << remaining;
 #endif
 
-    if (whole_blocks > 0) {
-        auto write_request = make_request<AsyncBlockDeviceRequest>(AsyncBlockDeviceRequest::Write, index, whole_blocks, inbuf, whole_blocks * block_size());
+    // Split the write into the largest requests the device can handle.
+    for (size_t blocks_written = 0; blocks_written < whole_blocks;) {
+        size_t block_count = min(whole_blocks - blocks_written, max_blocks_per_request());
+        auto write_request = make_request<AsyncBlockDeviceRequest>(AsyncBlockDeviceRequest::Write, index + blocks_written, block_count, inbuf.offset(blocks_written * block_size()), block_count * block_size());
         auto result = write_request->wait();
         if (result.wait_result().was_interrupted())
             return EINTR;
@@ -149,6 +136,7 @@ KResultOr<size_t> StorageDevice::write(FileDescription&, size_t offset, const Us
         default:
             break;
         }
+        blocks_written += block_count;
     }
 
     off_t pos = whole_blocks * block_size();
@@ -41,12 +41,16 @@ public:
     enum class Type : u8 {
         Ramdisk,
         IDE,
+        AHCI,
         NVMe,
+        VirtIO,
     };
 
 public:
     virtual Type type() const = 0;
     virtual size_t max_addressable_block() const { return m_max_addressable_block; }
+    // The largest number of blocks read() and write() will put into a single request.
+    virtual size_t max_blocks_per_request() const { return PAGE_SIZE / block_size(); }
 
     NonnullRefPtr<StorageController> controller() const;
 
@@ -30,12 +30,15 @@
 #include <Kernel/FileSystem/Ext2FileSystem.h>
 #include <Kernel/PCI/Access.h>
 #include <Kernel/Panic.h>
+#include <Kernel/Storage/AHCIController.h>
 #include <Kernel/Storage/IDEController.h>
 #include <Kernel/Storage/Partition/EBRPartitionTable.h>
 #include <Kernel/Storage/Partition/GUIDPartitionTable.h>
 #include <Kernel/Storage/Partition/MBRPartitionTable.h>
 #include <Kernel/Storage/RamdiskController.h>
 #include <Kernel/Storage/StorageManagement.h>
+#include <Kernel/Storage/VirtIOBlockController.h>
+#include <Kernel/VirtIO/VirtIO.h>
 
 namespace Kernel {
 
@@ -69,6 +72,22 @@ NonnullRefPtrVector<StorageController> StorageManagement::enumerate_controllers(
             }
         });
     }
+    if (!kernel_command_line().contains("disable_ahci")) {
+        PCI::enumerate([&](const PCI::Address& address, PCI::ID) {
+            // Mass storage controller, SATA, AHCI 1.0 programming interface.
+            if (PCI::get_class(address) == 0x1 && PCI::get_subclass(address) == 0x6 && PCI::get_programming_interface(address) == 0x1) {
+                controllers.append(AHCIController::initialize(address));
+            }
+        });
+    }
+    if (!kernel_command_line().contains("disable_virtio")) {
+        PCI::enumerate([&](const PCI::Address& address, PCI::ID id) {
+            if (id.vendor_id == VirtIO::pci_vendor_id && id.device_id == VirtIO::PCIDeviceID::Block) {
+                if (auto controller = VirtIOBlockController::initialize(address))
+                    controllers.append(controller.release_nonnull());
+            }
+        });
+    }
     controllers.append(RamdiskController::initialize());
     return controllers;
 }
@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Array.h>
+#include <Kernel/Debug.h>
+#include <Kernel/Storage/VirtIOBlockController.h>
+#include <Kernel/Storage/VirtIOBlockDevice.h>
+#include <Kernel/VM/MemoryManager.h>
+#include <Kernel/WorkQueue.h>
+
+namespace Kernel {
+
+namespace VirtIOBlock {
+
+namespace Feature {
+enum : u32 {
+    SegmentCountMax = 1 << 2,
+    ReadOnly = 1 << 5,
+};
+}
+
+namespace ConfigurationOffset {
+enum : u16 {
+    Capacity = 0,
+    SegmentCountMax = 12,
+};
+}
+
+namespace RequestType {
+enum : u32 {
+    In = 0,
+    Out = 1,
+};
+}
+
+static constexpr u8 status_ok = 0;
+
+}
+
+UNMAP_AFTER_INIT RefPtr<VirtIOBlockController> VirtIOBlockController::initialize(PCI::Address address)
+{
+    auto controller = adopt(*new VirtIOBlockController(address));
+    if (!controller->initialize())
+        return {};
+    return controller;
+}
+
+UNMAP_AFTER_INIT VirtIOBlockController::VirtIOBlockController(PCI::Address address)
+    : StorageController()
+    , VirtIODevice(address, "VirtIO Block")
+{
+}
+
+UNMAP_AFTER_INIT VirtIOBlockController::~VirtIOBlockController()
+{
+}
+
+UNMAP_AFTER_INIT bool VirtIOBlockController::initialize()
+{
+    begin_initialization(VirtIOBlock::Feature::SegmentCountMax | VirtIOBlock::Feature::ReadOnly);
+    if (!setup_queue(0)) {
+        fail_initialization();
+        return false;
+    }
+
+    // Each request takes a descriptor for its header, one per page of data and one for the status byte.
+    size_t data_segments = max_sectors_per_request * 512 / PAGE_SIZE;
+    if (is_feature_accepted(VirtIOBlock::Feature::SegmentCountMax)) {
+        u32 segment_count_max = config_read<u32>(VirtIOBlock::ConfigurationOffset::SegmentCountMax);
+        if (segment_count_max != 0)
+            data_segments = min(data_segments, (size_t)segment_count_max);
+    }
+    m_sectors_per_request = data_segments * PAGE_SIZE / 512;
+    m_queue_depth = min(max_outstanding_requests, queue(0).size() / (data_segments + 2));
+    if (m_queue_depth == 0) {
+        dbgln("VirtIOBlockController: Queue with {} entries is too small", queue(0).size());
+        fail_initialization();
+        return false;
+    }
+    m_read_only = is_feature_accepted(VirtIOBlock::Feature::ReadOnly);
+
+    m_slot_control_region = MM.allocate_contiguous_kernel_region(PAGE_SIZE, "VirtIO Block Requests", Region::Access::Read | Region::Access::Write);
+    if (!m_slot_control_region) {
+        fail_initialization();
+        return false;
+    }
+    for (size_t slot = 0; slot < m_queue_depth; ++slot) {
+        m_slots[slot].dma_buffer = MM.allocate_kernel_region(m_sectors_per_request * 512, "VirtIO Block DMA", Region::Access::Read | Region::Access::Write, AllocationStrategy::AllocateNow);
+        if (!m_slots[slot].dma_buffer) {
+            fail_initialization();
+            return false;
+        }
+    }
+
+    // The capacity is always given in 512-byte sectors, and legacy devices only allow 32-bit accesses to it.
+    u64 capacity = config_read<u32>(VirtIOBlock::ConfigurationOffset::Capacity) | ((u64)config_read<u32>(VirtIOBlock::ConfigurationOffset::Capacity + 4) << 32);
+    dbgln("VirtIOBlockController: {} with {} sectors, {} requests of up to {} sectors in flight{}", pci_address(), capacity, m_queue_depth, m_sectors_per_request, m_read_only ? ", read-only" : "");
+
+    m_device = VirtIOBlockDevice::create(*this, capacity);
+    finish_initialization();
+    return true;
+}
+
+bool VirtIOBlockController::reset()
+{
+    TODO();
+}
+
+bool VirtIOBlockController::shutdown()
+{
+    TODO();
+}
+
+void VirtIOBlockController::complete_current_request(AsyncDeviceRequest::RequestResult)
+{
+    VERIFY_NOT_REACHED();
+}
+
+RefPtr<StorageDevice> VirtIOBlockController::device(u32 index) const
+{
+    if (index != 0)
+        return nullptr;
+    return m_device;
+}
+
+void VirtIOBlockController::start_request(const StorageDevice&, AsyncBlockDeviceRequest& request)
+{
+    bool is_write = request.request_type() == AsyncBlockDeviceRequest::Write;
+    if (is_write && m_read_only) {
+        request.complete(AsyncDeviceRequest::Failure);
+        return;
+    }
+
+    ScopedSpinLock lock(m_lock);
+
+    // The device layer never has more requests in flight than our queue depth.
+    size_t slot = 0;
+    while (slot < m_queue_depth && (m_busy_slots & (1u << slot)))
+        ++slot;
+    VERIFY(slot < m_queue_depth);
+    VERIFY(request.block_count() <= m_sectors_per_request);
+
+    dbgln_if(VIRTIO_DEBUG, "VirtIOBlockController: start_request in slot {} ({} x {})", slot, request.block_index(), request.block_count());
+
+    auto& dma_buffer = *m_slots[slot].dma_buffer;
+    size_t data_size = 512 * request.block_count();
+    if (is_write) {
+        if (!request.read_from_buffer(request.buffer(), dma_buffer.vaddr().as_ptr(), data_size)) {
+            request.complete(AsyncDeviceRequest::MemoryFault);
+            return;
+        }
+    }
+
+    auto& control = slot_control(slot);
+    control.header.type = is_write ? VirtIOBlock::RequestType::Out : VirtIOBlock::RequestType::In;
+    control.header.reserved = 0;
+    control.header.sector = request.block_index();
+    control.status = 0xff;
+
+    Array<VirtIOQueue::BufferSegment, max_sectors_per_request * 512 / PAGE_SIZE + 2> segments;
+    size_t segment_count = 0;
+    segments[segment_count++] = { slot_control_physical_address(slot), sizeof(RequestHeader), false };
+    for (size_t offset = 0; offset < data_size; offset += PAGE_SIZE)
+        segments[segment_count++] = { dma_buffer.physical_page(offset / PAGE_SIZE)->paddr(), (u32)min(data_size - offset, (size_t)PAGE_SIZE), !is_write };
+    segments[segment_count++] = { slot_control_physical_address(slot).offset(sizeof(RequestHeader)), 1, true };
+
+    m_busy_slots |= 1u << slot;
+    m_slots[slot].request = &request;
+    bool supplied = queue(0).supply_buffer(segments.span().trim(segment_count), reinterpret_cast<void*>(slot));
+    // The queue depth was chosen so that every slot fits into the queue at the same time.
+    VERIFY(supplied);
+    notify_queue(0);
+}
+
+void VirtIOBlockController::complete_slot(size_t slot, AsyncDeviceRequest::RequestResult result)
+{
+    // NOTE: This is called from the interrupt handler!
+    VERIFY(m_lock.is_locked());
+    VERIFY(m_busy_slots & (1u << slot));
+
+    // Copy the data out in a work queue, since writing to the request's buffer
+    // may cause page faults.
+    WorkQueue::queue([this, slot, result]() {
+        AsyncBlockDeviceRequest* request;
+        auto final_result = result;
+        {
+            ScopedSpinLock lock(m_lock);
+            request = m_slots[slot].request;
+            VERIFY(request);
+            if (final_result == AsyncDeviceRequest::Success && request->request_type() == AsyncBlockDeviceRequest::Read) {
+                if (!request->write_to_buffer(request->buffer(), m_slots[slot].dma_buffer->vaddr().as_ptr(), 512 * request->block_count()))
+                    final_result = AsyncDeviceRequest::MemoryFault;
+            }
+            m_slots[slot].request = nullptr;
+            m_busy_slots &= ~(1u << slot);
+        }
+        dbgln_if(VIRTIO_DEBUG, "VirtIOBlockController: Slot {} completed with result {}", slot, (int)final_result);
+        request->complete(final_result);
+    });
+}
+
+void VirtIOBlockController::handle_queue_update(u16 queue_index)
+{
+    VERIFY(queue_index == 0);
+    ScopedSpinLock lock(m_lock);
+    void* token;
+    u32 written_length;
+    while (queue(0).get_used_buffer(token, written_length)) {
+        size_t slot = reinterpret_cast<FlatPtr>(token);
+        VERIFY(slot < m_queue_depth);
+        u8 status = slot_control(slot).status;
+        if (status != VirtIOBlock::status_ok)
+            dbgln("VirtIOBlockController: Request in slot {} failed with status {}", slot, status);
+        complete_slot(slot, status == VirtIOBlock::status_ok ? AsyncDeviceRequest::Success : AsyncDeviceRequest::Failure);
+    }
+}
+
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Array.h>
+#include <AK/OwnPtr.h>
+#include <AK/RefPtr.h>
+#include <Kernel/SpinLock.h>
+#include <Kernel/Storage/StorageController.h>
+#include <Kernel/Storage/StorageDevice.h>
+#include <Kernel/VirtIO/VirtIO.h>
+
+namespace Kernel {
+
+class AsyncBlockDeviceRequest;
+class VirtIOBlockDevice;
+
+class VirtIOBlockController final : public StorageController
+    , public VirtIODevice {
+    AK_MAKE_ETERNAL
+public:
+    // Each request has its own DMA buffer, which is handed to the device as one
+    // descriptor per page, so requests need not be physically contiguous.
+    static constexpr size_t max_outstanding_requests = 8;
+    static constexpr size_t max_sectors_per_request = 128;
+
+    static RefPtr<VirtIOBlockController> initialize(PCI::Address address);
+    virtual ~VirtIOBlockController() override;
+
+    // ^StorageController
+    virtual Type type() const override { return Type::VirtIO; }
+    virtual RefPtr<StorageDevice> device(u32 index) const override;
+    virtual size_t devices_count() const override { return m_device ? 1 : 0; }
+    virtual void start_request(const StorageDevice&, AsyncBlockDeviceRequest&) override;
+
+    size_t queue_depth() const { return m_queue_depth; }
+    size_t sectors_per_request() const { return m_sectors_per_request; }
+
+private:
+    explicit VirtIOBlockController(PCI::Address address);
+
+    bool initialize();
+    void complete_slot(size_t slot, AsyncDeviceRequest::RequestResult);
+
+    // ^StorageController
+    virtual bool reset() override;
+    virtual bool shutdown() override;
+    virtual void complete_current_request(AsyncDeviceRequest::RequestResult) override;
+
+    // ^VirtIODevice
+    virtual void handle_queue_update(u16 queue_index) override;
+
+    struct [[gnu::packed]] RequestHeader {
+        u32 type;
+        u32 reserved;
+        u64 sector;
+    };
+
+    // The request header and the status byte the device writes back, one per slot.
+    struct SlotControl {
+        RequestHeader header;
+        u8 status;
+        u8 padding[15];
+    };
+    static_assert(sizeof(SlotControl) * max_outstanding_requests <= PAGE_SIZE);
+    static_assert(sizeof(RequestHeader) == 16);
+
+    struct Slot {
+        AsyncBlockDeviceRequest* request { nullptr };
+        OwnPtr<Region> dma_buffer;
+    };
+
+    volatile SlotControl& slot_control(size_t slot) { return reinterpret_cast<volatile SlotControl*>(m_slot_control_region->vaddr().as_ptr())[slot]; }
+    PhysicalAddress slot_control_physical_address(size_t slot) const { return m_slot_control_region->physical_page(0)->paddr().offset(slot * sizeof(SlotControl)); }
+
+    RefPtr<VirtIOBlockDevice> m_device;
+    bool m_read_only { false };
+    size_t m_queue_depth { 1 };
+    size_t m_sectors_per_request { max_sectors_per_request };
+
+    SpinLock<u8> m_lock;
+    OwnPtr<Region> m_slot_control_region;
+    Array<Slot, max_outstanding_requests> m_slots;
+    u32 m_busy_slots { 0 };
+};
+
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/NumericLimits.h>
+#include <AK/StringView.h>
+#include <Kernel/Storage/VirtIOBlockController.h>
+#include <Kernel/Storage/VirtIOBlockDevice.h>
+
+namespace Kernel {
+
+static int s_next_minor = 0;
+
+UNMAP_AFTER_INIT NonnullRefPtr<VirtIOBlockDevice> VirtIOBlockDevice::create(VirtIOBlockController& controller, u64 sector_count)
+{
+    return adopt(*new VirtIOBlockDevice(controller, sector_count, s_next_minor++));
+}
+
+UNMAP_AFTER_INIT VirtIOBlockDevice::VirtIOBlockDevice(VirtIOBlockController& controller, u64 sector_count, int minor)
+    : StorageDevice(controller, 254, minor, 512, min(sector_count, (u64)NumericLimits<size_t>::max() / 512))
+    , m_controller(controller)
+{
+}
+
+UNMAP_AFTER_INIT VirtIOBlockDevice::~VirtIOBlockDevice()
+{
+}
+
+const char* VirtIOBlockDevice::class_name() const
+{
+    return "VirtIOBlockDevice";
+}
+
+void VirtIOBlockDevice::start_request(AsyncBlockDeviceRequest& request)
+{
+    m_controller.start_request(*this, request);
+}
+
+String VirtIOBlockDevice::device_name() const
+{
+    return String::formatted("vd{:c}", 'a' + minor());
+}
+
+size_t VirtIOBlockDevice::max_blocks_per_request() const
+{
+    return m_controller.sectors_per_request();
+}
+
+size_t VirtIOBlockDevice::max_concurrent_requests() const
+{
+    return m_controller.queue_depth();
+}
+
+}
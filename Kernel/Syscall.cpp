@@ -30,12 +30,14 @@
 #include <Kernel/Process.h>
 #include <Kernel/Random.h>
 #include <Kernel/ThreadTracer.h>
+#include <Kernel/Tracepoint.h>
 #include <Kernel/VM/MemoryManager.h>
 
 namespace Kernel {
 
 extern "C" void syscall_handler(TrapFrame*);
 extern "C" void syscall_asm_entry();
+extern "C" void sysenter_asm_entry();
 
 // clang-format off
 asm(
@@ -65,6 +67,76 @@ asm(
     "    call syscall_handler \n"
     "    movl %ebx, 0(%esp) \n" // push pointer to TrapFrame
     "    jmp common_trap_exit \n");
+
+// SYSENTER enters here with CS/SS loaded from IA32_SYSENTER_CS, ESP pointing at the top of
+// the current thread's kernel stack (IA32_SYSENTER_ESP is updated on every context switch)
+// and interrupts disabled. Userspace passes its return address in %esi and its stack pointer
+// in %edi, which we use to build the same frame that an `int 0x82` would have pushed.
+asm(
+    ".globl sysenter_asm_entry\n"
+    "sysenter_asm_entry:\n"
+    "    pushl $" __STRINGIFY(GDT_SELECTOR_DATA3 | 3) "\n" // userspace_ss
+    "    pushl %edi\n" // userspace_esp
+    "    pushfl\n" // eflags
+    "    pushl $0x2\n"
+    "    popfl\n" // clear TF, DF, NT and AC now that the userspace flags are saved
+    "    orl $0x200, (%esp)\n" // SYSENTER cleared IF, but it is always set in userspace
+    "    pushl $" __STRINGIFY(GDT_SELECTOR_CODE3 | 3) "\n" // cs
+    "    pushl %esi\n" // eip
+    "    pushw $" __STRINGIFY(SYSENTER_ISR_NUMBER) "\n"
+    "    pushw $0x0\n"
+    "    pusha\n"
+    "    pushl %ds\n"
+    "    pushl %es\n"
+    "    pushl %fs\n"
+    "    pushl %gs\n"
+    "    pushl %ss\n"
+    "    mov $" __STRINGIFY(GDT_SELECTOR_DATA0) ", %ax\n"
+    "    mov %ax, %ds\n"
+    "    mov %ax, %es\n"
+    "    mov $" __STRINGIFY(GDT_SELECTOR_PROC) ", %ax\n"
+    "    mov %ax, %fs\n"
+    "    cld\n"
+    "    sti\n"
+    "    xor %esi, %esi\n"
+    "    xor %edi, %edi\n"
+    "    pushl %esp \n" // set TrapFrame::regs
+    "    subl $" __STRINGIFY(TRAP_FRAME_SIZE - 4) ", %esp \n"
+    "    movl %esp, %ebx \n"
+    "    pushl %ebx \n" // push pointer to TrapFrame
+    "    call enter_trap_no_irq \n"
+    "    movl %ebx, 0(%esp) \n" // push pointer to TrapFrame
+    "    call syscall_handler \n"
+    "    movl %ebx, 0(%esp) \n" // push pointer to TrapFrame
+    "    call exit_trap \n"
+    "    addl $" __STRINGIFY(TRAP_FRAME_SIZE + 4) ", %esp\n" // pop TrapFrame and pointer to it
+         // SYSEXIT can only return to the %esi/%edi we came in with and clobbers %ecx/%edx.
+         // If the syscall rewrote the register state (signal dispatch, sigreturn, execve,
+         // ptrace, ...) or we're single-stepping, take the regular IRET exit instead.
+    "    movl 56(%esp), %eax\n" // RegisterState::eip
+    "    cmpl 24(%esp), %eax\n" // RegisterState::esi
+    "    jne interrupt_common_asm_exit\n"
+    "    movl 68(%esp), %eax\n" // RegisterState::userspace_esp
+    "    cmpl 20(%esp), %eax\n" // RegisterState::edi
+    "    jne interrupt_common_asm_exit\n"
+    "    cmpl $" __STRINGIFY(GDT_SELECTOR_CODE3 | 3) ", 60(%esp)\n" // RegisterState::cs
+    "    jne interrupt_common_asm_exit\n"
+    "    testl $0x24100, 64(%esp)\n" // RegisterState::eflags (VM, NT, TF)
+    "    jnz interrupt_common_asm_exit\n"
+    "    addl $4, %esp\n" // pop %ss
+    "    popl %gs\n"
+    "    popl %fs\n"
+    "    popl %es\n"
+    "    popl %ds\n"
+    "    popa\n"
+    "    addl $0x4, %esp\n" // skip exception_code, isr_number
+    "    movl 0(%esp), %edx\n" // eip
+    "    movl 12(%esp), %ecx\n" // userspace_esp
+    "    andl $~0x200, 8(%esp)\n" // keep interrupts disabled until SYSEXIT
+    "    addl $8, %esp\n" // pop eip, cs
+    "    popfl\n"
+    "    sti\n" // the STI interrupt shadow covers SYSEXIT
+    "    sysexit\n");
 // clang-format on
 
 namespace Syscall {
@@ -75,6 +147,8 @@ UNMAP_AFTER_INIT void initialize()
 {
     register_user_callable_interrupt_handler(syscall_vector, syscall_asm_entry);
     klog() << "Syscall: int 0x82 handler installed";
+    if (Processor::current().has_feature(CPUFeature::SEP))
+        klog() << "Syscall: SYSENTER fast path available";
 }
 
 #pragma GCC diagnostic ignored "-Wcast-function-type"
@@ -192,11 +266,26 @@ void syscall_handler(TrapFrame* trap)
         handle_crash(regs, "Syscall from non-syscall region", SIGSEGV);
     }
 
+    if (regs.isr_number == SYSENTER_ISR_NUMBER) {
+        // With SYSENTER, userspace tells us where to return to, so make sure that address
+        // really follows a SYSENTER instruction in the calling region.
+        u8 instruction[2];
+        FlatPtr instruction_address = regs.eip - sizeof(instruction);
+        if (instruction_address < calling_region->vaddr().get()
+            || !copy_from_user(instruction, (const u8*)instruction_address, sizeof(instruction))
+            || instruction[0] != 0x0f || instruction[1] != 0x34) {
+            dbgln("SYSENTER with bogus return address {:p}", regs.eip);
+            handle_crash(regs, "SYSENTER with bogus return address", SIGSEGV);
+        }
+    }
+
     u32 function = regs.eax;
     u32 arg1 = regs.edx;
     u32 arg2 = regs.ecx;
     u32 arg3 = regs.ebx;
+    TRACEPOINT(SyscallEntry, function, 0);
     regs.eax = Syscall::handle(regs, function, arg1, arg2, arg3);
+    TRACEPOINT(SyscallExit, function, regs.eax);
 
     process.big_lock().unlock();
 
@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <AK/NumericLimits.h>
+#include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/KBuffer.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+static bool is_all_zeros(ReadonlyBytes bytes)
+{
+    for (auto byte : bytes) {
+        if (byte)
+            return false;
+    }
+    return true;
+}
+
+ssize_t Process::sys$copy_file_range(Userspace<const Syscall::SC_copy_file_range_params*> user_params)
+{
+    REQUIRE_PROMISE(stdio);
+    Syscall::SC_copy_file_range_params params;
+    if (!copy_from_user(&params, user_params))
+        return -EFAULT;
+    if (params.flags)
+        return -EINVAL;
+
+    auto in_description = file_description(params.in_fd);
+    auto out_description = file_description(params.out_fd);
+    if (!in_description || !out_description)
+        return -EBADF;
+    if (!in_description->is_readable() || !out_description->is_writable() || out_description->should_append())
+        return -EBADF;
+    // Both ends have to be regular files, so they can be read and written at arbitrary offsets.
+    if (!in_description->inode() || !in_description->metadata().is_regular_file())
+        return -EINVAL;
+    if (!out_description->inode() || !out_description->metadata().is_regular_file())
+        return -EINVAL;
+
+    off_t in_offset = in_description->offset();
+    if (params.in_offset && !copy_from_user(&in_offset, params.in_offset))
+        return -EFAULT;
+    off_t out_offset = out_description->offset();
+    if (params.out_offset && !copy_from_user(&out_offset, params.out_offset))
+        return -EFAULT;
+    if (in_offset < 0 || out_offset < 0)
+        return -EINVAL;
+
+    size_t count = min(params.count, (size_t)NumericLimits<i32>::max());
+    if (count == 0)
+        return 0;
+    if (in_description->inode() == out_description->inode()) {
+        if ((u64)in_offset < (u64)out_offset + count && (u64)out_offset < (u64)in_offset + count)
+            return -EINVAL;
+    }
+
+    // Chunks go from one file's cache to the other's through a kernel buffer. A chunk of zeros
+    // isn't written if the destination already has zeros there, which is the case when copying
+    // into a file that was just truncated to its final size.
+    static constexpr size_t chunk_size = 64 * KiB;
+    auto chunk = KBuffer::try_create_with_size(min(count, chunk_size), Region::Access::Read | Region::Access::Write, "copy_file_range");
+    if (!chunk)
+        return -ENOMEM;
+    OwnPtr<KBuffer> destination_chunk;
+
+    ssize_t total_ncopied = 0;
+    while ((size_t)total_ncopied < count) {
+        size_t nread_wanted = min(count - total_ncopied, chunk->size());
+        auto chunk_buffer = UserOrKernelBuffer::for_kernel_buffer(chunk->data());
+        auto nread_or_error = in_description->file().read(*in_description, in_offset, chunk_buffer, nread_wanted);
+        if (nread_or_error.is_error()) {
+            if (total_ncopied == 0)
+                return nread_or_error.error();
+            break;
+        }
+        size_t nread = nread_or_error.value();
+        if (nread == 0)
+            break;
+
+        bool destination_has_same_zeros = false;
+        if (is_all_zeros({ chunk->data(), nread })) {
+            if (!destination_chunk)
+                destination_chunk = KBuffer::try_create_with_size(chunk->size(), Region::Access::Read | Region::Access::Write, "copy_file_range");
+            if (destination_chunk) {
+                auto destination_buffer = UserOrKernelBuffer::for_kernel_buffer(destination_chunk->data());
+                auto existing_or_error = out_description->file().read(*out_description, out_offset, destination_buffer, nread);
+                destination_has_same_zeros = !existing_or_error.is_error() && existing_or_error.value() == nread
+                    && is_all_zeros({ destination_chunk->data(), nread });
+            }
+        }
+
+        size_t nwritten = nread;
+        if (!destination_has_same_zeros) {
+            auto nwritten_or_error = out_description->file().write(*out_description, out_offset, chunk_buffer, nread);
+            if (nwritten_or_error.is_error()) {
+                if (total_ncopied == 0)
+                    return nwritten_or_error.error();
+                break;
+            }
+            nwritten = nwritten_or_error.value();
+        }
+        in_offset += nwritten;
+        out_offset += nwritten;
+        total_ncopied += nwritten;
+        if (nwritten < nread)
+            break;
+    }
+
+    // Like read() and write(), this moves the file positions unless the caller passed offsets.
+    if (params.in_offset) {
+        if (!copy_to_user(params.in_offset, &in_offset))
+            return -EFAULT;
+    } else if (auto result = in_description->seek(in_offset, SEEK_SET); result < 0) {
+        return result;
+    }
+    if (params.out_offset) {
+        if (!copy_to_user(params.out_offset, &out_offset))
+            return -EFAULT;
+    } else if (auto result = out_description->seek(out_offset, SEEK_SET); result < 0) {
+        return result;
+    }
+    return total_ncopied;
+}
+
+}
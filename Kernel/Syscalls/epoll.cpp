@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/ScopeGuard.h>
+#include <Kernel/FileSystem/EventPoll.h>
+#include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+int Process::sys$epoll_create(int flags)
+{
+    REQUIRE_PROMISE(stdio);
+    if ((flags & EPOLL_CLOEXEC) != flags)
+        return -EINVAL;
+
+    int fd = alloc_fd();
+    if (fd < 0)
+        return fd;
+
+    auto description = FileDescription::create(EventPoll::create());
+    if (description.is_error())
+        return description.error();
+
+    m_fds[fd].set(description.release_value(), (flags & EPOLL_CLOEXEC) ? FD_CLOEXEC : 0);
+    m_fds[fd].description()->set_readable(true);
+    return fd;
+}
+
+static EventPoll* event_poll_from(FileDescription* description)
+{
+    if (!description || !description->file().is_event_poll())
+        return nullptr;
+    return static_cast<EventPoll*>(&description->file());
+}
+
+int Process::sys$epoll_ctl(Userspace<const Syscall::SC_epoll_ctl_params*> user_params)
+{
+    REQUIRE_PROMISE(stdio);
+    Syscall::SC_epoll_ctl_params params;
+    if (!copy_from_user(&params, user_params))
+        return -EFAULT;
+
+    auto epoll_description = file_description(params.epoll_fd);
+    if (!epoll_description)
+        return -EBADF;
+    auto* event_poll = event_poll_from(epoll_description.ptr());
+    if (!event_poll)
+        return -EINVAL;
+
+    if (params.op == EPOLL_CTL_DEL)
+        return event_poll->remove(params.fd);
+
+    auto description = file_description(params.fd);
+    if (!description)
+        return -EBADF;
+
+    epoll_event event;
+    if (!copy_from_user(&event, params.event))
+        return -EFAULT;
+
+    switch (params.op) {
+    case EPOLL_CTL_ADD:
+        return event_poll->add(params.fd, *description, event);
+    case EPOLL_CTL_MOD:
+        return event_poll->modify(params.fd, *description, event);
+    default:
+        return -EINVAL;
+    }
+}
+
+int Process::sys$epoll_wait(Userspace<const Syscall::SC_epoll_wait_params*> user_params)
+{
+    REQUIRE_PROMISE(stdio);
+    Syscall::SC_epoll_wait_params params;
+    if (!copy_from_user(&params, user_params))
+        return -EFAULT;
+
+    if (params.max_events <= 0)
+        return -EINVAL;
+
+    auto description = file_description(params.epoll_fd);
+    if (!description)
+        return -EBADF;
+    auto* event_poll = event_poll_from(description.ptr());
+    if (!event_poll)
+        return -EINVAL;
+
+    Thread::BlockTimeout timeout;
+    if (params.timeout) {
+        timespec timeout_copy;
+        if (!copy_from_user(&timeout_copy, params.timeout))
+            return -EFAULT;
+        timeout = Thread::BlockTimeout(false, &timeout_copy);
+    }
+
+    auto current_thread = Thread::current();
+
+    u32 previous_signal_mask = 0;
+    if (params.sigmask) {
+        sigset_t sigmask_copy;
+        if (!copy_from_user(&sigmask_copy, params.sigmask))
+            return -EFAULT;
+        previous_signal_mask = current_thread->update_signal_mask(sigmask_copy);
+    }
+    ScopeGuard rollback_signal_mask([&]() {
+        if (params.sigmask)
+            current_thread->update_signal_mask(previous_signal_mask);
+    });
+
+    // A ready list can turn out to be empty after re-checking (level-triggered watches
+    // that stopped being ready), so keep waiting until something is reported or we time out.
+    Vector<epoll_event> events;
+    for (;;) {
+        events = event_poll->collect_ready_events(*this, params.max_events);
+        if (!events.is_empty() || !timeout.should_block())
+            break;
+
+        auto unblock_flags = Thread::FileBlocker::BlockFlags::None;
+        auto result = current_thread->block<Thread::ReadBlocker>(timeout, *description, unblock_flags);
+        if (result.was_interrupted())
+            return -EINTR;
+        if (result.timed_out()) {
+            events = event_poll->collect_ready_events(*this, params.max_events);
+            break;
+        }
+    }
+
+    if (!events.is_empty() && !copy_to_user(params.events, events.data(), events.size() * sizeof(epoll_event)))
+        return -EFAULT;
+    return events.size();
+}
+
+}
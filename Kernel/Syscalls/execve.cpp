@@ -60,7 +60,7 @@ struct LoadResult {
     WeakPtr<Region> stack_region;
 };
 
-static Vector<ELF::AuxiliaryValue> generate_auxiliary_vector(FlatPtr load_base, FlatPtr entry_eip, uid_t uid, uid_t euid, gid_t gid, gid_t egid, String executable_path, int main_program_fd);
+static Vector<ELF::AuxiliaryValue> generate_auxiliary_vector(FlatPtr load_base, FlatPtr entry_eip, uid_t uid, uid_t euid, gid_t gid, gid_t egid, String executable_path, int main_program_fd, VirtualAddress time_page);
 
 static bool validate_stack_size(const Vector<String>& arguments, const Vector<String>& environment)
 {
@@ -491,6 +491,12 @@ KResult Process::do_exec(NonnullRefPtr<FileDescription> main_program_description
         return ENOMEM;
     }
 
+    auto time_page_range = load_result_or_error.value().space->allocate_range({}, PAGE_SIZE);
+    if (!time_page_range.has_value()) {
+        dbgln("do_exec: Failed to allocate VM for time page");
+        return ENOMEM;
+    }
+
     // We commit to the new executable at this point. There is no turning back!
 
     // Prevent other processes from attaching to us with ptrace while we're doing this.
@@ -528,6 +534,11 @@ KResult Process::do_exec(NonnullRefPtr<FileDescription> main_program_description
     signal_trampoline_region.value()->set_syscall_region(true);
     m_signal_trampoline = signal_trampoline_region.value()->vaddr();
 
+    auto time_page_region = m_space->allocate_region_with_vmobject(time_page_range.value(), TimeManagement::the().time_page_region().vmobject(), 0, "Time page", PROT_READ, true);
+    if (time_page_region.is_error()) {
+        VERIFY_NOT_REACHED();
+    }
+
     m_executable = main_program_description->custody();
     m_arguments = arguments;
     m_environment = environment;
@@ -574,7 +585,7 @@ KResult Process::do_exec(NonnullRefPtr<FileDescription> main_program_description
     }
     VERIFY(new_main_thread);
 
-    auto auxv = generate_auxiliary_vector(load_result.load_base, load_result.entry_eip, m_uid, m_euid, m_gid, m_egid, path, main_program_fd);
+    auto auxv = generate_auxiliary_vector(load_result.load_base, load_result.entry_eip, m_uid, m_euid, m_gid, m_egid, path, main_program_fd, time_page_region.value()->vaddr());
 
     // NOTE: We create the new stack before disabling interrupts since it will zero-fault
     //       and we don't want to deal with faults after this point.
@@ -635,7 +646,7 @@ KResult Process::do_exec(NonnullRefPtr<FileDescription> main_program_description
     return KSuccess;
 }
 
-static Vector<ELF::AuxiliaryValue> generate_auxiliary_vector(FlatPtr load_base, FlatPtr entry_eip, uid_t uid, uid_t euid, gid_t gid, gid_t egid, String executable_path, int main_program_fd)
+static Vector<ELF::AuxiliaryValue> generate_auxiliary_vector(FlatPtr load_base, FlatPtr entry_eip, uid_t uid, uid_t euid, gid_t gid, gid_t egid, String executable_path, int main_program_fd, VirtualAddress time_page)
 {
     Vector<ELF::AuxiliaryValue> auxv;
     // PHDR/EXECFD
@@ -668,6 +679,8 @@ static Vector<ELF::AuxiliaryValue> generate_auxiliary_vector(FlatPtr load_base,
 
     auxv.append({ ELF::AuxiliaryValue::ExecFileDescriptor, main_program_fd });
 
+    auxv.append({ ELF::AuxiliaryValue::TimePage, time_page.as_ptr() });
+
     auxv.append({ ELF::AuxiliaryValue::Null, 0L });
     return auxv;
 }
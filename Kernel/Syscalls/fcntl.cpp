@@ -62,6 +62,26 @@ int Process::sys$fcntl(int fd, int cmd, u32 arg)
         break;
     case F_ISTTY:
         return description->is_tty();
+    case F_GETPIPE_SZ: {
+        auto* fifo = description->fifo();
+        if (!fifo)
+            return -EBADF;
+        return fifo->capacity();
+    }
+    case F_SETPIPE_SZ: {
+        auto* fifo = description->fifo();
+        if (!fifo)
+            return -EBADF;
+        if (arg > FIFO::max_capacity)
+            return -EINVAL;
+        size_t capacity = max((size_t)PAGE_SIZE, (size_t)round_up_to_power_of_two(arg, PAGE_SIZE));
+        if (capacity > FIFO::max_unprivileged_capacity && !is_superuser())
+            return -EPERM;
+        auto result = fifo->set_capacity(capacity);
+        if (result.is_error())
+            return result;
+        return fifo->capacity();
+    }
     default:
         return -EINVAL;
     }
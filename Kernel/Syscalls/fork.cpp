@@ -79,19 +79,22 @@ pid_t Process::sys$fork(RegisterState& regs)
 
     {
         ScopedSpinLock lock(space().get_lock());
+        // Write-protecting the CoW pages of every region would otherwise cost one shootdown per region.
+        ScopedTLBFlushBatch tlb_flush_batch;
         for (auto& region : space().regions()) {
-            dbgln_if(FORK_DEBUG, "fork: cloning Region({}) '{}' @ {}", &region, region.name(), region.vaddr());
-            auto region_clone = region.clone(*child);
+            dbgln_if(FORK_DEBUG, "fork: cloning Region({}) '{}' @ {}", region.ptr(), region->name(), region->vaddr());
+            auto region_clone = region->clone(*child);
             if (!region_clone) {
                 dbgln("fork: Cannot clone region, insufficient memory");
                 // TODO: tear down new process?
                 return -ENOMEM;
             }
 
+            // Most children execve() right away, so don't populate their page tables up front.
             auto& child_region = child->space().add_region(region_clone.release_nonnull());
-            child_region.map(child->space().page_directory());
+            child_region.map_lazily(child->space().page_directory());
 
-            if (&region == m_master_tls_region.unsafe_ptr())
+            if (region.ptr() == m_master_tls_region.unsafe_ptr())
                 child->m_master_tls_region = child_region;
         }
 
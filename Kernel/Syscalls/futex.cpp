@@ -104,7 +104,9 @@ void Process::clear_futex_queues_on_exec()
 
 int Process::sys$futex(Userspace<const Syscall::SC_futex_params*> user_params)
 {
-    REQUIRE_PROMISE(thread);
+    // Mutexes in LibC (including malloc's) sleep on futexes when contended, so this
+    // has to work for anyone allowed to use memory at all (like on OpenBSD).
+    REQUIRE_PROMISE(stdio);
 
     Syscall::SC_futex_params params;
     if (!copy_from_user(&params, user_params))
@@ -114,9 +116,8 @@ int Process::sys$futex(Userspace<const Syscall::SC_futex_params*> user_params)
     u32 cmd = params.futex_op & FUTEX_CMD_MASK;
     switch (cmd) {
     case FUTEX_WAIT:
-    case FUTEX_WAIT_BITSET:
-    case FUTEX_REQUEUE:
-    case FUTEX_CMP_REQUEUE: {
+    case FUTEX_WAIT_BITSET: {
+        // NOTE: The requeue and wake-op commands use this field as val2 instead.
         if (params.timeout) {
             timespec ts_stimeout { 0, 0 };
             if (!copy_from_user(&ts_stimeout, params.timeout))
@@ -158,7 +159,7 @@ int Process::sys$futex(Userspace<const Syscall::SC_futex_params*> user_params)
             if (!region2)
                 return -EFAULT;
             vmobject2 = region2->vmobject();
-            user_address_or_offset2 = region->offset_in_vmobject_from_vaddr(VirtualAddress(user_address_or_offset2));
+            user_address_or_offset2 = region2->offset_in_vmobject_from_vaddr(VirtualAddress(user_address_or_offset2));
             break;
         }
         }
@@ -294,8 +295,10 @@ int Process::sys$futex(Userspace<const Syscall::SC_futex_params*> user_params)
         u32 op_arg = _FUTEX_OP_ARG(params.val3);
         auto op = _FUTEX_OP(params.val3);
         if (op & FUTEX_OP_ARG_SHIFT) {
+            if (op_arg > 31)
+                return -EINVAL;
             op_arg = 1 << op_arg;
-            op &= FUTEX_OP_ARG_SHIFT;
+            op &= ~FUTEX_OP_ARG_SHIFT;
         }
         atomic_thread_fence(AK::MemoryOrder::memory_order_release);
         switch (op) {
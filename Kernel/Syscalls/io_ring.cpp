@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/FileSystem/IORing.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+int Process::sys$io_ring_create(Userspace<const Syscall::SC_io_ring_create_params*> user_params)
+{
+    REQUIRE_PROMISE(stdio);
+    Syscall::SC_io_ring_create_params params;
+    if (!copy_from_user(&params, user_params))
+        return -EFAULT;
+
+    if ((params.flags & IO_RING_CLOEXEC) != params.flags)
+        return -EINVAL;
+
+    auto ring = IORing::create(params.entries);
+    if (ring.is_error())
+        return ring.error();
+
+    auto ring_params = ring.value()->params();
+    if (!copy_to_user(params.params, &ring_params))
+        return -EFAULT;
+
+    int fd = alloc_fd();
+    if (fd < 0)
+        return fd;
+
+    auto description = FileDescription::create(ring.release_value());
+    if (description.is_error())
+        return description.error();
+
+    m_fds[fd].set(description.release_value(), (params.flags & IO_RING_CLOEXEC) ? FD_CLOEXEC : 0);
+    m_fds[fd].description()->set_readable(true);
+    return fd;
+}
+
+int Process::sys$io_ring_enter(Userspace<const Syscall::SC_io_ring_enter_params*> user_params)
+{
+    REQUIRE_PROMISE(stdio);
+    Syscall::SC_io_ring_enter_params params;
+    if (!copy_from_user(&params, user_params))
+        return -EFAULT;
+
+    auto description = file_description(params.ring_fd);
+    if (!description)
+        return -EBADF;
+    if (!description->file().is_io_ring())
+        return -EINVAL;
+    auto& ring = static_cast<IORing&>(description->file());
+
+    Thread::BlockTimeout timeout;
+    if (params.timeout) {
+        timespec timeout_copy;
+        if (!copy_from_user(&timeout_copy, params.timeout))
+            return -EFAULT;
+        timeout = Thread::BlockTimeout(false, &timeout_copy);
+    }
+
+    auto result = ring.enter(*this, *description, params.to_submit, params.min_complete, timeout);
+    if (result.is_error())
+        return result.error();
+    return result.value();
+}
+
+}
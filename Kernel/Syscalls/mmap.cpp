@@ -27,10 +27,12 @@
 #include <AK/WeakPtr.h>
 #include <Kernel/FileSystem/FileDescription.h>
 #include <Kernel/Process.h>
+#include <Kernel/VM/ContiguousVMObject.h>
 #include <Kernel/VM/MemoryManager.h>
 #include <Kernel/VM/PageDirectory.h>
 #include <Kernel/VM/PrivateInodeVMObject.h>
 #include <Kernel/VM/Region.h>
+#include <Kernel/VM/SharedImageCache.h>
 #include <Kernel/VM/SharedInodeVMObject.h>
 #include <LibC/limits.h>
 #include <LibELF/Validation.h>
@@ -137,6 +139,32 @@ static bool validate_inode_mmap_prot(const Process& process, int prot, const Ino
     return true;
 }
 
+// Faults in the pages of the range ahead of time, just like accessing them would. Pages of private
+// writable anonymous mappings are faulted in for writing, so that the first write doesn't fault either.
+static KResult populate_range(Space& space, const Range& range)
+{
+    for (auto vaddr = range.base(); vaddr < range.end(); vaddr = vaddr.offset(PAGE_SIZE)) {
+        ScopedSpinLock lock(space.get_lock());
+        // Inode faults let go of the lock while reading, so look up the region again after every fault.
+        auto* region = space.find_region_containing(vaddr);
+        if (!region)
+            return EFAULT;
+        if (!region->is_readable())
+            continue;
+        auto response = region->handle_fault(PageFault(PageFaultFlags::NotPresent | PageFaultFlags::Read, vaddr), lock);
+        if (response == PageFaultResponse::Continue) {
+            region = space.find_region_containing(vaddr);
+            if (region && region->is_writable() && !region->is_shared() && region->should_cow(region->page_index_from_address(vaddr)))
+                response = region->handle_fault(PageFault(PageFaultFlags::ProtectionViolation | PageFaultFlags::Write, vaddr), lock);
+        }
+        if (response == PageFaultResponse::OutOfMemory)
+            return ENOMEM;
+        if (response == PageFaultResponse::ShouldCrash)
+            return EFAULT;
+    }
+    return KSuccess;
+}
+
 FlatPtr Process::sys$mmap(Userspace<const Syscall::SC_mmap_params*> user_params)
 {
     REQUIRE_PROMISE(stdio);
@@ -191,6 +219,8 @@ FlatPtr Process::sys$mmap(Userspace<const Syscall::SC_mmap_params*> user_params)
     bool map_fixed = flags & MAP_FIXED;
     bool map_noreserve = flags & MAP_NORESERVE;
     bool map_randomized = flags & MAP_RANDOMIZED;
+    bool map_hugetlb = flags & MAP_HUGETLB;
+    bool map_populate = flags & MAP_POPULATE;
 
     if (map_shared && map_private)
         return -EINVAL;
@@ -207,6 +237,13 @@ FlatPtr Process::sys$mmap(Userspace<const Syscall::SC_mmap_params*> user_params)
     if (map_stack && (!map_private || !map_anonymous))
         return -EINVAL;
 
+    if (map_hugetlb && (!map_anonymous || map_stack))
+        return -EINVAL;
+
+    // Align huge anonymous mappings so that as much of them as possible can use huge pages.
+    if (map_hugetlb && size >= HUGE_PAGE_SIZE)
+        alignment = max(alignment, (size_t)HUGE_PAGE_SIZE);
+
     Region* region = nullptr;
     Optional<Range> range;
 
@@ -226,11 +263,23 @@ FlatPtr Process::sys$mmap(Userspace<const Syscall::SC_mmap_params*> user_params)
         return -ENOMEM;
 
     if (map_anonymous) {
-        auto strategy = map_noreserve ? AllocationStrategy::None : AllocationStrategy::Reserve;
-        auto region_or_error = space().allocate_region(range.value(), !name.is_null() ? name : "mmap", prot, strategy);
-        if (region_or_error.is_error())
-            return region_or_error.error().error();
-        region = region_or_error.value();
+        if (map_hugetlb && size >= HUGE_PAGE_SIZE) {
+            // MAP_HUGETLB is only a hint: without enough suitably aligned contiguous physical
+            // memory, we fall back to a regular anonymous mapping.
+            if (auto vmobject = ContiguousVMObject::try_create_with_user_pages(range.value().size(), HUGE_PAGE_SIZE)) {
+                auto region_or_error = space().allocate_region_with_vmobject(range.value(), vmobject.release_nonnull(), 0, !name.is_null() ? name : "mmap", prot, map_shared);
+                if (region_or_error.is_error())
+                    return region_or_error.error().error();
+                region = region_or_error.value();
+            }
+        }
+        if (!region) {
+            auto strategy = map_noreserve ? AllocationStrategy::None : AllocationStrategy::Reserve;
+            auto region_or_error = space().allocate_region(range.value(), !name.is_null() ? name : "mmap", prot, strategy);
+            if (region_or_error.is_error())
+                return region_or_error.error().error();
+            region = region_or_error.value();
+        }
     } else {
         if (offset < 0)
             return -EINVAL;
@@ -268,6 +317,13 @@ FlatPtr Process::sys$mmap(Userspace<const Syscall::SC_mmap_params*> user_params)
         region->set_stack(true);
     if (!name.is_null())
         region->set_name(name);
+    if (map_populate) {
+        // Failing to populate the mapping doesn't fail mmap(), the pages just get faulted in later.
+        auto range_to_populate = region->range();
+        if (auto result = populate_range(space(), range_to_populate); result.is_error())
+            dbgln("mmap: Failed to populate {} ({} bytes): {}", range_to_populate.base(), range_to_populate.size(), result.error());
+        return range_to_populate.base().get();
+    }
     return region->vaddr().get();
 }
 
@@ -310,7 +366,7 @@ int Process::sys$mprotect(void* addr, size_t size, int prot)
     if (auto* whole_region = space().find_region_from_range(range_to_mprotect)) {
         if (!whole_region->is_mmap())
             return -EPERM;
-        if (!validate_mmap_prot(prot, whole_region->is_stack(), whole_region->vmobject().is_anonymous(), whole_region))
+        if (!validate_mmap_prot(prot, whole_region->is_stack(), whole_region->vmobject().is_anonymous() || whole_region->vmobject().is_contiguous(), whole_region))
             return -EINVAL;
         if (whole_region->access() == prot_to_region_access_flags(prot))
             return 0;
@@ -330,7 +386,7 @@ int Process::sys$mprotect(void* addr, size_t size, int prot)
     if (auto* old_region = space().find_region_containing(range_to_mprotect)) {
         if (!old_region->is_mmap())
             return -EPERM;
-        if (!validate_mmap_prot(prot, old_region->is_stack(), old_region->vmobject().is_anonymous(), old_region))
+        if (!validate_mmap_prot(prot, old_region->is_stack(), old_region->vmobject().is_anonymous() || old_region->vmobject().is_contiguous(), old_region))
             return -EINVAL;
         if (old_region->access() == prot_to_region_access_flags(prot))
             return 0;
@@ -339,6 +395,9 @@ int Process::sys$mprotect(void* addr, size_t size, int prot)
             return -EACCES;
         }
 
+        // The old region's VMObject stays alive in the new regions, so its pages can't be freed before the batch ends.
+        ScopedTLBFlushBatch tlb_flush_batch;
+
         // This vector is the region(s) adjacent to our range.
         // We need to allocate a new region for the range we wanted to change permission bits on.
         auto adjacent_regions = space().split_region_around_range(*old_region, range_to_mprotect);
@@ -382,6 +441,15 @@ int Process::sys$madvise(void* address, size_t size, int advice)
     if (!is_user_range(range_to_madvise))
         return -EFAULT;
 
+    switch (advice) {
+    case MADV_NORMAL:
+    case MADV_SEQUENTIAL:
+    case MADV_RANDOM:
+    case MADV_WILLNEED:
+    case MADV_DONTNEED:
+        return do_madvise(range_to_madvise, advice);
+    }
+
     auto* region = space().find_region_from_range(range_to_madvise);
     if (!region)
         return -EINVAL;
@@ -412,9 +480,55 @@ int Process::sys$madvise(void* address, size_t size, int advice)
             return -EPERM;
         return region->is_volatile(VirtualAddress(address), size) ? 0 : 1;
     }
+    if (advice & MADV_SHARE_IDENTICAL) {
+        if (!region->vmobject().is_anonymous() || region->is_shared() || region->is_writable())
+            return -EPERM;
+        ScopedSpinLock lock(space().get_lock());
+        SharedImageCache::the().share_pages(*region);
+        return 0;
+    }
     return -EINVAL;
 }
 
+int Process::do_madvise(const Range& range, int advice)
+{
+    // Unlike the advice above, these may be given for any part of a mapping.
+    auto* region = space().find_region_containing(range);
+    if (!region)
+        return -EINVAL;
+    if (!region->is_mmap())
+        return -EPERM;
+
+    switch (advice) {
+    case MADV_NORMAL:
+        // FIXME: The access pattern applies to the whole region, we should split it instead.
+        region->set_access_pattern(Region::AccessPattern::Normal);
+        return 0;
+    case MADV_SEQUENTIAL:
+        region->set_access_pattern(Region::AccessPattern::Sequential);
+        return 0;
+    case MADV_RANDOM:
+        region->set_access_pattern(Region::AccessPattern::Random);
+        return 0;
+    case MADV_WILLNEED: {
+        // Anonymous memory is either there already or will be zero-filled, so only files need reading.
+        if (!region->vmobject().is_inode())
+            return 0;
+        auto result = populate_range(space(), range);
+        if (result.is_error())
+            return result;
+        return 0;
+    }
+    case MADV_DONTNEED:
+        // Other processes may still be using the contents of shared anonymous memory.
+        if (region->is_shared() && region->vmobject().is_anonymous())
+            return 0;
+        region->discard_pages(region->page_index_from_address(range.base()), range.size() / PAGE_SIZE);
+        return 0;
+    }
+    VERIFY_NOT_REACHED();
+}
+
 int Process::sys$set_mmap_name(Userspace<const Syscall::SC_set_mmap_name_params*> user_params)
 {
     REQUIRE_PROMISE(stdio);
@@ -582,6 +696,31 @@ FlatPtr Process::sys$allocate_tls(size_t size)
     return m_master_tls_region.unsafe_ptr()->vaddr().get();
 }
 
+FlatPtr Process::sys$reserve_shared_image(int fd, size_t size)
+{
+    REQUIRE_PROMISE(stdio);
+
+    if (!size || page_round_up_would_wrap(size))
+        return -EINVAL;
+
+    auto description = file_description(fd);
+    if (!description)
+        return -EBADF;
+    auto* inode = description->inode();
+    if (!inode)
+        return -ENODEV;
+
+    auto range = SharedImageCache::the().allocate_range(space(), *inode, page_round_up(size));
+    if (!range.has_value())
+        return -ENOMEM;
+
+    auto region_or_error = space().allocate_region(range.value(), "Image reservation", PROT_NONE, AllocationStrategy::None);
+    if (region_or_error.is_error())
+        return region_or_error.error().error();
+    region_or_error.value()->set_mmap(true);
+    return region_or_error.value()->vaddr().get();
+}
+
 int Process::sys$msyscall(void* address)
 {
     if (space().enforces_syscall_regions())
@@ -31,6 +31,9 @@ namespace Kernel {
 
 int Process::sys$perf_event(int type, FlatPtr arg1, FlatPtr arg2)
 {
+    // The other event types are reserved for the kernel's tracepoints.
+    if (type != PERF_EVENT_SAMPLE && type != PERF_EVENT_MALLOC && type != PERF_EVENT_FREE)
+        return -EINVAL;
     return ensure_perf_events().append(type, arg1, arg2);
 }
 
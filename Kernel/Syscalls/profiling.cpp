@@ -24,41 +24,89 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Singleton.h>
 #include <Kernel/CoreDump.h>
 #include <Kernel/FileSystem/FileDescription.h>
 #include <Kernel/FileSystem/VirtualFileSystem.h>
+#include <Kernel/PerformanceCounters.h>
 #include <Kernel/PerformanceEventBuffer.h>
 #include <Kernel/Process.h>
+#include <Kernel/Tracepoint.h>
 
 namespace Kernel {
 
-int Process::sys$profiling_enable(pid_t pid)
+static Atomic<u32> s_profiled_process_count;
+static AK::Singleton<Lock> s_profiling_lock;
+
+KResult Process::enable_profiling(int sample_source)
+{
+    Locker locker(*s_profiling_lock);
+    if (m_profiling) {
+        if (m_profiling_sample_source != sample_source)
+            return EBUSY;
+        return KSuccess;
+    }
+
+    auto result = PerformanceCounters::acquire(sample_source);
+    if (result.is_error())
+        return result;
+    ensure_perf_events().set_sample_source(sample_source);
+    m_profiling_sample_source = sample_source;
+    m_profiling = true;
+
+    // Keep the tracepoints enabled for as long as anyone is being profiled.
+    if (s_profiled_process_count.fetch_add(1) == 0)
+        set_tracepoints_enabled(true);
+    return KSuccess;
+}
+
+void Process::disable_profiling()
+{
+    Locker locker(*s_profiling_lock);
+    if (!m_profiling)
+        return;
+    m_profiling = false;
+    PerformanceCounters::release(m_profiling_sample_source);
+
+    if (s_profiled_process_count.fetch_sub(1) == 1)
+        set_tracepoints_enabled(false);
+}
+
+int Process::sys$profiling_enable(pid_t pid, int sample_source)
 {
     REQUIRE_NO_PROMISES;
-    ScopedSpinLock lock(g_processes_lock);
-    auto process = Process::from_pid(pid);
-    if (!process)
-        return -ESRCH;
-    if (process->is_dead())
-        return -ESRCH;
-    if (!is_superuser() && process->uid() != m_euid)
-        return -EPERM;
-    process->ensure_perf_events();
-    process->set_profiling(true);
-    return 0;
+    if (!PerformanceCounters::is_valid_sample_source(sample_source))
+        return -EINVAL;
+
+    // Starting the performance counters may have to wait for other processors, so don't hold on to g_processes_lock.
+    RefPtr<Process> process;
+    {
+        ScopedSpinLock lock(g_processes_lock);
+        process = Process::from_pid(pid);
+        if (!process)
+            return -ESRCH;
+        if (process->is_dead())
+            return -ESRCH;
+        if (!is_superuser() && process->uid() != m_euid)
+            return -EPERM;
+    }
+    return process->enable_profiling(sample_source);
 }
 
 int Process::sys$profiling_disable(pid_t pid)
 {
-    ScopedSpinLock lock(g_processes_lock);
-    auto process = Process::from_pid(pid);
-    if (!process)
-        return -ESRCH;
-    if (!is_superuser() && process->uid() != m_euid)
-        return -EPERM;
-    if (!process->is_profiling())
-        return -EINVAL;
-    process->set_profiling(false);
+    RefPtr<Process> process;
+    {
+        ScopedSpinLock lock(g_processes_lock);
+        process = Process::from_pid(pid);
+        if (!process)
+            return -ESRCH;
+        if (!is_superuser() && process->uid() != m_euid)
+            return -EPERM;
+        if (!process->is_profiling())
+            return -EINVAL;
+    }
+    process->disable_profiling();
     return 0;
 }
 
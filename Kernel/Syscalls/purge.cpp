@@ -24,10 +24,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <AK/NonnullRefPtrVector.h>
 #include <Kernel/Process.h>
-#include <Kernel/VM/AnonymousVMObject.h>
-#include <Kernel/VM/InodeVMObject.h>
 #include <Kernel/VM/MemoryManager.h>
 
 namespace Kernel {
@@ -38,34 +35,10 @@ int Process::sys$purge(int mode)
     if (!is_superuser())
         return -EPERM;
     int purged_page_count = 0;
-    if (mode & PURGE_ALL_VOLATILE) {
-        NonnullRefPtrVector<AnonymousVMObject> vmobjects;
-        {
-            InterruptDisabler disabler;
-            MM.for_each_vmobject([&](auto& vmobject) {
-                if (vmobject.is_anonymous())
-                    vmobjects.append(vmobject);
-                return IterationDecision::Continue;
-            });
-        }
-        for (auto& vmobject : vmobjects) {
-            purged_page_count += vmobject.purge();
-        }
-    }
-    if (mode & PURGE_ALL_CLEAN_INODE) {
-        NonnullRefPtrVector<InodeVMObject> vmobjects;
-        {
-            InterruptDisabler disabler;
-            MM.for_each_vmobject([&](auto& vmobject) {
-                if (vmobject.is_inode())
-                    vmobjects.append(static_cast<InodeVMObject&>(vmobject));
-                return IterationDecision::Continue;
-            });
-        }
-        for (auto& vmobject : vmobjects) {
-            purged_page_count += vmobject.release_all_clean_pages();
-        }
-    }
+    if (mode & PURGE_ALL_VOLATILE)
+        purged_page_count += MM.purge_all_volatile_memory();
+    if (mode & PURGE_ALL_CLEAN_INODE)
+        purged_page_count += MM.release_all_clean_inode_pages();
     return purged_page_count;
 }
 
@@ -61,25 +61,30 @@ ssize_t Process::sys$readv(int fd, Userspace<const struct iovec*> iov, int iov_c
     if (description->is_directory())
         return -EISDIR;
 
+    // Only wait for data before the first read; after that, return whatever we got.
+    if (description->is_blocking() && !description->can_read()) {
+        auto unblock_flags = Thread::FileBlocker::BlockFlags::None;
+        if (Thread::current()->block<Thread::ReadBlocker>({}, *description, unblock_flags).was_interrupted())
+            return -EINTR;
+        if (!((u32)unblock_flags & (u32)Thread::FileBlocker::BlockFlags::Read))
+            return -EAGAIN;
+        // TODO: handle exceptions in unblock_flags
+    }
+
     int nread = 0;
     for (auto& vec : vecs) {
-        if (description->is_blocking()) {
-            if (!description->can_read()) {
-                auto unblock_flags = Thread::FileBlocker::BlockFlags::None;
-                if (Thread::current()->block<Thread::ReadBlocker>({}, *description, unblock_flags).was_interrupted())
-                    return -EINTR;
-                if (!((u32)unblock_flags & (u32)Thread::FileBlocker::BlockFlags::Read))
-                    return -EAGAIN;
-                // TODO: handle exceptions in unblock_flags
-            }
-        }
         auto buffer = UserOrKernelBuffer::for_user_buffer((u8*)vec.iov_base, vec.iov_len);
         if (!buffer.has_value())
             return -EFAULT;
         auto result = description->read(buffer.value(), vec.iov_len);
-        if (result.is_error())
-            return result.error();
+        if (result.is_error()) {
+            if (nread == 0)
+                return result.error();
+            break;
+        }
         nread += result.value();
+        if (result.value() < vec.iov_len)
+            break;
     }
 
     return nread;
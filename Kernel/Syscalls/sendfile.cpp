@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/NumericLimits.h>
+#include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/KBuffer.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+ssize_t Process::sys$sendfile(Userspace<const Syscall::SC_sendfile_params*> user_params)
+{
+    REQUIRE_PROMISE(stdio);
+    Syscall::SC_sendfile_params params;
+    if (!copy_from_user(&params, user_params))
+        return -EFAULT;
+
+    auto in_description = file_description(params.in_fd);
+    auto out_description = file_description(params.out_fd);
+    if (!in_description || !out_description)
+        return -EBADF;
+    if (!in_description->is_readable() || !out_description->is_writable())
+        return -EBADF;
+    // Only regular files can be read at arbitrary offsets without side effects.
+    if (!in_description->inode() || in_description->is_directory())
+        return -EINVAL;
+
+    off_t offset = in_description->offset();
+    if (params.offset && !copy_from_user(&offset, params.offset))
+        return -EFAULT;
+    if (offset < 0)
+        return -EINVAL;
+
+    size_t count = min(params.count, (size_t)NumericLimits<i32>::max());
+    if (count == 0)
+        return 0;
+
+    // Data goes from the file's cache to the destination through one kernel buffer,
+    // without a round trip through userspace.
+    static constexpr size_t chunk_size = 64 * KiB;
+    auto chunk = KBuffer::try_create_with_size(min(count, chunk_size), Region::Access::Read | Region::Access::Write, "sendfile");
+    if (!chunk)
+        return -ENOMEM;
+
+    ssize_t total_nsent = 0;
+    while ((size_t)total_nsent < count) {
+        size_t nread_wanted = min(count - total_nsent, chunk->size());
+        auto chunk_buffer = UserOrKernelBuffer::for_kernel_buffer(chunk->data());
+        auto nread_or_error = in_description->file().read(*in_description, offset, chunk_buffer, nread_wanted);
+        if (nread_or_error.is_error()) {
+            if (total_nsent == 0)
+                return nread_or_error.error();
+            break;
+        }
+        size_t nread = nread_or_error.value();
+        if (nread == 0)
+            break;
+
+        auto nwritten = do_write(*out_description, chunk_buffer, nread);
+        if (nwritten < 0) {
+            if (total_nsent == 0)
+                return nwritten;
+            break;
+        }
+        offset += nwritten;
+        total_nsent += nwritten;
+        // A short write means the destination can't take more right now (e.g. a full non-blocking socket).
+        if ((size_t)nwritten < nread)
+            break;
+    }
+
+    // Only what made it to the destination counts as consumed.
+    if (params.offset) {
+        if (!copy_to_user(params.offset, &offset))
+            return -EFAULT;
+    } else {
+        auto result = in_description->seek(offset, SEEK_SET);
+        if (result < 0)
+            return result;
+    }
+    return total_nsent;
+}
+
+}
@@ -24,10 +24,13 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/NumericLimits.h>
 #include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/KBuffer.h>
 #include <Kernel/Net/IPv4Socket.h>
 #include <Kernel/Net/LocalSocket.h>
 #include <Kernel/Process.h>
+#include <Kernel/Time/TimeManagement.h>
 #include <Kernel/UnixTypes.h>
 
 namespace Kernel {
@@ -97,7 +100,14 @@ int Process::sys$listen(int sockfd, int backlog)
 int Process::sys$accept(int accepting_socket_fd, Userspace<sockaddr*> user_address, Userspace<socklen_t*> user_address_size)
 {
     REQUIRE_PROMISE(accept);
+    auto accepting_socket_description = file_description(accepting_socket_fd);
+    if (!accepting_socket_description)
+        return -EBADF;
+    return do_accept(accepting_socket_fd, user_address, user_address_size, accepting_socket_description->is_blocking());
+}
 
+int Process::do_accept(int accepting_socket_fd, Userspace<sockaddr*> user_address, Userspace<socklen_t*> user_address_size, bool should_block)
+{
     socklen_t address_size = 0;
     if (user_address && !copy_from_user(&address_size, static_ptr_cast<const socklen_t*>(user_address_size)))
         return -EFAULT;
@@ -113,7 +123,7 @@ int Process::sys$accept(int accepting_socket_fd, Userspace<sockaddr*> user_addre
     auto& socket = *accepting_socket_description->socket();
 
     if (!socket.can_accept()) {
-        if (accepting_socket_description->is_blocking()) {
+        if (should_block) {
             auto unblock_flags = Thread::FileBlocker::BlockFlags::None;
             if (Thread::current()->block<Thread::AcceptBlocker>({}, *accepting_socket_description, unblock_flags).was_interrupted())
                 return -EINTR;
@@ -183,86 +193,155 @@ int Process::sys$shutdown(int sockfd, int how)
     return socket.shutdown(how);
 }
 
-ssize_t Process::sys$sendmsg(int sockfd, Userspace<const struct msghdr*> user_msg, int flags)
-{
-    REQUIRE_PROMISE(stdio);
-    struct msghdr msg;
-    if (!copy_from_user(&msg, user_msg))
-        return -EFAULT;
+// Arbitrary pain threshold, same as Linux's UIO_MAXIOV.
+static constexpr int max_message_iovecs = 1024;
+// Messages spread over several iovecs are gathered into a kernel buffer of at most this size.
+// Stream sockets send and receive bigger ones in parts, datagram sockets refuse to send them.
+static constexpr size_t max_gathered_message_size = 256 * KiB;
 
-    if (msg.msg_iovlen != 1)
-        return -ENOTSUP; // FIXME: Support this :)
-    Vector<iovec, 1> iovs;
+static KResult copy_message_iovecs_from_user(const msghdr& msg, Vector<iovec, 8>& iovs, size_t& total_length)
+{
+    if (msg.msg_iovlen < 0 || msg.msg_iovlen > max_message_iovecs)
+        return EMSGSIZE;
     iovs.resize(msg.msg_iovlen);
     if (!copy_n_from_user(iovs.data(), msg.msg_iov, msg.msg_iovlen))
-        return -EFAULT;
+        return EFAULT;
+    u64 length = 0;
+    for (auto& iov : iovs) {
+        length += iov.iov_len;
+        if (length > NumericLimits<i32>::max())
+            return EINVAL;
+    }
+    total_length = length;
+    return KSuccess;
+}
+
+ssize_t Process::do_sendmsg(FileDescription& description, const struct msghdr& msg, int flags)
+{
+    Vector<iovec, 8> iovs;
+    size_t total_length = 0;
+    auto result = copy_message_iovecs_from_user(msg, iovs, total_length);
+    if (result.is_error())
+        return result;
 
     Userspace<const sockaddr*> user_addr((FlatPtr)msg.msg_name);
     socklen_t addr_length = msg.msg_namelen;
 
-    auto description = file_description(sockfd);
-    if (!description)
-        return -EBADF;
-    if (!description->is_socket())
+    if (!description.is_socket())
         return -ENOTSOCK;
-    auto& socket = *description->socket();
+    auto& socket = *description.socket();
     if (socket.is_shut_down_for_writing())
         return -EPIPE;
-    auto data_buffer = UserOrKernelBuffer::for_user_buffer((u8*)iovs[0].iov_base, iovs[0].iov_len);
-    if (!data_buffer.has_value())
-        return -EFAULT;
-    auto result = socket.sendto(*description, data_buffer.value(), iovs[0].iov_len, flags, user_addr, addr_length);
-    if (result.is_error())
-        return result.error();
-    return result.value();
+
+    if (iovs.size() == 1) {
+        auto data_buffer = UserOrKernelBuffer::for_user_buffer((u8*)iovs[0].iov_base, iovs[0].iov_len);
+        if (!data_buffer.has_value())
+            return -EFAULT;
+        auto nsent_or_error = socket.sendto(description, data_buffer.value(), iovs[0].iov_len, flags, user_addr, addr_length);
+        if (nsent_or_error.is_error())
+            return nsent_or_error.error();
+        return nsent_or_error.value();
+    }
+
+    // The socket layer takes one contiguous buffer, and a datagram has to go out in one piece.
+    size_t gathered_length = total_length;
+    if (gathered_length > max_gathered_message_size) {
+        if (socket.type() != SOCK_STREAM)
+            return -EMSGSIZE;
+        gathered_length = max_gathered_message_size;
+    }
+    auto gathered = KBuffer::try_create_with_size(max(gathered_length, (size_t)1), Region::Access::Read | Region::Access::Write, "sendmsg");
+    if (!gathered)
+        return -ENOMEM;
+    size_t offset = 0;
+    for (auto& iov : iovs) {
+        size_t size = min(iov.iov_len, gathered_length - offset);
+        if (!copy_from_user(gathered->data() + offset, iov.iov_base, size))
+            return -EFAULT;
+        offset += size;
+        if (offset == gathered_length)
+            break;
+    }
+    auto nsent_or_error = socket.sendto(description, UserOrKernelBuffer::for_kernel_buffer(gathered->data()), gathered_length, flags, user_addr, addr_length);
+    if (nsent_or_error.is_error())
+        return nsent_or_error.error();
+    return nsent_or_error.value();
 }
 
-ssize_t Process::sys$recvmsg(int sockfd, Userspace<struct msghdr*> user_msg, int flags)
+ssize_t Process::sys$sendmsg(int sockfd, Userspace<const struct msghdr*> user_msg, int flags)
 {
     REQUIRE_PROMISE(stdio);
-
     struct msghdr msg;
     if (!copy_from_user(&msg, user_msg))
         return -EFAULT;
 
-    if (msg.msg_iovlen != 1)
-        return -ENOTSUP; // FIXME: Support this :)
-    Vector<iovec, 1> iovs;
-    iovs.resize(msg.msg_iovlen);
-    if (!copy_n_from_user(iovs.data(), msg.msg_iov, msg.msg_iovlen))
+    auto description = file_description(sockfd);
+    if (!description)
+        return -EBADF;
+    return do_sendmsg(*description, msg, flags);
+}
+
+ssize_t Process::do_recvmsg(FileDescription& description, Userspace<struct msghdr*> user_msg, int flags)
+{
+    struct msghdr msg;
+    if (!copy_from_user(&msg, user_msg))
         return -EFAULT;
 
+    Vector<iovec, 8> iovs;
+    size_t total_length = 0;
+    auto iovecs_result = copy_message_iovecs_from_user(msg, iovs, total_length);
+    if (iovecs_result.is_error())
+        return iovecs_result;
+
     Userspace<sockaddr*> user_addr((FlatPtr)msg.msg_name);
     Userspace<socklen_t*> user_addr_length(msg.msg_name ? (FlatPtr)&user_msg.unsafe_userspace_ptr()->msg_namelen : 0);
 
-    auto description = file_description(sockfd);
-    if (!description)
-        return -EBADF;
-    if (!description->is_socket())
+    if (!description.is_socket())
         return -ENOTSOCK;
-    auto& socket = *description->socket();
+    auto& socket = *description.socket();
 
     if (socket.is_shut_down_for_reading())
         return 0;
 
-    bool original_blocking = description->is_blocking();
-    if (flags & MSG_DONTWAIT)
-        description->set_blocking(false);
+    Optional<UserOrKernelBuffer> data_buffer;
+    OwnPtr<KBuffer> gathered;
+    size_t buffer_length = total_length;
+    if (iovs.size() == 1) {
+        data_buffer = UserOrKernelBuffer::for_user_buffer((u8*)iovs[0].iov_base, iovs[0].iov_len);
+        if (!data_buffer.has_value())
+            return -EFAULT;
+    } else {
+        // Receive into one kernel buffer and scatter it afterwards, so a datagram isn't split up.
+        buffer_length = min(total_length, max_gathered_message_size);
+        gathered = KBuffer::try_create_with_size(max(buffer_length, (size_t)1), Region::Access::Read | Region::Access::Write, "recvmsg");
+        if (!gathered)
+            return -ENOMEM;
+        data_buffer = UserOrKernelBuffer::for_kernel_buffer(gathered->data());
+    }
 
-    auto data_buffer = UserOrKernelBuffer::for_user_buffer((u8*)iovs[0].iov_base, iovs[0].iov_len);
-    if (!data_buffer.has_value())
-        return -EFAULT;
     timeval timestamp = { 0, 0 };
-    auto result = socket.recvfrom(*description, data_buffer.value(), iovs[0].iov_len, flags, user_addr, user_addr_length, timestamp);
-    if (flags & MSG_DONTWAIT)
-        description->set_blocking(original_blocking);
+    auto result = socket.recvfrom(description, data_buffer.value(), buffer_length, flags, user_addr, user_addr_length, timestamp);
 
     if (result.is_error())
         return result.error();
 
+    if (iovs.size() != 1) {
+        size_t remaining = min(result.value(), buffer_length);
+        size_t offset = 0;
+        for (auto& iov : iovs) {
+            if (!remaining)
+                break;
+            size_t size = min(remaining, iov.iov_len);
+            if (!copy_to_user(iov.iov_base, gathered->data() + offset, size))
+                return -EFAULT;
+            offset += size;
+            remaining -= size;
+        }
+    }
+
     int msg_flags = 0;
 
-    if (result.value() > iovs[0].iov_len) {
+    if (result.value() > buffer_length) {
         VERIFY(socket.type() != SOCK_STREAM);
         msg_flags |= MSG_TRUNC;
     }
@@ -290,6 +369,93 @@ ssize_t Process::sys$recvmsg(int sockfd, Userspace<struct msghdr*> user_msg, int
     return result.value();
 }
 
+ssize_t Process::sys$recvmsg(int sockfd, Userspace<struct msghdr*> user_msg, int flags)
+{
+    REQUIRE_PROMISE(stdio);
+
+    auto description = file_description(sockfd);
+    if (!description)
+        return -EBADF;
+    return do_recvmsg(*description, user_msg, flags);
+}
+
+int Process::sys$sendmmsg(Userspace<const Syscall::SC_sendmmsg_params*> user_params)
+{
+    REQUIRE_PROMISE(stdio);
+    Syscall::SC_sendmmsg_params params;
+    if (!copy_from_user(&params, user_params))
+        return -EFAULT;
+
+    auto description = file_description(params.sockfd);
+    if (!description)
+        return -EBADF;
+
+    unsigned count = min(params.vlen, (unsigned)max_message_iovecs);
+    unsigned nsent_messages = 0;
+    for (; nsent_messages < count; ++nsent_messages) {
+        auto& user_message = params.msgvec[nsent_messages];
+        struct msghdr msg;
+        if (!copy_from_user(&msg, &user_message.msg_hdr))
+            return nsent_messages ? (int)nsent_messages : -EFAULT;
+
+        // Like sendmsg(), except that a failure after the first message just ends the batch.
+        auto rc = do_sendmsg(*description, msg, params.flags);
+        if (rc < 0)
+            return nsent_messages ? (int)nsent_messages : rc;
+
+        unsigned message_length = rc;
+        if (!copy_to_user(&user_message.msg_len, &message_length))
+            return nsent_messages ? (int)nsent_messages : -EFAULT;
+    }
+    return nsent_messages;
+}
+
+int Process::sys$recvmmsg(Userspace<const Syscall::SC_recvmmsg_params*> user_params)
+{
+    REQUIRE_PROMISE(stdio);
+    Syscall::SC_recvmmsg_params params;
+    if (!copy_from_user(&params, user_params))
+        return -EFAULT;
+
+    Optional<timespec> deadline;
+    if (params.timeout) {
+        timespec timeout;
+        if (!copy_from_user(&timeout, params.timeout))
+            return -EFAULT;
+        timespec now = TimeManagement::the().current_time(CLOCK_MONOTONIC_COARSE).value();
+        timespec_add(now, timeout, timeout);
+        deadline = timeout;
+    }
+
+    auto description = file_description(params.sockfd);
+    if (!description)
+        return -EBADF;
+
+    unsigned count = min(params.vlen, (unsigned)max_message_iovecs);
+    unsigned nreceived_messages = 0;
+    for (; nreceived_messages < count; ++nreceived_messages) {
+        int flags = params.flags & ~MSG_WAITFORONE;
+        if (nreceived_messages > 0 && (params.flags & MSG_WAITFORONE))
+            flags |= MSG_DONTWAIT;
+
+        auto& user_message = params.msgvec[nreceived_messages];
+        auto rc = do_recvmsg(*description, Userspace<struct msghdr*>((FlatPtr)&user_message.msg_hdr), flags);
+        if (rc < 0)
+            return nreceived_messages ? (int)nreceived_messages : rc;
+
+        unsigned message_length = rc;
+        if (!copy_to_user(&user_message.msg_len, &message_length))
+            return nreceived_messages ? (int)nreceived_messages : -EFAULT;
+
+        // As on Linux, the timeout is only checked between messages.
+        if (deadline.has_value() && TimeManagement::the().current_time(CLOCK_MONOTONIC_COARSE).value() >= deadline.value()) {
+            ++nreceived_messages;
+            break;
+        }
+    }
+    return nreceived_messages;
+}
+
 template<bool sockname, typename Params>
 int Process::get_sock_or_peer_name(const Params& params)
 {
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Kernel/Devices/MemoryPressureDevice.h>
+#include <Kernel/Process.h>
+#include <Kernel/Tasks/PageScannerTask.h>
+#include <Kernel/VM/CompressedPageStore.h>
+#include <Kernel/VM/MemoryManager.h>
+#include <Kernel/WaitQueue.h>
+
+namespace Kernel {
+
+// Don't evict more than this many pages per round, we're only trying to stay
+// ahead of demand. Allocations that run dry evict pages synchronously.
+static constexpr size_t max_pages_evicted_per_round = 256;
+
+void PageScannerTask::spawn()
+{
+    RefPtr<Thread> page_scanner_thread;
+    Process::create_kernel_process(page_scanner_thread, "PageScannerTask", [] {
+        Thread::current()->set_priority(THREAD_PRIORITY_LOW);
+        auto last_level = MemoryPressureLevel::Low;
+        for (;;) {
+            auto level = MM.memory_pressure_level();
+            if (level != last_level) {
+                dbgln("PageScannerTask: Memory pressure is now {}", to_string(level));
+                last_level = level;
+                MemoryPressureDevice::did_change_level();
+            }
+
+            if (level == MemoryPressureLevel::Critical) {
+                // Don't wait for allocations to fail before reclaiming what we can.
+                auto purged_page_count = MM.purge_all_volatile_memory();
+                if (MM.memory_pressure_level() == MemoryPressureLevel::Critical)
+                    purged_page_count += MM.release_all_clean_inode_pages();
+                dbgln("PageScannerTask: Reclaimed {} pages", purged_page_count);
+            }
+
+            if (CompressedPageStore::is_initialized()) {
+                // Try to keep an eighth of user memory available by moving cold
+                // anonymous pages into the compressed page store ahead of time.
+                size_t target = MM.user_physical_pages() / 8;
+                size_t available = MM.user_physical_pages_uncommitted();
+                if (available < target)
+                    MM.evict_cold_anonymous_pages(min(target - available, max_pages_evicted_per_round));
+            }
+
+            timeval timeout { 1, 0 };
+            [[maybe_unused]] auto result = MM.memory_pressure_wait_queue().wait_on(Thread::BlockTimeout(false, &timeout), "PageScannerTask");
+        }
+    });
+}
+
+}
@@ -24,7 +24,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <Kernel/FileSystem/VirtualFileSystem.h>
+#include <Kernel/FileSystem/FileSystem.h>
 #include <Kernel/Process.h>
 #include <Kernel/Tasks/SyncTask.h>
 #include <Kernel/Time/TimeManagement.h>
@@ -37,7 +37,7 @@ void SyncTask::spawn()
     Process::create_kernel_process(syncd_thread, "SyncTask", [] {
         dbgln("SyncTask is running");
         for (;;) {
-            VFS::the().sync();
+            FS::write_back_all();
             (void)Thread::current()->sleep({ 1, 0 });
         }
     });
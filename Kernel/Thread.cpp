@@ -38,6 +38,7 @@
 #include <Kernel/Scheduler.h>
 #include <Kernel/Thread.h>
 #include <Kernel/ThreadTracer.h>
+#include <Kernel/Time/TimeManagement.h>
 #include <Kernel/TimerQueue.h>
 #include <Kernel/VM/MemoryManager.h>
 #include <Kernel/VM/PageDirectory.h>
@@ -146,6 +147,7 @@ Thread::~Thread()
 
         // We shouldn't be queued
         VERIFY(m_runnable_priority < 0);
+        VERIFY(m_runnable_cpu < 0);
     }
     {
         ScopedSpinLock lock(g_tid_map_lock);
@@ -923,9 +925,18 @@ void Thread::set_state(State new_state, u8 stop_signal)
         }
     }
 
+    if (TimeManagement::initialized()) {
+        if (m_state == Runnable) {
+            m_runnable_since_us = TimeManagement::the().uptime_us();
+        } else if (m_state == Running && previous_state == Runnable) {
+            auto now_us = TimeManagement::the().uptime_us();
+            if (now_us > m_runnable_since_us)
+                m_scheduler_latency_us += now_us - m_runnable_since_us;
+        }
+    }
+
     if (m_state == Runnable) {
         Scheduler::queue_runnable_thread(*this);
-        Processor::smp_wake_n_idle_processors(1);
     } else if (m_state == Stopped) {
         // We don't want to restore to Running state, only Runnable!
         m_stop_state = previous_state != Running ? previous_state : Runnable;
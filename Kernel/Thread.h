@@ -455,7 +455,7 @@ public:
             Vector<BlockerInfo, 4> taken_blockers;
             taken_blockers.ensure_capacity(move_count);
             for (size_t i = 0; i < move_count; i++)
-                taken_blockers.append(m_blockers.take(i));
+                taken_blockers.append(m_blockers[i]);
             m_blockers.remove(0, move_count);
             return taken_blockers;
         }
@@ -470,7 +470,7 @@ public:
             }
             m_blockers.ensure_capacity(m_blockers.size() + blockers_to_append.size());
             for (size_t i = 0; i < blockers_to_append.size(); i++)
-                m_blockers.append(blockers_to_append.take(i));
+                m_blockers.append(blockers_to_append[i]);
             blockers_to_append.clear();
         }
 
@@ -1013,11 +1013,45 @@ public:
     unsigned syscall_count() const { return m_syscall_count; }
     void did_syscall() { ++m_syscall_count; }
     unsigned inode_faults() const { return m_inode_faults; }
-    void did_inode_fault() { ++m_inode_faults; }
+    void did_inode_fault()
+    {
+        ++m_inode_faults;
+        ++m_major_faults;
+    }
     unsigned zero_faults() const { return m_zero_faults; }
-    void did_zero_fault() { ++m_zero_faults; }
+    void did_zero_fault()
+    {
+        ++m_zero_faults;
+        ++m_minor_faults;
+    }
     unsigned cow_faults() const { return m_cow_faults; }
-    void did_cow_fault() { ++m_cow_faults; }
+    void did_cow_fault()
+    {
+        ++m_cow_faults;
+        ++m_minor_faults;
+    }
+    // Minor faults are resolved without waiting for a disk, major faults aren't.
+    unsigned minor_faults() const { return m_minor_faults; }
+    void did_minor_fault() { ++m_minor_faults; }
+    unsigned major_faults() const { return m_major_faults; }
+
+    u64 block_io_wait_us() const { return m_block_io_wait_us; }
+    void did_block_io_wait(u64 us) { m_block_io_wait_us += us; }
+
+    // A voluntary context switch is one where the thread gave up the processor because it
+    // blocked, an involuntary one is where it was preempted (or yielded) while still runnable.
+    unsigned voluntary_context_switches() const { return m_voluntary_context_switches; }
+    unsigned involuntary_context_switches() const { return m_involuntary_context_switches; }
+    void did_context_switch_away(bool voluntary)
+    {
+        if (voluntary)
+            ++m_voluntary_context_switches;
+        else
+            ++m_involuntary_context_switches;
+    }
+
+    // Total time spent runnable but waiting for a processor.
+    u64 scheduler_latency_us() const { return m_scheduler_latency_us; }
 
     unsigned file_read_bytes() const { return m_file_read_bytes; }
     unsigned file_write_bytes() const { return m_file_write_bytes; }
@@ -1156,6 +1190,7 @@ private:
 
     IntrusiveListNode m_process_thread_list_node;
     int m_runnable_priority { -1 };
+    int m_runnable_cpu { -1 };
 
     friend class WaitQueue;
 
@@ -1265,6 +1300,13 @@ private:
     unsigned m_inode_faults { 0 };
     unsigned m_zero_faults { 0 };
     unsigned m_cow_faults { 0 };
+    unsigned m_minor_faults { 0 };
+    unsigned m_major_faults { 0 };
+    u64 m_block_io_wait_us { 0 };
+    unsigned m_voluntary_context_switches { 0 };
+    unsigned m_involuntary_context_switches { 0 };
+    u64 m_runnable_since_us { 0 };
+    u64 m_scheduler_latency_us { 0 };
 
     unsigned m_file_read_bytes { 0 };
     unsigned m_file_write_bytes { 0 };
@@ -145,6 +145,18 @@ void APICTimer::disable_local_timer()
     APIC::the().setup_local_timer(0, APIC::TimerMode::OneShot, false);
 }
 
+void APICTimer::set_local_one_shot(u64 nanoseconds)
+{
+    // m_timer_period is the (undivided) APIC timer count of one periodic tick.
+    auto& apic = APIC::the();
+    u64 count = (nanoseconds * m_timer_period * m_frequency) / 1'000'000'000ull;
+    if (count < apic.get_timer_divisor())
+        count = apic.get_timer_divisor();
+    else if (count > 0xffffffffull)
+        count = 0xffffffffull;
+    apic.setup_local_timer((u32)count, APIC::TimerMode::OneShot, true);
+}
+
 size_t APICTimer::ticks_per_second() const
 {
     return m_frequency;
@@ -53,6 +53,9 @@ public:
 
     void enable_local_timer();
     void disable_local_timer();
+    // Replaces the periodic tick on this CPU with a single interrupt after the given time.
+    // enable_local_timer() goes back to the periodic tick.
+    void set_local_one_shot(u64 nanoseconds);
 
 private:
     explicit APICTimer(u8, Function<void(const RegisterState&)>);
@@ -50,6 +50,11 @@ TimeManagement& TimeManagement::the()
     return *s_the;
 }
 
+bool TimeManagement::initialized()
+{
+    return s_the.is_initialized();
+}
+
 bool TimeManagement::is_valid_clock_id(clockid_t clock_id)
 {
     switch (clock_id) {
@@ -92,6 +97,7 @@ void TimeManagement::set_epoch_time(timespec ts)
     InterruptDisabler disabler;
     m_epoch_time = ts;
     m_remaining_epoch_time_adjustment = { 0, 0 };
+    update_time_page();
 }
 
 timespec TimeManagement::monotonic_time(TimePrecision precision) const
@@ -145,6 +151,12 @@ u64 TimeManagement::uptime_ms() const
     return ms;
 }
 
+u64 TimeManagement::uptime_us(TimePrecision precision) const
+{
+    auto mtime = monotonic_time(precision);
+    return mtime.tv_sec * 1000000ull + mtime.tv_nsec / 1000;
+}
+
 UNMAP_AFTER_INIT void TimeManagement::initialize(u32 cpu)
 {
     if (cpu == 0) {
@@ -158,6 +170,16 @@ UNMAP_AFTER_INIT void TimeManagement::initialize(u32 cpu)
         if (auto* apic_timer = APIC::the().initialize_timers(*s_the->m_system_timer)) {
             klog() << "Time: Using APIC timer as system timer";
             s_the->set_system_timer(*apic_timer);
+
+            // Skipping ticks is only safe if the time can be caught up with a counter afterwards.
+            if (kernel_command_line().lookup("nohz").value_or("off") == "on") {
+                if (s_the->m_can_query_precise_time) {
+                    klog() << "Time: Stopping the tick on idle processors";
+                    s_the->m_tick_mode = TickMode::TicklessIdle;
+                } else {
+                    klog() << "Time: nohz=on requires the HPET, keeping periodic ticks";
+                }
+            }
         }
     } else {
         VERIFY(s_the.is_initialized());
@@ -168,6 +190,40 @@ UNMAP_AFTER_INIT void TimeManagement::initialize(u32 cpu)
     }
 }
 
+void TimeManagement::stop_tick_for_idle()
+{
+    VERIFY_INTERRUPTS_DISABLED();
+    VERIFY(m_tick_mode == TickMode::TicklessIdle);
+
+    auto* apic_timer = APIC::the().get_timer();
+    VERIFY(apic_timer);
+
+    u64 sleep_ns = max_tickless_idle_ns;
+    if (auto next_event = TimerQueue::the().next_event_ns(); next_event.has_value()) {
+        auto now = monotonic_time(TimePrecision::Precise);
+        u64 now_ns = (u64)now.tv_sec * 1'000'000'000ull + now.tv_nsec;
+        sleep_ns = next_event.value() > now_ns ? min(next_event.value() - now_ns, sleep_ns) : 0;
+    }
+
+    m_tick_stopped_cpu_mask.fetch_or(1u << Processor::id(), AK::MemoryOrder::memory_order_relaxed);
+    apic_timer->set_local_one_shot(sleep_ns);
+}
+
+void TimeManagement::restart_tick_after_idle()
+{
+    InterruptDisabler disabler;
+    u32 cpu_bit = 1u << Processor::id();
+    if (!(m_tick_stopped_cpu_mask.fetch_and(~cpu_bit, AK::MemoryOrder::memory_order_relaxed) & cpu_bit))
+        return;
+
+    APIC::the().get_timer()->enable_local_timer();
+    if (Processor::id() == 0) {
+        // The coarse clocks haven't moved while we were halted, bring them up to date.
+        ScopedSpinLock lock(m_time_keeping_lock);
+        increment_time_since_boot_hpet();
+    }
+}
+
 void TimeManagement::set_system_timer(HardwareTimerBase& timer)
 {
     VERIFY(Processor::id() == 0); // This should only be called on the BSP!
@@ -189,6 +245,9 @@ time_t TimeManagement::boot_time() const
 
 UNMAP_AFTER_INIT TimeManagement::TimeManagement()
 {
+    m_time_page_region = MM.allocate_kernel_region(PAGE_SIZE, "Time page", Region::Access::Read | Region::Access::Write, AllocationStrategy::AllocateNow);
+    VERIFY(m_time_page_region);
+
     bool probe_non_legacy_hardware_timers = !(kernel_command_line().lookup("time").value_or("modern") == "legacy");
     if (ACPI::is_enabled()) {
         if (!ACPI::Parser::the()->x86_specific_flags().cmos_rtc_not_present) {
@@ -209,6 +268,7 @@ UNMAP_AFTER_INIT TimeManagement::TimeManagement()
     } else if (!probe_and_set_legacy_hardware_timers()) {
         VERIFY_NOT_REACHED();
     }
+    update_time_page();
 }
 
 timeval TimeManagement::now_as_timeval()
@@ -286,9 +346,11 @@ UNMAP_AFTER_INIT bool TimeManagement::probe_and_set_non_legacy_hardware_timers()
     m_system_timer->set_callback([this](const RegisterState& regs) {
         // Update the time. We don't really care too much about the
         // frequency of the interrupt because we'll query the main
-        // counter to get an accurate time.
-        if (Processor::id() == 0) {
+        // counter to get an accurate time. While the BSP's tick is stopped,
+        // whichever processor still takes ticks keeps the time instead.
+        if (Processor::id() == 0 || (m_tick_stopped_cpu_mask.load(AK::MemoryOrder::memory_order_relaxed) & 1)) {
             // TODO: Have the other CPUs call system_timer_tick directly
+            ScopedSpinLock lock(m_time_keeping_lock);
             increment_time_since_boot_hpet();
         }
 
@@ -355,6 +417,8 @@ void TimeManagement::increment_time_since_boot_hpet()
     // TODO: Apply m_remaining_epoch_time_adjustment
     timespec_add(m_epoch_time, { (time_t)(delta_ns / 1000000000), (long)(delta_ns % 1000000000) }, m_epoch_time);
     m_update2.store(update_iteration + 1, AK::MemoryOrder::memory_order_release);
+
+    update_time_page();
 }
 
 void TimeManagement::increment_time_since_boot()
@@ -385,6 +449,28 @@ void TimeManagement::increment_time_since_boot()
         m_ticks_this_second = 0;
     }
     m_update2.store(update_iteration + 1, AK::MemoryOrder::memory_order_release);
+
+    update_time_page();
+}
+
+TimePage& TimeManagement::time_page()
+{
+    return *reinterpret_cast<TimePage*>(m_time_page_region->vaddr().as_ptr());
+}
+
+void TimeManagement::update_time_page()
+{
+    // Only the clocks that time_page_supports() are kept up to date here.
+    ScopedSpinLock lock(m_time_page_lock);
+    auto& page = time_page();
+    u32 update_iteration = AK::atomic_fetch_add(&page.update1, 1u, AK::MemoryOrder::memory_order_acquire);
+    page.clocks[CLOCK_REALTIME] = m_epoch_time;
+    page.clocks[CLOCK_REALTIME_COARSE] = m_epoch_time;
+    if (m_time_ticks_per_second > 0) {
+        u64 ns = ((u64)m_ticks_this_second * 1000000000ull) / m_time_ticks_per_second;
+        page.clocks[CLOCK_MONOTONIC_COARSE] = { (long)m_seconds_since_boot, (long)ns };
+    }
+    AK::atomic_store(&page.update2, update_iteration + 1, AK::MemoryOrder::memory_order_release);
 }
 
 void TimeManagement::system_timer_tick(const RegisterState& regs)
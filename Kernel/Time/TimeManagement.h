@@ -27,9 +27,12 @@
 #pragma once
 
 #include <AK/NonnullRefPtrVector.h>
+#include <AK/OwnPtr.h>
 #include <AK/RefPtr.h>
 #include <AK/Types.h>
+#include <Kernel/API/TimePage.h>
 #include <Kernel/KResult.h>
+#include <Kernel/SpinLock.h>
 #include <Kernel/UnixTypes.h>
 
 namespace Kernel {
@@ -37,12 +40,20 @@ namespace Kernel {
 #define OPTIMAL_TICKS_PER_SECOND_RATE 250
 
 class HardwareTimerBase;
+class Region;
 
 enum class TimePrecision {
     Coarse = 0,
     Precise
 };
 
+enum class TickMode {
+    // Every CPU takes a scheduler tick at a fixed rate, idle or not.
+    Periodic = 0,
+    // Idle CPUs stop their tick and only wake up for the next timer deadline (or an interrupt).
+    TicklessIdle
+};
+
 class TimeManagement {
     AK_MAKE_ETERNAL;
 
@@ -75,6 +86,7 @@ public:
     static bool is_hpet_periodic_mode_allowed();
 
     u64 uptime_ms() const;
+    u64 uptime_us(TimePrecision = TimePrecision::Precise) const;
     static timeval now_as_timeval();
 
     timespec remaining_epoch_time_adjustment() const { return m_remaining_epoch_time_adjustment; }
@@ -82,7 +94,18 @@ public:
 
     bool can_query_precise_time() const { return m_can_query_precise_time; }
 
+    TickMode tick_mode() const { return m_tick_mode; }
+    // Called by the idle loop with interrupts disabled, right before halting.
+    void stop_tick_for_idle();
+    void restart_tick_after_idle();
+
+    // Mapped read-only into every process by execve().
+    Region& time_page_region() { return *m_time_page_region; }
+
 private:
+    TimePage& time_page();
+    void update_time_page();
+
     bool probe_and_set_legacy_hardware_timers();
     bool probe_and_set_non_legacy_hardware_timers();
     Vector<HardwareTimerBase*> scan_and_initialize_periodic_timers();
@@ -102,8 +125,18 @@ private:
     u32 m_time_ticks_per_second { 0 }; // may be different from interrupts/second (e.g. hpet)
     bool m_can_query_precise_time { false };
 
+    // The longest an idle CPU sleeps without a tick, keeping HPET counter wraps detectable.
+    static constexpr u64 max_tickless_idle_ns = 1'000'000'000;
+    TickMode m_tick_mode { TickMode::Periodic };
+    Atomic<u32> m_tick_stopped_cpu_mask { 0 };
+    // Serializes time keeping, which moves off the BSP while its tick is stopped.
+    SpinLock<u8> m_time_keeping_lock;
+
     RefPtr<HardwareTimerBase> m_system_timer;
     RefPtr<HardwareTimerBase> m_time_keeper_timer;
+
+    OwnPtr<Region> m_time_page_region;
+    SpinLock<u8> m_time_page_lock;
 };
 
 }
@@ -87,19 +87,45 @@ TimerQueue& TimerQueue::the()
 UNMAP_AFTER_INIT TimerQueue::TimerQueue()
 {
     m_ticks_per_second = TimeManagement::the().ticks_per_second();
+    m_wheel.current_tick = time_to_ns(TimeManagement::the().monotonic_time(TimePrecision::Coarse)) / wheel_tick_ns;
 }
 
-RefPtr<Timer> TimerQueue::add_timer_without_id(clockid_t clock_id, const timespec& deadline, Function<void()>&& callback)
+bool TimerQueue::is_monotonic(const Timer& timer)
 {
-    if (deadline <= TimeManagement::the().current_time(clock_id).value())
+    switch (timer.m_clock_id) {
+    case CLOCK_MONOTONIC:
+    case CLOCK_MONOTONIC_COARSE:
+    case CLOCK_MONOTONIC_RAW:
+        return true;
+    case CLOCK_REALTIME:
+    case CLOCK_REALTIME_COARSE:
+        return false;
+    default:
+        VERIFY_NOT_REACHED();
+    }
+}
+
+RefPtr<Timer> TimerQueue::add_timer_without_id(clockid_t clock_id, const timespec& deadline, Function<void()>&& callback, const timespec& slack)
+{
+    auto now = TimeManagement::the().current_time(clock_id).value();
+    if (deadline <= now)
         return {};
 
+    u64 slack_ns = time_to_ns(slack);
+    if (clock_id == CLOCK_MONOTONIC_COARSE || clock_id == CLOCK_REALTIME_COARSE) {
+        // Callers asking for a coarse clock don't care about precision, so let the
+        // timer fire up to 1/32 of its duration late if that lets it share a tick.
+        timespec duration;
+        timespec_sub(deadline, now, duration);
+        slack_ns = max(slack_ns, time_to_ns(duration) / 32);
+    }
+
     // Because timer handlers can execute on any processor and there is
     // a race between executing a timer handler and cancel_timer() this
     // *must* be a RefPtr<Timer>. Otherwise calling cancel_timer() could
     // inadvertently cancel another timer that has been created between
     // returning from the timer handler and a call to cancel_timer().
-    auto timer = adopt(*new Timer(clock_id, time_to_ns(deadline), move(callback)));
+    auto timer = adopt(*new Timer(clock_id, time_to_ns(deadline), move(callback), slack_ns));
 
     ScopedSpinLock lock(g_timerqueue_lock);
     timer->m_id = 0; // Don't generate a timer id
@@ -119,32 +145,77 @@ TimerId TimerQueue::add_timer(NonnullRefPtr<Timer>&& timer)
 
 void TimerQueue::add_timer_locked(NonnullRefPtr<Timer> timer)
 {
-    u64 timer_expiration = timer->m_expires;
-
     VERIFY(!timer->is_queued());
 
-    auto& queue = queue_for_timer(*timer);
-    if (queue.list.is_empty()) {
-        queue.list.append(&timer.leak_ref());
-        queue.next_timer_due = timer_expiration;
-    } else {
-        Timer* following_timer = nullptr;
-        queue.list.for_each([&](Timer& t) {
-            if (t.m_expires > timer_expiration) {
-                following_timer = &t;
-                return IterationDecision::Break;
-            }
-            return IterationDecision::Continue;
-        });
-        if (following_timer) {
-            bool next_timer_needs_update = queue.list.head() == following_timer;
-            queue.list.insert_before(following_timer, &timer.leak_ref());
-            if (next_timer_needs_update)
-                queue.next_timer_due = timer_expiration;
-        } else {
-            queue.list.append(&timer.leak_ref());
+    auto& leaked_timer = timer.leak_ref();
+    leaked_timer.set_queued(true);
+    if (!is_monotonic(leaked_timer)) {
+        add_to_queue(leaked_timer);
+        return;
+    }
+
+    // The timer fires on the first tick strictly after its deadline. If it allows
+    // some slack, pick the tick with the most trailing zero bits within that window,
+    // so timers with similar deadlines end up sharing a slot.
+    u64 earliest_tick = leaked_timer.m_expires / wheel_tick_ns + 1;
+    u64 latest_tick = (leaked_timer.m_expires + leaked_timer.m_slack) / wheel_tick_ns + 1;
+    u64 expires_tick = earliest_tick;
+    for (u64 alignment = 2; alignment != 0 && alignment <= latest_tick; alignment <<= 1) {
+        u64 aligned_tick = (earliest_tick + alignment - 1) & ~(alignment - 1);
+        if (aligned_tick > latest_tick)
+            break;
+        expires_tick = aligned_tick;
+    }
+
+    // The wheel may be behind if fire() hasn't caught up yet; anything already
+    // due goes into the next slot to be processed.
+    leaked_timer.m_expires_tick = max(expires_tick, m_wheel.current_tick + 1);
+    add_to_wheel(leaked_timer);
+}
+
+void TimerQueue::add_to_wheel(Timer& timer)
+{
+    VERIFY(g_timerqueue_lock.is_locked());
+    VERIFY(!timer.m_list);
+
+    // While cascading, a timer may be due in exactly the tick being processed.
+    u64 expires_tick = max(timer.m_expires_tick, m_wheel.current_tick);
+    u64 delta = expires_tick - m_wheel.current_tick;
+
+    InlineLinkedList<Timer>* list = &m_wheel.overflow;
+    for (size_t level = 0; level < wheel_levels; ++level) {
+        if (delta < (1ull << (wheel_level_bits * (level + 1)))) {
+            list = &m_wheel.slots[level][(expires_tick >> (wheel_level_bits * level)) & (wheel_slots - 1)];
+            ++m_wheel.timer_count[level];
+            break;
         }
     }
+    if (list == &m_wheel.overflow)
+        ++m_wheel.timer_count[wheel_levels];
+
+    list->append(&timer);
+    timer.m_list = list;
+}
+
+void TimerQueue::add_to_queue(Timer& timer)
+{
+    VERIFY(g_timerqueue_lock.is_locked());
+    VERIFY(!timer.m_list);
+
+    auto& list = m_timer_queue_realtime.list;
+    Timer* following_timer = nullptr;
+    list.for_each([&](Timer& t) {
+        if (t.m_expires > timer.m_expires) {
+            following_timer = &t;
+            return IterationDecision::Break;
+        }
+        return IterationDecision::Continue;
+    });
+    if (following_timer)
+        list.insert_before(following_timer, &timer);
+    else
+        list.append(&timer);
+    timer.m_list = &list;
 }
 
 TimerId TimerQueue::add_timer(clockid_t clock_id, timeval& deadline, Function<void()>&& callback)
@@ -154,30 +225,35 @@ TimerId TimerQueue::add_timer(clockid_t clock_id, timeval& deadline, Function<vo
     return add_timer(adopt(*new Timer(clock_id, time_to_ns(expires), move(callback))));
 }
 
-bool TimerQueue::cancel_timer(TimerId id)
+Timer* TimerQueue::find_queued_timer(TimerId id)
 {
     Timer* found_timer = nullptr;
-    Queue* timer_queue = nullptr;
-
-    ScopedSpinLock lock(g_timerqueue_lock);
-    if (m_timer_queue_monotonic.list.for_each([&](Timer& timer) {
-            if (timer.m_id == id) {
-                found_timer = &timer;
-                timer_queue = &m_timer_queue_monotonic;
-                return IterationDecision::Break;
-            }
-            return IterationDecision::Continue;
-        })
-        != IterationDecision::Break) {
-        m_timer_queue_realtime.list.for_each([&](Timer& timer) {
+    auto find_in = [&](InlineLinkedList<Timer>& list) {
+        list.for_each([&](Timer& timer) {
             if (timer.m_id == id) {
                 found_timer = &timer;
-                timer_queue = &m_timer_queue_realtime;
                 return IterationDecision::Break;
             }
             return IterationDecision::Continue;
         });
+        return found_timer != nullptr;
+    };
+
+    for (auto& level : m_wheel.slots) {
+        for (auto& slot : level) {
+            if (find_in(slot))
+                return found_timer;
+        }
     }
+    if (find_in(m_wheel.overflow) || find_in(m_timer_queue_realtime.list))
+        return found_timer;
+    return nullptr;
+}
+
+bool TimerQueue::cancel_timer(TimerId id)
+{
+    ScopedSpinLock lock(g_timerqueue_lock);
+    auto* found_timer = find_queued_timer(id);
 
     if (!found_timer) {
         // The timer may be executing right now, if it is then it should
@@ -202,17 +278,14 @@ bool TimerQueue::cancel_timer(TimerId id)
         return false;
     }
 
-    VERIFY(found_timer);
-    VERIFY(timer_queue);
-    remove_timer_locked(*timer_queue, *found_timer);
+    remove_timer_locked(*found_timer);
     return true;
 }
 
 bool TimerQueue::cancel_timer(Timer& timer)
 {
-    auto& timer_queue = queue_for_timer(timer);
     ScopedSpinLock lock(g_timerqueue_lock);
-    if (!timer_queue.list.contains_slow(&timer)) {
+    if (!timer.m_list) {
         // The timer may be executing right now, if it is then it should
         // be in m_timers_executing. If it is then release the lock
         // briefly to allow it to finish by removing itself
@@ -232,74 +305,178 @@ bool TimerQueue::cancel_timer(Timer& timer)
     }
 
     VERIFY(timer.ref_count() > 1);
-    remove_timer_locked(timer_queue, timer);
+    remove_timer_locked(timer);
     return true;
 }
 
-void TimerQueue::remove_timer_locked(Queue& queue, Timer& timer)
+size_t TimerQueue::wheel_level_of(const InlineLinkedList<Timer>* list) const
+{
+    auto* first_slot = &m_wheel.slots[0][0];
+    if (list >= first_slot && list < first_slot + wheel_levels * wheel_slots)
+        return (list - first_slot) / wheel_slots;
+    VERIFY(list == &m_wheel.overflow);
+    return wheel_levels;
+}
+
+void TimerQueue::unlink_timer(Timer& timer)
+{
+    VERIFY(g_timerqueue_lock.is_locked());
+    VERIFY(timer.m_list);
+
+    if (timer.m_list != &m_timer_queue_realtime.list)
+        --m_wheel.timer_count[wheel_level_of(timer.m_list)];
+    timer.m_list->remove(&timer);
+    timer.m_list = nullptr;
+}
+
+void TimerQueue::remove_timer_locked(Timer& timer)
 {
-    bool was_next_timer = (queue.list.head() == &timer);
-    queue.list.remove(&timer);
+    unlink_timer(timer);
     timer.set_queued(false);
     auto now = timer.now(false);
     if (timer.m_expires > now)
         timer.m_remaining = timer.m_expires - now;
 
-    if (was_next_timer)
-        update_next_timer_due(queue);
     // Whenever we remove a timer that was still queued (but hasn't been
     // fired) we added a reference to it. So, when removing it from the
     // queue we need to drop that reference.
     timer.unref();
 }
 
-void TimerQueue::fire()
+void TimerQueue::cascade(InlineLinkedList<Timer>& list)
 {
-    ScopedSpinLock lock(g_timerqueue_lock);
+    // Detach the whole list first, timers that are still far out may end up right back in it.
+    InlineLinkedList<Timer> pending;
+    pending.append(list);
+    auto level = wheel_level_of(&list);
+    while (auto* timer = pending.remove_head()) {
+        --m_wheel.timer_count[level];
+        timer->m_list = nullptr;
+        add_to_wheel(*timer);
+    }
+}
 
-    auto fire_timers = [&](Queue& queue) {
-        auto* timer = queue.list.head();
-        VERIFY(timer);
-        VERIFY(queue.next_timer_due == timer->m_expires);
+void TimerQueue::execute_timer(Timer& timer, ScopedSpinLock<SpinLock<u8>>& lock)
+{
+    unlink_timer(timer);
+    timer.set_queued(false);
+    m_timers_executing.append(&timer);
 
-        while (timer && timer->now(true) > timer->m_expires) {
-            queue.list.remove(timer);
-            timer->set_queued(false);
+    lock.unlock();
 
-            m_timers_executing.append(timer);
+    // Defer executing the timer outside of the irq handler
+    Processor::current().deferred_call_queue([this, &timer]() {
+        timer.m_callback();
+        ScopedSpinLock lock(g_timerqueue_lock);
+        m_timers_executing.remove(&timer);
+        // Drop the reference we added when queueing the timer
+        timer.unref();
+    });
 
-            update_next_timer_due(queue);
+    lock.lock();
+}
 
-            lock.unlock();
+void TimerQueue::process_wheel_tick(u64 tick, ScopedSpinLock<SpinLock<u8>>& lock)
+{
+    m_wheel.current_tick = tick;
+
+    // Move timers down from every level whose slot boundary we just reached,
+    // starting with the highest one so they can trickle down all the way.
+    size_t cascade_levels = 0;
+    while (cascade_levels < wheel_levels && (tick & ((1ull << (wheel_level_bits * (cascade_levels + 1))) - 1)) == 0)
+        ++cascade_levels;
+    if (cascade_levels == wheel_levels)
+        cascade(m_wheel.overflow);
+    for (size_t level = min(cascade_levels, wheel_levels - 1); level > 0; --level)
+        cascade(m_wheel.slots[level][(tick >> (wheel_level_bits * level)) & (wheel_slots - 1)]);
+
+    auto& slot = m_wheel.slots[0][tick & (wheel_slots - 1)];
+    while (auto* timer = slot.head()) {
+        if (timer->now(true) <= timer->m_expires) {
+            // This clock hasn't quite reached the deadline yet (e.g. CLOCK_MONOTONIC_RAW),
+            // so check again on the next tick.
+            unlink_timer(*timer);
+            timer->m_expires_tick = tick + 1;
+            add_to_wheel(*timer);
+            continue;
+        }
+        execute_timer(*timer, lock);
+    }
+}
 
-            // Defer executing the timer outside of the irq handler
-            Processor::current().deferred_call_queue([this, timer]() {
-                timer->m_callback();
-                ScopedSpinLock lock(g_timerqueue_lock);
-                m_timers_executing.remove(timer);
-                // Drop the reference we added when queueing the timer
-                timer->unref();
-            });
+Optional<u64> TimerQueue::next_event_ns()
+{
+    ScopedSpinLock lock(g_timerqueue_lock);
 
-            lock.lock();
-            timer = queue.list.head();
+    // For each level, the next slot to be reached is either due (level 0) or cascaded
+    // at its block boundary, which is never later than the timers it contains.
+    Optional<u64> next_tick;
+    for (size_t level = 0; level < wheel_levels; ++level) {
+        if (m_wheel.timer_count[level] == 0)
+            continue;
+        size_t shift = wheel_level_bits * level;
+        u64 current_block = m_wheel.current_tick >> shift;
+        for (u64 block = current_block + 1; block <= current_block + wheel_slots; ++block) {
+            if (!m_wheel.slots[level][block & (wheel_slots - 1)].is_empty()) {
+                u64 tick = block << shift;
+                if (!next_tick.has_value() || tick < next_tick.value())
+                    next_tick = tick;
+                break;
+            }
         }
-    };
+    }
+    if (m_wheel.timer_count[wheel_levels] != 0) {
+        size_t shift = wheel_level_bits * wheel_levels;
+        u64 tick = ((m_wheel.current_tick >> shift) + 1) << shift;
+        if (!next_tick.has_value() || tick < next_tick.value())
+            next_tick = tick;
+    }
 
-    if (!m_timer_queue_monotonic.list.is_empty())
-        fire_timers(m_timer_queue_monotonic);
-    if (!m_timer_queue_realtime.list.is_empty())
-        fire_timers(m_timer_queue_realtime);
+    Optional<u64> next_ns;
+    if (next_tick.has_value())
+        next_ns = next_tick.value() * wheel_tick_ns;
+
+    if (auto* timer = m_timer_queue_realtime.list.head()) {
+        // Translate the realtime deadline onto the monotonic clock.
+        u64 monotonic_now = time_to_ns(TimeManagement::the().monotonic_time(TimePrecision::Coarse));
+        u64 realtime_now = timer->now(true);
+        u64 due = monotonic_now + (timer->m_expires > realtime_now ? timer->m_expires - realtime_now : 0);
+        if (!next_ns.has_value() || due < next_ns.value())
+            next_ns = due;
+    }
+    return next_ns;
 }
 
-void TimerQueue::update_next_timer_due(Queue& queue)
+void TimerQueue::fire()
 {
-    VERIFY(g_timerqueue_lock.is_locked());
+    ScopedSpinLock lock(g_timerqueue_lock);
 
-    if (auto* next_timer = queue.list.head())
-        queue.next_timer_due = next_timer->m_expires;
-    else
-        queue.next_timer_due = 0;
+    u64 now_tick = time_to_ns(TimeManagement::the().monotonic_time(TimePrecision::Coarse)) / wheel_tick_ns;
+    while (m_wheel.current_tick < now_tick) {
+        // Skip straight to the next tick that could have anything to do: if the lowest
+        // levels are empty, only the next boundary of the first populated level matters.
+        size_t first_populated_level = 0;
+        while (first_populated_level <= wheel_levels && m_wheel.timer_count[first_populated_level] == 0)
+            ++first_populated_level;
+        if (first_populated_level > wheel_levels) {
+            m_wheel.current_tick = now_tick;
+            break;
+        }
+        size_t shift = wheel_level_bits * first_populated_level;
+        u64 next_tick = ((m_wheel.current_tick >> shift) + 1) << shift;
+        if (next_tick > now_tick) {
+            m_wheel.current_tick = now_tick;
+            break;
+        }
+        process_wheel_tick(next_tick, lock);
+    }
+
+    auto& realtime_list = m_timer_queue_realtime.list;
+    while (auto* timer = realtime_list.head()) {
+        if (timer->now(true) <= timer->m_expires)
+            break;
+        execute_timer(*timer, lock);
+    }
 }
 
 }
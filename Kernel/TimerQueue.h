@@ -29,8 +29,10 @@
 #include <AK/Function.h>
 #include <AK/InlineLinkedList.h>
 #include <AK/NonnullRefPtr.h>
+#include <AK/Optional.h>
 #include <AK/OwnPtr.h>
 #include <AK/RefCounted.h>
+#include <Kernel/SpinLock.h>
 #include <Kernel/Time/TimeManagement.h>
 
 namespace Kernel {
@@ -43,9 +45,10 @@ class Timer : public RefCounted<Timer>
     friend class InlineLinkedListNode<Timer>;
 
 public:
-    Timer(clockid_t clock_id, u64 expires, Function<void()>&& callback)
+    Timer(clockid_t clock_id, u64 expires, Function<void()>&& callback, u64 slack = 0)
         : m_clock_id(clock_id)
         , m_expires(expires)
+        , m_slack(slack)
         , m_callback(move(callback))
     {
     }
@@ -60,10 +63,15 @@ private:
     TimerId m_id;
     clockid_t m_clock_id;
     u64 m_expires;
+    // How much later than m_expires this timer may fire, so it can be batched with others.
+    u64 m_slack { 0 };
     u64 m_remaining { 0 };
     Function<void()> m_callback;
     Timer* m_next { nullptr };
     Timer* m_prev { nullptr };
+    // The timer wheel slot or queue list this timer is currently linked into.
+    InlineLinkedList<Timer>* m_list { nullptr };
+    u64 m_expires_tick { 0 };
     Atomic<bool, AK::MemoryOrder::memory_order_relaxed> m_queued { false };
 
     bool operator<(const Timer& rhs) const
@@ -91,7 +99,7 @@ public:
     static TimerQueue& the();
 
     TimerId add_timer(NonnullRefPtr<Timer>&&);
-    RefPtr<Timer> add_timer_without_id(clockid_t, const timespec&, Function<void()>&&);
+    RefPtr<Timer> add_timer_without_id(clockid_t, const timespec&, Function<void()>&&, const timespec& slack = {});
     TimerId add_timer(clockid_t, timeval& timeout, Function<void()>&& callback);
     bool cancel_timer(TimerId id);
     bool cancel_timer(Timer&);
@@ -101,33 +109,48 @@ public:
     }
     void fire();
 
+    // Monotonic time (in ns) at which fire() will next have something to do, if any timers are pending.
+    Optional<u64> next_event_ns();
+
 private:
+    // Monotonic timers live in a hierarchical timing wheel: each level has wheel_slots slots,
+    // a slot on level N spanning wheel_slots^N ticks. Timers are added to and removed from
+    // their slot in constant time, and are moved down a level whenever the wheel reaches
+    // their slot on the level above.
+    static constexpr u64 wheel_tick_ns = 1'000'000;
+    static constexpr size_t wheel_level_bits = 6;
+    static constexpr size_t wheel_slots = 1 << wheel_level_bits;
+    static constexpr size_t wheel_levels = 4;
+
+    struct TimerWheel {
+        InlineLinkedList<Timer> slots[wheel_levels][wheel_slots];
+        // Timers beyond the last level, brought back in whenever the last level wraps around.
+        InlineLinkedList<Timer> overflow;
+        // Number of timers on each level, the last entry counting the overflow list.
+        size_t timer_count[wheel_levels + 1] {};
+        u64 current_tick { 0 };
+    };
+
+    // Realtime timers are kept sorted by deadline, because the clock can be set at any time.
     struct Queue {
         InlineLinkedList<Timer> list;
-        u64 next_timer_due { 0 };
     };
-    void remove_timer_locked(Queue&, Timer&);
-    void update_next_timer_due(Queue&);
-    void add_timer_locked(NonnullRefPtr<Timer>);
 
-    Queue& queue_for_timer(Timer& timer)
-    {
-        switch (timer.m_clock_id) {
-        case CLOCK_MONOTONIC:
-        case CLOCK_MONOTONIC_COARSE:
-        case CLOCK_MONOTONIC_RAW:
-            return m_timer_queue_monotonic;
-        case CLOCK_REALTIME:
-        case CLOCK_REALTIME_COARSE:
-            return m_timer_queue_realtime;
-        default:
-            VERIFY_NOT_REACHED();
-        }
-    }
+    static bool is_monotonic(const Timer&);
+    void remove_timer_locked(Timer&);
+    void add_timer_locked(NonnullRefPtr<Timer>);
+    void add_to_wheel(Timer&);
+    void add_to_queue(Timer&);
+    void unlink_timer(Timer&);
+    size_t wheel_level_of(const InlineLinkedList<Timer>*) const;
+    void cascade(InlineLinkedList<Timer>&);
+    void process_wheel_tick(u64 tick, ScopedSpinLock<SpinLock<u8>>&);
+    void execute_timer(Timer&, ScopedSpinLock<SpinLock<u8>>&);
+    Timer* find_queued_timer(TimerId);
 
     u64 m_timer_id_count { 0 };
     u64 m_ticks_per_second { 0 };
-    Queue m_timer_queue_monotonic;
+    TimerWheel m_wheel;
     Queue m_timer_queue_realtime;
     InlineLinkedList<Timer> m_timers_executing;
 };
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Kernel/PerformanceEventBuffer.h>
+#include <Kernel/Process.h>
+#include <Kernel/Thread.h>
+#include <Kernel/Tracepoint.h>
+
+namespace Kernel {
+
+u32 g_enabled_tracepoints { 0 };
+
+void set_tracepoints_enabled(bool enabled)
+{
+    u32 mask = enabled ? (1u << (u8)Tracepoint::__Count) - 1 : 0;
+    AK::atomic_store(&g_enabled_tracepoints, mask, AK::MemoryOrder::memory_order_relaxed);
+}
+
+static int perf_event_type_for(Tracepoint tracepoint)
+{
+    switch (tracepoint) {
+#define __ENUMERATE_TRACEPOINT(name, event_type) \
+    case Tracepoint::name:                       \
+        return event_type;
+        ENUMERATE_TRACEPOINTS
+#undef __ENUMERATE_TRACEPOINT
+    default:
+        VERIFY_NOT_REACHED();
+    }
+}
+
+void emit_tracepoint(Tracepoint tracepoint, FlatPtr arg1, FlatPtr arg2)
+{
+    auto* current_thread = Thread::current();
+    if (!current_thread)
+        return;
+    auto& process = current_thread->process();
+    if (!process.is_profiling() || !process.perf_events())
+        return;
+    [[maybe_unused]] auto rc = process.perf_events()->append(perf_event_type_for(tracepoint), arg1, arg2);
+}
+
+}
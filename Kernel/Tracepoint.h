@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/Types.h>
+#include <Kernel/UnixTypes.h>
+
+namespace Kernel {
+
+// Every tracepoint, with the perf event it records and what its two arguments mean.
+//
+// ContextSwitch: tid of the thread being switched to, 0
+// PageFault:     faulting address, page fault flags (userspace faults only)
+// DiskRequest:   first block index, block count with disk_request_write_flag set for writes
+// SyscallEntry:  syscall function, 0
+// SyscallExit:   syscall function, return value
+#define ENUMERATE_TRACEPOINTS                                        \
+    __ENUMERATE_TRACEPOINT(ContextSwitch, PERF_EVENT_CONTEXT_SWITCH) \
+    __ENUMERATE_TRACEPOINT(PageFault, PERF_EVENT_PAGE_FAULT)         \
+    __ENUMERATE_TRACEPOINT(DiskRequest, PERF_EVENT_DISK_REQUEST)     \
+    __ENUMERATE_TRACEPOINT(SyscallEntry, PERF_EVENT_SYSCALL_ENTRY)   \
+    __ENUMERATE_TRACEPOINT(SyscallExit, PERF_EVENT_SYSCALL_EXIT)
+
+enum class Tracepoint : u8 {
+#define __ENUMERATE_TRACEPOINT(name, event_type) name,
+    ENUMERATE_TRACEPOINTS
+#undef __ENUMERATE_TRACEPOINT
+        __Count
+};
+
+static constexpr FlatPtr disk_request_write_flag = (FlatPtr)1 << (sizeof(FlatPtr) * 8 - 1);
+
+// One bit per Tracepoint. Tracepoints are enabled while any process is being profiled.
+extern u32 g_enabled_tracepoints;
+
+ALWAYS_INLINE bool is_tracepoint_enabled(Tracepoint tracepoint)
+{
+    return AK::atomic_load(&g_enabled_tracepoints, AK::MemoryOrder::memory_order_relaxed) & (1u << (u8)tracepoint);
+}
+
+void set_tracepoints_enabled(bool);
+
+// Records the event into the current process' perf events, if it is being profiled.
+[[gnu::cold]] void emit_tracepoint(Tracepoint, FlatPtr arg1, FlatPtr arg2);
+
+// A disabled tracepoint costs a single predicted-not-taken branch.
+#define TRACEPOINT(name, arg1, arg2)                                                                 \
+    do {                                                                                             \
+        if (__builtin_expect(::Kernel::is_tracepoint_enabled(::Kernel::Tracepoint::name), 0))        \
+            ::Kernel::emit_tracepoint(::Kernel::Tracepoint::name, (FlatPtr)(arg1), (FlatPtr)(arg2)); \
+    } while (0)
+
+}
@@ -68,6 +68,18 @@ enum {
 #define PERF_EVENT_SAMPLE 0
 #define PERF_EVENT_MALLOC 1
 #define PERF_EVENT_FREE 2
+#define PERF_EVENT_CONTEXT_SWITCH 3
+#define PERF_EVENT_PAGE_FAULT 4
+#define PERF_EVENT_DISK_REQUEST 5
+#define PERF_EVENT_SYSCALL_ENTRY 6
+#define PERF_EVENT_SYSCALL_EXIT 7
+
+// What drives the samples of a profile, see profiling_enable().
+#define PROFILING_SAMPLE_TIMER 0
+#define PROFILING_SAMPLE_CYCLES 1
+#define PROFILING_SAMPLE_INSTRUCTIONS 2
+#define PROFILING_SAMPLE_CACHE_MISSES 3
+#define PROFILING_SAMPLE_BRANCH_MISSES 4
 
 #define WNOHANG 1
 #define WUNTRACED 2
@@ -97,15 +109,23 @@ enum {
 #define MAP_STACK 0x40
 #define MAP_NORESERVE 0x80
 #define MAP_RANDOMIZED 0x100
+#define MAP_HUGETLB 0x200
+#define MAP_POPULATE 0x400
 
 #define PROT_READ 0x1
 #define PROT_WRITE 0x2
 #define PROT_EXEC 0x4
 #define PROT_NONE 0x0
 
+#define MADV_NORMAL 0x0
+#define MADV_RANDOM 0x1
+#define MADV_SEQUENTIAL 0x2
+#define MADV_WILLNEED 0x3
+#define MADV_DONTNEED 0x4
 #define MADV_SET_VOLATILE 0x100
 #define MADV_SET_NONVOLATILE 0x200
 #define MADV_GET_VOLATILE 0x400
+#define MADV_SHARE_IDENTICAL 0x800
 
 #define F_DUPFD 0
 #define F_GETFD 1
@@ -113,6 +133,8 @@ enum {
 #define F_GETFL 3
 #define F_SETFL 4
 #define F_ISTTY 5
+#define F_SETPIPE_SZ 6
+#define F_GETPIPE_SZ 7
 
 #define FD_CLOEXEC 1
 
@@ -482,6 +504,79 @@ struct pollfd {
     short revents;
 };
 
+#define EPOLLIN (1u << 0)
+#define EPOLLPRI (1u << 1)
+#define EPOLLOUT (1u << 2)
+#define EPOLLERR (1u << 3)
+#define EPOLLHUP (1u << 4)
+#define EPOLLRDHUP (1u << 13)
+#define EPOLLONESHOT (1u << 30)
+#define EPOLLET (1u << 31)
+
+#define EPOLL_CTL_ADD 1
+#define EPOLL_CTL_DEL 2
+#define EPOLL_CTL_MOD 3
+
+#define EPOLL_CLOEXEC O_CLOEXEC
+
+typedef union epoll_data {
+    void* ptr;
+    int fd;
+    uint32_t u32;
+    uint64_t u64;
+} epoll_data_t;
+
+struct epoll_event {
+    uint32_t events;
+    epoll_data_t data;
+};
+
+#define IO_RING_OP_NOP 0
+#define IO_RING_OP_READ 1
+#define IO_RING_OP_WRITE 2
+#define IO_RING_OP_ACCEPT 3
+#define IO_RING_OP_RECV 4
+#define IO_RING_OP_SEND 5
+#define IO_RING_OP_FSYNC 6
+
+#define IO_RING_CLOEXEC O_CLOEXEC
+#define IO_RING_MAX_ENTRIES 4096
+#define IO_RING_CURRENT_OFFSET ((uint64_t)-1)
+
+struct io_ring_sqe {
+    uint8_t opcode;
+    uint8_t reserved[3];
+    int32_t fd;
+    uint64_t offset;
+    uint64_t addr;
+    uint32_t len;
+    uint32_t msg_flags;
+    uint64_t user_data;
+};
+
+struct io_ring_cqe {
+    uint64_t user_data;
+    int32_t result;
+    uint32_t reserved;
+};
+
+struct io_ring_header {
+    uint32_t sq_head;
+    uint32_t sq_tail;
+    uint32_t sq_mask;
+    uint32_t cq_head;
+    uint32_t cq_tail;
+    uint32_t cq_mask;
+};
+
+struct io_ring_params {
+    uint32_t sq_entries;
+    uint32_t cq_entries;
+    uint32_t sqes_offset;
+    uint32_t cqes_offset;
+    uint32_t ring_size;
+};
+
 #define AF_MASK 0xff
 #define AF_UNSPEC 0
 #define AF_LOCAL 1
@@ -504,6 +599,7 @@ struct pollfd {
 #define MSG_TRUNC 0x1
 #define MSG_CTRUNC 0x2
 #define MSG_DONTWAIT 0x40
+#define MSG_WAITFORONE 0x10000
 
 #define SOL_SOCKET 1
 
@@ -532,6 +628,9 @@ enum {
 
 #define IP_TTL 2
 
+#define TCP_NODELAY 10
+#define TCP_CORK 11
+
 struct ucred {
     pid_t pid;
     uid_t uid;
@@ -627,6 +726,11 @@ struct msghdr {
     int msg_flags;
 };
 
+struct mmsghdr {
+    struct msghdr msg_hdr;
+    unsigned int msg_len;
+};
+
 struct sched_param {
     int sched_priority;
 };
@@ -680,6 +784,7 @@ struct rtentry {
 #define RTF_GATEWAY 0x2 /* the route is a gateway and not an end host */
 
 #define AT_FDCWD -100
+#define AT_SYMLINK_NOFOLLOW 0x100
 
 #define PURGE_ALL_VOLATILE 0x1
 #define PURGE_ALL_CLEAN_INODE 0x2
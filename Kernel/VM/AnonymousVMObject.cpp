@@ -24,6 +24,8 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Array.h>
+#include <AK/ScopeGuard.h>
 #include <Kernel/Arch/x86/SmapDisabler.h>
 #include <Kernel/Debug.h>
 #include <Kernel/Process.h>
@@ -86,6 +88,11 @@ NonnullRefPtr<AnonymousVMObject> AnonymousVMObject::create_with_physical_page(Ph
     return adopt(*new AnonymousVMObject(page));
 }
 
+NonnullRefPtr<AnonymousVMObject> AnonymousVMObject::create_with_physical_pages(const NonnullRefPtrVector<PhysicalPage>& pages)
+{
+    return adopt(*new AnonymousVMObject(pages));
+}
+
 RefPtr<AnonymousVMObject> AnonymousVMObject::create_for_physical_range(PhysicalAddress paddr, size_t size)
 {
     if (paddr.offset(size) < paddr) {
@@ -99,6 +106,7 @@ AnonymousVMObject::AnonymousVMObject(size_t size, AllocationStrategy strategy)
     : VMObject(size)
     , m_volatile_ranges_cache({ 0, page_count() })
     , m_unused_committed_pages(strategy == AllocationStrategy::Reserve ? page_count() : 0)
+    , m_may_evict_pages(true)
 {
     if (strategy == AllocationStrategy::AllocateNow) {
         // Allocate all pages right now. We know we can get all because we committed the amount needed
@@ -127,6 +135,14 @@ AnonymousVMObject::AnonymousVMObject(PhysicalPage& page)
     physical_pages()[0] = page;
 }
 
+AnonymousVMObject::AnonymousVMObject(const NonnullRefPtrVector<PhysicalPage>& pages)
+    : VMObject(pages.size() * PAGE_SIZE)
+    , m_volatile_ranges_cache({ 0, page_count() })
+{
+    for (size_t i = 0; i < pages.size(); ++i)
+        physical_pages()[i] = pages[i];
+}
+
 AnonymousVMObject::AnonymousVMObject(const AnonymousVMObject& other)
     : VMObject(other)
     , m_volatile_ranges_cache({ 0, page_count() }) // do *not* clone this
@@ -135,11 +151,19 @@ AnonymousVMObject::AnonymousVMObject(const AnonymousVMObject& other)
     , m_unused_committed_pages(other.m_unused_committed_pages)
     , m_cow_map()                                                      // do *not* clone this
     , m_shared_committed_cow_pages(other.m_shared_committed_cow_pages) // share the pool
+    , m_compressed_pages(other.m_compressed_pages)                     // share the compressed pages
+    , m_may_evict_pages(other.m_may_evict_pages)
 {
     // We can't really "copy" a spinlock. But we're holding it. Clear in the clone
     VERIFY(other.m_lock.is_locked());
     m_lock.initialize();
 
+    if (!m_compressed_pages.is_empty()) {
+        ScopedSpinLock mm_lock(s_mm_lock);
+        for (auto& it : m_compressed_pages)
+            CompressedPageStore::the().retain(it.value);
+    }
+
     // The clone also becomes COW
     ensure_or_reset_cow_map();
 
@@ -164,6 +188,12 @@ AnonymousVMObject::~AnonymousVMObject()
     // Return any unused committed pages
     if (m_unused_committed_pages > 0)
         MM.uncommit_user_physical_pages(m_unused_committed_pages);
+
+    if (!m_compressed_pages.is_empty()) {
+        ScopedSpinLock mm_lock(s_mm_lock);
+        for (auto& it : m_compressed_pages)
+            CompressedPageStore::the().release(it.value);
+    }
 }
 
 int AnonymousVMObject::purge()
@@ -198,6 +228,11 @@ int AnonymousVMObject::purge_impl()
             auto& phys_page = m_physical_pages[i];
             if (phys_page && !phys_page->is_shared_zero_page()) {
                 VERIFY(!phys_page->is_lazy_committed_page());
+                if (phys_page->is_compressed_page()) {
+                    ScopedSpinLock mm_lock(s_mm_lock);
+                    CompressedPageStore::the().release(m_compressed_pages.get(i).value());
+                    m_compressed_pages.remove(i);
+                }
                 ++purged_in_range;
             }
             phys_page = MM.shared_zero_page();
@@ -223,6 +258,43 @@ int AnonymousVMObject::purge_impl()
     return purged_page_count;
 }
 
+size_t AnonymousVMObject::discard_pages(Region& region, size_t page_index, size_t page_count)
+{
+    // Only plain anonymous memory can be thrown away, not e.g. physical ranges mapped by device drivers.
+    if (!m_may_evict_pages)
+        return 0;
+    size_t discarded_count = 0;
+    ScopedSpinLock lock(m_lock);
+    auto end = min(page_index + page_count, this->page_count());
+    // Another processor may still write to a page through its TLB until the page has been remapped,
+    // so the pages are only let go of after that, a batch at a time.
+    static constexpr size_t batch_page_count = 32;
+    for (size_t batch_start = page_index; batch_start < end; batch_start += batch_page_count) {
+        auto batch_end = min(batch_start + batch_page_count, end);
+        Array<RefPtr<PhysicalPage>, batch_page_count> discarded_pages;
+        size_t discarded_in_batch = 0;
+        for (size_t i = batch_start; i < batch_end; ++i) {
+            auto& phys_page = m_physical_pages[i];
+            if (!phys_page || phys_page->is_shared_zero_page() || phys_page->is_lazy_committed_page())
+                continue;
+            if (phys_page->is_compressed_page()) {
+                ScopedSpinLock mm_lock(s_mm_lock);
+                CompressedPageStore::the().release(m_compressed_pages.get(i).value());
+                m_compressed_pages.remove(i);
+            }
+            // Just like after purging a volatile range, the page isn't committed anymore: a later
+            // write allocates a fresh page the same way it does for MAP_NORESERVE mappings.
+            discarded_pages[discarded_in_batch++] = move(phys_page);
+            phys_page = MM.shared_zero_page();
+        }
+        if (discarded_in_batch) {
+            region.remap_vmobject_page_range(batch_start, batch_end - batch_start);
+            discarded_count += discarded_in_batch;
+        }
+    }
+    return discarded_count;
+}
+
 void AnonymousVMObject::register_purgeable_page_ranges(PurgeablePageRanges& purgeable_page_ranges)
 {
     ScopedSpinLock lock(m_lock);
@@ -423,6 +495,17 @@ void AnonymousVMObject::set_should_cow(size_t page_index, bool cow)
     ensure_cow_map().set(page_index, cow);
 }
 
+bool AnonymousVMObject::replace_with_shared_page(size_t page_index, const PhysicalPage& expected_page, PhysicalPage& shared_page)
+{
+    ScopedSpinLock lock(m_lock);
+    auto& page_slot = physical_pages()[page_index];
+    if (page_slot.ptr() != &expected_page)
+        return false;
+    page_slot = shared_page;
+    set_should_cow(page_index, true);
+    return true;
+}
+
 size_t AnonymousVMObject::cow_pages() const
 {
     if (!m_cow_map)
@@ -442,6 +525,11 @@ PageFaultResponse AnonymousVMObject::handle_cow_fault(size_t page_index, Virtual
     VERIFY_INTERRUPTS_DISABLED();
     ScopedSpinLock lock(m_lock);
     auto& page_slot = physical_pages()[page_index];
+    if (page_slot->is_compressed_page()) {
+        // The page was evicted after we faulted on it. Once it's been unmapped,
+        // we'll fault on it again and bring it back in.
+        return PageFaultResponse::Continue;
+    }
     bool have_committed = m_shared_committed_cow_pages && is_nonvolatile(page_index);
     if (page_slot->ref_count() == 1) {
 #if PAGE_FAULT_DEBUG
@@ -494,4 +582,129 @@ PageFaultResponse AnonymousVMObject::handle_cow_fault(size_t page_index, Virtual
     return PageFaultResponse::Continue;
 }
 
+PageFaultResponse AnonymousVMObject::handle_compressed_page_fault(size_t page_index)
+{
+    VERIFY_INTERRUPTS_DISABLED();
+    VERIFY(m_paging_lock.is_locked());
+
+    // Holding our lock keeps the page from being cloned or evicted
+    // again while we're bringing it back.
+    ScopedSpinLock lock(m_lock);
+    auto& page_slot = physical_pages()[page_index];
+    if (!page_slot->is_compressed_page()) {
+        dbgln_if(COMPRESSED_PAGE_DEBUG, "MM: handle_compressed_page_fault() but page is back already. Fine with me!");
+        return PageFaultResponse::Continue;
+    }
+
+    // Once decompressed, the page is private to us. If it was shared with a
+    // clone, we may have committed a page for copying it already.
+    bool was_cow = m_cow_map && m_cow_map->get(page_index);
+    RefPtr<PhysicalPage> page;
+    if (was_cow && m_shared_committed_cow_pages && is_nonvolatile(page_index)) {
+        page = m_shared_committed_cow_pages->allocate_one();
+    } else {
+        page = MM.allocate_user_physical_page(MemoryManager::ShouldZeroFill::No);
+        if (page.is_null()) {
+            klog() << "MM: handle_compressed_page_fault was unable to allocate a physical page";
+            return PageFaultResponse::OutOfMemory;
+        }
+    }
+
+    ScopedSpinLock mm_lock(s_mm_lock);
+    auto handle = m_compressed_pages.get(page_index).value();
+    m_compressed_pages.remove(page_index);
+    CompressedPageStore::the().load(handle, *page);
+    CompressedPageStore::the().release(handle);
+    dbgln_if(COMPRESSED_PAGE_DEBUG, "MM: Decompressed page {} of {} into {}", page_index, this, page->paddr());
+
+    page_slot = move(page);
+    if (was_cow)
+        set_should_cow(page_index, false);
+    return PageFaultResponse::Continue;
+}
+
+size_t AnonymousVMObject::evict_cold_pages(Badge<MemoryManager>, size_t max_page_count, size_t& scan_budget)
+{
+    VERIFY(s_mm_lock.own_lock());
+    if (!m_may_evict_pages || m_paging_lock.is_locked())
+        return 0;
+
+    // We may have been called while allocating memory on behalf of this very VMObject.
+    u32 prev_flags;
+    if (!m_lock.try_lock(prev_flags))
+        return 0;
+    ScopeGuard unlock_guard = [&] { m_lock.unlock(prev_flags); };
+
+    // Purgeable memory has its own way of being reclaimed.
+    if (!m_purgeable_ranges.is_empty())
+        return 0;
+
+    // The kernel may access its own memory at any time, without expecting to fault.
+    Vector<Region*, 4> regions;
+    bool is_mapped_by_kernel = false;
+    for_each_region([&](Region& region) {
+        if (!region.is_user())
+            is_mapped_by_kernel = true;
+        regions.append(&region);
+    });
+    if (regions.is_empty() || is_mapped_by_kernel)
+        return 0;
+
+    size_t evicted_count = 0;
+    size_t scan_count = min(scan_budget, page_count());
+    for (size_t i = 0; i < scan_count && evicted_count < max_page_count; ++i) {
+        auto page_index = m_eviction_clock_hand;
+        m_eviction_clock_hand = (m_eviction_clock_hand + 1) % page_count();
+        --scan_budget;
+
+        auto& page = m_physical_pages[page_index];
+        if (!page || page->is_shared_zero_page() || page->is_lazy_committed_page() || page->is_compressed_page())
+            continue;
+        // Pages that are shared with clones or mapped elsewhere stay where they are.
+        if (page->ref_count() != 1 || (m_cow_map && m_cow_map->get(page_index)))
+            continue;
+
+        // Clock algorithm: Pages that were accessed since we last came
+        // around get a second chance, the others are evicted.
+        bool was_accessed = false;
+        for (auto* region : regions) {
+            if (region->test_and_clear_accessed_bit(page_index))
+                was_accessed = true;
+        }
+        if (was_accessed)
+            continue;
+
+        if (evict_page(page_index, *regions.first()))
+            ++evicted_count;
+    }
+    return evicted_count;
+}
+
+bool AnonymousVMObject::evict_page(size_t page_index, Region& region)
+{
+    VERIFY(s_mm_lock.own_lock());
+    VERIFY(m_lock.is_locked());
+
+    // Unmap the page everywhere first, so that nobody can modify it while we compress it.
+    auto& page_slot = m_physical_pages[page_index];
+    RefPtr<PhysicalPage> page = move(page_slot);
+    page_slot = MM.compressed_page();
+    region.remap_vmobject_page_range(page_index, 1);
+
+    CompressedPageStore::Handle handle;
+    switch (CompressedPageStore::the().store(page, handle)) {
+    case CompressedPageStore::StoreResult::Stored:
+        m_compressed_pages.set(page_index, handle);
+        return true;
+    case CompressedPageStore::StoreResult::AllZero:
+        page_slot = MM.shared_zero_page();
+        return true;
+    case CompressedPageStore::StoreResult::Rejected:
+        page_slot = move(page);
+        region.remap_vmobject_page_range(page_index, 1);
+        return false;
+    }
+    VERIFY_NOT_REACHED();
+}
+
 }
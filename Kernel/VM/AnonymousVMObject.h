@@ -26,8 +26,11 @@
 
 #pragma once
 
+#include <AK/HashMap.h>
+#include <AK/NonnullRefPtrVector.h>
 #include <Kernel/PhysicalAddress.h>
 #include <Kernel/VM/AllocationStrategy.h>
+#include <Kernel/VM/CompressedPageStore.h>
 #include <Kernel/VM/PageFaultResponse.h>
 #include <Kernel/VM/PurgeablePageRanges.h>
 #include <Kernel/VM/VMObject.h>
@@ -43,20 +46,31 @@ public:
     static RefPtr<AnonymousVMObject> create_with_size(size_t, AllocationStrategy);
     static RefPtr<AnonymousVMObject> create_for_physical_range(PhysicalAddress paddr, size_t size);
     static NonnullRefPtr<AnonymousVMObject> create_with_physical_page(PhysicalPage& page);
+    static NonnullRefPtr<AnonymousVMObject> create_with_physical_pages(const NonnullRefPtrVector<PhysicalPage>&);
     virtual RefPtr<VMObject> clone() override;
 
     RefPtr<PhysicalPage> allocate_committed_page(size_t);
     PageFaultResponse handle_cow_fault(size_t, VirtualAddress);
+    PageFaultResponse handle_compressed_page_fault(size_t);
+
+    size_t evict_cold_pages(Badge<MemoryManager>, size_t max_page_count, size_t& scan_budget);
     size_t cow_pages() const;
     bool should_cow(size_t page_index, bool) const;
     void set_should_cow(size_t page_index, bool);
 
+    // Swaps expected_page (if it's still there) for an identical page that is shared with others.
+    bool replace_with_shared_page(size_t page_index, const PhysicalPage& expected_page, PhysicalPage& shared_page);
+
     void register_purgeable_page_ranges(PurgeablePageRanges&);
     void unregister_purgeable_page_ranges(PurgeablePageRanges&);
 
     int purge();
     int purge_with_interrupts_disabled(Badge<MemoryManager>);
 
+    // Throws away the contents of the given pages, they read back as zeroes on the next access.
+    // The discarded pages are unmapped through `region` (and every other region sharing us) before they are freed.
+    size_t discard_pages(Region&, size_t page_index, size_t page_count);
+
     bool is_any_volatile() const;
 
     template<typename F>
@@ -119,6 +133,7 @@ private:
     explicit AnonymousVMObject(size_t, AllocationStrategy);
     explicit AnonymousVMObject(PhysicalAddress, size_t);
     explicit AnonymousVMObject(PhysicalPage&);
+    explicit AnonymousVMObject(const NonnullRefPtrVector<PhysicalPage>&);
     explicit AnonymousVMObject(const AnonymousVMObject&);
 
     virtual const char* class_name() const override { return "AnonymousVMObject"; }
@@ -132,6 +147,7 @@ private:
     size_t count_needed_commit_pages_for_nonvolatile_range(const VolatilePageRange&);
     size_t mark_committed_pages_for_nonvolatile_range(const VolatilePageRange&, size_t);
     bool is_nonvolatile(size_t page_index);
+    bool evict_page(size_t page_index, Region&);
 
     AnonymousVMObject& operator=(const AnonymousVMObject&) = delete;
     AnonymousVMObject& operator=(AnonymousVMObject&&) = delete;
@@ -151,6 +167,11 @@ private:
 
     // We share a pool of committed cow-pages with clones
     RefPtr<CommittedCowPages> m_shared_committed_cow_pages;
+
+    // Pages that have been moved to the CompressedPageStore, their slot holds MM.compressed_page()
+    HashMap<size_t, CompressedPageStore::Handle> m_compressed_pages;
+    size_t m_eviction_clock_hand { 0 };
+    bool m_may_evict_pages { false };
 };
 
 }
@@ -0,0 +1,316 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/NumericLimits.h>
+#include <Kernel/StdLib.h>
+#include <Kernel/VM/CompressedPageStore.h>
+#include <Kernel/VM/MemoryManager.h>
+
+namespace Kernel {
+
+static CompressedPageStore* s_the;
+
+// Pages are compressed one 32-bit word at a time, in the spirit of WKdm:
+// every word gets a 2-bit tag, and words that aren't zero are looked up in a
+// small direct-mapped dictionary of recently seen words. A word either matches
+// a dictionary entry exactly, matches all but its low 10 bits, or is stored
+// as a literal. The tags come first, followed by the per-word payloads.
+static constexpr size_t words_per_page = PAGE_SIZE / sizeof(u32);
+static constexpr size_t tags_size = words_per_page / 4;
+static constexpr size_t dictionary_size = 16;
+static constexpr u32 low_bits_mask = 0x3ff;
+
+enum WordTag : u8 {
+    Zero = 0,
+    ExactMatch = 1,
+    PartialMatch = 2,
+    Miss = 3,
+};
+
+static inline size_t dictionary_index(u32 word)
+{
+    return ((word >> 10) * 2654435761u) >> 28;
+}
+
+static Optional<size_t> compress_page(const u32* words, u8* output)
+{
+    u32 dictionary[dictionary_size] {};
+    auto* tags = output;
+    memset(tags, 0, tags_size);
+    size_t offset = tags_size;
+    bool all_zero = true;
+
+    for (size_t i = 0; i < words_per_page; ++i) {
+        u32 word = words[i];
+        u8 tag = WordTag::Zero;
+        if (word != 0) {
+            all_zero = false;
+            auto index = dictionary_index(word);
+            auto& entry = dictionary[index];
+            if (entry == word) {
+                if (offset + 1 > CompressedPageStore::max_compressed_size)
+                    return {};
+                output[offset++] = index;
+                tag = WordTag::ExactMatch;
+            } else if ((entry & ~low_bits_mask) == (word & ~low_bits_mask)) {
+                if (offset + 2 > CompressedPageStore::max_compressed_size)
+                    return {};
+                u16 value = (index << 10) | (word & low_bits_mask);
+                output[offset++] = value & 0xff;
+                output[offset++] = value >> 8;
+                entry = word;
+                tag = WordTag::PartialMatch;
+            } else {
+                if (offset + sizeof(u32) > CompressedPageStore::max_compressed_size)
+                    return {};
+                memcpy(&output[offset], &word, sizeof(u32));
+                offset += sizeof(u32);
+                entry = word;
+                tag = WordTag::Miss;
+            }
+        }
+        tags[i / 4] |= tag << ((i % 4) * 2);
+    }
+
+    if (all_zero)
+        return 0;
+    return offset;
+}
+
+static bool decompress_page(const u8* input, size_t input_size, u32* words)
+{
+    if (input_size < tags_size)
+        return false;
+    u32 dictionary[dictionary_size] {};
+    size_t offset = tags_size;
+
+    for (size_t i = 0; i < words_per_page; ++i) {
+        switch ((input[i / 4] >> ((i % 4) * 2)) & 3) {
+        case WordTag::Zero:
+            words[i] = 0;
+            break;
+        case WordTag::ExactMatch: {
+            if (offset + 1 > input_size || input[offset] >= dictionary_size)
+                return false;
+            words[i] = dictionary[input[offset++]];
+            break;
+        }
+        case WordTag::PartialMatch: {
+            if (offset + 2 > input_size)
+                return false;
+            u16 value = input[offset] | (input[offset + 1] << 8);
+            offset += 2;
+            auto& entry = dictionary[value >> 10];
+            entry = (entry & ~low_bits_mask) | (value & low_bits_mask);
+            words[i] = entry;
+            break;
+        }
+        case WordTag::Miss: {
+            if (offset + sizeof(u32) > input_size)
+                return false;
+            u32 word;
+            memcpy(&word, &input[offset], sizeof(u32));
+            offset += sizeof(u32);
+            dictionary[dictionary_index(word)] = word;
+            words[i] = word;
+            break;
+        }
+        }
+    }
+    return true;
+}
+
+static Optional<size_t> find_free_chunk_run(u64 used_chunks, size_t chunk_count)
+{
+    if ((size_t)__builtin_popcountll(~used_chunks) < chunk_count)
+        return {};
+    size_t run = 0;
+    for (size_t i = 0; i < CompressedPageStore::chunks_per_page; ++i) {
+        if (used_chunks & (1ull << i)) {
+            run = 0;
+            continue;
+        }
+        if (++run == chunk_count)
+            return i + 1 - chunk_count;
+    }
+    return {};
+}
+
+static inline u64 chunk_mask(size_t first_chunk, size_t chunk_count)
+{
+    if (chunk_count == CompressedPageStore::chunks_per_page)
+        return ~0ull;
+    return ((1ull << chunk_count) - 1) << first_chunk;
+}
+
+void CompressedPageStore::initialize()
+{
+    VERIFY(!s_the);
+    s_the = new CompressedPageStore;
+}
+
+bool CompressedPageStore::is_initialized()
+{
+    return s_the != nullptr;
+}
+
+CompressedPageStore& CompressedPageStore::the()
+{
+    return *s_the;
+}
+
+CompressedPageStore::CompressedPageStore()
+    : m_max_storage_page_count(MM.user_physical_pages() / 4)
+{
+    dmesgln("CompressedPageStore: Using up to {} KiB of memory for compressed pages", m_max_storage_page_count * PAGE_SIZE / KiB);
+}
+
+Optional<CompressedPageStore::Handle> CompressedPageStore::find_free_chunks(size_t chunk_count)
+{
+    // Keep filling the storage page we used last, that's where the free chunks usually are.
+    for (size_t i = 0; i < m_storage_pages.size(); ++i) {
+        auto storage_index = (m_search_hint + i) % m_storage_pages.size();
+        auto& storage_page = m_storage_pages[storage_index];
+        if (!storage_page.page)
+            continue;
+        auto first_chunk = find_free_chunk_run(storage_page.used_chunks, chunk_count);
+        if (first_chunk.has_value()) {
+            m_search_hint = storage_index;
+            return make_handle(storage_index, first_chunk.value());
+        }
+    }
+    return {};
+}
+
+CompressedPageStore::Handle CompressedPageStore::add_storage_page(NonnullRefPtr<PhysicalPage> page)
+{
+    ++m_storage_page_count;
+    for (size_t i = 0; i < m_storage_pages.size(); ++i) {
+        auto& storage_page = m_storage_pages[i];
+        if (storage_page.page)
+            continue;
+        storage_page.page = move(page);
+        m_search_hint = i;
+        return make_handle(i, 0);
+    }
+    StoragePage storage_page;
+    storage_page.page = move(page);
+    m_storage_pages.append(move(storage_page));
+    m_search_hint = m_storage_pages.size() - 1;
+    return make_handle(m_search_hint, 0);
+}
+
+CompressedPageStore::StoreResult CompressedPageStore::store(RefPtr<PhysicalPage>& page, Handle& handle)
+{
+    ScopedSpinLock lock(s_mm_lock);
+    VERIFY(page && page->ref_count() == 1);
+
+    auto* page_ptr = MM.quickmap_page(*page);
+    auto compressed_size = compress_page(reinterpret_cast<const u32*>(page_ptr), m_buffer);
+    MM.unquickmap_page();
+
+    if (!compressed_size.has_value())
+        return StoreResult::Rejected;
+    if (compressed_size.value() == 0) {
+        page = nullptr;
+        return StoreResult::AllZero;
+    }
+
+    size_t chunk_count = ceil_div(compressed_size.value(), chunk_size);
+    auto location = find_free_chunks(chunk_count);
+    if (!location.has_value()) {
+        if (m_storage_page_count >= m_max_storage_page_count)
+            return StoreResult::Rejected;
+        // We might well be out of physical pages, but the page we just compressed
+        // is about to be freed anyway, so there is always one left for us to take.
+        page = nullptr;
+        auto storage_page = MM.find_free_user_physical_page(false);
+        VERIFY(storage_page);
+        location = add_storage_page(storage_page.release_nonnull());
+    }
+
+    handle = location.value();
+    auto& storage_page = storage_page_for(handle);
+    auto first_chunk = handle % chunks_per_page;
+    auto* storage_ptr = MM.quickmap_page(*storage_page.page);
+    memcpy(storage_ptr + first_chunk * chunk_size, m_buffer, compressed_size.value());
+    MM.unquickmap_page();
+
+    storage_page.used_chunks |= chunk_mask(first_chunk, chunk_count);
+    storage_page.chunk_counts[first_chunk] = chunk_count;
+    storage_page.ref_counts[first_chunk] = 1;
+    ++m_stored_page_count;
+
+    page = nullptr;
+    return StoreResult::Stored;
+}
+
+void CompressedPageStore::load(Handle handle, PhysicalPage& page)
+{
+    ScopedSpinLock lock(s_mm_lock);
+    auto& storage_page = storage_page_for(handle);
+    auto first_chunk = handle % chunks_per_page;
+    VERIFY(storage_page.ref_counts[first_chunk] > 0);
+    size_t compressed_size = storage_page.chunk_counts[first_chunk] * chunk_size;
+
+    // We can only quickmap one page at a time, so bounce the data through our buffer.
+    auto* storage_ptr = MM.quickmap_page(*storage_page.page);
+    memcpy(m_buffer, storage_ptr + first_chunk * chunk_size, compressed_size);
+    MM.unquickmap_page();
+
+    auto* page_ptr = MM.quickmap_page(page);
+    bool success = decompress_page(m_buffer, compressed_size, reinterpret_cast<u32*>(page_ptr));
+    MM.unquickmap_page();
+    VERIFY(success);
+}
+
+void CompressedPageStore::retain(Handle handle)
+{
+    ScopedSpinLock lock(s_mm_lock);
+    auto& ref_count = storage_page_for(handle).ref_counts[handle % chunks_per_page];
+    VERIFY(ref_count > 0 && ref_count < NumericLimits<u16>::max());
+    ++ref_count;
+}
+
+void CompressedPageStore::release(Handle handle)
+{
+    ScopedSpinLock lock(s_mm_lock);
+    auto& storage_page = storage_page_for(handle);
+    auto first_chunk = handle % chunks_per_page;
+    VERIFY(storage_page.ref_counts[first_chunk] > 0);
+    if (--storage_page.ref_counts[first_chunk] > 0)
+        return;
+
+    storage_page.used_chunks &= ~chunk_mask(first_chunk, storage_page.chunk_counts[first_chunk]);
+    storage_page.chunk_counts[first_chunk] = 0;
+    --m_stored_page_count;
+    if (storage_page.used_chunks == 0) {
+        storage_page.page = nullptr;
+        --m_storage_page_count;
+    }
+}
+
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Optional.h>
+#include <AK/RefPtr.h>
+#include <AK/Types.h>
+#include <AK/Vector.h>
+#include <Kernel/VM/PhysicalPage.h>
+
+namespace Kernel {
+
+// Keeps the contents of evicted anonymous pages compressed in RAM.
+// Compressed pages are packed into physical pages taken from the user
+// page pool, in units of chunk_size bytes. An entry never straddles two
+// storage pages, and entries are reference counted so that VMObject clones
+// can share them.
+class CompressedPageStore {
+    AK_MAKE_ETERNAL
+
+public:
+    using Handle = u32;
+
+    static void initialize();
+    static bool is_initialized();
+    static CompressedPageStore& the();
+
+    static constexpr size_t chunk_size = 64;
+    static constexpr size_t chunks_per_page = PAGE_SIZE / chunk_size;
+    // Pages that don't compress below this aren't worth evicting.
+    static constexpr size_t max_compressed_size = 48 * chunk_size;
+
+    enum class StoreResult {
+        Stored,
+        AllZero,
+        Rejected,
+    };
+
+    // Compresses the page, which must not be mapped anywhere anymore. Unless the
+    // page is rejected, the reference to it is dropped and the page is freed.
+    StoreResult store(RefPtr<PhysicalPage>&, Handle&);
+    void load(Handle, PhysicalPage&);
+    void retain(Handle);
+    void release(Handle);
+
+    size_t stored_page_count() const { return m_stored_page_count; }
+    size_t storage_page_count() const { return m_storage_page_count; }
+
+private:
+    CompressedPageStore();
+
+    struct StoragePage {
+        RefPtr<PhysicalPage> page;
+        u64 used_chunks { 0 };
+        u8 chunk_counts[chunks_per_page] {};
+        u16 ref_counts[chunks_per_page] {};
+    };
+
+    static Handle make_handle(size_t storage_index, size_t first_chunk) { return storage_index * chunks_per_page + first_chunk; }
+    StoragePage& storage_page_for(Handle handle) { return m_storage_pages[handle / chunks_per_page]; }
+
+    Optional<Handle> find_free_chunks(size_t chunk_count);
+    Handle add_storage_page(NonnullRefPtr<PhysicalPage>);
+
+    Vector<StoragePage> m_storage_pages;
+    size_t m_search_hint { 0 };
+    size_t m_storage_page_count { 0 };
+    size_t m_max_storage_page_count { 0 };
+    size_t m_stored_page_count { 0 };
+
+    alignas(u32) u8 m_buffer[max_compressed_size];
+};
+
+}
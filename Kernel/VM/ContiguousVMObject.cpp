@@ -24,6 +24,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <Kernel/StdLib.h>
 #include <Kernel/VM/ContiguousVMObject.h>
 #include <Kernel/VM/MemoryManager.h>
 #include <Kernel/VM/PhysicalPage.h>
@@ -35,8 +36,17 @@ NonnullRefPtr<ContiguousVMObject> ContiguousVMObject::create_with_size(size_t si
     return adopt(*new ContiguousVMObject(size, physical_alignment));
 }
 
+RefPtr<ContiguousVMObject> ContiguousVMObject::try_create_with_user_pages(size_t size, size_t physical_alignment)
+{
+    auto contiguous_physical_pages = MM.allocate_contiguous_user_physical_pages(size, physical_alignment);
+    if (contiguous_physical_pages.is_empty())
+        return {};
+    return adopt(*new ContiguousVMObject(size, physical_alignment, move(contiguous_physical_pages)));
+}
+
 ContiguousVMObject::ContiguousVMObject(size_t size, size_t physical_alignment)
     : VMObject(size)
+    , m_physical_alignment(physical_alignment)
 {
     auto contiguous_physical_pages = MM.allocate_contiguous_supervisor_physical_pages(size, physical_alignment);
     for (size_t i = 0; i < page_count(); i++) {
@@ -45,8 +55,21 @@ ContiguousVMObject::ContiguousVMObject(size_t size, size_t physical_alignment)
     }
 }
 
+ContiguousVMObject::ContiguousVMObject(size_t size, size_t physical_alignment, NonnullRefPtrVector<PhysicalPage>&& contiguous_physical_pages)
+    : VMObject(size)
+    , m_physical_alignment(physical_alignment)
+    , m_user_pages(true)
+{
+    for (size_t i = 0; i < page_count(); i++) {
+        physical_pages()[i] = contiguous_physical_pages[i];
+        dbgln_if(CONTIGUOUS_VMOBJECT_DEBUG, "Contiguous user page[{}]: {}", i, physical_pages()[i]->paddr());
+    }
+}
+
 ContiguousVMObject::ContiguousVMObject(const ContiguousVMObject& other)
     : VMObject(other)
+    , m_physical_alignment(other.m_physical_alignment)
+    , m_user_pages(other.m_user_pages)
 {
 }
 
@@ -56,7 +79,20 @@ ContiguousVMObject::~ContiguousVMObject()
 
 RefPtr<VMObject> ContiguousVMObject::clone()
 {
-    VERIFY_NOT_REACHED();
+    // Supervisor pages are only ever used for kernel-owned buffers, which are never cloned.
+    VERIFY(m_user_pages);
+
+    // A private mapping of user pages is copied eagerly when forking, since the clone
+    // has to stay physically contiguous.
+    auto clone = try_create_with_user_pages(size(), m_physical_alignment);
+    if (!clone)
+        return {};
+    auto source_region = MM.allocate_kernel_region(physical_pages()[0]->paddr(), size(), "ContiguousVMObject clone source", Region::Access::Read);
+    auto destination_region = MM.allocate_kernel_region(clone->physical_pages()[0]->paddr(), size(), "ContiguousVMObject clone destination", Region::Access::Read | Region::Access::Write);
+    if (!source_region || !destination_region)
+        return {};
+    memcpy(destination_region->vaddr().as_ptr(), source_region->vaddr().as_ptr(), size());
+    return clone;
 }
 
 }
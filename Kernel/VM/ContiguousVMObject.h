@@ -36,9 +36,11 @@ public:
     virtual ~ContiguousVMObject() override;
 
     static NonnullRefPtr<ContiguousVMObject> create_with_size(size_t, size_t physical_alignment = PAGE_SIZE);
+    static RefPtr<ContiguousVMObject> try_create_with_user_pages(size_t, size_t physical_alignment = PAGE_SIZE);
 
 private:
     explicit ContiguousVMObject(size_t, size_t physical_alignment);
+    ContiguousVMObject(size_t, size_t physical_alignment, NonnullRefPtrVector<PhysicalPage>&&);
     explicit ContiguousVMObject(const ContiguousVMObject&);
 
     virtual const char* class_name() const override { return "ContiguousVMObject"; }
@@ -49,6 +51,9 @@ private:
     ContiguousVMObject(ContiguousVMObject&&) = delete;
 
     virtual bool is_contiguous() const override { return true; }
+
+    size_t m_physical_alignment { PAGE_SIZE };
+    bool m_user_pages { false };
 };
 
 }
@@ -24,6 +24,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Array.h>
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/VM/InodeVMObject.h>
 #include <Kernel/VM/MemoryManager.h>
@@ -125,6 +126,106 @@ int InodeVMObject::release_all_clean_pages_impl()
     return count;
 }
 
+size_t InodeVMObject::release_clean_pages(Region& region, size_t page_index, size_t page_count)
+{
+    LOCKER(m_paging_lock);
+    size_t count = 0;
+    InterruptDisabler disabler;
+    auto end = min(page_index + page_count, this->page_count());
+    // The pages stay alive until they're unmapped everywhere, since a stale TLB entry could still reach them.
+    static constexpr size_t batch_page_count = 32;
+    for (size_t batch_start = page_index; batch_start < end; batch_start += batch_page_count) {
+        auto batch_end = min(batch_start + batch_page_count, end);
+        Array<RefPtr<PhysicalPage>, batch_page_count> released_pages;
+        size_t released_in_batch = 0;
+        for (size_t i = batch_start; i < batch_end; ++i) {
+            if (!m_dirty_pages.get(i) && m_physical_pages[i])
+                released_pages[released_in_batch++] = move(m_physical_pages[i]);
+        }
+        if (released_in_batch) {
+            region.remap_vmobject_page_range(batch_start, batch_end - batch_start);
+            count += released_in_batch;
+        }
+    }
+    return count;
+}
+
+RefPtr<PhysicalPage> InodeVMObject::populate_page_for_read(size_t page_index, FileDescription* description)
+{
+    VERIFY(m_paging_lock.is_locked());
+
+    u8 page_buffer[PAGE_SIZE];
+    auto buffer = UserOrKernelBuffer::for_kernel_buffer(page_buffer);
+    auto nread = m_inode->read_bytes(page_index * PAGE_SIZE, PAGE_SIZE, buffer, description);
+    if (nread < 0)
+        return {};
+    if (nread < PAGE_SIZE) {
+        // If we read less than a page, zero out the rest to avoid leaking uninitialized data.
+        memset(page_buffer + nread, 0, PAGE_SIZE - nread);
+    }
+
+    auto page = MM.allocate_user_physical_page(MemoryManager::ShouldZeroFill::No);
+    if (!page)
+        return {};
+
+    InterruptDisabler disabler;
+    u8* dest_ptr = MM.quickmap_page(*page);
+    memcpy(dest_ptr, page_buffer, PAGE_SIZE);
+    MM.unquickmap_page();
+    // The inode may have been truncated while we were reading from it.
+    if (page_index < page_count())
+        m_physical_pages[page_index] = page;
+    return page;
+}
+
+ssize_t InodeVMObject::read_bytes(off_t offset, ssize_t count, UserOrKernelBuffer& buffer, FileDescription* description)
+{
+    VERIFY(offset >= 0);
+    VERIFY(count >= 0);
+    LOCKER(m_paging_lock);
+
+    size_t inode_size = m_inode->size();
+    if ((size_t)offset >= inode_size)
+        return 0;
+    size_t remaining = min((size_t)count, inode_size - offset);
+
+    u8 page_buffer[PAGE_SIZE];
+    ssize_t nread = 0;
+    while (remaining) {
+        size_t page_index = (offset + nread) / PAGE_SIZE;
+        size_t offset_in_page = (offset + nread) % PAGE_SIZE;
+        size_t chunk_size = min(PAGE_SIZE - offset_in_page, remaining);
+
+        RefPtr<PhysicalPage> page;
+        {
+            InterruptDisabler disabler;
+            if (page_index >= page_count())
+                break;
+            page = m_physical_pages[page_index];
+        }
+        if (!page) {
+            page = populate_page_for_read(page_index, description);
+            if (!page)
+                return nread ? nread : -EIO;
+        }
+
+        // Copy through a bounce buffer, since writing to a userspace buffer may
+        // fault and we can't take faults while holding the quickmap.
+        {
+            InterruptDisabler disabler;
+            u8* src_ptr = MM.quickmap_page(*page);
+            memcpy(page_buffer, src_ptr + offset_in_page, chunk_size);
+            MM.unquickmap_page();
+        }
+        if (!buffer.write(page_buffer, nread, chunk_size))
+            return -EFAULT;
+
+        nread += chunk_size;
+        remaining -= chunk_size;
+    }
+    return nread;
+}
+
 u32 InodeVMObject::writable_mappings() const
 {
     u32 count = 0;
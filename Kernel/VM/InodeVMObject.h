@@ -46,6 +46,14 @@ public:
     size_t amount_clean() const;
 
     int release_all_clean_pages();
+    // Drops the clean pages in the given range, they are read back from the inode on the next access.
+    // Like discard_pages() on anonymous memory, they are unmapped through `region` before they are freed.
+    size_t release_clean_pages(Region&, size_t page_index, size_t page_count);
+
+    // Reads straight out of the pages cached in this VMObject, populating missing
+    // pages from the inode. Returns the number of bytes read or a negative errno,
+    // just like Inode::read_bytes().
+    ssize_t read_bytes(off_t, ssize_t, UserOrKernelBuffer&, FileDescription*);
 
     u32 writable_mappings() const;
     u32 executable_mappings() const;
@@ -61,6 +69,7 @@ protected:
     virtual bool is_inode() const final { return true; }
 
     int release_all_clean_pages_impl();
+    RefPtr<PhysicalPage> populate_page_for_read(size_t page_index, FileDescription*);
 
     NonnullRefPtr<Inode> m_inode;
     Bitmap m_dirty_pages;
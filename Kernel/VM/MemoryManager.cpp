@@ -29,17 +29,21 @@
 #include <AK/StringView.h>
 #include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/CMOS.h>
+#include <Kernel/Debug.h>
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/Heap/kmalloc.h>
 #include <Kernel/Multiboot.h>
 #include <Kernel/Process.h>
 #include <Kernel/StdLib.h>
 #include <Kernel/VM/AnonymousVMObject.h>
+#include <Kernel/VM/CompressedPageStore.h>
 #include <Kernel/VM/ContiguousVMObject.h>
+#include <Kernel/VM/InodeVMObject.h>
 #include <Kernel/VM/MemoryManager.h>
 #include <Kernel/VM/PageDirectory.h>
 #include <Kernel/VM/PhysicalRegion.h>
 #include <Kernel/VM/SharedInodeVMObject.h>
+#include <Kernel/WaitQueue.h>
 
 extern u8* start_of_kernel_image;
 extern u8* end_of_kernel_image;
@@ -84,13 +88,15 @@ bool MemoryManager::is_initialized()
 UNMAP_AFTER_INIT MemoryManager::MemoryManager()
 {
     ScopedSpinLock lock(s_mm_lock);
+    m_zeroed_user_physical_page_pool_wait_queue = new WaitQueue;
+    m_memory_pressure_wait_queue = new WaitQueue;
     m_kernel_page_directory = PageDirectory::create_kernel_page_directory();
     parse_memory_map();
-    write_cr3(kernel_page_directory().cr3());
+    Processor::load_page_directory(kernel_page_directory().cr3());
     protect_kernel_image();
 
-    // We're temporarily "committing" to two pages that we need to allocate below
-    if (!commit_user_physical_pages(2))
+    // We're temporarily "committing" to three pages that we need to allocate below
+    if (!commit_user_physical_pages(3))
         VERIFY_NOT_REACHED();
 
     m_shared_zero_page = allocate_committed_user_physical_page();
@@ -102,6 +108,10 @@ UNMAP_AFTER_INIT MemoryManager::MemoryManager()
     // By using a tag we don't have to query the VMObject for every page
     // whether it was committed or not
     m_lazy_committed_page = allocate_committed_user_physical_page();
+
+    // Likewise, this tag marks pages whose contents have been moved to the
+    // CompressedPageStore. It is never mapped anywhere.
+    m_compressed_page = allocate_committed_user_physical_page();
 }
 
 UNMAP_AFTER_INIT MemoryManager::~MemoryManager()
@@ -332,7 +342,7 @@ PageTableEntry* MemoryManager::pte(PageDirectory& page_directory, VirtualAddress
 
     auto* pd = quickmap_pd(const_cast<PageDirectory&>(page_directory), page_directory_table_index);
     const PageDirectoryEntry& pde = pd[page_directory_index];
-    if (!pde.is_present())
+    if (!pde.is_present() || pde.is_huge())
         return nullptr;
 
     return &quickmap_pt(PhysicalAddress((FlatPtr)pde.page_table_base()))[page_table_index];
@@ -349,6 +359,10 @@ PageTableEntry* MemoryManager::ensure_pte(PageDirectory& page_directory, Virtual
 
     auto* pd = quickmap_pd(page_directory, page_directory_table_index);
     PageDirectoryEntry& pde = pd[page_directory_index];
+    if (pde.is_present() && pde.is_huge()) {
+        dbgln("MM: Unable to map {} inside a huge page", vaddr);
+        return nullptr;
+    }
     if (!pde.is_present()) {
         bool did_purge = false;
         auto page_table = allocate_user_physical_page(ShouldZeroFill::Yes, &did_purge);
@@ -391,6 +405,7 @@ void MemoryManager::release_pte(PageDirectory& page_directory, VirtualAddress va
     auto* pd = quickmap_pd(page_directory, page_directory_table_index);
     PageDirectoryEntry& pde = pd[page_directory_index];
     if (pde.is_present()) {
+        VERIFY(!pde.is_huge());
         auto* page_table = quickmap_pt(PhysicalAddress((FlatPtr)pde.page_table_base()));
         auto& pte = page_table[page_table_index];
         pte.clear();
@@ -415,6 +430,50 @@ void MemoryManager::release_pte(PageDirectory& page_directory, VirtualAddress va
     }
 }
 
+PageDirectoryEntry* MemoryManager::ensure_huge_pde(PageDirectory& page_directory, VirtualAddress vaddr)
+{
+    VERIFY_INTERRUPTS_DISABLED();
+    VERIFY(s_mm_lock.own_lock());
+    VERIFY(page_directory.get_lock().own_lock());
+    VERIFY(!(vaddr.get() % HUGE_PAGE_SIZE));
+    u32 page_directory_table_index = (vaddr.get() >> 30) & 0x3;
+    u32 page_directory_index = (vaddr.get() >> 21) & 0x1ff;
+
+    auto* pd = quickmap_pd(page_directory, page_directory_table_index);
+    PageDirectoryEntry& pde = pd[page_directory_index];
+    if (pde.is_present() && !pde.is_huge()) {
+        // We can only replace page tables that we allocated ourselves, and only
+        // if nothing is mapped through them anymore.
+        auto it = page_directory.m_page_tables.find(vaddr.get());
+        if (it == page_directory.m_page_tables.end())
+            return nullptr;
+        auto* page_table = quickmap_pt(PhysicalAddress((FlatPtr)pde.page_table_base()));
+        for (u32 i = 0; i <= 0x1ff; i++) {
+            if (!page_table[i].is_null())
+                return nullptr;
+        }
+        pde.clear();
+        page_directory.m_page_tables.remove(it);
+    }
+    return &pde;
+}
+
+bool MemoryManager::release_huge_pde(PageDirectory& page_directory, VirtualAddress vaddr)
+{
+    VERIFY_INTERRUPTS_DISABLED();
+    VERIFY(s_mm_lock.own_lock());
+    VERIFY(page_directory.get_lock().own_lock());
+    u32 page_directory_table_index = (vaddr.get() >> 30) & 0x3;
+    u32 page_directory_index = (vaddr.get() >> 21) & 0x1ff;
+
+    auto* pd = quickmap_pd(page_directory, page_directory_table_index);
+    PageDirectoryEntry& pde = pd[page_directory_index];
+    if (!pde.is_huge())
+        return false;
+    pde.clear();
+    return true;
+}
+
 UNMAP_AFTER_INIT void MemoryManager::initialize(u32 cpu)
 {
     auto mm_data = new MemoryManagerData;
@@ -438,18 +497,13 @@ Region* MemoryManager::kernel_region_from_vaddr(VirtualAddress vaddr)
 
 Region* MemoryManager::user_region_from_vaddr(Space& space, VirtualAddress vaddr)
 {
-    // FIXME: Use a binary search tree (maybe red/black?) or some other more appropriate data structure!
-    ScopedSpinLock lock(space.get_lock());
-    for (auto& region : space.regions()) {
-        if (region.contains(vaddr))
-            return &region;
-    }
-    return nullptr;
+    return space.find_region_containing(vaddr);
 }
 
 Region* MemoryManager::find_region_from_vaddr(Space& space, VirtualAddress vaddr)
 {
-    ScopedSpinLock lock(s_mm_lock);
+    // NOTE: We don't hold s_mm_lock while looking at the Space, since the page
+    //       fault path takes the Space lock first and s_mm_lock second.
     if (auto* region = user_region_from_vaddr(space, vaddr))
         return region;
     return kernel_region_from_vaddr(vaddr);
@@ -457,7 +511,6 @@ Region* MemoryManager::find_region_from_vaddr(Space& space, VirtualAddress vaddr
 
 Region* MemoryManager::find_region_from_vaddr(VirtualAddress vaddr)
 {
-    ScopedSpinLock lock(s_mm_lock);
     if (auto* region = kernel_region_from_vaddr(vaddr))
         return region;
     auto page_directory = PageDirectory::find_by_cr3(read_cr3());
@@ -470,7 +523,6 @@ Region* MemoryManager::find_region_from_vaddr(VirtualAddress vaddr)
 PageFaultResponse MemoryManager::handle_page_fault(const PageFault& fault)
 {
     VERIFY_INTERRUPTS_DISABLED();
-    ScopedSpinLock lock(s_mm_lock);
     if (Processor::current().in_irq()) {
         dbgln("CPU[{}] BUG! Page fault while handling IRQ! code={}, vaddr={}, irq level: {}",
             Processor::id(), fault.code(), fault.vaddr(), Processor::current().in_irq());
@@ -480,20 +532,38 @@ PageFaultResponse MemoryManager::handle_page_fault(const PageFault& fault)
 #if PAGE_FAULT_DEBUG
     dbgln("MM: CPU[{}] handle_page_fault({:#04x}) at {}", Processor::id(), fault.code(), fault.vaddr());
 #endif
-    auto* region = find_region_from_vaddr(fault.vaddr());
-    if (!region) {
-        dmesgln("CPU[{}] NP(error) fault at invalid address {}", Processor::id(), fault.vaddr());
-        return PageFaultResponse::ShouldCrash;
+
+    {
+        // Faults on kernel regions are rare and still serialize on s_mm_lock.
+        ScopedSpinLock mm_lock(s_mm_lock);
+        if (auto* region = kernel_region_from_vaddr(fault.vaddr()))
+            return region->handle_fault(fault, mm_lock);
     }
 
-    return region->handle_fault(fault, lock);
+    // Faults on user regions only need to be serialized against other faults
+    // and region changes within the same address space, so we hold the Space
+    // lock instead of s_mm_lock. This lets unrelated processes fault in
+    // parallel. Per-VMObject state is protected by the VMObject's paging lock,
+    // and s_mm_lock is only taken briefly when page tables are touched.
+    auto page_directory = PageDirectory::find_by_cr3(read_cr3());
+    if (page_directory && page_directory->space()) {
+        auto& space = *page_directory->space();
+        ScopedSpinLock space_lock(space.get_lock());
+        if (auto* region = space.find_region_containing(fault.vaddr()))
+            return region->handle_fault(fault, space_lock);
+    }
+
+    dmesgln("CPU[{}] NP(error) fault at invalid address {}", Processor::id(), fault.vaddr());
+    return PageFaultResponse::ShouldCrash;
 }
 
 OwnPtr<Region> MemoryManager::allocate_contiguous_kernel_region(size_t size, String name, u8 access, size_t physical_alignment, Region::Cacheable cacheable)
 {
     VERIFY(!(size % PAGE_SIZE));
     ScopedSpinLock lock(s_mm_lock);
-    auto range = kernel_page_directory().range_allocator().allocate_anywhere(size);
+    // Align the virtual range like the physical pages so the region can be mapped with huge pages.
+    size_t virtual_alignment = (physical_alignment >= HUGE_PAGE_SIZE && size >= HUGE_PAGE_SIZE) ? HUGE_PAGE_SIZE : PAGE_SIZE;
+    auto range = kernel_page_directory().range_allocator().allocate_anywhere(size, virtual_alignment);
     if (!range.has_value())
         return {};
     auto vmobject = ContiguousVMObject::create_with_size(size, physical_alignment);
@@ -562,11 +632,19 @@ bool MemoryManager::commit_user_physical_pages(size_t page_count)
 {
     VERIFY(page_count > 0);
     ScopedSpinLock lock(s_mm_lock);
-    if (m_user_physical_pages_uncommitted < page_count)
-        return false;
+    if (m_user_physical_pages_uncommitted < page_count) {
+        // Pages sitting in the zeroed pool are only a cache, give them back first.
+        m_zeroed_user_physical_pages.clear();
+        // Then try to make room by compressing cold pages, which lets us overcommit.
+        if (m_user_physical_pages_uncommitted < page_count)
+            evict_cold_anonymous_pages(page_count - m_user_physical_pages_uncommitted + eviction_batch_size);
+        if (m_user_physical_pages_uncommitted < page_count)
+            return false;
+    }
 
     m_user_physical_pages_uncommitted -= page_count;
     m_user_physical_pages_committed += page_count;
+    update_memory_pressure_level();
     return true;
 }
 
@@ -578,6 +656,7 @@ void MemoryManager::uncommit_user_physical_pages(size_t page_count)
 
     m_user_physical_pages_uncommitted += page_count;
     m_user_physical_pages_committed -= page_count;
+    update_memory_pressure_level();
 }
 
 void MemoryManager::deallocate_user_physical_page(const PhysicalPage& page)
@@ -594,6 +673,7 @@ void MemoryManager::deallocate_user_physical_page(const PhysicalPage& page)
         // committed and allocated are only freed upon request. Once
         // returned there is no guarantee being able to get them back.
         ++m_user_physical_pages_uncommitted;
+        update_memory_pressure_level();
         return;
     }
 
@@ -623,12 +703,155 @@ RefPtr<PhysicalPage> MemoryManager::find_free_user_physical_page(bool committed)
         }
     }
     VERIFY(!committed || !page.is_null());
+    update_memory_pressure_level();
+    return page;
+}
+
+void MemoryManager::update_memory_pressure_level()
+{
+    VERIFY(s_mm_lock.own_lock());
+    // Pages in the zeroed pool were drawn from the uncommitted ones, but they are just as available.
+    size_t available = m_user_physical_pages_uncommitted + m_zeroed_user_physical_pages.size();
+    size_t total = m_user_physical_pages;
+    auto level_for = [&](size_t available) {
+        if (available < total / 32)
+            return MemoryPressureLevel::Critical;
+        if (available < total / 8)
+            return MemoryPressureLevel::Medium;
+        return MemoryPressureLevel::Low;
+    };
+
+    auto new_level = level_for(available);
+    if (new_level == m_memory_pressure_level)
+        return;
+    // Only report relief once we're clearly past the threshold, so that we
+    // don't flap between levels while memory usage hovers around it.
+    if (new_level < m_memory_pressure_level && level_for(available - total / 64) == m_memory_pressure_level)
+        return;
+
+    m_memory_pressure_level = new_level;
+    // Don't wake anyone while holding the MM lock, wait until we've left it.
+    Processor::deferred_call_queue([] {
+        MM.memory_pressure_wait_queue().wake_one();
+    });
+}
+
+size_t MemoryManager::purge_all_volatile_memory()
+{
+    NonnullRefPtrVector<AnonymousVMObject> vmobjects;
+    {
+        InterruptDisabler disabler;
+        for_each_vmobject([&](auto& vmobject) {
+            if (vmobject.is_anonymous())
+                vmobjects.append(static_cast<AnonymousVMObject&>(vmobject));
+            return IterationDecision::Continue;
+        });
+    }
+    size_t purged_page_count = 0;
+    for (auto& vmobject : vmobjects)
+        purged_page_count += vmobject.purge();
+    return purged_page_count;
+}
+
+size_t MemoryManager::release_all_clean_inode_pages()
+{
+    NonnullRefPtrVector<InodeVMObject> vmobjects;
+    {
+        InterruptDisabler disabler;
+        for_each_vmobject([&](auto& vmobject) {
+            if (vmobject.is_inode())
+                vmobjects.append(static_cast<InodeVMObject&>(vmobject));
+            return IterationDecision::Continue;
+        });
+    }
+    size_t released_page_count = 0;
+    for (auto& vmobject : vmobjects)
+        released_page_count += vmobject.release_all_clean_pages();
+    return released_page_count;
+}
+
+RefPtr<PhysicalPage> MemoryManager::take_zeroed_user_physical_page()
+{
+    VERIFY(s_mm_lock.own_lock());
+    if (m_zeroed_user_physical_pages.is_empty())
+        return {};
+    auto page = m_zeroed_user_physical_pages.take_last();
+    update_memory_pressure_level();
+    if (m_zeroed_user_physical_pages.size() == zeroed_user_physical_page_pool_size / 2) {
+        // Don't wake PageZeroingTask while holding the MM lock, wait until we've left it.
+        Processor::deferred_call_queue([] {
+            MM.zeroed_user_physical_page_pool_wait_queue().wake_one();
+        });
+    }
     return page;
 }
 
+void MemoryManager::refill_zeroed_user_physical_page_pool()
+{
+    for (;;) {
+        // Take the lock for one page at a time, so that page faults don't have to wait for us.
+        ScopedSpinLock lock(s_mm_lock);
+        if (m_zeroed_user_physical_pages.size() >= zeroed_user_physical_page_pool_size)
+            return;
+        // Don't park the last free pages in the pool when memory is tight.
+        if (m_user_physical_pages_uncommitted < zeroed_user_physical_page_pool_size * 4)
+            return;
+        auto page = find_free_user_physical_page(false);
+        if (!page)
+            return;
+        auto* ptr = quickmap_page(*page);
+        memset(ptr, 0, PAGE_SIZE);
+        unquickmap_page();
+        m_zeroed_user_physical_pages.append(page.release_nonnull());
+    }
+}
+
+size_t MemoryManager::evict_cold_anonymous_pages(size_t page_count)
+{
+    if (!CompressedPageStore::is_initialized())
+        return 0;
+    ScopedSpinLock lock(s_mm_lock);
+
+    // Look at a bounded number of pages, we don't want to spend ages walking
+    // through memory that is all in use.
+    size_t scan_budget = min(page_count * 16, (size_t)m_user_physical_pages);
+    size_t evicted_count = 0;
+    VMObject* last_visited_vmobject = nullptr;
+    for_each_vmobject([&](auto& vmobject) {
+        if (!vmobject.is_anonymous())
+            return IterationDecision::Continue;
+        last_visited_vmobject = &vmobject;
+        evicted_count += static_cast<AnonymousVMObject&>(vmobject).evict_cold_pages({}, page_count - evicted_count, scan_budget);
+        if (evicted_count == page_count || scan_budget == 0)
+            return IterationDecision::Break;
+        return IterationDecision::Continue;
+    });
+
+    // Pick up where we left off next time, so that every VMObject gets its turn.
+    if (last_visited_vmobject) {
+        while (auto* vmobject = m_vmobjects.remove_head()) {
+            m_vmobjects.append(vmobject);
+            if (vmobject == last_visited_vmobject)
+                break;
+        }
+    }
+
+    dbgln_if(COMPRESSED_PAGE_DEBUG, "MM: Evicted {} of {} requested pages, {} pages in {} storage pages", evicted_count, page_count, CompressedPageStore::the().stored_page_count(), CompressedPageStore::the().storage_page_count());
+    return evicted_count;
+}
+
 NonnullRefPtr<PhysicalPage> MemoryManager::allocate_committed_user_physical_page(ShouldZeroFill should_zero_fill)
 {
     ScopedSpinLock lock(s_mm_lock);
+    if (should_zero_fill == ShouldZeroFill::Yes) {
+        if (auto page = take_zeroed_user_physical_page()) {
+            // Pool pages were drawn from the uncommitted pool, so return our commitment to it instead.
+            VERIFY(m_user_physical_pages_committed > 0);
+            m_user_physical_pages_committed--;
+            m_user_physical_pages_uncommitted++;
+            return page.release_nonnull();
+        }
+    }
     auto page = find_free_user_physical_page(true);
     if (should_zero_fill == ShouldZeroFill::Yes) {
         auto* ptr = quickmap_page(*page);
@@ -641,9 +864,23 @@ NonnullRefPtr<PhysicalPage> MemoryManager::allocate_committed_user_physical_page
 RefPtr<PhysicalPage> MemoryManager::allocate_user_physical_page(ShouldZeroFill should_zero_fill, bool* did_purge)
 {
     ScopedSpinLock lock(s_mm_lock);
-    auto page = find_free_user_physical_page(false);
+    RefPtr<PhysicalPage> page;
+    if (should_zero_fill == ShouldZeroFill::Yes) {
+        page = take_zeroed_user_physical_page();
+        if (page) {
+            if (did_purge)
+                *did_purge = false;
+            return page;
+        }
+    }
+    page = find_free_user_physical_page(false);
     bool purged_pages = false;
 
+    if (!page) {
+        // Pages in the zeroed pool are still good to use if we're out of everything else.
+        page = take_zeroed_user_physical_page();
+    }
+
     if (!page) {
         // We didn't have a single free physical page. Let's try to free something up!
         // First, we look for a purgeable VMObject in the volatile state.
@@ -660,6 +897,11 @@ RefPtr<PhysicalPage> MemoryManager::allocate_user_physical_page(ShouldZeroFill s
             }
             return IterationDecision::Continue;
         });
+        if (!page && evict_cold_anonymous_pages(eviction_batch_size)) {
+            // Like purging, eviction may have touched page tables through quickmap_pd().
+            page = find_free_user_physical_page(false);
+            purged_pages = true;
+        }
         if (!page) {
             dmesgln("MM: no user physical pages available");
             return {};
@@ -705,7 +947,7 @@ NonnullRefPtrVector<PhysicalPage> MemoryManager::allocate_contiguous_supervisor_
     for (auto& region : m_super_physical_regions) {
         physical_pages = region.take_contiguous_free_pages(count, true, physical_alignment);
         if (!physical_pages.is_empty())
-            continue;
+            break;
     }
 
     if (physical_pages.is_empty()) {
@@ -724,6 +966,35 @@ NonnullRefPtrVector<PhysicalPage> MemoryManager::allocate_contiguous_supervisor_
     return physical_pages;
 }
 
+NonnullRefPtrVector<PhysicalPage> MemoryManager::allocate_contiguous_user_physical_pages(size_t size, size_t physical_alignment)
+{
+    VERIFY(!(size % PAGE_SIZE));
+    size_t count = ceil_div(size, PAGE_SIZE);
+    if (!commit_user_physical_pages(count))
+        return {};
+
+    ScopedSpinLock lock(s_mm_lock);
+    NonnullRefPtrVector<PhysicalPage> physical_pages;
+    for (auto& region : m_user_physical_regions) {
+        physical_pages = region.take_contiguous_free_pages(count, false, physical_alignment);
+        if (!physical_pages.is_empty())
+            break;
+    }
+
+    if (physical_pages.is_empty()) {
+        uncommit_user_physical_pages(count);
+        return {};
+    }
+
+    // These pages are handed out right away, so they leave the committed pool immediately.
+    m_user_physical_pages_committed -= count;
+    m_user_physical_pages_used += count;
+
+    auto cleanup_region = MM.allocate_kernel_region(physical_pages[0].paddr(), PAGE_SIZE * count, "MemoryManager Allocation Sanitization", Region::Access::Read | Region::Access::Write);
+    fast_u32_fill((u32*)cleanup_region->vaddr().as_ptr(), 0, (PAGE_SIZE * count) / sizeof(u32));
+    return physical_pages;
+}
+
 RefPtr<PhysicalPage> MemoryManager::allocate_supervisor_physical_page()
 {
     ScopedSpinLock lock(s_mm_lock);
@@ -762,7 +1033,7 @@ void MemoryManager::enter_space(Space& space)
     ScopedSpinLock lock(s_mm_lock);
 
     current_thread->tss().cr3 = space.page_directory().cr3();
-    write_cr3(space.page_directory().cr3());
+    Processor::load_page_directory(space.page_directory().cr3());
 }
 
 void MemoryManager::flush_tlb_local(VirtualAddress vaddr, size_t page_count)
@@ -867,7 +1138,6 @@ bool MemoryManager::validate_user_stack(const Process& process, VirtualAddress v
 {
     if (!is_user_address(vaddr))
         return false;
-    ScopedSpinLock lock(s_mm_lock);
     auto* region = user_region_from_vaddr(const_cast<Process&>(process).space(), vaddr);
     return region && region->is_user() && region->is_stack();
 }
@@ -107,6 +107,25 @@ struct PhysicalMemoryRange {
 
 const LogStream& operator<<(const LogStream& stream, const UsedMemoryRange& value);
 
+enum class MemoryPressureLevel {
+    Low,
+    Medium,
+    Critical,
+};
+
+inline StringView to_string(MemoryPressureLevel level)
+{
+    switch (level) {
+    case MemoryPressureLevel::Low:
+        return "low";
+    case MemoryPressureLevel::Medium:
+        return "medium";
+    case MemoryPressureLevel::Critical:
+        return "critical";
+    }
+    VERIFY_NOT_REACHED();
+}
+
 #define MM Kernel::MemoryManager::the()
 
 struct MemoryManagerData {
@@ -121,11 +140,15 @@ extern RecursiveSpinLock s_mm_lock;
 
 class MemoryManager {
     AK_MAKE_ETERNAL
+    friend class CompressedPageStore;
     friend class PageDirectory;
     friend class PhysicalPage;
     friend class PhysicalRegion;
     friend class AnonymousVMObject;
+    friend class InodeVMObject;
     friend class Region;
+    friend class SharedImageCache;
+    friend class TmpFSInode;
     friend class VMObject;
 
 public:
@@ -160,9 +183,29 @@ public:
     RefPtr<PhysicalPage> allocate_user_physical_page(ShouldZeroFill = ShouldZeroFill::Yes, bool* did_purge = nullptr);
     RefPtr<PhysicalPage> allocate_supervisor_physical_page();
     NonnullRefPtrVector<PhysicalPage> allocate_contiguous_supervisor_physical_pages(size_t size, size_t physical_alignment = PAGE_SIZE);
+    NonnullRefPtrVector<PhysicalPage> allocate_contiguous_user_physical_pages(size_t size, size_t physical_alignment = PAGE_SIZE);
     void deallocate_user_physical_page(const PhysicalPage&);
     void deallocate_supervisor_physical_page(const PhysicalPage&);
 
+    // Zero-filled user page allocations are served from a pool of pre-zeroed pages,
+    // which PageZeroingTask keeps topped up in the background.
+    static constexpr size_t zeroed_user_physical_page_pool_size = 64;
+    void refill_zeroed_user_physical_page_pool();
+    WaitQueue& zeroed_user_physical_page_pool_wait_queue() { return *m_zeroed_user_physical_page_pool_wait_queue; }
+
+    // Moves up to page_count anonymous pages that haven't been accessed recently
+    // into the CompressedPageStore and returns how many pages were evicted.
+    static constexpr size_t eviction_batch_size = 32;
+    size_t evict_cold_anonymous_pages(size_t page_count);
+
+    // The pressure level is recomputed whenever the amount of available memory changes,
+    // and the wait queue is woken when it has changed.
+    MemoryPressureLevel memory_pressure_level() const { return m_memory_pressure_level; }
+    WaitQueue& memory_pressure_wait_queue() { return *m_memory_pressure_wait_queue; }
+
+    size_t purge_all_volatile_memory();
+    size_t release_all_clean_inode_pages();
+
     OwnPtr<Region> allocate_contiguous_kernel_region(size_t, String name, u8 access, size_t physical_alignment = PAGE_SIZE, Region::Cacheable = Region::Cacheable::Yes);
     OwnPtr<Region> allocate_kernel_region(size_t, String name, u8 access, AllocationStrategy strategy = AllocationStrategy::Reserve, Region::Cacheable = Region::Cacheable::Yes);
     OwnPtr<Region> allocate_kernel_region(PhysicalAddress, size_t, String name, u8 access, Region::Cacheable = Region::Cacheable::Yes);
@@ -192,6 +235,7 @@ public:
 
     PhysicalPage& shared_zero_page() { return *m_shared_zero_page; }
     PhysicalPage& lazy_committed_page() { return *m_lazy_committed_page; }
+    PhysicalPage& compressed_page() { return *m_compressed_page; }
 
     PageDirectory& kernel_page_directory() { return *m_kernel_page_directory; }
 
@@ -220,6 +264,8 @@ private:
     static Region* find_region_from_vaddr(VirtualAddress);
 
     RefPtr<PhysicalPage> find_free_user_physical_page(bool);
+    void update_memory_pressure_level();
+    RefPtr<PhysicalPage> take_zeroed_user_physical_page();
     u8* quickmap_page(PhysicalPage&);
     void unquickmap_page();
 
@@ -229,11 +275,14 @@ private:
     PageTableEntry* pte(PageDirectory&, VirtualAddress);
     PageTableEntry* ensure_pte(PageDirectory&, VirtualAddress);
     void release_pte(PageDirectory&, VirtualAddress, bool);
+    PageDirectoryEntry* ensure_huge_pde(PageDirectory&, VirtualAddress);
+    bool release_huge_pde(PageDirectory&, VirtualAddress);
 
     RefPtr<PageDirectory> m_kernel_page_directory;
 
     RefPtr<PhysicalPage> m_shared_zero_page;
     RefPtr<PhysicalPage> m_lazy_committed_page;
+    RefPtr<PhysicalPage> m_compressed_page;
 
     Atomic<unsigned, AK::MemoryOrder::memory_order_relaxed> m_user_physical_pages { 0 };
     Atomic<unsigned, AK::MemoryOrder::memory_order_relaxed> m_user_physical_pages_used { 0 };
@@ -243,6 +292,10 @@ private:
     Atomic<unsigned, AK::MemoryOrder::memory_order_relaxed> m_super_physical_pages_used { 0 };
 
     NonnullRefPtrVector<PhysicalRegion> m_user_physical_regions;
+    NonnullRefPtrVector<PhysicalPage> m_zeroed_user_physical_pages;
+    WaitQueue* m_zeroed_user_physical_page_pool_wait_queue { nullptr };
+    MemoryPressureLevel m_memory_pressure_level { MemoryPressureLevel::Low };
+    WaitQueue* m_memory_pressure_wait_queue { nullptr };
     NonnullRefPtrVector<PhysicalRegion> m_super_physical_regions;
 
     InlineLinkedList<Region> m_user_regions;
@@ -297,4 +350,9 @@ inline bool PhysicalPage::is_lazy_committed_page() const
     return this == &MM.lazy_committed_page();
 }
 
+inline bool PhysicalPage::is_compressed_page() const
+{
+    return this == &MM.compressed_page();
+}
+
 }
@@ -65,6 +65,7 @@ public:
 
     bool is_shared_zero_page() const;
     bool is_lazy_committed_page() const;
+    bool is_compressed_page() const;
 
 private:
     PhysicalPage(PhysicalAddress paddr, bool supervisor, bool may_return_to_freelist = true);
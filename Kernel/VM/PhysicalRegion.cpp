@@ -43,7 +43,6 @@ NonnullRefPtr<PhysicalRegion> PhysicalRegion::create(PhysicalAddress lower, Phys
 PhysicalRegion::PhysicalRegion(PhysicalAddress lower, PhysicalAddress upper)
     : m_lower(lower)
     , m_upper(upper)
-    , m_bitmap(Bitmap::create())
 {
 }
 
@@ -60,40 +59,125 @@ unsigned PhysicalRegion::finalize_capacity()
     VERIFY(!m_pages);
 
     m_pages = (m_upper.get() - m_lower.get()) / PAGE_SIZE;
-    m_bitmap.grow(m_pages, false);
+
+    // Block numbers are relative to the closest max_order-aligned page below m_lower,
+    // so that a block's alignment in the region is also its physical alignment.
+    m_block_base_offset = (m_lower.get() / PAGE_SIZE) & (max_order_block_pages - 1);
+    size_t slot_count = m_block_base_offset + m_pages;
+    for (unsigned order = 0; order <= max_order; ++order) {
+        // Bitmap searches only look at whole bytes, so round up to keep every block visible.
+        size_t block_count = ceil_div(slot_count, (size_t)1 << order);
+        m_free_blocks.append(Bitmap::create(ceil_div(block_count, (size_t)32) * 32, false));
+    }
+    free_range(0, m_pages);
 
     return size();
 }
 
-NonnullRefPtrVector<PhysicalPage> PhysicalRegion::take_contiguous_free_pages(size_t count, bool supervisor, size_t physical_alignment)
+void PhysicalRegion::set_block_free(unsigned order, size_t block, bool free)
 {
-    VERIFY(m_pages);
-    VERIFY(m_used != m_pages);
+    VERIFY(m_free_blocks[order].get(block) != free);
+    m_free_blocks[order].set(block, free);
+    if (free) {
+        ++m_free_block_count[order];
+        m_free_block_hint[order] = block;
+    } else {
+        --m_free_block_count[order];
+    }
+}
 
-    NonnullRefPtrVector<PhysicalPage> physical_pages;
-    physical_pages.ensure_capacity(count);
+void PhysicalRegion::free_block(size_t block, unsigned order)
+{
+    // Merge with our buddy for as long as it is free as well.
+    while (order < max_order) {
+        size_t buddy = block ^ 1;
+        if (buddy >= m_free_blocks[order].size() || !m_free_blocks[order].get(buddy))
+            break;
+        set_block_free(order, buddy, false);
+        block >>= 1;
+        ++order;
+    }
+    set_block_free(order, block, true);
+}
 
-    auto first_contiguous_page = find_contiguous_free_pages(count, physical_alignment);
+void PhysicalRegion::free_range(unsigned page_index, size_t count)
+{
+    // Split the range into the largest naturally aligned blocks that fit.
+    while (count) {
+        size_t slot = m_block_base_offset + page_index;
+        unsigned order = max_order;
+        while (order && ((slot & ((1u << order) - 1)) || ((size_t)1 << order) > count))
+            --order;
+        free_block(slot >> order, order);
+        page_index += 1u << order;
+        count -= 1u << order;
+    }
+}
 
-    for (size_t index = 0; index < count; index++)
-        physical_pages.append(PhysicalPage::create(m_lower.offset(PAGE_SIZE * (index + first_contiguous_page)), supervisor));
-    return physical_pages;
+Optional<unsigned> PhysicalRegion::allocate_block(unsigned order)
+{
+    unsigned found_order = order;
+    while (found_order <= max_order && !m_free_block_count[found_order])
+        ++found_order;
+    if (found_order > max_order)
+        return {};
+
+    auto block = m_free_blocks[found_order].find_one_anywhere_set(m_free_block_hint[found_order]);
+    VERIFY(block.has_value());
+    set_block_free(found_order, block.value(), false);
+
+    // Split the block down to the requested order, keeping the lower half every time.
+    size_t slot = block.value() << found_order;
+    while (found_order > order) {
+        --found_order;
+        set_block_free(found_order, (slot >> found_order) + 1, true);
+    }
+    return slot - m_block_base_offset;
 }
 
-unsigned PhysicalRegion::find_contiguous_free_pages(size_t count, size_t physical_alignment)
+Optional<unsigned> PhysicalRegion::allocate_max_order_block_run(size_t block_count, unsigned alignment)
 {
+    // Requests larger than our biggest block need a run of adjacent max-order blocks.
+    auto& bitmap = m_free_blocks[max_order];
+    size_t alignment_in_blocks = max((size_t)1, alignment / max_order_block_pages);
+    size_t first_physical_block = (m_lower.get() / PAGE_SIZE) >> max_order;
+    size_t first = (alignment_in_blocks - first_physical_block % alignment_in_blocks) % alignment_in_blocks;
+    for (; first + block_count <= bitmap.size(); first += alignment_in_blocks) {
+        if (bitmap.count_in_range(first, block_count, true) != block_count)
+            continue;
+        for (size_t i = 0; i < block_count; ++i)
+            set_block_free(max_order, first + i, false);
+        return first * max_order_block_pages - m_block_base_offset;
+    }
+    return {};
+}
+
+NonnullRefPtrVector<PhysicalPage> PhysicalRegion::take_contiguous_free_pages(size_t count, bool supervisor, size_t physical_alignment)
+{
+    VERIFY(m_pages);
     VERIFY(count != 0);
     VERIFY(physical_alignment % PAGE_SIZE == 0);
-    // search from the last page we allocated
-    auto range = find_and_allocate_contiguous_range(count, physical_alignment / PAGE_SIZE);
-    VERIFY(range.has_value());
-    return range.value();
+
+    auto first_contiguous_page = find_and_allocate_contiguous_range(count, physical_alignment / PAGE_SIZE);
+    if (!first_contiguous_page.has_value() && !m_recently_returned.is_empty()) {
+        // The return queue may be holding on to exactly the pages we need.
+        drain_recently_returned();
+        first_contiguous_page = find_and_allocate_contiguous_range(count, physical_alignment / PAGE_SIZE);
+    }
+    if (!first_contiguous_page.has_value())
+        return {};
+
+    NonnullRefPtrVector<PhysicalPage> physical_pages;
+    physical_pages.ensure_capacity(count);
+    for (size_t index = 0; index < count; index++)
+        physical_pages.append(PhysicalPage::create(m_lower.offset(PAGE_SIZE * (index + first_contiguous_page.value())), supervisor));
+    return physical_pages;
 }
 
 Optional<unsigned> PhysicalRegion::find_one_free_page()
 {
     if (m_used == m_pages) {
-        // We know we don't have any free pages, no need to check the bitmap
+        // We know we don't have any free pages, no need to check the free lists
         // Check if we can draw one from the return queue
         if (m_recently_returned.size() > 0) {
             u8 index = get_fast_random<u8>() % m_recently_returned.size();
@@ -106,42 +190,40 @@ Optional<unsigned> PhysicalRegion::find_one_free_page()
         }
         return {};
     }
-    auto free_index = m_bitmap.find_one_anywhere_unset(m_free_hint);
-    if (!free_index.has_value())
-        return {};
-
-    auto page_index = free_index.value();
-    m_bitmap.set(page_index, true);
+    auto page_index = allocate_block(0);
+    VERIFY(page_index.has_value());
     m_used++;
-    m_free_hint = free_index.value() + 1; // Just a guess
-    if (m_free_hint >= m_bitmap.size())
-        m_free_hint = 0;
     return page_index;
 }
 
 Optional<unsigned> PhysicalRegion::find_and_allocate_contiguous_range(size_t count, unsigned alignment)
 {
     VERIFY(count != 0);
-    size_t found_pages_count = 0;
-    // TODO: Improve how we deal with alignment != 1
-    auto first_index = m_bitmap.find_longest_range_of_unset_bits(count + alignment - 1, found_pages_count);
-    if (!first_index.has_value())
+    if (count > m_pages - m_used)
         return {};
 
-    auto page = first_index.value();
-    if (alignment != 1) {
-        auto lower_page = m_lower.get() / PAGE_SIZE;
-        page = ((lower_page + page + alignment - 1) & ~(alignment - 1)) - lower_page;
-    }
-    if (found_pages_count >= count) {
-        m_bitmap.set_range<true>(page, count);
-        m_used += count;
-        m_free_hint = first_index.value() + count + 1; // Just a guess
-        if (m_free_hint >= m_bitmap.size())
-            m_free_hint = 0;
-        return page;
+    // Buddy blocks are naturally aligned, so the order also has to cover the alignment.
+    unsigned order = 0;
+    while (order <= max_order && (((size_t)1 << order) < count || (1u << order) < alignment))
+        ++order;
+
+    Optional<unsigned> page;
+    size_t allocated_pages;
+    if (order <= max_order) {
+        page = allocate_block(order);
+        allocated_pages = (size_t)1 << order;
+    } else {
+        size_t block_count = ceil_div(count, max_order_block_pages);
+        page = allocate_max_order_block_run(block_count, alignment);
+        allocated_pages = block_count * max_order_block_pages;
     }
-    return {};
+    if (!page.has_value())
+        return {};
+
+    // Give back the part of the block that we don't need.
+    free_range(page.value() + count, allocated_pages - count);
+    m_used += count;
+    return page;
 }
 
 RefPtr<PhysicalPage> PhysicalRegion::take_free_page(bool supervisor)
@@ -169,11 +251,17 @@ void PhysicalRegion::free_page_at(PhysicalAddress addr)
     VERIFY(local_offset.value() < (FlatPtr)(m_pages * PAGE_SIZE));
 
     auto page = local_offset.value() / PAGE_SIZE;
-    m_bitmap.set(page, false);
-    m_free_hint = page; // We know we can find one here for sure
+    free_block(m_block_base_offset + page, 0);
     m_used--;
 }
 
+void PhysicalRegion::drain_recently_returned()
+{
+    for (auto& paddr : m_recently_returned)
+        free_page_at(paddr);
+    m_recently_returned.clear_with_capacity();
+}
+
 void PhysicalRegion::return_page(const PhysicalPage& page)
 {
     auto returned_count = m_recently_returned.size();
@@ -56,10 +56,21 @@ public:
     void return_page(const PhysicalPage& page);
 
 private:
-    unsigned find_contiguous_free_pages(size_t count, size_t physical_alignment = PAGE_SIZE);
+    // Free pages are managed by a binary buddy allocator: a free block of order N spans
+    // 2^N pages and starts at a physical page number that is a multiple of 2^N.
+    static constexpr unsigned max_order = 10;
+    static constexpr size_t max_order_block_pages = 1u << max_order;
+
     Optional<unsigned> find_and_allocate_contiguous_range(size_t count, unsigned alignment = 1);
     Optional<unsigned> find_one_free_page();
     void free_page_at(PhysicalAddress addr);
+    void drain_recently_returned();
+
+    Optional<unsigned> allocate_block(unsigned order);
+    Optional<unsigned> allocate_max_order_block_run(size_t block_count, unsigned alignment);
+    void free_block(size_t block, unsigned order);
+    void free_range(unsigned page_index, size_t count);
+    void set_block_free(unsigned order, size_t block, bool free);
 
     PhysicalRegion(PhysicalAddress lower, PhysicalAddress upper);
 
@@ -67,8 +78,11 @@ private:
     PhysicalAddress m_upper;
     unsigned m_pages { 0 };
     unsigned m_used { 0 };
-    Bitmap m_bitmap;
-    size_t m_free_hint { 0 };
+    // Number of pages between the first max_order-aligned page and m_lower.
+    unsigned m_block_base_offset { 0 };
+    Vector<Bitmap, max_order + 1> m_free_blocks;
+    size_t m_free_block_count[max_order + 1] {};
+    size_t m_free_block_hint[max_order + 1] {};
     Vector<PhysicalAddress, 256> m_recently_returned;
 };
 
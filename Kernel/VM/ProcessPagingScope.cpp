@@ -40,7 +40,7 @@ ProcessPagingScope::~ProcessPagingScope()
 {
     InterruptDisabler disabler;
     Thread::current()->tss().cr3 = m_previous_cr3;
-    write_cr3(m_previous_cr3);
+    Processor::load_page_directory(m_previous_cr3);
 }
 
 }
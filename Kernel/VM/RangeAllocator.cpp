@@ -24,9 +24,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <AK/BinarySearch.h>
 #include <AK/Checked.h>
-#include <AK/QuickSort.h>
 #include <Kernel/Random.h>
 #include <Kernel/Thread.h>
 #include <Kernel/VM/RangeAllocator.h>
@@ -43,14 +41,16 @@ RangeAllocator::RangeAllocator()
 void RangeAllocator::initialize_with_range(VirtualAddress base, size_t size)
 {
     m_total_range = { base, size };
-    m_available_ranges.append({ base, size });
+    m_available_ranges.insert(base.get(), Range { base, size });
 }
 
 void RangeAllocator::initialize_from_parent(const RangeAllocator& parent_allocator)
 {
     ScopedSpinLock lock(parent_allocator.m_lock);
     m_total_range = parent_allocator.m_total_range;
-    m_available_ranges = parent_allocator.m_available_ranges;
+    m_available_ranges.clear();
+    for (auto it = parent_allocator.m_available_ranges.begin(); it != parent_allocator.m_available_ranges.end(); ++it)
+        m_available_ranges.insert(it.key(), *it);
 }
 
 RangeAllocator::~RangeAllocator()
@@ -66,16 +66,14 @@ void RangeAllocator::dump() const
     }
 }
 
-void RangeAllocator::carve_at_index(int index, const Range& range)
+void RangeAllocator::carve_from_range(const Range& from, const Range& range)
 {
     VERIFY(m_lock.is_locked());
-    auto remaining_parts = m_available_ranges[index].carve(range);
-    VERIFY(remaining_parts.size() >= 1);
-    VERIFY(m_total_range.contains(remaining_parts[0]));
-    m_available_ranges[index] = remaining_parts[0];
-    if (remaining_parts.size() == 2) {
-        VERIFY(m_total_range.contains(remaining_parts[1]));
-        m_available_ranges.insert(index + 1, move(remaining_parts[1]));
+    auto remaining_parts = from.carve(range);
+    m_available_ranges.remove(from.base().get());
+    for (auto& part : remaining_parts) {
+        VERIFY(m_total_range.contains(part));
+        m_available_ranges.insert(part.base().get(), part);
     }
 }
 
@@ -127,8 +125,9 @@ Optional<Range> RangeAllocator::allocate_anywhere(size_t size, size_t alignment)
         return {};
 
     ScopedSpinLock lock(m_lock);
-    for (size_t i = 0; i < m_available_ranges.size(); ++i) {
-        auto& available_range = m_available_ranges[i];
+    // FIXME: This is still a first-fit scan in address order. Augmenting the tree
+    //        with the largest free range in each subtree would make this O(log n) too.
+    for (auto& available_range : m_available_ranges) {
         // FIXME: This check is probably excluding some valid candidates when using a large alignment.
         if (available_range.size() < (effective_size + alignment))
             continue;
@@ -139,11 +138,7 @@ Optional<Range> RangeAllocator::allocate_anywhere(size_t size, size_t alignment)
         Range allocated_range(VirtualAddress(aligned_base), size);
         VERIFY(m_total_range.contains(allocated_range));
 
-        if (available_range == allocated_range) {
-            m_available_ranges.remove(i);
-            return allocated_range;
-        }
-        carve_at_index(i, allocated_range);
+        carve_from_range(Range(available_range), allocated_range);
         return allocated_range;
     }
     dmesgln("RangeAllocator: Failed to allocate anywhere: size={}, alignment={}", size, alignment);
@@ -160,19 +155,13 @@ Optional<Range> RangeAllocator::allocate_specific(VirtualAddress base, size_t si
 
     Range allocated_range(base, size);
     ScopedSpinLock lock(m_lock);
-    for (size_t i = 0; i < m_available_ranges.size(); ++i) {
-        auto& available_range = m_available_ranges[i];
-        VERIFY(m_total_range.contains(allocated_range));
-        if (!available_range.contains(base, size))
-            continue;
-        if (available_range == allocated_range) {
-            m_available_ranges.remove(i);
-            return allocated_range;
-        }
-        carve_at_index(i, allocated_range);
-        return allocated_range;
-    }
-    return {};
+    VERIFY(m_total_range.contains(allocated_range));
+    // Available ranges never overlap, so the only candidate is the last one starting at or below base.
+    auto* available_range = m_available_ranges.find_largest_not_above(base.get());
+    if (!available_range || !available_range->contains(base, size))
+        return {};
+    carve_from_range(Range(*available_range), allocated_range);
+    return allocated_range;
 }
 
 void RangeAllocator::deallocate(const Range& range)
@@ -182,37 +171,25 @@ void RangeAllocator::deallocate(const Range& range)
     VERIFY(range.size());
     VERIFY((range.size() % PAGE_SIZE) == 0);
     VERIFY(range.base() < range.end());
-    VERIFY(!m_available_ranges.is_empty());
-
-    size_t nearby_index = 0;
-    auto* existing_range = binary_search(
-        m_available_ranges.span(),
-        range,
-        &nearby_index,
-        [](auto& a, auto& b) { return a.base().get() - b.end().get(); });
-
-    size_t inserted_index = 0;
-    if (existing_range) {
-        existing_range->m_size += range.size();
-        inserted_index = nearby_index;
-    } else {
-        m_available_ranges.insert_before_matching(
-            Range(range), [&](auto& entry) {
-                return entry.base() >= range.end();
-            },
-            nearby_index, &inserted_index);
-    }
 
-    if (inserted_index < (m_available_ranges.size() - 1)) {
-        // We already merged with previous. Try to merge with next.
-        auto& inserted_range = m_available_ranges[inserted_index];
-        auto& next_range = m_available_ranges[inserted_index + 1];
-        if (inserted_range.end() == next_range.base()) {
-            inserted_range.m_size += next_range.size();
-            m_available_ranges.remove(inserted_index + 1);
-            return;
+    Range merged_range = range;
+
+    // Merge with the available range immediately before us, if any.
+    if (auto* previous_range = m_available_ranges.find_largest_not_above(range.base().get())) {
+        VERIFY(previous_range->end() <= range.base());
+        if (previous_range->end() == range.base()) {
+            merged_range = Range(previous_range->base(), previous_range->size() + range.size());
+            m_available_ranges.remove(previous_range->base().get());
         }
     }
+
+    // ...and with the one immediately after us.
+    if (auto* next_range = m_available_ranges.find(range.end().get())) {
+        merged_range = Range(merged_range.base(), merged_range.size() + next_range->size());
+        m_available_ranges.remove(range.end().get());
+    }
+
+    m_available_ranges.insert(merged_range.base().get(), merged_range);
 }
 
 }
@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <AK/RedBlackTree.h>
 #include <AK/Traits.h>
 #include <AK/Vector.h>
 #include <Kernel/SpinLock.h>
@@ -55,9 +56,10 @@ public:
     }
 
 private:
-    void carve_at_index(int, const Range&);
+    void carve_from_range(const Range& from, const Range&);
 
-    Vector<Range> m_available_ranges;
+    // Available ranges, keyed by their base address.
+    RedBlackTree<FlatPtr, Range> m_available_ranges;
     Range m_total_range;
     mutable SpinLock<u8> m_lock;
 };
@@ -39,6 +39,9 @@
 
 namespace Kernel {
 
+u32 g_inode_fault_around_page_count = 16;
+u32 g_inode_sequential_read_ahead_page_count = 64;
+
 Region::Region(const Range& range, NonnullRefPtr<VMObject> vmobject, size_t offset_in_vmobject, String name, u8 access, Cacheable cacheable, bool shared)
     : PurgeablePageRanges(vmobject)
     , m_range(range)
@@ -110,6 +113,7 @@ OwnPtr<Region> Region::clone(Process& new_owner)
         region->set_mmap(m_mmap);
         region->set_shared(m_shared);
         region->set_syscall_region(is_syscall_region());
+        region->set_access_pattern(m_access_pattern);
         return region;
     }
 
@@ -121,7 +125,10 @@ OwnPtr<Region> Region::clone(Process& new_owner)
         return {};
 
     // Set up a COW region. The parent (this) region becomes COW as well!
-    remap();
+    if (m_vmobject->is_anonymous())
+        write_protect_cow_pages();
+    else
+        remap();
     auto clone_region = Region::create_user_accessible(
         &new_owner, m_range, vmobject_clone.release_nonnull(), m_offset_in_vmobject, m_name, m_access, m_cacheable ? Cacheable::Yes : Cacheable::No, m_shared);
     if (m_vmobject->is_anonymous())
@@ -134,6 +141,7 @@ OwnPtr<Region> Region::clone(Process& new_owner)
     }
     clone_region->set_syscall_region(is_syscall_region());
     clone_region->set_mmap(m_mmap);
+    clone_region->set_access_pattern(m_access_pattern);
     return clone_region;
 }
 
@@ -211,7 +219,7 @@ size_t Region::amount_resident() const
     size_t bytes = 0;
     for (size_t i = 0; i < page_count(); ++i) {
         auto* page = physical_page(i);
-        if (page && !page->is_shared_zero_page() && !page->is_lazy_committed_page())
+        if (page && !page->is_shared_zero_page() && !page->is_lazy_committed_page() && !page->is_compressed_page())
             bytes += PAGE_SIZE;
     }
     return bytes;
@@ -222,7 +230,7 @@ size_t Region::amount_shared() const
     size_t bytes = 0;
     for (size_t i = 0; i < page_count(); ++i) {
         auto* page = physical_page(i);
-        if (page && page->ref_count() > 1 && !page->is_shared_zero_page() && !page->is_lazy_committed_page())
+        if (page && page->ref_count() > 1 && !page->is_shared_zero_page() && !page->is_lazy_committed_page() && !page->is_compressed_page())
             bytes += PAGE_SIZE;
     }
     return bytes;
@@ -269,7 +277,7 @@ bool Region::map_individual_page_impl(size_t page_index)
     if (!pte)
         return false;
     auto* page = physical_page(page_index);
-    if (!page || (!is_readable() && !is_writable())) {
+    if (!page || page->is_compressed_page() || (!is_readable() && !is_writable())) {
         pte->clear();
     } else {
         pte->set_cache_disabled(!m_cacheable);
@@ -286,6 +294,47 @@ bool Region::map_individual_page_impl(size_t page_index)
     return true;
 }
 
+bool Region::can_map_huge_page(size_t page_index) const
+{
+    // Only physically contiguous VMObjects are guaranteed to never have individual pages
+    // remapped later on (by CoW, purging, lazy commits, ...), which a huge page can't do.
+    if (!vmobject().is_contiguous())
+        return false;
+    if (page_index + HUGE_PAGE_SIZE / PAGE_SIZE > page_count())
+        return false;
+    if (vaddr_from_page_index(page_index).get() % HUGE_PAGE_SIZE)
+        return false;
+    auto* page = physical_page(page_index);
+    return page && !(page->paddr().get() % HUGE_PAGE_SIZE);
+}
+
+bool Region::map_huge_page_impl(size_t page_index)
+{
+    VERIFY(m_page_directory->get_lock().own_lock());
+    auto page_vaddr = vaddr_from_page_index(page_index);
+
+    bool user_allowed = page_vaddr.get() >= 0x00800000 && is_user_address(page_vaddr);
+    if (is_mmap() && !user_allowed) {
+        PANIC("About to map mmap'ed page at a kernel address");
+    }
+
+    auto* pde = MM.ensure_huge_pde(*m_page_directory, page_vaddr);
+    if (!pde)
+        return false;
+    // For huge pages, the page table base holds the address of the 2 MiB physical page.
+    pde->set_page_table_base(physical_page(page_index)->paddr().get());
+    pde->set_huge(true);
+    pde->set_cache_disabled(!m_cacheable);
+    // Like individual pages, inaccessible huge pages stay non-present so that accesses fault.
+    pde->set_present(is_readable() || is_writable());
+    pde->set_writable(is_writable());
+    if (Processor::current().has_feature(CPUFeature::NX))
+        pde->set_execute_disabled(!is_executable());
+    pde->set_user_allowed(user_allowed);
+    pde->set_global(m_page_directory == &MM.kernel_page_directory());
+    return true;
+}
+
 bool Region::do_remap_vmobject_page_range(size_t page_index, size_t page_count)
 {
     bool success = true;
@@ -357,6 +406,23 @@ bool Region::remap_vmobject_page(size_t page_index, bool with_flush)
     return success;
 }
 
+bool Region::test_and_clear_accessed_bit(size_t page_index)
+{
+    VERIFY(s_mm_lock.own_lock());
+    if (!m_page_directory)
+        return false;
+    if (!translate_vmobject_page(page_index))
+        return false;
+    ScopedSpinLock page_lock(m_page_directory->get_lock());
+    auto* pte = MM.pte(*m_page_directory, vaddr_from_page_index(page_index));
+    if (!pte || !pte->is_present() || !pte->is_accessed())
+        return false;
+    // We don't flush the TLB here. A CPU that still has the entry cached won't
+    // set the bit again, so at worst the page is considered cold a bit early.
+    pte->set_accessed(false);
+    return true;
+}
+
 void Region::unmap(ShouldDeallocateVirtualMemoryRange deallocate_range)
 {
     ScopedSpinLock lock(s_mm_lock);
@@ -366,6 +432,10 @@ void Region::unmap(ShouldDeallocateVirtualMemoryRange deallocate_range)
     size_t count = page_count();
     for (size_t i = 0; i < count; ++i) {
         auto vaddr = vaddr_from_page_index(i);
+        if (!(vaddr.get() % HUGE_PAGE_SIZE) && i + HUGE_PAGE_SIZE / PAGE_SIZE <= count && MM.release_huge_pde(*m_page_directory, vaddr)) {
+            i += HUGE_PAGE_SIZE / PAGE_SIZE - 1;
+            continue;
+        }
         MM.release_pte(*m_page_directory, vaddr, i == count - 1);
     }
     MM.flush_tlb(m_page_directory, vaddr(), page_count());
@@ -398,6 +468,10 @@ bool Region::map(PageDirectory& page_directory)
     set_page_directory(page_directory);
     size_t page_index = 0;
     while (page_index < page_count()) {
+        if (can_map_huge_page(page_index) && map_huge_page_impl(page_index)) {
+            page_index += HUGE_PAGE_SIZE / PAGE_SIZE;
+            continue;
+        }
         if (!map_individual_page_impl(page_index))
             break;
         ++page_index;
@@ -409,13 +483,42 @@ bool Region::map(PageDirectory& page_directory)
     return false;
 }
 
+void Region::map_lazily(PageDirectory& page_directory)
+{
+    // Physically contiguous regions may use huge pages, which are only set up by map().
+    if (vmobject().is_contiguous()) {
+        map(page_directory);
+        return;
+    }
+    // Leave the page tables empty, handle_fault() maps pages in on first access.
+    ScopedSpinLock lock(s_mm_lock);
+    set_page_directory(page_directory);
+}
+
+void Region::write_protect_cow_pages()
+{
+    VERIFY(m_page_directory);
+    ScopedSpinLock lock(s_mm_lock);
+    ScopedSpinLock page_lock(m_page_directory->get_lock());
+    for (size_t i = 0; i < page_count(); ++i) {
+        // Pages without a writable mapping already fault on write, so leave them (and
+        // their possibly missing page tables) alone instead of remapping everything.
+        auto* pte = MM.pte(*m_page_directory, vaddr_from_page_index(i));
+        if (!pte || !pte->is_present() || !pte->is_writable())
+            continue;
+        if (should_cow(i))
+            pte->set_writable(false);
+    }
+    MM.flush_tlb(m_page_directory, vaddr(), page_count());
+}
+
 void Region::remap()
 {
     VERIFY(m_page_directory);
     map(*m_page_directory);
 }
 
-PageFaultResponse Region::handle_fault(const PageFault& fault, ScopedSpinLock<RecursiveSpinLock>& mm_lock)
+PageFaultResponse Region::handle_fault(const PageFault& fault, ScopedSpinLock<RecursiveSpinLock>& fault_lock)
 {
     auto page_index_in_region = page_index_from_address(fault.vaddr());
     if (fault.type() == PageFault::Type::PageNotPresent) {
@@ -429,14 +532,24 @@ PageFaultResponse Region::handle_fault(const PageFault& fault, ScopedSpinLock<Re
         }
         if (vmobject().is_inode()) {
             dbgln_if(PAGE_FAULT_DEBUG, "NP(inode) fault in Region({})[{}]", this, page_index_in_region);
-            return handle_inode_fault(page_index_in_region, mm_lock);
+            return handle_inode_fault(page_index_in_region, fault_lock);
         }
 
         auto& page_slot = physical_page_slot(page_index_in_region);
         if (page_slot->is_lazy_committed_page()) {
-            auto page_index_in_vmobject = translate_to_vmobject_page(page_index_in_region);
-            page_slot = static_cast<AnonymousVMObject&>(*m_vmobject).allocate_committed_page(page_index_in_vmobject);
-            remap_vmobject_page(page_index_in_vmobject);
+            // We don't hold s_mm_lock here, so let handle_zero_fault() commit
+            // the page under the VMObject's paging lock.
+            return handle_zero_fault(page_index_in_region);
+        }
+        if (page_slot->is_compressed_page()) {
+            dbgln_if(PAGE_FAULT_DEBUG, "NP(compressed) fault in Region({})[{}] at {}", this, page_index_in_region, fault.vaddr());
+            return handle_compressed_fault(page_index_in_region);
+        }
+        if (!page_slot.is_null()) {
+            // The page exists, it just wasn't mapped into this region yet (e.g. after fork).
+            dbgln_if(PAGE_FAULT_DEBUG, "NP(present) fault in Region({})[{}] at {}", this, page_index_in_region, fault.vaddr());
+            if (!remap_vmobject_page(translate_to_vmobject_page(page_index_in_region)))
+                return PageFaultResponse::OutOfMemory;
             return PageFaultResponse::Continue;
         }
 #ifdef MAP_SHARED_ZERO_PAGE_LAZILY
@@ -507,6 +620,28 @@ PageFaultResponse Region::handle_zero_fault(size_t page_index_in_region)
     return PageFaultResponse::Continue;
 }
 
+PageFaultResponse Region::handle_compressed_fault(size_t page_index_in_region)
+{
+    VERIFY_INTERRUPTS_DISABLED();
+    VERIFY(vmobject().is_anonymous());
+    auto current_thread = Thread::current();
+    if (current_thread)
+        current_thread->did_minor_fault();
+
+    LOCKER(vmobject().m_paging_lock);
+
+    auto page_index_in_vmobject = translate_to_vmobject_page(page_index_in_region);
+    auto response = static_cast<AnonymousVMObject&>(vmobject()).handle_compressed_page_fault(page_index_in_vmobject);
+    if (response != PageFaultResponse::Continue)
+        return response;
+
+    if (!remap_vmobject_page(page_index_in_vmobject)) {
+        klog() << "MM: handle_compressed_fault was unable to allocate a page table to map " << physical_page(page_index_in_region);
+        return PageFaultResponse::OutOfMemory;
+    }
+    return PageFaultResponse::Continue;
+}
+
 PageFaultResponse Region::handle_cow_fault(size_t page_index_in_region)
 {
     VERIFY_INTERRUPTS_DISABLED();
@@ -524,18 +659,20 @@ PageFaultResponse Region::handle_cow_fault(size_t page_index_in_region)
     return response;
 }
 
-PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region, ScopedSpinLock<RecursiveSpinLock>& mm_lock)
+PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region, ScopedSpinLock<RecursiveSpinLock>& fault_lock)
 {
     VERIFY_INTERRUPTS_DISABLED();
     VERIFY(vmobject().is_inode());
 
-    mm_lock.unlock();
+    // NOTE: fault_lock is either s_mm_lock (for kernel regions) or the lock
+    //       of the Space this region belongs to (for user regions).
+    fault_lock.unlock();
     VERIFY(!s_mm_lock.own_lock());
     VERIFY(!g_scheduler_lock.own_lock());
 
     LOCKER(vmobject().m_paging_lock);
 
-    mm_lock.lock();
+    fault_lock.lock();
 
     VERIFY_INTERRUPTS_DISABLED();
     auto& inode_vmobject = static_cast<InodeVMObject&>(vmobject());
@@ -546,58 +683,165 @@ PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region, Scoped
 
     if (!vmobject_physical_page_entry.is_null()) {
         dbgln_if(PAGE_FAULT_DEBUG, "MM: page_in_from_inode() but page already present. Fine with me!");
+        if (auto current_thread = Thread::current())
+            current_thread->did_minor_fault();
         if (!remap_vmobject_page(page_index_in_vmobject))
             return PageFaultResponse::OutOfMemory;
+        fault_around_cached_pages(page_index_in_vmobject);
         return PageFaultResponse::Continue;
     }
 
+    auto& inode = inode_vmobject.inode();
+
+    // Shared mappings of inodes that keep their contents in memory use those very pages.
+    if (inode_vmobject.is_shared_inode()) {
+        // Getting the page may block, so release the fault lock temporarily
+        fault_lock.unlock();
+        auto page = inode.shared_physical_page(page_index_in_vmobject);
+        fault_lock.lock();
+
+        if (page && page_index_in_vmobject < inode_vmobject.page_count()) {
+            auto& physical_page_entry = inode_vmobject.physical_pages()[page_index_in_vmobject];
+            if (physical_page_entry.is_null())
+                physical_page_entry = move(page);
+            if (auto current_thread = Thread::current())
+                current_thread->did_minor_fault();
+            if (!remap_vmobject_page(page_index_in_vmobject))
+                return PageFaultResponse::OutOfMemory;
+            fault_around_cached_pages(page_index_in_vmobject);
+            return PageFaultResponse::Continue;
+        }
+    }
+
     auto current_thread = Thread::current();
     if (current_thread)
         current_thread->did_inode_fault();
 
-    u8 page_buffer[PAGE_SIZE];
-    auto& inode = inode_vmobject.inode();
-
-    // Reading the page may block, so release the MM lock temporarily
-    mm_lock.unlock();
-    auto buffer = UserOrKernelBuffer::for_kernel_buffer(page_buffer);
-    auto nread = inode.read_bytes(page_index_in_vmobject * PAGE_SIZE, PAGE_SIZE, buffer, nullptr);
-    mm_lock.lock();
-
-    if (nread < 0) {
-        klog() << "MM: handle_inode_fault had error (" << nread << ") while reading!";
-        return PageFaultResponse::ShouldCrash;
-    }
-    if (nread < PAGE_SIZE) {
-        // If we read less than a page, zero out the rest to avoid leaking uninitialized data.
-        memset(page_buffer + nread, 0, PAGE_SIZE - nread);
+    // Read ahead the run of not-yet-cached pages following the faulting one, so that
+    // sequential access (e.g. the dynamic loader walking a large library) doesn't
+    // take a separate fault and a separate disk read for every single page.
+    size_t read_ahead_page_count = g_inode_fault_around_page_count;
+    if (m_access_pattern == AccessPattern::Sequential)
+        read_ahead_page_count = g_inode_sequential_read_ahead_page_count;
+    else if (m_access_pattern == AccessPattern::Random)
+        read_ahead_page_count = 1;
+    auto region_end_in_vmobject = first_page_index() + page_count();
+    size_t read_page_count = 1;
+    while (read_page_count < read_ahead_page_count) {
+        auto index = page_index_in_vmobject + read_page_count;
+        if (index >= region_end_in_vmobject || index >= inode_vmobject.page_count())
+            break;
+        if (!inode_vmobject.physical_pages()[index].is_null())
+            break;
+        ++read_page_count;
     }
 
-    vmobject_physical_page_entry = MM.allocate_user_physical_page(MemoryManager::ShouldZeroFill::No);
-    if (vmobject_physical_page_entry.is_null()) {
+    // The data is read straight into the pages that will end up in the VMObject.
+    // Read-ahead is best effort, so we only insist on getting the faulting page.
+    NonnullRefPtrVector<PhysicalPage> pages;
+    pages.ensure_capacity(read_page_count);
+    for (size_t i = 0; i < read_page_count; ++i) {
+        auto page = MM.allocate_user_physical_page(MemoryManager::ShouldZeroFill::No);
+        if (!page)
+            break;
+        pages.append(page.release_nonnull());
+    }
+    if (pages.is_empty()) {
         klog() << "MM: handle_inode_fault was unable to allocate a physical page";
         return PageFaultResponse::OutOfMemory;
     }
 
-    u8* dest_ptr = MM.quickmap_page(*vmobject_physical_page_entry);
-    {
-        void* fault_at;
-        if (!safe_memcpy(dest_ptr, page_buffer, PAGE_SIZE, fault_at)) {
-            if ((u8*)fault_at >= dest_ptr && (u8*)fault_at <= dest_ptr + PAGE_SIZE)
-                dbgln("      >> inode fault: error copying data to {}/{}, failed at {}",
-                    vmobject_physical_page_entry->paddr(),
-                    VirtualAddress(dest_ptr),
-                    VirtualAddress(fault_at));
-            else
-                VERIFY_NOT_REACHED();
+    // Reading the pages may block, so release the fault lock temporarily
+    fault_lock.unlock();
+    ssize_t nread;
+    auto read_vmobject = AnonymousVMObject::create_with_physical_pages(pages);
+    if (auto read_region = MM.allocate_kernel_region_with_vmobject(*read_vmobject, pages.size() * PAGE_SIZE, "Inode fault", Region::Access::Read | Region::Access::Write)) {
+        read_page_count = pages.size();
+        auto* data = read_region->vaddr().as_ptr();
+        auto buffer = UserOrKernelBuffer::for_kernel_buffer(data);
+        nread = inode.read_bytes(page_index_in_vmobject * PAGE_SIZE, read_page_count * PAGE_SIZE, buffer, nullptr);
+        if (nread >= 0 && (size_t)nread < read_page_count * PAGE_SIZE) {
+            // Zero out the rest to avoid leaking uninitialized data.
+            memset(data + nread, 0, read_page_count * PAGE_SIZE - nread);
+        }
+    } else {
+        // No kernel address space to map the pages into, make do with just the faulting page.
+        read_page_count = 1;
+        u8 page_buffer[PAGE_SIZE];
+        auto buffer = UserOrKernelBuffer::for_kernel_buffer(page_buffer);
+        nread = inode.read_bytes(page_index_in_vmobject * PAGE_SIZE, PAGE_SIZE, buffer, nullptr);
+        if (nread >= 0) {
+            memset(page_buffer + nread, 0, PAGE_SIZE - nread);
+            InterruptDisabler disabler;
+            u8* dest_ptr = MM.quickmap_page(pages[0]);
+            memcpy(dest_ptr, page_buffer, PAGE_SIZE);
+            MM.unquickmap_page();
         }
     }
-    MM.unquickmap_page();
+    fault_lock.lock();
+
+    if (nread < 0) {
+        klog() << "MM: handle_inode_fault had error (" << nread << ") while reading!";
+        return PageFaultResponse::ShouldCrash;
+    }
+
+    // The faulting page is always populated, even if it lies past the end of the file.
+    // Read-ahead pages are only populated if we actually got some data for them.
+    size_t populated_page_count = max((size_t)1, ceil_div((size_t)nread, PAGE_SIZE));
+    VERIFY(populated_page_count <= read_page_count);
+
+    for (size_t i = 0; i < populated_page_count; ++i) {
+        auto index = page_index_in_vmobject + i;
+        auto& physical_page_entry = inode_vmobject.physical_pages()[index];
+        if (!physical_page_entry.is_null())
+            continue;
+        physical_page_entry = pages[i];
+
+        // Read-ahead pages were not mapped anywhere before, so there is no need to
+        // flush the TLB or to touch other regions sharing this VMObject.
+        if (i != 0)
+            do_remap_vmobject_page(index, false);
+    }
 
     remap_vmobject_page(page_index_in_vmobject);
+    fault_around_cached_pages(page_index_in_vmobject);
     return PageFaultResponse::Continue;
 }
 
+size_t Region::discard_pages(size_t page_index, size_t page_count)
+{
+    auto page_index_in_vmobject = translate_to_vmobject_page(page_index);
+    size_t discarded_count = 0;
+    if (vmobject().is_anonymous()) {
+        discarded_count = static_cast<AnonymousVMObject&>(vmobject()).discard_pages(*this, page_index_in_vmobject, page_count);
+    } else if (vmobject().is_inode()) {
+        auto& inode_vmobject = static_cast<InodeVMObject&>(vmobject());
+        // Writes through shared mappings don't mark pages dirty, so the pages are all we've got.
+        if (inode_vmobject.is_shared_inode() && inode_vmobject.writable_mappings())
+            return 0;
+        discarded_count = inode_vmobject.release_clean_pages(*this, page_index_in_vmobject, page_count);
+    }
+    return discarded_count;
+}
+
+void Region::fault_around_cached_pages(size_t page_index_in_vmobject)
+{
+    // Map the pages surrounding the faulting one that are already cached in the VMObject,
+    // e.g. because another process mapping the same file has faulted them in before us.
+    // The window is aligned to g_inode_fault_around_page_count pages.
+    auto& vmobject = this->vmobject();
+    size_t window_size = g_inode_fault_around_page_count;
+    auto window_start = max(first_page_index(), page_index_in_vmobject - (page_index_in_vmobject % window_size));
+    auto window_end = min(min(window_start + window_size, first_page_index() + page_count()), vmobject.page_count());
+    for (auto index = window_start; index < window_end; ++index) {
+        if (index == page_index_in_vmobject || vmobject.physical_pages()[index].is_null())
+            continue;
+        // These pages were either not mapped by this region yet, or are being
+        // remapped to the very same physical page, so no TLB flush is needed.
+        do_remap_vmobject_page(index, false);
+    }
+}
+
 RefPtr<Process> Region::get_owner()
 {
     return m_owner.strong_ref();
@@ -42,6 +42,13 @@ namespace Kernel {
 class Inode;
 class VMObject;
 
+// Number of pages an inode fault maps around the faulting page, and reads ahead in regions
+// marked MADV_SEQUENTIAL. Tunable through /proc/sys/inode_fault_around and
+// /proc/sys/inode_sequential_read_ahead, within [1, max_inode_fault_page_count].
+static constexpr u32 max_inode_fault_page_count = 256;
+extern u32 g_inode_fault_around_page_count;
+extern u32 g_inode_sequential_read_ahead_page_count;
+
 class Region final
     : public InlineLinkedListNode<Region>
     , public Weakable<Region>
@@ -64,6 +71,14 @@ public:
         Yes,
     };
 
+    // How userspace expects to access the region, see MADV_SEQUENTIAL and MADV_RANDOM.
+    // This decides how far inode faults read ahead.
+    enum class AccessPattern : u8 {
+        Normal,
+        Sequential,
+        Random,
+    };
+
     static NonnullOwnPtr<Region> create_user_accessible(Process*, const Range&, NonnullRefPtr<VMObject>, size_t offset_in_vmobject, String name, u8 access, Cacheable, bool shared);
     static NonnullOwnPtr<Region> create_kernel_only(const Range&, NonnullRefPtr<VMObject>, size_t offset_in_vmobject, String name, u8 access, Cacheable = Cacheable::Yes);
 
@@ -99,6 +114,12 @@ public:
     bool is_mmap() const { return m_mmap; }
     void set_mmap(bool mmap) { m_mmap = mmap; }
 
+    AccessPattern access_pattern() const { return m_access_pattern; }
+    void set_access_pattern(AccessPattern access_pattern) { m_access_pattern = access_pattern; }
+
+    // Drops the pages that can be brought back on demand, see MADV_DONTNEED.
+    size_t discard_pages(size_t page_index, size_t page_count);
+
     bool is_user() const { return !is_kernel(); }
     bool is_kernel() const { return vaddr().get() < 0x00800000 || vaddr().get() >= 0xc0000000; }
 
@@ -216,6 +237,7 @@ public:
 
     void set_page_directory(PageDirectory&);
     bool map(PageDirectory&);
+    void map_lazily(PageDirectory&);
     enum class ShouldDeallocateVirtualMemoryRange {
         No,
         Yes,
@@ -229,6 +251,7 @@ public:
     Region* m_prev { nullptr };
 
     bool remap_vmobject_page_range(size_t page_index, size_t page_count);
+    bool test_and_clear_accessed_bit(size_t page_index_in_vmobject);
 
     bool is_volatile(VirtualAddress vaddr, size_t size) const;
     enum class SetVolatileError {
@@ -261,9 +284,14 @@ private:
 
     PageFaultResponse handle_cow_fault(size_t page_index);
     PageFaultResponse handle_inode_fault(size_t page_index, ScopedSpinLock<RecursiveSpinLock>&);
+    void fault_around_cached_pages(size_t page_index_in_vmobject);
     PageFaultResponse handle_zero_fault(size_t page_index);
+    PageFaultResponse handle_compressed_fault(size_t page_index);
 
     bool map_individual_page_impl(size_t page_index);
+    void write_protect_cow_pages();
+    bool can_map_huge_page(size_t page_index) const;
+    bool map_huge_page_impl(size_t page_index);
 
     void register_purgeable_page_ranges();
     void unregister_purgeable_page_ranges();
@@ -274,6 +302,7 @@ private:
     NonnullRefPtr<VMObject> m_vmobject;
     String m_name;
     u8 m_access { 0 };
+    AccessPattern m_access_pattern { AccessPattern::Normal };
     bool m_shared : 1 { false };
     bool m_cacheable : 1 { false };
     bool m_stack : 1 { false };
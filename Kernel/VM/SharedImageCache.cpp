@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/ByteBuffer.h>
+#include <AK/Singleton.h>
+#include <AK/StringImpl.h>
+#include <Kernel/Debug.h>
+#include <Kernel/FileSystem/Inode.h>
+#include <Kernel/VM/AnonymousVMObject.h>
+#include <Kernel/VM/MemoryManager.h>
+#include <Kernel/VM/PageDirectory.h>
+#include <Kernel/VM/Region.h>
+#include <Kernel/VM/SharedImageCache.h>
+#include <Kernel/VM/Space.h>
+
+namespace Kernel {
+
+static AK::Singleton<SharedImageCache> s_the;
+
+SharedImageCache& SharedImageCache::the()
+{
+    return *s_the;
+}
+
+SharedImageCache::SharedImageCache()
+{
+}
+
+size_t SharedImageCache::page_count() const
+{
+    ScopedSpinLock lock(m_lock);
+    return m_pages.size();
+}
+
+Optional<Range> SharedImageCache::allocate_range(Space& space, Inode& inode, size_t size)
+{
+    auto mtime = inode.metadata().mtime;
+    Optional<ImageBase> image_base;
+    {
+        ScopedSpinLock lock(m_lock);
+        auto it = m_image_bases.find(inode.identifier());
+        // If the file changed, the old address is as good as any other.
+        if (it != m_image_bases.end() && it->value.size == size && it->value.mtime == mtime)
+            image_base = it->value;
+    }
+
+    if (image_base.has_value()) {
+        if (auto range = space.allocate_range(image_base->base, size); range.has_value())
+            return range;
+        dbgln_if(SHARED_IMAGE_DEBUG, "SharedImageCache: {} is taken, can't map {} there", image_base->base, inode.identifier());
+    }
+
+    auto range = space.page_directory().range_allocator().allocate_randomized(size, PAGE_SIZE);
+    if (range.has_value() && !image_base.has_value()) {
+        ScopedSpinLock lock(m_lock);
+        m_image_bases.set(inode.identifier(), { range->base(), size, mtime });
+    }
+    return range;
+}
+
+void SharedImageCache::remove_unused_pages()
+{
+    // Don't let go of the pages while holding our lock, freeing them takes the MM lock.
+    NonnullRefPtrVector<PhysicalPage> unused_pages;
+    {
+        ScopedSpinLock lock(m_lock);
+        Vector<PageKey> unused_keys;
+        for (auto& it : m_pages) {
+            // Nobody but us holds on to the page anymore.
+            if (it.value->ref_count() == 1)
+                unused_keys.append(it.key);
+        }
+        for (auto& key : unused_keys) {
+            auto it = m_pages.find(key);
+            unused_pages.append(it->value);
+            m_pages.remove(it);
+        }
+    }
+}
+
+size_t SharedImageCache::share_pages(Region& region)
+{
+    VERIFY(region.vmobject().is_anonymous());
+    VERIFY(!region.is_writable() && !region.is_shared());
+    auto& vmobject = static_cast<AnonymousVMObject&>(region.vmobject());
+
+    remove_unused_pages();
+
+    auto buffer = ByteBuffer::create_uninitialized(PAGE_SIZE);
+    size_t shared_count = 0;
+    for (size_t i = 0; i < region.page_count(); ++i) {
+        // Holding the MM lock keeps the page from being evicted under us.
+        ScopedSpinLock mm_lock(s_mm_lock);
+        RefPtr<PhysicalPage> page = region.physical_page_slot(i);
+        if (!page || page->is_shared_zero_page() || page->is_lazy_committed_page() || page->is_compressed_page())
+            continue;
+
+        auto* ptr = MM.quickmap_page(*page);
+        memcpy(buffer.data(), ptr, PAGE_SIZE);
+        MM.unquickmap_page();
+
+        auto page_index = region.translate_to_vmobject_page(i);
+        PageKey key { region.vaddr().offset(i * PAGE_SIZE), string_hash((const char*)buffer.data(), PAGE_SIZE) };
+
+        ScopedSpinLock lock(m_lock);
+        auto it = m_pages.find(key);
+        if (it == m_pages.end()) {
+            // Whoever writes to the page from now on (after making it writable again) has to copy it first.
+            region.set_should_cow(i, true);
+            m_pages.set(key, page.release_nonnull());
+            continue;
+        }
+        auto& shared_page = it->value;
+        if (shared_page.ptr() == page.ptr())
+            continue;
+
+        ptr = MM.quickmap_page(shared_page);
+        bool is_identical = !memcmp(buffer.data(), ptr, PAGE_SIZE);
+        MM.unquickmap_page();
+        if (!is_identical)
+            continue;
+
+        if (vmobject.replace_with_shared_page(page_index, *page, shared_page)) {
+            region.remap_vmobject_page_range(page_index, 1);
+            ++shared_count;
+        }
+    }
+
+    dbgln_if(SHARED_IMAGE_DEBUG, "SharedImageCache: Shared {} of {} pages of {}", shared_count, region.page_count(), region.name());
+    return shared_count;
+}
+
+}
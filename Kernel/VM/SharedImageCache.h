@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/HashMap.h>
+#include <AK/NonnullRefPtr.h>
+#include <AK/Optional.h>
+#include <Kernel/FileSystem/FileSystem.h>
+#include <Kernel/SpinLock.h>
+#include <Kernel/UnixTypes.h>
+#include <Kernel/VM/PhysicalPage.h>
+#include <Kernel/VM/Range.h>
+
+namespace Kernel {
+
+class Inode;
+class Region;
+class Space;
+
+// Dynamic libraries that are loaded at the same address in every process end up with
+// the same pages after relocation (.got, .data.rel.ro). The SharedImageCache remembers
+// where each image was first mapped during this boot so that later processes can map it
+// there too, and lets them trade their read-only relocated pages for one shared copy.
+//
+// Pages are only ever shared after comparing their contents, so a process that had to
+// load a library elsewhere (or binds its symbols differently) just keeps its own copy.
+class SharedImageCache {
+    AK_MAKE_ETERNAL;
+
+public:
+    static SharedImageCache& the();
+
+    SharedImageCache();
+
+    // Finds room for an image of the given size in the space, preferably at the address
+    // the image was given in other processes.
+    Optional<Range> allocate_range(Space&, Inode&, size_t size);
+
+    // Replaces the pages of a read-only private anonymous region with identical pages
+    // other processes have at the same address. Returns the number of pages shared.
+    size_t share_pages(Region&);
+
+    size_t page_count() const;
+
+private:
+    struct ImageBase {
+        VirtualAddress base;
+        size_t size { 0 };
+        time_t mtime { 0 };
+    };
+
+    struct PageKey {
+        VirtualAddress vaddr;
+        u32 hash { 0 };
+
+        bool operator==(const PageKey& other) const { return vaddr == other.vaddr && hash == other.hash; }
+    };
+
+    struct PageKeyTraits : public GenericTraits<PageKey> {
+        static unsigned hash(const PageKey& key) { return pair_int_hash(key.vaddr.get(), key.hash); }
+        static bool equals(const PageKey& a, const PageKey& b) { return a == b; }
+    };
+
+    void remove_unused_pages();
+
+    mutable SpinLock<u8> m_lock;
+    HashMap<InodeIdentifier, ImageBase> m_image_bases;
+    HashMap<PageKey, NonnullRefPtr<PhysicalPage>, PageKeyTraits> m_pages;
+};
+
+}
@@ -26,8 +26,8 @@
 
 #pragma once
 
-#include <AK/NonnullOwnPtrVector.h>
-#include <AK/WeakPtr.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/RedBlackTree.h>
 #include <Kernel/UnixTypes.h>
 #include <Kernel/VM/AllocationStrategy.h>
 #include <Kernel/VM/PageDirectory.h>
@@ -46,8 +46,9 @@ public:
 
     size_t region_count() const { return m_regions.size(); }
 
-    NonnullOwnPtrVector<Region>& regions() { return m_regions; }
-    const NonnullOwnPtrVector<Region>& regions() const { return m_regions; }
+    // Regions are keyed (and iterated) by their base address.
+    RedBlackTree<FlatPtr, NonnullOwnPtr<Region>>& regions() { return m_regions; }
+    const RedBlackTree<FlatPtr, NonnullOwnPtr<Region>>& regions() const { return m_regions; }
 
     void dump_regions();
 
@@ -62,6 +63,7 @@ public:
 
     Region* find_region_from_range(const Range&);
     Region* find_region_containing(const Range&);
+    Region* find_region_containing(VirtualAddress);
 
     bool enforces_syscall_regions() const { return m_enforces_syscall_regions; }
     void set_enforces_syscall_regions(bool b) { m_enforces_syscall_regions = b; }
@@ -86,13 +88,7 @@ private:
 
     RefPtr<PageDirectory> m_page_directory;
 
-    NonnullOwnPtrVector<Region> m_regions;
-
-    struct RegionLookupCache {
-        Optional<Range> range;
-        WeakPtr<Region> region;
-    };
-    RegionLookupCache m_region_lookup_cache;
+    RedBlackTree<FlatPtr, NonnullOwnPtr<Region>> m_regions;
 
     bool m_enforces_syscall_regions { false };
 };
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Kernel/Debug.h>
+#include <Kernel/VirtIO/VirtIO.h>
+
+namespace Kernel {
+
+UNMAP_AFTER_INIT VirtIOInterruptHandler::VirtIOInterruptHandler(VirtIODevice& device, u8 irq, const char* purpose)
+    : IRQHandler(irq)
+    , m_device(device)
+    , m_purpose(purpose)
+{
+}
+
+VirtIOInterruptHandler::~VirtIOInterruptHandler()
+{
+}
+
+void VirtIOInterruptHandler::handle_irq(const RegisterState&)
+{
+    m_device.handle_interrupt();
+}
+
+UNMAP_AFTER_INIT VirtIODevice::VirtIODevice(PCI::Address address, const char* purpose)
+    : PCI::DeviceController(address)
+    , m_purpose(purpose)
+    , m_io_base(PCI::get_BAR0(address) & ~3)
+{
+}
+
+VirtIODevice::~VirtIODevice()
+{
+}
+
+void VirtIODevice::set_status_bit(u8 bit)
+{
+    auto status_register = m_io_base.offset(VirtIO::Register::DeviceStatus);
+    status_register.out<u8>(status_register.in<u8>() | bit);
+}
+
+UNMAP_AFTER_INIT void VirtIODevice::begin_initialization(u32 wanted_features)
+{
+    PCI::enable_bus_mastering(pci_address());
+
+    // Writing zero to the status register resets the device.
+    m_io_base.offset(VirtIO::Register::DeviceStatus).out<u8>(0);
+    set_status_bit(VirtIO::DeviceStatus::Acknowledge);
+    set_status_bit(VirtIO::DeviceStatus::Driver);
+
+    u32 device_features = m_io_base.offset(VirtIO::Register::DeviceFeatures).in<u32>();
+    m_accepted_features = device_features & wanted_features;
+    m_io_base.offset(VirtIO::Register::GuestFeatures).out<u32>(m_accepted_features);
+    dbgln_if(VIRTIO_DEBUG, "{}: Device features {:#08x}, accepted {:#08x}", m_purpose, device_features, m_accepted_features);
+}
+
+UNMAP_AFTER_INIT bool VirtIODevice::setup_queue(u16 queue_index)
+{
+    VERIFY(queue_index == m_queues.size());
+    m_io_base.offset(VirtIO::Register::QueueSelect).out<u16>(queue_index);
+    // Legacy devices dictate the size of their queues.
+    u16 queue_size = m_io_base.offset(VirtIO::Register::QueueSize).in<u16>();
+    auto queue = VirtIOQueue::create(queue_size, String::formatted("{} queue {}", m_purpose, queue_index));
+    if (!queue) {
+        dbgln("{}: Failed to set up queue {} with {} entries", m_purpose, queue_index, queue_size);
+        return false;
+    }
+    m_io_base.offset(VirtIO::Register::QueueAddress).out<u32>(queue->physical_address().get() >> 12);
+    dbgln_if(VIRTIO_DEBUG, "{}: Queue {} has {} entries at {}", m_purpose, queue_index, queue_size, queue->physical_address());
+    m_queues.append(queue.release_nonnull());
+    return true;
+}
+
+UNMAP_AFTER_INIT void VirtIODevice::finish_initialization()
+{
+    m_interrupt_handler = make<VirtIOInterruptHandler>(*this, PCI::get_interrupt_line(pci_address()), m_purpose);
+    set_status_bit(VirtIO::DeviceStatus::DriverOK);
+    m_interrupt_handler->enable_irq();
+}
+
+UNMAP_AFTER_INIT void VirtIODevice::fail_initialization()
+{
+    set_status_bit(VirtIO::DeviceStatus::Failed);
+}
+
+void VirtIODevice::notify_queue(u16 queue_index)
+{
+    if (queue(queue_index).should_notify())
+        m_io_base.offset(VirtIO::Register::QueueNotify).out<u16>(queue_index);
+}
+
+void VirtIODevice::handle_interrupt()
+{
+    // Reading the ISR status acknowledges the interrupt. The line may be shared,
+    // so there's nothing to do if neither bit is set.
+    u8 status = m_io_base.offset(VirtIO::Register::ISRStatus).in<u8>();
+    if (status & VirtIO::ISRStatus::ConfigurationChange)
+        handle_device_configuration_change();
+    if (status & VirtIO::ISRStatus::QueueInterrupt) {
+        for (u16 queue_index = 0; queue_index < m_queues.size(); ++queue_index)
+            handle_queue_update(queue_index);
+    }
+}
+
+}
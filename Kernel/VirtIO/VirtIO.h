@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/NonnullOwnPtrVector.h>
+#include <AK/OwnPtr.h>
+#include <Kernel/IO.h>
+#include <Kernel/Interrupts/IRQHandler.h>
+#include <Kernel/PCI/Access.h>
+#include <Kernel/PCI/DeviceController.h>
+#include <Kernel/VirtIO/VirtIOQueue.h>
+
+namespace Kernel {
+
+namespace VirtIO {
+
+static constexpr u16 pci_vendor_id = 0x1af4;
+
+// Transitional devices, which implement the legacy interface we drive.
+namespace PCIDeviceID {
+enum : u16 {
+    Network = 0x1000,
+    Block = 0x1001,
+};
+}
+
+// Register layout of the legacy virtio-pci interface in I/O space (BAR0). Without MSI-X
+// enabled, the device-specific configuration follows the common registers directly.
+namespace Register {
+enum : u16 {
+    DeviceFeatures = 0x00,
+    GuestFeatures = 0x04,
+    QueueAddress = 0x08,
+    QueueSize = 0x0c,
+    QueueSelect = 0x0e,
+    QueueNotify = 0x10,
+    DeviceStatus = 0x12,
+    ISRStatus = 0x13,
+    DeviceConfiguration = 0x14,
+};
+}
+
+namespace DeviceStatus {
+enum : u8 {
+    Acknowledge = 1 << 0,
+    Driver = 1 << 1,
+    DriverOK = 1 << 2,
+    FeaturesOK = 1 << 3,
+    Failed = 1 << 7,
+};
+}
+
+namespace ISRStatus {
+enum : u8 {
+    QueueInterrupt = 1 << 0,
+    ConfigurationChange = 1 << 1,
+};
+}
+
+}
+
+class VirtIODevice;
+
+class VirtIOInterruptHandler final : public IRQHandler {
+    AK_MAKE_ETERNAL
+public:
+    VirtIOInterruptHandler(VirtIODevice&, u8 irq, const char* purpose);
+    virtual ~VirtIOInterruptHandler() override;
+
+    virtual const char* purpose() const override { return m_purpose; }
+
+private:
+    //^ IRQHandler
+    virtual void handle_irq(const RegisterState&) override;
+
+    VirtIODevice& m_device;
+    const char* m_purpose { nullptr };
+};
+
+// The transport shared by all virtio drivers: feature negotiation, virtqueue setup and
+// interrupt dispatch. Drivers derive from this next to their subsystem's base class.
+class VirtIODevice : public PCI::DeviceController {
+    friend class VirtIOInterruptHandler;
+
+public:
+    virtual ~VirtIODevice() override;
+
+protected:
+    VirtIODevice(PCI::Address, const char* purpose);
+
+    // Resets the device and accepts those of the wanted feature bits that it offers.
+    void begin_initialization(u32 wanted_features);
+    bool setup_queue(u16 queue_index);
+    // Tells the device we're ready and starts taking interrupts.
+    void finish_initialization();
+    void fail_initialization();
+
+    bool is_feature_accepted(u32 feature) const { return m_accepted_features & feature; }
+    size_t queue_count() const { return m_queues.size(); }
+    VirtIOQueue& queue(u16 queue_index) { return m_queues[queue_index]; }
+    // Kicks the device if the queue asks for it after buffers have been supplied.
+    void notify_queue(u16 queue_index);
+
+    template<typename T>
+    T config_read(u16 offset) { return m_io_base.offset(VirtIO::Register::DeviceConfiguration + offset).in<T>(); }
+
+    // Called from IRQ context.
+    virtual void handle_queue_update(u16 queue_index) = 0;
+    virtual void handle_device_configuration_change() { }
+
+private:
+    void handle_interrupt();
+    void set_status_bit(u8);
+
+    const char* m_purpose { nullptr };
+    IOAddress m_io_base;
+    u32 m_accepted_features { 0 };
+    NonnullOwnPtrVector<VirtIOQueue> m_queues;
+    OwnPtr<VirtIOInterruptHandler> m_interrupt_handler;
+};
+
+}
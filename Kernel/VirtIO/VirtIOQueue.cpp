@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Atomic.h>
+#include <Kernel/StdLib.h>
+#include <Kernel/VM/MemoryManager.h>
+#include <Kernel/VirtIO/VirtIOQueue.h>
+
+namespace Kernel {
+
+size_t VirtIOQueue::required_memory_size(u16 queue_size)
+{
+    size_t descriptor_table_size = sizeof(VirtIO::QueueDescriptor) * queue_size;
+    size_t available_ring_size = sizeof(u16) * (3 + queue_size);
+    size_t used_ring_size = sizeof(u16) * 3 + sizeof(VirtIO::QueueUsedElement) * queue_size;
+    return page_round_up(descriptor_table_size + available_ring_size) + page_round_up(used_ring_size);
+}
+
+UNMAP_AFTER_INIT OwnPtr<VirtIOQueue> VirtIOQueue::create(u16 queue_size, const String& name)
+{
+    if (queue_size == 0)
+        return {};
+    // The device gets the ring's page frame number, so all of it has to be physically contiguous.
+    auto region = MM.allocate_contiguous_kernel_region(required_memory_size(queue_size), name, Region::Access::Read | Region::Access::Write);
+    if (!region)
+        return {};
+    return adopt_own(*new VirtIOQueue(queue_size, region.release_nonnull()));
+}
+
+UNMAP_AFTER_INIT VirtIOQueue::VirtIOQueue(u16 queue_size, NonnullOwnPtr<Region> region)
+    : m_size(queue_size)
+    , m_available_ring_offset(sizeof(VirtIO::QueueDescriptor) * queue_size)
+    , m_used_ring_offset(page_round_up(m_available_ring_offset + sizeof(u16) * (3 + queue_size)))
+    , m_region(move(region))
+    , m_free_descriptor_count(queue_size)
+{
+    memset(m_region->vaddr().as_ptr(), 0, m_region->size());
+    for (u16 i = 0; i < m_size; ++i)
+        descriptor(i).next = i + 1;
+    m_tokens.resize(m_size);
+}
+
+VirtIOQueue::~VirtIOQueue()
+{
+}
+
+bool VirtIOQueue::supply_buffer(Span<const BufferSegment> segments, void* token)
+{
+    VERIFY(!segments.is_empty());
+    if (segments.size() > m_free_descriptor_count)
+        return false;
+
+    u16 head = m_free_head;
+    u16 current = head;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        auto& segment = segments[i];
+        auto& entry = descriptor(current);
+        bool is_last = i == segments.size() - 1;
+        entry.address = segment.address.get();
+        entry.length = segment.length;
+        entry.flags = (is_last ? 0 : VirtIO::QueueDescriptorFlags::Next) | (segment.device_writable ? VirtIO::QueueDescriptorFlags::DeviceWritable : 0);
+        // Free descriptors are linked through their next field already, so the chain
+        // just takes over that link for all but the last segment.
+        if (is_last)
+            m_free_head = entry.next;
+        else
+            current = entry.next;
+    }
+    m_free_descriptor_count -= segments.size();
+    m_tokens[head] = token;
+
+    auto* available = available_ring();
+    u16 available_index = available[1];
+    available[2 + (available_index % m_size)] = head;
+    // The device must see the ring entry before the index that publishes it.
+    AK::atomic_thread_fence(AK::MemoryOrder::memory_order_seq_cst);
+    available[1] = available_index + 1;
+    return true;
+}
+
+bool VirtIOQueue::has_used_buffers() const
+{
+    AK::atomic_thread_fence(AK::MemoryOrder::memory_order_seq_cst);
+    return used_ring_header()[1] != m_last_used_index;
+}
+
+bool VirtIOQueue::get_used_buffer(void*& token, u32& written_length)
+{
+    if (!has_used_buffers())
+        return false;
+
+    auto& element = used_ring()[m_last_used_index % m_size];
+    u16 head = element.descriptor_index;
+    written_length = element.length;
+    VERIFY(head < m_size);
+    token = m_tokens[head];
+    m_tokens[head] = nullptr;
+    ++m_last_used_index;
+
+    u16 last = head;
+    size_t chain_length = 1;
+    while (descriptor(last).flags & VirtIO::QueueDescriptorFlags::Next) {
+        last = descriptor(last).next;
+        ++chain_length;
+    }
+    descriptor(last).next = m_free_head;
+    m_free_head = head;
+    m_free_descriptor_count += chain_length;
+    return true;
+}
+
+bool VirtIOQueue::should_notify() const
+{
+    AK::atomic_thread_fence(AK::MemoryOrder::memory_order_seq_cst);
+    return !(used_ring_header()[0] & VirtIO::QueueUsedFlags::NoNotify);
+}
+
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Span.h>
+#include <AK/String.h>
+#include <AK/Types.h>
+#include <AK/Vector.h>
+#include <Kernel/PhysicalAddress.h>
+#include <Kernel/VM/PhysicalPage.h>
+#include <Kernel/VM/Region.h>
+
+namespace Kernel {
+
+namespace VirtIO {
+
+struct [[gnu::packed]] QueueDescriptor {
+    u64 address;
+    u32 length;
+    u16 flags;
+    u16 next;
+};
+
+namespace QueueDescriptorFlags {
+enum {
+    Next = 1 << 0,
+    DeviceWritable = 1 << 1,
+};
+}
+
+struct [[gnu::packed]] QueueUsedElement {
+    u32 descriptor_index;
+    u32 length;
+};
+
+namespace QueueUsedFlags {
+enum {
+    NoNotify = 1 << 0,
+};
+}
+
+}
+
+// A split virtqueue as laid out by the legacy virtio-pci interface: the descriptor table
+// is directly followed by the available ring, and the used ring starts on the next page.
+//
+// A buffer handed to the device is a chain of descriptors, so a single request can be
+// scattered over several physically discontiguous pages. VirtIOQueue does no locking
+// of its own; the owning driver has to serialize all accesses to it.
+class VirtIOQueue {
+    AK_MAKE_NONCOPYABLE(VirtIOQueue);
+
+public:
+    struct BufferSegment {
+        PhysicalAddress address;
+        u32 length { 0 };
+        bool device_writable { false };
+    };
+
+    static OwnPtr<VirtIOQueue> create(u16 queue_size, const String& name);
+    ~VirtIOQueue();
+
+    u16 size() const { return m_size; }
+    size_t free_descriptor_count() const { return m_free_descriptor_count; }
+    PhysicalAddress physical_address() const { return m_region->physical_page(0)->paddr(); }
+
+    // Queues a chain made of the given segments and remembers the token for when the
+    // device returns it. Returns false if there aren't enough free descriptors.
+    bool supply_buffer(Span<const BufferSegment>, void* token);
+
+    // Pops the next buffer the device is done with, returning the number of bytes it wrote.
+    bool get_used_buffer(void*& token, u32& written_length);
+    bool has_used_buffers() const;
+
+    // Whether the driver has to kick the device after supplying buffers.
+    bool should_notify() const;
+
+    static size_t required_memory_size(u16 queue_size);
+
+private:
+    VirtIOQueue(u16 queue_size, NonnullOwnPtr<Region>);
+
+    volatile VirtIO::QueueDescriptor& descriptor(u16 index) { return reinterpret_cast<volatile VirtIO::QueueDescriptor*>(m_region->vaddr().as_ptr())[index]; }
+
+    // The available ring is { u16 flags; u16 index; u16 ring[size]; u16 used_event; }.
+    volatile u16* available_ring() { return reinterpret_cast<volatile u16*>(m_region->vaddr().offset(m_available_ring_offset).as_ptr()); }
+    // The used ring is { u16 flags; u16 index; QueueUsedElement ring[size]; u16 available_event; }.
+    volatile u16* used_ring_header() const { return reinterpret_cast<volatile u16*>(m_region->vaddr().offset(m_used_ring_offset).as_ptr()); }
+    volatile VirtIO::QueueUsedElement* used_ring() const { return reinterpret_cast<volatile VirtIO::QueueUsedElement*>(m_region->vaddr().offset(m_used_ring_offset + 2 * sizeof(u16)).as_ptr()); }
+
+    u16 m_size { 0 };
+    size_t m_available_ring_offset { 0 };
+    size_t m_used_ring_offset { 0 };
+    NonnullOwnPtr<Region> m_region;
+
+    u16 m_free_head { 0 };
+    size_t m_free_descriptor_count { 0 };
+    u16 m_last_used_index { 0 };
+    Vector<void*> m_tokens;
+};
+
+}
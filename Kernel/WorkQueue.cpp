@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Vector.h>
+#include <Kernel/Process.h>
+#include <Kernel/WorkQueue.h>
+
+namespace Kernel {
+
+static Vector<WorkQueue*>* s_work_queues;
+
+UNMAP_AFTER_INIT void WorkQueue::initialize()
+{
+    VERIFY(!s_work_queues);
+    s_work_queues = new Vector<WorkQueue*>;
+    for (u32 cpu = 0; cpu < Processor::count(); cpu++)
+        s_work_queues->append(new WorkQueue(cpu));
+}
+
+bool WorkQueue::is_initialized()
+{
+    return s_work_queues;
+}
+
+WorkQueue& WorkQueue::for_current_processor()
+{
+    VERIFY(s_work_queues);
+    return *s_work_queues->at(Processor::id());
+}
+
+UNMAP_AFTER_INIT WorkQueue::WorkQueue(u32 cpu)
+{
+    RefPtr<Thread> thread;
+    Process::create_kernel_process(
+        thread, String::formatted("WorkQueue #{}", cpu), [this] {
+            run();
+        },
+        1u << cpu);
+    VERIFY(thread);
+}
+
+void WorkQueue::queue(Function<void()> function)
+{
+    // Before the queues exist, fall back to running the work when we leave the interrupt handler.
+    if (!is_initialized()) {
+        Processor::deferred_call_queue(move(function));
+        return;
+    }
+    for_current_processor().enqueue(move(function));
+}
+
+void WorkQueue::enqueue(Function<void()>&& function)
+{
+    auto* item = new WorkItem(move(function));
+    {
+        ScopedSpinLock lock(m_lock);
+        m_items.append(*item);
+    }
+    m_wait_queue.wake_one();
+}
+
+void WorkQueue::run()
+{
+    Thread::current()->set_priority(THREAD_PRIORITY_HIGH);
+    for (;;) {
+        WorkItem* item;
+        {
+            ScopedSpinLock lock(m_lock);
+            item = m_items.take_first();
+        }
+        if (!item) {
+            m_wait_queue.wait_forever("WorkQueue");
+            continue;
+        }
+        item->function();
+        delete item;
+    }
+}
+
+}
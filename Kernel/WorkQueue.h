@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Function.h>
+#include <AK/IntrusiveList.h>
+#include <AK/Noncopyable.h>
+#include <Kernel/SpinLock.h>
+#include <Kernel/WaitQueue.h>
+
+namespace Kernel {
+
+// Runs the slow half of interrupt handling in a kernel thread, with interrupts enabled.
+// There's one queue (and thread) per processor, and queue() picks the one of the
+// processor it's called on, so a device's interrupt affinity also decides where its
+// deferred work runs.
+class WorkQueue {
+    AK_MAKE_NONCOPYABLE(WorkQueue);
+    AK_MAKE_NONMOVABLE(WorkQueue);
+
+public:
+    static void initialize();
+    static bool is_initialized();
+    static WorkQueue& for_current_processor();
+
+    static void queue(Function<void()>);
+
+private:
+    explicit WorkQueue(u32 cpu);
+
+    void enqueue(Function<void()>&&);
+    [[noreturn]] void run();
+
+    struct WorkItem {
+        explicit WorkItem(Function<void()>&& function)
+            : function(move(function))
+        {
+        }
+
+        IntrusiveListNode m_list_node;
+        Function<void()> function;
+    };
+
+    SpinLock<u8> m_lock;
+    IntrusiveList<WorkItem, &WorkItem::m_list_node> m_items;
+    WaitQueue m_wait_queue;
+};
+
+}
@@ -37,7 +37,9 @@
 #include <Kernel/Devices/I8042Controller.h>
 #include <Kernel/Devices/MBVGADevice.h>
 #include <Kernel/Devices/MemoryDevice.h>
+#include <Kernel/Devices/MemoryPressureDevice.h>
 #include <Kernel/Devices/NullDevice.h>
+#include <Kernel/Devices/ProfileDevice.h>
 #include <Kernel/Devices/RandomDevice.h>
 #include <Kernel/Devices/SB16.h>
 #include <Kernel/Devices/SerialDevice.h>
@@ -58,6 +60,8 @@
 #include <Kernel/Net/NE2000NetworkAdapter.h>
 #include <Kernel/Net/NetworkTask.h>
 #include <Kernel/Net/RTL8139NetworkAdapter.h>
+#include <Kernel/Net/VirtIONetworkAdapter.h>
+#include <Kernel/Net/VirtIONetworkAdapter.h>
 #include <Kernel/PCI/Access.h>
 #include <Kernel/PCI/Initializer.h>
 #include <Kernel/Panic.h>
@@ -69,9 +73,13 @@
 #include <Kernel/TTY/PTYMultiplexer.h>
 #include <Kernel/TTY/VirtualConsole.h>
 #include <Kernel/Tasks/FinalizerTask.h>
+#include <Kernel/Tasks/PageScannerTask.h>
+#include <Kernel/Tasks/PageZeroingTask.h>
 #include <Kernel/Tasks/SyncTask.h>
 #include <Kernel/Time/TimeManagement.h>
+#include <Kernel/VM/CompressedPageStore.h>
 #include <Kernel/VM/MemoryManager.h>
+#include <Kernel/WorkQueue.h>
 
 // Defined in the linker script
 typedef void (*ctor_func_t)();
@@ -244,6 +252,12 @@ void init_stage2(void*)
 
     SyncTask::spawn();
     FinalizerTask::spawn();
+    PageZeroingTask::spawn();
+    WorkQueue::initialize();
+
+    if (kernel_command_line().lookup("compressed_memory").value_or("off") == "on")
+        CompressedPageStore::initialize();
+    PageScannerTask::spawn();
 
     PCI::initialize();
 
@@ -279,6 +293,8 @@ void init_stage2(void*)
     E1000NetworkAdapter::detect();
     NE2000NetworkAdapter::detect();
     RTL8139NetworkAdapter::detect();
+    VirtIONetworkAdapter::detect();
+    VirtIONetworkAdapter::detect();
 
     LoopbackAdapter::the();
 
@@ -288,6 +304,8 @@ void init_stage2(void*)
     new ZeroDevice;
     new FullDevice;
     new RandomDevice;
+    new ProfileDevice;
+    new MemoryPressureDevice;
     PTYMultiplexer::initialize();
     SB16::detect();
     VMWareBackdoor::the(); // don't wait until first mouse packet
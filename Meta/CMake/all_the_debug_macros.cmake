@@ -24,10 +24,13 @@ set(INTERRUPT_DEBUG ON)
 set(E1000_DEBUG ON)
 set(IPV4_SOCKET_DEBUG ON)
 set(LOCAL_SOCKET_DEBUG ON)
+set(LOOPBACK_DEBUG ON)
 set(SOCKET_DEBUG ON)
 set(TCP_SOCKET_DEBUG ON)
 set(PCI_DEBUG ON)
 set(PATA_DEBUG ON)
+set(AHCI_DEBUG ON)
+set(VIRTIO_DEBUG ON)
 set(IO_DEBUG ON)
 set(FORK_DEBUG ON)
 set(POLL_SELECT_DEBUG ON)
@@ -38,6 +41,9 @@ set(SLAVEPTY_DEBUG ON)
 set(PTMX_DEBUG ON)
 set(TTY_DEBUG ON)
 set(CONTIGUOUS_VMOBJECT_DEBUG ON)
+set(COMPRESSED_PAGE_DEBUG ON)
+set(DENTRY_CACHE_DEBUG ON)
+set(SHARED_IMAGE_DEBUG ON)
 set(VRA_DEBUG ON)
 set(COPY_DEBUG ON)
 set(CURSOR_TOOL_DEBUG ON)
@@ -53,9 +59,9 @@ set(DWARF_DEBUG ON)
 set(HUNKS_DEBUG ON)
 set(JOB_DEBUG ON)
 set(GIF_DEBUG ON)
+set(GLYPH_ATLAS_DEBUG ON)
 set(JPG_DEBUG ON)
 set(EMOJI_DEBUG ON)
-set(FILL_PATH_DEBUG ON)
 set(PNG_DEBUG ON)
 set(PORTABLE_IMAGE_LOADER_DEBUG ON)
 set(SYNTAX_HIGHLIGHTING_DEBUG ON)
@@ -128,6 +134,7 @@ set(HEAP_DEBUG ON)
 set(HEX_DEBUG ON)
 set(HTML_SCRIPT_DEBUG ON)
 set(HTTPSJOB_DEBUG ON)
+set(HTTP_CONNECTION_POOL_DEBUG ON)
 set(ICMP_DEBUG ON)
 set(ICO_DEBUG ON)
 set(IPV4_DEBUG ON)
@@ -158,6 +165,7 @@ set(UCI_DEBUG ON)
 set(UDP_DEBUG ON)
 set(UHCI_VERBOSE_DEBUG ON)
 set(UPDATE_COALESCING_DEBUG ON)
+set(VECTOR_GROWTH_DEBUG ON)
 set(VOLATILE_PAGE_RANGES_DEBUG ON)
 set(WSMESSAGELOOP_DEBUG ON)
 set(GPT_DEBUG ON)
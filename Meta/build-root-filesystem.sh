@@ -66,12 +66,14 @@ chmod 755 mnt/res/devel/templates/*.postcreate
 echo "done"
 
 printf "creating initial filesystem structure... "
-for dir in bin etc proc mnt tmp boot mod var/run; do
+for dir in bin etc proc mnt tmp boot mod var/run var/cache/protocol; do
     mkdir -p mnt/$dir
 done
 chmod 700 mnt/boot
 chmod 700 mnt/mod
 chmod 1777 mnt/tmp
+chown 11:11 mnt/var/cache/protocol
+chmod 700 mnt/var/cache/protocol
 echo "done"
 
 printf "creating utmp file... "
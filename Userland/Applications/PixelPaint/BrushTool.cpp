@@ -59,7 +59,8 @@ void BrushTool::on_mousemove(Layer& layer, GUI::MouseEvent& event, GUI::MouseEve
         return;
 
     draw_line(layer.bitmap(), m_editor->color_for(event), m_last_position, event.position());
-    layer.did_modify_bitmap(*m_editor->image());
+    auto modified_rect = Gfx::IntRect::from_two_points(m_last_position, event.position()).inflated(m_size * 2 + 1, m_size * 2 + 1);
+    layer.did_modify_bitmap(*m_editor->image(), modified_rect);
     m_last_position = event.position();
     m_was_drawing = true;
 }
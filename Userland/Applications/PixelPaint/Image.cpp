@@ -178,20 +178,20 @@ void Image::add_layer(NonnullRefPtr<Layer> layer)
     did_modify_layer_stack();
 }
 
-RefPtr<Image> Image::take_snapshot() const
+Image::Snapshot Image::take_snapshot()
 {
-    auto snapshot = create_with_size(m_size);
-    for (const auto& layer : m_layers)
-        snapshot->add_layer(*Layer::create_snapshot(*snapshot, layer));
+    Snapshot snapshot;
+    for (auto& layer : m_layers)
+        snapshot.layers.append(layer.take_snapshot());
     return snapshot;
 }
 
-void Image::restore_snapshot(const Image& snapshot)
+void Image::restore_snapshot(const Snapshot& snapshot)
 {
     m_layers.clear();
     select_layer(nullptr);
-    for (const auto& snapshot_layer : snapshot.m_layers) {
-        auto layer = Layer::create_snapshot(*this, snapshot_layer);
+    for (const auto& snapshot_layer : snapshot.layers) {
+        auto layer = Layer::create_from_snapshot(*this, snapshot_layer);
         if (layer->is_selected())
             select_layer(layer.ptr());
         add_layer(*layer);
@@ -300,13 +300,13 @@ void Image::remove_client(ImageClient& client)
     m_clients.remove(&client);
 }
 
-void Image::layer_did_modify_bitmap(Badge<Layer>, const Layer& layer)
+void Image::layer_did_modify_bitmap(Badge<Layer>, const Layer& layer, const Gfx::IntRect& rect)
 {
     auto layer_index = index_of(layer);
     for (auto* client : m_clients)
         client->image_did_modify_layer(layer_index);
 
-    did_change();
+    did_change(rect.translated(layer.location()));
 }
 
 void Image::layer_did_modify_properties(Badge<Layer>, const Layer& layer)
@@ -319,9 +319,14 @@ void Image::layer_did_modify_properties(Badge<Layer>, const Layer& layer)
 }
 
 void Image::did_change()
+{
+    did_change(rect());
+}
+
+void Image::did_change(const Gfx::IntRect& rect)
 {
     for (auto* client : m_clients)
-        client->image_did_change();
+        client->image_did_change(rect);
 }
 
 ImageUndoCommand::ImageUndoCommand(Image& image)
@@ -332,7 +337,7 @@ ImageUndoCommand::ImageUndoCommand(Image& image)
 
 void ImageUndoCommand::undo()
 {
-    m_image.restore_snapshot(*m_snapshot);
+    m_image.restore_snapshot(m_snapshot);
 }
 
 void ImageUndoCommand::redo()
@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include "Layer.h"
 #include <AK/HashTable.h>
 #include <AK/NonnullRefPtrVector.h>
 #include <AK/RefCounted.h>
@@ -39,20 +40,23 @@
 
 namespace PixelPaint {
 
-class Layer;
-
 class ImageClient {
 public:
     virtual void image_did_add_layer(size_t) { }
     virtual void image_did_remove_layer(size_t) { }
     virtual void image_did_modify_layer(size_t) { }
     virtual void image_did_modify_layer_stack() { }
-    virtual void image_did_change() { }
+    // The rect is in image coordinates.
+    virtual void image_did_change(const Gfx::IntRect&) { }
     virtual void image_select_layer(Layer*) { }
 };
 
 class Image : public RefCounted<Image> {
 public:
+    struct Snapshot {
+        Vector<Layer::Snapshot> layers;
+    };
+
     static RefPtr<Image> create_with_size(const Gfx::IntSize&);
     static RefPtr<Image> create_from_file(const String& file_path);
 
@@ -64,8 +68,8 @@ public:
     Gfx::IntRect rect() const { return { {}, m_size }; }
 
     void add_layer(NonnullRefPtr<Layer>);
-    RefPtr<Image> take_snapshot() const;
-    void restore_snapshot(const Image&);
+    Snapshot take_snapshot();
+    void restore_snapshot(const Snapshot&);
 
     void paint_into(GUI::Painter&, const Gfx::IntRect& dest_rect);
     void save(const String& file_path) const;
@@ -83,7 +87,7 @@ public:
     void add_client(ImageClient&);
     void remove_client(ImageClient&);
 
-    void layer_did_modify_bitmap(Badge<Layer>, const Layer&);
+    void layer_did_modify_bitmap(Badge<Layer>, const Layer&, const Gfx::IntRect&);
     void layer_did_modify_properties(Badge<Layer>, const Layer&);
 
     size_t index_of(const Layer&) const;
@@ -92,6 +96,7 @@ private:
     explicit Image(const Gfx::IntSize&);
 
     void did_change();
+    void did_change(const Gfx::IntRect&);
     void did_modify_layer_stack();
 
     Gfx::IntSize m_size;
@@ -108,7 +113,7 @@ public:
     virtual void redo() override;
 
 private:
-    RefPtr<Image> m_snapshot;
+    Image::Snapshot m_snapshot;
     Image& m_image;
 };
 
@@ -405,9 +405,10 @@ void ImageEditor::relayout()
     update();
 }
 
-void ImageEditor::image_did_change()
+void ImageEditor::image_did_change(const Gfx::IntRect& image_rect)
 {
-    update();
+    // Only recomposite what changed. The margin covers the rounding of scaled rects, and the frame around the image.
+    update(enclosing_int_rect(image_rect_to_editor_rect(image_rect)).inflated(4, 4));
 }
 
 void ImageEditor::image_select_layer(Layer* layer)
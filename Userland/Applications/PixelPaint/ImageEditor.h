@@ -98,7 +98,7 @@ private:
     virtual void context_menu_event(GUI::ContextMenuEvent&) override;
     virtual void resize_event(GUI::ResizeEvent&) override;
 
-    virtual void image_did_change() override;
+    virtual void image_did_change(const Gfx::IntRect&) override;
     virtual void image_select_layer(Layer*) override;
 
     GUI::MouseEvent event_adjusted_for_layer(const GUI::MouseEvent&, const Layer&) const;
@@ -27,6 +27,7 @@
 #include "Layer.h"
 #include "Image.h"
 #include <LibGfx/Bitmap.h>
+#include <string.h>
 
 namespace PixelPaint {
 
@@ -52,14 +53,24 @@ RefPtr<Layer> Layer::create_with_bitmap(Image& image, const Gfx::Bitmap& bitmap,
     return adopt(*new Layer(image, bitmap, name));
 }
 
-RefPtr<Layer> Layer::create_snapshot(Image& image, const Layer& layer)
+RefPtr<Layer> Layer::create_from_snapshot(Image& image, const Snapshot& snapshot)
 {
-    auto snapshot = create_with_bitmap(image, *layer.bitmap().clone(), layer.name());
-    snapshot->set_opacity_percent(layer.opacity_percent());
-    snapshot->set_visible(layer.is_visible());
-    snapshot->set_selected(layer.is_selected());
-    snapshot->set_location(layer.location());
-    return snapshot;
+    auto bitmap = Gfx::Bitmap::create(snapshot.format, snapshot.size);
+    if (!bitmap)
+        return nullptr;
+    auto layer = create_with_bitmap(image, *bitmap, snapshot.name);
+    if (!layer)
+        return nullptr;
+    layer->m_opacity_percent = snapshot.opacity_percent;
+    layer->m_visible = snapshot.visible;
+    layer->m_selected = snapshot.selected;
+    layer->m_location = snapshot.location;
+
+    VERIFY(snapshot.tiles.size() == layer->tile_count());
+    for (size_t i = 0; i < snapshot.tiles.size(); ++i)
+        snapshot.tiles[i].copy_into(*layer->m_bitmap, layer->tile_rect(i));
+    layer->m_tiles = snapshot.tiles;
+    return layer;
 }
 
 Layer::Layer(Image& image, const Gfx::IntSize& size, const String& name)
@@ -76,9 +87,65 @@ Layer::Layer(Image& image, const Gfx::Bitmap& bitmap, const String& name)
 {
 }
 
-void Layer::did_modify_bitmap(Image& image)
+void Layer::did_modify_bitmap(Image& image, const Gfx::IntRect& rect)
+{
+    image.layer_did_modify_bitmap({}, *this, rect.is_empty() ? this->rect() : rect.intersected(this->rect()));
+}
+
+size_t Layer::tile_count() const
+{
+    return ceil_div(size().width(), tile_size) * ceil_div(size().height(), tile_size);
+}
+
+Gfx::IntRect Layer::tile_rect(size_t index) const
+{
+    int columns = ceil_div(size().width(), tile_size);
+    Gfx::IntRect rect { (int)(index % columns) * tile_size, (int)(index / columns) * tile_size, tile_size, tile_size };
+    return rect.intersected(this->rect());
+}
+
+Layer::Snapshot Layer::take_snapshot()
+{
+    // Tools and filters paint straight into the bitmap without telling us where, so we find the tiles
+    // that changed by comparing them. That's still much cheaper than copying all of them.
+    VERIFY(m_bitmap->bpp() == 32);
+    if (m_tiles.size() != tile_count()) {
+        m_tiles.clear();
+        for (size_t i = 0; i < tile_count(); ++i)
+            m_tiles.append(adopt(*new Tile(*m_bitmap, tile_rect(i))));
+    } else {
+        for (size_t i = 0; i < m_tiles.size(); ++i) {
+            auto rect = tile_rect(i);
+            if (!m_tiles[i].has_same_pixels_as(*m_bitmap, rect))
+                m_tiles.ptr_at(i) = adopt(*new Tile(*m_bitmap, rect));
+        }
+    }
+
+    return { m_name, m_location, size(), m_bitmap->format(), m_opacity_percent, m_visible, m_selected, m_tiles };
+}
+
+Layer::Tile::Tile(const Gfx::Bitmap& bitmap, const Gfx::IntRect& rect)
+{
+    m_pixels.ensure_capacity(rect.width() * rect.height());
+    for (int y = rect.top(); y <= rect.bottom(); ++y)
+        m_pixels.append(bitmap.scanline(y) + rect.left(), rect.width());
+}
+
+bool Layer::Tile::has_same_pixels_as(const Gfx::Bitmap& bitmap, const Gfx::IntRect& rect) const
+{
+    VERIFY(m_pixels.size() == (size_t)(rect.width() * rect.height()));
+    for (int row = 0; row < rect.height(); ++row) {
+        if (memcmp(m_pixels.data() + row * rect.width(), bitmap.scanline(rect.top() + row) + rect.left(), rect.width() * sizeof(Gfx::RGBA32)))
+            return false;
+    }
+    return true;
+}
+
+void Layer::Tile::copy_into(Gfx::Bitmap& bitmap, const Gfx::IntRect& rect) const
 {
-    image.layer_did_modify_bitmap({}, *this);
+    VERIFY(m_pixels.size() == (size_t)(rect.width() * rect.height()));
+    for (int row = 0; row < rect.height(); ++row)
+        memcpy(bitmap.scanline(rect.top() + row) + rect.left(), m_pixels.data() + row * rect.width(), rect.width() * sizeof(Gfx::RGBA32));
 }
 
 void Layer::set_visible(bool visible)
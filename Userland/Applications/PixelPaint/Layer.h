@@ -27,8 +27,10 @@
 #pragma once
 
 #include <AK/Noncopyable.h>
+#include <AK/NonnullRefPtrVector.h>
 #include <AK/RefCounted.h>
 #include <AK/String.h>
+#include <AK/Vector.h>
 #include <AK/Weakable.h>
 #include <LibGfx/Bitmap.h>
 
@@ -44,9 +46,37 @@ class Layer
     AK_MAKE_NONMOVABLE(Layer);
 
 public:
+    static constexpr int tile_size = 64;
+
+    // The pixels of one tile of a layer, at some point in its history. Tiles never change once
+    // they're made, so all the snapshots in which a tile looks the same share the same Tile.
+    class Tile : public RefCounted<Tile> {
+    public:
+        Tile(const Gfx::Bitmap&, const Gfx::IntRect&);
+
+        bool has_same_pixels_as(const Gfx::Bitmap&, const Gfx::IntRect&) const;
+        void copy_into(Gfx::Bitmap&, const Gfx::IntRect&) const;
+
+    private:
+        Vector<Gfx::RGBA32> m_pixels;
+    };
+
+    // Everything about a layer that undo needs to bring back. Snapshots only cost as much
+    // memory as the tiles that changed since the previous one.
+    struct Snapshot {
+        String name;
+        Gfx::IntPoint location;
+        Gfx::IntSize size;
+        Gfx::BitmapFormat format { Gfx::BitmapFormat::RGBA32 };
+        int opacity_percent { 100 };
+        bool visible { true };
+        bool selected { false };
+        NonnullRefPtrVector<Tile> tiles;
+    };
+
     static RefPtr<Layer> create_with_size(Image&, const Gfx::IntSize&, const String& name);
     static RefPtr<Layer> create_with_bitmap(Image&, const Gfx::Bitmap&, const String& name);
-    static RefPtr<Layer> create_snapshot(Image&, const Layer&);
+    static RefPtr<Layer> create_from_snapshot(Image&, const Snapshot&);
 
     ~Layer() { }
 
@@ -63,9 +93,16 @@ public:
     const String& name() const { return m_name; }
     void set_name(const String&);
 
-    void set_bitmap(Gfx::Bitmap& bitmap) { m_bitmap = bitmap; }
+    void set_bitmap(Gfx::Bitmap& bitmap)
+    {
+        m_bitmap = bitmap;
+        m_tiles.clear();
+    }
+
+    // The rect is in layer coordinates. An empty rect means that the whole layer may have changed.
+    void did_modify_bitmap(Image&, const Gfx::IntRect& = {});
 
-    void did_modify_bitmap(Image&);
+    Snapshot take_snapshot();
 
     void set_selected(bool selected) { m_selected = selected; }
     bool is_selected() const { return m_selected; }
@@ -80,12 +117,18 @@ private:
     Layer(Image&, const Gfx::IntSize&, const String& name);
     Layer(Image&, const Gfx::Bitmap&, const String& name);
 
+    size_t tile_count() const;
+    Gfx::IntRect tile_rect(size_t index) const;
+
     Image& m_image;
 
     String m_name;
     Gfx::IntPoint m_location;
     RefPtr<Gfx::Bitmap> m_bitmap;
 
+    // The tiles of our latest snapshot, so the next one can reuse the ones that haven't changed.
+    NonnullRefPtrVector<Tile> m_tiles;
+
     bool m_selected { false };
     bool m_visible { true };
 
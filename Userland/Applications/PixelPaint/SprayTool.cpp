@@ -67,7 +67,6 @@ void SprayTool::paint_it()
     auto& bitmap = layer->bitmap();
     GUI::Painter painter(bitmap);
     VERIFY(bitmap.bpp() == 32);
-    m_editor->update();
     const double minimal_radius = 2;
     const double base_radius = minimal_radius * m_thickness;
     for (int i = 0; i < M_PI * base_radius * base_radius * (m_density / 100.0f); i++) {
@@ -82,7 +81,8 @@ void SprayTool::paint_it()
         bitmap.set_pixel<Gfx::StorageFormat::RGBA32>(xpos, ypos, m_color);
     }
 
-    layer->did_modify_bitmap(*m_editor->image());
+    int modified_radius = ceil(base_radius) + 1;
+    layer->did_modify_bitmap(*m_editor->image(), Gfx::IntRect(m_last_pos, { 1, 1 }).inflated(modified_radius * 2, modified_radius * 2));
 }
 
 void SprayTool::on_mousedown(Layer&, GUI::MouseEvent& event, GUI::MouseEvent&)
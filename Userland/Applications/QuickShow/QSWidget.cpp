@@ -188,8 +188,11 @@ void QSWidget::paint_event(GUI::PaintEvent& event)
 
     Gfx::StylePainter::paint_transparency_grid(painter, frame_inner_rect(), palette());
 
-    if (!m_bitmap.is_null())
-        painter.draw_scaled_bitmap(m_bitmap_rect, *m_bitmap, m_bitmap->rect());
+    if (!m_bitmap.is_null()) {
+        // Zoomed in, the individual pixels should stay visible.
+        auto scaling_mode = m_scale < 100 ? Gfx::Painter::ScalingMode::BoxSampling : Gfx::Painter::ScalingMode::NearestNeighbor;
+        painter.draw_scaled_bitmap(m_bitmap_rect, *m_bitmap, m_bitmap->rect(), 1.0f, scaling_mode);
+    }
 }
 
 void QSWidget::mousedown_event(GUI::MouseEvent& event)
@@ -24,12 +24,11 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #include "TreeMapWidget.h"
-#include <AK/Queue.h>
 #include <AK/QuickSort.h>
 #include <AK/RefCounted.h>
 #include <AK/URL.h>
 #include <Applications/SpaceAnalyzer/SpaceAnalyzerGML.h>
-#include <LibCore/DirIterator.h>
+#include <LibCore/DirectoryWalker.h>
 #include <LibCore/File.h>
 #include <LibDesktop/Launcher.h>
 #include <LibGUI/AboutDialog.h>
@@ -140,70 +139,60 @@ static long long int update_totals(TreeNode& node)
     return result;
 }
 
-struct QueueEntry {
-    QueueEntry(String path, TreeNode* node)
-        : path(move(path))
-        , node(node) {};
-    String path;
-    TreeNode* node { nullptr };
-};
-
-static void populate_filesize_tree(TreeNode& root, Vector<MountInfo>& mounts, HashMap<int, int>& error_accumulator)
+static void populate_directory(Core::DirectoryWalker& walker, TreeNode& node, const String& path, MountInfo& root_mount_info, Vector<MountInfo>& mounts, HashMap<int, int>& error_accumulator)
 {
-    VERIFY(!root.m_name.ends_with("/"));
-
-    Queue<QueueEntry> queue;
-    queue.enqueue(QueueEntry(root.m_name, &root));
+    auto accumulate_error = [&](int error) {
+        int error_sum = error_accumulator.get(error).value_or(0);
+        error_accumulator.set(error, error_sum + 1);
+    };
 
-    StringBuilder builder = StringBuilder();
-    builder.append(root.m_name);
-    builder.append("/");
-    MountInfo* root_mount_info = find_mount_for_path(builder.to_string(), mounts);
-    if (!root_mount_info) {
+    auto listing = walker.list(path);
+    if (listing.error) {
+        accumulate_error(listing.error);
         return;
     }
-    while (!queue.is_empty()) {
-        QueueEntry queue_entry = queue.dequeue();
 
-        builder.clear();
-        builder.append(queue_entry.path);
-        builder.append("/");
-
-        MountInfo* mount_info = find_mount_for_path(builder.to_string(), mounts);
-        if (!mount_info || (mount_info != root_mount_info && mount_info->source != root_mount_info->source)) {
+    node.m_children = make<Vector<TreeNode>>();
+    Vector<size_t> subdirectory_indices;
+    Vector<String> subdirectory_paths;
+    for (auto& entry : listing.entries) {
+        node.m_children->append(TreeNode(entry.name));
+        if (!entry.has_metadata) {
+            accumulate_error(entry.metadata_error);
             continue;
         }
-
-        Core::DirIterator dir_iterator(builder.to_string(), Core::DirIterator::SkipParentAndBaseDir);
-        if (dir_iterator.has_error()) {
-            int error_sum = error_accumulator.get(dir_iterator.error()).value_or(0);
-            error_accumulator.set(dir_iterator.error(), error_sum + 1);
-        } else {
-            queue_entry.node->m_children = make<Vector<TreeNode>>();
-            while (dir_iterator.has_next()) {
-                queue_entry.node->m_children->append(TreeNode(dir_iterator.next_path()));
-            }
-            for (auto& child : *queue_entry.node->m_children) {
-                String& name = child.m_name;
-                int name_len = name.length();
-                builder.append(name);
-                struct stat st;
-                int stat_result = lstat(builder.to_string().characters(), &st);
-                if (stat_result < 0) {
-                    int error_sum = error_accumulator.get(errno).value_or(0);
-                    error_accumulator.set(errno, error_sum + 1);
-                } else {
-                    if (S_ISDIR(st.st_mode)) {
-                        queue.enqueue(QueueEntry(builder.to_string(), &child));
-                    } else {
-                        child.m_area = st.st_size;
-                    }
-                }
-                builder.trim(name_len);
-            }
+        if (!S_ISDIR(entry.metadata.st_mode)) {
+            node.m_children->last().m_area = entry.metadata.st_size;
+            continue;
         }
+        auto subdirectory_path = String::formatted("{}{}/", path, entry.name);
+        MountInfo* mount_info = find_mount_for_path(subdirectory_path, mounts);
+        if (!mount_info || (mount_info != &root_mount_info && mount_info->source != root_mount_info.source))
+            continue;
+        subdirectory_indices.append(node.m_children->size() - 1);
+        subdirectory_paths.append(move(subdirectory_path));
     }
 
+    walker.prefetch(subdirectory_paths);
+    for (size_t i = 0; i < subdirectory_indices.size(); ++i)
+        populate_directory(walker, node.m_children->at(subdirectory_indices[i]), subdirectory_paths[i], root_mount_info, mounts, error_accumulator);
+}
+
+static void populate_filesize_tree(TreeNode& root, Vector<MountInfo>& mounts, HashMap<int, int>& error_accumulator)
+{
+    VERIFY(!root.m_name.ends_with("/"));
+
+    auto root_path = String::formatted("{}/", root.m_name);
+    MountInfo* root_mount_info = find_mount_for_path(root_path, mounts);
+    if (!root_mount_info) {
+        return;
+    }
+
+    Core::DirectoryWalker::Options walker_options;
+    walker_options.stat_entries = true;
+    Core::DirectoryWalker walker(walker_options);
+    populate_directory(walker, root, root_path, *root_mount_info, mounts, error_accumulator);
+
     update_totals(root);
 }
 
@@ -63,10 +63,12 @@ struct Cell : public Weakable<Cell> {
     }
 
     void reference_from(Cell*);
+    void forget_referenced_cells();
 
     void set_data(String new_data);
     void set_data(JS::Value new_data);
     bool dirty() const { return m_dirty; }
+    void mark_dirty() { m_dirty = true; }
     void clear_dirty() { m_dirty = false; }
 
     void set_exception(JS::Exception* exc) { m_js_exception = exc; }
@@ -119,6 +121,7 @@ struct Cell : public Weakable<Cell> {
     void copy_from(const Cell&);
 
 private:
+
     bool m_dirty { false };
     bool m_evaluated_externally { false };
     String m_data;
@@ -126,7 +129,9 @@ private:
     JS::Exception* m_js_exception { nullptr };
     Kind m_kind { LiteralString };
     WeakPtr<Sheet> m_sheet;
+    // The cells that use this one, and the ones this one used when it was last evaluated.
     Vector<WeakPtr<Cell>> m_referencing_cells;
+    Vector<WeakPtr<Cell>> m_referenced_cells;
     const CellType* m_type { nullptr };
     CellTypeMetadata m_type_metadata;
     Position m_position;
@@ -54,7 +54,7 @@ void CellSyntaxHighlighter::rehighlight(const Palette& palette)
         nullptr,
         false);
 
-    if (m_cell && m_cell->exception()) {
+    if (m_cell && m_cell->exception() && !m_cell->exception()->source_ranges().is_empty()) {
         auto range = m_cell->exception()->source_ranges().first();
         GUI::TextRange text_range { { range.start.line - 1, range.start.column }, { range.end.line - 1, range.end.column - 1 } };
         m_client->spans().prepend(
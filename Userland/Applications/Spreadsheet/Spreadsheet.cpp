@@ -38,6 +38,8 @@
 #include <AK/URL.h>
 #include <LibCore/File.h>
 #include <LibJS/Parser.h>
+#include <LibJS/Runtime/Error.h>
+#include <LibJS/Runtime/Exception.h>
 #include <LibJS/Runtime/Function.h>
 #include <ctype.h>
 
@@ -151,6 +153,51 @@ String Sheet::add_column()
     return next_column;
 }
 
+// Orders the changed cells and everything that uses them (directly or not) so that each cell comes after the ones it uses.
+// Cells that are part of a reference cycle, or use one, can't be ordered and are put into cells_in_cycles instead.
+static void order_cells_for_update(const Vector<Cell*>& changed_cells, Vector<Cell*>& ordered_cells, Vector<Cell*>& cells_in_cycles)
+{
+    // For every affected cell, the number of affected cells it uses that haven't been ordered yet.
+    HashMap<Cell*, size_t> pending_reference_counts;
+    Vector<Cell*> affected_cells;
+
+    for (auto* cell : changed_cells) {
+        pending_reference_counts.set(cell, 0);
+        affected_cells.append(cell);
+    }
+    for (size_t i = 0; i < affected_cells.size(); ++i) {
+        for (auto& referencing_cell : affected_cells[i]->referencing_cells()) {
+            if (referencing_cell && !pending_reference_counts.contains(referencing_cell.ptr())) {
+                pending_reference_counts.set(referencing_cell.ptr(), 0);
+                affected_cells.append(referencing_cell.ptr());
+            }
+        }
+    }
+
+    for (auto* cell : affected_cells) {
+        for (auto& referencing_cell : cell->referencing_cells()) {
+            if (referencing_cell)
+                ++pending_reference_counts.find(referencing_cell.ptr())->value;
+        }
+    }
+
+    for (auto* cell : affected_cells) {
+        if (pending_reference_counts.get(cell).value() == 0)
+            ordered_cells.append(cell);
+    }
+    for (size_t i = 0; i < ordered_cells.size(); ++i) {
+        for (auto& referencing_cell : ordered_cells[i]->referencing_cells()) {
+            if (referencing_cell && --pending_reference_counts.find(referencing_cell.ptr())->value == 0)
+                ordered_cells.append(referencing_cell.ptr());
+        }
+    }
+
+    for (auto* cell : affected_cells) {
+        if (pending_reference_counts.get(cell).value() != 0)
+            cells_in_cycles.append(cell);
+    }
+}
+
 void Sheet::update()
 {
     if (m_should_ignore_updates) {
@@ -158,19 +205,52 @@ void Sheet::update()
         return;
     }
     m_visited_cells_in_update.clear();
-    Vector<Cell*> cells_copy;
+    Vector<Cell*> changed_cells;
 
     // Grab a copy as updates might insert cells into the table.
     for (auto& it : m_cells) {
         if (it.value->dirty()) {
-            cells_copy.append(it.value);
+            changed_cells.append(it.value);
             m_workbook.set_dirty(true);
         }
     }
 
-    for (auto& cell : cells_copy)
+    // What a changed cell used before doesn't matter anymore, and would make it look like it's still part of a cycle.
+    // Evaluating it finds out what it uses now.
+    for (auto* cell : changed_cells)
+        cell->forget_referenced_cells();
+
+    // Only the changed cells and the ones that use them need to be evaluated again, and each of them only once,
+    // after everything it uses is up to date.
+    Vector<Cell*> ordered_cells;
+    Vector<Cell*> cells_in_cycles;
+    order_cells_for_update(changed_cells, ordered_cells, cells_in_cycles);
+
+    auto mark_circular_references = [&](auto& cells) {
+        for (auto* cell : cells) {
+            if (cell->kind() != Cell::Formula)
+                continue;
+            cell->clear_dirty();
+            auto* error = JS::ReferenceError::create(global_object(), "Circular reference");
+            cell->set_exception(interpreter().heap().allocate<JS::Exception>(global_object(), error));
+        }
+    };
+
+    for (auto* cell : ordered_cells)
+        cell->mark_dirty();
+    mark_circular_references(cells_in_cycles);
+
+    for (auto* cell : ordered_cells)
+        update(*cell);
+    for (auto* cell : cells_in_cycles)
         update(*cell);
 
+    // Evaluating the formulas may have turned up new references that close a cycle.
+    Vector<Cell*> reordered_cells;
+    Vector<Cell*> cells_in_new_cycles;
+    order_cells_for_update(ordered_cells, reordered_cells, cells_in_new_cycles);
+    mark_circular_references(cells_in_new_cycles);
+
     m_visited_cells_in_update.clear();
 }
 
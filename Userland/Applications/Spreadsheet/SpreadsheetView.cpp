@@ -156,6 +156,7 @@ SpreadsheetView::SpreadsheetView(Sheet& sheet)
     m_table_view->set_edit_triggers(GUI::AbstractView::EditTrigger::EditKeyPressed | GUI::AbstractView::AnyKeyPressed | GUI::AbstractView::DoubleClicked);
     m_table_view->set_tab_key_navigation_enabled(true);
     m_table_view->row_header().set_visible(true);
+    m_table_view->set_virtualized(true);
     m_table_view->set_model(SheetModel::create(*m_sheet));
     m_table_view->on_reaching_vertical_end = [&]() {
         for (size_t i = 0; i < 100; ++i) {
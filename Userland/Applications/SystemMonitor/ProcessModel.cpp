@@ -121,6 +121,18 @@ String ProcessModel::column_name(int column) const
         return "F:Zero";
     case Column::CowFaults:
         return "F:CoW";
+    case Column::MinorFaults:
+        return "F:Minor";
+    case Column::MajorFaults:
+        return "F:Major";
+    case Column::BlockIOWait:
+        return "I/O Wait";
+    case Column::VoluntaryContextSwitches:
+        return "CS:Vol";
+    case Column::InvoluntaryContextSwitches:
+        return "CS:Invol";
+    case Column::SchedulerLatency:
+        return "Sched Wait";
     case Column::IPv4SocketReadBytes:
         return "IPv4 In";
     case Column::IPv4SocketWriteBytes:
@@ -147,6 +159,11 @@ static String pretty_byte_size(size_t size)
     return String::formatted("{}K", size / 1024);
 }
 
+static String pretty_duration(u64 us)
+{
+    return String::formatted("{} ms", us / 1000);
+}
+
 GUI::Variant ProcessModel::data(const GUI::ModelIndex& index, GUI::ModelRole role) const
 {
     VERIFY(is_valid(index));
@@ -178,6 +195,12 @@ GUI::Variant ProcessModel::data(const GUI::ModelIndex& index, GUI::ModelRole rol
         case Column::InodeFaults:
         case Column::ZeroFaults:
         case Column::CowFaults:
+        case Column::MinorFaults:
+        case Column::MajorFaults:
+        case Column::BlockIOWait:
+        case Column::VoluntaryContextSwitches:
+        case Column::InvoluntaryContextSwitches:
+        case Column::SchedulerLatency:
         case Column::FileReadBytes:
         case Column::FileWriteBytes:
         case Column::UnixSocketReadBytes:
@@ -239,6 +262,18 @@ GUI::Variant ProcessModel::data(const GUI::ModelIndex& index, GUI::ModelRole rol
             return thread.current_state.zero_faults;
         case Column::CowFaults:
             return thread.current_state.cow_faults;
+        case Column::MinorFaults:
+            return thread.current_state.minor_faults;
+        case Column::MajorFaults:
+            return thread.current_state.major_faults;
+        case Column::BlockIOWait:
+            return (i64)thread.current_state.block_io_wait_us;
+        case Column::VoluntaryContextSwitches:
+            return thread.current_state.voluntary_context_switches;
+        case Column::InvoluntaryContextSwitches:
+            return thread.current_state.involuntary_context_switches;
+        case Column::SchedulerLatency:
+            return (i64)thread.current_state.scheduler_latency_us;
         case Column::IPv4SocketReadBytes:
             return thread.current_state.ipv4_socket_read_bytes;
         case Column::IPv4SocketWriteBytes:
@@ -309,6 +344,18 @@ GUI::Variant ProcessModel::data(const GUI::ModelIndex& index, GUI::ModelRole rol
             return thread.current_state.zero_faults;
         case Column::CowFaults:
             return thread.current_state.cow_faults;
+        case Column::MinorFaults:
+            return thread.current_state.minor_faults;
+        case Column::MajorFaults:
+            return thread.current_state.major_faults;
+        case Column::BlockIOWait:
+            return pretty_duration(thread.current_state.block_io_wait_us);
+        case Column::VoluntaryContextSwitches:
+            return thread.current_state.voluntary_context_switches;
+        case Column::InvoluntaryContextSwitches:
+            return thread.current_state.involuntary_context_switches;
+        case Column::SchedulerLatency:
+            return pretty_duration(thread.current_state.scheduler_latency_us);
         case Column::IPv4SocketReadBytes:
             return thread.current_state.ipv4_socket_read_bytes;
         case Column::IPv4SocketWriteBytes:
@@ -334,7 +381,7 @@ GUI::Variant ProcessModel::data(const GUI::ModelIndex& index, GUI::ModelRole rol
 void ProcessModel::update()
 {
     auto previous_tid_count = m_tids.size();
-    auto all_processes = Core::ProcessStatisticsReader::get_all(m_proc_all);
+    auto all_processes = Core::ProcessStatisticsReader::get_all(m_proc_stats);
 
     u64 last_sum_ticks_scheduled = 0, last_sum_ticks_scheduled_kernel = 0;
     for (auto& it : m_threads) {
@@ -357,6 +404,12 @@ void ProcessModel::update()
                 state.inode_faults = thread.inode_faults;
                 state.zero_faults = thread.zero_faults;
                 state.cow_faults = thread.cow_faults;
+                state.minor_faults = thread.minor_faults;
+                state.major_faults = thread.major_faults;
+                state.block_io_wait_us = thread.block_io_wait_us;
+                state.voluntary_context_switches = thread.voluntary_context_switches;
+                state.involuntary_context_switches = thread.involuntary_context_switches;
+                state.scheduler_latency_us = thread.scheduler_latency_us;
                 state.unix_socket_read_bytes = thread.unix_socket_read_bytes;
                 state.unix_socket_write_bytes = thread.unix_socket_write_bytes;
                 state.ipv4_socket_read_bytes = thread.ipv4_socket_read_bytes;
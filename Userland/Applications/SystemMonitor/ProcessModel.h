@@ -62,6 +62,12 @@ public:
         InodeFaults,
         ZeroFaults,
         CowFaults,
+        MinorFaults,
+        MajorFaults,
+        BlockIOWait,
+        VoluntaryContextSwitches,
+        InvoluntaryContextSwitches,
+        SchedulerLatency,
         FileReadBytes,
         FileWriteBytes,
         UnixSocketReadBytes,
@@ -126,6 +132,12 @@ private:
         unsigned inode_faults;
         unsigned zero_faults;
         unsigned cow_faults;
+        unsigned minor_faults;
+        unsigned major_faults;
+        u64 block_io_wait_us;
+        unsigned voluntary_context_switches;
+        unsigned involuntary_context_switches;
+        u64 scheduler_latency_us;
         unsigned unix_socket_read_bytes;
         unsigned unix_socket_write_bytes;
         unsigned ipv4_socket_read_bytes;
@@ -145,5 +157,5 @@ private:
     NonnullOwnPtrVector<CpuInfo> m_cpus;
     Vector<int> m_tids;
     RefPtr<Gfx::Bitmap> m_generic_process_icon;
-    RefPtr<Core::File> m_proc_all;
+    RefPtr<Core::File> m_proc_stats;
 };
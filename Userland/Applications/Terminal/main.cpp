@@ -397,6 +397,8 @@ int main(int argc, char** argv)
 
     auto new_scrollback_size = config->read_num_entry("Terminal", "MaxHistorySize", terminal.max_history_size());
     terminal.set_max_history_size(new_scrollback_size);
+    auto new_scrollback_bytes = config->read_num_entry("Terminal", "MaxHistoryBytes", terminal.max_history_bytes());
+    terminal.set_max_history_bytes(new_scrollback_bytes);
 
     auto open_settings_action = GUI::Action::create("Settings", Gfx::Bitmap::load_from_file("/res/icons/16x16/gear.png"),
         [&](const GUI::Action&) {
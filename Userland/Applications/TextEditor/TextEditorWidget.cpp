@@ -27,6 +27,7 @@
 #include "TextEditorWidget.h"
 #include <AK/JsonObject.h>
 #include <AK/JsonValue.h>
+#include <AK/MappedFile.h>
 #include <AK/Optional.h>
 #include <AK/StringBuilder.h>
 #include <AK/URL.h>
@@ -590,7 +591,11 @@ void TextEditorWidget::open_file(const String& path)
         return;
     }
 
-    m_editor->set_text(file->read_all());
+    // Mapping the file lets the document decode only the lines we actually look at, so large files open quickly.
+    if (auto mapped_file = MappedFile::map(path); !mapped_file.is_error())
+        m_editor->set_text_from_mapped_file(mapped_file.release_value());
+    else
+        m_editor->set_text(file->read_all());
     m_document_dirty = false;
     m_document_opening = true;
 
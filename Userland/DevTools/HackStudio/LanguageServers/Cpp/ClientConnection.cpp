@@ -85,7 +85,7 @@ void ClientConnection::handle(const Messages::LanguageServer::FileEditInsertText
     dbgln("[{}:{}]", message.start_line(), message.start_column());
 #endif
     m_filedb.on_file_edit_insert_text(message.file_name(), message.text(), message.start_line(), message.start_column());
-    m_autocomplete_engine->on_edit(message.file_name());
+    did_edit_file(message.file_name());
 }
 
 void ClientConnection::handle(const Messages::LanguageServer::FileEditRemoveText& message)
@@ -95,7 +95,7 @@ void ClientConnection::handle(const Messages::LanguageServer::FileEditRemoveText
     dbgln("[{}:{} - {}:{}]", message.start_line(), message.start_column(), message.end_line(), message.end_column());
 #endif
     m_filedb.on_file_edit_remove_text(message.file_name(), message.start_line(), message.start_column(), message.end_line(), message.end_column());
-    m_autocomplete_engine->on_edit(message.file_name());
+    did_edit_file(message.file_name());
 }
 
 void ClientConnection::handle(const Messages::LanguageServer::AutoCompleteSuggestions& message)
@@ -110,6 +110,7 @@ void ClientConnection::handle(const Messages::LanguageServer::AutoCompleteSugges
         return;
     }
 
+    flush_edited_files();
     GUI::TextPosition autocomplete_position = { (size_t)message.location().line, (size_t)max(message.location().column, message.location().column - 1) };
     Vector<GUI::AutocompleteProvider::Entry> suggestions = m_autocomplete_engine->get_suggestions(message.location().file, autocomplete_position);
     post_message(Messages::LanguageClient::AutoCompleteSuggestions(move(suggestions)));
@@ -124,7 +125,7 @@ void ClientConnection::handle(const Messages::LanguageServer::SetFileContent& me
     }
     auto content = message.content();
     document->set_text(content.view());
-    m_autocomplete_engine->on_edit(message.file_name());
+    did_edit_file(message.file_name());
 }
 
 void ClientConnection::handle(const Messages::LanguageServer::SetAutoCompleteMode& message)
@@ -132,6 +133,7 @@ void ClientConnection::handle(const Messages::LanguageServer::SetAutoCompleteMod
 #ifdef CPP_LANGUAGE_SERVER_DEBUG
     dbgln("SetAutoCompleteMode: {}", message.mode());
 #endif
+    m_edited_files.clear();
     if (message.mode() == "Parser")
         m_autocomplete_engine = make<ParserAutoComplete>(*this, m_filedb);
     else
@@ -147,6 +149,7 @@ void ClientConnection::handle(const Messages::LanguageServer::FindDeclaration& m
         return;
     }
 
+    flush_edited_files();
     GUI::TextPosition identifier_position = { (size_t)message.location().line, (size_t)message.location().column };
     auto location = m_autocomplete_engine->find_declaration_of(message.location().file, identifier_position);
     if (!location.has_value()) {
@@ -157,6 +160,20 @@ void ClientConnection::handle(const Messages::LanguageServer::FindDeclaration& m
     post_message(Messages::LanguageClient::DeclarationLocation(GUI::AutocompleteProvider::ProjectLocation { location.value().file, location.value().line, location.value().column }));
 }
 
+void ClientConnection::did_edit_file(const String& file_name)
+{
+    if (m_edited_files.is_empty())
+        deferred_invoke([this](auto&) { flush_edited_files(); });
+    m_edited_files.set(file_name);
+}
+
+void ClientConnection::flush_edited_files()
+{
+    auto edited_files = move(m_edited_files);
+    for (auto& file_name : edited_files)
+        m_autocomplete_engine->on_edit(file_name);
+}
+
 void ClientConnection::set_declarations_of_document_callback(ClientConnection& instance, const String& filename, Vector<GUI::AutocompleteProvider::Declaration>&& declarations)
 {
     instance.post_message(Messages::LanguageClient::DeclarationsInDocument(filename, move(declarations)));
@@ -29,6 +29,7 @@
 #include "AutoCompleteEngine.h"
 #include "FileDB.h"
 #include <AK/HashMap.h>
+#include <AK/HashTable.h>
 #include <AK/LexicalPath.h>
 #include <DevTools/HackStudio/AutoCompleteResponse.h>
 #include <LibIPC/ClientConnection.h>
@@ -61,8 +62,15 @@ private:
 
     static void set_declarations_of_document_callback(ClientConnection&, const String&, Vector<GUI::AutocompleteProvider::Declaration>&&);
 
+    void did_edit_file(const String& file_name);
+    void flush_edited_files();
+
     FileDB m_filedb;
     OwnPtr<AutoCompleteEngine> m_autocomplete_engine;
+
+    // Every keystroke in the editor arrives as its own edit message, so we only tell the
+    // autocomplete engine about edits once we've handled all the messages we received.
+    HashTable<String> m_edited_files;
 };
 
 }
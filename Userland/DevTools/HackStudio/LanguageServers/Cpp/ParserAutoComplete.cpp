@@ -47,15 +47,18 @@ const ParserAutoComplete::DocumentData& ParserAutoComplete::get_or_create_docume
     if (!m_documents.contains(absolute_path)) {
         set_document_data(absolute_path, create_document_data_for(absolute_path));
     }
-    return get_document_data(absolute_path);
+    auto document_data = get_document_data(absolute_path);
+    VERIFY(document_data);
+    return *document_data;
 }
 
-const ParserAutoComplete::DocumentData& ParserAutoComplete::get_document_data(const String& file) const
+const ParserAutoComplete::DocumentData* ParserAutoComplete::get_document_data(const String& file) const
 {
     auto absolute_path = filedb().to_absolute_path(file);
     auto document_data = m_documents.get(absolute_path);
-    VERIFY(document_data.has_value());
-    return *document_data.value();
+    if (!document_data.has_value())
+        return nullptr;
+    return document_data.value();
 }
 
 OwnPtr<ParserAutoComplete::DocumentData> ParserAutoComplete::create_document_data_for(const String& file)
@@ -63,12 +66,8 @@ OwnPtr<ParserAutoComplete::DocumentData> ParserAutoComplete::create_document_dat
     auto document = filedb().get(file);
     if (!document)
         return {};
-    auto content = document->text();
     auto document_data = make<DocumentData>(document->text(), file);
     auto root = document_data->parser.parse();
-    for (auto& path : document_data->preprocessor.included_paths()) {
-        get_or_create_document_data(document_path_from_include_path(path));
-    }
 #ifdef CPP_LANGUAGE_SERVER_DEBUG
     root->dump(0);
 #endif
@@ -80,7 +79,24 @@ OwnPtr<ParserAutoComplete::DocumentData> ParserAutoComplete::create_document_dat
 
 void ParserAutoComplete::set_document_data(const String& file, OwnPtr<DocumentData>&& data)
 {
-    m_documents.set(filedb().to_absolute_path(file), move(data));
+    auto absolute_path = filedb().to_absolute_path(file);
+    if (auto old_data = get_document_data(absolute_path))
+        remove_from_symbol_index(*old_data);
+    m_declarations_including_headers.clear();
+    m_documents.set(absolute_path, move(data));
+
+    auto document_data = get_document_data(absolute_path);
+    if (!document_data)
+        return;
+    add_to_symbol_index(*document_data);
+
+    // Headers that we've already parsed are reused as they are, and since this document is already
+    // in m_documents, an include cycle doesn't make us parse it again.
+    for (auto& path : document_data->preprocessor.included_paths()) {
+        auto included_path = filedb().to_absolute_path(document_path_from_include_path(path));
+        if (!m_documents.contains(included_path))
+            set_document_data(included_path, create_document_data_for(included_path));
+    }
 }
 
 ParserAutoComplete::DocumentData::DocumentData(String&& _text, const String& _filename)
@@ -271,15 +287,31 @@ Vector<ParserAutoComplete::PropertyInfo> ParserAutoComplete::properties_of_type(
 
 NonnullRefPtrVector<Declaration> ParserAutoComplete::get_declarations_in_outer_scope_including_headers(const DocumentData& document) const
 {
+    auto absolute_path = filedb().to_absolute_path(document.filename);
+    if (auto cached_declarations = m_declarations_including_headers.get(absolute_path); cached_declarations.has_value())
+        return cached_declarations.release_value();
+
     NonnullRefPtrVector<Declaration> declarations;
+    HashTable<String> visited_documents;
+    collect_declarations_in_outer_scope_including_headers(document, declarations, visited_documents);
+    m_declarations_including_headers.set(absolute_path, declarations);
+    return declarations;
+}
+
+void ParserAutoComplete::collect_declarations_in_outer_scope_including_headers(const DocumentData& document, NonnullRefPtrVector<Declaration>& declarations, HashTable<String>& visited_documents) const
+{
+    // A header that's included more than once only contributes its declarations once.
+    if (visited_documents.set(filedb().to_absolute_path(document.filename)) != AK::HashSetResult::InsertedNewEntry)
+        return;
     for (auto& include : document.preprocessor.included_paths()) {
         auto included_document = get_document_data(document_path_from_include_path(include));
-        declarations.append(get_declarations_in_outer_scope_including_headers(included_document));
+        if (!included_document)
+            continue;
+        collect_declarations_in_outer_scope_including_headers(*included_document, declarations, visited_documents);
     }
     for (auto& decl : document.parser.root_node()->declarations()) {
         declarations.append(decl);
     }
-    return declarations;
 }
 
 String ParserAutoComplete::document_path_from_include_path(const StringView& include_path) const
@@ -314,6 +346,11 @@ String ParserAutoComplete::document_path_from_include_path(const StringView& inc
 
 void ParserAutoComplete::on_edit(const String& file)
 {
+    // Edits that cancel each other out (or a SetFileContent with the same text) don't need a reparse.
+    auto document = filedb().get(file);
+    auto document_data = get_document_data(file);
+    if (document && document_data && document_data->text == document->text())
+        return;
     set_document_data(file, create_document_data_for(file));
 }
 
@@ -332,7 +369,7 @@ Optional<GUI::AutocompleteProvider::ProjectLocation> ParserAutoComplete::find_de
     }
     auto decl = find_declaration_of(document, *node);
     if (!decl)
-        return {};
+        return find_declaration_in_symbol_index(*node);
 
     return GUI::AutocompleteProvider::ProjectLocation { decl->filename(), decl->start().line, decl->start().column };
 }
@@ -365,6 +402,46 @@ RefPtr<Declaration> ParserAutoComplete::find_declaration_of(const DocumentData&
     return {};
 }
 
+Optional<GUI::AutocompleteProvider::ProjectLocation> ParserAutoComplete::find_declaration_in_symbol_index(const ASTNode& node) const
+{
+    StringView name;
+    if (node.is_identifier())
+        name = static_cast<const Identifier&>(node).m_name;
+    else if (node.is_type())
+        name = static_cast<const Type&>(node).m_name;
+    else if (node.is_function_call())
+        name = static_cast<const FunctionCall&>(node).m_name;
+    if (name.is_empty())
+        return {};
+
+    auto locations = m_symbol_index.get(name);
+    if (!locations.has_value() || locations.value().is_empty())
+        return {};
+    dbgln_if(CPP_LANGUAGE_SERVER_DEBUG, "found {} in the symbol index", name);
+    return locations.value().first();
+}
+
+void ParserAutoComplete::add_to_symbol_index(const DocumentData& document)
+{
+    for (auto& decl : document.parser.root_node()->declarations()) {
+        if (decl.name().is_empty())
+            continue;
+        m_symbol_index.ensure(decl.name()).append({ decl.filename(), decl.start().line, decl.start().column });
+    }
+}
+
+void ParserAutoComplete::remove_from_symbol_index(const DocumentData& document)
+{
+    for (auto& decl : document.parser.root_node()->declarations()) {
+        auto it = m_symbol_index.find(decl.name());
+        if (it == m_symbol_index.end())
+            continue;
+        it->value.remove_all_matching([&](auto& location) { return location.file == decl.filename(); });
+        if (it->value.is_empty())
+            m_symbol_index.remove(it);
+    }
+}
+
 void ParserAutoComplete::update_declared_symbols(const DocumentData& document)
 {
     Vector<GUI::AutocompleteProvider::Declaration> declarations;
@@ -29,6 +29,7 @@
 #include "AutoCompleteEngine.h"
 #include "FileDB.h"
 #include <AK/Function.h>
+#include <AK/HashTable.h>
 #include <AK/String.h>
 #include <AK/Vector.h>
 #include <DevTools/HackStudio/AutoCompleteResponse.h>
@@ -75,17 +76,29 @@ private:
     };
     Vector<PropertyInfo> properties_of_type(const DocumentData& document, const String& type) const;
     NonnullRefPtrVector<Declaration> get_declarations_in_outer_scope_including_headers(const DocumentData& document) const;
+    void collect_declarations_in_outer_scope_including_headers(const DocumentData& document, NonnullRefPtrVector<Declaration>&, HashTable<String>& visited_documents) const;
+    Optional<GUI::AutocompleteProvider::ProjectLocation> find_declaration_in_symbol_index(const ASTNode&) const;
 
-    const DocumentData& get_document_data(const String& file) const;
+    const DocumentData* get_document_data(const String& file) const;
     const DocumentData& get_or_create_document_data(const String& file);
     void set_document_data(const String& file, OwnPtr<DocumentData>&& data);
 
     OwnPtr<DocumentData> create_document_data_for(const String& file);
     String document_path_from_include_path(const StringView& include_path) const;
     void update_declared_symbols(const DocumentData&);
+    void add_to_symbol_index(const DocumentData&);
+    void remove_from_symbol_index(const DocumentData&);
     GUI::AutocompleteProvider::DeclarationType type_of_declaration(const Declaration&);
 
     HashMap<String, OwnPtr<DocumentData>> m_documents;
+
+    // The declarations visible in a document's outer scope, including the ones from the headers it
+    // (transitively) includes. This is thrown away whenever any document changes.
+    mutable HashMap<String, NonnullRefPtrVector<Declaration>> m_declarations_including_headers;
+
+    // Where the top-level declarations of every document we've parsed so far are, by name.
+    // This lets us find declarations in files that aren't included by the current one.
+    HashMap<String, Vector<GUI::AutocompleteProvider::ProjectLocation>> m_symbol_index;
 };
 
 }
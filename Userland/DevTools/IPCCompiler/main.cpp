@@ -24,6 +24,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/AnyOf.h>
 #include <AK/Debug.h>
 #include <AK/Function.h>
 #include <AK/GenericLexer.h>
@@ -38,6 +39,9 @@ struct Parameter {
     Vector<String> attributes;
     String type;
     String name;
+
+    // Borrowed parameters are decoded as views into the buffer the message was received in.
+    bool is_borrowed() const { return attributes.contains_slow("Borrow"); }
 };
 
 struct Message {
@@ -113,6 +117,16 @@ int main(int argc, char** argv)
                 }
             }
             parameter.type = lexer.consume_until([](char ch) { return isspace(ch); });
+            if (parameter.is_borrowed()) {
+                if (parameter.type == "String") {
+                    parameter.type = "StringView";
+                } else if (parameter.type == "ByteBuffer") {
+                    parameter.type = "ReadonlyBytes";
+                } else {
+                    warnln("Error: Cannot borrow a parameter of type {}", parameter.type);
+                    exit(1);
+                }
+            }
             consume_whitespace();
             parameter.name = lexer.consume_until([](char ch) { return isspace(ch) || ch == ',' || ch == ')'; });
             consume_whitespace();
@@ -317,16 +331,19 @@ public:
     static i32 static_message_id() { return (int)MessageID::@message.name@; }
     virtual const char* message_name() const override { return "@endpoint.name@::@message.name@"; }
 
-    static OwnPtr<@message.name@> decode(InputMemoryStream& stream, int sockfd)
+    static OwnPtr<@message.name@> decode(InputMemoryStream& stream, int sockfd, RefPtr<IPC::ReceiveBuffer> receive_buffer = {})
     {
-        IPC::Decoder decoder { stream, sockfd };
+        IPC::Decoder decoder { stream, sockfd, move(receive_buffer) };
 )~~~");
 
+            bool has_borrowed_parameters = any_of(parameters.begin(), parameters.end(), [](auto& parameter) { return parameter.is_borrowed(); });
+
             for (auto& parameter : parameters) {
                 auto parameter_generator = message_generator.fork();
 
                 parameter_generator.set("parameter.type", parameter.type);
                 parameter_generator.set("parameter.name", parameter.name);
+                parameter_generator.set("parameter.decode", parameter.is_borrowed() ? "decode_borrowed" : "decode");
 
                 if (parameter.type == "bool")
                     parameter_generator.set("parameter.initial_value", "false");
@@ -335,7 +352,7 @@ public:
 
                 parameter_generator.append(R"~~~(
         @parameter.type@ @parameter.name@ = @parameter.initial_value@;
-        if (!decoder.decode(@parameter.name@))
+        if (!decoder.@parameter.decode@(@parameter.name@))
             return {};
 )~~~");
 
@@ -359,10 +376,19 @@ public:
 
             message_generator.set("message.constructor_call_parameters", builder.build());
 
-            message_generator.append(R"~~~(
+            if (has_borrowed_parameters) {
+                message_generator.append(R"~~~(
+        auto message = make<@message.name@>(@message.constructor_call_parameters@);
+        message->m_receive_buffer = decoder.receive_buffer();
+        return message;
+    }
+)~~~");
+            } else {
+                message_generator.append(R"~~~(
         return make<@message.name@>(@message.constructor_call_parameters@);
     }
 )~~~");
+            }
 
             message_generator.append(R"~~~(
     virtual IPC::MessageBuffer encode() const override
@@ -377,9 +403,15 @@ public:
                 auto parameter_generator = message_generator.fork();
 
                 parameter_generator.set("parameter.name", parameter.name);
-                parameter_generator.append(R"~~~(
+                if (parameter.is_borrowed()) {
+                    parameter_generator.append(R"~~~(
+        stream.encode_borrowed(m_@parameter.name@);
+)~~~");
+                } else {
+                    parameter_generator.append(R"~~~(
         stream << m_@parameter.name@;
 )~~~");
+                }
             }
 
             message_generator.append(R"~~~(
@@ -409,6 +441,12 @@ private:
 )~~~");
             }
 
+            if (has_borrowed_parameters) {
+                message_generator.append(R"~~~(
+    RefPtr<IPC::ReceiveBuffer> m_receive_buffer;
+)~~~");
+            }
+
             message_generator.append(R"~~~(
 };
             )~~~");
@@ -437,7 +475,7 @@ public:
     static String static_name() { return "@endpoint.name@"; }
     virtual String name() const override { return "@endpoint.name@"; }
 
-    static OwnPtr<IPC::Message> decode_message(ReadonlyBytes buffer, int sockfd)
+    static OwnPtr<IPC::Message> decode_message(ReadonlyBytes buffer, int sockfd, RefPtr<IPC::ReceiveBuffer> receive_buffer = {})
     {
         InputMemoryStream stream { buffer };
         i32 message_endpoint_magic = 0;
@@ -489,7 +527,7 @@ public:
 
                 message_generator.append(R"~~~(
         case (int)Messages::@endpoint.name@::MessageID::@message.name@:
-            message = Messages::@endpoint.name@::@message.name@::decode(stream, sockfd);
+            message = Messages::@endpoint.name@::@message.name@::decode(stream, sockfd, receive_buffer);
             break;
 )~~~");
             };
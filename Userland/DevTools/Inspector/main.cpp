@@ -73,7 +73,7 @@ int main(int argc, char** argv)
         return 1;
     }
 
-    if (unveil("/proc/all", "r") < 0) {
+    if (unveil("/proc/stats", "r") < 0) {
         perror("unveil");
         return 1;
     }
@@ -28,30 +28,47 @@
 #include "DisassemblyModel.h"
 #include "ProfileModel.h"
 #include "SamplesModel.h"
-#include <AK/HashTable.h>
+#include <AK/Atomic.h>
 #include <AK/LexicalPath.h>
 #include <AK/MappedFile.h>
-#include <AK/QuickSort.h>
+#include <AK/MemoryStream.h>
+#include <AK/MergeSort.h>
 #include <AK/RefPtr.h>
+#include <Kernel/API/Perfcore.h>
 #include <LibCore/File.h>
 #include <LibELF/Image.h>
+#include <LibThread/ThreadPool.h>
+#include <serenity.h>
 #include <sys/stat.h>
 
 static void sort_profile_nodes(Vector<NonnullRefPtr<ProfileNode>>& nodes)
 {
-    quick_sort(nodes.begin(), nodes.end(), [](auto& a, auto& b) {
-        return a->event_count() >= b->event_count();
+    // Nodes whose last event left the filter range go away, along with all of their children.
+    nodes.remove_all_matching([](auto& node) { return node->event_count() == 0; });
+
+    // Keep nodes with the same event count in the order they first showed up in.
+    merge_sort(nodes, [](auto& a, auto& b) {
+        return a->event_count() > b->event_count();
     });
 
     for (auto& child : nodes)
         child->sort_children();
 }
 
-Profile::Profile(String executable_path, Vector<Event> events, NonnullOwnPtr<LibraryMetadata> library_metadata)
+Profile::Profile(String executable_path, String sample_source, Vector<Event> events, NonnullOwnPtr<LibraryMetadata> library_metadata)
     : m_executable_path(move(executable_path))
+    , m_sample_source(move(sample_source))
     , m_events(move(events))
     , m_library_metadata(move(library_metadata))
 {
+    // Events are recorded in order, so this is only ever needed for hand-edited profiles.
+    for (size_t i = 1; i < m_events.size(); ++i) {
+        if (m_events[i].timestamp < m_events[i - 1].timestamp) {
+            merge_sort(m_events, [](auto& a, auto& b) { return a.timestamp < b.timestamp; });
+            break;
+        }
+    }
+
     m_first_timestamp = m_events.first().timestamp;
     m_last_timestamp = m_events.last().timestamp;
 
@@ -60,8 +77,11 @@ Profile::Profile(String executable_path, Vector<Event> events, NonnullOwnPtr<Lib
 
     for (auto& event : m_events) {
         m_deepest_stack_depth = max((u32)event.frames.size(), m_deepest_stack_depth);
+        if (event.type == "free")
+            m_has_free_events = true;
     }
 
+    update_filtered_events();
     rebuild_tree();
 }
 
@@ -79,178 +99,277 @@ GUI::Model& Profile::samples_model()
     return *m_samples_model;
 }
 
-void Profile::rebuild_tree()
+size_t Profile::first_event_index_at_or_after(u64 timestamp) const
 {
-    u32 filtered_event_count = 0;
-    Vector<NonnullRefPtr<ProfileNode>> roots;
-
-    auto find_or_create_root = [&roots](FlyString object_name, String symbol, u32 address, u32 offset, u64 timestamp) -> ProfileNode& {
-        for (size_t i = 0; i < roots.size(); ++i) {
-            auto& root = roots[i];
-            if (root->symbol() == symbol) {
-                return root;
-            }
-        }
-        auto new_root = ProfileNode::create(move(object_name), move(symbol), address, offset, timestamp);
-        roots.append(new_root);
-        return new_root;
-    };
+    size_t begin = 0;
+    size_t end = m_events.size();
+    while (begin < end) {
+        size_t middle = begin + (end - begin) / 2;
+        if (m_events[middle].timestamp < timestamp)
+            begin = middle + 1;
+        else
+            end = middle;
+    }
+    return begin;
+}
 
-    HashTable<FlatPtr> live_allocations;
+void Profile::update_filtered_events()
+{
+    if (!m_has_timestamp_filter_range) {
+        m_filtered_events_begin = 0;
+        m_filtered_events_end = m_events.size();
+    } else {
+        m_filtered_events_begin = first_event_index_at_or_after(m_timestamp_filter_range_start);
+        m_filtered_events_end = first_event_index_at_or_after(m_timestamp_filter_range_end + 1);
+    }
+    m_first_filtered_event_index = m_filtered_events_begin;
+}
 
-    for_each_event_in_filter_range([&](auto& event) {
-        if (event.type == "malloc")
-            live_allocations.set(event.ptr);
-        else if (event.type == "free")
-            live_allocations.remove(event.ptr);
-    });
+ProfileNode& Profile::find_or_create_root(const Frame& frame, u64 timestamp)
+{
+    for (size_t i = 0; i < m_roots.size(); ++i) {
+        auto& root = m_roots[i];
+        if (root->symbol() == frame.symbol) {
+            return root;
+        }
+    }
+    auto new_root = ProfileNode::create(frame.object_name, frame.symbol, frame.address, frame.offset, timestamp);
+    m_roots.append(new_root);
+    return new_root;
+}
 
-    Optional<size_t> first_filtered_event_index;
+// Adds the event to the tree when delta is 1, and takes it out again when delta is -1.
+// Returns whether the event counts towards the tree at all.
+bool Profile::add_or_remove_event(size_t event_index, int delta)
+{
+    auto& event = m_events.at(event_index);
 
-    for (size_t event_index = 0; event_index < m_events.size(); ++event_index) {
-        auto& event = m_events.at(event_index);
-        if (has_timestamp_filter_range()) {
-            auto timestamp = event.timestamp;
-            if (timestamp < m_timestamp_filter_range_start || timestamp > m_timestamp_filter_range_end)
-                continue;
-        }
+    if (event.type == "malloc" && m_has_free_events && !m_live_allocations.contains(event.ptr))
+        return false;
 
-        if (!first_filtered_event_index.has_value())
-            first_filtered_event_index = event_index;
+    // Only samples and allocations say where time or memory went.
+    if (event.type == "free" || event.is_tracepoint)
+        return false;
 
-        if (event.type == "malloc" && !live_allocations.contains(event.ptr))
-            continue;
+    auto for_each_frame = [&]<typename Callback>(Callback callback) {
+        if (!m_inverted) {
+            for (size_t i = 0; i < event.frames.size(); ++i) {
+                if (callback(event.frames.at(i), i == event.frames.size() - 1) == IterationDecision::Break)
+                    break;
+            }
+        } else {
+            for (ssize_t i = event.frames.size() - 1; i >= 0; --i) {
+                if (callback(event.frames.at(i), static_cast<size_t>(i) == event.frames.size() - 1) == IterationDecision::Break)
+                    break;
+            }
+        }
+    };
 
-        if (event.type == "free")
-            continue;
+    if (!m_show_top_functions) {
+        ProfileNode* node = nullptr;
+        for_each_frame([&](const Frame& frame, bool is_innermost_frame) {
+            if (frame.symbol.is_empty())
+                return IterationDecision::Break;
+
+            if (!node)
+                node = &find_or_create_root(frame, event.timestamp);
+            else
+                node = &node->find_or_create_child(frame.object_name, frame.symbol, frame.address, frame.offset, event.timestamp);
+
+            node->adjust_event_count(delta);
+            if (is_innermost_frame) {
+                node->adjust_event_address_count(frame.address, delta);
+                node->adjust_self_count(delta);
+            }
+            return IterationDecision::Continue;
+        });
+        return true;
+    }
 
-        auto for_each_frame = [&]<typename Callback>(Callback callback) {
-            if (!m_inverted) {
-                for (size_t i = 0; i < event.frames.size(); ++i) {
-                    if (callback(event.frames.at(i), i == event.frames.size() - 1) == IterationDecision::Break)
-                        break;
-                }
+    // A function shows up as a root once for every frame it's in, but only counts the event once.
+    Vector<ProfileNode*, 16> counted_roots;
+    for (size_t i = 0; i < event.frames.size(); ++i) {
+        ProfileNode* node = nullptr;
+        ProfileNode* root = nullptr;
+        for (size_t j = i; j < event.frames.size(); ++j) {
+            auto& frame = event.frames.at(j);
+            if (frame.symbol.is_empty())
+                break;
+
+            if (!node) {
+                node = &find_or_create_root(frame, event.timestamp);
+                root = node;
             } else {
-                for (ssize_t i = event.frames.size() - 1; i >= 0; --i) {
-                    if (callback(event.frames.at(i), static_cast<size_t>(i) == event.frames.size() - 1) == IterationDecision::Break)
-                        break;
-                }
+                node = &node->find_or_create_child(frame.object_name, frame.symbol, frame.address, frame.offset, event.timestamp);
             }
-        };
-
-        if (!m_show_top_functions) {
-            ProfileNode* node = nullptr;
-            for_each_frame([&](const Frame& frame, bool is_innermost_frame) {
-                auto& object_name = frame.object_name;
-                auto& symbol = frame.symbol;
-                auto& address = frame.address;
-                auto& offset = frame.offset;
-
-                if (symbol.is_empty())
-                    return IterationDecision::Break;
-
-                if (!node)
-                    node = &find_or_create_root(object_name, symbol, address, offset, event.timestamp);
-                else
-                    node = &node->find_or_create_child(object_name, symbol, address, offset, event.timestamp);
-
-                node->increment_event_count();
-                if (is_innermost_frame) {
-                    node->add_event_address(address);
-                    node->increment_self_count();
-                }
-                return IterationDecision::Continue;
-            });
-        } else {
-            for (size_t i = 0; i < event.frames.size(); ++i) {
-                ProfileNode* node = nullptr;
-                ProfileNode* root = nullptr;
-                for (size_t j = i; j < event.frames.size(); ++j) {
-                    auto& frame = event.frames.at(j);
-                    auto& object_name = frame.object_name;
-                    auto& symbol = frame.symbol;
-                    auto& address = frame.address;
-                    auto& offset = frame.offset;
-                    if (symbol.is_empty())
-                        break;
-
-                    if (!node) {
-                        node = &find_or_create_root(object_name, symbol, address, offset, event.timestamp);
-                        root = node;
-                        root->will_track_seen_events(m_events.size());
-                    } else {
-                        node = &node->find_or_create_child(object_name, symbol, address, offset, event.timestamp);
-                    }
 
-                    if (!root->has_seen_event(event_index)) {
-                        root->did_see_event(event_index);
-                        root->increment_event_count();
-                    } else if (node != root) {
-                        node->increment_event_count();
-                    }
+            if (!counted_roots.contains_slow(root)) {
+                counted_roots.append(root);
+                root->adjust_event_count(delta);
+            } else if (node != root) {
+                node->adjust_event_count(delta);
+            }
 
-                    if (j == event.frames.size() - 1) {
-                        node->add_event_address(address);
-                        node->increment_self_count();
-                    }
-                }
+            if (j == event.frames.size() - 1) {
+                node->adjust_event_address_count(frame.address, delta);
+                node->adjust_self_count(delta);
             }
         }
+    }
+    return true;
+}
 
-        ++filtered_event_count;
+void Profile::rebuild_tree()
+{
+    m_roots.clear();
+    m_filtered_event_count = 0;
+
+    m_live_allocations.clear();
+    if (m_has_free_events) {
+        for_each_event_in_filter_range([&](auto& event) {
+            if (event.type == "malloc")
+                m_live_allocations.set(event.ptr);
+            else if (event.type == "free")
+                m_live_allocations.remove(event.ptr);
+        });
+    }
+
+    for (size_t event_index = m_filtered_events_begin; event_index < m_filtered_events_end; ++event_index) {
+        if (add_or_remove_event(event_index, 1))
+            ++m_filtered_event_count;
+    }
+
+    m_tree_events_begin = m_filtered_events_begin;
+    m_tree_events_end = m_filtered_events_end;
+    finish_tree_update();
+}
+
+void Profile::update_tree()
+{
+    auto begin = m_filtered_events_begin;
+    auto end = m_filtered_events_end;
+
+    // Dragging out a selection on the timeline only moves its edges a little at a time, so the
+    // tree follows along by adding and removing the events at the edges. When more events would
+    // change than are left in the range (which includes ranges that don't overlap at all), it's
+    // quicker to start over.
+    size_t changed_event_count = (begin < m_tree_events_begin ? m_tree_events_begin - begin : begin - m_tree_events_begin)
+        + (end < m_tree_events_end ? m_tree_events_end - end : end - m_tree_events_end);
+    if (m_has_free_events || changed_event_count > end - begin) {
+        rebuild_tree();
+        return;
     }
 
-    sort_profile_nodes(roots);
+    auto add_or_remove_events = [&](size_t first, size_t last, int delta) {
+        for (size_t event_index = first; event_index < last; ++event_index) {
+            if (add_or_remove_event(event_index, delta))
+                m_filtered_event_count += delta;
+        }
+    };
+
+    if (begin < m_tree_events_begin)
+        add_or_remove_events(begin, m_tree_events_begin, 1);
+    else
+        add_or_remove_events(m_tree_events_begin, begin, -1);
+
+    if (end > m_tree_events_end)
+        add_or_remove_events(m_tree_events_end, end, 1);
+    else
+        add_or_remove_events(end, m_tree_events_end, -1);
+
+    m_tree_events_begin = begin;
+    m_tree_events_end = end;
+    finish_tree_update();
+}
 
-    m_filtered_event_count = filtered_event_count;
-    m_first_filtered_event_index = first_filtered_event_index.value_or(0);
-    m_roots = move(roots);
+void Profile::finish_tree_update()
+{
+    sort_profile_nodes(m_roots);
     m_model->update();
 }
 
-Result<NonnullOwnPtr<Profile>, String> Profile::load_from_perfcore_file(const StringView& path)
+namespace {
+
+// A perfcore file as stored on disk, before symbolication.
+struct RawPerfcore {
+    struct Event {
+        u64 timestamp { 0 };
+        String type;
+        FlatPtr ptr { 0 };
+        size_t size { 0 };
+        bool is_tracepoint { false };
+        FlatPtr arg1 { 0 };
+        FlatPtr arg2 { 0 };
+        size_t stack_index { 0 };
+    };
+
+    String executable_path;
+    // Profiles from before hardware event sampling were always sampled on the timer.
+    String sample_source { "timer" };
+    JsonArray regions;
+    Vector<Vector<FlatPtr>> stacks;
+    Vector<Event> events;
+};
+
+static const char* tracepoint_event_type_name(size_t type)
 {
-    auto file = Core::File::construct(path);
-    if (!file->open(Core::IODevice::ReadOnly))
-        return String::formatted("Unable to open {}, error: {}", path, file->error_string());
+    switch (type) {
+    case PERF_EVENT_CONTEXT_SWITCH:
+        return "context_switch";
+    case PERF_EVENT_PAGE_FAULT:
+        return "page_fault";
+    case PERF_EVENT_DISK_REQUEST:
+        return "disk_request";
+    case PERF_EVENT_SYSCALL_ENTRY:
+        return "syscall_entry";
+    case PERF_EVENT_SYSCALL_EXIT:
+        return "syscall_exit";
+    default:
+        return nullptr;
+    }
+}
+
+static bool is_tracepoint_event_type(const String& type)
+{
+    for (size_t i = PERF_EVENT_CONTEXT_SWITCH; i <= PERF_EVENT_SYSCALL_EXIT; ++i) {
+        if (type == tracepoint_event_type_name(i))
+            return true;
+    }
+    return false;
+}
+
+}
 
-    auto json = JsonValue::from_string(file->read_all());
+static Result<RawPerfcore, String> parse_json_perfcore(ReadonlyBytes bytes)
+{
+    auto json = JsonValue::from_string(StringView(bytes));
     if (!json.has_value() || !json.value().is_object())
         return String { "Invalid perfcore format (not a JSON object)" };
 
     auto& object = json.value().as_object();
-    auto executable_path = object.get("executable").to_string();
 
     auto pid = object.get("pid");
     if (!pid.is_u32())
         return String { "Invalid perfcore format (no process ID)" };
 
-    auto file_or_error = MappedFile::map("/boot/Kernel");
-    OwnPtr<ELF::Image> kernel_elf;
-    if (!file_or_error.is_error())
-        kernel_elf = make<ELF::Image>(file_or_error.value()->bytes());
-
     auto events_value = object.get("events");
     if (!events_value.is_array())
         return String { "Malformed profile (events is not an array)" };
 
     auto regions_value = object.get("regions");
-    if (!regions_value.is_array() || regions_value.as_array().is_empty())
-        return String { "Malformed profile (regions is not an array, or it is empty)" };
-
-    auto& perf_events = events_value.as_array();
-    if (perf_events.is_empty())
-        return String { "No events captured (targeted process was never on CPU)" };
-
-    auto library_metadata = make<LibraryMetadata>(regions_value.as_array());
+    if (!regions_value.is_array())
+        return String { "Malformed profile (regions is not an array)" };
 
-    Vector<Event> events;
+    RawPerfcore perfcore;
+    perfcore.executable_path = object.get("executable").to_string();
+    if (object.has("sample_source"))
+        perfcore.sample_source = object.get("sample_source").to_string();
+    perfcore.regions = regions_value.as_array();
 
-    for (auto& perf_event_value : perf_events.values()) {
+    for (auto& perf_event_value : events_value.as_array().values()) {
         auto& perf_event = perf_event_value.as_object();
 
-        Event event;
-
+        RawPerfcore::Event event;
         event.timestamp = perf_event.get("timestamp").to_number<u64>();
         event.type = perf_event.get("type").to_string();
 
@@ -259,44 +378,311 @@ Result<NonnullOwnPtr<Profile>, String> Profile::load_from_perfcore_file(const St
             event.size = perf_event.get("size").to_number<size_t>();
         } else if (event.type == "free") {
             event.ptr = perf_event.get("ptr").to_number<FlatPtr>();
+        } else if (is_tracepoint_event_type(event.type)) {
+            event.is_tracepoint = true;
+            event.arg1 = perf_event.get("arg1").to_number<FlatPtr>();
+            event.arg2 = perf_event.get("arg2").to_number<FlatPtr>();
         }
 
-        auto stack_array = perf_event.get("stack").as_array();
-        for (ssize_t i = stack_array.values().size() - 1; i >= 0; --i) {
-            auto& frame = stack_array.at(i);
-            auto ptr = frame.to_number<u32>();
-            u32 offset = 0;
-            FlyString object_name;
-            String symbol;
+        Vector<FlatPtr> stack;
+        for (auto& frame : perf_event.get("stack").as_array().values())
+            stack.append(frame.to_number<u32>());
+        event.stack_index = perfcore.stacks.size();
+        perfcore.stacks.append(move(stack));
 
+        perfcore.events.append(move(event));
+    }
+    return perfcore;
+}
+
+static Result<RawPerfcore, String> parse_binary_perfcore(ReadonlyBytes bytes)
+{
+    InputMemoryStream stream { bytes };
+    auto malformed = [&](const char* what) -> Result<RawPerfcore, String> {
+        stream.handle_any_error();
+        return String::formatted("Malformed profile ({})", what);
+    };
+
+    u32 magic = 0;
+    u32 version = 0;
+    stream >> magic >> version;
+    if (stream.handle_any_error() || magic != Kernel::perfcore_magic)
+        return malformed("bad header");
+    if (version == 0 || version > Kernel::perfcore_version)
+        return String::formatted("Unsupported perfcore version {}", version);
+
+    RawPerfcore perfcore;
+    Vector<String> strings;
+    bool has_process = false;
+    u64 timestamp = 0;
+
+    auto read_string_id = [&](String& string) {
+        size_t id;
+        if (!stream.read_LEB128_unsigned(id) || id >= strings.size())
+            return false;
+        string = strings[id];
+        return true;
+    };
+
+    while (!stream.eof()) {
+        u8 record;
+        stream >> record;
+        switch ((Kernel::PerfcoreRecord)record) {
+        case Kernel::PerfcoreRecord::String: {
+            size_t length;
+            if (!stream.read_LEB128_unsigned(length) || length > stream.remaining())
+                return malformed("truncated string");
+            strings.append(String { bytes.slice(stream.offset(), length) });
+            stream.discard_or_error(length);
+            break;
+        }
+        case Kernel::PerfcoreRecord::Process: {
+            size_t pid;
+            if (!stream.read_LEB128_unsigned(pid) || !read_string_id(perfcore.executable_path))
+                return malformed("bad process record");
+            has_process = true;
+            break;
+        }
+        case Kernel::PerfcoreRecord::SampleSource: {
+            if (!read_string_id(perfcore.sample_source))
+                return malformed("bad sample source record");
+            break;
+        }
+        case Kernel::PerfcoreRecord::Region: {
+            size_t base;
+            size_t size;
+            String name;
+            if (!stream.read_LEB128_unsigned(base) || !stream.read_LEB128_unsigned(size) || !read_string_id(name))
+                return malformed("bad region record");
+            JsonObject region;
+            region.set("base", (u32)base);
+            region.set("size", (u32)size);
+            region.set("name", move(name));
+            perfcore.regions.append(move(region));
+            break;
+        }
+        case Kernel::PerfcoreRecord::Stack: {
+            size_t frame_count;
+            if (!stream.read_LEB128_unsigned(frame_count) || frame_count > stream.remaining())
+                return malformed("bad stack record");
+            Vector<FlatPtr> stack;
+            stack.ensure_capacity(frame_count);
+            FlatPtr frame = 0;
+            for (size_t i = 0; i < frame_count; ++i) {
+                size_t zigzag;
+                if (!stream.read_LEB128_unsigned(zigzag))
+                    return malformed("truncated stack");
+                frame += (FlatPtr)((zigzag >> 1) ^ -(zigzag & 1));
+                stack.unchecked_append(frame);
+            }
+            perfcore.stacks.append(move(stack));
+            break;
+        }
+        case Kernel::PerfcoreRecord::Event: {
+            size_t type;
+            size_t tid;
+            size_t timestamp_delta;
+            RawPerfcore::Event event;
+            if (!stream.read_LEB128_unsigned(type) || !stream.read_LEB128_unsigned(tid)
+                || !stream.read_LEB128_unsigned(timestamp_delta) || !stream.read_LEB128_unsigned(event.stack_index)
+                || event.stack_index >= perfcore.stacks.size())
+                return malformed("bad event record");
+            timestamp += timestamp_delta;
+            event.timestamp = timestamp;
+            switch (type) {
+            case PERF_EVENT_SAMPLE:
+                event.type = "sample";
+                break;
+            case PERF_EVENT_MALLOC:
+                event.type = "malloc";
+                if (!stream.read_LEB128_unsigned(event.ptr) || !stream.read_LEB128_unsigned(event.size))
+                    return malformed("bad malloc event");
+                break;
+            case PERF_EVENT_FREE:
+                event.type = "free";
+                if (!stream.read_LEB128_unsigned(event.ptr))
+                    return malformed("bad free event");
+                break;
+            default:
+                if (!tracepoint_event_type_name(type))
+                    return malformed("unknown event type");
+                event.type = tracepoint_event_type_name(type);
+                event.is_tracepoint = true;
+                if (!stream.read_LEB128_unsigned(event.arg1) || !stream.read_LEB128_unsigned(event.arg2))
+                    return malformed("bad tracepoint event");
+                break;
+            }
+            perfcore.events.append(move(event));
+            break;
+        }
+        default:
+            return malformed("unknown record");
+        }
+    }
+
+    if (!has_process)
+        return String { "Invalid perfcore format (no process ID)" };
+    return perfcore;
+}
+
+Result<NonnullOwnPtr<Profile>, String> Profile::load_from_perfcore_file(const StringView& path, Function<void(size_t done, size_t total)> on_progress)
+{
+    auto file = Core::File::construct(path);
+    if (!file->open(Core::IODevice::ReadOnly))
+        return String::formatted("Unable to open {}, error: {}", path, file->error_string());
+
+    auto contents = file->read_all();
+    u32 magic = 0;
+    if (contents.size() >= sizeof(magic))
+        memcpy(&magic, contents.data(), sizeof(magic));
+    auto perfcore_or_error = magic == Kernel::perfcore_magic ? parse_binary_perfcore(contents) : parse_json_perfcore(contents);
+    if (perfcore_or_error.is_error())
+        return perfcore_or_error.error();
+    auto perfcore = perfcore_or_error.release_value();
+
+    if (perfcore.regions.is_empty())
+        return String { "Malformed profile (regions is empty)" };
+    if (perfcore.events.is_empty())
+        return String { "No events captured (targeted process was never on CPU)" };
+
+    auto file_or_error = MappedFile::map("/boot/Kernel");
+    OwnPtr<ELF::Image> kernel_elf;
+    if (!file_or_error.is_error())
+        kernel_elf = make<ELF::Image>(file_or_error.value()->bytes());
+
+    auto library_metadata = make<LibraryMetadata>(move(perfcore.regions));
+
+    // Symbolicating is what takes the time, so every distinct address only gets looked up once,
+    // and the lookups are spread over the thread pool. ELF::Image fills in its symbol caches as it
+    // goes without any locking, so each image is only ever used by one task.
+    struct ImageToSymbolicate {
+        const ELF::Image* elf { nullptr };
+        FlatPtr base { 0 };
+        const String* object_name { nullptr };
+        Vector<FlatPtr> addresses;
+        Vector<String> symbols;
+        Vector<u32> offsets;
+    };
+    Vector<ImageToSymbolicate> images;
+    HashMap<const ELF::Image*, size_t> image_indices;
+    HashMap<FlatPtr, Frame> symbolicated_frames;
+    size_t address_count = 0;
+
+    for (auto& stack : perfcore.stacks) {
+        for (auto ptr : stack) {
+            if (symbolicated_frames.contains(ptr))
+                continue;
+
+            const ELF::Image* elf = nullptr;
+            FlatPtr base = 0;
+            const String* object_name = nullptr;
             if (ptr >= 0xc0000000) {
-                if (kernel_elf) {
-                    symbol = kernel_elf->symbolicate(ptr, &offset);
-                } else {
-                    symbol = "??";
-                }
-            } else {
-                if (auto* library = library_metadata->library_containing(ptr)) {
-                    object_name = library->name;
-                    symbol = library->elf.symbolicate(ptr - library->base, &offset);
-                } else {
-                    symbol = "??";
+                elf = kernel_elf.ptr();
+            } else if (auto* library = library_metadata->library_containing(ptr)) {
+                elf = &library->elf;
+                base = library->base;
+                object_name = &library->name;
+            }
+
+            // The symbols get filled in once the tasks below are done.
+            symbolicated_frames.set(ptr, { {}, "??", ptr, 0 });
+            if (!elf)
+                continue;
+
+            auto image_index = image_indices.get(elf);
+            if (!image_index.has_value()) {
+                image_index = images.size();
+                image_indices.set(elf, image_index.value());
+                images.append({ elf, base, object_name, {}, {}, {} });
+            }
+            images[image_index.value()].addresses.append(ptr);
+            ++address_count;
+        }
+    }
+
+    Atomic<size_t> symbolicated_address_count { 0 };
+    {
+        LibThread::TaskGroup tasks;
+        for (auto& image : images) {
+            tasks.spawn([&image, &symbolicated_address_count] {
+                static constexpr size_t progress_interval = 1024;
+                image.symbols.ensure_capacity(image.addresses.size());
+                image.offsets.ensure_capacity(image.addresses.size());
+                for (size_t i = 0; i < image.addresses.size(); ++i) {
+                    u32 offset = 0;
+                    image.symbols.unchecked_append(image.elf->symbolicate(image.addresses[i] - image.base, &offset));
+                    image.offsets.unchecked_append(offset);
+                    if ((i + 1) % progress_interval == 0) {
+                        symbolicated_address_count.fetch_add(progress_interval);
+                        LibThread::ThreadPool::the().notify_waiters();
+                    }
                 }
+                symbolicated_address_count.fetch_add(image.addresses.size() % progress_interval);
+                LibThread::ThreadPool::the().notify_waiters();
+            });
+        }
+
+        if (on_progress) {
+            size_t reported_count = 0;
+            while (reported_count < address_count) {
+                LibThread::ThreadPool::the().wait_until([&] { return symbolicated_address_count.load() != reported_count; });
+                reported_count = symbolicated_address_count.load();
+                on_progress(reported_count, address_count);
             }
+        }
+    }
 
-            event.frames.append({ object_name, symbol, ptr, offset });
+    // FlyStrings aren't safe to make from several threads at once, so the frames are put together here.
+    for (auto& image : images) {
+        FlyString object_name;
+        if (image.object_name)
+            object_name = *image.object_name;
+        for (size_t i = 0; i < image.addresses.size(); ++i) {
+            auto& frame = symbolicated_frames.find(image.addresses[i])->value;
+            frame.object_name = object_name;
+            frame.symbol = move(image.symbols[i]);
+            frame.offset = image.offsets[i];
+        }
+    }
+
+    // Events usually share their stacks, so every distinct stack only gets put together once.
+    Vector<Optional<Vector<Frame>>> symbolicated_stacks;
+    symbolicated_stacks.resize(perfcore.stacks.size());
+
+    Vector<Event> events;
+    events.ensure_capacity(perfcore.events.size());
+
+    for (auto& raw_event : perfcore.events) {
+        auto& frames = symbolicated_stacks[raw_event.stack_index];
+        if (!frames.has_value()) {
+            auto& stack = perfcore.stacks[raw_event.stack_index];
+            Vector<Frame> stack_frames;
+            stack_frames.ensure_capacity(stack.size());
+            for (ssize_t i = stack.size() - 1; i >= 0; --i)
+                stack_frames.unchecked_append(symbolicated_frames.find(stack[i])->value);
+            frames = move(stack_frames);
         }
 
-        if (event.frames.size() < 2)
+        if (frames.value().size() < 2)
             continue;
 
+        Event event;
+        event.timestamp = raw_event.timestamp;
+        event.type = move(raw_event.type);
+        event.ptr = raw_event.ptr;
+        event.size = raw_event.size;
+        event.is_tracepoint = raw_event.is_tracepoint;
+        event.arg1 = raw_event.arg1;
+        event.arg2 = raw_event.arg2;
+        event.frames = frames.value();
+
         FlatPtr innermost_frame_address = event.frames.at(1).address;
         event.in_kernel = innermost_frame_address >= 0xc0000000;
 
         events.append(move(event));
     }
 
-    return adopt_own(*new Profile(executable_path, move(events), move(library_metadata)));
+    return adopt_own(*new Profile(perfcore.executable_path, perfcore.sample_source, move(events), move(library_metadata)));
 }
 
 void ProfileNode::sort_children()
@@ -313,7 +699,8 @@ void Profile::set_timestamp_filter_range(u64 start, u64 end)
     m_timestamp_filter_range_start = min(start, end);
     m_timestamp_filter_range_end = max(start, end);
 
-    rebuild_tree();
+    update_filtered_events();
+    update_tree();
     m_samples_model->update();
 }
 
@@ -322,7 +709,8 @@ void Profile::clear_timestamp_filter_range()
     if (!m_has_timestamp_filter_range)
         return;
     m_has_timestamp_filter_range = false;
-    rebuild_tree();
+    update_filtered_events();
+    update_tree();
     m_samples_model->update();
 }
 
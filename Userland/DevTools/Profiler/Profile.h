@@ -26,8 +26,9 @@
 
 #pragma once
 
-#include <AK/Bitmap.h>
 #include <AK/FlyString.h>
+#include <AK/Function.h>
+#include <AK/HashTable.h>
 #include <AK/JsonArray.h>
 #include <AK/JsonObject.h>
 #include <AK/JsonValue.h>
@@ -50,15 +51,6 @@ public:
         return adopt(*new ProfileNode(move(object_name), move(symbol), address, offset, timestamp));
     }
 
-    // These functions are only relevant for root nodes
-    void will_track_seen_events(size_t profile_event_count)
-    {
-        if (m_seen_events.size() != profile_event_count)
-            m_seen_events = Bitmap::create(profile_event_count, false);
-    }
-    bool has_seen_event(size_t event_index) const { return m_seen_events.get(event_index); }
-    void did_see_event(size_t event_index) { m_seen_events.set(event_index, true); }
-
     const FlyString& object_name() const { return m_object_name; }
     const String& symbol() const { return m_symbol; }
     u32 address() const { return m_address; }
@@ -96,19 +88,20 @@ public:
     ProfileNode* parent() { return m_parent; }
     const ProfileNode* parent() const { return m_parent; }
 
-    void increment_event_count() { ++m_event_count; }
-    void increment_self_count() { ++m_self_count; }
+    // The counts go down again as events leave the filter range, see Profile::add_or_remove_event().
+    void adjust_event_count(int delta) { m_event_count += delta; }
+    void adjust_self_count(int delta) { m_self_count += delta; }
 
     void sort_children();
 
     const HashMap<FlatPtr, size_t>& events_per_address() const { return m_events_per_address; }
-    void add_event_address(FlatPtr address)
+    void adjust_event_address_count(FlatPtr address, int delta)
     {
-        auto it = m_events_per_address.find(address);
-        if (it == m_events_per_address.end())
-            m_events_per_address.set(address, 1);
+        auto count = m_events_per_address.get(address).value_or(0) + delta;
+        if (count == 0)
+            m_events_per_address.remove(address);
         else
-            m_events_per_address.set(address, it->value + 1);
+            m_events_per_address.set(address, count);
     }
 
 private:
@@ -124,12 +117,13 @@ private:
     u64 m_timestamp { 0 };
     Vector<NonnullRefPtr<ProfileNode>> m_children;
     HashMap<FlatPtr, size_t> m_events_per_address;
-    Bitmap m_seen_events;
 };
 
 class Profile {
 public:
-    static Result<NonnullOwnPtr<Profile>, String> load_from_perfcore_file(const StringView& path);
+    // Symbolication is the slow part of loading a profile; on_progress gets called on the calling
+    // thread as it goes, with the number of addresses symbolicated so far and the total.
+    static Result<NonnullOwnPtr<Profile>, String> load_from_perfcore_file(const StringView& path, Function<void(size_t done, size_t total)> on_progress = nullptr);
     ~Profile();
 
     GUI::Model& model();
@@ -152,6 +146,10 @@ public:
         String type;
         FlatPtr ptr { 0 };
         size_t size { 0 };
+        // Recorded by one of the kernel's tracepoints rather than sampled, see Kernel/Tracepoint.h.
+        bool is_tracepoint { false };
+        FlatPtr arg1 { 0 };
+        FlatPtr arg2 { 0 };
         bool in_kernel { false };
         Vector<Frame> frames;
     };
@@ -180,6 +178,10 @@ public:
 
     const String& executable_path() const { return m_executable_path; }
 
+    // What the samples were taken on: "timer", or a hardware event like "cycles" or "cache-misses".
+    const String& sample_source() const { return m_sample_source; }
+    bool is_sampled_on_timer() const { return m_sample_source == "timer"; }
+
     class LibraryMetadata {
     public:
         LibraryMetadata(JsonArray regions);
@@ -206,22 +208,24 @@ public:
     template<typename Callback>
     void for_each_event_in_filter_range(Callback callback)
     {
-        for (auto& event : m_events) {
-            if (has_timestamp_filter_range()) {
-                auto timestamp = event.timestamp;
-                if (timestamp < m_timestamp_filter_range_start || timestamp > m_timestamp_filter_range_end)
-                    continue;
-            }
-            callback(event);
-        }
+        for (size_t event_index = m_filtered_events_begin; event_index < m_filtered_events_end; ++event_index)
+            callback(m_events[event_index]);
     }
 
 private:
-    Profile(String executable_path, Vector<Event>, NonnullOwnPtr<LibraryMetadata>);
+    Profile(String executable_path, String sample_source, Vector<Event>, NonnullOwnPtr<LibraryMetadata>);
+
+    size_t first_event_index_at_or_after(u64 timestamp) const;
+    void update_filtered_events();
 
     void rebuild_tree();
+    void update_tree();
+    void finish_tree_update();
+    bool add_or_remove_event(size_t event_index, int delta);
+    ProfileNode& find_or_create_root(const Frame&, u64 timestamp);
 
     String m_executable_path;
+    String m_sample_source;
 
     RefPtr<ProfileModel> m_model;
     RefPtr<SamplesModel> m_samples_model;
@@ -230,6 +234,16 @@ private:
     GUI::ModelIndex m_disassembly_index;
 
     Vector<NonnullRefPtr<ProfileNode>> m_roots;
+    // The events are sorted by timestamp, so the ones in the filter range are a contiguous run of
+    // them. m_roots always describes the events from m_tree_events_begin up to m_tree_events_end.
+    size_t m_filtered_events_begin { 0 };
+    size_t m_filtered_events_end { 0 };
+    size_t m_tree_events_begin { 0 };
+    size_t m_tree_events_end { 0 };
+    // Allocations only count while they're live, which adding or removing single events can't
+    // keep track of, so profiles with frees always get their tree rebuilt from scratch.
+    bool m_has_free_events { false };
+    HashTable<FlatPtr> m_live_allocations;
     u32 m_filtered_event_count { 0 };
     size_t m_first_filtered_event_index { 0 };
     u64 m_first_timestamp { 0 };
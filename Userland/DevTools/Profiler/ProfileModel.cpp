@@ -96,8 +96,12 @@ int ProfileModel::column_count(const GUI::ModelIndex&) const
 String ProfileModel::column_name(int column) const
 {
     switch (column) {
-    case Column::SampleCount:
-        return m_profile.show_percentages() ? "% Samples" : "# Samples";
+    case Column::SampleCount: {
+        String name = m_profile.show_percentages() ? "% Samples" : "# Samples";
+        if (!m_profile.is_sampled_on_timer())
+            return String::formatted("{} ({})", name, m_profile.sample_source());
+        return name;
+    }
     case Column::SelfCount:
         return m_profile.show_percentages() ? "% Self" : "# Self";
     case Column::ObjectName:
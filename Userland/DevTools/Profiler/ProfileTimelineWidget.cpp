@@ -29,6 +29,8 @@
 #include <LibGUI/Painter.h>
 #include <LibGfx/Font.h>
 
+static constexpr int tracepoint_band_height = 6;
+
 ProfileTimelineWidget::ProfileTimelineWidget(Profile& profile)
     : m_profile(profile)
 {
@@ -41,6 +43,17 @@ ProfileTimelineWidget::~ProfileTimelineWidget()
 {
 }
 
+static Color tracepoint_color(const String& type)
+{
+    if (type == "context_switch")
+        return Color::from_rgb(0x3a9e4f);
+    if (type == "page_fault")
+        return Color::from_rgb(0xd1a02c);
+    if (type == "disk_request")
+        return Color::from_rgb(0x8c4fb8);
+    return Color::from_rgb(0x7a7a7a);
+}
+
 void ProfileTimelineWidget::paint_event(GUI::PaintEvent& event)
 {
     GUI::Frame::paint_event(event);
@@ -63,6 +76,12 @@ void ProfileTimelineWidget::paint_event(GUI::PaintEvent& event)
         int x = (int)((float)t * column_width);
         int cw = max(1, (int)column_width);
 
+        if (event.is_tracepoint) {
+            // Tracepoints mark moments rather than time spent, so draw them as ticks along the top edge.
+            painter.draw_line({ x + 1, frame_thickness() }, { x + 1, frame_thickness() + tracepoint_band_height }, tracepoint_color(event.type));
+            continue;
+        }
+
         int column_height = frame_inner_rect().height() - (int)((float)event.frames.size() * frame_height);
 
         bool in_kernel = event.in_kernel;
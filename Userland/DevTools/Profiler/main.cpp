@@ -44,6 +44,8 @@
 #include <LibGUI/MessageBox.h>
 #include <LibGUI/Model.h>
 #include <LibGUI/ProcessChooser.h>
+#include <LibGUI/ProgressBar.h>
+#include <LibGUI/SortingProxyModel.h>
 #include <LibGUI/Splitter.h>
 #include <LibGUI/TabWidget.h>
 #include <LibGUI/TableView.h>
@@ -53,28 +55,52 @@
 #include <stdio.h>
 #include <string.h>
 
-static bool generate_profile(pid_t& pid);
+static bool generate_profile(pid_t& pid, int sample_source);
+static Result<NonnullOwnPtr<Profile>, String> load_profile(const String& path);
+
+static Optional<int> sample_source_from_name(const StringView& name)
+{
+    if (name == "timer")
+        return PROFILING_SAMPLE_TIMER;
+    if (name == "cycles")
+        return PROFILING_SAMPLE_CYCLES;
+    if (name == "instructions")
+        return PROFILING_SAMPLE_INSTRUCTIONS;
+    if (name == "cache-misses")
+        return PROFILING_SAMPLE_CACHE_MISSES;
+    if (name == "branch-misses")
+        return PROFILING_SAMPLE_BRANCH_MISSES;
+    return {};
+}
 
 int main(int argc, char** argv)
 {
     Core::ArgsParser args_parser;
     int pid = 0;
+    const char* sample_source_name = "timer";
     args_parser.add_option(pid, "PID to profile", "pid", 'p', "PID");
+    args_parser.add_option(sample_source_name, "Sample on timer ticks (default), or every so many cycles, instructions, cache-misses or branch-misses", "sample", 's', "event");
     args_parser.parse(argc, argv, false);
 
+    auto sample_source = sample_source_from_name(sample_source_name);
+    if (!sample_source.has_value()) {
+        warnln("Unknown sample source '{}'", sample_source_name);
+        return 1;
+    }
+
     auto app = GUI::Application::construct(argc, argv);
     auto app_icon = GUI::Icon::default_icon("app-profiler");
 
     String path;
     if (argc != 2) {
-        if (!generate_profile(pid))
+        if (!generate_profile(pid, sample_source.value()))
             return 0;
         path = String::formatted("/proc/{}/perf_events", pid);
     } else {
         path = argv[1];
     }
 
-    auto profile_or_error = Profile::load_from_perfcore_file(path);
+    auto profile_or_error = load_profile(path);
     if (profile_or_error.is_error()) {
         GUI::MessageBox::show(nullptr, profile_or_error.error(), "Profiler", GUI::MessageBox::Type::Error);
         return 0;
@@ -92,7 +118,10 @@ int main(int argc, char** argv)
         return 1;
     }
 
-    window->set_title("Profiler");
+    if (profile->is_sampled_on_timer())
+        window->set_title("Profiler");
+    else
+        window->set_title(String::formatted("Profiler - sampled on {}", profile->sample_source()));
     window->set_icon(app_icon.bitmap_for_size(16));
     window->resize(800, 600);
 
@@ -127,7 +156,11 @@ int main(int argc, char** argv)
 
     auto& samples_splitter = samples_tab.add<GUI::HorizontalSplitter>();
     auto& samples_table_view = samples_splitter.add<GUI::TableView>();
-    samples_table_view.set_model(profile->samples_model());
+    // There's one row per sample, which easily adds up to hundreds of thousands.
+    samples_table_view.set_virtualized(true);
+    auto samples_sorting_model = GUI::SortingProxyModel::create(profile->samples_model());
+    samples_sorting_model->set_sorts_in_background(true);
+    samples_table_view.set_model(move(samples_sorting_model));
 
     auto& individual_sample_view = samples_splitter.add<GUI::TableView>();
     samples_table_view.on_selection = [&](const GUI::ModelIndex& index) {
@@ -186,6 +219,30 @@ int main(int argc, char** argv)
     return app->exec();
 }
 
+static Result<NonnullOwnPtr<Profile>, String> load_profile(const String& path)
+{
+    auto window = GUI::Window::construct();
+    window->set_title("Loading profile");
+    window->resize(240, 46);
+    window->set_icon(Gfx::Bitmap::load_from_file("/res/icons/16x16/app-profiler.png"));
+    window->center_on_screen();
+
+    auto& widget = window->set_main_widget<GUI::Widget>();
+    widget.set_fill_with_background_color(true);
+    auto& layout = widget.set_layout<GUI::VerticalBoxLayout>();
+    layout.set_margins(GUI::Margins(12, 12, 12, 12));
+
+    auto& progress_bar = widget.add<GUI::ProgressBar>();
+    progress_bar.set_text("Symbolicating: ");
+
+    window->show();
+    return Profile::load_from_perfcore_file(path, [&](size_t done, size_t total) {
+        progress_bar.set_range(0, total);
+        progress_bar.set_value(done);
+        Core::EventLoop::current().pump(Core::EventLoop::WaitMode::PollForEvents);
+    });
+}
+
 static bool prompt_to_stop_profiling(pid_t pid, const String& process_name)
 {
     auto window = GUI::Window::construct();
@@ -216,7 +273,7 @@ static bool prompt_to_stop_profiling(pid_t pid, const String& process_name)
     return GUI::Application::the()->exec() == 0;
 }
 
-bool generate_profile(pid_t& pid)
+bool generate_profile(pid_t& pid, int sample_source)
 {
     if (!pid) {
         auto process_chooser = GUI::ProcessChooser::construct("Profiler", "Profile", Gfx::Bitmap::load_from_file("/res/icons/16x16/app-profiler.png"));
@@ -237,7 +294,7 @@ bool generate_profile(pid_t& pid)
         process_name = "(unknown)";
     }
 
-    if (profiling_enable(pid) < 0) {
+    if (profiling_enable(pid, sample_source) < 0) {
         int saved_errno = errno;
         GUI::MessageBox::show(nullptr, String::formatted("Unable to profile process {}({}): {}", process_name, pid, strerror(saved_errno)), "Profiler", GUI::MessageBox::Type::Error);
         return false;
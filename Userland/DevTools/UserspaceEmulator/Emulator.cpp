@@ -251,20 +251,28 @@ int Emulator::exec()
     bool trace = false;
 
     while (!m_shutdown) {
-        m_cpu.save_base_eip();
+        auto block = m_cpu.basic_block_at_eip();
+        for (auto& cached : block->instructions) {
+            m_cpu.save_base_eip();
+            u32 next_eip = m_cpu.base_eip() + cached.length;
+            m_cpu.set_eip(next_eip);
 
-        auto insn = X86::Instruction::from_stream(m_cpu, true, true);
+            auto& insn = cached.instruction;
+            if (trace)
+                outln("{:p}  \033[33;1m{}\033[0m", m_cpu.base_eip(), insn.to_string(m_cpu.base_eip(), symbol_provider));
 
-        if (trace)
-            outln("{:p}  \033[33;1m{}\033[0m", m_cpu.base_eip(), insn.to_string(m_cpu.base_eip(), symbol_provider));
+            (m_cpu.*cached.handler)(insn);
 
-        (m_cpu.*insn.handler())(insn);
+            if (trace)
+                m_cpu.dump();
 
-        if (trace)
-            m_cpu.dump();
+            if (m_pending_signals)
+                dispatch_one_pending_signal();
 
-        if (m_pending_signals)
-            dispatch_one_pending_signal();
+            // Stop following the block if we jumped (or got sent) somewhere else, or the code changed.
+            if (m_shutdown || m_cpu.eip() != next_eip || !block->is_valid)
+                break;
+        }
     }
 
     if (auto* tracer = malloc_tracer())
@@ -398,7 +406,7 @@ u32 Emulator::virt_syscall(u32 function, u32 arg1, u32 arg2, u32 arg3)
     case SC_get_dir_entries:
         return virt$get_dir_entries(arg1, arg2, arg3);
     case SC_profiling_enable:
-        return virt$profiling_enable(arg1);
+        return virt$profiling_enable(arg1, arg2);
     case SC_profiling_disable:
         return virt$profiling_disable(arg1);
     case SC_disown:
@@ -568,9 +576,9 @@ int Emulator::virt$recvfd(int socket, int options)
     return syscall(SC_recvfd, socket, options);
 }
 
-int Emulator::virt$profiling_enable(pid_t pid)
+int Emulator::virt$profiling_enable(pid_t pid, int sample_source)
 {
-    return syscall(SC_profiling_enable, pid);
+    return syscall(SC_profiling_enable, pid, sample_source);
 }
 
 int Emulator::virt$profiling_disable(pid_t pid)
@@ -1092,6 +1100,8 @@ u32 Emulator::virt$mprotect(FlatPtr base, size_t size, int prot)
         VERIFY(region->size() == size);
         auto& mmap_region = *(MmapRegion*)region;
         mmap_region.set_prot(prot);
+        // The code cache doesn't check whether regions are still executable.
+        mmu().invalidate_cached_code();
         return 0;
     }
     return -EINVAL;
@@ -1298,11 +1308,7 @@ int Emulator::virt$stat(FlatPtr params_addr)
 
     auto path = String::copy(mmu().copy_buffer_from_vm((FlatPtr)params.path.characters, params.path.length));
     struct stat host_statbuf;
-    int rc;
-    if (params.follow_symlinks)
-        rc = stat(path.characters(), &host_statbuf);
-    else
-        rc = lstat(path.characters(), &host_statbuf);
+    int rc = fstatat(params.dirfd, path.characters(), &host_statbuf, params.follow_symlinks ? 0 : AT_SYMLINK_NOFOLLOW);
     if (rc < 0)
         return -errno;
     mmu().copy_to_vm((FlatPtr)params.statbuf, &host_statbuf, sizeof(host_statbuf));
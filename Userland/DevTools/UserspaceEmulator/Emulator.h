@@ -59,6 +59,7 @@ public:
     u32 virt_syscall(u32 function, u32 arg1, u32 arg2, u32 arg3);
 
     SoftMMU& mmu() { return m_mmu; }
+    SoftCPU& cpu() { return m_cpu; }
 
     MallocTracer* malloc_tracer() { return m_malloc_tracer; }
 
@@ -92,7 +93,7 @@ private:
     int virt$stat(FlatPtr);
     int virt$realpath(FlatPtr);
     int virt$gethostname(FlatPtr, ssize_t);
-    int virt$profiling_enable(pid_t);
+    int virt$profiling_enable(pid_t, int sample_source);
     int virt$profiling_disable(pid_t);
     int virt$disown(pid_t);
     int virt$purge(int mode);
@@ -139,11 +139,94 @@ void SoftCPU::update_code_cache()
         TODO();
     }
 
-    // FIXME: This cache needs to be invalidated if the code region is ever unmapped.
     m_cached_code_region = region;
     m_cached_code_base_ptr = region->data();
 }
 
+static bool ends_basic_block(const X86::Instruction& insn)
+{
+    if (insn.has_sub_op()) {
+        // Jcc imm16/32, and UD2.
+        return (insn.sub_op() >= 0x80 && insn.sub_op() <= 0x8f) || insn.sub_op() == 0x0b;
+    }
+    switch (insn.op()) {
+    case 0x70 ... 0x7f: // Jcc imm8
+    case 0x9a:          // CALL imm16:16/32
+    case 0xc2:          // RET imm16
+    case 0xc3:          // RET
+    case 0xca:          // RETF imm16
+    case 0xcb:          // RETF
+    case 0xcc:          // INT3
+    case 0xcd:          // INT imm8
+    case 0xce:          // INTO
+    case 0xcf:          // IRET
+    case 0xe0 ... 0xe3: // LOOPNZ, LOOPZ, LOOP, JCXZ
+    case 0xe8:          // CALL imm16/32
+    case 0xe9:          // JMP imm16/32
+    case 0xea:          // JMP imm16:16/32
+    case 0xeb:          // JMP imm8
+    case 0xf4:          // HLT
+        return true;
+    case 0xff:
+        // CALL, CALLF, JMP and JMPF through RM16/32.
+        return insn.slash() >= 2 && insn.slash() <= 5;
+    default:
+        return false;
+    }
+}
+
+NonnullRefPtr<SoftCPU::BasicBlock> SoftCPU::basic_block_at_eip()
+{
+    if (auto it = m_basic_block_cache.find(m_eip); it != m_basic_block_cache.end())
+        return it->value;
+
+    // Don't let a block grow too long, so that we don't decode a lot of code that's jumped over.
+    static constexpr size_t max_instructions_per_block = 64;
+    // The longest x86 instruction is 15 bytes.
+    static constexpr u32 max_instruction_length = 15;
+
+    u32 block_eip = m_eip;
+    auto block = adopt(*new BasicBlock);
+    for (;;) {
+        u32 instruction_eip = m_eip;
+        auto insn = X86::Instruction::from_stream(*this, true, true);
+        if (!insn.is_valid()) {
+            if (block->instructions.is_empty()) {
+                reportln("SoftCPU: Invalid instruction @ {:p}", instruction_eip);
+                m_emulator.dump_backtrace();
+                TODO();
+            }
+            // Leave it to whoever ends up executing it to complain.
+            m_eip = instruction_eip;
+            break;
+        }
+        block->instructions.append({ insn, insn.handler(), m_eip - instruction_eip });
+        if (ends_basic_block(insn) || block->instructions.size() == max_instructions_per_block)
+            break;
+        // Don't decode past the end of the code region, there may be nothing (executable) after it.
+        if (!m_cached_code_region->contains(m_eip + max_instruction_length - 1))
+            break;
+    }
+
+    // Writes to the code we've just decoded invalidate the cache.
+    for (u32 page = block_eip / PAGE_SIZE; page <= (m_eip - 1) / PAGE_SIZE; ++page)
+        m_emulator.mmu().set_page_has_cached_code(page);
+
+    m_eip = block_eip;
+    m_basic_block_cache.set(block_eip, block);
+    return block;
+}
+
+void SoftCPU::invalidate_code_cache()
+{
+    // Blocks that are being executed right now stay alive, but the emulator stops running them.
+    for (auto& it : m_basic_block_cache)
+        it.value->is_valid = false;
+    m_basic_block_cache.clear();
+    m_cached_code_region = nullptr;
+    m_cached_code_base_ptr = nullptr;
+}
+
 ValueWithShadow<u8> SoftCPU::read_memory8(X86::LogicalAddress address)
 {
     VERIFY(address.selector() == 0x1b || address.selector() == 0x23 || address.selector() == 0x2b);
@@ -28,6 +28,10 @@
 
 #include "Region.h"
 #include "ValueWithShadow.h"
+#include <AK/HashMap.h>
+#include <AK/NonnullRefPtr.h>
+#include <AK/RefCounted.h>
+#include <AK/Vector.h>
 #include <LibX86/Instruction.h>
 #include <LibX86/Interpreter.h>
 
@@ -63,6 +67,24 @@ public:
     explicit SoftCPU(Emulator&);
     void dump() const;
 
+    struct CachedInstruction {
+        X86::Instruction instruction;
+        X86::InstructionHandler handler;
+        u32 length;
+    };
+
+    // A run of instructions that are executed one after the other, up to and including
+    // the first one that might jump somewhere else.
+    struct BasicBlock : public RefCounted<BasicBlock> {
+        Vector<CachedInstruction, 16> instructions;
+        // Cleared when the code it was decoded from may have changed.
+        bool is_valid { true };
+    };
+
+    // Returns the decoded basic block starting at EIP, decoding and caching it if needed.
+    NonnullRefPtr<BasicBlock> basic_block_at_eip();
+    void invalidate_code_cache();
+
     u32 base_eip() const { return m_base_eip; }
     void save_base_eip() { m_base_eip = m_eip; }
 
@@ -1155,6 +1177,8 @@ private:
     Region* m_cached_code_region { nullptr };
     u8* m_cached_code_base_ptr { nullptr };
 
+    HashMap<u32, NonnullRefPtr<BasicBlock>> m_basic_block_cache;
+
     u32 m_secret_handshake_state { 0 };
     u32 m_secret_data[3];
 };
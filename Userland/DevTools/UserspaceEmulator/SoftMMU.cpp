@@ -49,6 +49,7 @@ void SoftMMU::add_region(NonnullOwnPtr<Region> region)
     }
 
     m_regions.append(move(region));
+    invalidate_cached_code();
 }
 
 void SoftMMU::remove_region(Region& region)
@@ -59,6 +60,15 @@ void SoftMMU::remove_region(Region& region)
     }
 
     m_regions.remove_first_matching([&](auto& entry) { return entry.ptr() == &region; });
+    invalidate_cached_code();
+}
+
+void SoftMMU::invalidate_cached_code()
+{
+    for (auto page_index : m_pages_with_cached_code)
+        m_page_has_cached_code[page_index] = false;
+    m_pages_with_cached_code.clear();
+    m_emulator.cpu().invalidate_code_cache();
 }
 
 void SoftMMU::set_tls_region(NonnullOwnPtr<Region> region)
@@ -154,6 +164,7 @@ void SoftMMU::write8(X86::LogicalAddress address, ValueWithShadow<u8> value)
         TODO();
     }
     region->write8(address.offset() - region->base(), value);
+    did_write(address, 1);
 }
 
 void SoftMMU::write16(X86::LogicalAddress address, ValueWithShadow<u16> value)
@@ -172,6 +183,7 @@ void SoftMMU::write16(X86::LogicalAddress address, ValueWithShadow<u16> value)
     }
 
     region->write16(address.offset() - region->base(), value);
+    did_write(address, 2);
 }
 
 void SoftMMU::write32(X86::LogicalAddress address, ValueWithShadow<u32> value)
@@ -190,6 +202,7 @@ void SoftMMU::write32(X86::LogicalAddress address, ValueWithShadow<u32> value)
     }
 
     region->write32(address.offset() - region->base(), value);
+    did_write(address, 4);
 }
 
 void SoftMMU::write64(X86::LogicalAddress address, ValueWithShadow<u64> value)
@@ -208,6 +221,7 @@ void SoftMMU::write64(X86::LogicalAddress address, ValueWithShadow<u64> value)
     }
 
     region->write64(address.offset() - region->base(), value);
+    did_write(address, 8);
 }
 
 void SoftMMU::copy_to_vm(FlatPtr destination, const void* source, size_t size)
@@ -253,6 +267,7 @@ bool SoftMMU::fast_fill_memory8(X86::LogicalAddress address, size_t size, ValueW
     size_t offset_in_region = address.offset() - region->base();
     memset(region->data() + offset_in_region, value.value(), size);
     memset(region->shadow_data() + offset_in_region, value.shadow(), size);
+    did_write(address, size);
     return true;
 }
 
@@ -278,6 +293,7 @@ bool SoftMMU::fast_fill_memory32(X86::LogicalAddress address, size_t count, Valu
     size_t offset_in_region = address.offset() - region->base();
     fast_u32_fill((u32*)(region->data() + offset_in_region), value.value(), count);
     fast_u32_fill((u32*)(region->shadow_data() + offset_in_region), value.shadow(), count);
+    did_write(address, count * sizeof(u32));
     return true;
 }
 
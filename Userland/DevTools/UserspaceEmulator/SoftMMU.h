@@ -32,6 +32,7 @@
 #include <AK/NonnullOwnPtrVector.h>
 #include <AK/OwnPtr.h>
 #include <AK/Types.h>
+#include <AK/Vector.h>
 #include <LibX86/Instruction.h>
 
 namespace UserspaceEmulator {
@@ -64,6 +65,16 @@ public:
     void add_region(NonnullOwnPtr<Region>);
     void remove_region(Region&);
 
+    // SoftCPU caches decoded instructions, so writes to the pages they came from have to drop the cache.
+    void set_page_has_cached_code(size_t page_index)
+    {
+        if (m_page_has_cached_code[page_index])
+            return;
+        m_page_has_cached_code[page_index] = true;
+        m_pages_with_cached_code.append(page_index);
+    }
+    void invalidate_cached_code();
+
     void set_tls_region(NonnullOwnPtr<Region>);
 
     bool fast_fill_memory8(X86::LogicalAddress, size_t size, ValueWithShadow<u8>);
@@ -87,9 +98,19 @@ public:
     }
 
 private:
+    ALWAYS_INLINE void did_write(X86::LogicalAddress address, size_t size)
+    {
+        if (address.selector() == 0x2b)
+            return;
+        if (m_page_has_cached_code[address.offset() / PAGE_SIZE] || m_page_has_cached_code[(address.offset() + size - 1) / PAGE_SIZE])
+            invalidate_cached_code();
+    }
+
     Emulator& m_emulator;
 
     Region* m_page_to_region_map[786432];
+    bool m_page_has_cached_code[786432] {};
+    Vector<size_t> m_pages_with_cached_code;
 
     OwnPtr<Region> m_tls_region;
     NonnullOwnPtrVector<Region> m_regions;
@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <AK/Array.h>
 #include <AK/ByteBuffer.h>
 #include <AK/MemoryStream.h>
 #include <AK/Types.h>
@@ -89,9 +90,10 @@ struct Sample {
     double right;
 };
 
-// Small helper to resample from one playback rate to another
-// This isn't really "smart", in that we just insert (or drop) samples.
-// Should do better...
+// Resamples from one playback rate to another with a windowed sinc filter. The filter is
+// precomputed for a number of fractional positions between two input samples (its "phases"),
+// and each output sample uses the phase nearest to where it falls between the input samples.
+// Output lags behind the input by half the filter's width.
 class ResampleHelper {
 public:
     ResampleHelper(double source, double target);
@@ -100,10 +102,18 @@ public:
     bool read_sample(double& next_l, double& next_r);
 
 private:
+    static constexpr size_t tap_count = 32;
+    static constexpr size_t phase_count = 128;
+
+    // How many input samples to advance per output sample.
     const double m_ratio;
-    double m_current_ratio { 0 };
-    double m_last_sample_l { 0 };
-    double m_last_sample_r { 0 };
+    // Where the next output sample falls, counted in input samples.
+    double m_next_output_position { 0 };
+    size_t m_input_count { 0 };
+    bool m_has_unread_input { false };
+    Array<double, tap_count> m_history_l {};
+    Array<double, tap_count> m_history_r {};
+    Vector<double> m_filter;
 };
 
 // A buffer of audio samples, normalized to 44100hz.
@@ -100,6 +100,11 @@ int ClientConnection::get_playing_buffer()
     return send_sync<Messages::AudioServer::GetPlayingBuffer>()->buffer_id();
 }
 
+int ClientConnection::get_latency_us()
+{
+    return send_sync<Messages::AudioServer::GetLatency>()->latency_us();
+}
+
 void ClientConnection::handle(const Messages::AudioClient::FinishedPlayingBuffer& message)
 {
     if (on_finish_playing_buffer)
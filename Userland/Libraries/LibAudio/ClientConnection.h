@@ -53,6 +53,8 @@ public:
     int get_remaining_samples();
     int get_played_samples();
     int get_playing_buffer();
+    // How long it takes on average from enqueuing a buffer until it's heard, in microseconds.
+    int get_latency_us();
 
     void set_paused(bool paused);
     void clear_buffer(bool paused = false);
@@ -31,6 +31,7 @@
 #include <LibAudio/WavLoader.h>
 #include <LibCore/File.h>
 #include <LibCore/IODeviceStreamReader.h>
+#include <math.h>
 
 namespace Audio {
 
@@ -255,25 +256,68 @@ bool WavLoaderPlugin::parse_header()
 ResampleHelper::ResampleHelper(double source, double target)
     : m_ratio(source / target)
 {
+    if (m_ratio == 1)
+        return;
+
+    // When going down to a lower rate, everything above the new Nyquist frequency has to be filtered out.
+    double cutoff = min(1.0, 1 / m_ratio);
+    m_filter.resize(phase_count * tap_count);
+    for (size_t phase = 0; phase < phase_count; ++phase) {
+        double* taps = &m_filter[phase * tap_count];
+        double sum = 0;
+        for (size_t tap = 0; tap < tap_count; ++tap) {
+            // How far the input sample for this tap is from the output sample.
+            double x = (double)tap - (tap_count / 2 - 1) - (double)phase / phase_count;
+            double sinc = x == 0 ? 1 : sin(M_PI * cutoff * x) / (M_PI * cutoff * x);
+            double window = 0.42 + 0.5 * cos(2 * M_PI * x / tap_count) + 0.08 * cos(4 * M_PI * x / tap_count);
+            taps[tap] = sinc * window;
+            sum += taps[tap];
+        }
+        for (size_t tap = 0; tap < tap_count; ++tap)
+            taps[tap] /= sum;
+    }
 }
 
 void ResampleHelper::process_sample(double sample_l, double sample_r)
 {
-    m_last_sample_l = sample_l;
-    m_last_sample_r = sample_r;
-    m_current_ratio += 1;
+    m_history_l[m_input_count % tap_count] = sample_l;
+    m_history_r[m_input_count % tap_count] = sample_r;
+    ++m_input_count;
+    m_has_unread_input = true;
 }
 
 bool ResampleHelper::read_sample(double& next_l, double& next_r)
 {
-    if (m_current_ratio > 0) {
-        m_current_ratio -= m_ratio;
-        next_l = m_last_sample_l;
-        next_r = m_last_sample_r;
+    if (m_ratio == 1) {
+        if (!m_has_unread_input)
+            return false;
+        m_has_unread_input = false;
+        next_l = m_history_l[(m_input_count - 1) % tap_count];
+        next_r = m_history_r[(m_input_count - 1) % tap_count];
         return true;
     }
 
-    return false;
+    // The filter reaches half its width past the output sample, so wait for those input samples.
+    size_t base = (size_t)m_next_output_position;
+    if (base + tap_count / 2 >= m_input_count)
+        return false;
+
+    size_t phase = (size_t)((m_next_output_position - base) * phase_count);
+    const double* taps = &m_filter[phase * tap_count];
+    double sum_l = 0;
+    double sum_r = 0;
+    for (size_t tap = 0; tap < tap_count; ++tap) {
+        // Samples before the first one count as silence.
+        if (base + tap < tap_count / 2 - 1)
+            continue;
+        size_t index = (base + tap - (tap_count / 2 - 1)) % tap_count;
+        sum_l += taps[tap] * m_history_l[index];
+        sum_r += taps[tap] * m_history_r[index];
+    }
+    next_l = sum_l;
+    next_r = sum_r;
+    m_next_output_position += m_ratio;
+    return true;
 }
 
 }
@@ -38,6 +38,8 @@ void __pthread_fork_atfork_register_parent(void (*)(void));
 void __pthread_fork_atfork_register_child(void (*)(void));
 
 int __pthread_mutex_lock(void*);
+int __pthread_mutex_lock_pessimistic_np(void*);
+int __pthread_mutex_trylock(void*);
 int __pthread_mutex_unlock(void*);
 int __pthread_mutex_init(void*, const void*);
 
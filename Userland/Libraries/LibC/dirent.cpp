@@ -87,6 +87,9 @@ static void create_struct_dirent(sys_dirent* sys_ent, struct dirent* str_ent)
     str_ent->d_name[sys_ent->namelen] = '\0';
 }
 
+// This matches the largest buffer the kernel is willing to fill.
+static constexpr size_t max_dir_entries_buffer_size = 16 * MiB;
+
 static int allocate_dirp_buffer(DIR* dirp)
 {
     if (dirp->buffer) {
@@ -102,14 +105,21 @@ static int allocate_dirp_buffer(DIR* dirp)
         errno = old_errno;
         return new_errno;
     }
+    // The kernel fails with EINVAL if the entries don't fit, which they usually do in a buffer the size
+    // of the directory. Some file systems don't report a size for directories, though.
     size_t size_to_allocate = max(st.st_size, static_cast<off_t>(4096));
-    dirp->buffer = (char*)malloc(size_to_allocate);
-    ssize_t nread = syscall(SC_get_dir_entries, dirp->fd, dirp->buffer, size_to_allocate);
-    if (nread < 0) {
+    ssize_t nread;
+    for (;;) {
+        dirp->buffer = (char*)malloc(size_to_allocate);
+        nread = syscall(SC_get_dir_entries, dirp->fd, dirp->buffer, size_to_allocate);
+        if (nread >= 0)
+            break;
         // uh-oh, the syscall returned an error
         free(dirp->buffer);
         dirp->buffer = nullptr;
-        return -nread;
+        if (nread != -EINVAL || size_to_allocate >= max_dir_entries_buffer_size)
+            return -nread;
+        size_to_allocate = min(size_to_allocate * 2, max_dir_entries_buffer_size);
     }
     dirp->buffer_size = nread;
     dirp->nextptr = dirp->buffer;
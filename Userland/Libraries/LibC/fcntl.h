@@ -37,6 +37,8 @@ __BEGIN_DECLS
 #define F_GETFL 3
 #define F_SETFL 4
 #define F_ISTTY 5
+#define F_SETPIPE_SZ 6
+#define F_GETPIPE_SZ 7
 
 #define FD_CLOEXEC 1
 
@@ -86,6 +88,7 @@ __BEGIN_DECLS
 int creat(const char* path, mode_t);
 int open(const char* path, int options, ...);
 #define AT_FDCWD -100
+#define AT_SYMLINK_NOFOLLOW 0x100
 int openat(int dirfd, const char* path, int options, ...);
 
 int fcntl(int fd, int cmd, ...);
@@ -101,8 +101,9 @@ static bool parse_grpdb_entry(const String& line)
         return false;
     }
 
-    s_name = parts[0];
-    s_passwd = parts[1];
+    // The entry hands out writable pointers to these, so they must not share a StringImpl with anyone else.
+    s_name = String(parts[0]).isolated_copy();
+    s_passwd = String(parts[1]).isolated_copy();
 
     auto& gid_string = parts[2];
     String members_string = parts[3];
@@ -117,6 +118,7 @@ static bool parse_grpdb_entry(const String& line)
     s_members_ptrs.clear_with_capacity();
     s_members_ptrs.ensure_capacity(s_members.size() + 1);
     for (auto& member : s_members) {
+        member = member.isolated_copy();
         s_members_ptrs.append(member.characters());
     }
     s_members_ptrs.append(nullptr);
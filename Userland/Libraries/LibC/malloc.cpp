@@ -40,8 +40,6 @@
 #include <sys/internals.h>
 #include <sys/mman.h>
 
-// FIXME: Thread safety.
-
 #define RECYCLE_BIG_ALLOCATIONS
 
 #define PAGE_ROUND_UP(x) ((((size_t)(x)) + PAGE_SIZE - 1) & (~(PAGE_SIZE - 1)))
@@ -67,8 +65,15 @@ static LibThread::Lock& malloc_lock()
     return *reinterpret_cast<LibThread::Lock*>(&lock_storage);
 }
 
-constexpr size_t number_of_chunked_blocks_to_keep_around_per_size_class = 4;
+// How many empty blocks of a size class we hold on to adapts to how the program behaves:
+// whenever we have to allocate a new block shortly after releasing one, we keep more of them
+// around. When blocks keep being released without needing new ones, we keep fewer.
+constexpr size_t min_number_of_empty_blocks_to_keep_per_size_class = 1;
+constexpr size_t initial_number_of_empty_blocks_to_keep_per_size_class = 4;
+constexpr size_t max_number_of_empty_blocks_to_keep_per_size_class = 16;
 constexpr size_t number_of_big_blocks_to_keep_around_per_size_class = 8;
+constexpr size_t max_number_of_chunks_in_thread_cache_per_size_class = 32;
+constexpr size_t max_thread_cache_bytes_per_size_class = 16 * KiB;
 
 static bool s_log_malloc = false;
 static bool s_scrub_malloc = true;
@@ -95,6 +100,13 @@ struct MallocStats {
     size_t number_of_freed_full_blocks;
     size_t number_of_keeps;
     size_t number_of_frees;
+
+    size_t number_of_thread_cache_refills;
+    size_t number_of_thread_cache_flushes;
+
+    size_t number_of_empty_block_target_increases;
+    size_t number_of_empty_block_target_decreases;
+    size_t big_allocation_bytes;
 };
 static MallocStats g_malloc_stats = {};
 
@@ -102,7 +114,10 @@ struct Allocator {
     size_t size { 0 };
     size_t block_count { 0 };
     size_t empty_block_count { 0 };
-    ChunkedBlock* empty_blocks[number_of_chunked_blocks_to_keep_around_per_size_class] { nullptr };
+    size_t empty_block_target { initial_number_of_empty_blocks_to_keep_per_size_class };
+    // Blocks released since we last had to allocate a new one.
+    size_t consecutive_release_count { 0 };
+    ChunkedBlock* empty_blocks[max_number_of_empty_blocks_to_keep_per_size_class] { nullptr };
     InlineLinkedList<ChunkedBlock> usable_blocks;
     InlineLinkedList<ChunkedBlock> full_blocks;
 };
@@ -130,9 +145,14 @@ static inline BigAllocator (&big_allocators())[1]
     return reinterpret_cast<BigAllocator(&)[1]>(g_big_allocators_storage);
 }
 
+// Maps (size - 1) / 8 to a size class, so that the common small sizes don't have to search for theirs.
+constexpr size_t max_small_allocation_size = 1024;
+static u8 g_small_size_class_indices[max_small_allocation_size / 8];
+
 static Allocator* allocator_for_size(size_t size, size_t& good_size)
 {
-    for (size_t i = 0; size_classes[i]; ++i) {
+    size_t first_size_class = g_small_size_class_indices[(min(size, max_small_allocation_size) - 1) / 8];
+    for (size_t i = first_size_class; size_classes[i]; ++i) {
         if (size <= size_classes[i]) {
             good_size = size_classes[i];
             return &allocators()[i];
@@ -142,6 +162,55 @@ static Allocator* allocator_for_size(size_t size, size_t& good_size)
     return nullptr;
 }
 
+static inline size_t size_class_of(const Allocator* allocator)
+{
+    return allocator - allocators();
+}
+
+// Each thread keeps some free chunks of every size class to itself, so that most calls to
+// malloc() and free() don't have to take the malloc lock. While a chunk sits in a thread
+// cache, its ChunkedBlock counts it as used. Chunks move between a thread cache and the
+// blocks in batches of half the cache's capacity.
+struct ThreadCache {
+    FreelistEntry* chunks[num_size_classes];
+    u8 chunk_counts[num_size_classes];
+};
+
+static __thread ThreadCache t_thread_cache;
+
+// Every allocation this thread made, including the ones served from its cache without taking the lock.
+static __thread size_t t_allocation_count;
+
+static constexpr size_t thread_cache_capacity(size_t size_class)
+{
+    return min(max_number_of_chunks_in_thread_cache_per_size_class, max_thread_cache_bytes_per_size_class / size_classes[size_class]);
+}
+
+static constexpr size_t thread_cache_batch_size(size_t size_class)
+{
+    return max(thread_cache_capacity(size_class) / 2, (size_t)1);
+}
+
+ALWAYS_INLINE static void* take_chunk_from_thread_cache(size_t size_class)
+{
+    auto& cache = t_thread_cache;
+    auto* entry = cache.chunks[size_class];
+    if (!entry)
+        return nullptr;
+    cache.chunks[size_class] = entry->next;
+    --cache.chunk_counts[size_class];
+    return entry;
+}
+
+ALWAYS_INLINE static void put_chunk_in_thread_cache(size_t size_class, void* ptr)
+{
+    auto& cache = t_thread_cache;
+    auto* entry = (FreelistEntry*)ptr;
+    entry->next = cache.chunks[size_class];
+    cache.chunks[size_class] = entry;
+    ++cache.chunk_counts[size_class];
+}
+
 #ifdef RECYCLE_BIG_ALLOCATIONS
 static BigAllocator* big_allocator_for_size(size_t size)
 {
@@ -171,55 +240,9 @@ enum class CallerWillInitializeMemory {
     Yes,
 };
 
-static void* malloc_impl(size_t size, CallerWillInitializeMemory caller_will_initialize_memory)
+// Takes a chunk out of one of the allocator's blocks. Must be called with the malloc lock held.
+static void* allocate_chunk(Allocator* allocator, size_t good_size)
 {
-    LOCKER(malloc_lock());
-
-    if (s_log_malloc)
-        dbgln("LibC: malloc({})", size);
-
-    if (!size)
-        return nullptr;
-
-    g_malloc_stats.number_of_malloc_calls++;
-
-    size_t good_size;
-    auto* allocator = allocator_for_size(size, good_size);
-
-    if (!allocator) {
-        size_t real_size = round_up_to_power_of_two(sizeof(BigAllocationBlock) + size, ChunkedBlock::block_size);
-#ifdef RECYCLE_BIG_ALLOCATIONS
-        if (auto* allocator = big_allocator_for_size(real_size)) {
-            if (!allocator->blocks.is_empty()) {
-                g_malloc_stats.number_of_big_allocator_hits++;
-                auto* block = allocator->blocks.take_last();
-                int rc = madvise(block, real_size, MADV_SET_NONVOLATILE);
-                bool this_block_was_purged = rc == 1;
-                if (rc < 0) {
-                    perror("madvise");
-                    VERIFY_NOT_REACHED();
-                }
-                if (mprotect(block, real_size, PROT_READ | PROT_WRITE) < 0) {
-                    perror("mprotect");
-                    VERIFY_NOT_REACHED();
-                }
-                if (this_block_was_purged) {
-                    g_malloc_stats.number_of_big_allocator_purge_hits++;
-                    new (block) BigAllocationBlock(real_size);
-                }
-
-                ue_notify_malloc(&block->m_slot[0], size);
-                return &block->m_slot[0];
-            }
-        }
-#endif
-        g_malloc_stats.number_of_big_allocs++;
-        auto* block = (BigAllocationBlock*)os_alloc(real_size, "malloc: BigAllocationBlock");
-        new (block) BigAllocationBlock(real_size);
-        ue_notify_malloc(&block->m_slot[0], size);
-        return &block->m_slot[0];
-    }
-
     ChunkedBlock* block = nullptr;
 
     for (block = allocator->usable_blocks.head(); block; block = block->next()) {
@@ -250,6 +273,12 @@ static void* malloc_impl(size_t size, CallerWillInitializeMemory caller_will_ini
 
     if (!block) {
         g_malloc_stats.number_of_block_allocs++;
+        if (allocator->consecutive_release_count != 0 && allocator->empty_block_target < max_number_of_empty_blocks_to_keep_per_size_class) {
+            // We just gave a block back and now need a new one, keep more of them around next time.
+            g_malloc_stats.number_of_empty_block_target_increases++;
+            allocator->empty_block_target = min(allocator->empty_block_target * 2, max_number_of_empty_blocks_to_keep_per_size_class);
+        }
+        allocator->consecutive_release_count = 0;
         char buffer[64];
         snprintf(buffer, sizeof(buffer), "malloc: ChunkedBlock(%zu)", good_size);
         block = (ChunkedBlock*)os_alloc(ChunkedBlock::block_size, buffer);
@@ -269,61 +298,83 @@ static void* malloc_impl(size_t size, CallerWillInitializeMemory caller_will_ini
         allocator->full_blocks.append(block);
     }
     dbgln_if(MALLOC_DEBUG, "LibC: allocated {:p} (chunk in block {:p}, size {})", ptr, block, block->bytes_per_chunk());
-
-    if (s_scrub_malloc && caller_will_initialize_memory == CallerWillInitializeMemory::No)
-        memset(ptr, MALLOC_SCRUB_BYTE, block->m_size);
-
-    ue_notify_malloc(ptr, size);
     return ptr;
 }
 
-static void free_impl(void* ptr)
+static void* malloc_impl(size_t size, CallerWillInitializeMemory caller_will_initialize_memory)
 {
-    ScopedValueRollback rollback(errno);
-
-    if (!ptr)
-        return;
+    if (s_log_malloc)
+        dbgln("LibC: malloc({})", size);
 
-    g_malloc_stats.number_of_free_calls++;
+    if (!size)
+        return nullptr;
 
-    LOCKER(malloc_lock());
+    ++t_allocation_count;
 
-    void* block_base = (void*)((FlatPtr)ptr & ChunkedBlock::ChunkedBlock::block_mask);
-    size_t magic = *(size_t*)block_base;
+    size_t good_size;
+    auto* allocator = allocator_for_size(size, good_size);
 
-    if (magic == MAGIC_BIGALLOC_HEADER) {
-        auto* block = (BigAllocationBlock*)block_base;
-#ifdef RECYCLE_BIG_ALLOCATIONS
-        if (auto* allocator = big_allocator_for_size(block->m_size)) {
-            if (allocator->blocks.size() < number_of_big_blocks_to_keep_around_per_size_class) {
-                g_malloc_stats.number_of_big_allocator_keeps++;
-                allocator->blocks.append(block);
-                size_t this_block_size = block->m_size;
-                if (mprotect(block, this_block_size, PROT_NONE) < 0) {
-                    perror("mprotect");
-                    VERIFY_NOT_REACHED();
-                }
-                if (madvise(block, this_block_size, MADV_SET_VOLATILE) != 0) {
-                    perror("madvise");
-                    VERIFY_NOT_REACHED();
-                }
-                return;
+    if (allocator) {
+        auto size_class = size_class_of(allocator);
+        void* ptr = take_chunk_from_thread_cache(size_class);
+        if (!ptr) {
+            LOCKER(malloc_lock());
+            g_malloc_stats.number_of_malloc_calls++;
+            ptr = allocate_chunk(allocator, good_size);
+            if (thread_cache_capacity(size_class) != 0) {
+                g_malloc_stats.number_of_thread_cache_refills++;
+                for (size_t i = 1; i < thread_cache_batch_size(size_class); ++i)
+                    put_chunk_in_thread_cache(size_class, allocate_chunk(allocator, good_size));
             }
         }
-#endif
-        g_malloc_stats.number_of_big_allocator_frees++;
-        os_free(block, block->m_size);
-        return;
+
+        if (s_scrub_malloc && caller_will_initialize_memory == CallerWillInitializeMemory::No)
+            memset(ptr, MALLOC_SCRUB_BYTE, good_size);
+
+        ue_notify_malloc(ptr, size);
+        return ptr;
     }
 
-    assert(magic == MAGIC_PAGE_HEADER);
-    auto* block = (ChunkedBlock*)block_base;
+    LOCKER(malloc_lock());
+    g_malloc_stats.number_of_malloc_calls++;
 
-    dbgln_if(MALLOC_DEBUG, "LibC: freeing {:p} in allocator {:p} (size={}, used={})", ptr, block, block->bytes_per_chunk(), block->used_chunks());
+    size_t real_size = round_up_to_power_of_two(sizeof(BigAllocationBlock) + size, ChunkedBlock::block_size);
+#ifdef RECYCLE_BIG_ALLOCATIONS
+    if (auto* allocator = big_allocator_for_size(real_size)) {
+        if (!allocator->blocks.is_empty()) {
+            g_malloc_stats.number_of_big_allocator_hits++;
+            auto* block = allocator->blocks.take_last();
+            int rc = madvise(block, real_size, MADV_SET_NONVOLATILE);
+            bool this_block_was_purged = rc == 1;
+            if (rc < 0) {
+                perror("madvise");
+                VERIFY_NOT_REACHED();
+            }
+            if (mprotect(block, real_size, PROT_READ | PROT_WRITE) < 0) {
+                perror("mprotect");
+                VERIFY_NOT_REACHED();
+            }
+            if (this_block_was_purged) {
+                g_malloc_stats.number_of_big_allocator_purge_hits++;
+                new (block) BigAllocationBlock(real_size);
+            }
 
-    if (s_scrub_free)
-        memset(ptr, FREE_SCRUB_BYTE, block->bytes_per_chunk());
+            ue_notify_malloc(&block->m_slot[0], size);
+            return &block->m_slot[0];
+        }
+    }
+#endif
+    g_malloc_stats.number_of_big_allocs++;
+    g_malloc_stats.big_allocation_bytes += real_size;
+    auto* block = (BigAllocationBlock*)os_alloc(real_size, "malloc: BigAllocationBlock");
+    new (block) BigAllocationBlock(real_size);
+    ue_notify_malloc(&block->m_slot[0], size);
+    return &block->m_slot[0];
+}
 
+// Puts a chunk back into its block. Must be called with the malloc lock held.
+static void free_chunk(ChunkedBlock* block, void* ptr)
+{
     auto* entry = (FreelistEntry*)ptr;
     entry->next = block->m_freelist;
     block->m_freelist = entry;
@@ -342,7 +393,7 @@ static void free_impl(void* ptr)
     if (!block->used_chunks()) {
         size_t good_size;
         auto* allocator = allocator_for_size(block->m_size, good_size);
-        if (allocator->block_count < number_of_chunked_blocks_to_keep_around_per_size_class) {
+        if (allocator->empty_block_count < allocator->empty_block_target) {
             dbgln_if(MALLOC_DEBUG, "Keeping block {:p} around for size class {}", block, good_size);
             g_malloc_stats.number_of_keeps++;
             allocator->usable_blocks.remove(block);
@@ -356,9 +407,99 @@ static void free_impl(void* ptr)
         allocator->usable_blocks.remove(block);
         --allocator->block_count;
         os_free(block, ChunkedBlock::block_size);
+
+        // If we keep releasing blocks without needing new ones, the program is shrinking.
+        if (++allocator->consecutive_release_count > allocator->empty_block_target && allocator->empty_block_target > min_number_of_empty_blocks_to_keep_per_size_class) {
+            g_malloc_stats.number_of_empty_block_target_decreases++;
+            allocator->empty_block_target = max(allocator->empty_block_target / 2, min_number_of_empty_blocks_to_keep_per_size_class);
+            allocator->consecutive_release_count = 0;
+        }
     }
 }
 
+// Gives up to chunk_count chunks from the thread cache back to their blocks. Must be called with the malloc lock held.
+static void flush_thread_cache(size_t size_class, size_t chunk_count)
+{
+    g_malloc_stats.number_of_thread_cache_flushes++;
+    for (size_t i = 0; i < chunk_count; ++i) {
+        auto* ptr = take_chunk_from_thread_cache(size_class);
+        if (!ptr)
+            break;
+        free_chunk((ChunkedBlock*)((FlatPtr)ptr & ChunkedBlock::block_mask), ptr);
+    }
+}
+
+static void free_impl(void* ptr)
+{
+    ScopedValueRollback rollback(errno);
+
+    if (!ptr)
+        return;
+
+    void* block_base = (void*)((FlatPtr)ptr & ChunkedBlock::ChunkedBlock::block_mask);
+    size_t magic = *(size_t*)block_base;
+
+    if (magic == MAGIC_PAGE_HEADER) {
+        auto* block = (ChunkedBlock*)block_base;
+
+        dbgln_if(MALLOC_DEBUG, "LibC: freeing {:p} in allocator {:p} (size={}, used={})", ptr, block, block->bytes_per_chunk(), block->used_chunks());
+
+        if (s_scrub_free)
+            memset(ptr, FREE_SCRUB_BYTE, block->bytes_per_chunk());
+
+        size_t good_size;
+        auto size_class = size_class_of(allocator_for_size(block->m_size, good_size));
+        auto capacity = thread_cache_capacity(size_class);
+        if (capacity == 0) {
+            LOCKER(malloc_lock());
+            g_malloc_stats.number_of_free_calls++;
+            free_chunk(block, ptr);
+            return;
+        }
+        if (t_thread_cache.chunk_counts[size_class] >= capacity) {
+            LOCKER(malloc_lock());
+            g_malloc_stats.number_of_free_calls++;
+            flush_thread_cache(size_class, thread_cache_batch_size(size_class));
+        }
+        put_chunk_in_thread_cache(size_class, ptr);
+        return;
+    }
+
+    LOCKER(malloc_lock());
+    g_malloc_stats.number_of_free_calls++;
+
+    assert(magic == MAGIC_BIGALLOC_HEADER);
+    auto* block = (BigAllocationBlock*)block_base;
+#ifdef RECYCLE_BIG_ALLOCATIONS
+    if (auto* allocator = big_allocator_for_size(block->m_size)) {
+        if (allocator->blocks.size() < number_of_big_blocks_to_keep_around_per_size_class) {
+            g_malloc_stats.number_of_big_allocator_keeps++;
+            allocator->blocks.append(block);
+            size_t this_block_size = block->m_size;
+            if (mprotect(block, this_block_size, PROT_NONE) < 0) {
+                perror("mprotect");
+                VERIFY_NOT_REACHED();
+            }
+            if (madvise(block, this_block_size, MADV_SET_VOLATILE) != 0) {
+                perror("madvise");
+                VERIFY_NOT_REACHED();
+            }
+            return;
+        }
+    }
+#endif
+    g_malloc_stats.number_of_big_allocator_frees++;
+    g_malloc_stats.big_allocation_bytes -= block->m_size;
+    os_free(block, block->m_size);
+}
+
+void __malloc_thread_exit()
+{
+    LOCKER(malloc_lock());
+    for (size_t i = 0; i < num_size_classes; ++i)
+        flush_thread_cache(i, t_thread_cache.chunk_counts[i]);
+}
+
 [[gnu::flatten]] void* malloc(size_t size)
 {
     void* ptr = malloc_impl(size, CallerWillInitializeMemory::No);
@@ -439,12 +580,24 @@ void __malloc_init()
         allocators()[i].size = size_classes[i];
     }
 
+    size_t size_class = 0;
+    for (size_t i = 0; i < max_small_allocation_size / 8; ++i) {
+        while (size_classes[size_class] < (i + 1) * 8)
+            ++size_class;
+        g_small_size_class_indices[i] = size_class;
+    }
+
     new (&big_allocators()[0])(BigAllocator);
 }
 
+size_t serenity_allocation_count()
+{
+    return t_allocation_count;
+}
+
 void serenity_dump_malloc_stats()
 {
-    dbgln("# malloc() calls: {}", g_malloc_stats.number_of_malloc_calls);
+    dbgln("# malloc() calls that took the lock: {}", g_malloc_stats.number_of_malloc_calls);
     dbgln();
     dbgln("big alloc hits: {}", g_malloc_stats.number_of_big_allocator_hits);
     dbgln("big alloc hits that were purged: {}", g_malloc_stats.number_of_big_allocator_purge_hits);
@@ -455,7 +608,7 @@ void serenity_dump_malloc_stats()
     dbgln("block allocs: {}", g_malloc_stats.number_of_block_allocs);
     dbgln("filled blocks: {}", g_malloc_stats.number_of_blocks_full);
     dbgln();
-    dbgln("# free() calls: {}", g_malloc_stats.number_of_free_calls);
+    dbgln("# free() calls that took the lock: {}", g_malloc_stats.number_of_free_calls);
     dbgln();
     dbgln("big alloc keeps: {}", g_malloc_stats.number_of_big_allocator_keeps);
     dbgln("big alloc frees: {}", g_malloc_stats.number_of_big_allocator_frees);
@@ -463,5 +616,37 @@ void serenity_dump_malloc_stats()
     dbgln("full block frees: {}", g_malloc_stats.number_of_freed_full_blocks);
     dbgln("number of keeps: {}", g_malloc_stats.number_of_keeps);
     dbgln("number of frees: {}", g_malloc_stats.number_of_frees);
+    dbgln();
+    dbgln("thread cache refills: {}", g_malloc_stats.number_of_thread_cache_refills);
+    dbgln("thread cache flushes: {}", g_malloc_stats.number_of_thread_cache_flushes);
+    dbgln();
+    dbgln("empty block target increases: {}", g_malloc_stats.number_of_empty_block_target_increases);
+    dbgln("empty block target decreases: {}", g_malloc_stats.number_of_empty_block_target_decreases);
+
+    LOCKER(malloc_lock());
+
+    // Chunks that sit in a thread cache count as used here.
+    size_t total_mapped_bytes = 0;
+    size_t total_used_bytes = 0;
+    dbgln();
+    dbgln("size class | blocks | empty | target | chunks used | bytes used | utilization");
+    for (size_t i = 0; i < num_size_classes; ++i) {
+        auto& allocator = allocators()[i];
+        if (!allocator.block_count)
+            continue;
+        size_t used_chunks = 0;
+        for (auto* block = allocator.usable_blocks.head(); block; block = block->next())
+            used_chunks += block->used_chunks();
+        for (auto* block = allocator.full_blocks.head(); block; block = block->next())
+            used_chunks += block->used_chunks();
+        size_t mapped_bytes = allocator.block_count * ChunkedBlock::block_size;
+        size_t used_bytes = used_chunks * allocator.size;
+        total_mapped_bytes += mapped_bytes;
+        total_used_bytes += used_bytes;
+        dbgln("{:>10} | {:>6} | {:>5} | {:>6} | {:>11} | {:>10} | {:>3}%", allocator.size, allocator.block_count, allocator.empty_block_count, allocator.empty_block_target, used_chunks, used_bytes, used_bytes * 100 / mapped_bytes);
+    }
+    dbgln();
+    dbgln("chunked blocks: {} bytes mapped, {} bytes used", total_mapped_bytes, total_used_bytes);
+    dbgln("big allocations: {} bytes mapped", g_malloc_stats.big_allocation_bytes);
 }
 }
@@ -34,7 +34,16 @@
 #define MALLOC_SCRUB_BYTE 0xdc
 #define FREE_SCRUB_BYTE 0xed
 
-static constexpr unsigned short size_classes[] = { 8, 16, 32, 64, 128, 256, 500, 1016, 2032, 4088, 8184, 16376, 32752, 0 };
+// Size classes are roughly a quarter of a power of two apart, so that no chunk wastes much more
+// than 20% of its size. The bigger ones are picked so that a whole number of them fits nicely
+// into a ChunkedBlock.
+static constexpr unsigned short size_classes[] = {
+    8, 16, 24, 32, 48, 64, 80, 96, 112, 128,
+    160, 192, 224, 256, 320, 384, 448, 512,
+    640, 768, 896, 1016, 1280, 1536, 1792, 2032,
+    2560, 3072, 3584, 4088, 4672, 5456, 6544, 8184,
+    10912, 13096, 16376, 21832, 32752, 0
+};
 static constexpr size_t num_size_classes = (sizeof(size_classes) / sizeof(unsigned short)) - 1;
 
 struct CommonHeader {
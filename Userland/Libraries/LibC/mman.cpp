@@ -102,4 +102,14 @@ void* allocate_tls(size_t size)
     }
     return (void*)rc;
 }
+
+void* reserve_shared_image(int fd, size_t size)
+{
+    ptrdiff_t rc = syscall(SC_reserve_shared_image, fd, size);
+    if (rc < 0 && -rc < EMAXERRNO) {
+        errno = -rc;
+        return MAP_FAILED;
+    }
+    return (void*)rc;
+}
 }
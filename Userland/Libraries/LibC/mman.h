@@ -38,6 +38,8 @@
 #define MAP_STACK 0x40
 #define MAP_NORESERVE 0x80
 #define MAP_RANDOMIZED 0x100
+#define MAP_HUGETLB 0x200
+#define MAP_POPULATE 0x400
 
 #define PROT_READ 0x1
 #define PROT_WRITE 0x2
@@ -46,9 +48,15 @@
 
 #define MAP_FAILED ((void*)-1)
 
+#define MADV_NORMAL 0x0
+#define MADV_RANDOM 0x1
+#define MADV_SEQUENTIAL 0x2
+#define MADV_WILLNEED 0x3
+#define MADV_DONTNEED 0x4
 #define MADV_SET_VOLATILE 0x100
 #define MADV_SET_NONVOLATILE 0x200
 #define MADV_GET_VOLATILE 0x400
+#define MADV_SHARE_IDENTICAL 0x800
 
 __BEGIN_DECLS
 
@@ -61,5 +69,6 @@ int mprotect(void*, size_t, int prot);
 int set_mmap_name(void*, size_t, const char*);
 int madvise(void*, size_t, int advice);
 void* allocate_tls(size_t);
+void* reserve_shared_image(int fd, size_t);
 
 __END_DECLS
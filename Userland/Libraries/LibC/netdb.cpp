@@ -96,6 +96,7 @@ static int connect_to_lookup_server()
     return fd;
 }
 
+// Like the other buffers handed out as writable char*, this must not share its StringImpl with anyone else.
 static String gethostbyname_name_buffer;
 
 hostent* gethostbyname(const char* name)
@@ -103,7 +104,7 @@ hostent* gethostbyname(const char* name)
     auto ipv4_address = IPv4Address::from_string(name);
 
     if (ipv4_address.has_value()) {
-        gethostbyname_name_buffer = ipv4_address.value().to_string();
+        gethostbyname_name_buffer = ipv4_address.value().to_string().isolated_copy();
         __gethostbyname_buffer.h_name = const_cast<char*>(gethostbyname_name_buffer.characters());
         __gethostbyname_buffer.h_aliases = nullptr;
         __gethostbyname_buffer.h_addrtype = AF_INET;
@@ -190,7 +191,7 @@ hostent* gethostbyname(const char* name)
     }
     VERIFY(nrecv == response_length);
 
-    gethostbyname_name_buffer = name;
+    gethostbyname_name_buffer = String(name).isolated_copy();
     __gethostbyname_buffer.h_name = const_cast<char*>(gethostbyname_name_buffer.characters());
     __gethostbyname_buffer.h_aliases = nullptr;
     __gethostbyname_buffer.h_addrtype = AF_INET;
@@ -448,7 +449,7 @@ static bool fill_getserv_buffers(const char* line, ssize_t read)
         fprintf(stderr, "getservent(): malformed services file\n");
         return false;
     }
-    __getserv_name_buffer = split_line[0];
+    __getserv_name_buffer = split_line[0].isolated_copy();
 
     auto port_protocol_split = String(split_line[1]).split('/');
     if (port_protocol_split.size() < 2) {
@@ -466,7 +467,7 @@ static bool fill_getserv_buffers(const char* line, ssize_t read)
     port_protocol_split[1].replace("\t", "", true);
     port_protocol_split[1].replace("\n", "", true);
 
-    __getserv_protocol_buffer = port_protocol_split[1];
+    __getserv_protocol_buffer = port_protocol_split[1].isolated_copy();
     __getserv_alias_list_buffer.clear();
 
     // If there are aliases for the service, we will fill the alias list buffer.
@@ -630,7 +631,7 @@ static bool fill_getproto_buffers(const char* line, ssize_t read)
         fprintf(stderr, "getprotoent(): malformed protocols file\n");
         return false;
     }
-    __getproto_name_buffer = split_line[0];
+    __getproto_name_buffer = split_line[0].isolated_copy();
 
     auto number = split_line[1].to_int();
     if (!number.has_value())
@@ -27,3 +27,4 @@
 #pragma once
 
 #define TCP_NODELAY 10
+#define TCP_CORK 11
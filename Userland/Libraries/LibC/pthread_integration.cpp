@@ -29,7 +29,9 @@
 #include <AK/Types.h>
 #include <AK/Vector.h>
 #include <bits/pthread_integration.h>
+#include <errno.h>
 #include <sched.h>
+#include <serenity.h>
 #include <sys/types.h>
 #include <unistd.h>
 
@@ -110,25 +112,91 @@ int __pthread_self()
     return gettid();
 }
 
+// The lock word is one of these, so that only unlocking a mutex somebody is
+// sleeping on has to enter the kernel.
+static constexpr u32 MUTEX_UNLOCKED = 0;
+static constexpr u32 MUTEX_LOCKED_NO_WAITERS = 1;
+static constexpr u32 MUTEX_LOCKED_WITH_WAITERS = 2;
+
+// Most critical sections are short, so it's usually cheaper to wait a little
+// for the holder to finish on another CPU than to go to sleep right away.
+static constexpr int MUTEX_SPIN_COUNT = 100;
+
+static bool try_lock_spinning(pthread_mutex_t* mutex)
+{
+    auto& atomic = reinterpret_cast<Atomic<u32>&>(mutex->lock);
+    for (int i = 0; i < MUTEX_SPIN_COUNT; ++i) {
+        // Don't hog the cache line with failing exchanges, and stop spinning once somebody sleeps.
+        u32 current = atomic.load(AK::memory_order_relaxed);
+        if (current == MUTEX_LOCKED_WITH_WAITERS)
+            return false;
+        if (current == MUTEX_UNLOCKED && atomic.compare_exchange_strong(current, MUTEX_LOCKED_NO_WAITERS, AK::memory_order_acquire))
+            return true;
+        __builtin_ia32_pause();
+    }
+    return false;
+}
+
+static void lock_with_waiters(pthread_mutex_t* mutex)
+{
+    auto& atomic = reinterpret_cast<Atomic<u32>&>(mutex->lock);
+    int saved_errno = errno;
+    while (atomic.exchange(MUTEX_LOCKED_WITH_WAITERS, AK::memory_order_acquire) != MUTEX_UNLOCKED)
+        futex(&mutex->lock, FUTEX_WAIT, MUTEX_LOCKED_WITH_WAITERS, nullptr, nullptr, 0);
+    errno = saved_errno;
+}
+
 int __pthread_mutex_lock(void* mutexp)
 {
     auto* mutex = reinterpret_cast<pthread_mutex_t*>(mutexp);
     auto& atomic = reinterpret_cast<Atomic<u32>&>(mutex->lock);
     pthread_t this_thread = __pthread_self();
-    for (;;) {
-        u32 expected = false;
-        if (!atomic.compare_exchange_strong(expected, true, AK::memory_order_acq_rel)) {
-            if (mutex->type == __PTHREAD_MUTEX_RECURSIVE && mutex->owner == this_thread) {
-                mutex->level++;
-                return 0;
-            }
-            sched_yield();
-            continue;
+    u32 expected = MUTEX_UNLOCKED;
+    if (!atomic.compare_exchange_strong(expected, MUTEX_LOCKED_NO_WAITERS, AK::memory_order_acquire)) {
+        if (mutex->type == __PTHREAD_MUTEX_RECURSIVE && mutex->owner == this_thread) {
+            mutex->level++;
+            return 0;
         }
-        mutex->owner = this_thread;
-        mutex->level = 0;
+        if (!try_lock_spinning(mutex))
+            lock_with_waiters(mutex);
+    }
+    mutex->owner = this_thread;
+    mutex->level = 0;
+    return 0;
+}
+
+// Like __pthread_mutex_lock(), but always assumes there are other waiters.
+// pthread_cond_broadcast() requeues sleeping waiters onto the mutex without
+// going through the lock word, so whoever they wake into must hand the mutex on.
+int __pthread_mutex_lock_pessimistic_np(void* mutexp)
+{
+    auto* mutex = reinterpret_cast<pthread_mutex_t*>(mutexp);
+    pthread_t this_thread = __pthread_self();
+    if (mutex->type == __PTHREAD_MUTEX_RECURSIVE && mutex->owner == this_thread) {
+        mutex->level++;
         return 0;
     }
+    lock_with_waiters(mutex);
+    mutex->owner = this_thread;
+    mutex->level = 0;
+    return 0;
+}
+
+int __pthread_mutex_trylock(void* mutexp)
+{
+    auto* mutex = reinterpret_cast<pthread_mutex_t*>(mutexp);
+    auto& atomic = reinterpret_cast<Atomic<u32>&>(mutex->lock);
+    u32 expected = MUTEX_UNLOCKED;
+    if (!atomic.compare_exchange_strong(expected, MUTEX_LOCKED_NO_WAITERS, AK::memory_order_acquire)) {
+        if (mutex->type == __PTHREAD_MUTEX_RECURSIVE && mutex->owner == __pthread_self()) {
+            mutex->level++;
+            return 0;
+        }
+        return EBUSY;
+    }
+    mutex->owner = __pthread_self();
+    mutex->level = 0;
+    return 0;
 }
 
 int __pthread_mutex_unlock(void* mutexp)
@@ -139,7 +207,9 @@ int __pthread_mutex_unlock(void* mutexp)
         return 0;
     }
     mutex->owner = 0;
-    mutex->lock = 0;
+    auto& atomic = reinterpret_cast<Atomic<u32>&>(mutex->lock);
+    if (atomic.exchange(MUTEX_UNLOCKED, AK::memory_order_release) == MUTEX_LOCKED_WITH_WAITERS)
+        futex(&mutex->lock, FUTEX_WAKE, 1, nullptr, nullptr, 0);
     return 0;
 }
 
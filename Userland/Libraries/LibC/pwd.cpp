@@ -104,13 +104,14 @@ static bool parse_pwddb_entry(const String& line)
         return false;
     }
 
-    s_name = parts[0];
-    s_passwd = parts[1];
+    // The entry hands out writable pointers to these, so they must not share a StringImpl with anyone else.
+    s_name = String(parts[0]).isolated_copy();
+    s_passwd = String(parts[1]).isolated_copy();
     auto& uid_string = parts[2];
     auto& gid_string = parts[3];
-    s_gecos = parts[4];
-    s_dir = parts[5];
-    s_shell = parts[6];
+    s_gecos = String(parts[4]).isolated_copy();
+    s_dir = String(parts[5]).isolated_copy();
+    s_shell = String(parts[6]).isolated_copy();
 
     auto uid = uid_string.to_uint();
     if (!uid.has_value()) {
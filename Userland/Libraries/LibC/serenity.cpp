@@ -49,9 +49,9 @@ int module_unload(const char* name, size_t name_length)
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
-int profiling_enable(pid_t pid)
+int profiling_enable(pid_t pid, int sample_source)
 {
-    int rc = syscall(SC_profiling_enable, pid);
+    int rc = syscall(SC_profiling_enable, pid, sample_source);
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
@@ -65,8 +65,8 @@ int futex(uint32_t* userspace_address, int futex_op, uint32_t value, const struc
 {
     int rc;
     switch (futex_op & FUTEX_CMD_MASK) {
-    //case FUTEX_CMP_REQUEUE:
-    // FUTEX_CMP_REQUEUE_PI:
+    case FUTEX_REQUEUE:
+    case FUTEX_CMP_REQUEUE:
     case FUTEX_WAKE_OP: {
         // These interpret timeout as a u32 value for val2
         Syscall::SC_futex_params params {
@@ -37,7 +37,7 @@ int disown(pid_t);
 int module_load(const char* path, size_t path_length);
 int module_unload(const char* name, size_t name_length);
 
-int profiling_enable(pid_t);
+int profiling_enable(pid_t, int sample_source);
 int profiling_disable(pid_t);
 
 #define THREAD_PRIORITY_MIN 1
@@ -97,6 +97,18 @@ int purge(int mode);
 #define PERF_EVENT_SAMPLE 0
 #define PERF_EVENT_MALLOC 1
 #define PERF_EVENT_FREE 2
+#define PERF_EVENT_CONTEXT_SWITCH 3
+#define PERF_EVENT_PAGE_FAULT 4
+#define PERF_EVENT_DISK_REQUEST 5
+#define PERF_EVENT_SYSCALL_ENTRY 6
+#define PERF_EVENT_SYSCALL_EXIT 7
+
+// What drives the samples of a profile, see profiling_enable().
+#define PROFILING_SAMPLE_TIMER 0
+#define PROFILING_SAMPLE_CYCLES 1
+#define PROFILING_SAMPLE_INSTRUCTIONS 2
+#define PROFILING_SAMPLE_CACHE_MISSES 3
+#define PROFILING_SAMPLE_BRANCH_MISSES 4
 
 int perf_event(int type, uintptr_t arg1, uintptr_t arg2);
 
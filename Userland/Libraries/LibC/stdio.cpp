@@ -31,6 +31,7 @@
 #include <AK/StdLibExtras.h>
 #include <AK/kmalloc.h>
 #include <assert.h>
+#include <bits/pthread_integration.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <stdarg.h>
@@ -38,6 +39,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/internals.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <syscall.h>
@@ -69,8 +71,17 @@ public:
     size_t write(const u8*, size_t);
 
     bool gets(u8*, size_t);
+    ssize_t getdelim(char** lineptr, size_t* n, int delim);
     bool ungetc(u8 byte) { return m_buffer.enqueue_front(byte); }
 
+    // Single byte I/O that goes straight to the buffer when it can.
+    int getc();
+    bool putc(u8 byte);
+
+    void lock() { __pthread_mutex_lock(&m_mutex); }
+    bool try_lock() { return __pthread_mutex_trylock(&m_mutex) == 0; }
+    void unlock() { __pthread_mutex_unlock(&m_mutex); }
+
     int seek(off_t offset, int whence);
     off_t tell();
 
@@ -90,7 +101,10 @@ private:
         // Make sure to call realize() before enqueuing any data.
         // Dequeuing can be attempted without it.
         void realize(int fd);
+        // Discard the buffered data, but keep the buffer itself around.
         void drop();
+        // Also free the buffer, so that the next realize() sets up a new one.
+        void free_data();
 
         bool may_use() const { return m_ungotten || m_mode != _IONBF; }
         bool is_not_empty() const { return m_ungotten || !m_empty; }
@@ -104,6 +118,9 @@ private:
 
         bool enqueue_front(u8 byte);
 
+        bool try_dequeue_byte(u8& byte);
+        bool try_enqueue_byte(u8 byte);
+
     private:
         // Note: the fields here are arranged this way
         // to make sizeof(Buffer) smaller.
@@ -136,6 +153,20 @@ private:
     bool m_eof { false };
     pid_t m_popen_child { -1 };
     Buffer m_buffer;
+    pthread_mutex_t m_mutex { 0, 0, 0, __PTHREAD_MUTEX_RECURSIVE };
+};
+
+class ScopedFileLock {
+public:
+    explicit ScopedFileLock(FILE* file)
+        : m_file(file)
+    {
+        m_file->lock();
+    }
+    ~ScopedFileLock() { m_file->unlock(); }
+
+private:
+    FILE* m_file;
 };
 
 FILE::~FILE()
@@ -392,6 +423,71 @@ bool FILE::gets(u8* data, size_t size)
     return total_read > 0;
 }
 
+ssize_t FILE::getdelim(char** lineptr, size_t* n, int delim)
+{
+    // Like gets(), but the line can be arbitrarily long, so we look for the delimiter
+    // in whatever is buffered and copy everything up to it in one go.
+    size_t length = 0;
+    for (;;) {
+        const u8* data;
+        size_t available_size;
+        u8 byte;
+        bool buffered = m_buffer.may_use();
+        if (buffered) {
+            data = m_buffer.begin_dequeue(available_size);
+            if (available_size == 0) {
+                if (read_into_buffer())
+                    continue;
+                break;
+            }
+        } else {
+            if (do_read(&byte, 1) <= 0)
+                break;
+            data = &byte;
+            available_size = 1;
+        }
+
+        auto* delimiter = reinterpret_cast<const u8*>(memchr(data, delim, available_size));
+        size_t actual_size = delimiter ? delimiter - data + 1 : available_size;
+        if (length + actual_size + 1 > *n) {
+            size_t new_size = max(*n * 2, length + actual_size + 1);
+            auto* new_line = reinterpret_cast<char*>(realloc(*lineptr, new_size));
+            if (!new_line)
+                return -1;
+            *lineptr = new_line;
+            *n = new_size;
+        }
+        memcpy(*lineptr + length, data, actual_size);
+        if (buffered)
+            m_buffer.did_dequeue(actual_size);
+        length += actual_size;
+        if (delimiter)
+            break;
+    }
+
+    (*lineptr)[length] = '\0';
+    if (length == 0)
+        return -1;
+    return length;
+}
+
+int FILE::getc()
+{
+    u8 byte;
+    if (m_buffer.try_dequeue_byte(byte) || read(&byte, 1) == 1)
+        return byte;
+    return EOF;
+}
+
+bool FILE::putc(u8 byte)
+{
+    if (!m_buffer.try_enqueue_byte(byte))
+        return write(&byte, 1) == 1;
+    if (m_buffer.mode() == _IOLBF && byte == '\n')
+        flush();
+    return true;
+}
+
 int FILE::seek(off_t offset, int whence)
 {
     bool ok = flush();
@@ -425,8 +521,9 @@ void FILE::reopen(int fd, int mode)
     flush();
     close();
 
-    // Just in case flush() and close() didn't drop the buffer.
-    m_buffer.drop();
+    // Just in case flush() and close() didn't drop the buffer. The new file
+    // may also want a differently sized one.
+    m_buffer.free_data();
 
     m_fd = fd;
     m_mode = mode;
@@ -440,12 +537,24 @@ FILE::Buffer::~Buffer()
         free(m_data);
 }
 
+// Regular files are usually read or written in bulk, so they get a bigger buffer
+// that is a multiple of the file system's preferred I/O size.
+static size_t buffer_capacity_for(int fd)
+{
+    static constexpr size_t max_buffer_capacity = 64 * KiB;
+    struct stat st;
+    if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) || st.st_blksize <= 0)
+        return BUFSIZ;
+    return min(max((size_t)st.st_blksize * 16, (size_t)BUFSIZ), max_buffer_capacity);
+}
+
 void FILE::Buffer::realize(int fd)
 {
     if (m_mode == -1)
         m_mode = isatty(fd) ? _IOLBF : _IOFBF;
 
     if (m_mode != _IONBF && m_data == nullptr) {
+        m_capacity = buffer_capacity_for(fd);
         m_data = reinterpret_cast<u8*>(malloc(m_capacity));
         m_data_is_malloced = true;
     }
@@ -453,7 +562,7 @@ void FILE::Buffer::realize(int fd)
 
 void FILE::Buffer::setbuf(u8* data, int mode, size_t size)
 {
-    drop();
+    free_data();
     m_mode = mode;
     if (data != nullptr) {
         m_data = data;
@@ -463,14 +572,19 @@ void FILE::Buffer::setbuf(u8* data, int mode, size_t size)
 
 void FILE::Buffer::drop()
 {
+    m_begin = m_end = 0;
+    m_empty = true;
+    m_ungotten = false;
+}
+
+void FILE::Buffer::free_data()
+{
+    drop();
     if (m_data_is_malloced) {
         free(m_data);
         m_data = nullptr;
         m_data_is_malloced = false;
     }
-    m_begin = m_end = 0;
-    m_empty = true;
-    m_ungotten = false;
 }
 
 size_t FILE::Buffer::buffered_size() const
@@ -572,6 +686,32 @@ bool FILE::Buffer::enqueue_front(u8 byte)
     return true;
 }
 
+bool FILE::Buffer::try_dequeue_byte(u8& byte)
+{
+    if (m_ungotten) {
+        byte = m_unget_buffer;
+        m_ungotten = false;
+        return true;
+    }
+    if (m_empty)
+        return false;
+    byte = m_data[m_begin];
+    did_dequeue(1);
+    return true;
+}
+
+bool FILE::Buffer::try_enqueue_byte(u8 byte)
+{
+    if (m_mode == _IONBF || m_data == nullptr)
+        return false;
+    bool is_full = !m_empty && m_begin == m_end;
+    if (is_full)
+        return false;
+    m_data[m_end] = byte;
+    did_enqueue(1);
+    return true;
+}
+
 extern "C" {
 
 static u8 default_streams[3][sizeof(FILE)];
@@ -595,6 +735,7 @@ int setvbuf(FILE* stream, char* buf, int mode, size_t size)
         errno = EINVAL;
         return -1;
     }
+    ScopedFileLock lock(stream);
     stream->setbuf(reinterpret_cast<u8*>(buf), mode, size);
     return 0;
 }
@@ -627,12 +768,14 @@ int fflush(FILE* stream)
         dbgln("FIXME: fflush(nullptr) should flush all open streams");
         return 0;
     }
+    ScopedFileLock lock(stream);
     return stream->flush() ? 0 : EOF;
 }
 
 char* fgets(char* buffer, int size, FILE* stream)
 {
     VERIFY(stream);
+    ScopedFileLock lock(stream);
     bool ok = stream->gets(reinterpret_cast<u8*>(buffer), size);
     return ok ? buffer : nullptr;
 }
@@ -640,11 +783,14 @@ char* fgets(char* buffer, int size, FILE* stream)
 int fgetc(FILE* stream)
 {
     VERIFY(stream);
-    char ch;
-    size_t nread = fread(&ch, sizeof(char), 1, stream);
-    if (nread == 1)
-        return ch;
-    return EOF;
+    ScopedFileLock lock(stream);
+    return stream->getc();
+}
+
+int fgetc_unlocked(FILE* stream)
+{
+    VERIFY(stream);
+    return stream->getc();
 }
 
 int getc(FILE* stream)
@@ -654,7 +800,7 @@ int getc(FILE* stream)
 
 int getc_unlocked(FILE* stream)
 {
-    return fgetc(stream);
+    return fgetc_unlocked(stream);
 }
 
 int getchar()
@@ -662,6 +808,11 @@ int getchar()
     return getc(stdin);
 }
 
+int getchar_unlocked()
+{
+    return getc_unlocked(stdin);
+}
+
 ssize_t getdelim(char** lineptr, size_t* n, int delim, FILE* stream)
 {
     if (!lineptr || !n) {
@@ -676,36 +827,9 @@ ssize_t getdelim(char** lineptr, size_t* n, int delim, FILE* stream)
         }
     }
 
-    char* ptr;
-    char* eptr;
-    for (ptr = *lineptr, eptr = *lineptr + *n;;) {
-        int c = fgetc(stream);
-        if (c == -1) {
-            if (feof(stream)) {
-                *ptr = '\0';
-                return ptr == *lineptr ? -1 : ptr - *lineptr;
-            } else {
-                return -1;
-            }
-        }
-        *ptr++ = c;
-        if (c == delim) {
-            *ptr = '\0';
-            return ptr - *lineptr;
-        }
-        if (ptr + 2 >= eptr) {
-            char* nbuf;
-            size_t nbuf_sz = *n * 2;
-            ssize_t d = ptr - *lineptr;
-            if ((nbuf = static_cast<char*>(realloc(*lineptr, nbuf_sz))) == nullptr) {
-                return -1;
-            }
-            *lineptr = nbuf;
-            *n = nbuf_sz;
-            eptr = nbuf + nbuf_sz;
-            ptr = nbuf + d;
-        }
-    }
+    VERIFY(stream);
+    ScopedFileLock lock(stream);
+    return stream->getdelim(lineptr, n, delim);
 }
 
 ssize_t getline(char** lineptr, size_t* n, FILE* stream)
@@ -716,18 +840,24 @@ ssize_t getline(char** lineptr, size_t* n, FILE* stream)
 int ungetc(int c, FILE* stream)
 {
     VERIFY(stream);
+    ScopedFileLock lock(stream);
     bool ok = stream->ungetc(c);
     return ok ? c : EOF;
 }
 
 int fputc(int ch, FILE* stream)
+{
+    VERIFY(stream);
+    ScopedFileLock lock(stream);
+    return fputc_unlocked(ch, stream);
+}
+
+int fputc_unlocked(int ch, FILE* stream)
 {
     VERIFY(stream);
     u8 byte = ch;
-    size_t nwritten = stream->write(&byte, 1);
-    if (nwritten == 0)
+    if (!stream->putc(byte))
         return EOF;
-    VERIFY(nwritten == 1);
     return byte;
 }
 
@@ -736,12 +866,29 @@ int putc(int ch, FILE* stream)
     return fputc(ch, stream);
 }
 
+int putc_unlocked(int ch, FILE* stream)
+{
+    return fputc_unlocked(ch, stream);
+}
+
 int putchar(int ch)
 {
     return putc(ch, stdout);
 }
 
+int putchar_unlocked(int ch)
+{
+    return putc_unlocked(ch, stdout);
+}
+
 int fputs(const char* s, FILE* stream)
+{
+    VERIFY(stream);
+    ScopedFileLock lock(stream);
+    return fputs_unlocked(s, stream);
+}
+
+int fputs_unlocked(const char* s, FILE* stream)
 {
     VERIFY(stream);
     size_t len = strlen(s);
@@ -753,10 +900,11 @@ int fputs(const char* s, FILE* stream)
 
 int puts(const char* s)
 {
-    int rc = fputs(s, stdout);
+    ScopedFileLock lock(stdout);
+    int rc = fputs_unlocked(s, stdout);
     if (rc == EOF)
         return EOF;
-    return fputc('\n', stdout);
+    return fputc_unlocked('\n', stdout);
 }
 
 void clearerr(FILE* stream)
@@ -772,6 +920,13 @@ int ferror(FILE* stream)
 }
 
 size_t fread(void* ptr, size_t size, size_t nmemb, FILE* stream)
+{
+    VERIFY(stream);
+    ScopedFileLock lock(stream);
+    return fread_unlocked(ptr, size, nmemb, stream);
+}
+
+size_t fread_unlocked(void* ptr, size_t size, size_t nmemb, FILE* stream)
 {
     VERIFY(stream);
     VERIFY(!Checked<size_t>::multiplication_would_overflow(size, nmemb));
@@ -781,6 +936,13 @@ size_t fread(void* ptr, size_t size, size_t nmemb, FILE* stream)
 }
 
 size_t fwrite(const void* ptr, size_t size, size_t nmemb, FILE* stream)
+{
+    VERIFY(stream);
+    ScopedFileLock lock(stream);
+    return fwrite_unlocked(ptr, size, nmemb, stream);
+}
+
+size_t fwrite_unlocked(const void* ptr, size_t size, size_t nmemb, FILE* stream)
 {
     VERIFY(stream);
     VERIFY(!Checked<size_t>::multiplication_would_overflow(size, nmemb));
@@ -792,24 +954,28 @@ size_t fwrite(const void* ptr, size_t size, size_t nmemb, FILE* stream)
 int fseek(FILE* stream, long offset, int whence)
 {
     VERIFY(stream);
+    ScopedFileLock lock(stream);
     return stream->seek(offset, whence);
 }
 
 int fseeko(FILE* stream, off_t offset, int whence)
 {
     VERIFY(stream);
+    ScopedFileLock lock(stream);
     return stream->seek(offset, whence);
 }
 
 long ftell(FILE* stream)
 {
     VERIFY(stream);
+    ScopedFileLock lock(stream);
     return stream->tell();
 }
 
 off_t ftello(FILE* stream)
 {
     VERIFY(stream);
+    ScopedFileLock lock(stream);
     return stream->tell();
 }
 
@@ -818,6 +984,7 @@ int fgetpos(FILE* stream, fpos_t* pos)
     VERIFY(stream);
     VERIFY(pos);
 
+    ScopedFileLock lock(stream);
     off_t val = stream->tell();
     if (val == -1L)
         return 1;
@@ -831,31 +998,30 @@ int fsetpos(FILE* stream, const fpos_t* pos)
     VERIFY(stream);
     VERIFY(pos);
 
+    ScopedFileLock lock(stream);
     return stream->seek(*pos, SEEK_SET);
 }
 
 void rewind(FILE* stream)
 {
     VERIFY(stream);
+    ScopedFileLock lock(stream);
     int rc = stream->seek(0, SEEK_SET);
     VERIFY(rc == 0);
 }
 
-ALWAYS_INLINE void stdout_putch(char*&, char ch)
+// The stream is smuggled through printf_internal() as the buffer pointer, so that
+// the whole format only has to take the stream's lock once.
+ALWAYS_INLINE static void stream_putch(char*& stream, char ch)
 {
-    putchar(ch);
-}
-
-static FILE* __current_stream = nullptr;
-ALWAYS_INLINE static void stream_putch(char*&, char ch)
-{
-    fputc(ch, __current_stream);
+    fputc_unlocked(ch, reinterpret_cast<FILE*>(stream));
 }
 
 int vfprintf(FILE* stream, const char* fmt, va_list ap)
 {
-    __current_stream = stream;
-    return printf_internal(stream_putch, nullptr, fmt, ap);
+    VERIFY(stream);
+    ScopedFileLock lock(stream);
+    return printf_internal(stream_putch, reinterpret_cast<char*>(stream), fmt, ap);
 }
 
 int fprintf(FILE* stream, const char* fmt, ...)
@@ -869,7 +1035,7 @@ int fprintf(FILE* stream, const char* fmt, ...)
 
 int vprintf(const char* fmt, va_list ap)
 {
-    return printf_internal(stdout_putch, nullptr, fmt, ap);
+    return vfprintf(stdout, fmt, ap);
 }
 
 int printf(const char* fmt, ...)
@@ -1002,6 +1168,7 @@ FILE* freopen(const char* pathname, const char* mode, FILE* stream)
     if (fd < 0)
         return nullptr;
 
+    ScopedFileLock lock(stream);
     stream->reopen(fd, flags);
     return stream;
 }
@@ -1023,7 +1190,9 @@ static inline bool is_default_stream(FILE* stream)
 int fclose(FILE* stream)
 {
     VERIFY(stream);
+    stream->lock();
     bool ok = stream->close();
+    stream->unlock();
     ScopedValueRollback errno_restorer(errno);
 
     stream->~FILE();
@@ -1178,14 +1347,22 @@ int vfscanf(FILE* stream, const char* fmt, va_list ap)
     return vsscanf(buffer, fmt, ap);
 }
 
-void flockfile([[maybe_unused]] FILE* filehandle)
+void flockfile(FILE* filehandle)
+{
+    VERIFY(filehandle);
+    filehandle->lock();
+}
+
+int ftrylockfile(FILE* filehandle)
 {
-    dbgln("FIXME: Implement flockfile()");
+    VERIFY(filehandle);
+    return filehandle->try_lock() ? 0 : -1;
 }
 
-void funlockfile([[maybe_unused]] FILE* filehandle)
+void funlockfile(FILE* filehandle)
 {
-    dbgln("FIXME: Implement funlockfile()");
+    VERIFY(filehandle);
+    filehandle->unlock();
 }
 
 FILE* tmpfile()
@@ -65,11 +65,14 @@ long ftell(FILE*);
 off_t ftello(FILE*);
 char* fgets(char* buffer, int size, FILE*);
 int fputc(int ch, FILE*);
+int fputc_unlocked(int ch, FILE*);
 int fileno(FILE*);
 int fgetc(FILE*);
+int fgetc_unlocked(FILE*);
 int getc(FILE*);
 int getc_unlocked(FILE* stream);
 int getchar();
+int getchar_unlocked();
 ssize_t getdelim(char**, size_t*, int, FILE*);
 ssize_t getline(char**, size_t*, FILE*);
 int ungetc(int c, FILE*);
@@ -78,6 +81,7 @@ FILE* fdopen(int fd, const char* mode);
 FILE* fopen(const char* pathname, const char* mode);
 FILE* freopen(const char* pathname, const char* mode, FILE*);
 void flockfile(FILE* filehandle);
+int ftrylockfile(FILE* filehandle);
 void funlockfile(FILE* filehandle);
 int fclose(FILE*);
 void rewind(FILE*);
@@ -86,7 +90,9 @@ int ferror(FILE*);
 int feof(FILE*);
 int fflush(FILE*);
 size_t fread(void* ptr, size_t size, size_t nmemb, FILE*);
+size_t fread_unlocked(void* ptr, size_t size, size_t nmemb, FILE*);
 size_t fwrite(const void* ptr, size_t size, size_t nmemb, FILE*);
+size_t fwrite_unlocked(const void* ptr, size_t size, size_t nmemb, FILE*);
 int vprintf(const char* fmt, va_list) __attribute__((format(printf, 1, 0)));
 int vfprintf(FILE*, const char* fmt, va_list) __attribute__((format(printf, 2, 0)));
 int vsprintf(char* buffer, const char* fmt, va_list) __attribute__((format(printf, 2, 0)));
@@ -98,9 +104,12 @@ int dbgputstr(const char*, ssize_t);
 int sprintf(char* buffer, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
 int snprintf(char* buffer, size_t, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
 int putchar(int ch);
+int putchar_unlocked(int ch);
 int putc(int ch, FILE*);
+int putc_unlocked(int ch, FILE*);
 int puts(const char*);
 int fputs(const char*, FILE*);
+int fputs_unlocked(const char*, FILE*);
 void perror(const char*);
 int scanf(const char* fmt, ...) __attribute__((format(scanf, 1, 2)));
 int sscanf(const char* str, const char* fmt, ...) __attribute__((format(scanf, 2, 3)));
@@ -36,6 +36,153 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if ARCH(I386)
+#    include <emmintrin.h>
+
+// Userland can't assume SSE2, so we check for it once (CPUID leaf 1, EDX bit 26) and then use
+// SSE2 versions of the hottest mem/str functions if they're available.
+// FIXME: Add AVX2 versions once the kernel enables XSAVE and preserves the upper halves of the YMM registers.
+static bool cpu_has_sse2()
+{
+    static int s_has_sse2 = -1;
+    if (s_has_sse2 < 0) {
+        u32 eax, ebx, ecx, edx;
+        asm volatile("cpuid"
+                     : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+                     : "a"(1), "c"(0));
+        s_has_sse2 = (edx >> 26) & 1;
+    }
+    return s_has_sse2;
+}
+
+// Below this size, setting up the vector loop costs more than it gains.
+static constexpr size_t sse2_threshold = 64;
+// Copies and fills bigger than this would only evict everything else from the cache.
+static constexpr size_t non_temporal_threshold = 1 * MiB;
+
+[[gnu::target("sse2")]] static void* memcpy_sse2(void* dest_ptr, const void* src_ptr, size_t n)
+{
+    auto* dest = (u8*)dest_ptr;
+    auto* src = (const u8*)src_ptr;
+
+    // Align the destination to 16 bytes, so that all stores are aligned.
+    size_t head = (16 - ((FlatPtr)dest & 15)) & 15;
+    n -= head;
+    asm volatile(
+        "rep movsb"
+        : "+D"(dest), "+S"(src), "+c"(head)::"memory");
+
+    size_t blocks = n / 64;
+    bool use_non_temporal_stores = n >= non_temporal_threshold;
+    for (size_t i = 0; i < blocks; ++i) {
+        __m128i a = _mm_loadu_si128((const __m128i*)src);
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + 16));
+        __m128i c = _mm_loadu_si128((const __m128i*)(src + 32));
+        __m128i d = _mm_loadu_si128((const __m128i*)(src + 48));
+        if (use_non_temporal_stores) {
+            _mm_stream_si128((__m128i*)dest, a);
+            _mm_stream_si128((__m128i*)(dest + 16), b);
+            _mm_stream_si128((__m128i*)(dest + 32), c);
+            _mm_stream_si128((__m128i*)(dest + 48), d);
+        } else {
+            _mm_store_si128((__m128i*)dest, a);
+            _mm_store_si128((__m128i*)(dest + 16), b);
+            _mm_store_si128((__m128i*)(dest + 32), c);
+            _mm_store_si128((__m128i*)(dest + 48), d);
+        }
+        src += 64;
+        dest += 64;
+    }
+    if (use_non_temporal_stores)
+        _mm_sfence();
+
+    n -= blocks * 64;
+    asm volatile(
+        "rep movsb"
+        : "+D"(dest), "+S"(src), "+c"(n)::"memory");
+    return dest_ptr;
+}
+
+[[gnu::target("sse2")]] static void* memset_sse2(void* dest_ptr, int c, size_t n)
+{
+    auto* dest = (u8*)dest_ptr;
+
+    size_t head = (16 - ((FlatPtr)dest & 15)) & 15;
+    n -= head;
+    asm volatile(
+        "rep stosb"
+        : "+D"(dest), "+c"(head)
+        : "a"(c)
+        : "memory");
+
+    __m128i value = _mm_set1_epi8((char)c);
+    size_t blocks = n / 64;
+    bool use_non_temporal_stores = n >= non_temporal_threshold;
+    for (size_t i = 0; i < blocks; ++i) {
+        if (use_non_temporal_stores) {
+            _mm_stream_si128((__m128i*)dest, value);
+            _mm_stream_si128((__m128i*)(dest + 16), value);
+            _mm_stream_si128((__m128i*)(dest + 32), value);
+            _mm_stream_si128((__m128i*)(dest + 48), value);
+        } else {
+            _mm_store_si128((__m128i*)dest, value);
+            _mm_store_si128((__m128i*)(dest + 16), value);
+            _mm_store_si128((__m128i*)(dest + 32), value);
+            _mm_store_si128((__m128i*)(dest + 48), value);
+        }
+        dest += 64;
+    }
+    if (use_non_temporal_stores)
+        _mm_sfence();
+
+    n -= blocks * 64;
+    asm volatile(
+        "rep stosb"
+        : "+D"(dest), "+c"(n)
+        : "a"(c)
+        : "memory");
+    return dest_ptr;
+}
+
+// The string functions below only ever load whole aligned 16-byte blocks. Such a block never
+// crosses a page boundary, so reading bytes past the end of the string (or before its start)
+// can't fault if the string's own bytes can be read.
+
+[[gnu::target("sse2")]] static size_t strlen_sse2(const char* str)
+{
+    const __m128i zero = _mm_setzero_si128();
+    auto* block = (const char*)((FlatPtr)str & ~15);
+    u32 mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((const __m128i*)block), zero));
+    // Ignore whatever comes before the start of the string.
+    mask &= 0xffffu << ((FlatPtr)str & 15);
+    while (!mask) {
+        block += 16;
+        mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((const __m128i*)block), zero));
+    }
+    return block + __builtin_ctz(mask) - str;
+}
+
+[[gnu::target("sse2")]] static void* memchr_sse2(const void* ptr, int c, size_t size)
+{
+    auto* start = (const u8*)ptr;
+    auto* end = start + size;
+    const __m128i needle = _mm_set1_epi8((char)c);
+    auto* block = (const u8*)((FlatPtr)start & ~15);
+    u32 mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((const __m128i*)block), needle));
+    mask &= 0xffffu << ((FlatPtr)start & 15);
+    for (;;) {
+        if (mask) {
+            auto* found = block + __builtin_ctz(mask);
+            return found < end ? const_cast<u8*>(found) : nullptr;
+        }
+        block += 16;
+        if (block >= end)
+            return nullptr;
+        mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((const __m128i*)block), needle));
+    }
+}
+#endif
+
 extern "C" {
 
 size_t strspn(const char* s, const char* accept)
@@ -66,6 +213,10 @@ size_t strcspn(const char* s, const char* reject)
 
 size_t strlen(const char* str)
 {
+#if ARCH(I386)
+    if (cpu_has_sse2())
+        return strlen_sse2(str);
+#endif
     size_t len = 0;
     while (*(str++))
         ++len;
@@ -133,6 +284,8 @@ int memcmp(const void* v1, const void* v2, size_t n)
 #if ARCH(I386)
 void* memcpy(void* dest_ptr, const void* src_ptr, size_t n)
 {
+    if (n >= sse2_threshold && cpu_has_sse2())
+        return memcpy_sse2(dest_ptr, src_ptr, n);
     void* original_dest = dest_ptr;
     asm volatile(
         "rep movsb"
@@ -142,6 +295,8 @@ void* memcpy(void* dest_ptr, const void* src_ptr, size_t n)
 
 void* memset(void* dest_ptr, int c, size_t n)
 {
+    if (n >= sse2_threshold && cpu_has_sse2())
+        return memset_sse2(dest_ptr, c, n);
     void* original_dest = dest_ptr;
     asm volatile(
         "rep stosb\n"
@@ -171,7 +326,7 @@ void* memset(void* dest_ptr, int c, size_t n)
 
 void* memmove(void* dest, const void* src, size_t n)
 {
-    if (dest < src)
+    if (dest < src || (const u8*)dest >= (const u8*)src + n)
         return memcpy(dest, src, n);
 
     u8* pd = (u8*)dest;
@@ -239,6 +394,10 @@ char* strchrnul(const char* str, int c)
 
 void* memchr(const void* ptr, int c, size_t size)
 {
+#if ARCH(I386)
+    if (size && cpu_has_sse2())
+        return memchr_sse2(ptr, c, size);
+#endif
     char ch = c;
     auto* cptr = (const char*)ptr;
     for (size_t i = 0; i < size; ++i) {
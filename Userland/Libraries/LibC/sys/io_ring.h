@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/cdefs.h>
+#include <time.h>
+
+__BEGIN_DECLS
+
+#define IO_RING_OP_NOP 0
+#define IO_RING_OP_READ 1
+#define IO_RING_OP_WRITE 2
+#define IO_RING_OP_ACCEPT 3
+#define IO_RING_OP_RECV 4
+#define IO_RING_OP_SEND 5
+#define IO_RING_OP_FSYNC 6
+
+#define IO_RING_CLOEXEC O_CLOEXEC
+#define IO_RING_MAX_ENTRIES 4096
+#define IO_RING_CURRENT_OFFSET ((uint64_t)-1)
+
+struct io_ring_sqe {
+    uint8_t opcode;
+    uint8_t reserved[3];
+    int32_t fd;
+    uint64_t offset;
+    uint64_t addr;
+    uint32_t len;
+    uint32_t msg_flags;
+    uint64_t user_data;
+};
+
+struct io_ring_cqe {
+    uint64_t user_data;
+    int32_t result;
+    uint32_t reserved;
+};
+
+struct io_ring_header {
+    uint32_t sq_head;
+    uint32_t sq_tail;
+    uint32_t sq_mask;
+    uint32_t cq_head;
+    uint32_t cq_tail;
+    uint32_t cq_mask;
+};
+
+struct io_ring_params {
+    uint32_t sq_entries;
+    uint32_t cq_entries;
+    uint32_t sqes_offset;
+    uint32_t cqes_offset;
+    uint32_t ring_size;
+};
+
+int io_ring_create(unsigned entries, struct io_ring_params* params, int flags);
+int io_ring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, const struct timespec* timeout);
+
+__END_DECLS
@@ -68,7 +68,9 @@ enum IOCtlNumber {
     SIOCSIFNETMASK,
     SIOCADDRT,
     SIOCDELRT,
-    FIBMAP
+    FIBMAP,
+    SOUNDCARD_IOCTL_GET_QUEUED_BYTES,
+    SOUNDCARD_IOCTL_SET_QUEUE_LIMIT
 };
 
 #define TIOCGPGRP TIOCGPGRP
@@ -94,3 +96,5 @@ enum IOCtlNumber {
 #define SIOCADDRT SIOCADDRT
 #define SIOCDELRT SIOCDELRT
 #define FIBMAP FIBMAP
+#define SOUNDCARD_IOCTL_GET_QUEUED_BYTES SOUNDCARD_IOCTL_GET_QUEUED_BYTES
+#define SOUNDCARD_IOCTL_SET_QUEUE_LIMIT SOUNDCARD_IOCTL_SET_QUEUE_LIMIT
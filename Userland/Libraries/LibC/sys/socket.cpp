@@ -76,6 +76,13 @@ ssize_t sendmsg(int sockfd, const struct msghdr* msg, int flags)
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
+int sendmmsg(int sockfd, struct mmsghdr* msgvec, unsigned vlen, int flags)
+{
+    Syscall::SC_sendmmsg_params params { sockfd, msgvec, vlen, flags };
+    int rc = syscall(SC_sendmmsg, &params);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
 ssize_t sendto(int sockfd, const void* data, size_t data_length, int flags, const struct sockaddr* addr, socklen_t addr_length)
 {
     iovec iov = { const_cast<void*>(data), data_length };
@@ -94,6 +101,13 @@ ssize_t recvmsg(int sockfd, struct msghdr* msg, int flags)
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
+int recvmmsg(int sockfd, struct mmsghdr* msgvec, unsigned vlen, int flags, struct timespec* timeout)
+{
+    Syscall::SC_recvmmsg_params params { sockfd, msgvec, vlen, flags, timeout };
+    int rc = syscall(SC_recvmmsg, &params);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
 ssize_t recvfrom(int sockfd, void* buffer, size_t buffer_length, int flags, struct sockaddr* addr, socklen_t* addr_length)
 {
     if (!addr_length && addr) {
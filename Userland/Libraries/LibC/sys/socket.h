@@ -64,6 +64,7 @@ __BEGIN_DECLS
 #define MSG_TRUNC 0x1
 #define MSG_CTRUNC 0x2
 #define MSG_DONTWAIT 0x40
+#define MSG_WAITFORONE 0x10000
 
 typedef uint16_t sa_family_t;
 
@@ -83,6 +84,11 @@ struct msghdr {
     int msg_flags;
 };
 
+struct mmsghdr {
+    struct msghdr msg_hdr;
+    unsigned int msg_len;
+};
+
 struct sockaddr {
     sa_family_t sa_family;
     char sa_data[14];
@@ -139,6 +145,8 @@ struct sockaddr_storage {
     };
 };
 
+struct timespec;
+
 int socket(int domain, int type, int protocol);
 int bind(int sockfd, const struct sockaddr* addr, socklen_t);
 int listen(int sockfd, int backlog);
@@ -147,9 +155,11 @@ int connect(int sockfd, const struct sockaddr*, socklen_t);
 int shutdown(int sockfd, int how);
 ssize_t send(int sockfd, const void*, size_t, int flags);
 ssize_t sendmsg(int sockfd, const struct msghdr*, int flags);
+int sendmmsg(int sockfd, struct mmsghdr*, unsigned vlen, int flags);
 ssize_t sendto(int sockfd, const void*, size_t, int flags, const struct sockaddr*, socklen_t);
 ssize_t recv(int sockfd, void*, size_t, int flags);
 ssize_t recvmsg(int sockfd, struct msghdr*, int flags);
+int recvmmsg(int sockfd, struct mmsghdr*, unsigned vlen, int flags, struct timespec* timeout);
 ssize_t recvfrom(int sockfd, void*, size_t, int flags, struct sockaddr*, socklen_t*);
 int getsockopt(int sockfd, int level, int option, void*, socklen_t*);
 int setsockopt(int sockfd, int level, int option, const void*, socklen_t);
@@ -24,20 +24,47 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Atomic.h>
 #include <AK/String.h>
 #include <AK/StringBuilder.h>
 #include <AK/Time.h>
+#include <Kernel/API/TimePage.h>
+#include <LibELF/AuxiliaryVector.h>
 #include <assert.h>
 #include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/internals.h>
 #include <sys/time.h>
 #include <sys/times.h>
 #include <syscall.h>
 #include <time.h>
 
+static const Kernel::TimePage* s_time_page;
+
+static bool read_time_page(clockid_t clock_id, struct timespec* ts)
+{
+    if (!s_time_page || !Kernel::time_page_supports(clock_id))
+        return false;
+    u32 update_iteration;
+    do {
+        update_iteration = AK::atomic_load(&s_time_page->update1, AK::MemoryOrder::memory_order_acquire);
+        *ts = s_time_page->clocks[clock_id];
+    } while (update_iteration != AK::atomic_load(&s_time_page->update2, AK::MemoryOrder::memory_order_acquire));
+    return true;
+}
+
 extern "C" {
 
+void __time_init()
+{
+    // NOTE: This has to happen before main(), since getauxval() finds the auxiliary
+    //       vector by walking past the end of the original environment.
+    s_time_page = (const Kernel::TimePage*)getauxval(AT_TIME_PAGE);
+    errno = 0;
+}
+
 time_t time(time_t* tloc)
 {
     struct timeval tv;
@@ -57,6 +84,11 @@ int adjtime(const struct timeval* delta, struct timeval* old_delta)
 
 int gettimeofday(struct timeval* __restrict__ tv, void* __restrict__)
 {
+    timespec ts;
+    if (read_time_page(CLOCK_REALTIME, &ts)) {
+        timespec_to_timeval(ts, *tv);
+        return 0;
+    }
     int rc = syscall(SC_gettimeofday, tv);
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
@@ -347,6 +379,8 @@ clock_t clock()
 
 int clock_gettime(clockid_t clock_id, struct timespec* ts)
 {
+    if (read_time_page(clock_id, ts))
+        return 0;
     int rc = syscall(SC_clock_gettime, clock_id, ts);
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
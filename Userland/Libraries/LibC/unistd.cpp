@@ -624,7 +624,7 @@ char* getlogin()
 {
     if (getlogin_buffer.is_null()) {
         if (auto* passwd = getpwuid(getuid())) {
-            getlogin_buffer = String(passwd->pw_name);
+            getlogin_buffer = String(passwd->pw_name).isolated_copy();
         }
         endpwent();
     }
@@ -764,6 +764,13 @@ int unveil(const char* path, const char* permissions)
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
+ssize_t copy_file_range(int in_fd, off_t* in_offset, int out_fd, off_t* out_offset, size_t count, unsigned flags)
+{
+    Syscall::SC_copy_file_range_params params { in_fd, in_offset, out_fd, out_offset, count, flags };
+    int rc = syscall(SC_copy_file_range, &params);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
 ssize_t pread(int fd, void* buf, size_t count, off_t offset)
 {
     // FIXME: This is not thread safe and should be implemented in the kernel instead.
@@ -774,6 +781,16 @@ ssize_t pread(int fd, void* buf, size_t count, off_t offset)
     return nread;
 }
 
+ssize_t pwrite(int fd, const void* buf, size_t count, off_t offset)
+{
+    // FIXME: This is not thread safe and should be implemented in the kernel instead.
+    off_t old_offset = lseek(fd, 0, SEEK_CUR);
+    lseek(fd, offset, SEEK_SET);
+    ssize_t nwritten = write(fd, buf, count);
+    lseek(fd, old_offset, SEEK_SET);
+    return nwritten;
+}
+
 char* getpass(const char* prompt)
 {
     dbgln("FIXME: getpass('{}')", prompt);
@@ -100,6 +100,8 @@ int tcsetpgrp(int fd, pid_t pgid);
 ssize_t read(int fd, void* buf, size_t count);
 ssize_t pread(int fd, void* buf, size_t count, off_t);
 ssize_t write(int fd, const void* buf, size_t count);
+ssize_t pwrite(int fd, const void* buf, size_t count, off_t);
+ssize_t copy_file_range(int in_fd, off_t* in_offset, int out_fd, off_t* out_offset, size_t count, unsigned flags);
 int close(int fd);
 int chdir(const char* path);
 int fchdir(int fd);
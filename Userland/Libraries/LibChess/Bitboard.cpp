@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Assertions.h>
+#include <LibChess/Bitboard.h>
+
+namespace Chess {
+
+// Sliding piece attacks are looked up with "fancy" magic bitboards: only the squares between a
+// piece and the edge of the board (the relevant occupancy) can change its attacks, and multiplying
+// them by a magic number packs them into a dense index into that square's part of the table.
+
+struct Magic {
+    Bitboard mask { 0 };
+    u64 magic { 0 };
+    unsigned shift { 0 };
+    Bitboard* attacks { nullptr };
+
+    size_t index(Bitboard occupied) const { return ((occupied & mask) * magic) >> shift; }
+};
+
+struct Direction {
+    int rank_delta;
+    int file_delta;
+};
+
+static constexpr Direction bishop_directions[] = { { 1, 1 }, { 1, -1 }, { -1, 1 }, { -1, -1 } };
+static constexpr Direction rook_directions[] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+
+// Table sizes are the sums of 2^(relevant occupancy squares) over all squares.
+static constexpr size_t bishop_table_size = 5248;
+static constexpr size_t rook_table_size = 102400;
+
+static Bitboard step_attacks(unsigned square_index, const Direction* directions, size_t direction_count)
+{
+    Bitboard attacks = 0;
+    int rank = square_index / 8;
+    int file = square_index % 8;
+    for (size_t i = 0; i < direction_count; ++i) {
+        int to_rank = rank + directions[i].rank_delta;
+        int to_file = file + directions[i].file_delta;
+        if (to_rank >= 0 && to_rank < 8 && to_file >= 0 && to_file < 8)
+            attacks |= bitboard_for_square(to_rank * 8 + to_file);
+    }
+    return attacks;
+}
+
+static Bitboard sliding_attacks(unsigned square_index, Bitboard occupied, const Direction (&directions)[4])
+{
+    Bitboard attacks = 0;
+    for (auto& direction : directions) {
+        int rank = square_index / 8 + direction.rank_delta;
+        int file = square_index % 8 + direction.file_delta;
+        for (; rank >= 0 && rank < 8 && file >= 0 && file < 8; rank += direction.rank_delta, file += direction.file_delta) {
+            auto square = bitboard_for_square(rank * 8 + file);
+            attacks |= square;
+            if (occupied & square)
+                break;
+        }
+    }
+    return attacks;
+}
+
+// Magic numbers that map every relevant occupancy of a square to an index without destructive collisions.
+// They were found by trying sparse random numbers until one worked for each square.
+static constexpr u64 bishop_magic_numbers[64] = {
+    0x10102002004a1420ull, 0x8020040400584008ull, 0x10510800811201c8ull, 0x5204042080000088ull,
+    0x2204106880000002ull, 0x1401042004000000ull, 0x400880410042004ull, 0x28208200a02020ull,
+    0x1500241990010e00ull, 0x8001200182020a40ull, 0x40004101030b0000ull, 0x8002041042000100ull,
+    0x4010011041020038ull, 0x10421044000ull, 0x1500210808020a00ull, 0x8000088400880520ull,
+    0x405004010040100ull, 0x1005823210040108ull, 0x2708008102040011ull, 0x4048200404009100ull,
+    0x18104101400024ull, 0x3000601190101ull, 0x8004803108491000ull, 0x8014241200820800ull,
+    0x6e080100c3040ull, 0x501044a11041800ull, 0x9020300008004045ull, 0x894080000220040ull,
+    0x1001010083104000ull, 0x5004030040900080ull, 0x400422c012400ull, 0x2128698404812ull,
+    0x1010108404900440ull, 0x928021182084100ull, 0x2006080409020024ull, 0x1010202020180080ull,
+    0xa010008200202200ull, 0x2098015100019004ull, 0x2041440810811ull, 0x802a02020000b098ull,
+    0x9015090004060ull, 0x4000821082081001ull, 0x100210040420800ull, 0x800004010488a00ull,
+    0x2000081104004040ull, 0x4c8e029015000082ull, 0x420340322224842ull, 0x1298260043400210ull,
+    0x822802400008ull, 0x8a0101600000ull, 0x3040003412080021ull, 0x3040290220884800ull,
+    0x4a1500401041004aull, 0x8010200282020781ull, 0x20203142209091ull, 0x70300600902110ull,
+    0x40808800b62048ull, 0x810400c44420ull, 0x80400440c0441ull, 0x8340080020840411ull,
+    0x104208200ull, 0x800810d00080ull, 0x400530411080200ull, 0x4040702400932244ull,
+};
+
+static constexpr u64 rook_magic_numbers[64] = {
+    0x1080004008801020ull, 0x840092002c03000ull, 0x1900200010400900ull, 0x880100008000480ull,
+    0x4200100420080200ull, 0x8100020100080400ull, 0x200040110886200ull, 0x200008040220411ull,
+    0x404800084400220ull, 0x401000402000ull, 0x86001081220440ull, 0x408800800100280ull,
+    0xa001201040820ull, 0x8848800200840080ull, 0x4001000100040200ull, 0x442000102105084ull,
+    0x9080010020804100ull, 0x40404000201009ull, 0x808010002009ull, 0x2200090021d00100ull,
+    0x8008008040080ull, 0x4004002010040ull, 0x11040008015042ull, 0xa0001768104ull,
+    0x800080204009ull, 0x2010004140002001ull, 0x9800200280100080ull, 0x1000100080080080ull,
+    0x442000a00049020ull, 0x2100040080020080ull, 0x800120400900148ull, 0x10040a00128541ull,
+    0x2800804000800030ull, 0x1010002000400041ull, 0x4000200011004100ull, 0x610008410800800ull,
+    0x400802402800800ull, 0xc100020080800400ull, 0x2000802000401ull, 0x182085882000401ull,
+    0x220204000808000ull, 0x2860100040024022ull, 0x1002004110040ull, 0x99101042000a0020ull,
+    0x4080004008080ull, 0x10040002008080ull, 0x2012004881020004ull, 0x8300842444820011ull,
+    0x88403882010200ull, 0x820400080210100ull, 0x110910040a00300ull, 0x801100280080480ull,
+    0x242009008200600ull, 0x1002000489500200ull, 0x40800200010080ull, 0x91800041000080ull,
+    0x209300488001ull, 0x4c1002414824001ull, 0x20020000b001041ull, 0x7000100004200901ull,
+    0x8002002004100802ull, 0x30010002084c0007ull, 0x888221800813004ull, 0x4000002840840112ull,
+};
+
+class AttackTables {
+public:
+    AttackTables()
+    {
+        static constexpr Direction knight_steps[] = { { 2, 1 }, { 2, -1 }, { 1, 2 }, { 1, -2 }, { -1, 2 }, { -1, -2 }, { -2, 1 }, { -2, -1 } };
+        static constexpr Direction king_steps[] = { { 1, 1 }, { 1, 0 }, { 1, -1 }, { 0, 1 }, { 0, -1 }, { -1, 1 }, { -1, 0 }, { -1, -1 } };
+        for (unsigned square = 0; square < 64; ++square) {
+            m_knight_attacks[square] = step_attacks(square, knight_steps, 8);
+            m_king_attacks[square] = step_attacks(square, king_steps, 8);
+        }
+        fill_magic_table(m_bishop_magics, m_bishop_attacks, bishop_directions, bishop_magic_numbers);
+        fill_magic_table(m_rook_magics, m_rook_attacks, rook_directions, rook_magic_numbers);
+    }
+
+    Bitboard knight_attacks(unsigned square) const { return m_knight_attacks[square]; }
+    Bitboard king_attacks(unsigned square) const { return m_king_attacks[square]; }
+    Bitboard bishop_attacks(unsigned square, Bitboard occupied) const { return m_bishop_magics[square].attacks[m_bishop_magics[square].index(occupied)]; }
+    Bitboard rook_attacks(unsigned square, Bitboard occupied) const { return m_rook_magics[square].attacks[m_rook_magics[square].index(occupied)]; }
+
+private:
+    template<size_t table_size>
+    static void fill_magic_table(Magic (&magics)[64], Bitboard (&table)[table_size], const Direction (&directions)[4], const u64 (&magic_numbers)[64])
+    {
+        size_t table_offset = 0;
+        for (unsigned square = 0; square < 64; ++square) {
+            // Pieces on the edge of the board never block anything, unless the slider is on that edge itself.
+            Bitboard edges = ((rank_1_bitboard | rank_8_bitboard) & ~(rank_1_bitboard << (8 * (square / 8))))
+                | ((file_a_bitboard | file_h_bitboard) & ~(file_a_bitboard << (square % 8)));
+
+            auto& magic = magics[square];
+            magic.mask = sliding_attacks(square, 0, directions) & ~edges;
+            magic.magic = magic_numbers[square];
+            magic.shift = 64 - square_count(magic.mask);
+            magic.attacks = &table[table_offset];
+            table_offset += size_t(1) << square_count(magic.mask);
+            VERIFY(table_offset <= table_size);
+
+            // Walk all subsets of the mask with the Carry-Rippler trick.
+            Bitboard occupied = 0;
+            do {
+                auto attacks = sliding_attacks(square, occupied, directions);
+                auto& entry = magic.attacks[magic.index(occupied)];
+                // No attack set is empty, so an empty entry hasn't been filled in yet.
+                VERIFY(!entry || entry == attacks);
+                entry = attacks;
+                occupied = (occupied - magic.mask) & magic.mask;
+            } while (occupied);
+        }
+        VERIFY(table_offset == table_size);
+    }
+
+    Bitboard m_knight_attacks[64];
+    Bitboard m_king_attacks[64];
+    Magic m_bishop_magics[64];
+    Magic m_rook_magics[64];
+    Bitboard m_bishop_attacks[bishop_table_size] {};
+    Bitboard m_rook_attacks[rook_table_size] {};
+};
+
+static const AttackTables& attack_tables()
+{
+    // Built on first use, which is thread-safe.
+    static AttackTables* s_tables = new AttackTables;
+    return *s_tables;
+}
+
+Bitboard knight_attacks(unsigned square_index)
+{
+    return attack_tables().knight_attacks(square_index);
+}
+
+Bitboard king_attacks(unsigned square_index)
+{
+    return attack_tables().king_attacks(square_index);
+}
+
+Bitboard bishop_attacks(unsigned square_index, Bitboard occupied)
+{
+    return attack_tables().bishop_attacks(square_index, occupied);
+}
+
+Bitboard rook_attacks(unsigned square_index, Bitboard occupied)
+{
+    return attack_tables().rook_attacks(square_index, occupied);
+}
+
+}
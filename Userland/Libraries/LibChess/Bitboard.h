@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+
+namespace Chess {
+
+// One bit per square, bit (rank * 8 + file) stands for the square at that rank and file.
+using Bitboard = u64;
+
+constexpr Bitboard bitboard_for_square(unsigned square_index) { return Bitboard(1) << square_index; }
+
+// Removes the lowest set bit from the bitboard and returns its square index.
+inline unsigned pop_lowest_square(Bitboard& bitboard)
+{
+    unsigned square_index = __builtin_ctzll(bitboard);
+    bitboard &= bitboard - 1;
+    return square_index;
+}
+
+inline unsigned square_count(Bitboard bitboard) { return __builtin_popcountll(bitboard); }
+
+constexpr Bitboard file_a_bitboard = 0x0101010101010101ull;
+constexpr Bitboard file_h_bitboard = file_a_bitboard << 7;
+constexpr Bitboard rank_1_bitboard = 0xffull;
+constexpr Bitboard rank_8_bitboard = rank_1_bitboard << 56;
+
+constexpr Bitboard shift_north(Bitboard bitboard) { return bitboard << 8; }
+constexpr Bitboard shift_south(Bitboard bitboard) { return bitboard >> 8; }
+constexpr Bitboard shift_east(Bitboard bitboard) { return (bitboard & ~file_h_bitboard) << 1; }
+constexpr Bitboard shift_west(Bitboard bitboard) { return (bitboard & ~file_a_bitboard) >> 1; }
+
+// The squares that a piece standing on the given square attacks. Sliding pieces are stopped by
+// the first occupied square in every direction, which is included in the result.
+Bitboard knight_attacks(unsigned square_index);
+Bitboard king_attacks(unsigned square_index);
+Bitboard bishop_attacks(unsigned square_index, Bitboard occupied);
+Bitboard rook_attacks(unsigned square_index, Bitboard occupied);
+inline Bitboard queen_attacks(unsigned square_index, Bitboard occupied) { return bishop_attacks(square_index, occupied) | rook_attacks(square_index, occupied); }
+
+}
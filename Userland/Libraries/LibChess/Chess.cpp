@@ -358,6 +358,16 @@ Piece Board::set_piece(const Square& square, const Piece& piece)
 {
     VERIFY(square.rank < 8);
     VERIFY(square.file < 8);
+    auto square_bitboard = bitboard_for_square(square.index());
+    auto& old_piece = m_board[square.rank][square.file];
+    if (old_piece.color != Color::None) {
+        m_pieces[static_cast<int>(old_piece.color)][static_cast<int>(old_piece.type)] &= ~square_bitboard;
+        m_occupied[static_cast<int>(old_piece.color)] &= ~square_bitboard;
+    }
+    if (piece.color != Color::None) {
+        m_pieces[static_cast<int>(piece.color)][static_cast<int>(piece.type)] |= square_bitboard;
+        m_occupied[static_cast<int>(piece.color)] |= square_bitboard;
+    }
     return m_board[square.rank][square.file] = piece;
 }
 
@@ -401,35 +411,175 @@ bool Board::is_legal(const Move& move, Color color) const
     if (!is_legal_promotion(move, color))
         return false;
 
-    Board clone = *this;
-    clone.apply_illegal_move(move, color);
-    if (clone.in_check(color))
+    if (is_castling_move(move, color)) {
+        // Don't allow castling through check or out of check.
+        unsigned back_rank = (color == Color::White) ? 0 : 7;
+        if (move.to.file < 4)
+            return can_castle_through(color, Bitboard(0b00011100) << (8 * back_rank));
+        return can_castle_through(color, Bitboard(0b01110000) << (8 * back_rank));
+    }
+
+    return !leaves_king_in_check(move, color);
+}
+
+bool Board::is_castling_move(const Move& move, Color color) const
+{
+    Square king_square = (color == Color::White) ? Square(0, 4) : Square(7, 4);
+    if (move.from != king_square || get_piece(king_square) != Piece(color, Type::King))
         return false;
+    return move.to.rank == king_square.rank && (move.to.file <= 2 || move.to.file >= 6);
+}
 
-    // Don't allow castling through check or out of check.
-    Vector<Square> check_squares;
-    if (color == Color::White && move.from == Square("e1") && get_piece(Square("e1")) == Piece(Color::White, Type::King)) {
-        if (move.to == Square("a1") || move.to == Square("c1")) {
-            check_squares = { Square("e1"), Square("d1"), Square("c1") };
-        } else if (move.to == Square("h1") || move.to == Square("g1")) {
-            check_squares = { Square("e1"), Square("f1"), Square("g1") };
+bool Board::can_castle_through(Color color, Bitboard squares) const
+{
+    // The king doesn't shield the squares it moves through.
+    auto occupied_without_king = occupied() & ~pieces(color, Type::King);
+    while (squares) {
+        if (is_attacked(pop_lowest_square(squares), opposing_color(color), occupied_without_king))
+            return false;
+    }
+    return true;
+}
+
+bool Board::is_attacked(unsigned square_index, Color by, Bitboard occupied, Bitboard ignored) const
+{
+    auto attackers = [&](Type type) { return pieces(by, type) & ~ignored; };
+
+    if (knight_attacks(square_index) & attackers(Type::Knight))
+        return true;
+    if (king_attacks(square_index) & attackers(Type::King))
+        return true;
+
+    // Pawns attacking the square stand diagonally behind it, as seen from their side.
+    auto square = bitboard_for_square(square_index);
+    auto pawn_rank = (by == Color::White) ? shift_south(square) : shift_north(square);
+    if ((shift_east(pawn_rank) | shift_west(pawn_rank)) & attackers(Type::Pawn))
+        return true;
+
+    auto queens = attackers(Type::Queen);
+    if (bishop_attacks(square_index, occupied) & (attackers(Type::Bishop) | queens))
+        return true;
+    if (rook_attacks(square_index, occupied) & (attackers(Type::Rook) | queens))
+        return true;
+    return false;
+}
+
+bool Board::leaves_king_in_check(const Move& move, Color color) const
+{
+    auto piece = get_piece(move.from);
+    auto from = bitboard_for_square(move.from.index());
+    auto to = bitboard_for_square(move.to.index());
+
+    auto captured = to & pieces(opposing_color(color));
+    if (piece.type == Type::Pawn && move.from.file != move.to.file && !captured) {
+        // En passant, the captured pawn is next to ours.
+        captured = bitboard_for_square(Square(move.from.rank, move.to.file).index());
+    }
+
+    auto king = pieces(color, Type::King);
+    if (piece.type == Type::King)
+        king = to;
+    if (!king)
+        return false;
+
+    auto occupied_after_move = (occupied() & ~from & ~captured) | to;
+    return is_attacked(pop_lowest_square(king), opposing_color(color), occupied_after_move, captured);
+}
+
+Vector<Move> Board::legal_moves(Color color) const
+{
+    if (color == Color::None)
+        color = turn();
+
+    Vector<Move> moves;
+    auto try_move = [&](unsigned from, unsigned to, Type promote_to = Type::None) {
+        Move move { Square::from_index(from), Square::from_index(to), promote_to };
+        if (!leaves_king_in_check(move, color))
+            moves.append(move);
+    };
+
+    auto own = pieces(color);
+    auto opponent = pieces(opposing_color(color));
+    auto occupied = own | opponent;
+
+    auto for_each_target = [&](Type type, auto attacks) {
+        auto from_squares = pieces(color, type);
+        while (from_squares) {
+            auto from = pop_lowest_square(from_squares);
+            auto targets = attacks(from) & ~own;
+            while (targets)
+                try_move(from, pop_lowest_square(targets));
         }
-    } else if (color == Color::Black && move.from == Square("e8") && get_piece(Square("e8")) == Piece(Color::Black, Type::King)) {
-        if (move.to == Square("a8") || move.to == Square("c8")) {
-            check_squares = { Square("e8"), Square("d8"), Square("c8") };
-        } else if (move.to == Square("h8") || move.to == Square("g8")) {
-            check_squares = { Square("e8"), Square("f8"), Square("g8") };
+    };
+
+    // Pawns.
+    int direction = (color == Color::White) ? 8 : -8;
+    unsigned start_rank = (color == Color::White) ? 1 : 6;
+    unsigned promotion_rank = (color == Color::White) ? 7 : 0;
+    unsigned en_passant_rank = (color == Color::White) ? 4 : 3;
+    auto try_pawn_move = [&](unsigned from, unsigned to) {
+        if (to / 8 != promotion_rank) {
+            try_move(from, to);
+            return;
         }
+        for (auto type : { Type::Knight, Type::Bishop, Type::Rook, Type::Queen })
+            try_move(from, to, type);
+    };
+
+    // A pawn that just advanced two squares can be taken en passant.
+    Optional<unsigned> en_passant_file;
+    if (m_last_move.has_value()) {
+        auto& last_move = m_last_move.value();
+        unsigned other_start_rank = (color == Color::White) ? 6 : 1;
+        if (last_move.from == Square(other_start_rank, last_move.to.file) && last_move.to == Square(en_passant_rank, last_move.to.file)
+            && get_piece(last_move.to) == Piece(opposing_color(color), Type::Pawn))
+            en_passant_file = last_move.to.file;
     }
-    for (auto& square : check_squares) {
-        Board clone = *this;
-        clone.set_piece(move.from, EmptyPiece);
-        clone.set_piece(square, { color, Type::King });
-        if (clone.in_check(color))
-            return false;
+
+    auto pawns = pieces(color, Type::Pawn);
+    while (pawns) {
+        auto from = pop_lowest_square(pawns);
+        unsigned to = from + direction;
+        if (!(occupied & bitboard_for_square(to))) {
+            try_pawn_move(from, to);
+            unsigned double_step_to = to + direction;
+            if (from / 8 == start_rank && !(occupied & bitboard_for_square(double_step_to)))
+                try_move(from, double_step_to);
+        }
+
+        auto forward = bitboard_for_square(to);
+        auto captures = (shift_east(forward) | shift_west(forward)) & opponent;
+        while (captures)
+            try_pawn_move(from, pop_lowest_square(captures));
+
+        if (en_passant_file.has_value() && from / 8 == en_passant_rank) {
+            unsigned file = from % 8;
+            if (file + 1 == en_passant_file.value() || file == en_passant_file.value() + 1)
+                try_move(from, (from / 8) * 8 + en_passant_file.value() + direction);
+        }
     }
 
-    return true;
+    for_each_target(Type::Knight, [](unsigned from) { return knight_attacks(from); });
+    for_each_target(Type::Bishop, [&](unsigned from) { return bishop_attacks(from, occupied); });
+    for_each_target(Type::Rook, [&](unsigned from) { return rook_attacks(from, occupied); });
+    for_each_target(Type::Queen, [&](unsigned from) { return queen_attacks(from, occupied); });
+    for_each_target(Type::King, [](unsigned from) { return king_attacks(from); });
+
+    // Castling moves.
+    unsigned back_rank_shift = (color == Color::White) ? 0 : 56;
+    Square king_square = Square::from_index(back_rank_shift + 4);
+    if (get_piece(king_square) == Piece(color, Type::King)) {
+        bool can_castle_queenside = (color == Color::White) ? m_white_can_castle_queenside : m_black_can_castle_queenside;
+        bool can_castle_kingside = (color == Color::White) ? m_white_can_castle_kingside : m_black_can_castle_kingside;
+        if (can_castle_queenside && !(occupied & (Bitboard(0b00001110) << back_rank_shift))
+            && can_castle_through(color, Bitboard(0b00011100) << back_rank_shift))
+            moves.append({ king_square, Square::from_index(back_rank_shift + 2) });
+        if (can_castle_kingside && !(occupied & (Bitboard(0b01100000) << back_rank_shift))
+            && can_castle_through(color, Bitboard(0b01110000) << back_rank_shift))
+            moves.append({ king_square, Square::from_index(back_rank_shift + 6) });
+    }
+
+    return moves;
 }
 
 bool Board::is_legal_no_check(const Move& move, Color color) const
@@ -480,8 +630,8 @@ bool Board::is_legal_no_check(const Move& move, Color color) const
 
         return false;
     } else if (piece.type == Type::Knight) {
-        int rank_delta = abs(move.to.rank - move.from.rank);
-        int file_delta = abs(move.to.file - move.from.file);
+        int rank_delta = abs(static_cast<int>(move.to.rank) - static_cast<int>(move.from.rank));
+        int file_delta = abs(static_cast<int>(move.to.file) - static_cast<int>(move.from.file));
         if (get_piece(move.to).color != color && max(rank_delta, file_delta) == 2 && min(rank_delta, file_delta) == 1) {
             return true;
         }
@@ -566,25 +716,10 @@ bool Board::is_legal_no_check(const Move& move, Color color) const
 
 bool Board::in_check(Color color) const
 {
-    Square king_square = { 50, 50 };
-    Square::for_each([&](const Square& square) {
-        if (get_piece(square) == Piece(color, Type::King)) {
-            king_square = square;
-            return IterationDecision::Break;
-        }
-        return IterationDecision::Continue;
-    });
-
-    bool check = false;
-    Square::for_each([&](const Square& square) {
-        if (is_legal_no_check({ square, king_square }, opposing_color(color))) {
-            check = true;
-            return IterationDecision::Break;
-        }
-        return IterationDecision::Continue;
-    });
-
-    return check;
+    auto king = pieces(color, Type::King);
+    if (!king)
+        return false;
+    return is_attacked(pop_lowest_square(king), opposing_color(color), occupied());
 }
 
 bool Board::apply_move(const Move& move, Color color)
@@ -714,16 +849,10 @@ Move Board::random_move(Color color) const
     if (color == Color::None)
         color = turn();
 
-    Move move = { { 50, 50 }, { 50, 50 } };
-    int probability = 1;
-    generate_moves([&](Move m) {
-        if (rand() % probability == 0)
-            move = m;
-        ++probability;
-        return IterationDecision::Continue;
-    });
-
-    return move;
+    auto moves = legal_moves(color);
+    if (moves.is_empty())
+        return { { 50, 50 }, { 50, 50 } };
+    return moves[rand() % moves.size()];
 }
 
 Board::Result Board::game_result() const
@@ -828,35 +957,13 @@ bool Board::game_finished() const
 
 int Board::material_imbalance() const
 {
-    int imbalance = 0;
-    Square::for_each([&](Square square) {
-        int value = 0;
-        switch (get_piece(square).type) {
-        case Type::Pawn:
-            value = 1;
-            break;
-        case Type::Knight:
-        case Type::Bishop:
-            value = 3;
-            break;
-        case Type::Rook:
-            value = 5;
-            break;
-        case Type::Queen:
-            value = 9;
-            break;
-        default:
-            break;
-        }
-
-        if (get_piece(square).color == Color::White) {
-            imbalance += value;
-        } else {
-            imbalance -= value;
-        }
-        return IterationDecision::Continue;
-    });
-    return imbalance;
+    auto material = [&](Color color) {
+        return 1 * square_count(pieces(color, Type::Pawn))
+            + 3 * square_count(pieces(color, Type::Knight) | pieces(color, Type::Bishop))
+            + 5 * square_count(pieces(color, Type::Rook))
+            + 9 * square_count(pieces(color, Type::Queen));
+    };
+    return static_cast<int>(material(Color::White)) - static_cast<int>(material(Color::Black));
 }
 
 bool Board::is_promotion_move(const Move& move, Color color) const
@@ -881,16 +988,12 @@ bool Board::is_promotion_move(const Move& move, Color color) const
 
 bool Board::operator==(const Board& other) const
 {
-    bool equal_squares = true;
-    Square::for_each([&](Square sq) {
-        if (get_piece(sq) != other.get_piece(sq)) {
-            equal_squares = false;
-            return IterationDecision::Break;
+    for (size_t color = 0; color < 2; ++color) {
+        for (size_t type = 0; type < 6; ++type) {
+            if (m_pieces[color][type] != other.m_pieces[color][type])
+                return false;
         }
-        return IterationDecision::Continue;
-    });
-    if (!equal_squares)
-        return false;
+    }
 
     if (m_white_can_castle_queenside != other.m_white_can_castle_queenside)
         return false;
@@ -32,6 +32,7 @@
 #include <AK/StringView.h>
 #include <AK/Traits.h>
 #include <AK/Vector.h>
+#include <LibChess/Bitboard.h>
 
 namespace Chess {
 
@@ -96,6 +97,9 @@ struct Square {
         }
     }
 
+    static Square from_index(unsigned index) { return { index / 8, index % 8 }; }
+    unsigned index() const { return rank * 8 + file; }
+
     bool in_bounds() const { return rank < 8 && file < 8; }
     bool is_light() const { return (rank % 2) != (file % 2); }
     String to_algebraic() const;
@@ -134,6 +138,10 @@ public:
     Piece get_piece(const Square&) const;
     Piece set_piece(const Square&, const Piece&);
 
+    Bitboard pieces(Color color, Type type) const { return m_pieces[static_cast<int>(color)][static_cast<int>(type)]; }
+    Bitboard pieces(Color color) const { return m_occupied[static_cast<int>(color)]; }
+    Bitboard occupied() const { return m_occupied[0] | m_occupied[1]; }
+
     bool is_legal(const Move&, Color color = Color::None) const;
     bool in_check(Color color) const;
 
@@ -162,6 +170,7 @@ public:
 
     template<typename Callback>
     void generate_moves(Callback callback, Color color = Color::None) const;
+    Vector<Move> legal_moves(Color color = Color::None) const;
     Move random_move(Color color = Color::None) const;
     Result game_result() const;
     Color game_winner() const;
@@ -180,7 +189,17 @@ private:
     bool is_legal_promotion(const Move&, Color color) const;
     bool apply_illegal_move(const Move&, Color color);
 
+    // Whether any piece of the given color attacks the square, with the given squares occupied.
+    // Pieces on the ignored squares don't attack anything, they are about to be captured.
+    bool is_attacked(unsigned square_index, Color by, Bitboard occupied, Bitboard ignored = 0) const;
+    bool leaves_king_in_check(const Move&, Color color) const;
+    bool is_castling_move(const Move&, Color color) const;
+    bool can_castle_through(Color color, Bitboard squares) const;
+
     Piece m_board[8][8];
+    // The same position, one bitboard per color and piece type.
+    Bitboard m_pieces[2][6] {};
+    Bitboard m_occupied[2] {};
     Color m_turn { Color::White };
     Color m_resigned { Color::None };
     Optional<Move> m_last_move;
@@ -200,96 +219,10 @@ private:
 template<typename Callback>
 void Board::generate_moves(Callback callback, Color color) const
 {
-    if (color == Color::None)
-        color = turn();
-
-    auto try_move = [&](Move m) {
-        if (is_legal(m, color)) {
-            if (callback(m) == IterationDecision::Break)
-                return false;
-        }
-        return true;
-    };
-
-    Square::for_each([&](Square sq) {
-        auto piece = get_piece(sq);
-        if (piece.color != color)
-            return IterationDecision::Continue;
-
-        bool keep_going = true;
-        if (piece.type == Type::Pawn) {
-            for (auto& piece : Vector({ Type::None, Type::Knight, Type::Bishop, Type::Rook, Type::Queen })) {
-                keep_going = try_move({ sq, { sq.rank + 1, sq.file }, piece })
-                    && try_move({ sq, { sq.rank + 2, sq.file }, piece })
-                    && try_move({ sq, { sq.rank - 1, sq.file }, piece })
-                    && try_move({ sq, { sq.rank - 2, sq.file }, piece })
-                    && try_move({ sq, { sq.rank + 1, sq.file + 1 }, piece })
-                    && try_move({ sq, { sq.rank + 1, sq.file - 1 }, piece })
-                    && try_move({ sq, { sq.rank - 1, sq.file + 1 }, piece })
-                    && try_move({ sq, { sq.rank - 1, sq.file - 1 }, piece });
-            }
-        } else if (piece.type == Type::Knight) {
-            keep_going = try_move({ sq, { sq.rank + 2, sq.file + 1 } })
-                && try_move({ sq, { sq.rank + 2, sq.file - 1 } })
-                && try_move({ sq, { sq.rank + 1, sq.file + 2 } })
-                && try_move({ sq, { sq.rank + 1, sq.file - 2 } })
-                && try_move({ sq, { sq.rank - 2, sq.file + 1 } })
-                && try_move({ sq, { sq.rank - 2, sq.file - 1 } })
-                && try_move({ sq, { sq.rank - 1, sq.file + 2 } })
-                && try_move({ sq, { sq.rank - 1, sq.file - 2 } });
-        } else if (piece.type == Type::Bishop) {
-            for (int dr = -1; dr <= 1; dr += 2) {
-                for (int df = -1; df <= 1; df += 2) {
-                    for (Square to = sq; to.in_bounds(); to = { to.rank + dr, to.file + df }) {
-                        if (!try_move({ sq, to }))
-                            return IterationDecision::Break;
-                    }
-                }
-            }
-        } else if (piece.type == Type::Rook) {
-            for (int dr = -1; dr <= 1; dr++) {
-                for (int df = -1; df <= 1; df++) {
-                    if ((dr == 0) != (df == 0)) {
-                        for (Square to = sq; to.in_bounds(); to = { to.rank + dr, to.file + df }) {
-                            if (!try_move({ sq, to }))
-                                return IterationDecision::Break;
-                        }
-                    }
-                }
-            }
-        } else if (piece.type == Type::Queen) {
-            for (int dr = -1; dr <= 1; dr++) {
-                for (int df = -1; df <= 1; df++) {
-                    if (dr != 0 || df != 0) {
-                        for (Square to = sq; to.in_bounds(); to = { to.rank + dr, to.file + df }) {
-                            if (!try_move({ sq, to }))
-                                return IterationDecision::Break;
-                        }
-                    }
-                }
-            }
-        } else if (piece.type == Type::King) {
-            for (int dr = -1; dr <= 1; dr++) {
-                for (int df = -1; df <= 1; df++) {
-                    if (!try_move({ sq, { sq.rank + dr, sq.file + df } }))
-                        return IterationDecision::Break;
-                }
-            }
-
-            // Castling moves.
-            if (sq == Square("e1")) {
-                keep_going = try_move({ sq, Square("c1") }) && try_move({ sq, Square("g1") });
-            } else if (sq == Square("e8")) {
-                keep_going = try_move({ sq, Square("c8") }) && try_move({ sq, Square("g8") });
-            }
-        }
-
-        if (keep_going) {
-            return IterationDecision::Continue;
-        } else {
-            return IterationDecision::Break;
-        }
-    });
+    for (auto& move : legal_moves(color)) {
+        if (callback(move) == IterationDecision::Break)
+            return;
+    }
 }
 
 }
@@ -304,7 +237,7 @@ struct AK::Traits<Chess::Piece> : public GenericTraits<Chess::Piece> {
 
 template<>
 struct AK::Traits<Chess::Board> : public GenericTraits<Chess::Board> {
-    static unsigned hash(Chess::Board chess)
+    static unsigned hash(const Chess::Board& chess)
     {
         unsigned hash = 0;
         hash = pair_int_hash(hash, static_cast<u32>(chess.m_white_can_castle_queenside));
@@ -312,12 +245,10 @@ struct AK::Traits<Chess::Board> : public GenericTraits<Chess::Board> {
         hash = pair_int_hash(hash, static_cast<u32>(chess.m_black_can_castle_queenside));
         hash = pair_int_hash(hash, static_cast<u32>(chess.m_black_can_castle_kingside));
 
-        hash = pair_int_hash(hash, static_cast<u32>(chess.m_black_can_castle_kingside));
-
-        Chess::Square::for_each([&](Chess::Square sq) {
-            hash = pair_int_hash(hash, Traits<Chess::Piece>::hash(chess.get_piece(sq)));
-            return IterationDecision::Continue;
-        });
+        for (auto& bitboards : chess.m_pieces) {
+            for (auto bitboard : bitboards)
+                hash = pair_int_hash(hash, u64_hash(bitboard));
+        }
 
         return hash;
     }
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/TestSuite.h>
+
+#include <LibChess/Chess.h>
+#include <LibCore/ElapsedTimer.h>
+#include <stdlib.h>
+
+static size_t perft(const Chess::Board& board, int depth)
+{
+    if (depth == 0)
+        return 1;
+    auto moves = board.legal_moves();
+    if (depth == 1)
+        return moves.size();
+    size_t nodes = 0;
+    for (auto& move : moves) {
+        Chess::Board clone = board;
+        VERIFY(clone.apply_move(move));
+        nodes += perft(clone, depth - 1);
+    }
+    return nodes;
+}
+
+// Checks the generated moves against trying every conceivable move with Board::is_legal().
+static void expect_moves_match_is_legal(const Chess::Board& board)
+{
+    auto moves = board.legal_moves();
+    for (auto& move : moves)
+        EXPECT(board.is_legal(move));
+
+    size_t legal_move_count = 0;
+    for (unsigned from = 0; from < 64; ++from) {
+        for (unsigned to = 0; to < 64; ++to) {
+            if (from == to)
+                continue;
+            auto from_square = Chess::Square::from_index(from);
+            auto to_square = Chess::Square::from_index(to);
+            // Castling can also be spelled as the king moving onto the rook, generate_moves() only gives the usual form.
+            if (board.get_piece(from_square).type == Chess::Type::King && abs((int)to_square.file - (int)from_square.file) > 2)
+                continue;
+            for (auto type : { Chess::Type::None, Chess::Type::Knight, Chess::Type::Bishop, Chess::Type::Rook, Chess::Type::Queen }) {
+                if (board.is_legal({ from_square, to_square, type }))
+                    ++legal_move_count;
+            }
+        }
+    }
+    EXPECT_EQ(moves.size(), legal_move_count);
+}
+
+static Chess::Board board_after(std::initializer_list<const char*> moves)
+{
+    Chess::Board board;
+    for (auto* move : moves)
+        VERIFY(board.apply_move(Chess::Move(move)));
+    return board;
+}
+
+TEST_CASE(perft_from_starting_position)
+{
+    Chess::Board board;
+    EXPECT_EQ(perft(board, 1), 20u);
+    EXPECT_EQ(perft(board, 2), 400u);
+    EXPECT_EQ(perft(board, 3), 8902u);
+}
+
+TEST_CASE(castling)
+{
+    auto board = board_after({ "e2e4", "e7e5", "g1f3", "b8c6", "f1c4", "f8c5" });
+    EXPECT(board.legal_moves().contains_slow(Chess::Move("e1g1")));
+    expect_moves_match_is_legal(board);
+
+    // There's no castling out of check.
+    board = board_after({ "e2e4", "e7e5", "g1f3", "b8c6", "f1c4", "f8c5", "d2d3", "d8h4", "c1e3", "h4f2" });
+    EXPECT(!board.legal_moves().contains_slow(Chess::Move("e1g1")));
+    expect_moves_match_is_legal(board);
+}
+
+TEST_CASE(en_passant_and_promotion)
+{
+    auto board = board_after({ "e2e4", "a7a6", "e4e5", "d7d5" });
+    EXPECT(board.legal_moves().contains_slow(Chess::Move("e5d6")));
+    expect_moves_match_is_legal(board);
+
+    board = board_after({ "h2h4", "g7g5", "h4g5", "h7h6", "g5h6", "a7a6", "h6h7", "a6a5" });
+    EXPECT(board.legal_moves().contains_slow(Chess::Move("h7g8n")));
+    expect_moves_match_is_legal(board);
+}
+
+TEST_CASE(random_games)
+{
+    srand(0);
+    for (int game = 0; game < 5; ++game) {
+        Chess::Board board;
+        for (int ply = 0; ply < 80 && !board.game_finished(); ++ply) {
+            expect_moves_match_is_legal(board);
+            VERIFY(board.apply_move(board.random_move()));
+        }
+    }
+}
+
+BENCHMARK_CASE(perft_nodes_per_second)
+{
+    Core::ElapsedTimer timer;
+    timer.start();
+    auto nodes = perft(Chess::Board(), 4);
+    EXPECT_EQ(nodes, 197281u);
+    auto elapsed_ms = max(timer.elapsed(), 1);
+    outln("perft(4): {} nodes in {} ms, {} nodes per second", nodes, elapsed_ms, nodes * 1000 / elapsed_ms);
+}
+
+TEST_MAIN(Chess)
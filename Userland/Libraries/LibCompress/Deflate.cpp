@@ -26,9 +26,9 @@
 
 #include <AK/Array.h>
 #include <AK/Assertions.h>
-#include <AK/BinarySearch.h>
 #include <AK/LogStream.h>
 #include <AK/MemoryStream.h>
+#include <AK/QuickSort.h>
 
 #include <LibCompress/Deflate.h>
 
@@ -71,33 +71,92 @@ const CanonicalCode& CanonicalCode::fixed_distance_codes()
     return code;
 }
 
-Optional<CanonicalCode> CanonicalCode::from_bytes(ReadonlyBytes bytes)
+static u16 reverse_bits(u16 code, size_t length)
 {
-    // FIXME: I can't quite follow the algorithm here, but it seems to work.
+    u16 result = 0;
+    for (size_t i = 0; i < length; ++i) {
+        result = result << 1 | (code & 1);
+        code >>= 1;
+    }
+    return result;
+}
 
-    CanonicalCode code;
+Optional<CanonicalCode> CanonicalCode::from_bytes(ReadonlyBytes bytes)
+{
+    // Codes are assigned as described in RFC 1951 section 3.2.2: codes of the same length are consecutive
+    // in symbol order, and shorter codes lexicographically precede longer ones.
+
+    Array<u16, max_code_length + 1> length_counts {};
+    for (auto length : bytes) {
+        if (length > max_code_length)
+            return {};
+        ++length_counts[length];
+    }
+    length_counts[0] = 0;
+
+    // The code has to be complete, i.e. every sequence of bits has to start with exactly one code.
+    i32 unassigned_codes = 1;
+    for (size_t length = 1; length <= max_code_length; ++length) {
+        unassigned_codes = (unassigned_codes << 1) - length_counts[length];
+        if (unassigned_codes < 0)
+            return {};
+    }
+    if (unassigned_codes != 0)
+        return {};
 
-    auto next_code = 0;
-    for (size_t code_length = 1; code_length <= 15; ++code_length) {
-        next_code <<= 1;
-        auto start_bit = 1 << code_length;
+    Array<u16, max_code_length + 1> next_code {};
+    for (size_t length = 2; length <= max_code_length; ++length)
+        next_code[length] = (next_code[length - 1] + length_counts[length - 1]) << 1;
+
+    // Codes are stored most significant bit first, but the bit stream hands out the first bit as the least
+    // significant one. Store them reversed, so they can be compared to the input directly.
+    Vector<u16> symbol_codes;
+    symbol_codes.resize(bytes.size());
+    for (size_t symbol = 0; symbol < bytes.size(); ++symbol) {
+        if (bytes[symbol] != 0)
+            symbol_codes[symbol] = reverse_bits(next_code[bytes[symbol]]++, bytes[symbol]);
+    }
 
-        for (size_t symbol = 0; symbol < bytes.size(); ++symbol) {
-            if (bytes[symbol] != code_length)
-                continue;
+    constexpr size_t primary_table_size = 1 << primary_table_bits;
+    constexpr u16 primary_table_mask = primary_table_size - 1;
 
-            if (next_code > start_bit)
-                return {};
+    CanonicalCode code;
+    code.m_table.resize(primary_table_size);
 
-            code.m_symbol_codes.append(start_bit | next_code);
-            code.m_symbol_values.append(symbol);
+    // Each second level table has to be big enough for the longest code that shares its prefix.
+    for (size_t symbol = 0; symbol < bytes.size(); ++symbol) {
+        if (bytes[symbol] <= primary_table_bits)
+            continue;
+        auto& entry = code.m_table[symbol_codes[symbol] & primary_table_mask];
+        entry.subtable_bits = max<u8>(entry.subtable_bits, bytes[symbol] - primary_table_bits);
+    }
 
-            next_code++;
-        }
+    size_t table_size = primary_table_size;
+    for (size_t index = 0; index < primary_table_size; ++index) {
+        auto& entry = code.m_table[index];
+        if (entry.subtable_bits == 0)
+            continue;
+        entry.symbol_or_subtable_offset = table_size;
+        entry.code_length = primary_table_bits + entry.subtable_bits;
+        table_size += 1 << entry.subtable_bits;
     }
+    code.m_table.resize(table_size);
 
-    if (next_code != (1 << 15)) {
-        return {};
+    for (size_t symbol = 0; symbol < bytes.size(); ++symbol) {
+        const u8 length = bytes[symbol];
+        if (length == 0)
+            continue;
+
+        // A code fills every entry whose index starts with it, no matter which bits follow.
+        const TableEntry symbol_entry { static_cast<u16>(symbol), length, 0 };
+        if (length <= primary_table_bits) {
+            for (size_t index = symbol_codes[symbol]; index < primary_table_size; index += 1 << length)
+                code.m_table[index] = symbol_entry;
+        } else {
+            const auto subtable = code.m_table[symbol_codes[symbol] & primary_table_mask];
+            for (size_t index = symbol_codes[symbol] >> primary_table_bits; index < (1u << subtable.subtable_bits); index += 1 << (length - primary_table_bits))
+                code.m_table[subtable.symbol_or_subtable_offset + index] = symbol_entry;
+        }
     }
 
     return code;
@@ -105,17 +164,24 @@ Optional<CanonicalCode> CanonicalCode::from_bytes(ReadonlyBytes bytes)
 
 u32 CanonicalCode::read_symbol(InputBitStream& stream) const
 {
-    u32 code_bits = 1;
-
     for (;;) {
-        code_bits = code_bits << 1 | stream.read_bits(1);
-        VERIFY(code_bits < (1 << 16));
+        const auto bits = stream.peek_bits(max_code_length);
 
-        // FIXME: This is very inefficient and could greatly be improved by implementing this
-        //        algorithm: https://www.hanshq.net/zip.html#huffdec
-        size_t index;
-        if (binary_search(m_symbol_codes.span(), code_bits, &index))
-            return m_symbol_values[index];
+        auto entry = m_table[bits & ((1 << primary_table_bits) - 1)];
+        if (entry.subtable_bits != 0)
+            entry = m_table[entry.symbol_or_subtable_offset + ((bits >> primary_table_bits) & ((1 << entry.subtable_bits) - 1))];
+
+        // Bits that haven't been buffered yet read as zero, so the entry can only be trusted if it didn't
+        // depend on any of them. Otherwise, we need more input.
+        if (entry.code_length <= stream.buffered_bit_count()) {
+            stream.discard_bits(entry.code_length);
+            return entry.symbol_or_subtable_offset;
+        }
+
+        if (!stream.refill()) {
+            stream.set_fatal_error();
+            return 0;
+        }
     }
 }
 
@@ -133,6 +199,11 @@ bool DeflateDecompressor::CompressedBlock::try_read_more()
 
     const auto symbol = m_literal_codes.read_symbol(m_decompressor.m_input_stream);
 
+    if (m_decompressor.m_input_stream.handle_any_error()) {
+        m_decompressor.set_fatal_error();
+        return false;
+    }
+
     if (symbol < 256) {
         m_decompressor.m_output_stream << static_cast<u8>(symbol);
         return true;
@@ -148,11 +219,24 @@ bool DeflateDecompressor::CompressedBlock::try_read_more()
         const auto length = m_decompressor.decode_length(symbol);
         const auto distance = m_decompressor.decode_distance(m_distance_codes.value().read_symbol(m_decompressor.m_input_stream));
 
-        for (size_t idx = 0; idx < length; ++idx) {
-            u8 byte = 0;
-            m_decompressor.m_output_stream.read({ &byte, sizeof(byte) }, distance);
-            m_decompressor.m_output_stream << byte;
+        if (m_decompressor.m_input_stream.handle_any_error()) {
+            m_decompressor.set_fatal_error();
+            return false;
+        }
+
+        // Copy the whole back-reference at once. If it overlaps the bytes it produces, those simply repeat
+        // the `distance` bytes before them, so we can extend the part we could read in the buffer instead.
+        u8 buffer[258];
+        const auto nread = m_decompressor.m_output_stream.read({ buffer, length }, distance);
+        if (nread == 0) {
+            m_decompressor.m_output_stream.handle_any_error();
+            m_decompressor.set_fatal_error();
+            return false;
         }
+        for (size_t idx = nread; idx < length; ++idx)
+            buffer[idx] = buffer[idx - distance];
+
+        m_decompressor.m_output_stream << ReadonlyBytes { buffer, length };
 
         return true;
     }
@@ -178,6 +262,12 @@ bool DeflateDecompressor::UncompressedBlock::try_read_more()
 }
 
 DeflateDecompressor::DeflateDecompressor(InputStream& stream)
+    : m_owned_input_stream(make<InputBitStream>(stream))
+    , m_input_stream(*m_owned_input_stream)
+{
+}
+
+DeflateDecompressor::DeflateDecompressor(InputBitStream& stream)
     : m_input_stream(stream)
 {
 }
@@ -449,4 +539,607 @@ void DeflateDecompressor::decode_codes(CanonicalCode& literal_code, Optional<Can
     distance_code = distance_code_result.value();
 }
 
+struct SymbolWithExtraBits {
+    u16 symbol;
+    u8 extra_bits;
+    u16 extra_value;
+};
+
+static size_t log2(size_t value)
+{
+    return sizeof(unsigned) * 8 - 1 - __builtin_clz(value);
+}
+
+// The inverse of DeflateDecompressor::decode_length().
+static SymbolWithExtraBits encode_length(size_t length)
+{
+    VERIFY(length >= 3 && length <= 258);
+
+    if (length == 258)
+        return { 285, 0, 0 };
+
+    const auto offset = length - 3;
+    if (offset < 8)
+        return { static_cast<u16>(257 + offset), 0, 0 };
+
+    const auto extra_bits = log2(offset) - 2;
+    const auto symbol = 261 + 4 * extra_bits + ((offset >> extra_bits) & 3);
+    return { static_cast<u16>(symbol), static_cast<u8>(extra_bits), static_cast<u16>(offset & ((1 << extra_bits) - 1)) };
+}
+
+// The inverse of DeflateDecompressor::decode_distance().
+static SymbolWithExtraBits encode_distance(size_t distance)
+{
+    VERIFY(distance >= 1 && distance <= DeflateCompressor::max_distance);
+
+    const auto offset = distance - 1;
+    if (offset < 4)
+        return { static_cast<u16>(offset), 0, 0 };
+
+    const auto extra_bits = log2(offset) - 1;
+    const auto symbol = 2 * extra_bits + 2 + ((offset >> extra_bits) & 1);
+    return { static_cast<u16>(symbol), static_cast<u8>(extra_bits), static_cast<u16>(offset & ((1 << extra_bits) - 1)) };
+}
+
+// Builds a Huffman code for the given frequencies where no code is longer than max_code_length bits.
+template<size_t Size>
+static void generate_huffman_lengths(Array<u8, Size>& lengths, Array<u16, Size> frequencies, size_t max_code_length)
+{
+    // A code needs at least two symbols to be complete, which is what decoders (including ours) expect.
+    size_t used_symbol_count = 0;
+    for (auto frequency : frequencies)
+        used_symbol_count += frequency != 0;
+    for (size_t symbol = 0; used_symbol_count < 2; ++symbol) {
+        if (frequencies[symbol] == 0) {
+            frequencies[symbol] = 1;
+            ++used_symbol_count;
+        }
+    }
+
+    struct Node {
+        u32 frequency;
+        u16 parent;
+        u8 depth;
+    };
+
+    for (;;) {
+        Vector<u16, Size> leaves;
+        for (size_t symbol = 0; symbol < Size; ++symbol) {
+            if (frequencies[symbol] != 0)
+                leaves.append(symbol);
+        }
+        quick_sort(leaves, [&](auto a, auto b) { return frequencies[a] < frequencies[b]; });
+
+        // The leaves come first, sorted by frequency. Internal nodes are appended as they are created, which
+        // happens in order of frequency as well, so the two smallest nodes are always at the front of one of
+        // these two queues.
+        const auto leaf_count = leaves.size();
+        Array<Node, 2 * Size> nodes;
+        for (size_t i = 0; i < leaf_count; ++i)
+            nodes[i].frequency = frequencies[leaves[i]];
+
+        size_t next_leaf = 0;
+        size_t next_internal_node = leaf_count;
+        size_t node_count = leaf_count;
+        auto take_smallest = [&] {
+            if (next_leaf < leaf_count && (next_internal_node == node_count || nodes[next_leaf].frequency <= nodes[next_internal_node].frequency))
+                return next_leaf++;
+            return next_internal_node++;
+        };
+        while (node_count < 2 * leaf_count - 1) {
+            const auto left = take_smallest();
+            const auto right = take_smallest();
+            nodes[node_count].frequency = nodes[left].frequency + nodes[right].frequency;
+            nodes[left].parent = node_count;
+            nodes[right].parent = node_count;
+            ++node_count;
+        }
+
+        // Parents always come after their children.
+        size_t max_depth = 0;
+        nodes[node_count - 1].depth = 0;
+        for (size_t i = node_count - 1; i-- > 0;) {
+            nodes[i].depth = nodes[nodes[i].parent].depth + 1;
+            max_depth = max<size_t>(max_depth, nodes[i].depth);
+        }
+
+        if (max_depth <= max_code_length) {
+            lengths.span().fill(0);
+            for (size_t i = 0; i < leaf_count; ++i)
+                lengths[leaves[i]] = nodes[i].depth;
+            return;
+        }
+
+        // The tree is too deep. Make the frequencies more alike and try again, which eventually results in
+        // a balanced tree.
+        for (auto& frequency : frequencies) {
+            if (frequency != 0)
+                frequency = (frequency + 1) / 2;
+        }
+    }
+}
+
+// Assigns canonical codes to the given code lengths, bit reversed so they can be written as they are.
+template<size_t Size>
+static void generate_huffman_codes(const Array<u8, Size>& lengths, Array<u16, Size>& codes)
+{
+    Array<u16, 16> length_counts {};
+    for (auto length : lengths)
+        ++length_counts[length];
+    length_counts[0] = 0;
+
+    Array<u16, 16> next_code {};
+    for (size_t length = 2; length < 16; ++length)
+        next_code[length] = (next_code[length - 1] + length_counts[length - 1]) << 1;
+
+    for (size_t symbol = 0; symbol < Size; ++symbol) {
+        if (lengths[symbol] != 0)
+            codes[symbol] = reverse_bits(next_code[lengths[symbol]]++, lengths[symbol]);
+    }
+}
+
+struct DeflateCompressor::DynamicHeader {
+    struct CodeLengthSymbol {
+        u8 symbol;
+        u8 extra_value;
+    };
+
+    size_t literal_count { 0 };
+    size_t distance_count { 0 };
+    size_t code_length_count { 0 };
+
+    Array<u8, code_length_code_count> code_length_lengths {};
+    Array<u16, code_length_code_count> code_length_codes {};
+    Vector<CodeLengthSymbol> code_length_symbols;
+
+    size_t length_in_bits { 0 };
+};
+
+static constexpr u8 code_length_code_order[] { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+DeflateCompressor::DeflateCompressor(OutputStream& stream, CompressionLevel compression_level)
+    : m_output_stream(stream)
+    , m_compression_level(compression_level)
+{
+    switch (compression_level) {
+    case CompressionLevel::Store:
+        m_constants = { 0, 0, 0, 0 };
+        break;
+    case CompressionLevel::Fast:
+        m_constants = { 8, 4, 0, 32 };
+        break;
+    case CompressionLevel::Good:
+        m_constants = { 128, 8, 16, 128 };
+        break;
+    case CompressionLevel::Best:
+        m_constants = { 4096, 32, max_match_length, max_match_length };
+        break;
+    }
+
+    m_window = ByteBuffer::create_uninitialized(window_size);
+    if (m_compression_level != CompressionLevel::Store) {
+        m_hash_head.resize(1 << hash_bits);
+        m_hash_head.span().fill(empty_slot);
+        m_hash_previous.resize(window_size);
+        m_hash_previous.span().fill(empty_slot);
+        m_tokens.ensure_capacity(block_size);
+    }
+}
+
+DeflateCompressor::~DeflateCompressor()
+{
+    VERIFY(m_finished);
+}
+
+size_t DeflateCompressor::write(ReadonlyBytes bytes)
+{
+    VERIFY(!m_finished);
+
+    if (has_any_error())
+        return 0;
+
+    size_t nwritten = 0;
+    while (nwritten < bytes.size()) {
+        const auto count = min(bytes.size() - nwritten, block_size - m_pending_length);
+        bytes.slice(nwritten, count).copy_to(m_window.bytes().slice(block_size + m_pending_length, count));
+        m_pending_length += count;
+        nwritten += count;
+
+        if (m_pending_length == block_size) {
+            flush_block(false);
+            slide_window();
+            m_pending_length = 0;
+        }
+    }
+
+    return nwritten;
+}
+
+bool DeflateCompressor::write_or_error(ReadonlyBytes bytes)
+{
+    if (write(bytes) < bytes.size() || m_output_stream.handle_any_error()) {
+        set_fatal_error();
+        return false;
+    }
+
+    return true;
+}
+
+void DeflateCompressor::final_flush()
+{
+    VERIFY(!m_finished);
+
+    flush_block(true);
+    m_output_stream.align_to_byte_boundary();
+    m_finished = true;
+
+    if (m_output_stream.handle_any_error())
+        set_fatal_error();
+}
+
+Optional<ByteBuffer> DeflateCompressor::compress_all(ReadonlyBytes bytes, CompressionLevel compression_level)
+{
+    DuplexMemoryStream output_stream;
+    DeflateCompressor deflate_stream { output_stream, compression_level };
+
+    deflate_stream.write_or_error(bytes);
+    deflate_stream.final_flush();
+
+    if (deflate_stream.handle_any_error())
+        return {};
+
+    return output_stream.copy_into_contiguous_buffer();
+}
+
+u16 DeflateCompressor::hash(const u8* bytes)
+{
+    const u32 value = bytes[0] | bytes[1] << 8 | bytes[2] << 16;
+    return (value * 2654435761u) >> (32 - hash_bits);
+}
+
+void DeflateCompressor::insert_hash(size_t position)
+{
+    auto& head = m_hash_head[hash(m_window.data() + position)];
+    m_hash_previous[position] = head;
+    head = position;
+}
+
+DeflateCompressor::Match DeflateCompressor::find_longest_match(size_t position, size_t previous_length) const
+{
+    const auto* window = m_window.data();
+    const auto max_length = min(max_match_length, block_size + m_pending_length - position);
+    if (max_length < min_match_length)
+        return {};
+
+    auto chain_length = m_constants.max_chain;
+    if (previous_length >= m_constants.good_match_length)
+        chain_length /= 4;
+
+    // Only matches that are longer than the one we already have are interesting.
+    Match best_match;
+    auto best_length = max(previous_length, min_match_length - 1);
+
+    for (auto candidate = m_hash_head[hash(window + position)]; candidate != empty_slot && chain_length-- > 0; candidate = m_hash_previous[candidate]) {
+        if (position - candidate > max_distance)
+            break;
+
+        // A match can only be longer if it gets the byte after the current best one right.
+        if (best_length < max_length && window[candidate + best_length] != window[position + best_length])
+            continue;
+
+        size_t length = 0;
+        while (length < max_length && window[candidate + length] == window[position + length])
+            ++length;
+
+        if (length > best_length) {
+            best_match = { length, position - candidate };
+            best_length = length;
+            if (length >= m_constants.nice_match_length || length == max_length)
+                break;
+        }
+    }
+
+    // A short match far away takes more bits than the literals would.
+    if (best_match.length == min_match_length && best_match.distance > 4 * KiB)
+        return {};
+
+    return best_match;
+}
+
+void DeflateCompressor::slide_window()
+{
+    __builtin_memcpy(m_window.data(), m_window.data() + block_size, block_size);
+
+    if (m_compression_level == CompressionLevel::Store)
+        return;
+
+    auto slide = [](u16 position) -> u16 {
+        if (position == empty_slot || position < block_size)
+            return empty_slot;
+        return position - block_size;
+    };
+
+    for (auto& position : m_hash_head)
+        position = slide(position);
+    for (size_t position = 0; position < block_size; ++position)
+        m_hash_previous[position] = slide(m_hash_previous[position + block_size]);
+    m_hash_previous.span().slice(block_size).fill(empty_slot);
+}
+
+void DeflateCompressor::emit_literal(u8 literal)
+{
+    m_tokens.unchecked_append({ literal, 0 });
+    ++m_literal_frequencies[literal];
+}
+
+void DeflateCompressor::emit_match(const Match& match)
+{
+    m_tokens.unchecked_append({ static_cast<u16>(match.length), static_cast<u16>(match.distance) });
+    ++m_literal_frequencies[encode_length(match.length).symbol];
+    ++m_distance_frequencies[encode_distance(match.distance).symbol];
+}
+
+void DeflateCompressor::lz77_compress_block()
+{
+    const auto end = block_size + m_pending_length;
+    const auto lazy = m_constants.max_lazy_length != 0;
+
+    auto insert_hashes = [&](size_t from, size_t to) {
+        for (auto position = from; position < to && position + min_match_length <= end; ++position)
+            insert_hash(position);
+    };
+
+    // With lazy matching, the match found at a position is held back until we know whether the match at
+    // the following position is longer. If it is, the first byte becomes a literal instead.
+    Match deferred_match;
+    bool has_deferred_literal = false;
+
+    size_t position = block_size;
+    while (position < end) {
+        Match match;
+        if (!lazy || deferred_match.length < m_constants.max_lazy_length)
+            match = find_longest_match(position, deferred_match.length);
+        insert_hashes(position, position + 1);
+
+        if (!lazy) {
+            if (match.length >= min_match_length) {
+                emit_match(match);
+                insert_hashes(position + 1, position + match.length);
+                position += match.length;
+            } else {
+                emit_literal(m_window[position]);
+                ++position;
+            }
+            continue;
+        }
+
+        if (deferred_match.length >= min_match_length && match.length <= deferred_match.length) {
+            emit_match(deferred_match);
+            const auto match_end = position - 1 + deferred_match.length;
+            insert_hashes(position + 1, match_end);
+            position = match_end;
+            deferred_match = {};
+            has_deferred_literal = false;
+            continue;
+        }
+
+        if (has_deferred_literal)
+            emit_literal(m_window[position - 1]);
+        deferred_match = match;
+        has_deferred_literal = true;
+        ++position;
+    }
+
+    if (has_deferred_literal)
+        emit_literal(m_window[position - 1]);
+}
+
+const DeflateCompressor::HuffmanTree& DeflateCompressor::fixed_huffman_tree()
+{
+    static HuffmanTree tree;
+    static bool initialized = false;
+
+    if (initialized)
+        return tree;
+
+    tree.literal_lengths.span().slice(0, 144 - 0).fill(8);
+    tree.literal_lengths.span().slice(144, 256 - 144).fill(9);
+    tree.literal_lengths.span().slice(256, 280 - 256).fill(7);
+    tree.literal_lengths.span().slice(280, 288 - 280).fill(8);
+    tree.distance_lengths.span().fill(5);
+
+    generate_huffman_codes(tree.literal_lengths, tree.literal_codes);
+    generate_huffman_codes(tree.distance_lengths, tree.distance_codes);
+    initialized = true;
+
+    return tree;
+}
+
+void DeflateCompressor::build_dynamic_header(const HuffmanTree& tree, DynamicHeader& header)
+{
+    header.literal_count = literal_code_count;
+    while (header.literal_count > 257 && tree.literal_lengths[header.literal_count - 1] == 0)
+        --header.literal_count;
+    header.distance_count = distance_code_count;
+    while (header.distance_count > 1 && tree.distance_lengths[header.distance_count - 1] == 0)
+        --header.distance_count;
+
+    // The code lengths of both codes are sent as one sequence, with runs of the same length shortened.
+    Vector<u8, literal_code_count + distance_code_count> lengths;
+    lengths.append(tree.literal_lengths.data(), header.literal_count);
+    lengths.append(tree.distance_lengths.data(), header.distance_count);
+
+    Array<u16, code_length_code_count> frequencies {};
+    auto emit = [&](u8 symbol, u8 extra_value = 0) {
+        header.code_length_symbols.append({ symbol, extra_value });
+        ++frequencies[symbol];
+    };
+
+    for (size_t i = 0; i < lengths.size();) {
+        const auto length = lengths[i];
+        size_t run_length = 1;
+        while (i + run_length < lengths.size() && lengths[i + run_length] == length)
+            ++run_length;
+        i += run_length;
+
+        if (length == 0) {
+            while (run_length >= 11) {
+                const auto count = min<size_t>(run_length, 138);
+                emit(18, count - 11);
+                run_length -= count;
+            }
+            if (run_length >= 3) {
+                emit(17, run_length - 3);
+                run_length = 0;
+            }
+        } else {
+            emit(length);
+            --run_length;
+            while (run_length >= 3) {
+                const auto count = min<size_t>(run_length, 6);
+                emit(16, count - 3);
+                run_length -= count;
+            }
+        }
+
+        while (run_length-- > 0)
+            emit(length);
+    }
+
+    generate_huffman_lengths(header.code_length_lengths, frequencies, 7);
+    generate_huffman_codes(header.code_length_lengths, header.code_length_codes);
+
+    header.code_length_count = code_length_code_count;
+    while (header.code_length_count > 4 && header.code_length_lengths[code_length_code_order[header.code_length_count - 1]] == 0)
+        --header.code_length_count;
+
+    header.length_in_bits = 5 + 5 + 4 + 3 * header.code_length_count;
+    for (auto& symbol : header.code_length_symbols) {
+        header.length_in_bits += header.code_length_lengths[symbol.symbol];
+        if (symbol.symbol == 16)
+            header.length_in_bits += 2;
+        else if (symbol.symbol == 17)
+            header.length_in_bits += 3;
+        else if (symbol.symbol == 18)
+            header.length_in_bits += 7;
+    }
+}
+
+size_t DeflateCompressor::encoded_length(const HuffmanTree& tree) const
+{
+    size_t length = 0;
+
+    for (size_t symbol = 0; symbol < literal_code_count; ++symbol) {
+        if (m_literal_frequencies[symbol] == 0)
+            continue;
+        length += m_literal_frequencies[symbol] * tree.literal_lengths[symbol];
+        if (symbol >= 265 && symbol < 285)
+            length += m_literal_frequencies[symbol] * ((symbol - 261) / 4);
+    }
+
+    for (size_t symbol = 0; symbol < distance_code_count; ++symbol) {
+        if (m_distance_frequencies[symbol] == 0)
+            continue;
+        length += m_distance_frequencies[symbol] * tree.distance_lengths[symbol];
+        if (symbol >= 4)
+            length += m_distance_frequencies[symbol] * (symbol / 2 - 1);
+    }
+
+    return length;
+}
+
+void DeflateCompressor::write_dynamic_header(const DynamicHeader& header)
+{
+    m_output_stream.write_bits(header.literal_count - 257, 5);
+    m_output_stream.write_bits(header.distance_count - 1, 5);
+    m_output_stream.write_bits(header.code_length_count - 4, 4);
+
+    for (size_t i = 0; i < header.code_length_count; ++i)
+        m_output_stream.write_bits(header.code_length_lengths[code_length_code_order[i]], 3);
+
+    for (auto& symbol : header.code_length_symbols) {
+        m_output_stream.write_bits(header.code_length_codes[symbol.symbol], header.code_length_lengths[symbol.symbol]);
+        if (symbol.symbol == 16)
+            m_output_stream.write_bits(symbol.extra_value, 2);
+        else if (symbol.symbol == 17)
+            m_output_stream.write_bits(symbol.extra_value, 3);
+        else if (symbol.symbol == 18)
+            m_output_stream.write_bits(symbol.extra_value, 7);
+    }
+}
+
+void DeflateCompressor::write_tokens(const HuffmanTree& tree)
+{
+    for (auto& token : m_tokens) {
+        if (token.distance == 0) {
+            m_output_stream.write_bits(tree.literal_codes[token.length_or_literal], tree.literal_lengths[token.length_or_literal]);
+            continue;
+        }
+
+        const auto length = encode_length(token.length_or_literal);
+        m_output_stream.write_bits(tree.literal_codes[length.symbol], tree.literal_lengths[length.symbol]);
+        m_output_stream.write_bits(length.extra_value, length.extra_bits);
+
+        const auto distance = encode_distance(token.distance);
+        m_output_stream.write_bits(tree.distance_codes[distance.symbol], tree.distance_lengths[distance.symbol]);
+        m_output_stream.write_bits(distance.extra_value, distance.extra_bits);
+    }
+
+    m_output_stream.write_bits(tree.literal_codes[256], tree.literal_lengths[256]);
+}
+
+void DeflateCompressor::write_stored_block(bool final)
+{
+    m_output_stream.write_bit(final);
+    m_output_stream.write_bits(0b00, 2);
+    m_output_stream.align_to_byte_boundary();
+
+    m_output_stream.write_bits(m_pending_length, 16);
+    m_output_stream.write_bits(~m_pending_length & 0xffff, 16);
+    m_output_stream.write_or_error(m_window.bytes().slice(block_size, m_pending_length));
+}
+
+void DeflateCompressor::flush_block(bool final)
+{
+    if (m_compression_level == CompressionLevel::Store) {
+        write_stored_block(final);
+        return;
+    }
+
+    lz77_compress_block();
+    m_literal_frequencies[256] = 1;
+
+    HuffmanTree dynamic_tree;
+    generate_huffman_lengths(dynamic_tree.literal_lengths, m_literal_frequencies, 15);
+    generate_huffman_codes(dynamic_tree.literal_lengths, dynamic_tree.literal_codes);
+    generate_huffman_lengths(dynamic_tree.distance_lengths, m_distance_frequencies, 15);
+    generate_huffman_codes(dynamic_tree.distance_lengths, dynamic_tree.distance_codes);
+
+    DynamicHeader dynamic_header;
+    build_dynamic_header(dynamic_tree, dynamic_header);
+
+    // Use whichever block type ends up the smallest. (The 3 bits of block header are the same for all of them.)
+    const auto& fixed_tree = fixed_huffman_tree();
+    const auto dynamic_length = dynamic_header.length_in_bits + encoded_length(dynamic_tree);
+    const auto fixed_length = encoded_length(fixed_tree);
+    const auto stored_length = (8 - (m_output_stream.bit_offset() + 3) % 8) % 8 + 32 + 8 * m_pending_length;
+
+    if (stored_length <= dynamic_length && stored_length <= fixed_length) {
+        write_stored_block(final);
+    } else if (fixed_length <= dynamic_length) {
+        m_output_stream.write_bit(final);
+        m_output_stream.write_bits(0b01, 2);
+        write_tokens(fixed_tree);
+    } else {
+        m_output_stream.write_bit(final);
+        m_output_stream.write_bits(0b10, 2);
+        write_dynamic_header(dynamic_header);
+        write_tokens(dynamic_tree);
+    }
+
+    m_tokens.clear_with_capacity();
+    m_literal_frequencies.span().fill(0);
+    m_distance_frequencies.span().fill(0);
+}
+
 }
@@ -30,6 +30,8 @@
 #include <AK/ByteBuffer.h>
 #include <AK/CircularDuplexStream.h>
 #include <AK/Endian.h>
+#include <AK/NumericLimits.h>
+#include <AK/OwnPtr.h>
 #include <AK/Vector.h>
 
 namespace Compress {
@@ -45,8 +47,18 @@ public:
     static Optional<CanonicalCode> from_bytes(ReadonlyBytes);
 
 private:
-    Vector<u32> m_symbol_codes;
-    Vector<u32> m_symbol_values;
+    // Codes are decoded with a table lookup on the next primary_table_bits bits of input. Longer codes
+    // share an entry there that points to a second level table, indexed by the bits that follow.
+    static constexpr size_t max_code_length = 15;
+    static constexpr size_t primary_table_bits = 9;
+
+    struct TableEntry {
+        u16 symbol_or_subtable_offset { 0 };
+        u8 code_length { 0 };
+        u8 subtable_bits { 0 };
+    };
+
+    Vector<TableEntry> m_table;
 };
 
 class DeflateDecompressor final : public InputStream {
@@ -87,6 +99,9 @@ public:
     friend UncompressedBlock;
 
     DeflateDecompressor(InputStream&);
+    // The bit stream reads ahead of the compressed data, so whatever follows it has to be read from the
+    // same bit stream, which the caller keeps using after this decompressor is gone.
+    DeflateDecompressor(InputBitStream&);
     ~DeflateDecompressor();
 
     size_t read(Bytes) override;
@@ -110,8 +125,112 @@ private:
         UncompressedBlock m_uncompressed_block;
     };
 
-    InputBitStream m_input_stream;
+    OwnPtr<InputBitStream> m_owned_input_stream;
+    InputBitStream& m_input_stream;
     CircularDuplexStream<32 * 1024> m_output_stream;
 };
 
+class DeflateCompressor final : public OutputStream {
+public:
+    // Input is compressed in blocks of up to block_size bytes. Matches may reach back into the previous block,
+    // so the window holds both of them (and block positions fit into a u16, leaving room for an empty marker.)
+    static constexpr size_t block_size = 32 * KiB - 1;
+    static constexpr size_t window_size = 2 * block_size;
+    static constexpr size_t max_distance = 32 * KiB;
+    static constexpr size_t min_match_length = 3;
+    static constexpr size_t max_match_length = 258;
+    static constexpr size_t hash_bits = 15;
+    static constexpr u16 empty_slot = NumericLimits<u16>::max();
+
+    enum class CompressionLevel {
+        Store,
+        Fast,
+        Good,
+        Best,
+    };
+
+    DeflateCompressor(OutputStream&, CompressionLevel = CompressionLevel::Good);
+    ~DeflateCompressor();
+
+    size_t write(ReadonlyBytes) override;
+    bool write_or_error(ReadonlyBytes) override;
+
+    // Compresses whatever input is still buffered as the final block. Nothing may be written afterwards.
+    void final_flush();
+
+    static Optional<ByteBuffer> compress_all(ReadonlyBytes, CompressionLevel = CompressionLevel::Good);
+
+private:
+    // How hard each level looks for matches, the same knobs zlib has:
+    // - the number of earlier positions with the same hash that are tried,
+    // - the match length at which only a quarter of them are tried anymore,
+    // - the match length below which we check whether starting one byte later is better (zero for greedy matching),
+    // - the match length that is good enough to stop looking.
+    struct CompressionConstants {
+        size_t max_chain;
+        size_t good_match_length;
+        size_t max_lazy_length;
+        size_t nice_match_length;
+    };
+
+    struct Match {
+        size_t length { 0 };
+        size_t distance { 0 };
+    };
+
+    // A literal byte if distance is zero, a back-reference otherwise.
+    struct Token {
+        u16 length_or_literal;
+        u16 distance;
+    };
+
+    static constexpr size_t literal_code_count = 288;
+    static constexpr size_t distance_code_count = 30;
+    static constexpr size_t code_length_code_count = 19;
+
+    struct HuffmanTree {
+        Array<u8, literal_code_count> literal_lengths {};
+        Array<u16, literal_code_count> literal_codes {};
+        Array<u8, distance_code_count> distance_lengths {};
+        Array<u16, distance_code_count> distance_codes {};
+    };
+
+    struct DynamicHeader;
+
+    static const HuffmanTree& fixed_huffman_tree();
+    static void build_dynamic_header(const HuffmanTree&, DynamicHeader&);
+
+    static u16 hash(const u8*);
+    void insert_hash(size_t position);
+    Match find_longest_match(size_t position, size_t previous_length) const;
+    void slide_window();
+
+    void emit_literal(u8);
+    void emit_match(const Match&);
+    void lz77_compress_block();
+
+    size_t encoded_length(const HuffmanTree&) const;
+    void write_dynamic_header(const DynamicHeader&);
+    void write_tokens(const HuffmanTree&);
+    void write_stored_block(bool final);
+    void flush_block(bool final);
+
+    OutputBitStream m_output_stream;
+    CompressionLevel m_compression_level;
+    CompressionConstants m_constants;
+
+    // The previous block lives in [0, block_size), the one being collected in [block_size, block_size + m_pending_length).
+    ByteBuffer m_window;
+    size_t m_pending_length { 0 };
+
+    Vector<u16> m_hash_head;
+    Vector<u16> m_hash_previous;
+
+    Vector<Token> m_tokens;
+    Array<u16, literal_code_count> m_literal_frequencies {};
+    Array<u16, distance_code_count> m_distance_frequencies {};
+
+    bool m_finished { false };
+};
+
 }
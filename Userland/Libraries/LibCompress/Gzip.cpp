@@ -113,9 +113,10 @@ size_t GzipDecompressor::read(Bytes bytes)
         }
 
         if (header.flags & Flags::FEXTRA) {
-            LittleEndian<u16> subfield_id, length;
-            m_input_stream >> subfield_id >> length;
-            m_input_stream.discard_or_error(length);
+            // The extra field may hold any number of subfields, none of which we need.
+            LittleEndian<u16> extra_length;
+            m_input_stream >> extra_length;
+            m_input_stream.discard_or_error(extra_length);
         }
 
         if (header.flags & Flags::FNAME) {
@@ -180,4 +181,75 @@ Optional<ByteBuffer> GzipDecompressor::decompress_all(ReadonlyBytes bytes)
 
 bool GzipDecompressor::unreliable_eof() const { return m_eof; }
 
+
+GzipCompressor::GzipCompressor(OutputStream& stream, DeflateCompressor::CompressionLevel compression_level)
+    : m_output_stream(stream)
+    , m_deflate_stream(stream, compression_level)
+{
+    u8 extra_flags = 0;
+    if (compression_level == DeflateCompressor::CompressionLevel::Best)
+        extra_flags = 2;
+    else if (compression_level == DeflateCompressor::CompressionLevel::Fast)
+        extra_flags = 4;
+
+    // We don't know (or care) where the data came from, so there's no file name or modification time.
+    const u8 header[] {
+        0x1f, 0x8b, // identification
+        0x08,       // compression method (deflate)
+        0,          // flags
+        0, 0, 0, 0, // modification time
+        extra_flags,
+        3, // operating system (Unix)
+    };
+    m_output_stream << ReadonlyBytes { header, sizeof(header) };
+}
+
+size_t GzipCompressor::write(ReadonlyBytes bytes)
+{
+    if (has_any_error())
+        return 0;
+
+    const auto nwritten = m_deflate_stream.write(bytes);
+    m_checksum.update(bytes.trim(nwritten));
+    m_total_bytes += nwritten;
+    return nwritten;
+}
+
+bool GzipCompressor::write_or_error(ReadonlyBytes bytes)
+{
+    if (write(bytes) < bytes.size() || m_deflate_stream.handle_any_error()) {
+        set_fatal_error();
+        return false;
+    }
+
+    return true;
+}
+
+void GzipCompressor::final_flush()
+{
+    m_deflate_stream.final_flush();
+    if (m_deflate_stream.handle_any_error()) {
+        set_fatal_error();
+        return;
+    }
+
+    LittleEndian<u32> crc32 = m_checksum.digest();
+    LittleEndian<u32> input_size = static_cast<u32>(m_total_bytes);
+    m_output_stream << crc32 << input_size;
+}
+
+Optional<ByteBuffer> GzipCompressor::compress_all(ReadonlyBytes bytes, DeflateCompressor::CompressionLevel compression_level)
+{
+    DuplexMemoryStream output_stream;
+    GzipCompressor gzip_stream { output_stream, compression_level };
+
+    gzip_stream.write_or_error(bytes);
+    gzip_stream.final_flush();
+
+    if (gzip_stream.handle_any_error())
+        return {};
+
+    return output_stream.copy_into_contiguous_buffer();
+}
+
 }
@@ -70,7 +70,7 @@ private:
 
     class Member {
     public:
-        Member(BlockHeader header, InputStream& stream)
+        Member(BlockHeader header, InputBitStream& stream)
             : m_header(header)
             , m_stream(stream)
         {
@@ -85,10 +85,31 @@ private:
     const Member& current_member() const { return m_current_member.value(); }
     Member& current_member() { return m_current_member.value(); }
 
-    InputStream& m_input_stream;
+    // Members are decompressed straight from here, so the headers and trailers in between are read from
+    // the same bit stream as the compressed data.
+    InputBitStream m_input_stream;
     Optional<Member> m_current_member;
 
     bool m_eof { false };
 };
 
+class GzipCompressor final : public OutputStream {
+public:
+    GzipCompressor(OutputStream&, DeflateCompressor::CompressionLevel = DeflateCompressor::CompressionLevel::Good);
+
+    size_t write(ReadonlyBytes) override;
+    bool write_or_error(ReadonlyBytes) override;
+
+    // Finishes the member: compresses whatever input is still buffered and writes the trailer.
+    void final_flush();
+
+    static Optional<ByteBuffer> compress_all(ReadonlyBytes, DeflateCompressor::CompressionLevel = DeflateCompressor::CompressionLevel::Good);
+
+private:
+    OutputStream& m_output_stream;
+    DeflateCompressor m_deflate_stream;
+    Crypto::Checksum::CRC32 m_checksum;
+    size_t m_total_bytes { 0 };
+};
+
 }
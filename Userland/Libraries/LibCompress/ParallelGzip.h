@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/ByteBuffer.h>
+#include <AK/Optional.h>
+#include <AK/Stream.h>
+#include <AK/Vector.h>
+#include <LibCompress/Gzip.h>
+#include <LibThread/ThreadPool.h>
+
+namespace Compress {
+
+// Decompresses gzip files that are made of many small members, like the BGZF files written
+// by bgzip, on the thread pool. Each such member records its own compressed size in
+// a "BC" extra subfield, so the members can be found without decompressing anything first.
+// Members are decompressed in batches, which keeps memory use bounded no matter how large
+// the whole file is. Users have to link against LibThread.
+class ParallelGzipDecompressor final : public InputStream {
+public:
+    static constexpr size_t members_per_worker = 16;
+
+    // Returns the members of a gzip file, or nothing if their sizes aren't all recorded
+    // (in which case the file has to go through a GzipDecompressor.)
+    static Optional<Vector<ReadonlyBytes>> split_into_members(ReadonlyBytes bytes)
+    {
+        constexpr u8 flag_extra = 1 << 2;
+        constexpr size_t header_size = 10;
+
+        Vector<ReadonlyBytes> members;
+        size_t offset = 0;
+        while (offset < bytes.size()) {
+            auto rest = bytes.slice(offset);
+            if (rest.size() < header_size + 2 || rest[0] != 0x1f || rest[1] != 0x8b || rest[2] != 0x08 || !(rest[3] & flag_extra))
+                return {};
+
+            size_t extra_length = rest[10] | rest[11] << 8;
+            if (rest.size() < header_size + 2 + extra_length)
+                return {};
+            auto extra = rest.slice(header_size + 2, extra_length);
+
+            Optional<size_t> member_size;
+            for (size_t i = 0; i + 4 <= extra.size();) {
+                size_t subfield_length = extra[i + 2] | extra[i + 3] << 8;
+                if (extra[i] == 'B' && extra[i + 1] == 'C' && subfield_length == 2 && i + 6 <= extra.size()) {
+                    // This stores the size of the whole member, minus one.
+                    member_size = (extra[i + 4] | extra[i + 5] << 8) + 1;
+                    break;
+                }
+                i += 4 + subfield_length;
+            }
+            if (!member_size.has_value() || member_size.value() > rest.size())
+                return {};
+
+            members.append(rest.trim(member_size.value()));
+            offset += member_size.value();
+        }
+        return members;
+    }
+
+    explicit ParallelGzipDecompressor(Vector<ReadonlyBytes> members)
+        : m_members(move(members))
+    {
+    }
+
+    virtual size_t read(Bytes bytes) override
+    {
+        size_t nread = 0;
+        while (nread < bytes.size() && !has_any_error()) {
+            if (m_batch_index >= m_batch.size()) {
+                if (!decompress_next_batch())
+                    break;
+                continue;
+            }
+            auto& buffer = m_batch[m_batch_index];
+            auto ncopied = buffer.bytes().slice(m_offset_in_buffer).copy_trimmed_to(bytes.slice(nread));
+            nread += ncopied;
+            m_offset_in_buffer += ncopied;
+            if (m_offset_in_buffer == buffer.size()) {
+                ++m_batch_index;
+                m_offset_in_buffer = 0;
+            }
+        }
+        return nread;
+    }
+
+    virtual bool read_or_error(Bytes bytes) override
+    {
+        if (read(bytes) < bytes.size()) {
+            set_fatal_error();
+            return false;
+        }
+        return true;
+    }
+
+    virtual bool discard_or_error(size_t count) override
+    {
+        u8 buffer[4096];
+        while (count > 0) {
+            auto nread = read({ buffer, min(count, sizeof(buffer)) });
+            if (nread == 0) {
+                set_fatal_error();
+                return false;
+            }
+            count -= nread;
+        }
+        return true;
+    }
+
+    virtual bool unreliable_eof() const override
+    {
+        return m_next_member >= m_members.size() && m_batch_index >= m_batch.size();
+    }
+
+private:
+    bool decompress_next_batch()
+    {
+        m_batch.clear();
+        m_batch_index = 0;
+        m_offset_in_buffer = 0;
+        if (m_next_member >= m_members.size())
+            return false;
+
+        auto& pool = LibThread::ThreadPool::the();
+        size_t batch_size = min(pool.worker_count() * members_per_worker, m_members.size() - m_next_member);
+        m_batch.resize(batch_size);
+        Vector<bool> succeeded;
+        succeeded.resize(batch_size);
+
+        pool.parallel_for(0, batch_size, 1, [&](size_t i) {
+            auto decompressed = GzipDecompressor::decompress_all(m_members[m_next_member + i]);
+            if (decompressed.has_value()) {
+                m_batch[i] = decompressed.release_value();
+                succeeded[i] = true;
+            }
+        });
+
+        m_next_member += batch_size;
+        for (auto success : succeeded) {
+            if (!success) {
+                set_fatal_error();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    Vector<ReadonlyBytes> m_members;
+    size_t m_next_member { 0 };
+
+    Vector<ByteBuffer> m_batch;
+    size_t m_batch_index { 0 };
+    size_t m_offset_in_buffer { 0 };
+};
+
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <LibCore/Async.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace Core {
+
+FdReadinessAwaiter::FdReadinessAwaiter(int fd, Notifier::Event event)
+    : m_fd(fd)
+    , m_event(event)
+{
+}
+
+void FdReadinessAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    // The event loop keeps the notifier alive while it's calling back, so it's fine for the
+    // resumed coroutine to destroy us (and drop the notifier) before the callback returns.
+    m_notifier = Notifier::construct(m_fd, m_event);
+    auto resume = [this, handle] {
+        m_notifier->set_enabled(false);
+        handle.resume();
+    };
+    if (m_event == Notifier::Read)
+        m_notifier->on_ready_to_read = move(resume);
+    else
+        m_notifier->on_ready_to_write = move(resume);
+}
+
+ReadAwaiter::ReadAwaiter(IODevice& device, Bytes buffer)
+    : FdReadinessAwaiter(device.fd(), Notifier::Read)
+    , m_device(device)
+    , m_buffer(buffer)
+{
+}
+
+int ReadAwaiter::await_resume()
+{
+    if (m_buffer.is_empty())
+        return 0;
+    int nread = m_device->read(m_buffer.data(), m_buffer.size());
+    if (!nread && !m_device->eof())
+        return -1;
+    return nread;
+}
+
+WriteAwaiter::WriteAwaiter(IODevice& device, ReadonlyBytes data)
+    : FdReadinessAwaiter(device.fd(), Notifier::Write)
+    , m_device(device)
+    , m_data(data)
+{
+}
+
+int WriteAwaiter::await_resume()
+{
+    if (m_data.is_empty())
+        return 0;
+    return ::write(m_device->fd(), m_data.data(), m_data.size());
+}
+
+ConnectAwaiter::ConnectAwaiter(Socket& socket, const SocketAddress& address, int port)
+    : m_socket(socket)
+    , m_address(address)
+    , m_port(port)
+{
+}
+
+bool ConnectAwaiter::await_ready()
+{
+    if (m_port < 0)
+        m_connect_started = m_socket->connect(m_address);
+    else
+        m_connect_started = m_socket->connect(m_address, m_port);
+    return !m_connect_started || m_socket->is_connected();
+}
+
+void ConnectAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    m_socket->on_connected = [handle] {
+        handle.resume();
+    };
+}
+
+bool ConnectAwaiter::await_resume()
+{
+    if (!m_connect_started)
+        return false;
+    // A non-blocking connect becomes writable when it fails, too.
+    int error = 0;
+    socklen_t error_size = sizeof(error);
+    if (getsockopt(m_socket->fd(), SOL_SOCKET, SO_ERROR, &error, &error_size) < 0 || error) {
+        errno = error;
+        return false;
+    }
+    return true;
+}
+
+void SleepAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    m_timer = Timer::create_single_shot(m_milliseconds, [handle] {
+        handle.resume();
+    });
+    m_timer->start();
+}
+
+Task<bool> async_read_exactly(IODevice& device, Bytes buffer)
+{
+    while (!buffer.is_empty()) {
+        int nread = co_await async_read(device, buffer);
+        if (nread <= 0)
+            co_return false;
+        buffer = buffer.slice(nread);
+    }
+    co_return true;
+}
+
+Task<bool> async_write_all(IODevice& device, ReadonlyBytes data)
+{
+    while (!data.is_empty()) {
+        int nwritten = co_await async_write(device, data);
+        if (nwritten < 0)
+            co_return false;
+        data = data.slice(nwritten);
+    }
+    co_return true;
+}
+
+}
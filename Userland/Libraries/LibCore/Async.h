@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Span.h>
+#include <LibCore/IODevice.h>
+#include <LibCore/Notifier.h>
+#include <LibCore/Socket.h>
+#include <LibCore/SocketAddress.h>
+#include <LibCore/Task.h>
+#include <LibCore/Timer.h>
+
+// Awaitables for use in Core::Task coroutines. They suspend the coroutine until the event loop
+// sees that the operation can proceed, so the current thread needs a running Core::EventLoop.
+
+namespace Core {
+
+class FdReadinessAwaiter {
+public:
+    FdReadinessAwaiter(int fd, Notifier::Event);
+
+    void await_suspend(std::coroutine_handle<>);
+
+private:
+    int m_fd { -1 };
+    Notifier::Event m_event { Notifier::None };
+    RefPtr<Notifier> m_notifier;
+};
+
+class ReadAwaiter : public FdReadinessAwaiter {
+public:
+    ReadAwaiter(IODevice&, Bytes);
+
+    bool await_ready() const { return m_device->buffered_size(); }
+    int await_resume();
+
+private:
+    NonnullRefPtr<IODevice> m_device;
+    Bytes m_buffer;
+};
+
+class WriteAwaiter : public FdReadinessAwaiter {
+public:
+    WriteAwaiter(IODevice&, ReadonlyBytes);
+
+    bool await_ready() const { return false; }
+    int await_resume();
+
+private:
+    NonnullRefPtr<IODevice> m_device;
+    ReadonlyBytes m_data;
+};
+
+class ConnectAwaiter {
+public:
+    ConnectAwaiter(Socket&, const SocketAddress&, int port);
+
+    bool await_ready();
+    void await_suspend(std::coroutine_handle<>);
+    bool await_resume();
+
+private:
+    NonnullRefPtr<Socket> m_socket;
+    SocketAddress m_address;
+    int m_port { -1 };
+    bool m_connect_started { false };
+};
+
+class SleepAwaiter {
+public:
+    explicit SleepAwaiter(int milliseconds)
+        : m_milliseconds(milliseconds)
+    {
+    }
+
+    bool await_ready() const { return m_milliseconds <= 0; }
+    void await_suspend(std::coroutine_handle<>);
+    void await_resume() { }
+
+private:
+    int m_milliseconds { 0 };
+    RefPtr<Timer> m_timer;
+};
+
+// Reads straight into the given buffer once the device has data.
+// Resolves to the number of bytes read, 0 at end of file, or -1 on error.
+inline ReadAwaiter async_read(IODevice& device, Bytes buffer) { return { device, buffer }; }
+
+// Writes as much of the data as the device takes once it's writable.
+// Resolves to the number of bytes written, or -1 on error (with errno set).
+inline WriteAwaiter async_write(IODevice& device, ReadonlyBytes data) { return { device, data }; }
+
+// Connects without blocking. This uses the socket's on_connected hook, so don't set it yourself.
+inline ConnectAwaiter async_connect(Socket& socket, const SocketAddress& address, int port = -1) { return { socket, address, port }; }
+
+inline SleepAwaiter async_sleep(int milliseconds) { return SleepAwaiter { milliseconds }; }
+
+Task<bool> async_read_exactly(IODevice&, Bytes);
+Task<bool> async_write_all(IODevice&, ReadonlyBytes);
+
+}
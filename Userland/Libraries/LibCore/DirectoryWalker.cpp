@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <LibCore/DirectoryWalker.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace Core {
+
+bool DirectoryWalker::Entry::is_directory() const
+{
+    if (has_metadata)
+        return S_ISDIR(metadata.st_mode);
+    return type == DT_DIR;
+}
+
+DirectoryWalker::DirectoryWalker(Options options)
+    : m_options(options)
+{
+    pthread_mutex_init(&m_mutex, nullptr);
+    pthread_cond_init(&m_work_cond, nullptr);
+    pthread_cond_init(&m_done_cond, nullptr);
+}
+
+DirectoryWalker::~DirectoryWalker()
+{
+    pthread_mutex_lock(&m_mutex);
+    m_exit_requested = true;
+    pthread_cond_broadcast(&m_work_cond);
+    pthread_mutex_unlock(&m_mutex);
+    for (auto worker : m_workers)
+        pthread_join(worker, nullptr);
+
+    pthread_cond_destroy(&m_done_cond);
+    pthread_cond_destroy(&m_work_cond);
+    pthread_mutex_destroy(&m_mutex);
+}
+
+DirectoryWalker::Listing DirectoryWalker::list_directory(const String& path, const Options& options)
+{
+    Listing listing;
+    DIR* dir = opendir(path.characters());
+    if (!dir) {
+        listing.error = errno;
+        return listing;
+    }
+
+    for (;;) {
+        errno = 0;
+        auto* dirent = readdir(dir);
+        if (!dirent) {
+            listing.error = errno;
+            break;
+        }
+        if (!strcmp(dirent->d_name, ".") || !strcmp(dirent->d_name, ".."))
+            continue;
+
+        Entry entry;
+        entry.name = dirent->d_name;
+        entry.inode = dirent->d_ino;
+        entry.type = dirent->d_type;
+        bool type_is_unclear = entry.type == DT_UNKNOWN || (options.follow_symlinks && entry.type == DT_LNK);
+        if (options.stat_entries || type_is_unclear) {
+            int flags = options.follow_symlinks ? 0 : AT_SYMLINK_NOFOLLOW;
+            if (fstatat(dirfd(dir), dirent->d_name, &entry.metadata, flags) < 0)
+                entry.metadata_error = errno;
+            else
+                entry.has_metadata = true;
+        }
+        listing.entries.append(move(entry));
+    }
+
+    closedir(dir);
+    return listing;
+}
+
+void DirectoryWalker::start_workers()
+{
+    if (!m_workers.is_empty())
+        return;
+    long processor_count = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t worker_count = min(max(processor_count, 1l), (long)max(m_options.max_thread_count, (size_t)1));
+    for (size_t i = 0; i < worker_count; ++i) {
+        pthread_t thread;
+        int rc = pthread_create(
+            &thread, nullptr, [](void* walker) -> void* {
+                static_cast<DirectoryWalker*>(walker)->worker_main();
+                return nullptr;
+            },
+            this);
+        // Without workers, list() does all the work itself.
+        if (rc != 0)
+            break;
+        m_workers.append(thread);
+    }
+}
+
+void DirectoryWalker::worker_main()
+{
+    pthread_mutex_lock(&m_mutex);
+    for (;;) {
+        while (m_queue.is_empty() && !m_exit_requested)
+            pthread_cond_wait(&m_work_cond, &m_mutex);
+        if (m_exit_requested)
+            break;
+
+        auto job = m_queue.take_last();
+        job->state = Job::State::Running;
+        pthread_mutex_unlock(&m_mutex);
+        auto listing = list_directory(job->path, m_options);
+        pthread_mutex_lock(&m_mutex);
+        job->listing = move(listing);
+        job->state = Job::State::Done;
+        pthread_cond_broadcast(&m_done_cond);
+    }
+    pthread_mutex_unlock(&m_mutex);
+}
+
+void DirectoryWalker::prefetch(const Vector<String>& paths)
+{
+    if (m_options.max_thread_count == 0 || paths.is_empty())
+        return;
+    start_workers();
+    if (m_workers.is_empty())
+        return;
+
+    pthread_mutex_lock(&m_mutex);
+    for (size_t i = paths.size(); i > 0 && m_jobs.size() < m_options.max_prefetched_directory_count; --i) {
+        auto& path = paths[i - 1];
+        if (m_jobs.contains(path))
+            continue;
+        auto job = adopt(*new Job);
+        job->path = path;
+        m_jobs.set(path, job);
+        m_queue.append(move(job));
+    }
+    pthread_cond_broadcast(&m_work_cond);
+    pthread_mutex_unlock(&m_mutex);
+}
+
+DirectoryWalker::Listing DirectoryWalker::list(const String& path)
+{
+    pthread_mutex_lock(&m_mutex);
+    auto it = m_jobs.find(path);
+    if (it == m_jobs.end()) {
+        pthread_mutex_unlock(&m_mutex);
+        return list_directory(path, m_options);
+    }
+
+    auto job = it->value;
+    m_jobs.remove(it);
+    if (job->state == Job::State::Queued) {
+        // No need to wait for a worker to get to it.
+        m_queue.remove_first_matching([&](auto& queued_job) { return queued_job.ptr() == job.ptr(); });
+        pthread_mutex_unlock(&m_mutex);
+        return list_directory(path, m_options);
+    }
+
+    while (job->state != Job::State::Done)
+        pthread_cond_wait(&m_done_cond, &m_mutex);
+    auto listing = move(job->listing);
+    pthread_mutex_unlock(&m_mutex);
+    return listing;
+}
+
+}
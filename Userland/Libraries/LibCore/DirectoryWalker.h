@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <AK/HashMap.h>
+#include <AK/Noncopyable.h>
+#include <AK/RefCounted.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+namespace Core {
+
+// Lists directories for programs that walk whole trees. The program asks for directories in
+// whatever order it visits them, and prefetches the ones it's going to visit soon: a few worker
+// threads list those in the background, and stat their entries too if asked to. Entries are
+// stat'ed relative to the open directory, so the kernel doesn't look up the whole path every time.
+class DirectoryWalker {
+    AK_MAKE_NONCOPYABLE(DirectoryWalker);
+    AK_MAKE_NONMOVABLE(DirectoryWalker);
+
+public:
+    struct Options {
+        // Get the metadata of every entry. Otherwise, only entries whose type the directory
+        // doesn't tell us (and symlinks, when following them) get stat'ed.
+        bool stat_entries { false };
+        bool follow_symlinks { false };
+        size_t max_thread_count { 4 };
+        // How many prefetched listings may be waiting to be picked up.
+        size_t max_prefetched_directory_count { 256 };
+    };
+
+    struct Entry {
+        String name;
+        ino_t inode { 0 };
+        unsigned char type { DT_UNKNOWN };
+        bool has_metadata { false };
+        // The errno from stat'ing the entry, if that failed.
+        int metadata_error { 0 };
+        struct stat metadata {};
+
+        bool is_directory() const;
+    };
+
+    struct Listing {
+        // The errno from opening or reading the directory, if that failed.
+        int error { 0 };
+        Vector<Entry> entries;
+    };
+
+    explicit DirectoryWalker(Options);
+    ~DirectoryWalker();
+
+    // Queues directories to be listed in the background, the first one first. Directories that
+    // don't fit in the queue are skipped; list() will get to them later.
+    void prefetch(const Vector<String>& paths);
+
+    // Returns the entries of the directory, except for "." and "..". Prefetched directories are
+    // taken from the background (waiting for them if needed), other ones are listed right away.
+    Listing list(const String& path);
+
+    static Listing list_directory(const String& path, const Options&);
+
+private:
+    struct Job : public RefCounted<Job> {
+        enum class State {
+            Queued,
+            Running,
+            Done,
+        };
+
+        String path;
+        State state { State::Queued };
+        Listing listing;
+    };
+
+    void start_workers();
+    void worker_main();
+
+    Options m_options;
+    Vector<pthread_t> m_workers;
+    bool m_exit_requested { false };
+
+    // Guards everything below.
+    pthread_mutex_t m_mutex;
+    // Idle workers wait on this.
+    pthread_cond_t m_work_cond;
+    // list() waits on this for a running job to finish.
+    pthread_cond_t m_done_cond;
+    HashMap<String, NonnullRefPtr<Job>> m_jobs;
+    // The most recently queued jobs get picked up first, so that depth-first walks get what they
+    // need next, soonest.
+    Vector<NonnullRefPtr<Job>> m_queue;
+};
+
+}
@@ -24,6 +24,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Atomic.h>
 #include <AK/Badge.h>
 #include <AK/ByteBuffer.h>
 #include <AK/Debug.h>
@@ -41,7 +42,7 @@
 #include <LibCore/Notifier.h>
 #include <LibCore/Object.h>
 #include <LibCore/SyscallUtils.h>
-#include <LibThread/Lock.h>
+#include <LibCore/Trace.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <signal.h>
@@ -55,6 +56,13 @@
 #include <time.h>
 #include <unistd.h>
 
+#if defined(__serenity__) || defined(__linux__)
+#    define EVENTLOOP_USE_EPOLL 1
+#    include <sys/epoll.h>
+#else
+#    define EVENTLOOP_USE_EPOLL 0
+#endif
+
 namespace Core {
 
 class RPCClient;
@@ -67,20 +75,51 @@ struct EventLoopTimer {
     TimerShouldFireWhenNotVisible fire_when_not_visible { TimerShouldFireWhenNotVisible::No };
     WeakPtr<Object> owner;
 
+    // Where this timer is in s_timer_heap, or -1 if it expired while its owner wasn't visible,
+    // in which case it's in s_timers_waiting_for_visibility instead.
+    ssize_t heap_index { -1 };
+
     void reload(const timeval& now);
     bool has_expired(const timeval& now) const;
+    bool fires_before(const EventLoopTimer& other) const;
+    bool should_wait_for_visibility() const;
 };
 
 struct EventLoop::Private {
-    LibThread::Lock lock;
+    // Events posted from other threads than the one the event loop runs on. Those threads push onto
+    // this stack without taking a lock, and the event loop takes all of them at once when it pumps.
+    struct ForeignEvent {
+        ForeignEvent* next { nullptr };
+        QueuedEvent queued_event;
+    };
+    Atomic<ForeignEvent*> foreign_events { nullptr };
+
+    // The address of a thread_local is different in every thread, which makes it a cheap thread ID.
+    const void* thread_identity { nullptr };
+
+    ~Private()
+    {
+        for (auto* event = foreign_events.load(); event;)
+            delete exchange(event, event->next);
+    }
 };
 
+static thread_local char s_thread_identity;
+
 static EventLoop* s_main_event_loop;
 static Vector<EventLoop*>* s_event_loop_stack;
 static NeverDestroyed<IDAllocator> s_id_allocator;
 static HashMap<int, NonnullOwnPtr<EventLoopTimer>>* s_timers;
-static HashTable<Notifier*>* s_notifiers;
+// A binary min-heap of the timers, ordered by when they fire next.
+static Vector<EventLoopTimer*>* s_timer_heap;
+static Vector<EventLoopTimer*>* s_timers_waiting_for_visibility;
+static void insert_timer_into_heap(EventLoopTimer&);
+static void remove_timer_from_heap(EventLoopTimer&);
+static HashMap<int, Vector<Notifier*, 1>>* s_notifiers_by_fd;
 int EventLoop::s_wake_pipe_fds[2];
+#if EVENTLOOP_USE_EPOLL
+static int s_epoll_fd = -1;
+#endif
 static RefPtr<LocalServer> s_rpc_server;
 HashMap<int, RefPtr<RPCClient>> s_rpc_clients;
 
@@ -138,6 +177,19 @@ inline SignalHandlersInfo* signals_info()
     return AK::Singleton<SignalHandlersInfo>::get(s_signals);
 }
 
+struct MemoryPressureHandlersInfo {
+    HashMap<int, Function<void(EventLoop::MemoryPressure)>> handlers;
+    int next_handler_id { 1 };
+    int fd { -1 };
+    RefPtr<Notifier> notifier;
+};
+
+static MemoryPressureHandlersInfo* memory_pressure_info()
+{
+    static MemoryPressureHandlersInfo* s_memory_pressure;
+    return AK::Singleton<MemoryPressureHandlersInfo>::get(s_memory_pressure);
+}
+
 pid_t EventLoop::s_pid;
 
 class RPCClient : public Object {
@@ -258,6 +310,22 @@ public:
             return;
         }
 
+        if (type == "SetTracingEnabled") {
+            bool enabled = request.get("enabled").to_bool();
+            if (enabled)
+                Trace::clear();
+            Trace::set_enabled(enabled);
+            return;
+        }
+
+        if (type == "GetTrace") {
+            JsonObject response;
+            response.set("type", type);
+            response.set("trace", Trace::to_chrome_trace_json());
+            send_response(response);
+            return;
+        }
+
         if (type == "Disconnect") {
             shutdown();
             return;
@@ -279,10 +347,14 @@ private:
 EventLoop::EventLoop()
     : m_private(make<Private>())
 {
+    m_private->thread_identity = &s_thread_identity;
+
     if (!s_event_loop_stack) {
         s_event_loop_stack = new Vector<EventLoop*>;
         s_timers = new HashMap<int, NonnullOwnPtr<EventLoopTimer>>;
-        s_notifiers = new HashTable<Notifier*>;
+        s_timer_heap = new Vector<EventLoopTimer*>;
+        s_timers_waiting_for_visibility = new Vector<EventLoopTimer*>;
+        s_notifiers_by_fd = new HashMap<int, Vector<Notifier*, 1>>;
     }
 
     if (!s_main_event_loop) {
@@ -297,6 +369,9 @@ EventLoop::EventLoop()
 
 #endif
         VERIFY(rc == 0);
+#if EVENTLOOP_USE_EPOLL
+        create_epoll_instance();
+#endif
         s_event_loop_stack->append(this);
 
 #ifdef __serenity__
@@ -398,11 +473,8 @@ void EventLoop::pump(WaitMode mode)
 {
     wait_for_event(mode);
 
-    decltype(m_queued_events) events;
-    {
-        LOCKER(m_private->lock);
-        events = move(m_queued_events);
-    }
+    take_foreign_events();
+    auto events = move(m_queued_events);
 
     for (size_t i = 0; i < events.size(); ++i) {
         auto& queued_event = events.at(i);
@@ -434,7 +506,6 @@ void EventLoop::pump(WaitMode mode)
         }
 
         if (m_exit_requested) {
-            LOCKER(m_private->lock);
 #if EVENTLOOP_DEBUG
             dbgln("Core::EventLoop: Exit requested. Rejigging {} events.", events.size() - i);
 #endif
@@ -451,13 +522,42 @@ void EventLoop::pump(WaitMode mode)
 
 void EventLoop::post_event(Object& receiver, NonnullOwnPtr<Event>&& event)
 {
-    LOCKER(m_private->lock);
+    if (m_private->thread_identity != &s_thread_identity) {
+        auto* foreign_event = new Private::ForeignEvent { nullptr, QueuedEvent(receiver, move(event)) };
+        auto* next = m_private->foreign_events.load(AK::MemoryOrder::memory_order_relaxed);
+        do {
+            foreign_event->next = next;
+        } while (!m_private->foreign_events.compare_exchange_strong(next, foreign_event, AK::MemoryOrder::memory_order_release));
+        return;
+    }
 #if EVENTLOOP_DEBUG
     dbgln("Core::EventLoop::post_event: ({}) << receivier={}, event={}", m_queued_events.size(), receiver, event);
 #endif
     m_queued_events.empend(receiver, move(event));
 }
 
+void EventLoop::take_foreign_events()
+{
+    auto* foreign_events = m_private->foreign_events.exchange(nullptr, AK::MemoryOrder::memory_order_acquire);
+    if (!foreign_events)
+        return;
+
+    // The stack has the most recently posted event on top, so put it back in the order the events were posted in.
+    Private::ForeignEvent* reversed_events = nullptr;
+    while (foreign_events)
+        reversed_events = exchange(foreign_events, exchange(foreign_events->next, reversed_events));
+    while (reversed_events) {
+        m_queued_events.append(move(reversed_events->queued_event));
+        delete exchange(reversed_events, reversed_events->next);
+    }
+}
+
+void EventLoop::take_pending_events_from(EventLoop& other)
+{
+    other.take_foreign_events();
+    m_queued_events.append(move(other.m_queued_events));
+}
+
 SignalHandlers::SignalHandlers(int signo, void (*handle_signal)(int))
     : m_signo(signo)
     , m_original_handler(signal(signo, handle_signal))
@@ -592,6 +692,60 @@ void EventLoop::unregister_signal(int handler_id)
         info.signal_handlers.remove(remove_signo);
 }
 
+static Optional<EventLoop::MemoryPressure> read_memory_pressure_level(int fd)
+{
+    char buffer[16];
+    ssize_t nread = read(fd, buffer, sizeof(buffer));
+    if (nread <= 0)
+        return {};
+    auto level = StringView(buffer, nread).trim_whitespace();
+    if (level == "low")
+        return EventLoop::MemoryPressure::Low;
+    if (level == "medium")
+        return EventLoop::MemoryPressure::Medium;
+    if (level == "critical")
+        return EventLoop::MemoryPressure::Critical;
+    dbgln("Core::EventLoop: Unknown memory pressure level '{}'", level);
+    return {};
+}
+
+int EventLoop::register_memory_pressure_handler(Function<void(MemoryPressure)> handler)
+{
+    auto& info = *memory_pressure_info();
+    if (info.fd < 0) {
+        info.fd = open("/dev/mempressure", O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (info.fd < 0) {
+            dbgln_if(EVENTLOOP_DEBUG, "Core::EventLoop: Can't open /dev/mempressure: {}", strerror(errno));
+        } else {
+            info.notifier = Notifier::construct(info.fd, Notifier::Read);
+            info.notifier->on_ready_to_read = [] {
+                auto& info = *memory_pressure_info();
+                auto level = read_memory_pressure_level(info.fd);
+                if (!level.has_value())
+                    return;
+                // Handlers may unregister themselves (or others), so iterate over a snapshot.
+                Vector<int> handler_ids;
+                for (auto& it : info.handlers)
+                    handler_ids.append(it.key);
+                for (auto handler_id : handler_ids) {
+                    auto it = info.handlers.find(handler_id);
+                    if (it != info.handlers.end())
+                        it->value(level.value());
+                }
+            };
+        }
+    }
+    int handler_id = info.next_handler_id++;
+    info.handlers.set(handler_id, move(handler));
+    return handler_id;
+}
+
+void EventLoop::unregister_memory_pressure_handler(int handler_id)
+{
+    VERIFY(handler_id != 0);
+    memory_pressure_info()->handlers.remove(handler_id);
+}
+
 void EventLoop::notify_forked(ForkEvent event)
 {
     switch (event) {
@@ -599,7 +753,14 @@ void EventLoop::notify_forked(ForkEvent event)
         s_main_event_loop = nullptr;
         s_event_loop_stack->clear();
         s_timers->clear();
-        s_notifiers->clear();
+        s_timer_heap->clear();
+        s_timers_waiting_for_visibility->clear();
+        s_notifiers_by_fd->clear();
+#if EVENTLOOP_USE_EPOLL
+        // The epoll instance is shared with the parent, so don't touch its registrations.
+        close(s_epoll_fd);
+        s_epoll_fd = -1;
+#endif
         if (auto* info = signals_info<false>()) {
             info->signal_handlers.clear();
             info->next_signal_id = 0;
@@ -617,36 +778,12 @@ void EventLoop::notify_forked(ForkEvent event)
 
 void EventLoop::wait_for_event(WaitMode mode)
 {
+#if !EVENTLOOP_USE_EPOLL
     fd_set rfds;
     fd_set wfds;
+#endif
 retry:
-    FD_ZERO(&rfds);
-    FD_ZERO(&wfds);
-
-    int max_fd = 0;
-    auto add_fd_to_set = [&max_fd](int fd, fd_set& set) {
-        FD_SET(fd, &set);
-        if (fd > max_fd)
-            max_fd = fd;
-    };
-
-    int max_fd_added = -1;
-    add_fd_to_set(s_wake_pipe_fds[0], rfds);
-    max_fd = max(max_fd, max_fd_added);
-    for (auto& notifier : *s_notifiers) {
-        if (notifier->event_mask() & Notifier::Read)
-            add_fd_to_set(notifier->fd(), rfds);
-        if (notifier->event_mask() & Notifier::Write)
-            add_fd_to_set(notifier->fd(), wfds);
-        if (notifier->event_mask() & Notifier::Exceptional)
-            VERIFY_NOT_REACHED();
-    }
-
-    bool queued_events_is_empty;
-    {
-        LOCKER(m_private->lock);
-        queued_events_is_empty = m_queued_events.is_empty();
-    }
+    bool queued_events_is_empty = m_queued_events.is_empty() && !m_private->foreign_events.load(AK::MemoryOrder::memory_order_relaxed);
 
     timeval now;
     struct timeval timeout = { 0, 0 };
@@ -668,14 +805,45 @@ retry:
         }
     }
 
-try_select_again:
+#if EVENTLOOP_USE_EPOLL
+    // Round up, so that we don't wake up just before a timer is due and spin until it is.
+    int timeout_ms = should_wait_forever ? -1 : timeout.tv_sec * 1000 + (timeout.tv_usec + 999) / 1000;
+    epoll_event ready_events[64];
+
+try_wait_again:
+    int marked_fd_count = epoll_wait(s_epoll_fd, ready_events, array_size(ready_events), timeout_ms);
+#else
+    FD_ZERO(&rfds);
+    FD_ZERO(&wfds);
+
+    int max_fd = 0;
+    auto add_fd_to_set = [&max_fd](int fd, fd_set& set) {
+        FD_SET(fd, &set);
+        if (fd > max_fd)
+            max_fd = fd;
+    };
+
+    add_fd_to_set(s_wake_pipe_fds[0], rfds);
+    for (auto& it : *s_notifiers_by_fd) {
+        for (auto* notifier : it.value) {
+            if (notifier->event_mask() & Notifier::Read)
+                add_fd_to_set(notifier->fd(), rfds);
+            if (notifier->event_mask() & Notifier::Write)
+                add_fd_to_set(notifier->fd(), wfds);
+            if (notifier->event_mask() & Notifier::Exceptional)
+                VERIFY_NOT_REACHED();
+        }
+    }
+
+try_wait_again:
     int marked_fd_count = select(max_fd + 1, &rfds, &wfds, nullptr, should_wait_forever ? nullptr : &timeout);
+#endif
     if (marked_fd_count < 0) {
         int saved_errno = errno;
         if (saved_errno == EINTR) {
             if (m_exit_requested)
                 return;
-            goto try_select_again;
+            goto try_wait_again;
         }
 #if EVENTLOOP_DEBUG
         dbgln("Core::EventLoop::wait_for_event: {} ({}: {})", marked_fd_count, saved_errno, strerror(saved_errno));
@@ -683,7 +851,17 @@ try_select_again:
         // Blow up, similar to Core::safe_syscall.
         VERIFY_NOT_REACHED();
     }
-    if (FD_ISSET(s_wake_pipe_fds[0], &rfds)) {
+
+#if EVENTLOOP_USE_EPOLL
+    bool wake_pipe_is_readable = false;
+    for (int i = 0; i < marked_fd_count; ++i) {
+        if (ready_events[i].data.fd == s_wake_pipe_fds[0])
+            wake_pipe_is_readable = true;
+    }
+#else
+    bool wake_pipe_is_readable = FD_ISSET(s_wake_pipe_fds[0], &rfds);
+#endif
+    if (wake_pipe_is_readable) {
         int wake_events[8];
         auto nread = read(s_wake_pipe_fds[0], wake_events, sizeof(wake_events));
         if (nread < 0) {
@@ -711,22 +889,37 @@ try_select_again:
         now.tv_usec = now_spec.tv_nsec / 1000;
     }
 
-    for (auto& it : *s_timers) {
-        auto& timer = *it.value;
-        if (!timer.has_expired(now))
-            continue;
-        auto owner = timer.owner.strong_ref();
-        if (timer.fire_when_not_visible == TimerShouldFireWhenNotVisible::No
-            && owner && !owner->is_visible_for_timer_purposes()) {
+    Vector<EventLoopTimer*, 8> expired_timers;
+    for (size_t i = 0; i < s_timers_waiting_for_visibility->size();) {
+        auto* timer = s_timers_waiting_for_visibility->at(i);
+        if (timer->should_wait_for_visibility()) {
+            ++i;
             continue;
         }
+        expired_timers.append(timer);
+        s_timers_waiting_for_visibility->remove(i);
+    }
+    // Take all the expired timers out of the heap before reloading any, so that timers with an
+    // interval of 0 don't keep us here forever.
+    while (!s_timer_heap->is_empty() && s_timer_heap->first()->has_expired(now)) {
+        auto* timer = s_timer_heap->first();
+        remove_timer_from_heap(*timer);
+        if (timer->should_wait_for_visibility())
+            s_timers_waiting_for_visibility->append(timer);
+        else
+            expired_timers.append(timer);
+    }
+
+    for (auto* timer : expired_timers) {
+        auto owner = timer->owner.strong_ref();
 #if EVENTLOOP_DEBUG
-        dbgln("Core::EventLoop: Timer {} has expired, sending Core::TimerEvent to {}", timer.timer_id, *owner);
+        dbgln("Core::EventLoop: Timer {} has expired, sending Core::TimerEvent to {}", timer->timer_id, *owner);
 #endif
         if (owner)
-            post_event(*owner, make<TimerEvent>(timer.timer_id));
-        if (timer.should_reload) {
-            timer.reload(now);
+            post_event(*owner, make<TimerEvent>(timer->timer_id));
+        if (timer->should_reload) {
+            timer->reload(now);
+            insert_timer_into_heap(*timer);
         } else {
             // FIXME: Support removing expired timers that don't want to reload.
             VERIFY_NOT_REACHED();
@@ -736,16 +929,36 @@ try_select_again:
     if (!marked_fd_count)
         return;
 
-    for (auto& notifier : *s_notifiers) {
-        if (FD_ISSET(notifier->fd(), &rfds)) {
-            if (notifier->event_mask() & Notifier::Event::Read)
+#if EVENTLOOP_USE_EPOLL
+    for (int i = 0; i < marked_fd_count; ++i) {
+        auto& ready_event = ready_events[i];
+        auto it = s_notifiers_by_fd->find(ready_event.data.fd);
+        if (it == s_notifiers_by_fd->end())
+            continue;
+        // Like select(), treat errors and hangups as readiness, so that the next read or write reports them.
+        bool is_readable = ready_event.events & (EPOLLIN | EPOLLERR | EPOLLHUP);
+        bool is_writable = ready_event.events & (EPOLLOUT | EPOLLERR | EPOLLHUP);
+        for (auto* notifier : it->value) {
+            if (is_readable && (notifier->event_mask() & Notifier::Event::Read))
                 post_event(*notifier, make<NotifierReadEvent>(notifier->fd()));
-        }
-        if (FD_ISSET(notifier->fd(), &wfds)) {
-            if (notifier->event_mask() & Notifier::Event::Write)
+            if (is_writable && (notifier->event_mask() & Notifier::Event::Write))
                 post_event(*notifier, make<NotifierWriteEvent>(notifier->fd()));
         }
     }
+#else
+    for (auto& it : *s_notifiers_by_fd) {
+        for (auto* notifier : it.value) {
+            if (FD_ISSET(notifier->fd(), &rfds)) {
+                if (notifier->event_mask() & Notifier::Event::Read)
+                    post_event(*notifier, make<NotifierReadEvent>(notifier->fd()));
+            }
+            if (FD_ISSET(notifier->fd(), &wfds)) {
+                if (notifier->event_mask() & Notifier::Event::Write)
+                    post_event(*notifier, make<NotifierWriteEvent>(notifier->fd()));
+            }
+        }
+    }
+#endif
 }
 
 bool EventLoopTimer::has_expired(const timeval& now) const
@@ -760,20 +973,90 @@ void EventLoopTimer::reload(const timeval& now)
     fire_time.tv_usec += (interval % 1000) * 1000;
 }
 
-Optional<struct timeval> EventLoop::get_next_timer_expiration()
+bool EventLoopTimer::fires_before(const EventLoopTimer& other) const
 {
-    Optional<struct timeval> soonest {};
-    for (auto& it : *s_timers) {
-        auto& fire_time = it.value->fire_time;
-        auto owner = it.value->owner.strong_ref();
-        if (it.value->fire_when_not_visible == TimerShouldFireWhenNotVisible::No
-            && owner && !owner->is_visible_for_timer_purposes()) {
-            continue;
+    return fire_time.tv_sec < other.fire_time.tv_sec || (fire_time.tv_sec == other.fire_time.tv_sec && fire_time.tv_usec < other.fire_time.tv_usec);
+}
+
+bool EventLoopTimer::should_wait_for_visibility() const
+{
+    if (fire_when_not_visible == TimerShouldFireWhenNotVisible::Yes)
+        return false;
+    auto owner = this->owner.strong_ref();
+    return owner && !owner->is_visible_for_timer_purposes();
+}
+
+static void swap_timers_in_heap(size_t a, size_t b)
+{
+    auto& heap = *s_timer_heap;
+    swap(heap[a], heap[b]);
+    heap[a]->heap_index = a;
+    heap[b]->heap_index = b;
+}
+
+static void sift_timer_up(size_t index)
+{
+    auto& heap = *s_timer_heap;
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (!heap[index]->fires_before(*heap[parent]))
+            break;
+        swap_timers_in_heap(index, parent);
+        index = parent;
+    }
+}
+
+static void sift_timer_down(size_t index)
+{
+    auto& heap = *s_timer_heap;
+    for (;;) {
+        size_t soonest = index;
+        for (size_t child = index * 2 + 1; child <= index * 2 + 2 && child < heap.size(); ++child) {
+            if (heap[child]->fires_before(*heap[soonest]))
+                soonest = child;
         }
-        if (!soonest.has_value() || fire_time.tv_sec < soonest.value().tv_sec || (fire_time.tv_sec == soonest.value().tv_sec && fire_time.tv_usec < soonest.value().tv_usec))
-            soonest = fire_time;
+        if (soonest == index)
+            break;
+        swap_timers_in_heap(index, soonest);
+        index = soonest;
     }
-    return soonest;
+}
+
+static void insert_timer_into_heap(EventLoopTimer& timer)
+{
+    VERIFY(timer.heap_index == -1);
+    timer.heap_index = s_timer_heap->size();
+    s_timer_heap->append(&timer);
+    sift_timer_up(timer.heap_index);
+}
+
+static void remove_timer_from_heap(EventLoopTimer& timer)
+{
+    size_t index = timer.heap_index;
+    VERIFY(s_timer_heap->at(index) == &timer);
+    size_t last_index = s_timer_heap->size() - 1;
+    if (index != last_index)
+        swap_timers_in_heap(index, last_index);
+    s_timer_heap->take_last();
+    timer.heap_index = -1;
+    if (index != last_index) {
+        sift_timer_up(index);
+        sift_timer_down(index);
+    }
+}
+
+Optional<struct timeval> EventLoop::get_next_timer_expiration()
+{
+    // Timers that are waiting for their owner to become visible have expired already, so if one of
+    // them can fire now, there's no need to wait at all.
+    for (auto* timer : *s_timers_waiting_for_visibility) {
+        if (!timer->should_wait_for_visibility())
+            return timer->fire_time;
+    }
+    // FIXME: The soonest timer may belong to an owner that isn't visible, in which case we wake up for nothing once.
+    if (s_timer_heap->is_empty())
+        return {};
+    return s_timer_heap->first()->fire_time;
 }
 
 int EventLoop::register_timer(Object& object, int milliseconds, bool should_reload, TimerShouldFireWhenNotVisible fire_when_not_visible)
@@ -792,6 +1075,7 @@ int EventLoop::register_timer(Object& object, int milliseconds, bool should_relo
     timer->fire_when_not_visible = fire_when_not_visible;
     int timer_id = s_id_allocator->allocate();
     timer->timer_id = timer_id;
+    insert_timer_into_heap(*timer);
     s_timers->set(timer_id, move(timer));
     return timer_id;
 }
@@ -802,18 +1086,99 @@ bool EventLoop::unregister_timer(int timer_id)
     auto it = s_timers->find(timer_id);
     if (it == s_timers->end())
         return false;
+    auto& timer = *it->value;
+    if (timer.heap_index >= 0)
+        remove_timer_from_heap(timer);
+    else
+        s_timers_waiting_for_visibility->remove_first_matching([&](auto* entry) { return entry == &timer; });
     s_timers->remove(it);
     return true;
 }
 
+#if EVENTLOOP_USE_EPOLL
+void EventLoop::create_epoll_instance()
+{
+    s_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    VERIFY(s_epoll_fd >= 0);
+
+    epoll_event wake_event {};
+    wake_event.events = EPOLLIN;
+    wake_event.data.fd = s_wake_pipe_fds[0];
+    int rc = epoll_ctl(s_epoll_fd, EPOLL_CTL_ADD, s_wake_pipe_fds[0], &wake_event);
+    VERIFY(rc == 0);
+
+    // Notifiers may have been set up before the main loop (e.g. right after a fork).
+    for (auto& it : *s_notifiers_by_fd)
+        update_epoll_registration(it.key);
+}
+
+void EventLoop::update_epoll_registration(int fd)
+{
+    if (s_epoll_fd < 0)
+        return;
+
+    unsigned events = 0;
+    auto it = s_notifiers_by_fd->find(fd);
+    if (it != s_notifiers_by_fd->end()) {
+        for (auto* notifier : it->value) {
+            if (notifier->event_mask() & Notifier::Read)
+                events |= EPOLLIN;
+            if (notifier->event_mask() & Notifier::Write)
+                events |= EPOLLOUT;
+            if (notifier->event_mask() & Notifier::Exceptional)
+                VERIFY_NOT_REACHED();
+        }
+    }
+
+    if (!events) {
+        // This fails harmlessly if the fd was closed already, as that drops it from the epoll set.
+        epoll_ctl(s_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+        return;
+    }
+
+    epoll_event event {};
+    event.events = events;
+    event.data.fd = fd;
+    if (epoll_ctl(s_epoll_fd, EPOLL_CTL_MOD, fd, &event) == 0)
+        return;
+    if (errno == ENOENT && epoll_ctl(s_epoll_fd, EPOLL_CTL_ADD, fd, &event) == 0)
+        return;
+    dbgln("Core::EventLoop: Failed to watch fd {}: {}", fd, strerror(errno));
+}
+#endif
+
 void EventLoop::register_notifier(Badge<Notifier>, Notifier& notifier)
 {
-    s_notifiers->set(&notifier);
+    auto& notifiers = s_notifiers_by_fd->ensure(notifier.fd());
+    if (!notifiers.contains_slow(&notifier))
+        notifiers.append(&notifier);
+#if EVENTLOOP_USE_EPOLL
+    update_epoll_registration(notifier.fd());
+#endif
 }
 
 void EventLoop::unregister_notifier(Badge<Notifier>, Notifier& notifier)
 {
-    s_notifiers->remove(&notifier);
+    auto it = s_notifiers_by_fd->find(notifier.fd());
+    if (it == s_notifiers_by_fd->end())
+        return;
+    it->value.remove_first_matching([&](auto* entry) { return entry == &notifier; });
+    if (it->value.is_empty())
+        s_notifiers_by_fd->remove(it);
+#if EVENTLOOP_USE_EPOLL
+    update_epoll_registration(notifier.fd());
+#endif
+}
+
+void EventLoop::did_change_notifier_event_mask(Badge<Notifier>, Notifier& notifier)
+{
+#if EVENTLOOP_USE_EPOLL
+    auto it = s_notifiers_by_fd->find(notifier.fd());
+    if (it != s_notifiers_by_fd->end() && it->value.contains_slow(&notifier))
+        update_epoll_registration(notifier.fd());
+#else
+    (void)notifier;
+#endif
 }
 
 void EventLoop::wake()
@@ -67,20 +67,28 @@ public:
 
     static void register_notifier(Badge<Notifier>, Notifier&);
     static void unregister_notifier(Badge<Notifier>, Notifier&);
+    static void did_change_notifier_event_mask(Badge<Notifier>, Notifier&);
 
     void quit(int);
     void unquit();
 
-    void take_pending_events_from(EventLoop& other)
-    {
-        m_queued_events.append(move(other.m_queued_events));
-    }
+    void take_pending_events_from(EventLoop& other);
 
     static void wake();
 
     static int register_signal(int signo, Function<void(int)> handler);
     static void unregister_signal(int handler_id);
 
+    // Handlers are called from the event loop whenever the kernel's memory pressure
+    // level (as reported by /dev/mempressure) changes.
+    enum class MemoryPressure {
+        Low,
+        Medium,
+        Critical,
+    };
+    static int register_memory_pressure_handler(Function<void(MemoryPressure)> handler);
+    static void unregister_memory_pressure_handler(int handler_id);
+
     // Note: Boost uses Parent/Child/Prepare, but we don't really have anything
     //       interesting to do in the parent or before forking.
     enum class ForkEvent {
@@ -91,7 +99,10 @@ public:
 private:
     bool start_rpc_server();
     void wait_for_event(WaitMode);
+    static void create_epoll_instance();
+    static void update_epoll_registration(int fd);
     Optional<struct timeval> get_next_timer_expiration();
+    void take_foreign_events();
     static void dispatch_signal(int);
     static void handle_signal(int);
 
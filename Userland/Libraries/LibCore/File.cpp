@@ -350,6 +350,15 @@ Result<void, File::CopyError> File::copy_file(const String& dst_path, const stru
             return CopyError { OSError(errno), false };
     }
 
+    // Have the kernel copy the data between the two files without going through our memory.
+    // That only works between regular files; copy anything else (or whatever is left after an error,
+    // which the loop below will run into and report) by hand.
+    for (;;) {
+        ssize_t ncopied = copy_file_range(source.fd(), nullptr, dst_fd, nullptr, 16 * MiB, 0);
+        if (ncopied <= 0)
+            break;
+    }
+
     for (;;) {
         char buffer[32768];
         ssize_t nread = ::read(source.fd(), buffer, sizeof(buffer));
@@ -93,6 +93,9 @@ public:
 
     bool can_read() const;
 
+    // The number of bytes that have been read from the file descriptor but not consumed yet.
+    size_t buffered_size() const { return m_buffered_data.size(); }
+
     enum class SeekMode {
         SetPosition,
         FromCurrentPosition,
@@ -49,6 +49,12 @@ public:
     Function<void(bool success)> on_finish;
     Function<void(Optional<u32>, u32)> on_progress;
 
+    // Called when the output stream can't take any more of the response for now. If this is set,
+    // the job stops reading from the network until it's told to go on with resume_output(),
+    // instead of buffering everything that arrives in the meantime.
+    Function<void()> on_output_blocked;
+    virtual void resume_output() { }
+
     bool is_cancelled() const { return m_error == Error::Cancelled; }
     bool has_error() const { return m_error != Error::None; }
     Error error() const { return m_error; }
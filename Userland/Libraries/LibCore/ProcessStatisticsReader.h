@@ -48,6 +48,12 @@ struct ThreadStatistics {
     unsigned ipv4_socket_write_bytes;
     unsigned file_read_bytes;
     unsigned file_write_bytes;
+    unsigned minor_faults;
+    unsigned major_faults;
+    unsigned voluntary_context_switches;
+    unsigned involuntary_context_switches;
+    u64 block_io_wait_us;
+    u64 scheduler_latency_us;
     String state;
     u32 cpu;
     u32 priority;
@@ -55,7 +61,7 @@ struct ThreadStatistics {
 };
 
 struct ProcessStatistics {
-    // Keep this in sync with /proc/all.
+    // Keep this in sync with /proc/all and /proc/stats.
     // From the kernel side:
     pid_t pid;
     pid_t pgid;
@@ -187,6 +187,13 @@ bool Socket::send(ReadonlyBytes data)
     return true;
 }
 
+void Socket::set_read_notifications_enabled(bool enabled)
+{
+    m_read_notifications_enabled = enabled;
+    if (m_read_notifier)
+        m_read_notifier->set_enabled(enabled);
+}
+
 void Socket::did_update_fd(int fd)
 {
     if (fd < 0) {
@@ -212,6 +219,7 @@ void Socket::ensure_read_notifier()
 {
     VERIFY(m_connected);
     m_read_notifier = Notifier::construct(fd(), Notifier::Event::Read, this);
+    m_read_notifier->set_enabled(m_read_notifications_enabled);
     m_read_notifier->on_ready_to_read = [this] {
         if (!can_read())
             return;
@@ -56,6 +56,11 @@ public:
     bool is_connected() const { return m_connected; }
     void set_blocking(bool blocking);
 
+    // Lets users stop hearing about incoming data for a while, e.g. to apply backpressure
+    // while they have other things to do, or after the peer has closed its end.
+    void set_read_notifications_enabled(bool);
+    bool read_notifications_enabled() const { return m_read_notifications_enabled; }
+
     SocketAddress source_address() const { return m_source_address; }
     int source_port() const { return m_source_port; }
 
@@ -82,6 +87,7 @@ private:
     void ensure_read_notifier();
 
     Type m_type { Type::Invalid };
+    bool m_read_notifications_enabled { true };
     RefPtr<Notifier> m_notifier;
     RefPtr<Notifier> m_read_notifier;
 };
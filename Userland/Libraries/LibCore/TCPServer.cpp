@@ -29,6 +29,7 @@
 #include <LibCore/Notifier.h>
 #include <LibCore/TCPServer.h>
 #include <LibCore/TCPSocket.h>
+#include <errno.h>
 #include <stdio.h>
 #include <sys/socket.h>
 
@@ -90,13 +91,21 @@ RefPtr<TCPSocket> TCPServer::accept()
     socklen_t in_size = sizeof(in);
     int accepted_fd = ::accept(m_fd, (sockaddr*)&in, &in_size);
     if (accepted_fd < 0) {
-        perror("accept");
+        // Another process sharing this socket may have taken the connection already.
+        if (errno != EAGAIN)
+            perror("accept");
         return nullptr;
     }
 
     return TCPSocket::construct(accepted_fd);
 }
 
+void TCPServer::resume_accepting_after_fork()
+{
+    VERIFY(m_listening);
+    m_notifier->set_enabled(true);
+}
+
 Optional<IPv4Address> TCPServer::local_address() const
 {
     if (m_fd == -1)
@@ -42,6 +42,10 @@ public:
 
     RefPtr<TCPSocket> accept();
 
+    // Core::EventLoop::notify_forked() forgets every notifier, so a forked child that
+    // keeps serving the same listening socket has to call this once its event loop exists.
+    void resume_accepting_after_fork();
+
     Optional<IPv4Address> local_address() const;
     Optional<u16> local_port() const;
 
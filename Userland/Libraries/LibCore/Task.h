@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Assertions.h>
+#include <AK/Function.h>
+#include <AK/Noncopyable.h>
+#include <AK/Optional.h>
+#include <AK/StdLibExtras.h>
+#include <coroutine>
+
+namespace Core {
+
+template<typename T = void>
+class Task;
+
+namespace Detail {
+
+class TaskPromiseBase {
+public:
+    // Tasks are lazy: nothing runs until they're awaited or started.
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+
+        template<typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+        {
+            auto& promise = handle.promise();
+            if (promise.m_continuation)
+                return promise.m_continuation;
+            if (promise.m_detached) {
+                promise.did_finish_detached();
+                handle.destroy();
+            }
+            return std::noop_coroutine();
+        }
+
+        void await_resume() noexcept { }
+    };
+
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() { VERIFY_NOT_REACHED(); }
+
+    std::coroutine_handle<> m_continuation;
+    bool m_detached { false };
+};
+
+template<typename T>
+class TaskPromise final : public TaskPromiseBase {
+public:
+    using CompletionHandler = Function<void(T&)>;
+
+    Task<T> get_return_object();
+    void return_value(T value) { m_result = move(value); }
+    T take_result() { return m_result.release_value(); }
+
+    void did_finish_detached()
+    {
+        if (m_on_complete)
+            m_on_complete(m_result.value());
+    }
+
+    CompletionHandler m_on_complete;
+
+private:
+    Optional<T> m_result;
+};
+
+template<>
+class TaskPromise<void> final : public TaskPromiseBase {
+public:
+    using CompletionHandler = Function<void()>;
+
+    Task<void> get_return_object();
+    void return_void() { }
+    void take_result() { }
+
+    void did_finish_detached()
+    {
+        if (m_on_complete)
+            m_on_complete();
+    }
+
+    CompletionHandler m_on_complete;
+};
+
+}
+
+// The return type of a coroutine that runs on the Core::EventLoop. Awaiting a Task from
+// another coroutine runs it and hands over its result; start() runs it from regular code.
+// NOTE: GCC silently drops coroutines that co_await inside an if or while condition,
+//       so await into a local variable first and test that.
+template<typename T>
+class [[nodiscard]] Task {
+    AK_MAKE_NONCOPYABLE(Task);
+
+public:
+    using promise_type = Detail::TaskPromise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    explicit Task(Handle handle)
+        : m_handle(handle)
+    {
+    }
+
+    Task(Task&& other)
+        : m_handle(exchange(other.m_handle, {}))
+    {
+    }
+
+    Task& operator=(Task&& other)
+    {
+        if (this != &other) {
+            if (m_handle)
+                m_handle.destroy();
+            m_handle = exchange(other.m_handle, {});
+        }
+        return *this;
+    }
+
+    ~Task()
+    {
+        if (m_handle)
+            m_handle.destroy();
+    }
+
+    // Runs the task until its first suspension point, and lets it clean up after itself once it's done.
+    // If the event loop exits while the task is still suspended, the task is never resumed.
+    void start(typename promise_type::CompletionHandler on_complete = {})
+    {
+        VERIFY(m_handle);
+        auto handle = exchange(m_handle, {});
+        handle.promise().m_detached = true;
+        handle.promise().m_on_complete = move(on_complete);
+        handle.resume();
+    }
+
+    bool await_ready() const { return false; }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter)
+    {
+        VERIFY(m_handle);
+        m_handle.promise().m_continuation = awaiter;
+        return m_handle;
+    }
+
+    T await_resume() { return m_handle.promise().take_result(); }
+
+private:
+    Handle m_handle;
+};
+
+namespace Detail {
+
+template<typename T>
+Task<T> TaskPromise<T>::get_return_object()
+{
+    return Task<T> { Task<T>::Handle::from_promise(*this) };
+}
+
+inline Task<void> TaskPromise<void>::get_return_object()
+{
+    return Task<void> { Task<void>::Handle::from_promise(*this) };
+}
+
+}
+
+}
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/JsonArray.h>
+#include <AK/JsonObject.h>
+#include <AK/JsonObjectSerializer.h>
+#include <AK/JsonValue.h>
+#include <AK/String.h>
+#include <AK/StringBuilder.h>
+#include <AK/Vector.h>
+#include <LibCore/File.h>
+#include <LibCore/Trace.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace Core::Trace {
+
+Atomic<bool> g_enabled { false };
+
+struct Event {
+    const char* category;
+    const char* name;
+    u64 start_us;
+    u64 duration_us;
+};
+
+// Each thread only ever writes to its own buffer, so recording an event needs no locking.
+// Once full, a buffer starts overwriting its oldest events.
+struct ThreadBuffer {
+    static constexpr size_t capacity = 8192;
+
+    pid_t tid { 0 };
+    Atomic<size_t> next_index { 0 };
+    Event events[capacity];
+};
+
+// Buffers are never freed, so the events of threads that have already exited still end up in the trace.
+static pthread_mutex_t s_buffers_lock = PTHREAD_MUTEX_INITIALIZER;
+static Vector<ThreadBuffer*>* s_buffers;
+static thread_local ThreadBuffer* t_buffer;
+
+static const char* s_exit_dump_path;
+
+[[gnu::constructor]] static void initialize_from_environment()
+{
+    auto* value = getenv("SERENITY_TRACE");
+    if (!value)
+        return;
+    g_enabled = true;
+    if (value[0] == '/') {
+        s_exit_dump_path = value;
+        atexit([] {
+            if (!dump_chrome_trace(s_exit_dump_path))
+                warnln("Failed to write trace to {}", s_exit_dump_path);
+        });
+    }
+}
+
+void set_enabled(bool enabled)
+{
+    g_enabled = enabled;
+}
+
+u64 now_us()
+{
+    // This is the same clock the kernel timestamps its performance events with.
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1'000'000 + (u64)ts.tv_nsec / 1000;
+}
+
+static ThreadBuffer& buffer_for_current_thread()
+{
+    if (!t_buffer) {
+        t_buffer = new ThreadBuffer;
+        t_buffer->tid = gettid();
+        pthread_mutex_lock(&s_buffers_lock);
+        if (!s_buffers)
+            s_buffers = new Vector<ThreadBuffer*>;
+        s_buffers->append(t_buffer);
+        pthread_mutex_unlock(&s_buffers_lock);
+    }
+    return *t_buffer;
+}
+
+void record(const char* category, const char* name, u64 start_us, u64 duration_us)
+{
+    auto& buffer = buffer_for_current_thread();
+    auto index = buffer.next_index.load(AK::memory_order_relaxed);
+    buffer.events[index % ThreadBuffer::capacity] = { category, name, start_us, duration_us };
+    buffer.next_index.store(index + 1, AK::memory_order_release);
+}
+
+void clear()
+{
+    pthread_mutex_lock(&s_buffers_lock);
+    if (s_buffers) {
+        for (auto* buffer : *s_buffers)
+            buffer->next_index = 0;
+    }
+    pthread_mutex_unlock(&s_buffers_lock);
+}
+
+static String process_name()
+{
+#ifdef __serenity__
+    char buffer[1024];
+    if (get_process_name(buffer, sizeof(buffer)) >= 0)
+        return buffer;
+#endif
+    return String::number(getpid());
+}
+
+static void append_kernel_events(JsonArraySerializer<StringBuilder>& array)
+{
+    // /proc/<pid>/perf_events only exists while the process is being profiled.
+    auto file_or_error = File::open(String::formatted("/proc/{}/perf_events", getpid()), IODevice::ReadOnly);
+    if (file_or_error.is_error())
+        return;
+    auto json = JsonValue::from_string(file_or_error.value()->read_all());
+    if (!json.has_value() || !json.value().is_object())
+        return;
+
+    json.value().as_object().get("events").as_array().for_each([&](const JsonValue& value) {
+        auto& event = value.as_object();
+        auto type = event.get("type").to_string();
+        if (type == "sample" || type == "malloc" || type == "free")
+            return;
+        auto event_object = array.add_object();
+        event_object.add("name", type);
+        event_object.add("cat", "kernel");
+        event_object.add("ph", "i");
+        event_object.add("s", "t");
+        event_object.add("ts", event.get("timestamp").to_number<u64>() * 1000);
+        event_object.add("pid", getpid());
+        event_object.add("tid", event.get("tid").to_i32());
+        auto args = event_object.add_object("args");
+        args.add("arg1", event.get("arg1").to_number<u64>());
+        args.add("arg2", event.get("arg2").to_number<u64>());
+    });
+}
+
+String to_chrome_trace_json()
+{
+    StringBuilder builder;
+    JsonObjectSerializer object(builder);
+    auto array = object.add_array("traceEvents");
+
+    {
+        auto metadata = array.add_object();
+        metadata.add("name", "process_name");
+        metadata.add("ph", "M");
+        metadata.add("pid", getpid());
+        auto args = metadata.add_object("args");
+        args.add("name", process_name());
+    }
+
+    pthread_mutex_lock(&s_buffers_lock);
+    if (s_buffers) {
+        for (auto* buffer : *s_buffers) {
+            // Events that are being recorded while we read them may come out garbled, so stop
+            // tracing before dumping to get a clean trace.
+            size_t end = buffer->next_index.load(AK::memory_order_acquire);
+            size_t begin = end > ThreadBuffer::capacity ? end - ThreadBuffer::capacity : 0;
+            for (size_t i = begin; i < end; ++i) {
+                auto& event = buffer->events[i % ThreadBuffer::capacity];
+                auto event_object = array.add_object();
+                event_object.add("name", event.name);
+                event_object.add("cat", event.category);
+                event_object.add("ph", "X");
+                event_object.add("ts", event.start_us);
+                event_object.add("dur", event.duration_us);
+                event_object.add("pid", getpid());
+                event_object.add("tid", buffer->tid);
+            }
+        }
+    }
+    pthread_mutex_unlock(&s_buffers_lock);
+
+    append_kernel_events(array);
+
+    array.finish();
+    object.finish();
+    return builder.to_string();
+}
+
+bool dump_chrome_trace(const String& path)
+{
+    auto file_or_error = File::open(path, IODevice::WriteOnly);
+    if (file_or_error.is_error())
+        return false;
+    return file_or_error.value()->write(to_chrome_trace_json());
+}
+
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/Forward.h>
+#include <AK/Types.h>
+
+// Scoped tracing for finding out where time goes across threads and processes.
+//
+// TRACE_SCOPE("category", "name") records how long the enclosing scope took into a ring buffer
+// belonging to the calling thread. While tracing is disabled, a scope costs a single relaxed load.
+// Tracing is enabled at startup by setting SERENITY_TRACE in the environment (if its value is an
+// absolute path, the trace is written there when the process exits), or at runtime over the
+// EventLoop RPC socket, see tracectl(1).
+//
+// Traces are written in the Chrome trace event format, which chrome://tracing and Perfetto can load.
+// If the process is being profiled, its kernel performance events are merged into the same timeline.
+
+namespace Core::Trace {
+
+extern Atomic<bool> g_enabled;
+
+ALWAYS_INLINE bool is_enabled() { return g_enabled.load(AK::memory_order_relaxed); }
+void set_enabled(bool);
+
+u64 now_us();
+void record(const char* category, const char* name, u64 start_us, u64 duration_us);
+
+// Forgets every event recorded so far.
+void clear();
+
+String to_chrome_trace_json();
+bool dump_chrome_trace(const String& path);
+
+class Scope {
+public:
+    // Both strings must outlive the trace, in practice that means string literals.
+    ALWAYS_INLINE Scope(const char* category, const char* name)
+    {
+        if (!is_enabled())
+            return;
+        m_category = category;
+        m_name = name;
+        m_start_us = now_us();
+    }
+
+    ALWAYS_INLINE ~Scope()
+    {
+        if (m_name)
+            record(m_category, m_name, m_start_us, now_us() - m_start_us);
+    }
+
+private:
+    const char* m_category { nullptr };
+    const char* m_name { nullptr };
+    u64 m_start_us { 0 };
+};
+
+}
+
+#define __TRACE_SCOPE_NAME2(counter) __trace_scope_##counter
+#define __TRACE_SCOPE_NAME(counter) __TRACE_SCOPE_NAME2(counter)
+#define TRACE_SCOPE(category, name) Core::Trace::Scope __TRACE_SCOPE_NAME(__COUNTER__)(category, name)
@@ -37,15 +37,45 @@ OwnPtr<Reader> Reader::create(const String& path)
     auto file_or_error = MappedFile::map(path);
     if (file_or_error.is_error())
         return {};
-    return adopt_own(*new Reader(file_or_error.release_value()));
+    auto reader = adopt_own(*new Reader(file_or_error.release_value()));
+    if (!reader->initialize())
+        return {};
+    return reader;
 }
 
 Reader::Reader(NonnullRefPtr<MappedFile> coredump_file)
     : m_coredump_file(move(coredump_file))
-    , m_coredump_image(m_coredump_file->bytes())
 {
+}
+
+bool Reader::initialize()
+{
+    auto bytes = m_coredump_file->bytes();
+    m_available_size = bytes.size();
+
+    if (bytes.size() >= 18 && bytes[0] == 0x1f && bytes[1] == 0x8b) {
+        // The gzip trailer ends with the uncompressed size, which lets us decompress straight into place.
+        LittleEndian<u32> uncompressed_size;
+        memcpy(&uncompressed_size, bytes.data() + bytes.size() - sizeof(uncompressed_size), sizeof(uncompressed_size));
+        m_decompressed_data = ByteBuffer::create_uninitialized(uncompressed_size);
+        m_compressed_stream = make<InputMemoryStream>(bytes);
+        m_decompressor = make<Compress::GzipDecompressor>(*m_compressed_stream);
+        m_available_size = 0;
+        bytes = m_decompressed_data;
+
+        if (!ensure_decompressed(sizeof(Elf32_Ehdr)))
+            return false;
+        auto& header = *reinterpret_cast<const Elf32_Ehdr*>(bytes.data());
+        if (!ensure_decompressed(header.e_phoff + header.e_phnum * sizeof(Elf32_Phdr)))
+            return false;
+    }
+
+    m_coredump_image.emplace(bytes);
+    if (!m_coredump_image->is_valid())
+        return false;
+
     size_t index = 0;
-    m_coredump_image.for_each_program_header([this, &index](auto pheader) {
+    m_coredump_image->for_each_program_header([this, &index](auto pheader) {
         if (pheader.type() == PT_NOTE) {
             m_notes_segment_index = index;
             return IterationDecision::Break;
@@ -53,7 +83,41 @@ Reader::Reader(NonnullRefPtr<MappedFile> coredump_file)
         ++index;
         return IterationDecision::Continue;
     });
-    VERIFY(m_notes_segment_index != -1);
+    if (m_notes_segment_index == -1)
+        return false;
+
+    // The kernel puts the notes before the memory, so we usually get away without decompressing any of that here.
+    auto notes = m_coredump_image->program_header(m_notes_segment_index);
+    return ensure_decompressed(notes.offset() + notes.size_in_image());
+}
+
+bool Reader::ensure_decompressed(size_t end) const
+{
+    // Decompressing in bigger steps keeps the per-call overhead down when reading memory word by word.
+    static constexpr size_t minimum_step = 64 * KiB;
+
+    if (end <= m_available_size)
+        return true;
+    if (!m_decompressor || end > m_decompressed_data.size())
+        return false;
+
+    while (m_available_size < end) {
+        auto step = min(max(end - m_available_size, minimum_step), m_decompressed_data.size() - m_available_size);
+        auto nread = m_decompressor->read(m_decompressed_data.bytes().slice(m_available_size, step));
+        if (nread == 0)
+            break;
+        m_available_size += nread;
+    }
+
+    if (m_available_size < end || m_available_size == m_decompressed_data.size()) {
+        if (m_available_size < end)
+            dbgln("CoreDump::Reader: Compressed coredump ended after {} bytes", m_available_size);
+        m_decompressor->handle_any_error();
+        m_compressed_stream->handle_any_error();
+        m_decompressor = nullptr;
+        m_compressed_stream = nullptr;
+    }
+    return end <= m_available_size;
 }
 
 Reader::~Reader()
@@ -121,15 +185,24 @@ Optional<uint32_t> Reader::peek_memory(FlatPtr address) const
     if (!region)
         return {};
 
-    FlatPtr offset_in_region = address - region->region_start;
-    const char* region_data = image().program_header(region->program_header_index).raw_data();
-    return *(const uint32_t*)(&region_data[offset_in_region]);
+    // Only [vaddr, vaddr + size_in_image) of a region is in the dump, the kernel leaves out untouched pages
+    // at either end and read-only file mappings.
+    auto program_header = image().program_header(region->program_header_index);
+    FlatPtr start = program_header.vaddr().get();
+    if (address < start || address - start + sizeof(u32) > program_header.size_in_image())
+        return {};
+
+    FlatPtr offset_in_segment = address - start;
+    if (!ensure_decompressed(program_header.offset() + offset_in_segment + sizeof(u32)))
+        return {};
+    const char* segment_data = program_header.raw_data();
+    return *(const uint32_t*)(&segment_data[offset_in_segment]);
 }
 
 const JsonObject Reader::process_info() const
 {
     const ELF::Core::ProcessInfo* process_info_notes_entry = nullptr;
-    for (NotesEntryIterator it((const u8*)m_coredump_image.program_header(m_notes_segment_index).raw_data()); !it.at_end(); it.next()) {
+    for (NotesEntryIterator it((const u8*)m_coredump_image->program_header(m_notes_segment_index).raw_data()); !it.at_end(); it.next()) {
         if (it.type() != ELF::Core::NotesEntryHeader::Type::ProcessInfo)
             continue;
         process_info_notes_entry = reinterpret_cast<const ELF::Core::ProcessInfo*>(it.current());
@@ -214,7 +287,7 @@ Vector<String> Reader::process_environment() const
 HashMap<String, String> Reader::metadata() const
 {
     const ELF::Core::Metadata* metadata_notes_entry = nullptr;
-    for (NotesEntryIterator it((const u8*)m_coredump_image.program_header(m_notes_segment_index).raw_data()); !it.at_end(); it.next()) {
+    for (NotesEntryIterator it((const u8*)m_coredump_image->program_header(m_notes_segment_index).raw_data()); !it.at_end(); it.next()) {
         if (it.type() != ELF::Core::NotesEntryHeader::Type::Metadata)
             continue;
         metadata_notes_entry = reinterpret_cast<const ELF::Core::Metadata*>(it.current());
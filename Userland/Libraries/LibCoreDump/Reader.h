@@ -26,10 +26,14 @@
 
 #pragma once
 
+#include <AK/ByteBuffer.h>
 #include <AK/HashMap.h>
 #include <AK/MappedFile.h>
+#include <AK/MemoryStream.h>
 #include <AK/Noncopyable.h>
+#include <AK/Optional.h>
 #include <AK/OwnPtr.h>
+#include <LibCompress/Gzip.h>
 #include <LibELF/CoreDump.h>
 #include <LibELF/Image.h>
 
@@ -49,7 +53,9 @@ public:
     template<typename Func>
     void for_each_thread_info(Func func) const;
 
-    const ELF::Image& image() const { return m_coredump_image; }
+    // Compressed dumps are decompressed front to back as far as they have been looked at, so the memory
+    // of the image must only be accessed through peek_memory().
+    const ELF::Image& image() const { return *m_coredump_image; }
 
     Optional<uint32_t> peek_memory(FlatPtr address) const;
     const ELF::Core::MemoryRegionInfo* region_containing(FlatPtr address) const;
@@ -72,6 +78,9 @@ public:
 private:
     Reader(NonnullRefPtr<MappedFile>);
 
+    bool initialize();
+    bool ensure_decompressed(size_t end) const;
+
     class NotesEntryIterator {
     public:
         NotesEntryIterator(const u8* notes_data);
@@ -93,14 +102,22 @@ private:
     const JsonObject process_info() const;
 
     NonnullRefPtr<MappedFile> m_coredump_file;
-    ELF::Image m_coredump_image;
+
+    // For gzip-compressed dumps: the first m_available_size bytes of m_decompressed_data are filled in,
+    // and the decompressor is dropped once it's done (or has failed).
+    mutable ByteBuffer m_decompressed_data;
+    mutable OwnPtr<InputMemoryStream> m_compressed_stream;
+    mutable OwnPtr<Compress::GzipDecompressor> m_decompressor;
+    mutable size_t m_available_size { 0 };
+
+    Optional<ELF::Image> m_coredump_image;
     ssize_t m_notes_segment_index { -1 };
 };
 
 template<typename Func>
 void Reader::for_each_memory_region_info(Func func) const
 {
-    for (NotesEntryIterator it((const u8*)m_coredump_image.program_header(m_notes_segment_index).raw_data()); !it.at_end(); it.next()) {
+    for (NotesEntryIterator it((const u8*)m_coredump_image->program_header(m_notes_segment_index).raw_data()); !it.at_end(); it.next()) {
         if (it.type() != ELF::Core::NotesEntryHeader::Type::MemoryRegionInfo)
             continue;
         auto& memory_region_info = reinterpret_cast<const ELF::Core::MemoryRegionInfo&>(*it.current());
@@ -113,7 +130,7 @@ void Reader::for_each_memory_region_info(Func func) const
 template<typename Func>
 void Reader::for_each_thread_info(Func func) const
 {
-    for (NotesEntryIterator it((const u8*)m_coredump_image.program_header(m_notes_segment_index).raw_data()); !it.at_end(); it.next()) {
+    for (NotesEntryIterator it((const u8*)m_coredump_image->program_header(m_notes_segment_index).raw_data()); !it.at_end(); it.next()) {
         if (it.type() != ELF::Core::NotesEntryHeader::Type::ThreadInfo)
             continue;
         auto& thread_info = reinterpret_cast<const ELF::Core::ThreadInfo&>(*it.current());
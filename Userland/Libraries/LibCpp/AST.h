@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <AK/BumpAllocator.h>
 #include <AK/FlyString.h>
 #include <AK/NonnullRefPtrVector.h>
 #include <AK/Optional.h>
@@ -45,6 +46,7 @@ class Parameter;
 class Statement;
 
 class ASTNode : public RefCounted<ASTNode> {
+    AK_MAKE_BUMP_ALLOCATED(ASTNode)
 public:
     virtual ~ASTNode() = default;
     virtual const char* class_name() const = 0;
@@ -78,6 +78,16 @@ bool SyntaxHighlighter::is_navigatable(void* token) const
 void SyntaxHighlighter::rehighlight(const Palette& palette)
 {
     auto text = m_client->get_text();
+    m_client->do_set_spans(spans_for_text(text, 0, palette));
+
+    m_has_brace_buddies = false;
+    highlight_matching_token_pair();
+
+    m_client->do_update();
+}
+
+Vector<GUI::TextDocumentSpan> SyntaxHighlighter::spans_for_text(const StringView& text, size_t first_line, const Palette& palette)
+{
     Cpp::Lexer lexer(text);
     auto tokens = lexer.lex();
 
@@ -85,8 +95,8 @@ void SyntaxHighlighter::rehighlight(const Palette& palette)
     for (auto& token : tokens) {
         dbgln_if(SYNTAX_HIGHLIGHTING_DEBUG, "{} @ {}:{} - {}:{}", token.to_string(), token.m_start.line, token.m_start.column, token.m_end.line, token.m_end.column);
         GUI::TextDocumentSpan span;
-        span.range.set_start({ token.m_start.line, token.m_start.column });
-        span.range.set_end({ token.m_end.line, token.m_end.column });
+        span.range.set_start({ first_line + token.m_start.line, token.m_start.column });
+        span.range.set_end({ first_line + token.m_end.line, token.m_end.column });
         auto style = style_for_token_type(palette, token.m_type);
         span.attributes.color = style.color;
         span.attributes.bold = style.bold;
@@ -94,12 +104,7 @@ void SyntaxHighlighter::rehighlight(const Palette& palette)
         span.data = reinterpret_cast<void*>(token.m_type);
         spans.append(span);
     }
-    m_client->do_set_spans(move(spans));
-
-    m_has_brace_buddies = false;
-    highlight_matching_token_pair();
-
-    m_client->do_update();
+    return spans;
 }
 
 Vector<SyntaxHighlighter::MatchingTokenPair> SyntaxHighlighter::matching_token_pairs() const
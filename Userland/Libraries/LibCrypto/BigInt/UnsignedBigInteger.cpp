@@ -224,12 +224,9 @@ FLATTEN UnsignedBigInteger UnsignedBigInteger::shift_left(size_t num_bits) const
 FLATTEN UnsignedBigInteger UnsignedBigInteger::multiplied_by(const UnsignedBigInteger& other) const
 {
     UnsignedBigInteger result;
-    UnsignedBigInteger temp_shift_result;
-    UnsignedBigInteger temp_shift_plus;
-    UnsignedBigInteger temp_shift;
-    UnsignedBigInteger temp_plus;
+    UnsignedBigInteger temp_scratch;
 
-    multiply_without_allocation(*this, other, temp_shift_result, temp_shift_plus, temp_shift, temp_plus, result);
+    multiply_without_allocation(*this, other, temp_scratch, result);
 
     return result;
 }
@@ -587,40 +584,151 @@ FLATTEN void UnsignedBigInteger::shift_left_without_allocation(
     }
 }
 
+// Below this many words, Karatsuba's bookkeeping costs more than the multiplications it saves.
+static constexpr size_t KARATSUBA_THRESHOLD = 32;
+
+// output[0..left_length + right_length) = left * right
+static void multiply_words(const u32* left, size_t left_length, const u32* right, size_t right_length, u32* output)
+{
+    __builtin_memset(output, 0, (left_length + right_length) * sizeof(u32));
+    for (size_t i = 0; i < left_length; ++i) {
+        u64 carry = 0;
+        for (size_t j = 0; j < right_length; ++j) {
+            u64 product = (u64)left[i] * right[j] + output[i + j] + carry;
+            output[i + j] = (u32)product;
+            carry = product >> 32;
+        }
+        output[i + right_length] = (u32)carry;
+    }
+}
+
+// number[0..length) += addend[0..addend_length), where addend_length <= length. Returns the carry.
+static u32 add_words_in_place(u32* number, size_t length, const u32* addend, size_t addend_length)
+{
+    u64 carry = 0;
+    size_t i = 0;
+    for (; i < addend_length; ++i) {
+        u64 sum = (u64)number[i] + addend[i] + carry;
+        number[i] = (u32)sum;
+        carry = sum >> 32;
+    }
+    for (; carry && i < length; ++i) {
+        u64 sum = (u64)number[i] + carry;
+        number[i] = (u32)sum;
+        carry = sum >> 32;
+    }
+    return carry;
+}
+
+// number[0..length) -= subtrahend[0..subtrahend_length), where the result must not be negative.
+static void subtract_words_in_place(u32* number, size_t length, const u32* subtrahend, size_t subtrahend_length)
+{
+    u32 borrow = 0;
+    size_t i = 0;
+    for (; i < subtrahend_length; ++i) {
+        u64 difference = (u64)number[i] - subtrahend[i] - borrow;
+        number[i] = (u32)difference;
+        borrow = (difference >> 32) & 1;
+    }
+    for (; borrow && i < length; ++i) {
+        borrow = number[i] == 0;
+        --number[i];
+    }
+    VERIFY(borrow == 0);
+}
+
+static size_t karatsuba_scratch_size(size_t length)
+{
+    if (length < KARATSUBA_THRESHOLD)
+        return 0;
+    size_t high_length = length - length / 2;
+    return 4 * (high_length + 1) + karatsuba_scratch_size(high_length + 1);
+}
+
+// output[0..2 * length) = left * right, where both numbers are `length` words long.
+// scratch must have room for karatsuba_scratch_size(length) words.
+static void karatsuba_multiply(const u32* left, const u32* right, size_t length, u32* output, u32* scratch)
+{
+    if (length < KARATSUBA_THRESHOLD) {
+        multiply_words(left, length, right, length, output);
+        return;
+    }
+
+    // With left = left_high * W + left_low and right = right_high * W + right_low:
+    // left * right = high * W^2 + (middle - high - low) * W + low, where
+    // low = left_low * right_low, high = left_high * right_high and
+    // middle = (left_low + left_high) * (right_low + right_high).
+    size_t low_length = length / 2;
+    size_t high_length = length - low_length;
+    size_t sum_length = high_length + 1;
+
+    karatsuba_multiply(left, right, low_length, output, scratch);
+    karatsuba_multiply(left + low_length, right + low_length, high_length, output + 2 * low_length, scratch);
+
+    u32* left_sum = scratch;
+    u32* right_sum = scratch + sum_length;
+    u32* middle = scratch + 2 * sum_length;
+    __builtin_memcpy(left_sum, left + low_length, high_length * sizeof(u32));
+    left_sum[high_length] = add_words_in_place(left_sum, high_length, left, low_length);
+    __builtin_memcpy(right_sum, right + low_length, high_length * sizeof(u32));
+    right_sum[high_length] = add_words_in_place(right_sum, high_length, right, low_length);
+    karatsuba_multiply(left_sum, right_sum, sum_length, middle, scratch + 4 * sum_length);
+
+    subtract_words_in_place(middle, 2 * sum_length, output, 2 * low_length);
+    subtract_words_in_place(middle, 2 * sum_length, output + 2 * low_length, 2 * high_length);
+    // The top words of middle are zero, but don't run past the end of output.
+    size_t middle_length = min(2 * sum_length, 2 * length - low_length);
+    add_words_in_place(output + low_length, 2 * length - low_length, middle, middle_length);
+}
+
 /**
- * Complexity: O(N^2) where N is the number of words in the larger number
+ * Complexity: O(N^2) where N is the number of words in the larger number,
+ *             or O(N^1.58) once both numbers are at least KARATSUBA_THRESHOLD words long
  * Multiplication method:
- * An integer is equal to the sum of the powers of two
- * according to the indexes of its 'on' bits.
- * So to multiple x*y, we go over each '1' bit in x (say the i'th bit), 
- * and add y<<i to the result.
+ * Long multiplication over whole words, with 64-bit intermediate products.
+ * Long enough numbers are split in halves and multiplied with Karatsuba's method,
+ * which takes three half-size multiplications instead of four.
+ * If one number is much longer than the other, it's multiplied piece by piece.
  */
 FLATTEN void UnsignedBigInteger::multiply_without_allocation(
     const UnsignedBigInteger& left,
     const UnsignedBigInteger& right,
-    UnsignedBigInteger& temp_shift_result,
-    UnsignedBigInteger& temp_shift_plus,
-    UnsignedBigInteger& temp_shift,
-    UnsignedBigInteger& temp_plus,
+    UnsignedBigInteger& temp_scratch,
     UnsignedBigInteger& output)
 {
     output.set_to_0();
 
-    // iterate all bits
-    for (size_t word_index = 0; word_index < left.length(); ++word_index) {
-        for (size_t bit_index = 0; bit_index < UnsignedBigInteger::BITS_IN_WORD; ++bit_index) {
-            // If the bit is off - skip over it
-            if (!(left.m_words[word_index] & (1 << bit_index)))
-                continue;
-
-            const size_t shift_amount = word_index * UnsignedBigInteger::BITS_IN_WORD + bit_index;
+    const UnsignedBigInteger* longer = &left;
+    const UnsignedBigInteger* shorter = &right;
+    if (left.trimmed_length() < right.trimmed_length())
+        swap(longer, shorter);
+    size_t longer_length = longer->trimmed_length();
+    size_t shorter_length = shorter->trimmed_length();
+    if (shorter_length == 0)
+        return;
 
-            // output += (right << shift_amount);
-            shift_left_without_allocation(right, shift_amount, temp_shift_result, temp_shift_plus, temp_shift);
-            add_without_allocation(output, temp_shift, temp_plus);
-            output.set_to(temp_plus);
+    output.m_words.resize_and_keep_capacity(longer_length + shorter_length);
+    if (shorter_length < KARATSUBA_THRESHOLD) {
+        multiply_words(longer->m_words.data(), longer_length, shorter->m_words.data(), shorter_length, output.m_words.data());
+    } else {
+        __builtin_memset(output.m_words.data(), 0, output.length() * sizeof(u32));
+        temp_scratch.m_words.resize_and_keep_capacity(2 * shorter_length + karatsuba_scratch_size(shorter_length));
+        temp_scratch.m_cached_trimmed_length = {};
+        u32* product = temp_scratch.m_words.data();
+        u32* scratch = product + 2 * shorter_length;
+
+        for (size_t offset = 0; offset < longer_length; offset += shorter_length) {
+            size_t piece_length = min(shorter_length, longer_length - offset);
+            if (piece_length == shorter_length)
+                karatsuba_multiply(longer->m_words.data() + offset, shorter->m_words.data(), shorter_length, product, scratch);
+            else
+                multiply_words(shorter->m_words.data(), shorter_length, longer->m_words.data() + offset, piece_length, product);
+            add_words_in_place(output.m_words.data() + offset, output.length() - offset, product, shorter_length + piece_length);
         }
     }
+
+    // The top word may be zero, leave it out like the other operations do.
+    output.m_words.resize_and_keep_capacity(output.trimmed_length());
 }
 
 /**
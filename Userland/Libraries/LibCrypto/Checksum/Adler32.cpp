@@ -24,18 +24,102 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Platform.h>
 #include <AK/Span.h>
 #include <AK/Types.h>
+#include <LibCrypto/CPUFeatures.h>
 #include <LibCrypto/Checksum/Adler32.h>
 
+#if ARCH(I386) || ARCH(X86_64)
+#    include <tmmintrin.h>
+#endif
+
 namespace Crypto::Checksum {
 
+static constexpr u32 modulus = 65521;
+
+// The largest number of bytes that can be summed up before the sums have to be reduced modulo 65521, without
+// overflowing 32 bits (i.e. the largest n with 255 * n * (n + 1) / 2 + (n + 1) * (65521 - 1) < 2^32.)
+static constexpr size_t max_bytes_between_reductions = 5552;
+
+static void update_scalar(u32& a, u32& b, ReadonlyBytes data)
+{
+    const u8* bytes = data.data();
+    size_t size = data.size();
+
+    while (size > 0) {
+        auto count = min(size, max_bytes_between_reductions);
+        size -= count;
+        while (count-- > 0) {
+            a += *bytes++;
+            b += a;
+        }
+        a %= modulus;
+        b %= modulus;
+    }
+}
+
+#if ARCH(I386) || ARCH(X86_64)
+// Processes 32 bytes at a time: a gets the plain sum of the bytes, and b gets a times 32 (for the bytes that
+// came before) plus the bytes weighted by 32, 31, ..., 1 (for the ones in the block.) Expects a multiple of 32 bytes.
+[[gnu::target("ssse3")]] static void update_with_ssse3(u32& a, u32& b, ReadonlyBytes data)
+{
+    constexpr size_t block_size = 32;
+    VERIFY(data.size() % block_size == 0);
+
+    const auto weights_1 = _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17);
+    const auto weights_2 = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+    const auto ones = _mm_set1_epi16(1);
+    const auto zero = _mm_setzero_si128();
+
+    const u8* bytes = data.data();
+    size_t block_count = data.size() / block_size;
+
+    while (block_count > 0) {
+        auto count = min(block_count, max_bytes_between_reductions / block_size);
+        block_count -= count;
+
+        // previous_a_sum accumulates a as it was before each block, to be multiplied by the block size at the end.
+        auto previous_a_sum = _mm_cvtsi32_si128(a * count);
+        auto a_sum = _mm_setzero_si128();
+        auto b_sum = _mm_cvtsi32_si128(b);
+
+        while (count-- > 0) {
+            auto block_1 = _mm_loadu_si128((const __m128i*)bytes);
+            auto block_2 = _mm_loadu_si128((const __m128i*)(bytes + 16));
+            bytes += block_size;
+
+            previous_a_sum = _mm_add_epi32(previous_a_sum, a_sum);
+            a_sum = _mm_add_epi32(a_sum, _mm_sad_epu8(block_1, zero));
+            a_sum = _mm_add_epi32(a_sum, _mm_sad_epu8(block_2, zero));
+            b_sum = _mm_add_epi32(b_sum, _mm_madd_epi16(_mm_maddubs_epi16(block_1, weights_1), ones));
+            b_sum = _mm_add_epi32(b_sum, _mm_madd_epi16(_mm_maddubs_epi16(block_2, weights_2), ones));
+        }
+
+        b_sum = _mm_add_epi32(b_sum, _mm_slli_epi32(previous_a_sum, 5));
+
+        // Add up the lanes. (_mm_sad_epu8 only leaves sums in the low halves of the 64-bit lanes.)
+        a_sum = _mm_add_epi32(a_sum, _mm_shuffle_epi32(a_sum, _MM_SHUFFLE(1, 0, 3, 2)));
+        b_sum = _mm_add_epi32(b_sum, _mm_shuffle_epi32(b_sum, _MM_SHUFFLE(2, 3, 0, 1)));
+        b_sum = _mm_add_epi32(b_sum, _mm_shuffle_epi32(b_sum, _MM_SHUFFLE(1, 0, 3, 2)));
+
+        a = (a + _mm_cvtsi128_si32(a_sum)) % modulus;
+        b = _mm_cvtsi128_si32(b_sum) % modulus;
+    }
+}
+#endif
+
 void Adler32::update(ReadonlyBytes data)
 {
-    for (size_t i = 0; i < data.size(); i++) {
-        m_state_a = (m_state_a + data.at(i)) % 65521;
-        m_state_b = (m_state_b + m_state_a) % 65521;
+#if ARCH(I386) || ARCH(X86_64)
+    if (data.size() >= 32 && cpu_supports_ssse3()) {
+        auto vectorized_size = data.size() & ~(size_t)31;
+        update_with_ssse3(m_state_a, m_state_b, data.trim(vectorized_size));
+        data = data.slice(vectorized_size);
     }
+#endif
+
+    update_scalar(m_state_a, m_state_b, data);
 };
 
 u32 Adler32::digest()
@@ -24,17 +24,147 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Platform.h>
 #include <AK/Span.h>
 #include <AK/Types.h>
 #include <LibCrypto/Checksum/CRC32.h>
 
+// The kernel builds this file too, but it can't touch the SSE registers.
+#if (ARCH(I386) || ARCH(X86_64)) && !defined(KERNEL)
+#    define CRC32_USE_PCLMULQDQ 1
+#    include <LibCrypto/CPUFeatures.h>
+#    include <emmintrin.h>
+#    include <wmmintrin.h>
+#else
+#    define CRC32_USE_PCLMULQDQ 0
+#endif
+
 namespace Crypto::Checksum {
 
+// slice_tables[k][i] is the CRC of byte i followed by k zero bytes, which lets us process eight bytes
+// with eight independent table lookups instead of eight dependent ones.
+struct SliceTables {
+    u32 data[8][256];
+
+    constexpr SliceTables()
+        : data()
+    {
+        for (auto i = 0; i < 256; i++)
+            data[0][i] = table[i];
+
+        for (auto k = 1; k < 8; k++) {
+            for (auto i = 0; i < 256; i++)
+                data[k][i] = (data[k - 1][i] >> 8) ^ table[data[k - 1][i] & 0xFF];
+        }
+    }
+};
+
+constexpr static auto slice_tables = SliceTables();
+
+static u32 read_u32_le(const u8* bytes)
+{
+    return bytes[0] | bytes[1] << 8 | bytes[2] << 16 | (u32)bytes[3] << 24;
+}
+
+static u32 update_with_slice_tables(u32 state, ReadonlyBytes data)
+{
+    const auto& tables = slice_tables.data;
+    const u8* bytes = data.data();
+    size_t size = data.size();
+
+    while (size >= 8) {
+        auto low = read_u32_le(bytes) ^ state;
+        auto high = read_u32_le(bytes + 4);
+        state = tables[7][low & 0xFF] ^ tables[6][(low >> 8) & 0xFF] ^ tables[5][(low >> 16) & 0xFF] ^ tables[4][low >> 24]
+            ^ tables[3][high & 0xFF] ^ tables[2][(high >> 8) & 0xFF] ^ tables[1][(high >> 16) & 0xFF] ^ tables[0][high >> 24];
+        bytes += 8;
+        size -= 8;
+    }
+
+    while (size-- > 0)
+        state = table[(state ^ *bytes++) & 0xFF] ^ (state >> 8);
+
+    return state;
+}
+
+#if CRC32_USE_PCLMULQDQ
+[[gnu::target("pclmul,sse2")]] static __m128i fold_with_pclmulqdq(__m128i remainder, __m128i next, __m128i constants)
+{
+    auto low = _mm_clmulepi64_si128(remainder, constants, 0x00);
+    auto high = _mm_clmulepi64_si128(remainder, constants, 0x11);
+    return _mm_xor_si128(_mm_xor_si128(low, high), next);
+}
+
+// Folds the input into a 128-bit remainder with carry-less multiplications, four blocks of 16 bytes at a
+// time, and then reduces that to the 32-bit CRC, as described in Intel's "Fast CRC Computation for Generic
+// Polynomials Using PCLMULQDQ Instruction". The constants are powers of x modulo the (bit-reflected) CRC-32
+// polynomial. Expects at least 64 bytes, and a multiple of 16.
+[[gnu::target("pclmul,sse2")]] static u32 update_with_pclmulqdq(u32 state, ReadonlyBytes data)
+{
+    VERIFY(data.size() >= 64 && data.size() % 16 == 0);
+
+    const auto k1k2 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+    const auto k3k4 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+    const auto k5 = _mm_set_epi64x(0, 0x0163cd6124);
+    const auto polynomial_and_mu = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+    const auto low_32_bits_mask = _mm_setr_epi32(~0, 0, ~0, 0);
+
+    const u8* bytes = data.data();
+    size_t size = data.size();
+
+    auto x1 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)bytes), _mm_cvtsi32_si128(state));
+    auto x2 = _mm_loadu_si128((const __m128i*)(bytes + 16));
+    auto x3 = _mm_loadu_si128((const __m128i*)(bytes + 32));
+    auto x4 = _mm_loadu_si128((const __m128i*)(bytes + 48));
+    bytes += 64;
+    size -= 64;
+
+    while (size >= 64) {
+        x1 = fold_with_pclmulqdq(x1, _mm_loadu_si128((const __m128i*)bytes), k1k2);
+        x2 = fold_with_pclmulqdq(x2, _mm_loadu_si128((const __m128i*)(bytes + 16)), k1k2);
+        x3 = fold_with_pclmulqdq(x3, _mm_loadu_si128((const __m128i*)(bytes + 32)), k1k2);
+        x4 = fold_with_pclmulqdq(x4, _mm_loadu_si128((const __m128i*)(bytes + 48)), k1k2);
+        bytes += 64;
+        size -= 64;
+    }
+
+    x1 = fold_with_pclmulqdq(x1, x2, k3k4);
+    x1 = fold_with_pclmulqdq(x1, x3, k3k4);
+    x1 = fold_with_pclmulqdq(x1, x4, k3k4);
+
+    while (size >= 16) {
+        x1 = fold_with_pclmulqdq(x1, _mm_loadu_si128((const __m128i*)bytes), k3k4);
+        bytes += 16;
+        size -= 16;
+    }
+
+    // Fold the 128-bit remainder to 64 bits, ...
+    x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_clmulepi64_si128(_mm_and_si128(x1, low_32_bits_mask), k5, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    // ... and then to 32 bits with a Barrett reduction.
+    x2 = _mm_clmulepi64_si128(_mm_and_si128(x1, low_32_bits_mask), polynomial_and_mu, 0x10);
+    x2 = _mm_clmulepi64_si128(_mm_and_si128(x2, low_32_bits_mask), polynomial_and_mu, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    return _mm_cvtsi128_si32(_mm_srli_si128(x1, 4));
+}
+#endif
+
 void CRC32::update(ReadonlyBytes data)
 {
-    for (size_t i = 0; i < data.size(); i++) {
-        m_state = table[(m_state ^ data.at(i)) & 0xFF] ^ (m_state >> 8);
+#if CRC32_USE_PCLMULQDQ
+    if (data.size() >= 64 && cpu_supports_pclmulqdq()) {
+        auto folded_size = data.size() & ~(size_t)15;
+        m_state = update_with_pclmulqdq(m_state, data.trim(folded_size));
+        data = data.slice(folded_size);
     }
+#endif
+
+    m_state = update_with_slice_tables(m_state, data);
 };
 
 u32 CRC32::digest()
@@ -24,9 +24,19 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Platform.h>
 #include <AK/StringBuilder.h>
 #include <LibCrypto/Cipher/AES.h>
 
+// The kernel builds this file too, but it can't touch the SSE registers.
+#if (ARCH(I386) || ARCH(X86_64)) && !defined(KERNEL)
+#    define AES_USE_AES_NI 1
+#    include <LibCrypto/CPUFeatures.h>
+#    include <wmmintrin.h>
+#else
+#    define AES_USE_AES_NI 0
+#endif
+
 namespace Crypto {
 namespace Cipher {
 
@@ -170,6 +180,40 @@ void AESCipherKey::expand_encrypt_key(ReadonlyBytes user_key, size_t bits)
     }
 }
 
+void AESCipherKey::update_round_key_bytes()
+{
+    for (size_t i = 0; i < (rounds() + 1) * 4; ++i) {
+        m_rd_key_bytes[i * 4 + 0] = m_rd_keys[i] >> 24;
+        m_rd_key_bytes[i * 4 + 1] = m_rd_keys[i] >> 16;
+        m_rd_key_bytes[i * 4 + 2] = m_rd_keys[i] >> 8;
+        m_rd_key_bytes[i * 4 + 3] = m_rd_keys[i];
+    }
+}
+
+#if AES_USE_AES_NI
+// The decryption round keys are already reversed and run through InvMixColumns, which is
+// exactly what AESDEC expects (the "equivalent inverse cipher" from FIPS-197, section 5.3.5).
+[[gnu::target("aes")]] static void encrypt_block_with_aes_ni(const u8* in, u8* out, const u8* round_key_bytes, size_t rounds)
+{
+    auto* round_keys = (const __m128i*)round_key_bytes;
+    auto state = _mm_xor_si128(_mm_loadu_si128((const __m128i*)in), _mm_loadu_si128(&round_keys[0]));
+    for (size_t i = 1; i < rounds; ++i)
+        state = _mm_aesenc_si128(state, _mm_loadu_si128(&round_keys[i]));
+    state = _mm_aesenclast_si128(state, _mm_loadu_si128(&round_keys[rounds]));
+    _mm_storeu_si128((__m128i*)out, state);
+}
+
+[[gnu::target("aes")]] static void decrypt_block_with_aes_ni(const u8* in, u8* out, const u8* round_key_bytes, size_t rounds)
+{
+    auto* round_keys = (const __m128i*)round_key_bytes;
+    auto state = _mm_xor_si128(_mm_loadu_si128((const __m128i*)in), _mm_loadu_si128(&round_keys[0]));
+    for (size_t i = 1; i < rounds; ++i)
+        state = _mm_aesdec_si128(state, _mm_loadu_si128(&round_keys[i]));
+    state = _mm_aesdeclast_si128(state, _mm_loadu_si128(&round_keys[rounds]));
+    _mm_storeu_si128((__m128i*)out, state);
+}
+#endif
+
 void AESCipherKey::expand_decrypt_key(ReadonlyBytes user_key, size_t bits)
 {
     u32* round_key;
@@ -216,6 +260,13 @@ void AESCipherKey::expand_decrypt_key(ReadonlyBytes user_key, size_t bits)
 
 void AESCipher::encrypt_block(const AESCipherBlock& in, AESCipherBlock& out)
 {
+#if AES_USE_AES_NI
+    if (cpu_supports_aes_ni()) {
+        encrypt_block_with_aes_ni(in.bytes().data(), out.bytes().data(), key().round_key_bytes(), key().rounds());
+        return;
+    }
+#endif
+
     u32 s0, s1, s2, s3, t0, t1, t2, t3;
     size_t r { 0 };
 
@@ -308,6 +359,12 @@ void AESCipher::encrypt_block(const AESCipherBlock& in, AESCipherBlock& out)
 
 void AESCipher::decrypt_block(const AESCipherBlock& in, AESCipherBlock& out)
 {
+#if AES_USE_AES_NI
+    if (cpu_supports_aes_ni()) {
+        decrypt_block_with_aes_ni(in.bytes().data(), out.bytes().data(), key().round_key_bytes(), key().rounds());
+        return;
+    }
+#endif
 
     u32 s0, s1, s2, s3, t0, t1, t2, t3;
     size_t r { 0 };
@@ -82,6 +82,9 @@ struct AESCipherKey : public CipherKey {
         return (const u32*)m_rd_keys;
     }
 
+    // The same round keys as a byte stream, which is the layout the AES-NI instructions want.
+    const u8* round_key_bytes() const { return m_rd_key_bytes; }
+
     AESCipherKey(ReadonlyBytes user_key, size_t key_bits, Intent intent)
         : m_bits(key_bits)
     {
@@ -89,6 +92,7 @@ struct AESCipherKey : public CipherKey {
             expand_encrypt_key(user_key, key_bits);
         else
             expand_decrypt_key(user_key, key_bits);
+        update_round_key_bytes();
     }
 
     virtual ~AESCipherKey() override { }
@@ -103,8 +107,11 @@ protected:
     }
 
 private:
+    void update_round_key_bytes();
+
     static constexpr size_t MAX_ROUND_COUNT = 14;
     u32 m_rd_keys[(MAX_ROUND_COUNT + 1) * 4] { 0 };
+    u8 m_rd_key_bytes[(MAX_ROUND_COUNT + 1) * 16] { 0 };
     size_t m_rounds;
     size_t m_bits;
 };
@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Random.h>
+#include <LibCrypto/Curves/X25519.h>
+
+namespace Crypto {
+namespace Curves {
+
+// Field elements modulo 2^255 - 19 are kept in 16 limbs of 16 bits each. The limbs are signed and
+// wider than that, so that sums and products can be carried out lazily. This is slower than the
+// usual radix 2^51 representation, but doesn't need 128-bit multiplication, which not all of our
+// targets have. Everything here runs in constant time, regardless of the key material.
+using FieldElement = i64[16];
+
+static void carry(FieldElement o)
+{
+    for (size_t i = 0; i < 16; ++i) {
+        o[i] += (i64)1 << 16;
+        i64 c = o[i] >> 16;
+        // The carry out of the top limb wraps around to the bottom one, multiplied by 38 = 2 * 19 (2^256 = 38 mod p).
+        if (i < 15)
+            o[i + 1] += c - 1;
+        else
+            o[0] += 38 * (c - 1);
+        o[i] -= c << 16;
+    }
+}
+
+// Swaps p and q if swap is 1, and leaves them alone if it's 0.
+static void conditional_swap(FieldElement p, FieldElement q, i64 swap)
+{
+    i64 mask = ~(swap - 1);
+    for (size_t i = 0; i < 16; ++i) {
+        i64 t = mask & (p[i] ^ q[i]);
+        p[i] ^= t;
+        q[i] ^= t;
+    }
+}
+
+static void pack(u8* out, const FieldElement n)
+{
+    FieldElement t;
+    FieldElement m;
+    for (size_t i = 0; i < 16; ++i)
+        t[i] = n[i];
+    carry(t);
+    carry(t);
+    carry(t);
+    // Subtract p until the value is fully reduced.
+    for (size_t j = 0; j < 2; ++j) {
+        m[0] = t[0] - 0xffed;
+        for (size_t i = 1; i < 15; ++i) {
+            m[i] = t[i] - 0xffff - ((m[i - 1] >> 16) & 1);
+            m[i - 1] &= 0xffff;
+        }
+        m[15] = t[15] - 0x7fff - ((m[14] >> 16) & 1);
+        i64 borrow = (m[15] >> 16) & 1;
+        m[14] &= 0xffff;
+        conditional_swap(t, m, 1 - borrow);
+    }
+    for (size_t i = 0; i < 16; ++i) {
+        out[2 * i] = t[i] & 0xff;
+        out[2 * i + 1] = t[i] >> 8;
+    }
+}
+
+static void unpack(FieldElement o, const u8* n)
+{
+    for (size_t i = 0; i < 16; ++i)
+        o[i] = n[2 * i] + ((i64)n[2 * i + 1] << 8);
+    // The most significant bit of the u-coordinate is ignored.
+    o[15] &= 0x7fff;
+}
+
+static void add(FieldElement o, const FieldElement a, const FieldElement b)
+{
+    for (size_t i = 0; i < 16; ++i)
+        o[i] = a[i] + b[i];
+}
+
+static void subtract(FieldElement o, const FieldElement a, const FieldElement b)
+{
+    for (size_t i = 0; i < 16; ++i)
+        o[i] = a[i] - b[i];
+}
+
+static void multiply(FieldElement o, const FieldElement a, const FieldElement b)
+{
+    i64 t[31] {};
+    for (size_t i = 0; i < 16; ++i) {
+        for (size_t j = 0; j < 16; ++j)
+            t[i + j] += a[i] * b[j];
+    }
+    for (size_t i = 0; i < 15; ++i)
+        t[i] += 38 * t[i + 16];
+    for (size_t i = 0; i < 16; ++i)
+        o[i] = t[i];
+    carry(o);
+    carry(o);
+}
+
+static void square(FieldElement o, const FieldElement a)
+{
+    multiply(o, a, a);
+}
+
+// Computes i^(p - 2), which is the inverse of i by Fermat's little theorem.
+static void invert(FieldElement o, const FieldElement i)
+{
+    FieldElement c;
+    for (size_t a = 0; a < 16; ++a)
+        c[a] = i[a];
+    for (int a = 253; a >= 0; --a) {
+        square(c, c);
+        if (a != 2 && a != 4)
+            multiply(c, c, i);
+    }
+    for (size_t a = 0; a < 16; ++a)
+        o[a] = c[a];
+}
+
+// The Montgomery ladder from RFC 7748, section 5.
+static void scalar_multiply(u8* out, const u8* scalar, const u8* point)
+{
+    static constexpr FieldElement a24 { 0xdb41, 1 }; // (486662 - 2) / 4 = 121665
+
+    u8 clamped[32];
+    for (size_t i = 0; i < 32; ++i)
+        clamped[i] = scalar[i];
+    clamped[0] &= 248;
+    clamped[31] = (clamped[31] & 127) | 64;
+
+    FieldElement x;
+    unpack(x, point);
+
+    FieldElement a {}, b, c {}, d {}, e, f;
+    for (size_t i = 0; i < 16; ++i)
+        b[i] = x[i];
+    a[0] = 1;
+    d[0] = 1;
+
+    for (int i = 254; i >= 0; --i) {
+        i64 bit = (clamped[i >> 3] >> (i & 7)) & 1;
+        conditional_swap(a, b, bit);
+        conditional_swap(c, d, bit);
+        add(e, a, c);
+        subtract(a, a, c);
+        add(c, b, d);
+        subtract(b, b, d);
+        square(d, e);
+        square(f, a);
+        multiply(a, c, a);
+        multiply(c, b, e);
+        add(e, a, c);
+        subtract(a, a, c);
+        square(b, a);
+        subtract(c, d, f);
+        multiply(a, c, a24);
+        add(a, a, d);
+        multiply(c, c, a);
+        multiply(a, d, f);
+        multiply(d, b, x);
+        square(b, e);
+        conditional_swap(a, b, bit);
+        conditional_swap(c, d, bit);
+    }
+
+    invert(c, c);
+    multiply(a, a, c);
+    pack(out, a);
+}
+
+void X25519::generate_private_key(Bytes private_key)
+{
+    VERIFY(private_key.size() == key_size);
+    fill_with_random(private_key.data(), key_size);
+}
+
+void X25519::compute_public_key(ReadonlyBytes private_key, Bytes public_key)
+{
+    VERIFY(private_key.size() == key_size);
+    VERIFY(public_key.size() == key_size);
+    static constexpr u8 base_point[32] { 9 };
+    scalar_multiply(public_key.data(), private_key.data(), base_point);
+}
+
+bool X25519::compute_shared_secret(ReadonlyBytes private_key, ReadonlyBytes peer_public_key, Bytes shared_secret)
+{
+    VERIFY(private_key.size() == key_size);
+    VERIFY(peer_public_key.size() == key_size);
+    VERIFY(shared_secret.size() == key_size);
+    scalar_multiply(shared_secret.data(), private_key.data(), peer_public_key.data());
+
+    u8 all_bits = 0;
+    for (auto byte : shared_secret)
+        all_bits |= byte;
+    return all_bits != 0;
+}
+
+}
+}
@@ -25,9 +25,18 @@
  */
 
 #include <AK/Endian.h>
+#include <AK/Platform.h>
 #include <AK/Types.h>
 #include <LibCrypto/Hash/SHA1.h>
 
+#if (ARCH(I386) || ARCH(X86_64)) && !defined(KERNEL)
+#    define SHA_USE_SHA_NI 1
+#    include <LibCrypto/CPUFeatures.h>
+#    include <immintrin.h>
+#else
+#    define SHA_USE_SHA_NI 0
+#endif
+
 namespace Crypto {
 namespace Hash {
 
@@ -36,8 +45,69 @@ inline static constexpr auto ROTATE_LEFT(u32 value, size_t bits)
     return (value << bits) | (value >> (32 - bits));
 }
 
+#if SHA_USE_SHA_NI
+// After Intel's "New Instructions Supporting the Secure Hash Algorithm on Intel Architecture Processors".
+// SHA1RNDS4 does four rounds at a time on ABCD, and SHA1NEXTE derives the next E from the old A.
+[[gnu::target("sha,sse4.1")]] static void transform_with_sha_ni(u32 (&state)[5], const u8* data)
+{
+    auto const byte_swap = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+
+    auto abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)state), 0x1b);
+    auto e = _mm_set_epi32(state[4], 0, 0, 0);
+    auto abcd_before = abcd;
+    auto e_before = e;
+
+    __m128i w0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 0)), byte_swap);
+    __m128i w1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 16)), byte_swap);
+    __m128i w2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 32)), byte_swap);
+    __m128i w3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 48)), byte_swap);
+
+    // Every iteration does four rounds with the message words in w0, and computes the words
+    // four rounds ahead from the ones it has, the same way the scalar code expands blocks[].
+    __m128i previous_abcd = abcd;
+    for (size_t i = 0; i < 20; ++i) {
+        e = i == 0 ? _mm_add_epi32(e, w0) : _mm_sha1nexte_epu32(previous_abcd, w0);
+        previous_abcd = abcd;
+        // The round function is an immediate operand, so it can't come from a variable.
+        switch (i / 5) {
+        case 0:
+            abcd = _mm_sha1rnds4_epu32(abcd, e, 0);
+            break;
+        case 1:
+            abcd = _mm_sha1rnds4_epu32(abcd, e, 1);
+            break;
+        case 2:
+            abcd = _mm_sha1rnds4_epu32(abcd, e, 2);
+            break;
+        default:
+            abcd = _mm_sha1rnds4_epu32(abcd, e, 3);
+            break;
+        }
+
+        auto next = _mm_sha1msg2_epu32(_mm_xor_si128(_mm_sha1msg1_epu32(w0, w1), w2), w3);
+        w0 = w1;
+        w1 = w2;
+        w2 = w3;
+        w3 = next;
+    }
+
+    e = _mm_sha1nexte_epu32(previous_abcd, e_before);
+    abcd = _mm_add_epi32(abcd, abcd_before);
+
+    _mm_storeu_si128((__m128i*)state, _mm_shuffle_epi32(abcd, 0x1b));
+    state[4] = _mm_extract_epi32(e, 3);
+}
+#endif
+
 inline void SHA1::transform(const u8* data)
 {
+#if SHA_USE_SHA_NI
+    if (cpu_supports_sha_ni()) {
+        transform_with_sha_ni(m_state, data);
+        return;
+    }
+#endif
+
     u32 blocks[80];
     for (size_t i = 0; i < 16; ++i)
         blocks[i] = AK::convert_between_host_and_network_endian(((const u32*)data)[i]);
@@ -88,13 +158,17 @@ inline void SHA1::transform(const u8* data)
 
 void SHA1::update(const u8* message, size_t length)
 {
-    for (size_t i = 0; i < length; ++i) {
+    while (length > 0) {
         if (m_data_length == BlockSize) {
             transform(m_data_buffer);
             m_bit_length += 512;
             m_data_length = 0;
         }
-        m_data_buffer[m_data_length++] = message[i];
+        size_t copy_length = min(length, BlockSize - m_data_length);
+        __builtin_memcpy(m_data_buffer + m_data_length, message, copy_length);
+        m_data_length += copy_length;
+        message += copy_length;
+        length -= copy_length;
     }
 }
 
@@ -113,7 +187,9 @@ SHA1::DigestType SHA1::peek()
     // make a local copy of the data as we modify it
     u8 data[BlockSize];
     u32 state[5];
-    __builtin_memcpy(data, m_data_buffer, m_data_length);
+    auto data_length = m_data_length;
+    auto bit_length = m_bit_length;
+    __builtin_memcpy(data, m_data_buffer, BlockSize);
     __builtin_memcpy(state, m_state, 20);
 
     if (BlockSize == m_data_length) {
@@ -160,8 +236,10 @@ SHA1::DigestType SHA1::peek()
         digest.data[i + 16] = (m_state[4] >> (24 - i * 8)) & 0x000000ff;
     }
     // restore the data
-    __builtin_memcpy(m_data_buffer, data, m_data_length);
+    __builtin_memcpy(m_data_buffer, data, BlockSize);
     __builtin_memcpy(m_state, state, 20);
+    m_data_length = data_length;
+    m_bit_length = bit_length;
     return digest;
 }
 
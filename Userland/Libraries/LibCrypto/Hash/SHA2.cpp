@@ -24,9 +24,19 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Platform.h>
 #include <AK/Types.h>
 #include <LibCrypto/Hash/SHA2.h>
 
+// The kernel builds this file too, but it can't touch the SSE registers.
+#if (ARCH(I386) || ARCH(X86_64)) && !defined(KERNEL)
+#    define SHA_USE_SHA_NI 1
+#    include <LibCrypto/CPUFeatures.h>
+#    include <immintrin.h>
+#else
+#    define SHA_USE_SHA_NI 0
+#endif
+
 namespace Crypto {
 namespace Hash {
 constexpr static auto ROTRIGHT(u32 a, size_t b) { return (a >> b) | (a << (32 - b)); }
@@ -45,8 +55,58 @@ constexpr static auto EP1(u64 x) { return ROTRIGHT(x, 14) ^ ROTRIGHT(x, 18) ^ RO
 constexpr static auto SIGN0(u64 x) { return ROTRIGHT(x, 1) ^ ROTRIGHT(x, 8) ^ (x >> 7); }
 constexpr static auto SIGN1(u64 x) { return ROTRIGHT(x, 19) ^ ROTRIGHT(x, 61) ^ (x >> 6); }
 
+#if SHA_USE_SHA_NI
+// After Intel's "New Instructions Supporting the Secure Hash Algorithm on Intel Architecture Processors".
+// SHA256RNDS2 wants the state split into ABEF and CDGH halves, and does two rounds at a time.
+[[gnu::target("sha,sse4.1")]] static void transform_with_sha_ni(u32 (&state)[8], const u8* data)
+{
+    auto const byte_swap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    auto cdab = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[0]), 0xb1);
+    auto efgh = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[4]), 0x1b);
+    auto abef = _mm_alignr_epi8(cdab, efgh, 8);
+    auto cdgh = _mm_blend_epi16(efgh, cdab, 0xf0);
+    auto abef_before = abef;
+    auto cdgh_before = cdgh;
+
+    __m128i w0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 0)), byte_swap);
+    __m128i w1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 16)), byte_swap);
+    __m128i w2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 32)), byte_swap);
+    __m128i w3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 48)), byte_swap);
+
+    // Every iteration does four rounds with the message words in w0, and computes the words
+    // four rounds ahead from the ones it has, the same way the scalar code expands m[].
+    for (size_t i = 0; i < 16; ++i) {
+        auto message = _mm_add_epi32(w0, _mm_loadu_si128((const __m128i*)&SHA256Constants::RoundConstants[i * 4]));
+        cdgh = _mm_sha256rnds2_epu32(cdgh, abef, message);
+        abef = _mm_sha256rnds2_epu32(abef, cdgh, _mm_shuffle_epi32(message, 0x0e));
+
+        auto next = _mm_sha256msg2_epu32(_mm_add_epi32(_mm_sha256msg1_epu32(w0, w1), _mm_alignr_epi8(w3, w2, 4)), w3);
+        w0 = w1;
+        w1 = w2;
+        w2 = w3;
+        w3 = next;
+    }
+
+    abef = _mm_add_epi32(abef, abef_before);
+    cdgh = _mm_add_epi32(cdgh, cdgh_before);
+
+    auto feba = _mm_shuffle_epi32(abef, 0x1b);
+    auto dchg = _mm_shuffle_epi32(cdgh, 0xb1);
+    _mm_storeu_si128((__m128i*)&state[0], _mm_blend_epi16(feba, dchg, 0xf0));
+    _mm_storeu_si128((__m128i*)&state[4], _mm_alignr_epi8(dchg, feba, 8));
+}
+#endif
+
 inline void SHA256::transform(const u8* data)
 {
+#if SHA_USE_SHA_NI
+    if (cpu_supports_sha_ni()) {
+        transform_with_sha_ni(m_state, data);
+        return;
+    }
+#endif
+
     u32 m[64];
 
     size_t i = 0;
@@ -88,13 +148,17 @@ inline void SHA256::transform(const u8* data)
 
 void SHA256::update(const u8* message, size_t length)
 {
-    for (size_t i = 0; i < length; ++i) {
+    while (length > 0) {
         if (m_data_length == BlockSize) {
             transform(m_data_buffer);
             m_bit_length += 512;
             m_data_length = 0;
         }
-        m_data_buffer[m_data_length++] = message[i];
+        size_t copy_length = min(length, BlockSize - m_data_length);
+        __builtin_memcpy(m_data_buffer + m_data_length, message, copy_length);
+        m_data_length += copy_length;
+        message += copy_length;
+        length -= copy_length;
     }
 }
 
@@ -110,6 +174,14 @@ SHA256::DigestType SHA256::peek()
     DigestType digest;
     size_t i = m_data_length;
 
+    // make a local copy of the state as we modify it
+    u8 data[BlockSize];
+    u32 state[8];
+    auto data_length = m_data_length;
+    auto bit_length = m_bit_length;
+    __builtin_memcpy(data, m_data_buffer, BlockSize);
+    __builtin_memcpy(state, m_state, sizeof(state));
+
     if (BlockSize == m_data_length) {
         transform(m_data_buffer);
         m_bit_length += BlockSize * 8;
@@ -159,6 +231,11 @@ SHA256::DigestType SHA256::peek()
         digest.data[i + 24] = (m_state[6] >> (24 - i * 8)) & 0x000000ff;
         digest.data[i + 28] = (m_state[7] >> (24 - i * 8)) & 0x000000ff;
     }
+    // restore the state
+    __builtin_memcpy(m_data_buffer, data, BlockSize);
+    __builtin_memcpy(m_state, state, sizeof(state));
+    m_data_length = data_length;
+    m_bit_length = bit_length;
     return digest;
 }
 
@@ -205,13 +282,17 @@ inline void SHA512::transform(const u8* data)
 
 void SHA512::update(const u8* message, size_t length)
 {
-    for (size_t i = 0; i < length; ++i) {
+    while (length > 0) {
         if (m_data_length == BlockSize) {
             transform(m_data_buffer);
             m_bit_length += 1024;
             m_data_length = 0;
         }
-        m_data_buffer[m_data_length++] = message[i];
+        size_t copy_length = min(length, BlockSize - m_data_length);
+        __builtin_memcpy(m_data_buffer + m_data_length, message, copy_length);
+        m_data_length += copy_length;
+        message += copy_length;
+        length -= copy_length;
     }
 }
 
@@ -227,6 +308,14 @@ SHA512::DigestType SHA512::peek()
     DigestType digest;
     size_t i = m_data_length;
 
+    // make a local copy of the state as we modify it
+    u8 data[BlockSize];
+    u64 state[8];
+    auto data_length = m_data_length;
+    auto bit_length = m_bit_length;
+    __builtin_memcpy(data, m_data_buffer, BlockSize);
+    __builtin_memcpy(state, m_state, sizeof(state));
+
     if (BlockSize == m_data_length) {
         transform(m_data_buffer);
         m_bit_length += BlockSize * 8;
@@ -276,6 +365,11 @@ SHA512::DigestType SHA512::peek()
         digest.data[i + 48] = (m_state[6] >> (56 - i * 8)) & 0x000000ff;
         digest.data[i + 56] = (m_state[7] >> (56 - i * 8)) & 0x000000ff;
     }
+    // restore the state
+    __builtin_memcpy(m_data_buffer, data, BlockSize);
+    __builtin_memcpy(m_state, state, sizeof(state));
+    m_data_length = data_length;
+    m_bit_length = bit_length;
     return digest;
 }
 }
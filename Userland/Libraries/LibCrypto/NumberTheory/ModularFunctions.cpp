@@ -117,11 +117,150 @@ UnsignedBigInteger ModularInverse(const UnsignedBigInteger& a_, const UnsignedBi
     return temp_remainder;
 }
 
+// Montgomery arithmetic works on residues in the form x * R mod m, where R = 2^(32 * n) for an odd n-word
+// modulus m. Products of such residues can be reduced with word multiplications and shifts, so a whole
+// exponentiation gets away with two divisions (to compute R^2 mod m and to reduce the base).
+
+// Returns -m^-1 mod 2^32, for odd m.
+static u32 montgomery_inverse(u32 m)
+{
+    // Newton's iteration doubles the number of correct low bits every step, and m is its own inverse mod 8.
+    u32 inverse = m;
+    for (size_t i = 0; i < 4; ++i)
+        inverse *= 2 - m * inverse;
+    return -inverse;
+}
+
+// output = left * right * R^-1 mod m, where all numbers have n words and left, right < m.
+// temp must have room for n + 2 words. output may alias left or right.
+static void montgomery_multiply(const u32* left, const u32* right, const u32* m, size_t n, u32 m_inverse, u32* temp, u32* output)
+{
+    __builtin_memset(temp, 0, (n + 2) * sizeof(u32));
+    for (size_t i = 0; i < n; ++i) {
+        // temp += left * right[i]
+        u64 carry = 0;
+        for (size_t j = 0; j < n; ++j) {
+            u64 sum = temp[j] + (u64)left[j] * right[i] + carry;
+            temp[j] = (u32)sum;
+            carry = sum >> 32;
+        }
+        u64 sum = temp[n] + carry;
+        temp[n] = (u32)sum;
+        temp[n + 1] = sum >> 32;
+
+        // temp = (temp + q * m) / 2^32, with q chosen so that the division is exact.
+        u32 q = temp[0] * m_inverse;
+        carry = (temp[0] + (u64)q * m[0]) >> 32;
+        for (size_t j = 1; j < n; ++j) {
+            sum = temp[j] + (u64)q * m[j] + carry;
+            temp[j - 1] = (u32)sum;
+            carry = sum >> 32;
+        }
+        sum = temp[n] + carry;
+        temp[n - 1] = (u32)sum;
+        temp[n] = temp[n + 1] + (u32)(sum >> 32);
+    }
+
+    // temp < 2m, so at most one subtraction is needed.
+    bool at_least_m = temp[n] != 0;
+    if (!at_least_m) {
+        at_least_m = true;
+        for (size_t i = n; i > 0; --i) {
+            if (temp[i - 1] != m[i - 1]) {
+                at_least_m = temp[i - 1] > m[i - 1];
+                break;
+            }
+        }
+    }
+    if (at_least_m) {
+        u32 borrow = 0;
+        for (size_t i = 0; i < n; ++i) {
+            u64 difference = (u64)temp[i] - m[i] - borrow;
+            temp[i] = (u32)difference;
+            borrow = (difference >> 32) & 1;
+        }
+    }
+    __builtin_memcpy(output, temp, n * sizeof(u32));
+}
+
+static void copy_words(const UnsignedBigInteger& number, u32* output, size_t n)
+{
+    size_t length = min(number.trimmed_length(), n);
+    __builtin_memcpy(output, number.words().data(), length * sizeof(u32));
+    __builtin_memset(output + length, 0, (n - length) * sizeof(u32));
+}
+
+static UnsignedBigInteger montgomery_modular_power(const UnsignedBigInteger& b, const UnsignedBigInteger& e, const UnsignedBigInteger& m)
+{
+    size_t n = m.trimmed_length();
+    u32 m_inverse = montgomery_inverse(m.words()[0]);
+    auto base = b < m ? b : b.divided_by(m).remainder;
+    auto r_squared = UnsignedBigInteger { 1 }.shift_left(64 * n).divided_by(m).remainder;
+
+    size_t exponent_bits = 0;
+    if (auto length = e.trimmed_length())
+        exponent_bits = 32 * length - __builtin_clz(e.words()[length - 1]);
+    auto exponent_bit = [&](size_t index) { return (e.words()[index / 32] >> (index % 32)) & 1; };
+
+    // Sliding windows: every run of up to window_bits exponent bits that starts and ends with a 1
+    // costs a single multiplication by a precomputed odd power of the base.
+    size_t window_bits = exponent_bits > 671 ? 6 : exponent_bits > 239 ? 5 : exponent_bits > 79 ? 4 : exponent_bits > 23 ? 3 : 1;
+
+    Vector<u32> words;
+    words.resize(n * (4 + (1 << (window_bits - 1))));
+    u32* temp = words.data();
+    u32* result = temp + n + 2;
+    u32* base_squared = result + n;
+    u32* odd_powers = base_squared + n;
+
+    copy_words(r_squared, result, n);
+    copy_words(base, odd_powers, n);
+    montgomery_multiply(odd_powers, result, m.words().data(), n, m_inverse, temp, odd_powers);
+    montgomery_multiply(odd_powers, odd_powers, m.words().data(), n, m_inverse, temp, base_squared);
+    for (size_t i = 1; i < (1u << (window_bits - 1)); ++i)
+        montgomery_multiply(odd_powers + (i - 1) * n, base_squared, m.words().data(), n, m_inverse, temp, odd_powers + i * n);
+
+    // result = 1 * R mod m
+    __builtin_memset(base_squared, 0, n * sizeof(u32));
+    base_squared[0] = 1;
+    montgomery_multiply(result, base_squared, m.words().data(), n, m_inverse, temp, result);
+
+    for (ssize_t i = exponent_bits - 1; i >= 0;) {
+        if (!exponent_bit(i)) {
+            montgomery_multiply(result, result, m.words().data(), n, m_inverse, temp, result);
+            --i;
+            continue;
+        }
+        ssize_t window_end = max<ssize_t>(i - window_bits + 1, 0);
+        while (!exponent_bit(window_end))
+            ++window_end;
+        size_t window_value = 0;
+        for (ssize_t j = i; j >= window_end; --j) {
+            window_value = (window_value << 1) | exponent_bit(j);
+            montgomery_multiply(result, result, m.words().data(), n, m_inverse, temp, result);
+        }
+        montgomery_multiply(result, odd_powers + (window_value / 2) * n, m.words().data(), n, m_inverse, temp, result);
+        i = window_end - 1;
+    }
+
+    // Leave the Montgomery form by multiplying with 1.
+    __builtin_memset(base_squared, 0, n * sizeof(u32));
+    base_squared[0] = 1;
+    montgomery_multiply(result, base_squared, m.words().data(), n, m_inverse, temp, result);
+
+    Vector<u32, STARTING_WORD_SIZE> result_words;
+    result_words.append(result, n);
+    return UnsignedBigInteger(move(result_words));
+}
+
 UnsignedBigInteger ModularPower(const UnsignedBigInteger& b, const UnsignedBigInteger& e, const UnsignedBigInteger& m)
 {
     if (m == 1)
         return 0;
 
+    if (m.words()[0] % 2 == 1)
+        return montgomery_modular_power(b, e, m);
+
     UnsignedBigInteger ep { e };
     UnsignedBigInteger base { b };
     UnsignedBigInteger exp { 1 };
@@ -137,7 +276,7 @@ UnsignedBigInteger ModularPower(const UnsignedBigInteger& b, const UnsignedBigIn
     while (!(ep < 1)) {
         if (ep.words()[0] % 2 == 1) {
             // exp = (exp * base) % m;
-            UnsignedBigInteger::multiply_without_allocation(exp, base, temp_1, temp_2, temp_3, temp_4, temp_multiply);
+            UnsignedBigInteger::multiply_without_allocation(exp, base, temp_1, temp_multiply);
             UnsignedBigInteger::divide_without_allocation(temp_multiply, m, temp_1, temp_2, temp_3, temp_4, temp_quotient, temp_remainder);
             exp.set_to(temp_remainder);
         }
@@ -147,7 +286,7 @@ UnsignedBigInteger ModularPower(const UnsignedBigInteger& b, const UnsignedBigIn
         ep.set_to(temp_quotient);
 
         // base = (base * base) % m;
-        UnsignedBigInteger::multiply_without_allocation(base, base, temp_1, temp_2, temp_3, temp_4, temp_multiply);
+        UnsignedBigInteger::multiply_without_allocation(base, base, temp_1, temp_multiply);
         UnsignedBigInteger::divide_without_allocation(temp_multiply, m, temp_1, temp_2, temp_3, temp_4, temp_quotient, temp_remainder);
         base.set_to(temp_remainder);
     }
@@ -229,7 +368,7 @@ UnsignedBigInteger LCM(const UnsignedBigInteger& a, const UnsignedBigInteger& b)
 
     // output = (a / gcd_output) * b
     UnsignedBigInteger::divide_without_allocation(a, gcd_output, temp_1, temp_2, temp_3, temp_4, temp_quotient, temp_remainder);
-    UnsignedBigInteger::multiply_without_allocation(temp_quotient, b, temp_1, temp_2, temp_3, temp_4, output);
+    UnsignedBigInteger::multiply_without_allocation(temp_quotient, b, temp_1, output);
 
     dbgln_if(NT_DEBUG, "quot: {} rem: {} out: {}", temp_quotient, temp_remainder, output);
 
@@ -25,6 +25,7 @@
  */
 
 #include "DebugInfo.h"
+#include <AK/AnyOf.h>
 #include <AK/Debug.h>
 #include <AK/LexicalPath.h>
 #include <AK/MemoryStream.h>
@@ -39,21 +40,76 @@ DebugInfo::DebugInfo(NonnullOwnPtr<const ELF::Image> elf, String source_root, Fl
     : m_elf(move(elf))
     , m_source_root(source_root)
     , m_base_address(base_address)
-    , m_dwarf_info(*m_elf)
+    , m_dwarf_info(make<Dwarf::DwarfInfo>(*m_elf))
 {
-    prepare_variable_scopes();
-    prepare_lines();
 }
 
-void DebugInfo::prepare_variable_scopes()
+void DebugInfo::prepare_compilation_units() const
 {
-    m_dwarf_info.for_each_compilation_unit([&](const Dwarf::CompilationUnit& unit) {
+    if (m_has_prepared_compilation_units)
+        return;
+    m_has_prepared_compilation_units = true;
+
+    m_dwarf_info->for_each_compilation_unit([&](const Dwarf::CompilationUnit& unit) {
+        CompilationUnitScopes unit_scopes;
+        unit_scopes.unit = &unit;
+
+        // Only look at the root DIE for now, so we know which addresses the unit covers.
         auto root = unit.root_die();
-        parse_scopes_impl(root);
+        auto low_pc = root.get_attribute(Dwarf::Attribute::LowPc);
+        auto high_pc = root.get_attribute(Dwarf::Attribute::HighPc);
+        auto ranges = root.get_attribute(Dwarf::Attribute::Ranges);
+        u32 base_address = low_pc.has_value() ? low_pc.value().data.as_u32 : 0;
+        if (ranges.has_value() && ranges.value().type == Dwarf::DIE::AttributeValue::Type::SecOffset) {
+            // Units with code in several sections (e.g. for inline functions) list their ranges in .debug_ranges.
+            InputMemoryStream stream { m_dwarf_info->debug_ranges_data() };
+            stream.discard_or_error(ranges.value().data.as_u32);
+            for (;;) {
+                u32 begin = 0;
+                u32 end = 0;
+                stream >> begin >> end;
+                if (stream.handle_any_error() || (begin == 0 && end == 0))
+                    break;
+                if (begin == NumericLimits<u32>::max()) {
+                    base_address = end;
+                    continue;
+                }
+                unit_scopes.address_ranges.append({ base_address + begin, base_address + end });
+            }
+        } else if (low_pc.has_value() && high_pc.has_value()) {
+            // Like for scopes, HighPc is an offset from LowPc.
+            unit_scopes.address_ranges.append({ base_address, base_address + high_pc.value().data.as_u32 });
+        }
+        if (unit_scopes.address_ranges.is_empty()) {
+            // We don't know which addresses it covers, so it has to be searched for all of them.
+            unit_scopes.address_ranges.append({ 0, NumericLimits<u32>::max() });
+        }
+        m_compilation_units.append(move(unit_scopes));
     });
 }
 
-void DebugInfo::parse_scopes_impl(const Dwarf::DIE& die)
+template<typename Callback>
+void DebugInfo::for_each_scope_containing(u32 address, Callback callback) const
+{
+    prepare_compilation_units();
+    for (auto& unit_scopes : m_compilation_units) {
+        bool unit_contains_address = any_of(unit_scopes.address_ranges.begin(), unit_scopes.address_ranges.end(), [&](auto& range) {
+            return address >= range.low && address < range.high;
+        });
+        if (!unit_contains_address)
+            continue;
+        if (!unit_scopes.has_parsed_scopes) {
+            unit_scopes.has_parsed_scopes = true;
+            parse_scopes_impl(unit_scopes.unit->root_die(), unit_scopes.scopes);
+        }
+        for (auto& scope : unit_scopes.scopes) {
+            if (address >= scope.address_low && address < scope.address_high)
+                callback(scope);
+        }
+    }
+}
+
+void DebugInfo::parse_scopes_impl(const Dwarf::DIE& die, Vector<VariablesScope>& scopes)
 {
     die.for_each_child([&](const Dwarf::DIE& child) {
         if (child.is_null())
@@ -96,14 +152,18 @@ void DebugInfo::parse_scopes_impl(const Dwarf::DIE& die)
                 return;
             scope.dies_of_variables.append(variable_entry);
         });
-        m_scopes.append(scope);
+        scopes.append(scope);
 
-        parse_scopes_impl(child);
+        parse_scopes_impl(child, scopes);
     });
 }
 
-void DebugInfo::prepare_lines()
+void DebugInfo::prepare_lines() const
 {
+    if (m_has_prepared_lines)
+        return;
+    m_has_prepared_lines = true;
+
     auto section = elf().lookup_section(".debug_line");
     if (section.is_undefined())
         return;
@@ -134,22 +194,33 @@ void DebugInfo::prepare_lines()
     quick_sort(m_sorted_lines, [](auto& a, auto& b) {
         return a.address < b.address;
     });
+
+    for (size_t i = 0; i < m_sorted_lines.size(); ++i)
+        m_line_indices_by_file.ensure(m_sorted_lines[i].file).append(i);
 }
 
 Optional<DebugInfo::SourcePosition> DebugInfo::get_source_position(u32 target_address) const
 {
+    prepare_lines();
     if (m_sorted_lines.is_empty())
         return {};
     if (target_address < m_sorted_lines[0].address)
         return {};
 
-    // TODO: We can do a binray search here
-    for (size_t i = 0; i < m_sorted_lines.size() - 1; ++i) {
-        if (m_sorted_lines[i + 1].address > target_address) {
-            return SourcePosition::from_line_info(m_sorted_lines[i]);
-        }
+    // Find the first line whose address is after the target address; the one before it contains it.
+    size_t low = 1;
+    size_t high = m_sorted_lines.size();
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (m_sorted_lines[middle].address > target_address)
+            high = middle;
+        else
+            low = middle + 1;
     }
-    return {};
+    // Like before, the last line only marks where the code ends.
+    if (low == m_sorted_lines.size())
+        return {};
+    return SourcePosition::from_line_info(m_sorted_lines[low - 1]);
 }
 
 Optional<DebugInfo::SourcePositionAndAddress> DebugInfo::get_address_from_source_position(const String& file, size_t line) const
@@ -164,19 +235,23 @@ Optional<DebugInfo::SourcePositionAndAddress> DebugInfo::get_address_from_source
         file_path = String::format("../%s", file_path.characters());
     }
 
+    prepare_lines();
     Optional<SourcePositionAndAddress> result;
-    for (const auto& line_entry : m_sorted_lines) {
-        if (!line_entry.file.ends_with(file_path))
+    for (auto& it : m_line_indices_by_file) {
+        if (!it.key.view().ends_with(file_path))
             continue;
 
-        if (line_entry.line > line)
-            continue;
+        for (auto index : it.value) {
+            auto& line_entry = m_sorted_lines[index];
+            if (line_entry.line > line)
+                continue;
 
-        // We look for the source position that is closest to the desired position, and is not after it.
-        // For example, get_address_of_source_position("main.cpp", 73) could return the address for an instruction whose location is ("main.cpp", 72)
-        // as there might not be an instruction mapped for "main.cpp", 73.
-        if (!result.has_value() || (line_entry.line > result.value().line)) {
-            result = SourcePositionAndAddress { line_entry.file, line_entry.line, line_entry.address };
+            // We look for the source position that is closest to the desired position, and is not after it.
+            // For example, get_address_of_source_position("main.cpp", 73) could return the address for an instruction whose location is ("main.cpp", 72)
+            // as there might not be an instruction mapped for "main.cpp", 73.
+            if (!result.has_value() || (line_entry.line > result.value().line)) {
+                result = SourcePositionAndAddress { line_entry.file, line_entry.line, line_entry.address };
+            }
         }
     }
     return result;
@@ -186,18 +261,14 @@ NonnullOwnPtrVector<DebugInfo::VariableInfo> DebugInfo::get_variables_in_current
 {
     NonnullOwnPtrVector<DebugInfo::VariableInfo> variables;
 
-    // TODO: We can store the scopes in a better data structure
-    for (const auto& scope : m_scopes) {
-        if (regs.eip - m_base_address < scope.address_low || regs.eip - m_base_address >= scope.address_high)
-            continue;
-
+    for_each_scope_containing(regs.eip - m_base_address, [&](const VariablesScope& scope) {
         for (const auto& die_entry : scope.dies_of_variables) {
             auto variable_info = create_variable_info(die_entry, regs);
             if (!variable_info)
                 continue;
             variables.append(variable_info.release_nonnull());
         }
-    }
+    });
     return variables;
 }
 
@@ -340,16 +411,17 @@ String DebugInfo::name_of_containing_function(u32 address) const
 
 Optional<DebugInfo::VariablesScope> DebugInfo::get_containing_function(u32 address) const
 {
-    for (const auto& scope : m_scopes) {
-        if (!scope.is_function || address < scope.address_low || address >= scope.address_high)
-            continue;
-        return scope;
-    }
-    return {};
+    Optional<VariablesScope> function;
+    for_each_scope_containing(address, [&](const VariablesScope& scope) {
+        if (scope.is_function && !function.has_value())
+            function = scope;
+    });
+    return function;
 }
 
 Vector<DebugInfo::SourcePosition> DebugInfo::source_lines_in_scope(const VariablesScope& scope) const
 {
+    prepare_lines();
     Vector<DebugInfo::SourcePosition> source_lines;
     for (const auto& line : m_sorted_lines) {
         if (line.address < scope.address_low)
@@ -26,6 +26,8 @@
 
 #pragma once
 
+#include <AK/FlyString.h>
+#include <AK/HashMap.h>
 #include <AK/NonnullOwnPtrVector.h>
 #include <AK/NonnullRefPtr.h>
 #include <AK/Optional.h>
@@ -121,6 +123,7 @@ public:
     template<typename Callback>
     void for_each_source_position(Callback callback) const
     {
+        prepare_lines();
         FlyString previous_file = "";
         size_t previous_line = 0;
         for (const auto& line_info : m_sorted_lines) {
@@ -137,18 +140,39 @@ public:
     Optional<VariablesScope> get_containing_function(u32 address) const;
 
 private:
-    void prepare_variable_scopes();
-    void prepare_lines();
-    void parse_scopes_impl(const Dwarf::DIE& die);
+    // The DWARF information is only parsed once somebody asks for it, and the scopes only
+    // for the compilation units that contain the addresses that are asked about.
+    struct CompilationUnitScopes {
+        struct AddressRange {
+            u32 low { 0 };
+            u32 high { 0 }; // Non-inclusive
+        };
+        const Dwarf::CompilationUnit* unit { nullptr };
+        Vector<AddressRange, 1> address_ranges;
+        bool has_parsed_scopes { false };
+        Vector<VariablesScope> scopes;
+    };
+
+    void prepare_compilation_units() const;
+    void prepare_lines() const;
+    static void parse_scopes_impl(const Dwarf::DIE& die, Vector<VariablesScope>&);
+    template<typename Callback>
+    void for_each_scope_containing(u32 address, Callback) const;
     OwnPtr<VariableInfo> create_variable_info(const Dwarf::DIE& variable_die, const PtraceRegisters&) const;
 
     NonnullOwnPtr<const ELF::Image> m_elf;
     String m_source_root;
     FlatPtr m_base_address { 0 };
-    Dwarf::DwarfInfo m_dwarf_info;
+    // This is on the heap, since the compilation units and DIEs refer to it and DebugInfo can be moved.
+    NonnullOwnPtr<Dwarf::DwarfInfo> m_dwarf_info;
+
+    mutable bool m_has_prepared_compilation_units { false };
+    mutable Vector<CompilationUnitScopes> m_compilation_units;
 
-    Vector<VariablesScope> m_scopes;
-    Vector<Dwarf::LineProgram::LineInfo> m_sorted_lines;
+    mutable bool m_has_prepared_lines { false };
+    mutable Vector<Dwarf::LineProgram::LineInfo> m_sorted_lines;
+    // Indices into m_sorted_lines, by file.
+    mutable HashMap<FlyString, Vector<size_t>> m_line_indices_by_file;
 };
 
 }
@@ -35,11 +35,12 @@ AbbreviationsMap::AbbreviationsMap(const DwarfInfo& dwarf_info, u32 offset)
     : m_dwarf_info(dwarf_info)
     , m_offset(offset)
 {
-    populate_map();
 }
 
-void AbbreviationsMap::populate_map()
+void AbbreviationsMap::populate_map() const
 {
+    m_is_populated = true;
+
     InputMemoryStream abbreviation_stream(m_dwarf_info.abbreviation_data());
     abbreviation_stream.discard_or_error(m_offset);
 
@@ -80,9 +81,14 @@ void AbbreviationsMap::populate_map()
     }
 }
 
-Optional<AbbreviationsMap::AbbreviationEntry> AbbreviationsMap::get(u32 code) const
+const AbbreviationsMap::AbbreviationEntry* AbbreviationsMap::get(u32 code) const
 {
-    return m_entries.get(code);
+    if (!m_is_populated)
+        populate_map();
+    auto it = m_entries.find(code);
+    if (it == m_entries.end())
+        return nullptr;
+    return &it->value;
 }
 
 }
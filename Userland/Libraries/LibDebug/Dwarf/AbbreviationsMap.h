@@ -47,14 +47,16 @@ public:
         Vector<AttributeSpecification> attribute_specifications;
     };
 
-    Optional<AbbreviationEntry> get(u32 code) const;
+    const AbbreviationEntry* get(u32 code) const;
 
 private:
-    void populate_map();
+    void populate_map() const;
 
     const DwarfInfo& m_dwarf_info;
     u32 m_offset { 0 };
-    HashMap<u32, AbbreviationEntry> m_entries;
+    // The abbreviations are only parsed once a DIE of the compilation unit is looked at.
+    mutable bool m_is_populated { false };
+    mutable HashMap<u32, AbbreviationEntry> m_entries;
 };
 
 }
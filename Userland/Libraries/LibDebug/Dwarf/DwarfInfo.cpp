@@ -36,6 +36,7 @@ DwarfInfo::DwarfInfo(const ELF::Image& elf)
     m_debug_info_data = section_data(".debug_info");
     m_abbreviation_data = section_data(".debug_abbrev");
     m_debug_strings_data = section_data(".debug_str");
+    m_debug_ranges_data = section_data(".debug_ranges");
 
     populate_compilation_units();
 }
@@ -43,6 +43,7 @@ public:
     ReadonlyBytes debug_info_data() const { return m_debug_info_data; }
     ReadonlyBytes abbreviation_data() const { return m_abbreviation_data; }
     ReadonlyBytes debug_strings_data() const { return m_debug_strings_data; }
+    ReadonlyBytes debug_ranges_data() const { return m_debug_ranges_data; }
 
     template<typename Callback>
     void for_each_compilation_unit(Callback) const;
@@ -56,6 +57,7 @@ private:
     ReadonlyBytes m_debug_info_data;
     ReadonlyBytes m_abbreviation_data;
     ReadonlyBytes m_debug_strings_data;
+    ReadonlyBytes m_debug_ranges_data;
 
     Vector<Dwarf::CompilationUnit> m_compilation_units;
 };
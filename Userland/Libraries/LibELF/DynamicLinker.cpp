@@ -26,6 +26,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/ByteBuffer.h>
 #include <AK/Debug.h>
 #include <AK/HashMap.h>
 #include <AK/HashTable.h>
@@ -42,6 +43,9 @@
 #include <LibELF/Hashes.h>
 #include <dlfcn.h>
 #include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <syscall.h>
 
@@ -50,6 +54,27 @@ namespace ELF {
 namespace {
 HashMap<String, NonnullRefPtr<ELF::DynamicLoader>> g_loaders;
 Vector<NonnullRefPtr<ELF::DynamicObject>> g_global_objects;
+// Parallel to g_global_objects.
+Vector<DynamicLoader::FileIdentity> g_global_object_identities;
+
+// Symbol names are views into the string tables of loaded objects, which stay mapped for good.
+HashMap<StringView, DynamicObject::SymbolLookupResult> g_symbol_lookup_cache;
+
+// The prelink cache remembers which of the global objects ended up providing each symbol the last
+// time this executable was linked. It's only trusted if all objects are the same files, in the same
+// order, as back then; the search order is deterministic, so the answers are too.
+struct PrelinkCacheEntry {
+    u32 object_index { 0 };
+    u32 bind { 0 };
+    FlatPtr value { 0 };
+};
+constexpr u32 prelink_cache_magic = 0x4b4e4c50; // "PLNK"
+constexpr u32 prelink_cache_version = 1;
+String g_prelink_cache_path;
+ByteBuffer g_prelink_cache_data;
+// Symbol names are views into g_prelink_cache_data.
+HashMap<StringView, PrelinkCacheEntry> g_prelink_cache;
+bool g_prelink_cache_is_valid { false };
 
 using EntryPointFunction = int (*)(int, char**, char**);
 using LibCExitFunction = void (*)(int);
@@ -59,11 +84,37 @@ size_t g_total_tls_size = 0;
 char** g_envp = nullptr;
 LibCExitFunction g_libc_exit = nullptr;
 
+String g_main_program_name;
+
 bool g_allowed_to_check_environment_variables { false };
 bool g_do_breakpoint_trap_before_entry { false };
+bool g_do_exit_before_entry { false };
+bool g_bind_now { false };
 }
 
 Optional<DynamicObject::SymbolLookupResult> DynamicLinker::lookup_global_symbol(const StringView& symbol)
+{
+    if (auto it = g_symbol_lookup_cache.find(symbol); it != g_symbol_lookup_cache.end())
+        return it->value;
+
+    if (g_prelink_cache_is_valid) {
+        if (auto it = g_prelink_cache.find(symbol); it != g_prelink_cache.end()) {
+            auto& entry = it->value;
+            auto& object = g_global_objects[entry.object_index];
+            auto address = object->elf_is_dynamic() ? object->base_address().offset(entry.value) : VirtualAddress { entry.value };
+            DynamicObject::SymbolLookupResult result { entry.value, address, entry.bind, object.ptr() };
+            g_symbol_lookup_cache.set(symbol, result);
+            return result;
+        }
+    }
+
+    auto result = search_global_objects(symbol);
+    if (result.has_value())
+        g_symbol_lookup_cache.set(symbol, result.value());
+    return result;
+}
+
+Optional<DynamicObject::SymbolLookupResult> DynamicLinker::search_global_objects(const StringView& symbol)
 {
     Optional<DynamicObject::SymbolLookupResult> weak_result;
 
@@ -90,6 +141,8 @@ static void map_library(const String& name, int fd)
         dbgln("Failed to create ELF::DynamicLoader for fd={}, name={}", fd, name);
         VERIFY_NOT_REACHED();
     }
+    // Sharing library addresses between processes weakens ASLR, so secure programs don't.
+    loader->set_may_share_image(g_allowed_to_check_environment_variables);
     loader->set_tls_offset(g_current_tls_offset);
 
     g_loaders.set(name, *loader);
@@ -203,6 +256,103 @@ static NonnullRefPtrVector<DynamicLoader> collect_loaders_for_executable(const S
     return loaders;
 }
 
+template<typename T>
+static bool read_from(ReadonlyBytes& bytes, T& value)
+{
+    if (bytes.size() < sizeof(T))
+        return false;
+    memcpy(&value, bytes.data(), sizeof(T));
+    bytes = bytes.slice(sizeof(T));
+    return true;
+}
+
+static void load_prelink_cache()
+{
+    int fd = open(g_prelink_cache_path.characters(), O_RDONLY);
+    if (fd < 0)
+        return;
+    ScopeGuard close_fd = [&] { close(fd); };
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size <= 0)
+        return;
+    auto buffer = ByteBuffer::create_uninitialized(st.st_size);
+    if (read(fd, buffer.data(), buffer.size()) != (ssize_t)buffer.size())
+        return;
+
+    ReadonlyBytes bytes = buffer.bytes();
+    u32 magic = 0;
+    u32 version = 0;
+    u32 object_count = 0;
+    if (!read_from(bytes, magic) || !read_from(bytes, version) || !read_from(bytes, object_count))
+        return;
+    if (magic != prelink_cache_magic || version != prelink_cache_version || object_count != g_global_object_identities.size())
+        return;
+    for (auto& identity : g_global_object_identities) {
+        DynamicLoader::FileIdentity cached_identity;
+        if (!read_from(bytes, cached_identity) || !(cached_identity == identity)) {
+            dbgln_if(DYNAMIC_LOAD_DEBUG, "Prelink cache {} is stale", g_prelink_cache_path);
+            return;
+        }
+    }
+
+    u32 entry_count = 0;
+    if (!read_from(bytes, entry_count))
+        return;
+    for (u32 i = 0; i < entry_count; ++i) {
+        PrelinkCacheEntry entry;
+        u32 name_length = 0;
+        if (!read_from(bytes, entry) || !read_from(bytes, name_length) || bytes.size() < name_length || entry.object_index >= object_count) {
+            g_prelink_cache.clear();
+            return;
+        }
+        g_prelink_cache.set(StringView(bytes.data(), name_length), entry);
+        bytes = bytes.slice(name_length);
+    }
+    g_prelink_cache_data = move(buffer);
+    g_prelink_cache_is_valid = true;
+    dbgln_if(DYNAMIC_LOAD_DEBUG, "Loaded {} symbols from prelink cache {}", g_prelink_cache.size(), g_prelink_cache_path);
+}
+
+static void save_prelink_cache()
+{
+    HashMap<const DynamicObject*, u32> object_indices;
+    for (size_t i = 0; i < g_global_objects.size(); ++i)
+        object_indices.set(g_global_objects[i].ptr(), i);
+
+    ByteBuffer buffer;
+    auto append = [&](const auto& value) { buffer.append(&value, sizeof(value)); };
+    append(prelink_cache_magic);
+    append(prelink_cache_version);
+    append((u32)g_global_object_identities.size());
+    for (auto& identity : g_global_object_identities)
+        append(identity);
+
+    u32 entry_count = 0;
+    size_t entry_count_offset = buffer.size();
+    append(entry_count);
+    for (auto& it : g_symbol_lookup_cache) {
+        auto index = object_indices.get(it.value.dynamic_object);
+        if (!index.has_value())
+            continue;
+        append(PrelinkCacheEntry { index.value(), it.value.bind, it.value.value });
+        append((u32)it.key.length());
+        buffer.append(it.key.characters_without_null_termination(), it.key.length());
+        ++entry_count;
+    }
+    memcpy(buffer.data() + entry_count_offset, &entry_count, sizeof(entry_count));
+
+    // Write to the side and rename, so a concurrent launch never sees a half-written cache.
+    auto temporary_path = String::formatted("{}.{}", g_prelink_cache_path, getpid());
+    int fd = open(temporary_path.characters(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0)
+        return;
+    bool success = write(fd, buffer.data(), buffer.size()) == (ssize_t)buffer.size();
+    close(fd);
+    if (!success || rename(temporary_path.characters(), g_prelink_cache_path.characters()) < 0)
+        unlink(temporary_path.characters());
+}
+
 static NonnullRefPtr<DynamicLoader> load_main_executable(const String& name)
 {
     // NOTE: We always map the main executable first, since it may require
@@ -210,22 +360,30 @@ static NonnullRefPtr<DynamicLoader> load_main_executable(const String& name)
     auto& main_executable_loader = *g_loaders.get(name).value();
     auto main_executable_object = main_executable_loader.map();
     g_global_objects.append(*main_executable_object);
+    g_global_object_identities.append(main_executable_loader.file_identity());
 
     auto loaders = collect_loaders_for_executable(name);
 
     for (auto& loader : loaders) {
         auto dynamic_object = loader.map();
-        if (dynamic_object)
+        if (dynamic_object) {
             g_global_objects.append(*dynamic_object);
+            g_global_object_identities.append(loader.file_identity());
+        }
     }
 
+    if (!g_prelink_cache_path.is_null())
+        load_prelink_cache();
+
+    unsigned flags = RTLD_GLOBAL | (g_bind_now ? RTLD_NOW : RTLD_LAZY);
+
     for (auto& loader : loaders) {
-        bool success = loader.link(RTLD_GLOBAL | RTLD_LAZY, g_total_tls_size);
+        bool success = loader.link(flags, g_total_tls_size);
         VERIFY(success);
     }
 
     for (auto& loader : loaders) {
-        auto object = loader.load_stage_3(RTLD_GLOBAL | RTLD_LAZY, g_total_tls_size);
+        auto object = loader.load_stage_3(flags, g_total_tls_size);
         VERIFY(object);
 
         if (loader.filename() == "libsystem.so") {
@@ -239,6 +397,13 @@ static NonnullRefPtr<DynamicLoader> load_main_executable(const String& name)
         }
     }
 
+    // All eager relocations are done, so we've seen most of the symbols this program will ever need.
+    if (!g_prelink_cache_path.is_null() && !g_prelink_cache_is_valid)
+        save_prelink_cache();
+    g_prelink_cache.clear();
+    g_prelink_cache_data.clear();
+    g_prelink_cache_is_valid = false;
+
     for (auto& loader : loaders) {
         loader.load_stage_4();
     }
@@ -249,15 +414,31 @@ static NonnullRefPtr<DynamicLoader> load_main_executable(const String& name)
 static void read_environment_variables()
 {
     for (char** env = g_envp; *env; ++env) {
-        if (StringView { *env } == "_LOADER_BREAKPOINT=1") {
+        StringView env_string { *env };
+        if (env_string == "_LOADER_BREAKPOINT=1") {
             g_do_breakpoint_trap_before_entry = true;
         }
+        // Exits right where main() would be called, for measuring how long it takes to get there.
+        if (env_string == "_LOADER_EXIT_BEFORE_ENTRY=1") {
+            g_do_exit_before_entry = true;
+        }
+        // As with other loaders, any non-empty LD_BIND_NOW resolves all PLT entries up front.
+        if (env_string.starts_with("LD_BIND_NOW=") && env_string.length() > strlen("LD_BIND_NOW=")) {
+            g_bind_now = true;
+        }
+        // _LOADER_PRELINK_CACHE=<directory> keeps a prelink cache for each executable in that directory.
+        if (env_string.starts_with("_LOADER_PRELINK_CACHE=")) {
+            auto directory = env_string.substring_view(strlen("_LOADER_PRELINK_CACHE="));
+            if (!directory.is_empty())
+                g_prelink_cache_path = String::formatted("{}/{}.prelink", directory, get_library_name(g_main_program_name));
+        }
     }
 }
 
 void ELF::DynamicLinker::linker_main(String&& main_program_name, int main_program_fd, bool is_secure, int argc, char** argv, char** envp)
 {
     g_envp = envp;
+    g_main_program_name = main_program_name;
 
     g_allowed_to_check_environment_variables = !is_secure;
     if (g_allowed_to_check_environment_variables)
@@ -292,6 +473,9 @@ void ELF::DynamicLinker::linker_main(String&& main_program_name, int main_progra
     if (g_do_breakpoint_trap_before_entry) {
         asm("int3");
     }
+    if (g_do_exit_before_entry) {
+        _exit(0);
+    }
     rc = entry_point_function(argc, argv, envp);
     dbgln_if(DYNAMIC_LOAD_DEBUG, "rc: {}", rc);
     if (g_libc_exit != nullptr) {
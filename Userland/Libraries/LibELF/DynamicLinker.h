@@ -38,6 +38,8 @@ public:
     [[noreturn]] static void linker_main(String&& main_program_name, int fd, bool is_secure, int argc, char** argv, char** envp);
 
 private:
+    static Optional<DynamicObject::SymbolLookupResult> search_global_objects(const StringView& symbol);
+
     DynamicLinker() = delete;
     ~DynamicLinker() = delete;
 };
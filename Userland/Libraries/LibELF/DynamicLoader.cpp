@@ -72,12 +72,14 @@ RefPtr<DynamicLoader> DynamicLoader::try_create(int fd, String filename)
         return {};
     }
 
-    return adopt(*new DynamicLoader(fd, move(filename), data, size));
+    FileIdentity identity { (u64)stat.st_dev, (u64)stat.st_ino, (i64)stat.st_mtime, (u64)stat.st_size };
+    return adopt(*new DynamicLoader(fd, move(filename), data, size, identity));
 }
 
-DynamicLoader::DynamicLoader(int fd, String filename, void* data, size_t size)
+DynamicLoader::DynamicLoader(int fd, String filename, void* data, size_t size, const FileIdentity& identity)
     : m_filename(move(filename))
     , m_file_size(size)
+    , m_file_identity(identity)
     , m_image_fd(fd)
     , m_file_data(data)
     , m_elf_image((u8*)m_file_data, m_file_size)
@@ -181,6 +183,7 @@ bool DynamicLoader::link(unsigned flags, size_t total_tls_size)
 bool DynamicLoader::load_stage_2(unsigned flags, size_t total_tls_size)
 {
     VERIFY(flags & RTLD_GLOBAL);
+    m_bind_now = flags & RTLD_NOW;
 
     if (m_dynamic_object->has_text_relocations()) {
         VERIFY(m_text_segment_load_address.get() != 0);
@@ -245,6 +248,11 @@ RefPtr<DynamicObject> DynamicLoader::load_stage_3(unsigned flags, size_t total_t
             perror("set_mmap_name .relro");
             return nullptr;
         }
+
+        // Other processes that have this library at the same address most likely ended up
+        // with the very same .relro pages, so we can do with a single copy of them.
+        if (m_may_share_image)
+            (void)madvise(m_relro_segment_address.as_ptr(), m_relro_segment_size, MADV_SHARE_IDENTICAL);
 #endif
     }
 
@@ -325,7 +333,13 @@ void DynamicLoader::load_program_headers()
     size_t text_segment_size = ph_text_end - ph_text_base;
     size_t data_segment_size = ph_data_end - ph_data_base;
 
-    auto* reservation = mmap(requested_load_address, total_mapping_size, PROT_NONE, reservation_mmap_flags, 0, 0);
+    void* reservation = MAP_FAILED;
+#ifdef __serenity__
+    if (m_elf_image.is_dynamic() && m_may_share_image)
+        reservation = reserve_shared_image(m_image_fd, total_mapping_size);
+#endif
+    if (reservation == MAP_FAILED)
+        reservation = mmap(requested_load_address, total_mapping_size, PROT_NONE, reservation_mmap_flags, 0, 0);
     if (reservation == MAP_FAILED) {
         perror("mmap reservation");
         VERIFY_NOT_REACHED();
@@ -469,8 +483,7 @@ DynamicLoader::RelocationResult DynamicLoader::do_relocation(size_t total_tls_si
         break;
     }
     case R_386_JMP_SLOT: {
-        // FIXME: Or BIND_NOW flag passed in?
-        if (m_dynamic_object->must_bind_now()) {
+        if (m_bind_now || m_dynamic_object->must_bind_now()) {
             // Eagerly BIND_NOW the PLT entries, doing all the symbol looking goodness
             // The patch method returns the address for the LAZY fixup path, but we don't need it here
             m_dynamic_object->patch_plt_entry(relocation.offset_in_section());
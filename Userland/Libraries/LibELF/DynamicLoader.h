@@ -45,6 +45,20 @@ public:
 
     const String& filename() const { return m_filename; }
 
+    // Identifies the file this image was loaded from, so caches derived from it can tell when it changed.
+    struct FileIdentity {
+        u64 device { 0 };
+        u64 inode { 0 };
+        i64 modification_time { 0 };
+        u64 size { 0 };
+
+        bool operator==(const FileIdentity& other) const
+        {
+            return device == other.device && inode == other.inode && modification_time == other.modification_time && size == other.size;
+        }
+    };
+    const FileIdentity& file_identity() const { return m_file_identity; }
+
     bool is_valid() const { return m_valid; }
 
     // Load a full ELF image from file into the current process and create an DynamicObject
@@ -66,6 +80,10 @@ public:
     // Intended for use by dlsym or other internal methods
     void* symbol_for_name(const StringView&);
 
+    // Map the image at the same address as in other processes, and share its relocated
+    // read-only pages with them. Not something setuid programs should do.
+    void set_may_share_image(bool may_share_image) { m_may_share_image = may_share_image; }
+
     void set_tls_offset(size_t offset) { m_tls_offset = offset; };
     size_t tls_size() const { return m_tls_size; }
     size_t tls_offset() const { return m_tls_offset; }
@@ -80,7 +98,7 @@ public:
     static Optional<DynamicObject::SymbolLookupResult> lookup_symbol(const ELF::DynamicObject::Symbol&);
 
 private:
-    DynamicLoader(int fd, String filename, void* file_data, size_t file_size);
+    DynamicLoader(int fd, String filename, void* file_data, size_t file_size, const FileIdentity&);
 
     class ProgramHeaderRegion {
     public:
@@ -134,10 +152,13 @@ private:
     String m_filename;
     String m_program_interpreter;
     size_t m_file_size { 0 };
+    FileIdentity m_file_identity;
     int m_image_fd { -1 };
     void* m_file_data { nullptr };
     ELF::Image m_elf_image;
     bool m_valid { true };
+    bool m_may_share_image { false };
+    bool m_bind_now { false };
 
     RefPtr<DynamicObject> m_dynamic_object;
 
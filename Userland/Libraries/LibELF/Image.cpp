@@ -327,15 +327,10 @@ Optional<Image::Symbol> Image::find_demangled_function(const String& name) const
     return found;
 }
 
-Optional<Image::Symbol> Image::find_symbol(u32 address, u32* out_offset) const
+Image::SortedSymbol* Image::find_sorted_symbol(u32 address) const
 {
-    auto symbol_count = this->symbol_count();
-    if (!symbol_count)
-        return {};
-
-    SortedSymbol* sorted_symbols = nullptr;
     if (m_sorted_symbols.is_empty()) {
-        m_sorted_symbols.ensure_capacity(symbol_count);
+        m_sorted_symbols.ensure_capacity(symbol_count());
         for_each_symbol([this](const auto& symbol) {
             m_sorted_symbols.append({ symbol.value(), symbol.name(), {}, symbol });
             return IterationDecision::Continue;
@@ -344,19 +339,33 @@ Optional<Image::Symbol> Image::find_symbol(u32 address, u32* out_offset) const
             return a.address < b.address;
         });
     }
-    sorted_symbols = m_sorted_symbols.data();
-
-    for (size_t i = 0; i < symbol_count; ++i) {
-        if (sorted_symbols[i].address > address) {
-            if (i == 0)
-                return {};
-            auto& symbol = sorted_symbols[i - 1];
-            if (out_offset)
-                *out_offset = address - symbol.address;
-            return symbol.symbol;
-        }
+
+    // Find the first symbol after the address; the one before it contains the address.
+    size_t low = 0;
+    size_t high = m_sorted_symbols.size();
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (m_sorted_symbols[middle].address > address)
+            high = middle;
+        else
+            low = middle + 1;
     }
-    return {};
+    if (low == 0 || low == m_sorted_symbols.size())
+        return nullptr;
+    return &m_sorted_symbols[low - 1];
+}
+
+Optional<Image::Symbol> Image::find_symbol(u32 address, u32* out_offset) const
+{
+    if (!symbol_count())
+        return {};
+
+    auto* symbol = find_sorted_symbol(address);
+    if (!symbol)
+        return {};
+    if (out_offset)
+        *out_offset = address - symbol->address;
+    return symbol->symbol;
 }
 
 String Image::symbolicate(u32 address, u32* out_offset) const
@@ -367,43 +376,26 @@ String Image::symbolicate(u32 address, u32* out_offset) const
             *out_offset = 0;
         return "??";
     }
-    SortedSymbol* sorted_symbols = nullptr;
-    if (m_sorted_symbols.is_empty()) {
-        m_sorted_symbols.ensure_capacity(symbol_count);
-        for_each_symbol([this](const auto& symbol) {
-            m_sorted_symbols.append({ symbol.value(), symbol.name(), {}, symbol });
-            return IterationDecision::Continue;
-        });
-        quick_sort(m_sorted_symbols, [](auto& a, auto& b) {
-            return a.address < b.address;
-        });
+
+    auto* symbol = find_sorted_symbol(address);
+    if (!symbol) {
+        if (out_offset)
+            *out_offset = 0;
+        // Addresses before the first symbol are told apart from ones after the last symbol.
+        if (!m_sorted_symbols.is_empty() && address < m_sorted_symbols.first().address)
+            return "!!";
+        return "??";
     }
-    sorted_symbols = m_sorted_symbols.data();
-
-    for (size_t i = 0; i < symbol_count; ++i) {
-        if (sorted_symbols[i].address > address) {
-            if (i == 0) {
-                if (out_offset)
-                    *out_offset = 0;
-                return "!!";
-            }
-            auto& symbol = sorted_symbols[i - 1];
-
-            auto& demangled_name = symbol.demangled_name;
-            if (demangled_name.is_null()) {
-                demangled_name = demangle(symbol.name);
-            }
-
-            if (out_offset) {
-                *out_offset = address - symbol.address;
-                return demangled_name;
-            }
-            return String::format("%s +0x%x", demangled_name.characters(), address - symbol.address);
-        }
+
+    auto& demangled_name = symbol->demangled_name;
+    if (demangled_name.is_null())
+        demangled_name = demangle(symbol->name);
+
+    if (out_offset) {
+        *out_offset = address - symbol->address;
+        return demangled_name;
     }
-    if (out_offset)
-        *out_offset = 0;
-    return "??";
+    return String::format("%s +0x%x", demangled_name.characters(), address - symbol->address);
 }
 
 } // end namespace ELF
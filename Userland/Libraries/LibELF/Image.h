@@ -239,6 +239,9 @@ private:
         Optional<Image::Symbol> symbol;
     };
 
+    // Returns the last symbol at or before the address, unless the address is after the last symbol.
+    SortedSymbol* find_sorted_symbol(u32 address) const;
+
     mutable Vector<SortedSymbol> m_sorted_symbols;
 };
 
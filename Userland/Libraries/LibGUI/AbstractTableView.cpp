@@ -74,7 +74,7 @@ void AbstractTableView::update_column_sizes()
 
     auto& model = *this->model();
     int column_count = model.column_count();
-    int row_count = model.row_count();
+    auto rows = rows_to_measure(model.row_count(), row_height());
 
     for (int column = 0; column < column_count; ++column) {
         if (!column_header().is_section_visible(column))
@@ -83,7 +83,7 @@ void AbstractTableView::update_column_sizes()
         if (column == m_key_column && model.is_column_sortable(column))
             header_width += font().width(" \xE2\xAC\x86"); // UPWARDS BLACK ARROW
         int column_width = header_width;
-        for (int row = 0; row < row_count; ++row) {
+        for (int row : rows) {
             auto cell_data = model.index(row, column).data();
             int cell_width = 0;
             if (cell_data.is_icon()) {
@@ -306,6 +306,7 @@ void AbstractTableView::model_did_update(unsigned flags)
     update_column_sizes();
     update_content_size();
     update();
+    fetch_more_if_needed(row_height());
 }
 
 void AbstractTableView::resize_event(ResizeEvent& event)
@@ -340,6 +341,9 @@ void AbstractTableView::did_scroll()
 {
     AbstractView::did_scroll();
     layout_headers();
+    if (is_virtualized())
+        update_column_sizes();
+    fetch_more_if_needed(row_height());
 }
 
 void AbstractTableView::layout_headers()
@@ -131,6 +131,40 @@ void AbstractView::did_scroll()
     update_edit_widget_position();
 }
 
+Vector<int> AbstractView::rows_to_measure(int row_count, int row_height) const
+{
+    static constexpr int max_sampled_rows = 100;
+
+    Vector<int> rows;
+    if (!m_virtualized || row_count <= max_sampled_rows) {
+        rows.ensure_capacity(row_count);
+        for (int row = 0; row < row_count; ++row)
+            rows.unchecked_append(row);
+        return rows;
+    }
+
+    // The visible rows must fit, and sampling the rest evenly keeps the estimate from depending
+    // on where we happen to be scrolled to.
+    int first_visible_row = vertical_scrollbar().value() / row_height;
+    int last_visible_row = min(row_count - 1, first_visible_row + visible_content_rect().height() / row_height);
+    for (int row = first_visible_row; row <= last_visible_row; ++row)
+        rows.append(row);
+    for (int i = 0; i < max_sampled_rows; ++i)
+        rows.append(i * row_count / max_sampled_rows);
+    return rows;
+}
+
+void AbstractView::fetch_more_if_needed(int row_height)
+{
+    if (!model() || !model()->can_fetch_more())
+        return;
+    // Ask for more while there's still a page of rows left, so hopefully we never show the end.
+    int visible_row_count = visible_content_rect().height() / row_height + 1;
+    int last_visible_row = vertical_scrollbar().value() / row_height + visible_row_count;
+    if (model()->row_count() - last_visible_row <= visible_row_count)
+        model()->fetch_more();
+}
+
 void AbstractView::update_edit_widget_position()
 {
     if (!m_edit_widget)
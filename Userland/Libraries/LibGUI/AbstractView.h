@@ -143,6 +143,12 @@ public:
 
     void set_draw_item_text_with_shadow(bool b) { m_draw_item_text_with_shadow = b; }
 
+    // A virtualized view sizes its content from the visible rows and an even sample of the
+    // rest, instead of asking the model about every row. Columns widen as wider rows scroll
+    // into view. This keeps views of huge models responsive.
+    bool is_virtualized() const { return m_virtualized; }
+    void set_virtualized(bool virtualized) { m_virtualized = virtualized; }
+
 protected:
     AbstractView();
     virtual ~AbstractView() override;
@@ -174,6 +180,8 @@ protected:
     void set_suppress_update_on_selection_change(bool value) { m_suppress_update_on_selection_change = value; }
 
     virtual void did_scroll() override;
+    Vector<int> rows_to_measure(int row_count, int row_height) const;
+    void fetch_more_if_needed(int row_height);
     void set_hovered_index(const ModelIndex&);
     void activate(const ModelIndex&);
     void activate_selected();
@@ -189,6 +197,7 @@ protected:
 
     bool m_editable { false };
     bool m_searchable { true };
+    bool m_virtualized { false };
     ModelIndex m_edit_index;
     RefPtr<Widget> m_edit_widget;
     Gfx::IntRect m_edit_widget_content_rect;
@@ -28,6 +28,7 @@
 #include <AK/Function.h>
 #include <AK/HashMap.h>
 #include <LibGUI/DisplayLink.h>
+#include <LibGUI/Window.h>
 #include <LibGUI/WindowServerConnection.h>
 
 namespace GUI {
@@ -76,12 +77,20 @@ bool DisplayLink::unregister_callback(i32 callback_id)
     VERIFY(callbacks().contains(callback_id));
     callbacks().remove(callback_id);
 
-    if (callbacks().is_empty())
+    if (callbacks().is_empty()) {
         WindowServerConnection::the().post_message(Messages::WindowServer::DisableDisplayLink());
+        // Windows hold on to their invalidations until the next display link notification, which won't come now.
+        Window::flush_pending_updates_of_all_windows();
+    }
 
     return true;
 }
 
+bool DisplayLink::has_callbacks()
+{
+    return !callbacks().is_empty();
+}
+
 void DisplayLink::notify(Badge<WindowServerConnection>)
 {
     auto copy_of_callbacks = callbacks();
@@ -35,6 +35,7 @@ class DisplayLink {
 public:
     static i32 register_callback(Function<void(i32)>);
     static bool unregister_callback(i32 callback_id);
+    static bool has_callbacks();
 
     static void notify(Badge<WindowServerConnection>);
 };
@@ -34,7 +34,10 @@
 #include <LibGUI/FileSystemModel.h>
 #include <LibGUI/Painter.h>
 #include <LibGfx/Bitmap.h>
-#include <LibThread/BackgroundAction.h>
+#include <LibGfx/JPGLoader.h>
+#include <LibGfx/PNGLoader.h>
+#include <LibGfx/PNGWriter.h>
+#include <LibThread/ThreadPool.h>
 #include <dirent.h>
 #include <grp.h>
 #include <pwd.h>
@@ -42,9 +45,13 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <utime.h>
 
 namespace GUI {
 
+// Thumbnails by path, shared by all the models in the process. A null thumbnail means we haven't got one (yet).
+static HashMap<String, RefPtr<Gfx::Bitmap>> s_thumbnail_cache;
+
 ModelIndex FileSystemModel::Node::index(int column) const
 {
     if (!parent)
@@ -231,6 +238,9 @@ FileSystemModel::FileSystemModel(const StringView& root_path, Mode mode)
 
 FileSystemModel::~FileSystemModel()
 {
+    // Nobody is going to render the thumbnails we haven't started on, so let the next model ask for them again.
+    for (auto& request : m_thumbnail_requests)
+        s_thumbnail_cache.remove(request.path);
 }
 
 String FileSystemModel::name_for_uid(uid_t uid) const
@@ -487,22 +497,83 @@ Icon FileSystemModel::icon_for(const Node& node) const
     return FileIconProvider::icon_for_path(node.full_path(), node.mode);
 }
 
-static HashMap<String, RefPtr<Gfx::Bitmap>> s_thumbnail_cache;
+static const Gfx::IntSize thumbnail_size { 32, 32 };
+
+static String thumbnail_cache_directory()
+{
+    return String::formatted("{}/thumbnails", Core::StandardPaths::cache_directory());
+}
+
+// Thumbnails are stored on disk under a hash of the path of their image, with the modification time of the image as their own.
+static String thumbnail_cache_path(const String& path)
+{
+    // 64-bit FNV-1a, so that we don't have to worry about collisions.
+    u64 hash = 0xcbf29ce484222325;
+    for (size_t i = 0; i < path.length(); ++i) {
+        hash ^= (u8)path[i];
+        hash *= 0x100000001b3;
+    }
+    return String::formatted("{}/{:016x}.png", thumbnail_cache_directory(), hash);
+}
+
+static RefPtr<Gfx::Bitmap> load_cached_thumbnail(const String& cache_path, time_t mtime)
+{
+    struct stat st;
+    if (stat(cache_path.characters(), &st) < 0 || st.st_mtime != mtime)
+        return nullptr;
+    return Gfx::load_png(cache_path);
+}
+
+static void store_cached_thumbnail(const String& cache_path, time_t mtime, const RefPtr<Gfx::Bitmap>& thumbnail)
+{
+    if (!Core::File::ensure_parent_directories(cache_path))
+        return;
+
+    // Write to a temporary file and move it into place, so that nobody ever sees half a thumbnail.
+    auto temporary_path = String::formatted("{}.{}", cache_path, gettid());
+    auto file_or_error = Core::File::open(temporary_path, Core::IODevice::WriteOnly);
+    if (file_or_error.is_error())
+        return;
+    auto data = Gfx::PNGWriter().write(thumbnail);
+    bool ok = file_or_error.value()->write(data.data(), data.size());
+    file_or_error.value()->close();
+
+    utimbuf times { mtime, mtime };
+    if (!ok || utime(temporary_path.characters(), &times) < 0 || rename(temporary_path.characters(), cache_path.characters()) < 0)
+        unlink(temporary_path.characters());
+}
 
 static RefPtr<Gfx::Bitmap> render_thumbnail(const StringView& path)
 {
-    auto png_bitmap = Gfx::Bitmap::load_from_file(path);
-    if (!png_bitmap)
+    RefPtr<Gfx::Bitmap> bitmap;
+    if (path.ends_with(".jpg", CaseSensitivity::CaseInsensitive) || path.ends_with(".jpeg", CaseSensitivity::CaseInsensitive))
+        bitmap = Gfx::load_jpg_for_thumbnail(path, thumbnail_size);
+    else
+        bitmap = Gfx::Bitmap::load_from_file(path);
+    if (!bitmap)
         return nullptr;
 
-    double scale = min(32 / (double)png_bitmap->width(), 32 / (double)png_bitmap->height());
+    double scale = min(thumbnail_size.width() / (double)bitmap->width(), thumbnail_size.height() / (double)bitmap->height());
 
-    auto thumbnail = Gfx::Bitmap::create(Gfx::BitmapFormat::RGBA32, { 32, 32 });
-    Gfx::IntRect destination = Gfx::IntRect(0, 0, (int)(png_bitmap->width() * scale), (int)(png_bitmap->height() * scale));
+    auto thumbnail = Gfx::Bitmap::create(Gfx::BitmapFormat::RGBA32, thumbnail_size);
+    Gfx::IntRect destination = Gfx::IntRect(0, 0, (int)(bitmap->width() * scale), (int)(bitmap->height() * scale));
     destination.center_within(thumbnail->rect());
 
     Painter painter(*thumbnail);
-    painter.draw_scaled_bitmap(destination, *png_bitmap, png_bitmap->rect());
+    painter.draw_scaled_bitmap(destination, *bitmap, bitmap->rect());
+    return thumbnail;
+}
+
+static RefPtr<Gfx::Bitmap> load_or_render_thumbnail(const String& path, time_t mtime)
+{
+    auto cache_path = thumbnail_cache_path(path);
+    if (auto thumbnail = load_cached_thumbnail(cache_path, mtime))
+        return thumbnail;
+
+    auto thumbnail = render_thumbnail(path);
+    // Don't go making thumbnails of the thumbnails when someone browses the cache.
+    if (thumbnail && !path.starts_with(thumbnail_cache_directory()))
+        store_cached_thumbnail(cache_path, mtime, thumbnail);
     return thumbnail;
 }
 
@@ -513,10 +584,17 @@ bool FileSystemModel::fetch_thumbnail_for(const Node& node)
     auto path = node.full_path();
     auto it = s_thumbnail_cache.find(path);
     if (it != s_thumbnail_cache.end()) {
-        if (!(*it).value)
-            return false;
-        node.thumbnail = (*it).value;
-        return true;
+        if ((*it).value) {
+            node.thumbnail = (*it).value;
+            return true;
+        }
+
+        // Views only ask for the icons of the items they paint, so whatever they ask for
+        // last is on screen, and should be rendered before the rest.
+        auto request = m_thumbnail_requests.find_if([&](auto& request) { return request.path == path; });
+        if (!request.is_end() && request.index() != m_thumbnail_requests.size() - 1)
+            m_thumbnail_requests.append(m_thumbnail_requests.take(request.index()));
+        return false;
     }
 
     // Otherwise, arrange to render the thumbnail
@@ -524,36 +602,50 @@ bool FileSystemModel::fetch_thumbnail_for(const Node& node)
 
     s_thumbnail_cache.set(path, nullptr);
     m_thumbnail_progress_total++;
-
-    auto weak_this = make_weak_ptr();
-
-    LibThread::BackgroundAction<RefPtr<Gfx::Bitmap>>::create(
-        [path] {
-            return render_thumbnail(path);
-        },
-
-        [this, path, weak_this](auto thumbnail) {
-            s_thumbnail_cache.set(path, move(thumbnail));
-
-            // The model was destroyed, no need to update
-            // progress or call any event handlers.
-            if (weak_this.is_null())
-                return;
-
-            m_thumbnail_progress++;
-            if (on_thumbnail_progress)
-                on_thumbnail_progress(m_thumbnail_progress, m_thumbnail_progress_total);
-            if (m_thumbnail_progress == m_thumbnail_progress_total) {
-                m_thumbnail_progress = 0;
-                m_thumbnail_progress_total = 0;
-            }
-
-            did_update();
-        });
+    m_thumbnail_requests.append({ path, node.mtime });
+    start_thumbnail_jobs();
 
     return false;
 }
 
+void FileSystemModel::start_thumbnail_jobs()
+{
+    // We only hand the pool as many thumbnails as it has workers, so that newer
+    // requests can still overtake the ones that have been waiting.
+    while (m_thumbnail_jobs_in_flight < LibThread::ThreadPool::the().worker_count() && !m_thumbnail_requests.is_empty()) {
+        auto request = m_thumbnail_requests.take_last();
+        m_thumbnail_jobs_in_flight++;
+
+        auto weak_this = make_weak_ptr();
+
+        LibThread::Future<RefPtr<Gfx::Bitmap>>::run(
+            [request] {
+                return load_or_render_thumbnail(request.path, request.mtime);
+            },
+
+            [this, path = request.path, weak_this](auto& thumbnail) {
+                s_thumbnail_cache.set(path, thumbnail);
+
+                // The model was destroyed, no need to update
+                // progress or call any event handlers.
+                if (weak_this.is_null())
+                    return;
+
+                m_thumbnail_jobs_in_flight--;
+                m_thumbnail_progress++;
+                if (on_thumbnail_progress)
+                    on_thumbnail_progress(m_thumbnail_progress, m_thumbnail_progress_total);
+                if (m_thumbnail_progress == m_thumbnail_progress_total) {
+                    m_thumbnail_progress = 0;
+                    m_thumbnail_progress_total = 0;
+                }
+
+                did_update();
+                start_thumbnail_jobs();
+            });
+    }
+}
+
 int FileSystemModel::column_count(const ModelIndex&) const
 {
     return Column::__Count;
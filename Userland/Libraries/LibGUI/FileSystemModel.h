@@ -171,6 +171,7 @@ private:
     HashMap<gid_t, String> m_group_names;
 
     bool fetch_thumbnail_for(const Node& node);
+    void start_thumbnail_jobs();
     GUI::Icon icon_for(const Node& node) const;
 
     String m_root_path;
@@ -180,6 +181,14 @@ private:
     unsigned m_thumbnail_progress { 0 };
     unsigned m_thumbnail_progress_total { 0 };
 
+    struct ThumbnailRequest {
+        String path;
+        time_t mtime { 0 };
+    };
+    // The thumbnails we still have to render, the most recently requested last.
+    Vector<ThumbnailRequest> m_thumbnail_requests;
+    size_t m_thumbnail_jobs_in_flight { 0 };
+
     bool m_should_show_dotfiles { false };
 };
 
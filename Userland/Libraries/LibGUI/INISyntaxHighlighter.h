@@ -43,6 +43,8 @@ public:
 protected:
     virtual Vector<MatchingTokenPair> matching_token_pairs() const override;
     virtual bool token_types_equal(void*, void*) const override;
+    virtual bool supports_incremental_highlighting() const override { return true; }
+    virtual Vector<GUI::TextDocumentSpan> spans_for_text(const StringView&, size_t first_line, const Palette&) override;
 };
 
 }
@@ -59,8 +59,9 @@ void ListView::update_content_size()
     if (!model())
         return set_content_size({});
 
-    int content_width = 0;
-    for (int row = 0, row_count = model()->row_count(); row < row_count; ++row) {
+    // Estimates only ever grow, so the view doesn't jump around as different rows are sampled.
+    int content_width = is_virtualized() ? content_size().width() : 0;
+    for (int row : rows_to_measure(model()->row_count(), item_height())) {
         auto text = model()->index(row, m_model_column).data();
         content_width = max(content_width, font().width(text.to_string()));
     }
@@ -82,6 +83,15 @@ void ListView::model_did_update(unsigned flags)
     AbstractView::model_did_update(flags);
     update_content_size();
     update();
+    fetch_more_if_needed(item_height());
+}
+
+void ListView::did_scroll()
+{
+    AbstractView::did_scroll();
+    if (is_virtualized())
+        update_content_size();
+    fetch_more_if_needed(item_height());
 }
 
 Gfx::IntRect ListView::content_rect(int row) const
@@ -99,12 +109,12 @@ ModelIndex ListView::index_at_event_position(const Gfx::IntPoint& point) const
     VERIFY(model());
 
     auto adjusted_position = this->adjusted_position(point);
-    for (int row = 0, row_count = model()->row_count(); row < row_count; ++row) {
-        if (!content_rect(row).contains(adjusted_position))
-            continue;
-        return model()->index(row, m_model_column);
-    }
-    return {};
+    if (adjusted_position.x() < 0 || adjusted_position.x() >= content_width() || adjusted_position.y() < 0)
+        return {};
+    int row = adjusted_position.y() / item_height();
+    if (row >= model()->row_count())
+        return {};
+    return model()->index(row, m_model_column);
 }
 
 Gfx::IntPoint ListView::adjusted_position(const Gfx::IntPoint& position) const
@@ -168,14 +178,16 @@ void ListView::paint_event(PaintEvent& event)
     painter.translate(-horizontal_scrollbar().value(), -vertical_scrollbar().value());
 
     int exposed_width = max(content_size().width(), width());
-    int painted_item_index = 0;
+    int row_count = model()->row_count();
 
-    for (int row_index = 0; row_index < model()->row_count(); ++row_index) {
-        paint_list_item(painter, row_index, painted_item_index);
-        ++painted_item_index;
-    };
+    // Only the rows that intersect the exposed rect need painting.
+    auto exposed_rect = event.rect().translated(horizontal_scrollbar().value() - frame_thickness(), vertical_scrollbar().value() - frame_thickness());
+    int first_row = max(0, exposed_rect.top() / item_height());
+    int last_row = min(row_count - 1, exposed_rect.bottom() / item_height());
+    for (int row_index = first_row; row_index <= last_row; ++row_index)
+        paint_list_item(painter, row_index, row_index);
 
-    Gfx::IntRect unpainted_rect(0, painted_item_index * item_height(), exposed_width, height());
+    Gfx::IntRect unpainted_rect(0, row_count * item_height(), exposed_width, height());
     if (fill_with_background_color())
         painter.fill_rect(unpainted_rect, palette().color(background_role()));
 }
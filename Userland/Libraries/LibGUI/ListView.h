@@ -68,6 +68,7 @@ protected:
 
 private:
     virtual void model_did_update(unsigned flags) override;
+    virtual void did_scroll() override;
     virtual void paint_event(PaintEvent&) override;
     virtual void keydown_event(KeyEvent&) override;
     virtual void resize_event(ResizeEvent&) override;
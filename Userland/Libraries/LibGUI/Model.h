@@ -88,6 +88,12 @@ public:
     virtual bool is_column_sortable([[maybe_unused]] int column_index) const { return true; }
     virtual void sort([[maybe_unused]] int column, SortOrder) { }
 
+    // Models that load their rows incrementally say here whether there are more to come.
+    // Views call fetch_more() when they're about to run out of rows to show, and the model
+    // calls did_update() once it has added some.
+    virtual bool can_fetch_more([[maybe_unused]] const ModelIndex& parent = ModelIndex()) const { return false; }
+    virtual void fetch_more([[maybe_unused]] const ModelIndex& parent = ModelIndex()) { }
+
     bool is_valid(const ModelIndex& index) const
     {
         auto parent_index = this->parent_index(index);
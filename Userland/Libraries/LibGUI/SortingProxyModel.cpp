@@ -24,9 +24,12 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/NonnullOwnPtrVector.h>
 #include <AK/QuickSort.h>
 #include <LibGUI/AbstractView.h>
 #include <LibGUI/SortingProxyModel.h>
+#include <LibThread/BackgroundAction.h>
+#include <LibThread/ParallelSort.h>
 
 namespace GUI {
 
@@ -44,6 +47,7 @@ SortingProxyModel::~SortingProxyModel()
 
 void SortingProxyModel::invalidate(unsigned int flags)
 {
+    ++m_sort_generation;
     if (flags == UpdateFlag::DontInvalidateIndexes) {
         sort(m_last_key_column, m_last_sort_order);
     } else {
@@ -68,6 +72,16 @@ bool SortingProxyModel::accepts_drag(const ModelIndex& proxy_index, const Vector
     return source().accepts_drag(map_to_source(proxy_index), mime_types);
 }
 
+bool SortingProxyModel::can_fetch_more(const ModelIndex& proxy_index) const
+{
+    return source().can_fetch_more(map_to_source(proxy_index));
+}
+
+void SortingProxyModel::fetch_more(const ModelIndex& proxy_index)
+{
+    source().fetch_more(map_to_source(proxy_index));
+}
+
 int SortingProxyModel::row_count(const ModelIndex& proxy_index) const
 {
     return source().row_count(map_to_source(proxy_index));
@@ -191,17 +205,61 @@ void SortingProxyModel::sort_mapping(Mapping& mapping, int column, SortOrder sor
         return;
     }
 
-    auto old_source_rows = mapping.source_rows;
-
     int row_count = source().row_count(mapping.source_parent);
+    Vector<int> source_rows;
+    source_rows.resize(row_count);
     for (int i = 0; i < row_count; ++i)
-        mapping.source_rows[i] = i;
+        source_rows[i] = i;
 
-    quick_sort(mapping.source_rows, [&](auto row1, auto row2) -> bool {
+    quick_sort(source_rows, [&](auto row1, auto row2) -> bool {
         bool is_less_than = less_than(source().index(row1, column, mapping.source_parent), source().index(row2, column, mapping.source_parent));
         return sort_order == SortOrder::Ascending ? is_less_than : !is_less_than;
     });
 
+    apply_sorted_rows(mapping, move(source_rows));
+}
+
+void SortingProxyModel::sort_mapping_in_background(Mapping& mapping, int column, SortOrder sort_order)
+{
+    // The source model can only be used from this thread, so take a copy of everything we sort by.
+    int row_count = source().row_count(mapping.source_parent);
+    NonnullOwnPtrVector<Variant> keys;
+    keys.ensure_capacity(row_count);
+    for (int row = 0; row < row_count; ++row) {
+        auto key = source().index(row, column, mapping.source_parent).data(m_sort_role);
+        if (key.is_string())
+            key = key.as_string().to_lowercase();
+        keys.unchecked_append(make<Variant>(key));
+    }
+
+    LibThread::BackgroundAction<Vector<int>>::create(
+        [keys = move(keys), sort_order] {
+            Vector<int> source_rows;
+            source_rows.resize(keys.size());
+            for (size_t i = 0; i < keys.size(); ++i)
+                source_rows[i] = i;
+            LibThread::parallel_sort(source_rows, [&](int row1, int row2) {
+                return sort_order == SortOrder::Ascending ? keys[row1] < keys[row2] : keys[row2] < keys[row1];
+            });
+            return source_rows;
+        },
+        [this, protect = NonnullRefPtr(*this), generation = m_sort_generation, source_parent = mapping.source_parent](Vector<int> source_rows) {
+            if (generation != m_sort_generation)
+                return;
+            auto it = m_mappings.find(source_parent);
+            if (it == m_mappings.end() || it->value->source_rows.size() != source_rows.size())
+                return;
+            apply_sorted_rows(*it->value, move(source_rows));
+            did_update(UpdateFlag::DontInvalidateIndexes);
+        });
+}
+
+void SortingProxyModel::apply_sorted_rows(Mapping& mapping, Vector<int> source_rows)
+{
+    auto old_source_rows = move(mapping.source_rows);
+    mapping.source_rows = move(source_rows);
+
+    int row_count = mapping.source_rows.size();
     for (int i = 0; i < row_count; ++i)
         mapping.proxy_rows[mapping.source_rows[i]] = i;
 
@@ -249,9 +307,13 @@ void SortingProxyModel::sort_mapping(Mapping& mapping, int column, SortOrder sor
 
 void SortingProxyModel::sort(int column, SortOrder sort_order)
 {
+    ++m_sort_generation;
     for (auto& it : m_mappings) {
         auto& mapping = *it.value;
-        sort_mapping(mapping, column, sort_order);
+        if (m_sorts_in_background && column != -1)
+            sort_mapping_in_background(mapping, column, sort_order);
+        else
+            sort_mapping(mapping, column, sort_order);
     }
 
     m_last_key_column = column;
@@ -274,7 +336,13 @@ SortingProxyModel::InternalMapIterator SortingProxyModel::build_mapping(const Mo
     mapping->source_rows.resize(row_count);
     mapping->proxy_rows.resize(row_count);
 
-    sort_mapping(*mapping, m_last_key_column, m_last_sort_order);
+    if (m_sorts_in_background && m_last_key_column != -1) {
+        // Show the rows in their original order until they're sorted.
+        sort_mapping(*mapping, -1, m_last_sort_order);
+        sort_mapping_in_background(*mapping, m_last_key_column, m_last_sort_order);
+    } else {
+        sort_mapping(*mapping, m_last_key_column, m_last_sort_order);
+    }
 
     if (source_parent.is_valid()) {
         auto source_grand_parent = source_parent.parent();
@@ -50,6 +50,8 @@ public:
     virtual void set_data(const ModelIndex&, const Variant&) override;
     virtual Vector<ModelIndex, 1> matches(const StringView&, unsigned = MatchesFlag::AllMatching, const ModelIndex& = ModelIndex()) override;
     virtual bool accepts_drag(const ModelIndex&, const Vector<String>& mime_types) const override;
+    virtual bool can_fetch_more(const ModelIndex& = ModelIndex()) const override;
+    virtual void fetch_more(const ModelIndex& = ModelIndex()) override;
 
     virtual bool is_column_sortable(int column_index) const override;
 
@@ -63,6 +65,13 @@ public:
 
     virtual void sort(int column, SortOrder) override;
 
+    // When sorting in the background, the sort keys are copied out of the source model up front,
+    // sorted on another thread, and the new order is applied once that's done, unless the model
+    // has changed in the meantime. The old order is shown until then. Keys are compared the way
+    // less_than() does by default, so subclasses that override it shouldn't enable this.
+    bool sorts_in_background() const { return m_sorts_in_background; }
+    void set_sorts_in_background(bool sorts_in_background) { m_sorts_in_background = sorts_in_background; }
+
 private:
     explicit SortingProxyModel(NonnullRefPtr<Model> source);
 
@@ -76,6 +85,8 @@ private:
     using InternalMapIterator = HashMap<ModelIndex, NonnullOwnPtr<Mapping>>::IteratorType;
 
     void sort_mapping(Mapping&, int column, SortOrder);
+    void sort_mapping_in_background(Mapping&, int column, SortOrder);
+    void apply_sorted_rows(Mapping&, Vector<int> source_rows);
 
     // ^ModelClient
     virtual void model_did_update(unsigned) override;
@@ -92,6 +103,9 @@ private:
     ModelRole m_sort_role { ModelRole::Sort };
     int m_last_key_column { -1 };
     SortOrder m_last_sort_order { SortOrder::Ascending };
+    bool m_sorts_in_background { false };
+    // Bumped whenever the mappings are re-sorted or thrown away, so stale background sorts are dropped.
+    u32 m_sort_generation { 0 };
 };
 
 }
@@ -32,6 +32,7 @@
 #include <LibGUI/TextEditor.h>
 #include <LibRegex/Regex.h>
 #include <ctype.h>
+#include <string.h>
 
 namespace GUI {
 
@@ -58,27 +59,53 @@ TextDocument::~TextDocument()
 }
 
 void TextDocument::set_text(const StringView& text)
+{
+    // The text may point into our current original text, so copy it before letting go of that.
+    auto original_text = ByteBuffer::copy(text.characters_without_null_termination(), text.length());
+    m_original_text = move(original_text);
+    m_mapped_file = nullptr;
+    set_lines_from_original_text({ m_original_text.data(), m_original_text.size() });
+}
+
+void TextDocument::set_text_from_mapped_file(NonnullRefPtr<MappedFile> file)
+{
+    m_mapped_file = move(file);
+    m_original_text.clear();
+    set_lines_from_original_text({ static_cast<const char*>(m_mapped_file->data()), m_mapped_file->size() });
+}
+
+void TextDocument::release_mapped_file()
+{
+    if (!m_mapped_file)
+        return;
+    auto original_text = ByteBuffer::copy(m_mapped_file->bytes());
+    auto* old_base = static_cast<const char*>(m_mapped_file->data());
+    auto* new_base = reinterpret_cast<const char*>(original_text.data());
+    for (auto& line : m_lines)
+        line.rebase_unmaterialized_text({}, old_base, new_base);
+    m_original_text = move(original_text);
+    m_mapped_file = nullptr;
+}
+
+void TextDocument::set_lines_from_original_text(const StringView& text)
 {
     m_client_notifications_enabled = false;
     m_spans.clear();
     remove_all_lines();
 
-    size_t start_of_current_line = 0;
+    auto* start_of_current_line = text.characters_without_null_termination();
+    auto* end = start_of_current_line + text.length();
 
-    auto add_line = [&](size_t current_position) {
-        size_t line_length = current_position - start_of_current_line;
+    auto add_line = [&](const char* end_of_line) {
         auto line = make<TextDocumentLine>(*this);
-        if (line_length)
-            line->set_text(*this, text.substring_view(start_of_current_line, current_position - start_of_current_line));
+        if (end_of_line != start_of_current_line)
+            line->set_unmaterialized_text({}, { start_of_current_line, static_cast<size_t>(end_of_line - start_of_current_line) });
         append_line(move(line));
-        start_of_current_line = current_position + 1;
+        start_of_current_line = end_of_line + 1;
     };
-    size_t i = 0;
-    for (i = 0; i < text.length(); ++i) {
-        if (text[i] == '\n')
-            add_line(i);
-    }
-    add_line(i);
+    while (auto* newline = static_cast<const char*>(memchr(start_of_current_line, '\n', end - start_of_current_line)))
+        add_line(newline);
+    add_line(end);
 
     // Don't show the file's trailing newline as an actual new line.
     if (line_count() > 1 && line(line_count() - 1).is_empty())
@@ -119,6 +146,7 @@ bool TextDocumentLine::ends_in_whitespace() const
 
 size_t TextDocumentLine::leading_spaces() const
 {
+    materialize();
     size_t count = 0;
     for (; count < m_text.size(); ++count) {
         if (m_text[count] != ' ') {
@@ -128,8 +156,54 @@ size_t TextDocumentLine::leading_spaces() const
     return count;
 }
 
+size_t TextDocumentLine::length() const
+{
+    if (is_materialized())
+        return m_text.size();
+    if (!m_unmaterialized_length.has_value())
+        m_unmaterialized_length = Utf8View(m_unmaterialized_text).length();
+    return m_unmaterialized_length.value();
+}
+
+static u64 s_next_line_revision = 1;
+
+void TextDocumentLine::did_change(TextDocument& document)
+{
+    m_revision = s_next_line_revision++;
+    document.update_views({});
+}
+
+void TextDocumentLine::materialize() const
+{
+    if (is_materialized())
+        return;
+    m_text.ensure_capacity(length());
+    for (auto code_point : Utf8View(m_unmaterialized_text))
+        m_text.unchecked_append(code_point);
+    m_unmaterialized_text = {};
+    m_unmaterialized_length = {};
+}
+
+void TextDocumentLine::set_unmaterialized_text(Badge<TextDocument>, const StringView& text)
+{
+    m_text.clear();
+    m_unmaterialized_text = text;
+    m_unmaterialized_length = {};
+    m_revision = s_next_line_revision++;
+}
+
+void TextDocumentLine::rebase_unmaterialized_text(Badge<TextDocument>, const char* old_base, const char* new_base)
+{
+    if (is_materialized())
+        return;
+    auto offset = m_unmaterialized_text.characters_without_null_termination() - old_base;
+    m_unmaterialized_text = { new_base + offset, m_unmaterialized_text.length() };
+}
+
 String TextDocumentLine::to_utf8() const
 {
+    if (!is_materialized())
+        return String(m_unmaterialized_text);
     StringBuilder builder;
     builder.append(view());
     return builder.to_string();
@@ -148,13 +222,15 @@ TextDocumentLine::TextDocumentLine(TextDocument& document, const StringView& tex
 void TextDocumentLine::clear(TextDocument& document)
 {
     m_text.clear();
-    document.update_views({});
+    m_unmaterialized_text = {};
+    did_change(document);
 }
 
 void TextDocumentLine::set_text(TextDocument& document, const Vector<u32> text)
 {
     m_text = move(text);
-    document.update_views({});
+    m_unmaterialized_text = {};
+    did_change(document);
 }
 
 void TextDocumentLine::set_text(TextDocument& document, const StringView& text)
@@ -164,18 +240,21 @@ void TextDocumentLine::set_text(TextDocument& document, const StringView& text)
         return;
     }
     m_text.clear();
+    m_unmaterialized_text = {};
     Utf8View utf8_view(text);
+    m_text.ensure_capacity(utf8_view.length());
     for (auto code_point : utf8_view)
-        m_text.append(code_point);
-    document.update_views({});
+        m_text.unchecked_append(code_point);
+    did_change(document);
 }
 
 void TextDocumentLine::append(TextDocument& document, const u32* code_points, size_t length)
 {
     if (length == 0)
         return;
+    materialize();
     m_text.append(code_points, length);
-    document.update_views({});
+    did_change(document);
 }
 
 void TextDocumentLine::append(TextDocument& document, u32 code_point)
@@ -190,26 +269,29 @@ void TextDocumentLine::prepend(TextDocument& document, u32 code_point)
 
 void TextDocumentLine::insert(TextDocument& document, size_t index, u32 code_point)
 {
+    materialize();
     if (index == length()) {
         m_text.append(code_point);
     } else {
         m_text.insert(index, code_point);
     }
-    document.update_views({});
+    did_change(document);
 }
 
 void TextDocumentLine::remove(TextDocument& document, size_t index)
 {
+    materialize();
     if (index == length()) {
         m_text.take_last();
     } else {
         m_text.remove(index);
     }
-    document.update_views({});
+    did_change(document);
 }
 
 void TextDocumentLine::remove_range(TextDocument& document, size_t start, size_t length)
 {
+    materialize();
     VERIFY(length <= m_text.size());
 
     Vector<u32> new_data;
@@ -219,13 +301,14 @@ void TextDocumentLine::remove_range(TextDocument& document, size_t start, size_t
     for (size_t i = (start + length); i < m_text.size(); ++i)
         new_data.append(m_text[i]);
     m_text = move(new_data);
-    document.update_views({});
+    did_change(document);
 }
 
 void TextDocumentLine::truncate(TextDocument& document, size_t length)
 {
+    materialize();
     m_text.resize(length);
-    document.update_views({});
+    did_change(document);
 }
 
 void TextDocument::append_line(NonnullOwnPtr<TextDocumentLine> line)
@@ -306,7 +389,10 @@ String TextDocument::text() const
     StringBuilder builder;
     for (size_t i = 0; i < line_count(); ++i) {
         auto& line = this->line(i);
-        builder.append(line.view());
+        if (line.is_materialized())
+            builder.append(line.view());
+        else
+            builder.append(line.unmaterialized_text());
         if (i != line_count() - 1)
             builder.append('\n');
     }
@@ -447,7 +533,26 @@ TextRange TextDocument::find_next(const StringView& needle, const TextPosition&
     TextPosition start_of_potential_match;
     size_t needle_index = 0;
 
+    // A needle without newlines can't span lines, so lines that haven't been decoded yet can be ruled out
+    // by looking at their UTF-8 text. That only works if the needle is ASCII, since it's matched byte-wise.
+    bool can_skip_lines = !needle.contains('\n');
+    for (auto ch : needle) {
+        if (static_cast<u8>(ch) >= 0x80)
+            can_skip_lines = false;
+    }
+    auto case_sensitivity = match_case ? CaseSensitivity::CaseSensitive : CaseSensitivity::CaseInsensitive;
+
     do {
+        if (can_skip_lines && needle_index == 0 && position.column() == 0 && position.line() != original_position.line()) {
+            auto& line = this->line(position.line());
+            if (!line.is_materialized() && !line.unmaterialized_text().contains(needle, case_sensitivity)) {
+                // Continue from the line's newline, which can't start a match either.
+                position = { position.line(), line.length() };
+                position = next_position_after(position, should_wrap);
+                continue;
+            }
+        }
+
         auto ch = code_point_at(position);
         // FIXME: This is not the right way to use a Unicode needle!
         if (match_case ? ch == (u32)needle[needle_index] : tolower(ch) == tolower((u32)needle[needle_index])) {
@@ -26,7 +26,9 @@
 
 #pragma once
 
+#include <AK/ByteBuffer.h>
 #include <AK/HashTable.h>
+#include <AK/MappedFile.h>
 #include <AK/NonnullOwnPtrVector.h>
 #include <AK/NonnullRefPtr.h>
 #include <AK/Optional.h>
@@ -82,6 +84,10 @@ public:
     void set_spans(Vector<TextDocumentSpan> spans) { m_spans = move(spans); }
 
     void set_text(const StringView&);
+    void set_text_from_mapped_file(NonnullRefPtr<MappedFile>);
+
+    // Copies the text that unedited lines still refer to out of the mapped file, so that the file can be overwritten.
+    void release_mapped_file();
 
     const NonnullOwnPtrVector<TextDocumentLine>& lines() const { return m_lines; }
     NonnullOwnPtrVector<TextDocumentLine>& lines() { return m_lines; }
@@ -149,9 +155,15 @@ protected:
 private:
     void update_undo_timer();
 
+    void set_lines_from_original_text(const StringView&);
+
     NonnullOwnPtrVector<TextDocumentLine> m_lines;
     Vector<TextDocumentSpan> m_spans;
 
+    // The text passed to set_text(). Lines point into this until they are first looked at.
+    ByteBuffer m_original_text;
+    RefPtr<MappedFile> m_mapped_file;
+
     HashTable<Client*> m_clients;
     bool m_client_notifications_enabled { true };
 
@@ -174,8 +186,12 @@ public:
     String to_utf8() const;
 
     Utf32View view() const { return { code_points(), length() }; }
-    const u32* code_points() const { return m_text.data(); }
-    size_t length() const { return m_text.size(); }
+    const u32* code_points() const
+    {
+        materialize();
+        return m_text.data();
+    }
+    size_t length() const;
     void set_text(TextDocument&, const StringView&);
     void set_text(TextDocument&, Vector<u32>);
     void append(TextDocument&, u32);
@@ -193,9 +209,25 @@ public:
     bool is_empty() const { return length() == 0; }
     size_t leading_spaces() const;
 
+    // Changes whenever the text of the line does, and is never reused, so two lines with the same revision have the same text.
+    u64 revision() const { return m_revision; }
+
+    // Lines loaded by TextDocument::set_text() refer to the document's original UTF-8 text
+    // and are only decoded into code points once somebody needs them. Code that only reads
+    // the line can use the UTF-8 text directly to avoid decoding the whole document.
+    bool is_materialized() const { return m_unmaterialized_text.is_null(); }
+    StringView unmaterialized_text() const { return m_unmaterialized_text; }
+    void set_unmaterialized_text(Badge<TextDocument>, const StringView&);
+    void rebase_unmaterialized_text(Badge<TextDocument>, const char* old_base, const char* new_base);
+
 private:
-    // NOTE: This vector is null terminated.
-    Vector<u32> m_text;
+    void did_change(TextDocument&);
+    void materialize() const;
+
+    u64 m_revision { 0 };
+    mutable Vector<u32> m_text;
+    mutable StringView m_unmaterialized_text;
+    mutable Optional<size_t> m_unmaterialized_length;
 };
 
 class TextDocumentUndoCommand : public Command {
@@ -28,6 +28,7 @@
 #include <AK/ScopeGuard.h>
 #include <AK/StringBuilder.h>
 #include <AK/TemporaryChange.h>
+#include <AK/Utf8View.h>
 #include <LibCore/Timer.h>
 #include <LibGUI/Action.h>
 #include <LibGUI/AutocompleteProvider.h>
@@ -120,9 +121,19 @@ void TextEditor::create_actions()
 void TextEditor::set_text(const StringView& text)
 {
     m_selection.clear();
-
     document().set_text(text);
+    did_set_text();
+}
 
+void TextEditor::set_text_from_mapped_file(NonnullRefPtr<MappedFile> file)
+{
+    m_selection.clear();
+    document().set_text_from_mapped_file(move(file));
+    did_set_text();
+}
+
+void TextEditor::did_set_text()
+{
     update_content_size();
     recompute_all_visual_lines();
     if (is_single_line())
@@ -1054,6 +1065,9 @@ void TextEditor::timer_event(Core::TimerEvent&)
 
 bool TextEditor::write_to_file(const String& path)
 {
+    // We may be about to truncate the file our text is mapped from.
+    document().release_mapped_file();
+
     int fd = open(path.characters(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
     if (fd < 0) {
         perror("open");
@@ -1245,7 +1259,7 @@ void TextEditor::did_change()
             if (on_change)
                 on_change();
             if (m_highlighter)
-                m_highlighter->rehighlight(palette());
+                m_highlighter->rehighlight_changed_lines(palette());
             m_has_pending_change_notification = false;
         });
     }
@@ -1346,6 +1360,8 @@ void TextEditor::resize_event(ResizeEvent& event)
 void TextEditor::theme_change_event(ThemeChangeEvent& event)
 {
     ScrollableWidget::theme_change_event(event);
+    // Catch the highlighter up with the text first, so that it stays in sync with the spans we're about to recolor.
+    flush_pending_change_notification_if_needed();
     if (m_highlighter)
         m_highlighter->rehighlight(palette());
 }
@@ -1454,8 +1470,10 @@ void TextEditor::recompute_visual_lines(size_t line_index)
 
     if (is_wrapping_enabled())
         visual_data.visual_rect = { m_horizontal_content_padding, 0, available_width, static_cast<int>(visual_data.visual_line_breaks.size()) * line_height() };
-    else
+    else if (line.is_materialized())
         visual_data.visual_rect = { m_horizontal_content_padding, 0, font().width(line.view()), line_height() };
+    else
+        visual_data.visual_rect = { m_horizontal_content_padding, 0, font().width(Utf8View(line.unmaterialized_text())), line_height() };
 }
 
 template<typename Callback>
@@ -1588,7 +1606,7 @@ void TextEditor::flush_pending_change_notification_if_needed()
     if (on_change)
         on_change();
     if (m_highlighter)
-        m_highlighter->rehighlight(palette());
+        m_highlighter->rehighlight_changed_lines(palette());
     m_has_pending_change_notification = false;
 }
 
@@ -1604,7 +1622,7 @@ void TextEditor::set_syntax_highlighter(OwnPtr<Syntax::Highlighter> highlighter)
     m_highlighter = move(highlighter);
     if (m_highlighter) {
         m_highlighter->attach(*this);
-        m_highlighter->rehighlight(palette());
+        m_highlighter->rehighlight_changed_lines(palette());
     } else
         document().set_spans({});
 }
@@ -118,6 +118,7 @@ public:
     Function<void()> on_focusout;
 
     void set_text(const StringView&);
+    void set_text_from_mapped_file(NonnullRefPtr<MappedFile>);
     void scroll_cursor_into_view();
     void scroll_position_into_view(const TextPosition&);
     size_t line_count() const { return document().line_count(); }
@@ -288,6 +289,7 @@ private:
     int content_x_for_position(const TextPosition&) const;
     Gfx::IntRect ruler_rect_in_inner_coordinates() const;
     Gfx::IntRect visible_text_rect_in_inner_coordinates() const;
+    void did_set_text();
     void recompute_all_visual_lines();
     void ensure_cursor_is_valid();
     void flush_pending_change_notification_if_needed();
@@ -34,6 +34,7 @@
 #include <LibGUI/Action.h>
 #include <LibGUI/Application.h>
 #include <LibGUI/Desktop.h>
+#include <LibGUI/DisplayLink.h>
 #include <LibGUI/Event.h>
 #include <LibGUI/Painter.h>
 #include <LibGUI/Widget.h>
@@ -597,15 +598,32 @@ void Window::update(const Gfx::IntRect& a_rect)
         }
     }
 
-    if (m_pending_paint_event_rects.is_empty()) {
-        deferred_invoke([this](auto&) {
-            auto rects = move(m_pending_paint_event_rects);
-            if (rects.is_empty())
-                return;
-            WindowServerConnection::the().post_message(Messages::WindowServer::InvalidateRect(m_window_id, rects, false));
-        });
+    // While something is animating, everything invalidated during a frame is sent off together
+    // once WindowServer notifies us about the next one.
+    if (m_pending_paint_event_rects.is_empty() && !DisplayLink::has_callbacks())
+        deferred_invoke([this](auto&) { flush_pending_updates(); });
+
+    m_pending_paint_event_rects.remove_all_matching([&](auto& pending_rect) { return a_rect.contains(pending_rect); });
+
+    auto rect = a_rect;
+    if (m_pending_paint_event_rects.size() >= max_pending_paint_event_rects) {
+        // Painting a bit more than necessary is cheaper than handling lots of tiny rects.
+        for (auto& pending_rect : m_pending_paint_event_rects)
+            rect = rect.united(pending_rect);
+        m_pending_paint_event_rects.clear_with_capacity();
+#if UPDATE_COALESCING_DEBUG
+        dbgln("Collapsed {} pending rects into {}", max_pending_paint_event_rects, rect);
+#endif
     }
-    m_pending_paint_event_rects.append(a_rect);
+    m_pending_paint_event_rects.append(rect);
+}
+
+void Window::flush_pending_updates()
+{
+    auto rects = move(m_pending_paint_event_rects);
+    if (rects.is_empty() || !is_visible())
+        return;
+    WindowServerConnection::the().post_message(Messages::WindowServer::InvalidateRect(m_window_id, rects, false));
 }
 
 void Window::set_main_widget(Widget* widget)
@@ -921,6 +939,12 @@ void Window::update_all_windows(Badge<WindowServerConnection>)
     }
 }
 
+void Window::flush_pending_updates_of_all_windows()
+{
+    for (auto& e : *reified_windows)
+        e.value->flush_pending_updates();
+}
+
 void Window::notify_state_changed(Badge<WindowServerConnection>, bool minimized, bool occluded)
 {
     m_visible_for_timer_purposes = !minimized && !occluded;
@@ -194,6 +194,7 @@ public:
 
     static void for_each_window(Badge<WindowServerConnection>, Function<void(Window&)>);
     static void update_all_windows(Badge<WindowServerConnection>);
+    static void flush_pending_updates_of_all_windows();
     void notify_state_changed(Badge<WindowServerConnection>, bool minimized, bool occluded);
 
     virtual bool is_visible_for_timer_purposes() const override { return m_visible_for_timer_purposes; }
@@ -216,6 +217,7 @@ protected:
     virtual void wm_event(WMEvent&);
 
 private:
+    void flush_pending_updates();
     void update_cursor();
     void focus_a_widget_if_possible(FocusSource);
 
@@ -255,7 +257,8 @@ private:
     Gfx::IntSize m_minimum_size_when_windowless { 50, 50 };
     bool m_minimum_size_modified { false };
     String m_title_when_windowless;
-    Vector<Gfx::IntRect, 32> m_pending_paint_event_rects;
+    static constexpr size_t max_pending_paint_event_rects = 32;
+    Vector<Gfx::IntRect, max_pending_paint_event_rects> m_pending_paint_event_rects;
     Gfx::IntSize m_size_increment;
     Gfx::IntSize m_base_size;
     Color m_background_color { Color::WarmGray };
@@ -230,6 +230,21 @@ void WindowServerConnection::handle(const Messages::WindowClient::MouseUp& messa
         Core::EventLoop::current().post_event(*window, make<MouseEvent>(Event::MouseUp, message.mouse_position(), message.buttons(), to_gmousebutton(message.button()), message.modifiers(), message.wheel_delta()));
 }
 
+bool WindowServerConnection::is_superseded_by(const IPC::Message& message, const IPC::Message& next_message) const
+{
+    // If we've fallen behind on mouse moves, only the latest position matters.
+    if (message.endpoint_magic() != WindowClientEndpoint::static_magic() || next_message.endpoint_magic() != WindowClientEndpoint::static_magic())
+        return false;
+    if (message.message_id() != Messages::WindowClient::MouseMove::static_message_id() || next_message.message_id() != Messages::WindowClient::MouseMove::static_message_id())
+        return false;
+    auto& move = static_cast<const Messages::WindowClient::MouseMove&>(message);
+    auto& next_move = static_cast<const Messages::WindowClient::MouseMove&>(next_message);
+    return move.window_id() == next_move.window_id()
+        && move.buttons() == next_move.buttons()
+        && move.modifiers() == next_move.modifiers()
+        && move.is_drag() == next_move.is_drag();
+}
+
 void WindowServerConnection::handle(const Messages::WindowClient::MouseMove& message)
 {
     if (auto* window = Window::from_window_id(message.window_id())) {
@@ -331,6 +346,8 @@ void WindowServerConnection::handle(const Messages::WindowClient::DisplayLinkNot
     m_display_link_notification_pending = true;
     deferred_invoke([this](auto&) {
         DisplayLink::notify({});
+        // Send off everything the callbacks invalidated as one update per window.
+        Window::flush_pending_updates_of_all_windows();
         m_display_link_notification_pending = false;
     });
 }
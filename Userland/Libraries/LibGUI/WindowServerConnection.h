@@ -47,6 +47,9 @@ public:
     static WindowServerConnection& the();
 
 private:
+    // ^IPC::Endpoint
+    virtual bool is_superseded_by(const IPC::Message&, const IPC::Message& next_message) const override;
+
     virtual void handle(const Messages::WindowClient::Paint&) override;
     virtual void handle(const Messages::WindowClient::MouseMove&) override;
     virtual void handle(const Messages::WindowClient::MouseDown&) override;
@@ -35,6 +35,7 @@
 #include <AK/kmalloc.h>
 #include <LibCore/FileStream.h>
 #include <LibGfx/FontDatabase.h>
+#include <LibGfx/TextRunCache.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -276,6 +277,12 @@ int BitmapFont::width(const Utf32View& view) const
     return width;
 }
 
+void BitmapFont::did_change_metrics()
+{
+    // Text laid out with the old metrics would be drawn in the wrong places now.
+    TextRunCache::the().forget(*this);
+}
+
 void BitmapFont::set_type(FontTypes type)
 {
     if (type == m_type)
@@ -284,6 +291,8 @@ void BitmapFont::set_type(FontTypes type)
     if (type == FontTypes::Default)
         return;
 
+    did_change_metrics();
+
     size_t new_glyph_count = glyph_count_by_type(type);
     if (new_glyph_count <= m_glyph_count) {
         m_glyph_count = new_glyph_count;
@@ -74,6 +74,7 @@ public:
     {
         m_baseline = baseline;
         update_x_height();
+        did_change_metrics();
     }
 
     u8 mean_line() const { return m_mean_line; }
@@ -91,15 +92,24 @@ public:
     void set_name(String name) { m_name = move(name); }
 
     bool is_fixed_width() const { return m_fixed_width; }
-    void set_fixed_width(bool b) { m_fixed_width = b; }
+    void set_fixed_width(bool b)
+    {
+        m_fixed_width = b;
+        did_change_metrics();
+    }
 
     u8 glyph_spacing() const { return m_glyph_spacing; }
-    void set_glyph_spacing(u8 spacing) { m_glyph_spacing = spacing; }
+    void set_glyph_spacing(u8 spacing)
+    {
+        m_glyph_spacing = spacing;
+        did_change_metrics();
+    }
 
     void set_glyph_width(size_t ch, u8 width)
     {
         VERIFY(m_glyph_widths);
         m_glyph_widths[ch] = width;
+        did_change_metrics();
     }
 
     int glyph_count() const { return m_glyph_count; }
@@ -122,6 +132,7 @@ private:
     static size_t glyph_count_by_type(FontTypes type);
 
     void update_x_height() { m_x_height = m_baseline - m_mean_line; };
+    void did_change_metrics();
 
     String m_name;
     String m_family;
@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Platform.h>
+#include <AK/SIMD.h>
+#include <AK/StdLibExtras.h>
+#include <LibGfx/Blending.h>
+#include <LibGfx/CPUFeatures.h>
+#include <string.h>
+
+#if defined(__GNUC__) && !defined(__clang__)
+#    pragma GCC optimize("O3")
+#endif
+
+namespace Gfx {
+
+enum class SourceFilter {
+    None,
+    AlphaTable,
+    Opacity,
+    Brighten,
+    Dim,
+    Constant,
+    ConstantWithCoverage,
+};
+
+struct RowParameters {
+    const RGBA32* src { nullptr };
+    const u8* alpha_table { nullptr };
+    const u8* coverage { nullptr };
+    u8 alpha { 0 };
+    RGBA32 color { 0 };
+};
+
+// Brightening and dimming come from Painter::blit_filtered(), which skips transparent source pixels
+// entirely instead of blending them. Uncovered pixels are skipped the same way.
+static constexpr bool keeps_destination_for_transparent_source(SourceFilter filter)
+{
+    return filter == SourceFilter::Brighten || filter == SourceFilter::Dim || filter == SourceFilter::ConstantWithCoverage;
+}
+
+template<SourceFilter filter>
+ALWAYS_INLINE static Color filtered_source_pixel(const RowParameters& parameters, size_t index)
+{
+    if constexpr (filter == SourceFilter::Constant)
+        return Color::from_rgba(parameters.color);
+    if constexpr (filter == SourceFilter::ConstantWithCoverage) {
+        auto color = Color::from_rgba(parameters.color);
+        return color.with_alpha(color.alpha() * parameters.coverage[index] / 255);
+    }
+
+    auto source = Color::from_rgba(parameters.src[index]);
+    if constexpr (filter == SourceFilter::AlphaTable)
+        return source.with_alpha(parameters.alpha_table[source.alpha()]);
+    if constexpr (filter == SourceFilter::Opacity)
+        return source.with_alpha(parameters.alpha);
+    if constexpr (filter == SourceFilter::Brighten)
+        return source.lightened();
+    if constexpr (filter == SourceFilter::Dim)
+        return source.to_grayscale().lightened();
+    return source;
+}
+
+template<SourceFilter filter>
+static void blend_row_scalar(RGBA32* dst, size_t count, const RowParameters& parameters)
+{
+    for (size_t i = 0; i < count; ++i) {
+        auto source = filtered_source_pixel<filter>(parameters, i);
+        if (keeps_destination_for_transparent_source(filter) && !source.alpha())
+            continue;
+        auto destination = filter == SourceFilter::Opacity ? Color::from_rgb(dst[i]) : Color::from_rgba(dst[i]);
+        dst[i] = destination.blend(source).value();
+    }
+}
+
+#if ARCH(I386) || ARCH(X86_64)
+template<typename VectorType>
+ALWAYS_INLINE static bool all_lanes_equal(const VectorType& vector, u32 value)
+{
+    for (size_t i = 0; i < sizeof(VectorType) / sizeof(u32); ++i) {
+        if (vector[i] != value)
+            return false;
+    }
+    return true;
+}
+
+// This is Color::blend() for a whole vector of pixels at a time. All the intermediate values stay
+// below 2^24, so single precision floats hold them exactly, and the truncated float quotients
+// match the integer divisions of the scalar code.
+template<typename U32xN, typename I32xN, typename F32xN, SourceFilter filter>
+ALWAYS_INLINE static void blend_row_vectorized(RGBA32* dst, size_t count, const RowParameters& parameters)
+{
+    constexpr size_t lanes = sizeof(U32xN) / sizeof(u32);
+
+    for (size_t i = 0; i < count; i += lanes) {
+        size_t pixels = min(lanes, count - i);
+
+        // The last few pixels of a row go through the same code, with zeroes in the unused lanes.
+        U32xN destination {};
+        U32xN source {};
+        if (pixels == lanes)
+            memcpy(&destination, dst + i, sizeof(destination));
+        else
+            memcpy(&destination, dst + i, pixels * sizeof(u32));
+        if constexpr (filter == SourceFilter::Constant) {
+            source += parameters.color;
+        } else if constexpr (filter == SourceFilter::ConstantWithCoverage) {
+            U32xN coverage {};
+            for (size_t j = 0; j < pixels; ++j)
+                coverage[j] = parameters.coverage[i + j];
+            F32xN alpha = __builtin_convertvector((I32xN)(coverage * (parameters.color >> 24)), F32xN) / 255;
+            source = (U32xN)__builtin_convertvector(alpha, I32xN) << 24 | (parameters.color & 0xffffff);
+        } else if constexpr (filter == SourceFilter::AlphaTable) {
+            for (size_t j = 0; j < pixels; ++j) {
+                u32 pixel = parameters.src[i + j];
+                source[j] = (pixel & 0xffffff) | (u32)parameters.alpha_table[pixel >> 24] << 24;
+            }
+        } else if (pixels == lanes) {
+            memcpy(&source, parameters.src + i, sizeof(source));
+        } else {
+            memcpy(&source, parameters.src + i, pixels * sizeof(u32));
+        }
+
+        if constexpr (filter == SourceFilter::Opacity) {
+            source = (source & 0xffffff) | (u32)parameters.alpha << 24;
+            destination |= 0xff000000;
+        }
+
+        if constexpr (filter == SourceFilter::Brighten || filter == SourceFilter::Dim) {
+            U32xN filtered = source & 0xff000000;
+            if constexpr (filter == SourceFilter::Dim) {
+                I32xN sum = (I32xN)((source >> 16) & 0xff) + (I32xN)((source >> 8) & 0xff) + (I32xN)(source & 0xff);
+                I32xN gray = __builtin_convertvector(__builtin_convertvector(sum, F32xN) / 3.0f, I32xN);
+                I32xN lightened = __builtin_convertvector(__builtin_convertvector(gray, F32xN) * 1.2f, I32xN);
+                U32xN channel = (U32xN)(lightened > 255 ? 255 : lightened);
+                filtered |= channel << 16 | channel << 8 | channel;
+            } else {
+                for (int shift = 0; shift < 24; shift += 8) {
+                    F32xN channel = __builtin_convertvector((I32xN)((source >> shift) & 0xff), F32xN);
+                    I32xN lightened = __builtin_convertvector(channel * 1.2f, I32xN);
+                    filtered |= (U32xN)(lightened > 255 ? 255 : lightened) << shift;
+                }
+            }
+            source = filtered;
+        }
+
+        U32xN source_alpha = source & 0xff000000;
+        U32xN result;
+        if (all_lanes_equal(source_alpha, 0xff000000)) {
+            result = source;
+        } else if (all_lanes_equal(source_alpha, 0) && keeps_destination_for_transparent_source(filter)) {
+            result = destination;
+        } else {
+            F32xN destination_weight = __builtin_convertvector((I32xN)(destination >> 24), F32xN);
+            F32xN source_weight = __builtin_convertvector((I32xN)(source >> 24), F32xN);
+            destination_weight *= 255 - source_weight;
+            source_weight *= 255;
+            F32xN total_weight = destination_weight + source_weight;
+
+            result = (U32xN)__builtin_convertvector(total_weight / 255, I32xN) << 24;
+            for (int shift = 0; shift < 24; shift += 8) {
+                F32xN destination_channel = __builtin_convertvector((I32xN)((destination >> shift) & 0xff), F32xN);
+                F32xN source_channel = __builtin_convertvector((I32xN)((source >> shift) & 0xff), F32xN);
+                F32xN blended = (destination_channel * destination_weight + source_channel * source_weight) / total_weight;
+                result |= (U32xN)__builtin_convertvector(blended, I32xN) << shift;
+            }
+
+            // Color::blend() returns the source when both pixels are fully transparent.
+            result = total_weight == 0 ? source : result;
+            if constexpr (keeps_destination_for_transparent_source(filter))
+                result = source_alpha == 0 ? destination : result;
+        }
+
+        if (pixels == lanes)
+            memcpy(dst + i, &result, sizeof(result));
+        else
+            memcpy(dst + i, &result, pixels * sizeof(u32));
+    }
+}
+
+template<SourceFilter filter>
+[[gnu::target("sse2")]] static void blend_row_sse2(RGBA32* dst, size_t count, const RowParameters& parameters)
+{
+    using namespace AK::SIMD;
+    blend_row_vectorized<u32x4, i32x4, f32x4, filter>(dst, count, parameters);
+}
+
+template<SourceFilter filter>
+[[gnu::target("avx2")]] static void blend_row_avx2(RGBA32* dst, size_t count, const RowParameters& parameters)
+{
+    using namespace AK::SIMD;
+    blend_row_vectorized<u32x8, i32x8, f32x8, filter>(dst, count, parameters);
+}
+#endif
+
+template<SourceFilter filter>
+static void blend_row_with_filter(RGBA32* dst, size_t count, const RowParameters& parameters)
+{
+#if ARCH(I386) || ARCH(X86_64)
+    if (cpu_supports_avx2())
+        return blend_row_avx2<filter>(dst, count, parameters);
+    if (cpu_supports_sse2())
+        return blend_row_sse2<filter>(dst, count, parameters);
+#endif
+    blend_row_scalar<filter>(dst, count, parameters);
+}
+
+void blend_row(RGBA32* dst, const RGBA32* src, size_t count)
+{
+    blend_row_with_filter<SourceFilter::None>(dst, count, { .src = src });
+}
+
+void blend_row_with_alpha_table(RGBA32* dst, const RGBA32* src, size_t count, const u8 alpha_table[256])
+{
+    blend_row_with_filter<SourceFilter::AlphaTable>(dst, count, { .src = src, .alpha_table = alpha_table });
+}
+
+void blend_row_with_opacity(RGBA32* dst, const RGBA32* src, size_t count, u8 alpha)
+{
+    blend_row_with_filter<SourceFilter::Opacity>(dst, count, { .src = src, .alpha = alpha });
+}
+
+void blend_row_brightened(RGBA32* dst, const RGBA32* src, size_t count)
+{
+    blend_row_with_filter<SourceFilter::Brighten>(dst, count, { .src = src });
+}
+
+void blend_row_dimmed(RGBA32* dst, const RGBA32* src, size_t count)
+{
+    blend_row_with_filter<SourceFilter::Dim>(dst, count, { .src = src });
+}
+
+void blend_color_over_row(RGBA32* dst, size_t count, Color color)
+{
+    blend_row_with_filter<SourceFilter::Constant>(dst, count, { .color = color.value() });
+}
+
+void blend_color_over_row_with_coverage(RGBA32* dst, const u8* coverage, size_t count, Color color)
+{
+    blend_row_with_filter<SourceFilter::ConstantWithCoverage>(dst, count, { .coverage = coverage, .color = color.value() });
+}
+
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+#include <LibGfx/Color.h>
+
+namespace Gfx {
+
+// Source-over blending of whole rows of RGBA32 pixels. These use SSE2 or AVX2 when the CPU
+// supports them, and give exactly the same results as blending pixel by pixel with Color::blend().
+
+// dst[i] = dst[i].blend(src[i])
+void blend_row(RGBA32* dst, const RGBA32* src, size_t count);
+
+// Like blend_row(), but looks up the alpha of every source pixel in a table first.
+void blend_row_with_alpha_table(RGBA32* dst, const RGBA32* src, size_t count, const u8 alpha_table[256]);
+
+// Blends opaque RGB32 pixels over each other: dst[i] = Color::from_rgb(dst[i]).blend(Color::from_rgb(src[i]).with_alpha(alpha))
+void blend_row_with_opacity(RGBA32* dst, const RGBA32* src, size_t count, u8 alpha);
+
+// Like blend_row(), but with src[i].lightened() (or src[i].to_grayscale().lightened() when dimming).
+// Fully transparent source pixels leave the destination alone.
+void blend_row_brightened(RGBA32* dst, const RGBA32* src, size_t count);
+void blend_row_dimmed(RGBA32* dst, const RGBA32* src, size_t count);
+
+// dst[i] = dst[i].blend(color)
+void blend_color_over_row(RGBA32* dst, size_t count, Color);
+
+// Blends the color in as far as every pixel is covered, like for anti-aliased glyphs:
+// dst[i] = dst[i].blend(color.with_alpha(color.alpha() * coverage[i] / 255))
+// Pixels that aren't covered at all are left alone.
+void blend_color_over_row_with_coverage(RGBA32* dst, const u8* coverage, size_t count, Color);
+
+}
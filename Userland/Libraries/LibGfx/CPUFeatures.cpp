@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Platform.h>
+#include <AK/Types.h>
+#include <LibGfx/CPUFeatures.h>
+
+namespace Gfx {
+
+static bool s_hardware_acceleration_enabled = true;
+
+#if ARCH(I386) || ARCH(X86_64)
+struct CPUIDFeatures {
+    bool sse2 { false };
+    bool avx2 { false };
+};
+
+static void cpuid(u32 leaf, u32& eax, u32& ebx, u32& ecx, u32& edx)
+{
+    asm volatile("cpuid"
+                 : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+                 : "a"(leaf), "c"(0));
+}
+
+static const CPUIDFeatures& cpuid_features()
+{
+    static CPUIDFeatures s_features;
+    static bool s_initialized = false;
+    if (!s_initialized) {
+        u32 eax, ebx, ecx, edx;
+        cpuid(0, eax, ebx, ecx, edx);
+        u32 max_leaf = eax;
+
+        cpuid(1, eax, ebx, ecx, edx);
+        s_features.sse2 = (edx >> 26) & 1;
+
+        // AVX2 also needs the operating system to save the YMM registers on context switches,
+        // which it says by setting OSXSAVE and the SSE and AVX state bits in XCR0.
+        bool osxsave = (ecx >> 27) & 1;
+        bool avx = (ecx >> 28) & 1;
+        if (max_leaf >= 7 && osxsave && avx) {
+            u32 xcr0_low, xcr0_high;
+            asm volatile("xgetbv"
+                         : "=a"(xcr0_low), "=d"(xcr0_high)
+                         : "c"(0));
+            cpuid(7, eax, ebx, ecx, edx);
+            s_features.avx2 = (xcr0_low & 0x6) == 0x6 && ((ebx >> 5) & 1);
+        }
+        s_initialized = true;
+    }
+    return s_features;
+}
+#endif
+
+bool cpu_supports_sse2()
+{
+#if ARCH(I386) || ARCH(X86_64)
+    return s_hardware_acceleration_enabled && cpuid_features().sse2;
+#else
+    return false;
+#endif
+}
+
+bool cpu_supports_avx2()
+{
+#if ARCH(I386) || ARCH(X86_64)
+    return s_hardware_acceleration_enabled && cpuid_features().avx2;
+#else
+    return false;
+#endif
+}
+
+void set_hardware_acceleration_enabled(bool enabled)
+{
+    s_hardware_acceleration_enabled = enabled;
+}
+
+}
@@ -27,6 +27,7 @@
 #pragma once
 
 #include "GenericConvolutionFilter.h"
+#include "SeparableBlur.h"
 
 namespace Gfx {
 
@@ -37,6 +38,15 @@ public:
     virtual ~BoxBlurFilter() { }
 
     virtual const char* class_name() const override { return "BoxBlurFilter"; }
+
+    virtual void apply(Bitmap& target_bitmap, const IntRect& target_rect, const Bitmap& source_bitmap, const IntRect& source_rect, const Filter::Parameters& parameters) override
+    {
+        VERIFY(parameters.is_generic_convolution_filter());
+        auto& gcf_params = static_cast<const typename GenericConvolutionFilter<N>::Parameters&>(parameters);
+
+        // All weights of a box kernel are the same, so only its size matters.
+        box_blur(target_bitmap, target_rect, source_bitmap, source_rect, N / 2, gcf_params.should_wrap());
+    }
 };
 
 }
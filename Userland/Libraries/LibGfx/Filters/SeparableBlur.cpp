@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/NonnullRefPtrVector.h>
+#include <AK/Platform.h>
+#include <AK/SIMD.h>
+#include <AK/Vector.h>
+#include <LibGfx/Bitmap.h>
+#include <LibGfx/CPUFeatures.h>
+#include <LibGfx/Filters/SeparableBlur.h>
+#include <LibThread/ThreadPool.h>
+#include <math.h>
+#include <string.h>
+
+#if ARCH(I386) || ARCH(X86_64)
+#    include <emmintrin.h>
+#endif
+
+namespace Gfx {
+
+using AK::SIMD::f32x4;
+
+// One blur along the rows or the columns: either a box of the given radius, or a kernel of (2 * radius + 1) weights.
+struct Pass {
+    int radius { 0 };
+    Span<const float> kernel;
+};
+
+// The pixels being blurred, row by row.
+struct Plane {
+    Vector<u32> pixels;
+    int width { 0 };
+    int height { 0 };
+
+    u32* row(int y) { return pixels.data() + (size_t)y * width; }
+    const u32* row(int y) const { return pixels.data() + (size_t)y * width; }
+
+    // Rows above and below the plane repeat the edge, or come from the other side.
+    const u32* row_or_edge(int y, bool should_wrap) const
+    {
+        if (should_wrap)
+            return row((y % height + height) % height);
+        return row(clamp(y, 0, height - 1));
+    }
+};
+
+// The channels of a pixel are processed side by side, one in each lane of a vector. Each of these knows how
+// to get a pixel into such a vector and back. Sums of up to 65536 whole channel values stay exact as floats.
+struct PortablePixels {
+    ALWAYS_INLINE static f32x4 unpack(u32 pixel)
+    {
+        return f32x4 { (float)(pixel & 0xff), (float)((pixel >> 8) & 0xff), (float)((pixel >> 16) & 0xff), (float)(pixel >> 24) };
+    }
+
+    ALWAYS_INLINE static u32 pack(f32x4 channels)
+    {
+        auto channel = [&](int i) -> u32 { return clamp(channels[i], 0.0f, 255.0f) + 0.5f; };
+        return channel(0) | channel(1) << 8 | channel(2) << 16 | channel(3) << 24;
+    }
+};
+
+#if ARCH(I386) || ARCH(X86_64)
+struct SSE2Pixels {
+    [[gnu::target("sse2")]] ALWAYS_INLINE static f32x4 unpack(u32 pixel)
+    {
+        auto zero = _mm_setzero_si128();
+        auto channels = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(pixel), zero), zero);
+        return (f32x4)_mm_cvtepi32_ps(channels);
+    }
+
+    [[gnu::target("sse2")]] ALWAYS_INLINE static u32 pack(f32x4 channels)
+    {
+        // Rounds the same way as PortablePixels, and the packs saturate to 0-255 like its clamp().
+        auto rounded = _mm_cvttps_epi32(_mm_add_ps((__m128)channels, _mm_set1_ps(0.5f)));
+        auto words = _mm_packs_epi32(rounded, rounded);
+        return _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+    }
+};
+#endif
+
+// `padded` starts `radius` pixels before the row and goes on for radius + 1 pixels past its end.
+template<typename Pixels>
+ALWAYS_INLINE static void blur_row(const Pass& pass, const u32* padded, u32* out, int width)
+{
+    if (pass.kernel.is_empty()) {
+        // Slide the box along the row, adding the pixel that enters it and removing the one that leaves.
+        float scale = 1.0f / (2 * pass.radius + 1);
+        f32x4 sum {};
+        for (int i = 0; i < 2 * pass.radius + 1; ++i)
+            sum += Pixels::unpack(padded[i]);
+        for (int x = 0; x < width; ++x) {
+            out[x] = Pixels::pack(sum * scale);
+            sum += Pixels::unpack(padded[x + 2 * pass.radius + 1]) - Pixels::unpack(padded[x]);
+        }
+        return;
+    }
+
+    for (int x = 0; x < width; ++x) {
+        f32x4 sum {};
+        for (size_t i = 0; i < pass.kernel.size(); ++i)
+            sum += Pixels::unpack(padded[x + i]) * pass.kernel[i];
+        out[x] = Pixels::pack(sum);
+    }
+}
+
+// Blurs the given columns, going through the plane row by row (which is much kinder to the cache
+// than following each column) with a running sum or accumulator for every column.
+template<typename Pixels>
+ALWAYS_INLINE static void blur_columns(const Pass& pass, const Plane& in, Plane& out, int first_column, int column_count, bool should_wrap)
+{
+    Vector<f32x4> sums;
+    sums.resize(column_count);
+    auto row = [&](int y) { return in.row_or_edge(y, should_wrap) + first_column; };
+
+    if (pass.kernel.is_empty()) {
+        float scale = 1.0f / (2 * pass.radius + 1);
+        for (int x = 0; x < column_count; ++x)
+            sums[x] = f32x4 {};
+        for (int y = -pass.radius; y <= pass.radius; ++y) {
+            auto* pixels = row(y);
+            for (int x = 0; x < column_count; ++x)
+                sums[x] += Pixels::unpack(pixels[x]);
+        }
+        for (int y = 0; y < in.height; ++y) {
+            auto* entering = row(y + pass.radius + 1);
+            auto* leaving = row(y - pass.radius);
+            auto* out_row = out.row(y) + first_column;
+            for (int x = 0; x < column_count; ++x) {
+                out_row[x] = Pixels::pack(sums[x] * scale);
+                sums[x] += Pixels::unpack(entering[x]) - Pixels::unpack(leaving[x]);
+            }
+        }
+        return;
+    }
+
+    for (int y = 0; y < in.height; ++y) {
+        for (int x = 0; x < column_count; ++x)
+            sums[x] = f32x4 {};
+        for (size_t i = 0; i < pass.kernel.size(); ++i) {
+            auto* pixels = row(y + (int)i - pass.radius);
+            for (int x = 0; x < column_count; ++x)
+                sums[x] += Pixels::unpack(pixels[x]) * pass.kernel[i];
+        }
+        auto* out_row = out.row(y) + first_column;
+        for (int x = 0; x < column_count; ++x)
+            out_row[x] = Pixels::pack(sums[x]);
+    }
+}
+
+#if ARCH(I386) || ARCH(X86_64)
+[[gnu::target("sse2")]] static void blur_row_sse2(const Pass& pass, const u32* padded, u32* out, int width)
+{
+    blur_row<SSE2Pixels>(pass, padded, out, width);
+}
+
+[[gnu::target("sse2")]] static void blur_columns_sse2(const Pass& pass, const Plane& in, Plane& out, int first_column, int column_count, bool should_wrap)
+{
+    blur_columns<SSE2Pixels>(pass, in, out, first_column, column_count, should_wrap);
+}
+#endif
+
+static void blur_row_scalar(const Pass& pass, const u32* padded, u32* out, int width)
+{
+    blur_row<PortablePixels>(pass, padded, out, width);
+}
+
+static void blur_columns_scalar(const Pass& pass, const Plane& in, Plane& out, int first_column, int column_count, bool should_wrap)
+{
+    blur_columns<PortablePixels>(pass, in, out, first_column, column_count, should_wrap);
+}
+
+// Runs callback(first, count) for parts of `total` rows or columns, on the thread pool if there are enough pixels to go around.
+template<typename Callback>
+static void for_each_part_in_parallel(int total, int pixels_per_item, Callback callback)
+{
+    constexpr int min_pixels_per_thread = 64 * 1024;
+    auto& pool = LibThread::ThreadPool::the();
+    int part_count = min((int)pool.worker_count(), total * pixels_per_item / min_pixels_per_thread);
+    if (part_count <= 1) {
+        callback(0, total);
+        return;
+    }
+
+    auto first_of_part = [&](int part) { return total * part / part_count; };
+    pool.parallel_for(0, part_count, 1, [&](size_t part) {
+        callback(first_of_part(part), first_of_part(part + 1) - first_of_part(part));
+    });
+}
+
+static void separable_blur(Bitmap& target, const IntRect& target_rect, const Bitmap& source, const IntRect& source_rect, Span<const Pass> horizontal_passes, Span<const Pass> vertical_passes, bool should_wrap)
+{
+    VERIFY(source_rect.contains(target_rect));
+    VERIFY(target.rect().contains(target_rect));
+    VERIFY(source.rect().contains(source_rect));
+    VERIFY(source.format() == BitmapFormat::RGB32 || source.format() == BitmapFormat::RGBA32);
+    VERIFY(target.format() == BitmapFormat::RGB32 || target.format() == BitmapFormat::RGBA32);
+
+    if (target_rect.is_empty())
+        return;
+
+    auto blur_row = &blur_row_scalar;
+    auto blur_columns = &blur_columns_scalar;
+#if ARCH(I386) || ARCH(X86_64)
+    if (cpu_supports_sse2()) {
+        blur_row = &blur_row_sse2;
+        blur_columns = &blur_columns_sse2;
+    }
+#endif
+
+    int width = source_rect.width();
+    int height = source_rect.height();
+    Plane plane { {}, width, height };
+    Plane scratch_plane { {}, width, height };
+    plane.pixels.resize((size_t)width * height);
+    scratch_plane.pixels.resize(plane.pixels.size());
+    for (int y = 0; y < height; ++y)
+        memcpy(plane.row(y), source.scanline(source_rect.y() + y) + source_rect.x(), width * sizeof(u32));
+
+    for (auto& pass : horizontal_passes) {
+        for_each_part_in_parallel(height, width, [&](int first_row, int row_count) {
+            Vector<u32> padded;
+            padded.resize(width + 2 * pass.radius + 1);
+            for (int y = first_row; y < first_row + row_count; ++y) {
+                auto* row = plane.row(y);
+                for (int x = -pass.radius; x < 0; ++x)
+                    padded[x + pass.radius] = row[should_wrap ? (x % width + width) % width : 0];
+                memcpy(padded.data() + pass.radius, row, width * sizeof(u32));
+                for (int x = width; x < width + pass.radius + 1; ++x)
+                    padded[x + pass.radius] = row[should_wrap ? x % width : width - 1];
+                blur_row(pass, padded.data(), scratch_plane.row(y), width);
+            }
+        });
+        swap(plane.pixels, scratch_plane.pixels);
+    }
+
+    for (auto& pass : vertical_passes) {
+        for_each_part_in_parallel(width, height, [&](int first_column, int column_count) {
+            blur_columns(pass, plane, scratch_plane, first_column, column_count, should_wrap);
+        });
+        swap(plane.pixels, scratch_plane.pixels);
+    }
+
+    for (int y = target_rect.top(); y <= target_rect.bottom(); ++y) {
+        auto* blurred = plane.row(y - source_rect.y()) - source_rect.x();
+        auto* source_scanline = source.scanline(y);
+        auto* target_scanline = target.scanline(y);
+        for (int x = target_rect.left(); x <= target_rect.right(); ++x)
+            target_scanline[x] = (blurred[x] & 0x00ffffff) | (source_scanline[x] & 0xff000000);
+    }
+}
+
+void box_blur(Bitmap& target, const IntRect& target_rect, const Bitmap& source, const IntRect& source_rect, int radius, bool should_wrap)
+{
+    VERIFY(radius >= 0);
+    Pass pass { radius, {} };
+    separable_blur(target, target_rect, source, source_rect, { &pass, 1 }, { &pass, 1 }, should_wrap);
+}
+
+void gaussian_blur(Bitmap& target, const IntRect& target_rect, const Bitmap& source, const IntRect& source_rect, float sigma, bool should_wrap)
+{
+    VERIFY(sigma > 0);
+
+    if (sigma < 2) {
+        // Three boxes are too coarse to get small blurs right, but kernels this small are cheap enough to use directly.
+        int radius = ceilf(3 * sigma);
+        Vector<float> kernel;
+        float sum = 0;
+        for (int i = -radius; i <= radius; ++i) {
+            kernel.append(expf(-(i * i) / (2 * sigma * sigma)));
+            sum += kernel.last();
+        }
+        for (auto& weight : kernel)
+            weight /= sum;
+        separable_convolution(target, target_rect, source, source_rect, kernel, kernel, should_wrap);
+        return;
+    }
+
+    // Three box blurs of about the same size add up to the variance of the Gaussian we want, and their
+    // combined kernel is already very close to its bell shape. Box widths have to be odd, so some are
+    // a bit narrower and some a bit wider (see Kovesi, "Fast Almost-Gaussian Filtering").
+    constexpr int pass_count = 3;
+    float variance = sigma * sigma;
+    int lower_width = sqrtf(12 * variance / pass_count + 1);
+    if (lower_width % 2 == 0)
+        --lower_width;
+    int lower_width_count = roundf((12 * variance - pass_count * lower_width * lower_width - 4 * pass_count * lower_width - 3 * pass_count) / (-4 * lower_width - 4));
+
+    Pass passes[pass_count];
+    for (int i = 0; i < pass_count; ++i)
+        passes[i].radius = (i < lower_width_count ? lower_width : lower_width + 2) / 2;
+    separable_blur(target, target_rect, source, source_rect, { passes, pass_count }, { passes, pass_count }, should_wrap);
+}
+
+void separable_convolution(Bitmap& target, const IntRect& target_rect, const Bitmap& source, const IntRect& source_rect, Span<const float> horizontal_kernel, Span<const float> vertical_kernel, bool should_wrap)
+{
+    VERIFY(horizontal_kernel.size() % 2 == 1);
+    VERIFY(vertical_kernel.size() % 2 == 1);
+    Pass horizontal_pass { (int)horizontal_kernel.size() / 2, horizontal_kernel };
+    Pass vertical_pass { (int)vertical_kernel.size() / 2, vertical_kernel };
+    separable_blur(target, target_rect, source, source_rect, { &horizontal_pass, 1 }, { &vertical_pass, 1 }, should_wrap);
+}
+
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Span.h>
+#include <LibGfx/Forward.h>
+#include <LibGfx/Rect.h>
+
+namespace Gfx {
+
+// These blur the pixels in source_rect of source, and write the result for target_rect into target.
+// As with GenericConvolutionFilter, target may be the same bitmap as source. Pixels beyond the edges
+// of source_rect repeat the closest edge pixel, or come from the other side if should_wrap is set.
+// Alpha isn't blurred, every pixel keeps its own.
+//
+// All of them blur the rows first and the columns second, so they only need a few operations per
+// pixel instead of one for every element of a 2D kernel. Big bitmaps are processed on several threads.
+
+// Averages the (2 * radius + 1) x (2 * radius + 1) pixels around each pixel. This takes the same time
+// for any radius, as the sum is updated while sliding along the rows and columns.
+void box_blur(Bitmap& target, const IntRect& target_rect, const Bitmap& source, const IntRect& source_rect, int radius, bool should_wrap = false);
+
+// Approximates a Gaussian blur with three box blurs, so it also takes the same time for any sigma.
+// This is close to a real Gaussian for a sigma of 2 and up; for smaller ones, it's exact.
+void gaussian_blur(Bitmap& target, const IntRect& target_rect, const Bitmap& source, const IntRect& source_rect, float sigma, bool should_wrap = false);
+
+// Convolves with the 2D kernel that's the outer product of the given 1D kernels, which must both
+// have an odd length. The kernels are used as they are, so they should each sum up to 1.
+void separable_convolution(Bitmap& target, const IntRect& target_rect, const Bitmap& source, const IntRect& source_rect, Span<const float> horizontal_kernel, Span<const float> vertical_kernel, bool should_wrap = false);
+
+}
@@ -27,7 +27,9 @@
 #pragma once
 
 #include "GenericConvolutionFilter.h"
+#include "SeparableBlur.h"
 #include <AK/StdLibExtras.h>
+#include <math.h>
 
 namespace Gfx {
 
@@ -38,6 +40,41 @@ public:
     virtual ~SpatialGaussianBlurFilter() { }
 
     virtual const char* class_name() const override { return "SpatialGaussianBlurFilter"; }
+
+    virtual void apply(Bitmap& target_bitmap, const IntRect& target_rect, const Bitmap& source_bitmap, const IntRect& source_rect, const Filter::Parameters& parameters) override
+    {
+        VERIFY(parameters.is_generic_convolution_filter());
+        auto& gcf_params = static_cast<const typename GenericConvolutionFilter<N>::Parameters&>(parameters);
+        auto kernel = gcf_params.kernel().elements();
+
+        // A Gaussian kernel is the outer product of its row sums and its column sums (divided by the
+        // sum of all of them), so it can be applied as one pass along the rows and one along the columns.
+        float horizontal_kernel[N] {};
+        float vertical_kernel[N] {};
+        float sum = 0;
+        for (size_t k = 0; k < N; ++k) {
+            for (size_t l = 0; l < N; ++l) {
+                horizontal_kernel[k] += kernel[k][l];
+                vertical_kernel[l] += kernel[k][l];
+                sum += kernel[k][l];
+            }
+        }
+        for (size_t l = 0; l < N; ++l)
+            vertical_kernel[l] /= sum;
+
+        if constexpr (N <= max_direct_kernel_size) {
+            separable_convolution(target_bitmap, target_rect, source_bitmap, source_rect, { horizontal_kernel, N }, { vertical_kernel, N }, gcf_params.should_wrap());
+        } else {
+            // Past this size, three box blurs with the same variance are faster and look the same.
+            float variance = 0;
+            for (size_t k = 0; k < N; ++k)
+                variance += horizontal_kernel[k] * ((float)k - N / 2) * ((float)k - N / 2);
+            gaussian_blur(target_bitmap, target_rect, source_bitmap, source_rect, sqrtf(variance / sum), gcf_params.should_wrap());
+        }
+    }
+
+private:
+    static constexpr size_t max_direct_kernel_size = 9;
 };
 
 }
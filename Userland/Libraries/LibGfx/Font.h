@@ -68,6 +68,32 @@ private:
     IntSize m_size { 0, 0 };
 };
 
+// Anti-aliased glyphs are 8-bit coverage masks. Like GlyphBitmap, this only points at pixels
+// owned by the font (or its glyph cache), so it should be drawn right away and not kept around.
+class GlyphCoverage {
+public:
+    GlyphCoverage() = default;
+    GlyphCoverage(const u8* data, size_t pitch, IntSize size)
+        : m_data(data)
+        , m_pitch(pitch)
+        , m_size(size)
+    {
+    }
+
+    const u8* scanline(int y) const { return m_data + y * m_pitch; }
+    u8 coverage_at(int x, int y) const { return scanline(y)[x]; }
+
+    bool is_null() const { return !m_data; }
+    IntSize size() const { return m_size; }
+    int width() const { return m_size.width(); }
+    int height() const { return m_size.height(); }
+
+private:
+    const u8* m_data { nullptr };
+    size_t m_pitch { 0 };
+    IntSize m_size { 0, 0 };
+};
+
 class Glyph {
 public:
     Glyph(const GlyphBitmap& glyph_bitmap, int left_bearing, int advance, int ascent)
@@ -86,8 +112,18 @@ public:
     {
     }
 
-    bool is_glyph_bitmap() const { return !m_bitmap; }
+    Glyph(const GlyphCoverage& glyph_coverage, int left_bearing, int advance, int ascent)
+        : m_glyph_coverage(glyph_coverage)
+        , m_left_bearing(left_bearing)
+        , m_advance(advance)
+        , m_ascent(ascent)
+    {
+    }
+
+    bool is_glyph_bitmap() const { return !m_bitmap && m_glyph_coverage.is_null(); }
+    bool is_glyph_coverage() const { return !m_glyph_coverage.is_null(); }
     GlyphBitmap glyph_bitmap() const { return m_glyph_bitmap; }
+    GlyphCoverage glyph_coverage() const { return m_glyph_coverage; }
     RefPtr<Bitmap> bitmap() const { return m_bitmap; }
     int left_bearing() const { return m_left_bearing; }
     int advance() const { return m_advance; }
@@ -95,6 +131,7 @@ public:
 
 private:
     GlyphBitmap m_glyph_bitmap;
+    GlyphCoverage m_glyph_coverage;
     RefPtr<Bitmap> m_bitmap;
     int m_left_bearing;
     int m_advance;
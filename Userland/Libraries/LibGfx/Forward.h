@@ -35,6 +35,7 @@ class DisjointRectSet;
 class Emoji;
 class Font;
 class GlyphBitmap;
+class GlyphCoverage;
 class ImageDecoder;
 class Painter;
 class Palette;
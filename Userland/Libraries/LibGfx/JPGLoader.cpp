@@ -31,11 +31,15 @@
 #include <AK/LexicalPath.h>
 #include <AK/MappedFile.h>
 #include <AK/MemoryStream.h>
+#include <AK/Platform.h>
+#include <AK/SIMD.h>
 #include <AK/String.h>
 #include <AK/Vector.h>
 #include <LibGfx/Bitmap.h>
+#include <LibGfx/CPUFeatures.h>
 #include <LibGfx/JPGLoader.h>
 #include <math.h>
+#include <string.h>
 
 #define JPG_INVALID 0X0000
 
@@ -203,6 +207,7 @@ struct JPGLoadingContext {
     size_t data_size { 0 };
     u32 luma_table[64] = { 0 };
     u32 chroma_table[64] = { 0 };
+    i32 idct_tables[2][64] = { { 0 } }; // Prescaled copies of the tables above, see prepare_idct_tables().
     StartOfFrame frame;
     u8 hsample_factor { 0 };
     u8 vsample_factor { 0 };
@@ -215,6 +220,9 @@ struct JPGLoadingContext {
     HuffmanStreamState huffman_stream;
     i32 previous_dc_values[3] = { 0 };
     MacroblockMeta mblock_meta;
+    // If set, we decode the image at 1/8th of its size when that's still enough to fill this size, see load_jpg_for_thumbnail().
+    Optional<IntSize> thumbnail_size;
+    bool dc_only { false };
 };
 
 static void generate_huffman_codes(HuffmanTableSpec& table)
@@ -274,21 +282,21 @@ static Optional<u8> get_next_symbol(HuffmanStreamState& hstream, const HuffmanTa
 }
 
 /**
- * Build the macroblocks possible by reading single (MCU) subsampled pair of CbCr.
+ * Build the blocks of a single MCU by reading its (possibly subsampled) YCbCr data.
  * Depending on the sampling factors, we may not see triples of y, cb, cr in that
  * order. If sample factors differ from one, we'll read more than one block of y-
  * coefficients before we get to read a cb-cr block.
 
- * In the function below, `hcursor` and `vcursor` denote the location of the block
- * we're building in the macroblock matrix. `vfactor_i` and `hfactor_i` are cursors
- * that iterate over the vertical and horizontal subsampling factors, respectively.
- * When we finish one iteration of the innermost loop, we'll have the coefficients
- * of one of the components of block at position `mb_index`. When the outermost loop
- * finishes first iteration, we'll have all the luminance coefficients for all the
- * macroblocks that share the chrominance data. Next two iterations (assuming that
- * we are dealing with three components) will fill up the blocks with chroma data.
+ * In the function below, `vfactor_i` and `hfactor_i` are cursors that iterate over
+ * the vertical and horizontal subsampling factors, respectively, and pick the block
+ * of the MCU we're building. When we finish one iteration of the innermost loop,
+ * we'll have the coefficients of one of the components of that block. When the
+ * outermost loop finishes first iteration, we'll have all the luminance coefficients
+ * for all the macroblocks that share the chrominance data. Next two iterations
+ * (assuming that we are dealing with three components) will fill up the first
+ * block with chroma data.
  */
-static bool build_macroblocks(JPGLoadingContext& context, Vector<Macroblock>& macroblocks, u8 hcursor, u8 vcursor)
+static bool build_macroblocks(JPGLoadingContext& context, Vector<Macroblock>& macroblocks)
 {
     for (auto it = context.components.begin(); it != context.components.end(); ++it) {
         ComponentSpec& component = it->value;
@@ -300,8 +308,7 @@ static bool build_macroblocks(JPGLoadingContext& context, Vector<Macroblock>& ma
 
         for (u8 vfactor_i = 0; vfactor_i < component.vsample_factor; vfactor_i++) {
             for (u8 hfactor_i = 0; hfactor_i < component.hsample_factor; hfactor_i++) {
-                u32 mb_index = (vcursor + vfactor_i) * context.mblock_meta.hpadded_count + (hfactor_i + hcursor);
-                Macroblock& block = macroblocks[mb_index];
+                Macroblock& block = macroblocks[vfactor_i * context.hsample_factor + hfactor_i];
 
                 auto& dc_table = context.dc_tables.find(component.dc_destination_id)->value;
                 auto& ac_table = context.ac_tables.find(component.ac_destination_id)->value;
@@ -378,63 +385,6 @@ static bool build_macroblocks(JPGLoadingContext& context, Vector<Macroblock>& ma
     return true;
 }
 
-static Optional<Vector<Macroblock>> decode_huffman_stream(JPGLoadingContext& context)
-{
-    Vector<Macroblock> macroblocks;
-    macroblocks.resize(context.mblock_meta.padded_total);
-
-    if constexpr (JPG_DEBUG) {
-        dbgln("Image width: {}", context.frame.width);
-        dbgln("Image height: {}", context.frame.height);
-        dbgln("Macroblocks in a row: {}", context.mblock_meta.hpadded_count);
-        dbgln("Macroblocks in a column: {}", context.mblock_meta.vpadded_count);
-        dbgln("Macroblock meta padded total: {}", context.mblock_meta.padded_total);
-    }
-
-    // Compute huffman codes for DC and AC tables.
-    for (auto it = context.dc_tables.begin(); it != context.dc_tables.end(); ++it)
-        generate_huffman_codes(it->value);
-
-    for (auto it = context.ac_tables.begin(); it != context.ac_tables.end(); ++it)
-        generate_huffman_codes(it->value);
-
-    for (u32 vcursor = 0; vcursor < context.mblock_meta.vcount; vcursor += context.vsample_factor) {
-        for (u32 hcursor = 0; hcursor < context.mblock_meta.hcount; hcursor += context.hsample_factor) {
-            u32 i = vcursor * context.mblock_meta.hpadded_count + hcursor;
-            if (context.dc_reset_interval > 0) {
-                if (i % context.dc_reset_interval == 0) {
-                    context.previous_dc_values[0] = 0;
-                    context.previous_dc_values[1] = 0;
-                    context.previous_dc_values[2] = 0;
-
-                    // Restart markers are stored in byte boundaries. Advance the huffman stream cursor to
-                    //  the 0th bit of the next byte.
-                    if (context.huffman_stream.byte_offset < context.huffman_stream.stream.size()) {
-                        if (context.huffman_stream.bit_offset > 0) {
-                            context.huffman_stream.bit_offset = 0;
-                            context.huffman_stream.byte_offset++;
-                        }
-
-                        // Skip the restart marker (RSTn).
-                        context.huffman_stream.byte_offset++;
-                    }
-                }
-            }
-
-            if (!build_macroblocks(context, macroblocks, hcursor, vcursor)) {
-                if constexpr (JPG_DEBUG) {
-                    dbgln("Failed to build Macroblock {}", i);
-                    dbgln("Huffman stream byte offset {}", context.huffman_stream.byte_offset);
-                    dbgln("Huffman stream bit offset {}", context.huffman_stream.bit_offset);
-                }
-                return {};
-            }
-        }
-    }
-
-    return macroblocks;
-}
-
 static inline bool bounds_okay(const size_t cursor, const size_t delta, const size_t bound)
 {
     return (delta + cursor) < bound;
@@ -860,243 +810,329 @@ static bool skip_marker_with_length(InputMemoryStream& stream)
     return !stream.handle_any_error();
 }
 
-static void dequantize(JPGLoadingContext& context, Vector<Macroblock>& macroblocks)
+// The inverse DCT is the AAN (Arai, Agui and Nakajima) algorithm in fixed point, like libjpeg's
+// jidctfst.c. It wants every coefficient multiplied by aan_scale[row] * aan_scale[column] first,
+// so we fold those factors into the quantization tables, and dequantize as we load the coefficients.
+static constexpr int idct_table_bits = 8;
+static constexpr int idct_constant_bits = 12;
+static constexpr int idct_pass1_bits = 6;
+// Each pass leaves the samples scaled by sqrt(8), on top of the bits of the tables we haven't dropped yet.
+static constexpr int idct_pass2_bits = idct_table_bits - idct_pass1_bits + 3;
+
+static constexpr i32 idct_fixed(double value)
+{
+    return value * (1 << idct_constant_bits) + 0.5;
+}
+
+static void prepare_idct_tables(JPGLoadingContext& context)
 {
-    for (u32 vcursor = 0; vcursor < context.mblock_meta.vcount; vcursor += context.vsample_factor) {
-        for (u32 hcursor = 0; hcursor < context.mblock_meta.hcount; hcursor += context.hsample_factor) {
-            for (auto it = context.components.begin(); it != context.components.end(); ++it) {
-                auto& component = it->value;
-                const u32* table = component.qtable_id == 0 ? context.luma_table : context.chroma_table;
-                for (u32 vfactor_i = 0; vfactor_i < component.vsample_factor; vfactor_i++) {
-                    for (u32 hfactor_i = 0; hfactor_i < component.hsample_factor; hfactor_i++) {
-                        u32 mb_index = (vcursor + vfactor_i) * context.mblock_meta.hpadded_count + (hfactor_i + hcursor);
-                        Macroblock& block = macroblocks[mb_index];
-                        int* block_component = component.serial_id == 0 ? block.y : (component.serial_id == 1 ? block.cb : block.cr);
-                        for (u32 k = 0; k < 64; k++)
-                            block_component[k] *= table[k];
+    double aan_scale[8];
+    for (int k = 0; k < 8; k++)
+        aan_scale[k] = k == 0 ? 1.0 : cos(k * M_PI / 16.0) * M_SQRT2;
+
+    for (int table_id = 0; table_id < 2; table_id++) {
+        const u32* table = table_id == 0 ? context.luma_table : context.chroma_table;
+        for (int k = 0; k < 64; k++)
+            context.idct_tables[table_id][k] = static_cast<i32>(round(table[k] * aan_scale[k / 8] * aan_scale[k % 8] * (1 << idct_table_bits)));
+    }
+}
+
+// The transforms below work on VectorType, which is either a plain i32 or a vector of them. Every lane
+// handles its own row or column, so the same code makes up the scalar and the SSE2 paths.
+template<typename VectorType>
+static constexpr size_t lane_count = sizeof(VectorType) / sizeof(i32);
+
+template<typename VectorType>
+ALWAYS_INLINE static VectorType load_lanes(const i32* source)
+{
+    VectorType value;
+    memcpy(&value, source, sizeof(value));
+    return value;
+}
+
+// Stores lane i at destination[i * 8], i.e. down a column of a block.
+template<typename VectorType>
+ALWAYS_INLINE static void store_lanes_transposed(i32* destination, VectorType value)
+{
+    i32 lanes[lane_count<VectorType>];
+    memcpy(lanes, &value, sizeof(value));
+    for (size_t i = 0; i < lane_count<VectorType>; i++)
+        destination[i * 8] = lanes[i];
+}
+
+template<typename VectorType>
+ALWAYS_INLINE static VectorType descale(VectorType value, int bits)
+{
+    return (value + (1 << (bits - 1))) >> bits;
+}
+
+template<typename VectorType>
+ALWAYS_INLINE static VectorType idct_multiply(VectorType value, i32 constant)
+{
+    return (value * constant) >> idct_constant_bits;
+}
+
+template<typename VectorType>
+ALWAYS_INLINE static void idct_1d(VectorType (&v)[8])
+{
+    // Even part.
+    VectorType tmp10 = v[0] + v[4];
+    VectorType tmp11 = v[0] - v[4];
+    VectorType tmp13 = v[2] + v[6];
+    VectorType tmp12 = idct_multiply(v[2] - v[6], idct_fixed(1.414213562)) - tmp13;
+
+    VectorType even0 = tmp10 + tmp13;
+    VectorType even1 = tmp11 + tmp12;
+    VectorType even2 = tmp11 - tmp12;
+    VectorType even3 = tmp10 - tmp13;
+
+    // Odd part.
+    VectorType z10 = v[5] - v[3];
+    VectorType z11 = v[1] + v[7];
+    VectorType z12 = v[1] - v[7];
+    VectorType z13 = v[5] + v[3];
+    VectorType z5 = idct_multiply(z10 + z12, idct_fixed(1.847759065));
+
+    VectorType odd7 = z11 + z13;
+    VectorType odd6 = z5 - idct_multiply(z10, idct_fixed(2.613125930)) - odd7;
+    VectorType odd5 = idct_multiply(z11 - z13, idct_fixed(1.414213562)) - odd6;
+    VectorType odd4 = idct_multiply(z12, idct_fixed(1.082392200)) - z5 + odd5;
+
+    v[0] = even0 + odd7;
+    v[1] = even1 + odd6;
+    v[2] = even2 + odd5;
+    v[3] = even3 - odd4;
+    v[4] = even3 + odd4;
+    v[5] = even2 - odd5;
+    v[6] = even1 - odd6;
+    v[7] = even0 - odd7;
+}
+
+// Turns the quantized coefficients of a block into samples (still centered around zero) in place.
+template<typename VectorType>
+ALWAYS_INLINE static void dequantize_and_inverse_dct(i32* block, const i32* table)
+{
+    constexpr size_t lanes = lane_count<VectorType>;
+
+    // The first pass transforms the columns and stores them transposed, so that the second pass
+    // can load the rows the same way.
+    i32 workspace[64];
+    for (size_t column = 0; column < 8; column += lanes) {
+        VectorType v[8];
+        for (size_t row = 0; row < 8; row++)
+            v[row] = load_lanes<VectorType>(block + row * 8 + column) * load_lanes<VectorType>(table + row * 8 + column);
+        idct_1d(v);
+        for (size_t row = 0; row < 8; row++)
+            store_lanes_transposed(workspace + column * 8 + row, descale(v[row], idct_pass1_bits));
+    }
+
+    for (size_t row = 0; row < 8; row += lanes) {
+        VectorType v[8];
+        for (size_t column = 0; column < 8; column++)
+            v[column] = load_lanes<VectorType>(workspace + column * 8 + row);
+        idct_1d(v);
+        for (size_t column = 0; column < 8; column++)
+            store_lanes_transposed(block + row * 8 + column, descale(v[column], idct_pass2_bits));
+    }
+}
+
+static constexpr int color_bits = 16;
+
+static constexpr i32 color_fixed(double value)
+{
+    return value * (1 << color_bits) + 0.5;
+}
+
+template<typename VectorType>
+ALWAYS_INLINE static VectorType clamp_to_u8(VectorType value)
+{
+    value = value < 0 ? 0 : value;
+    return value > 255 ? 255 : value;
+}
+
+// Converts up to 8 pixels from YCbCr to RGB32. cb and cr must have 8 samples even when we write fewer pixels.
+template<typename VectorType>
+ALWAYS_INLINE static void ycbcr_to_rgb(RGBA32* destination, const i32* y, const i32* cb, const i32* cr, size_t count)
+{
+    constexpr size_t lanes = lane_count<VectorType>;
+    constexpr i32 half = 1 << (color_bits - 1);
+    for (size_t i = 0; i < count; i += lanes) {
+        VectorType luma = load_lanes<VectorType>(y + i) + 128;
+        VectorType blue_difference = load_lanes<VectorType>(cb + i);
+        VectorType red_difference = load_lanes<VectorType>(cr + i);
+
+        VectorType red = clamp_to_u8(luma + ((red_difference * color_fixed(1.402) + half) >> color_bits));
+        VectorType green = clamp_to_u8(luma - ((blue_difference * color_fixed(0.344136) + red_difference * color_fixed(0.714136) + half) >> color_bits));
+        VectorType blue = clamp_to_u8(luma + ((blue_difference * color_fixed(1.772) + half) >> color_bits));
+        VectorType pixels = static_cast<i32>(0xff000000) | (red << 16) | (green << 8) | blue;
+        memcpy(destination + i, &pixels, min(lanes, count - i) * sizeof(RGBA32));
+    }
+}
+
+// Transforms the blocks of the MCU at (hcursor, vcursor) and writes their pixels into the bitmap.
+template<typename VectorType>
+ALWAYS_INLINE static void compose_macroblocks(JPGLoadingContext& context, Vector<Macroblock>& macroblocks, u32 hcursor, u32 vcursor)
+{
+    for (auto it = context.components.begin(); it != context.components.end(); ++it) {
+        auto& component = it->value;
+        const i32* table = context.idct_tables[component.qtable_id];
+        for (u8 vfactor_i = 0; vfactor_i < component.vsample_factor; vfactor_i++) {
+            for (u8 hfactor_i = 0; hfactor_i < component.hsample_factor; hfactor_i++) {
+                Macroblock& block = macroblocks[vfactor_i * context.hsample_factor + hfactor_i];
+                i32* block_component = component.serial_id == 0 ? block.y : (component.serial_id == 1 ? block.cb : block.cr);
+                dequantize_and_inverse_dct<VectorType>(block_component, table);
+            }
+        }
+    }
+
+    // The chroma of the whole MCU lives in its first block, one sample per hsample_factor x vsample_factor pixels.
+    const Macroblock& chroma = macroblocks[0];
+    for (u8 vfactor_i = 0; vfactor_i < context.vsample_factor; vfactor_i++) {
+        for (u8 hfactor_i = 0; hfactor_i < context.hsample_factor; hfactor_i++) {
+            u32 x = (hcursor + hfactor_i) * 8;
+            u32 y = (vcursor + vfactor_i) * 8;
+            if (x >= context.frame.width || y >= context.frame.height)
+                continue;
+            size_t pixel_count = min(8u, context.frame.width - x);
+            u32 row_count = min(8u, context.frame.height - y);
+
+            const Macroblock& block = macroblocks[vfactor_i * context.hsample_factor + hfactor_i];
+            for (u32 row = 0; row < row_count; row++) {
+                u32 chroma_row = (row + 8 * vfactor_i) / context.vsample_factor;
+                const i32* cb = chroma.cb + chroma_row * 8;
+                const i32* cr = chroma.cr + chroma_row * 8;
+                i32 upsampled_cb[8];
+                i32 upsampled_cr[8];
+                if (context.hsample_factor == 2) {
+                    for (u32 column = 0; column < 8; column++) {
+                        upsampled_cb[column] = cb[(column + 8 * hfactor_i) / 2];
+                        upsampled_cr[column] = cr[(column + 8 * hfactor_i) / 2];
                     }
+                    cb = upsampled_cb;
+                    cr = upsampled_cr;
                 }
+                ycbcr_to_rgb<VectorType>(context.bitmap->scanline(y + row) + x, block.y + row * 8, cb, cr, pixel_count);
             }
         }
     }
 }
 
-static void inverse_dct(const JPGLoadingContext& context, Vector<Macroblock>& macroblocks)
+#if ARCH(I386) || ARCH(X86_64)
+[[gnu::target("sse2")]] static void compose_macroblocks_sse2(JPGLoadingContext& context, Vector<Macroblock>& macroblocks, u32 hcursor, u32 vcursor)
+{
+    compose_macroblocks<AK::SIMD::i32x4>(context, macroblocks, hcursor, vcursor);
+}
+#endif
+
+static void compose_macroblocks_scalar(JPGLoadingContext& context, Vector<Macroblock>& macroblocks, u32 hcursor, u32 vcursor)
 {
-    static const float m0 = 2.0 * cos(1.0 / 16.0 * 2.0 * M_PI);
-    static const float m1 = 2.0 * cos(2.0 / 16.0 * 2.0 * M_PI);
-    static const float m3 = 2.0 * cos(2.0 / 16.0 * 2.0 * M_PI);
-    static const float m5 = 2.0 * cos(3.0 / 16.0 * 2.0 * M_PI);
-    static const float m2 = m0 - m5;
-    static const float m4 = m0 + m5;
-    static const float s0 = cos(0.0 / 16.0 * M_PI) / sqrt(8);
-    static const float s1 = cos(1.0 / 16.0 * M_PI) / 2.0;
-    static const float s2 = cos(2.0 / 16.0 * M_PI) / 2.0;
-    static const float s3 = cos(3.0 / 16.0 * M_PI) / 2.0;
-    static const float s4 = cos(4.0 / 16.0 * M_PI) / 2.0;
-    static const float s5 = cos(5.0 / 16.0 * M_PI) / 2.0;
-    static const float s6 = cos(6.0 / 16.0 * M_PI) / 2.0;
-    static const float s7 = cos(7.0 / 16.0 * M_PI) / 2.0;
+    compose_macroblocks<i32>(context, macroblocks, hcursor, vcursor);
+}
 
-    for (u32 vcursor = 0; vcursor < context.mblock_meta.vcount; vcursor += context.vsample_factor) {
-        for (u32 hcursor = 0; hcursor < context.mblock_meta.hcount; hcursor += context.hsample_factor) {
-            for (auto it = context.components.begin(); it != context.components.end(); ++it) {
-                auto& component = it->value;
-                for (u8 vfactor_i = 0; vfactor_i < component.vsample_factor; vfactor_i++) {
-                    for (u8 hfactor_i = 0; hfactor_i < component.hsample_factor; hfactor_i++) {
-                        u32 mb_index = (vcursor + vfactor_i) * context.mblock_meta.hpadded_count + (hfactor_i + hcursor);
-                        Macroblock& block = macroblocks[mb_index];
-                        i32* block_component = component.serial_id == 0 ? block.y : (component.serial_id == 1 ? block.cb : block.cr);
-                        for (u32 k = 0; k < 8; ++k) {
-                            const float g0 = block_component[0 * 8 + k] * s0;
-                            const float g1 = block_component[4 * 8 + k] * s4;
-                            const float g2 = block_component[2 * 8 + k] * s2;
-                            const float g3 = block_component[6 * 8 + k] * s6;
-                            const float g4 = block_component[5 * 8 + k] * s5;
-                            const float g5 = block_component[1 * 8 + k] * s1;
-                            const float g6 = block_component[7 * 8 + k] * s7;
-                            const float g7 = block_component[3 * 8 + k] * s3;
-
-                            const float f0 = g0;
-                            const float f1 = g1;
-                            const float f2 = g2;
-                            const float f3 = g3;
-                            const float f4 = g4 - g7;
-                            const float f5 = g5 + g6;
-                            const float f6 = g5 - g6;
-                            const float f7 = g4 + g7;
-
-                            const float e0 = f0;
-                            const float e1 = f1;
-                            const float e2 = f2 - f3;
-                            const float e3 = f2 + f3;
-                            const float e4 = f4;
-                            const float e5 = f5 - f7;
-                            const float e6 = f6;
-                            const float e7 = f5 + f7;
-                            const float e8 = f4 + f6;
-
-                            const float d0 = e0;
-                            const float d1 = e1;
-                            const float d2 = e2 * m1;
-                            const float d3 = e3;
-                            const float d4 = e4 * m2;
-                            const float d5 = e5 * m3;
-                            const float d6 = e6 * m4;
-                            const float d7 = e7;
-                            const float d8 = e8 * m5;
-
-                            const float c0 = d0 + d1;
-                            const float c1 = d0 - d1;
-                            const float c2 = d2 - d3;
-                            const float c3 = d3;
-                            const float c4 = d4 + d8;
-                            const float c5 = d5 + d7;
-                            const float c6 = d6 - d8;
-                            const float c7 = d7;
-                            const float c8 = c5 - c6;
-
-                            const float b0 = c0 + c3;
-                            const float b1 = c1 + c2;
-                            const float b2 = c1 - c2;
-                            const float b3 = c0 - c3;
-                            const float b4 = c4 - c8;
-                            const float b5 = c8;
-                            const float b6 = c6 - c7;
-                            const float b7 = c7;
-
-                            block_component[0 * 8 + k] = b0 + b7;
-                            block_component[1 * 8 + k] = b1 + b6;
-                            block_component[2 * 8 + k] = b2 + b5;
-                            block_component[3 * 8 + k] = b3 + b4;
-                            block_component[4 * 8 + k] = b3 - b4;
-                            block_component[5 * 8 + k] = b2 - b5;
-                            block_component[6 * 8 + k] = b1 - b6;
-                            block_component[7 * 8 + k] = b0 - b7;
-                        }
-                        for (u32 l = 0; l < 8; ++l) {
-                            const float g0 = block_component[l * 8 + 0] * s0;
-                            const float g1 = block_component[l * 8 + 4] * s4;
-                            const float g2 = block_component[l * 8 + 2] * s2;
-                            const float g3 = block_component[l * 8 + 6] * s6;
-                            const float g4 = block_component[l * 8 + 5] * s5;
-                            const float g5 = block_component[l * 8 + 1] * s1;
-                            const float g6 = block_component[l * 8 + 7] * s7;
-                            const float g7 = block_component[l * 8 + 3] * s3;
-
-                            const float f0 = g0;
-                            const float f1 = g1;
-                            const float f2 = g2;
-                            const float f3 = g3;
-                            const float f4 = g4 - g7;
-                            const float f5 = g5 + g6;
-                            const float f6 = g5 - g6;
-                            const float f7 = g4 + g7;
-
-                            const float e0 = f0;
-                            const float e1 = f1;
-                            const float e2 = f2 - f3;
-                            const float e3 = f2 + f3;
-                            const float e4 = f4;
-                            const float e5 = f5 - f7;
-                            const float e6 = f6;
-                            const float e7 = f5 + f7;
-                            const float e8 = f4 + f6;
-
-                            const float d0 = e0;
-                            const float d1 = e1;
-                            const float d2 = e2 * m1;
-                            const float d3 = e3;
-                            const float d4 = e4 * m2;
-                            const float d5 = e5 * m3;
-                            const float d6 = e6 * m4;
-                            const float d7 = e7;
-                            const float d8 = e8 * m5;
-
-                            const float c0 = d0 + d1;
-                            const float c1 = d0 - d1;
-                            const float c2 = d2 - d3;
-                            const float c3 = d3;
-                            const float c4 = d4 + d8;
-                            const float c5 = d5 + d7;
-                            const float c6 = d6 - d8;
-                            const float c7 = d7;
-                            const float c8 = c5 - c6;
-
-                            const float b0 = c0 + c3;
-                            const float b1 = c1 + c2;
-                            const float b2 = c1 - c2;
-                            const float b3 = c0 - c3;
-                            const float b4 = c4 - c8;
-                            const float b5 = c8;
-                            const float b6 = c6 - c7;
-                            const float b7 = c7;
-
-                            block_component[l * 8 + 0] = b0 + b7;
-                            block_component[l * 8 + 1] = b1 + b6;
-                            block_component[l * 8 + 2] = b2 + b5;
-                            block_component[l * 8 + 3] = b3 + b4;
-                            block_component[l * 8 + 4] = b3 - b4;
-                            block_component[l * 8 + 5] = b2 - b5;
-                            block_component[l * 8 + 6] = b1 - b6;
-                            block_component[l * 8 + 7] = b0 - b7;
-                        }
-                    }
-                }
+// Writes one pixel per block, using the DC coefficients alone. Without its AC coefficients, the inverse DCT
+// of a block is flat: every sample is an eighth of the dequantized DC coefficient.
+static void compose_macroblocks_dc_only(JPGLoadingContext& context, Vector<Macroblock>& macroblocks, u32 hcursor, u32 vcursor)
+{
+    for (auto it = context.components.begin(); it != context.components.end(); ++it) {
+        auto& component = it->value;
+        i32 quantizer = component.qtable_id == 0 ? context.luma_table[0] : context.chroma_table[0];
+        for (u8 vfactor_i = 0; vfactor_i < component.vsample_factor; vfactor_i++) {
+            for (u8 hfactor_i = 0; hfactor_i < component.hsample_factor; hfactor_i++) {
+                Macroblock& block = macroblocks[vfactor_i * context.hsample_factor + hfactor_i];
+                i32* block_component = component.serial_id == 0 ? block.y : (component.serial_id == 1 ? block.cb : block.cr);
+                block_component[0] = (block_component[0] * quantizer + 4) >> 3;
             }
         }
     }
+
+    const Macroblock& chroma = macroblocks[0];
+    for (u8 vfactor_i = 0; vfactor_i < context.vsample_factor; vfactor_i++) {
+        for (u8 hfactor_i = 0; hfactor_i < context.hsample_factor; hfactor_i++) {
+            u32 x = hcursor + hfactor_i;
+            u32 y = vcursor + vfactor_i;
+            if (x >= (u32)context.bitmap->width() || y >= (u32)context.bitmap->height())
+                continue;
+            const Macroblock& block = macroblocks[vfactor_i * context.hsample_factor + hfactor_i];
+            ycbcr_to_rgb<i32>(context.bitmap->scanline(y) + x, block.y, chroma.cb, chroma.cr, 1);
+        }
+    }
 }
 
-static void ycbcr_to_rgb(const JPGLoadingContext& context, Vector<Macroblock>& macroblocks)
+// Decodes the image one MCU at a time, straight into the bitmap, so the blocks we're working
+// on stay in the cache and we never hold the coefficients of the whole image in memory.
+static bool decode_macroblocks(JPGLoadingContext& context)
 {
+    if constexpr (JPG_DEBUG) {
+        dbgln("Image width: {}", context.frame.width);
+        dbgln("Image height: {}", context.frame.height);
+        dbgln("Macroblocks in a row: {}", context.mblock_meta.hpadded_count);
+        dbgln("Macroblocks in a column: {}", context.mblock_meta.vpadded_count);
+        dbgln("Macroblock meta padded total: {}", context.mblock_meta.padded_total);
+    }
+
+    IntSize bitmap_size { context.frame.width, context.frame.height };
+    if (context.dc_only)
+        bitmap_size = { ceil_div(context.frame.width, (u16)8), ceil_div(context.frame.height, (u16)8) };
+    context.bitmap = Bitmap::create_purgeable(BitmapFormat::RGB32, bitmap_size);
+    if (!context.bitmap)
+        return false;
+
+    // Compute huffman codes for DC and AC tables.
+    for (auto it = context.dc_tables.begin(); it != context.dc_tables.end(); ++it)
+        generate_huffman_codes(it->value);
+
+    for (auto it = context.ac_tables.begin(); it != context.ac_tables.end(); ++it)
+        generate_huffman_codes(it->value);
+
+    prepare_idct_tables(context);
+    auto* compose = &compose_macroblocks_scalar;
+#if ARCH(I386) || ARCH(X86_64)
+    if (cpu_supports_sse2())
+        compose = &compose_macroblocks_sse2;
+#endif
+    if (context.dc_only)
+        compose = &compose_macroblocks_dc_only;
+
+    Vector<Macroblock> macroblocks;
+    macroblocks.resize(context.hsample_factor * context.vsample_factor);
+
     for (u32 vcursor = 0; vcursor < context.mblock_meta.vcount; vcursor += context.vsample_factor) {
         for (u32 hcursor = 0; hcursor < context.mblock_meta.hcount; hcursor += context.hsample_factor) {
-            const u32 chroma_block_index = vcursor * context.mblock_meta.hpadded_count + hcursor;
-            const Macroblock& chroma = macroblocks[chroma_block_index];
-            // Overflows are intentional.
-            for (u8 vfactor_i = context.vsample_factor - 1; vfactor_i < context.vsample_factor; --vfactor_i) {
-                for (u8 hfactor_i = context.hsample_factor - 1; hfactor_i < context.hsample_factor; --hfactor_i) {
-                    u32 mb_index = (vcursor + vfactor_i) * context.mblock_meta.hpadded_count + (hcursor + hfactor_i);
-                    i32* y = macroblocks[mb_index].y;
-                    i32* cb = macroblocks[mb_index].cb;
-                    i32* cr = macroblocks[mb_index].cr;
-                    for (u8 i = 7; i < 8; --i) {
-                        for (u8 j = 7; j < 8; --j) {
-                            const u8 pixel = i * 8 + j;
-                            const u32 chroma_pxrow = (i / context.vsample_factor) + 4 * vfactor_i;
-                            const u32 chroma_pxcol = (j / context.hsample_factor) + 4 * hfactor_i;
-                            const u32 chroma_pixel = chroma_pxrow * 8 + chroma_pxcol;
-                            int r = y[pixel] + 1.402f * chroma.cr[chroma_pixel] + 128;
-                            int g = y[pixel] - 0.344f * chroma.cb[chroma_pixel] - 0.714f * chroma.cr[chroma_pixel] + 128;
-                            int b = y[pixel] + 1.772f * chroma.cb[chroma_pixel] + 128;
-                            y[pixel] = r < 0 ? 0 : (r > 255 ? 255 : r);
-                            cb[pixel] = g < 0 ? 0 : (g > 255 ? 255 : g);
-                            cr[pixel] = b < 0 ? 0 : (b > 255 ? 255 : b);
+            u32 i = vcursor * context.mblock_meta.hpadded_count + hcursor;
+            if (context.dc_reset_interval > 0) {
+                if (i % context.dc_reset_interval == 0) {
+                    context.previous_dc_values[0] = 0;
+                    context.previous_dc_values[1] = 0;
+                    context.previous_dc_values[2] = 0;
+
+                    // Restart markers are stored in byte boundaries. Advance the huffman stream cursor to
+                    //  the 0th bit of the next byte.
+                    if (context.huffman_stream.byte_offset < context.huffman_stream.stream.size()) {
+                        if (context.huffman_stream.bit_offset > 0) {
+                            context.huffman_stream.bit_offset = 0;
+                            context.huffman_stream.byte_offset++;
                         }
+
+                        // Skip the restart marker (RSTn).
+                        context.huffman_stream.byte_offset++;
                     }
                 }
             }
-        }
-    }
-}
 
-static bool compose_bitmap(JPGLoadingContext& context, const Vector<Macroblock>& macroblocks)
-{
-    context.bitmap = Bitmap::create_purgeable(BitmapFormat::RGB32, { context.frame.width, context.frame.height });
-    if (!context.bitmap)
-        return false;
+            for (auto& macroblock : macroblocks)
+                macroblock = {};
+
+            if (!build_macroblocks(context, macroblocks)) {
+                if constexpr (JPG_DEBUG) {
+                    dbgln("Failed to build Macroblock {}", i);
+                    dbgln("Huffman stream byte offset {}", context.huffman_stream.byte_offset);
+                    dbgln("Huffman stream bit offset {}", context.huffman_stream.bit_offset);
+                }
+                context.bitmap = nullptr;
+                return false;
+            }
 
-    for (u32 y = context.frame.height - 1; y < context.frame.height; y--) {
-        const u32 block_row = y / 8;
-        const u32 pixel_row = y % 8;
-        for (u32 x = 0; x < context.frame.width; x++) {
-            const u32 block_column = x / 8;
-            auto& block = macroblocks[block_row * context.mblock_meta.hpadded_count + block_column];
-            const u32 pixel_column = x % 8;
-            const u32 pixel_index = pixel_row * 8 + pixel_column;
-            const Color color { (u8)block.y[pixel_index], (u8)block.cb[pixel_index], (u8)block.cr[pixel_index] };
-            context.bitmap->set_pixel(x, y, color);
+            compose(context, macroblocks, hcursor, vcursor);
         }
     }
 
@@ -1222,29 +1258,30 @@ static bool decode_jpg(JPGLoadingContext& context)
 
     if (!parse_header(stream, context))
         return false;
+
+    // If the image is going to be scaled down to at most 1/8th of its size anyway, decoding it at
+    // that size loses nothing, and it spares us the inverse DCT and most of the pixels.
+    if (context.thumbnail_size.has_value()) {
+        auto& thumbnail_size = context.thumbnail_size.value();
+        context.dc_only = context.frame.width >= 8 * thumbnail_size.width() || context.frame.height >= 8 * thumbnail_size.height();
+    }
+
     if (!scan_huffman_stream(stream, context))
         return false;
 
-    auto result = decode_huffman_stream(context);
-    if (!result.has_value()) {
+    if (!decode_macroblocks(context)) {
         dbgln_if(JPG_DEBUG, "{}: Failed to decode Macroblocks!", stream.offset());
         return false;
     }
-
-    auto macroblocks = result.release_value();
-    dequantize(context, macroblocks);
-    inverse_dct(context, macroblocks);
-    ycbcr_to_rgb(context, macroblocks);
-    if (!compose_bitmap(context, macroblocks))
-        return false;
     return true;
 }
 
-static RefPtr<Gfx::Bitmap> load_jpg_impl(const u8* data, size_t data_size)
+static RefPtr<Gfx::Bitmap> load_jpg_impl(const u8* data, size_t data_size, Optional<IntSize> thumbnail_size = {})
 {
     JPGLoadingContext context;
     context.data = data;
     context.data_size = data_size;
+    context.thumbnail_size = thumbnail_size;
 
     if (!decode_jpg(context))
         return nullptr;
@@ -1263,6 +1300,17 @@ RefPtr<Gfx::Bitmap> load_jpg(const StringView& path)
     return bitmap;
 }
 
+RefPtr<Gfx::Bitmap> load_jpg_for_thumbnail(const StringView& path, const IntSize& thumbnail_size)
+{
+    auto file_or_error = MappedFile::map(path);
+    if (file_or_error.is_error())
+        return nullptr;
+    auto bitmap = load_jpg_impl((const u8*)file_or_error.value()->data(), file_or_error.value()->size(), thumbnail_size);
+    if (bitmap)
+        bitmap->set_mmap_name(String::formatted("Gfx::Bitmap [{}] - Decoded JPG thumbnail: {}", bitmap->size(), LexicalPath::canonicalized_path(path)));
+    return bitmap;
+}
+
 RefPtr<Gfx::Bitmap> load_jpg_from_memory(const u8* data, size_t length)
 {
     auto bitmap = load_jpg_impl(data, length);
@@ -34,6 +34,9 @@
 namespace Gfx {
 
 RefPtr<Gfx::Bitmap> load_jpg(const StringView& path);
+// Like load_jpg(), for an image that is going to be scaled down to fit into thumbnail_size. If that's
+// at most 1/8th of its size, the image is decoded from its DC coefficients alone, which is much faster.
+RefPtr<Gfx::Bitmap> load_jpg_for_thumbnail(const StringView& path, const IntSize& thumbnail_size);
 RefPtr<Gfx::Bitmap> load_jpg_from_memory(const u8* data, size_t length);
 
 struct JPGLoadingContext;
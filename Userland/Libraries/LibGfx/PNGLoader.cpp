@@ -24,24 +24,24 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/ByteBuffer.h>
 #include <AK/Debug.h>
 #include <AK/Endian.h>
 #include <AK/LexicalPath.h>
 #include <AK/MappedFile.h>
-#include <LibCore/puff.h>
+#include <AK/MemoryStream.h>
+#include <AK/Platform.h>
+#include <AK/SIMD.h>
+#include <LibCompress/Deflate.h>
+#include <LibGfx/CPUFeatures.h>
 #include <LibGfx/PNGLoader.h>
 #include <fcntl.h>
 #include <math.h>
 #include <stdio.h>
 #include <string.h>
-#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
-#ifdef __serenity__
-#    include <serenity.h>
-#endif
-
 namespace Gfx {
 
 static const u8 png_header[8] = { 0x89, 'P', 'N', 'G', 13, 10, 26, 10 };
@@ -58,11 +58,6 @@ struct PNG_IHDR {
 
 static_assert(sizeof(PNG_IHDR) == 13);
 
-struct Scanline {
-    u8 filter { 0 };
-    ReadonlyBytes data {};
-};
-
 struct [[gnu::packed]] PaletteEntry {
     u8 r;
     u8 g;
@@ -70,27 +65,6 @@ struct [[gnu::packed]] PaletteEntry {
     //u8 a;
 };
 
-template<typename T>
-struct [[gnu::packed]] Tuple {
-    T gray;
-    T a;
-};
-
-template<typename T>
-struct [[gnu::packed]] Triplet {
-    T r;
-    T g;
-    T b;
-};
-
-template<typename T>
-struct [[gnu::packed]] Quad {
-    T r;
-    T g;
-    T b;
-    T a;
-};
-
 enum PngInterlaceMethod {
     Null = 0,
     Adam7 = 1
@@ -118,10 +92,7 @@ struct PNGLoadingContext {
     u8 channels { 0 };
     bool has_seen_zlib_header { false };
     bool has_alpha() const { return color_type & 4 || palette_transparency_data.size() > 0; }
-    Vector<Scanline> scanlines;
     RefPtr<Gfx::Bitmap> bitmap;
-    u8* decompression_buffer { nullptr };
-    size_t decompression_buffer_size { 0 };
     Vector<u8> compressed_data;
     Vector<PaletteEntry> palette_data;
     Vector<u8> palette_transparency_data;
@@ -222,301 +193,221 @@ ALWAYS_INLINE static u8 paeth_predictor(int a, int b, int c)
     return c;
 }
 
-union [[gnu::packed]] Pixel {
-    RGBA32 rgba { 0 };
-    u8 v[4];
-    struct {
-        u8 r;
-        u8 g;
-        u8 b;
-        u8 a;
-    };
-};
-static_assert(sizeof(Pixel) == 4);
-
-template<bool has_alpha, u8 filter_type>
-ALWAYS_INLINE static void unfilter_impl(Gfx::Bitmap& bitmap, int y, const void* dummy_scanline_data)
+// Scanlines are unfiltered byte by byte, with the byte bytes_per_pixel to the left (a), the one
+// above (b) and the one above and to the left (c) as predictors. The row buffers have zeroes in
+// front of the first pixel, so that a and c are zero there without having to check for it.
+static void unfilter_scanline_scalar(u8 filter, u8* row, const u8* previous_row, size_t row_size, size_t bytes_per_pixel)
 {
-    auto* dummy_scanline = (const Pixel*)dummy_scanline_data;
-    if constexpr (filter_type == 0) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        for (int i = 0; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-        }
+    switch (filter) {
+    case 1:
+        for (size_t i = 0; i < row_size; ++i)
+            row[i] += row[i - bytes_per_pixel];
+        break;
+    case 2:
+        for (size_t i = 0; i < row_size; ++i)
+            row[i] += previous_row[i];
+        break;
+    case 3:
+        for (size_t i = 0; i < row_size; ++i)
+            row[i] += (row[i - bytes_per_pixel] + previous_row[i]) / 2;
+        break;
+    case 4:
+        for (size_t i = 0; i < row_size; ++i)
+            row[i] += paeth_predictor(row[i - bytes_per_pixel], previous_row[i], previous_row[i - bytes_per_pixel]);
+        break;
     }
+}
 
-    if constexpr (filter_type == 1) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        swap(pixels[0].r, pixels[0].b);
-        for (int i = 1; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-            auto& a = (const Pixel&)pixels[i - 1];
-            x.v[0] += a.v[0];
-            x.v[1] += a.v[1];
-            x.v[2] += a.v[2];
-            if constexpr (has_alpha)
-                x.v[3] += a.v[3];
-        }
-        return;
-    }
-    if constexpr (filter_type == 2) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        auto* pixels_y_minus_1 = y == 0 ? dummy_scanline : (const Pixel*)bitmap.scanline(y - 1);
-        for (int i = 0; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-            const Pixel& b = pixels_y_minus_1[i];
-            x.v[0] += b.v[0];
-            x.v[1] += b.v[1];
-            x.v[2] += b.v[2];
-            if constexpr (has_alpha)
-                x.v[3] += b.v[3];
-        }
-        return;
+#if ARCH(I386) || ARCH(X86_64)
+// The Up filter doesn't depend on the current row, so it can do 16 bytes at a time. The row buffers
+// are padded, so we don't need to handle a partial vector at the end.
+ALWAYS_INLINE static void unfilter_up_vectorized(u8* row, const u8* previous_row, size_t row_size)
+{
+    using AK::SIMD::u8x16;
+    for (size_t i = 0; i < row_size; i += sizeof(u8x16)) {
+        u8x16 x, b;
+        memcpy(&x, row + i, sizeof(x));
+        memcpy(&b, previous_row + i, sizeof(b));
+        x += b;
+        memcpy(row + i, &x, sizeof(x));
     }
-    if constexpr (filter_type == 3) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        auto* pixels_y_minus_1 = y == 0 ? dummy_scanline : (const Pixel*)bitmap.scanline(y - 1);
-        for (int i = 0; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-            Pixel a;
-            if (i != 0)
-                a = pixels[i - 1];
-            const Pixel& b = pixels_y_minus_1[i];
-            x.v[0] = x.v[0] + ((a.v[0] + b.v[0]) / 2);
-            x.v[1] = x.v[1] + ((a.v[1] + b.v[1]) / 2);
-            x.v[2] = x.v[2] + ((a.v[2] + b.v[2]) / 2);
-            if constexpr (has_alpha)
-                x.v[3] = x.v[3] + ((a.v[3] + b.v[3]) / 2);
+}
+
+// Sub, Average and Paeth depend on the pixel to the left, so these go one pixel at a time,
+// with all of its channels in one vector.
+template<size_t bytes_per_pixel>
+ALWAYS_INLINE static void unfilter_pixels_vectorized(u8 filter, u8* row, const u8* previous_row, size_t row_size)
+{
+    using AK::SIMD::i16x4;
+    using AK::SIMD::u8x4;
+
+    auto load = [](const u8* pixel) {
+        u8x4 value {};
+        memcpy(&value, pixel, bytes_per_pixel);
+        return value;
+    };
+
+    u8x4 a {};
+    u8x4 c {};
+    for (size_t i = 0; i < row_size; i += bytes_per_pixel) {
+        u8x4 x = load(row + i);
+        u8x4 b = load(previous_row + i);
+        switch (filter) {
+        case 1:
+            x += a;
+            break;
+        case 3:
+            // The average of a and b, rounded down, without overflowing a byte.
+            x += (a & b) + ((a ^ b) >> 1);
+            break;
+        case 4: {
+            auto wide_a = __builtin_convertvector(a, i16x4);
+            auto wide_b = __builtin_convertvector(b, i16x4);
+            auto wide_c = __builtin_convertvector(c, i16x4);
+            // These are |p - a|, |p - b| and |p - c| for p = a + b - c.
+            auto pa = wide_b - wide_c;
+            auto pb = wide_a - wide_c;
+            auto pc = pa + pb;
+            pa = pa < 0 ? -pa : pa;
+            pb = pb < 0 ? -pb : pb;
+            pc = pc < 0 ? -pc : pc;
+            auto predictor = (pa <= pb) & (pa <= pc) ? wide_a : (pb <= pc ? wide_b : wide_c);
+            x += __builtin_convertvector(predictor, u8x4);
+            break;
         }
-        return;
-    }
-    if constexpr (filter_type == 4) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        auto* pixels_y_minus_1 = y == 0 ? dummy_scanline : (Pixel*)bitmap.scanline(y - 1);
-        for (int i = 0; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-            Pixel a;
-            const Pixel& b = pixels_y_minus_1[i];
-            Pixel c;
-            if (i != 0) {
-                a = pixels[i - 1];
-                c = pixels_y_minus_1[i - 1];
-            }
-            x.v[0] += paeth_predictor(a.v[0], b.v[0], c.v[0]);
-            x.v[1] += paeth_predictor(a.v[1], b.v[1], c.v[1]);
-            x.v[2] += paeth_predictor(a.v[2], b.v[2], c.v[2]);
-            if constexpr (has_alpha)
-                x.v[3] += paeth_predictor(a.v[3], b.v[3], c.v[3]);
         }
+        memcpy(row + i, &x, bytes_per_pixel);
+        a = x;
+        c = b;
     }
 }
 
-template<typename T>
-ALWAYS_INLINE static void unpack_grayscale_without_alpha(PNGLoadingContext& context)
+[[gnu::target("sse2")]] static void unfilter_scanline_sse2(u8 filter, u8* row, const u8* previous_row, size_t row_size, size_t bytes_per_pixel)
 {
-    for (int y = 0; y < context.height; ++y) {
-        auto* gray_values = reinterpret_cast<const T*>(context.scanlines[y].data.data());
-        for (int i = 0; i < context.width; ++i) {
-            auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-            pixel.r = gray_values[i];
-            pixel.g = gray_values[i];
-            pixel.b = gray_values[i];
-            pixel.a = 0xff;
-        }
-    }
+    if (filter == 2)
+        return unfilter_up_vectorized(row, previous_row, row_size);
+    if (filter != 0 && bytes_per_pixel == 4)
+        return unfilter_pixels_vectorized<4>(filter, row, previous_row, row_size);
+    if (filter != 0 && bytes_per_pixel == 3)
+        return unfilter_pixels_vectorized<3>(filter, row, previous_row, row_size);
+    unfilter_scanline_scalar(filter, row, previous_row, row_size, bytes_per_pixel);
 }
+#endif
 
-template<typename T>
-ALWAYS_INLINE static void unpack_grayscale_with_alpha(PNGLoadingContext& context)
+static void unfilter_scanline(u8 filter, u8* row, const u8* previous_row, size_t row_size, size_t bytes_per_pixel)
 {
-    for (int y = 0; y < context.height; ++y) {
-        auto* tuples = reinterpret_cast<const Tuple<T>*>(context.scanlines[y].data.data());
-        for (int i = 0; i < context.width; ++i) {
-            auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-            pixel.r = tuples[i].gray;
-            pixel.g = tuples[i].gray;
-            pixel.b = tuples[i].gray;
-            pixel.a = tuples[i].a;
-        }
-    }
+#if ARCH(I386) || ARCH(X86_64)
+    if (cpu_supports_sse2())
+        return unfilter_scanline_sse2(filter, row, previous_row, row_size, bytes_per_pixel);
+#endif
+    unfilter_scanline_scalar(filter, row, previous_row, row_size, bytes_per_pixel);
 }
 
-template<typename T>
-ALWAYS_INLINE static void unpack_triplets_without_alpha(PNGLoadingContext& context)
+ALWAYS_INLINE static RGBA32 rgba(u8 r, u8 g, u8 b, u8 a)
 {
-    for (int y = 0; y < context.height; ++y) {
-        auto* triplets = reinterpret_cast<const Triplet<T>*>(context.scanlines[y].data.data());
-        for (int i = 0; i < context.width; ++i) {
-            auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-            pixel.r = triplets[i].r;
-            pixel.g = triplets[i].g;
-            pixel.b = triplets[i].b;
-            pixel.a = 0xff;
-        }
-    }
+    return (a << 24) | (r << 16) | (g << 8) | b;
 }
 
-NEVER_INLINE FLATTEN static bool unfilter(PNGLoadingContext& context)
+// Converts an unfiltered scanline to RGBA32 pixels. 16-bit samples are cut down to their most significant byte.
+static bool unpack_scanline(const PNGLoadingContext& context, const u8* row, RGBA32* pixels, int width)
 {
-    // First unpack the scanlines to RGBA:
+    size_t sample_size = context.bit_depth == 16 ? 2 : 1;
+
     switch (context.color_type) {
     case 0:
-        if (context.bit_depth == 8) {
-            unpack_grayscale_without_alpha<u8>(context);
-        } else if (context.bit_depth == 16) {
-            unpack_grayscale_without_alpha<u16>(context);
-        } else if (context.bit_depth == 1 || context.bit_depth == 2 || context.bit_depth == 4) {
+        if (context.bit_depth < 8) {
             auto bit_depth_squared = context.bit_depth * context.bit_depth;
             auto pixels_per_byte = 8 / context.bit_depth;
             auto mask = (1 << context.bit_depth) - 1;
-            for (int y = 0; y < context.height; ++y) {
-                auto* gray_values = context.scanlines[y].data.data();
-                for (int x = 0; x < context.width; ++x) {
-                    auto bit_offset = (8 - context.bit_depth) - (context.bit_depth * (x % pixels_per_byte));
-                    auto value = (gray_values[x / pixels_per_byte] >> bit_offset) & mask;
-                    auto& pixel = (Pixel&)context.bitmap->scanline(y)[x];
-                    pixel.r = value * (0xff / bit_depth_squared);
-                    pixel.g = value * (0xff / bit_depth_squared);
-                    pixel.b = value * (0xff / bit_depth_squared);
-                    pixel.a = 0xff;
-                }
+            for (int x = 0; x < width; ++x) {
+                auto bit_offset = (8 - context.bit_depth) - (context.bit_depth * (x % pixels_per_byte));
+                u8 value = ((row[x / pixels_per_byte] >> bit_offset) & mask) * (0xff / bit_depth_squared);
+                pixels[x] = rgba(value, value, value, 0xff);
             }
         } else {
-            VERIFY_NOT_REACHED();
+            for (int x = 0; x < width; ++x) {
+                u8 gray = row[x * sample_size];
+                pixels[x] = rgba(gray, gray, gray, 0xff);
+            }
         }
-        break;
+        return true;
     case 4:
-        if (context.bit_depth == 8) {
-            unpack_grayscale_with_alpha<u8>(context);
-        } else if (context.bit_depth == 16) {
-            unpack_grayscale_with_alpha<u16>(context);
-        } else {
-            VERIFY_NOT_REACHED();
+        for (int x = 0; x < width; ++x) {
+            auto* tuple = row + x * 2 * sample_size;
+            pixels[x] = rgba(tuple[0], tuple[0], tuple[0], tuple[sample_size]);
         }
-        break;
+        return true;
     case 2:
-        if (context.bit_depth == 8) {
-            unpack_triplets_without_alpha<u8>(context);
-        } else if (context.bit_depth == 16) {
-            unpack_triplets_without_alpha<u16>(context);
-        } else {
-            VERIFY_NOT_REACHED();
+        for (int x = 0; x < width; ++x) {
+            auto* triplet = row + x * 3 * sample_size;
+            pixels[x] = rgba(triplet[0], triplet[sample_size], triplet[2 * sample_size], 0xff);
         }
-        break;
+        return true;
     case 6:
-        if (context.bit_depth == 8) {
-            for (int y = 0; y < context.height; ++y) {
-                memcpy(context.bitmap->scanline(y), context.scanlines[y].data.data(), context.scanlines[y].data.size());
-            }
-        } else if (context.bit_depth == 16) {
-            for (int y = 0; y < context.height; ++y) {
-                auto* triplets = reinterpret_cast<const Quad<u16>*>(context.scanlines[y].data.data());
-                for (int i = 0; i < context.width; ++i) {
-                    auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-                    pixel.r = triplets[i].r & 0xFF;
-                    pixel.g = triplets[i].g & 0xFF;
-                    pixel.b = triplets[i].b & 0xFF;
-                    pixel.a = triplets[i].a & 0xFF;
-                }
-            }
-        } else {
-            VERIFY_NOT_REACHED();
+        for (int x = 0; x < width; ++x) {
+            auto* quad = row + x * 4 * sample_size;
+            pixels[x] = rgba(quad[0], quad[sample_size], quad[2 * sample_size], quad[3 * sample_size]);
         }
-        break;
-    case 3:
-        if (context.bit_depth == 8) {
-            for (int y = 0; y < context.height; ++y) {
-                auto* palette_index = context.scanlines[y].data.data();
-                for (int i = 0; i < context.width; ++i) {
-                    auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-                    if (palette_index[i] >= context.palette_data.size())
-                        return false;
-                    auto& color = context.palette_data.at((int)palette_index[i]);
-                    auto transparency = context.palette_transparency_data.size() >= palette_index[i] + 1u
-                        ? context.palette_transparency_data.data()[palette_index[i]]
-                        : 0xff;
-                    pixel.r = color.r;
-                    pixel.g = color.g;
-                    pixel.b = color.b;
-                    pixel.a = transparency;
-                }
-            }
-        } else if (context.bit_depth == 1 || context.bit_depth == 2 || context.bit_depth == 4) {
-            auto pixels_per_byte = 8 / context.bit_depth;
-            auto mask = (1 << context.bit_depth) - 1;
-            for (int y = 0; y < context.height; ++y) {
-                auto* palette_indexes = context.scanlines[y].data.data();
-                for (int i = 0; i < context.width; ++i) {
-                    auto bit_offset = (8 - context.bit_depth) - (context.bit_depth * (i % pixels_per_byte));
-                    auto palette_index = (palette_indexes[i / pixels_per_byte] >> bit_offset) & mask;
-                    auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-                    if ((size_t)palette_index >= context.palette_data.size())
-                        return false;
-                    auto& color = context.palette_data.at(palette_index);
-                    auto transparency = context.palette_transparency_data.size() >= palette_index + 1u
-                        ? context.palette_transparency_data.data()[palette_index]
-                        : 0xff;
-                    pixel.r = color.r;
-                    pixel.g = color.g;
-                    pixel.b = color.b;
-                    pixel.a = transparency;
-                }
+        return true;
+    case 3: {
+        auto pixels_per_byte = 8 / context.bit_depth;
+        auto mask = (1 << context.bit_depth) - 1;
+        for (int x = 0; x < width; ++x) {
+            size_t palette_index = row[x];
+            if (context.bit_depth < 8) {
+                auto bit_offset = (8 - context.bit_depth) - (context.bit_depth * (x % pixels_per_byte));
+                palette_index = (row[x / pixels_per_byte] >> bit_offset) & mask;
             }
-        } else {
-            VERIFY_NOT_REACHED();
+            if (palette_index >= context.palette_data.size())
+                return false;
+            auto& color = context.palette_data[palette_index];
+            auto transparency = palette_index < context.palette_transparency_data.size()
+                ? context.palette_transparency_data[palette_index]
+                : 0xff;
+            pixels[x] = rgba(color.r, color.g, color.b, transparency);
         }
-        break;
+        return true;
+    }
     default:
         VERIFY_NOT_REACHED();
-        break;
     }
+}
 
-    u8 dummy_scanline[context.width * sizeof(RGBA32)];
+// Reads the rows of a (sub)image from the inflater one at a time, unfilters them against the
+// previous row and hands them to the callback, so we never hold more than two rows of image data.
+template<typename Callback>
+static bool read_scanlines(PNGLoadingContext& context, InputStream& stream, int width, int height, Callback callback)
+{
+    auto checked_row_size = context.compute_row_size_for_width(width);
+    if (checked_row_size.has_overflow())
+        return false;
+    size_t row_size = checked_row_size.value();
+    size_t bytes_per_pixel = max(1, context.channels * context.bit_depth / 8);
 
-    for (int y = 0; y < context.height; ++y) {
-        auto filter = context.scanlines[y].filter;
-        if (filter == 0) {
-            if (context.has_alpha())
-                unfilter_impl<true, 0>(*context.bitmap, y, dummy_scanline);
-            else
-                unfilter_impl<false, 0>(*context.bitmap, y, dummy_scanline);
-            continue;
-        }
-        if (filter == 1) {
-            if (context.has_alpha())
-                unfilter_impl<true, 1>(*context.bitmap, y, dummy_scanline);
-            else
-                unfilter_impl<false, 1>(*context.bitmap, y, dummy_scanline);
-            continue;
-        }
-        if (filter == 2) {
-            if (context.has_alpha())
-                unfilter_impl<true, 2>(*context.bitmap, y, dummy_scanline);
-            else
-                unfilter_impl<false, 2>(*context.bitmap, y, dummy_scanline);
-            continue;
-        }
-        if (filter == 3) {
-            if (context.has_alpha())
-                unfilter_impl<true, 3>(*context.bitmap, y, dummy_scanline);
-            else
-                unfilter_impl<false, 3>(*context.bitmap, y, dummy_scanline);
-            continue;
+    // Room for the zeroed pixel to the left of the row, and for the vectorized unfilters to run over the end.
+    constexpr size_t padding = 16;
+    auto row_buffer = ByteBuffer::create_zeroed(padding + row_size + padding);
+    auto previous_row_buffer = ByteBuffer::create_zeroed(padding + row_size + padding);
+    u8* row = row_buffer.data() + padding;
+    u8* previous_row = previous_row_buffer.data() + padding;
+
+    for (int y = 0; y < height; ++y) {
+        u8 filter;
+        if (!stream.read_or_error({ &filter, 1 }) || !stream.read_or_error({ row, row_size })) {
+            dbgln_if(PNG_DEBUG, "PNG data ended before row {}", y);
+            return false;
         }
-        if (filter == 4) {
-            if (context.has_alpha())
-                unfilter_impl<true, 4>(*context.bitmap, y, dummy_scanline);
-            else
-                unfilter_impl<false, 4>(*context.bitmap, y, dummy_scanline);
-            continue;
+
+        if (filter > 4) {
+            dbgln_if(PNG_DEBUG, "Invalid PNG filter: {}", filter);
+            return false;
         }
-    }
 
+        unfilter_scanline(filter, row, previous_row, row_size, bytes_per_pixel);
+        if (!callback(y, row))
+            return false;
+        swap(row, previous_row);
+    }
     return true;
 }
 
@@ -601,43 +492,11 @@ static bool decode_png_chunks(PNGLoadingContext& context)
     return true;
 }
 
-static bool decode_png_bitmap_simple(PNGLoadingContext& context)
+static bool decode_png_bitmap_simple(PNGLoadingContext& context, InputStream& stream)
 {
-    Streamer streamer(context.decompression_buffer, context.decompression_buffer_size);
-
-    for (int y = 0; y < context.height; ++y) {
-        u8 filter;
-        if (!streamer.read(filter)) {
-            context.state = PNGLoadingContext::State::Error;
-            return false;
-        }
-
-        if (filter > 4) {
-            dbgln_if(PNG_DEBUG, "Invalid PNG filter: {}", filter);
-            context.state = PNGLoadingContext::State::Error;
-            return false;
-        }
-
-        context.scanlines.append({ filter });
-        auto& scanline_buffer = context.scanlines.last().data;
-        auto row_size = context.compute_row_size_for_width(context.width);
-        if (row_size.has_overflow())
-            return false;
-
-        if (!streamer.wrap_bytes(scanline_buffer, row_size.value())) {
-            context.state = PNGLoadingContext::State::Error;
-            return false;
-        }
-    }
-
-    context.bitmap = Bitmap::create_purgeable(context.has_alpha() ? BitmapFormat::RGBA32 : BitmapFormat::RGB32, { context.width, context.height });
-
-    if (!context.bitmap) {
-        context.state = PNGLoadingContext::State::Error;
-        return false;
-    }
-
-    return unfilter(context);
+    return read_scanlines(context, stream, context.width, context.height, [&](int y, const u8* row) {
+        return unpack_scanline(context, row, context.bitmap->scanline(y), context.width);
+    });
 }
 
 static int adam7_height(PNGLoadingContext& context, int pass)
@@ -690,72 +549,32 @@ static int adam7_startx[8] = { 0, 0, 4, 0, 2, 0, 1, 0 };
 static int adam7_stepy[8] = { 1, 8, 8, 8, 4, 4, 2, 2 };
 static int adam7_stepx[8] = { 1, 8, 8, 4, 4, 2, 2, 1 };
 
-static bool decode_adam7_pass(PNGLoadingContext& context, Streamer& streamer, int pass)
+static bool decode_adam7_pass(PNGLoadingContext& context, InputStream& stream, int pass)
 {
-    PNGLoadingContext subimage_context;
-    subimage_context.width = adam7_width(context, pass);
-    subimage_context.height = adam7_height(context, pass);
-    subimage_context.channels = context.channels;
-    subimage_context.color_type = context.color_type;
-    subimage_context.palette_data = context.palette_data;
-    subimage_context.palette_transparency_data = context.palette_transparency_data;
-    subimage_context.bit_depth = context.bit_depth;
-    subimage_context.filter_method = context.filter_method;
+    int width = adam7_width(context, pass);
+    int height = adam7_height(context, pass);
 
     // For small images, some passes might be empty
-    if (!subimage_context.width || !subimage_context.height)
+    if (!width || !height)
         return true;
 
-    subimage_context.scanlines.clear_with_capacity();
-    for (int y = 0; y < subimage_context.height; ++y) {
-        u8 filter;
-        if (!streamer.read(filter)) {
-            context.state = PNGLoadingContext::State::Error;
+    Vector<RGBA32> pixels;
+    pixels.resize(width);
+    return read_scanlines(context, stream, width, height, [&](int y, const u8* row) {
+        if (!unpack_scanline(context, row, pixels.data(), width))
             return false;
-        }
-
-        if (filter > 4) {
-            dbgln_if(PNG_DEBUG, "Invalid PNG filter: {}", filter);
-            context.state = PNGLoadingContext::State::Error;
-            return false;
-        }
-
-        subimage_context.scanlines.append({ filter });
-        auto& scanline_buffer = subimage_context.scanlines.last().data;
-
-        auto row_size = context.compute_row_size_for_width(subimage_context.width);
-        if (row_size.has_overflow())
-            return false;
-        if (!streamer.wrap_bytes(scanline_buffer, row_size.value())) {
-            context.state = PNGLoadingContext::State::Error;
-            return false;
-        }
-    }
-
-    subimage_context.bitmap = Bitmap::create(context.bitmap->format(), { subimage_context.width, subimage_context.height });
-    if (!unfilter(subimage_context)) {
-        subimage_context.bitmap = nullptr;
-        return false;
-    }
-
-    // Copy the subimage data into the main image according to the pass pattern
-    for (int y = 0, dy = adam7_starty[pass]; y < subimage_context.height && dy < context.height; ++y, dy += adam7_stepy[pass]) {
-        for (int x = 0, dx = adam7_startx[pass]; x < subimage_context.width && dy < context.width; ++x, dx += adam7_stepx[pass]) {
-            context.bitmap->set_pixel(dx, dy, subimage_context.bitmap->get_pixel(x, y));
-        }
-    }
-    return true;
+        // Copy the subimage row into the main image according to the pass pattern
+        auto* destination = context.bitmap->scanline(adam7_starty[pass] + y * adam7_stepy[pass]);
+        for (int x = 0; x < width; ++x)
+            destination[adam7_startx[pass] + x * adam7_stepx[pass]] = pixels[x];
+        return true;
+    });
 }
 
-static bool decode_png_adam7(PNGLoadingContext& context)
+static bool decode_png_adam7(PNGLoadingContext& context, InputStream& stream)
 {
-    Streamer streamer(context.decompression_buffer, context.decompression_buffer_size);
-    context.bitmap = Bitmap::create_purgeable(context.has_alpha() ? BitmapFormat::RGBA32 : BitmapFormat::RGB32, { context.width, context.height });
-    if (!context.bitmap)
-        return false;
-
     for (int pass = 1; pass <= 7; ++pass) {
-        if (!decode_adam7_pass(context, streamer, pass))
+        if (!decode_adam7_pass(context, stream, pass))
             return false;
     }
     return true;
@@ -777,45 +596,45 @@ static bool decode_png_bitmap(PNGLoadingContext& context)
     if (context.color_type == 3 && context.palette_data.is_empty())
         return false; // Didn't see a PLTE chunk for a palettized image, or it was empty.
 
-    unsigned long srclen = context.compressed_data.size() - 6;
-    unsigned long destlen = 0;
-    int ret = puff(nullptr, &destlen, context.compressed_data.data() + 2, &srclen);
-    if (ret != 0) {
+    if (context.compressed_data.size() < 2) {
         context.state = PNGLoadingContext::State::Error;
         return false;
     }
-    context.decompression_buffer_size = destlen;
-#ifdef __serenity__
-    context.decompression_buffer = (u8*)mmap_with_name(nullptr, context.decompression_buffer_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0, "PNG decompression buffer");
-#else
-    context.decompression_buffer = (u8*)mmap(nullptr, context.decompression_buffer_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0);
-#endif
 
-    ret = puff(context.decompression_buffer, &destlen, context.compressed_data.data() + 2, &srclen);
-    if (ret != 0) {
+    context.bitmap = Bitmap::create_purgeable(context.has_alpha() ? BitmapFormat::RGBA32 : BitmapFormat::RGB32, { context.width, context.height });
+    if (!context.bitmap) {
         context.state = PNGLoadingContext::State::Error;
         return false;
     }
-    context.compressed_data.clear();
 
-    context.scanlines.ensure_capacity(context.height);
+    // Inflate the image data as we go instead of all at once, so the rows go straight from the
+    // decompressor into the bitmap. The first two bytes are the zlib header.
+    InputMemoryStream compressed_stream { context.compressed_data.span().slice(2) };
+    Compress::DeflateDecompressor decompressor { compressed_stream };
+
+    bool success = false;
     switch (context.interlace_method) {
     case PngInterlaceMethod::Null:
-        if (!decode_png_bitmap_simple(context))
-            return false;
+        success = decode_png_bitmap_simple(context, decompressor);
         break;
     case PngInterlaceMethod::Adam7:
-        if (!decode_png_adam7(context))
-            return false;
+        success = decode_png_adam7(context, decompressor);
         break;
     default:
         VERIFY_NOT_REACHED();
     }
 
-    munmap(context.decompression_buffer, context.decompression_buffer_size);
-    context.decompression_buffer = nullptr;
-    context.decompression_buffer_size = 0;
+    // Truncated or corrupt image data leaves an error on the streams; we've already reported it through `success`.
+    decompressor.handle_any_error();
+    compressed_stream.handle_any_error();
 
+    if (!success) {
+        context.bitmap = nullptr;
+        context.state = PNGLoadingContext::State::Error;
+        return false;
+    }
+
+    context.compressed_data.clear();
     context.state = PNGLoadingContext::State::BitmapDecoded;
     return true;
 }
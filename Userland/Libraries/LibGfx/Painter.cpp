@@ -26,10 +26,12 @@
 
 #include "Painter.h"
 #include "Bitmap.h"
+#include "Blending.h"
 #include "Emoji.h"
 #include "Font.h"
 #include "FontDatabase.h"
 #include "Gamma.h"
+#include "TextRunCache.h"
 #include <AK/Assertions.h>
 #include <AK/Debug.h>
 #include <AK/Function.h>
@@ -42,6 +44,7 @@
 #include <LibGfx/CharacterBitmap.h>
 #include <LibGfx/Palette.h>
 #include <LibGfx/Path.h>
+#include <LibGfx/PathRasterizer.h>
 #include <math.h>
 #include <stdio.h>
 
@@ -130,8 +133,7 @@ void Painter::fill_physical_rect(const IntRect& physical_rect, Color color)
     const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
 
     for (int i = physical_rect.height() - 1; i >= 0; --i) {
-        for (int j = 0; j < physical_rect.width(); ++j)
-            dst[j] = Color::from_rgba(dst[j]).blend(color).value();
+        blend_color_over_row(dst, physical_rect.width(), color);
         dst += dst_skip;
     }
 }
@@ -452,6 +454,45 @@ void Painter::draw_bitmap(const IntPoint& p, const GlyphBitmap& bitmap, Color co
     }
 }
 
+void Painter::draw_bitmap(const IntPoint& p, const GlyphCoverage& coverage, Color color)
+{
+    auto dst_rect = IntRect(p, coverage.size()).translated(translation());
+    auto clipped_rect = dst_rect.intersected(clip_rect());
+    if (clipped_rect.is_empty())
+        return;
+    const int first_row = clipped_rect.top() - dst_rect.top();
+    const int last_row = clipped_rect.bottom() - dst_rect.top();
+    const int first_column = clipped_rect.left() - dst_rect.left();
+    const int last_column = clipped_rect.right() - dst_rect.left();
+    const size_t width = last_column - first_column + 1;
+
+    int scale = this->scale();
+    RGBA32* dst = m_target->scanline(clipped_rect.y() * scale) + clipped_rect.x() * scale;
+    const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
+
+    if (scale == 1) {
+        for (int row = first_row; row <= last_row; ++row) {
+            blend_color_over_row_with_coverage(dst, coverage.scanline(row) + first_column, width, color);
+            dst += dst_skip;
+        }
+        return;
+    }
+
+    Vector<u8, 256> scaled_row;
+    scaled_row.resize(width * scale);
+    for (int row = first_row; row <= last_row; ++row) {
+        const u8* src = coverage.scanline(row) + first_column;
+        for (size_t j = 0; j < width; ++j) {
+            for (int ix = 0; ix < scale; ++ix)
+                scaled_row[j * scale + ix] = src[j];
+        }
+        for (int iy = 0; iy < scale; ++iy) {
+            blend_color_over_row_with_coverage(dst, scaled_row.data(), scaled_row.size(), color);
+            dst += dst_skip;
+        }
+    }
+}
+
 void Painter::draw_triangle(const IntPoint& a, const IntPoint& b, const IntPoint& c, Color color)
 {
     VERIFY(scale() == 1); // FIXME: Add scaling support.
@@ -555,31 +596,42 @@ void Painter::blit_with_opacity(const IntPoint& position, const Gfx::Bitmap& sou
     const RGBA32* src = source.scanline(src_rect.top() + first_row) + src_rect.left() + first_column;
     const unsigned src_skip = source.pitch() / sizeof(RGBA32);
 
-    auto do_blit = [&]<bool with_src_alpha>() {
+    const size_t width = last_column - first_column + 1;
+
+    if (!source.has_alpha_channel() || !apply_alpha) {
         for (int row = first_row; row <= last_row; ++row) {
-            for (int x = 0; x <= (last_column - first_column); ++x) {
-                if constexpr (with_src_alpha) {
-                    Color src_color_with_alpha = Color::from_rgba(src[x]);
-                    float pixel_opacity = src_color_with_alpha.alpha() / 255.0;
-                    src_color_with_alpha.set_alpha(255 * (opacity * pixel_opacity));
-                    dst[x] = Color::from_rgba(dst[x]).blend(src_color_with_alpha).value();
-                } else {
-                    Color src_color_with_alpha = Color::from_rgb(src[x]);
-                    src_color_with_alpha.set_alpha(alpha);
-                    dst[x] = Color::from_rgb(dst[x]).blend(src_color_with_alpha).value();
-                }
-            }
+            blend_row_with_opacity(dst, src, width, alpha);
             dst += dst_skip;
             src += src_skip;
         }
-    };
-    if (source.has_alpha_channel() && apply_alpha)
-        do_blit.template operator()<true>();
-    else
-        do_blit.template operator()<false>();
+        return;
+    }
+
+    // Scaling every source alpha by the opacity only has 256 possible outcomes, so work them out up front.
+    u8 alpha_table[256];
+    bool is_identity = true;
+    for (int i = 0; i < 256; ++i) {
+        float pixel_opacity = i / 255.0;
+        alpha_table[i] = 255 * (opacity * pixel_opacity);
+        is_identity &= alpha_table[i] == i;
+    }
+
+    for (int row = first_row; row <= last_row; ++row) {
+        if (is_identity)
+            blend_row(dst, src, width);
+        else
+            blend_row_with_alpha_table(dst, src, width, alpha_table);
+        dst += dst_skip;
+        src += src_skip;
+    }
 }
 
 void Painter::blit_filtered(const IntPoint& position, const Gfx::Bitmap& source, const IntRect& src_rect, Function<Color(Color)> filter)
+{
+    blit_filtered(position, source, src_rect, move(filter), nullptr);
+}
+
+void Painter::blit_filtered(const IntPoint& position, const Gfx::Bitmap& source, const IntRect& src_rect, Function<Color(Color)> filter, BlendRowFunction blend_row_function)
 {
     VERIFY((source.scale() == 1 || source.scale() == scale()) && "blit_filtered only supports integer upsampling");
 
@@ -606,6 +658,15 @@ void Painter::blit_filtered(const IntPoint& position, const Gfx::Bitmap& source,
         const RGBA32* src = source.scanline(safe_src_rect.top() + first_row) + safe_src_rect.left() + first_column;
         const size_t src_skip = source.pitch() / sizeof(RGBA32);
 
+        if (blend_row_function) {
+            for (int row = first_row; row <= last_row; ++row) {
+                blend_row_function(dst, src, last_column - first_column + 1);
+                dst += dst_skip;
+                src += src_skip;
+            }
+            return;
+        }
+
         for (int row = first_row; row <= last_row; ++row) {
             for (int x = 0; x <= (last_column - first_column); ++x) {
                 u8 alpha = Color::from_rgba(src[x]).alpha();
@@ -646,16 +707,20 @@ void Painter::blit_filtered(const IntPoint& position, const Gfx::Bitmap& source,
 
 void Painter::blit_brightened(const IntPoint& position, const Gfx::Bitmap& source, const IntRect& src_rect)
 {
-    return blit_filtered(position, source, src_rect, [](Color src) {
-        return src.lightened();
-    });
+    return blit_filtered(
+        position, source, src_rect, [](Color src) {
+            return src.lightened();
+        },
+        blend_row_brightened);
 }
 
 void Painter::blit_dimmed(const IntPoint& position, const Gfx::Bitmap& source, const IntRect& src_rect)
 {
-    return blit_filtered(position, source, src_rect, [](Color src) {
-        return src.to_grayscale().lightened();
-    });
+    return blit_filtered(
+        position, source, src_rect, [](Color src) {
+            return src.to_grayscale().lightened();
+        },
+        blend_row_dimmed);
 }
 
 void Painter::draw_tiled_bitmap(const IntRect& a_dst_rect, const Gfx::Bitmap& source)
@@ -799,6 +864,23 @@ ALWAYS_INLINE static void do_draw_integer_scaled_bitmap(Gfx::Bitmap& target, con
     }
 }
 
+template<bool has_alpha_channel>
+static void draw_scaled_row(RGBA32* dst, const RGBA32* row, size_t width, float opacity)
+{
+    if (opacity == 1.0f) {
+        if constexpr (has_alpha_channel)
+            blend_row(dst, row, width);
+        else
+            fast_u32_copy(dst, row, width);
+        return;
+    }
+
+    u8 alpha_table[256];
+    for (int i = 0; i < 256; ++i)
+        alpha_table[i] = i * opacity;
+    blend_row_with_alpha_table(dst, row, width, alpha_table);
+}
+
 template<bool has_alpha_channel, typename GetPixel>
 ALWAYS_INLINE static void do_draw_scaled_bitmap(Gfx::Bitmap& target, const IntRect& dst_rect, const IntRect& clipped_rect, const Gfx::Bitmap& source, const FloatRect& src_rect, GetPixel get_pixel, float opacity)
 {
@@ -815,34 +897,228 @@ ALWAYS_INLINE static void do_draw_scaled_bitmap(Gfx::Bitmap& target, const IntRe
         return do_draw_integer_scaled_bitmap<has_alpha_channel>(target, dst_rect, int_src_rect, source, hfactor, vfactor, get_pixel, opacity);
     }
 
-    bool has_opacity = opacity != 1.0f;
     int hscale = (src_rect.width() * (1 << 16)) / dst_rect.width();
     int vscale = (src_rect.height() * (1 << 16)) / dst_rect.height();
     int src_left = src_rect.left() * (1 << 16);
     int src_top = src_rect.top() * (1 << 16);
 
+    size_t width = clipped_rect.width();
+    Vector<int> scaled_xs;
+    scaled_xs.resize(width);
+    for (size_t i = 0; i < width; ++i)
+        scaled_xs[i] = ((clipped_rect.left() + (int)i - dst_rect.x()) * hscale + src_left) >> 16;
+
+    Vector<RGBA32> row;
+    row.resize(width);
     for (int y = clipped_rect.top(); y <= clipped_rect.bottom(); ++y) {
-        auto* scanline = (Color*)target.scanline(y);
-        for (int x = clipped_rect.left(); x <= clipped_rect.right(); ++x) {
-            auto scaled_x = ((x - dst_rect.x()) * hscale + src_left) >> 16;
-            auto scaled_y = ((y - dst_rect.y()) * vscale + src_top) >> 16;
-            auto src_pixel = get_pixel(source, scaled_x, scaled_y);
-            if (has_opacity)
-                src_pixel.set_alpha(src_pixel.alpha() * opacity);
-            if constexpr (has_alpha_channel) {
-                scanline[x] = scanline[x].blend(src_pixel);
-            } else
-                scanline[x] = src_pixel;
+        auto scaled_y = ((y - dst_rect.y()) * vscale + src_top) >> 16;
+        for (size_t i = 0; i < width; ++i)
+            row[i] = get_pixel(source, scaled_xs[i], scaled_y).value();
+        draw_scaled_row<has_alpha_channel>(target.scanline(y) + clipped_rect.left(), row.data(), width, opacity);
+    }
+}
+
+// Filtered scaling is done separably: every source row that's needed gets scaled horizontally once,
+// and the destination rows are then blended together from those. Which source pixels contribute to
+// each destination pixel, and how much, only depends on the coordinates, so that's worked out up
+// front for both axes. The weights are 14-bit fixed point numbers that add up to exactly 1.0.
+static constexpr int scaling_weight_bits = 14;
+
+struct ScalingContributors {
+    struct Span {
+        int first_source { 0 };
+        int count { 0 };
+        size_t weights_offset { 0 };
+    };
+
+    Vector<Span> spans;
+    Vector<i32> weights;
+    int max_count { 0 };
+};
+
+static ScalingContributors compute_scaling_contributors(Painter::ScalingMode mode, float source_start, float source_length, int source_min, int source_max, int destination_length, int first_destination, int last_destination)
+{
+    float scale = source_length / destination_length;
+    // When scaling down, the filter stretches to cover every source pixel that ends up in a destination pixel.
+    float filter_scale = max(scale, 1.0f);
+    float support = (mode == Painter::ScalingMode::BoxSampling ? 0.5f : 1.0f) * filter_scale;
+
+    auto filter = [&](float distance) {
+        float t = distance / filter_scale;
+        if (mode == Painter::ScalingMode::BoxSampling)
+            return (t >= -0.5f && t < 0.5f) ? 1.0f : 0.0f;
+        return max(0.0f, 1.0f - fabsf(t));
+    };
+
+    ScalingContributors contributors;
+    contributors.spans.ensure_capacity(last_destination - first_destination + 1);
+    Vector<float, 32> float_weights;
+    for (int destination = first_destination; destination <= last_destination; ++destination) {
+        float center = source_start + (destination + 0.5f) * scale;
+        int first = max(source_min, (int)floorf(center - support));
+        int last = min(source_max, (int)ceilf(center + support));
+
+        float_weights.clear_with_capacity();
+        float total = 0;
+        for (int source = first; source <= last; ++source) {
+            float weight = filter(source + 0.5f - center);
+            float_weights.append(weight);
+            total += weight;
+        }
+        // Trim pixels that don't contribute anything off both ends.
+        while (!float_weights.is_empty() && float_weights.last() == 0)
+            float_weights.take_last();
+        while (!float_weights.is_empty() && float_weights.first() == 0) {
+            float_weights.take_first();
+            ++first;
+        }
+        if (float_weights.is_empty()) {
+            first = max(source_min, min((int)center, source_max));
+            float_weights.append(1);
+            total = 1;
+        }
+
+        ScalingContributors::Span span { first, (int)float_weights.size(), contributors.weights.size() };
+        i32 fixed_total = 0;
+        size_t largest = 0;
+        for (size_t i = 0; i < float_weights.size(); ++i) {
+            i32 weight = roundf(float_weights[i] / total * (1 << scaling_weight_bits));
+            contributors.weights.append(weight);
+            fixed_total += weight;
+            if (weight > contributors.weights[span.weights_offset + largest])
+                largest = i;
+        }
+        // Rounding may leave the sum slightly off, so make up the difference with the largest weight.
+        contributors.weights[span.weights_offset + largest] += (1 << scaling_weight_bits) - fixed_total;
+
+        contributors.spans.append(span);
+        contributors.max_count = max(contributors.max_count, span.count);
+    }
+    return contributors;
+}
+
+static void fetch_source_row(const Gfx::Bitmap& source, int y, int first_x, int count, RGBA32* row)
+{
+    const RGBA32* scanline = source.scanline(y) + first_x;
+    switch (source.format()) {
+    case BitmapFormat::RGBA32:
+        fast_u32_copy(row, scanline, count);
+        break;
+    case BitmapFormat::RGB32:
+        for (int i = 0; i < count; ++i)
+            row[i] = scanline[i] | 0xff000000;
+        break;
+    default:
+        for (int i = 0; i < count; ++i)
+            row[i] = source.get_pixel(first_x + i, y).value();
+        break;
+    }
+}
+
+// Filtering happens on premultiplied colors, so transparent pixels don't bleed their color into their
+// neighbors. Every lane holds a channel multiplied by the alpha, and the alpha multiplied by 255.
+static void scale_row_horizontally(const Vector<AK::SIMD::i32x4>& premultiplied_row, int first_source_x, const ScalingContributors& contributors, AK::SIMD::i32x4* scaled_row)
+{
+    using AK::SIMD::i32x4;
+    for (size_t x = 0; x < contributors.spans.size(); ++x) {
+        auto& span = contributors.spans[x];
+        const i32x4* pixels = premultiplied_row.data() + (span.first_source - first_source_x);
+        const i32* weights = contributors.weights.data() + span.weights_offset;
+        i32x4 sum {};
+        for (int i = 0; i < span.count; ++i)
+            sum += pixels[i] * weights[i];
+        scaled_row[x] = (sum + (1 << (scaling_weight_bits - 1))) >> scaling_weight_bits;
+    }
+}
+
+template<bool has_alpha_channel>
+static void do_draw_filtered_scaled_bitmap(Gfx::Bitmap& target, const IntRect& dst_rect, const IntRect& clipped_rect, const Gfx::Bitmap& source, const FloatRect& src_rect, float opacity, Painter::ScalingMode mode)
+{
+    using AK::SIMD::i32x4;
+
+    // Only the source pixels inside src_rect can contribute.
+    int source_min_x = max(0, (int)floorf(src_rect.left()));
+    int source_max_x = min(source.physical_width() - 1, (int)ceilf(src_rect.x() + src_rect.width()) - 1);
+    int source_min_y = max(0, (int)floorf(src_rect.top()));
+    int source_max_y = min(source.physical_height() - 1, (int)ceilf(src_rect.y() + src_rect.height()) - 1);
+    if (source_min_x > source_max_x || source_min_y > source_max_y)
+        return;
+
+    auto columns = compute_scaling_contributors(mode, src_rect.x(), src_rect.width(), source_min_x, source_max_x, dst_rect.width(),
+        clipped_rect.left() - dst_rect.left(), clipped_rect.right() - dst_rect.left());
+    auto rows = compute_scaling_contributors(mode, src_rect.y(), src_rect.height(), source_min_y, source_max_y, dst_rect.height(),
+        clipped_rect.top() - dst_rect.top(), clipped_rect.bottom() - dst_rect.top());
+
+    int first_source_x = columns.spans.first().first_source;
+    int last_source_x = columns.spans.last().first_source + columns.spans.last().count - 1;
+    int source_width = last_source_x - first_source_x + 1;
+    size_t width = clipped_rect.width();
+
+    Vector<RGBA32> source_row;
+    source_row.resize(source_width);
+    Vector<i32x4> premultiplied_row;
+    premultiplied_row.resize(source_width);
+
+    // The horizontally scaled rows live in a ring buffer, since consecutive destination rows mostly use
+    // the same source rows, and each source row only needs to be scaled once.
+    int ring_size = rows.max_count;
+    Vector<i32x4> ring;
+    ring.resize(ring_size * width);
+    Vector<int> ring_source_rows;
+    ring_source_rows.resize(ring_size);
+    for (auto& row : ring_source_rows)
+        row = -1;
+
+    Vector<i32x4> sums;
+    sums.resize(width);
+    Vector<RGBA32> output_row;
+    output_row.resize(width);
+
+    for (int y = clipped_rect.top(); y <= clipped_rect.bottom(); ++y) {
+        auto& span = rows.spans[y - clipped_rect.top()];
+        const i32* weights = rows.weights.data() + span.weights_offset;
+
+        for (size_t x = 0; x < width; ++x)
+            sums[x] = i32x4 {};
+        for (int i = 0; i < span.count; ++i) {
+            int source_y = span.first_source + i;
+            i32x4* scaled_row = ring.data() + (source_y % ring_size) * width;
+            if (ring_source_rows[source_y % ring_size] != source_y) {
+                fetch_source_row(source, source_y, first_source_x, source_width, source_row.data());
+                for (int x = 0; x < source_width; ++x) {
+                    auto color = Color::from_rgba(source_row[x]);
+                    i32 alpha = color.alpha();
+                    premultiplied_row[x] = i32x4 { color.red() * alpha, color.green() * alpha, color.blue() * alpha, alpha * 255 };
+                }
+                scale_row_horizontally(premultiplied_row, first_source_x, columns, scaled_row);
+                ring_source_rows[source_y % ring_size] = source_y;
+            }
+            i32 weight = weights[i];
+            for (size_t x = 0; x < width; ++x)
+                sums[x] += scaled_row[x] * weight;
+        }
+
+        for (size_t x = 0; x < width; ++x) {
+            i32x4 pixel = (sums[x] + (1 << (scaling_weight_bits - 1))) >> scaling_weight_bits;
+            if (pixel[3] <= 0) {
+                output_row[x] = 0;
+                continue;
+            }
+            float unpremultiply = 255.0f / pixel[3];
+            auto channel = [&](int index) { return (u8)min(255, (int)(pixel[index] * unpremultiply + 0.5f)); };
+            output_row[x] = Color(channel(0), channel(1), channel(2), (pixel[3] + 127) / 255).value();
         }
+
+        draw_scaled_row<has_alpha_channel>(target.scanline(y) + clipped_rect.left(), output_row.data(), width, opacity);
     }
 }
 
-void Painter::draw_scaled_bitmap(const IntRect& a_dst_rect, const Gfx::Bitmap& source, const IntRect& a_src_rect, float opacity)
+void Painter::draw_scaled_bitmap(const IntRect& a_dst_rect, const Gfx::Bitmap& source, const IntRect& a_src_rect, float opacity, ScalingMode scaling_mode)
 {
-    draw_scaled_bitmap(a_dst_rect, source, FloatRect { a_src_rect }, opacity);
+    draw_scaled_bitmap(a_dst_rect, source, FloatRect { a_src_rect }, opacity, scaling_mode);
 }
 
-void Painter::draw_scaled_bitmap(const IntRect& a_dst_rect, const Gfx::Bitmap& source, const FloatRect& a_src_rect, float opacity)
+void Painter::draw_scaled_bitmap(const IntRect& a_dst_rect, const Gfx::Bitmap& source, const FloatRect& a_src_rect, float opacity, ScalingMode scaling_mode)
 {
     IntRect int_src_rect = enclosing_int_rect(a_src_rect);
     if (scale() == source.scale() && a_src_rect == int_src_rect && a_dst_rect.size() == int_src_rect.size())
@@ -854,6 +1130,14 @@ void Painter::draw_scaled_bitmap(const IntRect& a_dst_rect, const Gfx::Bitmap& s
     if (clipped_rect.is_empty())
         return;
 
+    if (scaling_mode != ScalingMode::NearestNeighbor) {
+        if (source.has_alpha_channel() || opacity != 1.0f)
+            do_draw_filtered_scaled_bitmap<true>(*m_target, dst_rect, clipped_rect, source, src_rect, opacity, scaling_mode);
+        else
+            do_draw_filtered_scaled_bitmap<false>(*m_target, dst_rect, clipped_rect, source, src_rect, opacity, scaling_mode);
+        return;
+    }
+
     if (source.has_alpha_channel() || opacity != 1.0f) {
         switch (source.format()) {
         case BitmapFormat::RGB32:
@@ -905,6 +1189,8 @@ FLATTEN void Painter::draw_glyph(const IntPoint& point, u32 code_point, const Fo
 
     if (glyph.is_glyph_bitmap()) {
         draw_bitmap(top_left, glyph.glyph_bitmap(), color);
+    } else if (glyph.is_glyph_coverage()) {
+        draw_bitmap(top_left, glyph.glyph_coverage(), color);
     } else {
         blit_filtered(top_left, *glyph.bitmap(), glyph.bitmap()->rect(), [color](Color pixel) -> Color {
             return pixel.multiply(color);
@@ -1128,6 +1414,24 @@ void do_draw_text(const IntRect& rect, const TextType& text, const Font& font, T
     }
 }
 
+// Text gets laid out in a rect of the same size at the origin, since where the glyphs go
+// relative to the rect doesn't depend on where the rect is.
+static const Vector<TextRunCache::Glyph>* cached_text_run(const StringView& text, const Font& font, const IntSize& size, TextAlignment alignment, TextElision elision)
+{
+    if (text.length() > TextRunCache::max_text_length)
+        return nullptr;
+
+    auto& cache = TextRunCache::the();
+    if (auto* glyphs = cache.find(text, font, size, alignment, elision))
+        return glyphs;
+
+    Vector<TextRunCache::Glyph> glyphs;
+    do_draw_text(IntRect { {}, size }, Utf8View(text), font, alignment, elision, [&](const IntRect& r, u32 code_point) {
+        glyphs.append({ r, code_point });
+    });
+    return &cache.add(text, font, size, alignment, elision, move(glyphs));
+}
+
 void Painter::draw_text(const IntRect& rect, const StringView& text, TextAlignment alignment, Color color, TextElision elision)
 {
     draw_text(rect, text, font(), alignment, color, elision);
@@ -1140,6 +1444,12 @@ void Painter::draw_text(const IntRect& rect, const Utf32View& text, TextAlignmen
 
 void Painter::draw_text(const IntRect& rect, const StringView& raw_text, const Font& font, TextAlignment alignment, Color color, TextElision elision)
 {
+    if (auto* glyphs = cached_text_run(raw_text, font, rect.size(), alignment, elision)) {
+        for (auto& glyph : *glyphs)
+            draw_glyph_or_emoji(glyph.rect.location().translated(rect.location()), glyph.code_point, font, color);
+        return;
+    }
+
     Utf8View text { raw_text };
     do_draw_text(rect, Utf8View(text), font, alignment, elision, [&](const IntRect& r, u32 code_point) {
         draw_glyph_or_emoji(r.location(), code_point, font, color);
@@ -1157,6 +1467,12 @@ void Painter::draw_text(Function<void(const IntRect&, u32)> draw_one_glyph, cons
 {
     VERIFY(scale() == 1); // FIXME: Add scaling support.
 
+    if (auto* glyphs = cached_text_run(raw_text, font, rect.size(), alignment, elision)) {
+        for (auto& glyph : *glyphs)
+            draw_one_glyph(glyph.rect.translated(rect.location()), glyph.code_point);
+        return;
+    }
+
     Utf8View text { raw_text };
     do_draw_text(rect, text, font, alignment, elision, [&](const IntRect& r, u32 code_point) {
         draw_one_glyph(r, code_point);
@@ -1167,6 +1483,12 @@ void Painter::draw_text(Function<void(const IntRect&, u32)> draw_one_glyph, cons
 {
     VERIFY(scale() == 1); // FIXME: Add scaling support.
 
+    if (auto* glyphs = cached_text_run(text.as_string(), font, rect.size(), alignment, elision)) {
+        for (auto& glyph : *glyphs)
+            draw_one_glyph(glyph.rect.translated(rect.location()), glyph.code_point);
+        return;
+    }
+
     do_draw_text(rect, text, font, alignment, elision, [&](const IntRect& r, u32 code_point) {
         draw_one_glyph(r, code_point);
     });
@@ -1374,46 +1696,27 @@ void Painter::draw_line(const IntPoint& p1, const IntPoint& p2, Color color, int
     }
 }
 
-static void split_quadratic_bezier_curve(const FloatPoint& original_control, const FloatPoint& p1, const FloatPoint& p2, Function<void(const FloatPoint&, const FloatPoint&)>& callback)
-{
-    auto po1_midpoint = original_control + p1;
-    po1_midpoint /= 2;
-
-    auto po2_midpoint = original_control + p2;
-    po2_midpoint /= 2;
-
-    auto new_segment = po1_midpoint + po2_midpoint;
-    new_segment /= 2;
-
-    Painter::for_each_line_segment_on_bezier_curve(po1_midpoint, p1, new_segment, callback);
-    Painter::for_each_line_segment_on_bezier_curve(po2_midpoint, new_segment, p2, callback);
-}
-
-static bool can_approximate_bezier_curve(const FloatPoint& p1, const FloatPoint& p2, const FloatPoint& control)
-{
-    constexpr static int tolerance = 15;
-
-    auto p1x = 3 * control.x() - 2 * p1.x() - p2.x();
-    auto p1y = 3 * control.y() - 2 * p1.y() - p2.y();
-    auto p2x = 3 * control.x() - 2 * p2.x() - p1.x();
-    auto p2y = 3 * control.y() - 2 * p2.y() - p1.y();
-
-    p1x = p1x * p1x;
-    p1y = p1y * p1y;
-    p2x = p2x * p2x;
-    p2y = p2y * p2y;
-
-    return max(p1x, p2x) + max(p1y, p2y) <= tolerance;
-}
+// How far flattened curves may stray from the real curve, in pixels. Anti-aliased edges show anything coarser.
+static constexpr float curve_flattening_tolerance = 0.2f;
 
 // static
 void Painter::for_each_line_segment_on_bezier_curve(const FloatPoint& control_point, const FloatPoint& p1, const FloatPoint& p2, Function<void(const FloatPoint&, const FloatPoint&)>& callback)
 {
-    if (can_approximate_bezier_curve(p1, p2, control_point)) {
-        callback(p1, p2);
-    } else {
-        split_quadratic_bezier_curve(control_point, p1, p2, callback);
+    // Split into n equal steps, a quadratic curve is at most |p1 - 2 * control + p2| / (4 * n^2) away from
+    // its chords, so pick the smallest n that keeps that within the tolerance.
+    auto deviation = p1 - control_point * 2 + p2;
+    float distance = sqrtf(deviation.x() * deviation.x() + deviation.y() * deviation.y());
+    int steps = max(1, (int)ceilf(sqrtf(distance / (4 * curve_flattening_tolerance))));
+
+    auto previous = p1;
+    for (int i = 1; i < steps; ++i) {
+        float t = (float)i / steps;
+        float u = 1 - t;
+        FloatPoint point { u * u * p1.x() + 2 * u * t * control_point.x() + t * t * p2.x(), u * u * p1.y() + 2 * u * t * control_point.y() + t * t * p2.y() };
+        callback(previous, point);
+        previous = point;
     }
+    callback(previous, p2);
 }
 
 void Painter::for_each_line_segment_on_bezier_curve(const FloatPoint& control_point, const FloatPoint& p1, const FloatPoint& p2, Function<void(const FloatPoint&, const FloatPoint&)>&& callback)
@@ -1421,45 +1724,6 @@ void Painter::for_each_line_segment_on_bezier_curve(const FloatPoint& control_po
     for_each_line_segment_on_bezier_curve(control_point, p1, p2, callback);
 }
 
-static void split_elliptical_arc(const FloatPoint& p1, const FloatPoint& p2, const FloatPoint& center, const FloatPoint radii, float x_axis_rotation, float theta_1, float theta_delta, Function<void(const FloatPoint&, const FloatPoint&)>& callback)
-{
-    auto half_theta_delta = theta_delta / 2;
-    auto theta_mid = theta_1 + half_theta_delta;
-
-    auto xc = cosf(x_axis_rotation);
-    auto xs = sinf(x_axis_rotation);
-    auto tc = cosf(theta_1 + half_theta_delta);
-    auto ts = sinf(theta_1 + half_theta_delta);
-
-    auto x2 = xc * radii.x() * tc - xs * radii.y() * ts + center.x();
-    auto y2 = xs * radii.x() * tc + xc * radii.y() * ts + center.y();
-
-    FloatPoint mid_point = { x2, y2 };
-
-    Painter::for_each_line_segment_on_elliptical_arc(p1, mid_point, center, radii, x_axis_rotation, theta_1, half_theta_delta, callback);
-    Painter::for_each_line_segment_on_elliptical_arc(mid_point, p2, center, radii, x_axis_rotation, theta_mid, half_theta_delta, callback);
-}
-
-static bool can_approximate_elliptical_arc(const FloatPoint& p1, const FloatPoint& p2, const FloatPoint& center, const FloatPoint radii, float x_axis_rotation, float theta_1, float theta_delta)
-{
-    constexpr static float tolerance = 1;
-
-    auto half_theta_delta = theta_delta / 2.0f;
-
-    auto xc = cosf(x_axis_rotation);
-    auto xs = sinf(x_axis_rotation);
-    auto tc = cosf(theta_1 + half_theta_delta);
-    auto ts = sinf(theta_1 + half_theta_delta);
-
-    auto x2 = xc * radii.x() * tc - xs * radii.y() * ts + center.x();
-    auto y2 = xs * radii.x() * tc + xc * radii.y() * ts + center.y();
-
-    auto ellipse_mid_point = FloatPoint { x2, y2 };
-    auto line_mid_point = p1 + (p2 - p1) / 2.0f;
-
-    return ellipse_mid_point.distance_from(line_mid_point) < tolerance;
-}
-
 void Painter::draw_quadratic_bezier_curve(const IntPoint& control_point, const IntPoint& p1, const IntPoint& p2, Color color, int thickness, LineStyle style)
 {
     VERIFY(scale() == 1); // FIXME: Add scaling support.
@@ -1472,11 +1736,24 @@ void Painter::draw_quadratic_bezier_curve(const IntPoint& control_point, const I
 // static
 void Painter::for_each_line_segment_on_elliptical_arc(const FloatPoint& p1, const FloatPoint& p2, const FloatPoint& center, const FloatPoint radii, float x_axis_rotation, float theta_1, float theta_delta, Function<void(const FloatPoint&, const FloatPoint&)>& callback)
 {
-    if (can_approximate_elliptical_arc(p1, p2, center, radii, x_axis_rotation, theta_1, theta_delta)) {
-        callback(p1, p2);
-    } else {
-        split_elliptical_arc(p1, p2, center, radii, x_axis_rotation, theta_1, theta_delta, callback);
+    // A chord spanning an angle of a on a circle of radius r is r * (1 - cos(a / 2)) away from it at most.
+    // Using the larger radius of the ellipse keeps every step within the tolerance.
+    float radius = max(fabsf(radii.x()), fabsf(radii.y()));
+    float max_step = radius > curve_flattening_tolerance ? 2 * acosf(1 - curve_flattening_tolerance / radius) : (float)M_PI / 2;
+    int steps = max(1, (int)ceilf(fabsf(theta_delta) / max_step));
+
+    auto xc = cosf(x_axis_rotation);
+    auto xs = sinf(x_axis_rotation);
+    auto previous = p1;
+    for (int i = 1; i < steps; ++i) {
+        float theta = theta_1 + theta_delta * i / steps;
+        auto tc = cosf(theta);
+        auto ts = sinf(theta);
+        FloatPoint point { xc * radii.x() * tc - xs * radii.y() * ts + center.x(), xs * radii.x() * tc + xc * radii.y() * ts + center.y() };
+        callback(previous, point);
+        previous = point;
     }
+    callback(previous, p2);
 }
 
 // static
@@ -1549,166 +1826,49 @@ void Painter::stroke_path(const Path& path, Color color, int thickness)
     }
 }
 
-[[maybe_unused]] static void approximately_place_on_int_grid(FloatPoint ffrom, FloatPoint fto, IntPoint& from, IntPoint& to, Optional<IntPoint> previous_to)
-{
-    auto diffs = fto - ffrom;
-    // Truncate all first (round down).
-    from = ffrom.to_type<int>();
-    to = fto.to_type<int>();
-    // There are 16 possible configurations, by deciding to round each
-    // coord up or down (and there are four coords, from.x from.y to.x to.y)
-    // we will simply choose one which most closely matches the correct slope
-    // with the following heuristic:
-    // - if the x diff is positive or zero (that is, a right-to-left slant), round 'from.x' up and 'to.x' down.
-    // - if the x diff is negative         (that is, a left-to-right slant), round 'from.x' down and 'to.x' up.
-    // Note that we do not need to touch the 'y' attribute, as that is our scanline.
-    if (diffs.x() >= 0) {
-        from.set_x(from.x() + 1);
-    } else {
-        to.set_x(to.x() + 1);
-    }
-    if (previous_to.has_value() && from.x() != previous_to.value().x()) // The points have to line up, since we're using these lines to fill a shape.
-        from.set_x(previous_to.value().x());
-}
-
 void Painter::fill_path(Path& path, Color color, WindingRule winding_rule)
 {
     VERIFY(scale() == 1); // FIXME: Add scaling support.
 
-    const auto& segments = path.split_lines();
-
-    if (segments.size() == 0)
+    if (path.segments().is_empty() || color.alpha() == 0)
         return;
 
-    Vector<Path::SplitLineSegment> active_list;
-    active_list.ensure_capacity(segments.size());
-
-    // first, grab the segments for the very first scanline
-    int first_y = path.bounding_box().bottom_right().y() + 1;
-    int last_y = path.bounding_box().top_left().y() - 1;
-    float scanline = first_y;
-
-    size_t last_active_segment { 0 };
-
-    for (auto& segment : segments) {
-        if (segment.maximum_y != scanline)
-            break;
-        active_list.append(segment);
-        ++last_active_segment;
-    }
-
-    auto is_inside_shape = [winding_rule](int winding_number) {
-        if (winding_rule == WindingRule::Nonzero)
-            return winding_number != 0;
-
-        if (winding_rule == WindingRule::EvenOdd)
-            return winding_number % 2 == 0;
-
-        VERIFY_NOT_REACHED();
-    };
-
-    auto increment_winding = [winding_rule](int& winding_number, const IntPoint& from, const IntPoint& to) {
-        if (winding_rule == WindingRule::EvenOdd) {
-            ++winding_number;
-            return;
-        }
-
-        if (winding_rule == WindingRule::Nonzero) {
-            if (from.dy_relative_to(to) < 0)
-                ++winding_number;
-            else
-                --winding_number;
-            return;
-        }
-
-        VERIFY_NOT_REACHED();
-    };
+    auto bounds = enclosing_int_rect(path.bounding_box().translated(translation().to_type<float>())).inflated(2, 2).intersected(clip_rect());
+    if (bounds.is_empty())
+        return;
 
-    while (scanline >= last_y) {
-        Optional<IntPoint> previous_to;
-        if (active_list.size()) {
-            // sort the active list by 'x' from right to left
-            quick_sort(active_list, [](const auto& line0, const auto& line1) {
-                return line1.x < line0.x;
-            });
-#if FILL_PATH_DEBUG
-            if ((int)scanline % 10 == 0) {
-                draw_text(IntRect(active_list.last().x - 20, scanline, 20, 10), String::number((int)scanline));
+    PathRasterizer rasterizer(bounds);
+    rasterizer.add_path(path, translation().to_type<float>());
+    rasterizer.for_each_span(winding_rule, [&](int x, int y, ReadonlyBytes coverage) {
+        RGBA32* dst = m_target->scanline(y) + x;
+        for (size_t i = 0; i < coverage.size();) {
+            if (coverage[i] == 0) {
+                ++i;
+                continue;
             }
-#endif
-
-            if (active_list.size() > 1) {
-                auto winding_number { 0 };
-                for (size_t i = 1; i < active_list.size(); ++i) {
-                    auto& previous = active_list[i - 1];
-                    auto& current = active_list[i];
-
-                    IntPoint from, to;
-                    IntPoint truncated_from { previous.x, scanline };
-                    IntPoint truncated_to { current.x, scanline };
-                    approximately_place_on_int_grid({ previous.x, scanline }, { current.x, scanline }, from, to, previous_to);
-
-                    if (is_inside_shape(winding_number)) {
-                        // The points between this segment and the previous are
-                        // inside the shape
-
-                        dbgln_if(FILL_PATH_DEBUG, "y={}: {} at {}: {} -- {}", scanline, winding_number, i, from, to);
-                        draw_line(from, to, color, 1);
-                    }
-
-                    auto is_passing_through_maxima = scanline == previous.maximum_y
-                        || scanline == previous.minimum_y
-                        || scanline == current.maximum_y
-                        || scanline == current.minimum_y;
-
-                    auto is_passing_through_vertex = false;
-
-                    if (is_passing_through_maxima) {
-                        is_passing_through_vertex = previous.x == current.x;
-                    }
-
-                    if (!is_passing_through_vertex || previous.inverse_slope * current.inverse_slope < 0)
-                        increment_winding(winding_number, truncated_from, truncated_to);
-
-                    // update the x coord
-                    active_list[i - 1].x -= active_list[i - 1].inverse_slope;
+            if (coverage[i] < 255 || draw_op() != DrawOp::Copy) {
+                if (draw_op() != DrawOp::Copy) {
+                    // There's no sensible way to anti-alias XOR and friends.
+                    if (coverage[i] >= 128)
+                        set_physical_pixel_with_draw_op(dst[i], color);
+                } else {
+                    dst[i] = Color::from_rgba(dst[i]).blend(color.with_alpha(color.alpha() * coverage[i] / 255)).value();
                 }
-                active_list.last().x -= active_list.last().inverse_slope;
-            } else {
-                auto point = IntPoint(active_list[0].x, scanline);
-                draw_line(point, point, color);
-
-                // update the x coord
-                active_list.first().x -= active_list.first().inverse_slope;
-            }
-        }
-
-        --scanline;
-        // remove any edge that goes out of bound from the active list
-        for (size_t i = 0, count = active_list.size(); i < count; ++i) {
-            if (scanline <= active_list[i].minimum_y) {
-                active_list.remove(i);
-                --count;
-                --i;
-            }
-        }
-        for (size_t j = last_active_segment; j < segments.size(); ++j, ++last_active_segment) {
-            auto& segment = segments[j];
-            if (segment.maximum_y < scanline)
-                break;
-            if (segment.minimum_y >= scanline)
+                ++i;
                 continue;
+            }
 
-            active_list.append(segment);
+            // Fully covered runs of pixels in the interior of the shape get filled all at once.
+            size_t run_end = i + 1;
+            while (run_end < coverage.size() && coverage[run_end] == 255)
+                ++run_end;
+            if (color.alpha() == 255)
+                fast_u32_fill(dst + i, color.value(), run_end - i);
+            else
+                blend_color_over_row(dst + i, run_end - i, color);
+            i = run_end;
         }
-    }
-
-#if FILL_PATH_DEBUG
-    size_t i { 0 };
-    for (auto& segment : segments) {
-        draw_line(Point<int>(segment.from), Point<int>(segment.to), Color::from_hsv(i++ * 360.0 / segments.size(), 1.0, 1.0), 1);
-    }
-#endif
+    });
 }
 
 void Painter::blit_disabled(const IntPoint& location, const Gfx::Bitmap& bitmap, const IntRect& rect, const Palette& palette)
@@ -50,6 +50,17 @@ public:
         Dashed,
     };
 
+    enum class ScalingMode {
+        // Copies the closest source pixel. Fast, and keeps pixel art crisp.
+        NearestNeighbor,
+        // Interpolates between neighboring source pixels, and averages over all the pixels a
+        // destination pixel covers when scaling down.
+        BilinearBlend,
+        // Averages the source pixels each destination pixel covers. The best choice for scaling
+        // down, and gives nearest neighbor results with smoothed edges when scaling up.
+        BoxSampling,
+    };
+
     void clear_rect(const IntRect&, Color);
     void fill_rect(const IntRect&, Color);
     void fill_rect_with_dither_pattern(const IntRect&, Color, Color);
@@ -61,8 +72,9 @@ public:
     void draw_focus_rect(const IntRect&, Color);
     void draw_bitmap(const IntPoint&, const CharacterBitmap&, Color = Color());
     void draw_bitmap(const IntPoint&, const GlyphBitmap&, Color = Color());
-    void draw_scaled_bitmap(const IntRect& dst_rect, const Gfx::Bitmap&, const IntRect& src_rect, float opacity = 1.0f);
-    void draw_scaled_bitmap(const IntRect& dst_rect, const Gfx::Bitmap&, const FloatRect& src_rect, float opacity = 1.0f);
+    void draw_bitmap(const IntPoint&, const GlyphCoverage&, Color = Color());
+    void draw_scaled_bitmap(const IntRect& dst_rect, const Gfx::Bitmap&, const IntRect& src_rect, float opacity = 1.0f, ScalingMode = ScalingMode::NearestNeighbor);
+    void draw_scaled_bitmap(const IntRect& dst_rect, const Gfx::Bitmap&, const FloatRect& src_rect, float opacity = 1.0f, ScalingMode = ScalingMode::NearestNeighbor);
     void draw_triangle(const IntPoint&, const IntPoint&, const IntPoint&, Color);
     void draw_ellipse_intersecting(const IntRect&, Color, int thickness = 1);
     void set_pixel(const IntPoint&, Color);
@@ -140,6 +152,10 @@ protected:
     void fill_physical_scanline_with_draw_op(int y, int x, int width, const Color& color);
     void fill_rect_with_draw_op(const IntRect&, Color);
     void blit_with_opacity(const IntPoint&, const Gfx::Bitmap&, const IntRect& src_rect, float opacity, bool apply_alpha = true);
+
+    // Does the same as the filter for whole rows at a time, when the bitmap doesn't need to be scaled up.
+    using BlendRowFunction = void (*)(RGBA32* dst, const RGBA32* src, size_t count);
+    void blit_filtered(const IntPoint&, const Gfx::Bitmap&, const IntRect& src_rect, Function<Color(Color)>, BlendRowFunction);
     void draw_physical_pixel(const IntPoint&, Color, int thickness = 1);
 
     struct State {
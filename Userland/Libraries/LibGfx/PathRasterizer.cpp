@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/QuickSort.h>
+#include <LibGfx/Path.h>
+#include <LibGfx/PathRasterizer.h>
+#include <math.h>
+
+namespace Gfx {
+
+PathRasterizer::PathRasterizer(const IntRect& bounds)
+    : m_bounds(bounds)
+{
+}
+
+void PathRasterizer::add_line(const FloatPoint& from, const FloatPoint& to)
+{
+    auto origin = m_bounds.location().to_type<float>();
+    auto a = from - origin;
+    auto b = to - origin;
+
+    // Horizontal lines don't change the winding of anything, and lines above or below the bounds can't either.
+    if (a.y() == b.y())
+        return;
+    if (max(a.y(), b.y()) <= 0 || min(a.y(), b.y()) >= m_bounds.height())
+        return;
+
+    // The parts of the line to the left and right of the bounds still change the winding of the pixels to
+    // their right, so they get moved onto the nearest vertical edge of the bounds instead of being dropped.
+    float width = m_bounds.width();
+    float crossings[2];
+    size_t crossing_count = 0;
+    for (float boundary : { 0.0f, width }) {
+        if ((a.x() - boundary) * (b.x() - boundary) < 0)
+            crossings[crossing_count++] = (boundary - a.x()) / (b.x() - a.x());
+    }
+    if (crossing_count == 2 && crossings[0] > crossings[1])
+        swap(crossings[0], crossings[1]);
+
+    auto clamped = [&](const FloatPoint& point) {
+        return FloatPoint { min(max(point.x(), 0.0f), width), point.y() };
+    };
+
+    auto piece_start = a;
+    for (size_t i = 0; i < crossing_count; ++i) {
+        auto crossing = a + (b - a) * crossings[i];
+        add_edge(clamped(piece_start), clamped(crossing));
+        piece_start = crossing;
+    }
+    add_edge(clamped(piece_start), clamped(b));
+}
+
+void PathRasterizer::add_edge(const FloatPoint& from, const FloatPoint& to)
+{
+    if (from.y() == to.y())
+        return;
+    auto& top = from.y() < to.y() ? from : to;
+    auto& bottom = from.y() < to.y() ? to : from;
+    m_edges.append({ top.x(), top.y(), bottom.y(), (bottom.x() - top.x()) / (bottom.y() - top.y()), from.y() < to.y() ? 1.0f : -1.0f });
+}
+
+void PathRasterizer::add_path(const Path& path, const FloatPoint& offset)
+{
+    FloatPoint cursor;
+    FloatPoint subpath_start;
+    Function<void(const FloatPoint&, const FloatPoint&)> add_line_with_offset = [&](const FloatPoint& from, const FloatPoint& to) {
+        add_line(from + offset, to + offset);
+    };
+
+    for (auto& segment : path.segments()) {
+        switch (segment.type()) {
+        case Segment::Type::MoveTo:
+            add_line_with_offset(cursor, subpath_start);
+            subpath_start = segment.point();
+            break;
+        case Segment::Type::LineTo:
+            add_line_with_offset(cursor, segment.point());
+            break;
+        case Segment::Type::QuadraticBezierCurveTo: {
+            auto& control = static_cast<const QuadraticBezierCurveSegment&>(segment).through();
+            Painter::for_each_line_segment_on_bezier_curve(control, cursor, segment.point(), add_line_with_offset);
+            break;
+        }
+        case Segment::Type::EllipticalArcTo: {
+            auto& arc = static_cast<const EllipticalArcSegment&>(segment);
+            Painter::for_each_line_segment_on_elliptical_arc(cursor, arc.point(), arc.center(), arc.radii(), arc.x_axis_rotation(), arc.theta_1(), arc.theta_delta(), add_line_with_offset);
+            break;
+        }
+        case Segment::Type::Invalid:
+            VERIFY_NOT_REACHED();
+        }
+        cursor = segment.point();
+    }
+    add_line_with_offset(cursor, subpath_start);
+}
+
+// Adds the area an edge covers within one row (from x0 to x1, spanning signed_height of the row) to the
+// accumulators. The running sum over a row then goes from 0 to signed_height across the edge.
+void PathRasterizer::accumulate(float x0, float x1, float signed_height)
+{
+    if (x0 > x1)
+        swap(x0, x1);
+
+    float x0_floor = floorf(x0);
+    int x0i = x0_floor;
+    int x1i = ceilf(x1);
+    m_touched_min_x = min(m_touched_min_x, x0i);
+    m_touched_max_x = max(m_touched_max_x, max(x1i, x0i + 1));
+
+    auto& accumulators = m_accumulators;
+    if (x1i <= x0i + 1) {
+        // The edge stays within one pixel, which gets the part of the area left of the edge's midpoint.
+        float midpoint = 0.5f * (x0 + x1) - x0_floor;
+        accumulators[x0i] += signed_height * (1 - midpoint);
+        accumulators[x0i + 1] += signed_height * midpoint;
+        return;
+    }
+
+    float slope = 1 / (x1 - x0);
+    float x0_fraction = x0 - x0_floor;
+    float first_area = 0.5f * slope * (1 - x0_fraction) * (1 - x0_fraction);
+    float x1_fraction = x1 - x1i + 1;
+    float last_area = 0.5f * slope * x1_fraction * x1_fraction;
+
+    accumulators[x0i] += signed_height * first_area;
+    if (x1i == x0i + 2) {
+        accumulators[x0i + 1] += signed_height * (1 - first_area - last_area);
+    } else {
+        float second_area = slope * (1.5f - x0_fraction);
+        accumulators[x0i + 1] += signed_height * (second_area - first_area);
+        for (int x = x0i + 2; x < x1i - 1; ++x)
+            accumulators[x] += signed_height * slope;
+        float area_before_last = second_area + (x1i - x0i - 3) * slope;
+        accumulators[x1i - 1] += signed_height * (1 - area_before_last - last_area);
+    }
+    accumulators[x1i] += signed_height * last_area;
+}
+
+void PathRasterizer::for_each_span(Painter::WindingRule winding_rule, Function<void(int x, int y, ReadonlyBytes coverage)> callback)
+{
+    if (m_edges.is_empty() || m_bounds.is_empty())
+        return;
+
+    quick_sort(m_edges, [](auto& a, auto& b) { return a.top < b.top; });
+
+    int width = m_bounds.width();
+    // Edges on the right end of the bounds reach one past it.
+    m_accumulators.resize(width + 2);
+    for (auto& accumulator : m_accumulators)
+        accumulator = 0;
+    Vector<u8> coverage;
+    coverage.resize(width);
+
+    auto coverage_for_winding = [winding_rule](float winding) -> u8 {
+        float amount = fabsf(winding);
+        if (winding_rule == Painter::WindingRule::EvenOdd) {
+            amount = fmodf(amount, 2);
+            if (amount > 1)
+                amount = 2 - amount;
+        } else if (amount > 1) {
+            amount = 1;
+        }
+        return amount * 255 + 0.5f;
+    };
+
+    auto clamp_to_width = [width](float x) {
+        return min(max(x, 0.0f), (float)width);
+    };
+
+    Vector<size_t> active_edges;
+    size_t next_edge = 0;
+    for (int y = max(0, (int)floorf(m_edges.first().top)); y < m_bounds.height(); ++y) {
+        while (next_edge < m_edges.size() && m_edges[next_edge].top < y + 1)
+            active_edges.append(next_edge++);
+
+        if (active_edges.is_empty()) {
+            if (next_edge == m_edges.size())
+                break;
+            // Skip ahead to the next row with edges in it.
+            y = (int)floorf(m_edges[next_edge].top) - 1;
+            continue;
+        }
+
+        m_touched_min_x = width + 1;
+        m_touched_max_x = -1;
+        for (size_t i = 0; i < active_edges.size();) {
+            auto& edge = m_edges[active_edges[i]];
+            if (edge.bottom <= y) {
+                active_edges[i] = active_edges.last();
+                active_edges.take_last();
+                continue;
+            }
+            ++i;
+
+            float top = max(edge.top, (float)y);
+            float bottom = min(edge.bottom, (float)y + 1);
+            if (bottom <= top)
+                continue;
+            // Nearly horizontal edges have huge slopes, so rounding errors can put these a long way outside the bounds.
+            float x_at_top = clamp_to_width(edge.x_at_top + (top - edge.top) * edge.dxdy);
+            float x_at_bottom = clamp_to_width(edge.x_at_top + (bottom - edge.top) * edge.dxdy);
+            accumulate(x_at_top, x_at_bottom, (bottom - top) * edge.direction);
+        }
+        if (m_touched_max_x < 0)
+            continue;
+
+        // Sum up the row from the first touched pixel, until nothing is covered past the last touched one.
+        float winding = 0;
+        int x = m_touched_min_x;
+        for (; x < width; ++x) {
+            if (x <= m_touched_max_x) {
+                winding += m_accumulators[x];
+                m_accumulators[x] = 0;
+            }
+            u8 value = coverage_for_winding(winding);
+            if (x > m_touched_max_x && !value)
+                break;
+            coverage[x - m_touched_min_x] = value;
+        }
+        for (int i = max(x, m_touched_min_x); i <= m_touched_max_x; ++i)
+            m_accumulators[i] = 0;
+
+        if (x > m_touched_min_x)
+            callback(m_bounds.x() + m_touched_min_x, m_bounds.y() + y, coverage.span().slice(0, x - m_touched_min_x));
+    }
+
+    m_edges.clear();
+}
+
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Function.h>
+#include <AK/Span.h>
+#include <AK/Vector.h>
+#include <LibGfx/Forward.h>
+#include <LibGfx/Painter.h>
+#include <LibGfx/Point.h>
+#include <LibGfx/Rect.h>
+
+namespace Gfx {
+
+// Works out how much of every pixel an outline covers, for anti-aliased filling.
+//
+// Each edge adds the signed area it covers in every pixel it passes through to a row of
+// accumulators; a running sum over the row then gives the winding number of each pixel,
+// with fractions along the edges. Only the rows and columns edges actually touch get
+// visited, so large, mostly empty bounds don't cost anything.
+class PathRasterizer {
+public:
+    // Coverage is only computed for the pixels inside bounds.
+    explicit PathRasterizer(const IntRect& bounds);
+
+    void add_line(const FloatPoint& from, const FloatPoint& to);
+
+    // Subpaths are closed implicitly, like filling requires.
+    void add_path(const Path&, const FloatPoint& offset = {});
+
+    // Calls the callback with the coverage (0-255) of a run of pixels starting at (x, y), once per
+    // row that has anything in it. Pixels outside of these runs aren't covered at all.
+    void for_each_span(Painter::WindingRule, Function<void(int x, int y, ReadonlyBytes coverage)>);
+
+private:
+    struct Edge {
+        float x_at_top;
+        float top;
+        float bottom;
+        float dxdy;
+        // +1 for edges that go down, -1 for edges that go up.
+        float direction;
+    };
+
+    void add_edge(const FloatPoint& from, const FloatPoint& to);
+    void accumulate(float x0, float x1, float signed_height);
+
+    IntRect m_bounds;
+    Vector<Edge> m_edges;
+    Vector<float> m_accumulators;
+    int m_touched_min_x { 0 };
+    int m_touched_max_x { 0 };
+};
+
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/QuickSort.h>
+#include <LibGfx/TextRunCache.h>
+
+namespace Gfx {
+
+unsigned TextRunKey::hash(const StringView& text, const Font& font, const IntSize& size, TextAlignment alignment, TextElision elision)
+{
+    unsigned hash = pair_int_hash(string_hash(text.characters_without_null_termination(), text.length()), ptr_hash(&font));
+    hash = pair_int_hash(hash, pair_int_hash(size.width(), size.height()));
+    return pair_int_hash(hash, pair_int_hash((u32)alignment, (u32)elision));
+}
+
+bool TextRunKey::matches(const StringView& other_text, const Font& other_font, const IntSize& other_size, TextAlignment other_alignment, TextElision other_elision) const
+{
+    return font == &other_font && size == other_size && alignment == other_alignment && elision == other_elision && text == other_text;
+}
+
+TextRunCache& TextRunCache::the()
+{
+    static TextRunCache cache;
+    return cache;
+}
+
+const Vector<TextRunCache::Glyph>* TextRunCache::find(const StringView& text, const Font& font, const IntSize& size, TextAlignment alignment, TextElision elision)
+{
+    auto it = m_runs.find(TextRunKey::hash(text, font, size, alignment, elision), [&](auto& entry) {
+        return entry.key.matches(text, font, size, alignment, elision);
+    });
+    if (it == m_runs.end())
+        return nullptr;
+    it->value.last_used = ++m_clock;
+    return &it->value.glyphs;
+}
+
+const Vector<TextRunCache::Glyph>& TextRunCache::add(const StringView& text, const Font& font, const IntSize& size, TextAlignment alignment, TextElision elision, Vector<Glyph>&& glyphs)
+{
+    if (m_runs.size() >= capacity)
+        evict_least_recently_used();
+
+    TextRunKey key { text, &font, size, alignment, elision };
+    m_runs.set(key, { const_cast<Font&>(font), move(glyphs), ++m_clock });
+    return m_runs.find(key)->value.glyphs;
+}
+
+void TextRunCache::evict_least_recently_used()
+{
+    // Throwing out the older half at once keeps this from happening on every add().
+    Vector<u64> last_used;
+    last_used.ensure_capacity(m_runs.size());
+    for (auto& it : m_runs)
+        last_used.append(it.value.last_used);
+    quick_sort(last_used);
+    u64 oldest_to_keep = last_used[last_used.size() / 2];
+
+    Vector<TextRunKey> keys_to_remove;
+    for (auto& it : m_runs) {
+        if (it.value.last_used < oldest_to_keep)
+            keys_to_remove.append(it.key);
+    }
+    for (auto& key : keys_to_remove)
+        m_runs.remove(key);
+}
+
+void TextRunCache::forget(const Font& font)
+{
+    Vector<TextRunKey> keys_to_remove;
+    for (auto& it : m_runs) {
+        if (it.key.font == &font)
+            keys_to_remove.append(it.key);
+    }
+    for (auto& key : keys_to_remove)
+        m_runs.remove(key);
+}
+
+}
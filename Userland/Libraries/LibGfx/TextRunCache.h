@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/HashMap.h>
+#include <AK/NonnullRefPtr.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
+#include <LibGfx/Font.h>
+#include <LibGfx/Rect.h>
+#include <LibGfx/TextAlignment.h>
+#include <LibGfx/TextElision.h>
+
+namespace Gfx {
+
+struct TextRunKey {
+    String text;
+    const Font* font { nullptr };
+    IntSize size;
+    TextAlignment alignment;
+    TextElision elision;
+
+    static unsigned hash(const StringView& text, const Font&, const IntSize&, TextAlignment, TextElision);
+    bool matches(const StringView& text, const Font&, const IntSize&, TextAlignment, TextElision) const;
+    bool operator==(const TextRunKey& other) const { return other.matches(text, *font, size, alignment, elision); }
+};
+
+}
+
+namespace AK {
+
+template<>
+struct Traits<Gfx::TextRunKey> : public GenericTraits<Gfx::TextRunKey> {
+    static unsigned hash(const Gfx::TextRunKey& key) { return Gfx::TextRunKey::hash(key.text, *key.font, key.size, key.alignment, key.elision); }
+};
+
+}
+
+namespace Gfx {
+
+// Remembers where Painter::draw_text() put the glyphs of recently drawn text, since widgets tend
+// to draw the same labels over and over again. Laying out text means measuring it (more than once
+// when it gets elided), which is a lot more work than looking it up here.
+class TextRunCache {
+public:
+    struct Glyph {
+        // Relative to the top left corner of the rect the text was laid out in.
+        IntRect rect;
+        u32 code_point { 0 };
+    };
+
+    static constexpr size_t capacity = 512;
+    // Longer texts are rarely drawn more than once, so they aren't worth keeping.
+    static constexpr size_t max_text_length = 512;
+
+    static TextRunCache& the();
+
+    // Returns nullptr if the text hasn't been laid out in a rect of this size yet.
+    const Vector<Glyph>* find(const StringView& text, const Font&, const IntSize&, TextAlignment, TextElision);
+    const Vector<Glyph>& add(const StringView& text, const Font&, const IntSize&, TextAlignment, TextElision, Vector<Glyph>&&);
+
+    // Fonts whose metrics change (like in FontEditor) have to drop their laid out text.
+    void forget(const Font&);
+
+    size_t size() const { return m_runs.size(); }
+
+private:
+    TextRunCache() { }
+
+    void evict_least_recently_used();
+
+    struct Run {
+        // Keeps the font alive, so no other font can take its place (and key) while this is cached.
+        NonnullRefPtr<Font> font;
+        Vector<Glyph> glyphs;
+        u64 last_used { 0 };
+    };
+
+    HashMap<TextRunKey, Run> m_runs;
+    u64 m_clock { 0 };
+};
+
+}
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Debug.h>
+#include <AK/HashMap.h>
+#include <AK/NonnullRefPtr.h>
+#include <AK/String.h>
+#include <AK/URL.h>
+#include <AK/Vector.h>
+#include <LibCore/ElapsedTimer.h>
+#include <LibCore/TCPSocket.h>
+#include <LibTLS/TLSv12.h>
+
+namespace HTTP {
+
+// Keeps connections that the server left open after a response (HTTP/1.1 keep-alive) around for a while,
+// so that later requests to the same origin can skip the DNS lookup and the TCP and TLS handshakes.
+// There is one pool per socket type in each process.
+template<typename SocketType>
+class ConnectionPool {
+public:
+    static constexpr size_t max_idle_connections_per_origin = 6;
+
+    // Servers commonly close idle connections after 5 to 15 seconds. Requests sent on a connection
+    // that's just being closed have to be retried, so don't hand out connections that are older than that.
+    static constexpr int max_idle_time_ms = 10000;
+
+    struct Statistics {
+        size_t connections_opened { 0 };
+        size_t connections_reused { 0 };
+        size_t connections_discarded { 0 };
+    };
+
+    static ConnectionPool& the()
+    {
+        static ConnectionPool pool;
+        return pool;
+    }
+
+    // Hands out an idle connection to the origin of the URL, or null if the caller has to open a new one.
+    RefPtr<SocketType> take(const URL& url)
+    {
+        auto origin = origin_of(url);
+        auto it = m_idle_connections.find(origin);
+        if (it != m_idle_connections.end()) {
+            auto& connections = it->value;
+            // Prefer the most recently used connection, it's the least likely one to have been closed by the server.
+            while (!connections.is_empty()) {
+                auto connection = connections.take_last();
+                stop_watching(*connection.socket);
+                if (connection.idle_timer.elapsed() > max_idle_time_ms || !is_usable(*connection.socket)) {
+                    ++m_statistics.connections_discarded;
+                    continue;
+                }
+                ++m_statistics.connections_reused;
+                dbgln_if(HTTP_CONNECTION_POOL_DEBUG, "ConnectionPool: Reusing connection to {} ({} of {} requests reused a connection)",
+                    origin, m_statistics.connections_reused, m_statistics.connections_reused + m_statistics.connections_opened);
+                return move(connection.socket);
+            }
+        }
+        ++m_statistics.connections_opened;
+        dbgln_if(HTTP_CONNECTION_POOL_DEBUG, "ConnectionPool: No idle connection to {}, opening a new one", origin);
+        return nullptr;
+    }
+
+    // Takes back a connection that has finished its last response and is ready for another request.
+    void release(const URL& url, NonnullRefPtr<SocketType> socket)
+    {
+        auto origin = origin_of(url);
+        auto& connections = m_idle_connections.ensure(origin);
+        if (connections.size() >= max_idle_connections_per_origin || !is_usable(*socket)) {
+            ++m_statistics.connections_discarded;
+            return;
+        }
+
+        watch_for_closure(origin, *socket);
+        Core::ElapsedTimer idle_timer;
+        idle_timer.start();
+        connections.append({ move(socket), idle_timer });
+        dbgln_if(HTTP_CONNECTION_POOL_DEBUG, "ConnectionPool: Keeping connection to {} alive, {} idle connection(s) to it", origin, connections.size());
+    }
+
+    const Statistics& statistics() const { return m_statistics; }
+
+private:
+    struct IdleConnection {
+        NonnullRefPtr<SocketType> socket;
+        Core::ElapsedTimer idle_timer;
+    };
+
+    ConnectionPool() { }
+
+    static String origin_of(const URL& url)
+    {
+        return String::formatted("{}://{}:{}", url.protocol(), url.host(), url.port());
+    }
+
+    static bool is_usable(Core::TCPSocket& socket) { return socket.is_connected() && !socket.eof() && socket.buffered_size() == 0; }
+    static bool is_usable(TLS::TLSv12& socket) { return socket.is_established() && !socket.can_read(); }
+
+    // An idle connection becoming readable means that the server has closed it (or is misbehaving),
+    // either way it can't be used for another request.
+    void watch_for_closure(const String& origin, Core::TCPSocket& socket)
+    {
+        socket.on_ready_to_read = [this, origin, &socket] { discard(origin, socket); };
+    }
+
+    void watch_for_closure(const String& origin, TLS::TLSv12& socket)
+    {
+        socket.on_tls_ready_to_read = [this, origin, &socket](auto&) { discard(origin, socket); };
+        socket.on_tls_error = [this, origin, &socket](auto) { discard(origin, socket); };
+        socket.on_tls_finished = [this, origin, &socket] { discard(origin, socket); };
+    }
+
+    static void stop_watching(Core::TCPSocket& socket)
+    {
+        socket.on_ready_to_read = nullptr;
+    }
+
+    static void stop_watching(TLS::TLSv12& socket)
+    {
+        socket.on_tls_ready_to_read = nullptr;
+        socket.on_tls_ready_to_write = nullptr;
+        socket.on_tls_error = nullptr;
+        socket.on_tls_finished = nullptr;
+    }
+
+    void discard(const String& origin, SocketType& socket)
+    {
+        auto it = m_idle_connections.find(origin);
+        if (it == m_idle_connections.end())
+            return;
+        auto& connections = it->value;
+        for (size_t i = 0; i < connections.size(); ++i) {
+            if (connections[i].socket.ptr() != &socket)
+                continue;
+            // We're being called from one of the socket's own callbacks, so keep it alive until that has returned.
+            auto connection = connections.take(i);
+            socket.deferred_invoke([protector = move(connection.socket)](auto&) {});
+            ++m_statistics.connections_discarded;
+            dbgln_if(HTTP_CONNECTION_POOL_DEBUG, "ConnectionPool: Idle connection to {} was closed", origin);
+            return;
+        }
+    }
+
+    HashMap<String, Vector<IdleConnection>> m_idle_connections;
+    Statistics m_statistics;
+};
+
+}
@@ -27,6 +27,7 @@
 #include <AK/Debug.h>
 #include <LibCore/Gzip.h>
 #include <LibCore/TCPSocket.h>
+#include <LibHTTP/ConnectionPool.h>
 #include <LibHTTP/HttpJob.h>
 #include <LibHTTP/HttpResponse.h>
 #include <stdio.h>
@@ -36,6 +37,17 @@ namespace HTTP {
 void HttpJob::start()
 {
     VERIFY(!m_socket);
+    if (can_send_request_on_pooled_connection()) {
+        if (auto socket = ConnectionPool<Core::TCPSocket>::the().take(m_request.url())) {
+            m_socket = move(socket);
+            add_child(*m_socket);
+            m_connection_was_reused = true;
+            deferred_invoke([this](auto&) { on_socket_connected(); });
+            return;
+        }
+    }
+
+    m_connection_was_reused = false;
     m_socket = Core::TCPSocket::construct(this);
     m_socket->on_connected = [this] {
 #if CHTTPJOB_DEBUG
@@ -58,12 +70,40 @@ void HttpJob::shutdown()
     m_socket->on_ready_to_read = nullptr;
     m_socket->on_connected = nullptr;
     remove_child(*m_socket);
+    if (m_can_reuse_connection)
+        ConnectionPool<Core::TCPSocket>::the().release(m_request.url(), m_socket.release_nonnull());
     m_socket = nullptr;
 }
 
+void HttpJob::set_reading_paused(bool paused)
+{
+    if (!m_socket)
+        return;
+    m_socket->set_read_notifications_enabled(!paused);
+    if (paused)
+        return;
+    deferred_invoke([this](auto&) {
+        if (m_socket && m_socket->on_ready_to_read && m_socket->can_read())
+            m_socket->on_ready_to_read();
+    });
+}
+
 void HttpJob::register_on_ready_to_read(Function<void()> callback)
 {
-    m_socket->on_ready_to_read = move(callback);
+    m_socket->on_ready_to_read = [this, callback = move(callback)] {
+        callback();
+        // The socket reads ahead into a buffer of its own, and the notifier only fires for data that's still
+        // in the kernel. When the server keeps the connection open, no EOF comes along to wake us up for what's
+        // left in that buffer, so keep going for as long as the job is making progress with it.
+        while (m_socket && m_state != State::Finished && !is_cancelled()) {
+            auto buffered_size = m_socket->buffered_size();
+            if (buffered_size == 0)
+                break;
+            callback();
+            if (m_socket && m_socket->buffered_size() == buffered_size)
+                break;
+        }
+    };
 }
 
 void HttpJob::register_on_ready_to_write(Function<void()> callback)
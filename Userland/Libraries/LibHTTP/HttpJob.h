@@ -52,6 +52,7 @@ public:
 
 protected:
     virtual bool should_fail_on_empty_payload() const override { return false; }
+    virtual void set_reading_paused(bool) override;
     virtual void register_on_ready_to_read(Function<void()>) override;
     virtual void register_on_ready_to_write(Function<void()>) override;
     virtual bool can_read_line() const override;
@@ -63,7 +64,7 @@ protected:
     virtual bool is_established() const override { return true; }
 
 private:
-    RefPtr<Core::Socket> m_socket;
+    RefPtr<Core::TCPSocket> m_socket;
 };
 
 }
@@ -24,6 +24,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/AnyOf.h>
 #include <AK/StringBuilder.h>
 #include <LibHTTP/HttpJob.h>
 #include <LibHTTP/HttpRequest.h>
@@ -71,7 +72,9 @@ ByteBuffer HttpRequest::to_raw_request() const
         builder.append(header.value);
         builder.append("\r\n");
     }
-    builder.append("Connection: close\r\n");
+    // Ask the server to leave the connection open, so it can go back into the ConnectionPool afterwards.
+    if (!any_of(m_headers.begin(), m_headers.end(), [](auto& header) { return header.name.equals_ignoring_case("Connection"); }))
+        builder.append("Connection: keep-alive\r\n");
     if (!m_body.is_empty()) {
         builder.appendff("Content-Length: {}\r\n\r\n", m_body.size());
         builder.append((const char*)m_body.data(), m_body.size());
@@ -181,6 +184,7 @@ Optional<HttpRequest> HttpRequest::from_raw_request(ReadonlyBytes raw_request)
         return {};
 
     request.m_resource = resource;
+    request.m_protocol = protocol;
     request.m_headers = move(headers);
 
     return request;
@@ -53,6 +53,7 @@ public:
     ~HttpRequest();
 
     const String& resource() const { return m_resource; }
+    const String& protocol() const { return m_protocol; }
     const Vector<Header>& headers() const { return m_headers; }
 
     const URL& url() const { return m_url; }
@@ -75,6 +76,7 @@ public:
 private:
     URL m_url;
     String m_resource;
+    String m_protocol;
     Method m_method { GET };
     Vector<Header> m_headers;
     ByteBuffer m_body;
@@ -27,6 +27,7 @@
 #include <AK/Debug.h>
 #include <LibCore/EventLoop.h>
 #include <LibCore/Gzip.h>
+#include <LibHTTP/ConnectionPool.h>
 #include <LibHTTP/HttpResponse.h>
 #include <LibHTTP/HttpsJob.h>
 #include <LibTLS/TLSv12.h>
@@ -38,6 +39,19 @@ namespace HTTP {
 void HttpsJob::start()
 {
     VERIFY(!m_socket);
+    // Pooled connections were verified against the default root certificates, so they're no good for jobs that bring their own.
+    if (!m_override_ca_certificates && can_send_request_on_pooled_connection()) {
+        if (auto socket = ConnectionPool<TLS::TLSv12>::the().take(m_request.url())) {
+            m_socket = move(socket);
+            add_child(*m_socket);
+            m_connection_was_reused = true;
+            set_up_socket_callbacks();
+            deferred_invoke([this](auto&) { on_socket_connected(); });
+            return;
+        }
+    }
+
+    m_connection_was_reused = false;
     m_socket = TLS::TLSv12::construct(this);
     m_socket->set_root_certificates(m_override_ca_certificates ? *m_override_ca_certificates : DefaultRootCACertificates::the().certificates());
     m_socket->on_tls_connected = [this] {
@@ -46,7 +60,20 @@ void HttpsJob::start()
 #endif
         on_socket_connected();
     };
+    set_up_socket_callbacks();
+    bool success = ((TLS::TLSv12&)*m_socket).connect(m_request.url().host(), m_request.url().port());
+    if (!success) {
+        deferred_invoke([this](auto&) {
+            return did_fail(Core::NetworkJob::Error::ConnectionFailed);
+        });
+    }
+}
+
+void HttpsJob::set_up_socket_callbacks()
+{
     m_socket->on_tls_error = [&](TLS::AlertDescription error) {
+        if (retry_on_new_connection_if_reused())
+            return;
         if (error == TLS::AlertDescription::HandshakeFailure) {
             deferred_invoke([this](auto&) {
                 return did_fail(Core::NetworkJob::Error::ProtocolFailed);
@@ -62,18 +89,14 @@ void HttpsJob::start()
         }
     };
     m_socket->on_tls_finished = [&] {
+        if (retry_on_new_connection_if_reused())
+            return;
         finish_up();
     };
     m_socket->on_tls_certificate_request = [this](auto&) {
         if (on_certificate_requested)
             on_certificate_requested(*this);
     };
-    bool success = ((TLS::TLSv12&)*m_socket).connect(m_request.url().host(), m_request.url().port());
-    if (!success) {
-        deferred_invoke([this](auto&) {
-            return did_fail(Core::NetworkJob::Error::ConnectionFailed);
-        });
-    }
 }
 
 void HttpsJob::shutdown()
@@ -81,8 +104,14 @@ void HttpsJob::shutdown()
     if (!m_socket)
         return;
     m_socket->on_tls_ready_to_read = nullptr;
+    m_socket->on_tls_ready_to_write = nullptr;
     m_socket->on_tls_connected = nullptr;
+    m_socket->on_tls_error = nullptr;
+    m_socket->on_tls_finished = nullptr;
+    m_socket->on_tls_certificate_request = nullptr;
     remove_child(*m_socket);
+    if (m_can_reuse_connection)
+        ConnectionPool<TLS::TLSv12>::the().release(m_request.url(), m_socket.release_nonnull());
     m_socket = nullptr;
 }
 
@@ -103,6 +132,19 @@ void HttpsJob::read_while_data_available(Function<IterationDecision()> read)
     }
 }
 
+void HttpsJob::set_reading_paused(bool paused)
+{
+    if (!m_socket)
+        return;
+    m_socket->set_read_notifications_enabled(!paused);
+    if (paused)
+        return;
+    deferred_invoke([this](auto&) {
+        if (m_socket && m_socket->on_tls_ready_to_read && m_socket->can_read())
+            m_socket->on_tls_ready_to_read(*m_socket);
+    });
+}
+
 void HttpsJob::register_on_ready_to_read(Function<void()> callback)
 {
     m_socket->on_tls_ready_to_read = [callback = move(callback)](auto&) {
@@ -115,6 +157,9 @@ void HttpsJob::register_on_ready_to_write(Function<void()> callback)
     m_socket->on_tls_ready_to_write = [callback = move(callback)](auto&) {
         callback();
     };
+    // A connection from the pool has finished its handshake long ago, so nothing else is going to tell us that it's writable.
+    if (m_connection_was_reused)
+        m_socket->on_tls_ready_to_write(*m_socket);
 }
 
 bool HttpsJob::can_read_line() const
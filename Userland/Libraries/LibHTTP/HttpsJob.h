@@ -55,6 +55,7 @@ public:
     Function<void(HttpsJob&)> on_certificate_requested;
 
 protected:
+    virtual void set_reading_paused(bool) override;
     virtual void register_on_ready_to_read(Function<void()>) override;
     virtual void register_on_ready_to_write(Function<void()>) override;
     virtual bool can_read_line() const override;
@@ -68,6 +69,8 @@ protected:
     virtual void read_while_data_available(Function<IterationDecision()>) override;
 
 private:
+    void set_up_socket_callbacks();
+
     RefPtr<TLS::TLSv12> m_socket;
     const Vector<Certificate>* m_override_ca_certificates { nullptr };
 };
@@ -90,11 +90,46 @@ void Job::flush_received_buffers()
         }
         VERIFY(written < payload.size());
         payload = payload.slice(written, payload.size() - written);
+        if (on_output_blocked && !m_output_blocked) {
+            m_output_blocked = true;
+            on_output_blocked();
+        }
         break;
     }
+    if (m_buffered_size == 0)
+        m_output_blocked = false;
     dbgln_if(JOB_DEBUG, "Job: Flushing received buffers done: have {} bytes in {} buffers", m_buffered_size, m_received_buffers.size());
 }
 
+bool Job::should_pause_reading() const
+{
+    // How much of the response we keep around while waiting for the output to take it.
+    constexpr size_t max_buffered_size = 256 * KiB;
+
+    // Responses that aren't streamed are buffered in full anyway, and without on_output_blocked nobody would resume us.
+    return m_can_stream_response && on_output_blocked && m_buffered_size >= max_buffered_size;
+}
+
+void Job::resume_output()
+{
+    if (!m_output_blocked)
+        return;
+    m_output_blocked = false;
+    flush_received_buffers();
+    if (m_output_blocked)
+        return;
+
+    if (m_state == State::Finished) {
+        finish_up();
+        return;
+    }
+    if (m_reading_paused) {
+        dbgln_if(JOB_DEBUG, "Job: Output drained, resuming reading");
+        m_reading_paused = false;
+        set_reading_paused(false);
+    }
+}
+
 void Job::on_socket_connected()
 {
     register_on_ready_to_write([&] {
@@ -109,7 +144,7 @@ void Job::on_socket_connected()
         }
 
         bool success = write(raw_request);
-        if (!success)
+        if (!success && !retry_on_new_connection_if_reused())
             deferred_invoke([this](auto&) { did_fail(Core::NetworkJob::Error::TransmissionFailed); });
     });
     register_on_ready_to_read([&] {
@@ -118,17 +153,18 @@ void Job::on_socket_connected()
 
         if (m_state == State::Finished) {
             // This is probably just a EOF notification, which means we should receive nothing
-            // and then get eof() == true.
+            // and then get eof() == true. Either way, the server is done with this connection.
             [[maybe_unused]] auto payload = receive(64);
-            // These assertions are only correct if "Connection: close".
-            VERIFY(payload.is_empty());
-            VERIFY(eof());
+            m_can_reuse_connection = false;
             return;
         }
 
         if (m_state == State::InStatus) {
-            if (!can_read_line())
+            if (!can_read_line()) {
+                if (eof() && !retry_on_new_connection_if_reused())
+                    deferred_invoke([this](auto&) { did_fail(Core::NetworkJob::Error::TransmissionFailed); });
                 return;
+            }
             auto line = read_line(PAGE_SIZE);
             if (line.is_null()) {
                 fprintf(stderr, "Job: Expected HTTP status\n");
@@ -145,6 +181,8 @@ void Job::on_socket_connected()
                 return deferred_invoke([this](auto&) { did_fail(Core::NetworkJob::Error::ProtocolFailed); });
             }
             m_code = code.value();
+            // HTTP/1.1 connections are persistent by default, HTTP/1.0 ones only if the server says so.
+            m_server_keeps_connection_alive = parts[0] != "HTTP/1.0";
             m_state = State::InHeaders;
             return;
         }
@@ -160,15 +198,27 @@ void Job::on_socket_connected()
                     return finish_up();
                 }
                 fprintf(stderr, "Job: Expected HTTP header\n");
-                return did_fail(Core::NetworkJob::Error::ProtocolFailed);
+                return deferred_invoke([this](auto&) { did_fail(Core::NetworkJob::Error::ProtocolFailed); });
             }
             if (line.is_empty()) {
                 if (m_state == State::Trailers) {
-                    return finish_up();
+                    return finish_up_keeping_connection_alive();
                 } else {
+                    if (auto connection = m_headers.get("Connection"); connection.has_value()) {
+                        if (connection.value().contains("close", CaseSensitivity::CaseInsensitive))
+                            m_server_keeps_connection_alive = false;
+                        else if (connection.value().contains("keep-alive", CaseSensitivity::CaseInsensitive))
+                            m_server_keeps_connection_alive = true;
+                    }
                     if (on_headers_received)
                         on_headers_received(m_headers, m_code > 0 ? m_code : Optional<u32> {});
                     m_state = State::InBody;
+
+                    // When the connection stays open, there's no EOF to tell us that these are done.
+                    auto content_length = m_headers.get("Content-Length");
+                    if (m_request.method() == HttpRequest::Method::HEAD || m_code == 204 || m_code == 304
+                        || (content_length.has_value() && content_length.value() == "0"))
+                        return finish_up_keeping_connection_alive();
                 }
                 return;
             }
@@ -205,9 +255,18 @@ void Job::on_socket_connected()
             return;
         }
         VERIFY(m_state == State::InBody);
+        if (m_reading_paused)
+            return;
         VERIFY(can_read());
 
         read_while_data_available([&] {
+            if (should_pause_reading()) {
+                dbgln_if(JOB_DEBUG, "Job: {} bytes are waiting for the output to drain, pausing reading", m_buffered_size);
+                m_reading_paused = true;
+                set_reading_paused(true);
+                return IterationDecision::Break;
+            }
+
             auto read_size = 64 * KiB;
             if (m_current_chunk_remaining_size.has_value()) {
             read_chunk_size:;
@@ -323,7 +382,7 @@ void Job::on_socket_connected()
                 auto length = content_length.value();
                 if (m_received_size >= length) {
                     m_received_size = length;
-                    finish_up();
+                    finish_up_keeping_connection_alive();
                     return IterationDecision::Break;
                 }
             }
@@ -339,6 +398,31 @@ void Job::on_socket_connected()
     });
 }
 
+bool Job::retry_on_new_connection_if_reused()
+{
+    // A connection from the pool may have been closed by the server just as we sent our request on it.
+    // As long as none of the response has arrived, it's safe to send the request again on a new connection.
+    if (!m_connection_was_reused || m_state != State::InStatus || !can_send_request_on_pooled_connection())
+        return false;
+
+    dbgln_if(JOB_DEBUG, "Job: Reused connection to {} was closed, retrying on a new one", m_request.url());
+    m_connection_was_reused = false;
+    deferred_invoke([this](auto&) {
+        shutdown();
+        m_sent_data = false;
+        start();
+    });
+    return true;
+}
+
+void Job::finish_up_keeping_connection_alive()
+{
+    // The response ended where its framing said it would, rather than with the connection being closed,
+    // so the connection can be used for another request.
+    m_can_reuse_connection = m_server_keeps_connection_alive;
+    finish_up();
+}
+
 void Job::finish_up()
 {
     m_state = State::Finished;
@@ -368,6 +452,10 @@ void Job::finish_up()
         // before we can actually call `did_finish`. in a normal flow, this should
         // never be hit since the client is reading as we are writing, unless there
         // are too many concurrent downloads going on.
+        if (m_output_blocked) {
+            // resume_output() will get back to us.
+            return;
+        }
         deferred_invoke([this](auto&) {
             finish_up();
         });
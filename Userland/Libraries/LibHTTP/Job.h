@@ -47,10 +47,19 @@ public:
     HttpResponse* response() { return static_cast<HttpResponse*>(Core::NetworkJob::response()); }
     const HttpResponse* response() const { return static_cast<const HttpResponse*>(Core::NetworkJob::response()); }
 
+    virtual void resume_output() override;
+
 protected:
     void finish_up();
+    void finish_up_keeping_connection_alive();
+    bool retry_on_new_connection_if_reused();
+    bool can_send_request_on_pooled_connection() const { return m_request.method() != HttpRequest::Method::POST; }
     void on_socket_connected();
     void flush_received_buffers();
+    bool should_pause_reading() const;
+    // Stops (or restarts) reading from the connection. When restarting, anything that was read into
+    // a buffer in the meantime has to be handed to the callback, since nothing will wake us up for it.
+    virtual void set_reading_paused(bool) = 0;
     virtual void register_on_ready_to_read(Function<void()>) = 0;
     virtual void register_on_ready_to_write(Function<void()>) = 0;
     virtual bool can_read_line() const = 0;
@@ -82,6 +91,11 @@ protected:
     Optional<ssize_t> m_current_chunk_remaining_size;
     Optional<size_t> m_current_chunk_total_size;
     bool m_can_stream_response { true };
+    bool m_server_keeps_connection_alive { false };
+    bool m_connection_was_reused { false };
+    bool m_can_reuse_connection { false };
+    bool m_output_blocked { false };
+    bool m_reading_paused { false };
 };
 
 }
@@ -28,19 +28,24 @@
 
 #include <AK/ByteBuffer.h>
 #include <AK/NonnullOwnPtrVector.h>
+#include <LibCore/AnonymousBuffer.h>
 #include <LibCore/Event.h>
 #include <LibCore/EventLoop.h>
 #include <LibCore/LocalSocket.h>
 #include <LibCore/Notifier.h>
 #include <LibCore/SyscallUtils.h>
 #include <LibCore/Timer.h>
+#include <LibCore/Trace.h>
 #include <LibIPC/Message.h>
+#include <LibIPC/SharedRing.h>
+#include <fcntl.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/select.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 namespace IPC {
@@ -68,6 +73,14 @@ public:
     }
 
     void post_message(const Message& message)
+    {
+        post_message(message, 0);
+    }
+
+    // While batching, a message posted with a non-zero coalescing key replaces the message posted
+    // right before it if that one is still waiting to be sent and had the same key. This is for
+    // messages that only carry the latest state of something, like the mouse position.
+    void post_message(const Message& message, u64 coalescing_key)
     {
         // NOTE: If this connection is being shut down, but has not yet been destroyed,
         //       the socket will be closed. Don't try to send more messages.
@@ -75,9 +88,7 @@ public:
             return;
 
         auto buffer = message.encode();
-        // Prepend the message size.
         uint32_t message_size = buffer.data.size();
-        buffer.data.prepend(reinterpret_cast<const u8*>(&message_size), sizeof(message_size));
 
 #ifdef __serenity__
         for (int fd : buffer.fds) {
@@ -92,29 +103,35 @@ public:
             warnln("fd passing is not supported on this platform, sorry :(");
 #endif
 
-        size_t total_nwritten = 0;
-        while (total_nwritten < buffer.data.size()) {
-            auto nwritten = write(m_socket->fd(), buffer.data.data() + total_nwritten, buffer.data.size() - total_nwritten);
-            if (nwritten < 0) {
-                switch (errno) {
-                case EPIPE:
-                    dbgln("{}::post_message: Disconnected from peer", *this);
-                    shutdown();
-                    return;
-                case EAGAIN:
-                    dbgln("{}::post_message: Peer buffer overflowed", *this);
-                    shutdown();
-                    return;
-                default:
-                    perror("Connection::post_message write");
-                    shutdown();
-                    return;
-                }
+        // The fds above still went over the socket, ahead of the message that refers to them.
+        if (m_batching_enabled) {
+            if (coalescing_key && coalescing_key == m_last_batched_coalescing_key && buffer.fds.is_empty()) {
+                m_batch.shrink(m_last_batched_message_offset, true);
+                ++m_coalesced_message_count;
             }
-            total_nwritten += nwritten;
+            m_last_batched_message_offset = m_batch.size();
+            m_last_batched_coalescing_key = buffer.fds.is_empty() ? coalescing_key : 0;
+            m_batch.append(reinterpret_cast<const u8*>(&message_size), sizeof(message_size));
+            m_batch.append(buffer.data.data(), buffer.data.size());
+            schedule_batch_flush();
+            return;
         }
 
-        m_responsiveness_timer->start();
+        if (send_bytes({ reinterpret_cast<const u8*>(&message_size), sizeof(message_size) }, buffer.data.span()))
+            m_responsiveness_timer->start();
+    }
+
+    // Sends whatever async messages have been batched up so far.
+    void flush_batch()
+    {
+        if (m_batch.is_empty())
+            return;
+        auto batch = move(m_batch);
+        m_last_batched_coalescing_key = 0;
+        if (!m_socket->is_open())
+            return;
+        if (send_bytes({}, batch.span()))
+            m_responsiveness_timer->start();
     }
 
     template<typename RequestType, typename... Args>
@@ -133,6 +150,9 @@ public:
         return wait_for_specific_endpoint_message<typename RequestType::ResponseType, PeerEndpoint>();
     }
 
+    // How many messages were dropped because a newer one replaced them, on the way out or in.
+    size_t coalesced_message_count() const { return m_coalesced_message_count; }
+
     virtual void may_have_become_unresponsive() { }
     virtual void did_become_responsive() { }
 
@@ -148,9 +168,46 @@ public:
 protected:
     Core::LocalSocket& socket() { return *m_socket; }
 
+    // While enabled, posted messages are held back and sent together once control returns to
+    // the event loop, instead of with a write each. Anything that waits for the peer to respond
+    // flushes them first.
+    void set_batching_enabled(bool enabled)
+    {
+        m_batching_enabled = enabled;
+        if (!enabled)
+            flush_batch();
+    }
+
+    // Offers the peer a pair of shared memory rings to carry messages in both directions
+    // instead of the socket, which then only passes fds and wakes up the other side.
+    // This has to come before any other message we send.
+    void propose_shared_rings()
+    {
+#ifdef __serenity__
+        auto buffer = Core::AnonymousBuffer::create_with_size(SharedRing::size_in_memory() * 2);
+        if (!buffer.is_valid())
+            return;
+        SharedRing::initialize(buffer.data<u8>());
+        SharedRing::initialize(buffer.data<u8>() + SharedRing::size_in_memory());
+        if (sendfd(m_socket->fd(), buffer.fd()) < 0) {
+            perror("sendfd");
+            return;
+        }
+        if (!write_shared_ring_frame())
+            return;
+        // Our messages go through the ring from now on. The peer's keep coming over the
+        // socket until it acknowledges the rings.
+        m_send_ring = make<SharedRing>(buffer.data<u8>());
+        m_receive_ring = make<SharedRing>(buffer.data<u8>() + SharedRing::size_in_memory());
+        m_shared_rings = move(buffer);
+#endif
+    }
+
     template<typename MessageType, typename Endpoint>
     OwnPtr<MessageType> wait_for_specific_endpoint_message()
     {
+        // The peer won't answer anything it hasn't seen yet.
+        flush_batch();
         for (;;) {
             // Double check we don't already have the event waiting for us.
             // Otherwise we might end up blocked for a while for no reason.
@@ -181,7 +238,10 @@ protected:
 
     bool drain_messages_from_peer()
     {
-        Vector<u8> bytes;
+        // Messages with borrowed parameters point into this, so it must not be resized once
+        // we've started decoding.
+        auto receive_buffer = adopt(*new ReceiveBuffer);
+        auto& bytes = receive_buffer->data;
 
         if (!m_unprocessed_bytes.is_empty()) {
             bytes.append(m_unprocessed_bytes.data(), m_unprocessed_bytes.size());
@@ -204,7 +264,15 @@ protected:
                 }
                 return false;
             }
-            bytes.append(buffer, nread);
+            // Once the peer uses the shared ring, all it sends over the socket are doorbells.
+            if (!m_peer_sends_via_ring)
+                bytes.append(buffer, nread);
+        }
+
+        if (m_peer_sends_via_ring && !read_from_receive_ring(bytes)) {
+            dbgln("{}::drain_messages_from_peer: Peer corrupted the shared ring", *this);
+            shutdown();
+            return false;
         }
 
         if (!bytes.is_empty()) {
@@ -214,15 +282,32 @@ protected:
 
         size_t index = 0;
         uint32_t message_size = 0;
+        bool switched_to_receive_ring = false;
         for (; index + sizeof(message_size) < bytes.size(); index += message_size) {
             message_size = *reinterpret_cast<uint32_t*>(bytes.data() + index);
+            if (message_size == shared_ring_frame_marker && !m_peer_sends_via_ring) {
+                if (bytes.size() - index - sizeof(uint32_t) < sizeof(u32))
+                    break;
+                index += sizeof(message_size);
+                u32 capacity = *reinterpret_cast<u32*>(bytes.data() + index);
+                if (!did_receive_shared_ring_frame(capacity)) {
+                    shutdown();
+                    return false;
+                }
+                // Anything after the frame that came over the socket is a doorbell, and the
+                // message stream carries on in the ring. Read that into a buffer of its own.
+                index += sizeof(u32);
+                bytes.resize(index);
+                switched_to_receive_ring = true;
+                break;
+            }
             if (message_size == 0 || bytes.size() - index - sizeof(uint32_t) < message_size)
                 break;
             index += sizeof(message_size);
             auto remaining_bytes = ReadonlyBytes { bytes.data() + index, bytes.size() - index };
-            if (auto message = LocalEndpoint::decode_message(remaining_bytes, m_socket->fd())) {
+            if (auto message = LocalEndpoint::decode_message(remaining_bytes, m_socket->fd(), receive_buffer)) {
                 m_unprocessed_messages.append(message.release_nonnull());
-            } else if (auto message = PeerEndpoint::decode_message(remaining_bytes, m_socket->fd())) {
+            } else if (auto message = PeerEndpoint::decode_message(remaining_bytes, m_socket->fd(), receive_buffer)) {
                 m_unprocessed_messages.append(message.release_nonnull());
             } else {
                 dbgln("Failed to parse a message");
@@ -243,6 +328,9 @@ protected:
             m_unprocessed_bytes = remaining_bytes;
         }
 
+        if (switched_to_receive_ring)
+            return drain_messages_from_peer();
+
         if (!m_unprocessed_messages.is_empty()) {
             deferred_invoke([this](auto&) {
                 handle_messages();
@@ -251,13 +339,185 @@ protected:
         return true;
     }
 
+    bool send_bytes(ReadonlyBytes header, ReadonlyBytes body)
+    {
+        if (m_send_ring)
+            return write_to_send_ring(header) && write_to_send_ring(body);
+
+        // Send the header and the body with a single writev() instead of concatenating them,
+        // which would copy the whole body.
+        size_t total_size = header.size() + body.size();
+        size_t total_nwritten = 0;
+        while (total_nwritten < total_size) {
+            ssize_t nwritten;
+            if (total_nwritten < header.size()) {
+                iovec iov[2];
+                iov[0].iov_base = const_cast<u8*>(header.data()) + total_nwritten;
+                iov[0].iov_len = header.size() - total_nwritten;
+                iov[1].iov_base = const_cast<u8*>(body.data());
+                iov[1].iov_len = body.size();
+                nwritten = writev(m_socket->fd(), iov, 2);
+            } else {
+                size_t offset = total_nwritten - header.size();
+                nwritten = write(m_socket->fd(), body.data() + offset, body.size() - offset);
+            }
+            if (nwritten < 0) {
+                switch (errno) {
+                case EPIPE:
+                    dbgln("{}::post_message: Disconnected from peer", *this);
+                    shutdown();
+                    return false;
+                case EAGAIN:
+                    dbgln("{}::post_message: Peer buffer overflowed", *this);
+                    shutdown();
+                    return false;
+                default:
+                    perror("Connection::post_message write");
+                    shutdown();
+                    return false;
+                }
+            }
+            total_nwritten += nwritten;
+        }
+        return true;
+    }
+
+    void schedule_batch_flush()
+    {
+        if (m_batch_flush_scheduled)
+            return;
+        m_batch_flush_scheduled = true;
+        deferred_invoke([this](auto&) {
+            m_batch_flush_scheduled = false;
+            flush_batch();
+        });
+    }
+
+    bool write_to_send_ring(ReadonlyBytes bytes)
+    {
+        while (!bytes.is_empty()) {
+            auto nwritten_or_error = m_send_ring->write(bytes);
+            if (!nwritten_or_error.has_value()) {
+                dbgln("{}::post_message: Peer corrupted the shared ring", *this);
+                shutdown();
+                return false;
+            }
+            size_t nwritten = nwritten_or_error.value();
+            bytes = bytes.slice(nwritten);
+            if (m_send_ring->take_doorbell_request() && !ring_doorbell())
+                return false;
+            if (nwritten > 0)
+                continue;
+
+            // The ring is full. Just like with a full socket buffer, only clients wait for the
+            // peer to catch up, servers give up on the peer right away.
+            if (fcntl(m_socket->fd(), F_GETFL) & O_NONBLOCK) {
+                dbgln("{}::post_message: Peer buffer overflowed", *this);
+                shutdown();
+                return false;
+            }
+            m_send_ring->wait_for_space(100);
+            // Make sure the peer knows to drain the ring, and find out if it's still there.
+            if (!ring_doorbell())
+                return false;
+        }
+        return true;
+    }
+
+    bool ring_doorbell()
+    {
+        u8 doorbell = 0;
+        if (send(m_socket->fd(), &doorbell, sizeof(doorbell), MSG_DONTWAIT) < 0 && errno != EAGAIN) {
+            if (errno == EPIPE)
+                dbgln("{}::post_message: Disconnected from peer", *this);
+            else
+                perror("Connection::ring_doorbell send");
+            shutdown();
+            return false;
+        }
+        return true;
+    }
+
+    bool read_from_receive_ring(Vector<u8>& bytes)
+    {
+        // Ask for a doorbell before going back to sleep, then look again in case the peer
+        // wrote something before it could have seen the request.
+        do {
+            if (!m_receive_ring->read(bytes))
+                return false;
+            m_receive_ring->request_doorbell();
+        } while (!m_receive_ring->is_empty());
+        return true;
+    }
+
+    bool write_shared_ring_frame()
+    {
+        u32 frame[] = { shared_ring_frame_marker, SharedRing::capacity };
+        size_t total_nwritten = 0;
+        while (total_nwritten < sizeof(frame)) {
+            ssize_t nwritten = write(m_socket->fd(), reinterpret_cast<u8*>(frame) + total_nwritten, sizeof(frame) - total_nwritten);
+            if (nwritten < 0) {
+                perror("Connection::write_shared_ring_frame write");
+                shutdown();
+                return false;
+            }
+            total_nwritten += nwritten;
+        }
+        return true;
+    }
+
+    bool did_receive_shared_ring_frame([[maybe_unused]] u32 capacity)
+    {
+        if (m_send_ring) {
+            // The peer acknowledged the rings we proposed.
+            m_peer_sends_via_ring = true;
+            return true;
+        }
+
+#ifdef __serenity__
+        if (capacity != SharedRing::capacity) {
+            dbgln("{}: Peer proposed shared rings of the wrong size ({})", *this, capacity);
+            return false;
+        }
+        int fd = recvfd(m_socket->fd(), O_CLOEXEC);
+        if (fd < 0) {
+            perror("recvfd");
+            return false;
+        }
+        auto buffer = Core::AnonymousBuffer::create_from_anon_fd(fd, SharedRing::size_in_memory() * 2);
+        if (!buffer.is_valid())
+            return false;
+        m_receive_ring = make<SharedRing>(buffer.data<u8>());
+        m_peer_sends_via_ring = true;
+        // Whatever we've sent so far went over the socket, so tell the peer where to look next.
+        if (!write_shared_ring_frame())
+            return false;
+        m_send_ring = make<SharedRing>(buffer.data<u8>() + SharedRing::size_in_memory());
+        m_shared_rings = move(buffer);
+        return true;
+#else
+        dbgln("{}: Shared rings are not supported on this platform", *this);
+        return false;
+#endif
+    }
+
     void handle_messages()
     {
         auto messages = move(m_unprocessed_messages);
-        for (auto& message : messages) {
-            if (message.endpoint_magic() == LocalEndpoint::static_magic())
-                if (auto response = m_local_endpoint.handle(message))
+        for (size_t i = 0; i < messages.size(); ++i) {
+            auto& message = messages[i];
+            if (i + 1 < messages.size() && m_local_endpoint.is_superseded_by(message, messages[i + 1])) {
+                ++m_coalesced_message_count;
+                continue;
+            }
+            if (message.endpoint_magic() == LocalEndpoint::static_magic()) {
+                Core::Trace::Scope trace_scope("ipc", message.message_name());
+                if (auto response = m_local_endpoint.handle(message)) {
                     post_message(*response);
+                    // The peer is blocked until it gets this.
+                    flush_batch();
+                }
+            }
         }
     }
 
@@ -269,6 +529,21 @@ protected:
     RefPtr<Core::Notifier> m_notifier;
     NonnullOwnPtrVector<Message> m_unprocessed_messages;
     ByteBuffer m_unprocessed_bytes;
+
+    // Sent in place of a message size to propose or acknowledge shared rings, followed by the ring capacity.
+    static constexpr u32 shared_ring_frame_marker = 0xffffffff;
+
+    Core::AnonymousBuffer m_shared_rings;
+    OwnPtr<SharedRing> m_send_ring;
+    OwnPtr<SharedRing> m_receive_ring;
+    bool m_peer_sends_via_ring { false };
+
+    bool m_batching_enabled { false };
+    bool m_batch_flush_scheduled { false };
+    Vector<u8> m_batch;
+    size_t m_last_batched_message_offset { 0 };
+    u64 m_last_batched_coalescing_key { 0 };
+    size_t m_coalesced_message_count { 0 };
 };
 
 }
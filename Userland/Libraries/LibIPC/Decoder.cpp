@@ -136,6 +136,42 @@ bool Decoder::decode(ByteBuffer& value)
     return !m_stream.handle_any_error();
 }
 
+bool Decoder::decode_borrowed_bytes(ReadonlyBytes& value, bool& is_null)
+{
+    if (!m_receive_buffer)
+        return false;
+    i32 length = 0;
+    m_stream >> length;
+    if (m_stream.handle_any_error())
+        return false;
+    is_null = length < 0;
+    if (is_null) {
+        value = {};
+        return true;
+    }
+    if (m_stream.remaining() < static_cast<size_t>(length))
+        return false;
+    value = m_stream.bytes().slice(m_stream.offset(), length);
+    m_stream.discard_or_error(length);
+    return true;
+}
+
+bool Decoder::decode_borrowed(StringView& value)
+{
+    ReadonlyBytes bytes;
+    bool is_null = false;
+    if (!decode_borrowed_bytes(bytes, is_null))
+        return false;
+    value = is_null ? StringView {} : StringView { bytes };
+    return true;
+}
+
+bool Decoder::decode_borrowed(ReadonlyBytes& value)
+{
+    bool is_null = false;
+    return decode_borrowed_bytes(value, is_null);
+}
+
 bool Decoder::decode(URL& value)
 {
     String string;
@@ -28,6 +28,7 @@
 
 #include <AK/Forward.h>
 #include <AK/NumericLimits.h>
+#include <AK/RefPtr.h>
 #include <AK/StdLibExtras.h>
 #include <AK/String.h>
 #include <LibIPC/Forward.h>
@@ -44,12 +45,16 @@ inline bool decode(Decoder&, T&)
 
 class Decoder {
 public:
-    Decoder(InputMemoryStream& stream, int sockfd)
+    Decoder(InputMemoryStream& stream, int sockfd, RefPtr<ReceiveBuffer> receive_buffer = {})
         : m_stream(stream)
         , m_sockfd(sockfd)
+        , m_receive_buffer(move(receive_buffer))
     {
     }
 
+    // The buffer the stream reads from, if it is one that borrowed parameters can point into.
+    const RefPtr<ReceiveBuffer>& receive_buffer() const { return m_receive_buffer; }
+
     bool decode(bool&);
     bool decode(u8&);
     bool decode(u16&);
@@ -65,6 +70,11 @@ public:
     bool decode(URL&);
     bool decode(Dictionary&);
     bool decode(File&);
+
+    // Like decoding a String or ByteBuffer, but without copying anything out of the receive buffer.
+    bool decode_borrowed(StringView&);
+    bool decode_borrowed(ReadonlyBytes&);
+
     template<typename K, typename V>
     bool decode(HashMap<K, V>& hashmap)
     {
@@ -125,8 +135,11 @@ public:
     }
 
 private:
+    bool decode_borrowed_bytes(ReadonlyBytes&, bool& is_null);
+
     InputMemoryStream& m_stream;
     int m_sockfd { -1 };
+    RefPtr<ReceiveBuffer> m_receive_buffer;
 };
 
 }
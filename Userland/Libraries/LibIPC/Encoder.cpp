@@ -144,6 +144,21 @@ Encoder& Encoder::operator<<(const String& value)
     return *this << value.view();
 }
 
+Encoder& Encoder::encode_borrowed(const StringView& value)
+{
+    if (value.is_null())
+        return *this << (i32)-1;
+    *this << static_cast<i32>(value.length());
+    return *this << value;
+}
+
+Encoder& Encoder::encode_borrowed(ReadonlyBytes value)
+{
+    *this << static_cast<i32>(value.size());
+    m_buffer.data.append(value.data(), value.size());
+    return *this;
+}
+
 Encoder& Encoder::operator<<(const ByteBuffer& value)
 {
     *this << static_cast<i32>(value.size());
@@ -62,6 +62,11 @@ public:
     Encoder& operator<<(const URL&);
     Encoder& operator<<(const Dictionary&);
     Encoder& operator<<(const File&);
+
+    // These match the encoding of String and ByteBuffer, for parameters the peer decodes as borrowed views.
+    Encoder& encode_borrowed(const StringView&);
+    Encoder& encode_borrowed(ReadonlyBytes);
+
     template<typename K, typename V>
     Encoder& operator<<(const HashMap<K, V>& hashmap)
     {
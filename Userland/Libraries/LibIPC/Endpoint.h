@@ -45,6 +45,10 @@ public:
     virtual String name() const = 0;
     virtual OwnPtr<Message> handle(const Message&) = 0;
 
+    // Lets an endpoint skip a message that the one queued right behind it makes redundant,
+    // like a mouse move that was followed by another one before we got around to handling it.
+    virtual bool is_superseded_by(const Message&, [[maybe_unused]] const Message& next_message) const { return false; }
+
 protected:
     Endpoint();
 
@@ -32,6 +32,7 @@ class Decoder;
 class Dictionary;
 class Encoder;
 class Message;
+struct ReceiveBuffer;
 class File;
 
 }
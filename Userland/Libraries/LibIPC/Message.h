@@ -27,6 +27,7 @@
 #pragma once
 
 #include <AK/Function.h>
+#include <AK/RefCounted.h>
 #include <AK/Vector.h>
 
 namespace IPC {
@@ -36,6 +37,12 @@ struct MessageBuffer {
     Vector<int> fds;
 };
 
+// The bytes that a batch of messages was decoded from. Messages with borrowed parameters
+// point into it, and keep it alive for as long as they live.
+struct ReceiveBuffer : public RefCounted<ReceiveBuffer> {
+    Vector<u8> data;
+};
+
 class Message {
 public:
     virtual ~Message();
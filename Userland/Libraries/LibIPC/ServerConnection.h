@@ -45,6 +45,8 @@ public:
         }
 
         VERIFY(this->socket().is_connected());
+
+        this->propose_shared_rings();
     }
 
     virtual void handshake() = 0;
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Assertions.h>
+#include <LibIPC/SharedRing.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __serenity__
+#    include <serenity.h>
+#endif
+
+namespace IPC {
+
+void SharedRing::initialize(void* memory)
+{
+    auto& header = *new (memory) Header;
+    header.head = 0;
+    header.tail = 0;
+    // The consumer hasn't looked at the ring yet, so it's as good as asleep.
+    header.consumer_wants_doorbell = 1;
+    header.producer_is_waiting = 0;
+}
+
+SharedRing::SharedRing(void* memory)
+    : m_header(reinterpret_cast<Header*>(memory))
+    , m_data(reinterpret_cast<u8*>(memory) + sizeof(Header))
+{
+}
+
+Optional<size_t> SharedRing::write(ReadonlyBytes bytes)
+{
+    // Both positions are only read once: the consumer could change them under us at any time.
+    u32 head = header().head.load(AK::MemoryOrder::memory_order_relaxed);
+    u32 tail = header().tail.load(AK::MemoryOrder::memory_order_acquire);
+    u32 used_space = head - tail;
+    if (used_space > capacity)
+        return {};
+    size_t free_space = capacity - used_space;
+    size_t size = min(bytes.size(), free_space);
+    if (size == 0)
+        return 0;
+
+    size_t offset = head & (capacity - 1);
+    size_t first_chunk_size = min(size, capacity - offset);
+    memcpy(m_data + offset, bytes.data(), first_chunk_size);
+    memcpy(m_data, bytes.data() + first_chunk_size, size - first_chunk_size);
+
+    // This has to be ordered before checking for a doorbell request, so that the consumer either
+    // sees the new data when it re-checks after asking for a doorbell, or we see its request.
+    header().head.store(head + size);
+    return size;
+}
+
+bool SharedRing::take_doorbell_request()
+{
+    if (!header().consumer_wants_doorbell.load())
+        return false;
+    return header().consumer_wants_doorbell.exchange(0) != 0;
+}
+
+void SharedRing::wait_for_space(int timeout_ms)
+{
+    u32 tail = header().tail.load();
+    header().producer_is_waiting.store(1);
+    if (header().head.load(AK::MemoryOrder::memory_order_relaxed) - header().tail.load() == capacity) {
+#ifdef __serenity__
+        timespec timeout { timeout_ms / 1000, (timeout_ms % 1000) * 1'000'000 };
+        futex(const_cast<u32*>(header().tail.ptr()), FUTEX_WAIT, tail, &timeout, nullptr, 0);
+#else
+        (void)tail;
+        usleep(min(timeout_ms, 1) * 1000);
+#endif
+    }
+    header().producer_is_waiting.store(0);
+}
+
+bool SharedRing::read(Vector<u8>& buffer)
+{
+    // Both positions are only read once: the producer could change them under us at any time.
+    u32 tail = header().tail.load(AK::MemoryOrder::memory_order_relaxed);
+    u32 head = header().head.load(AK::MemoryOrder::memory_order_acquire);
+    u32 size = head - tail;
+    if (size > capacity)
+        return false;
+    if (size == 0)
+        return true;
+
+    size_t offset = tail & (capacity - 1);
+    size_t first_chunk_size = min<size_t>(size, capacity - offset);
+    buffer.append(m_data + offset, first_chunk_size);
+    buffer.append(m_data, size - first_chunk_size);
+
+    header().tail.store(tail + size);
+    if (header().producer_is_waiting.load()) {
+#ifdef __serenity__
+        futex(const_cast<u32*>(header().tail.ptr()), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+#endif
+    }
+    return true;
+}
+
+void SharedRing::request_doorbell()
+{
+    // The caller has to check is_empty() after this, to catch anything written in the meantime.
+    header().consumer_wants_doorbell.store(1);
+}
+
+bool SharedRing::is_empty() const
+{
+    return header().head.load() == header().tail.load(AK::MemoryOrder::memory_order_relaxed);
+}
+
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/Noncopyable.h>
+#include <AK/Optional.h>
+#include <AK/Span.h>
+#include <AK/Types.h>
+#include <AK/Vector.h>
+
+namespace IPC {
+
+// A single-producer, single-consumer byte ring in memory shared between the two ends of a
+// connection. It carries the same length-prefixed message stream as the socket would.
+//
+// Both sides only make a syscall when the other one has to be woken up: the consumer asks
+// for a "doorbell" before it goes back to sleep on the socket, and the producer only writes
+// a byte to the socket if the doorbell was asked for. Likewise, a producer that runs out of
+// space waits on a futex, which the consumer only wakes if someone is waiting.
+class SharedRing {
+    AK_MAKE_NONCOPYABLE(SharedRing);
+
+public:
+    static constexpr size_t capacity = 64 * KiB;
+    static_assert((capacity & (capacity - 1)) == 0);
+
+    // How much shared memory one ring needs, including its header.
+    static constexpr size_t size_in_memory();
+
+    // Sets up a new ring in the given memory, which must be zeroed.
+    static void initialize(void* memory);
+
+    explicit SharedRing(void* memory);
+
+    // Producer side. Writes as many of the bytes as fit, and returns how many that was.
+    // The peer can write anything it likes to the header, so this returns an empty Optional
+    // when the ring doesn't make sense anymore.
+    Optional<size_t> write(ReadonlyBytes);
+    // Returns true (once) if the consumer wants to be woken up through the socket.
+    bool take_doorbell_request();
+    // Waits until there's some room in the ring, or the timeout expires.
+    void wait_for_space(int timeout_ms);
+
+    // Consumer side. Appends everything in the ring to the given buffer. Returns false if the
+    // ring doesn't make sense anymore.
+    bool read(Vector<u8>&);
+    void request_doorbell();
+    bool is_empty() const;
+
+private:
+    struct Header {
+        Atomic<u32> head;
+        Atomic<u32> tail;
+        Atomic<u32> consumer_wants_doorbell;
+        Atomic<u32> producer_is_waiting;
+    };
+
+    Header& header() { return *m_header; }
+    const Header& header() const { return *m_header; }
+
+    Header* m_header { nullptr };
+    u8* m_data { nullptr };
+};
+
+constexpr size_t SharedRing::size_in_memory()
+{
+    return sizeof(Header) + capacity;
+}
+
+}
@@ -37,6 +37,10 @@ Client::Client()
 
 void Client::die()
 {
+    auto pending_decodes = move(m_pending_decodes);
+    for (auto& it : pending_decodes)
+        it.value({});
+
     if (on_death)
         on_death();
 }
@@ -46,8 +50,29 @@ void Client::handshake()
     send_sync<Messages::ImageDecoderServer::Greet>();
 }
 
-void Client::handle(const Messages::ImageDecoderClient::Dummy&)
+void Client::handle(const Messages::ImageDecoderClient::DidDecodeImage& message)
 {
+    auto it = m_pending_decodes.find(message.request_id());
+    if (it == m_pending_decodes.end())
+        return;
+    auto callback = move(it->value);
+    m_pending_decodes.remove(message.request_id());
+
+    if (!message.success()) {
+        callback({});
+        return;
+    }
+
+    DecodedImage image;
+    image.is_animated = message.is_animated();
+    image.loop_count = message.loop_count();
+    image.frames.resize(message.bitmaps().size());
+    for (size_t i = 0; i < image.frames.size(); ++i) {
+        auto& frame = image.frames[i];
+        frame.bitmap = message.bitmaps()[i].bitmap();
+        frame.duration = message.durations()[i];
+    }
+    callback(move(image));
 }
 
 Optional<DecodedImage> Client::decode_image(const ByteBuffer& encoded_data)
@@ -81,4 +106,24 @@ Optional<DecodedImage> Client::decode_image(const ByteBuffer& encoded_data)
     return move(image);
 }
 
+void Client::decode_image_async(const ByteBuffer& encoded_data, Function<void(Optional<DecodedImage>)> callback)
+{
+    if (encoded_data.is_empty()) {
+        callback({});
+        return;
+    }
+
+    auto encoded_buffer = Core::AnonymousBuffer::create_with_size(encoded_data.size());
+    if (!encoded_buffer.is_valid()) {
+        dbgln("Could not allocate encoded buffer");
+        callback({});
+        return;
+    }
+
+    memcpy(encoded_buffer.data<void>(), encoded_data.data(), encoded_data.size());
+    auto request_id = m_next_request_id++;
+    m_pending_decodes.set(request_id, move(callback));
+    post_message(Messages::ImageDecoderServer::DecodeImageAsync(request_id, move(encoded_buffer)));
+}
+
 }
@@ -54,6 +54,10 @@ public:
 
     Optional<DecodedImage> decode_image(const ByteBuffer&);
 
+    // Decodes the image without blocking; the callback is invoked from the event loop once the decoder replies
+    // (or with an empty Optional if it couldn't be reached.)
+    void decode_image_async(const ByteBuffer&, Function<void(Optional<DecodedImage>)>);
+
     Function<void()> on_death;
 
 private:
@@ -61,7 +65,10 @@ private:
 
     virtual void die() override;
 
-    virtual void handle(const Messages::ImageDecoderClient::Dummy&) override;
+    virtual void handle(const Messages::ImageDecoderClient::DidDecodeImage&) override;
+
+    i32 m_next_request_id { 0 };
+    HashMap<i32, Function<void(Optional<DecodedImage>)>> m_pending_decodes;
 };
 
 }
@@ -109,6 +109,25 @@ Value Program::execute(Interpreter& interpreter, GlobalObject& global_object) co
     return interpreter.execute_statement(global_object, *this, ScopeType::Block);
 }
 
+FunctionNode::FunctionNode(const FlyString& name, NonnullRefPtr<Statement> body, Vector<Parameter> parameters, i32 function_length, NonnullRefPtrVector<VariableDeclaration> variables, bool is_strict_mode)
+    : m_name(name)
+    , m_body(move(body))
+    , m_parameters(move(parameters))
+    , m_variables(move(variables))
+    , m_function_length(function_length)
+    , m_is_strict_mode(is_strict_mode)
+{
+    if (!is<ScopeNode>(*m_body))
+        return;
+    auto& body_scope = static_cast<ScopeNode&>(*m_body);
+    auto layout = ScopeLayout::create();
+    for (auto& parameter : m_parameters)
+        layout->add(parameter.name, DeclarationKind::Var);
+    for (auto& binding : body_scope.layout().bindings())
+        layout->add(binding.name, binding.declaration_kind);
+    body_scope.set_function_layout(move(layout));
+}
+
 Value FunctionDeclaration::execute(Interpreter& interpreter, GlobalObject&) const
 {
     interpreter.enter_node(*this);
@@ -166,7 +185,14 @@ CallExpression::ThisAndCallee CallExpression::compute_this_and_callee(Interprete
         auto property_name = member_expression.computed_property_name(interpreter, global_object);
         if (!property_name.is_valid())
             return {};
-        auto callee = lookup_target.to_object(global_object)->get(property_name).value_or(js_undefined());
+        auto* lookup_object = lookup_target.to_object(global_object);
+        if (vm.exception())
+            return {};
+        Value callee;
+        if (!member_expression.is_computed() && !is_super_property_lookup)
+            callee = member_expression.property_cache().get(*lookup_object, property_name);
+        else
+            callee = lookup_object->get(property_name).value_or(js_undefined());
         return { this_value, callee };
     }
     return { &global_object, m_callee->execute(interpreter, global_object) };
@@ -371,24 +397,32 @@ Value DoWhileStatement::execute(Interpreter& interpreter, GlobalObject& global_o
     return last_value;
 }
 
+ForStatement::ForStatement(SourceRange source_range, RefPtr<ASTNode> init, RefPtr<Expression> test, RefPtr<Expression> update, NonnullRefPtr<Statement> body)
+    : Statement(move(source_range))
+    , m_init(move(init))
+    , m_test(move(test))
+    , m_update(move(update))
+    , m_body(move(body))
+{
+    if (m_init && is<VariableDeclaration>(*m_init) && static_cast<const VariableDeclaration&>(*m_init).declaration_kind() != DeclarationKind::Var) {
+        m_scope_wrapper = create_ast_node<BlockStatement>(this->source_range());
+        NonnullRefPtrVector<VariableDeclaration> decls;
+        decls.append(static_cast<VariableDeclaration&>(*m_init));
+        m_scope_wrapper->add_variables(decls);
+    }
+}
+
 Value ForStatement::execute(Interpreter& interpreter, GlobalObject& global_object) const
 {
     interpreter.enter_node(*this);
     ScopeGuard exit_node { [&] { interpreter.exit_node(*this); } };
 
-    RefPtr<BlockStatement> wrapper;
-
-    if (m_init && is<VariableDeclaration>(*m_init) && static_cast<const VariableDeclaration&>(*m_init).declaration_kind() != DeclarationKind::Var) {
-        wrapper = create_ast_node<BlockStatement>(source_range());
-        NonnullRefPtrVector<VariableDeclaration> decls;
-        decls.append(*static_cast<const VariableDeclaration*>(m_init.ptr()));
-        wrapper->add_variables(decls);
-        interpreter.enter_scope(*wrapper, ScopeType::Block, global_object);
-    }
+    if (m_scope_wrapper)
+        interpreter.enter_scope(*m_scope_wrapper, ScopeType::Block, global_object);
 
     auto wrapper_cleanup = ScopeGuard([&] {
-        if (wrapper)
-            interpreter.exit_scope(*wrapper);
+        if (m_scope_wrapper)
+            interpreter.exit_scope(*m_scope_wrapper);
     });
 
     Value last_value = js_undefined();
@@ -1305,6 +1339,9 @@ Value Identifier::execute(Interpreter& interpreter, GlobalObject& global_object)
     interpreter.enter_node(*this);
     ScopeGuard exit_node { [&] { interpreter.exit_node(*this); } };
 
+    if (auto* variable = interpreter.vm().find_binding(m_binding_location))
+        return variable->value;
+
     auto value = interpreter.vm().get_variable(string(), global_object);
     if (value.is_empty()) {
         interpreter.vm().throw_exception<ReferenceError>(global_object, ErrorType::UnknownIdentifier, string());
@@ -1442,9 +1479,16 @@ Value AssignmentExpression::execute(Interpreter& interpreter, GlobalObject& glob
     if (interpreter.exception())
         return {};
 
-    auto reference = m_lhs->to_reference(interpreter, global_object);
-    if (interpreter.exception())
-        return {};
+    // Local variables the parser could resolve are assigned to directly, without creating a Reference.
+    auto* identifier = is<Identifier>(*m_lhs) ? static_cast<const Identifier*>(m_lhs.ptr()) : nullptr;
+    bool assign_to_binding = identifier && interpreter.vm().find_binding(identifier->binding_location());
+
+    Reference reference;
+    if (!assign_to_binding) {
+        reference = m_lhs->to_reference(interpreter, global_object);
+        if (interpreter.exception())
+            return {};
+    }
 
     if (m_op == AssignmentOp::Assignment) {
         rhs_result = m_rhs->execute(interpreter, global_object);
@@ -1452,6 +1496,21 @@ Value AssignmentExpression::execute(Interpreter& interpreter, GlobalObject& glob
             return {};
     }
 
+    if (assign_to_binding) {
+        if (auto* variable = interpreter.vm().find_binding(identifier->binding_location())) {
+            if (variable->declaration_kind == DeclarationKind::Const) {
+                interpreter.vm().throw_exception<TypeError>(global_object, ErrorType::InvalidAssignToConst);
+                return {};
+            }
+            update_function_name(rhs_result, identifier->string());
+            variable->value = rhs_result;
+            return rhs_result;
+        }
+        reference = m_lhs->to_reference(interpreter, global_object);
+        if (interpreter.exception())
+            return {};
+    }
+
     if (reference.is_unresolvable()) {
         interpreter.vm().throw_exception<ReferenceError>(global_object, ErrorType::InvalidLeftHandAssignment);
         return {};
@@ -1469,12 +1528,22 @@ Value UpdateExpression::execute(Interpreter& interpreter, GlobalObject& global_o
     interpreter.enter_node(*this);
     ScopeGuard exit_node { [&] { interpreter.exit_node(*this); } };
 
-    auto reference = m_argument->to_reference(interpreter, global_object);
-    if (interpreter.exception())
-        return {};
-    auto old_value = reference.get(global_object);
-    if (interpreter.exception())
-        return {};
+    // Local variables the parser could resolve are updated directly, without creating a Reference.
+    auto* identifier = is<Identifier>(*m_argument) ? static_cast<const Identifier*>(m_argument.ptr()) : nullptr;
+    Variable* variable = identifier ? interpreter.vm().find_binding(identifier->binding_location()) : nullptr;
+
+    Reference reference;
+    Value old_value;
+    if (variable) {
+        old_value = variable->value;
+    } else {
+        reference = m_argument->to_reference(interpreter, global_object);
+        if (interpreter.exception())
+            return {};
+        old_value = reference.get(global_object);
+        if (interpreter.exception())
+            return {};
+    }
     old_value = old_value.to_numeric(global_object);
     if (interpreter.exception())
         return {};
@@ -1497,6 +1566,18 @@ Value UpdateExpression::execute(Interpreter& interpreter, GlobalObject& global_o
         VERIFY_NOT_REACHED();
     }
 
+    if (variable) {
+        // to_numeric() may have run user code, so look the binding up again before writing to it.
+        variable = interpreter.vm().find_binding(identifier->binding_location());
+        if (variable && variable->declaration_kind != DeclarationKind::Const) {
+            variable->value = new_value;
+            return m_prefixed ? new_value : old_value;
+        }
+        reference = m_argument->to_reference(interpreter, global_object);
+        if (interpreter.exception())
+            return {};
+    }
+
     reference.put(global_object, new_value);
     if (interpreter.exception())
         return {};
@@ -1600,7 +1681,10 @@ Value VariableDeclaration::execute(Interpreter& interpreter, GlobalObject& globa
                 return {};
             auto variable_name = declarator.id().string();
             update_function_name(initalizer_result, variable_name);
-            interpreter.vm().set_variable(variable_name, initalizer_result, global_object, true);
+            if (auto* variable = interpreter.vm().find_binding(declarator.id().binding_location()))
+                variable->value = initalizer_result;
+            else
+                interpreter.vm().set_variable(variable_name, initalizer_result, global_object, true);
         }
     }
     return js_undefined();
@@ -1794,6 +1878,8 @@ Value MemberExpression::execute(Interpreter& interpreter, GlobalObject& global_o
     auto property_name = computed_property_name(interpreter, global_object);
     if (!property_name.is_valid())
         return {};
+    if (!is_computed())
+        return m_property_cache.get(*object_result, property_name);
     return object_result->get(property_name).value_or(js_undefined());
 }
 
@@ -2043,9 +2129,8 @@ Value TryStatement::execute(Interpreter& interpreter, GlobalObject& global_objec
         if (m_handler) {
             interpreter.vm().clear_exception();
 
-            HashMap<FlyString, Variable> parameters;
-            parameters.set(m_handler->parameter(), Variable { exception->value(), DeclarationKind::Var });
-            auto* catch_scope = interpreter.heap().allocate<LexicalEnvironment>(global_object, move(parameters), interpreter.vm().call_frame().scope);
+            auto* catch_scope = interpreter.heap().allocate<LexicalEnvironment>(global_object, m_handler->layout(), interpreter.vm().call_frame().scope);
+            catch_scope->variable_at(0).value = exception->value();
             TemporaryChange<ScopeObject*> scope_change(interpreter.vm().call_frame().scope, catch_scope);
             interpreter.execute_statement(global_object, m_handler->body());
         }
@@ -2251,6 +2336,10 @@ Value DebuggerStatement::execute(Interpreter& interpreter, GlobalObject&) const
 
 void ScopeNode::add_variables(NonnullRefPtrVector<VariableDeclaration> variables)
 {
+    for (auto& declaration : variables) {
+        for (auto& declarator : declaration.declarations())
+            m_layout->add(declarator.id().string(), declaration.declaration_kind());
+    }
     m_variables.append(move(variables));
 }
 
@@ -0,0 +1,609 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <AK/Format.h>
+#include <LibJS/AST.h>
+#include <LibJS/Bytecode/Generator.h>
+#include <LibJS/Bytecode/Op.h>
+#include <LibJS/Bytecode/Register.h>
+
+namespace JS {
+
+Optional<Bytecode::Register> ASTNode::generate_bytecode(Bytecode::Generator& generator) const
+{
+    // Anything without a lowering of its own makes the whole program fall back to the AST interpreter.
+    generator.fail();
+    return {};
+}
+
+Optional<Bytecode::Register> ScopeNode::generate_bytecode(Bytecode::Generator& generator) const
+{
+    if (!label().is_null()) {
+        generator.fail();
+        return {};
+    }
+
+    generator.enter_scope(*this);
+    for (auto& child : children()) {
+        (void)child.generate_bytecode(generator);
+        if (generator.has_failed())
+            return {};
+    }
+    generator.exit_scope(*this);
+    return {};
+}
+
+Optional<Bytecode::Register> EmptyStatement::generate_bytecode(Bytecode::Generator&) const
+{
+    return {};
+}
+
+Optional<Bytecode::Register> ExpressionStatement::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto value = generator.generate_expression(m_expression);
+    generator.emit<Bytecode::Op::Move>(generator.completion_register(), value);
+    return {};
+}
+
+Optional<Bytecode::Register> FunctionDeclaration::generate_bytecode(Bytecode::Generator&) const
+{
+    // Function declarations are instantiated when their enclosing scope is entered.
+    return {};
+}
+
+Optional<Bytecode::Register> BinaryExpression::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto lhs = generator.generate_expression(m_lhs);
+    auto rhs = generator.generate_expression(m_rhs);
+    auto dst = generator.allocate_register();
+
+    switch (m_op) {
+#define __JS_BINARY_OP_CASE(ast_op, bytecode_op)                     \
+    case BinaryOp::ast_op:                                           \
+        generator.emit<Bytecode::Op::bytecode_op>(dst, lhs, rhs); \
+        break;
+        __JS_BINARY_OP_CASE(Addition, Add)
+        __JS_BINARY_OP_CASE(Subtraction, Sub)
+        __JS_BINARY_OP_CASE(Multiplication, Mul)
+        __JS_BINARY_OP_CASE(Division, Div)
+        __JS_BINARY_OP_CASE(Modulo, Mod)
+        __JS_BINARY_OP_CASE(Exponentiation, Exp)
+        __JS_BINARY_OP_CASE(TypedEquals, TypedEquals)
+        __JS_BINARY_OP_CASE(TypedInequals, TypedInequals)
+        __JS_BINARY_OP_CASE(AbstractEquals, AbstractEquals)
+        __JS_BINARY_OP_CASE(AbstractInequals, AbstractInequals)
+        __JS_BINARY_OP_CASE(GreaterThan, GreaterThan)
+        __JS_BINARY_OP_CASE(GreaterThanEquals, GreaterThanEquals)
+        __JS_BINARY_OP_CASE(LessThan, LessThan)
+        __JS_BINARY_OP_CASE(LessThanEquals, LessThanEquals)
+        __JS_BINARY_OP_CASE(BitwiseAnd, BitwiseAnd)
+        __JS_BINARY_OP_CASE(BitwiseOr, BitwiseOr)
+        __JS_BINARY_OP_CASE(BitwiseXor, BitwiseXor)
+        __JS_BINARY_OP_CASE(LeftShift, LeftShift)
+        __JS_BINARY_OP_CASE(RightShift, RightShift)
+        __JS_BINARY_OP_CASE(UnsignedRightShift, UnsignedRightShift)
+        __JS_BINARY_OP_CASE(In, In)
+        __JS_BINARY_OP_CASE(InstanceOf, InstanceOf)
+#undef __JS_BINARY_OP_CASE
+    default:
+        VERIFY_NOT_REACHED();
+    }
+    return dst;
+}
+
+Optional<Bytecode::Register> LogicalExpression::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto dst = generator.allocate_register();
+    generator.emit<Bytecode::Op::Move>(dst, generator.generate_expression(m_lhs));
+
+    Bytecode::Op::Jump* skip_rhs = nullptr;
+    switch (m_op) {
+    case LogicalOp::And:
+        skip_rhs = &generator.emit<Bytecode::Op::JumpIfFalse>(dst);
+        break;
+    case LogicalOp::Or:
+        skip_rhs = &generator.emit<Bytecode::Op::JumpIfTrue>(dst);
+        break;
+    case LogicalOp::NullishCoalescing:
+        skip_rhs = &generator.emit<Bytecode::Op::JumpIfNotNullish>(dst);
+        break;
+    default:
+        VERIFY_NOT_REACHED();
+    }
+
+    generator.emit<Bytecode::Op::Move>(dst, generator.generate_expression(m_rhs));
+    skip_rhs->set_target(generator.make_label());
+    return dst;
+}
+
+Optional<Bytecode::Register> UnaryExpression::generate_bytecode(Bytecode::Generator& generator) const
+{
+    if (m_op == UnaryOp::Delete) {
+        generator.fail();
+        return {};
+    }
+
+    Bytecode::Register src = [&] {
+        // typeof on an undeclared identifier is "undefined" rather than a ReferenceError.
+        if (m_op == UnaryOp::Typeof && is<Identifier>(*m_lhs)) {
+            auto src = generator.allocate_register();
+            auto& identifier = static_cast<const Identifier&>(*m_lhs);
+            generator.emit<Bytecode::Op::GetVariable>(src, identifier.string(), identifier.binding_location(), Bytecode::Op::GetVariable::ThrowIfMissing::No);
+            return src;
+        }
+        return generator.generate_expression(m_lhs);
+    }();
+
+    auto dst = generator.allocate_register();
+    switch (m_op) {
+    case UnaryOp::BitwiseNot:
+        generator.emit<Bytecode::Op::BitwiseNot>(dst, src);
+        break;
+    case UnaryOp::Not:
+        generator.emit<Bytecode::Op::Not>(dst, src);
+        break;
+    case UnaryOp::Plus:
+        generator.emit<Bytecode::Op::UnaryPlus>(dst, src);
+        break;
+    case UnaryOp::Minus:
+        generator.emit<Bytecode::Op::UnaryMinus>(dst, src);
+        break;
+    case UnaryOp::Typeof:
+        generator.emit<Bytecode::Op::Typeof>(dst, src);
+        break;
+    case UnaryOp::Void:
+        generator.emit<Bytecode::Op::Load>(dst, js_undefined());
+        break;
+    default:
+        VERIFY_NOT_REACHED();
+    }
+    return dst;
+}
+
+Optional<Bytecode::Register> SequenceExpression::generate_bytecode(Bytecode::Generator& generator) const
+{
+    Optional<Bytecode::Register> last_value;
+    for (auto& expression : m_expressions)
+        last_value = generator.generate_expression(expression);
+    return last_value;
+}
+
+Optional<Bytecode::Register> BooleanLiteral::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto dst = generator.allocate_register();
+    generator.emit<Bytecode::Op::Load>(dst, Value(m_value));
+    return dst;
+}
+
+Optional<Bytecode::Register> NumericLiteral::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto dst = generator.allocate_register();
+    generator.emit<Bytecode::Op::Load>(dst, Value(m_value));
+    return dst;
+}
+
+Optional<Bytecode::Register> StringLiteral::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto dst = generator.allocate_register();
+    generator.emit<Bytecode::Op::NewString>(dst, m_value);
+    return dst;
+}
+
+Optional<Bytecode::Register> NullLiteral::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto dst = generator.allocate_register();
+    generator.emit<Bytecode::Op::Load>(dst, js_null());
+    return dst;
+}
+
+Optional<Bytecode::Register> Identifier::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto dst = generator.allocate_register();
+    generator.emit<Bytecode::Op::GetVariable>(dst, m_string, m_binding_location);
+    return dst;
+}
+
+Optional<Bytecode::Register> ObjectExpression::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto dst = generator.allocate_register();
+    generator.emit<Bytecode::Op::NewObject>(dst);
+
+    for (auto& property : m_properties) {
+        // Accessors, spreads and methods need function name and home object bookkeeping the AST interpreter does.
+        if (property.type() != ObjectProperty::Type::KeyValue || property.is_method() || is<FunctionExpression>(property.value()) || is<ClassExpression>(property.value())) {
+            generator.fail();
+            return {};
+        }
+        auto key = generator.generate_expression(property.key());
+        auto value = generator.generate_expression(property.value());
+        generator.emit<Bytecode::Op::DefineProperty>(dst, key, value);
+    }
+    return dst;
+}
+
+Optional<Bytecode::Register> ArrayExpression::generate_bytecode(Bytecode::Generator& generator) const
+{
+    Vector<Bytecode::Register> elements;
+    elements.ensure_capacity(m_elements.size());
+    for (auto& element : m_elements) {
+        if (!element || is<SpreadExpression>(*element)) {
+            generator.fail();
+            return {};
+        }
+        elements.append(generator.generate_expression(*element));
+    }
+    auto dst = generator.allocate_register();
+    generator.emit<Bytecode::Op::NewArray>(dst, move(elements));
+    return dst;
+}
+
+Optional<Bytecode::Register> MemberExpression::generate_bytecode(Bytecode::Generator& generator) const
+{
+    if (is<SuperExpression>(*m_object)) {
+        generator.fail();
+        return {};
+    }
+
+    auto base = generator.generate_expression(m_object);
+    auto dst = generator.allocate_register();
+    if (is_computed()) {
+        auto property = generator.generate_expression(m_property);
+        generator.emit<Bytecode::Op::GetByValue>(dst, base, property);
+    } else {
+        generator.emit<Bytecode::Op::GetById>(dst, base, static_cast<const Identifier&>(*m_property).string());
+    }
+    return dst;
+}
+
+Optional<Bytecode::Register> ConditionalExpression::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto dst = generator.allocate_register();
+    auto test = generator.generate_expression(m_test);
+    auto& jump_to_alternate = generator.emit<Bytecode::Op::JumpIfFalse>(test);
+
+    generator.emit<Bytecode::Op::Move>(dst, generator.generate_expression(m_consequent));
+    auto& jump_to_end = generator.emit<Bytecode::Op::Jump>();
+
+    jump_to_alternate.set_target(generator.make_label());
+    generator.emit<Bytecode::Op::Move>(dst, generator.generate_expression(m_alternate));
+
+    jump_to_end.set_target(generator.make_label());
+    return dst;
+}
+
+Optional<Bytecode::Register> CallExpression::generate_bytecode(Bytecode::Generator& generator) const
+{
+    if (is<NewExpression>(*this) || is<SuperExpression>(*m_callee)) {
+        generator.fail();
+        return {};
+    }
+
+    Optional<Bytecode::Register> this_value;
+    Bytecode::Register callee = [&] {
+        if (is<MemberExpression>(*m_callee)) {
+            auto& member_expression = static_cast<const MemberExpression&>(*m_callee);
+            if (is<SuperExpression>(member_expression.object())) {
+                generator.fail();
+                return generator.allocate_register();
+            }
+            auto base = generator.generate_expression(member_expression.object());
+            this_value = base;
+            auto callee = generator.allocate_register();
+            if (member_expression.is_computed()) {
+                auto property = generator.generate_expression(member_expression.property());
+                generator.emit<Bytecode::Op::GetByValue>(callee, base, property);
+            } else {
+                generator.emit<Bytecode::Op::GetById>(callee, base, static_cast<const Identifier&>(member_expression.property()).string());
+            }
+            return callee;
+        }
+        return generator.generate_expression(m_callee);
+    }();
+
+    Vector<Bytecode::Register> arguments;
+    arguments.ensure_capacity(m_arguments.size());
+    for (auto& argument : m_arguments) {
+        if (argument.is_spread) {
+            generator.fail();
+            return {};
+        }
+        arguments.append(generator.generate_expression(argument.value));
+    }
+
+    String callee_description;
+    if (is<Identifier>(*m_callee))
+        callee_description = static_cast<const Identifier&>(*m_callee).string();
+    else if (is<MemberExpression>(*m_callee))
+        callee_description = static_cast<const MemberExpression&>(*m_callee).to_string_approximation();
+
+    auto dst = generator.allocate_register();
+    generator.emit<Bytecode::Op::Call>(dst, callee, this_value, move(arguments), move(callee_description));
+    return dst;
+}
+
+// Emits the ops that store |value| into the location described by |target|, which must be an identifier or a member expression
+// whose base (and computed property, if any) have already been evaluated into |base| and |property|.
+static void generate_store(Bytecode::Generator& generator, const Expression& target, Optional<Bytecode::Register> base, Optional<Bytecode::Register> property, Bytecode::Register value)
+{
+    if (is<Identifier>(target)) {
+        auto& identifier = static_cast<const Identifier&>(target);
+        generator.emit<Bytecode::Op::SetVariable>(identifier.string(), identifier.binding_location(), value);
+        return;
+    }
+    auto& member_expression = static_cast<const MemberExpression&>(target);
+    if (member_expression.is_computed())
+        generator.emit<Bytecode::Op::PutByValue>(*base, *property, value);
+    else
+        generator.emit<Bytecode::Op::PutById>(*base, static_cast<const Identifier&>(member_expression.property()).string(), value);
+}
+
+static Bytecode::Register generate_load(Bytecode::Generator& generator, const Expression& target, Optional<Bytecode::Register> base, Optional<Bytecode::Register> property)
+{
+    auto dst = generator.allocate_register();
+    if (is<Identifier>(target)) {
+        auto& identifier = static_cast<const Identifier&>(target);
+        generator.emit<Bytecode::Op::GetVariable>(dst, identifier.string(), identifier.binding_location());
+        return dst;
+    }
+    auto& member_expression = static_cast<const MemberExpression&>(target);
+    if (member_expression.is_computed())
+        generator.emit<Bytecode::Op::GetByValue>(dst, *base, *property);
+    else
+        generator.emit<Bytecode::Op::GetById>(dst, *base, static_cast<const Identifier&>(member_expression.property()).string());
+    return dst;
+}
+
+// Evaluates the base and computed property of a member expression target, or fails for unsupported targets.
+static bool generate_reference(Bytecode::Generator& generator, const Expression& target, Optional<Bytecode::Register>& base, Optional<Bytecode::Register>& property)
+{
+    if (is<Identifier>(target))
+        return true;
+    if (!is<MemberExpression>(target) || is<SuperExpression>(static_cast<const MemberExpression&>(target).object())) {
+        generator.fail();
+        return false;
+    }
+    auto& member_expression = static_cast<const MemberExpression&>(target);
+    base = generator.generate_expression(member_expression.object());
+    if (member_expression.is_computed())
+        property = generator.generate_expression(member_expression.property());
+    return true;
+}
+
+Optional<Bytecode::Register> AssignmentExpression::generate_bytecode(Bytecode::Generator& generator) const
+{
+    if (m_op == AssignmentOp::AndAssignment || m_op == AssignmentOp::OrAssignment || m_op == AssignmentOp::NullishAssignment) {
+        generator.fail();
+        return {};
+    }
+
+    // Function values would need their name updated from the assignment target.
+    if (is<FunctionExpression>(*m_rhs) || is<ClassExpression>(*m_rhs)) {
+        generator.fail();
+        return {};
+    }
+
+    Optional<Bytecode::Register> base;
+    Optional<Bytecode::Register> property;
+    if (!generate_reference(generator, m_lhs, base, property))
+        return {};
+
+    if (m_op == AssignmentOp::Assignment) {
+        auto value = generator.generate_expression(m_rhs);
+        generate_store(generator, m_lhs, base, property, value);
+        return value;
+    }
+
+    auto lhs = generate_load(generator, m_lhs, base, property);
+    auto rhs = generator.generate_expression(m_rhs);
+    auto dst = generator.allocate_register();
+
+    switch (m_op) {
+#define __JS_ASSIGNMENT_OP_CASE(ast_op, bytecode_op)                 \
+    case AssignmentOp::ast_op:                                       \
+        generator.emit<Bytecode::Op::bytecode_op>(dst, lhs, rhs); \
+        break;
+        __JS_ASSIGNMENT_OP_CASE(AdditionAssignment, Add)
+        __JS_ASSIGNMENT_OP_CASE(SubtractionAssignment, Sub)
+        __JS_ASSIGNMENT_OP_CASE(MultiplicationAssignment, Mul)
+        __JS_ASSIGNMENT_OP_CASE(DivisionAssignment, Div)
+        __JS_ASSIGNMENT_OP_CASE(ModuloAssignment, Mod)
+        __JS_ASSIGNMENT_OP_CASE(ExponentiationAssignment, Exp)
+        __JS_ASSIGNMENT_OP_CASE(BitwiseAndAssignment, BitwiseAnd)
+        __JS_ASSIGNMENT_OP_CASE(BitwiseOrAssignment, BitwiseOr)
+        __JS_ASSIGNMENT_OP_CASE(BitwiseXorAssignment, BitwiseXor)
+        __JS_ASSIGNMENT_OP_CASE(LeftShiftAssignment, LeftShift)
+        __JS_ASSIGNMENT_OP_CASE(RightShiftAssignment, RightShift)
+        __JS_ASSIGNMENT_OP_CASE(UnsignedRightShiftAssignment, UnsignedRightShift)
+#undef __JS_ASSIGNMENT_OP_CASE
+    default:
+        VERIFY_NOT_REACHED();
+    }
+
+    generate_store(generator, m_lhs, base, property, dst);
+    return dst;
+}
+
+Optional<Bytecode::Register> UpdateExpression::generate_bytecode(Bytecode::Generator& generator) const
+{
+    Optional<Bytecode::Register> base;
+    Optional<Bytecode::Register> property;
+    if (!generate_reference(generator, m_argument, base, property))
+        return {};
+
+    auto old_value = generate_load(generator, m_argument, base, property);
+    auto numeric_value = generator.allocate_register();
+    generator.emit<Bytecode::Op::ToNumeric>(numeric_value, old_value);
+
+    auto new_value = generator.allocate_register();
+    if (m_op == UpdateOp::Increment)
+        generator.emit<Bytecode::Op::Increment>(new_value, numeric_value);
+    else
+        generator.emit<Bytecode::Op::Decrement>(new_value, numeric_value);
+
+    generate_store(generator, m_argument, base, property, new_value);
+    return m_prefixed ? new_value : numeric_value;
+}
+
+Optional<Bytecode::Register> VariableDeclaration::generate_bytecode(Bytecode::Generator& generator) const
+{
+    for (auto& declarator : m_declarations) {
+        auto* init = declarator.init();
+        if (!init)
+            continue;
+        // Function values would need to be named after the variable.
+        if (is<FunctionExpression>(*init) || is<ClassExpression>(*init)) {
+            generator.fail();
+            return {};
+        }
+        auto value = generator.generate_expression(*init);
+        generator.emit<Bytecode::Op::SetVariable>(declarator.id().string(), declarator.id().binding_location(), value, true);
+    }
+    return {};
+}
+
+Optional<Bytecode::Register> IfStatement::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto predicate = generator.generate_expression(m_predicate);
+    auto& jump_to_alternate = generator.emit<Bytecode::Op::JumpIfFalse>(predicate);
+
+    (void)m_consequent->generate_bytecode(generator);
+    if (!m_alternate) {
+        jump_to_alternate.set_target(generator.make_label());
+        return {};
+    }
+
+    auto& jump_to_end = generator.emit<Bytecode::Op::Jump>();
+    jump_to_alternate.set_target(generator.make_label());
+    (void)m_alternate->generate_bytecode(generator);
+    jump_to_end.set_target(generator.make_label());
+    return {};
+}
+
+Optional<Bytecode::Register> WhileStatement::generate_bytecode(Bytecode::Generator& generator) const
+{
+    if (!label().is_null()) {
+        generator.fail();
+        return {};
+    }
+
+    auto test_label = generator.make_label();
+    auto test = generator.generate_expression(m_test);
+    auto& jump_to_end = generator.emit<Bytecode::Op::JumpIfFalse>(test);
+
+    generator.begin_loop();
+    (void)m_body->generate_bytecode(generator);
+    generator.emit<Bytecode::Op::Jump>(test_label);
+
+    auto end_label = generator.make_label();
+    jump_to_end.set_target(end_label);
+    generator.end_loop(end_label, test_label);
+    return {};
+}
+
+Optional<Bytecode::Register> DoWhileStatement::generate_bytecode(Bytecode::Generator& generator) const
+{
+    if (!label().is_null()) {
+        generator.fail();
+        return {};
+    }
+
+    auto body_label = generator.make_label();
+    generator.begin_loop();
+    (void)m_body->generate_bytecode(generator);
+
+    auto test_label = generator.make_label();
+    auto test = generator.generate_expression(m_test);
+    generator.emit<Bytecode::Op::JumpIfTrue>(test, body_label);
+
+    generator.end_loop(generator.make_label(), test_label);
+    return {};
+}
+
+Optional<Bytecode::Register> ForStatement::generate_bytecode(Bytecode::Generator& generator) const
+{
+    if (!label().is_null()) {
+        generator.fail();
+        return {};
+    }
+
+    // Like the AST interpreter, give let/const declarations in the initializer a scope of their own.
+    if (m_scope_wrapper)
+        generator.enter_scope(*m_scope_wrapper);
+
+    if (m_init) {
+        if (is<Expression>(*m_init))
+            generator.generate_expression(static_cast<const Expression&>(*m_init));
+        else
+            (void)m_init->generate_bytecode(generator);
+    }
+
+    auto test_label = generator.make_label();
+    Bytecode::Op::Jump* jump_to_end = nullptr;
+    if (m_test) {
+        auto test = generator.generate_expression(*m_test);
+        jump_to_end = &generator.emit<Bytecode::Op::JumpIfFalse>(test);
+    }
+
+    generator.begin_loop();
+    (void)m_body->generate_bytecode(generator);
+
+    auto update_label = generator.make_label();
+    if (m_update)
+        generator.generate_expression(*m_update);
+    generator.emit<Bytecode::Op::Jump>(test_label);
+
+    auto end_label = generator.make_label();
+    if (jump_to_end)
+        jump_to_end->set_target(end_label);
+    generator.end_loop(end_label, update_label);
+
+    if (m_scope_wrapper)
+        generator.exit_scope(*m_scope_wrapper);
+    return {};
+}
+
+Optional<Bytecode::Register> BreakStatement::generate_bytecode(Bytecode::Generator& generator) const
+{
+    if (!m_target_label.is_null()) {
+        generator.fail();
+        return {};
+    }
+    generator.emit_break();
+    return {};
+}
+
+Optional<Bytecode::Register> ContinueStatement::generate_bytecode(Bytecode::Generator& generator) const
+{
+    if (!m_target_label.is_null()) {
+        generator.fail();
+        return {};
+    }
+    generator.emit_continue();
+    return {};
+}
+
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <LibJS/AST.h>
+#include <LibJS/Bytecode/Generator.h>
+
+namespace JS::Bytecode {
+
+Generator::Generator()
+    : m_block(make<Block>())
+{
+}
+
+OwnPtr<Block> Generator::generate(const Program& program)
+{
+    // FIXME: Strict mode changes the semantics of assignments to undeclared variables and primitives,
+    //        which the variable and property ops don't model yet.
+    if (program.is_strict_mode())
+        return {};
+
+    Generator generator;
+    auto completion = generator.allocate_register();
+    VERIFY(completion.index() == generator.completion_register().index());
+
+    (void)program.generate_bytecode(generator);
+    if (generator.has_failed())
+        return {};
+
+    VERIFY(generator.m_scope_stack.is_empty());
+    VERIFY(generator.m_loop_stack.is_empty());
+    return move(generator.m_block);
+}
+
+Register Generator::allocate_register()
+{
+    return Register(m_block->m_register_count++);
+}
+
+Register Generator::generate_expression(const Expression& expression)
+{
+    auto result = expression.generate_bytecode(*this);
+    if (!result.has_value()) {
+        fail();
+        return allocate_register();
+    }
+    return *result;
+}
+
+void Generator::enter_scope(const ScopeNode& scope_node)
+{
+    emit<Op::EnterScope>(scope_node);
+    m_scope_stack.append(&scope_node);
+}
+
+void Generator::exit_scope(const ScopeNode& scope_node)
+{
+    VERIFY(!m_scope_stack.is_empty() && m_scope_stack.last() == &scope_node);
+    emit<Op::ExitScope>(scope_node);
+    m_scope_stack.take_last();
+}
+
+void Generator::begin_loop()
+{
+    m_loop_stack.append({ m_scope_stack.size(), {}, {} });
+}
+
+void Generator::end_loop(Label break_target, Label continue_target)
+{
+    auto frame = m_loop_stack.take_last();
+    for (auto* jump : frame.break_jumps)
+        jump->set_target(break_target);
+    for (auto* jump : frame.continue_jumps)
+        jump->set_target(continue_target);
+}
+
+void Generator::exit_scopes_above(size_t depth)
+{
+    // Exiting the outermost scope entered inside the loop unwinds all the ones nested within it.
+    if (m_scope_stack.size() > depth)
+        emit<Op::ExitScope>(*m_scope_stack[depth]);
+}
+
+void Generator::emit_break()
+{
+    if (m_loop_stack.is_empty()) {
+        fail();
+        return;
+    }
+    exit_scopes_above(m_loop_stack.last().scope_depth);
+    m_loop_stack.last().break_jumps.append(&emit<Op::Jump>());
+}
+
+void Generator::emit_continue()
+{
+    if (m_loop_stack.is_empty()) {
+        fail();
+        return;
+    }
+    exit_scopes_above(m_loop_stack.last().scope_depth);
+    m_loop_stack.last().continue_jumps.append(&emit<Op::Jump>());
+}
+
+}
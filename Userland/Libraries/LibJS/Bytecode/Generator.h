@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <AK/NonnullOwnPtr.h>
+#include <AK/NonnullRefPtrVector.h>
+#include <AK/OwnPtr.h>
+#include <AK/Vector.h>
+#include <LibJS/Bytecode/Block.h>
+#include <LibJS/Bytecode/Label.h>
+#include <LibJS/Bytecode/Op.h>
+#include <LibJS/Bytecode/Register.h>
+#include <LibJS/Forward.h>
+
+namespace JS::Bytecode {
+
+// Lowers an AST to a Block. Nodes without a bytecode lowering mark the generator as failed,
+// in which case generate() returns nullptr and the caller should use the AST interpreter instead.
+class Generator {
+public:
+    static OwnPtr<Block> generate(const Program&);
+
+    Register allocate_register();
+
+    // Register 0 holds the completion value of the program, i.e. the value of the last expression statement.
+    Register completion_register() const { return Register(0); }
+
+    template<typename OpType, typename... Args>
+    OpType& emit(Args&&... args)
+    {
+        auto instruction = make<OpType>(forward<Args>(args)...);
+        auto& instruction_ref = *instruction;
+        m_block->m_instructions.append(move(instruction));
+        return instruction_ref;
+    }
+
+    Label make_label() const { return Label { m_block->m_instructions.size() }; }
+
+    // Generates an expression and returns the register holding its value.
+    Register generate_expression(const Expression&);
+
+    void enter_scope(const ScopeNode&);
+    void exit_scope(const ScopeNode&);
+
+    void begin_loop();
+    void end_loop(Label break_target, Label continue_target);
+    void emit_break();
+    void emit_continue();
+
+    void fail() { m_failed = true; }
+    bool has_failed() const { return m_failed; }
+
+private:
+    Generator();
+
+    struct LoopFrame {
+        size_t scope_depth { 0 };
+        Vector<Op::Jump*> break_jumps;
+        Vector<Op::Jump*> continue_jumps;
+    };
+
+    void exit_scopes_above(size_t depth);
+
+    NonnullOwnPtr<Block> m_block;
+    Vector<const ScopeNode*> m_scope_stack;
+    Vector<LoopFrame> m_loop_stack;
+    bool m_failed { false };
+};
+
+}
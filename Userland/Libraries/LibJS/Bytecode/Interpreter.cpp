@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <LibJS/Bytecode/Block.h>
+#include <LibJS/Bytecode/Instruction.h>
+#include <LibJS/Bytecode/Interpreter.h>
+#include <LibJS/Interpreter.h>
+#include <LibJS/Runtime/GlobalObject.h>
+
+namespace JS::Bytecode {
+
+Interpreter::Interpreter(JS::Interpreter& ast_interpreter, GlobalObject& global_object)
+    : m_ast_interpreter(ast_interpreter)
+    , m_global_object(global_object)
+    , m_vm(global_object.vm())
+    , m_registers(global_object.heap())
+{
+}
+
+Interpreter::~Interpreter()
+{
+}
+
+Value Interpreter::run(const Block& block)
+{
+    VERIFY(!vm().exception());
+
+    m_registers.clear();
+    m_registers.resize(block.register_count());
+    for (auto& value : m_registers)
+        value = js_undefined();
+
+    auto& instructions = block.instructions();
+    size_t pc = 0;
+    while (pc < instructions.size()) {
+        instructions[pc].execute(*this);
+        if (vm().exception())
+            break;
+        if (m_pending_jump.has_value()) {
+            pc = m_pending_jump.release_value();
+            continue;
+        }
+        ++pc;
+    }
+
+    if (vm().exception()) {
+        // Exiting the outermost scope pops everything that was entered above it.
+        if (!m_scope_stack.is_empty())
+            exit_scope(*m_scope_stack.first());
+        m_pending_jump.clear();
+        return {};
+    }
+
+    VERIFY(m_scope_stack.is_empty());
+    return block.register_count() ? m_registers[0] : js_undefined();
+}
+
+void Interpreter::enter_scope(const ScopeNode& scope_node)
+{
+    m_ast_interpreter.enter_scope(scope_node, ScopeType::Block, global_object());
+    m_scope_stack.append(&scope_node);
+}
+
+void Interpreter::exit_scope(const ScopeNode& scope_node)
+{
+    m_ast_interpreter.exit_scope(scope_node);
+    while (!m_scope_stack.is_empty()) {
+        if (m_scope_stack.take_last() == &scope_node)
+            break;
+    }
+}
+
+}
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2020, Liav A. <liavalb@hotmail.co.il>
+ * Copyright (c) 2021, the SerenityOS developers.
  * All rights reserved.
  *
  * Redistribution and use in source and binary forms, with or without
@@ -24,36 +24,34 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+
 #pragma once
 
+#include <AK/Format.h>
 #include <AK/Types.h>
-#include <Kernel/Arch/i386/CPU.h>
-#include <Kernel/Interrupts/GenericInterruptHandler.h>
-#include <Kernel/PCI/Definitions.h>
 
-namespace Kernel {
+namespace JS::Bytecode {
 
-class MSIHandler final : public GenericInterruptHandler {
+// A jump target, expressed as an index into the instruction list of a Block.
+class Label {
 public:
-    virtual ~MSIHandler();
-
-    virtual void handle_interrupt(RegisterState&) override { }
-
-    void enable_irq();
-    void disable_irq();
-
-    virtual bool eoi() override;
+    explicit Label(size_t address)
+        : m_address(address)
+    {
+    }
 
-    virtual size_t sharing_devices_count() const override { return 0; }
-    virtual bool is_shared_handler() const override { return false; }
-    virtual bool is_sharing_with_others() const override { return m_shared_with_others; }
-
-protected:
-    void change_irq_number(u8 irq);
-    explicit MSIHandler(PCI::Address);
+    size_t address() const { return m_address; }
 
 private:
-    bool m_shared_with_others;
-    bool m_enabled;
+    size_t m_address { 0 };
 };
+
 }
+
+template<>
+struct AK::Formatter<JS::Bytecode::Label> : AK::Formatter<FormatString> {
+    void format(FormatBuilder& builder, const JS::Bytecode::Label& value)
+    {
+        Formatter<FormatString>::format(builder, "@{}", value.address());
+    }
+};
@@ -0,0 +1,423 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <AK/StringBuilder.h>
+#include <LibJS/AST.h>
+#include <LibJS/Bytecode/Interpreter.h>
+#include <LibJS/Bytecode/Op.h>
+#include <LibJS/Runtime/Array.h>
+#include <LibJS/Runtime/BigInt.h>
+#include <LibJS/Runtime/Error.h>
+#include <LibJS/Runtime/GlobalObject.h>
+#include <LibJS/Runtime/PropertyName.h>
+#include <LibJS/Runtime/ScopeObject.h>
+#include <LibJS/Runtime/VM.h>
+
+namespace JS::Bytecode::Op {
+
+static Value abstract_inequals(GlobalObject& global_object, Value lhs, Value rhs)
+{
+    return Value(!abstract_eq(global_object, lhs, rhs));
+}
+
+static Value abstract_equals(GlobalObject& global_object, Value lhs, Value rhs)
+{
+    return Value(abstract_eq(global_object, lhs, rhs));
+}
+
+static Value typed_inequals(GlobalObject&, Value lhs, Value rhs)
+{
+    return Value(!strict_eq(lhs, rhs));
+}
+
+static Value typed_equals(GlobalObject&, Value lhs, Value rhs)
+{
+    return Value(strict_eq(lhs, rhs));
+}
+
+static Value not_(GlobalObject&, Value value)
+{
+    return Value(!value.to_boolean());
+}
+
+static Value typeof_(GlobalObject& global_object, Value value)
+{
+    auto& vm = global_object.vm();
+    switch (value.type()) {
+    case Value::Type::Undefined:
+        return js_string(vm, "undefined");
+    case Value::Type::Null:
+        return js_string(vm, "object");
+    case Value::Type::Number:
+        return js_string(vm, "number");
+    case Value::Type::String:
+        return js_string(vm, "string");
+    case Value::Type::Object:
+        if (value.is_function())
+            return js_string(vm, "function");
+        return js_string(vm, "object");
+    case Value::Type::Boolean:
+        return js_string(vm, "boolean");
+    case Value::Type::Symbol:
+        return js_string(vm, "symbol");
+    case Value::Type::BigInt:
+        return js_string(vm, "bigint");
+    default:
+        VERIFY_NOT_REACHED();
+    }
+}
+
+static Value to_numeric(GlobalObject& global_object, Value value)
+{
+    return value.to_numeric(global_object);
+}
+
+// NOTE: Increment and Decrement expect an operand that has already been through ToNumeric.
+static Value increment(GlobalObject& global_object, Value value)
+{
+    if (value.is_number())
+        return Value(value.as_double() + 1);
+    return js_bigint(global_object.heap(), value.as_bigint().big_integer().plus(Crypto::SignedBigInteger { 1 }));
+}
+
+static Value decrement(GlobalObject& global_object, Value value)
+{
+    if (value.is_number())
+        return Value(value.as_double() - 1);
+    return js_bigint(global_object.heap(), value.as_bigint().big_integer().minus(Crypto::SignedBigInteger { 1 }));
+}
+
+void Load::execute(Bytecode::Interpreter& interpreter) const
+{
+    interpreter.reg(m_dst) = m_value;
+}
+
+String Load::to_string() const
+{
+    return String::formatted("Load {}, {}", m_dst, m_value.to_string_without_side_effects());
+}
+
+void Move::execute(Bytecode::Interpreter& interpreter) const
+{
+    interpreter.reg(m_dst) = interpreter.reg(m_src);
+}
+
+String Move::to_string() const
+{
+    return String::formatted("Move {}, {}", m_dst, m_src);
+}
+
+#define JS_DEFINE_BYTECODE_BINARY_OP(OpTitleCase, op_snake_case)                                                            \
+    void OpTitleCase::execute(Bytecode::Interpreter& interpreter) const                                                     \
+    {                                                                                                                       \
+        interpreter.reg(m_dst) = op_snake_case(interpreter.global_object(), interpreter.reg(m_lhs), interpreter.reg(m_rhs)); \
+    }                                                                                                                       \
+    String OpTitleCase::to_string() const                                                                                   \
+    {                                                                                                                       \
+        return String::formatted(#OpTitleCase " {}, {}, {}", m_dst, m_lhs, m_rhs);                                          \
+    }
+
+JS_ENUMERATE_BYTECODE_BINARY_OPS(JS_DEFINE_BYTECODE_BINARY_OP)
+#undef JS_DEFINE_BYTECODE_BINARY_OP
+
+#define JS_DEFINE_BYTECODE_UNARY_OP(OpTitleCase, op_snake_case)                                 \
+    void OpTitleCase::execute(Bytecode::Interpreter& interpreter) const                         \
+    {                                                                                           \
+        interpreter.reg(m_dst) = op_snake_case(interpreter.global_object(), interpreter.reg(m_src)); \
+    }                                                                                           \
+    String OpTitleCase::to_string() const                                                       \
+    {                                                                                           \
+        return String::formatted(#OpTitleCase " {}, {}", m_dst, m_src);                         \
+    }
+
+JS_ENUMERATE_BYTECODE_UNARY_OPS(JS_DEFINE_BYTECODE_UNARY_OP)
+#undef JS_DEFINE_BYTECODE_UNARY_OP
+
+void NewString::execute(Bytecode::Interpreter& interpreter) const
+{
+    interpreter.reg(m_dst) = js_string(interpreter.vm(), m_string);
+}
+
+String NewString::to_string() const
+{
+    return String::formatted("NewString {}, \"{}\"", m_dst, m_string);
+}
+
+void NewObject::execute(Bytecode::Interpreter& interpreter) const
+{
+    interpreter.reg(m_dst) = Object::create_empty(interpreter.global_object());
+}
+
+String NewObject::to_string() const
+{
+    return String::formatted("NewObject {}", m_dst);
+}
+
+void NewArray::execute(Bytecode::Interpreter& interpreter) const
+{
+    auto* array = Array::create(interpreter.global_object());
+    for (auto& element : m_elements)
+        array->indexed_properties().append(interpreter.reg(element));
+    interpreter.reg(m_dst) = array;
+}
+
+String NewArray::to_string() const
+{
+    StringBuilder builder;
+    builder.appendff("NewArray {}", m_dst);
+    if (!m_elements.is_empty()) {
+        builder.append(", [");
+        for (size_t i = 0; i < m_elements.size(); ++i) {
+            if (i != 0)
+                builder.append(", ");
+            builder.appendff("{}", m_elements[i]);
+        }
+        builder.append(']');
+    }
+    return builder.to_string();
+}
+
+void GetVariable::execute(Bytecode::Interpreter& interpreter) const
+{
+    if (auto* variable = interpreter.vm().find_binding(m_binding_location)) {
+        interpreter.reg(m_dst) = variable->value;
+        return;
+    }
+    auto value = interpreter.vm().get_variable(m_identifier, interpreter.global_object());
+    if (interpreter.vm().exception())
+        return;
+    if (value.is_empty()) {
+        if (m_throw_if_missing == ThrowIfMissing::Yes) {
+            interpreter.vm().throw_exception<ReferenceError>(interpreter.global_object(), ErrorType::UnknownIdentifier, m_identifier);
+            return;
+        }
+        value = js_undefined();
+    }
+    interpreter.reg(m_dst) = value;
+}
+
+String GetVariable::to_string() const
+{
+    return String::formatted("GetVariable {}, {}", m_dst, m_identifier);
+}
+
+void SetVariable::execute(Bytecode::Interpreter& interpreter) const
+{
+    if (auto* variable = interpreter.vm().find_binding(m_binding_location)) {
+        if (!m_is_initialization && variable->declaration_kind == DeclarationKind::Const) {
+            interpreter.vm().throw_exception<TypeError>(interpreter.global_object(), ErrorType::InvalidAssignToConst);
+            return;
+        }
+        variable->value = interpreter.reg(m_src);
+        return;
+    }
+    interpreter.vm().set_variable(m_identifier, interpreter.reg(m_src), interpreter.global_object(), m_is_initialization);
+}
+
+String SetVariable::to_string() const
+{
+    return String::formatted("SetVariable {}, {}{}", m_identifier, m_src, m_is_initialization ? " (initialization)" : "");
+}
+
+void GetById::execute(Bytecode::Interpreter& interpreter) const
+{
+    auto* object = interpreter.reg(m_base).to_object(interpreter.global_object());
+    if (!object)
+        return;
+    interpreter.reg(m_dst) = m_cache.get(*object, m_property);
+}
+
+String GetById::to_string() const
+{
+    return String::formatted("GetById {}, {}, {}", m_dst, m_base, m_property);
+}
+
+void PutById::execute(Bytecode::Interpreter& interpreter) const
+{
+    auto* object = interpreter.reg(m_base).to_object(interpreter.global_object());
+    if (!object)
+        return;
+    m_cache.put(*object, m_property, interpreter.reg(m_src));
+}
+
+String PutById::to_string() const
+{
+    return String::formatted("PutById {}, {}, {}", m_base, m_property, m_src);
+}
+
+void GetByValue::execute(Bytecode::Interpreter& interpreter) const
+{
+    auto* object = interpreter.reg(m_base).to_object(interpreter.global_object());
+    if (!object)
+        return;
+    auto property_name = PropertyName::from_value(interpreter.global_object(), interpreter.reg(m_property));
+    if (interpreter.vm().exception())
+        return;
+    interpreter.reg(m_dst) = object->get(property_name).value_or(js_undefined());
+}
+
+String GetByValue::to_string() const
+{
+    return String::formatted("GetByValue {}, {}, {}", m_dst, m_base, m_property);
+}
+
+void PutByValue::execute(Bytecode::Interpreter& interpreter) const
+{
+    auto* object = interpreter.reg(m_base).to_object(interpreter.global_object());
+    if (!object)
+        return;
+    auto property_name = PropertyName::from_value(interpreter.global_object(), interpreter.reg(m_property));
+    if (interpreter.vm().exception())
+        return;
+    object->put(property_name, interpreter.reg(m_src));
+}
+
+String PutByValue::to_string() const
+{
+    return String::formatted("PutByValue {}, {}, {}", m_base, m_property, m_src);
+}
+
+void DefineProperty::execute(Bytecode::Interpreter& interpreter) const
+{
+    auto property_name = PropertyName::from_value(interpreter.global_object(), interpreter.reg(m_property));
+    if (interpreter.vm().exception())
+        return;
+    interpreter.reg(m_object).as_object().define_property(property_name, interpreter.reg(m_src));
+}
+
+String DefineProperty::to_string() const
+{
+    return String::formatted("DefineProperty {}, {}, {}", m_object, m_property, m_src);
+}
+
+void Jump::execute(Bytecode::Interpreter& interpreter) const
+{
+    interpreter.jump(*m_target);
+}
+
+String Jump::to_string() const
+{
+    return String::formatted("Jump {}", *m_target);
+}
+
+void JumpIfTrue::execute(Bytecode::Interpreter& interpreter) const
+{
+    if (interpreter.reg(m_condition).to_boolean())
+        interpreter.jump(*m_target);
+}
+
+String JumpIfTrue::to_string() const
+{
+    return String::formatted("JumpIfTrue {}, {}", m_condition, *m_target);
+}
+
+void JumpIfFalse::execute(Bytecode::Interpreter& interpreter) const
+{
+    if (!interpreter.reg(m_condition).to_boolean())
+        interpreter.jump(*m_target);
+}
+
+String JumpIfFalse::to_string() const
+{
+    return String::formatted("JumpIfFalse {}, {}", m_condition, *m_target);
+}
+
+void JumpIfNotNullish::execute(Bytecode::Interpreter& interpreter) const
+{
+    if (!interpreter.reg(m_condition).is_nullish())
+        interpreter.jump(*m_target);
+}
+
+String JumpIfNotNullish::to_string() const
+{
+    return String::formatted("JumpIfNotNullish {}, {}", m_condition, *m_target);
+}
+
+void Call::execute(Bytecode::Interpreter& interpreter) const
+{
+    auto& vm = interpreter.vm();
+    auto& global_object = interpreter.global_object();
+    auto callee = interpreter.reg(m_callee);
+
+    if (!callee.is_function()) {
+        if (m_callee_description.is_null())
+            vm.throw_exception<TypeError>(global_object, ErrorType::IsNotA, callee.to_string_without_side_effects(), "function");
+        else
+            vm.throw_exception<TypeError>(global_object, ErrorType::IsNotAEvaluatedFrom, callee.to_string_without_side_effects(), "function", m_callee_description);
+        return;
+    }
+
+    Value this_value = &global_object;
+    if (m_this_value.has_value()) {
+        this_value = interpreter.reg(*m_this_value).to_object(global_object);
+        if (vm.exception())
+            return;
+    }
+
+    MarkedValueList arguments(vm.heap());
+    arguments.ensure_capacity(m_arguments.size());
+    for (auto& argument : m_arguments)
+        arguments.append(interpreter.reg(argument));
+
+    auto result = vm.call(callee.as_function(), this_value, move(arguments));
+    if (vm.exception())
+        return;
+    interpreter.reg(m_dst) = result;
+}
+
+String Call::to_string() const
+{
+    StringBuilder builder;
+    builder.appendff("Call {}, {}", m_dst, m_callee);
+    if (m_this_value.has_value())
+        builder.appendff(", this={}", *m_this_value);
+    for (auto& argument : m_arguments)
+        builder.appendff(", {}", argument);
+    return builder.to_string();
+}
+
+void EnterScope::execute(Bytecode::Interpreter& interpreter) const
+{
+    interpreter.enter_scope(m_scope_node);
+}
+
+String EnterScope::to_string() const
+{
+    return String::formatted("EnterScope {}", &m_scope_node);
+}
+
+void ExitScope::execute(Bytecode::Interpreter& interpreter) const
+{
+    interpreter.exit_scope(m_scope_node);
+}
+
+String ExitScope::to_string() const
+{
+    return String::formatted("ExitScope {}", &m_scope_node);
+}
+
+}
@@ -0,0 +1,452 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <AK/FlyString.h>
+#include <AK/Optional.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
+#include <LibJS/Bytecode/Instruction.h>
+#include <LibJS/Bytecode/Label.h>
+#include <LibJS/Bytecode/Register.h>
+#include <LibJS/Forward.h>
+#include <LibJS/Runtime/PropertyCache.h>
+#include <LibJS/Runtime/ScopeLayout.h>
+#include <LibJS/Runtime/Value.h>
+
+#define JS_ENUMERATE_BYTECODE_BINARY_OPS(O)         \
+    O(Add, add)                                     \
+    O(Sub, sub)                                     \
+    O(Mul, mul)                                     \
+    O(Div, div)                                     \
+    O(Exp, exp)                                     \
+    O(Mod, mod)                                     \
+    O(In, in)                                       \
+    O(InstanceOf, instance_of)                      \
+    O(GreaterThan, greater_than)                    \
+    O(GreaterThanEquals, greater_than_equals)       \
+    O(LessThan, less_than)                          \
+    O(LessThanEquals, less_than_equals)             \
+    O(AbstractInequals, abstract_inequals)          \
+    O(AbstractEquals, abstract_equals)              \
+    O(TypedInequals, typed_inequals)                \
+    O(TypedEquals, typed_equals)                    \
+    O(BitwiseAnd, bitwise_and)                      \
+    O(BitwiseOr, bitwise_or)                        \
+    O(BitwiseXor, bitwise_xor)                      \
+    O(LeftShift, left_shift)                        \
+    O(RightShift, right_shift)                      \
+    O(UnsignedRightShift, unsigned_right_shift)
+
+#define JS_ENUMERATE_BYTECODE_UNARY_OPS(O) \
+    O(BitwiseNot, bitwise_not)             \
+    O(Not, not_)                           \
+    O(UnaryPlus, unary_plus)               \
+    O(UnaryMinus, unary_minus)             \
+    O(Typeof, typeof_)                     \
+    O(ToNumeric, to_numeric)               \
+    O(Increment, increment)                \
+    O(Decrement, decrement)
+
+namespace JS::Bytecode::Op {
+
+// Loads a constant into a register. Only non-cell values (numbers, booleans, null, undefined) may be used here,
+// since instructions are not visited by the garbage collector.
+class Load final : public Instruction {
+public:
+    Load(Register dst, Value value)
+        : m_dst(dst)
+        , m_value(value)
+    {
+        VERIFY(!value.is_cell());
+    }
+
+    virtual void execute(Bytecode::Interpreter&) const override;
+    virtual String to_string() const override;
+
+private:
+    Register m_dst;
+    Value m_value;
+};
+
+class Move final : public Instruction {
+public:
+    Move(Register dst, Register src)
+        : m_dst(dst)
+        , m_src(src)
+    {
+    }
+
+    virtual void execute(Bytecode::Interpreter&) const override;
+    virtual String to_string() const override;
+
+private:
+    Register m_dst;
+    Register m_src;
+};
+
+#define JS_DECLARE_BYTECODE_BINARY_OP(OpTitleCase, op_snake_case)    \
+    class OpTitleCase final : public Instruction {                   \
+    public:                                                          \
+        OpTitleCase(Register dst, Register lhs, Register rhs)        \
+            : m_dst(dst)                                             \
+            , m_lhs(lhs)                                             \
+            , m_rhs(rhs)                                             \
+        {                                                            \
+        }                                                            \
+                                                                     \
+        virtual void execute(Bytecode::Interpreter&) const override; \
+        virtual String to_string() const override;                   \
+                                                                     \
+    private:                                                         \
+        Register m_dst;                                              \
+        Register m_lhs;                                              \
+        Register m_rhs;                                              \
+    };
+
+JS_ENUMERATE_BYTECODE_BINARY_OPS(JS_DECLARE_BYTECODE_BINARY_OP)
+#undef JS_DECLARE_BYTECODE_BINARY_OP
+
+#define JS_DECLARE_BYTECODE_UNARY_OP(OpTitleCase, op_snake_case)     \
+    class OpTitleCase final : public Instruction {                   \
+    public:                                                          \
+        OpTitleCase(Register dst, Register src)                      \
+            : m_dst(dst)                                             \
+            , m_src(src)                                             \
+        {                                                            \
+        }                                                            \
+                                                                     \
+        virtual void execute(Bytecode::Interpreter&) const override; \
+        virtual String to_string() const override;                   \
+                                                                     \
+    private:                                                         \
+        Register m_dst;                                              \
+        Register m_src;                                              \
+    };
+
+JS_ENUMERATE_BYTECODE_UNARY_OPS(JS_DECLARE_BYTECODE_UNARY_OP)
+#undef JS_DECLARE_BYTECODE_UNARY_OP
+
+class NewString final : public Instruction {
+public:
+    NewString(Register dst, String string)
+        : m_dst(dst)
+        , m_string(move(string))
+    {
+    }
+
+    virtual void execute(Bytecode::Interpreter&) const override;
+    virtual String to_string() const override;
+
+private:
+    Register m_dst;
+    String m_string;
+};
+
+class NewObject final : public Instruction {
+public:
+    explicit NewObject(Register dst)
+        : m_dst(dst)
+    {
+    }
+
+    virtual void execute(Bytecode::Interpreter&) const override;
+    virtual String to_string() const override;
+
+private:
+    Register m_dst;
+};
+
+class NewArray final : public Instruction {
+public:
+    NewArray(Register dst, Vector<Register> elements)
+        : m_dst(dst)
+        , m_elements(move(elements))
+    {
+    }
+
+    virtual void execute(Bytecode::Interpreter&) const override;
+    virtual String to_string() const override;
+
+private:
+    Register m_dst;
+    Vector<Register> m_elements;
+};
+
+// Looks the name up through the scope chain, like the AST interpreter does for identifiers.
+class GetVariable final : public Instruction {
+public:
+    enum class ThrowIfMissing {
+        No,
+        Yes,
+    };
+
+    GetVariable(Register dst, FlyString identifier, BindingLocation binding_location, ThrowIfMissing throw_if_missing = ThrowIfMissing::Yes)
+        : m_dst(dst)
+        , m_identifier(move(identifier))
+        , m_binding_location(move(binding_location))
+        , m_throw_if_missing(throw_if_missing)
+    {
+    }
+
+    virtual void execute(Bytecode::Interpreter&) const override;
+    virtual String to_string() const override;
+
+private:
+    Register m_dst;
+    FlyString m_identifier;
+    BindingLocation m_binding_location;
+    ThrowIfMissing m_throw_if_missing;
+};
+
+class SetVariable final : public Instruction {
+public:
+    SetVariable(FlyString identifier, BindingLocation binding_location, Register src, bool is_initialization = false)
+        : m_identifier(move(identifier))
+        , m_binding_location(move(binding_location))
+        , m_src(src)
+        , m_is_initialization(is_initialization)
+    {
+    }
+
+    virtual void execute(Bytecode::Interpreter&) const override;
+    virtual String to_string() const override;
+
+private:
+    FlyString m_identifier;
+    BindingLocation m_binding_location;
+    Register m_src;
+    bool m_is_initialization { false };
+};
+
+class GetById final : public Instruction {
+public:
+    GetById(Register dst, Register base, FlyString property)
+        : m_dst(dst)
+        , m_base(base)
+        , m_property(move(property))
+    {
+    }
+
+    virtual void execute(Bytecode::Interpreter&) const override;
+    virtual String to_string() const override;
+
+private:
+    Register m_dst;
+    Register m_base;
+    FlyString m_property;
+    mutable PropertyCache m_cache;
+};
+
+class PutById final : public Instruction {
+public:
+    PutById(Register base, FlyString property, Register src)
+        : m_base(base)
+        , m_property(move(property))
+        , m_src(src)
+    {
+    }
+
+    virtual void execute(Bytecode::Interpreter&) const override;
+    virtual String to_string() const override;
+
+private:
+    Register m_base;
+    FlyString m_property;
+    Register m_src;
+    mutable PropertyCache m_cache;
+};
+
+class GetByValue final : public Instruction {
+public:
+    GetByValue(Register dst, Register base, Register property)
+        : m_dst(dst)
+        , m_base(base)
+        , m_property(property)
+    {
+    }
+
+    virtual void execute(Bytecode::Interpreter&) const override;
+    virtual String to_string() const override;
+
+private:
+    Register m_dst;
+    Register m_base;
+    Register m_property;
+};
+
+class PutByValue final : public Instruction {
+public:
+    PutByValue(Register base, Register property, Register src)
+        : m_base(base)
+        , m_property(property)
+        , m_src(src)
+    {
+    }
+
+    virtual void execute(Bytecode::Interpreter&) const override;
+    virtual String to_string() const override;
+
+private:
+    Register m_base;
+    Register m_property;
+    Register m_src;
+};
+
+// Defines an own data property, as object literals do (no setters or prototype lookups are involved).
+class DefineProperty final : public Instruction {
+public:
+    DefineProperty(Register object, Register property, Register src)
+        : m_object(object)
+        , m_property(property)
+        , m_src(src)
+    {
+    }
+
+    virtual void execute(Bytecode::Interpreter&) const override;
+    virtual String to_string() const override;
+
+private:
+    Register m_object;
+    Register m_property;
+    Register m_src;
+};
+
+class Jump : public Instruction {
+public:
+    explicit Jump(Optional<Label> target = {})
+        : m_target(move(target))
+    {
+    }
+
+    void set_target(Label target) { m_target = target; }
+
+    virtual void execute(Bytecode::Interpreter&) const override;
+    virtual String to_string() const override;
+
+protected:
+    Optional<Label> m_target;
+};
+
+class JumpIfTrue final : public Jump {
+public:
+    explicit JumpIfTrue(Register condition, Optional<Label> target = {})
+        : Jump(move(target))
+        , m_condition(condition)
+    {
+    }
+
+    virtual void execute(Bytecode::Interpreter&) const override;
+    virtual String to_string() const override;
+
+private:
+    Register m_condition;
+};
+
+class JumpIfFalse final : public Jump {
+public:
+    explicit JumpIfFalse(Register condition, Optional<Label> target = {})
+        : Jump(move(target))
+        , m_condition(condition)
+    {
+    }
+
+    virtual void execute(Bytecode::Interpreter&) const override;
+    virtual String to_string() const override;
+
+private:
+    Register m_condition;
+};
+
+class JumpIfNotNullish final : public Jump {
+public:
+    explicit JumpIfNotNullish(Register condition, Optional<Label> target = {})
+        : Jump(move(target))
+        , m_condition(condition)
+    {
+    }
+
+    virtual void execute(Bytecode::Interpreter&) const override;
+    virtual String to_string() const override;
+
+private:
+    Register m_condition;
+};
+
+class Call final : public Instruction {
+public:
+    // If no |this| register is given, the global object is used, matching CallExpression in the AST interpreter.
+    Call(Register dst, Register callee, Optional<Register> this_value, Vector<Register> arguments, String callee_description)
+        : m_dst(dst)
+        , m_callee(callee)
+        , m_this_value(move(this_value))
+        , m_arguments(move(arguments))
+        , m_callee_description(move(callee_description))
+    {
+    }
+
+    virtual void execute(Bytecode::Interpreter&) const override;
+    virtual String to_string() const override;
+
+private:
+    Register m_dst;
+    Register m_callee;
+    Optional<Register> m_this_value;
+    Vector<Register> m_arguments;
+    String m_callee_description;
+};
+
+class EnterScope final : public Instruction {
+public:
+    explicit EnterScope(const ScopeNode& scope_node)
+        : m_scope_node(scope_node)
+    {
+    }
+
+    virtual void execute(Bytecode::Interpreter&) const override;
+    virtual String to_string() const override;
+
+private:
+    const ScopeNode& m_scope_node;
+};
+
+class ExitScope final : public Instruction {
+public:
+    explicit ExitScope(const ScopeNode& scope_node)
+        : m_scope_node(scope_node)
+    {
+    }
+
+    virtual void execute(Bytecode::Interpreter&) const override;
+    virtual String to_string() const override;
+
+private:
+    const ScopeNode& m_scope_node;
+};
+
+}
@@ -140,6 +140,7 @@ class NativeFunction;
 class NativeProperty;
 class PrimitiveString;
 class Reference;
+class ScopeLayout;
 class ScopeNode;
 class ScopeObject;
 class Shape;
@@ -150,6 +151,8 @@ class Uint8ClampedArray;
 class VM;
 class Value;
 enum class DeclarationKind;
+struct BindingLocation;
+struct Variable;
 
 // Not included in JS_ENUMERATE_NATIVE_OBJECTS due to missing distinct prototype
 class ProxyObject;
@@ -170,4 +173,12 @@ JS_ENUMERATE_TYPED_ARRAYS
 template<class T>
 class Handle;
 
+namespace Bytecode {
+class Block;
+class Generator;
+class Instruction;
+class Interpreter;
+class Register;
+}
+
 }
@@ -25,6 +25,7 @@
  */
 
 #include <AK/Badge.h>
+#include <AK/Debug.h>
 #include <LibJS/Heap/Allocator.h>
 #include <LibJS/Heap/HeapBlock.h>
 
@@ -41,10 +42,11 @@ Allocator::~Allocator()
 
 Cell* Allocator::allocate_cell(Heap& heap)
 {
-    if (m_usable_blocks.is_empty()) {
-        auto block = HeapBlock::create_with_cell_size(heap, m_cell_size);
-        m_usable_blocks.append(*block.leak_ptr());
-    }
+    while (m_usable_blocks.is_empty() && !m_unswept_blocks.is_empty())
+        sweep_block(*m_unswept_blocks.first());
+
+    if (m_usable_blocks.is_empty())
+        m_usable_blocks.append(*HeapBlock::create_with_cell_size(heap, m_cell_size));
 
     auto& block = *m_usable_blocks.last();
     auto* cell = block.allocate();
@@ -54,16 +56,44 @@ Cell* Allocator::allocate_cell(Heap& heap)
     return cell;
 }
 
-void Allocator::block_did_become_empty(Badge<Heap>, HeapBlock& block)
+void Allocator::did_mark_cells(Badge<Heap>)
 {
-    block.m_list_node.remove();
-    delete &block;
+    VERIFY(m_unswept_blocks.is_empty());
+    m_sweep_counts = {};
+    while (auto* block = m_full_blocks.first()) {
+        block->set_needs_sweep();
+        m_unswept_blocks.append(*block);
+    }
+    while (auto* block = m_usable_blocks.first()) {
+        block->set_needs_sweep();
+        m_unswept_blocks.append(*block);
+    }
 }
 
-void Allocator::block_did_become_usable(Badge<Heap>, HeapBlock& block)
+void Allocator::sweep_all_blocks(Badge<Heap>)
 {
-    VERIFY(!block.is_full());
-    m_usable_blocks.append(block);
+    while (auto* block = m_unswept_blocks.first())
+        sweep_block(*block);
+}
+
+void Allocator::sweep_block(HeapBlock& block)
+{
+    m_sweep_counts.collected_cells += block.sweep();
+
+    if (block.is_empty()) {
+#if HEAP_DEBUG
+        dbgln(" - HeapBlock empty @ {}: cell_size={}", &block, block.cell_size());
+#endif
+        block.m_list_node.remove();
+        HeapBlock::destroy(block);
+        ++m_sweep_counts.freed_blocks;
+        return;
+    }
+
+    if (block.is_full())
+        m_full_blocks.append(block);
+    else
+        m_usable_blocks.append(block);
 }
 
 }
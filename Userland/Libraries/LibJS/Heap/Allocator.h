@@ -54,18 +54,37 @@ public:
             if (callback(block) == IterationDecision::Break)
                 return IterationDecision::Break;
         }
+        for (auto& block : m_unswept_blocks) {
+            if (callback(block) == IterationDecision::Break)
+                return IterationDecision::Break;
+        }
         return IterationDecision::Continue;
     }
 
-    void block_did_become_empty(Badge<Heap>, HeapBlock&);
-    void block_did_become_usable(Badge<Heap>, HeapBlock&);
+    // Called once marking is done. Blocks are swept lazily, one at a time, when allocation runs
+    // out of usable blocks, or all at once by sweep_all_blocks().
+    void did_mark_cells(Badge<Heap>);
+    void sweep_all_blocks(Badge<Heap>);
+    bool has_unswept_blocks() const { return !m_unswept_blocks.is_empty(); }
+
+    // Accumulated by sweeping since the last call to did_mark_cells().
+    struct SweepCounts {
+        size_t collected_cells { 0 };
+        size_t freed_blocks { 0 };
+    };
+    const SweepCounts& sweep_counts() const { return m_sweep_counts; }
 
 private:
+    void sweep_block(HeapBlock&);
+
     const size_t m_cell_size;
 
     typedef IntrusiveList<HeapBlock, &HeapBlock::m_list_node> BlockList;
     BlockList m_full_blocks;
     BlockList m_usable_blocks;
+    BlockList m_unswept_blocks;
+
+    SweepCounts m_sweep_counts;
 };
 
 }
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <AK/Assertions.h>
+#include <LibJS/Heap/BlockAllocator.h>
+#include <LibJS/Heap/HeapBlock.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+namespace JS {
+
+BlockAllocator::~BlockAllocator()
+{
+    for (auto* block : m_blocks) {
+#ifdef __serenity__
+        int rc = munmap(block, HeapBlock::block_size);
+        VERIFY(rc == 0);
+#else
+        free(block);
+#endif
+    }
+}
+
+void* BlockAllocator::allocate_block([[maybe_unused]] const char* name)
+{
+    m_peak_live_block_count = max(m_peak_live_block_count, ++m_live_block_count);
+
+    if (!m_blocks.is_empty()) {
+        auto* block = m_blocks.take_last();
+#ifdef __serenity__
+        if (madvise(block, HeapBlock::block_size, MADV_SET_NONVOLATILE) < 0) {
+            perror("madvise");
+            VERIFY_NOT_REACHED();
+        }
+#endif
+        return block;
+    }
+
+#ifdef __serenity__
+    auto* block = serenity_mmap(nullptr, HeapBlock::block_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_RANDOMIZED | MAP_PRIVATE, 0, 0, HeapBlock::block_size, name);
+    VERIFY(block != MAP_FAILED);
+#else
+    auto* block = aligned_alloc(HeapBlock::block_size, HeapBlock::block_size);
+    VERIFY(block);
+#endif
+    return block;
+}
+
+void BlockAllocator::deallocate_block(void* block)
+{
+    VERIFY(block);
+    VERIFY(m_live_block_count);
+    --m_live_block_count;
+
+    if (m_blocks.size() >= max_pooled_blocks) {
+#ifdef __serenity__
+        int rc = munmap(block, HeapBlock::block_size);
+        VERIFY(rc == 0);
+#else
+        free(block);
+#endif
+        return;
+    }
+
+    // The block is fully re-initialized when it's handed out again, so the kernel is free to
+    // drop its pages in the meantime.
+#ifdef __serenity__
+    madvise(block, HeapBlock::block_size, MADV_SET_VOLATILE);
+#else
+    madvise(block, HeapBlock::block_size, MADV_DONTNEED);
+#endif
+    m_blocks.append(block);
+}
+
+}
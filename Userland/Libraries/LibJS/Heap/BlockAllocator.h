@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <AK/Noncopyable.h>
+#include <AK/Types.h>
+#include <AK/Vector.h>
+
+namespace JS {
+
+// Hands out HeapBlock-sized, HeapBlock-aligned chunks of memory and keeps a small pool of blocks
+// that became empty during sweeping, so a heap that oscillates in size doesn't keep mapping and
+// unmapping memory. Pooled blocks are marked as discardable, so they don't count towards RSS.
+class BlockAllocator {
+    AK_MAKE_NONCOPYABLE(BlockAllocator);
+    AK_MAKE_NONMOVABLE(BlockAllocator);
+
+public:
+    BlockAllocator() { }
+    ~BlockAllocator();
+
+    void* allocate_block(const char* name);
+    void deallocate_block(void*);
+
+    size_t pooled_block_count() const { return m_blocks.size(); }
+
+    // Blocks that have been handed out and not given back yet, i.e. the size of the heap.
+    size_t live_block_count() const { return m_live_block_count; }
+    size_t peak_live_block_count() const { return m_peak_live_block_count; }
+    void reset_peak_live_block_count() { m_peak_live_block_count = m_live_block_count; }
+
+private:
+    static constexpr size_t max_pooled_blocks = 64;
+
+    Vector<void*, max_pooled_blocks> m_blocks;
+    size_t m_live_block_count { 0 };
+    size_t m_peak_live_block_count { 0 };
+};
+
+}
@@ -27,9 +27,11 @@
 #include <AK/Badge.h>
 #include <AK/Debug.h>
 #include <AK/HashTable.h>
+#include <AK/NumericLimits.h>
 #include <AK/StackInfo.h>
 #include <AK/TemporaryChange.h>
 #include <LibCore/ElapsedTimer.h>
+#include <LibCore/Trace.h>
 #include <LibJS/Heap/Allocator.h>
 #include <LibJS/Heap/Handle.h>
 #include <LibJS/Heap/Heap.h>
@@ -37,9 +39,17 @@
 #include <LibJS/Interpreter.h>
 #include <LibJS/Runtime/Object.h>
 #include <setjmp.h>
+#include <time.h>
 
 namespace JS {
 
+static u64 monotonic_time_us()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)now.tv_sec * 1000000 + (u64)now.tv_nsec / 1000;
+}
+
 Heap::Heap(VM& vm)
     : m_vm(vm)
 {
@@ -72,7 +82,6 @@ Cell* Heap::allocate_cell(size_t size)
     if (should_collect_on_every_allocation()) {
         collect_garbage();
     } else if (m_allocations_since_last_gc > m_max_allocations_between_gc) {
-        m_allocations_since_last_gc = 0;
         collect_garbage();
     } else {
         ++m_allocations_since_last_gc;
@@ -84,21 +93,115 @@ Cell* Heap::allocate_cell(size_t size)
 
 void Heap::collect_garbage(CollectionType collection_type, bool print_report)
 {
+    TRACE_SCOPE("js", "Heap::collect_garbage");
     VERIFY(!m_collecting_garbage);
     TemporaryChange change(m_collecting_garbage, true);
 
+    if (collection_type == CollectionType::CollectGarbage && m_gc_deferrals) {
+        m_should_gc_when_deferral_ends = true;
+        return;
+    }
+
     Core::ElapsedTimer collection_measurement_timer;
     collection_measurement_timer.start();
+    auto start_time = monotonic_time_us();
+
+    // Marking expects every mark bit to be clear, so finish sweeping after the previous collection first.
+    finish_sweeping();
+    m_statistics.last_collected_cells = collected_cell_count();
+
+    auto root_gathering_start_time = monotonic_time_us();
+    auto marking_start_time = root_gathering_start_time;
+    auto marking_end_time = root_gathering_start_time;
+    size_t live_cells = 0;
+
     if (collection_type == CollectionType::CollectGarbage) {
-        if (m_gc_deferrals) {
-            m_should_gc_when_deferral_ends = true;
-            return;
-        }
         HashTable<Cell*> roots;
         gather_roots(roots);
-        mark_live_cells(roots);
+        marking_start_time = monotonic_time_us();
+        live_cells = mark_live_cells(roots);
+        marking_end_time = monotonic_time_us();
+    }
+
+    for (auto& allocator : m_allocators)
+        allocator->did_mark_cells({});
+
+    // Normally dead cells are swept lazily by the allocators, but everything has to go when the heap is
+    // torn down, and a report is only meaningful once the sweep is done.
+    if (collection_type == CollectionType::CollectEverything || print_report) {
+        finish_sweeping();
+        if (print_report)
+            print_collection_report(collection_measurement_timer);
+    }
+
+    auto end_time = monotonic_time_us();
+    auto pause = end_time - start_time;
+    ++m_statistics.collections;
+    m_statistics.total_pause_us += pause;
+    m_statistics.max_pause_us = max(m_statistics.max_pause_us, pause);
+    m_statistics.last_pause_us = pause;
+    m_statistics.last_root_gathering_us = marking_start_time - root_gathering_start_time;
+    m_statistics.last_marking_us = marking_end_time - marking_start_time;
+    m_statistics.last_sweeping_us = (root_gathering_start_time - start_time) + (end_time - marking_end_time);
+    m_statistics.last_live_cells = live_cells;
+
+    update_collection_threshold();
+}
+
+void Heap::update_collection_threshold()
+{
+    m_allocations_since_last_gc = 0;
+    m_max_allocations_between_gc = min(max(m_statistics.last_live_cells, min_allocations_between_gc), max_allocations_between_gc);
+    m_statistics.allocations_between_collections = m_max_allocations_between_gc;
+}
+
+void Heap::dump_statistics()
+{
+    dbgln("Garbage collection statistics");
+    dbgln("=============================================");
+    dbgln("         Collections: {}", m_statistics.collections);
+    dbgln("    Total pause time: {} us", m_statistics.total_pause_us);
+    dbgln("      Max pause time: {} us", m_statistics.max_pause_us);
+    dbgln("     Last pause time: {} us (roots: {} us, marking: {} us, sweeping: {} us)",
+        m_statistics.last_pause_us, m_statistics.last_root_gathering_us, m_statistics.last_marking_us, m_statistics.last_sweeping_us);
+    dbgln("     Last live cells: {}", m_statistics.last_live_cells);
+    dbgln("Last collected cells: {}", m_statistics.last_collected_cells);
+    dbgln("        GC threshold: {} allocations", m_statistics.allocations_between_collections);
+    dump_occupancy();
+    dbgln("=============================================");
+}
+
+void Heap::dump_occupancy()
+{
+    dbgln("Occupancy by size class:");
+    for (auto& allocator : m_allocators) {
+        size_t block_count = 0;
+        size_t unswept_block_count = 0;
+        size_t allocated_cells = 0;
+        size_t capacity = 0;
+        allocator->for_each_block([&](auto& block) {
+            ++block_count;
+            if (block.needs_sweep())
+                ++unswept_block_count;
+            allocated_cells += block.allocated_cell_count();
+            capacity += block.cell_count();
+            return IterationDecision::Continue;
+        });
+        if (!block_count)
+            continue;
+        dbgln("  {:>4} bytes: {} blocks ({} unswept), {}/{} cells allocated ({}%)",
+            allocator->cell_size(), block_count, unswept_block_count, allocated_cells, capacity, allocated_cells * 100 / capacity);
     }
-    sweep_dead_cells(print_report, collection_measurement_timer);
+    dbgln("  Live blocks: {} (peak {}), pooled empty blocks: {}",
+        m_block_allocator.live_block_count(), m_block_allocator.peak_live_block_count(), m_block_allocator.pooled_block_count());
+}
+
+size_t Heap::collected_cell_count() const
+{
+    size_t collected_cells = 0;
+    for (auto& allocator : m_allocators)
+        collected_cells += allocator->sweep_counts().collected_cells;
+    return collected_cells;
 }
 
 void Heap::gather_roots(HashTable<Cell*>& roots)
@@ -134,49 +237,59 @@ __attribute__((no_sanitize("address"))) void Heap::gather_conservative_roots(Has
     jmp_buf buf;
     setjmp(buf);
 
-    HashTable<FlatPtr> possible_pointers;
-
-    const FlatPtr* raw_jmp_buf = reinterpret_cast<const FlatPtr*>(buf);
-
-    for (size_t i = 0; i < ((size_t)sizeof(buf)) / sizeof(FlatPtr); i += sizeof(FlatPtr))
-        possible_pointers.set(raw_jmp_buf[i]);
-
-    FlatPtr stack_reference = reinterpret_cast<FlatPtr>(&dummy);
-    auto& stack_info = m_vm.stack_info();
-
-    for (FlatPtr stack_address = stack_reference; stack_address < stack_info.top(); stack_address += sizeof(FlatPtr)) {
-        auto data = *reinterpret_cast<FlatPtr*>(stack_address);
-        possible_pointers.set(data);
-    }
-
+    // Most words on the stack are not heap pointers, so reject them with a cheap range check
+    // against the lowest and highest block addresses before looking up the owning block.
     HashTable<HeapBlock*> all_live_heap_blocks;
+    FlatPtr min_block_address = NumericLimits<FlatPtr>::max();
+    FlatPtr max_block_address = 0;
     for_each_block([&](auto& block) {
         all_live_heap_blocks.set(&block);
+        min_block_address = min(min_block_address, reinterpret_cast<FlatPtr>(&block));
+        max_block_address = max(max_block_address, reinterpret_cast<FlatPtr>(&block) + HeapBlock::block_size);
         return IterationDecision::Continue;
     });
 
-    for (auto possible_pointer : possible_pointers) {
-        if (!possible_pointer)
-            continue;
+    auto add_possible_pointer = [&](FlatPtr possible_pointer) {
+        if (possible_pointer < min_block_address || possible_pointer >= max_block_address)
+            return;
 #if HEAP_DEBUG
         dbgln("  ? {}", (const void*)possible_pointer);
 #endif
         auto* possible_heap_block = HeapBlock::from_cell(reinterpret_cast<const Cell*>(possible_pointer));
-        if (all_live_heap_blocks.contains(possible_heap_block)) {
-            if (auto* cell = possible_heap_block->cell_from_possible_pointer(possible_pointer)) {
-                if (cell->is_live()) {
+        if (!all_live_heap_blocks.contains(possible_heap_block))
+            return;
+        if (auto* cell = possible_heap_block->cell_from_possible_pointer(possible_pointer)) {
+            if (cell->is_live()) {
 #if HEAP_DEBUG
-                    dbgln("  ?-> {}", (const void*)cell);
+                dbgln("  ?-> {}", (const void*)cell);
 #endif
-                    roots.set(cell);
-                } else {
+                roots.set(cell);
+            } else {
 #if HEAP_DEBUG
-                    dbgln("  #-> {}", (const void*)cell);
+                dbgln("  #-> {}", (const void*)cell);
 #endif
-                }
             }
         }
-    }
+    };
+
+    // On 64-bit targets a Value keeps its cell pointer in the low bits of a NaN-boxed word, so a word may
+    // also have to be unboxed. On 32-bit targets the pointer sits in a word of its own anyway.
+    auto add_possible_value = [&](FlatPtr possible_value) {
+        add_possible_pointer(possible_value);
+        if constexpr (sizeof(FlatPtr) == sizeof(u64))
+            add_possible_pointer(Value::cell_pointer_from_bits(possible_value));
+    };
+
+    const FlatPtr* raw_jmp_buf = reinterpret_cast<const FlatPtr*>(buf);
+
+    for (size_t i = 0; i < ((size_t)sizeof(buf)) / sizeof(FlatPtr); ++i)
+        add_possible_value(raw_jmp_buf[i]);
+
+    FlatPtr stack_reference = reinterpret_cast<FlatPtr>(&dummy);
+    auto& stack_info = m_vm.stack_info();
+
+    for (FlatPtr stack_address = stack_reference; stack_address < stack_info.top(); stack_address += sizeof(FlatPtr))
+        add_possible_value(*reinterpret_cast<FlatPtr*>(stack_address));
 }
 
 class MarkingVisitor final : public Cell::Visitor {
@@ -191,11 +304,26 @@ public:
         dbgln("  ! {}", cell);
 #endif
         cell->set_marked(true);
-        cell->visit_edges(*this);
+        ++m_marked_cells;
+        m_work_queue.append(cell);
+    }
+
+    // Edges are visited from an explicit work queue rather than recursively, since long chains
+    // of cells (linked lists, deep string ropes) would otherwise overflow the native stack.
+    void mark_all_reachable_cells()
+    {
+        while (!m_work_queue.is_empty())
+            m_work_queue.take_last()->visit_edges(*this);
     }
+
+    size_t marked_cells() const { return m_marked_cells; }
+
+private:
+    Vector<Cell*> m_work_queue;
+    size_t m_marked_cells { 0 };
 };
 
-void Heap::mark_live_cells(const HashTable<Cell*>& roots)
+size_t Heap::mark_live_cells(const HashTable<Cell*>& roots)
 {
 #if HEAP_DEBUG
     dbgln("mark_live_cells:");
@@ -203,87 +331,58 @@ void Heap::mark_live_cells(const HashTable<Cell*>& roots)
     MarkingVisitor visitor;
     for (auto* root : roots)
         visitor.visit(root);
+    visitor.mark_all_reachable_cells();
+    return visitor.marked_cells();
 }
 
-void Heap::sweep_dead_cells(bool print_report, const Core::ElapsedTimer& measurement_timer)
+void Heap::finish_sweeping()
 {
 #if HEAP_DEBUG
-    dbgln("sweep_dead_cells:");
+    dbgln("finish_sweeping:");
 #endif
-    Vector<HeapBlock*, 32> empty_blocks;
-    Vector<HeapBlock*, 32> full_blocks_that_became_usable;
+    for (auto& allocator : m_allocators)
+        allocator->sweep_all_blocks({});
 
-    size_t collected_cells = 0;
-    size_t live_cells = 0;
-    size_t collected_cell_bytes = 0;
-    size_t live_cell_bytes = 0;
-
-    for_each_block([&](auto& block) {
-        bool block_has_live_cells = false;
-        bool block_was_full = block.is_full();
-        block.for_each_cell([&](Cell* cell) {
-            if (cell->is_live()) {
-                if (!cell->is_marked()) {
 #if HEAP_DEBUG
-                    dbgln("  ~ {}", cell);
-#endif
-                    block.deallocate(cell);
-                    ++collected_cells;
-                    collected_cell_bytes += block.cell_size();
-                } else {
-                    cell->set_marked(false);
-                    block_has_live_cells = true;
-                    ++live_cells;
-                    live_cell_bytes += block.cell_size();
-                }
-            }
-        });
-        if (!block_has_live_cells)
-            empty_blocks.append(&block);
-        else if (block_was_full != block.is_full())
-            full_blocks_that_became_usable.append(&block);
+    for_each_block([&](auto& block) {
+        dbgln(" > Live HeapBlock @ {}: cell_size={}", &block, block.cell_size());
         return IterationDecision::Continue;
     });
-
-    for (auto* block : empty_blocks) {
-#if HEAP_DEBUG
-        dbgln(" - HeapBlock empty @ {}: cell_size={}", block, block->cell_size());
 #endif
-        allocator_for_size(block->cell_size()).block_did_become_empty({}, *block);
-    }
+}
 
-    for (auto* block : full_blocks_that_became_usable) {
-#if HEAP_DEBUG
-        dbgln(" - HeapBlock usable again @ {}: cell_size={}", block, block->cell_size());
-#endif
-        allocator_for_size(block->cell_size()).block_did_become_usable({}, *block);
+void Heap::print_collection_report(const Core::ElapsedTimer& measurement_timer)
+{
+    size_t collected_cells = 0;
+    size_t collected_cell_bytes = 0;
+    size_t freed_blocks = 0;
+    for (auto& allocator : m_allocators) {
+        collected_cells += allocator->sweep_counts().collected_cells;
+        collected_cell_bytes += allocator->sweep_counts().collected_cells * allocator->cell_size();
+        freed_blocks += allocator->sweep_counts().freed_blocks;
     }
 
-#if HEAP_DEBUG
+    size_t live_cells = 0;
+    size_t live_cell_bytes = 0;
+    size_t live_block_count = 0;
     for_each_block([&](auto& block) {
-        dbgln(" > Live HeapBlock @ {}: cell_size={}", &block, block.cell_size());
+        live_cells += block.allocated_cell_count();
+        live_cell_bytes += block.allocated_cell_count() * block.cell_size();
+        ++live_block_count;
         return IterationDecision::Continue;
     });
-#endif
 
     int time_spent = measurement_timer.elapsed();
 
-    if (print_report) {
-        size_t live_block_count = 0;
-        for_each_block([&](auto&) {
-            ++live_block_count;
-            return IterationDecision::Continue;
-        });
-
-        dbgln("Garbage collection report");
-        dbgln("=============================================");
-        dbgln("     Time spent: {} ms", time_spent);
-        dbgln("     Live cells: {} ({} bytes)", live_cells, live_cell_bytes);
-        dbgln("Collected cells: {} ({} bytes)", collected_cells, collected_cell_bytes);
-        dbgln("    Live blocks: {} ({} bytes)", live_block_count, live_block_count * HeapBlock::block_size);
-        dbgln("   Freed blocks: {} ({} bytes)", empty_blocks.size(), empty_blocks.size() * HeapBlock::block_size);
-        dbgln("=============================================");
-    }
+    dbgln("Garbage collection report");
+    dbgln("=============================================");
+    dbgln("     Time spent: {} ms", time_spent);
+    dbgln("     Live cells: {} ({} bytes)", live_cells, live_cell_bytes);
+    dbgln("Collected cells: {} ({} bytes)", collected_cells, collected_cell_bytes);
+    dbgln("    Live blocks: {} ({} bytes)", live_block_count, live_block_count * HeapBlock::block_size);
+    dbgln("   Freed blocks: {} ({} bytes)", freed_blocks, freed_blocks * HeapBlock::block_size);
+    dump_occupancy();
+    dbgln("=============================================");
 }
 
 void Heap::did_create_handle(Badge<HandleImpl>, HandleImpl& impl)
@@ -34,6 +34,7 @@
 #include <LibCore/Forward.h>
 #include <LibJS/Forward.h>
 #include <LibJS/Heap/Allocator.h>
+#include <LibJS/Heap/BlockAllocator.h>
 #include <LibJS/Heap/Handle.h>
 #include <LibJS/Runtime/Cell.h>
 #include <LibJS/Runtime/Object.h>
@@ -76,10 +77,33 @@ public:
         CollectEverything,
     };
 
+    // Marking is a full, stop-the-world pass over everything reachable. Marking only young cells, or
+    // marking in slices between mutator steps, would need a write barrier on every store of a Cell*,
+    // and cells keep raw Cell* edges in plain members all over LibJS and LibWeb.
     void collect_garbage(CollectionType = CollectionType::CollectGarbage, bool print_report = false);
 
+    struct Statistics {
+        size_t collections { 0 };
+        u64 total_pause_us { 0 };
+        u64 max_pause_us { 0 };
+        u64 last_pause_us { 0 };
+        u64 last_root_gathering_us { 0 };
+        u64 last_marking_us { 0 };
+        u64 last_sweeping_us { 0 };
+        size_t last_live_cells { 0 };
+        // Dead cells are finalized lazily, so this counts the cells collected by the previous
+        // collection and is only complete once the next one starts.
+        size_t last_collected_cells { 0 };
+        size_t allocations_between_collections { 0 };
+    };
+
+    const Statistics& statistics() const { return m_statistics; }
+    void dump_statistics();
+
     VM& vm() { return m_vm; }
 
+    BlockAllocator& block_allocator() { return m_block_allocator; }
+
     bool should_collect_on_every_allocation() const { return m_should_collect_on_every_allocation; }
     void set_should_collect_on_every_allocation(bool b) { m_should_collect_on_every_allocation = b; }
 
@@ -97,8 +121,12 @@ private:
 
     void gather_roots(HashTable<Cell*>&);
     void gather_conservative_roots(HashTable<Cell*>&);
-    void mark_live_cells(const HashTable<Cell*>& live_cells);
-    void sweep_dead_cells(bool print_report, const Core::ElapsedTimer&);
+    size_t mark_live_cells(const HashTable<Cell*>& live_cells);
+    void finish_sweeping();
+    void print_collection_report(const Core::ElapsedTimer&);
+    void dump_occupancy();
+    size_t collected_cell_count() const;
+    void update_collection_threshold();
 
     Allocator& allocator_for_size(size_t);
 
@@ -111,13 +139,21 @@ private:
         }
     }
 
-    size_t m_max_allocations_between_gc { 10000 };
-    size_t m_allocations_since_last_gc { false };
+    // Collections are triggered after a number of allocations proportional to the number of cells
+    // that survived the last one, so the cost of a full collection is amortized over the heap size
+    // instead of being paid every few thousand allocations on large heaps.
+    static constexpr size_t min_allocations_between_gc = 10000;
+    static constexpr size_t max_allocations_between_gc = 1000000;
+    size_t m_max_allocations_between_gc { min_allocations_between_gc };
+    size_t m_allocations_since_last_gc { 0 };
+
+    Statistics m_statistics;
 
     bool m_should_collect_on_every_allocation { false };
 
     VM& m_vm;
 
+    BlockAllocator m_block_allocator;
     Vector<NonnullOwnPtr<Allocator>> m_allocators;
     HashTable<HandleImpl*> m_handles;
 
@@ -25,36 +25,28 @@
  */
 
 #include <AK/Assertions.h>
-#include <AK/NonnullOwnPtr.h>
-#include <AK/kmalloc.h>
+#include <AK/Debug.h>
+#include <LibJS/Heap/BlockAllocator.h>
+#include <LibJS/Heap/Heap.h>
 #include <LibJS/Heap/HeapBlock.h>
 #include <stdio.h>
-#include <sys/mman.h>
 
 namespace JS {
 
-NonnullOwnPtr<HeapBlock> HeapBlock::create_with_cell_size(Heap& heap, size_t cell_size)
+HeapBlock* HeapBlock::create_with_cell_size(Heap& heap, size_t cell_size)
 {
     char name[64];
     snprintf(name, sizeof(name), "LibJS: HeapBlock(%zu)", cell_size);
-#ifdef __serenity__
-    auto* block = (HeapBlock*)serenity_mmap(nullptr, block_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_RANDOMIZED | MAP_PRIVATE, 0, 0, block_size, name);
-#else
-    auto* block = (HeapBlock*)aligned_alloc(block_size, block_size);
-#endif
-    VERIFY(block != MAP_FAILED);
+    auto* block = (HeapBlock*)heap.block_allocator().allocate_block(name);
     new (block) HeapBlock(heap, cell_size);
-    return NonnullOwnPtr<HeapBlock>(NonnullOwnPtr<HeapBlock>::Adopt, *block);
+    return block;
 }
 
-void HeapBlock::operator delete(void* ptr)
+void HeapBlock::destroy(HeapBlock& block)
 {
-#ifdef __serenity__
-    int rc = munmap(ptr, block_size);
-    VERIFY(rc == 0);
-#else
-    free(ptr);
-#endif
+    auto& heap = block.heap();
+    block.~HeapBlock();
+    heap.block_allocator().deallocate_block(&block);
 }
 
 HeapBlock::HeapBlock(Heap& heap, size_t cell_size)
@@ -84,6 +76,29 @@ void HeapBlock::deallocate(Cell* cell)
     freelist_entry->set_live(false);
     freelist_entry->next = m_freelist;
     m_freelist = freelist_entry;
+    --m_allocated_cell_count;
+}
+
+size_t HeapBlock::sweep()
+{
+    VERIFY(m_needs_sweep);
+    m_needs_sweep = false;
+
+    size_t collected_cells = 0;
+    for_each_cell([&](Cell* cell) {
+        if (!cell->is_live())
+            return;
+        if (cell->is_marked()) {
+            cell->set_marked(false);
+            return;
+        }
+#if HEAP_DEBUG
+        dbgln("  ~ {}", cell);
+#endif
+        deallocate(cell);
+        ++collected_cells;
+    });
+    return collected_cells;
 }
 
 }
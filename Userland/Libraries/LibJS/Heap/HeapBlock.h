@@ -39,24 +39,35 @@ class HeapBlock {
 
 public:
     static constexpr size_t block_size = 16 * KiB;
-    static NonnullOwnPtr<HeapBlock> create_with_cell_size(Heap&, size_t);
-
-    void operator delete(void*);
+    static HeapBlock* create_with_cell_size(Heap&, size_t);
+    static void destroy(HeapBlock&);
 
     size_t cell_size() const { return m_cell_size; }
     size_t cell_count() const { return (block_size - sizeof(HeapBlock)) / m_cell_size; }
+    size_t allocated_cell_count() const { return m_allocated_cell_count; }
     bool is_full() const { return !m_freelist; }
+    bool is_empty() const { return !m_allocated_cell_count; }
 
     ALWAYS_INLINE Cell* allocate()
     {
         if (!m_freelist)
             return nullptr;
         VERIFY(is_valid_cell_pointer(m_freelist));
+        ++m_allocated_cell_count;
         return exchange(m_freelist, m_freelist->next);
     }
 
     void deallocate(Cell*);
 
+    // Set on every block once marking is done. Until the block is swept, its unmarked live cells
+    // are garbage that hasn't been finalized yet.
+    bool needs_sweep() const { return m_needs_sweep; }
+    void set_needs_sweep() { m_needs_sweep = true; }
+
+    // Finalizes all unmarked cells and clears the mark bits of the others.
+    // Returns the number of cells that were collected.
+    size_t sweep();
+
     template<typename Callback>
     void for_each_cell(Callback callback)
     {
@@ -109,6 +120,8 @@ private:
 
     Heap& m_heap;
     size_t m_cell_size { 0 };
+    size_t m_allocated_cell_count { 0 };
+    bool m_needs_sweep { false };
     FreelistEntry* m_freelist { nullptr };
     alignas(Cell) u8 m_storage[];
 };
@@ -25,7 +25,11 @@
  */
 
 #include <AK/StringBuilder.h>
+#include <LibCore/Trace.h>
 #include <LibJS/AST.h>
+#include <LibJS/Bytecode/Block.h>
+#include <LibJS/Bytecode/Generator.h>
+#include <LibJS/Bytecode/Interpreter.h>
 #include <LibJS/Interpreter.h>
 #include <LibJS/Runtime/GlobalObject.h>
 #include <LibJS/Runtime/LexicalEnvironment.h>
@@ -56,6 +60,7 @@ Interpreter::~Interpreter()
 
 Value Interpreter::run(GlobalObject& global_object, const Program& program)
 {
+    TRACE_SCOPE("js", "Interpreter::run");
     auto& vm = this->vm();
     VERIFY(!vm.exception());
 
@@ -70,6 +75,20 @@ Value Interpreter::run(GlobalObject& global_object, const Program& program)
     global_call_frame.is_strict_mode = program.is_strict_mode();
     vm.push_call_frame(global_call_frame, global_object);
     VERIFY(!vm.exception());
+
+    if (m_bytecode_enabled) {
+        if (auto block = Bytecode::Generator::generate(program)) {
+            if (m_dump_bytecode)
+                block->dump();
+            Bytecode::Interpreter bytecode_interpreter(*this, global_object);
+            auto completion = bytecode_interpreter.run(*block);
+            if (!vm.exception())
+                vm.set_last_value({}, completion);
+            vm.pop_call_frame();
+            return js_undefined();
+        }
+    }
+
     auto result = program.execute(*this, global_object);
     vm.pop_call_frame();
     return result;
@@ -97,25 +116,18 @@ void Interpreter::enter_scope(const ScopeNode& scope_node, ScopeType scope_type,
         return;
     }
 
-    HashMap<FlyString, Variable> scope_variables_with_declaration_kind;
-    scope_variables_with_declaration_kind.ensure_capacity(16);
+    bool pushed_lexical_environment = false;
 
-    for (auto& declaration : scope_node.variables()) {
-        for (auto& declarator : declaration.declarations()) {
-            if (is<Program>(scope_node)) {
+    if (is<Program>(scope_node)) {
+        for (auto& declaration : scope_node.variables()) {
+            for (auto& declarator : declaration.declarations()) {
                 global_object.put(declarator.id().string(), js_undefined());
                 if (exception())
                     return;
-            } else {
-                scope_variables_with_declaration_kind.set(declarator.id().string(), { js_undefined(), declaration.declaration_kind() });
             }
         }
-    }
-
-    bool pushed_lexical_environment = false;
-
-    if (!scope_variables_with_declaration_kind.is_empty()) {
-        auto* block_lexical_environment = heap().allocate<LexicalEnvironment>(global_object, move(scope_variables_with_declaration_kind), current_scope());
+    } else if (!scope_node.layout().is_empty()) {
+        auto* block_lexical_environment = heap().allocate<LexicalEnvironment>(global_object, scope_node.layout(), current_scope());
         vm().call_frame().scope = block_lexical_environment;
         pushed_lexical_environment = true;
     }
@@ -82,6 +82,12 @@ public:
 
     Value execute_statement(GlobalObject&, const Statement&, ScopeType = ScopeType::Block);
 
+    // When enabled, programs are compiled to bytecode and run on Bytecode::Interpreter if the generator
+    // supports every node in them; anything else (and all function bodies) still runs on the AST.
+    bool is_bytecode_enabled() const { return m_bytecode_enabled; }
+    void set_bytecode_enabled(bool enabled) { m_bytecode_enabled = enabled; }
+    void set_dump_bytecode(bool dump) { m_dump_bytecode = dump; }
+
 private:
     explicit Interpreter(VM&);
 
@@ -92,6 +98,9 @@ private:
     NonnullRefPtr<VM> m_vm;
 
     Handle<Object> m_global_object;
+
+    bool m_bytecode_enabled { false };
+    bool m_dump_bytecode { false };
 };
 
 }
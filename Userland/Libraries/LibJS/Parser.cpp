@@ -57,21 +57,21 @@ public:
         , m_mask(mask)
     {
         if (m_mask & Var)
-            m_parser.m_parser_state.m_var_scopes.append(NonnullRefPtrVector<VariableDeclaration>());
+            m_parser.m_var_scopes.append(NonnullRefPtrVector<VariableDeclaration>());
         if (m_mask & Let)
-            m_parser.m_parser_state.m_let_scopes.append(NonnullRefPtrVector<VariableDeclaration>());
+            m_parser.m_let_scopes.append(NonnullRefPtrVector<VariableDeclaration>());
         if (m_mask & Function)
-            m_parser.m_parser_state.m_function_scopes.append(NonnullRefPtrVector<FunctionDeclaration>());
+            m_parser.m_function_scopes.append(NonnullRefPtrVector<FunctionDeclaration>());
     }
 
     ~ScopePusher()
     {
         if (m_mask & Var)
-            m_parser.m_parser_state.m_var_scopes.take_last();
+            m_parser.m_var_scopes.take_last();
         if (m_mask & Let)
-            m_parser.m_parser_state.m_let_scopes.take_last();
+            m_parser.m_let_scopes.take_last();
         if (m_mask & Function)
-            m_parser.m_parser_state.m_function_scopes.take_last();
+            m_parser.m_function_scopes.take_last();
     }
 
     Parser& m_parser;
@@ -244,10 +244,69 @@ Associativity Parser::operator_associativity(TokenType type) const
     }
 }
 
+Parser::LexicalScopePusher::LexicalScopePusher(Parser& parser, LexicalScope::Type type)
+    : m_parser(parser)
+    , m_scope(*new LexicalScope { type, parser.m_current_lexical_scope })
+{
+    m_parser.m_lexical_scopes.append(adopt_own(m_scope));
+    m_parser.m_current_lexical_scope = &m_scope;
+}
+
+Parser::LexicalScopePusher::~LexicalScopePusher()
+{
+    VERIFY(m_parser.m_current_lexical_scope == &m_scope);
+    m_parser.m_current_lexical_scope = m_scope.parent;
+    if (!m_scope.parent)
+        m_parser.resolve_identifiers();
+}
+
+void Parser::LexicalScopePusher::complete(const ScopeLayout* layout)
+{
+    m_scope.layout = layout;
+    m_scope.is_complete = true;
+}
+
+void Parser::register_identifier(Identifier& identifier)
+{
+    // "arguments" is special-cased by the interpreter and must always be looked up by name.
+    if (!m_current_lexical_scope || identifier.string() == "arguments")
+        return;
+    m_identifier_references.append({ identifier, m_current_lexical_scope });
+}
+
+void Parser::resolve_identifiers()
+{
+    for (auto& reference : m_identifier_references) {
+        auto& name = reference.identifier->string();
+        BindingLocation location;
+        for (auto* scope = reference.scope; scope;) {
+            if (!scope->is_complete || scope->type == LexicalScope::Type::Program || scope->type == LexicalScope::Type::With)
+                break;
+            if (scope->layout) {
+                location.layouts.append(scope->layout.ptr());
+                if (auto index = scope->layout->index_of(name); index.has_value()) {
+                    location.index = index.value();
+                    reference.identifier->set_binding_location(move(location));
+                    break;
+                }
+            }
+            auto* parent = scope->parent;
+            // Function declarations are instantiated when their enclosing block is entered,
+            // before that block's own environment has been pushed.
+            if (scope->is_function_declaration && parent && parent->type == LexicalScope::Type::Block && parent->layout)
+                parent = parent->parent;
+            scope = parent;
+        }
+    }
+    m_identifier_references.clear();
+    m_lexical_scopes.clear();
+}
+
 NonnullRefPtr<Program> Parser::parse_program()
 {
     auto rule_start = push_start();
     ScopePusher scope(*this, ScopePusher::Var | ScopePusher::Let | ScopePusher::Function);
+    LexicalScopePusher lexical_scope(*this, LexicalScope::Type::Program);
     auto program = adopt(*new Program({ rule_start.position(), position() }));
 
     bool first = true;
@@ -271,10 +330,10 @@ NonnullRefPtr<Program> Parser::parse_program()
         }
         first = false;
     }
-    if (m_parser_state.m_var_scopes.size() == 1) {
-        program->add_variables(m_parser_state.m_var_scopes.last());
-        program->add_variables(m_parser_state.m_let_scopes.last());
-        program->add_functions(m_parser_state.m_function_scopes.last());
+    if (m_var_scopes.size() == 1) {
+        program->add_variables(m_var_scopes.last());
+        program->add_variables(m_let_scopes.last());
+        program->add_functions(m_function_scopes.last());
     } else {
         syntax_error("Unclosed scope");
     }
@@ -290,7 +349,7 @@ NonnullRefPtr<Declaration> Parser::parse_declaration()
         return parse_class_declaration();
     case TokenType::Function: {
         auto declaration = parse_function_node<FunctionDeclaration>();
-        m_parser_state.m_function_scopes.last().append(declaration);
+        m_function_scopes.last().append(declaration);
         return declaration;
     }
     case TokenType::Let:
@@ -362,11 +421,12 @@ NonnullRefPtr<Statement> Parser::parse_statement()
 RefPtr<FunctionExpression> Parser::try_parse_arrow_function_expression(bool expect_parens)
 {
     save_state();
-    m_parser_state.m_var_scopes.append(NonnullRefPtrVector<VariableDeclaration>());
+    m_var_scopes.append(NonnullRefPtrVector<VariableDeclaration>());
+    LexicalScopePusher lexical_scope(*this, LexicalScope::Type::Function);
     auto rule_start = push_start();
 
     ArmedScopeGuard state_rollback_guard = [&] {
-        m_parser_state.m_var_scopes.take_last();
+        m_var_scopes.take_last();
         load_state();
     };
 
@@ -435,7 +495,11 @@ RefPtr<FunctionExpression> Parser::try_parse_arrow_function_expression(bool expe
         state_rollback_guard.disarm();
         discard_saved_state();
         auto body = function_body_result.release_nonnull();
-        return create_ast_node<FunctionExpression>({ rule_start.position(), position() }, "", move(body), move(parameters), function_length, m_parser_state.m_var_scopes.take_last(), is_strict, true);
+        // Like for other functions, vars declared in the body belong to the function's own scope.
+        body->add_variables(m_var_scopes.take_last());
+        auto function = create_ast_node<FunctionExpression>({ rule_start.position(), position() }, "", move(body), move(parameters), function_length, NonnullRefPtrVector<VariableDeclaration>(), is_strict, true);
+        lexical_scope.complete(static_cast<const ScopeNode&>(function->body()).function_layout());
+        return function;
     }
 
     return nullptr;
@@ -608,7 +672,7 @@ NonnullRefPtr<ClassExpression> Parser::parse_class_expression(bool expect_class_
             // constructor(... args){ super (...args);}
             auto super_call = create_ast_node<CallExpression>({ rule_start.position(), position() }, create_ast_node<SuperExpression>({ rule_start.position(), position() }), Vector { CallExpression::Argument { create_ast_node<Identifier>({ rule_start.position(), position() }, "args"), true } });
             constructor_body->append(create_ast_node<ExpressionStatement>({ rule_start.position(), position() }, move(super_call)));
-            constructor_body->add_variables(m_parser_state.m_var_scopes.last());
+            constructor_body->add_variables(m_var_scopes.last());
 
             constructor = create_ast_node<FunctionExpression>({ rule_start.position(), position() }, class_name, move(constructor_body), Vector { FunctionNode::Parameter { "args", nullptr, true } }, 0, NonnullRefPtrVector<VariableDeclaration>(), true);
         } else {
@@ -651,7 +715,9 @@ NonnullRefPtr<Expression> Parser::parse_primary_expression()
         auto arrow_function_result = try_parse_arrow_function_expression(false);
         if (!arrow_function_result.is_null())
             return arrow_function_result.release_nonnull();
-        return create_ast_node<Identifier>({ rule_start.position(), position() }, consume().value());
+        auto identifier = create_ast_node<Identifier>({ rule_start.position(), position() }, consume().value());
+        register_identifier(identifier);
+        return identifier;
     }
     case TokenType::NumericLiteral:
         return create_ast_node<NumericLiteral>({ rule_start.position(), position() }, consume_and_validate_numeric_literal().double_value());
@@ -812,7 +878,9 @@ NonnullRefPtr<ObjectExpression> Parser::parse_object_expression()
                 property_name = parse_property_key();
             } else {
                 property_name = create_ast_node<StringLiteral>({ rule_start.position(), position() }, identifier);
-                property_value = create_ast_node<Identifier>({ rule_start.position(), position() }, identifier);
+                auto identifier_node = create_ast_node<Identifier>({ rule_start.position(), position() }, identifier);
+                register_identifier(identifier_node);
+                property_value = move(identifier_node);
             }
         } else {
             property_name = parse_property_key();
@@ -1275,6 +1343,14 @@ NonnullRefPtr<BlockStatement> Parser::parse_block_statement(bool& is_strict)
 {
     auto rule_start = push_start();
     ScopePusher scope(*this, ScopePusher::Let);
+
+    // A function body shares the function's environment rather than getting one of its own.
+    OwnPtr<LexicalScopePusher> lexical_scope;
+    if (m_current_lexical_scope && m_current_lexical_scope->type == LexicalScope::Type::Function && !m_current_lexical_scope->has_function_body)
+        m_current_lexical_scope->has_function_body = true;
+    else
+        lexical_scope = make<LexicalScopePusher>(*this, LexicalScope::Type::Block);
+
     auto block = create_ast_node<BlockStatement>({ rule_start.position(), position() });
     consume(TokenType::CurlyOpen);
 
@@ -1306,8 +1382,10 @@ NonnullRefPtr<BlockStatement> Parser::parse_block_statement(bool& is_strict)
     m_parser_state.m_strict_mode = initial_strict_mode_state;
     m_parser_state.m_string_legacy_octal_escape_sequence_in_scope = false;
     consume(TokenType::CurlyClose);
-    block->add_variables(m_parser_state.m_let_scopes.last());
-    block->add_functions(m_parser_state.m_function_scopes.last());
+    block->add_variables(m_let_scopes.last());
+    block->add_functions(m_function_scopes.last());
+    if (lexical_scope)
+        lexical_scope->complete(block->layout().is_empty() ? nullptr : &block->layout());
     return block;
 }
 
@@ -1321,6 +1399,8 @@ NonnullRefPtr<FunctionNodeType> Parser::parse_function_node(u8 parse_options)
     TemporaryChange super_constructor_call_rollback(m_parser_state.m_allow_super_constructor_call, !!(parse_options & FunctionNodeParseOptions::AllowSuperConstructorCall));
 
     ScopePusher scope(*this, ScopePusher::Var | ScopePusher::Function);
+    LexicalScopePusher lexical_scope(*this, LexicalScope::Type::Function);
+    lexical_scope.scope().is_function_declaration = IsSame<FunctionNodeType, FunctionDeclaration>::value;
 
     String name;
     if (parse_options & FunctionNodeParseOptions::CheckForFunctionAndName) {
@@ -1344,9 +1424,11 @@ NonnullRefPtr<FunctionNodeType> Parser::parse_function_node(u8 parse_options)
 
     bool is_strict = false;
     auto body = parse_block_statement(is_strict);
-    body->add_variables(m_parser_state.m_var_scopes.last());
-    body->add_functions(m_parser_state.m_function_scopes.last());
-    return create_ast_node<FunctionNodeType>({ rule_start.position(), position() }, name, move(body), move(parameters), function_length, NonnullRefPtrVector<VariableDeclaration>(), is_strict);
+    body->add_variables(m_var_scopes.last());
+    body->add_functions(m_function_scopes.last());
+    auto function = create_ast_node<FunctionNodeType>({ rule_start.position(), position() }, name, move(body), move(parameters), function_length, NonnullRefPtrVector<VariableDeclaration>(), is_strict);
+    lexical_scope.complete(static_cast<const ScopeNode&>(function->body()).function_layout());
+    return function;
 }
 
 Vector<FunctionNode::Parameter> Parser::parse_function_parameters(int& function_length, u8 parse_options)
@@ -1441,7 +1523,9 @@ NonnullRefPtr<VariableDeclaration> Parser::parse_variable_declaration(bool for_l
         } else if (!for_loop_variable_declaration && declaration_kind == DeclarationKind::Const) {
             syntax_error("Missing initializer in 'const' variable declaration");
         }
-        declarations.append(create_ast_node<VariableDeclarator>({ rule_start.position(), position() }, create_ast_node<Identifier>({ rule_start.position(), position() }, move(id)), move(init)));
+        auto identifier = create_ast_node<Identifier>({ rule_start.position(), position() }, move(id));
+        register_identifier(identifier);
+        declarations.append(create_ast_node<VariableDeclarator>({ rule_start.position(), position() }, move(identifier), move(init)));
         if (match(TokenType::Comma)) {
             consume();
             continue;
@@ -1453,9 +1537,9 @@ NonnullRefPtr<VariableDeclaration> Parser::parse_variable_declaration(bool for_l
 
     auto declaration = create_ast_node<VariableDeclaration>({ rule_start.position(), position() }, declaration_kind, move(declarations));
     if (declaration_kind == DeclarationKind::Var)
-        m_parser_state.m_var_scopes.last().append(declaration);
+        m_var_scopes.last().append(declaration);
     else
-        m_parser_state.m_let_scopes.last().append(declaration);
+        m_let_scopes.last().append(declaration);
     return declaration;
 }
 
@@ -1631,6 +1715,7 @@ NonnullRefPtr<WithStatement> Parser::parse_with_statement()
 
     consume(TokenType::ParenClose);
 
+    LexicalScopePusher lexical_scope(*this, LexicalScope::Type::With);
     auto body = parse_statement();
     return create_ast_node<WithStatement>({ rule_start.position(), position() }, move(object), move(body));
 }
@@ -1672,8 +1757,11 @@ NonnullRefPtr<CatchClause> Parser::parse_catch_clause()
         consume(TokenType::ParenClose);
     }
 
+    LexicalScopePusher lexical_scope(*this, LexicalScope::Type::Catch);
     auto body = parse_block_statement();
-    return create_ast_node<CatchClause>({ rule_start.position(), position() }, parameter, move(body));
+    auto catch_clause = create_ast_node<CatchClause>({ rule_start.position(), position() }, parameter, move(body));
+    lexical_scope.complete(&catch_clause->layout());
+    return catch_clause;
 }
 
 NonnullRefPtr<IfStatement> Parser::parse_if_statement()
@@ -1687,7 +1775,7 @@ NonnullRefPtr<IfStatement> Parser::parse_if_statement()
         ScopePusher scope(*this, ScopePusher::Let);
         auto block = create_ast_node<BlockStatement>({ rule_start.position(), position() });
         block->append(parse_declaration());
-        block->add_functions(m_parser_state.m_function_scopes.last());
+        block->add_functions(m_function_scopes.last());
         return block;
     };
 
@@ -1725,6 +1813,7 @@ NonnullRefPtr<Statement> Parser::parse_for_statement()
     consume(TokenType::ParenOpen);
 
     bool in_scope = false;
+    OwnPtr<LexicalScopePusher> lexical_scope;
     RefPtr<ASTNode> init;
     if (!match(TokenType::Semicolon)) {
         if (match_expression()) {
@@ -1733,12 +1822,17 @@ NonnullRefPtr<Statement> Parser::parse_for_statement()
                 return parse_for_in_of_statement(*init);
         } else if (match_variable_declaration()) {
             if (!match(TokenType::Var)) {
-                m_parser_state.m_let_scopes.append(NonnullRefPtrVector<VariableDeclaration>());
+                m_let_scopes.append(NonnullRefPtrVector<VariableDeclaration>());
                 in_scope = true;
+                lexical_scope = make<LexicalScopePusher>(*this, LexicalScope::Type::Block);
             }
             init = parse_variable_declaration(true);
-            if (match_for_in_of())
+            if (match_for_in_of()) {
+                // for-in/of loops don't give their declaration an environment.
+                if (lexical_scope)
+                    lexical_scope->complete(nullptr);
                 return parse_for_in_of_statement(*init);
+            }
             if (static_cast<VariableDeclaration&>(*init).declaration_kind() == DeclarationKind::Const) {
                 for (auto& declaration : static_cast<VariableDeclaration&>(*init).declarations()) {
                     if (!declaration.init())
@@ -1768,10 +1862,13 @@ NonnullRefPtr<Statement> Parser::parse_for_statement()
     auto body = parse_statement();
 
     if (in_scope) {
-        m_parser_state.m_let_scopes.take_last();
+        m_let_scopes.take_last();
     }
 
-    return create_ast_node<ForStatement>({ rule_start.position(), position() }, move(init), move(test), move(update), move(body));
+    auto for_statement = create_ast_node<ForStatement>({ rule_start.position(), position() }, move(init), move(test), move(update), move(body));
+    if (lexical_scope)
+        lexical_scope->complete(for_statement->scope_wrapper() ? &for_statement->scope_wrapper()->layout() : nullptr);
+    return for_statement;
 }
 
 NonnullRefPtr<Statement> Parser::parse_for_in_of_statement(NonnullRefPtr<ASTNode> lhs)
@@ -27,7 +27,9 @@
 #pragma once
 
 #include <AK/HashTable.h>
+#include <AK/NonnullOwnPtrVector.h>
 #include <AK/NonnullRefPtr.h>
+#include <AK/OwnPtr.h>
 #include <AK/StringBuilder.h>
 #include <LibJS/AST.h>
 #include <LibJS/Lexer.h>
@@ -200,13 +202,52 @@ private:
 
     [[nodiscard]] RulePosition push_start() { return { *this, position() }; }
 
+    // A model of the environments the interpreter will create, so identifier references can be
+    // resolved to (environment, slot) pairs once all declarations are known. Scopes that get no
+    // environment at runtime have no layout and are skipped; with statements and the program
+    // scope end resolution, leaving the identifier to be looked up by name.
+    struct LexicalScope {
+        enum class Type {
+            Program,
+            Function,
+            Block,
+            Catch,
+            With,
+        };
+
+        Type type;
+        LexicalScope* parent { nullptr };
+        RefPtr<const ScopeLayout> layout {};
+        bool is_complete { false };
+        bool is_function_declaration { false };
+        bool has_function_body { false };
+    };
+
+    class LexicalScopePusher {
+        AK_MAKE_NONCOPYABLE(LexicalScopePusher);
+        AK_MAKE_NONMOVABLE(LexicalScopePusher);
+
+    public:
+        LexicalScopePusher(Parser&, LexicalScope::Type);
+        ~LexicalScopePusher();
+
+        // Called once the scope's AST node exists; a null layout means no environment is created for it.
+        void complete(const ScopeLayout* layout);
+
+        LexicalScope& scope() { return m_scope; }
+
+    private:
+        Parser& m_parser;
+        LexicalScope& m_scope;
+    };
+
+    void register_identifier(Identifier&);
+    void resolve_identifiers();
+
     struct ParserState {
         Lexer m_lexer;
         Token m_current_token;
         Vector<Error> m_errors;
-        Vector<NonnullRefPtrVector<VariableDeclaration>> m_var_scopes;
-        Vector<NonnullRefPtrVector<VariableDeclaration>> m_let_scopes;
-        Vector<NonnullRefPtrVector<FunctionDeclaration>> m_function_scopes;
         HashTable<StringView> m_labels_in_scope;
         bool m_strict_mode { false };
         bool m_allow_super_property_lookup { false };
@@ -223,5 +264,20 @@ private:
     Vector<Position> m_rule_starts;
     ParserState m_parser_state;
     Vector<ParserState> m_saved_state;
+
+    // These are kept out of ParserState, as saving the state happens often and copying the declarations
+    // made so far would make parsing quadratic. Speculatively parsing something never declares anything.
+    Vector<NonnullRefPtrVector<VariableDeclaration>> m_var_scopes;
+    Vector<NonnullRefPtrVector<VariableDeclaration>> m_let_scopes;
+    Vector<NonnullRefPtrVector<FunctionDeclaration>> m_function_scopes;
+
+    struct IdentifierReference {
+        NonnullRefPtr<Identifier> identifier;
+        LexicalScope* scope { nullptr };
+    };
+
+    NonnullOwnPtrVector<LexicalScope> m_lexical_scopes;
+    LexicalScope* m_current_lexical_scope { nullptr };
+    Vector<IdentifierReference> m_identifier_references;
 };
 }
@@ -107,6 +107,17 @@ static Function* callback_from_args(GlobalObject& global_object, const String& n
     return &callback.as_function();
 }
 
+// Returns the elements of `object` if it's an Array whose elements are all present in simple storage.
+// Such elements can be read directly, since looking them up can't reach a getter or the prototype chain.
+static const Vector<Value>* packed_elements_of(Object& object)
+{
+    if (!is<Array>(object))
+        return nullptr;
+    if (auto* storage = object.indexed_properties().packed_storage())
+        return &storage->elements();
+    return nullptr;
+}
+
 static void for_each_item(VM& vm, GlobalObject& global_object, const String& name, AK::Function<IterationDecision(size_t index, Value value, Value callback_result)> callback, bool skip_empty = true)
 {
     auto* this_object = vm.this_value(global_object).to_object(global_object);
@@ -124,9 +135,16 @@ static void for_each_item(VM& vm, GlobalObject& global_object, const String& nam
     auto this_value = vm.argument(1);
 
     for (size_t i = 0; i < initial_length; ++i) {
-        auto value = this_object->get(i);
-        if (vm.exception())
-            return;
+        // The callback may modify the array, so check whether its elements can still be read directly every time.
+        Value value;
+        auto* packed_elements = packed_elements_of(*this_object);
+        if (packed_elements && i < this_object->indexed_properties().array_like_size()) {
+            value = packed_elements->at(i);
+        } else {
+            value = this_object->get(i);
+            if (vm.exception())
+                return;
+        }
         if (value.is_empty()) {
             if (skip_empty)
                 continue;
@@ -170,13 +188,14 @@ JS_DEFINE_NATIVE_FUNCTION(ArrayPrototype::map)
     if (vm.exception())
         return {};
     auto* new_array = Array::create(global_object);
-    new_array->indexed_properties().set_array_like_size(initial_length);
     for_each_item(vm, global_object, "map", [&](auto index, auto, auto callback_result) {
         if (vm.exception())
             return IterationDecision::Break;
         new_array->define_property(index, callback_result);
         return IterationDecision::Continue;
     });
+    // Setting the length last keeps the result in simple storage while it's being filled in.
+    new_array->indexed_properties().set_array_like_size(initial_length);
     return Value(new_array);
 }
 
@@ -455,6 +474,23 @@ JS_DEFINE_NATIVE_FUNCTION(ArrayPrototype::index_of)
             from_index = max(length + from_index, 0);
     }
     auto search_element = vm.argument(0);
+    if (auto* packed_elements = packed_elements_of(*this_object)) {
+        auto& storage = *this_object->indexed_properties().packed_storage();
+        length = min((size_t)length, storage.array_like_size());
+        if (search_element.is_number() && storage.element_kind() == SimpleIndexedPropertyStorage::ElementKind::PackedNumbers) {
+            auto search_number = search_element.as_double();
+            for (i32 i = from_index; i < length; ++i) {
+                if (packed_elements->at(i).as_double() == search_number)
+                    return Value(i);
+            }
+            return Value(-1);
+        }
+        for (i32 i = from_index; i < length; ++i) {
+            if (strict_eq(packed_elements->at(i), search_element))
+                return Value(i);
+        }
+        return Value(-1);
+    }
     for (i32 i = from_index; i < length; ++i) {
         auto element = this_object->get(i);
         if (vm.exception())
@@ -595,110 +631,96 @@ JS_DEFINE_NATIVE_FUNCTION(ArrayPrototype::reverse)
     return array;
 }
 
-static void array_merge_sort(VM& vm, GlobalObject& global_object, Function* compare_func, MarkedValueList& arr_to_sort)
+static double compare_array_elements(VM& vm, GlobalObject& global_object, Function* compare_func, Value x, Value y)
 {
-    // FIXME: it would probably be better to switch to insertion sort for small arrays for
-    // better performance
-    if (arr_to_sort.size() <= 1)
-        return;
-
-    MarkedValueList left(vm.heap());
-    MarkedValueList right(vm.heap());
-
-    left.ensure_capacity(arr_to_sort.size() / 2);
-    right.ensure_capacity(arr_to_sort.size() / 2 + (arr_to_sort.size() & 1));
-
-    for (size_t i = 0; i < arr_to_sort.size(); ++i) {
-        if (i < arr_to_sort.size() / 2) {
-            left.append(arr_to_sort[i]);
-        } else {
-            right.append(arr_to_sort[i]);
-        }
+    if (x.is_undefined() && y.is_undefined())
+        return 0;
+    if (x.is_undefined())
+        return 1;
+    if (y.is_undefined())
+        return -1;
+
+    if (compare_func) {
+        auto call_result = vm.call(*compare_func, js_undefined(), x, y);
+        if (vm.exception())
+            return 0;
+        if (call_result.is_nan())
+            return 0;
+        return call_result.to_double(global_object);
     }
 
-    array_merge_sort(vm, global_object, compare_func, left);
+    // FIXME: It would probably be much better to be smarter about this and implement
+    // the Abstract Relational Comparison in line once iterating over code points, rather
+    // than calling it twice after creating two primitive strings.
+
+    auto x_string = x.to_primitive_string(global_object);
     if (vm.exception())
-        return;
-    array_merge_sort(vm, global_object, compare_func, right);
+        return 0;
+    auto y_string = y.to_primitive_string(global_object);
     if (vm.exception())
-        return;
-
-    arr_to_sort.clear();
+        return 0;
+
+    auto x_string_value = Value(x_string);
+    auto y_string_value = Value(y_string);
+
+    // Because they are called with primitive strings, these abstract_relation calls
+    // should never result in a VM exception.
+    auto x_lt_y_relation = abstract_relation(global_object, true, x_string_value, y_string_value);
+    VERIFY(x_lt_y_relation != TriState::Unknown);
+    auto y_lt_x_relation = abstract_relation(global_object, true, y_string_value, x_string_value);
+    VERIFY(y_lt_x_relation != TriState::Unknown);
+
+    if (x_lt_y_relation == TriState::True)
+        return -1;
+    if (y_lt_x_relation == TriState::True)
+        return 1;
+    return 0;
+}
 
-    size_t left_index = 0, right_index = 0;
+static void array_merge_sort(VM& vm, GlobalObject& global_object, Function* compare_func, MarkedValueList& arr_to_sort)
+{
+    // FIXME: it would probably be better to switch to insertion sort for small runs for
+    // better performance
+    auto size = arr_to_sort.size();
+    if (size <= 1)
+        return;
 
-    while (left_index < left.size() && right_index < right.size()) {
-        auto x = left[left_index];
-        auto y = right[right_index];
+    // Bottom-up merge sort, ping-ponging between the input and a single scratch buffer
+    // instead of allocating new lists at every level of recursion.
+    MarkedValueList scratch(vm.heap());
+    scratch.resize(size);
 
-        double comparison_result;
+    auto* source = &arr_to_sort;
+    auto* destination = &scratch;
 
-        if (x.is_undefined() && y.is_undefined()) {
-            comparison_result = 0;
-        } else if (x.is_undefined()) {
-            comparison_result = 1;
-        } else if (y.is_undefined()) {
-            comparison_result = -1;
-        } else if (compare_func) {
-            auto call_result = vm.call(*compare_func, js_undefined(), left[left_index], right[right_index]);
-            if (vm.exception())
-                return;
+    for (size_t width = 1; width < size; width *= 2) {
+        for (size_t start = 0; start < size; start += 2 * width) {
+            auto middle = min(start + width, size);
+            auto end = min(start + 2 * width, size);
+            auto left_index = start;
+            auto right_index = middle;
+            auto output_index = start;
 
-            if (call_result.is_nan()) {
-                comparison_result = 0;
-            } else {
-                comparison_result = call_result.to_double(global_object);
+            while (left_index < middle && right_index < end) {
+                auto comparison_result = compare_array_elements(vm, global_object, compare_func, (*source)[left_index], (*source)[right_index]);
                 if (vm.exception())
                     return;
+                if (comparison_result <= 0)
+                    (*destination)[output_index++] = (*source)[left_index++];
+                else
+                    (*destination)[output_index++] = (*source)[right_index++];
             }
-        } else {
-            // FIXME: It would probably be much better to be smarter about this and implement
-            // the Abstract Relational Comparison in line once iterating over code points, rather
-            // than calling it twice after creating two primitive strings.
-
-            auto x_string = x.to_primitive_string(global_object);
-            if (vm.exception())
-                return;
-            auto y_string = y.to_primitive_string(global_object);
-            if (vm.exception())
-                return;
-
-            auto x_string_value = Value(x_string);
-            auto y_string_value = Value(y_string);
-
-            // Because they are called with primitive strings, these abstract_relation calls
-            // should never result in a VM exception.
-            auto x_lt_y_relation = abstract_relation(global_object, true, x_string_value, y_string_value);
-            VERIFY(x_lt_y_relation != TriState::Unknown);
-            auto y_lt_x_relation = abstract_relation(global_object, true, y_string_value, x_string_value);
-            VERIFY(y_lt_x_relation != TriState::Unknown);
-
-            if (x_lt_y_relation == TriState::True) {
-                comparison_result = -1;
-            } else if (y_lt_x_relation == TriState::True) {
-                comparison_result = 1;
-            } else {
-                comparison_result = 0;
-            }
-        }
-
-        if (comparison_result <= 0) {
-            arr_to_sort.append(left[left_index]);
-            left_index++;
-        } else {
-            arr_to_sort.append(right[right_index]);
-            right_index++;
+            while (left_index < middle)
+                (*destination)[output_index++] = (*source)[left_index++];
+            while (right_index < end)
+                (*destination)[output_index++] = (*source)[right_index++];
         }
+        swap(source, destination);
     }
 
-    while (left_index < left.size()) {
-        arr_to_sort.append(left[left_index]);
-        left_index++;
-    }
-
-    while (right_index < right.size()) {
-        arr_to_sort.append(right[right_index]);
-        right_index++;
+    if (source != &arr_to_sort) {
+        for (size_t i = 0; i < size; ++i)
+            arr_to_sort[i] = (*source)[i];
     }
 }
 
@@ -720,13 +742,20 @@ JS_DEFINE_NATIVE_FUNCTION(ArrayPrototype::sort)
 
     MarkedValueList values_to_sort(vm.heap());
 
-    for (size_t i = 0; i < original_length; ++i) {
-        auto element_val = array->get(i);
-        if (vm.exception())
-            return {};
+    auto* packed_elements = packed_elements_of(*array);
+    if (packed_elements && original_length <= array->indexed_properties().array_like_size()) {
+        values_to_sort.ensure_capacity(original_length);
+        for (size_t i = 0; i < original_length; ++i)
+            values_to_sort.unchecked_append(packed_elements->at(i));
+    } else {
+        for (size_t i = 0; i < original_length; ++i) {
+            auto element_val = array->get(i);
+            if (vm.exception())
+                return {};
 
-        if (!element_val.is_empty())
-            values_to_sort.append(element_val);
+            if (!element_val.is_empty())
+                values_to_sort.append(element_val);
+        }
     }
 
     // Perform sorting by merge sort. This isn't as efficient compared to quick sort, but
@@ -738,10 +767,16 @@ JS_DEFINE_NATIVE_FUNCTION(ArrayPrototype::sort)
     if (vm.exception())
         return {};
 
-    for (size_t i = 0; i < values_to_sort.size(); ++i) {
-        array->put(i, values_to_sort[i]);
-        if (vm.exception())
-            return {};
+    // The comparison function may have changed the array, so check again before writing the elements back directly.
+    if (packed_elements_of(*array) && values_to_sort.size() <= array->indexed_properties().array_like_size()) {
+        for (size_t i = 0; i < values_to_sort.size(); ++i)
+            array->indexed_properties().put(array, i, values_to_sort[i]);
+    } else {
+        for (size_t i = 0; i < values_to_sort.size(); ++i) {
+            array->put(i, values_to_sort[i]);
+            if (vm.exception())
+                return {};
+        }
     }
 
     // The empty parts of the array are always sorted to the end, regardless of the
@@ -808,6 +843,14 @@ JS_DEFINE_NATIVE_FUNCTION(ArrayPrototype::includes)
             from_index = max(length + from_index, 0);
     }
     auto value_to_find = vm.argument(0);
+    if (auto* packed_elements = packed_elements_of(*this_object)) {
+        length = min((size_t)length, this_object->indexed_properties().array_like_size());
+        for (i32 i = from_index; i < length; ++i) {
+            if (same_value_zero(packed_elements->at(i), value_to_find))
+                return Value(true);
+        }
+        return Value(false);
+    }
     for (i32 i = from_index; i < length; ++i) {
         auto element = this_object->get(i).value_or(js_undefined());
         if (vm.exception())
@@ -43,6 +43,11 @@ void Cell::Visitor::visit(Value value)
         visit_impl(value.as_cell());
 }
 
+bool Cell::is_awaiting_finalization() const
+{
+    return !m_mark && HeapBlock::from_cell(this)->needs_sweep();
+}
+
 Heap& Cell::heap() const
 {
     return HeapBlock::from_cell(this)->heap();
@@ -49,6 +49,11 @@ public:
     bool is_live() const { return m_live; }
     void set_live(bool b) { m_live = b; }
 
+    // Dead cells are swept lazily, so a cell the last collection found unreachable may stay around for
+    // a while. Anything that can still reach such a cell without a strong reference (e.g. a WeakPtr)
+    // must treat it as gone.
+    bool is_awaiting_finalization() const;
+
     virtual const char* class_name() const = 0;
 
     class Visitor {
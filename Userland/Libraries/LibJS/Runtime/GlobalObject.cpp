@@ -113,6 +113,9 @@ void GlobalObject::initialize()
     JS_ENUMERATE_ITERATOR_PROTOTYPES
 #undef __JS_ENUMERATE
 
+    m_array_prototype_values_function = &m_array_prototype->get(vm.names.values).as_function();
+    m_array_iterator_prototype_next_function = &m_array_iterator_prototype->get(vm.names.next).as_function();
+
     u8 attr = Attribute::Writable | Attribute::Configurable;
     define_native_function(vm.names.gc, gc, 0, attr);
     define_native_function(vm.names.isNaN, is_nan, 1, attr);
@@ -165,6 +168,8 @@ void GlobalObject::visit_edges(Visitor& visitor)
     visitor.visit(m_new_object_shape);
     visitor.visit(m_new_script_function_prototype_object_shape);
     visitor.visit(m_proxy_constructor);
+    visitor.visit(m_array_prototype_values_function);
+    visitor.visit(m_array_iterator_prototype_next_function);
 
 #define __JS_ENUMERATE(ClassName, snake_name, PrototypeName, ConstructorName, ArrayType) \
     visitor.visit(m_##snake_name##_constructor);                                         \
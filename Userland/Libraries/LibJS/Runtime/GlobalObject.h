@@ -56,6 +56,11 @@ public:
     // Not included in JS_ENUMERATE_NATIVE_OBJECTS due to missing distinct prototype
     ProxyConstructor* proxy_constructor() { return m_proxy_constructor; }
 
+    // The original Array.prototype.values and %ArrayIteratorPrototype%.next, so iteration fast paths
+    // can tell whether iterating an array would run user code.
+    Function* array_prototype_values_function() { return m_array_prototype_values_function; }
+    Function* array_iterator_prototype_next_function() { return m_array_iterator_prototype_next_function; }
+
 #define __JS_ENUMERATE(ClassName, snake_name, PrototypeName, ConstructorName, ArrayType) \
     ConstructorName* snake_name##_constructor() { return m_##snake_name##_constructor; } \
     Object* snake_name##_prototype() { return m_##snake_name##_prototype; }
@@ -91,6 +96,9 @@ private:
     // Not included in JS_ENUMERATE_NATIVE_OBJECTS due to missing distinct prototype
     ProxyConstructor* m_proxy_constructor { nullptr };
 
+    Function* m_array_prototype_values_function { nullptr };
+    Function* m_array_iterator_prototype_next_function { nullptr };
+
 #define __JS_ENUMERATE(ClassName, snake_name, PrototypeName, ConstructorName, ArrayType) \
     ConstructorName* m_##snake_name##_constructor { nullptr };                           \
     Object* m_##snake_name##_prototype { nullptr };
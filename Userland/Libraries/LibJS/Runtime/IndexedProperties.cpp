@@ -34,6 +34,14 @@ SimpleIndexedPropertyStorage::SimpleIndexedPropertyStorage(Vector<Value>&& initi
     : m_array_size(initial_values.size())
     , m_packed_elements(move(initial_values))
 {
+    for (auto& value : m_packed_elements)
+        did_store(value);
+}
+
+void SimpleIndexedPropertyStorage::did_change_size()
+{
+    if (!m_array_size)
+        m_element_kind = ElementKind::PackedNumbers;
 }
 
 bool SimpleIndexedPropertyStorage::has_index(u32 index) const
@@ -51,35 +59,43 @@ Optional<ValueAndAttributes> SimpleIndexedPropertyStorage::get(u32 index) const
 void SimpleIndexedPropertyStorage::put(u32 index, Value value, PropertyAttributes attributes)
 {
     VERIFY(attributes == default_attributes);
-    VERIFY(index < SPARSE_ARRAY_THRESHOLD);
 
     if (index >= m_array_size) {
+        if (index > m_array_size)
+            m_element_kind = ElementKind::Holey;
         m_array_size = index + 1;
-        if (index >= m_packed_elements.size())
-            m_packed_elements.resize(index + MIN_PACKED_RESIZE_AMOUNT >= SPARSE_ARRAY_THRESHOLD ? SPARSE_ARRAY_THRESHOLD : index + MIN_PACKED_RESIZE_AMOUNT);
+        if (index >= m_packed_elements.size()) {
+            m_packed_elements.grow_capacity(index + MIN_PACKED_RESIZE_AMOUNT);
+            m_packed_elements.resize(index + MIN_PACKED_RESIZE_AMOUNT, true);
+        }
     }
     m_packed_elements[index] = value;
+    did_store(value);
 }
 
 void SimpleIndexedPropertyStorage::remove(u32 index)
 {
-    if (index < m_array_size)
+    if (index < m_array_size) {
         m_packed_elements[index] = {};
+        m_element_kind = ElementKind::Holey;
+    }
 }
 
 void SimpleIndexedPropertyStorage::insert(u32 index, Value value, PropertyAttributes attributes)
 {
     VERIFY(attributes == default_attributes);
-    VERIFY(index < SPARSE_ARRAY_THRESHOLD);
+    VERIFY(index <= m_array_size);
     m_array_size++;
-    VERIFY(m_array_size <= SPARSE_ARRAY_THRESHOLD);
     m_packed_elements.insert(index, value);
+    did_store(value);
 }
 
 ValueAndAttributes SimpleIndexedPropertyStorage::take_first()
 {
     m_array_size--;
-    return { m_packed_elements.take_first(), default_attributes };
+    auto first_element = m_packed_elements.take_first();
+    did_change_size();
+    return { first_element, default_attributes };
 }
 
 ValueAndAttributes SimpleIndexedPropertyStorage::take_last()
@@ -87,21 +103,31 @@ ValueAndAttributes SimpleIndexedPropertyStorage::take_last()
     m_array_size--;
     auto last_element = m_packed_elements[m_array_size];
     m_packed_elements[m_array_size] = {};
+    did_change_size();
     return { last_element, default_attributes };
 }
 
 void SimpleIndexedPropertyStorage::set_array_like_size(size_t new_size)
 {
-    VERIFY(new_size <= SPARSE_ARRAY_THRESHOLD);
+    if (new_size > m_array_size)
+        m_element_kind = ElementKind::Holey;
     m_array_size = new_size;
     m_packed_elements.resize(new_size);
+    did_change_size();
 }
 
 GenericIndexedPropertyStorage::GenericIndexedPropertyStorage(SimpleIndexedPropertyStorage&& storage)
 {
     m_array_size = storage.array_like_size();
-    for (auto& element : move(storage.m_packed_elements))
-        m_packed_elements.append({ element, default_attributes });
+    auto& elements = storage.m_packed_elements;
+    m_packed_elements.ensure_capacity(min(elements.size(), (size_t)SPARSE_ARRAY_THRESHOLD));
+    for (size_t i = 0; i < elements.size(); ++i) {
+        if (i < SPARSE_ARRAY_THRESHOLD)
+            m_packed_elements.unchecked_append({ elements[i], default_attributes });
+        else if (i < m_array_size && !elements[i].is_empty())
+            m_sparse_elements.set(i, { elements[i], default_attributes });
+    }
+    elements.clear();
 }
 
 bool GenericIndexedPropertyStorage::has_index(u32 index) const
@@ -263,6 +289,10 @@ ValueAndAttributes IndexedPropertyIterator::value_and_attributes(Object* this_ob
 
 void IndexedPropertyIterator::skip_empty_indices()
 {
+    if (auto* storage = m_indexed_properties.packed_storage()) {
+        m_index = min(m_index, (u32)storage->array_like_size());
+        return;
+    }
     auto indices = m_indexed_properties.indices();
     for (auto i : indices) {
         if (i < m_index)
@@ -291,7 +321,7 @@ Optional<ValueAndAttributes> IndexedProperties::get(Object* this_object, u32 ind
 
 void IndexedProperties::put(Object* this_object, u32 index, Value value, PropertyAttributes attributes, bool evaluate_accessors)
 {
-    if (m_storage->is_simple_storage() && (index >= SPARSE_ARRAY_THRESHOLD || attributes != default_attributes))
+    if (m_storage->is_simple_storage() && (attributes != default_attributes || should_switch_to_generic_storage_for_index(index)))
         switch_to_generic_storage();
     if (m_storage->is_simple_storage() || !evaluate_accessors) {
         m_storage->put(index, value, attributes);
@@ -320,7 +350,7 @@ bool IndexedProperties::remove(u32 index)
 
 void IndexedProperties::insert(u32 index, Value value, PropertyAttributes attributes)
 {
-    if (m_storage->is_simple_storage() && (index >= SPARSE_ARRAY_THRESHOLD || attributes != default_attributes || array_like_size() == SPARSE_ARRAY_THRESHOLD))
+    if (m_storage->is_simple_storage() && (attributes != default_attributes || index > array_like_size()))
         switch_to_generic_storage();
     m_storage->insert(index, move(value), attributes);
 }
@@ -356,7 +386,7 @@ void IndexedProperties::append_all(Object* this_object, const IndexedProperties&
 
 void IndexedProperties::set_array_like_size(size_t new_size)
 {
-    if (m_storage->is_simple_storage() && new_size > SPARSE_ARRAY_THRESHOLD)
+    if (m_storage->is_simple_storage() && new_size > array_like_size() && should_switch_to_generic_storage_for_index(new_size - 1))
         switch_to_generic_storage();
     m_storage->set_array_like_size(new_size);
 }
@@ -387,6 +417,13 @@ Vector<u32> IndexedProperties::indices() const
     return indices;
 }
 
+// Simple storage holds every element up to array_like_size(), so it only stays simple as long as
+// writes don't leave a large gap behind the current end of the array.
+bool IndexedProperties::should_switch_to_generic_storage_for_index(u32 index) const
+{
+    return index >= array_like_size() + SPARSE_ARRAY_THRESHOLD;
+}
+
 void IndexedProperties::switch_to_generic_storage()
 {
     auto& storage = static_cast<SimpleIndexedPropertyStorage&>(*m_storage);
@@ -85,11 +85,32 @@ public:
     virtual bool is_simple_storage() const override { return true; }
     const Vector<Value>& elements() const { return m_packed_elements; }
 
+    // Tracks what is known about the elements in [0, array_like_size()), so that hot builtins can
+    // read them directly instead of going through property lookups. Transitions only ever go
+    // towards Holey, until the array is emptied.
+    enum class ElementKind : u8 {
+        PackedNumbers, // No holes, and every element is a Number.
+        Packed,        // No holes.
+        Holey,
+    };
+    ElementKind element_kind() const { return m_element_kind; }
+    bool is_packed() const { return m_element_kind != ElementKind::Holey; }
+
 private:
     friend GenericIndexedPropertyStorage;
 
+    void did_store(Value value)
+    {
+        if (value.is_empty())
+            m_element_kind = ElementKind::Holey;
+        else if (m_element_kind == ElementKind::PackedNumbers && !value.is_number())
+            m_element_kind = ElementKind::Packed;
+    }
+    void did_change_size();
+
     size_t m_array_size { 0 };
     Vector<Value> m_packed_elements;
+    ElementKind m_element_kind { ElementKind::PackedNumbers };
 };
 
 class GenericIndexedPropertyStorage final : public IndexedPropertyStorage {
@@ -167,6 +188,15 @@ public:
 
     Vector<u32> indices() const;
 
+    // Returns the storage if it's simple and has no holes, so its elements can be read directly.
+    const SimpleIndexedPropertyStorage* packed_storage() const
+    {
+        if (!m_storage->is_simple_storage())
+            return nullptr;
+        auto& storage = static_cast<const SimpleIndexedPropertyStorage&>(*m_storage);
+        return storage.is_packed() ? &storage : nullptr;
+    }
+
     template<typename Callback>
     void for_each_value(Callback callback)
     {
@@ -183,6 +213,7 @@ public:
 
 private:
     void switch_to_generic_storage();
+    bool should_switch_to_generic_storage_for_index(u32 index) const;
 
     NonnullOwnPtr<IndexedPropertyStorage> m_storage { make<SimpleIndexedPropertyStorage>() };
 };
@@ -24,7 +24,9 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <LibJS/Runtime/Array.h>
 #include <LibJS/Runtime/Error.h>
+#include <LibJS/Runtime/Function.h>
 #include <LibJS/Runtime/GlobalObject.h>
 #include <LibJS/Runtime/IteratorOperations.h>
 
@@ -105,7 +107,33 @@ void get_iterator_values(GlobalObject& global_object, Value value, AK::Function<
 {
     auto& vm = global_object.vm();
 
-    auto iterator = get_iterator(global_object, value);
+    Value method;
+    if (value.is_object() && is<Array>(value.as_object())) {
+        auto& array = value.as_object();
+        method = array.get(vm.well_known_symbol_iterator());
+        if (vm.exception())
+            return;
+
+        // With the built-in iterator, iterating an array can't run any user code besides element getters,
+        // so skip allocating the iterator and one result object per element.
+        if (method.is_object() && &method.as_object() == global_object.array_prototype_values_function()) {
+            auto next_method = global_object.array_iterator_prototype()->get(vm.names.next);
+            if (vm.exception())
+                return;
+            if (next_method.is_object() && &next_method.as_object() == global_object.array_iterator_prototype_next_function()) {
+                for (size_t index = 0; index < array.indexed_properties().array_like_size(); ++index) {
+                    auto element = array.get(index);
+                    if (vm.exception())
+                        return;
+                    if (callback(element.value_or(js_undefined())) == IterationDecision::Break)
+                        return;
+                }
+                return;
+            }
+        }
+    }
+
+    auto iterator = get_iterator(global_object, value, "sync", method);
     if (!iterator)
         return;
 
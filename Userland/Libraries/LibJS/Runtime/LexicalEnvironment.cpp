@@ -44,17 +44,20 @@ LexicalEnvironment::LexicalEnvironment(EnvironmentRecordType environment_record_
 {
 }
 
-LexicalEnvironment::LexicalEnvironment(HashMap<FlyString, Variable> variables, ScopeObject* parent_scope)
-    : ScopeObject(parent_scope)
-    , m_variables(move(variables))
+LexicalEnvironment::LexicalEnvironment(const ScopeLayout& layout, ScopeObject* parent_scope)
+    : LexicalEnvironment(layout, parent_scope, EnvironmentRecordType::Declarative)
 {
 }
 
-LexicalEnvironment::LexicalEnvironment(HashMap<FlyString, Variable> variables, ScopeObject* parent_scope, EnvironmentRecordType environment_record_type)
+LexicalEnvironment::LexicalEnvironment(const ScopeLayout& layout, ScopeObject* parent_scope, EnvironmentRecordType environment_record_type)
     : ScopeObject(parent_scope)
     , m_environment_record_type(environment_record_type)
-    , m_variables(move(variables))
+    , m_layout(layout)
+    , m_layout_size(layout.size())
 {
+    m_variables.ensure_capacity(m_layout_size);
+    for (auto& binding : layout.bindings())
+        m_variables.unchecked_append({ js_undefined(), binding.declaration_kind });
 }
 
 LexicalEnvironment::~LexicalEnvironment()
@@ -68,18 +71,40 @@ void LexicalEnvironment::visit_edges(Visitor& visitor)
     visitor.visit(m_home_object);
     visitor.visit(m_new_target);
     visitor.visit(m_current_function);
-    for (auto& it : m_variables)
-        visitor.visit(it.value.value);
+    for (auto& variable : m_variables)
+        visitor.visit(variable.value);
+}
+
+Optional<size_t> LexicalEnvironment::index_of(const FlyString& name) const
+{
+    if (m_layout) {
+        auto index = m_layout->index_of(name);
+        if (index.has_value() && index.value() < m_layout_size)
+            return index;
+    }
+    for (size_t i = 0; i < m_dynamic_names.size(); ++i) {
+        if (m_dynamic_names[i] == name)
+            return m_layout_size + i;
+    }
+    return {};
 }
 
 Optional<Variable> LexicalEnvironment::get_from_scope(const FlyString& name) const
 {
-    return m_variables.get(name);
+    auto index = index_of(name);
+    if (!index.has_value())
+        return {};
+    return m_variables[index.value()];
 }
 
 void LexicalEnvironment::put_to_scope(const FlyString& name, Variable variable)
 {
-    m_variables.set(name, variable);
+    if (auto index = index_of(name); index.has_value()) {
+        m_variables[index.value()] = variable;
+        return;
+    }
+    m_dynamic_names.append(name);
+    m_variables.append(variable);
 }
 
 bool LexicalEnvironment::has_super_binding() const
@@ -27,7 +27,8 @@
 #pragma once
 
 #include <AK/FlyString.h>
-#include <AK/HashMap.h>
+#include <AK/Vector.h>
+#include <LibJS/Runtime/ScopeLayout.h>
 #include <LibJS/Runtime/ScopeObject.h>
 #include <LibJS/Runtime/Value.h>
 
@@ -52,8 +53,8 @@ public:
 
     LexicalEnvironment();
     LexicalEnvironment(EnvironmentRecordType);
-    LexicalEnvironment(HashMap<FlyString, Variable> variables, ScopeObject* parent_scope);
-    LexicalEnvironment(HashMap<FlyString, Variable> variables, ScopeObject* parent_scope, EnvironmentRecordType);
+    LexicalEnvironment(const ScopeLayout&, ScopeObject* parent_scope);
+    LexicalEnvironment(const ScopeLayout&, ScopeObject* parent_scope, EnvironmentRecordType);
     virtual ~LexicalEnvironment() override;
 
     // ^ScopeObject
@@ -61,10 +62,18 @@ public:
     virtual void put_to_scope(const FlyString&, Variable) override;
     virtual bool has_this_binding() const override;
     virtual Value get_this_binding(GlobalObject&) const override;
+    virtual bool is_lexical_environment() const override { return true; }
 
     void clear();
 
-    const HashMap<FlyString, Variable>& variables() const { return m_variables; }
+    const ScopeLayout* layout() const { return m_layout; }
+
+    // The binding at the given index of this environment's layout.
+    Variable& variable_at(size_t index) { return m_variables[index]; }
+    size_t layout_size() const { return m_layout_size; }
+
+    // Bindings that were not part of the layout, e.g. class declarations.
+    bool has_dynamic_bindings() const { return !m_dynamic_names.is_empty(); }
 
     void set_home_object(Value object) { m_home_object = object; }
     bool has_super_binding() const;
@@ -87,9 +96,14 @@ public:
 private:
     virtual void visit_edges(Visitor&) override;
 
+    Optional<size_t> index_of(const FlyString&) const;
+
     EnvironmentRecordType m_environment_record_type : 8 { EnvironmentRecordType::Declarative };
     ThisBindingStatus m_this_binding_status : 8 { ThisBindingStatus::Uninitialized };
-    HashMap<FlyString, Variable> m_variables;
+    RefPtr<const ScopeLayout> m_layout;
+    size_t m_layout_size { 0 };
+    Vector<Variable, 4> m_variables;
+    Vector<FlyString> m_dynamic_names;
     Value m_home_object;
     Value m_this_value;
     Value m_new_target;
@@ -97,4 +111,7 @@ private:
     Function* m_current_function { nullptr };
 };
 
+template<>
+inline bool ScopeObject::fast_is<LexicalEnvironment>() const { return is_lexical_environment(); }
+
 }
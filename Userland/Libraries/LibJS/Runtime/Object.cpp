@@ -343,6 +343,8 @@ Value Object::get_own_property_descriptor_object(const PropertyName& property_na
 
 void Object::set_shape(Shape& new_shape)
 {
+    // Properties are usually added one at a time, so leave some slack instead of reallocating for every one.
+    m_storage.grow_capacity(new_shape.property_count());
     m_storage.resize(new_shape.property_count());
     m_shape = &new_shape;
 }
@@ -489,6 +491,7 @@ bool Object::put_own_property(Object& this_object, const StringOrSymbol& propert
     //       Transitions are primarily interesting when scripts add properties to objects.
     if (!m_transitions_enabled && !m_shape->is_unique()) {
         m_shape->add_property_without_transition(property_name, attributes);
+        m_storage.grow_capacity(m_shape->property_count());
         m_storage.resize(m_shape->property_count());
         m_storage[m_shape->property_count() - 1] = value;
         return true;
@@ -515,11 +518,13 @@ bool Object::put_own_property(Object& this_object, const StringOrSymbol& propert
 
         if (m_shape->is_unique()) {
             m_shape->add_property_to_unique_shape(property_name, attributes);
+            m_storage.grow_capacity(m_shape->property_count());
             m_storage.resize(m_shape->property_count());
         } else if (m_transitions_enabled) {
             set_shape(*m_shape->create_put_transition(property_name, attributes));
         } else {
             m_shape->add_property_without_transition(property_name, attributes);
+            m_storage.grow_capacity(m_shape->property_count());
             m_storage.resize(m_shape->property_count());
         }
         metadata = shape().lookup(property_name);
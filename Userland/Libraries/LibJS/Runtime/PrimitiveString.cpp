@@ -24,6 +24,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/StringBuilder.h>
 #include <LibJS/Runtime/PrimitiveString.h>
 #include <LibJS/Runtime/VM.h>
 
@@ -31,6 +32,15 @@ namespace JS {
 
 PrimitiveString::PrimitiveString(String string)
     : m_string(move(string))
+    , m_byte_length(m_string.length())
+{
+}
+
+PrimitiveString::PrimitiveString(PrimitiveString& lhs, PrimitiveString& rhs)
+    : m_is_rope(true)
+    , m_lhs(&lhs)
+    , m_rhs(&rhs)
+    , m_byte_length(lhs.byte_length() + rhs.byte_length())
 {
 }
 
@@ -38,6 +48,39 @@ PrimitiveString::~PrimitiveString()
 {
 }
 
+void PrimitiveString::visit_edges(Cell::Visitor& visitor)
+{
+    Cell::visit_edges(visitor);
+    if (m_is_rope) {
+        visitor.visit(m_lhs);
+        visitor.visit(m_rhs);
+    }
+}
+
+void PrimitiveString::resolve_rope() const
+{
+    VERIFY(m_is_rope);
+
+    // Ropes built by repeated concatenation are arbitrarily deep, so walk them with an explicit stack.
+    StringBuilder builder(m_byte_length);
+    Vector<const PrimitiveString*> pieces;
+    pieces.append(this);
+    while (!pieces.is_empty()) {
+        auto* piece = pieces.take_last();
+        if (piece->m_is_rope) {
+            pieces.append(piece->m_rhs);
+            pieces.append(piece->m_lhs);
+            continue;
+        }
+        builder.append(piece->m_string);
+    }
+
+    m_string = builder.to_string();
+    m_is_rope = false;
+    m_lhs = nullptr;
+    m_rhs = nullptr;
+}
+
 PrimitiveString* js_string(Heap& heap, String string)
 {
     if (string.is_empty())
@@ -54,4 +97,22 @@ PrimitiveString* js_string(VM& vm, String string)
     return js_string(vm.heap(), move(string));
 }
 
+PrimitiveString* js_rope_string(VM& vm, PrimitiveString& lhs, PrimitiveString& rhs)
+{
+    // Copying short strings is cheaper than keeping (and later walking) a rope node around.
+    static constexpr size_t min_rope_byte_length = 64;
+
+    if (!lhs.byte_length())
+        return &rhs;
+    if (!rhs.byte_length())
+        return &lhs;
+    if (lhs.byte_length() + rhs.byte_length() < min_rope_byte_length) {
+        StringBuilder builder(lhs.byte_length() + rhs.byte_length());
+        builder.append(lhs.string());
+        builder.append(rhs.string());
+        return js_string(vm, builder.to_string());
+    }
+    return vm.heap().allocate_without_global_object<PrimitiveString>(lhs, rhs);
+}
+
 }
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <LibJS/Runtime/Object.h>
+#include <LibJS/Runtime/PropertyCache.h>
+#include <LibJS/Runtime/ProxyObject.h>
+#include <LibJS/Runtime/Shape.h>
+
+namespace JS {
+
+static bool is_cacheable_name(const PropertyName& property_name)
+{
+    if (property_name.is_number())
+        return false;
+    // Object::get() and Object::put() route integer-like strings to the indexed properties.
+    if (property_name.is_string() && property_name.as_string().to_int().value_or(-1) >= 0)
+        return false;
+    return true;
+}
+
+static bool is_cacheable_value(Value value)
+{
+    return !value.is_empty() && !value.is_accessor() && !value.is_native_property();
+}
+
+// Returns the last object of the entry's chain if every shape along it still has the cached key.
+Object* PropertyCache::match(const Entry& entry, Object& receiver)
+{
+    Object* object = &receiver;
+    for (size_t i = 0;; ++i) {
+        if (object->shape().cache_key() != entry.shape_keys[i])
+            return nullptr;
+        if (i + 1 == entry.chain_length)
+            return object;
+        // A matching key pins the prototype too, so this is the same object we saw when filling.
+        object = object->shape().prototype();
+    }
+}
+
+void PropertyCache::add_entry(const Entry& entry)
+{
+    if (m_entry_count < max_entries) {
+        m_entries[m_entry_count++] = entry;
+        return;
+    }
+    m_entries[m_next_victim] = entry;
+    m_next_victim = (m_next_victim + 1) % max_entries;
+}
+
+Value PropertyCache::get(Object& object, const PropertyName& property_name)
+{
+    for (size_t i = 0; i < m_entry_count; ++i) {
+        auto& entry = m_entries[i];
+        auto* holder = match(entry, object);
+        if (!holder)
+            continue;
+        auto value = holder->get_direct(entry.offset);
+        if (is_cacheable_value(value))
+            return value;
+        break;
+    }
+
+    if (!is_cacheable_name(property_name) || is<ProxyObject>(object))
+        return object.get(property_name).value_or(js_undefined());
+
+    auto name = property_name.to_string_or_symbol();
+    Entry entry;
+    Object* holder = &object;
+    while (holder && entry.chain_length < max_chain_length && !is<ProxyObject>(*holder)) {
+        entry.shape_keys[entry.chain_length++] = holder->shape().cache_key();
+        auto metadata = holder->shape().lookup(name);
+        if (metadata.has_value()) {
+            auto value = holder->get_direct(metadata.value().offset);
+            if (!is_cacheable_value(value))
+                break;
+            entry.offset = metadata.value().offset;
+            add_entry(entry);
+            return value;
+        }
+        holder = holder->shape().prototype();
+    }
+
+    return object.get(property_name).value_or(js_undefined());
+}
+
+bool PropertyCache::put(Object& object, const PropertyName& property_name, Value value)
+{
+    VERIFY(!value.is_empty());
+
+    for (size_t i = 0; i < m_entry_count; ++i) {
+        auto& entry = m_entries[i];
+        if (!match(entry, object))
+            continue;
+        if (!is_cacheable_value(object.get_direct(entry.offset)))
+            break;
+        object.put_direct(entry.offset, value);
+        return true;
+    }
+
+    if (!is_cacheable_name(property_name) || is<ProxyObject>(object))
+        return object.put(property_name, value);
+
+    // Object::put() consults setters anywhere on the prototype chain before writing an own property,
+    // so an existing own property can only be written directly if no prototype has one by that name.
+    auto name = property_name.to_string_or_symbol();
+    auto metadata = object.shape().lookup(name);
+    bool cacheable = metadata.has_value() && metadata.value().attributes.is_writable() && is_cacheable_value(object.get_direct(metadata.value().offset));
+
+    Entry entry;
+    for (Object* chain_object = &object; cacheable && chain_object; chain_object = chain_object->shape().prototype()) {
+        if (entry.chain_length == max_chain_length || is<ProxyObject>(*chain_object)) {
+            cacheable = false;
+            break;
+        }
+        entry.shape_keys[entry.chain_length++] = chain_object->shape().cache_key();
+        if (chain_object != &object && chain_object->shape().lookup(name).has_value())
+            cacheable = false;
+    }
+
+    if (!cacheable)
+        return object.put(property_name, value);
+
+    entry.offset = metadata.value().offset;
+    add_entry(entry);
+    object.put_direct(entry.offset, value);
+    return true;
+}
+
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <AK/Types.h>
+#include <LibJS/Forward.h>
+#include <LibJS/Runtime/PropertyName.h>
+#include <LibJS/Runtime/Value.h>
+
+namespace JS {
+
+// An inline cache for a single named property access site (e.g. `foo.bar`), remembering where
+// the property lived for the last few object shapes seen there. An entry stays valid for as long
+// as the shapes of the receiver and the prototypes it looked through keep their cache keys, so
+// any shape transition or in-place shape mutation naturally misses and refills the cache.
+//
+// Only plain data properties are cached; getters, setters, native properties, proxies and
+// integer-like names always take the regular Object::get() / Object::put() path.
+class PropertyCache {
+public:
+    Value get(Object&, const PropertyName&);
+    bool put(Object&, const PropertyName&, Value);
+
+private:
+    static constexpr size_t max_entries = 4;
+    static constexpr size_t max_chain_length = 4;
+
+    struct Entry {
+        // Cache keys of the receiver's shape followed by the shapes of its prototypes. For gets, the
+        // chain ends at the object holding the property. For puts, it covers the whole prototype chain.
+        u64 shape_keys[max_chain_length] { 0 };
+        u8 chain_length { 0 };
+        u32 offset { 0 };
+    };
+
+    static Object* match(const Entry&, Object& receiver);
+    void add_entry(const Entry&);
+
+    Entry m_entries[max_entries];
+    u8 m_entry_count { 0 };
+    u8 m_next_victim { 0 };
+};
+
+}
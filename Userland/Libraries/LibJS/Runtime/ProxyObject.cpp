@@ -67,6 +67,9 @@ ProxyObject::ProxyObject(Object& target, Object& handler, Object& prototype)
     , m_target(target)
     , m_handler(handler)
 {
+    // Proxies must never share a shape with an ordinary object, or a PropertyCache filled from
+    // that object could bypass the traps.
+    ensure_shape_is_unique();
 }
 
 ProxyObject::~ProxyObject()
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <LibJS/AST.h>
+#include <LibJS/Runtime/ScopeLayout.h>
+
+namespace JS {
+
+void ScopeLayout::add(const FlyString& name, DeclarationKind declaration_kind)
+{
+    if (auto index = index_of(name); index.has_value()) {
+        m_bindings[index.value()].declaration_kind = declaration_kind;
+        return;
+    }
+    m_bindings.append({ name, declaration_kind });
+    if (m_bindings.size() > max_linear_search_size) {
+        if (m_indices.is_empty()) {
+            for (size_t i = 0; i < m_bindings.size(); ++i)
+                m_indices.set(m_bindings[i].name, i);
+        } else {
+            m_indices.set(name, m_bindings.size() - 1);
+        }
+    }
+}
+
+Optional<size_t> ScopeLayout::index_of(const FlyString& name) const
+{
+    if (m_bindings.size() > max_linear_search_size)
+        return m_indices.get(name);
+    for (size_t i = 0; i < m_bindings.size(); ++i) {
+        if (m_bindings[i].name == name)
+            return i;
+    }
+    return {};
+}
+
+}
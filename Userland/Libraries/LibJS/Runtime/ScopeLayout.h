@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <AK/FlyString.h>
+#include <AK/HashMap.h>
+#include <AK/Optional.h>
+#include <AK/RefCounted.h>
+#include <AK/Vector.h>
+#include <LibJS/Forward.h>
+
+namespace JS {
+
+// The ordered list of bindings a declarative environment is created with: the parameters and
+// variables of a function, the let/const declarations of a block, or the parameter of a catch
+// clause. Layouts are built by the parser and shared by every LexicalEnvironment created for
+// the same scope, which stores its values in a flat vector indexed the same way.
+class ScopeLayout : public RefCounted<ScopeLayout> {
+public:
+    struct Binding {
+        FlyString name;
+        DeclarationKind declaration_kind;
+    };
+
+    static NonnullRefPtr<ScopeLayout> create() { return adopt(*new ScopeLayout); }
+
+    // Adding an existing name keeps its index but takes the new declaration kind,
+    // just like redeclaring it in a HashMap-based environment would.
+    void add(const FlyString& name, DeclarationKind);
+
+    size_t size() const { return m_bindings.size(); }
+    bool is_empty() const { return m_bindings.is_empty(); }
+    const Binding& binding(size_t index) const { return m_bindings[index]; }
+    const Vector<Binding>& bindings() const { return m_bindings; }
+
+    Optional<size_t> index_of(const FlyString& name) const;
+
+private:
+    ScopeLayout() = default;
+
+    // Small scopes are searched linearly (FlyString comparison is a pointer compare),
+    // larger ones get an index.
+    static constexpr size_t max_linear_search_size = 8;
+
+    Vector<Binding> m_bindings;
+    HashMap<FlyString, size_t> m_indices;
+};
+
+// Where a parser-resolved identifier lives: the layout of every environment between the reference
+// and the declaring scope (innermost first), and the index of the binding in the last of them.
+// Before using the slot, the environment chain is checked against these layouts, so anything the
+// parser could not predict (with statements, dynamically added bindings, closures created in an
+// unexpected scope) simply falls back to looking the name up.
+struct BindingLocation {
+    Vector<const ScopeLayout*, 4> layouts;
+    u32 index { 0 };
+
+    bool is_resolved() const { return !layouts.is_empty(); }
+};
+
+}
@@ -44,6 +44,11 @@ public:
     virtual bool has_this_binding() const = 0;
     virtual Value get_this_binding(GlobalObject&) const = 0;
 
+    virtual bool is_lexical_environment() const { return false; }
+
+    template<typename T>
+    bool fast_is() const = delete;
+
     ScopeObject* parent() { return m_parent; }
     const ScopeObject* parent() const { return m_parent; }
 
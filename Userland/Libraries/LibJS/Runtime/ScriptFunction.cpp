@@ -47,6 +47,23 @@ static ScriptFunction* typed_this(VM& vm, GlobalObject& global_object)
     return static_cast<ScriptFunction*>(this_object);
 }
 
+static NonnullRefPtr<const ScopeLayout> environment_layout_for(const Statement& body, const Vector<FunctionNode::Parameter>& parameters)
+{
+    if (is<ScopeNode>(body)) {
+        if (auto* layout = static_cast<const ScopeNode&>(body).function_layout())
+            return *layout;
+    }
+    // Function nodes compute this at parse time; this is only reached for hand-built bodies.
+    auto layout = ScopeLayout::create();
+    for (auto& parameter : parameters)
+        layout->add(parameter.name, DeclarationKind::Var);
+    if (is<ScopeNode>(body)) {
+        for (auto& binding : static_cast<const ScopeNode&>(body).layout().bindings())
+            layout->add(binding.name, binding.declaration_kind);
+    }
+    return layout;
+}
+
 ScriptFunction* ScriptFunction::create(GlobalObject& global_object, const FlyString& name, const Statement& body, Vector<FunctionNode::Parameter> parameters, i32 m_function_length, ScopeObject* parent_scope, bool is_strict, bool is_arrow_function)
 {
     return global_object.heap().allocate<ScriptFunction>(global_object, global_object, name, body, move(parameters), m_function_length, parent_scope, *global_object.function_prototype(), is_strict, is_arrow_function);
@@ -57,6 +74,7 @@ ScriptFunction::ScriptFunction(GlobalObject& global_object, const FlyString& nam
     , m_name(name)
     , m_body(body)
     , m_parameters(move(parameters))
+    , m_environment_layout(environment_layout_for(body, m_parameters))
     , m_parent_scope(parent_scope)
     , m_function_length(m_function_length)
     , m_is_strict(is_strict)
@@ -89,20 +107,7 @@ void ScriptFunction::visit_edges(Visitor& visitor)
 
 LexicalEnvironment* ScriptFunction::create_environment()
 {
-    HashMap<FlyString, Variable> variables;
-    for (auto& parameter : m_parameters) {
-        variables.set(parameter.name, { js_undefined(), DeclarationKind::Var });
-    }
-
-    if (is<ScopeNode>(body())) {
-        for (auto& declaration : static_cast<const ScopeNode&>(body()).variables()) {
-            for (auto& declarator : declaration.declarations()) {
-                variables.set(declarator.id().string(), { js_undefined(), declaration.declaration_kind() });
-            }
-        }
-    }
-
-    auto* environment = heap().allocate<LexicalEnvironment>(global_object(), move(variables), m_parent_scope, LexicalEnvironment::EnvironmentRecordType::Function);
+    auto* environment = heap().allocate<LexicalEnvironment>(global_object(), *m_environment_layout, m_parent_scope, LexicalEnvironment::EnvironmentRecordType::Function);
     environment->set_home_object(home_object());
     environment->set_current_function(*this);
     if (m_is_arrow_function) {
@@ -30,6 +30,8 @@
 
 namespace JS {
 
+static u64 s_next_cache_key = 1;
+
 Shape* Shape::create_unique_clone() const
 {
     VERIFY(m_global_object);
@@ -43,23 +45,36 @@ Shape* Shape::create_unique_clone() const
     return new_shape;
 }
 
+Shape* Shape::get_or_prune_cached_forward_transition(const TransitionKey& key)
+{
+    auto it = m_forward_transitions.find(key);
+    if (it == m_forward_transitions.end())
+        return nullptr;
+    // Dead shapes are swept lazily, so the weak pointer may not have been cleared yet.
+    if (!it->value || it->value->is_awaiting_finalization()) {
+        m_forward_transitions.remove(it);
+        return nullptr;
+    }
+    return it->value.ptr();
+}
+
 Shape* Shape::create_put_transition(const StringOrSymbol& property_name, PropertyAttributes attributes)
 {
     TransitionKey key { property_name, attributes };
-    if (auto* existing_shape = m_forward_transitions.get(key).value_or(nullptr))
+    if (auto* existing_shape = get_or_prune_cached_forward_transition(key))
         return existing_shape;
     auto* new_shape = heap().allocate_without_global_object<Shape>(*this, property_name, attributes, TransitionType::Put);
-    m_forward_transitions.set(key, new_shape);
+    m_forward_transitions.set(key, new_shape->make_weak_ptr());
     return new_shape;
 }
 
 Shape* Shape::create_configure_transition(const StringOrSymbol& property_name, PropertyAttributes attributes)
 {
     TransitionKey key { property_name, attributes };
-    if (auto* existing_shape = m_forward_transitions.get(key).value_or(nullptr))
+    if (auto* existing_shape = get_or_prune_cached_forward_transition(key))
         return existing_shape;
     auto* new_shape = heap().allocate_without_global_object<Shape>(*this, property_name, attributes, TransitionType::Configure);
-    m_forward_transitions.set(key, new_shape);
+    m_forward_transitions.set(key, new_shape->make_weak_ptr());
     return new_shape;
 }
 
@@ -69,16 +84,19 @@ Shape* Shape::create_prototype_transition(Object* new_prototype)
 }
 
 Shape::Shape(ShapeWithoutGlobalObjectTag)
+    : m_cache_key(s_next_cache_key++)
 {
 }
 
 Shape::Shape(Object& global_object)
-    : m_global_object(&global_object)
+    : m_cache_key(s_next_cache_key++)
+    , m_global_object(&global_object)
 {
 }
 
 Shape::Shape(Shape& previous_shape, const StringOrSymbol& property_name, PropertyAttributes attributes, TransitionType transition_type)
-    : m_attributes(attributes)
+    : m_cache_key(s_next_cache_key++)
+    , m_attributes(attributes)
     , m_transition_type(transition_type)
     , m_global_object(previous_shape.m_global_object)
     , m_previous(&previous_shape)
@@ -89,7 +107,8 @@ Shape::Shape(Shape& previous_shape, const StringOrSymbol& property_name, Propert
 }
 
 Shape::Shape(Shape& previous_shape, Object* new_prototype)
-    : m_transition_type(TransitionType::Prototype)
+    : m_cache_key(s_next_cache_key++)
+    , m_transition_type(TransitionType::Prototype)
     , m_global_object(previous_shape.m_global_object)
     , m_previous(&previous_shape)
     , m_prototype(new_prototype)
@@ -108,8 +127,6 @@ void Shape::visit_edges(Cell::Visitor& visitor)
     visitor.visit(m_prototype);
     visitor.visit(m_previous);
     m_property_name.visit_edges(visitor);
-    for (auto& it : m_forward_transitions)
-        visitor.visit(it.value);
 
     if (m_property_table) {
         for (auto& it : *m_property_table)
@@ -192,6 +209,7 @@ void Shape::add_property_to_unique_shape(const StringOrSymbol& property_name, Pr
     VERIFY(!m_property_table->contains(property_name));
     m_property_table->set(property_name, { m_property_table->size(), attributes });
     ++m_property_count;
+    invalidate_cache_key();
 }
 
 void Shape::reconfigure_property_in_unique_shape(const StringOrSymbol& property_name, PropertyAttributes attributes)
@@ -202,6 +220,7 @@ void Shape::reconfigure_property_in_unique_shape(const StringOrSymbol& property_
     VERIFY(it != m_property_table->end());
     it->value.attributes = attributes;
     m_property_table->set(property_name, it->value);
+    invalidate_cache_key();
 }
 
 void Shape::remove_property_from_unique_shape(const StringOrSymbol& property_name, size_t offset)
@@ -215,6 +234,7 @@ void Shape::remove_property_from_unique_shape(const StringOrSymbol& property_nam
         if (it.value.offset > offset)
             --it.value.offset;
     }
+    invalidate_cache_key();
 }
 
 void Shape::add_property_without_transition(const StringOrSymbol& property_name, PropertyAttributes attributes)
@@ -222,6 +242,12 @@ void Shape::add_property_without_transition(const StringOrSymbol& property_name,
     ensure_property_table();
     if (m_property_table->set(property_name, { m_property_count, attributes }) == AK::HashSetResult::InsertedNewEntry)
         ++m_property_count;
+    invalidate_cache_key();
+}
+
+void Shape::invalidate_cache_key()
+{
+    m_cache_key = s_next_cache_key++;
 }
 
 }
@@ -28,6 +28,8 @@
 
 #include <AK/HashMap.h>
 #include <AK/OwnPtr.h>
+#include <AK/WeakPtr.h>
+#include <AK/Weakable.h>
 #include <LibJS/Forward.h>
 #include <LibJS/Runtime/Cell.h>
 #include <LibJS/Runtime/PropertyAttributes.h>
@@ -51,7 +53,9 @@ struct TransitionKey {
     }
 };
 
-class Shape final : public Cell {
+class Shape final
+    : public Cell
+    , public Weakable<Shape> {
 public:
     virtual ~Shape() override;
 
@@ -94,7 +98,15 @@ public:
 
     Vector<Property> property_table_ordered() const;
 
-    void set_prototype_without_transition(Object* new_prototype) { m_prototype = new_prototype; }
+    void set_prototype_without_transition(Object* new_prototype)
+    {
+        m_prototype = new_prototype;
+        invalidate_cache_key();
+    }
+
+    // Identifies this shape's current layout and prototype for PropertyCache. Keys are never reused,
+    // and in-place mutations (unique shapes, transition-less setup) hand out a fresh one.
+    u64 cache_key() const { return m_cache_key; }
 
     void remove_property_from_unique_shape(const StringOrSymbol&, size_t offset);
     void add_property_to_unique_shape(const StringOrSymbol&, PropertyAttributes attributes);
@@ -105,6 +117,11 @@ private:
     virtual void visit_edges(Visitor&) override;
 
     void ensure_property_table() const;
+    void invalidate_cache_key();
+
+    Shape* get_or_prune_cached_forward_transition(const TransitionKey&);
+
+    u64 m_cache_key { 0 };
 
     PropertyAttributes m_attributes { 0 };
     TransitionType m_transition_type : 6 { TransitionType::Invalid };
@@ -114,7 +131,9 @@ private:
 
     mutable OwnPtr<HashMap<StringOrSymbol, PropertyMetadata>> m_property_table;
 
-    HashMap<TransitionKey, Shape*> m_forward_transitions;
+    // Held weakly, so shapes that no object uses anymore can be collected. The transition is
+    // simply made again if it's needed later.
+    HashMap<TransitionKey, WeakPtr<Shape>> m_forward_transitions;
     Shape* m_previous { nullptr };
     StringOrSymbol m_property_name;
     Object* m_prototype { nullptr };
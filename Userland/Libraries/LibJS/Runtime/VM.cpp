@@ -30,6 +30,7 @@
 #include <LibJS/Runtime/Array.h>
 #include <LibJS/Runtime/Error.h>
 #include <LibJS/Runtime/GlobalObject.h>
+#include <LibJS/Runtime/LexicalEnvironment.h>
 #include <LibJS/Runtime/Reference.h>
 #include <LibJS/Runtime/ScriptFunction.h>
 #include <LibJS/Runtime/Symbol.h>
@@ -208,6 +209,30 @@ Reference VM::get_reference(const FlyString& name)
     return { Reference::GlobalVariable, name };
 }
 
+Variable* VM::find_binding(const BindingLocation& location)
+{
+    if (!location.is_resolved() || m_call_stack.is_empty())
+        return nullptr;
+    auto* scope = current_scope();
+    auto last_hop = location.layouts.size() - 1;
+    for (size_t hop = 0;; ++hop) {
+        if (!is<LexicalEnvironment>(scope))
+            return nullptr;
+        auto& environment = static_cast<LexicalEnvironment&>(*scope);
+        if (environment.layout() != location.layouts[hop])
+            return nullptr;
+        if (hop == last_hop) {
+            if (location.index >= environment.layout_size())
+                return nullptr;
+            return &environment.variable_at(location.index);
+        }
+        // A binding added at runtime could shadow the one the parser found further out.
+        if (environment.has_dynamic_bindings())
+            return nullptr;
+        scope = environment.parent();
+    }
+}
+
 Value VM::construct(Function& function, Function& new_target, Optional<MarkedValueList> arguments, GlobalObject& global_object)
 {
     CallFrame call_frame;
@@ -223,7 +248,7 @@ Value VM::construct(Function& function, Function& new_target, Optional<MarkedVal
     call_frame.function_name = function.name();
     call_frame.arguments = function.bound_arguments();
     if (arguments.has_value())
-        call_frame.arguments.append(arguments.value().values());
+        call_frame.arguments.append(arguments.value().data(), arguments.value().size());
     auto* environment = function.create_environment();
     call_frame.scope = environment;
     environment->set_new_target(&new_target);
@@ -338,7 +363,7 @@ Value VM::call_internal(Function& function, Value this_value, Optional<MarkedVal
     call_frame.this_value = function.bound_this().value_or(this_value);
     call_frame.arguments = function.bound_arguments();
     if (arguments.has_value())
-        call_frame.arguments.append(move(arguments.release_value().values()));
+        call_frame.arguments.append(arguments.value().data(), arguments.value().size());
     auto* environment = function.create_environment();
     call_frame.scope = environment;
 
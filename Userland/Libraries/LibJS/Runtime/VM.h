@@ -58,7 +58,7 @@ struct ScopeFrame {
 struct CallFrame {
     FlyString function_name;
     Value this_value;
-    Vector<Value> arguments;
+    Vector<Value, 8> arguments;
     Array* arguments_object { nullptr };
     ScopeObject* scope { nullptr };
     bool is_strict_mode { false };
@@ -200,6 +200,11 @@ public:
 
     Reference get_reference(const FlyString& name);
 
+    // Returns the binding a parser-resolved identifier refers to, or nullptr if the current
+    // scope chain doesn't match what the parser saw and the name has to be looked up instead.
+    // The pointer is only valid until the next binding is added to that environment.
+    Variable* find_binding(const BindingLocation&);
+
     template<typename T, typename... Args>
     void throw_exception(GlobalObject& global_object, Args&&... args)
     {
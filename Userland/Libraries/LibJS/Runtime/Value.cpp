@@ -214,7 +214,7 @@ bool Value::is_array() const
 Array& Value::as_array()
 {
     VERIFY(is_array());
-    return static_cast<Array&>(*m_value.as_object);
+    return static_cast<Array&>(as_object());
 }
 
 bool Value::is_function() const
@@ -246,21 +246,21 @@ bool Value::is_regexp(GlobalObject& global_object) const
 
 String Value::to_string_without_side_effects() const
 {
-    switch (m_type) {
+    switch (type()) {
     case Type::Undefined:
         return "undefined";
     case Type::Null:
         return "null";
     case Type::Boolean:
-        return m_value.as_bool ? "true" : "false";
+        return as_bool() ? "true" : "false";
     case Type::Number:
-        return double_to_string(m_value.as_double);
+        return double_to_string(as_double());
     case Type::String:
-        return m_value.as_string->string();
+        return as_string().string();
     case Type::Symbol:
-        return m_value.as_symbol->to_string();
+        return as_symbol().to_string();
     case Type::BigInt:
-        return m_value.as_bigint->to_string();
+        return as_bigint().to_string();
     case Type::Object:
         return String::formatted("[object {}]", as_object().class_name());
     case Type::Accessor:
@@ -284,22 +284,24 @@ PrimitiveString* Value::to_primitive_string(GlobalObject& global_object)
 
 String Value::to_string(GlobalObject& global_object, bool legacy_null_to_empty_string) const
 {
-    switch (m_type) {
+    switch (type()) {
     case Type::Undefined:
         return "undefined";
     case Type::Null:
         return !legacy_null_to_empty_string ? "null" : String::empty();
     case Type::Boolean:
-        return m_value.as_bool ? "true" : "false";
+        return as_bool() ? "true" : "false";
     case Type::Number:
-        return double_to_string(m_value.as_double);
+        if (is_int32())
+            return String::number(as_int32());
+        return double_to_string(as_double());
     case Type::String:
-        return m_value.as_string->string();
+        return as_string().string();
     case Type::Symbol:
         global_object.vm().throw_exception<TypeError>(global_object, ErrorType::Convert, "symbol", "string");
         return {};
     case Type::BigInt:
-        return m_value.as_bigint->big_integer().to_base10();
+        return as_bigint().big_integer().to_base10();
     case Type::Object: {
         auto primitive_value = to_primitive(PreferredType::String);
         if (global_object.vm().exception())
@@ -313,22 +315,22 @@ String Value::to_string(GlobalObject& global_object, bool legacy_null_to_empty_s
 
 bool Value::to_boolean() const
 {
-    switch (m_type) {
+    switch (type()) {
     case Type::Undefined:
     case Type::Null:
         return false;
     case Type::Boolean:
-        return m_value.as_bool;
+        return as_bool();
     case Type::Number:
         if (is_nan())
             return false;
-        return m_value.as_double != 0;
+        return as_double() != 0;
     case Type::String:
-        return !m_value.as_string->string().is_empty();
+        return !as_string().string().is_empty();
     case Type::Symbol:
         return true;
     case Type::BigInt:
-        return m_value.as_bigint->big_integer() != BIGINT_ZERO;
+        return as_bigint().big_integer() != BIGINT_ZERO;
     case Type::Object:
         return true;
     default:
@@ -349,21 +351,21 @@ Value Value::to_primitive(PreferredType preferred_type) const
 
 Object* Value::to_object(GlobalObject& global_object) const
 {
-    switch (m_type) {
+    switch (type()) {
     case Type::Undefined:
     case Type::Null:
         global_object.vm().throw_exception<TypeError>(global_object, ErrorType::ToObjectNullOrUndefined);
         return nullptr;
     case Type::Boolean:
-        return BooleanObject::create(global_object, m_value.as_bool);
+        return BooleanObject::create(global_object, as_bool());
     case Type::Number:
-        return NumberObject::create(global_object, m_value.as_double);
+        return NumberObject::create(global_object, as_double());
     case Type::String:
-        return StringObject::create(global_object, *m_value.as_string);
+        return StringObject::create(global_object, *unbox_cell<PrimitiveString>());
     case Type::Symbol:
-        return SymbolObject::create(global_object, *m_value.as_symbol);
+        return SymbolObject::create(global_object, *unbox_cell<Symbol>());
     case Type::BigInt:
-        return BigIntObject::create(global_object, *m_value.as_bigint);
+        return BigIntObject::create(global_object, *unbox_cell<BigInt>());
     case Type::Object:
         return &const_cast<Object&>(as_object());
     default:
@@ -384,15 +386,15 @@ Value Value::to_numeric(GlobalObject& global_object) const
 
 Value Value::to_number(GlobalObject& global_object) const
 {
-    switch (m_type) {
+    switch (type()) {
     case Type::Undefined:
         return js_nan();
     case Type::Null:
         return Value(0);
     case Type::Boolean:
-        return Value(m_value.as_bool ? 1 : 0);
+        return Value(as_bool() ? 1 : 0);
     case Type::Number:
-        return Value(m_value.as_double);
+        return *this;
     case Type::String: {
         auto string = as_string().string().trim_whitespace();
         if (string.is_empty())
@@ -465,6 +467,8 @@ BigInt* Value::to_bigint(GlobalObject& global_object) const
 // FIXME: These two conversions are wrong for JS, and seem likely to be footguns
 i32 Value::as_i32() const
 {
+    if (is_int32())
+        return as_int32();
     return static_cast<i32>(as_double());
 }
 
@@ -490,6 +494,8 @@ double Value::to_double(GlobalObject& global_object) const
 
 i32 Value::to_i32(GlobalObject& global_object) const
 {
+    if (is_int32())
+        return as_int32();
     auto number = to_number(global_object);
     if (global_object.vm().exception())
         return INVALID;
@@ -509,6 +515,8 @@ i32 Value::to_i32(GlobalObject& global_object) const
 u32 Value::to_u32(GlobalObject& global_object) const
 {
     // 7.1.7 ToUint32, https://tc39.es/ecma262/#sec-touint32
+    if (is_int32())
+        return static_cast<u32>(as_int32());
     auto number = to_number(global_object);
     if (global_object.vm().exception())
         return INVALID;
@@ -581,6 +589,8 @@ double Value::to_integer_or_infinity(GlobalObject& global_object) const
 
 Value greater_than(GlobalObject& global_object, Value lhs, Value rhs)
 {
+    if (lhs.is_int32() && rhs.is_int32())
+        return Value(lhs.as_int32() > rhs.as_int32());
     TriState relation = abstract_relation(global_object, false, lhs, rhs);
     if (relation == TriState::Unknown)
         return Value(false);
@@ -589,6 +599,8 @@ Value greater_than(GlobalObject& global_object, Value lhs, Value rhs)
 
 Value greater_than_equals(GlobalObject& global_object, Value lhs, Value rhs)
 {
+    if (lhs.is_int32() && rhs.is_int32())
+        return Value(lhs.as_int32() >= rhs.as_int32());
     TriState relation = abstract_relation(global_object, true, lhs, rhs);
     if (relation == TriState::Unknown || relation == TriState::True)
         return Value(false);
@@ -597,6 +609,8 @@ Value greater_than_equals(GlobalObject& global_object, Value lhs, Value rhs)
 
 Value less_than(GlobalObject& global_object, Value lhs, Value rhs)
 {
+    if (lhs.is_int32() && rhs.is_int32())
+        return Value(lhs.as_int32() < rhs.as_int32());
     TriState relation = abstract_relation(global_object, true, lhs, rhs);
     if (relation == TriState::Unknown)
         return Value(false);
@@ -605,6 +619,8 @@ Value less_than(GlobalObject& global_object, Value lhs, Value rhs)
 
 Value less_than_equals(GlobalObject& global_object, Value lhs, Value rhs)
 {
+    if (lhs.is_int32() && rhs.is_int32())
+        return Value(lhs.as_int32() <= rhs.as_int32());
     TriState relation = abstract_relation(global_object, false, lhs, rhs);
     if (relation == TriState::Unknown || relation == TriState::True)
         return Value(false);
@@ -789,6 +805,13 @@ Value unsigned_right_shift(GlobalObject& global_object, Value lhs, Value rhs)
 
 Value add(GlobalObject& global_object, Value lhs, Value rhs)
 {
+    if (lhs.is_int32() && rhs.is_int32()) {
+        i32 result;
+        if (!__builtin_add_overflow(lhs.as_int32(), rhs.as_int32(), &result))
+            return Value(result);
+        return Value(static_cast<double>(lhs.as_int32()) + rhs.as_int32());
+    }
+
     auto lhs_primitive = lhs.to_primitive();
     if (global_object.vm().exception())
         return {};
@@ -797,16 +820,13 @@ Value add(GlobalObject& global_object, Value lhs, Value rhs)
         return {};
 
     if (lhs_primitive.is_string() || rhs_primitive.is_string()) {
-        auto lhs_string = lhs_primitive.to_string(global_object.global_object());
+        auto* lhs_string = lhs_primitive.to_primitive_string(global_object.global_object());
         if (global_object.vm().exception())
             return {};
-        auto rhs_string = rhs_primitive.to_string(global_object.global_object());
+        auto* rhs_string = rhs_primitive.to_primitive_string(global_object.global_object());
         if (global_object.vm().exception())
             return {};
-        StringBuilder builder(lhs_string.length() + rhs_string.length());
-        builder.append(lhs_string);
-        builder.append(rhs_string);
-        return js_string(global_object.heap(), builder.to_string());
+        return js_rope_string(global_object.vm(), *lhs_string, *rhs_string);
     }
 
     auto lhs_numeric = lhs_primitive.to_numeric(global_object.global_object());
@@ -825,6 +845,13 @@ Value add(GlobalObject& global_object, Value lhs, Value rhs)
 
 Value sub(GlobalObject& global_object, Value lhs, Value rhs)
 {
+    if (lhs.is_int32() && rhs.is_int32()) {
+        i32 result;
+        if (!__builtin_sub_overflow(lhs.as_int32(), rhs.as_int32(), &result))
+            return Value(result);
+        return Value(static_cast<double>(lhs.as_int32()) - rhs.as_int32());
+    }
+
     auto lhs_numeric = lhs.to_numeric(global_object.global_object());
     if (global_object.vm().exception())
         return {};
@@ -841,6 +868,14 @@ Value sub(GlobalObject& global_object, Value lhs, Value rhs)
 
 Value mul(GlobalObject& global_object, Value lhs, Value rhs)
 {
+    if (lhs.is_int32() && rhs.is_int32()) {
+        // A zero product with a negative operand is -0, which only a double can represent.
+        i32 result;
+        if (!__builtin_mul_overflow(lhs.as_int32(), rhs.as_int32(), &result) && (result != 0 || (lhs.as_int32() | rhs.as_int32()) >= 0))
+            return Value(result);
+        return Value(static_cast<double>(lhs.as_int32()) * rhs.as_int32());
+    }
+
     auto lhs_numeric = lhs.to_numeric(global_object.global_object());
     if (global_object.vm().exception())
         return {};
@@ -1050,6 +1085,9 @@ bool same_value_non_numeric(Value lhs, Value rhs)
 
 bool strict_eq(Value lhs, Value rhs)
 {
+    if (lhs.is_int32() && rhs.is_int32())
+        return lhs.as_int32() == rhs.as_int32();
+
     if (lhs.type() != rhs.type())
         return false;
 
@@ -29,6 +29,7 @@
 #include <AK/Assertions.h>
 #include <AK/Format.h>
 #include <AK/Forward.h>
+#include <AK/NumericLimits.h>
 #include <AK/String.h>
 #include <AK/Types.h>
 #include <LibJS/Forward.h>
@@ -63,180 +64,237 @@ public:
         Number,
     };
 
-    bool is_empty() const { return m_type == Type::Empty; }
-    bool is_undefined() const { return m_type == Type::Undefined; }
-    bool is_null() const { return m_type == Type::Null; }
-    bool is_number() const { return m_type == Type::Number; }
-    bool is_string() const { return m_type == Type::String; }
-    bool is_object() const { return m_type == Type::Object; }
-    bool is_boolean() const { return m_type == Type::Boolean; }
-    bool is_symbol() const { return m_type == Type::Symbol; }
-    bool is_accessor() const { return m_type == Type::Accessor; };
-    bool is_bigint() const { return m_type == Type::BigInt; };
-    bool is_native_property() const { return m_type == Type::NativeProperty; }
+    bool is_empty() const { return m_bits == EMPTY_BITS; }
+    bool is_undefined() const { return m_bits == UNDEFINED_BITS; }
+    bool is_null() const { return m_bits == NULL_BITS; }
+    bool is_number() const { return is_double() || is_int32(); }
+    bool is_int32() const { return tag() == INT32_TAG; }
+    bool is_string() const { return tag() == STRING_TAG; }
+    bool is_object() const { return tag() == OBJECT_TAG; }
+    bool is_boolean() const { return (m_bits & ~1ull) == FALSE_BITS; }
+    bool is_symbol() const { return tag() == SYMBOL_TAG; }
+    bool is_accessor() const { return tag() == ACCESSOR_TAG; };
+    bool is_bigint() const { return tag() == BIGINT_TAG; };
+    bool is_native_property() const { return tag() == NATIVE_PROPERTY_TAG; }
     bool is_nullish() const { return is_null() || is_undefined(); }
-    bool is_cell() const { return is_string() || is_accessor() || is_object() || is_bigint() || is_symbol() || is_native_property(); }
+    bool is_cell() const { return tag() >= FIRST_CELL_TAG; }
     bool is_array() const;
     bool is_function() const;
     bool is_regexp(GlobalObject& global_object) const;
 
-    bool is_nan() const { return is_number() && __builtin_isnan(as_double()); }
-    bool is_infinity() const { return is_number() && __builtin_isinf(as_double()); }
-    bool is_positive_infinity() const { return is_number() && __builtin_isinf_sign(as_double()) > 0; }
-    bool is_negative_infinity() const { return is_number() && __builtin_isinf_sign(as_double()) < 0; }
+    bool is_nan() const { return m_bits == CANONICAL_NAN_BITS; }
+    bool is_infinity() const { return is_double() && __builtin_isinf(as_double()); }
+    bool is_positive_infinity() const { return is_double() && __builtin_isinf_sign(as_double()) > 0; }
+    bool is_negative_infinity() const { return is_double() && __builtin_isinf_sign(as_double()) < 0; }
     bool is_positive_zero() const { return is_number() && 1.0 / as_double() == INFINITY; }
-    bool is_negative_zero() const { return is_number() && 1.0 / as_double() == -INFINITY; }
-    bool is_integer() const { return is_finite_number() && (i32)as_double() == as_double(); }
+    bool is_negative_zero() const { return is_double() && 1.0 / as_double() == -INFINITY; }
+    bool is_integer() const { return is_int32() || (is_finite_number() && (i32)as_double() == as_double()); }
     bool is_finite_number() const
     {
-        if (!is_number())
+        if (is_int32())
+            return true;
+        if (!is_double())
             return false;
         auto number = as_double();
         return !__builtin_isnan(number) && !__builtin_isinf(number);
     }
 
     Value()
-        : m_type(Type::Empty)
+        : m_bits(EMPTY_BITS)
     {
     }
 
     explicit Value(bool value)
-        : m_type(Type::Boolean)
+        : m_bits(value ? TRUE_BITS : FALSE_BITS)
     {
-        m_value.as_bool = value;
     }
 
     explicit Value(double value)
-        : m_type(Type::Number)
     {
-        m_value.as_double = value;
+        // Integral numbers are stored as int32 whenever they fit, so integer arithmetic can stay unboxed.
+        // All NaNs share one encoding, which keeps every other NaN bit pattern free for tagged values.
+        if (value >= NumericLimits<i32>::min() && value <= NumericLimits<i32>::max() && static_cast<i32>(value) == value && !(value == 0 && __builtin_signbit(value)))
+            m_bits = box_int32(static_cast<i32>(value));
+        else if (__builtin_isnan(value))
+            m_bits = CANONICAL_NAN_BITS;
+        else
+            __builtin_memcpy(&m_bits, &value, sizeof(m_bits));
     }
 
     explicit Value(unsigned value)
-        : m_type(Type::Number)
+        : Value(static_cast<double>(value))
     {
-        m_value.as_double = static_cast<double>(value);
     }
 
     explicit Value(i32 value)
-        : m_type(Type::Number)
+        : m_bits(box_int32(value))
     {
-        m_value.as_double = value;
     }
 
     Value(const Object* object)
-        : m_type(object ? Type::Object : Type::Null)
+        : m_bits(object ? box_cell(OBJECT_TAG, object) : NULL_BITS)
     {
-        m_value.as_object = const_cast<Object*>(object);
     }
 
     Value(const PrimitiveString* string)
-        : m_type(Type::String)
+        : m_bits(box_cell(STRING_TAG, string))
     {
-        m_value.as_string = const_cast<PrimitiveString*>(string);
     }
 
     Value(const Symbol* symbol)
-        : m_type(Type::Symbol)
+        : m_bits(box_cell(SYMBOL_TAG, symbol))
     {
-        m_value.as_symbol = const_cast<Symbol*>(symbol);
     }
 
     Value(const Accessor* accessor)
-        : m_type(Type::Accessor)
+        : m_bits(box_cell(ACCESSOR_TAG, accessor))
     {
-        m_value.as_accessor = const_cast<Accessor*>(accessor);
     }
 
     Value(const BigInt* bigint)
-        : m_type(Type::BigInt)
+        : m_bits(box_cell(BIGINT_TAG, bigint))
     {
-        m_value.as_bigint = const_cast<BigInt*>(bigint);
     }
 
     Value(const NativeProperty* native_property)
-        : m_type(Type::NativeProperty)
+        : m_bits(box_cell(NATIVE_PROPERTY_TAG, native_property))
     {
-        m_value.as_native_property = const_cast<NativeProperty*>(native_property);
     }
 
     explicit Value(Type type)
-        : m_type(type)
     {
+        switch (type) {
+        case Type::Empty:
+            m_bits = EMPTY_BITS;
+            break;
+        case Type::Undefined:
+            m_bits = UNDEFINED_BITS;
+            break;
+        case Type::Null:
+            m_bits = NULL_BITS;
+            break;
+        default:
+            VERIFY_NOT_REACHED();
+        }
     }
 
-    Type type() const { return m_type; }
+    Type type() const
+    {
+        switch (tag()) {
+        case MISC_TAG:
+            if (is_boolean())
+                return Type::Boolean;
+            if (is_undefined())
+                return Type::Undefined;
+            if (is_null())
+                return Type::Null;
+            return Type::Empty;
+        case INT32_TAG:
+            return Type::Number;
+        case OBJECT_TAG:
+            return Type::Object;
+        case STRING_TAG:
+            return Type::String;
+        case SYMBOL_TAG:
+            return Type::Symbol;
+        case ACCESSOR_TAG:
+            return Type::Accessor;
+        case BIGINT_TAG:
+            return Type::BigInt;
+        case NATIVE_PROPERTY_TAG:
+            return Type::NativeProperty;
+        default:
+            return Type::Number;
+        }
+    }
 
     double as_double() const
     {
-        VERIFY(type() == Type::Number);
-        return m_value.as_double;
+        VERIFY(is_number());
+        if (is_int32())
+            return static_cast<i32>(m_bits);
+        double value;
+        __builtin_memcpy(&value, &m_bits, sizeof(value));
+        return value;
+    }
+
+    // Only valid for numbers stored as int32; use as_double() or to_i32() for any other number.
+    i32 as_int32() const
+    {
+        VERIFY(is_int32());
+        return static_cast<i32>(m_bits);
     }
 
     bool as_bool() const
     {
-        VERIFY(type() == Type::Boolean);
-        return m_value.as_bool;
+        VERIFY(is_boolean());
+        return m_bits == TRUE_BITS;
     }
 
     Object& as_object()
     {
-        VERIFY(type() == Type::Object);
-        return *m_value.as_object;
+        VERIFY(is_object());
+        return *unbox_cell<Object>();
     }
 
     const Object& as_object() const
     {
-        VERIFY(type() == Type::Object);
-        return *m_value.as_object;
+        VERIFY(is_object());
+        return *unbox_cell<Object>();
     }
 
     PrimitiveString& as_string()
     {
         VERIFY(is_string());
-        return *m_value.as_string;
+        return *unbox_cell<PrimitiveString>();
     }
 
     const PrimitiveString& as_string() const
     {
         VERIFY(is_string());
-        return *m_value.as_string;
+        return *unbox_cell<PrimitiveString>();
     }
 
     Symbol& as_symbol()
     {
         VERIFY(is_symbol());
-        return *m_value.as_symbol;
+        return *unbox_cell<Symbol>();
     }
 
     const Symbol& as_symbol() const
     {
         VERIFY(is_symbol());
-        return *m_value.as_symbol;
+        return *unbox_cell<Symbol>();
     }
 
     Cell* as_cell()
     {
         VERIFY(is_cell());
-        return m_value.as_cell;
+        return unbox_cell<Cell>();
     }
 
     Accessor& as_accessor()
     {
         VERIFY(is_accessor());
-        return *m_value.as_accessor;
+        return *unbox_cell<Accessor>();
     }
 
     BigInt& as_bigint()
     {
         VERIFY(is_bigint());
-        return *m_value.as_bigint;
+        return *unbox_cell<BigInt>();
+    }
+
+    const BigInt& as_bigint() const
+    {
+        VERIFY(is_bigint());
+        return *unbox_cell<BigInt>();
     }
 
     NativeProperty& as_native_property()
     {
         VERIFY(is_native_property());
-        return *m_value.as_native_property;
+        return *unbox_cell<NativeProperty>();
     }
 
     Array& as_array();
@@ -270,22 +328,59 @@ public:
         return *this;
     }
 
+    // Returns the cell a NaN-boxed Value's bits refer to, if any. Used by the conservative stack scan.
+    static FlatPtr cell_pointer_from_bits(u64 bits)
+    {
+        if ((bits >> TAG_SHIFT) < FIRST_CELL_TAG)
+            return 0;
+        return static_cast<FlatPtr>(bits & PAYLOAD_MASK);
+    }
+
 private:
-    Type m_type { Type::Empty };
-
-    union {
-        bool as_bool;
-        double as_double;
-        PrimitiveString* as_string;
-        Symbol* as_symbol;
-        Object* as_object;
-        Cell* as_cell;
-        Accessor* as_accessor;
-        BigInt* as_bigint;
-        NativeProperty* as_native_property;
-    } m_value;
+    // Values are NaN-boxed into 64 bits. Every double is stored as-is, except that all NaNs are
+    // canonicalized to a single positive quiet NaN. That leaves the negative quiet NaN space, where the
+    // top 16 bits are 0xFFF8 or above, free to hold a tag plus a 48-bit payload: an int32, a cell
+    // pointer, or one of the "misc" constants (empty, undefined, null, false, true).
+    static constexpr u64 TAG_SHIFT = 48;
+    static constexpr u64 PAYLOAD_MASK = 0x0000FFFFFFFFFFFFull;
+    static constexpr u64 CANONICAL_NAN_BITS = 0x7FF8000000000000ull;
+
+    static constexpr u64 MISC_TAG = 0xFFF8;
+    static constexpr u64 INT32_TAG = 0xFFF9;
+    static constexpr u64 OBJECT_TAG = 0xFFFA;
+    static constexpr u64 STRING_TAG = 0xFFFB;
+    static constexpr u64 SYMBOL_TAG = 0xFFFC;
+    static constexpr u64 ACCESSOR_TAG = 0xFFFD;
+    static constexpr u64 BIGINT_TAG = 0xFFFE;
+    static constexpr u64 NATIVE_PROPERTY_TAG = 0xFFFF;
+    static constexpr u64 FIRST_CELL_TAG = OBJECT_TAG;
+
+    static constexpr u64 EMPTY_BITS = MISC_TAG << TAG_SHIFT;
+    static constexpr u64 UNDEFINED_BITS = (MISC_TAG << TAG_SHIFT) | 1;
+    static constexpr u64 NULL_BITS = (MISC_TAG << TAG_SHIFT) | 2;
+    static constexpr u64 FALSE_BITS = (MISC_TAG << TAG_SHIFT) | 4;
+    static constexpr u64 TRUE_BITS = (MISC_TAG << TAG_SHIFT) | 5;
+
+    u64 tag() const { return m_bits >> TAG_SHIFT; }
+    bool is_double() const { return tag() < MISC_TAG; }
+
+    static u64 box_int32(i32 value) { return (INT32_TAG << TAG_SHIFT) | static_cast<u32>(value); }
+
+    static u64 box_cell(u64 tag, const void* cell)
+    {
+        auto pointer = reinterpret_cast<FlatPtr>(cell);
+        VERIFY(!(static_cast<u64>(pointer) & ~PAYLOAD_MASK));
+        return (tag << TAG_SHIFT) | static_cast<u64>(pointer);
+    }
+
+    template<typename T>
+    T* unbox_cell() const { return reinterpret_cast<T*>(static_cast<FlatPtr>(m_bits & PAYLOAD_MASK)); }
+
+    u64 m_bits { EMPTY_BITS };
 };
 
+static_assert(sizeof(Value) == sizeof(u64));
+
 inline Value js_undefined()
 {
     return Value(Value::Type::Undefined);
@@ -0,0 +1,46 @@
+// The benchmark() workloads run once as tests, and repeatedly under `test-js --benchmark`.
+
+benchmark("int32 loop arithmetic", () => {
+    let sum = 0;
+    for (let i = 0; i < 100000; ++i) {
+        sum = (sum + i * 3 - (i >> 1)) | 0;
+    }
+    expect(sum).toBe(-385001888);
+    expect(Number.isInteger(sum)).toBeTrue();
+});
+
+test("int32 overflow falls back to doubles", () => {
+    let value = 1;
+    for (let i = 0; i < 40; ++i) value *= 2;
+    expect(value).toBe(1099511627776);
+    expect(2147483647 + 1).toBe(2147483648);
+    expect(-2147483648 - 1).toBe(-2147483649);
+    expect(65536 * 65536).toBe(4294967296);
+});
+
+test("negative zero survives integer multiplication", () => {
+    expect(Object.is(0 * -1, -0)).toBeTrue();
+    expect(Object.is(-5 * 0, -0)).toBeTrue();
+    expect(Object.is(0 * 5, 0)).toBeTrue();
+    expect(Object.is(-0 + 0, 0)).toBeTrue();
+    expect(Object.is(-0 - 0, -0)).toBeTrue();
+});
+
+benchmark("mixed int32 and double arithmetic", () => {
+    let total = 0;
+    for (let i = 0; i < 50000; ++i) {
+        total += i / 2;
+    }
+    expect(total).toBe(624987500);
+    expect(0.1 + 0.2).not.toBe(0.3);
+    expect(3 === 3.0).toBeTrue();
+    expect(NaN === NaN).toBeFalse();
+    expect(Object.is(NaN, 0 / 0)).toBeTrue();
+});
+
+benchmark("fibonacci", () => {
+    function fib(n) {
+        return n < 2 ? n : fib(n - 1) + fib(n - 2);
+    }
+    expect(fib(20)).toBe(6765);
+});
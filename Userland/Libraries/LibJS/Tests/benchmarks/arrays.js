@@ -0,0 +1,46 @@
+// Array workloads: growing and shrinking arrays, the higher-order builtins, and sorting.
+
+benchmark("push and pop", () => {
+    const stack = [];
+    let sum = 0;
+    for (let round = 0; round < 10; ++round) {
+        for (let i = 0; i < 5000; ++i) stack.push(i);
+        while (stack.length > 0) sum += stack.pop();
+    }
+    expect(sum).toBe(124975000);
+});
+
+benchmark("map, filter and reduce", () => {
+    const values = [];
+    for (let i = 0; i < 20000; ++i) values.push(i);
+    const result = values
+        .map(value => value * 3)
+        .filter(value => value % 2 === 0)
+        .reduce((sum, value) => sum + value, 0);
+    expect(result).toBe(299970000);
+});
+
+benchmark("numeric sort", () => {
+    const values = [];
+    let seed = 42;
+    for (let i = 0; i < 5000; ++i) {
+        seed = (seed * 1103515245 + 12345) & 0x7fffffff;
+        values.push(seed % 100000);
+    }
+    values.sort((a, b) => a - b);
+    let sorted = true;
+    for (let i = 1; i < values.length; ++i) {
+        if (values[i - 1] > values[i]) sorted = false;
+    }
+    expect(sorted).toBeTrue();
+});
+
+benchmark("arrays of objects", () => {
+    const people = [];
+    for (let i = 0; i < 5000; ++i) people.push({ id: i, age: i % 90, name: "person" + i });
+    const adults = people.filter(person => person.age >= 18);
+    const oldest = adults.reduce((a, b) => (b.age > a.age ? b : a));
+    expect(adults).toHaveLength(3992);
+    expect(oldest.id).toBe(89);
+    expect(people.findIndex(person => person.name === "person4321")).toBe(4321);
+});
@@ -0,0 +1,445 @@
+// A condensed version of the classic DeltaBlue benchmark: an incremental solver for one-way
+// constraints between variables, which keeps re-planning as constraints come and go. It mostly
+// exercises polymorphic method calls, class hierarchies and short-lived arrays.
+
+const REQUIRED = 0;
+const STRONG_PREFERRED = 1;
+const PREFERRED = 2;
+const STRONG_DEFAULT = 3;
+const NORMAL = 4;
+const WEAK_DEFAULT = 5;
+const WEAKEST = 6;
+
+const stronger = (a, b) => a < b;
+const weaker = (a, b) => a > b;
+const weakestOf = (a, b) => (weaker(a, b) ? a : b);
+const nextWeaker = strength => strength + 1;
+
+const DIRECTION_NONE = 0;
+const DIRECTION_FORWARD = 1;
+const DIRECTION_BACKWARD = 2;
+
+let planner = null;
+
+class Variable {
+    constructor(name, value = 0) {
+        this.name = name;
+        this.value = value;
+        this.constraints = [];
+        this.determinedBy = null;
+        this.mark = 0;
+        this.walkStrength = WEAKEST;
+        this.stay = true;
+    }
+
+    addConstraint(constraint) {
+        this.constraints.push(constraint);
+    }
+
+    removeConstraint(constraint) {
+        this.constraints = this.constraints.filter(other => other !== constraint);
+        if (this.determinedBy === constraint) this.determinedBy = null;
+    }
+}
+
+// Subclasses call addConstraint() once they are fully constructed.
+class Constraint {
+    constructor(strength) {
+        this.strength = strength;
+    }
+
+    addConstraint() {
+        this.addToGraph();
+        planner.incrementalAdd(this);
+    }
+
+    satisfy(mark) {
+        this.chooseMethod(mark);
+        if (!this.isSatisfied()) {
+            if (this.strength === REQUIRED) throw new Error("Could not satisfy a required constraint");
+            return null;
+        }
+        this.markInputs(mark);
+        const output = this.output();
+        const overridden = output.determinedBy;
+        if (overridden !== null) overridden.markUnsatisfied();
+        output.determinedBy = this;
+        if (!planner.addPropagate(this, mark)) throw new Error("Cycle encountered");
+        output.mark = mark;
+        return overridden;
+    }
+
+    destroyConstraint() {
+        if (this.isSatisfied()) planner.incrementalRemove(this);
+        else this.removeFromGraph();
+    }
+
+    isInput() {
+        return false;
+    }
+}
+
+class UnaryConstraint extends Constraint {
+    constructor(variable, strength) {
+        super(strength);
+        this.myOutput = variable;
+        this.satisfied = false;
+    }
+
+    addToGraph() {
+        this.myOutput.addConstraint(this);
+        this.satisfied = false;
+    }
+
+    chooseMethod(mark) {
+        this.satisfied =
+            this.myOutput.mark !== mark && stronger(this.strength, this.myOutput.walkStrength);
+    }
+
+    isSatisfied() {
+        return this.satisfied;
+    }
+
+    markInputs(mark) {}
+
+    output() {
+        return this.myOutput;
+    }
+
+    recalculate() {
+        this.myOutput.walkStrength = this.strength;
+        this.myOutput.stay = !this.isInput();
+        if (this.myOutput.stay) this.execute();
+    }
+
+    markUnsatisfied() {
+        this.satisfied = false;
+    }
+
+    inputsKnown() {
+        return true;
+    }
+
+    removeFromGraph() {
+        this.myOutput.removeConstraint(this);
+        this.satisfied = false;
+    }
+}
+
+class StayConstraint extends UnaryConstraint {
+    constructor(variable, strength) {
+        super(variable, strength);
+        this.addConstraint();
+    }
+
+    execute() {}
+}
+
+class EditConstraint extends UnaryConstraint {
+    constructor(variable, strength) {
+        super(variable, strength);
+        this.addConstraint();
+    }
+
+    isInput() {
+        return true;
+    }
+
+    execute() {}
+}
+
+class BinaryConstraint extends Constraint {
+    constructor(v1, v2, strength) {
+        super(strength);
+        this.v1 = v1;
+        this.v2 = v2;
+        this.direction = DIRECTION_NONE;
+    }
+
+    chooseMethod(mark) {
+        if (this.v1.mark === mark) {
+            this.direction =
+                this.v2.mark !== mark && stronger(this.strength, this.v2.walkStrength)
+                    ? DIRECTION_FORWARD
+                    : DIRECTION_NONE;
+        }
+        if (this.v2.mark === mark) {
+            this.direction =
+                this.v1.mark !== mark && stronger(this.strength, this.v1.walkStrength)
+                    ? DIRECTION_BACKWARD
+                    : DIRECTION_NONE;
+        }
+        if (weaker(this.v1.walkStrength, this.v2.walkStrength)) {
+            this.direction = stronger(this.strength, this.v1.walkStrength)
+                ? DIRECTION_BACKWARD
+                : DIRECTION_NONE;
+        } else {
+            this.direction = stronger(this.strength, this.v2.walkStrength)
+                ? DIRECTION_FORWARD
+                : DIRECTION_BACKWARD;
+        }
+    }
+
+    addToGraph() {
+        this.v1.addConstraint(this);
+        this.v2.addConstraint(this);
+        this.direction = DIRECTION_NONE;
+    }
+
+    isSatisfied() {
+        return this.direction !== DIRECTION_NONE;
+    }
+
+    markInputs(mark) {
+        this.input().mark = mark;
+    }
+
+    input() {
+        return this.direction === DIRECTION_FORWARD ? this.v1 : this.v2;
+    }
+
+    output() {
+        return this.direction === DIRECTION_FORWARD ? this.v2 : this.v1;
+    }
+
+    recalculate() {
+        const input = this.input();
+        const output = this.output();
+        output.walkStrength = weakestOf(this.strength, input.walkStrength);
+        output.stay = input.stay;
+        if (output.stay) this.execute();
+    }
+
+    markUnsatisfied() {
+        this.direction = DIRECTION_NONE;
+    }
+
+    inputsKnown(mark) {
+        const input = this.input();
+        return input.mark === mark || input.stay || input.determinedBy === null;
+    }
+
+    removeFromGraph() {
+        this.v1.removeConstraint(this);
+        this.v2.removeConstraint(this);
+        this.direction = DIRECTION_NONE;
+    }
+}
+
+class EqualityConstraint extends BinaryConstraint {
+    constructor(v1, v2, strength) {
+        super(v1, v2, strength);
+        this.addConstraint();
+    }
+
+    execute() {
+        this.output().value = this.input().value;
+    }
+}
+
+// Keeps destination = source * scale + offset.
+class ScaleConstraint extends BinaryConstraint {
+    constructor(source, scale, offset, destination, strength) {
+        super(source, destination, strength);
+        this.scale = scale;
+        this.offset = offset;
+        this.addConstraint();
+    }
+
+    addToGraph() {
+        super.addToGraph();
+        this.scale.addConstraint(this);
+        this.offset.addConstraint(this);
+    }
+
+    removeFromGraph() {
+        super.removeFromGraph();
+        this.scale.removeConstraint(this);
+        this.offset.removeConstraint(this);
+    }
+
+    markInputs(mark) {
+        super.markInputs(mark);
+        this.scale.mark = mark;
+        this.offset.mark = mark;
+    }
+
+    execute() {
+        if (this.direction === DIRECTION_FORWARD)
+            this.v2.value = this.v1.value * this.scale.value + this.offset.value;
+        else this.v1.value = (this.v2.value - this.offset.value) / this.scale.value;
+    }
+
+    recalculate() {
+        const input = this.input();
+        const output = this.output();
+        output.walkStrength = weakestOf(this.strength, input.walkStrength);
+        output.stay = input.stay && this.scale.stay && this.offset.stay;
+        if (output.stay) this.execute();
+    }
+}
+
+class Planner {
+    constructor() {
+        this.currentMark = 0;
+    }
+
+    newMark() {
+        return ++this.currentMark;
+    }
+
+    incrementalAdd(constraint) {
+        const mark = this.newMark();
+        let overridden = constraint.satisfy(mark);
+        while (overridden !== null) overridden = overridden.satisfy(mark);
+    }
+
+    incrementalRemove(constraint) {
+        const output = constraint.output();
+        constraint.markUnsatisfied();
+        constraint.removeFromGraph();
+        const unsatisfied = this.removePropagateFrom(output);
+        for (let strength = REQUIRED; strength !== WEAKEST; strength = nextWeaker(strength)) {
+            for (const other of unsatisfied) {
+                if (other.strength === strength) this.incrementalAdd(other);
+            }
+        }
+    }
+
+    makePlan(sources) {
+        const mark = this.newMark();
+        const plan = [];
+        const todo = sources;
+        for (let i = 0; i < todo.length; ++i) {
+            const constraint = todo[i];
+            if (constraint.output().mark !== mark && constraint.inputsKnown(mark)) {
+                plan.push(constraint);
+                constraint.output().mark = mark;
+                this.addConstraintsConsumingTo(constraint.output(), todo);
+            }
+        }
+        return plan;
+    }
+
+    extractPlanFromConstraints(constraints) {
+        return this.makePlan(constraints.filter(c => c.isInput() && c.isSatisfied()));
+    }
+
+    addPropagate(constraint, mark) {
+        const todo = [constraint];
+        for (let i = 0; i < todo.length; ++i) {
+            const other = todo[i];
+            if (other.output().mark === mark) {
+                this.incrementalRemove(constraint);
+                return false;
+            }
+            other.recalculate();
+            this.addConstraintsConsumingTo(other.output(), todo);
+        }
+        return true;
+    }
+
+    removePropagateFrom(output) {
+        output.determinedBy = null;
+        output.walkStrength = WEAKEST;
+        output.stay = true;
+        const unsatisfied = [];
+        const todo = [output];
+        for (let i = 0; i < todo.length; ++i) {
+            const variable = todo[i];
+            for (const constraint of variable.constraints) {
+                if (!constraint.isSatisfied()) unsatisfied.push(constraint);
+            }
+            const determining = variable.determinedBy;
+            for (const next of variable.constraints) {
+                if (next !== determining && next.isSatisfied()) {
+                    next.recalculate();
+                    todo.push(next.output());
+                }
+            }
+        }
+        return unsatisfied;
+    }
+
+    addConstraintsConsumingTo(variable, constraints) {
+        const determining = variable.determinedBy;
+        for (const constraint of variable.constraints) {
+            if (constraint !== determining && constraint.isSatisfied()) constraints.push(constraint);
+        }
+    }
+}
+
+function executePlan(plan) {
+    for (const constraint of plan) constraint.execute();
+}
+
+// Edits the first variable of a chain of equality constraints, and checks the change reaches the end.
+function chainTest(length) {
+    planner = new Planner();
+    let previous = null;
+    let first = null;
+    let last = null;
+    for (let i = 0; i <= length; ++i) {
+        const variable = new Variable("v" + i);
+        if (previous !== null) new EqualityConstraint(previous, variable, REQUIRED);
+        if (i === 0) first = variable;
+        if (i === length) last = variable;
+        previous = variable;
+    }
+
+    new StayConstraint(last, STRONG_DEFAULT);
+    const edit = new EditConstraint(first, PREFERRED);
+    const plan = planner.extractPlanFromConstraints([edit]);
+    let mismatches = 0;
+    for (let i = 0; i < 100; ++i) {
+        first.value = i;
+        executePlan(plan);
+        if (last.value !== i) ++mismatches;
+    }
+    return mismatches;
+}
+
+function change(variable, value) {
+    const edit = new EditConstraint(variable, PREFERRED);
+    const plan = planner.extractPlanFromConstraints([edit]);
+    for (let i = 0; i < 10; ++i) {
+        variable.value = value;
+        executePlan(plan);
+    }
+    edit.destroyConstraint();
+}
+
+// Ties pairs of variables together with scale constraints and edits both ends of the pairs.
+function projectionTest(count) {
+    planner = new Planner();
+    const scale = new Variable("scale", 10);
+    const offset = new Variable("offset", 1000);
+    let source = null;
+    let destination = null;
+    const destinations = [];
+    for (let i = 0; i < count; ++i) {
+        source = new Variable("src" + i, i);
+        destination = new Variable("dst" + i, i);
+        destinations.push(destination);
+        new StayConstraint(source, NORMAL);
+        new ScaleConstraint(source, scale, offset, destination, REQUIRED);
+    }
+
+    // The last pair was edited directly, so it's left out of the checks that follow.
+    const checkedDestinations = () => destinations.slice(0, count - 1);
+    const results = [];
+    change(source, 17);
+    results.push(destination.value);
+    change(destination, 1050);
+    results.push(source.value);
+    change(scale, 5);
+    results.push(checkedDestinations().every((variable, i) => variable.value === i * 5 + 1000));
+    change(offset, 2000);
+    results.push(checkedDestinations().every((variable, i) => variable.value === i * 5 + 2000));
+    return results;
+}
+
+benchmark("deltablue", () => {
+    expect(chainTest(100)).toBe(0);
+    expect(projectionTest(100)).toEqual([1170, 5, true, true]);
+});
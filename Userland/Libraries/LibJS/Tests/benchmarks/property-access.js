@@ -0,0 +1,37 @@
+// The benchmark() workloads run once as tests, and repeatedly under `test-js --benchmark`.
+
+benchmark("repeated named property access", () => {
+    const point = { x: 0, y: 0 };
+    for (let i = 0; i < 50000; ++i) {
+        point.x += 1;
+        point.y = point.x - point.y;
+    }
+    expect(point.x).toBe(50000);
+    expect(point.y).toBe(25000);
+});
+
+benchmark("objects with the same shape", () => {
+    const points = [];
+    for (let i = 0; i < 10000; ++i) points.push({ x: i, y: -i });
+    let sum = 0;
+    for (let i = 0; i < points.length; ++i) sum += points[i].x + points[i].y;
+    expect(sum).toBe(0);
+});
+
+benchmark("indexed element reads and writes", () => {
+    const values = new Array(10000).fill(1);
+    for (let pass = 0; pass < 5; ++pass) {
+        for (let i = 1; i < values.length; ++i) values[i] = values[i - 1] + 1;
+    }
+    expect(values[9999]).toBe(10000);
+});
+
+benchmark("computed property keys", () => {
+    const table = {};
+    for (let i = 0; i < 20000; ++i) {
+        const key = "k" + (i % 64);
+        table[key] = (table[key] || 0) + 1;
+    }
+    expect(Object.keys(table)).toHaveLength(64);
+    expect(table.k0).toBe(313);
+});
@@ -0,0 +1,40 @@
+// Regular expression workloads: matching, and finding every match in a larger text.
+
+const logLines = [];
+for (let i = 0; i < 2000; ++i) {
+    const level = ["INFO", "WARN", "ERROR"][i % 3];
+    logLines.push(`2021-03-${String((i % 28) + 1).padStart(2, "0")} ${level} request ${i} took ${i % 97}ms`);
+}
+
+benchmark("regex test on many strings", () => {
+    const pattern = /^\d{4}-\d{2}-\d{2} (WARN|ERROR) request \d+ took [1-9]\d*ms$/;
+    let matches = 0;
+    for (const line of logLines) {
+        if (pattern.test(line)) ++matches;
+    }
+    expect(matches).toBe(1319);
+});
+
+benchmark("regex exec with captures", () => {
+    const pattern = /request (\d+) took (\d+)ms/;
+    let total = 0;
+    for (const line of logLines) {
+        const match = pattern.exec(line);
+        total += parseInt(match[2]);
+    }
+    expect(total).toBe(94890);
+});
+
+benchmark("global regex over a large text", () => {
+    const text = logLines.join("\n");
+    const pattern = /ERROR request (\d+)/g;
+    let count = 0;
+    let sum = 0;
+    let match;
+    while ((match = pattern.exec(text)) !== null) {
+        ++count;
+        sum += parseInt(match[1]);
+    }
+    expect(count).toBe(666);
+    expect(sum).toBe(665667);
+});
@@ -0,0 +1,278 @@
+// A condensed version of the classic Richards benchmark: the scheduler of a tiny operating system,
+// whose idle, worker, handler and device tasks pass packets to each other. It mostly exercises
+// method calls, property access and small object allocation.
+
+const ID_IDLE = 0;
+const ID_WORKER = 1;
+const ID_HANDLER_A = 2;
+const ID_HANDLER_B = 3;
+const ID_DEVICE_A = 4;
+const ID_DEVICE_B = 5;
+const TASK_COUNT = 6;
+
+const KIND_DEVICE = 0;
+const KIND_WORK = 1;
+
+const DATA_SIZE = 4;
+
+const STATE_RUNNING = 0;
+const STATE_RUNNABLE = 1;
+const STATE_SUSPENDED = 2;
+const STATE_HELD = 4;
+const STATE_SUSPENDED_RUNNABLE = STATE_SUSPENDED | STATE_RUNNABLE;
+const STATE_NOT_HELD = ~STATE_HELD;
+
+class Packet {
+    constructor(link, id, kind) {
+        this.link = link;
+        this.id = id;
+        this.kind = kind;
+        this.a1 = 0;
+        this.a2 = new Array(DATA_SIZE).fill(0);
+    }
+
+    addTo(queue) {
+        this.link = null;
+        if (queue === null) return this;
+        let next = queue;
+        while (next.link !== null) next = next.link;
+        next.link = this;
+        return queue;
+    }
+}
+
+class TaskControlBlock {
+    constructor(link, id, priority, queue, task) {
+        this.link = link;
+        this.id = id;
+        this.priority = priority;
+        this.queue = queue;
+        this.task = task;
+        this.state = queue === null ? STATE_SUSPENDED : STATE_SUSPENDED_RUNNABLE;
+    }
+
+    setRunning() {
+        this.state = STATE_RUNNING;
+    }
+
+    markAsNotHeld() {
+        this.state &= STATE_NOT_HELD;
+    }
+
+    markAsHeld() {
+        this.state |= STATE_HELD;
+    }
+
+    isHeldOrSuspended() {
+        return (this.state & STATE_HELD) !== 0 || this.state === STATE_SUSPENDED;
+    }
+
+    markAsSuspended() {
+        this.state |= STATE_SUSPENDED;
+    }
+
+    markAsRunnable() {
+        this.state |= STATE_RUNNABLE;
+    }
+
+    run() {
+        let packet = null;
+        if (this.state === STATE_SUSPENDED_RUNNABLE) {
+            packet = this.queue;
+            this.queue = packet.link;
+            this.state = this.queue === null ? STATE_RUNNING : STATE_RUNNABLE;
+        }
+        return this.task.run(packet);
+    }
+
+    checkPriorityAdd(task, packet) {
+        if (this.queue === null) {
+            this.queue = packet;
+            this.markAsRunnable();
+            if (this.priority > task.priority) return this;
+        } else {
+            this.queue = packet.addTo(this.queue);
+        }
+        return task;
+    }
+}
+
+class Scheduler {
+    constructor() {
+        this.queueCount = 0;
+        this.holdCount = 0;
+        this.blocks = new Array(TASK_COUNT).fill(null);
+        this.list = null;
+        this.currentTcb = null;
+        this.currentId = null;
+    }
+
+    addTask(id, priority, queue, task) {
+        this.currentTcb = new TaskControlBlock(this.list, id, priority, queue, task);
+        this.list = this.currentTcb;
+        this.blocks[id] = this.currentTcb;
+    }
+
+    addRunningTask(id, priority, queue, task) {
+        this.addTask(id, priority, queue, task);
+        this.currentTcb.setRunning();
+    }
+
+    schedule() {
+        this.currentTcb = this.list;
+        while (this.currentTcb !== null) {
+            if (this.currentTcb.isHeldOrSuspended()) {
+                this.currentTcb = this.currentTcb.link;
+            } else {
+                this.currentId = this.currentTcb.id;
+                this.currentTcb = this.currentTcb.run();
+            }
+        }
+    }
+
+    release(id) {
+        const tcb = this.blocks[id];
+        if (tcb === null) return tcb;
+        tcb.markAsNotHeld();
+        return tcb.priority > this.currentTcb.priority ? tcb : this.currentTcb;
+    }
+
+    holdCurrent() {
+        ++this.holdCount;
+        this.currentTcb.markAsHeld();
+        return this.currentTcb.link;
+    }
+
+    suspendCurrent() {
+        this.currentTcb.markAsSuspended();
+        return this.currentTcb;
+    }
+
+    queue(packet) {
+        const tcb = this.blocks[packet.id];
+        if (tcb === null) return tcb;
+        ++this.queueCount;
+        packet.link = null;
+        packet.id = this.currentId;
+        return tcb.checkPriorityAdd(this.currentTcb, packet);
+    }
+}
+
+class IdleTask {
+    constructor(scheduler, seed, count) {
+        this.scheduler = scheduler;
+        this.seed = seed;
+        this.count = count;
+    }
+
+    run(packet) {
+        if (--this.count === 0) return this.scheduler.holdCurrent();
+        if ((this.seed & 1) === 0) {
+            this.seed >>= 1;
+            return this.scheduler.release(ID_DEVICE_A);
+        }
+        this.seed = (this.seed >> 1) ^ 0xd008;
+        return this.scheduler.release(ID_DEVICE_B);
+    }
+}
+
+class DeviceTask {
+    constructor(scheduler) {
+        this.scheduler = scheduler;
+        this.pending = null;
+    }
+
+    run(packet) {
+        if (packet === null) {
+            if (this.pending === null) return this.scheduler.suspendCurrent();
+            const pending = this.pending;
+            this.pending = null;
+            return this.scheduler.queue(pending);
+        }
+        this.pending = packet;
+        return this.scheduler.holdCurrent();
+    }
+}
+
+class WorkerTask {
+    constructor(scheduler, destination, count) {
+        this.scheduler = scheduler;
+        this.destination = destination;
+        this.count = count;
+    }
+
+    run(packet) {
+        if (packet === null) return this.scheduler.suspendCurrent();
+        this.destination = this.destination === ID_HANDLER_A ? ID_HANDLER_B : ID_HANDLER_A;
+        packet.id = this.destination;
+        packet.a1 = 0;
+        for (let i = 0; i < DATA_SIZE; ++i) {
+            if (++this.count > 26) this.count = 1;
+            packet.a2[i] = this.count;
+        }
+        return this.scheduler.queue(packet);
+    }
+}
+
+class HandlerTask {
+    constructor(scheduler) {
+        this.scheduler = scheduler;
+        this.work = null;
+        this.devices = null;
+    }
+
+    run(packet) {
+        if (packet !== null) {
+            if (packet.kind === KIND_WORK) this.work = packet.addTo(this.work);
+            else this.devices = packet.addTo(this.devices);
+        }
+        if (this.work !== null) {
+            const count = this.work.a1;
+            if (count < DATA_SIZE) {
+                if (this.devices !== null) {
+                    const device = this.devices;
+                    this.devices = this.devices.link;
+                    device.a1 = this.work.a2[count];
+                    this.work.a1 = count + 1;
+                    return this.scheduler.queue(device);
+                }
+            } else {
+                const work = this.work;
+                this.work = this.work.link;
+                return this.scheduler.queue(work);
+            }
+        }
+        return this.scheduler.suspendCurrent();
+    }
+}
+
+function runRichards(count) {
+    const scheduler = new Scheduler();
+    scheduler.addRunningTask(ID_IDLE, 0, null, new IdleTask(scheduler, 1, count));
+
+    let queue = new Packet(null, ID_WORKER, KIND_WORK);
+    queue = new Packet(queue, ID_WORKER, KIND_WORK);
+    scheduler.addTask(ID_WORKER, 1000, queue, new WorkerTask(scheduler, ID_HANDLER_A, 0));
+
+    queue = new Packet(null, ID_DEVICE_A, KIND_DEVICE);
+    queue = new Packet(queue, ID_DEVICE_A, KIND_DEVICE);
+    queue = new Packet(queue, ID_DEVICE_A, KIND_DEVICE);
+    scheduler.addTask(ID_HANDLER_A, 2000, queue, new HandlerTask(scheduler));
+
+    queue = new Packet(null, ID_DEVICE_B, KIND_DEVICE);
+    queue = new Packet(queue, ID_DEVICE_B, KIND_DEVICE);
+    queue = new Packet(queue, ID_DEVICE_B, KIND_DEVICE);
+    scheduler.addTask(ID_HANDLER_B, 3000, queue, new HandlerTask(scheduler));
+
+    scheduler.addTask(ID_DEVICE_A, 4000, null, new DeviceTask(scheduler));
+    scheduler.addTask(ID_DEVICE_B, 5000, null, new DeviceTask(scheduler));
+
+    scheduler.schedule();
+    return scheduler;
+}
+
+benchmark("richards", () => {
+    const scheduler = runRichards(1000);
+    expect(scheduler.queueCount).toBe(2322);
+    expect(scheduler.holdCount).toBe(928);
+});
@@ -0,0 +1,46 @@
+// String workloads: building strings up piece by piece, and taking them apart again.
+
+benchmark("string concatenation", () => {
+    let text = "";
+    for (let i = 0; i < 20000; ++i) text += String.fromCharCode(97 + (i % 26));
+    expect(text).toHaveLength(20000);
+    expect(text.charCodeAt(19999)).toBe(97 + (19999 % 26));
+});
+
+benchmark("template literals and joins", () => {
+    const lines = [];
+    for (let i = 0; i < 5000; ++i) lines.push(`${i}: ${i * 7} ${i % 3 === 0 ? "fizz" : "buzz"}`);
+    const text = lines.join("\n");
+    expect(text.split("\n")).toHaveLength(5000);
+    expect(text.indexOf("4999: 34993 buzz")).toBe(text.length - 16);
+});
+
+benchmark("split, slice and case conversion", () => {
+    const words = "the quick brown fox jumps over the lazy dog ".repeat(500).trim().split(" ");
+    let capitalized = 0;
+    let letters = 0;
+    for (const word of words) {
+        const upper = word.slice(0, 1).toUpperCase() + word.slice(1).toLowerCase();
+        if (upper.startsWith("T")) ++capitalized;
+        letters += upper.length;
+    }
+    expect(words).toHaveLength(4500);
+    expect(capitalized).toBe(1000);
+    expect(letters).toBe(17500);
+});
+
+benchmark("character scanning", () => {
+    const text = "lorem ipsum dolor sit amet, consectetur adipiscing elit. ".repeat(400);
+    let vowels = 0;
+    for (let i = 0; i < text.length; ++i) {
+        switch (text.charAt(i)) {
+        case "a":
+        case "e":
+        case "i":
+        case "o":
+        case "u":
+            ++vowels;
+        }
+    }
+    expect(vowels).toBe(7600);
+});
@@ -0,0 +1,120 @@
+describe("large dense arrays", () => {
+    test("stay consistent when grown past the old storage limit", () => {
+        const a = [];
+        for (let i = 0; i < 1000; ++i) a.push(i);
+        expect(a).toHaveLength(1000);
+        expect(a[999]).toBe(999);
+        expect(a.indexOf(500)).toBe(500);
+        expect(a.includes(999)).toBeTrue();
+        expect(a.map(x => x * 2)[999]).toBe(1998);
+    });
+
+    test("switch to sparse storage when a large hole is created", () => {
+        const a = [];
+        for (let i = 0; i < 300; ++i) a.push(i);
+        a[10000] = "far";
+        expect(a).toHaveLength(10001);
+        expect(a[299]).toBe(299);
+        expect(a[5000]).toBeUndefined();
+        expect(a[10000]).toBe("far");
+        expect(a.indexOf("far")).toBe(10000);
+        expect(Object.keys(a)).toHaveLength(301);
+    });
+
+    test("keep holes after deleting elements", () => {
+        const a = [1, 2, 3, 4];
+        delete a[1];
+        expect(1 in a).toBeFalse();
+        expect(a.indexOf(undefined)).toBe(-1);
+        expect(a.includes(undefined)).toBeTrue();
+        const seen = [];
+        a.forEach(x => seen.push(x));
+        expect(seen).toEqual([1, 3, 4]);
+    });
+});
+
+describe("fast paths", () => {
+    test("indexOf and includes on numbers", () => {
+        const a = [1, 2, NaN, -0, 3];
+        expect(a.indexOf(NaN)).toBe(-1);
+        expect(a.includes(NaN)).toBeTrue();
+        expect(a.indexOf(0)).toBe(3);
+        expect(a.indexOf("1")).toBe(-1);
+        expect(a.indexOf(3, -1)).toBe(4);
+    });
+
+    test("forEach observes changes made by the callback", () => {
+        const a = [1, 2, 3, 4];
+        const seen = [];
+        a.forEach((x, i) => {
+            seen.push(x);
+            if (i === 0) a[2] = "changed";
+            if (i === 1) a.pop();
+        });
+        expect(seen).toEqual([1, 2, "changed"]);
+    });
+
+    test("sort with a comparator that modifies the array", () => {
+        const a = [3, 1, 2];
+        a.sort((x, y) => {
+            a.length = 0;
+            return x - y;
+        });
+        expect(a).toEqual([1, 2, 3]);
+    });
+
+    test("sort of a large array is stable", () => {
+        const a = [];
+        for (let i = 0; i < 500; ++i) a.push({ key: i % 10, index: i });
+        a.sort((x, y) => x.key - y.key);
+        for (let i = 1; i < a.length; ++i) {
+            expect(a[i - 1].key <= a[i].key).toBeTrue();
+            if (a[i - 1].key === a[i].key) expect(a[i - 1].index < a[i].index).toBeTrue();
+        }
+    });
+
+    test("for-of over an array sees appended elements", () => {
+        const a = [1, 2];
+        const seen = [];
+        for (const x of a) {
+            seen.push(x);
+            if (a.length < 4) a.push(x * 10);
+        }
+        expect(seen).toEqual([1, 2, 10, 20]);
+    });
+
+    test("for-of honors an overridden iterator", () => {
+        const a = [1, 2, 3];
+        a[Symbol.iterator] = () => {
+            let done = false;
+            return {
+                next() {
+                    const result = { value: "custom", done };
+                    done = true;
+                    return result;
+                },
+            };
+        };
+        const seen = [];
+        for (const x of a) seen.push(x);
+        expect(seen).toEqual(["custom"]);
+    });
+
+    test("for-of honors an overridden ArrayIterator next", () => {
+        const iteratorPrototype = Object.getPrototypeOf([][Symbol.iterator]());
+        const originalNext = iteratorPrototype.next;
+        let calls = 0;
+        iteratorPrototype.next = function () {
+            ++calls;
+            return originalNext.call(this);
+        };
+        try {
+            const seen = [];
+            for (const x of [1, 2]) seen.push(x);
+            expect(seen).toEqual([1, 2]);
+            expect(calls).toBe(3);
+        } finally {
+            iteratorPrototype.next = originalNext;
+        }
+    });
+});
@@ -0,0 +1,87 @@
+test("syntax errors in function bodies are reported even if they are never called", () => {
+    expect("function f() { return +; }").not.toEval();
+    expect("function f() { function g() { ) } }").not.toEval();
+    expect("const f = () => { const g = () => { var; }; };").not.toEval();
+    expect("function f() { 'use strict'; with ({}) {} }").not.toEval();
+    expect("function f() { function g() { return; } }").toEval();
+});
+
+test("nested functions see the right variables", () => {
+    function outer(a) {
+        let b = 2;
+        function inner(c) {
+            const d = () => {
+                function innermost() {
+                    return a + b + c;
+                }
+                return innermost();
+            };
+            return d();
+        }
+        return inner(3);
+    }
+    expect(outer(1)).toBe(6);
+    expect(outer(10)).toBe(15);
+});
+
+test("parameters with default values", () => {
+    const a = "outer";
+    function f(a, b = a) {
+        return b;
+    }
+    expect(f("inner")).toBe("inner");
+});
+
+test("strict mode of nested functions", () => {
+    function outer() {
+        function strict() {
+            "use strict";
+            return isStrictMode();
+        }
+        function sloppy() {
+            return isStrictMode();
+        }
+        return [strict(), sloppy()];
+    }
+    for (let i = 0; i < 2; ++i) {
+        const result = outer();
+        expect(result[0]).toBeTrue();
+        expect(result[1]).toBeFalse();
+    }
+});
+
+test("code following a function body", () => {
+    function f() {
+        const g = function () {
+            return 8;
+        } / 2;
+        const h = `${(() => {
+            return "template";
+        })()} ${/a}/.test("a}")}`;
+        return [g, h];
+    }
+    const result = f();
+    expect(result[0]).toBeNaN();
+    expect(result[1]).toBe("template true");
+});
+
+test("break and continue inside functions in loops", () => {
+    let count = 0;
+    for (let i = 0; i < 3; ++i) {
+        const f = () => {
+            for (;;) {
+                ++count;
+                break;
+            }
+        };
+        f();
+        continue;
+    }
+    expect(count).toBe(3);
+});
+
+test("functions created by the Function constructor", () => {
+    const f = new Function("a", "b", "function add() { return a + b; } return add();");
+    expect(f(1, 2)).toBe(3);
+    expect(f(3, 4)).toBe(7);
+});
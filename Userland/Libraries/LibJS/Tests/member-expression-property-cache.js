@@ -0,0 +1,87 @@
+function readX(o) {
+    return o.x;
+}
+
+test("cached lookups see updated values", () => {
+    const o = { x: 1 };
+    expect(readX(o)).toBe(1);
+    o.x = 2;
+    expect(readX(o)).toBe(2);
+});
+
+test("polymorphic call site", () => {
+    const objects = [{ x: 1 }, { a: 0, x: 2 }, { b: 0, c: 0, x: 3 }, { d: 0, e: 0, f: 0, x: 4 }, { x: 5, y: 6 }];
+    for (let i = 0; i < 3; ++i) {
+        objects.forEach((o, index) => {
+            expect(readX(o)).toBe(index + 1);
+        });
+    }
+});
+
+test("lookups through the prototype chain", () => {
+    const proto = { x: "proto" };
+    const o = Object.setPrototypeOf({}, proto);
+    expect(readX(o)).toBe("proto");
+    proto.x = "changed";
+    expect(readX(o)).toBe("changed");
+    o.x = "own";
+    expect(readX(o)).toBe("own");
+    delete o.x;
+    expect(readX(o)).toBe("changed");
+    Object.setPrototypeOf(o, { x: "other proto" });
+    expect(readX(o)).toBe("other proto");
+});
+
+test("properties turning into accessors", () => {
+    const o = { x: 1 };
+    expect(readX(o)).toBe(1);
+    Object.defineProperty(o, "x", {
+        get() {
+            return "getter";
+        },
+        configurable: true,
+    });
+    expect(readX(o)).toBe("getter");
+});
+
+test("writes through a prototype setter", () => {
+    let setterValue;
+    const proto = {};
+    const o = Object.setPrototypeOf({}, proto);
+    function writeX(o, value) {
+        o.x = value;
+    }
+    o.x = 0;
+    writeX(o, 1);
+    expect(o.x).toBe(1);
+    Object.defineProperty(proto, "x", {
+        set(value) {
+            setterValue = value;
+        },
+        configurable: true,
+    });
+    writeX(o, 2);
+    expect(setterValue).toBe(2);
+});
+
+test("writes to non-writable properties", () => {
+    const o = { x: 1 };
+    function writeX(o, value) {
+        o.x = value;
+    }
+    writeX(o, 2);
+    Object.defineProperty(o, "x", { writable: false });
+    writeX(o, 3);
+    expect(o.x).toBe(2);
+});
+
+test("proxies are not bypassed", () => {
+    const target = { x: 1 };
+    expect(readX(target)).toBe(1);
+    const proxy = new Proxy(target, {
+        get() {
+            return "trapped";
+        },
+    });
+    expect(readX(proxy)).toBe("trapped");
+});
@@ -115,7 +115,8 @@ test("evaluation order", () => {
         "||=",
         "??=",
     ]) {
-        var a = [];
+        // Functions created with the Function constructor only see the global scope.
+        globalThis.a = [];
         function b() {
             b.hasBeenCalled = true;
             throw Error();
@@ -0,0 +1,46 @@
+test("repeated concatenation", () => {
+    let s = "";
+    for (let i = 0; i < 200000; ++i) s += "ab";
+    expect(s).toHaveLength(400000);
+    expect(s.substring(0, 6)).toBe("ababab");
+    expect(s.charAt(399999)).toBe("b");
+});
+
+test("repeated prepending", () => {
+    let s = "";
+    for (let i = 0; i < 100000; ++i) s = "x" + s;
+    expect(s).toHaveLength(100000);
+    expect(s.indexOf("y")).toBe(-1);
+});
+
+test("concatenated strings keep their contents in order", () => {
+    const parts = [];
+    let s = "";
+    for (let i = 0; i < 1000; ++i) {
+        const part = "<li>" + i + "</li>";
+        parts.push(part);
+        s += part;
+    }
+    expect(s).toBe(parts.join(""));
+    expect(s + s).toBe(parts.join("") + parts.join(""));
+});
+
+test("concatenation with non-string operands", () => {
+    let s = "long enough string to not be copied eagerly, ";
+    s += 1;
+    s += null;
+    s += undefined;
+    s += true;
+    s += [1, 2];
+    s += { toString: () => "!" };
+    expect(s).toBe("long enough string to not be copied eagerly, 1nullundefinedtrue1,2!");
+});
+
+test("concatenated strings as property keys", () => {
+    let key = "";
+    for (let i = 0; i < 50; ++i) key += "key";
+    const o = {};
+    o[key] = 1;
+    expect(o["key".repeat(50)]).toBe(1);
+    expect(key === "key".repeat(50)).toBeTrue();
+});
@@ -1,6 +1,7 @@
 let describe;
 let test;
 let expect;
+let benchmark;
 
 // Stores the results of each test and suite. Has a terrible
 // name to avoid name collision.
@@ -19,6 +20,10 @@ console.log = (...args) => {
     __UserOutput__.push(args.join(" "));
 };
 
+// Workloads registered with benchmark(), which `test-js --benchmark` times by calling them
+// repeatedly. Has a terrible name to avoid name collision.
+let __Benchmarks__ = [];
+
 class ExpectationError extends Error {
     constructor(message, fileName, lineNumber) {
         super(message, fileName, lineNumber);
@@ -446,6 +451,13 @@ class ExpectationError extends Error {
         }
     };
 
+    // Outside of benchmark mode, a benchmark is an ordinary test, so its expectations keep
+    // being checked. In benchmark mode, that run also tells whether it is worth timing.
+    benchmark = (message, callback) => {
+        __Benchmarks__.push({ name: message, callback });
+        test(message, callback);
+    };
+
     test.skip = (message, callback) => {
         if (typeof callback !== "function")
             throw new Error("test.skip has invalid second argument (must be a function)");
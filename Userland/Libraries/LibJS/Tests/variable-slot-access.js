@@ -0,0 +1,97 @@
+test("closures see the variables of enclosing functions", () => {
+    function outer(a) {
+        let b = a * 2;
+        function middle() {
+            const c = 1;
+            return () => a + b + c;
+        }
+        b++;
+        return middle();
+    }
+    expect(outer(1)()).toBe(5);
+    expect(outer(10)()).toBe(32);
+});
+
+test("assignments and updates write through to the declaring scope", () => {
+    let counter = 0;
+    const increment = () => {
+        counter++;
+        counter += 2;
+        ++counter;
+    };
+    increment();
+    increment();
+    expect(counter).toBe(8);
+});
+
+test("shadowing in blocks and loops", () => {
+    let x = "outer";
+    for (let i = 0; i < 2; ++i) {
+        let x = i;
+        expect(x).toBe(i);
+    }
+    {
+        let x = "block";
+        expect(x).toBe("block");
+        x = "changed";
+        expect(x).toBe("changed");
+    }
+    expect(x).toBe("outer");
+});
+
+test("catch parameters", () => {
+    let e = "outer";
+    try {
+        throw 42;
+    } catch (e) {
+        expect(e).toBe(42);
+        e = 43;
+        expect(e).toBe(43);
+    }
+    expect(e).toBe("outer");
+});
+
+test("with statements still take precedence over outer variables", () => {
+    let value = "variable";
+    const object = { value: "property" };
+    with (object) {
+        expect(value).toBe("property");
+        value = "assigned";
+    }
+    expect(object.value).toBe("assigned");
+    expect(value).toBe("variable");
+});
+
+test("class declarations shadow outer variables", () => {
+    let A = 1;
+    function f() {
+        class A {}
+        return typeof A;
+    }
+    expect(f()).toBe("function");
+    expect(A).toBe(1);
+});
+
+test("const variables cannot be updated", () => {
+    const value = 1;
+    expect(() => {
+        value++;
+    }).toThrowWithMessage(TypeError, "Invalid assignment to const variable");
+    expect(() => {
+        value += 1;
+    }).toThrowWithMessage(TypeError, "Invalid assignment to const variable");
+    expect(value).toBe(1);
+});
+
+test("parameters and variables with the same name", () => {
+    function f(a, a2) {
+        var a;
+        return a;
+    }
+    expect(f(5)).toBe(5);
+
+    function g(a, a) {
+        return a;
+    }
+    expect(g(1, 2)).toBe(2);
+});
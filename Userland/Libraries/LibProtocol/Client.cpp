@@ -46,6 +46,11 @@ bool Client::is_supported_protocol(const String& protocol)
     return send_sync<Messages::ProtocolServer::IsSupportedProtocol>(protocol)->supported();
 }
 
+void Client::prefetch_host_name(const String& host)
+{
+    post_message(Messages::ProtocolServer::PrefetchHostName(host));
+}
+
 template<typename RequestHashMapTraits>
 RefPtr<Download> Client::start_download(const String& method, const String& url, const HashMap<String, String, RequestHashMapTraits>& request_headers, ReadonlyBytes request_body)
 {
@@ -47,6 +47,9 @@ public:
     template<typename RequestHashMapTraits = Traits<String>>
     RefPtr<Download> start_download(const String& method, const String& url, const HashMap<String, String, RequestHashMapTraits>& request_headers = {}, ReadonlyBytes request_body = {});
 
+    // Asks the server to resolve the host name ahead of time, without waiting for it.
+    void prefetch_host_name(const String&);
+
     bool stop_download(Badge<Download>, Download&);
     bool set_certificate(Badge<Download>, Download&, String, String);
 
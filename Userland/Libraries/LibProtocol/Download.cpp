@@ -26,6 +26,9 @@
 
 #include <LibProtocol/Client.h>
 #include <LibProtocol/Download.h>
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
 
 namespace Protocol {
 
@@ -35,6 +38,12 @@ Download::Download(Client& client, i32 download_id)
 {
 }
 
+Download::~Download()
+{
+    if (m_fd != -1)
+        close(m_fd);
+}
+
 bool Download::stop()
 {
     return m_client->stop_download({}, *this);
@@ -46,34 +55,86 @@ void Download::stream_into(OutputStream& stream)
 
     auto notifier = Core::Notifier::construct(fd(), Core::Notifier::Read);
 
-    m_internal_stream_data = make<InternalStreamData>(fd());
+    m_internal_stream_data = make<InternalStreamData>();
     m_internal_stream_data->read_notifier = notifier;
+    m_internal_stream_data->on_finish = move(on_finish);
 
-    auto user_on_finish = move(on_finish);
     on_finish = [this](auto success, auto total_size) {
         m_internal_stream_data->success = success;
         m_internal_stream_data->total_size = total_size;
         m_internal_stream_data->download_done = true;
+        finish_streaming_if_done();
     };
 
-    notifier->on_ready_to_read = [this, &stream, user_on_finish = move(user_on_finish)] {
-        constexpr size_t buffer_size = PAGE_SIZE;
-        static char buf[buffer_size];
-        auto nread = m_internal_stream_data->read_stream.read({ buf, buffer_size });
-        if (!stream.write_or_error({ buf, nread })) {
-            // FIXME: What do we do here?
-            TODO();
+    notifier->on_ready_to_read = [this, &stream] {
+        // The server writes to the pipe as the data arrives, so take whatever is there right away
+        // rather than waiting for a buffer's worth of it.
+        constexpr size_t buffer_size = 64 * KiB;
+        static u8 buf[buffer_size];
+        auto nread = read(fd(), buf, buffer_size);
+        if (nread < 0) {
+            if (errno == EINTR || errno == EAGAIN)
+                return;
+            perror("Download: read");
+            nread = 0;
+        }
+        if (nread == 0) {
+            m_internal_stream_data->reached_end_of_data = true;
+            m_internal_stream_data->read_notifier->set_enabled(false);
+            finish_streaming_if_done();
+            return;
         }
 
-        if (m_internal_stream_data->read_stream.eof() && m_internal_stream_data->download_done) {
-            m_internal_stream_data->read_notifier->close();
-            user_on_finish(m_internal_stream_data->success, m_internal_stream_data->total_size);
-        } else {
-            m_internal_stream_data->read_stream.handle_any_error();
+        ReadonlyBytes chunk { buf, static_cast<size_t>(nread) };
+        if (!stream.write_or_error(chunk)) {
+            // FIXME: What do we do here?
+            TODO();
         }
+        if (m_internal_buffered_data && m_internal_buffered_data->has_received_headers && on_buffered_data_received)
+            on_buffered_data_received(m_internal_buffered_data->response_headers, m_internal_buffered_data->response_code, chunk);
     };
 }
 
+class CallbackOutputStream final : public OutputStream {
+public:
+    explicit CallbackOutputStream(Function<void(ReadonlyBytes)> callback)
+        : m_callback(move(callback))
+    {
+    }
+
+    virtual size_t write(ReadonlyBytes bytes) override
+    {
+        m_callback(bytes);
+        return bytes.size();
+    }
+
+    virtual bool write_or_error(ReadonlyBytes bytes) override
+    {
+        write(bytes);
+        return true;
+    }
+
+private:
+    Function<void(ReadonlyBytes)> m_callback;
+};
+
+void Download::stream_into(Function<void(ReadonlyBytes)> callback)
+{
+    auto stream = make<CallbackOutputStream>(move(callback));
+    stream_into(*stream);
+    m_internal_stream_data->owned_output_stream = move(stream);
+}
+
+void Download::finish_streaming_if_done()
+{
+    // The pipe may run dry before or after the server tells us the download is over.
+    if (!m_internal_stream_data->download_done || !m_internal_stream_data->reached_end_of_data)
+        return;
+    m_internal_stream_data->read_notifier->close();
+    if (auto user_on_finish = move(m_internal_stream_data->on_finish))
+        user_on_finish(m_internal_stream_data->success, m_internal_stream_data->total_size);
+}
+
 void Download::set_should_buffer_all_input(bool value)
 {
     if (m_should_buffer_all_input == value)
@@ -88,12 +149,19 @@ void Download::set_should_buffer_all_input(bool value)
     VERIFY(!m_internal_stream_data);
     VERIFY(!m_internal_buffered_data);
     VERIFY(on_buffered_download_finish); // Not having this set makes no sense.
-    m_internal_buffered_data = make<InternalBufferedData>(fd());
+    m_internal_buffered_data = make<InternalBufferedData>();
     m_should_buffer_all_input = true;
 
     on_headers_received = [this](auto& headers, auto response_code) {
         m_internal_buffered_data->response_headers = headers;
         m_internal_buffered_data->response_code = move(response_code);
+        m_internal_buffered_data->has_received_headers = true;
+
+        // Hand over whatever arrived before the headers did.
+        if (on_buffered_data_received && m_internal_buffered_data->payload_stream.size()) {
+            auto payload_so_far = m_internal_buffered_data->payload_stream.copy_into_contiguous_buffer();
+            on_buffered_data_received(m_internal_buffered_data->response_headers, m_internal_buffered_data->response_code, payload_so_far);
+        }
     };
 
     on_finish = [this](auto success, u32 total_size) {
@@ -53,11 +53,16 @@ public:
         return adopt(*new Download(client, download_id));
     }
 
+    ~Download();
+
     int id() const { return m_download_id; }
     int fd() const { return m_fd; }
     bool stop();
 
     void stream_into(OutputStream&);
+    /// Hands each chunk of the payload to the callback as soon as it arrives, without keeping any of it around.
+    /// Note: Like `stream_into', will override `on_finish' and call the original once all the data is in.
+    void stream_into(Function<void(ReadonlyBytes)>);
 
     bool should_buffer_all_input() const { return m_should_buffer_all_input; }
     /// Note: Will override `on_finish', and `on_headers_received', and expects `on_buffered_download_finish' to be set!
@@ -65,6 +70,8 @@ public:
 
     /// Note: Must be set before `set_should_buffer_all_input(true)`.
     Function<void(bool success, u32 total_size, const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers, Optional<u32> response_code, ReadonlyBytes payload)> on_buffered_download_finish;
+    /// Note: Only used while buffering all input. Called with each new chunk of the payload once the response headers are known.
+    Function<void(const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers, Optional<u32> response_code, ReadonlyBytes chunk)> on_buffered_data_received;
     Function<void(bool success, u32 total_size)> on_finish;
     Function<void(Optional<u32> total_size, u32 downloaded_size)> on_progress;
     Function<void(const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers, Optional<u32> response_code)> on_headers_received;
@@ -87,30 +94,24 @@ private:
     bool m_should_buffer_all_input { false };
 
     struct InternalBufferedData {
-        InternalBufferedData(int fd)
-            : read_stream(fd)
-        {
-        }
-
-        InputFileStream read_stream;
         DuplexMemoryStream payload_stream;
         HashMap<String, String, CaseInsensitiveStringTraits> response_headers;
         Optional<u32> response_code;
+        bool has_received_headers { false };
     };
 
     struct InternalStreamData {
-        InternalStreamData(int fd)
-            : read_stream(fd)
-        {
-        }
-
-        InputFileStream read_stream;
+        OwnPtr<OutputStream> owned_output_stream;
         RefPtr<Core::Notifier> read_notifier;
-        bool success;
+        Function<void(bool success, u32 total_size)> on_finish;
+        bool success { false };
         u32 total_size { 0 };
         bool download_done { false };
+        bool reached_end_of_data { false };
     };
 
+    void finish_streaming_if_done();
+
     OwnPtr<InternalBufferedData> m_internal_buffered_data;
     OwnPtr<InternalStreamData> m_internal_stream_data;
 };
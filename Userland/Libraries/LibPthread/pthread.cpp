@@ -38,6 +38,7 @@
 #include <signal.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/internals.h>
 #include <sys/mman.h>
 #include <syscall.h>
 #include <time.h>
@@ -106,6 +107,7 @@ static int create_thread(pthread_t* thread, void* (*entry)(void*), void* argumen
 [[noreturn]] static void exit_thread(void* code)
 {
     KeyDestroyer::destroy_for_current_thread();
+    __malloc_thread_exit();
     syscall(SC_exit_thread, code);
     VERIFY_NOT_REACHED();
 }
@@ -187,18 +189,7 @@ int pthread_mutex_lock(pthread_mutex_t* mutex)
 
 int pthread_mutex_trylock(pthread_mutex_t* mutex)
 {
-    auto& atomic = reinterpret_cast<Atomic<u32>&>(mutex->lock);
-    u32 expected = false;
-    if (!atomic.compare_exchange_strong(expected, true, AK::memory_order_acq_rel)) {
-        if (mutex->type == PTHREAD_MUTEX_RECURSIVE && mutex->owner == pthread_self()) {
-            mutex->level++;
-            return 0;
-        }
-        return EBUSY;
-    }
-    mutex->owner = pthread_self();
-    mutex->level = 0;
-    return 0;
+    return __pthread_mutex_trylock(mutex);
 }
 
 int pthread_mutex_unlock(pthread_mutex_t* mutex)
@@ -451,6 +442,7 @@ int pthread_cond_init(pthread_cond_t* cond, const pthread_condattr_t* attr)
     cond->value = 0;
     cond->previous = 0;
     cond->clockid = attr ? attr->clockid : CLOCK_MONOTONIC_COARSE;
+    cond->mutex = nullptr;
     return 0;
 }
 
@@ -476,9 +468,11 @@ static int cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex, const struct
 {
     u32 value = cond->value;
     cond->previous = value;
+    cond->mutex = mutex;
     pthread_mutex_unlock(mutex);
     int rc = futex_wait(cond->value, value, abstime);
-    pthread_mutex_lock(mutex);
+    // We may have been requeued onto the mutex by pthread_cond_broadcast(), see there.
+    __pthread_mutex_lock_pessimistic_np(mutex);
     return rc;
 }
 
@@ -524,6 +518,17 @@ int pthread_cond_broadcast(pthread_cond_t* cond)
 {
     u32 value = cond->previous + 1;
     cond->value = value;
+    if (auto* mutex = cond->mutex) {
+        // Waking everybody would only have them all fight over the mutex, so wake one and move
+        // the rest straight onto the mutex. Each waiter relocks it "with waiters", so whoever
+        // unlocks it next wakes the following one in turn.
+        int saved_errno = errno;
+        int rc = futex(&cond->value, FUTEX_CMP_REQUEUE, 1, reinterpret_cast<const timespec*>(INT32_MAX), &mutex->lock, value);
+        if (rc >= 0)
+            return 0;
+        // The value changed under us, or the recorded mutex is gone; fall back to waking everybody.
+        errno = saved_errno;
+    }
     int rc = futex(&cond->value, FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
     VERIFY(rc >= 0);
     return 0;
@@ -648,27 +653,33 @@ int pthread_equal(pthread_t t1, pthread_t t2)
     return t1 == t2;
 }
 
-// FIXME: Use the fancy futex mechanism above to write an rw lock.
-//        For the time being, let's just use a less-than-good lock to get things working.
-int pthread_rwlock_destroy(pthread_rwlock_t* rl)
+// A pthread_rwlock_t is two 32-bit words: the lock state below, and the ID of the
+// thread holding it for writing (if any), which pthread_rwlock_unlock() needs to tell
+// both kinds of unlock apart.
+//     bits 0..27: reader count
+//     bit 28: locked for writing
+//     bit 29: writers may be waiting, new readers must wait as well
+//     bit 30: readers may be waiting
+// Readers and writers sleep on the state word with different futex bitsets, so that
+// each unlock wakes only the side that can make progress. Waiting writers are
+// preferred over new readers, so a stream of readers can't starve them.
+constexpr static u32 rwlock_reader_count_mask = (1 << 28) - 1;
+constexpr static u32 rwlock_writer_locked = 1 << 28;
+constexpr static u32 rwlock_writers_waiting = 1 << 29;
+constexpr static u32 rwlock_readers_waiting = 1 << 30;
+constexpr static u32 rwlock_reader_wake_bitset = 1 << 0;
+constexpr static u32 rwlock_writer_wake_bitset = 1 << 1;
+
+static u32& rwlock_state(pthread_rwlock_t* lockp)
 {
-    if (!rl)
-        return 0;
-    return 0;
+    return reinterpret_cast<u32*>(lockp)[0];
+}
+
+static u32& rwlock_writer(pthread_rwlock_t* lockp)
+{
+    return reinterpret_cast<u32*>(lockp)[1];
 }
 
-// In a very non-straightforward way, this value is composed of two 32-bit integers
-// the top 32 bits are reserved for the ID of write-locking thread (if any)
-// and the bottom 32 bits are:
-//     top 2 bits (30,31): reader wake mask, writer wake mask
-//     middle 16 bits: information
-//        bit 16: someone is waiting to write
-//        bit 17: locked for write
-//     bottom 16 bits (0..15): reader count
-constexpr static u32 reader_wake_mask = 1 << 30;
-constexpr static u32 writer_wake_mask = 1 << 31;
-constexpr static u32 writer_locked_mask = 1 << 17;
-constexpr static u32 writer_intent_mask = 1 << 16;
 int pthread_rwlock_init(pthread_rwlock_t* __restrict lockp, const pthread_rwlockattr_t* __restrict attr)
 {
     // Just ignore the attributes. use defaults for now.
@@ -679,100 +690,110 @@ int pthread_rwlock_init(pthread_rwlock_t* __restrict lockp, const pthread_rwlock
     return 0;
 }
 
-// Note that this function does not care about the top 32 bits at all.
-static int rwlock_rdlock_maybe_timed(u32* lockp, const struct timespec* timeout = nullptr, bool only_once = false, int value_if_timeout = -1, int value_if_okay = -2)
-{
-    auto current = AK::atomic_load(lockp);
-    for (; !only_once;) {
-        // First, see if this is locked for writing
-        // if it's not, try to add to the counter.
-        // If someone is waiting to write, and there is one or no other readers, let them have the lock.
-        if (!(current & writer_locked_mask)) {
-            auto count = (u16)current;
-            if (!(current & writer_intent_mask) || count > 1) {
-                ++count;
-                auto desired = (current << 16) | count;
-                auto did_exchange = AK::atomic_compare_exchange_strong(lockp, current, desired, AK::MemoryOrder::memory_order_acquire);
-                if (!did_exchange)
-                    continue; // tough luck, try again.
-                return value_if_okay;
-            }
-        }
+int pthread_rwlock_destroy(pthread_rwlock_t* lockp)
+{
+    if (!lockp)
+        return 0;
+    if (AK::atomic_load(&rwlock_state(lockp)) & (rwlock_reader_count_mask | rwlock_writer_locked))
+        return EBUSY;
+    return 0;
+}
 
-        // If no one else is waiting for the read wake bit, set it.
-        if (!(current & reader_wake_mask)) {
-            auto desired = current | reader_wake_mask;
-            auto did_exchange = AK::atomic_compare_exchange_strong(lockp, current, desired, AK::MemoryOrder::memory_order_acquire);
-            if (!did_exchange)
-                continue; // Something interesting happened!
+// Returns 0 once the thread has slept on the lock, or an error code for pthread_rwlock_*() to return.
+static int rwlock_wait(pthread_rwlock_t* lockp, u32 expected_state, const struct timespec* abstime, u32 bitset)
+{
+    int saved_errno = errno;
+    // POSIX specifies the timeout against CLOCK_REALTIME.
+    int rc = futex(&rwlock_state(lockp), FUTEX_WAIT_BITSET | FUTEX_CLOCK_REALTIME, expected_state, abstime, nullptr, bitset);
+    int error = rc < 0 ? errno : 0;
+    errno = saved_errno;
+    if (error == EAGAIN || error == EINTR)
+        return 0;
+    return error;
+}
 
-            current = desired;
+// Called with the writers waiting bit just cleared from the state: hand the lock to a
+// writer if there is one, and to all readers otherwise.
+static void rwlock_wake_waiters(pthread_rwlock_t* lockp, u32 previous_state)
+{
+    auto& state = rwlock_state(lockp);
+    if (previous_state & rwlock_writers_waiting) {
+        if (futex(&state, FUTEX_WAKE_BITSET, 1, nullptr, nullptr, rwlock_writer_wake_bitset) > 0)
+            return;
+    }
+    auto current = AK::atomic_load(&state, AK::MemoryOrder::memory_order_relaxed);
+    while (current & rwlock_readers_waiting) {
+        if (AK::atomic_compare_exchange_strong(&state, current, current & ~rwlock_readers_waiting, AK::MemoryOrder::memory_order_relaxed)) {
+            futex(&state, FUTEX_WAKE_BITSET, INT32_MAX, nullptr, nullptr, rwlock_reader_wake_bitset);
+            return;
         }
+    }
+}
 
-        // Seems like someone is writing (or is interested in writing and we let them have the lock)
-        // wait until they're done.
-        auto rc = futex(lockp, FUTEX_WAIT_BITSET, current, timeout, nullptr, reader_wake_mask);
-        if (rc < 0 && errno == ETIMEDOUT && timeout) {
-            return value_if_timeout;
+static int rwlock_rdlock(pthread_rwlock_t* lockp, const struct timespec* abstime, bool only_once)
+{
+    auto& state = rwlock_state(lockp);
+    auto current = AK::atomic_load(&state, AK::MemoryOrder::memory_order_relaxed);
+    for (;;) {
+        if (!(current & (rwlock_writer_locked | rwlock_writers_waiting))) {
+            if ((current & rwlock_reader_count_mask) == rwlock_reader_count_mask)
+                return EAGAIN;
+            if (AK::atomic_compare_exchange_strong(&state, current, current + 1, AK::MemoryOrder::memory_order_acquire))
+                return 0;
+            continue;
         }
-        if (rc < 0 && errno != EAGAIN) {
-            // Something broke. let's just bail out.
-            return errno;
+
+        if (only_once)
+            return EBUSY;
+
+        if (!(current & rwlock_readers_waiting)) {
+            if (!AK::atomic_compare_exchange_strong(&state, current, current | rwlock_readers_waiting, AK::MemoryOrder::memory_order_relaxed))
+                continue;
+            current |= rwlock_readers_waiting;
         }
-        errno = 0;
-        // Reload the 'current' value
-        current = AK::atomic_load(lockp);
+
+        if (auto rc = rwlock_wait(lockp, current, abstime, rwlock_reader_wake_bitset))
+            return rc;
+        current = AK::atomic_load(&state, AK::MemoryOrder::memory_order_relaxed);
     }
-    return value_if_timeout;
-}
-
-static int rwlock_wrlock_maybe_timed(pthread_rwlock_t* lockval_p, const struct timespec* timeout = nullptr, bool only_once = false, int value_if_timeout = -1, int value_if_okay = -2)
-{
-    u32* lockp = reinterpret_cast<u32*>(lockval_p);
-    auto current = AK::atomic_load(lockp);
-    for (; !only_once;) {
-        // First, see if this is locked for writing, and if there are any readers.
-        // if not, lock it.
-        // If someone is waiting to write, let them have the lock.
-        if (!(current & writer_locked_mask) && ((u16)current) == 0) {
-            if (!(current & writer_intent_mask)) {
-                auto desired = current | writer_locked_mask | writer_intent_mask;
-                auto did_exchange = AK::atomic_compare_exchange_strong(lockp, current, desired, AK::MemoryOrder::memory_order_acquire);
-                if (!did_exchange)
-                    continue;
-
-                // Now that we've locked the value, it's safe to set our thread ID.
-                AK::atomic_store(reinterpret_cast<i32*>(lockval_p) + 1, pthread_self());
-                return value_if_okay;
+}
+
+static int rwlock_wrlock(pthread_rwlock_t* lockp, const struct timespec* abstime, bool only_once)
+{
+    auto& state = rwlock_state(lockp);
+    auto current = AK::atomic_load(&state, AK::MemoryOrder::memory_order_relaxed);
+    // Once we've slept we can't know whether other writers are still waiting, so
+    // keep the bit set for our unlock to check.
+    bool did_wait = false;
+    for (;;) {
+        if (!(current & (rwlock_writer_locked | rwlock_reader_count_mask))) {
+            auto desired = current | rwlock_writer_locked | (did_wait ? rwlock_writers_waiting : 0);
+            if (AK::atomic_compare_exchange_strong(&state, current, desired, AK::MemoryOrder::memory_order_acquire)) {
+                AK::atomic_store(&rwlock_writer(lockp), (u32)pthread_self(), AK::MemoryOrder::memory_order_relaxed);
+                return 0;
             }
+            continue;
         }
 
-        // That didn't work, if no one else is waiting for the write bit, set it.
-        if (!(current & writer_wake_mask)) {
-            auto desired = current | writer_wake_mask | writer_intent_mask;
-            auto did_exchange = AK::atomic_compare_exchange_strong(lockp, current, desired, AK::MemoryOrder::memory_order_acquire);
-            if (!did_exchange)
-                continue; // Something interesting happened!
+        if (only_once)
+            return EBUSY;
 
-            current = desired;
+        if (!(current & rwlock_writers_waiting)) {
+            if (!AK::atomic_compare_exchange_strong(&state, current, current | rwlock_writers_waiting, AK::MemoryOrder::memory_order_relaxed))
+                continue;
+            current |= rwlock_writers_waiting;
         }
 
-        // Seems like someone is writing (or is interested in writing and we let them have the lock)
-        // wait until they're done.
-        auto rc = futex(lockp, FUTEX_WAIT_BITSET, current, timeout, nullptr, writer_wake_mask);
-        if (rc < 0 && errno == ETIMEDOUT && timeout) {
-            return value_if_timeout;
-        }
-        if (rc < 0 && errno != EAGAIN) {
-            // Something broke. let's just bail out.
-            return errno;
+        if (auto rc = rwlock_wait(lockp, current, abstime, rwlock_writer_wake_bitset)) {
+            // We may have been the writer that readers were held back for, so let them
+            // (and any other writer, which will set the bit again) have another go.
+            auto previous = AK::atomic_fetch_and(&state, ~rwlock_writers_waiting, AK::MemoryOrder::memory_order_relaxed);
+            rwlock_wake_waiters(lockp, previous);
+            return rc;
         }
-        errno = 0;
-        // Reload the 'current' value
-        current = AK::atomic_load(lockp);
+        did_wait = true;
+        current = AK::atomic_load(&state, AK::MemoryOrder::memory_order_relaxed);
     }
-
-    return value_if_timeout;
 }
 
 int pthread_rwlock_rdlock(pthread_rwlock_t* lockp)
@@ -780,93 +801,75 @@ int pthread_rwlock_rdlock(pthread_rwlock_t* lockp)
     if (!lockp)
         return EINVAL;
 
-    return rwlock_rdlock_maybe_timed(reinterpret_cast<u32*>(lockp), nullptr, false, 0, 0);
+    return rwlock_rdlock(lockp, nullptr, false);
 }
 int pthread_rwlock_timedrdlock(pthread_rwlock_t* __restrict lockp, const struct timespec* __restrict timespec)
 {
     if (!lockp)
         return EINVAL;
 
-    auto rc = rwlock_rdlock_maybe_timed(reinterpret_cast<u32*>(lockp), timespec);
-    if (rc == -1) // "ok"
-        return 0;
-    if (rc == -2) // "timed out"
-        return 1;
-    return rc;
+    return rwlock_rdlock(lockp, timespec, false);
 }
 int pthread_rwlock_timedwrlock(pthread_rwlock_t* __restrict lockp, const struct timespec* __restrict timespec)
 {
     if (!lockp)
         return EINVAL;
 
-    auto rc = rwlock_wrlock_maybe_timed(lockp, timespec);
-    if (rc == -1) // "ok"
-        return 0;
-    if (rc == -2) // "timed out"
-        return 1;
-    return rc;
+    return rwlock_wrlock(lockp, timespec, false);
 }
 int pthread_rwlock_tryrdlock(pthread_rwlock_t* lockp)
 {
     if (!lockp)
         return EINVAL;
 
-    return rwlock_rdlock_maybe_timed(reinterpret_cast<u32*>(lockp), nullptr, true, EBUSY, 0);
+    return rwlock_rdlock(lockp, nullptr, true);
 }
 int pthread_rwlock_trywrlock(pthread_rwlock_t* lockp)
 {
     if (!lockp)
         return EINVAL;
 
-    return rwlock_wrlock_maybe_timed(lockp, nullptr, true, EBUSY, 0);
+    return rwlock_wrlock(lockp, nullptr, true);
 }
-int pthread_rwlock_unlock(pthread_rwlock_t* lockval_p)
+int pthread_rwlock_unlock(pthread_rwlock_t* lockp)
 {
-    if (!lockval_p)
+    if (!lockp)
         return EINVAL;
 
-    // This is a weird API, we don't really know whether we're unlocking write or read...
-    auto lockp = reinterpret_cast<u32*>(lockval_p);
-    auto current = AK::atomic_load(lockp, AK::MemoryOrder::memory_order_relaxed);
-    if (current & writer_locked_mask) {
+    auto& state = rwlock_state(lockp);
+    auto current = AK::atomic_load(&state, AK::MemoryOrder::memory_order_relaxed);
+    if (current & rwlock_writer_locked) {
         // If this lock is locked for writing, its owner better be us!
-        auto owner_id = AK::atomic_load(reinterpret_cast<i32*>(lockval_p) + 1);
-        auto my_id = pthread_self();
-        if (owner_id != my_id)
-            return EINVAL; // you don't own this lock, silly.
-
-        // Now just unlock it.
-        auto desired = current & ~(writer_locked_mask | writer_intent_mask);
-        AK::atomic_store(lockp, desired, AK::MemoryOrder::memory_order_release);
-        // Then wake both readers and writers, if any.
-        auto rc = futex(lockp, FUTEX_WAKE_BITSET, current, nullptr, nullptr, (current & writer_wake_mask) | reader_wake_mask);
-        if (rc < 0)
-            return errno;
+        if (AK::atomic_load(&rwlock_writer(lockp), AK::MemoryOrder::memory_order_relaxed) != (u32)pthread_self())
+            return EPERM;
+        AK::atomic_store(&rwlock_writer(lockp), 0u, AK::MemoryOrder::memory_order_relaxed);
+        auto previous = AK::atomic_fetch_and(&state, ~(rwlock_writer_locked | rwlock_writers_waiting), AK::MemoryOrder::memory_order_release);
+        rwlock_wake_waiters(lockp, previous);
         return 0;
     }
 
     for (;;) {
-        auto count = (u16)current;
+        auto count = current & rwlock_reader_count_mask;
         if (!count) {
             // Are you crazy? this isn't even locked!
-            return EINVAL;
+            return EPERM;
+        }
+        // The last reader out hands the lock to a waiting writer.
+        bool last_reader_with_writers = count == 1 && (current & rwlock_writers_waiting);
+        auto desired = (current - 1) & ~(last_reader_with_writers ? rwlock_writers_waiting : 0);
+        if (AK::atomic_compare_exchange_strong(&state, current, desired, AK::MemoryOrder::memory_order_release)) {
+            if (last_reader_with_writers)
+                rwlock_wake_waiters(lockp, current);
+            return 0;
         }
-        --count;
-        auto desired = (current << 16) | count;
-        auto did_exchange = AK::atomic_compare_exchange_strong(lockp, current, desired, AK::MemoryOrder::memory_order_release);
-        if (!did_exchange)
-            continue; // tough luck, try again.
     }
-
-    // Finally, unlocked at last!
-    return 0;
 }
 int pthread_rwlock_wrlock(pthread_rwlock_t* lockp)
 {
     if (!lockp)
         return EINVAL;
 
-    return rwlock_wrlock_maybe_timed(lockp, nullptr, false, 0, 0);
+    return rwlock_wrlock(lockp, nullptr, false);
 }
 int pthread_rwlockattr_destroy(pthread_rwlockattr_t*)
 {
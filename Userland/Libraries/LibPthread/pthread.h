@@ -81,14 +81,12 @@ int pthread_setschedparam(pthread_t thread, int policy, const struct sched_param
 #define PTHREAD_MUTEX_DEFAULT PTHREAD_MUTEX_NORMAL
 #define PTHREAD_MUTEX_INITIALIZER __PTHREAD_MUTEX_INITIALIZER
 
-#define PTHREAD_COND_INITIALIZER     \
-    {                                \
-        0, 0, CLOCK_MONOTONIC_COARSE \
+#define PTHREAD_COND_INITIALIZER        \
+    {                                   \
+        0, 0, CLOCK_MONOTONIC_COARSE, 0 \
     }
 
-// FIXME: Actually implement this!
-#define PTHREAD_RWLOCK_INITIALIZER \
-    NULL
+#define PTHREAD_RWLOCK_INITIALIZER 0
 
 #define PTHREAD_KEYS_MAX 64
 #define PTHREAD_DESTRUCTOR_ITERATIONS 4
@@ -108,7 +108,7 @@ static const char* character_class_name(CharClass ch_class)
     }
 }
 
-HashMap<u32, OwnPtr<OpCode>> ByteCode::s_opcodes {};
+thread_local HashMap<u32, OwnPtr<OpCode>> ByteCode::s_opcodes {};
 
 ALWAYS_INLINE OpCode* ByteCode::get_opcode_by_id(OpCodeId id) const
 {
@@ -188,6 +188,156 @@ OpCode* ByteCode::get_opcode(MatchState& state) const
     return op_code;
 }
 
+bool ByteCode::can_be_matched_without_backtracking() const
+{
+    MatchState state;
+    while (state.instruction_position < size()) {
+        auto* opcode = get_opcode(state);
+        if (!opcode)
+            return false;
+
+        switch (opcode->opcode_id()) {
+        case OpCodeId::Compare:
+            if (to<OpCode_Compare>(opcode)->has_backreferences())
+                return false;
+            break;
+        case OpCodeId::Jump:
+        case OpCodeId::ForkJump:
+        case OpCodeId::ForkStay:
+        case OpCodeId::SaveLeftCaptureGroup:
+        case OpCodeId::SaveRightCaptureGroup:
+        case OpCodeId::SaveLeftNamedCaptureGroup:
+        case OpCodeId::SaveRightNamedCaptureGroup:
+        case OpCodeId::CheckBegin:
+        case OpCodeId::CheckEnd:
+        case OpCodeId::CheckBoundary:
+            break;
+        case OpCodeId::FailForks:
+        case OpCodeId::Save:
+        case OpCodeId::Restore:
+        case OpCodeId::GoBack:
+        case OpCodeId::Exit:
+            // Lookarounds (and explicit exits) rely on the fork order of the backtracking VM.
+            return false;
+        }
+
+        state.instruction_position += opcode->size();
+    }
+
+    return true;
+}
+
+String ByteCode::literal_prefix() const
+{
+    StringBuilder builder;
+    MatchState state;
+    while (state.instruction_position < size()) {
+        auto* opcode = get_opcode(state);
+        if (!opcode)
+            break;
+
+        auto opcode_id = opcode->opcode_id();
+        if (opcode_id == OpCodeId::Compare) {
+            auto literal = to<OpCode_Compare>(opcode)->literal_string();
+            if (!literal.has_value())
+                break;
+            builder.append(literal.value());
+        } else if (opcode_id != OpCodeId::SaveLeftCaptureGroup
+            && opcode_id != OpCodeId::SaveRightCaptureGroup
+            && opcode_id != OpCodeId::SaveLeftNamedCaptureGroup
+            && opcode_id != OpCodeId::SaveRightNamedCaptureGroup) {
+            break;
+        }
+
+        state.instruction_position += opcode->size();
+    }
+
+    return builder.to_string();
+}
+
+Optional<Array<bool, 256>> ByteCode::first_bytes() const
+{
+    Array<bool, 256> bytes {};
+    Vector<bool> visited;
+    visited.ensure_capacity(size());
+    for (size_t i = 0; i < size(); ++i)
+        visited.unchecked_append(false);
+
+    if (!collect_first_bytes(0, bytes, visited))
+        return {};
+
+    for (auto byte : bytes) {
+        if (!byte)
+            return bytes;
+    }
+
+    // Every byte can start a match, so knowing that doesn't help.
+    return {};
+}
+
+bool ByteCode::collect_first_bytes(size_t instruction_position, Array<bool, 256>& bytes, Vector<bool>& visited) const
+{
+    // Reaching the end means the pattern can match without consuming anything.
+    if (instruction_position >= size())
+        return false;
+
+    if (visited[instruction_position])
+        return true;
+    visited[instruction_position] = true;
+
+    MatchState state;
+    state.instruction_position = instruction_position;
+    auto* opcode = get_opcode(state);
+    if (!opcode)
+        return false;
+
+    // Note: The opcode is shared with the recursive calls, so read its arguments before recursing.
+    auto next_instruction_position = instruction_position + opcode->size();
+    switch (opcode->opcode_id()) {
+    case OpCodeId::Compare: {
+        auto& compare = to<OpCode_Compare>(*opcode);
+        if (auto literal = compare.literal_string(); literal.has_value()) {
+            if (literal.value().is_empty())
+                return false;
+            bytes[(u8)literal.value()[0]] = true;
+            return true;
+        }
+        // Probing single bytes only works if the comparison consumes exactly one character.
+        if (!compare.compares_single_characters())
+            return false;
+        for (size_t byte = 0; byte < bytes.size(); ++byte) {
+            if (compare.matches_byte(byte))
+                bytes[byte] = true;
+        }
+        return true;
+    }
+    case OpCodeId::Jump:
+        return collect_first_bytes(next_instruction_position + static_cast<const OpCode_Jump*>(opcode)->offset(), bytes, visited);
+    case OpCodeId::ForkJump:
+    case OpCodeId::ForkStay: {
+        auto fork_instruction_position = next_instruction_position + (opcode->opcode_id() == OpCodeId::ForkJump ? static_cast<const OpCode_ForkJump*>(opcode)->offset() : static_cast<const OpCode_ForkStay*>(opcode)->offset());
+        return collect_first_bytes(next_instruction_position, bytes, visited)
+            && collect_first_bytes(fork_instruction_position, bytes, visited);
+    }
+    case OpCodeId::SaveLeftCaptureGroup:
+    case OpCodeId::SaveRightCaptureGroup:
+    case OpCodeId::SaveLeftNamedCaptureGroup:
+    case OpCodeId::SaveRightNamedCaptureGroup:
+    case OpCodeId::CheckBegin:
+    case OpCodeId::CheckEnd:
+    case OpCodeId::CheckBoundary:
+        return collect_first_bytes(next_instruction_position, bytes, visited);
+    case OpCodeId::FailForks:
+    case OpCodeId::Save:
+    case OpCodeId::Restore:
+    case OpCodeId::GoBack:
+    case OpCodeId::Exit:
+        return false;
+    }
+
+    VERIFY_NOT_REACHED();
+}
+
 ALWAYS_INLINE ExecutionResult OpCode_Exit::execute(const MatchInput& input, MatchState& state, MatchOutput&) const
 {
     if (state.string_position > input.view.length() || state.instruction_position >= m_bytecode->size())
@@ -332,7 +482,8 @@ ALWAYS_INLINE ExecutionResult OpCode_SaveRightCaptureGroup::execute(const MatchI
     auto start_position = match.left_column;
     auto length = state.string_position - start_position;
 
-    if (start_position < match.column)
+    // The left side may have been saved by a path that has since been backtracked over.
+    if (start_position < match.column || start_position > state.string_position)
         return ExecutionResult::Continue;
 
     VERIFY(start_position + length <= input.view.length());
@@ -692,6 +843,89 @@ const String OpCode_Compare::arguments_string() const
     return String::format("argc=%lu, args=%lu ", arguments_count(), arguments_size());
 }
 
+bool OpCode_Compare::has_backreferences() const
+{
+    size_t offset { state().instruction_position + 3 };
+    for (size_t i = 0; i < arguments_count(); ++i) {
+        auto compare_type = (CharacterCompareType)m_bytecode->at(offset++);
+        switch (compare_type) {
+        case CharacterCompareType::Reference:
+        case CharacterCompareType::NamedReference:
+            return true;
+        case CharacterCompareType::Inverse:
+        case CharacterCompareType::TemporaryInverse:
+        case CharacterCompareType::AnyChar:
+            break;
+        case CharacterCompareType::String:
+            offset += m_bytecode->at(offset) + 1;
+            break;
+        default:
+            ++offset;
+            break;
+        }
+    }
+    return false;
+}
+
+bool OpCode_Compare::compares_single_characters() const
+{
+    size_t offset { state().instruction_position + 3 };
+    for (size_t i = 0; i < arguments_count(); ++i) {
+        auto compare_type = (CharacterCompareType)m_bytecode->at(offset++);
+        switch (compare_type) {
+        case CharacterCompareType::Reference:
+        case CharacterCompareType::NamedReference:
+        case CharacterCompareType::String:
+            return false;
+        case CharacterCompareType::Inverse:
+        case CharacterCompareType::TemporaryInverse:
+        case CharacterCompareType::AnyChar:
+            break;
+        default:
+            ++offset;
+            break;
+        }
+    }
+    return true;
+}
+
+bool OpCode_Compare::matches_byte(u8 byte) const
+{
+    MatchInput input;
+    input.view = StringView { reinterpret_cast<const char*>(&byte), 1 };
+
+    MatchState state;
+    state.instruction_position = this->state().instruction_position;
+
+    MatchOutput output;
+    return execute(input, state, output) == ExecutionResult::Continue;
+}
+
+Optional<String> OpCode_Compare::literal_string() const
+{
+    if (arguments_count() != 1)
+        return {};
+
+    size_t offset { state().instruction_position + 3 };
+    auto compare_type = (CharacterCompareType)m_bytecode->at(offset++);
+    if (compare_type == CharacterCompareType::Char) {
+        auto ch = m_bytecode->at(offset);
+        if (ch > 0xff)
+            return {};
+        return String::repeated((char)ch, 1);
+    }
+
+    if (compare_type == CharacterCompareType::String) {
+        auto length = m_bytecode->at(offset++);
+        StringBuilder builder;
+        for (size_t i = 0; i < length; ++i)
+            builder.append((char)m_bytecode->at(offset++));
+        return builder.to_string();
+    }
+
+    return {};
+}
+
 const Vector<String> OpCode_Compare::variable_arguments_to_string(Optional<MatchInput> input) const
 {
     Vector<String> result;
@@ -29,6 +29,7 @@
 #include "RegexMatch.h"
 #include "RegexOptions.h"
 
+#include <AK/Array.h>
 #include <AK/Format.h>
 #include <AK/Forward.h>
 #include <AK/HashMap.h>
@@ -456,6 +457,17 @@ public:
 
     OpCode* get_opcode(MatchState& state) const;
 
+    // Bytecode without lookarounds and backreferences only ever depends on the current
+    // string position, so it can be simulated as an automaton instead of by backtracking.
+    bool can_be_matched_without_backtracking() const;
+
+    // The literal bytes every match starts with, if there are any.
+    String literal_prefix() const;
+
+    // The set of bytes a match can start with, or nothing if that could be any byte
+    // (or none at all, for patterns that match the empty string).
+    Optional<Array<bool, 256>> first_bytes() const;
+
 private:
     void insert_string(const StringView& view)
     {
@@ -464,8 +476,11 @@ private:
             empend((ByteCodeValueType)view[i]);
     }
 
+    bool collect_first_bytes(size_t instruction_position, Array<bool, 256>& bytes, Vector<bool>& visited) const;
+
     ALWAYS_INLINE OpCode* get_opcode_by_id(OpCodeId id) const;
-    static HashMap<u32, OwnPtr<OpCode>> s_opcodes;
+    // The opcodes keep pointers to the bytecode and match state they work on, so each thread needs its own.
+    static thread_local HashMap<u32, OwnPtr<OpCode>> s_opcodes;
 };
 
 #define ENUMERATE_EXECUTION_RESULTS                          \
@@ -765,6 +780,10 @@ public:
     ALWAYS_INLINE size_t arguments_size() const { return argument(1); }
     const String arguments_string() const override;
     const Vector<String> variable_arguments_to_string(Optional<MatchInput> input = {}) const;
+    bool has_backreferences() const;
+    bool compares_single_characters() const;
+    bool matches_byte(u8) const;
+    Optional<String> literal_string() const;
 
 private:
     ALWAYS_INLINE static void compare_char(const MatchInput& input, MatchState& state, u32 ch1, bool inverse, bool& inverse_matched);
@@ -273,6 +273,9 @@ struct MatchInput {
 
     mutable size_t fail_counter { 0 };
     mutable Vector<size_t> saved_positions;
+
+    // Once the backtracking VM has executed more operations than this, it gives up so the match can be finished by the automaton.
+    Optional<size_t> operations_limit;
 };
 
 struct MatchState {
@@ -28,9 +28,11 @@
 #include "RegexDebug.h"
 #include "RegexParser.h"
 #include <AK/Debug.h>
+#include <AK/NumericLimits.h>
 #include <AK/ScopedValueRollback.h>
 #include <AK/String.h>
 #include <AK/StringBuilder.h>
+#include <string.h>
 
 namespace regex {
 
@@ -73,6 +75,15 @@ String Regex<Parser>::error_string(Optional<String> message) const
     return eb.build();
 }
 
+template<class Parser>
+Matcher<Parser>::Matcher(const Regex<Parser>& pattern, Optional<typename ParserTraits<Parser>::OptionsType> regex_options)
+    : m_pattern(pattern)
+    , m_regex_options(regex_options.value_or({}))
+    , m_can_execute_as_automaton(pattern.parser_result.bytecode.can_be_matched_without_backtracking())
+{
+    dbgln_if(REGEX_DEBUG, "[match] Pattern '{}' {} fall back to an automaton", pattern.pattern_value, m_can_execute_as_automaton ? "can" : "cannot");
+}
+
 template<typename Parser>
 RegexResult Matcher<Parser>::match(const RegexStringView& view, Optional<typename ParserTraits<Parser>::OptionsType> regex_options) const
 {
@@ -86,6 +97,39 @@ RegexResult Matcher<Parser>::match(const RegexStringView& view, Optional<typenam
     return match(views, regex_options);
 }
 
+// Returns the first position at or after `start` where a match could begin, judging only by the
+// literal prefix or the set of first bytes the pattern requires.
+static Optional<size_t> find_possible_match_start(const StringView& view, size_t start, const String& literal_prefix, const Optional<Array<bool, 256>>& first_bytes)
+{
+    if (start >= view.length())
+        return {};
+
+    auto* haystack = view.characters_without_null_termination() + start;
+    auto haystack_length = view.length() - start;
+
+    if (!literal_prefix.is_empty()) {
+        // Find the first byte with memchr(), then check the rest; unlike memmem() this needs no per-call setup.
+        auto* haystack_end = haystack + haystack_length;
+        while (static_cast<size_t>(haystack_end - haystack) >= literal_prefix.length()) {
+            auto* found = static_cast<const char*>(memchr(haystack, literal_prefix[0], haystack_end - haystack - literal_prefix.length() + 1));
+            if (!found)
+                return {};
+            if (!memcmp(found + 1, literal_prefix.characters() + 1, literal_prefix.length() - 1))
+                return found - view.characters_without_null_termination();
+            haystack = found + 1;
+        }
+        return {};
+    }
+
+    VERIFY(first_bytes.has_value());
+    auto& bytes = first_bytes.value();
+    for (size_t i = 0; i < haystack_length; ++i) {
+        if (bytes[(u8)haystack[i]])
+            return start + i;
+    }
+    return {};
+}
+
 template<typename Parser>
 RegexResult Matcher<Parser>::match(const Vector<RegexStringView> views, Optional<typename ParserTraits<Parser>::OptionsType> regex_options) const
 {
@@ -146,6 +190,14 @@ RegexResult Matcher<Parser>::match(const Vector<RegexStringView> views, Optional
     if (input.regex_options.has_flag_set(AllFlags::Internal_Stateful))
         continue_search = false;
 
+    auto& literal_prefix = m_pattern.parser_result.literal_prefix;
+    auto& first_bytes = m_pattern.parser_result.first_bytes;
+    // Only searches that keep going after a failed attempt can skip positions, and the
+    // byte-wise scan doesn't know about case folding.
+    bool can_skip_to_possible_match = (continue_search || input.regex_options.has_flag_set(AllFlags::Internal_Stateful))
+        && !input.regex_options.has_flag_set(AllFlags::Insensitive)
+        && (!literal_prefix.is_empty() || first_bytes.has_value());
+
     for (auto& view : views) {
         input.view = view;
         dbgln_if(REGEX_DEBUG, "[match] Starting match with view ({}): _{}_", view.length(), view);
@@ -166,7 +218,7 @@ RegexResult Matcher<Parser>::match(const Vector<RegexStringView> views, Optional
             state.string_position = view_index;
             state.instruction_position = 0;
 
-            auto success = execute(input, state, temp_output, 0);
+            auto success = execute_from_start(input, state, temp_output);
             // This success is acceptable only if it doesn't read anything from the input (input length is 0).
             if (state.string_position <= view_index) {
                 if (success.value()) {
@@ -181,6 +233,13 @@ RegexResult Matcher<Parser>::match(const Vector<RegexStringView> views, Optional
         }
 
         for (; view_index < view_length; ++view_index) {
+            if (can_skip_to_possible_match && view.is_u8_view()) {
+                auto possible_match_start = find_possible_match_start(view.u8view(), view_index, literal_prefix, first_bytes);
+                if (!possible_match_start.has_value())
+                    break;
+                view_index = possible_match_start.value();
+            }
+
             auto& match_length_minimum = m_pattern.parser_result.match_length_minimum;
             // FIXME: More performant would be to know the remaining minimum string
             //        length needed to match from the current position onwards within
@@ -197,7 +256,7 @@ RegexResult Matcher<Parser>::match(const Vector<RegexStringView> views, Optional
             state.string_position = view_index;
             state.instruction_position = 0;
 
-            auto success = execute(input, state, output, 0);
+            auto success = execute_from_start(input, state, output);
             if (!success.has_value())
                 return { false, 0, {}, {}, {}, output.operations };
 
@@ -253,9 +312,12 @@ RegexResult Matcher<Parser>::match(const Vector<RegexStringView> views, Optional
 
     MatchOutput output_copy;
     if (match_count) {
+        // Every match gets an entry, even if its attempt never touched a capture group.
         auto capture_groups_count = min(output.capture_group_matches.size(), output.matches.size());
-        for (size_t i = 0; i < capture_groups_count; ++i) {
-            if (input.regex_options.has_flag_set(AllFlags::SkipTrimEmptyMatches)) {
+        for (size_t i = 0; i < match_count; ++i) {
+            if (i >= capture_groups_count) {
+                output_copy.capture_group_matches.append(Vector<Match> {});
+            } else if (input.regex_options.has_flag_set(AllFlags::SkipTrimEmptyMatches)) {
                 output_copy.capture_group_matches.append(output.capture_group_matches.at(i));
             } else {
                 Vector<Match> capture_group_matches;
@@ -272,6 +334,8 @@ RegexResult Matcher<Parser>::match(const Vector<RegexStringView> views, Optional
             if (output.matches.at(i).view.length())
                 output_copy.named_capture_group_matches.append(output.named_capture_group_matches.at(i));
         }
+        if (output_copy.named_capture_group_matches.is_empty())
+            output_copy.named_capture_group_matches.append(HashMap<String, Match> {});
 
         for (size_t i = 0; i < match_count; ++i)
             output_copy.matches.append(output.matches.at(i));
@@ -293,11 +357,38 @@ RegexResult Matcher<Parser>::match(const Vector<RegexStringView> views, Optional
     };
 }
 
+template<class Parser>
+Optional<bool> Matcher<Parser>::execute_from_start(MatchInput& input, MatchState& state, MatchOutput& output) const
+{
+    if (!m_can_execute_as_automaton)
+        return execute(input, state, output, 0);
+
+    // Backtracking is the fastest way to match most patterns, but some (like "(a|a)*b") make it take
+    // exponential time. Give it as many operations as the automaton could need at most, and let the
+    // automaton take over from the same position once they are used up.
+    auto start_position = state.string_position;
+    auto remaining_length = input.view.length() - start_position;
+    input.operations_limit = output.operations + (remaining_length + 1) * (m_pattern.parser_result.bytecode.size() + 1);
+
+    auto success = execute(input, state, output, 0);
+    input.operations_limit.clear();
+    if (success.has_value())
+        return success;
+
+    dbgln_if(REGEX_DEBUG, "[match] Backtracking gave up at position {}, continuing as an automaton", start_position);
+    state.string_position = start_position;
+    state.instruction_position = 0;
+    return execute_as_automaton(input, state, output);
+}
+
 template<class Parser>
 Optional<bool> Matcher<Parser>::execute(const MatchInput& input, MatchState& state, MatchOutput& output, size_t recursion_level) const
 {
-    if (recursion_level > c_max_recursion)
+    if (recursion_level > c_max_recursion) {
+        if (input.operations_limit.has_value())
+            return {};
         return false;
+    }
 
     Vector<MatchState> fork_low_prio_states;
     MatchState fork_high_prio_state;
@@ -307,6 +398,9 @@ Optional<bool> Matcher<Parser>::execute(const MatchInput& input, MatchState& sta
 
     for (;;) {
         ++output.operations;
+        if (input.operations_limit.has_value() && output.operations > input.operations_limit.value())
+            return {};
+
         auto* opcode = bytecode.get_opcode(state);
 
         if (!opcode) {
@@ -388,6 +482,261 @@ ALWAYS_INLINE Optional<bool> Matcher<Parser>::execute_low_prio_forks(const Match
     return false;
 }
 
+// Simulates the bytecode as a Thompson NFA (a "Pike VM"): all threads of execution advance
+// through the input in lockstep, and threads that reach the same instruction at the same string
+// position are merged, keeping only the one with the highest priority. Since the surviving
+// thread is the one the backtracking VM would have tried first, this finds the same match,
+// but in time linear in the length of the input. It cannot handle lookarounds or
+// backreferences, whose outcome depends on more than the current position.
+class Automaton {
+public:
+    Automaton(const ByteCode& bytecode, const MatchInput& input, MatchOutput& output, size_t capture_groups_count, size_t named_capture_groups_count)
+        : m_bytecode(bytecode)
+        , m_input(input)
+        , m_output(output)
+        , m_capture_groups_count(capture_groups_count + 1) // POSIX numbers its groups from 0, ECMA262 from 1.
+        , m_named_capture_groups_count(named_capture_groups_count)
+    {
+        m_visited_in_step.ensure_capacity(bytecode.size());
+        for (size_t i = 0; i < bytecode.size(); ++i)
+            m_visited_in_step.unchecked_append(0);
+    }
+
+    bool run(MatchState& state)
+    {
+        Vector<size_t> captures;
+        auto capture_slots_count = 2 * (m_capture_groups_count + m_named_capture_groups_count);
+        captures.ensure_capacity(capture_slots_count);
+        for (size_t i = 0; i < capture_slots_count; ++i)
+            captures.unchecked_append(c_unset_position);
+
+        Vector<Thread> threads;
+        Vector<Thread> next_threads;
+
+        auto string_position = state.string_position;
+        begin_step();
+        add_thread(threads, 0, string_position, captures);
+
+        while (!threads.is_empty() && string_position < m_input.view.length()) {
+            begin_step();
+            next_threads.clear_with_capacity();
+
+            for (auto& thread : threads) {
+                if (thread.resume_position > string_position) {
+                    // Still stepping over the input consumed by a multi-character compare.
+                    if (thread.resume_position == string_position + 1)
+                        add_thread(next_threads, thread.instruction_position, string_position + 1, thread.captures);
+                    else
+                        next_threads.append(move(thread));
+                } else {
+                    step_compare(next_threads, thread, string_position);
+                }
+
+                // A match cuts off all threads with a lower priority than the one that found it.
+                if (m_found_match_in_step)
+                    break;
+            }
+
+            swap(threads, next_threads);
+            ++string_position;
+        }
+
+        if (!m_match_end_position.has_value())
+            return false;
+
+        state.string_position = m_match_end_position.value();
+        if (!(m_input.regex_options & AllFlags::SkipSubExprResults))
+            save_capture_groups();
+        return true;
+    }
+
+private:
+    static constexpr size_t c_unset_position = NumericLimits<size_t>::max();
+
+    struct Thread {
+        size_t instruction_position { 0 };
+        size_t resume_position { 0 };
+        Vector<size_t> captures;
+    };
+
+    void begin_step()
+    {
+        ++m_step;
+        m_found_match_in_step = false;
+    }
+
+    void step_compare(Vector<Thread>& next_threads, Thread& thread, size_t string_position)
+    {
+        ++m_output.operations;
+
+        MatchState state;
+        state.string_position = string_position;
+        state.instruction_position = thread.instruction_position;
+        auto* opcode = m_bytecode.get_opcode(state);
+        if (opcode->execute(m_input, state, m_output) != ExecutionResult::Continue)
+            return;
+
+        auto next_instruction_position = thread.instruction_position + opcode->size();
+        if (state.string_position == string_position + 1)
+            add_thread(next_threads, next_instruction_position, string_position + 1, thread.captures);
+        else
+            next_threads.append({ next_instruction_position, state.string_position, move(thread.captures) });
+    }
+
+    // Follows all non-consuming instructions from instruction_position in priority order,
+    // and queues up a thread for each compare that is reached.
+    void add_thread(Vector<Thread>& threads, size_t instruction_position, size_t string_position, Vector<size_t>& captures)
+    {
+        if (m_found_match_in_step)
+            return;
+
+        if (instruction_position >= m_bytecode.size()) {
+            m_match_end_position = string_position;
+            m_match_captures = captures;
+            m_found_match_in_step = true;
+            return;
+        }
+
+        if (m_visited_in_step[instruction_position] == m_step)
+            return;
+        m_visited_in_step[instruction_position] = m_step;
+
+        ++m_output.operations;
+
+        MatchState state;
+        state.string_position = string_position;
+        state.instruction_position = instruction_position;
+        auto* opcode = m_bytecode.get_opcode(state);
+        auto next_instruction_position = instruction_position + opcode->size();
+
+        switch (opcode->opcode_id()) {
+        case OpCodeId::Compare:
+            threads.append({ instruction_position, string_position, captures });
+            return;
+        case OpCodeId::Jump:
+            add_thread(threads, next_instruction_position + static_cast<const OpCode_Jump*>(opcode)->offset(), string_position, captures);
+            return;
+        case OpCodeId::ForkJump: {
+            auto fork_instruction_position = next_instruction_position + static_cast<const OpCode_ForkJump*>(opcode)->offset();
+            add_thread(threads, fork_instruction_position, string_position, captures);
+            add_thread(threads, next_instruction_position, string_position, captures);
+            return;
+        }
+        case OpCodeId::ForkStay: {
+            // Note: The opcode is shared with the recursive calls, so read its arguments before following the first branch.
+            auto fork_instruction_position = next_instruction_position + static_cast<const OpCode_ForkStay*>(opcode)->offset();
+            add_thread(threads, next_instruction_position, string_position, captures);
+            add_thread(threads, fork_instruction_position, string_position, captures);
+            return;
+        }
+        case OpCodeId::SaveLeftCaptureGroup:
+            add_thread_with_capture(threads, next_instruction_position, string_position, captures, 2 * static_cast<const OpCode_SaveLeftCaptureGroup*>(opcode)->id());
+            return;
+        case OpCodeId::SaveRightCaptureGroup:
+            add_thread_with_capture(threads, next_instruction_position, string_position, captures, 2 * static_cast<const OpCode_SaveRightCaptureGroup*>(opcode)->id() + 1);
+            return;
+        case OpCodeId::SaveLeftNamedCaptureGroup:
+            add_thread_with_capture(threads, next_instruction_position, string_position, captures, named_capture_slot(static_cast<const OpCode_SaveLeftNamedCaptureGroup*>(opcode)->name()));
+            return;
+        case OpCodeId::SaveRightNamedCaptureGroup:
+            add_thread_with_capture(threads, next_instruction_position, string_position, captures, named_capture_slot(static_cast<const OpCode_SaveRightNamedCaptureGroup*>(opcode)->name()) + 1);
+            return;
+        case OpCodeId::CheckBegin:
+        case OpCodeId::CheckEnd:
+        case OpCodeId::CheckBoundary:
+            if (opcode->execute(m_input, state, m_output) == ExecutionResult::Continue)
+                add_thread(threads, next_instruction_position, string_position, captures);
+            return;
+        default:
+            // Matcher only uses the automaton for bytecode that passes can_be_matched_without_backtracking().
+            VERIFY_NOT_REACHED();
+        }
+    }
+
+    void add_thread_with_capture(Vector<Thread>& threads, size_t instruction_position, size_t string_position, Vector<size_t>& captures, size_t slot)
+    {
+        VERIFY(slot < captures.size());
+        auto previous_position = captures[slot];
+        captures[slot] = string_position;
+        add_thread(threads, instruction_position, string_position, captures);
+        captures[slot] = previous_position;
+    }
+
+    size_t named_capture_slot(const StringView& name)
+    {
+        auto index = m_capture_group_names.find_first_index(name);
+        if (!index.has_value()) {
+            index = m_capture_group_names.size();
+            m_capture_group_names.append(name);
+        }
+        return 2 * (m_capture_groups_count + index.value());
+    }
+
+    Match make_match(size_t start_position, size_t end_position) const
+    {
+        auto view = m_input.view.substring_view(start_position, end_position - start_position);
+        if (m_input.regex_options & AllFlags::StringCopyMatches)
+            return { view.to_string(), m_input.line, start_position, m_input.global_offset + start_position }; // create a copy of the original string
+        return { view, m_input.line, start_position, m_input.global_offset + start_position }; // take view to original string
+    }
+
+    void save_capture_groups()
+    {
+        auto is_set = [&](size_t slot) {
+            return m_match_captures[slot] != c_unset_position && m_match_captures[slot + 1] != c_unset_position && m_match_captures[slot] <= m_match_captures[slot + 1];
+        };
+
+        if (m_capture_groups_count > 1) {
+            while (m_output.capture_group_matches.size() <= m_input.match_index)
+                m_output.capture_group_matches.empend();
+
+            auto& groups = m_output.capture_group_matches.at(m_input.match_index);
+            groups.clear_with_capacity();
+            for (size_t id = 0; id < m_capture_groups_count; ++id) {
+                if (is_set(2 * id))
+                    groups.append(make_match(m_match_captures[2 * id], m_match_captures[2 * id + 1]));
+                else
+                    groups.empend();
+            }
+        }
+
+        if (m_named_capture_groups_count > 0) {
+            while (m_output.named_capture_group_matches.size() <= m_input.match_index)
+                m_output.named_capture_group_matches.empend();
+
+            auto& groups = m_output.named_capture_group_matches.at(m_input.match_index);
+            groups.clear();
+            for (size_t i = 0; i < m_capture_group_names.size(); ++i) {
+                auto slot = 2 * (m_capture_groups_count + i);
+                if (is_set(slot))
+                    groups.set(m_capture_group_names[i], make_match(m_match_captures[slot], m_match_captures[slot + 1]));
+            }
+        }
+    }
+
+    const ByteCode& m_bytecode;
+    const MatchInput& m_input;
+    MatchOutput& m_output;
+    size_t m_capture_groups_count { 0 };
+    size_t m_named_capture_groups_count { 0 };
+    Vector<StringView> m_capture_group_names;
+
+    Vector<size_t> m_visited_in_step;
+    size_t m_step { 0 };
+    bool m_found_match_in_step { false };
+
+    Optional<size_t> m_match_end_position;
+    Vector<size_t> m_match_captures;
+};
+
+template<class Parser>
+bool Matcher<Parser>::execute_as_automaton(const MatchInput& input, MatchState& state, MatchOutput& output) const
+{
+    auto& parser_result = m_pattern.parser_result;
+    Automaton automaton(parser_result.bytecode, input, output, parser_result.capture_groups_count, parser_result.named_capture_groups_count);
+    return automaton.run(state);
+}
+
 template class Matcher<PosixExtendedParser>;
 template class Regex<PosixExtendedParser>;
 
@@ -64,11 +64,7 @@ template<class Parser>
 class Matcher final {
 
 public:
-    Matcher(const Regex<Parser>& pattern, Optional<typename ParserTraits<Parser>::OptionsType> regex_options = {})
-        : m_pattern(pattern)
-        , m_regex_options(regex_options.value_or({}))
-    {
-    }
+    Matcher(const Regex<Parser>& pattern, Optional<typename ParserTraits<Parser>::OptionsType> regex_options = {});
     ~Matcher() = default;
 
     RegexResult match(const RegexStringView&, Optional<typename ParserTraits<Parser>::OptionsType> = {}) const;
@@ -82,9 +78,12 @@ public:
 private:
     Optional<bool> execute(const MatchInput& input, MatchState& state, MatchOutput& output, size_t recursion_level) const;
     ALWAYS_INLINE Optional<bool> execute_low_prio_forks(const MatchInput& input, MatchState& original_state, MatchOutput& output, Vector<MatchState> states, size_t recursion_level) const;
+    Optional<bool> execute_from_start(MatchInput& input, MatchState& state, MatchOutput& output) const;
+    bool execute_as_automaton(const MatchInput& input, MatchState& state, MatchOutput& output) const;
 
     const Regex<Parser>& m_pattern;
     const typename ParserTraits<Parser>::OptionsType m_regex_options;
+    bool m_can_execute_as_automaton { false };
 };
 
 template<class Parser>
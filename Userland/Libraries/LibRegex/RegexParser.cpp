@@ -166,13 +166,24 @@ Parser::Result Parser::parse(Optional<AllOptions> regex_options)
 #if REGEX_DEBUG
     fprintf(stderr, "[PARSER] Produced bytecode with %lu entries (opcodes + arguments)\n", m_parser_state.bytecode.size());
 #endif
+
+    String literal_prefix;
+    Optional<Array<bool, 256>> first_bytes;
+    if (!has_error()) {
+        literal_prefix = m_parser_state.bytecode.literal_prefix();
+        if (literal_prefix.is_empty())
+            first_bytes = m_parser_state.bytecode.first_bytes();
+    }
+
     return {
         move(m_parser_state.bytecode),
         move(m_parser_state.capture_groups_count),
         move(m_parser_state.named_capture_groups_count),
         move(m_parser_state.match_length_minimum),
         move(m_parser_state.error),
-        move(m_parser_state.error_token)
+        move(m_parser_state.error_token),
+        move(literal_prefix),
+        move(first_bytes)
     };
 }
 
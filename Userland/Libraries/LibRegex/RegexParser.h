@@ -67,6 +67,8 @@ public:
         size_t match_length_minimum;
         Error error;
         Token error_token;
+        String literal_prefix {};
+        Optional<Array<bool, 256>> first_bytes {};
     };
 
     explicit Parser(Lexer& lexer)
@@ -29,7 +29,7 @@
 #include <LibRegex/Regex.h>
 #include <stdio.h>
 
-#ifndef REGEX_DEBUG
+#if !REGEX_DEBUG
 
 #    define BENCHMARK_LOOP_ITERATIONS 100000
 
@@ -986,6 +986,84 @@ BENCHMARK_CASE(simple_notbol_noteol_benchmark_reference_stdcpp)
 }
 #    endif
 
+#    if defined(REGEX_BENCHMARK_OUR)
+BENCHMARK_CASE(pathological_alternation_benchmark)
+{
+    // Every 'a' can be matched by either alternative, so a backtracking matcher tries 2^n paths.
+    Regex<ECMA262> re("^(a|a)*b$");
+    String subject = String::repeated('a', 25);
+    for (size_t i = 0; i < BENCHMARK_LOOP_ITERATIONS / 100; ++i) {
+        EXPECT_EQ(re.match(subject).success, false);
+    }
+}
+#    endif
+
+#    if defined(REGEX_BENCHMARK_OUR)
+BENCHMARK_CASE(pathological_nested_star_benchmark)
+{
+    Regex<PosixExtended> re("^(a*)*b$");
+    String subject = String::repeated('a', 25);
+    for (size_t i = 0; i < BENCHMARK_LOOP_ITERATIONS / 100; ++i) {
+        EXPECT_EQ(re.match(subject).success, false);
+    }
+}
+#    endif
+
+#    if defined(REGEX_BENCHMARK_OTHER)
+BENCHMARK_CASE(pathological_nested_star_benchmark_reference_stdcpp)
+{
+    std::regex re("^(a*)*b$", std::regex_constants::extended);
+    std::string subject(25, 'a');
+    std::cmatch m;
+    for (size_t i = 0; i < BENCHMARK_LOOP_ITERATIONS / 100; ++i) {
+        EXPECT_EQ(std::regex_match(subject.c_str(), m, re), false);
+    }
+}
+#    endif
+
+#    if defined(REGEX_BENCHMARK_OUR)
+BENCHMARK_CASE(long_repetition_benchmark)
+{
+    Regex<ECMA262> re("^(a|b)*c$");
+    StringBuilder builder;
+    for (size_t i = 0; i < 5000; ++i)
+        builder.append("ab");
+    builder.append('c');
+    String subject = builder.to_string();
+    for (size_t i = 0; i < BENCHMARK_LOOP_ITERATIONS / 1000; ++i) {
+        EXPECT_EQ(re.match(subject).success, true);
+    }
+}
+#    endif
+
+#    if defined(REGEX_BENCHMARK_OUR)
+BENCHMARK_CASE(literal_prefix_search_benchmark)
+{
+    Regex<ECMA262> re("needle(s|d)");
+    StringBuilder builder;
+    for (size_t i = 0; i < 1000; ++i)
+        builder.append("haystack needle ");
+    builder.append("needled");
+    String subject = builder.to_string();
+    for (size_t i = 0; i < BENCHMARK_LOOP_ITERATIONS / 1000; ++i) {
+        EXPECT_EQ(re.search(subject).success, true);
+    }
+}
+
+BENCHMARK_CASE(first_bytes_search_benchmark)
+{
+    Regex<ECMA262> re("[0-9]+");
+    StringBuilder builder;
+    for (size_t i = 0; i < 1000; ++i)
+        builder.append("no digits in here ");
+    builder.append("42");
+    String subject = builder.to_string();
+    for (size_t i = 0; i < BENCHMARK_LOOP_ITERATIONS / 1000; ++i) {
+        EXPECT_EQ(re.search(subject).success, true);
+    }
+}
+#    endif
+
 #endif
 
 TEST_MAIN(Regex)
@@ -582,6 +582,71 @@ TEST_CASE(ECMA262_match)
     }
 }
 
+TEST_CASE(ECMA262_match_without_backtracking)
+{
+    // These would take exponential time (or run out of recursion) in the backtracking VM.
+    Regex<ECMA262> re("(a|a)*b");
+    EXPECT_EQ(re.parser_result.error, Error::NoError);
+    EXPECT_EQ(re.match(String::repeated('a', 40)).success, false);
+    EXPECT_EQ(re.match(String::formatted("{}b", String::repeated('a', 40))).success, true);
+
+    Regex<ECMA262> nested_star("(a*)*b");
+    EXPECT_EQ(nested_star.match(String::repeated('a', 40)).success, false);
+
+    Regex<ECMA262> long_subject("(a|b)*c");
+    StringBuilder builder;
+    for (size_t i = 0; i < 10000; ++i)
+        builder.append("ab");
+    builder.append('c');
+    EXPECT_EQ(long_subject.match(builder.to_string()).success, true);
+
+    // Only the groups on the path that matched are captured, not those from the abandoned attempts.
+    Regex<ECMA262> captures("^(?:(a|a)*b|(a*)c)$");
+    RegexResult result;
+    auto subject = String::formatted("{}c", String::repeated('a', 30));
+    EXPECT_EQ(captures.match(subject, result), true);
+    EXPECT_EQ(result.capture_group_matches.at(0).size(), 1u);
+    EXPECT_EQ(result.capture_group_matches.at(0).at(0).view, subject.substring_view(0, 30));
+}
+
+TEST_CASE(ECMA262_skip_to_possible_match)
+{
+    Regex<ECMA262> prefix("foo(bar|baz)");
+    EXPECT_EQ(prefix.parser_result.literal_prefix, "foo");
+    RegexResult result;
+    EXPECT_EQ(prefix.search("xfoo foobaz fooba foobar", result), true);
+    EXPECT_EQ(result.count, 2u);
+    EXPECT_EQ(result.matches.at(0).view, "foobaz");
+    EXPECT_EQ(result.matches.at(0).column, 5u);
+    EXPECT_EQ(result.matches.at(1).view, "foobar");
+    EXPECT_EQ(result.matches.at(1).column, 18u);
+    EXPECT_EQ(result.capture_group_matches.at(1).at(0).view, "bar");
+
+    Regex<ECMA262> first_bytes("[0-9]+|x");
+    EXPECT_EQ(first_bytes.parser_result.literal_prefix, "");
+    EXPECT(first_bytes.parser_result.first_bytes.has_value());
+    EXPECT_EQ(first_bytes.search("abc 12 def x 345", result), true);
+    EXPECT_EQ(result.count, 3u);
+    EXPECT_EQ(result.matches.at(0).view, "12");
+    EXPECT_EQ(result.matches.at(1).view, "x");
+    EXPECT_EQ(result.matches.at(2).view, "345");
+
+    // Patterns that can match the empty string can match anywhere.
+    Regex<ECMA262> optional("a*");
+    EXPECT(!optional.parser_result.first_bytes.has_value());
+
+    // A group that didn't take part in the match still gets an entry.
+    Regex<ECMA262> unused_group("x(a)?|b");
+    EXPECT_EQ(unused_group.search("cb", result), true);
+    EXPECT_EQ(result.capture_group_matches.size(), 1u);
+    EXPECT_EQ(result.capture_group_matches.at(0).size(), 0u);
+
+    // Case-insensitive searches don't skip ahead.
+    Regex<ECMA262> insensitive("foo", ECMAScriptFlags::Insensitive);
+    EXPECT_EQ(insensitive.search("xFOO", result), true);
+    EXPECT_EQ(result.matches.at(0).column, 1u);
+}
+
 TEST_CASE(replace)
 {
     struct _test {
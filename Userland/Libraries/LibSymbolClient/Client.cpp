@@ -24,6 +24,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/HashMap.h>
 #include <AK/JsonArray.h>
 #include <AK/JsonObject.h>
 #include <AK/JsonValue.h>
@@ -62,6 +63,44 @@ Optional<Symbol> Client::symbolicate(const String& path, FlatPtr address)
     };
 }
 
+Vector<Optional<Symbol>> Client::symbolicate(const Vector<SymbolicationRequest>& requests)
+{
+    Vector<String> paths;
+    HashMap<String, u32> path_indices_by_path;
+    Vector<u32> path_indices;
+    Vector<u32> addresses;
+    path_indices.ensure_capacity(requests.size());
+    addresses.ensure_capacity(requests.size());
+    for (auto& request : requests) {
+        auto path_index = path_indices_by_path.get(request.path);
+        if (!path_index.has_value()) {
+            path_index = paths.size();
+            path_indices_by_path.set(request.path, path_index.value());
+            paths.append(request.path);
+        }
+        path_indices.unchecked_append(path_index.value());
+        addresses.unchecked_append(request.address);
+    }
+
+    auto response = send_sync<Messages::SymbolServer::SymbolicateBatch>(paths, path_indices, addresses);
+
+    Vector<Optional<Symbol>> symbols;
+    symbols.ensure_capacity(requests.size());
+    for (size_t i = 0; i < requests.size(); ++i) {
+        if (!response->successes()[i]) {
+            symbols.unchecked_append({});
+            continue;
+        }
+        symbols.unchecked_append(Symbol {
+            .address = requests[i].address,
+            .name = response->names()[i],
+            .offset = response->offsets()[i],
+            .filename = response->filenames()[i],
+            .line_number = response->lines()[i] });
+    }
+    return symbols;
+}
+
 Vector<Symbol> symbolicate_thread(pid_t pid, pid_t tid)
 {
     struct RegionWithSymbols {
@@ -141,9 +180,8 @@ Vector<Symbol> symbolicate_thread(pid_t pid, pid_t tid)
         }
     }
 
-    auto client = SymbolClient::Client::construct();
-
     Vector<Symbol> symbols;
+    Vector<SymbolicationRequest> requests;
 
     for (auto address : stack) {
         const RegionWithSymbols* found_region = nullptr;
@@ -165,15 +203,20 @@ Vector<Symbol> symbolicate_thread(pid_t pid, pid_t tid)
         else
             adjusted_address = address;
 
-        auto result = client->symbolicate(found_region->path, adjusted_address);
-        if (!result.has_value()) {
-            symbols.append(Symbol {
-                .address = address,
-            });
-            continue;
-        }
+        symbols.append(Symbol {
+            .address = address,
+        });
+        requests.append({ found_region->path, adjusted_address });
+    }
 
-        symbols.append(result.value());
+    if (requests.is_empty())
+        return symbols;
+
+    auto client = SymbolClient::Client::construct();
+    auto results = client->symbolicate(requests);
+    for (size_t i = 0; i < results.size(); ++i) {
+        if (results[i].has_value())
+            symbols[i] = results[i].value();
     }
     return symbols;
 }
@@ -40,6 +40,11 @@ struct Symbol {
     u32 line_number { 0 };
 };
 
+struct SymbolicationRequest {
+    String path;
+    FlatPtr address { 0 };
+};
+
 Vector<Symbol> symbolicate_thread(pid_t pid, pid_t tid);
 
 class Client
@@ -51,6 +56,8 @@ public:
     virtual void handshake() override;
 
     Optional<Symbol> symbolicate(const String& path, FlatPtr address);
+    // Symbolicates all of the addresses with a single request.
+    Vector<Optional<Symbol>> symbolicate(const Vector<SymbolicationRequest>&);
 
 private:
     Client();
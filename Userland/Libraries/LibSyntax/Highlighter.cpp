@@ -24,6 +24,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/StringBuilder.h>
 #include <LibGUI/TextEditor.h>
 #include <LibGfx/Color.h>
 #include <LibSyntax/Highlighter.h>
@@ -97,13 +98,18 @@ void Highlighter::highlight_matching_token_pair()
     };
 
     auto pairs = matching_token_pairs();
+    auto cursor = m_client->get_cursor();
 
     for (size_t i = 0; i < document.spans().size(); ++i) {
         auto& span = const_cast<GUI::TextDocumentSpan&>(document.spans().at(i));
         auto token_type = span.data;
 
+        // Only spans right at the cursor can be part of a pair; don't bother asking about the others.
+        if (span.range.start().line() != cursor.line() && span.range.end().line() != cursor.line())
+            continue;
+
         for (auto& pair : pairs) {
-            if (token_types_equal(token_type, pair.open) && span.range.start() == m_client->get_cursor()) {
+            if (token_types_equal(token_type, pair.open) && span.range.start() == cursor) {
                 auto buddy = find_span_of_type(i, pair.close, pair.open, Direction::Forward);
                 if (buddy.has_value())
                     make_buddies(i, buddy.value());
@@ -115,7 +121,7 @@ void Highlighter::highlight_matching_token_pair()
         right_of_end.set_column(right_of_end.column() + 1);
 
         for (auto& pair : pairs) {
-            if (token_types_equal(token_type, pair.close) && right_of_end == m_client->get_cursor()) {
+            if (token_types_equal(token_type, pair.close) && right_of_end == cursor) {
                 auto buddy = find_span_of_type(i, pair.open, pair.close, Direction::Backward);
                 if (buddy.has_value())
                     make_buddies(i, buddy.value());
@@ -134,6 +140,7 @@ void Highlighter::attach(HighlighterClient& client)
 void Highlighter::detach()
 {
     m_client = nullptr;
+    m_line_states.clear();
 }
 
 void Highlighter::cursor_did_change()
@@ -150,4 +157,160 @@ void Highlighter::cursor_did_change()
     highlight_matching_token_pair();
 }
 
+// Clears can_restart_lexing for the lines in [first_line, end_line) that a span continues into.
+template<typename LineStates>
+static void mark_continued_lines(const Vector<GUI::TextDocumentSpan>& spans, LineStates& line_states, size_t first_line, size_t end_line)
+{
+    for (auto& span : spans) {
+        if (span.is_skippable)
+            continue;
+        for (size_t line = max(span.range.start().line() + 1, first_line); line <= span.range.end().line() && line < end_line; ++line)
+            line_states[line].can_restart_lexing = false;
+    }
+}
+
+void Highlighter::remember_line_states()
+{
+    auto& document = m_client->get_document();
+    m_line_states.clear_with_capacity();
+    m_line_states.ensure_capacity(document.line_count());
+    for (size_t i = 0; i < document.line_count(); ++i)
+        m_line_states.unchecked_append({ document.line(i).revision(), true });
+    mark_continued_lines(m_client->spans(), m_line_states, 0, m_line_states.size());
+}
+
+void Highlighter::rehighlight_changed_lines(const Palette& palette)
+{
+    // Setting the document's text throws away its spans, so there's nothing to patch up then.
+    if (!supports_incremental_highlighting() || m_line_states.is_empty() || m_client->spans().is_empty()) {
+        rehighlight(palette);
+        remember_line_states();
+        return;
+    }
+
+    auto& document = m_client->get_document();
+    size_t old_line_count = m_line_states.size();
+    size_t new_line_count = document.line_count();
+
+    Vector<LineState> new_line_states;
+    new_line_states.ensure_capacity(new_line_count);
+    for (size_t i = 0; i < new_line_count; ++i)
+        new_line_states.unchecked_append({ document.line(i).revision(), true });
+
+    // The lines in [first_changed_line, end of changed lines) differ, everything before and after is the same text.
+    size_t common_line_count = min(old_line_count, new_line_count);
+    size_t first_changed_line = 0;
+    while (first_changed_line < common_line_count && m_line_states[first_changed_line].revision == new_line_states[first_changed_line].revision)
+        ++first_changed_line;
+    if (first_changed_line == common_line_count && old_line_count == new_line_count)
+        return;
+    size_t unchanged_tail_line_count = 0;
+    while (unchanged_tail_line_count < common_line_count - first_changed_line
+        && m_line_states[old_line_count - unchanged_tail_line_count - 1].revision == new_line_states[new_line_count - unchanged_tail_line_count - 1].revision)
+        ++unchanged_tail_line_count;
+    size_t end_of_changed_lines = new_line_count - unchanged_tail_line_count;
+    ssize_t line_delta = (ssize_t)new_line_count - (ssize_t)old_line_count;
+
+    size_t restart_line = min(first_changed_line, old_line_count - 1);
+    while (restart_line > 0 && !m_line_states[restart_line].can_restart_lexing)
+        --restart_line;
+    for (size_t i = 0; i < restart_line; ++i)
+        new_line_states[i].can_restart_lexing = m_line_states[i].can_restart_lexing;
+
+    // Lex a growing run of lines until we reach a line past the edit where both the old and the new
+    // highlight could restart the lexer. From there on, the old spans are still correct.
+    Vector<GUI::TextDocumentSpan> new_spans;
+    size_t converged_line = new_line_count;
+    size_t end_line = min(new_line_count, max(end_of_changed_lines, restart_line) + 32);
+    for (;;) {
+        StringBuilder builder;
+        for (size_t i = restart_line; i < end_line; ++i) {
+            auto& line = document.line(i);
+            if (line.is_materialized())
+                builder.append(line.view());
+            else
+                builder.append(line.unmaterialized_text());
+            if (i != new_line_count - 1)
+                builder.append('\n');
+        }
+        new_spans = spans_for_text(builder.string_view(), restart_line, palette);
+
+        for (size_t i = restart_line; i < end_line; ++i)
+            new_line_states[i].can_restart_lexing = true;
+        mark_continued_lines(new_spans, new_line_states, restart_line, end_line);
+
+        if (end_line == new_line_count)
+            break;
+        // The last line we lexed may be missing spans that continue past it, so don't converge there.
+        for (size_t line = max(end_of_changed_lines, restart_line); line + 1 < end_line; ++line) {
+            if (new_line_states[line].can_restart_lexing && m_line_states[line - line_delta].can_restart_lexing) {
+                converged_line = line;
+                break;
+            }
+        }
+        if (converged_line != new_line_count)
+            break;
+        end_line = min(new_line_count, restart_line + (end_line - restart_line) * 2);
+    }
+
+    auto& spans = m_client->spans();
+    if (m_has_brace_buddies) {
+        for (auto& buddy : m_brace_buddies) {
+            if (buddy.index >= 0 && buddy.index < static_cast<int>(spans.size()))
+                spans[buddy.index] = buddy.span_backup;
+        }
+        m_has_brace_buddies = false;
+    }
+
+    // Spans are sorted, so find the old ones that start in [restart_line, converged line) and swap in the new ones.
+    auto first_span_starting_at_or_after = [&](size_t line) {
+        size_t low = 0;
+        size_t high = spans.size();
+        while (low < high) {
+            size_t middle = low + (high - low) / 2;
+            if (spans[middle].range.start().line() < line)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        return low;
+    };
+    size_t replace_start = first_span_starting_at_or_after(restart_line);
+    size_t replace_end = first_span_starting_at_or_after(converged_line - line_delta);
+    size_t new_span_count = 0;
+    while (new_span_count < new_spans.size() && new_spans[new_span_count].range.start().line() < converged_line)
+        ++new_span_count;
+
+    // Only whitespace can continue into the restart line, and the new spans cover that part again.
+    if (replace_start > 0 && spans[replace_start - 1].range.end().line() >= restart_line)
+        spans[replace_start - 1].range.set_end({ restart_line - 1, document.line(restart_line - 1).length() });
+
+    size_t replaced_count = replace_end - replace_start;
+    if (new_span_count > replaced_count) {
+        size_t growth = new_span_count - replaced_count;
+        size_t old_size = spans.size();
+        spans.resize(old_size + growth);
+        for (size_t i = old_size; i-- > replace_end;)
+            spans[i + growth] = spans[i];
+    } else {
+        spans.remove(replace_start + new_span_count, replaced_count - new_span_count);
+    }
+    for (size_t i = 0; i < new_span_count; ++i)
+        spans[replace_start + i] = new_spans[i];
+    if (line_delta != 0) {
+        for (size_t i = replace_start + new_span_count; i < spans.size(); ++i) {
+            auto& range = spans[i].range;
+            range.set_start({ range.start().line() + line_delta, range.start().column() });
+            range.set_end({ range.end().line() + line_delta, range.end().column() });
+        }
+    }
+
+    for (size_t i = converged_line; i < new_line_count; ++i)
+        new_line_states[i].can_restart_lexing = m_line_states[i - line_delta].can_restart_lexing;
+    m_line_states = move(new_line_states);
+
+    highlight_matching_token_pair();
+    m_client->do_update();
+}
+
 }
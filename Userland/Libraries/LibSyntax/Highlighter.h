@@ -59,6 +59,11 @@ public:
     virtual void rehighlight(const Palette&) = 0;
     virtual void highlight_matching_token_pair();
 
+    // Re-lexes only the lines that changed since the last call, starting from the nearest earlier line
+    // where lexing can restart and stopping once the lexer state matches the previous highlight again.
+    // Falls back to rehighlight() if the highlighter doesn't support that, or hasn't highlighted yet.
+    void rehighlight_changed_lines(const Palette&);
+
     virtual bool is_identifier(void*) const { return false; };
     virtual bool is_navigatable(void*) const { return false; };
 
@@ -80,6 +85,12 @@ protected:
     virtual Vector<MatchingTokenPair> matching_token_pairs() const = 0;
     virtual bool token_types_equal(void*, void*) const = 0;
 
+    // Highlighters whose lexer carries no state from one line to the next (other than through tokens
+    // that span several lines) can lex any run of whole lines on its own. They override these, and
+    // spans_for_text() returns the spans for text as if it started at first_line of the document.
+    virtual bool supports_incremental_highlighting() const { return false; }
+    virtual Vector<GUI::TextDocumentSpan> spans_for_text(const StringView&, size_t, const Palette&) { VERIFY_NOT_REACHED(); }
+
     struct BuddySpan {
         int index { -1 };
         GUI::TextDocumentSpan span_backup;
@@ -87,6 +98,18 @@ protected:
 
     bool m_has_brace_buddies { false };
     BuddySpan m_brace_buddies[2];
+
+private:
+    struct LineState {
+        u64 revision { 0 };
+        // No span other than whitespace continues into this line from the previous one,
+        // so the lexer can start over at the beginning of it.
+        bool can_restart_lexing { true };
+    };
+
+    void remember_line_states();
+
+    Vector<LineState> m_line_states;
 };
 
 }
@@ -27,25 +27,71 @@
 #include <Kernel/API/Syscall.h>
 #include <LibSystem/syscall.h>
 
+// SYSENTER is used whenever the CPU supports it, with `int 0x82` as the fallback.
+// This mirrors the CPUFeature::SEP detection in the kernel, which only sets up the
+// SYSENTER MSRs when that feature is present.
+static bool cpu_has_sysenter()
+{
+    static int s_has_sysenter = -1;
+    if (s_has_sysenter < 0) {
+        u32 eax, ebx, ecx, edx;
+        asm volatile("cpuid"
+                     : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+                     : "a"(1), "c"(0));
+        u32 stepping = eax & 0xf;
+        u32 model = (eax >> 4) & 0xf;
+        u32 family = (eax >> 8) & 0xf;
+        // The Pentium Pro reports SEP without actually supporting SYSENTER.
+        s_has_sysenter = (edx & (1 << 11)) && !(family == 6 && model < 3 && stepping < 3);
+    }
+    return s_has_sysenter;
+}
+
+static inline uintptr_t invoke_sysenter(uintptr_t function, uintptr_t arg0, uintptr_t arg1, uintptr_t arg2)
+{
+    // The kernel returns to the address in %esi with the stack pointer in %edi,
+    // and SYSEXIT clobbers %ecx and %edx.
+    uintptr_t result;
+    asm volatile(
+        "call 1f\n"
+        "1: popl %%esi\n"
+        "addl $(2f - 1b), %%esi\n"
+        "movl %%esp, %%edi\n"
+        "sysenter\n"
+        "2:\n"
+        : "=a"(result), "+d"(arg0), "+c"(arg1)
+        : "a"(function), "b"(arg2)
+        : "esi", "edi", "memory", "cc");
+    return result;
+}
+
 extern "C" {
 
 uintptr_t syscall0(uintptr_t function)
 {
+    if (cpu_has_sysenter())
+        return invoke_sysenter(function, 0, 0, 0);
     return Syscall::invoke((Syscall::Function)function);
 }
 
 uintptr_t syscall1(uintptr_t function, uintptr_t arg0)
 {
+    if (cpu_has_sysenter())
+        return invoke_sysenter(function, arg0, 0, 0);
     return Syscall::invoke((Syscall::Function)function, arg0);
 }
 
 uintptr_t syscall2(uintptr_t function, uintptr_t arg0, uintptr_t arg1)
 {
+    if (cpu_has_sysenter())
+        return invoke_sysenter(function, arg0, arg1, 0);
     return Syscall::invoke((Syscall::Function)function, arg0, arg1);
 }
 
 uintptr_t syscall3(uintptr_t function, uintptr_t arg0, uintptr_t arg1, uintptr_t arg2)
 {
+    if (cpu_has_sysenter())
+        return invoke_sysenter(function, arg0, arg1, arg2);
     return Syscall::invoke((Syscall::Function)function, arg0, arg1, arg2);
 }
 }
@@ -30,6 +30,7 @@
 
 #include <LibCore/Timer.h>
 #include <LibCrypto/ASN1/DER.h>
+#include <LibCrypto/Curves/X25519.h>
 #include <LibCrypto/PK/Code/EMSA_PSS.h>
 #include <LibTLS/TLSv12.h>
 
@@ -88,6 +89,9 @@ ssize_t TLSv12::handle_hello(ReadonlyBytes buffer, WritePacketStage& write_packe
         return (i8)Error::NeedMoreData;
     }
 
+    // If the server echoes the session ID we offered, it agreed to resume that session.
+    bool session_id_matches = session_length && session_length == m_context.session_id_size && !memcmp(m_context.session_id, buffer.offset_pointer(res), session_length);
+
     if (session_length && session_length <= 32) {
         memcpy(m_context.session_id, buffer.offset_pointer(res), session_length);
         m_context.session_id_size = session_length;
@@ -114,6 +118,8 @@ ssize_t TLSv12::handle_hello(ReadonlyBytes buffer, WritePacketStage& write_packe
     m_context.cipher = cipher;
     dbgln_if(TLS_DEBUG, "Cipher: {}", (u16)cipher);
 
+    m_context.session_resumed = session_id_matches && !m_context.resumable_master_key.is_empty() && cipher == m_context.resumable_cipher;
+
     // The handshake hash function is _always_ SHA256
     m_context.handshake_hash.initialize(Crypto::Hash::HashKind::SHA256);
 
@@ -197,6 +203,15 @@ ssize_t TLSv12::handle_hello(ReadonlyBytes buffer, WritePacketStage& write_packe
         }
     }
 
+    if (m_context.session_resumed) {
+        // The server skips straight to ChangeCipherSpec and Finished, using the keys we agreed on last time.
+        dbgln_if(TLS_DEBUG, "Resuming session with {}", m_context.SNI);
+        m_context.master_key = m_context.resumable_master_key;
+        m_context.connection_status = ConnectionStatus::KeyExchange;
+        expand_key();
+    }
+    m_context.resumable_master_key.clear();
+
     return res;
 }
 
@@ -222,30 +237,57 @@ ssize_t TLSv12::handle_finished(ReadonlyBytes buffer, WritePacketStage& write_pa
         return (i8)Error::BrokenPacket;
     }
 
-    if (size < buffer.size() - index) {
+    if (buffer.size() - index < size) {
         dbgln_if(TLS_DEBUG, "not enough data after length: {} > {}", size, buffer.size() - index);
         return (i8)Error::NeedMoreData;
     }
 
-// TODO: Compare Hashes
-#if TLS_DEBUG
-    dbgln("FIXME: handle_finished :: Check message validity");
-#endif
-    m_context.connection_status = ConnectionStatus::Established;
+    u8 verify_data[12];
+    auto verify_data_buffer = Bytes { verify_data, sizeof(verify_data) };
+    auto dummy = ByteBuffer::create_zeroed(0);
+    auto digest = m_context.handshake_hash.peek();
+    auto hashbuf = ReadonlyBytes { digest.immutable_data(), m_context.handshake_hash.digest_size() };
+    pseudorandom_function(verify_data_buffer, m_context.master_key, (const u8*)"server finished", 15, hashbuf, dummy);
 
-    if (m_handshake_timeout_timer) {
-        // Disable the handshake timeout timer as handshake has been established.
-        m_handshake_timeout_timer->stop();
-        m_handshake_timeout_timer->remove_from_parent();
-        m_handshake_timeout_timer = nullptr;
+    if (memcmp(verify_data, buffer.offset_pointer(index), sizeof(verify_data)) != 0) {
+        dbgln("server finished message does not match our handshake");
+        return (i8)Error::NotVerified;
     }
 
-    if (on_tls_ready_to_write)
-        on_tls_ready_to_write(*this);
+    if (m_context.session_resumed) {
+        // When resuming, the server finishes first, and we still have to send our own Finished message.
+        write_packets = WritePacketStage::Finished;
+    } else {
+        did_complete_handshake();
+    }
 
     return index + size;
 }
 
+ssize_t TLSv12::handle_new_session_ticket(ReadonlyBytes buffer)
+{
+    if (buffer.size() < 3)
+        return (i8)Error::NeedMoreData;
+
+    size_t size = buffer[0] * 0x10000 + buffer[1] * 0x100 + buffer[2];
+    if (buffer.size() - 3 < size)
+        return (i8)Error::NeedMoreData;
+
+    // u32 ticket_lifetime_hint, followed by opaque ticket<0..2^16-1>
+    if (size < 6)
+        return (i8)Error::BrokenPacket;
+    u32 lifetime_hint = AK::convert_between_host_and_network_endian(*(const u32*)buffer.offset_pointer(3));
+    u16 ticket_length = AK::convert_between_host_and_network_endian(*(const u16*)buffer.offset_pointer(7));
+    if (size - 6 < ticket_length)
+        return (i8)Error::BrokenPacket;
+
+    m_context.session_ticket = ByteBuffer::copy(buffer.offset_pointer(9), ticket_length);
+    m_context.session_ticket_lifetime_hint = lifetime_hint;
+    dbgln_if(TLS_DEBUG, "Received a {} byte session ticket, valid for {} seconds", ticket_length, lifetime_hint);
+
+    return size + 3;
+}
+
 void TLSv12::build_random(PacketBuilder& builder)
 {
     u8 random_bytes[48];
@@ -302,6 +344,41 @@ void TLSv12::build_random(PacketBuilder& builder)
     builder.append(outbuf);
 }
 
+void TLSv12::build_ecdhe_public_key(PacketBuilder& builder)
+{
+    using Crypto::Curves::X25519;
+
+    u8 private_key[X25519::key_size];
+    u8 public_key[X25519::key_size];
+    u8 shared_secret[X25519::key_size];
+
+    X25519::generate_private_key({ private_key, sizeof(private_key) });
+    X25519::compute_public_key({ private_key, sizeof(private_key) }, { public_key, sizeof(public_key) });
+
+    if (m_context.server_ecdhe_public_key.size() != X25519::key_size
+        || !X25519::compute_shared_secret({ private_key, sizeof(private_key) }, m_context.server_ecdhe_public_key, { shared_secret, sizeof(shared_secret) })) {
+        dbgln("could not agree on a shared secret with the server");
+        alert(AlertLevel::Critical, AlertDescription::IllegalParameter);
+        return;
+    }
+
+    m_context.premaster_key = ByteBuffer::copy(shared_secret, sizeof(shared_secret));
+#if TLS_DEBUG
+    dbgln("PreMaster secret");
+    print_buffer(m_context.premaster_key);
+#endif
+
+    // Unlike with RSA, the master secret is always 48 bytes, whatever the size of the premaster secret.
+    if (!compute_master_secret(48)) {
+        dbgln("oh noes we could not derive a master key :(");
+        return;
+    }
+
+    builder.append_u24(X25519::key_size + 1);
+    builder.append((u8)X25519::key_size);
+    builder.append(public_key, sizeof(public_key));
+}
+
 ssize_t TLSv12::handle_payload(ReadonlyBytes vbuffer)
 {
     if (m_context.connection_status == ConnectionStatus::Established) {
@@ -373,6 +450,18 @@ ssize_t TLSv12::handle_payload(ReadonlyBytes vbuffer)
             dbgln("unsupported: DTLS");
             payload_res = (i8)Error::UnexpectedMessage;
             break;
+        case NewSessionTicket:
+            // This is sent right before the server's ChangeCipherSpec, whether the session was resumed or not.
+            if (m_context.is_server || m_context.connection_status != ConnectionStatus::KeyExchange) {
+                dbgln("unexpected new session ticket message");
+                payload_res = (i8)Error::UnexpectedMessage;
+                break;
+            }
+#if TLS_DEBUG
+            dbgln("new session ticket");
+#endif
+            payload_res = handle_new_session_ticket(buffer.slice(1, payload_size));
+            break;
         case CertificateMessage:
             if (m_context.handshake_messages[4] >= 1) {
                 dbgln("unexpected certificate message");
@@ -542,7 +631,7 @@ ssize_t TLSv12::handle_payload(ReadonlyBytes vbuffer)
                 break;
             }
             case Error::NotVerified: {
-                auto packet = build_alert(true, (u8)AlertDescription::BadRecordMAC);
+                auto packet = build_alert(true, (u8)AlertDescription::DecryptError);
                 write_packet(packet);
                 break;
             }
@@ -646,7 +735,7 @@ ssize_t TLSv12::handle_payload(ReadonlyBytes vbuffer)
                 auto packet = build_finished();
                 write_packet(packet);
             }
-            m_context.connection_status = ConnectionStatus::Established;
+            did_complete_handshake();
             break;
         }
         payload_size++;
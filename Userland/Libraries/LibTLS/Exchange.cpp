@@ -26,6 +26,8 @@
 
 #include <AK/Debug.h>
 #include <LibCrypto/ASN1/DER.h>
+#include <LibCrypto/Curves/X25519.h>
+#include <LibCrypto/NumberTheory/ModularFunctions.h>
 #include <LibCrypto/PK/Code/EMSA_PSS.h>
 #include <LibTLS/TLSv12.h>
 
@@ -255,7 +257,10 @@ ByteBuffer TLSv12::build_client_key_exchange()
 {
     PacketBuilder builder { MessageType::Handshake, m_context.version };
     builder.append((u8)HandshakeType::ClientKeyExchange);
-    build_random(builder);
+    if (is_ecdhe())
+        build_ecdhe_public_key(builder);
+    else
+        build_random(builder);
 
     m_context.connection_status = ConnectionStatus::KeyExchange;
 
@@ -266,10 +271,117 @@ ByteBuffer TLSv12::build_client_key_exchange()
     return packet;
 }
 
-ssize_t TLSv12::handle_server_key_exchange(ReadonlyBytes)
+ssize_t TLSv12::handle_server_key_exchange(ReadonlyBytes buffer)
 {
-    dbgln("FIXME: parse_server_key_exchange");
-    return 0;
+    if (!is_ecdhe()) {
+        dbgln("unexpected server key exchange message for cipher {}", (u16)m_context.cipher);
+        return (i8)Error::UnexpectedMessage;
+    }
+
+    if (buffer.size() < 3)
+        return (i8)Error::NeedMoreData;
+
+    size_t size = buffer[0] * 0x10000 + buffer[1] * 0x100 + buffer[2];
+    if (buffer.size() - 3 < size)
+        return (i8)Error::NeedMoreData;
+
+    auto message = buffer.slice(3, size);
+
+    // ECParameters (u8 curve_type, u16 named_curve) and ECPoint (u8 length, public key)
+    if (message.size() < 4)
+        return (i8)Error::BrokenPacket;
+    auto curve_type = message[0];
+    auto curve = (NamedCurve)AK::convert_between_host_and_network_endian(*(const u16*)message.offset_pointer(1));
+    if (curve_type != 3 || curve != NamedCurve::x25519) {
+        dbgln("server picked an unsupported curve: {} {}", curve_type, (u16)curve);
+        return (i8)Error::NotUnderstood;
+    }
+    size_t public_key_size = message[3];
+    if (public_key_size != Crypto::Curves::X25519::key_size || message.size() < 4 + public_key_size + 4)
+        return (i8)Error::BrokenPacket;
+    auto parameters = message.slice(0, 4 + public_key_size);
+
+    // SignatureAndHashAlgorithm, followed by the signature over both randoms and the parameters
+    auto hash_algorithm = (HashAlgorithm)message[parameters.size()];
+    auto signature_algorithm = (SignatureAlgorithm)message[parameters.size() + 1];
+    u16 signature_length = AK::convert_between_host_and_network_endian(*(const u16*)message.offset_pointer(parameters.size() + 2));
+    if (message.size() - parameters.size() - 4 < signature_length)
+        return (i8)Error::BrokenPacket;
+    auto signature = message.slice(parameters.size() + 4, signature_length);
+
+    if (signature_algorithm != SignatureAlgorithm::RSA) {
+        dbgln("unsupported server key exchange signature algorithm {}", (u8)signature_algorithm);
+        return (i8)Error::UnsupportedCertificate;
+    }
+
+    auto certificate_option = verify_chain_and_get_matching_certificate(m_context.SNI); // if the SNI is empty, we'll make a special case and match *a* leaf certificate.
+    if (!certificate_option.has_value()) {
+        dbgln("certificate verification failed :(");
+        return (i8)Error::BadCertificate;
+    }
+
+    if (!verify_server_key_exchange_signature(m_context.certificates[certificate_option.value()], hash_algorithm, parameters, signature)) {
+        dbgln("server key exchange signature verification failed");
+        return (i8)Error::NotVerified;
+    }
+
+    m_context.server_ecdhe_public_key = ByteBuffer::copy(parameters.slice(4, public_key_size));
+    return size + 3;
+}
+
+bool TLSv12::verify_server_key_exchange_signature(const Certificate& certificate, HashAlgorithm hash_algorithm, ReadonlyBytes parameters, ReadonlyBytes signature)
+{
+    // DER encoded DigestInfo headers (RFC 8017 section 9.2, note 1)
+    static constexpr u8 sha1_digest_info[] { 0x30, 0x21, 0x30, 0x09, 0x06, 0x05, 0x2b, 0x0e, 0x03, 0x02, 0x1a, 0x05, 0x00, 0x04, 0x14 };
+    static constexpr u8 sha256_digest_info[] { 0x30, 0x31, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x01, 0x05, 0x00, 0x04, 0x20 };
+    static constexpr u8 sha512_digest_info[] { 0x30, 0x51, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x03, 0x05, 0x00, 0x04, 0x40 };
+
+    Crypto::Hash::HashKind hash_kind;
+    ReadonlyBytes digest_info;
+    switch (hash_algorithm) {
+    case HashAlgorithm::SHA1:
+        hash_kind = Crypto::Hash::HashKind::SHA1;
+        digest_info = { sha1_digest_info, sizeof(sha1_digest_info) };
+        break;
+    case HashAlgorithm::SHA256:
+        hash_kind = Crypto::Hash::HashKind::SHA256;
+        digest_info = { sha256_digest_info, sizeof(sha256_digest_info) };
+        break;
+    case HashAlgorithm::SHA512:
+        hash_kind = Crypto::Hash::HashKind::SHA512;
+        digest_info = { sha512_digest_info, sizeof(sha512_digest_info) };
+        break;
+    default:
+        dbgln("unsupported server key exchange hash algorithm {}", (u8)hash_algorithm);
+        return false;
+    }
+
+    Crypto::Hash::Manager hash { hash_kind };
+    hash.update(m_context.local_random, sizeof(m_context.local_random));
+    hash.update(m_context.remote_random, sizeof(m_context.remote_random));
+    hash.update(parameters);
+    auto digest = hash.digest();
+    auto digest_size = hash.digest_size();
+
+    // RSASSA-PKCS1-v1_5: the signature must decrypt to 00 01 FF .. FF 00 DigestInfo Digest.
+    auto& public_key = certificate.public_key;
+    auto key_size = signature.size();
+    if (key_size > public_key.length() || key_size < digest_info.size() + digest_size + 11)
+        return false;
+
+    auto encoded_message = ByteBuffer::create_zeroed(key_size);
+    encoded_message[1] = 0x01;
+    auto padding_end = key_size - digest_info.size() - digest_size - 1;
+    for (size_t i = 2; i < padding_end; ++i)
+        encoded_message[i] = 0xff;
+    encoded_message.overwrite(padding_end + 1, digest_info.data(), digest_info.size());
+    encoded_message.overwrite(padding_end + 1 + digest_info.size(), digest.immutable_data(), digest_size);
+
+    auto signature_integer = Crypto::UnsignedBigInteger::import_data(signature.data(), signature.size());
+    if (!(signature_integer < public_key.modulus()))
+        return false;
+    auto message_integer = Crypto::NumberTheory::ModularPower(signature_integer, public_key.public_exponent(), public_key.modulus());
+    return message_integer == Crypto::UnsignedBigInteger::import_data(encoded_message.data(), encoded_message.size());
 }
 
 ssize_t TLSv12::handle_verify(ReadonlyBytes)
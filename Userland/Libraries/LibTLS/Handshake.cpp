@@ -24,9 +24,12 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Debug.h>
 #include <AK/Random.h>
+#include <LibCore/Timer.h>
 #include <LibCrypto/ASN1/DER.h>
 #include <LibCrypto/PK/Code/EMSA_PSS.h>
+#include <LibTLS/SessionCache.h>
 #include <LibTLS/TLSv12.h>
 
 namespace TLS {
@@ -35,6 +38,25 @@ ByteBuffer TLSv12::build_hello()
 {
     fill_with_random(&m_context.local_random, 32);
 
+    // Offer to resume the last session we had with this host, if we still remember it.
+    ByteBuffer session_ticket;
+    if (!m_context.is_server && !m_context.SNI.is_null()) {
+        if (auto session = SessionCache::the().lookup(m_context.SNI); session.has_value()) {
+            m_context.resumable_cipher = session->cipher;
+            m_context.resumable_master_key = session->master_key;
+            session_ticket = session->ticket;
+            if (!session_ticket.is_empty()) {
+                // The server echoes the session ID back if it accepts the ticket (RFC 5077 section 3.4), so make one up.
+                fill_with_random(m_context.session_id, sizeof(m_context.session_id));
+                m_context.session_id_size = sizeof(m_context.session_id);
+            } else {
+                memcpy(m_context.session_id, session->session_id, session->session_id_size);
+                m_context.session_id_size = session->session_id_size;
+            }
+            dbgln_if(TLS_DEBUG, "Offering to resume session with {}", m_context.SNI);
+        }
+    }
+
     auto packet_version = (u16)m_context.version;
     auto version = (u16)m_context.version;
     PacketBuilder builder { MessageType::Handshake, packet_version };
@@ -73,7 +95,11 @@ ByteBuffer TLSv12::build_hello()
     }
 
     // Ciphers
-    builder.append((u16)(5 * sizeof(u16)));
+    builder.append((u16)(9 * sizeof(u16)));
+    builder.append((u16)CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA256);
+    builder.append((u16)CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA);
+    builder.append((u16)CipherSuite::ECDHE_RSA_WITH_AES_256_CBC_SHA);
+    builder.append((u16)CipherSuite::ECDHE_RSA_WITH_AES_128_GCM_SHA256);
     builder.append((u16)CipherSuite::RSA_WITH_AES_128_CBC_SHA256);
     builder.append((u16)CipherSuite::RSA_WITH_AES_256_CBC_SHA256);
     builder.append((u16)CipherSuite::RSA_WITH_AES_128_CBC_SHA);
@@ -92,6 +118,12 @@ ByteBuffer TLSv12::build_hello()
     if (sni_length)
         extension_length += sni_length + 9;
 
+    // supported groups (x25519), EC point formats (uncompressed), signature algorithms (3 of them)
+    extension_length += 8 + 6 + 12;
+
+    // session ticket (empty if we don't have one, to tell the server we'd like one)
+    extension_length += session_ticket.size() + 4;
+
     builder.append((u16)extension_length);
 
     if (sni_length) {
@@ -108,6 +140,34 @@ ByteBuffer TLSv12::build_hello()
         builder.append((const u8*)m_context.SNI.characters(), sni_length);
     }
 
+    // Supported groups extension
+    builder.append((u16)HandshakeExtension::SupportedGroups);
+    builder.append((u16)4);
+    builder.append((u16)2);
+    builder.append((u16)NamedCurve::x25519);
+
+    // EC point formats extension
+    builder.append((u16)HandshakeExtension::ECPointFormats);
+    builder.append((u16)2);
+    builder.append((u8)1);
+    builder.append((u8)0); // uncompressed
+
+    // Signature algorithms extension, the ones we can check in a server key exchange
+    builder.append((u16)HandshakeExtension::SignatureAlgorithms);
+    builder.append((u16)8);
+    builder.append((u16)6);
+    builder.append((u8)HashAlgorithm::SHA256);
+    builder.append((u8)SignatureAlgorithm::RSA);
+    builder.append((u8)HashAlgorithm::SHA512);
+    builder.append((u8)SignatureAlgorithm::RSA);
+    builder.append((u8)HashAlgorithm::SHA1);
+    builder.append((u8)SignatureAlgorithm::RSA);
+
+    // Session ticket extension
+    builder.append((u16)HandshakeExtension::SessionTicket);
+    builder.append((u16)session_ticket.size());
+    builder.append(session_ticket.bytes());
+
     if (alpn_length) {
         // TODO
         VERIFY_NOT_REACHED();
@@ -156,7 +216,8 @@ ByteBuffer TLSv12::build_finished()
     auto outbuffer = Bytes { out, out_size };
     auto dummy = ByteBuffer::create_zeroed(0);
 
-    auto digest = m_context.handshake_hash.digest();
+    // Peek, as the server's Finished message covers our own Finished message too.
+    auto digest = m_context.handshake_hash.peek();
     auto hashbuf = ReadonlyBytes { digest.immutable_data(), m_context.handshake_hash.digest_size() };
     pseudorandom_function(outbuffer, m_context.master_key, (const u8*)"client finished", 15, hashbuf, dummy);
 
@@ -167,6 +228,51 @@ ByteBuffer TLSv12::build_finished()
     return packet;
 }
 
+void TLSv12::did_complete_handshake()
+{
+    m_context.connection_status = ConnectionStatus::Established;
+
+    if (m_handshake_timeout_timer) {
+        // Disable the handshake timeout timer as handshake has been established.
+        m_handshake_timeout_timer->stop();
+        m_handshake_timeout_timer->remove_from_parent();
+        m_handshake_timeout_timer = nullptr;
+    }
+
+    remember_session();
+
+    if (on_tls_ready_to_write)
+        on_tls_ready_to_write(*this);
+}
+
+void TLSv12::remember_session()
+{
+    if (m_context.is_server || m_context.SNI.is_null())
+        return;
+
+    // The session we resumed is still in the cache, unless the server gave us a new ticket for it.
+    if (m_context.session_resumed && m_context.session_ticket.is_empty())
+        return;
+
+    if (!m_context.session_id_size && m_context.session_ticket.is_empty()) {
+        // The server doesn't let us resume sessions.
+        SessionCache::the().forget(m_context.SNI);
+        return;
+    }
+
+    SessionCache::Session session;
+    session.cipher = m_context.cipher;
+    session.master_key = m_context.master_key;
+    memcpy(session.session_id, m_context.session_id, m_context.session_id_size);
+    session.session_id_size = m_context.session_id_size;
+    session.ticket = m_context.session_ticket;
+
+    time_t lifetime = SessionCache::max_lifetime_in_seconds;
+    if (!session.ticket.is_empty() && m_context.session_ticket_lifetime_hint)
+        lifetime = m_context.session_ticket_lifetime_hint;
+    SessionCache::the().store(m_context.SNI, move(session), lifetime);
+}
+
 void TLSv12::alert(AlertLevel level, AlertDescription code)
 {
     auto the_alert = build_alert(level == AlertLevel::Critical, (u8)code);
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Debug.h>
+#include <LibTLS/SessionCache.h>
+
+namespace TLS {
+
+SessionCache& SessionCache::the()
+{
+    static SessionCache cache;
+    return cache;
+}
+
+Optional<SessionCache::Session> SessionCache::lookup(const String& host)
+{
+    auto it = m_sessions.find(host);
+    if (it == m_sessions.end())
+        return {};
+    if (time(nullptr) >= it->value.expires_at) {
+        m_sessions.remove(it);
+        return {};
+    }
+    return it->value;
+}
+
+void SessionCache::store(const String& host, Session session, time_t lifetime_in_seconds)
+{
+    auto now = time(nullptr);
+    session.expires_at = now + min(lifetime_in_seconds, max_lifetime_in_seconds);
+
+    if (!m_sessions.contains(host) && m_sessions.size() >= max_sessions) {
+        // Make room by dropping whichever session would have expired first.
+        auto oldest = m_sessions.begin();
+        for (auto it = m_sessions.begin(); it != m_sessions.end(); ++it) {
+            if (it->value.expires_at < oldest->value.expires_at)
+                oldest = it;
+        }
+        m_sessions.remove(oldest);
+    }
+
+    dbgln_if(TLS_DEBUG, "Remembering session for {} ({} byte ticket)", host, session.ticket.size());
+    m_sessions.set(host, move(session));
+}
+
+void SessionCache::forget(const String& host)
+{
+    m_sessions.remove(host);
+}
+
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/ByteBuffer.h>
+#include <AK/HashMap.h>
+#include <AK/Optional.h>
+#include <AK/String.h>
+#include <LibTLS/TLSv12.h>
+#include <time.h>
+
+namespace TLS {
+
+// Remembers the sessions we negotiated recently, keyed by host name, so that connecting to
+// the same host again can skip the certificate and key exchange (RFC 5246 section 7.4.1.2
+// session IDs and RFC 5077 session tickets). This is per-process and lives in memory only.
+class SessionCache {
+public:
+    static constexpr size_t max_sessions = 64;
+    static constexpr time_t max_lifetime_in_seconds = 60 * 60;
+
+    struct Session {
+        CipherSuite cipher { CipherSuite::Invalid };
+        ByteBuffer master_key;
+        u8 session_id[32] {};
+        u8 session_id_size { 0 };
+        ByteBuffer ticket;
+        time_t expires_at { 0 };
+    };
+
+    static SessionCache& the();
+
+    Optional<Session> lookup(const String& host);
+    void store(const String& host, Session, time_t lifetime_in_seconds);
+    void forget(const String& host);
+
+private:
+    SessionCache() { }
+
+    HashMap<String, Session> m_sessions;
+};
+
+}
@@ -160,6 +160,10 @@ bool TLSv12::common_connect(const struct sockaddr* saddr, socklen_t length)
 
 void TLSv12::read_from_socket()
 {
+    // Our user wants to stop hearing about data for a while, so don't read any more of it either.
+    if (!read_notifications_enabled())
+        return;
+
     if (m_context.application_buffer.size() > 0) {
         deferred_invoke([&](auto&) { read_from_socket(); });
         if (on_tls_ready_to_read)
@@ -73,6 +73,10 @@ enum class CipherSuite {
     RSA_WITH_AES_256_CBC_SHA = 0x0035,
     RSA_WITH_AES_128_CBC_SHA256 = 0x003C,
     RSA_WITH_AES_256_CBC_SHA256 = 0x003D,
+    ECDHE_RSA_WITH_AES_128_CBC_SHA = 0xC013,
+    ECDHE_RSA_WITH_AES_256_CBC_SHA = 0xC014,
+    ECDHE_RSA_WITH_AES_128_CBC_SHA256 = 0xC027,
+    ECDHE_RSA_WITH_AES_128_GCM_SHA256 = 0xC02F,
     // TODO
     RSA_WITH_AES_128_GCM_SHA256 = 0x009C,
     RSA_WITH_AES_256_GCM_SHA384 = 0x009D,
@@ -160,6 +164,7 @@ enum HandshakeType {
     ClientHello = 0x01,
     ServerHello = 0x02,
     HelloVerifyRequest = 0x03,
+    NewSessionTicket = 0x04,
     CertificateMessage = 0x0b,
     ServerKeyExchange = 0x0c,
     CertificateRequest = 0x0d,
@@ -172,7 +177,31 @@ enum HandshakeType {
 enum class HandshakeExtension : u16 {
     ServerName = 0x00,
     ApplicationLayerProtocolNegotiation = 0x10,
+    SupportedGroups = 0x0a,
+    ECPointFormats = 0x0b,
     SignatureAlgorithms = 0x0d,
+    SessionTicket = 0x23,
+};
+
+enum class NamedCurve : u16 {
+    x25519 = 0x001d,
+};
+
+enum class HashAlgorithm : u8 {
+    None = 0,
+    MD5 = 1,
+    SHA1 = 2,
+    SHA224 = 3,
+    SHA256 = 4,
+    SHA384 = 5,
+    SHA512 = 6,
+};
+
+enum class SignatureAlgorithm : u8 {
+    Anonymous = 0,
+    RSA = 1,
+    DSA = 2,
+    ECDSA = 3,
 };
 
 enum class WritePacketStage {
@@ -215,6 +244,7 @@ struct Context {
     Vector<Certificate> client_certificates;
     ByteBuffer master_key;
     ByteBuffer premaster_key;
+    ByteBuffer server_ecdhe_public_key;
     u8 cipher_spec_set { 0 };
     struct {
         int created { 0 };
@@ -263,6 +293,15 @@ struct Context {
     size_t send_retries { 0 };
 
     time_t handshake_initiation_timestamp { 0 };
+
+    // The session we offered to resume in our hello, and whether the server agreed to.
+    CipherSuite resumable_cipher { CipherSuite::Invalid };
+    ByteBuffer resumable_master_key;
+    bool session_resumed { false };
+
+    // A ticket the server handed us for resuming this session later (RFC 5077).
+    ByteBuffer session_ticket;
+    u32 session_ticket_lifetime_hint { 0 };
 };
 
 class TLSv12 : public Core::Socket {
@@ -270,6 +309,7 @@ class TLSv12 : public Core::Socket {
 public:
     ByteBuffer& write_buffer() { return m_context.tls_buffer; }
     bool is_established() const { return m_context.connection_status == ConnectionStatus::Established; }
+    bool is_session_resumed() const { return m_context.session_resumed; }
     virtual bool connect(const String&, int) override;
 
     void set_sni(const StringView& sni)
@@ -306,7 +346,11 @@ public:
             || suite == CipherSuite::RSA_WITH_AES_256_CBC_SHA256
             || suite == CipherSuite::RSA_WITH_AES_128_CBC_SHA
             || suite == CipherSuite::RSA_WITH_AES_256_CBC_SHA
-            || suite == CipherSuite::RSA_WITH_AES_128_GCM_SHA256;
+            || suite == CipherSuite::RSA_WITH_AES_128_GCM_SHA256
+            || suite == CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA256
+            || suite == CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA
+            || suite == CipherSuite::ECDHE_RSA_WITH_AES_256_CBC_SHA
+            || suite == CipherSuite::ECDHE_RSA_WITH_AES_128_GCM_SHA256;
     }
 
     bool supports_version(Version v) const
@@ -357,6 +401,7 @@ private:
     ByteBuffer build_change_cipher_spec();
     ByteBuffer build_verify_request();
     void build_random(PacketBuilder&);
+    void build_ecdhe_public_key(PacketBuilder&);
 
     bool flush();
     void write_into_socket();
@@ -368,6 +413,7 @@ private:
     ssize_t handle_finished(ReadonlyBytes, WritePacketStage&);
     ssize_t handle_certificate(ReadonlyBytes);
     ssize_t handle_server_key_exchange(ReadonlyBytes);
+    ssize_t handle_new_session_ticket(ReadonlyBytes);
     ssize_t handle_server_hello_done(ReadonlyBytes);
     ssize_t handle_verify(ReadonlyBytes);
     ssize_t handle_payload(ReadonlyBytes);
@@ -376,6 +422,11 @@ private:
 
     size_t asn1_length(ReadonlyBytes, size_t* octets);
 
+    bool verify_server_key_exchange_signature(const Certificate&, HashAlgorithm, ReadonlyBytes parameters, ReadonlyBytes signature);
+
+    void did_complete_handshake();
+    void remember_session();
+
     void pseudorandom_function(Bytes output, ReadonlyBytes secret, const u8* label, size_t label_length, ReadonlyBytes seed, ReadonlyBytes seed_b);
 
     size_t key_length() const
@@ -388,10 +439,14 @@ private:
         case CipherSuite::RSA_WITH_AES_128_CBC_SHA256:
         case CipherSuite::RSA_WITH_AES_128_CBC_SHA:
         case CipherSuite::RSA_WITH_AES_128_GCM_SHA256:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA256:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_GCM_SHA256:
         default:
             return 128 / 8;
         case CipherSuite::AES_256_GCM_SHA384:
         case CipherSuite::RSA_WITH_AES_256_CBC_SHA:
+        case CipherSuite::ECDHE_RSA_WITH_AES_256_CBC_SHA:
         case CipherSuite::RSA_WITH_AES_256_CBC_SHA256:
         case CipherSuite::RSA_WITH_AES_256_GCM_SHA384:
             return 256 / 8;
@@ -402,6 +457,8 @@ private:
         switch (m_context.cipher) {
         case CipherSuite::RSA_WITH_AES_128_CBC_SHA:
         case CipherSuite::RSA_WITH_AES_256_CBC_SHA:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA:
+        case CipherSuite::ECDHE_RSA_WITH_AES_256_CBC_SHA:
             return Crypto::Hash::SHA1::digest_size();
         case CipherSuite::AES_256_GCM_SHA384:
         case CipherSuite::RSA_WITH_AES_256_GCM_SHA384:
@@ -413,6 +470,8 @@ private:
         case CipherSuite::RSA_WITH_AES_128_CBC_SHA256:
         case CipherSuite::RSA_WITH_AES_128_GCM_SHA256:
         case CipherSuite::RSA_WITH_AES_256_CBC_SHA256:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA256:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_GCM_SHA256:
         default:
             return Crypto::Hash::SHA256::digest_size();
         }
@@ -427,12 +486,16 @@ private:
         case CipherSuite::RSA_WITH_AES_128_CBC_SHA:
         case CipherSuite::RSA_WITH_AES_256_CBC_SHA256:
         case CipherSuite::RSA_WITH_AES_256_CBC_SHA:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA:
+        case CipherSuite::ECDHE_RSA_WITH_AES_256_CBC_SHA:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA256:
         default:
             return 16;
         case CipherSuite::AES_128_GCM_SHA256:
         case CipherSuite::AES_256_GCM_SHA384:
         case CipherSuite::RSA_WITH_AES_128_GCM_SHA256:
         case CipherSuite::RSA_WITH_AES_256_GCM_SHA384:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_GCM_SHA256:
             return 8; // 4 bytes of fixed IV, 8 random (nonce) bytes, 4 bytes for counter
                       // GCM specifically asks us to transmit only the nonce, the counter is zero
                       // and the fixed IV is derived from the premaster key.
@@ -446,6 +509,20 @@ private:
         case CipherSuite::AES_256_GCM_SHA384:
         case CipherSuite::RSA_WITH_AES_128_GCM_SHA256:
         case CipherSuite::RSA_WITH_AES_256_GCM_SHA384:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_GCM_SHA256:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool is_ecdhe() const
+    {
+        switch (m_context.cipher) {
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA:
+        case CipherSuite::ECDHE_RSA_WITH_AES_256_CBC_SHA:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA256:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_GCM_SHA256:
             return true;
         default:
             return false;
@@ -33,6 +33,7 @@
 #include <LibTTF/Cmap.h>
 #include <LibTTF/Font.h>
 #include <LibTTF/Glyf.h>
+#include <LibTTF/GlyphAtlas.h>
 #include <LibTTF/Tables.h>
 #include <LibTextCodec/Decoder.h>
 #include <math.h>
@@ -553,23 +554,31 @@ int ScaledFont::width(const Utf32View& utf32) const
     return width;
 }
 
-RefPtr<Gfx::Bitmap> ScaledFont::raster_glyph(u32 glyph_id) const
+ScaledGlyphMetrics ScaledFont::glyph_metrics(u32 glyph_id) const
 {
-    auto glyph_iterator = m_cached_glyph_bitmaps.find(glyph_id);
-    if (glyph_iterator != m_cached_glyph_bitmaps.end())
-        return glyph_iterator->value;
+    if (auto metrics = m_cached_glyph_metrics.get(glyph_id); metrics.has_value())
+        return metrics.value();
+    auto metrics = m_font->glyph_metrics(glyph_id, m_x_scale, m_y_scale);
+    m_cached_glyph_metrics.set(glyph_id, metrics);
+    return metrics;
+}
+
+Gfx::GlyphCoverage ScaledFont::glyph_coverage(u32 glyph_id) const
+{
+    GlyphAtlasStrike strike { m_font->unique_id(), m_x_scale, m_y_scale };
+    if (auto coverage = GlyphAtlas::the().find(strike, glyph_id); coverage.has_value())
+        return coverage.value();
 
     auto glyph_bitmap = m_font->raster_glyph(glyph_id, m_x_scale, m_y_scale);
-    m_cached_glyph_bitmaps.set(glyph_id, glyph_bitmap);
-    return glyph_bitmap;
+    return GlyphAtlas::the().add(strike, glyph_id, glyph_bitmap.ptr());
 }
 
 Gfx::Glyph ScaledFont::glyph(u32 code_point) const
 {
     auto id = glyph_id_for_codepoint(code_point);
-    auto bitmap = raster_glyph(id);
+    auto coverage = glyph_coverage(id);
     auto metrics = glyph_metrics(id);
-    return Gfx::Glyph(bitmap, metrics.left_side_bearing, metrics.advance_width, metrics.ascender);
+    return Gfx::Glyph(coverage, metrics.left_side_bearing, metrics.advance_width, metrics.ascender);
 }
 
 u8 ScaledFont::glyph_width(size_t code_point) const
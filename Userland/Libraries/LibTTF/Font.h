@@ -75,6 +75,8 @@ public:
     u32 glyph_count() const;
     u16 units_per_em() const;
     u32 glyph_id_for_codepoint(u32 codepoint) const { return m_cmap.glyph_id_for_codepoint(codepoint); }
+    // Tells fonts apart in the GlyphAtlas, even if one is loaded at the address of another one that's gone.
+    u32 unique_id() const { return m_unique_id; }
     String family() const;
     String variant() const;
     u16 weight() const;
@@ -104,6 +106,8 @@ private:
         , m_glyf(move(glyf))
         , m_cmap(move(cmap))
     {
+        static u32 s_next_unique_id = 0;
+        m_unique_id = ++s_next_unique_id;
     }
 
     // This owns the font data
@@ -117,6 +121,7 @@ private:
     Loca m_loca;
     Glyf m_glyf;
     Cmap m_cmap;
+    u32 m_unique_id { 0 };
 };
 
 class ScaledFont : public Gfx::Font {
@@ -132,8 +137,9 @@ public:
     }
     u32 glyph_id_for_codepoint(u32 codepoint) const { return m_font->glyph_id_for_codepoint(codepoint); }
     ScaledFontMetrics metrics() const { return m_font->metrics(m_x_scale, m_y_scale); }
-    ScaledGlyphMetrics glyph_metrics(u32 glyph_id) const { return m_font->glyph_metrics(glyph_id, m_x_scale, m_y_scale); }
-    RefPtr<Gfx::Bitmap> raster_glyph(u32 glyph_id) const;
+    ScaledGlyphMetrics glyph_metrics(u32 glyph_id) const;
+    // The rasterized glyph, from the GlyphAtlas shared by all fonts. See there for how long it's valid.
+    Gfx::GlyphCoverage glyph_coverage(u32 glyph_id) const;
 
     // Gfx::Font implementation
     virtual NonnullRefPtr<Font> clone() const override { return *this; } // FIXME: clone() should not need to be implemented
@@ -168,7 +174,8 @@ private:
     float m_y_scale { 0.0f };
     float m_point_width { 0.0f };
     float m_point_height { 0.0f };
-    mutable HashMap<u32, RefPtr<Gfx::Bitmap>> m_cached_glyph_bitmaps;
+    // Measuring text needs the metrics of every glyph, and working them out means parsing the glyph.
+    mutable HashMap<u32, ScaledGlyphMetrics> m_cached_glyph_metrics;
 };
 
 }
@@ -30,6 +30,7 @@
 #include <AK/Vector.h>
 #include <LibGfx/AffineTransform.h>
 #include <LibGfx/Bitmap.h>
+#include <LibGfx/PathRasterizer.h>
 #include <LibTTF/Tables.h>
 #include <math.h>
 
@@ -42,10 +43,8 @@ public:
     RefPtr<Gfx::Bitmap> accumulate();
 
 private:
-    void draw_line(Gfx::FloatPoint, Gfx::FloatPoint);
-
     Gfx::IntSize m_size;
-    Vector<float> m_data;
+    Gfx::PathRasterizer m_path_rasterizer;
 };
 
 class Loca {
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Debug.h>
+#include <LibGfx/Bitmap.h>
+#include <LibTTF/GlyphAtlas.h>
+
+namespace TTF {
+
+GlyphAtlas& GlyphAtlas::the()
+{
+    static GlyphAtlas atlas;
+    return atlas;
+}
+
+Gfx::GlyphCoverage GlyphAtlas::coverage_for(const Entry& entry)
+{
+    if (!entry.page_index.has_value())
+        return {};
+    auto& page = *m_pages[entry.page_index.value()];
+    page.last_used = ++m_clock;
+    return { page.data.data() + entry.rect.y() * page.size.width() + entry.rect.x(), (size_t)page.size.width(), entry.rect.size() };
+}
+
+Optional<Gfx::GlyphCoverage> GlyphAtlas::find(const GlyphAtlasStrike& key, u32 glyph_id)
+{
+    auto strike = m_strikes.find(key);
+    if (strike == m_strikes.end())
+        return {};
+    auto entry = strike->value->glyphs.find(glyph_id);
+    if (entry == strike->value->glyphs.end())
+        return {};
+    return coverage_for(entry->value);
+}
+
+Optional<Gfx::IntPoint> GlyphAtlas::allocate_in_page(Page& page, const Gfx::IntSize& size)
+{
+    // Use the lowest shelf that's tall enough, as long as it doesn't waste too much space above the glyph.
+    Shelf* best_shelf = nullptr;
+    for (auto& shelf : page.shelves) {
+        if (shelf.height < size.height() || shelf.height > size.height() + size.height() / 4 + 1)
+            continue;
+        if (shelf.used_width + size.width() > page.size.width())
+            continue;
+        if (!best_shelf || shelf.height < best_shelf->height)
+            best_shelf = &shelf;
+    }
+
+    if (!best_shelf) {
+        if (page.used_height + size.height() > page.size.height() || size.width() > page.size.width())
+            return {};
+        page.shelves.append({ page.used_height, size.height(), 0 });
+        page.used_height += size.height();
+        best_shelf = &page.shelves.last();
+    }
+
+    Gfx::IntPoint location { best_shelf->used_width, best_shelf->y };
+    best_shelf->used_width += size.width();
+    return location;
+}
+
+size_t GlyphAtlas::allocate(const Gfx::IntSize& size, Gfx::IntPoint& location)
+{
+    bool fits_in_a_page = size.width() <= page_size && size.height() <= page_size;
+    if (fits_in_a_page) {
+        for (size_t i = 0; i < m_pages.size(); ++i) {
+            if (!m_pages[i] || m_pages[i]->size != Gfx::IntSize { page_size, page_size })
+                continue;
+            if (auto allocated_location = allocate_in_page(*m_pages[i], size); allocated_location.has_value()) {
+                location = allocated_location.value();
+                return i;
+            }
+        }
+    }
+
+    // Huge glyphs get a page of their own.
+    auto page_size_needed = fits_in_a_page ? Gfx::IntSize { page_size, page_size } : size;
+    size_t bytes_needed = page_size_needed.width() * page_size_needed.height();
+    while (m_size_in_bytes + bytes_needed > size_budget) {
+        Optional<size_t> least_recently_used;
+        for (size_t i = 0; i < m_pages.size(); ++i) {
+            if (m_pages[i] && (!least_recently_used.has_value() || m_pages[i]->last_used < m_pages[least_recently_used.value()]->last_used))
+                least_recently_used = i;
+        }
+        if (!least_recently_used.has_value())
+            break;
+        evict_page(least_recently_used.value());
+    }
+
+    auto page = make<Page>();
+    page->size = page_size_needed;
+    page->data.resize(bytes_needed);
+    m_size_in_bytes += bytes_needed;
+    location = allocate_in_page(*page, size).value();
+
+    for (size_t i = 0; i < m_pages.size(); ++i) {
+        if (!m_pages[i]) {
+            m_pages[i] = move(page);
+            return i;
+        }
+    }
+    m_pages.append(move(page));
+    return m_pages.size() - 1;
+}
+
+void GlyphAtlas::evict_page(size_t page_index)
+{
+    auto& page = *m_pages[page_index];
+    dbgln_if(GLYPH_ATLAS_DEBUG, "GlyphAtlas: Evicting page {} with {} glyphs", page_index, page.glyphs.size());
+    for (auto& glyph : page.glyphs) {
+        glyph.strike->glyphs.remove(glyph.glyph_id);
+        // Strikes of fonts that are gone never get used again, so don't let them pile up.
+        // This was the strike's last glyph in any page, so the page doesn't refer to it any further.
+        if (--glyph.strike->glyphs_in_pages == 0)
+            m_strikes.remove(glyph.strike->key);
+    }
+    m_size_in_bytes -= page.data.size();
+    m_pages[page_index] = nullptr;
+}
+
+Gfx::GlyphCoverage GlyphAtlas::add(const GlyphAtlasStrike& key, u32 glyph_id, const Gfx::Bitmap* bitmap)
+{
+    Entry entry;
+    if (bitmap && !bitmap->size().is_empty()) {
+        Gfx::IntPoint location;
+        size_t page_index = allocate(bitmap->size(), location);
+        auto& page = *m_pages[page_index];
+        for (int y = 0; y < bitmap->height(); ++y) {
+            const Gfx::RGBA32* src = bitmap->scanline(y);
+            u8* dst = page.data.data() + (location.y() + y) * page.size.width() + location.x();
+            for (int x = 0; x < bitmap->width(); ++x)
+                dst[x] = src[x] >> 24;
+        }
+        entry.page_index = page_index;
+        entry.rect = { location, bitmap->size() };
+    }
+
+    // Evicting a page may have removed this strike, so only look it up now.
+    auto strike = m_strikes.find(key);
+    if (strike == m_strikes.end()) {
+        m_strikes.set(key, make<Strike>(Strike { key, {} }));
+        strike = m_strikes.find(key);
+    }
+    strike->value->glyphs.set(glyph_id, entry);
+    if (entry.page_index.has_value()) {
+        m_pages[entry.page_index.value()]->glyphs.append({ strike->value.ptr(), glyph_id });
+        ++strike->value->glyphs_in_pages;
+    }
+    return coverage_for(entry);
+}
+
+}
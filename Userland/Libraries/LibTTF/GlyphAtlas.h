@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/HashMap.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Optional.h>
+#include <AK/OwnPtr.h>
+#include <AK/Vector.h>
+#include <LibGfx/Font.h>
+#include <LibGfx/Rect.h>
+
+namespace TTF {
+
+// Which font, at which size, a rasterized glyph belongs to.
+struct GlyphAtlasStrike {
+    u32 font_id { 0 };
+    float x_scale { 0 };
+    float y_scale { 0 };
+
+    bool operator==(const GlyphAtlasStrike& other) const { return font_id == other.font_id && x_scale == other.x_scale && y_scale == other.y_scale; }
+};
+
+}
+
+namespace AK {
+
+template<>
+struct Traits<TTF::GlyphAtlasStrike> : public GenericTraits<TTF::GlyphAtlasStrike> {
+    static unsigned hash(const TTF::GlyphAtlasStrike& strike)
+    {
+        return pair_int_hash(strike.font_id, pair_int_hash(strike.x_scale * 65536, strike.y_scale * 65536));
+    }
+};
+
+}
+
+namespace TTF {
+
+// The rasterized glyphs of every TTF font in this process, packed into pages of 8-bit coverage.
+// Every font and size gets the same glyphs, no matter how many ScaledFonts have been made for it,
+// and once the pages outgrow their size budget, the least recently used page is thrown away.
+//
+// The coverage handed out points into a page, so it's only good until the next glyph is added.
+class GlyphAtlas {
+public:
+    static constexpr int page_size = 256;
+    static constexpr size_t size_budget = 2 * MiB;
+
+    static GlyphAtlas& the();
+
+    // An empty Optional means the glyph hasn't been rasterized yet.
+    Optional<Gfx::GlyphCoverage> find(const GlyphAtlasStrike&, u32 glyph_id);
+
+    // Copies the alpha channel of the rasterized glyph into the atlas. Glyphs that didn't rasterize
+    // to anything are remembered too, so they aren't tried again.
+    Gfx::GlyphCoverage add(const GlyphAtlasStrike&, u32 glyph_id, const Gfx::Bitmap*);
+
+    size_t size_in_bytes() const { return m_size_in_bytes; }
+
+private:
+    GlyphAtlas() { }
+
+    struct Entry {
+        Optional<size_t> page_index;
+        Gfx::IntRect rect;
+    };
+
+    struct Strike {
+        GlyphAtlasStrike key;
+        HashMap<u32, Entry> glyphs;
+        size_t glyphs_in_pages { 0 };
+    };
+
+    struct Glyph {
+        Strike* strike { nullptr };
+        u32 glyph_id { 0 };
+    };
+
+    // Glyphs of similar heights share a shelf, which is filled from left to right.
+    struct Shelf {
+        int y { 0 };
+        int height { 0 };
+        int used_width { 0 };
+    };
+
+    struct Page {
+        Gfx::IntSize size;
+        Vector<u8> data;
+        Vector<Shelf> shelves;
+        int used_height { 0 };
+        u64 last_used { 0 };
+        // So evicting the page can remove its glyphs from their strikes.
+        Vector<Glyph> glyphs;
+    };
+
+    Gfx::GlyphCoverage coverage_for(const Entry&);
+    Optional<Gfx::IntPoint> allocate_in_page(Page&, const Gfx::IntSize&);
+    size_t allocate(const Gfx::IntSize&, Gfx::IntPoint& location);
+    void evict_page(size_t page_index);
+
+    HashMap<GlyphAtlasStrike, NonnullOwnPtr<Strike>> m_strikes;
+    Vector<OwnPtr<Page>> m_pages;
+    size_t m_size_in_bytes { 0 };
+    u64 m_clock { 0 };
+};
+
+}
@@ -29,8 +29,9 @@
 #ifdef __serenity__
 
 #    include <AK/Assertions.h>
-#    include <AK/Atomic.h>
 #    include <AK/Types.h>
+#    include <bits/pthread_integration.h>
+#    include <sys/types.h>
 #    include <unistd.h>
 
 namespace LibThread {
@@ -44,8 +45,8 @@ public:
     void unlock();
 
 private:
-    Atomic<pid_t> m_holder { 0 };
-    u32 m_level { 0 };
+    // This shares its uncontended fast path and futex-based slow path with pthread mutexes.
+    pthread_mutex_t m_mutex { 0, 0, 0, __PTHREAD_MUTEX_RECURSIVE };
 };
 
 class Locker {
@@ -65,29 +66,13 @@ private:
 
 ALWAYS_INLINE void Lock::lock()
 {
-    pid_t tid = gettid();
-    if (m_holder == tid) {
-        ++m_level;
-        return;
-    }
-    for (;;) {
-        int expected = 0;
-        if (m_holder.compare_exchange_strong(expected, tid, AK::memory_order_acq_rel)) {
-            m_level = 1;
-            return;
-        }
-        donate(expected);
-    }
+    __pthread_mutex_lock(&m_mutex);
 }
 
 inline void Lock::unlock()
 {
-    VERIFY(m_holder == gettid());
-    VERIFY(m_level);
-    if (m_level == 1)
-        m_holder.store(0, AK::memory_order_release);
-    else
-        --m_level;
+    VERIFY(m_mutex.owner == gettid());
+    __pthread_mutex_unlock(&m_mutex);
 }
 
 #    define LOCKER(lock) LibThread::Locker locker(lock)
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/MergeSort.h>
+#include <AK/Vector.h>
+#include <LibThread/ThreadPool.h>
+
+namespace LibThread {
+
+// Below this many elements per thread, starting the threads costs more than they save.
+static constexpr size_t parallel_sort_min_items_per_thread = 16384;
+
+// Sorts equally sized chunks on the thread pool, and then merges neighbouring chunks
+// (again in parallel) until only one is left. Like merge_sort(), this is stable.
+// less_than gets called from several threads at once, so it must not modify shared state.
+template<typename T, typename LessThan>
+void parallel_sort(Span<T> items, LessThan less_than)
+{
+    auto& pool = ThreadPool::the();
+    size_t chunk_count = min(pool.worker_count(), items.size() / parallel_sort_min_items_per_thread);
+    if (chunk_count <= 1) {
+        merge_sort(items, move(less_than));
+        return;
+    }
+
+    auto run_in_parallel = [&pool](size_t task_count, auto task) {
+        pool.parallel_for(0, task_count, 1, task);
+    };
+
+    // boundaries[i] is where the i-th sorted run starts; the last one is the end of the items.
+    Vector<size_t> boundaries;
+    for (size_t i = 0; i <= chunk_count; ++i)
+        boundaries.append(items.size() * i / chunk_count);
+
+    run_in_parallel(chunk_count, [&](size_t i) {
+        merge_sort(items.slice(boundaries[i], boundaries[i + 1] - boundaries[i]), less_than);
+    });
+
+    while (boundaries.size() > 2) {
+        size_t run_count = boundaries.size() - 1;
+        run_in_parallel(run_count / 2, [&](size_t i) {
+            size_t start = boundaries[2 * i];
+            size_t middle = boundaries[2 * i + 1];
+            size_t end = boundaries[2 * i + 2];
+            auto compare = less_than;
+            Vector<T> buffer;
+            AK::Detail::merge_sorted_runs(items.slice(start, end - start), middle - start, buffer, compare);
+        });
+
+        Vector<size_t> merged_boundaries;
+        for (size_t i = 0; i < boundaries.size(); i += 2)
+            merged_boundaries.append(boundaries[i]);
+        if (run_count % 2)
+            merged_boundaries.append(boundaries.last());
+        boundaries = move(merged_boundaries);
+    }
+}
+
+template<typename Collection, typename LessThan>
+void parallel_sort(Collection& collection, LessThan less_than)
+{
+    parallel_sort(collection.span(), move(less_than));
+}
+
+}
@@ -41,7 +41,7 @@ LibThread::Thread::Thread(Function<int()> action, StringView thread_name)
 LibThread::Thread::~Thread()
 {
     if (m_tid) {
-        dbgln("Destroying thread \"{}\"({}) while it is still running!", m_thread_name, m_tid);
+        dbgln("Destroying thread \"{}\"({}) that was never joined, joining it now", m_thread_name, m_tid);
         [[maybe_unused]] auto res = join();
     }
 }
@@ -54,7 +54,6 @@ void LibThread::Thread::start()
         [](void* arg) -> void* {
             Thread* self = static_cast<Thread*>(arg);
             int exit_code = self->m_action();
-            self->m_tid = 0;
             return (void*)exit_code;
         },
         static_cast<void*>(this));
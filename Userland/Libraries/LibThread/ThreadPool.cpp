@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <LibThread/Thread.h>
+#include <LibThread/ThreadPool.h>
+#include <unistd.h>
+
+namespace LibThread {
+
+// The worker that's running on the current thread, if any.
+static thread_local ThreadPool* s_current_pool;
+static thread_local size_t s_current_worker_index;
+
+ThreadPool& ThreadPool::the()
+{
+    static ThreadPool* s_the = [] {
+        long processor_count = sysconf(_SC_NPROCESSORS_ONLN);
+        return new ThreadPool(max(processor_count, 1l));
+    }();
+    return *s_the;
+}
+
+ThreadPool::ThreadPool(size_t worker_count)
+{
+    VERIFY(worker_count > 0);
+    pthread_mutex_init(&m_mutex, nullptr);
+    pthread_cond_init(&m_cond, nullptr);
+
+    for (size_t i = 0; i < worker_count; ++i) {
+        auto worker = make<Worker>();
+        pthread_mutex_init(&worker->mutex, nullptr);
+        m_workers.append(move(worker));
+    }
+    // Only start the threads once all the workers exist, as they steal from each other.
+    for (size_t i = 0; i < worker_count; ++i) {
+        m_workers[i].thread = Thread::construct([this, i] { return worker_main(i); }, "Pool worker");
+        m_workers[i].thread->start();
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    pthread_mutex_lock(&m_mutex);
+    m_exit_requested = true;
+    pthread_cond_broadcast(&m_cond);
+    pthread_mutex_unlock(&m_mutex);
+
+    for (auto& worker : m_workers) {
+        [[maybe_unused]] auto result = worker.thread->join();
+        pthread_mutex_destroy(&worker.mutex);
+    }
+    pthread_cond_destroy(&m_cond);
+    pthread_mutex_destroy(&m_mutex);
+}
+
+void ThreadPool::submit(Function<void()> task)
+{
+    // A worker keeps the tasks it submits to itself, so that they run while what they work on is still in its cache.
+    size_t worker_index = s_current_pool == this ? s_current_worker_index : m_next_worker.fetch_add(1) % m_workers.size();
+    auto& worker = m_workers[worker_index];
+    // Count the task before anyone can take it, so that the count never drops below zero.
+    m_pending_task_count.fetch_add(1);
+    pthread_mutex_lock(&worker.mutex);
+    worker.tasks.append(move(task));
+    pthread_mutex_unlock(&worker.mutex);
+
+    pthread_mutex_lock(&m_mutex);
+    pthread_cond_signal(&m_cond);
+    pthread_mutex_unlock(&m_mutex);
+}
+
+Optional<Function<void()>> ThreadPool::take_task()
+{
+    if (!m_pending_task_count.load())
+        return {};
+
+    // Workers take the newest task from their own queue, and everybody steals the oldest task from the other queues.
+    size_t first_index = 0;
+    if (s_current_pool == this) {
+        auto& worker = m_workers[s_current_worker_index];
+        pthread_mutex_lock(&worker.mutex);
+        Optional<Function<void()>> task;
+        if (!worker.tasks.is_empty())
+            task = worker.tasks.take_last();
+        pthread_mutex_unlock(&worker.mutex);
+        if (task.has_value()) {
+            m_pending_task_count.fetch_sub(1);
+            return task;
+        }
+        first_index = s_current_worker_index + 1;
+    }
+
+    for (size_t i = 0; i < m_workers.size(); ++i) {
+        auto& worker = m_workers[(first_index + i) % m_workers.size()];
+        pthread_mutex_lock(&worker.mutex);
+        Optional<Function<void()>> task;
+        if (!worker.tasks.is_empty())
+            task = worker.tasks.take_first();
+        pthread_mutex_unlock(&worker.mutex);
+        if (task.has_value()) {
+            m_pending_task_count.fetch_sub(1);
+            return task;
+        }
+    }
+    return {};
+}
+
+bool ThreadPool::run_pending_task()
+{
+    auto task = take_task();
+    if (!task.has_value())
+        return false;
+    task.value()();
+    return true;
+}
+
+void ThreadPool::notify_waiters()
+{
+    pthread_mutex_lock(&m_mutex);
+    pthread_cond_broadcast(&m_cond);
+    pthread_mutex_unlock(&m_mutex);
+}
+
+int ThreadPool::worker_main(size_t worker_index)
+{
+    s_current_pool = this;
+    s_current_worker_index = worker_index;
+
+    for (;;) {
+        if (run_pending_task())
+            continue;
+        pthread_mutex_lock(&m_mutex);
+        while (!m_pending_task_count.load() && !m_exit_requested)
+            pthread_cond_wait(&m_cond, &m_mutex);
+        bool exit_requested = m_exit_requested && !m_pending_task_count.load();
+        pthread_mutex_unlock(&m_mutex);
+        if (exit_requested)
+            return 0;
+    }
+}
+
+}
@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/Function.h>
+#include <AK/Noncopyable.h>
+#include <AK/NonnullOwnPtrVector.h>
+#include <AK/NonnullRefPtr.h>
+#include <AK/Optional.h>
+#include <LibCore/Event.h>
+#include <LibCore/EventLoop.h>
+#include <LibCore/Object.h>
+#include <pthread.h>
+
+namespace LibThread {
+
+class Thread;
+
+// A fixed set of worker threads that run tasks. Every worker has its own queue of tasks: tasks
+// submitted from a worker go to the front of its own queue, and a worker that runs out of tasks
+// steals the oldest ones from the other workers. Threads that wait for tasks to finish (through
+// a TaskGroup, a Future or parallel_for()) run pending tasks themselves in the meantime, so tasks
+// can start and wait for other tasks without running out of workers.
+class ThreadPool {
+    AK_MAKE_NONCOPYABLE(ThreadPool);
+    AK_MAKE_NONMOVABLE(ThreadPool);
+
+public:
+    // The pool shared by the whole process, with one worker per processor. It's never destroyed.
+    static ThreadPool& the();
+
+    explicit ThreadPool(size_t worker_count);
+    ~ThreadPool();
+
+    size_t worker_count() const { return m_workers.size(); }
+
+    void submit(Function<void()>);
+
+    // Runs one pending task on the calling thread. Returns false if there was nothing to run.
+    bool run_pending_task();
+
+    // Runs pending tasks on the calling thread until the condition holds. Whatever makes the
+    // condition hold has to call notify_waiters() afterwards.
+    template<typename Condition>
+    void wait_until(Condition condition)
+    {
+        while (!condition()) {
+            if (run_pending_task())
+                continue;
+            pthread_mutex_lock(&m_mutex);
+            while (!condition() && !m_pending_task_count.load())
+                pthread_cond_wait(&m_cond, &m_mutex);
+            pthread_mutex_unlock(&m_mutex);
+        }
+    }
+
+    void notify_waiters();
+
+    // Calls body(i) for every i from begin up to end, with every task taking at least grain_size of them.
+    // body gets called from several threads at once.
+    template<typename Callback>
+    void parallel_for(size_t begin, size_t end, size_t grain_size, Callback body);
+
+private:
+    struct Worker {
+        pthread_mutex_t mutex;
+        Vector<Function<void()>> tasks;
+        RefPtr<Thread> thread;
+    };
+
+    int worker_main(size_t worker_index);
+    Optional<Function<void()>> take_task();
+
+    NonnullOwnPtrVector<Worker> m_workers;
+    Atomic<size_t> m_next_worker { 0 };
+    Atomic<size_t> m_pending_task_count { 0 };
+    bool m_exit_requested { false };
+
+    // Idle workers and waiting threads sleep on this.
+    pthread_mutex_t m_mutex;
+    pthread_cond_t m_cond;
+};
+
+// Keeps track of a set of tasks, so they can all be waited for at once.
+class TaskGroup {
+    AK_MAKE_NONCOPYABLE(TaskGroup);
+    AK_MAKE_NONMOVABLE(TaskGroup);
+
+public:
+    explicit TaskGroup(ThreadPool& pool = ThreadPool::the())
+        : m_pool(pool)
+    {
+    }
+
+    ~TaskGroup() { wait(); }
+
+    void spawn(Function<void()> task)
+    {
+        m_unfinished_task_count.fetch_add(1);
+        m_pool.submit([this, task = move(task)] {
+            task();
+            if (m_unfinished_task_count.fetch_sub(1) == 1)
+                m_pool.notify_waiters();
+        });
+    }
+
+    void wait()
+    {
+        m_pool.wait_until([this] { return m_unfinished_task_count.load() == 0; });
+    }
+
+private:
+    ThreadPool& m_pool;
+    Atomic<size_t> m_unfinished_task_count { 0 };
+};
+
+// The result of a task that runs on a ThreadPool. It can be waited for, or handed to a callback
+// on the event loop that the task was started from.
+template<typename T>
+class Future final : public Core::Object {
+    C_OBJECT(Future);
+
+public:
+    static NonnullRefPtr<Future> run(Function<T()> task, Function<void(T&)> on_complete = {}, ThreadPool& pool = ThreadPool::the())
+    {
+        auto future = adopt(*new Future(pool, move(on_complete)));
+        pool.submit([protector = future, future = future.ptr(), task = move(task)] {
+            future->m_result = task();
+            future->m_is_ready.store(true);
+            future->m_pool.notify_waiters();
+            future->post_completion();
+        });
+        return future;
+    }
+
+    bool is_ready() const { return m_is_ready.load(); }
+
+    T& await()
+    {
+        m_pool.wait_until([this] { return is_ready(); });
+        return m_result.value();
+    }
+
+private:
+    Future(ThreadPool& pool, Function<void(T&)> on_complete)
+        : m_pool(pool)
+        , m_on_complete(move(on_complete))
+    {
+        if (m_on_complete) {
+            m_event_loop = &Core::EventLoop::current();
+            // The worker posts the completion to us, which needs a weak pointer to us. Creating the
+            // first one isn't thread-safe, so do it now.
+            [[maybe_unused]] auto weak_this = make_weak_ptr();
+        }
+    }
+
+    void post_completion()
+    {
+        if (!m_on_complete)
+            return;
+        // The event only has a weak pointer to us, so keep ourselves alive until it has been handled.
+        m_event_loop->post_event(*this, make<Core::DeferredInvocationEvent>([this, protector = NonnullRefPtr(*this)](auto&) {
+            m_on_complete(m_result.value());
+        }));
+        Core::EventLoop::wake();
+    }
+
+    ThreadPool& m_pool;
+    Function<void(T&)> m_on_complete;
+    Core::EventLoop* m_event_loop { nullptr };
+    Optional<T> m_result;
+    Atomic<bool> m_is_ready { false };
+};
+
+template<typename Callback>
+void ThreadPool::parallel_for(size_t begin, size_t end, size_t grain_size, Callback body)
+{
+    if (begin >= end)
+        return;
+    size_t count = end - begin;
+    // A few tasks per worker evens things out when some items take longer than others.
+    size_t task_count = min(worker_count() * 4, (count + grain_size - 1) / max(grain_size, (size_t)1));
+    if (task_count <= 1) {
+        for (size_t i = begin; i < end; ++i)
+            body(i);
+        return;
+    }
+
+    TaskGroup group(*this);
+    for (size_t task = 1; task < task_count; ++task) {
+        size_t first = begin + count * task / task_count;
+        size_t last = begin + count * (task + 1) / task_count;
+        group.spawn([&body, first, last] {
+            for (size_t i = first; i < last; ++i)
+                body(i);
+        });
+    }
+    for (size_t i = begin; i < begin + count / task_count; ++i)
+        body(i);
+    group.wait();
+}
+
+}
@@ -39,6 +39,7 @@ Line::~Line()
 
 void Line::set_length(size_t new_length)
 {
+    unpack();
     size_t old_length = length();
     if (old_length == new_length)
         return;
@@ -47,6 +48,7 @@ void Line::set_length(size_t new_length)
 
 void Line::clear(const Attribute& attribute)
 {
+    unpack();
     if (m_dirty) {
         for (auto& cell : m_cells) {
             cell = Cell { .code_point = ' ', .attribute = attribute };
@@ -64,6 +66,14 @@ bool Line::has_only_one_background_color() const
 {
     if (!length())
         return true;
+    if (m_packed) {
+        auto color = m_packed_attribute_runs.first().attribute.effective_background_color();
+        for (auto& run : m_packed_attribute_runs) {
+            if (run.attribute.effective_background_color() != color)
+                return false;
+        }
+        return true;
+    }
     // FIXME: Cache this result?
     auto color = attribute_at(0).effective_background_color();
     for (size_t i = 1; i < length(); ++i) {
@@ -73,4 +83,114 @@ bool Line::has_only_one_background_color() const
     return true;
 }
 
+static bool attributes_are_identical(const Attribute& a, const Attribute& b)
+{
+    if (a != b)
+        return false;
+    // Neighbouring cells usually share the very same (mostly null) strings, so avoid comparing their contents.
+    if (a.href.impl() == b.href.impl() && a.href_id.impl() == b.href_id.impl())
+        return true;
+    return a.href == b.href && a.href_id == b.href_id;
+}
+
+void Line::pack()
+{
+    if (m_packed || m_cells.is_empty())
+        return;
+
+    size_t stored_code_point_count = m_cells.size();
+    m_packed_trailing_code_point = m_cells.last().code_point;
+    while (stored_code_point_count > 0 && m_cells[stored_code_point_count - 1].code_point == m_packed_trailing_code_point)
+        --stored_code_point_count;
+
+    bool all_narrow = true;
+    for (size_t i = 0; i < stored_code_point_count; ++i) {
+        if (m_cells[i].code_point > 0xff) {
+            all_narrow = false;
+            break;
+        }
+    }
+    if (all_narrow) {
+        m_packed_narrow_code_points.ensure_capacity(stored_code_point_count);
+        for (size_t i = 0; i < stored_code_point_count; ++i)
+            m_packed_narrow_code_points.unchecked_append(m_cells[i].code_point);
+    } else {
+        m_packed_wide_code_points.ensure_capacity(stored_code_point_count);
+        for (size_t i = 0; i < stored_code_point_count; ++i)
+            m_packed_wide_code_points.unchecked_append(m_cells[i].code_point);
+    }
+
+    Vector<size_t, 16> run_starts;
+    run_starts.append(0);
+    for (size_t i = 1; i < m_cells.size(); ++i) {
+        if (!attributes_are_identical(m_cells[i - 1].attribute, m_cells[i].attribute))
+            run_starts.append(i);
+    }
+    m_packed_attribute_runs.ensure_capacity(run_starts.size());
+    for (auto start : run_starts)
+        m_packed_attribute_runs.unchecked_append({ start, m_cells[start].attribute });
+
+    m_packed_length = m_cells.size();
+    m_cells.clear();
+    m_packed = true;
+}
+
+void Line::unpack()
+{
+    if (!m_packed)
+        return;
+
+    m_cells.resize(m_packed_length);
+    for (size_t i = 0; i < m_packed_length; ++i)
+        m_cells[i].code_point = packed_code_point_at(i);
+    for (size_t run_index = 0; run_index < m_packed_attribute_runs.size(); ++run_index) {
+        auto& run = m_packed_attribute_runs[run_index];
+        size_t end = run_index + 1 < m_packed_attribute_runs.size() ? m_packed_attribute_runs[run_index + 1].start : m_packed_length;
+        for (size_t i = run.start; i < end; ++i)
+            m_cells[i].attribute = run.attribute;
+    }
+
+    m_packed_narrow_code_points.clear();
+    m_packed_wide_code_points.clear();
+    m_packed_attribute_runs.clear();
+    m_packed_length = 0;
+    m_packed = false;
+}
+
+u32 Line::packed_code_point_at(size_t index) const
+{
+    VERIFY(index < m_packed_length);
+    if (index < m_packed_narrow_code_points.size())
+        return m_packed_narrow_code_points[index];
+    if (index < m_packed_wide_code_points.size())
+        return m_packed_wide_code_points[index];
+    return m_packed_trailing_code_point;
+}
+
+const Attribute& Line::packed_attribute_at(size_t index) const
+{
+    VERIFY(index < m_packed_length);
+    size_t low = 0;
+    size_t high = m_packed_attribute_runs.size();
+    // Find the last run that starts at or before the index.
+    while (high - low > 1) {
+        size_t middle = low + (high - low) / 2;
+        if (m_packed_attribute_runs[middle].start <= index)
+            low = middle;
+        else
+            high = middle;
+    }
+    return m_packed_attribute_runs[low].attribute;
+}
+
+size_t Line::memory_usage() const
+{
+    if (!m_packed)
+        return sizeof(Line) + m_cells.capacity() * sizeof(Cell);
+    return sizeof(Line)
+        + m_packed_narrow_code_points.capacity()
+        + m_packed_wide_code_points.capacity() * sizeof(u32)
+        + m_packed_attribute_runs.capacity() * sizeof(AttributeRun);
+}
+
 }
@@ -93,33 +93,68 @@ public:
         Attribute attribute;
     };
 
-    const Attribute& attribute_at(size_t index) const { return m_cells[index].attribute; }
-    Attribute& attribute_at(size_t index) { return m_cells[index].attribute; }
-
-    Cell& cell_at(size_t index) { return m_cells[index]; }
-    const Cell& cell_at(size_t index) const { return m_cells[index]; }
+    const Attribute& attribute_at(size_t index) const
+    {
+        if (m_packed)
+            return packed_attribute_at(index);
+        return m_cells[index].attribute;
+    }
+    void set_attribute_at(size_t index, const Attribute& attribute)
+    {
+        unpack();
+        m_cells[index].attribute = attribute;
+    }
 
     void clear(const Attribute&);
     bool has_only_one_background_color() const;
 
-    size_t length() const { return m_cells.size(); }
+    size_t length() const { return m_packed ? m_packed_length : m_cells.size(); }
     void set_length(size_t);
 
     u32 code_point(size_t index) const
     {
+        if (m_packed)
+            return packed_code_point_at(index);
         return m_cells[index].code_point;
     }
 
     void set_code_point(size_t index, u32 code_point)
     {
+        unpack();
         m_cells[index].code_point = code_point;
     }
 
     bool is_dirty() const { return m_dirty; }
     void set_dirty(bool b) { m_dirty = b; }
 
+    // Lines in the history are packed into a much smaller form: the code points go into bytes if they
+    // all fit, repeated code points at the end are stored once, and attributes are stored as runs.
+    // Changing a packed line unpacks it again.
+    void pack();
+    bool is_packed() const { return m_packed; }
+
+    // Roughly how much memory the line takes up, for keeping the history within its byte budget.
+    size_t memory_usage() const;
+
 private:
+    struct AttributeRun {
+        size_t start { 0 };
+        Attribute attribute;
+    };
+
+    void unpack();
+    u32 packed_code_point_at(size_t index) const;
+    const Attribute& packed_attribute_at(size_t index) const;
+
     Vector<Cell> m_cells;
+
+    bool m_packed { false };
+    size_t m_packed_length { 0 };
+    Vector<u8> m_packed_narrow_code_points;
+    Vector<u32> m_packed_wide_code_points;
+    u32 m_packed_trailing_code_point { 0 };
+    Vector<AttributeRun> m_packed_attribute_runs;
+
     bool m_dirty { false };
 };
 
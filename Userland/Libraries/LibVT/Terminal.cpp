@@ -51,6 +51,7 @@ void Terminal::clear_including_history()
 {
     m_history.clear();
     m_history_start = 0;
+    m_history_bytes = 0;
 
     clear();
 
@@ -714,6 +715,56 @@ void Terminal::newline()
     set_cursor(new_row, 0);
 }
 
+void Terminal::add_line_to_history(NonnullOwnPtr<Line>&& line)
+{
+    if (max_history_size() == 0)
+        return;
+
+    line->pack();
+    size_t line_bytes = line->memory_usage();
+
+    // Once the history has filled up and started going around in a circle, it stays at that size.
+    // Growing it again would mean moving all the lines around, as the oldest one is at m_history_start.
+    if (m_history_start == 0 && m_history.size() < max_history_size() && m_history_bytes + line_bytes <= m_max_history_bytes) {
+        m_history_bytes += line_bytes;
+        m_history.append(move(line));
+        return;
+    }
+
+    if (m_history.is_empty())
+        return;
+    m_history_bytes -= m_history[m_history_start].memory_usage();
+    m_history_bytes += line_bytes;
+    m_history.ptr_at(m_history_start) = move(line);
+    m_history_start = (m_history_start + 1) % m_history.size();
+
+    // The new line may have been larger than the one it replaced.
+    while (m_history_bytes > m_max_history_bytes && m_history.size() > 1)
+        remove_oldest_history_line();
+}
+
+void Terminal::linearize_history()
+{
+    if (m_history_start == 0)
+        return;
+    NonnullOwnPtrVector<Line> new_history;
+    new_history.ensure_capacity(m_history.size());
+    for (size_t i = 0; i < m_history.size(); ++i) {
+        auto j = (m_history_start + i) % m_history.size();
+        new_history.unchecked_append(move(static_cast<Vector<NonnullOwnPtr<Line>>&>(m_history).at(j)));
+    }
+    m_history = move(new_history);
+    m_history_start = 0;
+}
+
+void Terminal::remove_oldest_history_line()
+{
+    m_history_bytes -= m_history[m_history_start].memory_usage();
+    m_history.remove(m_history_start);
+    if (m_history_start == m_history.size())
+        m_history_start = 0;
+}
+
 void Terminal::scroll_up()
 {
     // NOTE: We have to invalidate the cursor first.
@@ -758,8 +809,9 @@ void Terminal::put_character_at(unsigned row, unsigned column, u32 code_point)
     VERIFY(column < columns());
     auto& line = m_lines[row];
     line.set_code_point(column, code_point);
-    line.attribute_at(column) = m_current_attribute;
-    line.attribute_at(column).flags |= Attribute::Touched;
+    auto attribute = m_current_attribute;
+    attribute.flags |= Attribute::Touched;
+    line.set_attribute_at(column, attribute);
     line.set_dirty(true);
 
     m_last_code_point = code_point;
@@ -984,6 +1036,53 @@ void Terminal::on_input(u8 ch)
     on_code_point(ch);
 }
 
+static inline bool is_printable_ascii(u8 ch)
+{
+    return ch >= 0x20 && ch < 0x7f;
+}
+
+void Terminal::on_input(const u8* data, size_t size)
+{
+    size_t i = 0;
+    while (i < size) {
+        if (m_parser_state != Normal || !is_printable_ascii(data[i])) {
+            on_input(data[i++]);
+            continue;
+        }
+        size_t run_length = 1;
+        while (i + run_length < size && is_printable_ascii(data[i + run_length]))
+            ++run_length;
+        put_ascii_run(data + i, run_length);
+        i += run_length;
+    }
+}
+
+void Terminal::put_ascii_run(const u8* characters, size_t length)
+{
+    auto attribute = m_current_attribute;
+    attribute.flags |= Attribute::Touched;
+
+    while (length) {
+        // Wrapping at the right-hand side is left to on_code_point(), everything before it is filled in one go.
+        if (m_cursor_column + 1u >= columns()) {
+            on_code_point(*characters++);
+            --length;
+            continue;
+        }
+        size_t count = min(length, (size_t)(columns() - 1 - m_cursor_column));
+        auto& line = m_lines[m_cursor_row];
+        for (size_t i = 0; i < count; ++i) {
+            line.set_code_point(m_cursor_column + i, characters[i]);
+            line.set_attribute_at(m_cursor_column + i, attribute);
+        }
+        line.set_dirty(true);
+        m_last_code_point = characters[count - 1];
+        set_cursor(m_cursor_row, m_cursor_column + count);
+        characters += count;
+        length -= count;
+    }
+}
+
 void Terminal::on_code_point(u32 code_point)
 {
     auto new_column = m_cursor_column + 1;
@@ -1006,8 +1105,7 @@ void Terminal::on_code_point(u32 code_point)
 
 void Terminal::inject_string(const StringView& str)
 {
-    for (size_t i = 0; i < str.length(); ++i)
-        on_input(str[i]);
+    on_input((const u8*)str.characters_without_null_termination(), str.length());
 }
 
 void Terminal::emit_string(const StringView& string)
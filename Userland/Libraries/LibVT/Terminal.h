@@ -57,6 +57,8 @@ public:
 
     void invalidate_cursor();
     void on_input(u8);
+    // Same as calling on_input() for each byte, but runs of printable ASCII are put on the screen in bulk.
+    void on_input(const u8*, size_t);
 
     void clear();
     void clear_including_history();
@@ -100,26 +102,34 @@ public:
             m_max_history_lines = 0;
             m_history_start = 0;
             m_history.clear();
+            m_history_bytes = 0;
             m_client.terminal_history_changed();
             return;
         }
 
-        if (m_max_history_lines > value) {
-            NonnullOwnPtrVector<Line> new_history;
-            new_history.ensure_capacity(value);
-            auto existing_line_count = min(m_history.size(), value);
-            for (size_t i = m_history.size() - existing_line_count; i < m_history.size(); ++i) {
-                auto j = (m_history_start + i) % m_history.size();
-                new_history.unchecked_append(move(static_cast<Vector<NonnullOwnPtr<Line>>&>(m_history).at(j)));
-            }
-            m_history = move(new_history);
-            m_history_start = 0;
+        linearize_history();
+        if (m_history.size() > value) {
+            while (m_history.size() > value)
+                remove_oldest_history_line();
             m_client.terminal_history_changed();
         }
         m_max_history_lines = value;
     }
     size_t history_size() const { return m_history.size(); }
 
+    // The history is also limited by how much memory its (packed) lines take up.
+    size_t max_history_bytes() const { return m_max_history_bytes; }
+    void set_max_history_bytes(size_t value)
+    {
+        m_max_history_bytes = value;
+        linearize_history();
+        if (m_history_bytes > value) {
+            while (m_history_bytes > value && !m_history.is_empty())
+                remove_oldest_history_line();
+            m_client.terminal_history_changed();
+        }
+    }
+
     void inject_string(const StringView&);
     void handle_key_press(KeyCode, u32, u8 flags);
 
@@ -129,6 +139,7 @@ private:
     typedef Vector<unsigned, 4> ParamVector;
 
     void on_code_point(u32);
+    void put_ascii_run(const u8*, size_t);
 
     void scroll_up();
     void scroll_down();
@@ -238,19 +249,10 @@ private:
 
     size_t m_history_start = 0;
     NonnullOwnPtrVector<Line> m_history;
-    void add_line_to_history(NonnullOwnPtr<Line>&& line)
-    {
-        if (max_history_size() == 0)
-            return;
-
-        if (m_history.size() < max_history_size()) {
-            VERIFY(m_history_start == 0);
-            m_history.append(move(line));
-            return;
-        }
-        m_history.ptr_at(m_history_start) = move(line);
-        m_history_start = (m_history_start + 1) % m_history.size();
-    }
+    size_t m_history_bytes { 0 };
+    void add_line_to_history(NonnullOwnPtr<Line>&&);
+    void linearize_history();
+    void remove_oldest_history_line();
 
     NonnullOwnPtrVector<Line> m_lines;
 
@@ -298,6 +300,7 @@ private:
     u8 m_final { 0 };
     u32 m_last_code_point { 0 };
     size_t m_max_history_lines { 1024 };
+    size_t m_max_history_bytes { 8 * MiB };
 };
 
 }
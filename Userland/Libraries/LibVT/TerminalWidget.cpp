@@ -88,9 +88,8 @@ void TerminalWidget::set_pty_master_fd(int fd)
             set_pty_master_fd(-1);
             return;
         }
-        for (ssize_t i = 0; i < nread; ++i)
-            m_terminal.on_input(buffer[i]);
-        flush_dirty_lines();
+        m_terminal.on_input(buffer, nread);
+        flush_dirty_lines_soon();
     };
 }
 
@@ -106,6 +105,7 @@ TerminalWidget::TerminalWidget(int ptm_fd, bool automatic_size_policy, RefPtr<Co
     m_cursor_blink_timer = add<Core::Timer>();
     m_visual_beep_timer = add<Core::Timer>();
     m_auto_scroll_timer = add<Core::Timer>();
+    m_flush_timer = add<Core::Timer>();
 
     m_scrollbar = add<GUI::ScrollBar>(Orientation::Vertical);
     m_scrollbar->set_relative_rect(0, 0, 16, 0);
@@ -131,6 +131,16 @@ TerminalWidget::TerminalWidget(int ptm_fd, bool automatic_size_policy, RefPtr<Co
     };
     m_auto_scroll_timer->start();
 
+    m_flush_timer->set_single_shot(true);
+    m_flush_timer->set_interval(1000 / 60);
+    m_flush_timer->on_timeout = [this] {
+        if (!m_has_pending_flush)
+            return;
+        m_has_pending_flush = false;
+        flush_dirty_lines();
+        m_flush_timer->start();
+    };
+
     auto font_entry = m_config->read_entry("Text", "Font", "default");
     if (font_entry == "default")
         set_font(Gfx::FontDatabase::default_fixed_width_font());
@@ -332,6 +342,31 @@ void TerminalWidget::paint_event(GUI::PaintEvent& event)
         }
     }
 
+    auto should_reverse_fill_for_cursor_or_selection = [&](u16 visual_row, size_t column) {
+        if (m_cursor_blink_state && m_has_logical_focus && visual_row == row_with_cursor && column == m_terminal.cursor_column())
+            return true;
+        return selection_contains({ first_row_from_history + visual_row, (int)column });
+    };
+
+    // Neighbouring cells that look the same are painted together, so find where the run of them starting at a column ends.
+    auto end_of_run = [&](const VT::Line& line, u16 visual_row, size_t column) {
+        auto& attribute = line.attribute_at(column);
+        bool reversed = should_reverse_fill_for_cursor_or_selection(visual_row, column);
+        size_t end = column + 1;
+        for (; end < line.length(); ++end) {
+            auto& other_attribute = line.attribute_at(end);
+            if (other_attribute != attribute || other_attribute.href_id != attribute.href_id || other_attribute.href != attribute.href)
+                break;
+            if (should_reverse_fill_for_cursor_or_selection(visual_row, end) != reversed)
+                break;
+        }
+        return end;
+    };
+
+    auto run_rect = [&](u16 visual_row, size_t start, size_t end) {
+        return glyph_rect(visual_row, start).united(glyph_rect(visual_row, end - 1));
+    };
+
     // Pass: Paint background & text decorations.
     for (u16 visual_row = 0; visual_row < m_terminal.rows(); ++visual_row) {
         auto row_rect = this->row_rect(visual_row);
@@ -344,18 +379,16 @@ void TerminalWidget::paint_event(GUI::PaintEvent& event)
         else if (has_only_one_background_color)
             painter.clear_rect(row_rect, color_from_rgb(line.attribute_at(0).effective_background_color()).with_alpha(m_opacity));
 
-        for (size_t column = 0; column < line.length(); ++column) {
-            bool should_reverse_fill_for_cursor_or_selection = m_cursor_blink_state
-                && m_has_logical_focus
-                && visual_row == row_with_cursor
-                && column == m_terminal.cursor_column();
-            should_reverse_fill_for_cursor_or_selection |= selection_contains({ first_row_from_history + visual_row, (int)column });
-            auto attribute = line.attribute_at(column);
-            auto character_rect = glyph_rect(visual_row, column);
-            auto cell_rect = character_rect.inflated(0, m_line_spacing);
-            auto text_color = color_from_rgb(should_reverse_fill_for_cursor_or_selection ? attribute.effective_background_color() : attribute.effective_foreground_color());
-            if ((!visual_beep_active && !has_only_one_background_color) || should_reverse_fill_for_cursor_or_selection)
-                painter.clear_rect(cell_rect, color_from_rgb(should_reverse_fill_for_cursor_or_selection ? attribute.effective_foreground_color() : attribute.effective_background_color()));
+        for (size_t column = 0; column < line.length();) {
+            size_t end = end_of_run(line, visual_row, column);
+            bool reversed = should_reverse_fill_for_cursor_or_selection(visual_row, column);
+            auto& attribute = line.attribute_at(column);
+            auto cell_rect = run_rect(visual_row, column, end).inflated(0, m_line_spacing);
+            column = end;
+
+            auto text_color = color_from_rgb(reversed ? attribute.effective_background_color() : attribute.effective_foreground_color());
+            if ((!visual_beep_active && !has_only_one_background_color) || reversed)
+                painter.clear_rect(cell_rect, color_from_rgb(reversed ? attribute.effective_foreground_color() : attribute.effective_background_color()));
 
             enum class UnderlineStyle {
                 None,
@@ -406,30 +439,21 @@ void TerminalWidget::paint_event(GUI::PaintEvent& event)
         if (!event.rect().contains(row_rect))
             continue;
         auto& line = m_terminal.line(first_row_from_history + visual_row);
-        for (size_t column = 0; column < line.length(); ++column) {
-            auto attribute = line.attribute_at(column);
-            bool should_reverse_fill_for_cursor_or_selection = m_cursor_blink_state
-                && m_has_logical_focus
-                && visual_row == row_with_cursor
-                && column == m_terminal.cursor_column();
-            should_reverse_fill_for_cursor_or_selection |= selection_contains({ first_row_from_history + visual_row, (int)column });
-            auto text_color = color_from_rgb(should_reverse_fill_for_cursor_or_selection ? attribute.effective_background_color() : attribute.effective_foreground_color());
-            u32 code_point = line.code_point(column);
-
-            if (code_point == ' ')
-                continue;
-
-            auto character_rect = glyph_rect(visual_row, column);
-
-            if (!m_hovered_href_id.is_null() && attribute.href_id == m_hovered_href_id) {
+        for (size_t column = 0; column < line.length();) {
+            size_t end = end_of_run(line, visual_row, column);
+            bool reversed = should_reverse_fill_for_cursor_or_selection(visual_row, column);
+            auto& attribute = line.attribute_at(column);
+            auto text_color = color_from_rgb(reversed ? attribute.effective_background_color() : attribute.effective_foreground_color());
+            if (!m_hovered_href_id.is_null() && attribute.href_id == m_hovered_href_id)
                 text_color = palette().base_text();
-            }
+            auto& run_font = attribute.flags & VT::Attribute::Bold ? bold_font() : font();
 
-            painter.draw_glyph_or_emoji(
-                character_rect.location(),
-                code_point,
-                attribute.flags & VT::Attribute::Bold ? bold_font() : font(),
-                text_color);
+            for (; column < end; ++column) {
+                u32 code_point = line.code_point(column);
+                if (code_point == ' ')
+                    continue;
+                painter.draw_glyph_or_emoji(glyph_rect(visual_row, column).location(), code_point, run_font, text_color);
+            }
         }
     }
 
@@ -467,6 +491,17 @@ void TerminalWidget::invalidate_cursor()
     m_terminal.invalidate_cursor();
 }
 
+void TerminalWidget::flush_dirty_lines_soon()
+{
+    // While output keeps streaming in, repaint at most once per frame instead of after every read.
+    if (m_flush_timer->is_active()) {
+        m_has_pending_flush = true;
+        return;
+    }
+    flush_dirty_lines();
+    m_flush_timer->start();
+}
+
 void TerminalWidget::flush_dirty_lines()
 {
     // FIXME: Update smarter when scrolled
@@ -475,14 +510,20 @@ void TerminalWidget::flush_dirty_lines()
         m_terminal.m_need_full_flush = false;
         return;
     }
+    // Invalidate each block of neighbouring dirty rows separately, so that e.g. the cursor moving
+    // from the top to the bottom doesn't repaint everything in between.
     Gfx::IntRect rect;
     for (int i = 0; i < m_terminal.rows(); ++i) {
         if (m_terminal.visible_line(i).is_dirty()) {
             rect = rect.united(row_rect(i));
             m_terminal.visible_line(i).set_dirty(false);
+        } else if (!rect.is_empty()) {
+            update(rect);
+            rect = {};
         }
     }
-    update(rect);
+    if (!rect.is_empty())
+        update(rect);
 }
 
 void TerminalWidget::resize_event(GUI::ResizeEvent& event)
@@ -56,6 +56,7 @@ public:
     }
 
     void flush_dirty_lines();
+    void flush_dirty_lines_soon();
 
     void apply_size_increments_to_window(GUI::Window&);
 
@@ -93,6 +94,8 @@ public:
 
     size_t max_history_size() const { return m_terminal.max_history_size(); }
     void set_max_history_size(size_t value) { m_terminal.set_max_history_size(value); }
+    size_t max_history_bytes() const { return m_terminal.max_history_bytes(); }
+    void set_max_history_bytes(size_t value) { m_terminal.set_max_history_bytes(value); }
 
     GUI::Action& copy_action() { return *m_copy_action; }
     GUI::Action& paste_action() { return *m_paste_action; }
@@ -208,6 +211,8 @@ private:
     RefPtr<Core::Timer> m_cursor_blink_timer;
     RefPtr<Core::Timer> m_visual_beep_timer;
     RefPtr<Core::Timer> m_auto_scroll_timer;
+    RefPtr<Core::Timer> m_flush_timer;
+    bool m_has_pending_flush { false };
     RefPtr<Core::ConfigFile> m_config;
 
     RefPtr<GUI::ScrollBar> m_scrollbar;
@@ -34,9 +34,22 @@ Wrappable::~Wrappable()
 {
 }
 
+Wrapper* Wrappable::wrapper()
+{
+    // The wrapper may already be garbage that just hasn't been swept yet; handing it out again would resurrect it.
+    if (!m_wrapper || m_wrapper->is_awaiting_finalization())
+        return nullptr;
+    return m_wrapper;
+}
+
+const Wrapper* Wrappable::wrapper() const
+{
+    return const_cast<Wrappable&>(*this).wrapper();
+}
+
 void Wrappable::set_wrapper(Wrapper& wrapper)
 {
-    VERIFY(!m_wrapper);
+    VERIFY(!this->wrapper());
     m_wrapper = wrapper.make_weak_ptr();
 }
 
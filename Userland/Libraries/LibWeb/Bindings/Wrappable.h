@@ -38,8 +38,8 @@ public:
     virtual ~Wrappable();
 
     void set_wrapper(Wrapper&);
-    Wrapper* wrapper() { return m_wrapper; }
-    const Wrapper* wrapper() const { return m_wrapper; }
+    Wrapper* wrapper();
+    const Wrapper* wrapper() const;
 
 private:
     WeakPtr<Wrapper> m_wrapper;
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Array.h>
+#include <AK/HashFunctions.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
+
+namespace Web::CSS {
+
+// A counting Bloom filter over the tag names, ids and classes of the elements currently being
+// walked through. If it says an ancestor with some feature doesn't exist, that's certain, so
+// descendant selectors requiring it can be rejected without walking up the tree.
+class AncestorFilter {
+public:
+    static u32 hash_for_tag_name(const String& tag_name) { return pair_int_hash(tag_name.hash(), 1); }
+    static u32 hash_for_id(const String& id) { return pair_int_hash(id.hash(), 2); }
+    static u32 hash_for_class(const String& class_name) { return pair_int_hash(class_name.hash(), 3); }
+
+    void add(u32 hash)
+    {
+        increment(first_slot(hash));
+        increment(second_slot(hash));
+    }
+
+    void remove(u32 hash)
+    {
+        decrement(first_slot(hash));
+        decrement(second_slot(hash));
+    }
+
+    bool may_contain(u32 hash) const { return m_counters[first_slot(hash)] && m_counters[second_slot(hash)]; }
+
+    bool may_contain_all(const Vector<u32>& hashes) const
+    {
+        for (auto hash : hashes) {
+            if (!may_contain(hash))
+                return false;
+        }
+        return true;
+    }
+
+private:
+    static constexpr size_t key_bits = 12;
+    static constexpr u32 key_mask = (1 << key_bits) - 1;
+    static constexpr u8 max_count = 0xff;
+
+    static size_t first_slot(u32 hash) { return hash & key_mask; }
+    static size_t second_slot(u32 hash) { return (hash >> 16) & key_mask; }
+
+    // Saturated counters stay put, so removing things can never make the filter lie.
+    void increment(size_t slot)
+    {
+        if (m_counters[slot] != max_count)
+            ++m_counters[slot];
+    }
+
+    void decrement(size_t slot)
+    {
+        VERIFY(m_counters[slot]);
+        if (m_counters[slot] != max_count)
+            --m_counters[slot];
+    }
+
+    Array<u8, 1 << key_bits> m_counters {};
+};
+
+}
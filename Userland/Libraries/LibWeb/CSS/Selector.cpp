@@ -24,6 +24,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <LibWeb/CSS/AncestorFilter.h>
 #include <LibWeb/CSS/Selector.h>
 
 namespace Web::CSS {
@@ -31,6 +32,7 @@ namespace Web::CSS {
 Selector::Selector(Vector<ComplexSelector>&& component_lists)
     : m_complex_selectors(move(component_lists))
 {
+    collect_ancestor_hashes();
 }
 
 Selector::~Selector()
@@ -64,4 +66,31 @@ u32 Selector::specificity() const
     return ids * 0x10000 + classes * 0x100 + tag_names;
 }
 
+void Selector::collect_ancestor_hashes()
+{
+    // Walk leftwards from the subject for as long as each compound selector has to match an ancestor.
+    // Past a sibling combinator we stop, since those compounds aren't necessarily ancestors.
+    for (size_t i = m_complex_selectors.size(); i > 1; --i) {
+        auto relation = m_complex_selectors[i - 1].relation;
+        if (relation != ComplexSelector::Relation::Descendant && relation != ComplexSelector::Relation::ImmediateChild)
+            break;
+
+        for (auto& simple_selector : m_complex_selectors[i - 2].compound_selector) {
+            switch (simple_selector.type) {
+            case SimpleSelector::Type::Id:
+                m_ancestor_hashes.append(AncestorFilter::hash_for_id(simple_selector.value));
+                break;
+            case SimpleSelector::Type::Class:
+                m_ancestor_hashes.append(AncestorFilter::hash_for_class(simple_selector.value));
+                break;
+            case SimpleSelector::Type::TagName:
+                m_ancestor_hashes.append(AncestorFilter::hash_for_tag_name(simple_selector.value));
+                break;
+            default:
+                break;
+            }
+        }
+    }
+}
+
 }
@@ -99,8 +99,14 @@ public:
 
     u32 specificity() const;
 
+    // Hashes (see AncestorFilter) of features that some ancestor of a matching element must have.
+    const Vector<u32>& ancestor_hashes() const { return m_ancestor_hashes; }
+
 private:
+    void collect_ancestor_hashes();
+
     Vector<ComplexSelector> m_complex_selectors;
+    Vector<u32> m_ancestor_hashes;
 };
 
 }
@@ -31,7 +31,10 @@
 #include <LibWeb/CSS/StyleSheet.h>
 #include <LibWeb/DOM/Document.h>
 #include <LibWeb/DOM/Element.h>
+#include <LibWeb/DOM/Text.h>
 #include <LibWeb/Dump.h>
+#include <LibWeb/HTML/AttributeNames.h>
+#include <LibWeb/RenderingStatistics.h>
 #include <ctype.h>
 #include <stdio.h>
 
@@ -79,9 +82,32 @@ void StyleResolver::for_each_stylesheet(Callback callback) const
     }
 }
 
-Vector<MatchingRule> StyleResolver::collect_matching_rules(const DOM::Element& element) const
+void StyleResolver::invalidate_rule_cache()
 {
-    Vector<MatchingRule> matching_rules;
+    m_rule_cache = nullptr;
+    for (auto& ancestor : m_ancestors)
+        ancestor.shareable_styles.clear();
+}
+
+const StyleResolver::RuleCache& StyleResolver::rule_cache() const
+{
+    if (!m_rule_cache || m_rule_cache->built_in_quirks_mode != document().in_quirks_mode())
+        build_rule_cache();
+    return *m_rule_cache;
+}
+
+void StyleResolver::build_rule_cache() const
+{
+    auto rule_cache = make<RuleCache>();
+    rule_cache->built_in_quirks_mode = document().in_quirks_mode();
+
+    auto find_simple_selector = [](auto& compound_selector, Selector::SimpleSelector::Type type) -> const Selector::SimpleSelector* {
+        for (auto& simple_selector : compound_selector) {
+            if (simple_selector.type == type)
+                return &simple_selector;
+        }
+        return nullptr;
+    };
 
     size_t style_sheet_index = 0;
     for_each_stylesheet([&](auto& sheet) {
@@ -89,10 +115,38 @@ Vector<MatchingRule> StyleResolver::collect_matching_rules(const DOM::Element& e
         for (auto& rule : sheet.rules()) {
             size_t selector_index = 0;
             for (auto& selector : rule.selectors()) {
-                if (SelectorEngine::matches(selector, element)) {
-                    matching_rules.append({ rule, style_sheet_index, rule_index, selector_index });
-                    break;
+                for (auto& complex_selector : selector.complex_selectors()) {
+                    if (complex_selector.relation == Selector::ComplexSelector::Relation::AdjacentSibling || complex_selector.relation == Selector::ComplexSelector::Relation::GeneralSibling)
+                        rule_cache->has_sibling_combinators = true;
+                    for (auto& simple_selector : complex_selector.compound_selector) {
+                        switch (simple_selector.pseudo_class) {
+                        case Selector::SimpleSelector::PseudoClass::FirstChild:
+                        case Selector::SimpleSelector::PseudoClass::LastChild:
+                        case Selector::SimpleSelector::PseudoClass::OnlyChild:
+                            rule_cache->has_child_position_pseudo_classes = true;
+                            break;
+                        case Selector::SimpleSelector::PseudoClass::Empty:
+                            rule_cache->has_empty_pseudo_class = true;
+                            break;
+                        case Selector::SimpleSelector::PseudoClass::Hover:
+                            rule_cache->has_hover_pseudo_class = true;
+                            break;
+                        default:
+                            break;
+                        }
+                    }
                 }
+
+                MatchingRule matching_rule { rule, style_sheet_index, rule_index, selector_index };
+                auto& rightmost_compound_selector = selector.complex_selectors().last().compound_selector;
+                if (auto* simple_selector = find_simple_selector(rightmost_compound_selector, Selector::SimpleSelector::Type::Id))
+                    rule_cache->rules_by_id.ensure(simple_selector->value).append(move(matching_rule));
+                else if (auto* simple_selector = find_simple_selector(rightmost_compound_selector, Selector::SimpleSelector::Type::Class))
+                    rule_cache->rules_by_class.ensure(simple_selector->value).append(move(matching_rule));
+                else if (auto* simple_selector = find_simple_selector(rightmost_compound_selector, Selector::SimpleSelector::Type::TagName))
+                    rule_cache->rules_by_tag_name.ensure(simple_selector->value).append(move(matching_rule));
+                else
+                    rule_cache->other_rules.append(move(matching_rule));
                 ++selector_index;
             }
             ++rule_index;
@@ -100,7 +154,102 @@ Vector<MatchingRule> StyleResolver::collect_matching_rules(const DOM::Element& e
         ++style_sheet_index;
     });
 
-    return matching_rules;
+    m_rule_cache = move(rule_cache);
+}
+
+static const DOM::Element* element_ancestor(const DOM::Element& element)
+{
+    for (auto* ancestor = element.parent(); ancestor; ancestor = ancestor->parent()) {
+        if (is<DOM::Element>(*ancestor))
+            return downcast<DOM::Element>(ancestor);
+    }
+    return nullptr;
+}
+
+void StyleResolver::push_ancestor(const DOM::Element& element)
+{
+    Ancestor ancestor;
+    ancestor.element = &element;
+
+    // The filter may hold more than the element's ancestors (e.g. across a shadow root boundary), but never less.
+    auto* parent = element_ancestor(element);
+    ancestor.filter_covers_all_ancestors = !parent || (!m_ancestors.is_empty() && m_ancestors.last().element == parent && m_ancestors.last().filter_covers_all_ancestors);
+
+    ancestor.hashes.append(AncestorFilter::hash_for_tag_name(element.local_name()));
+    if (auto id = element.attribute(HTML::AttributeNames::id); !id.is_empty())
+        ancestor.hashes.append(AncestorFilter::hash_for_id(id));
+    for (auto& class_name : element.class_names())
+        ancestor.hashes.append(AncestorFilter::hash_for_class(class_name));
+
+    for (auto hash : ancestor.hashes)
+        m_ancestor_filter.add(hash);
+    m_ancestors.append(move(ancestor));
+}
+
+void StyleResolver::pop_ancestor(const DOM::Element& element)
+{
+    VERIFY(!m_ancestors.is_empty());
+    VERIFY(m_ancestors.last().element == &element);
+    auto ancestor = m_ancestors.take_last();
+    for (auto hash : ancestor.hashes)
+        m_ancestor_filter.remove(hash);
+}
+
+bool StyleResolver::can_use_ancestor_filter_for(const DOM::Element& element) const
+{
+    if (m_ancestors.is_empty())
+        return false;
+    auto& last_ancestor = m_ancestors.last();
+    return last_ancestor.filter_covers_all_ancestors && last_ancestor.element == element_ancestor(element);
+}
+
+Vector<MatchingRule> StyleResolver::collect_matching_rules(const DOM::Element& element) const
+{
+    auto& rule_cache = this->rule_cache();
+    bool use_ancestor_filter = can_use_ancestor_filter_for(element);
+
+    Vector<MatchingRule> matching_rules;
+    auto add_matching_rules = [&](const Vector<MatchingRule>& rules) {
+        for (auto& rule_to_run : rules) {
+            auto& selector = rule_to_run.rule->selectors()[rule_to_run.selector_index];
+            if (use_ancestor_filter && !m_ancestor_filter.may_contain_all(selector.ancestor_hashes()))
+                continue;
+            if (SelectorEngine::matches(selector, element))
+                matching_rules.append(rule_to_run);
+        }
+    };
+
+    if (auto id = element.attribute(HTML::AttributeNames::id); !id.is_empty()) {
+        if (auto it = rule_cache.rules_by_id.find(id); it != rule_cache.rules_by_id.end())
+            add_matching_rules(it->value);
+    }
+    for (auto& class_name : element.class_names()) {
+        if (auto it = rule_cache.rules_by_class.find(class_name); it != rule_cache.rules_by_class.end())
+            add_matching_rules(it->value);
+    }
+    if (auto it = rule_cache.rules_by_tag_name.find(element.local_name()); it != rule_cache.rules_by_tag_name.end())
+        add_matching_rules(it->value);
+    add_matching_rules(rule_cache.other_rules);
+
+    // A rule applies only once, through the first of its selectors that matches.
+    quick_sort(matching_rules, [](auto& a, auto& b) {
+        if (a.style_sheet_index != b.style_sheet_index)
+            return a.style_sheet_index < b.style_sheet_index;
+        if (a.rule_index != b.rule_index)
+            return a.rule_index < b.rule_index;
+        return a.selector_index < b.selector_index;
+    });
+    Vector<MatchingRule> unique_matching_rules;
+    unique_matching_rules.ensure_capacity(matching_rules.size());
+    for (auto& matching_rule : matching_rules) {
+        if (!unique_matching_rules.is_empty()
+            && unique_matching_rules.last().style_sheet_index == matching_rule.style_sheet_index
+            && unique_matching_rules.last().rule_index == matching_rule.rule_index)
+            continue;
+        unique_matching_rules.unchecked_append(move(matching_rule));
+    }
+
+    return unique_matching_rules;
 }
 
 void StyleResolver::sort_matching_rules(Vector<MatchingRule>& matching_rules) const
@@ -570,7 +719,90 @@ static void set_property_expanding_shorthands(StyleProperties& style, CSS::Prope
     style.set_property(property_id, value);
 }
 
+bool StyleResolver::can_share_style(const DOM::Element& element) const
+{
+    // Sharing is limited to children of the element on top of the ancestor stack, which are styled
+    // one after the other against the same parent style while the layout tree is built.
+    if (m_ancestors.is_empty() || element.parent() != m_ancestors.last().element)
+        return false;
+    if (element.inline_style() || element.has_attribute(HTML::AttributeNames::id))
+        return false;
+    return !rule_cache().has_sibling_combinators;
+}
+
+static bool has_same_attributes(const DOM::Element& a, const DOM::Element& b)
+{
+    size_t a_attribute_count = 0;
+    bool all_attributes_match = true;
+    a.for_each_attribute([&](auto& name, auto& value) {
+        ++a_attribute_count;
+        if (b.attribute(name) != value)
+            all_attributes_match = false;
+    });
+    if (!all_attributes_match)
+        return false;
+
+    size_t b_attribute_count = 0;
+    b.for_each_attribute([&](auto&, auto&) { ++b_attribute_count; });
+    return a_attribute_count == b_attribute_count;
+}
+
+static bool is_hovered_or_contains_hovered_node(const DOM::Element& element)
+{
+    auto* hovered_node = element.document().hovered_node();
+    return hovered_node && (hovered_node == &element || element.is_ancestor_of(*hovered_node));
+}
+
+static bool is_empty_for_selectors(const DOM::Element& element)
+{
+    return !element.first_child_of_type<DOM::Element>() && !element.first_child_of_type<DOM::Text>();
+}
+
+bool StyleResolver::can_share_style_between(const DOM::Element& element, const DOM::Element& candidate) const
+{
+    // Siblings with the same element type and attributes match the same rules and get the same presentational
+    // hints, except for selectors that look at their position among siblings, their contents or hover state.
+    if (element.local_name() != candidate.local_name() || element.namespace_() != candidate.namespace_())
+        return false;
+    if (!has_same_attributes(element, candidate))
+        return false;
+
+    auto& rule_cache = this->rule_cache();
+    if (rule_cache.has_child_position_pseudo_classes) {
+        if (!element.previous_element_sibling() != !candidate.previous_element_sibling())
+            return false;
+        if (!element.next_element_sibling() != !candidate.next_element_sibling())
+            return false;
+    }
+    if (rule_cache.has_empty_pseudo_class && is_empty_for_selectors(element) != is_empty_for_selectors(candidate))
+        return false;
+    if (rule_cache.has_hover_pseudo_class && is_hovered_or_contains_hovered_node(element) != is_hovered_or_contains_hovered_node(candidate))
+        return false;
+    return true;
+}
+
 NonnullRefPtr<StyleProperties> StyleResolver::resolve_style(const DOM::Element& element) const
+{
+    RenderingStatistics::Scope statistics_scope(RenderingStatistics::Phase::Style);
+    if (!can_share_style(element))
+        return compute_style(element);
+
+    auto& shareable_styles = m_ancestors.last().shareable_styles;
+    for (auto& shared_style : shareable_styles) {
+        if (can_share_style_between(element, *shared_style.element))
+            return shared_style.style;
+    }
+
+    auto style = compute_style(element);
+
+    static constexpr size_t max_shareable_styles = 8;
+    if (shareable_styles.size() == max_shareable_styles)
+        shareable_styles.take_first();
+    shareable_styles.append({ &element, style });
+    return style;
+}
+
+NonnullRefPtr<StyleProperties> StyleResolver::compute_style(const DOM::Element& element) const
 {
     auto style = StyleProperties::create();
 
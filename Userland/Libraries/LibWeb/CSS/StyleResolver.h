@@ -26,8 +26,11 @@
 
 #pragma once
 
+#include <AK/FlyString.h>
+#include <AK/HashMap.h>
 #include <AK/NonnullRefPtrVector.h>
 #include <AK/OwnPtr.h>
+#include <LibWeb/CSS/AncestorFilter.h>
 #include <LibWeb/CSS/StyleProperties.h>
 #include <LibWeb/Forward.h>
 
@@ -55,11 +58,61 @@ public:
 
     static bool is_inherited_property(CSS::PropertyID);
 
+    void invalidate_rule_cache();
+
+    // While the layout tree is built, the elements whose children are being styled are pushed here,
+    // which lets descendant selectors that can't match be skipped without walking up the tree.
+    void push_ancestor(const DOM::Element&);
+    void pop_ancestor(const DOM::Element&);
+
 private:
     template<typename Callback>
     void for_each_stylesheet(Callback) const;
 
+    // Every selector is filed under the most specific feature of its rightmost compound selector,
+    // so an element only has to be matched against the rules that could possibly apply to it.
+    struct RuleCache {
+        HashMap<FlyString, Vector<MatchingRule>> rules_by_id;
+        HashMap<FlyString, Vector<MatchingRule>> rules_by_class;
+        HashMap<FlyString, Vector<MatchingRule>> rules_by_tag_name;
+        Vector<MatchingRule> other_rules;
+        bool built_in_quirks_mode { false };
+
+        // Selectors that look at siblings, children or hover state make otherwise identical siblings style differently.
+        bool has_sibling_combinators { false };
+        bool has_child_position_pseudo_classes { false };
+        bool has_empty_pseudo_class { false };
+        bool has_hover_pseudo_class { false };
+    };
+
+    const RuleCache& rule_cache() const;
+    void build_rule_cache() const;
+
+    NonnullRefPtr<StyleProperties> compute_style(const DOM::Element&) const;
+
+    struct SharedStyle {
+        const DOM::Element* element { nullptr };
+        NonnullRefPtr<StyleProperties> style;
+    };
+
+    struct Ancestor {
+        const DOM::Element* element { nullptr };
+        Vector<u32> hashes;
+        bool filter_covers_all_ancestors { false };
+
+        // Styles of recently styled children, which their later siblings may be able to reuse.
+        mutable Vector<SharedStyle> shareable_styles;
+    };
+
+    bool can_use_ancestor_filter_for(const DOM::Element&) const;
+
+    bool can_share_style(const DOM::Element&) const;
+    bool can_share_style_between(const DOM::Element&, const DOM::Element&) const;
+
     DOM::Document& m_document;
+    mutable OwnPtr<RuleCache> m_rule_cache;
+    Vector<Ancestor> m_ancestors;
+    AncestorFilter m_ancestor_filter;
 };
 
 }
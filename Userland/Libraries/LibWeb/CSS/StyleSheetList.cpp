@@ -25,12 +25,14 @@
  */
 
 #include <LibWeb/CSS/StyleSheetList.h>
+#include <LibWeb/DOM/Document.h>
 
 namespace Web::CSS {
 
 void StyleSheetList::add_sheet(NonnullRefPtr<StyleSheet> sheet)
 {
     m_sheets.append(move(sheet));
+    m_document.style_resolver().invalidate_rule_cache();
 }
 
 StyleSheetList::StyleSheetList(DOM::Document& document)
@@ -29,6 +29,7 @@
 #include <LibWeb/CSS/StyleValue.h>
 #include <LibWeb/DOM/Document.h>
 #include <LibWeb/InProcessWebView.h>
+#include <LibWeb/Layout/InitialContainingBlockBox.h>
 #include <LibWeb/Loader/LoadRequest.h>
 #include <LibWeb/Loader/ResourceLoader.h>
 #include <LibWeb/Page/Frame.h>
@@ -181,13 +182,24 @@ ImageStyleValue::ImageStyleValue(const URL& url, DOM::Document& document)
 }
 
 void ImageStyleValue::resource_did_load()
+{
+    resource()->decode_if_needed();
+}
+
+void ImageStyleValue::resource_did_decode()
 {
     if (!m_document)
         return;
-    m_bitmap = resource()->bitmap();
     // FIXME: Do less than a full repaint if possible?
-    if (m_document->frame())
-        m_document->frame()->set_needs_display({});
+    if (auto* layout_root = m_document->layout_node())
+        layout_root->set_needs_display();
+}
+
+const Gfx::Bitmap* ImageStyleValue::bitmap() const
+{
+    if (!resource())
+        return nullptr;
+    return resource()->bitmap();
 }
 
 }
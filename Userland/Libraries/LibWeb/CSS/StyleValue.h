@@ -350,7 +350,7 @@ public:
 
     String to_string() const override { return String::formatted("Image({})", m_url.to_string()); }
 
-    const Gfx::Bitmap* bitmap() const { return m_bitmap; }
+    const Gfx::Bitmap* bitmap() const;
 
 private:
     ImageStyleValue(const URL&, DOM::Document&);
@@ -358,9 +358,11 @@ private:
     // ^ResourceClient
     virtual void resource_did_load() override;
 
+    // ^ImageResourceClient
+    virtual void resource_did_decode() override;
+
     URL m_url;
     WeakPtr<DOM::Document> m_document;
-    RefPtr<Gfx::Bitmap> m_bitmap;
 };
 
 inline CSS::ValueID StyleValue::to_identifier() const
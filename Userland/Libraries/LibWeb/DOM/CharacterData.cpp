@@ -44,8 +44,8 @@ void CharacterData::set_data(String data)
     if (m_data == data)
         return;
     m_data = move(data);
-    // FIXME: This is definitely too aggressive.
-    document().schedule_forced_layout();
+    // Text nodes read their data at layout time, so the layout tree itself can stay.
+    document().schedule_layout_update();
 }
 
 }
@@ -24,9 +24,11 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/QuickSort.h>
 #include <AK/StringBuilder.h>
 #include <AK/Utf8View.h>
 #include <LibCore/Timer.h>
+#include <LibCore/Trace.h>
 #include <LibJS/Interpreter.h>
 #include <LibJS/Parser.h>
 #include <LibJS/Runtime/Function.h>
@@ -57,10 +59,12 @@
 #include <LibWeb/InProcessWebView.h>
 #include <LibWeb/Layout/BlockFormattingContext.h>
 #include <LibWeb/Layout/InitialContainingBlockBox.h>
+#include <LibWeb/Layout/ListItemBox.h>
 #include <LibWeb/Layout/TreeBuilder.h>
 #include <LibWeb/Namespace.h>
 #include <LibWeb/Origin.h>
 #include <LibWeb/Page/Frame.h>
+#include <LibWeb/RenderingStatistics.h>
 #include <LibWeb/SVG/TagNames.h>
 #include <ctype.h>
 
@@ -81,6 +85,10 @@ Document::Document(const URL& url)
     m_forced_layout_timer = Core::Timer::create_single_shot(0, [this] {
         force_layout();
     });
+
+    m_layout_update_timer = Core::Timer::create_single_shot(0, [this] {
+        update_layout();
+    });
 }
 
 Document::~Document()
@@ -166,6 +174,13 @@ void Document::schedule_forced_layout()
     m_forced_layout_timer->start();
 }
 
+void Document::schedule_layout_update()
+{
+    if (m_layout_update_timer->is_active())
+        return;
+    m_layout_update_timer->start();
+}
+
 bool Document::is_child_allowed(const Node& node) const
 {
     switch (node.type()) {
@@ -381,10 +396,9 @@ void Document::update_layout()
     if (!frame())
         return;
 
-    if (!m_layout_root) {
-        Layout::TreeBuilder tree_builder;
-        m_layout_root = static_ptr_cast<Layout::InitialContainingBlockBox>(tree_builder.build(*this));
-    }
+    RenderingStatistics::Scope statistics_scope(RenderingStatistics::Phase::Layout);
+    TRACE_SCOPE("web", "Document::update_layout");
+    update_layout_tree();
 
     Layout::BlockFormattingContext root_formatting_context(*m_layout_root, nullptr);
     root_formatting_context.run(*m_layout_root, Layout::LayoutMode::Default);
@@ -397,6 +411,80 @@ void Document::update_layout()
     }
 }
 
+static void clear_layout_tree_update_flags(DOM::Node& node)
+{
+    node.for_each_in_subtree([&](auto& descendant) {
+        descendant.set_needs_layout_tree_update(false);
+        descendant.set_child_needs_layout_tree_update(false);
+        return IterationDecision::Continue;
+    });
+}
+
+// Returns the node whose layout children we can regenerate in place without disturbing anything outside of it.
+// Inline boxes share line boxes and anonymous wrappers with their siblings, so we climb to the nearest block container.
+static DOM::Node* layout_tree_rebuild_root_for(DOM::Node& node)
+{
+    for (auto* candidate = &node; candidate && !candidate->is_document(); candidate = candidate->parent()) {
+        auto* layout_node = candidate->layout_node();
+        if (!layout_node || !is<Layout::NodeWithStyle>(*layout_node) || !layout_node->can_have_children())
+            continue;
+        if (layout_node->is_inline() || is<Layout::ListItemBox>(*layout_node))
+            continue;
+        return candidate;
+    }
+    return nullptr;
+}
+
+static bool rebuild_dirty_layout_subtrees(DOM::Node& node)
+{
+    bool success = true;
+    node.for_each_child([&](auto& child) {
+        if (child.needs_layout_tree_update()) {
+            auto* rebuild_root = layout_tree_rebuild_root_for(child);
+            if (!rebuild_root) {
+                success = false;
+                return IterationDecision::Break;
+            }
+            Layout::TreeBuilder().rebuild_children(*rebuild_root);
+            clear_layout_tree_update_flags(*rebuild_root);
+            return IterationDecision::Continue;
+        }
+        if (child.child_needs_layout_tree_update()) {
+            if (!rebuild_dirty_layout_subtrees(child)) {
+                success = false;
+                return IterationDecision::Break;
+            }
+            child.set_child_needs_layout_tree_update(false);
+        }
+        return IterationDecision::Continue;
+    });
+    return success;
+}
+
+void Document::update_layout_tree()
+{
+    if (m_layout_root && !needs_layout_tree_update() && child_needs_layout_tree_update()) {
+        // Only regenerate the layout nodes below the DOM nodes whose children changed.
+        // If one of them can't be rebuilt in isolation, fall back to building the whole tree.
+        if (rebuild_dirty_layout_subtrees(*this)) {
+            set_child_needs_layout_tree_update(false);
+            // The selection may be anchored in layout nodes we just threw away.
+            m_layout_root->set_selection({});
+            return;
+        }
+        tear_down_layout_tree();
+    } else if (needs_layout_tree_update()) {
+        tear_down_layout_tree();
+    }
+
+    if (!m_layout_root) {
+        Layout::TreeBuilder tree_builder;
+        m_layout_root = static_ptr_cast<Layout::InitialContainingBlockBox>(tree_builder.build(*this));
+    }
+
+    clear_layout_tree_update_flags(*this);
+}
+
 static void update_style_recursively(DOM::Node& node)
 {
     node.for_each_child([&](auto& child) {
@@ -501,17 +589,123 @@ NonnullRefPtrVector<Element> Document::get_elements_by_tag_name(const FlyString&
     return elements;
 }
 
+// Compares the positions of two nodes in the same tree, without walking everything in between like TreeNode::is_before().
+static bool precedes_in_tree_order(const Node& a, const Node& b)
+{
+    if (&a == &b)
+        return false;
+
+    Vector<const Node*, 32> a_ancestors;
+    for (auto* node = &a; node; node = node->parent())
+        a_ancestors.append(node);
+    Vector<const Node*, 32> b_ancestors;
+    for (auto* node = &b; node; node = node->parent())
+        b_ancestors.append(node);
+
+    // Walk down from the root until the paths to `a` and `b` split up.
+    size_t a_index = a_ancestors.size();
+    size_t b_index = b_ancestors.size();
+    while (a_index > 0 && b_index > 0 && a_ancestors[a_index - 1] == b_ancestors[b_index - 1]) {
+        --a_index;
+        --b_index;
+    }
+    if (a_index == 0)
+        return true;
+    if (b_index == 0)
+        return false;
+
+    for (auto* sibling = a_ancestors[a_index - 1]->next_sibling(); sibling; sibling = sibling->next_sibling()) {
+        if (sibling == b_ancestors[b_index - 1])
+            return true;
+    }
+    return false;
+}
+
+RefPtr<Element> Document::get_element_by_id(const FlyString& id) const
+{
+    auto it = m_elements_by_id.find(id);
+    if (it == m_elements_by_id.end())
+        return nullptr;
+
+    // Ids should be unique, but when they aren't, the first element in tree order wins.
+    Element* first = it->value.first();
+    for (size_t i = 1; i < it->value.size(); ++i) {
+        if (precedes_in_tree_order(*it->value[i], *first))
+            first = it->value[i];
+    }
+    return first;
+}
+
 NonnullRefPtrVector<Element> Document::get_elements_by_class_name(const FlyString& class_name) const
 {
+    auto it = m_elements_by_class.find(class_name.to_lowercase());
+    if (it == m_elements_by_class.end())
+        return {};
+
+    auto& entry = it->value;
+    if (!entry.elements_in_tree_order.has_value()) {
+        Vector<Element*> elements;
+        // Sorting compares paths through the tree, so for many elements, walking the tree once is cheaper.
+        if (entry.elements.size() <= 32) {
+            for (auto* element : entry.elements)
+                elements.append(element);
+            quick_sort(elements, [](auto* a, auto* b) { return precedes_in_tree_order(*a, *b); });
+        } else {
+            for_each_in_subtree_of_type<Element>([&](auto& element) {
+                if (entry.elements.contains(const_cast<Element*>(&element)))
+                    elements.append(const_cast<Element*>(&element));
+                return IterationDecision::Continue;
+            });
+        }
+        entry.elements_in_tree_order = move(elements);
+    }
+
+    // The index is case-insensitive, so in no-quirks mode we still have to check the exact class name.
+    auto case_sensitivity = in_quirks_mode() ? CaseSensitivity::CaseInsensitive : CaseSensitivity::CaseSensitive;
     NonnullRefPtrVector<Element> elements;
-    for_each_in_subtree_of_type<Element>([&](auto& element) {
-        if (element.has_class(class_name, in_quirks_mode() ? CaseSensitivity::CaseInsensitive : CaseSensitivity::CaseSensitive))
-            elements.append(element);
-        return IterationDecision::Continue;
-    });
+    for (auto* element : *entry.elements_in_tree_order) {
+        if (element->has_class(class_name, case_sensitivity))
+            elements.append(*element);
+    }
     return elements;
 }
 
+void Document::add_to_element_indexes(Element& element)
+{
+    auto id = element.attribute(HTML::AttributeNames::id);
+    if (!id.is_empty())
+        m_elements_by_id.ensure(id).append(&element);
+
+    for (auto& class_name : element.class_names()) {
+        auto& entry = m_elements_by_class.ensure(class_name.to_lowercase());
+        entry.elements.set(&element);
+        entry.elements_in_tree_order.clear();
+    }
+}
+
+void Document::remove_from_element_indexes(Element& element)
+{
+    auto id = element.attribute(HTML::AttributeNames::id);
+    if (!id.is_empty()) {
+        auto it = m_elements_by_id.find(id);
+        if (it != m_elements_by_id.end()) {
+            it->value.remove_first_matching([&](auto* other) { return other == &element; });
+            if (it->value.is_empty())
+                m_elements_by_id.remove(it);
+        }
+    }
+
+    for (auto& class_name : element.class_names()) {
+        auto it = m_elements_by_class.find(class_name.to_lowercase());
+        if (it == m_elements_by_class.end())
+            continue;
+        it->value.elements.remove(&element);
+        it->value.elements_in_tree_order.clear();
+        if (it->value.elements.is_empty())
+            m_elements_by_class.remove(it);
+    }
+}
+
 Color Document::link_color() const
 {
     if (m_link_color.has_value())
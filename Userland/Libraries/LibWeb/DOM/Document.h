@@ -28,6 +28,8 @@
 
 #include <AK/FlyString.h>
 #include <AK/Function.h>
+#include <AK/HashMap.h>
+#include <AK/HashTable.h>
 #include <AK/NonnullRefPtrVector.h>
 #include <AK/OwnPtr.h>
 #include <AK/String.h>
@@ -147,11 +149,20 @@ public:
 
     void schedule_style_update();
     void schedule_forced_layout();
+    void schedule_layout_update();
 
     NonnullRefPtrVector<Element> get_elements_by_name(const String&) const;
     NonnullRefPtrVector<Element> get_elements_by_tag_name(const FlyString&) const;
     NonnullRefPtrVector<Element> get_elements_by_class_name(const FlyString&) const;
 
+    // Looks the element up in the index, instead of walking the tree like NonElementParentNode does.
+    RefPtr<Element> get_element_by_id(const FlyString&) const;
+
+    // The elements in the document tree (not counting shadow trees) are indexed by id and by class.
+    // These keep the indexes up to date as elements enter or leave the tree, or change their id or classes.
+    void add_to_element_indexes(Element&);
+    void remove_from_element_indexes(Element&);
+
     const String& source() const { return m_source; }
     void set_source(const String& source) { m_source = source; }
 
@@ -256,6 +267,7 @@ private:
     virtual EventTarget& global_event_handlers_to_event_target() final { return *this; }
 
     void tear_down_layout_tree();
+    void update_layout_tree();
 
     void increment_referencing_node_count()
     {
@@ -293,6 +305,7 @@ private:
 
     RefPtr<Core::Timer> m_style_update_timer;
     RefPtr<Core::Timer> m_forced_layout_timer;
+    RefPtr<Core::Timer> m_layout_update_timer;
 
     String m_source;
 
@@ -322,6 +335,16 @@ private:
     bool m_should_invalidate_styles_on_attribute_changes { true };
 
     u32 m_ignore_destructive_writes_counter { 0 };
+
+    HashMap<FlyString, Vector<Element*, 1>> m_elements_by_id;
+
+    struct ElementsWithClass {
+        HashTable<Element*> elements;
+        // Sorted on demand, and kept until the set of elements changes.
+        Optional<Vector<Element*>> elements_in_tree_order;
+    };
+    // Keyed by the lowercase class name, so that quirks mode can look classes up case-insensitively.
+    mutable HashMap<FlyString, ElementsWithClass> m_elements_by_class;
 };
 
 }
@@ -44,7 +44,6 @@
 #include <LibWeb/Layout/TableCellBox.h>
 #include <LibWeb/Layout/TableRowBox.h>
 #include <LibWeb/Layout/TableRowGroupBox.h>
-#include <LibWeb/Layout/TreeBuilder.h>
 #include <LibWeb/Namespace.h>
 
 namespace Web::DOM {
@@ -92,12 +91,19 @@ ExceptionOr<void> Element::set_attribute(const FlyString& name, const String& va
 
     CSS::StyleInvalidator style_invalidator(document());
 
+    auto* indexing_document = document_indexing_attribute(name);
+    if (indexing_document)
+        indexing_document->remove_from_element_indexes(*this);
+
     if (auto* attribute = find_attribute(name))
         attribute->set_value(value);
     else
         m_attributes.empend(name, value);
 
     parse_attribute(name, value);
+
+    if (indexing_document)
+        indexing_document->add_to_element_indexes(*this);
     return {};
 }
 
@@ -105,7 +111,27 @@ void Element::remove_attribute(const FlyString& name)
 {
     CSS::StyleInvalidator style_invalidator(document());
 
+    auto* indexing_document = document_indexing_attribute(name);
+    if (indexing_document)
+        indexing_document->remove_from_element_indexes(*this);
+
     m_attributes.remove_first_matching([&](auto& attribute) { return attribute.name() == name; });
+    if (name == HTML::AttributeNames::class_)
+        m_classes.clear();
+
+    if (indexing_document)
+        indexing_document->add_to_element_indexes(*this);
+}
+
+// The document whose id and class indexes need to follow changes of the given attribute, if any.
+Document* Element::document_indexing_attribute(const FlyString& name)
+{
+    if (name != HTML::AttributeNames::id && name != HTML::AttributeNames::class_)
+        return nullptr;
+    auto* root = this->root();
+    if (!root->is_document())
+        return nullptr;
+    return &downcast<Document>(*root);
 }
 
 bool Element::has_class(const FlyString& class_name, CaseSensitivity case_sensitivity) const
@@ -221,9 +247,17 @@ void Element::recompute_style()
     if (!layout_node()) {
         if (new_specified_css_values->display() == CSS::Display::None)
             return;
-        // We need a new layout tree here!
-        Layout::TreeBuilder tree_builder;
-        tree_builder.build(*this);
+        // If our parent isn't rendered, we won't be either.
+        if (!parent()->layout_node())
+            return;
+        // We need a new layout node here, and it has to go in the right place among our siblings'.
+        parent()->set_needs_layout_tree_update(true);
+        return;
+    }
+
+    if (old_specified_css_values && old_specified_css_values->display() != new_specified_css_values->display()) {
+        // A different display type means a different kind of layout node (or none at all.)
+        parent()->set_needs_layout_tree_update(true);
         return;
     }
 
@@ -234,7 +268,7 @@ void Element::recompute_style()
         return;
     layout_node()->apply_style(*new_specified_css_values);
     if (diff == StyleDifference::NeedsRelayout) {
-        document().schedule_forced_layout();
+        document().schedule_layout_update();
         return;
     }
     if (diff == StyleDifference::NeedsRepaint) {
@@ -279,7 +313,6 @@ void Element::set_inner_html(StringView markup)
     }
 
     set_needs_style_update(true);
-    document().invalidate_layout();
 }
 
 String Element::inner_html() const
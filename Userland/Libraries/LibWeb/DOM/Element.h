@@ -112,6 +112,7 @@ protected:
 private:
     Attribute* find_attribute(const FlyString& name);
     const Attribute* find_attribute(const FlyString& name) const;
+    Document* document_indexing_attribute(const FlyString& name);
 
     QualifiedName m_qualified_name;
     Vector<Attribute> m_attributes;
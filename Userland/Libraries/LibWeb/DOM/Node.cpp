@@ -30,6 +30,7 @@
 #include <LibWeb/Bindings/EventWrapper.h>
 #include <LibWeb/Bindings/NodeWrapper.h>
 #include <LibWeb/Bindings/NodeWrapperFactory.h>
+#include <LibWeb/DOM/Document.h>
 #include <LibWeb/DOM/Element.h>
 #include <LibWeb/DOM/Event.h>
 #include <LibWeb/DOM/EventDispatcher.h>
@@ -95,7 +96,6 @@ void Node::set_text_content(const String& content)
     }
 
     set_needs_style_update(true);
-    document().invalidate_layout();
 }
 
 RefPtr<Layout::Node> Node::create_layout_node()
@@ -254,9 +254,42 @@ void Node::set_needs_style_update(bool value)
     }
 }
 
-void Node::inserted_into(Node&)
+void Node::set_needs_layout_tree_update(bool value)
+{
+    if (m_needs_layout_tree_update == value)
+        return;
+    m_needs_layout_tree_update = value;
+
+    if (m_needs_layout_tree_update) {
+        for (auto* ancestor = parent(); ancestor; ancestor = ancestor->parent())
+            ancestor->m_child_needs_layout_tree_update = true;
+        document().schedule_layout_update();
+    }
+}
+
+void Node::inserted_into(Node& parent)
 {
     set_needs_style_update(true);
+    parent.set_needs_layout_tree_update(true);
+
+    if (auto* root = parent.root(); root->is_document()) {
+        for_each_in_subtree_of_type<Element>([&](auto& element) {
+            downcast<Document>(*root).add_to_element_indexes(element);
+            return IterationDecision::Continue;
+        });
+    }
+}
+
+void Node::removed_from(Node& old_parent)
+{
+    old_parent.set_needs_layout_tree_update(true);
+
+    if (auto* root = old_parent.root(); root->is_document()) {
+        for_each_in_subtree_of_type<Element>([&](auto& element) {
+            downcast<Document>(*root).remove_from_element_indexes(element);
+            return IterationDecision::Continue;
+        });
+    }
 }
 
 ParentNode* Node::parent_or_shadow_host()
@@ -123,7 +123,7 @@ public:
     const Element* parent_element() const;
 
     virtual void inserted_into(Node&);
-    virtual void removed_from(Node&) { }
+    virtual void removed_from(Node&);
     virtual void children_changed() { }
 
     const Layout::Node* layout_node() const { return m_layout_node; }
@@ -141,6 +141,14 @@ public:
 
     void invalidate_style();
 
+    // "Needs layout tree update" means the layout nodes generated for this node's children are stale,
+    // e.g. because children were inserted or removed, or a child's display type changed.
+    bool needs_layout_tree_update() const { return m_needs_layout_tree_update; }
+    void set_needs_layout_tree_update(bool);
+
+    bool child_needs_layout_tree_update() const { return m_child_needs_layout_tree_update; }
+    void set_child_needs_layout_tree_update(bool b) { m_child_needs_layout_tree_update = b; }
+
     bool is_link() const;
 
     void set_document(Badge<Document>, Document&);
@@ -158,6 +166,8 @@ protected:
     NodeType m_type { NodeType::INVALID };
     bool m_needs_style_update { false };
     bool m_child_needs_style_update { false };
+    bool m_needs_layout_tree_update { false };
+    bool m_child_needs_layout_tree_update { false };
 };
 
 }
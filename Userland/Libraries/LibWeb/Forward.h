@@ -116,6 +116,7 @@ class HTMLParagraphElement;
 class HTMLParamElement;
 class HTMLPictureElement;
 class HTMLPreElement;
+class HTMLPreloadScanner;
 class HTMLProgressElement;
 class HTMLQuoteElement;
 class HTMLScriptElement;
@@ -70,6 +70,7 @@ void HTMLLinkElement::resource_did_load()
 
     // Transfer the rules from the successfully parsed sheet into the sheet we've already inserted.
     m_style_sheet->rules() = sheet->rules();
+    document().style_resolver().invalidate_rule_cache();
 
     document().update_style();
 }
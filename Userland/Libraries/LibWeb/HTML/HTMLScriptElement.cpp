@@ -34,6 +34,8 @@
 #include <LibWeb/DOM/Text.h>
 #include <LibWeb/HTML/EventNames.h>
 #include <LibWeb/HTML/HTMLScriptElement.h>
+#include <LibWeb/Loader/LoadRequest.h>
+#include <LibWeb/Loader/Resource.h>
 #include <LibWeb/Loader/ResourceLoader.h>
 
 namespace Web::HTML {
@@ -229,19 +231,18 @@ void HTMLScriptElement::prepare_script(Badge<HTMLDocumentParser>)
 
         if (m_script_type == ScriptType::Classic) {
             // FIXME: This load should be made asynchronous and the parser should spin an event loop etc.
-            ResourceLoader::the().load_sync(
-                url,
-                [this, url](auto data, auto&) {
-                    if (data.is_null()) {
-                        dbgln("HTMLScriptElement: Failed to load {}", url);
-                        return;
-                    }
-                    m_script_source = String::copy(data);
-                    script_became_ready();
-                },
-                [this](auto&) {
-                    m_failed_to_load = true;
-                });
+            // Going through the resource cache lets us pick up a load the preload scanner already started.
+            LoadRequest request;
+            request.set_url(url);
+            auto resource = ResourceLoader::the().load_resource_sync(Resource::Type::Generic, request);
+            if (!resource || resource->is_failed()) {
+                m_failed_to_load = true;
+            } else if (!resource->has_encoded_data()) {
+                dbgln("HTMLScriptElement: Failed to load {}", url);
+            } else {
+                m_script_source = String::copy(resource->encoded_data());
+                script_became_ready();
+            }
         } else {
             TODO();
         }
@@ -26,6 +26,8 @@
 
 #include <AK/Debug.h>
 #include <AK/Utf32View.h>
+#include <LibCore/ElapsedTimer.h>
+#include <LibCore/Timer.h>
 #include <LibTextCodec/Decoder.h>
 #include <LibWeb/DOM/Comment.h>
 #include <LibWeb/DOM/Document.h>
@@ -40,8 +42,10 @@
 #include <LibWeb/HTML/HTMLScriptElement.h>
 #include <LibWeb/HTML/HTMLTemplateElement.h>
 #include <LibWeb/HTML/Parser/HTMLDocumentParser.h>
+#include <LibWeb/HTML/Parser/HTMLPreloadScanner.h>
 #include <LibWeb/HTML/Parser/HTMLToken.h>
 #include <LibWeb/Namespace.h>
+#include <LibWeb/RenderingStatistics.h>
 #include <LibWeb/SVG/TagNames.h>
 
 namespace Web::HTML {
@@ -125,6 +129,14 @@ HTMLDocumentParser::HTMLDocumentParser(DOM::Document& document, const StringView
     m_document->set_encoding(TextCodec::get_standardized_encoding(encoding));
 }
 
+HTMLDocumentParser::HTMLDocumentParser(DOM::Document& document, const String& encoding)
+    : m_tokenizer(encoding)
+    , m_document(document)
+{
+    m_document->set_should_invalidate_styles_on_attribute_changes(false);
+    m_document->set_encoding(TextCodec::get_standardized_encoding(encoding));
+}
+
 HTMLDocumentParser::~HTMLDocumentParser()
 {
     m_document->set_should_invalidate_styles_on_attribute_changes(true);
@@ -135,32 +147,127 @@ void HTMLDocumentParser::run(const URL& url)
     m_document->set_url(url);
     m_document->set_source(m_tokenizer.source());
 
+    parse_available_input(false);
+    the_end();
+}
+
+void HTMLDocumentParser::append_input(ReadonlyBytes bytes)
+{
+    if (m_aborted)
+        return;
+    m_tokenizer.append_input(bytes);
+    if (m_continue_parsing_timer && m_continue_parsing_timer->is_active())
+        return;
+    continue_parsing();
+}
+
+void HTMLDocumentParser::finish_input()
+{
+    if (m_continue_parsing_timer)
+        m_continue_parsing_timer->stop();
+    m_tokenizer.close_input();
+    m_document->set_source(m_tokenizer.source());
+
+    parse_available_input(false);
+    the_end();
+}
+
+void HTMLDocumentParser::abort()
+{
+    m_aborted = true;
+    if (m_continue_parsing_timer)
+        m_continue_parsing_timer->stop();
+}
+
+void HTMLDocumentParser::preload_resources_ahead_of_blocking_script()
+{
+    // Loading the script blocks us, so this is a good time to start loading whatever comes after it.
+    if (!m_preload_scanner)
+        m_preload_scanner = make<HTMLPreloadScanner>(m_document->url());
+    m_preload_scanner->scan(m_tokenizer.decoded_input(), m_tokenizer.is_input_closed());
+}
+
+void HTMLDocumentParser::continue_parsing()
+{
+    if (parse_available_input(true) != ParseResult::Yielded)
+        return;
+
+    // Let the event loop lay out and paint what we have so far (and handle input) before going on.
+    if (!m_continue_parsing_timer)
+        m_continue_parsing_timer = Core::Timer::create_single_shot(0, [this] { continue_parsing(); });
+    m_continue_parsing_timer->start();
+}
+
+HTMLDocumentParser::ParseResult HTMLDocumentParser::parse_available_input(bool yield_periodically)
+{
+    // How long we keep parsing before giving the event loop a turn.
+    constexpr int time_slice_ms = 16;
+    Core::ElapsedTimer timer;
+    timer.start();
+    RenderingStatistics::Scope statistics_scope(RenderingStatistics::Phase::Parse);
+
     for (;;) {
+        if (m_stop_parsing || m_aborted)
+            return ParseResult::ReachedEnd;
+        if (yield_periodically && timer.elapsed() >= time_slice_ms)
+            return ParseResult::Yielded;
+
         auto optional_token = m_tokenizer.next_token();
         if (!optional_token.has_value())
-            break;
+            return m_tokenizer.is_input_closed() ? ParseResult::ReachedEnd : ParseResult::NeedsMoreInput;
         auto& token = optional_token.value();
 
-        dbgln_if(PARSER_DEBUG, "[{}] {}", insertion_mode_name(), token.to_string());
-
-        // FIXME: If the adjusted current node is a MathML text integration point and the token is a start tag whose tag name is neither "mglyph" nor "malignmark"
-        // FIXME: If the adjusted current node is a MathML text integration point and the token is a character token
-        // FIXME: If the adjusted current node is a MathML annotation-xml element and the token is a start tag whose tag name is "svg"
-        // FIXME: If the adjusted current node is an HTML integration point and the token is a start tag
-        // FIXME: If the adjusted current node is an HTML integration point and the token is a character token
-        if (m_stack_of_open_elements.is_empty()
-            || adjusted_current_node().namespace_() == Namespace::HTML
-            || token.is_end_of_file()) {
-            process_using_the_rules_for(m_insertion_mode, token);
+        if (token.is_character()) {
+            // The tokenizer hands out runs of characters as a single token, but tree construction
+            // works on one code point at a time. Reuse one token for all of them.
+            HTMLToken character_token;
+            character_token.m_type = HTMLToken::Type::Character;
+            for (auto code_point : Utf8View(token.characters())) {
+                character_token.m_comment_or_character.data.clear();
+                character_token.m_comment_or_character.data.append_code_point(code_point);
+                process_token(character_token);
+            }
         } else {
-            process_using_the_rules_for_foreign_content(token);
+            process_token(token);
         }
 
         if (m_stop_parsing) {
             dbgln_if(PARSER_DEBUG, "Stop parsing{}! :^)", m_parsing_fragment ? " fragment" : "");
-            break;
+            return ParseResult::ReachedEnd;
         }
     }
+}
+
+void HTMLDocumentParser::process_token(HTMLToken& token)
+{
+    dbgln_if(PARSER_DEBUG, "[{}] {}", insertion_mode_name(), token.to_string());
+
+    if (m_next_line_feed_can_be_ignored) {
+        m_next_line_feed_can_be_ignored = false;
+        // Newlines at the start of pre blocks are ignored as an authoring convenience.
+        if (token.is_character() && token.code_point() == '\n')
+            return;
+    }
+
+    // FIXME: If the adjusted current node is a MathML text integration point and the token is a start tag whose tag name is neither "mglyph" nor "malignmark"
+    // FIXME: If the adjusted current node is a MathML text integration point and the token is a character token
+    // FIXME: If the adjusted current node is a MathML annotation-xml element and the token is a start tag whose tag name is "svg"
+    // FIXME: If the adjusted current node is an HTML integration point and the token is a start tag
+    // FIXME: If the adjusted current node is an HTML integration point and the token is a character token
+    if (m_stack_of_open_elements.is_empty()
+        || adjusted_current_node().namespace_() == Namespace::HTML
+        || token.is_end_of_file()) {
+        process_using_the_rules_for(m_insertion_mode, token);
+    } else {
+        process_using_the_rules_for_foreign_content(token);
+    }
+}
+
+void HTMLDocumentParser::the_end()
+{
+    if (m_has_run_the_end)
+        return;
+    m_has_run_the_end = true;
 
     flush_character_insertions();
 
@@ -594,6 +701,9 @@ void HTMLDocumentParser::handle_in_head(HTMLToken& token)
         }
 
         adjusted_insertion_location.parent->insert_before(element, adjusted_insertion_location.insert_before_sibling, false);
+        // The script isn't notified about being inserted, but it can still be looked up by id.
+        if (adjusted_insertion_location.parent->root()->is_document())
+            downcast<DOM::Document>(*adjusted_insertion_location.parent->root()).add_to_element_indexes(*element);
         m_stack_of_open_elements.push(element);
         m_tokenizer.switch_to({}, HTMLTokenizer::State::ScriptData);
         m_original_insertion_mode = m_insertion_mode;
@@ -1248,13 +1358,7 @@ void HTMLDocumentParser::handle_in_body(HTMLToken& token)
 
         // If the next token is a U+000A LINE FEED (LF) character token,
         // then ignore that token and move on to the next one.
-        // (Newlines at the start of pre blocks are ignored as an authoring convenience.)
-        auto next_token = m_tokenizer.next_token();
-        if (next_token.has_value() && next_token.value().is_character() && next_token.value().code_point() == '\n') {
-            // Ignore it.
-        } else {
-            process_using_the_rules_for(m_insertion_mode, next_token.value());
-        }
+        m_next_line_feed_can_be_ignored = true;
         return;
     }
 
@@ -1584,18 +1688,11 @@ void HTMLDocumentParser::handle_in_body(HTMLToken& token)
 
         // If the next token is a U+000A LINE FEED (LF) character token,
         // then ignore that token and move on to the next one.
-        // (Newlines at the start of pre blocks are ignored as an authoring convenience.)
-        auto next_token = m_tokenizer.next_token();
+        m_next_line_feed_can_be_ignored = true;
 
         m_original_insertion_mode = m_insertion_mode;
         m_frameset_ok = false;
         m_insertion_mode = InsertionMode::Text;
-
-        if (next_token.has_value() && next_token.value().is_character() && next_token.value().code_point() == '\n') {
-            // Ignore it.
-        } else {
-            process_using_the_rules_for(m_insertion_mode, next_token.value());
-        }
         return;
     }
 
@@ -1890,6 +1987,8 @@ void HTMLDocumentParser::handle_text(HTMLToken& token)
         m_stack_of_open_elements.pop();
         m_insertion_mode = m_original_insertion_mode;
         // FIXME: Handle tokenizer insertion point stuff here.
+        if (script->has_attribute(HTML::AttributeNames::src) && !m_parsing_fragment)
+            preload_resources_ahead_of_blocking_script();
         increment_script_nesting_level();
         script->prepare_script({});
         decrement_script_nesting_level();
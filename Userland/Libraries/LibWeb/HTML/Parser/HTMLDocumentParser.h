@@ -27,6 +27,7 @@
 #pragma once
 
 #include <AK/NonnullRefPtrVector.h>
+#include <LibCore/Forward.h>
 #include <LibWeb/DOM/Node.h>
 #include <LibWeb/HTML/Parser/HTMLTokenizer.h>
 #include <LibWeb/HTML/Parser/ListOfActiveFormattingElements.h>
@@ -64,10 +65,21 @@ RefPtr<DOM::Document> parse_html_document(const StringView&, const URL&, const S
 class HTMLDocumentParser {
 public:
     HTMLDocumentParser(DOM::Document&, const StringView& input, const String& encoding);
+
+    // Creates a parser for a document that arrives piece by piece. Nodes are inserted as soon as
+    // their input is available, so the document can be laid out and painted while loading.
+    HTMLDocumentParser(DOM::Document&, const String& encoding);
+
     ~HTMLDocumentParser();
 
     void run(const URL&);
 
+    void append_input(ReadonlyBytes);
+    void finish_input();
+
+    // Stops a parser that is still waiting for input for good, e.g. because its document is being navigated away from.
+    void abort();
+
     DOM::Document& document();
 
     static NonnullRefPtrVector<DOM::Node> parse_html_fragment(DOM::Element& context_element, const StringView&);
@@ -83,6 +95,18 @@ public:
     static bool is_special_tag(const FlyString& tag_name, const FlyString& namespace_);
 
 private:
+    enum class ParseResult {
+        ReachedEnd,
+        NeedsMoreInput,
+        Yielded,
+    };
+
+    ParseResult parse_available_input(bool yield_periodically);
+    void process_token(HTMLToken&);
+    void continue_parsing();
+    void preload_resources_ahead_of_blocking_script();
+    void the_end();
+
     const char* insertion_mode_name() const;
 
     DOM::QuirksMode which_quirks_mode(const HTMLToken&) const;
@@ -177,8 +201,13 @@ private:
     bool m_aborted { false };
     bool m_parser_pause_flag { false };
     bool m_stop_parsing { false };
+    bool m_next_line_feed_can_be_ignored { false };
+    bool m_has_run_the_end { false };
     size_t m_script_nesting_level { 0 };
 
+    RefPtr<Core::Timer> m_continue_parsing_timer;
+    OwnPtr<HTMLPreloadScanner> m_preload_scanner;
+
     NonnullRefPtr<DOM::Document> m_document;
     RefPtr<HTMLHeadElement> m_head_element;
     RefPtr<HTMLFormElement> m_form_element;
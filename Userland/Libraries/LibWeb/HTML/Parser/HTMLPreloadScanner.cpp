@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Debug.h>
+#include <LibWeb/HTML/AttributeNames.h>
+#include <LibWeb/HTML/Parser/HTMLPreloadScanner.h>
+#include <LibWeb/HTML/TagNames.h>
+#include <LibWeb/Loader/LoadRequest.h>
+#include <LibWeb/Loader/ResourceLoader.h>
+
+namespace Web::HTML {
+
+HTMLPreloadScanner::HTMLPreloadScanner(const URL& document_url)
+    : m_document_url(document_url)
+{
+}
+
+HTMLPreloadScanner::~HTMLPreloadScanner()
+{
+}
+
+void HTMLPreloadScanner::scan(const StringView& available_input, bool input_is_closed)
+{
+    if (m_tokenizer.is_input_closed())
+        return;
+
+    VERIFY(available_input.length() >= m_scanned_length);
+    if (available_input.length() > m_scanned_length) {
+        m_tokenizer.append_input(available_input.substring_view(m_scanned_length).bytes());
+        m_scanned_length = available_input.length();
+    }
+    if (input_is_closed)
+        m_tokenizer.close_input();
+
+    for (;;) {
+        auto token = m_tokenizer.next_token();
+        if (!token.has_value() || token->is_end_of_file())
+            return;
+        if (token->is_start_tag())
+            process_start_tag(token.value());
+    }
+}
+
+static bool is_javascript_type(const StringView& type)
+{
+    if (type.is_empty())
+        return true;
+    auto lowercase_type = type.to_string().to_lowercase();
+    return lowercase_type.contains("javascript") || lowercase_type.contains("ecmascript") || lowercase_type.contains("jscript") || lowercase_type.contains("livescript");
+}
+
+void HTMLPreloadScanner::process_start_tag(HTMLToken& token)
+{
+    auto tag_name = token.tag_name();
+
+    // The tree builder switches the tokenizer into these states, so we have to do it as well.
+    // Otherwise we'd go looking for tags in the middle of a script or a style sheet.
+    if (tag_name == HTML::TagNames::script) {
+        auto src = token.attribute(HTML::AttributeNames::src);
+        if (!src.is_empty() && is_javascript_type(token.attribute(HTML::AttributeNames::type)))
+            preload(Resource::Type::Generic, src);
+        m_tokenizer.switch_to_for_lookahead({}, HTMLTokenizer::State::ScriptData);
+        return;
+    }
+    if (tag_name.is_one_of(HTML::TagNames::style, HTML::TagNames::xmp, HTML::TagNames::iframe, HTML::TagNames::noembed, HTML::TagNames::noframes, HTML::TagNames::noscript)) {
+        m_tokenizer.switch_to_for_lookahead({}, HTMLTokenizer::State::RAWTEXT);
+        return;
+    }
+    if (tag_name.is_one_of(HTML::TagNames::textarea, HTML::TagNames::title)) {
+        m_tokenizer.switch_to_for_lookahead({}, HTMLTokenizer::State::RCDATA);
+        return;
+    }
+    if (tag_name == HTML::TagNames::plaintext) {
+        m_tokenizer.switch_to_for_lookahead({}, HTMLTokenizer::State::PLAINTEXT);
+        return;
+    }
+
+    if (tag_name == HTML::TagNames::img) {
+        auto src = token.attribute(HTML::AttributeNames::src);
+        if (!src.is_empty())
+            preload(Resource::Type::Image, src);
+        return;
+    }
+
+    if (tag_name == HTML::TagNames::link) {
+        auto href = token.attribute(HTML::AttributeNames::href);
+        if (href.is_empty())
+            return;
+        bool is_stylesheet = false;
+        bool is_alternate = false;
+        bool wants_dns_prefetch = false;
+        for (auto& part : token.attribute(HTML::AttributeNames::rel).split_view(' ')) {
+            auto lowercase_part = part.to_string().to_lowercase();
+            if (lowercase_part == "stylesheet")
+                is_stylesheet = true;
+            else if (lowercase_part == "alternate")
+                is_alternate = true;
+            else if (lowercase_part.is_one_of("dns-prefetch", "preconnect"))
+                wants_dns_prefetch = true;
+        }
+        if (is_stylesheet && !is_alternate)
+            preload(Resource::Type::Generic, href);
+        else if (wants_dns_prefetch)
+            ResourceLoader::the().prefetch_dns(m_document_url.complete_url(href));
+        return;
+    }
+}
+
+void HTMLPreloadScanner::preload(Resource::Type type, const StringView& url_string)
+{
+    auto url = m_document_url.complete_url(url_string);
+    if (!url.is_valid() || url.protocol().is_one_of("data", "about"))
+        return;
+
+    LoadRequest request;
+    request.set_url(url);
+    // Uncached loads wouldn't be picked up by the element that needs them, so they'd only be done twice.
+    if (!ResourceLoader::is_cacheable(request))
+        return;
+
+    auto url_string_to_preload = url.to_string();
+    if (m_preloaded_urls.contains(url_string_to_preload))
+        return;
+    m_preloaded_urls.set(url_string_to_preload);
+
+    dbgln_if(PARSER_DEBUG, "Preloading {}", url);
+    auto resource = ResourceLoader::the().load_resource(type, request);
+    if (resource)
+        m_preloaded_resources.append(resource.release_nonnull());
+}
+
+}
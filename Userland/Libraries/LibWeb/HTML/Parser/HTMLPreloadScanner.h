@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/HashTable.h>
+#include <AK/NonnullRefPtrVector.h>
+#include <AK/URL.h>
+#include <LibWeb/HTML/Parser/HTMLTokenizer.h>
+#include <LibWeb/Loader/Resource.h>
+
+namespace Web::HTML {
+
+// While the parser is blocked on a script, looks ahead in the input for the scripts, style sheets
+// and images it will need later, and starts loading them. Only the tokenizer runs here, so it's
+// fast but approximate; anything it misses is simply loaded when the parser gets to it.
+class HTMLPreloadScanner {
+public:
+    explicit HTMLPreloadScanner(const URL& document_url);
+    ~HTMLPreloadScanner();
+
+    // Scans whatever part of the input hasn't been scanned yet. available_input must start with
+    // the input passed to earlier calls.
+    void scan(const StringView& available_input, bool input_is_closed);
+
+private:
+    void process_start_tag(HTMLToken&);
+    void preload(Resource::Type, const StringView& url);
+
+    HTMLTokenizer m_tokenizer { "utf-8" };
+    size_t m_scanned_length { 0 };
+    // Completes URLs the way Document::complete_url() does, so we ask for the same things the elements will.
+    URL m_document_url;
+
+    HashTable<String> m_preloaded_urls;
+    NonnullRefPtrVector<Resource> m_preloaded_resources;
+};
+
+}
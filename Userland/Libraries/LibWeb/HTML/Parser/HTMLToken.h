@@ -73,6 +73,13 @@ public:
     bool is_character() const { return m_type == Type::Character; }
     bool is_end_of_file() const { return m_type == Type::EndOfFile; }
 
+    // The tokenizer emits runs of characters as a single token, the tree builder splits them up again.
+    StringView characters() const
+    {
+        VERIFY(is_character());
+        return m_comment_or_character.data.string_view();
+    }
+
     u32 code_point() const
     {
         VERIFY(is_character());
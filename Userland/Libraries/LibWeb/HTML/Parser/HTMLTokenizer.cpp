@@ -25,6 +25,7 @@
  */
 
 #include <AK/Debug.h>
+#include <AK/SIMD.h>
 #include <LibTextCodec/Decoder.h>
 #include <LibWeb/HTML/Parser/Entities.h>
 #include <LibWeb/HTML/Parser/HTMLToken.h>
@@ -172,6 +173,15 @@ namespace Web::HTML {
 #define EMIT_CURRENT_CHARACTER \
     EMIT_CHARACTER(current_input_character.value());
 
+// Emits the current input character together with all the following ones that need no special handling as a single token.
+#define EMIT_CURRENT_CHARACTER_RUN_UNTIL(condition)                                                                                     \
+    do {                                                                                                                                \
+        create_new_token(HTMLToken::Type::Character);                                                                                   \
+        m_current_token.m_comment_or_character.data.append(consume_current_code_point_and_run_until([](auto ch) { return condition; })); \
+        m_queued_tokens.enqueue(m_current_token);                                                                                       \
+        return m_queued_tokens.dequeue();                                                                                               \
+    } while (0)
+
 #define SWITCH_TO_AND_EMIT_CHARACTER(code_point, new_state) \
     do {                                                    \
         will_switch_to(State::new_state);                   \
@@ -217,8 +227,11 @@ static inline bool is_control(u32 code_point)
 
 Optional<u32> HTMLTokenizer::next_code_point()
 {
-    if (m_utf8_iterator == m_utf8_view.end())
+    if (m_utf8_iterator == m_utf8_view.end()) {
+        if (!m_input_is_closed)
+            m_ran_out_of_input = true;
         return {};
+    }
     m_prev_utf8_iterator = m_utf8_iterator;
     ++m_utf8_iterator;
     dbgln_if(TOKENIZER_TRACE_DEBUG, "(Tokenizer) Next code_point: {}", (char)*m_prev_utf8_iterator);
@@ -230,12 +243,60 @@ Optional<u32> HTMLTokenizer::peek_code_point(size_t offset) const
     auto it = m_utf8_iterator;
     for (size_t i = 0; i < offset && it != m_utf8_view.end(); ++i)
         ++it;
-    if (it == m_utf8_view.end())
+    if (it == m_utf8_view.end()) {
+        if (!m_input_is_closed)
+            m_ran_out_of_input = true;
         return {};
+    }
     return *it;
 }
 
+template<typename Callback>
+StringView HTMLTokenizer::consume_current_code_point_and_run_until(Callback is_end_of_run)
+{
+    // All the characters that end a run are ASCII, so we can scan the UTF-8 bytes directly
+    // instead of decoding every code point. The callbacks only compare against constants, so
+    // they work on a whole vector of bytes as well, which lets us skip 16 bytes at a time.
+    using AK::SIMD::u64x2;
+    using AK::SIMD::u8x16;
+    auto input = m_utf8_view.as_string();
+    size_t start = m_utf8_view.byte_offset_of(m_prev_utf8_iterator);
+    size_t end = m_utf8_view.byte_offset_of(m_utf8_iterator);
+    while (end + sizeof(u8x16) <= input.length()) {
+        u8x16 bytes;
+        memcpy(&bytes, input.characters_without_null_termination() + end, sizeof(bytes));
+        auto matches = (u64x2)is_end_of_run(bytes);
+        if (matches[0] | matches[1])
+            break;
+        end += sizeof(u8x16);
+    }
+    while (end < input.length() && !is_end_of_run(input[end]))
+        ++end;
+
+    m_utf8_iterator = m_utf8_view.substring_view(end, input.length() - end).begin();
+    m_prev_utf8_iterator = m_utf8_iterator;
+    dbgln_if(TOKENIZER_TRACE_DEBUG, "(Tokenizer) Consumed run of {} bytes", end - start);
+    return input.substring_view(start, end - start);
+}
+
 Optional<HTMLToken> HTMLTokenizer::next_token()
+{
+    if (m_input_is_closed || !m_queued_tokens.is_empty())
+        return next_token_from_available_input();
+
+    // With more input still to come, an end of input is not an end of file. Tokenize
+    // speculatively, and if we ran out of input halfway through, rewind and wait for more.
+    auto checkpoint = make_checkpoint();
+    m_ran_out_of_input = false;
+    auto token = next_token_from_available_input();
+    if (!m_ran_out_of_input)
+        return token;
+
+    restore_checkpoint(move(checkpoint));
+    return {};
+}
+
+Optional<HTMLToken> HTMLTokenizer::next_token_from_available_input()
 {
 _StartOfFunction:
     if (!m_queued_tokens.is_empty())
@@ -266,7 +327,7 @@ _StartOfFunction:
                 }
                 ANYTHING_ELSE
                 {
-                    EMIT_CURRENT_CHARACTER;
+                    EMIT_CURRENT_CHARACTER_RUN_UNTIL((ch == '<') | (ch == '&') | (ch == '\0'));
                 }
             }
             END_STATE
@@ -1173,7 +1234,7 @@ _StartOfFunction:
                 }
                 ANYTHING_ELSE
                 {
-                    m_current_token.m_tag.attributes.last().value_builder.append_code_point(current_input_character.value());
+                    m_current_token.m_tag.attributes.last().value_builder.append(consume_current_code_point_and_run_until([](auto ch) { return (ch == '"') | (ch == '&') | (ch == '\0'); }));
                     continue;
                 }
             }
@@ -1203,7 +1264,7 @@ _StartOfFunction:
                 }
                 ANYTHING_ELSE
                 {
-                    m_current_token.m_tag.attributes.last().value_builder.append_code_point(current_input_character.value());
+                    m_current_token.m_tag.attributes.last().value_builder.append(consume_current_code_point_and_run_until([](auto ch) { return (ch == '\'') | (ch == '&') | (ch == '\0'); }));
                     continue;
                 }
             }
@@ -1532,9 +1593,13 @@ _StartOfFunction:
 
             BEGIN_STATE(NamedCharacterReference)
             {
+                if (needs_more_input_to_match_a_named_character_reference())
+                    m_ran_out_of_input = true;
+
                 size_t byte_offset = m_utf8_view.byte_offset_of(m_prev_utf8_iterator);
 
-                auto match = HTML::code_points_from_entity(m_decoded_input.substring_view(byte_offset, m_decoded_input.length() - byte_offset - 1));
+                auto input = m_utf8_view.as_string();
+                auto match = HTML::code_points_from_entity(input.substring_view(byte_offset, input.length() - byte_offset - 1));
 
                 if (match.has_value()) {
                     for (size_t i = 0; i < match.value().entity.length() - 1; ++i) {
@@ -1786,7 +1851,7 @@ _StartOfFunction:
                 }
                 ANYTHING_ELSE
                 {
-                    EMIT_CURRENT_CHARACTER;
+                    EMIT_CURRENT_CHARACTER_RUN_UNTIL((ch == '<') | (ch == '&') | (ch == '\0'));
                 }
             }
             END_STATE
@@ -1896,7 +1961,7 @@ _StartOfFunction:
                 }
                 ANYTHING_ELSE
                 {
-                    EMIT_CURRENT_CHARACTER;
+                    EMIT_CURRENT_CHARACTER_RUN_UNTIL((ch == '<') | (ch == '\0'));
                 }
             }
             END_STATE
@@ -2006,7 +2071,7 @@ _StartOfFunction:
                 }
                 ANYTHING_ELSE
                 {
-                    EMIT_CURRENT_CHARACTER;
+                    EMIT_CURRENT_CHARACTER_RUN_UNTIL((ch == '<') | (ch == '\0'));
                 }
             }
             END_STATE
@@ -2024,7 +2089,7 @@ _StartOfFunction:
                 }
                 ANYTHING_ELSE
                 {
-                    EMIT_CURRENT_CHARACTER;
+                    EMIT_CURRENT_CHARACTER_RUN_UNTIL(ch == '\0');
                 }
             }
             END_STATE
@@ -2616,6 +2681,112 @@ HTMLTokenizer::HTMLTokenizer(const StringView& input, const String& encoding)
     m_utf8_iterator = m_utf8_view.begin();
 }
 
+HTMLTokenizer::HTMLTokenizer(const String& encoding)
+    : m_encoding(encoding)
+    , m_input_is_closed(false)
+{
+    VERIFY(TextCodec::decoder_for(encoding));
+    m_utf8_view = Utf8View(m_streamed_input.string_view());
+    m_utf8_iterator = m_utf8_view.begin();
+}
+
+// Returns how many bytes at the end of the given UTF-8 data belong to a sequence that isn't complete yet.
+static size_t incomplete_utf8_suffix_length(ReadonlyBytes bytes)
+{
+    for (size_t i = 1; i <= min(bytes.size(), (size_t)3); ++i) {
+        u8 byte = bytes[bytes.size() - i];
+        if ((byte & 0xc0) == 0x80)
+            continue;
+        size_t sequence_length = 1;
+        if ((byte & 0xe0) == 0xc0)
+            sequence_length = 2;
+        else if ((byte & 0xf0) == 0xe0)
+            sequence_length = 3;
+        else if ((byte & 0xf8) == 0xf0)
+            sequence_length = 4;
+        return sequence_length > i ? i : 0;
+    }
+    return 0;
+}
+
+void HTMLTokenizer::append_input(ReadonlyBytes bytes)
+{
+    VERIFY(!m_input_is_closed);
+    m_undecoded_input.append(bytes.data(), bytes.size());
+
+    // A chunk may end in the middle of a character, so only decode the complete ones.
+    // FIXME: Decode UTF-16 incrementally too. For now, it waits for close_input().
+    size_t decodable_length = 0;
+    if (TextCodec::get_standardized_encoding(m_encoding) == "UTF-8")
+        decodable_length = m_undecoded_input.size() - incomplete_utf8_suffix_length(m_undecoded_input);
+    else if (!TextCodec::get_standardized_encoding(m_encoding).starts_with("UTF-16"))
+        decodable_length = m_undecoded_input.size();
+    if (decodable_length == 0)
+        return;
+
+    auto byte_offset = m_utf8_view.byte_offset_of(m_utf8_iterator);
+    m_streamed_input.append(TextCodec::decoder_for(m_encoding)->to_utf8(StringView(m_undecoded_input.data(), decodable_length)));
+    m_undecoded_input = m_undecoded_input.slice(decodable_length, m_undecoded_input.size() - decodable_length);
+    set_utf8_view(m_streamed_input.string_view(), byte_offset);
+}
+
+void HTMLTokenizer::close_input()
+{
+    VERIFY(!m_input_is_closed);
+    auto byte_offset = m_utf8_view.byte_offset_of(m_utf8_iterator);
+    if (!m_undecoded_input.is_empty())
+        m_streamed_input.append(TextCodec::decoder_for(m_encoding)->to_utf8(StringView(m_undecoded_input.data(), m_undecoded_input.size())));
+    m_undecoded_input.clear();
+    m_decoded_input = m_streamed_input.to_string();
+    m_streamed_input.clear();
+    set_utf8_view(m_decoded_input, byte_offset);
+    m_input_is_closed = true;
+}
+
+void HTMLTokenizer::set_utf8_view(const StringView& input, size_t byte_offset)
+{
+    m_utf8_view = Utf8View(input);
+    m_utf8_iterator = m_utf8_view.substring_view(byte_offset, m_utf8_view.byte_length() - byte_offset).begin();
+    m_prev_utf8_iterator = m_utf8_iterator;
+}
+
+HTMLTokenizer::Checkpoint HTMLTokenizer::make_checkpoint() const
+{
+    return {
+        m_state,
+        m_return_state,
+        m_utf8_view.byte_offset_of(m_utf8_iterator),
+        m_current_token,
+        m_last_emitted_start_tag,
+        m_temporary_buffer,
+        m_character_reference_code,
+        m_has_emitted_eof,
+    };
+}
+
+void HTMLTokenizer::restore_checkpoint(Checkpoint&& checkpoint)
+{
+    m_state = checkpoint.state;
+    m_return_state = checkpoint.return_state;
+    m_current_token = move(checkpoint.current_token);
+    m_last_emitted_start_tag = move(checkpoint.last_emitted_start_tag);
+    m_temporary_buffer = move(checkpoint.temporary_buffer);
+    m_character_reference_code = checkpoint.character_reference_code;
+    m_has_emitted_eof = checkpoint.has_emitted_eof;
+    m_queued_tokens.clear();
+    set_utf8_view(m_utf8_view.as_string(), checkpoint.byte_offset);
+}
+
+bool HTMLTokenizer::needs_more_input_to_match_a_named_character_reference() const
+{
+    // The longest named character reference is "&CounterClockwiseContourIntegral;", so with fewer
+    // code points than that left, a longer match might still be on its way.
+    constexpr size_t longest_entity_length = 33;
+    if (m_input_is_closed)
+        return false;
+    return m_utf8_view.byte_length() - m_utf8_view.byte_offset_of(m_prev_utf8_iterator) < longest_entity_length;
+}
+
 void HTMLTokenizer::will_switch_to([[maybe_unused]] State new_state)
 {
     dbgln_if(TOKENIZER_TRACE_DEBUG, "[{}] Switch to {}", state_name(m_state), state_name(new_state));
@@ -2632,6 +2803,12 @@ void HTMLTokenizer::switch_to(Badge<HTMLDocumentParser>, State new_state)
     m_state = new_state;
 }
 
+void HTMLTokenizer::switch_to_for_lookahead(Badge<HTMLPreloadScanner>, State new_state)
+{
+    dbgln_if(TOKENIZER_TRACE_DEBUG, "[{}] Preload scanner switches tokenizer state to {}", state_name(m_state), state_name(new_state));
+    m_state = new_state;
+}
+
 void HTMLTokenizer::will_emit(HTMLToken& token)
 {
     if (token.is_start_tag())
@@ -27,6 +27,7 @@
 #pragma once
 
 #include <AK/Queue.h>
+#include <AK/StringBuilder.h>
 #include <AK/StringView.h>
 #include <AK/Types.h>
 #include <AK/Utf8View.h>
@@ -121,25 +122,60 @@ class HTMLTokenizer {
 public:
     explicit HTMLTokenizer(const StringView& input, const String& encoding);
 
+    // Creates a tokenizer without any input yet. Feed it with append_input() as the data
+    // arrives, and call close_input() after the last chunk.
+    explicit HTMLTokenizer(const String& encoding);
+
     enum class State {
 #define __ENUMERATE_TOKENIZER_STATE(state) state,
         ENUMERATE_TOKENIZER_STATES
 #undef __ENUMERATE_TOKENIZER_STATE
     };
 
+    // Returns an empty Optional once the end of file has been emitted, or if the
+    // next token can't be completed until more input has been appended.
     Optional<HTMLToken> next_token();
 
+    void append_input(ReadonlyBytes);
+    void close_input();
+    bool is_input_closed() const { return m_input_is_closed; }
+
     void switch_to(Badge<HTMLDocumentParser>, State new_state);
+    void switch_to_for_lookahead(Badge<HTMLPreloadScanner>, State new_state);
 
     void set_blocked(bool b) { m_blocked = b; }
     bool is_blocked() const { return m_blocked; }
 
     String source() const { return m_decoded_input; }
 
+    // The decoded input received so far. Unlike source(), this is also available before close_input().
+    StringView decoded_input() const { return m_input_is_closed ? m_decoded_input.view() : m_streamed_input.string_view(); }
+
 private:
+    // Everything next_token() may change while working on a single token, so a token that runs
+    // into the end of the input received so far can be thrown away and tokenized again later.
+    struct Checkpoint {
+        State state;
+        State return_state;
+        size_t byte_offset;
+        HTMLToken current_token;
+        HTMLToken last_emitted_start_tag;
+        Vector<u32> temporary_buffer;
+        u32 character_reference_code;
+        bool has_emitted_eof;
+    };
+
+    Optional<HTMLToken> next_token_from_available_input();
+    Checkpoint make_checkpoint() const;
+    void restore_checkpoint(Checkpoint&&);
+    void set_utf8_view(const StringView&, size_t byte_offset);
+    bool needs_more_input_to_match_a_named_character_reference() const;
+
     Optional<u32> next_code_point();
     Optional<u32> peek_code_point(size_t offset) const;
     bool consume_next_if_match(const StringView&, CaseSensitivity = CaseSensitivity::CaseSensitive);
+    template<typename Callback>
+    StringView consume_current_code_point_and_run_until(Callback is_end_of_run);
     void create_new_token(HTMLToken::Type);
     bool current_end_tag_token_is_appropriate() const;
 
@@ -168,7 +204,11 @@ private:
 
     String m_decoded_input;
 
-    StringView m_input;
+    String m_encoding;
+    StringBuilder m_streamed_input;
+    ByteBuffer m_undecoded_input;
+    bool m_input_is_closed { true };
+    mutable bool m_ran_out_of_input { false };
 
     Utf8View m_utf8_view;
     Utf8CodepointIterator m_utf8_iterator;
@@ -123,17 +123,38 @@ void TreeBuilder::create_layout_tree(DOM::Node& dom_node)
         }
     }
 
+    if (layout_node->can_have_children())
+        create_layout_tree_for_children(dom_node, downcast<NodeWithStyle>(*layout_node));
+}
+
+void TreeBuilder::create_layout_tree_for_children(DOM::Node& dom_node, Layout::NodeWithStyle& layout_node)
+{
     auto* shadow_root = is<DOM::Element>(dom_node) ? downcast<DOM::Element>(dom_node).shadow_root() : nullptr;
+    if (!dom_node.has_children() && !shadow_root)
+        return;
 
-    if ((dom_node.has_children() || shadow_root) && layout_node->can_have_children()) {
-        push_parent(downcast<NodeWithStyle>(*layout_node));
-        if (shadow_root)
-            create_layout_tree(*shadow_root);
-        downcast<DOM::ParentNode>(dom_node).for_each_child([&](auto& dom_child) {
-            create_layout_tree(dom_child);
-        });
-        pop_parent();
+    push_parent(layout_node);
+    auto* element = is<DOM::Element>(dom_node) ? &downcast<DOM::Element>(dom_node) : nullptr;
+    if (element)
+        dom_node.document().style_resolver().push_ancestor(*element);
+    if (shadow_root)
+        create_layout_tree(*shadow_root);
+    downcast<DOM::ParentNode>(dom_node).for_each_child([&](auto& dom_child) {
+        create_layout_tree(dom_child);
+    });
+    if (element)
+        dom_node.document().style_resolver().pop_ancestor(*element);
+    pop_parent();
+}
+
+static Vector<DOM::Element*> collect_ancestor_elements(DOM::Node& dom_node)
+{
+    Vector<DOM::Element*> ancestor_elements;
+    for (auto* ancestor = dom_node.parent(); ancestor; ancestor = ancestor->parent()) {
+        if (is<DOM::Element>(*ancestor))
+            ancestor_elements.prepend(downcast<DOM::Element>(ancestor));
     }
+    return ancestor_elements;
 }
 
 RefPtr<Node> TreeBuilder::build(DOM::Node& dom_node)
@@ -144,14 +165,62 @@ RefPtr<Node> TreeBuilder::build(DOM::Node& dom_node)
             m_parent_stack.prepend(downcast<NodeWithStyle>(ancestor));
     }
 
+    // When building a partial layout tree, let the style resolver know about the ancestors too.
+    auto ancestor_elements = collect_ancestor_elements(dom_node);
+    auto& style_resolver = dom_node.document().style_resolver();
+    for (auto* ancestor : ancestor_elements)
+        style_resolver.push_ancestor(*ancestor);
+
     create_layout_tree(dom_node);
 
+    for (ssize_t i = ancestor_elements.size() - 1; i >= 0; --i)
+        style_resolver.pop_ancestor(*ancestor_elements[i]);
+
     if (auto* root = dom_node.document().layout_node())
         fixup_tables(*root);
 
     return move(m_layout_root);
 }
 
+void TreeBuilder::rebuild_children(DOM::Node& dom_node)
+{
+    // Throw away everything below this node's layout node and generate it again from the DOM.
+    // The layout node itself (and thus its position among its siblings) is kept as-is.
+    VERIFY(dom_node.layout_node());
+    auto& layout_node = downcast<NodeWithStyle>(*dom_node.layout_node());
+    VERIFY(!layout_node.is_inline());
+
+    NonnullRefPtrVector<Layout::Node> old_children;
+    layout_node.for_each_in_subtree([&](auto& descendant) {
+        if (&descendant != &layout_node)
+            old_children.append(descendant);
+        return IterationDecision::Continue;
+    });
+    for (auto& old_child : old_children) {
+        if (old_child.parent())
+            old_child.parent()->remove_child(old_child);
+    }
+    layout_node.set_children_are_inline(false);
+    if (is<Box>(layout_node))
+        downcast<Box>(layout_node).line_boxes().clear();
+
+    for (auto* ancestor = layout_node.parent(); ancestor; ancestor = ancestor->parent())
+        m_parent_stack.prepend(downcast<NodeWithStyle>(ancestor));
+
+    auto ancestor_elements = collect_ancestor_elements(dom_node);
+    auto& style_resolver = dom_node.document().style_resolver();
+    for (auto* ancestor : ancestor_elements)
+        style_resolver.push_ancestor(*ancestor);
+
+    create_layout_tree_for_children(dom_node, layout_node);
+
+    for (ssize_t i = ancestor_elements.size() - 1; i >= 0; --i)
+        style_resolver.pop_ancestor(*ancestor_elements[i]);
+
+    if (auto* root = dom_node.document().layout_node())
+        fixup_tables(*root);
+}
+
 template<CSS::Display display, typename Callback>
 void TreeBuilder::for_each_in_tree_with_display(NodeWithStyle& root, Callback callback)
 {
@@ -37,9 +37,11 @@ public:
     TreeBuilder();
 
     RefPtr<Layout::Node> build(DOM::Node&);
+    void rebuild_children(DOM::Node&);
 
 private:
     void create_layout_tree(DOM::Node&);
+    void create_layout_tree_for_children(DOM::Node&, Layout::NodeWithStyle&);
 
     void push_parent(Layout::NodeWithStyle& node) { m_parent_stack.append(&node); }
     void pop_parent() { m_parent_stack.take_last(); }
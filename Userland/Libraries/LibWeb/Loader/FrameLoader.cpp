@@ -159,6 +159,7 @@ bool FrameLoader::load(const LoadRequest& request, Type type)
 
     auto& url = request.url();
 
+    discard_parser();
     set_resource(ResourceLoader::the().load_resource(Resource::Type::Generic, request));
 
     if (type == Type::Navigation) {
@@ -244,10 +245,45 @@ void FrameLoader::load_error_page(const URL& failed_url, const String& error)
         });
 }
 
+NonnullRefPtr<DOM::Document> FrameLoader::create_document_for_resource()
+{
+    dbgln("I believe this content has MIME type '{}', , encoding '{}'", resource()->mime_type(), resource()->encoding());
+
+    auto document = DOM::Document::create();
+    document->set_url(resource()->url());
+    document->set_encoding(resource()->encoding());
+    document->set_content_type(resource()->mime_type());
+
+    frame().set_document(document);
+    return document;
+}
+
+void FrameLoader::resource_did_receive_data(ReadonlyBytes chunk)
+{
+    if (!m_parser) {
+        // Only start parsing early if this is the very first chunk, so we don't miss any input.
+        if (resource()->received_size() != chunk.size())
+            return;
+        if (resource()->mime_type() != "text/html" || resource()->response_headers().contains("Location"))
+            return;
+        auto document = create_document_for_resource();
+        m_parser = make<HTML::HTMLDocumentParser>(document, document->encoding());
+    }
+    m_parser->append_input(chunk);
+}
+
 void FrameLoader::resource_did_load()
 {
     auto url = resource()->url();
 
+    if (m_parser) {
+        // Scripts run by the parser may start a new load, so don't let that destroy it under our feet.
+        auto parser = m_parser.release_nonnull();
+        parser->finish_input();
+        did_finish_loading_document(url);
+        return;
+    }
+
     if (!resource()->has_encoded_data()) {
         load_error_page(url, "No data");
         return;
@@ -260,20 +296,17 @@ void FrameLoader::resource_did_load()
         return;
     }
 
-    dbgln("I believe this content has MIME type '{}', , encoding '{}'", resource()->mime_type(), resource()->encoding());
-
-    auto document = DOM::Document::create();
-    document->set_url(url);
-    document->set_encoding(resource()->encoding());
-    document->set_content_type(resource()->mime_type());
-
-    frame().set_document(document);
-
+    auto document = create_document_for_resource();
     if (!parse_document(*document, resource()->encoded_data())) {
         load_error_page(url, "Failed to parse content.");
         return;
     }
 
+    did_finish_loading_document(url);
+}
+
+void FrameLoader::did_finish_loading_document(const URL& url)
+{
     if (!url.fragment().is_empty())
         frame().scroll_to_anchor(url.fragment());
 
@@ -287,8 +320,18 @@ void FrameLoader::resource_did_load()
         page->client().page_did_finish_loading(url);
 }
 
+void FrameLoader::discard_parser()
+{
+    if (!m_parser)
+        return;
+    m_parser->abort();
+    // The parser may be running the script that asked us to load something else, so let it unwind before destroying it.
+    ResourceLoader::the().deferred_invoke([parser = m_parser.release_nonnull()](auto&) {});
+}
+
 void FrameLoader::resource_did_fail()
 {
+    discard_parser();
     load_error_page(resource()->url(), resource()->error());
 }
 
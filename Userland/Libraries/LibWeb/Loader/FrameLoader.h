@@ -27,6 +27,7 @@
 #pragma once
 
 #include <AK/Forward.h>
+#include <AK/OwnPtr.h>
 #include <LibWeb/Forward.h>
 #include <LibWeb/Loader/Resource.h>
 
@@ -56,11 +57,18 @@ private:
     // ^ResourceClient
     virtual void resource_did_load() override;
     virtual void resource_did_fail() override;
+    virtual void resource_did_receive_data(ReadonlyBytes) override;
 
     void load_error_page(const URL& failed_url, const String& error_message);
     bool parse_document(DOM::Document&, const ByteBuffer& data);
+    NonnullRefPtr<DOM::Document> create_document_for_resource();
+    void did_finish_loading_document(const URL&);
+    void discard_parser();
 
     Frame& m_frame;
+
+    // Parses HTML documents while they're still arriving.
+    OwnPtr<HTML::HTMLDocumentParser> m_parser;
 };
 
 }
@@ -40,6 +40,9 @@ ImageLoader::ImageLoader()
 void ImageLoader::load(const URL& url)
 {
     m_loading_state = LoadingState::Loading;
+    m_has_image = false;
+    m_width = 0;
+    m_height = 0;
     LoadRequest request;
     request.set_url(url);
     set_resource(ResourceLoader::the().load_resource(Resource::Type::Image, request));
@@ -69,8 +72,6 @@ void ImageLoader::resource_did_load()
         return;
     }
 
-    m_loading_state = LoadingState::Loaded;
-
     if constexpr (IMAGE_LOADER_DEBUG) {
         if (!resource()->has_encoded_data()) {
             dbgln("ImageLoader: Resource did load, no encoded data. URL: {}", resource()->url());
@@ -79,6 +80,37 @@ void ImageLoader::resource_did_load()
         }
     }
 
+    // We finish loading once the image has been decoded, which happens asynchronously in the ImageDecoder service.
+    if (!resource()->has_encoded_data() || resource()->has_attempted_decode()) {
+        resource_did_decode();
+        return;
+    }
+    resource()->decode_if_needed();
+}
+
+void ImageLoader::resource_did_decode()
+{
+    VERIFY(resource());
+
+    if (m_loading_state == LoadingState::Failed)
+        return;
+
+    if (auto* bitmap = resource()->bitmap(0)) {
+        m_has_image = true;
+        m_width = bitmap->width();
+        m_height = bitmap->height();
+    }
+
+    if (m_loading_state == LoadingState::Loaded) {
+        // The decoded frames were discarded at some point and have now been decoded again. Our size
+        // hasn't changed, so all that's needed is a repaint.
+        if (on_animate)
+            on_animate();
+        return;
+    }
+
+    m_loading_state = LoadingState::Loaded;
+
     if (resource()->is_animated() && resource()->frame_count() > 1) {
         m_timer->set_interval(resource()->frame_duration(0));
         m_timer->on_timeout = [this] { animate(); };
@@ -122,23 +154,17 @@ void ImageLoader::resource_did_fail()
 
 bool ImageLoader::has_image() const
 {
-    if (!resource())
-        return false;
-    return bitmap(0);
+    return m_has_image;
 }
 
 unsigned ImageLoader::width() const
 {
-    if (!resource())
-        return 0;
-    return bitmap(0) ? bitmap(0)->width() : 0;
+    return m_width;
 }
 
 unsigned ImageLoader::height() const
 {
-    if (!resource())
-        return 0;
-    return bitmap(0) ? bitmap(0)->height() : 0;
+    return m_height;
 }
 
 const Gfx::Bitmap* ImageLoader::bitmap(size_t frame_index) const
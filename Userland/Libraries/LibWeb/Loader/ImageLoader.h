@@ -58,6 +58,7 @@ private:
     // ^ImageResourceClient
     virtual void resource_did_load() override;
     virtual void resource_did_fail() override;
+    virtual void resource_did_decode() override;
     virtual bool is_visible_in_viewport() const override { return m_visible_in_viewport; }
 
     void animate();
@@ -71,6 +72,11 @@ private:
 
     mutable bool m_visible_in_viewport { false };
 
+    // NOTE: These are remembered from the first successful decode, since the decoded frames may come and go.
+    bool m_has_image { false };
+    unsigned m_width { 0 };
+    unsigned m_height { 0 };
+
     size_t m_current_frame_index { 0 };
     size_t m_loops_completed { 0 };
     LoadingState m_loading_state { LoadingState::Loading };
@@ -25,12 +25,27 @@
  */
 
 #include <AK/Function.h>
+#include <AK/HashTable.h>
+#include <AK/QuickSort.h>
 #include <LibGfx/Bitmap.h>
 #include <LibImageDecoderClient/Client.h>
 #include <LibWeb/Loader/ImageResource.h>
 
 namespace Web {
 
+// Decoded frames of all images are kept within this budget. When we go over it, the least recently used
+// images that aren't visible in any viewport are discarded back to their encoded data.
+static constexpr size_t decoded_image_cache_budget = 64 * MiB;
+
+static HashTable<ImageResource*>& decoded_image_resources()
+{
+    static HashTable<ImageResource*> resources;
+    return resources;
+}
+
+static size_t s_decoded_image_bytes { 0 };
+static u64 s_next_use_serial { 1 };
+
 ImageResource::ImageResource(const LoadRequest& request)
     : Resource(Type::Image, request)
 {
@@ -38,11 +53,11 @@ ImageResource::ImageResource(const LoadRequest& request)
 
 ImageResource::~ImageResource()
 {
+    discard_decoded_frames();
 }
 
 int ImageResource::frame_duration(size_t frame_index) const
 {
-    decode_if_needed();
     if (frame_index >= m_decoded_frames.size())
         return 0;
     return m_decoded_frames[frame_index].duration;
@@ -65,16 +80,22 @@ void ImageResource::decode_if_needed() const
     if (!has_encoded_data())
         return;
 
-    if (m_has_attempted_decode)
+    if (m_has_attempted_decode || m_decode_in_progress)
         return;
 
-    if (!m_decoded_frames.is_empty())
-        return;
+    m_decode_in_progress = true;
+    NonnullRefPtr<ImageResource> protector = const_cast<ImageResource&>(*this);
+    image_decoder_client().decode_image_async(encoded_data(), [protector = move(protector)](auto image) mutable {
+        protector->did_decode(move(image));
+    });
+}
 
-    NonnullRefPtr decoder = image_decoder_client();
-    auto image = decoder->decode_image(encoded_data());
+void ImageResource::did_decode(Optional<ImageDecoderClient::DecodedImage> image)
+{
+    m_decode_in_progress = false;
 
     if (image.has_value()) {
+        discard_decoded_frames();
         m_loop_count = image.value().loop_count;
         m_animated = image.value().is_animated;
         m_decoded_frames.resize(image.value().frames.size());
@@ -83,9 +104,18 @@ void ImageResource::decode_if_needed() const
             frame.bitmap = image.value().frames[i].bitmap;
             frame.duration = image.value().frames[i].duration;
         }
+        m_last_use = s_next_use_serial++;
+        s_decoded_image_bytes += decoded_size_in_bytes();
+        decoded_image_resources().set(this);
     }
-
     m_has_attempted_decode = true;
+
+    if (image.has_value())
+        evict_decoded_images_if_needed();
+
+    for_each_client([](auto& client) {
+        static_cast<ImageResourceClient&>(client).resource_did_decode();
+    });
 }
 
 const Gfx::Bitmap* ImageResource::bitmap(size_t frame_index) const
@@ -93,18 +123,63 @@ const Gfx::Bitmap* ImageResource::bitmap(size_t frame_index) const
     decode_if_needed();
     if (frame_index >= m_decoded_frames.size())
         return nullptr;
+    m_last_use = s_next_use_serial++;
     return m_decoded_frames[frame_index].bitmap;
 }
 
-void ImageResource::update_volatility()
+size_t ImageResource::decoded_size_in_bytes() const
+{
+    size_t size = 0;
+    for (auto& frame : m_decoded_frames) {
+        if (frame.bitmap)
+            size += frame.bitmap->size_in_bytes();
+    }
+    return size;
+}
+
+void ImageResource::discard_decoded_frames()
+{
+    if (decoded_image_resources().remove(this))
+        s_decoded_image_bytes -= decoded_size_in_bytes();
+
+    // Keep the frame metadata around so animations can keep ticking; the bitmaps are decoded again on demand.
+    for (auto& frame : m_decoded_frames)
+        frame.bitmap = nullptr;
+    m_has_attempted_decode = false;
+}
+
+bool ImageResource::is_visible_in_viewport() const
 {
     bool visible_in_viewport = false;
-    for_each_client([&](auto& client) {
+    const_cast<ImageResource&>(*this).for_each_client([&](auto& client) {
         if (static_cast<const ImageResourceClient&>(client).is_visible_in_viewport())
             visible_in_viewport = true;
     });
+    return visible_in_viewport;
+}
+
+void ImageResource::evict_decoded_images_if_needed()
+{
+    if (s_decoded_image_bytes <= decoded_image_cache_budget)
+        return;
 
-    if (!visible_in_viewport) {
+    Vector<ImageResource*> candidates;
+    for (auto* resource : decoded_image_resources()) {
+        if (!resource->is_visible_in_viewport())
+            candidates.append(resource);
+    }
+    quick_sort(candidates, [](auto* a, auto* b) { return a->m_last_use < b->m_last_use; });
+
+    for (auto* resource : candidates) {
+        if (s_decoded_image_bytes <= decoded_image_cache_budget)
+            break;
+        resource->discard_decoded_frames();
+    }
+}
+
+void ImageResource::update_volatility()
+{
+    if (!is_visible_in_viewport()) {
         for (auto& frame : m_decoded_frames) {
             if (frame.bitmap)
                 frame.bitmap->set_volatile();
@@ -125,8 +200,8 @@ void ImageResource::update_volatility()
     if (still_has_decoded_image)
         return;
 
-    m_decoded_frames.clear();
-    m_has_attempted_decode = false;
+    discard_decoded_frames();
+    decode_if_needed();
 }
 
 ImageResourceClient::~ImageResourceClient()
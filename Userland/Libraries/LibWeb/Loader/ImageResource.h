@@ -28,6 +28,10 @@
 
 #include <LibWeb/Loader/Resource.h>
 
+namespace ImageDecoderClient {
+struct DecodedImage;
+}
+
 namespace Web {
 
 class ImageResource final : public Resource {
@@ -41,35 +45,36 @@ public:
         size_t duration { 0 };
     };
 
+    // NOTE: Decoding happens asynchronously. Until it's finished (and after the decoded frames have been
+    //       discarded to make room for other images), bitmap() returns nullptr and kicks off a new decode.
+    //       Clients are told via ImageResourceClient::resource_did_decode() once the frames are available.
     const Gfx::Bitmap* bitmap(size_t frame_index = 0) const;
     int frame_duration(size_t frame_index) const;
-    size_t frame_count() const
-    {
-        decode_if_needed();
-        return m_decoded_frames.size();
-    }
-    bool is_animated() const
-    {
-        decode_if_needed();
-        return m_animated;
-    }
-    size_t loop_count() const
-    {
-        decode_if_needed();
-        return m_loop_count;
-    }
+    size_t frame_count() const { return m_decoded_frames.size(); }
+    bool is_animated() const { return m_animated; }
+    size_t loop_count() const { return m_loop_count; }
+
+    bool has_attempted_decode() const { return m_has_attempted_decode; }
+    void decode_if_needed() const;
 
     void update_volatility();
 
 private:
     explicit ImageResource(const LoadRequest&);
 
-    void decode_if_needed() const;
+    void did_decode(Optional<ImageDecoderClient::DecodedImage>);
+    void discard_decoded_frames();
+    size_t decoded_size_in_bytes() const;
+    bool is_visible_in_viewport() const;
+
+    static void evict_decoded_images_if_needed();
 
     mutable bool m_animated { false };
     mutable int m_loop_count { 0 };
     mutable Vector<Frame> m_decoded_frames;
     mutable bool m_has_attempted_decode { false };
+    mutable bool m_decode_in_progress { false };
+    mutable u64 m_last_use { 0 };
 };
 
 class ImageResourceClient : public ResourceClient {
@@ -78,6 +83,8 @@ public:
 
     virtual bool is_visible_in_viewport() const { return false; }
 
+    virtual void resource_did_decode() { }
+
 protected:
     ImageResource* resource() { return static_cast<ImageResource*>(ResourceClient::resource()); }
     const ImageResource* resource() const { return static_cast<const ImageResource*>(ResourceClient::resource()); }
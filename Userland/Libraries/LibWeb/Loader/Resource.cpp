@@ -85,13 +85,34 @@ static String mime_type_from_content_type(const String& content_type)
     return content_type;
 }
 
+void Resource::did_receive_data(Badge<ResourceLoader>, ReadonlyBytes chunk, const HashMap<String, String, CaseInsensitiveStringTraits>& headers)
+{
+    VERIFY(!m_loaded);
+    if (m_received_size == 0)
+        set_response_headers(headers);
+    m_received_size += chunk.size();
+
+    for_each_client([&](auto& client) {
+        client.resource_did_receive_data(chunk);
+    });
+}
+
 void Resource::did_load(Badge<ResourceLoader>, ReadonlyBytes data, const HashMap<String, String, CaseInsensitiveStringTraits>& headers)
 {
     VERIFY(!m_loaded);
     m_encoded_data = ByteBuffer::copy(data);
-    m_response_headers = headers;
+    set_response_headers(headers);
     m_loaded = true;
 
+    for_each_client([](auto& client) {
+        client.resource_did_load();
+    });
+}
+
+void Resource::set_response_headers(const HashMap<String, String, CaseInsensitiveStringTraits>& headers)
+{
+    m_response_headers = headers;
+
     auto content_type = headers.get("Content-Type");
     if (content_type.has_value()) {
 #if RESOURCE_DEBUG
@@ -110,10 +131,6 @@ void Resource::did_load(Badge<ResourceLoader>, ReadonlyBytes data, const HashMap
         m_encoding = "utf-8"; // FIXME: This doesn't seem nice.
         m_mime_type = Core::guess_mime_type_based_on_filename(url().path());
     }
-
-    for_each_client([](auto& client) {
-        client.resource_did_load();
-    });
 }
 
 void Resource::did_fail(Badge<ResourceLoader>, const String& error)
@@ -77,6 +77,10 @@ public:
 
     void for_each_client(Function<void(ResourceClient&)>);
 
+    // How much of the body has been handed to clients through resource_did_receive_data() so far.
+    size_t received_size() const { return m_received_size; }
+
+    void did_receive_data(Badge<ResourceLoader>, ReadonlyBytes chunk, const HashMap<String, String, CaseInsensitiveStringTraits>& headers);
     void did_load(Badge<ResourceLoader>, ReadonlyBytes data, const HashMap<String, String, CaseInsensitiveStringTraits>& headers);
     void did_fail(Badge<ResourceLoader>, const String& error);
 
@@ -84,11 +88,14 @@ protected:
     explicit Resource(Type, const LoadRequest&);
 
 private:
+    void set_response_headers(const HashMap<String, String, CaseInsensitiveStringTraits>&);
+
     LoadRequest m_request;
     ByteBuffer m_encoded_data;
     Type m_type { Type::Generic };
     bool m_loaded { false };
     bool m_failed { false };
+    size_t m_received_size { 0 };
     String m_error;
     String m_encoding;
     String m_mime_type;
@@ -103,6 +110,9 @@ public:
     virtual void resource_did_load() { }
     virtual void resource_did_fail() { }
 
+    // Called with each chunk of the body as it arrives from the network, before resource_did_load().
+    virtual void resource_did_receive_data(ReadonlyBytes) { }
+
 protected:
     virtual Resource::Type client_type() const { return Resource::Type::Generic; }
 
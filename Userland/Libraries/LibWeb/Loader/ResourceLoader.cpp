@@ -73,12 +73,24 @@ void ResourceLoader::load_sync(const URL& url, Function<void(ReadonlyBytes, cons
 
 static HashMap<LoadRequest, NonnullRefPtr<Resource>> s_resource_cache;
 
+void ResourceLoader::purge_unused_cached_resources()
+{
+    Vector<LoadRequest> unused_requests;
+    for (auto& it : s_resource_cache) {
+        if (it.value->ref_count() == 1)
+            unused_requests.append(it.key);
+    }
+    for (auto& request : unused_requests)
+        s_resource_cache.remove(request);
+    dbgln_if(CACHE_DEBUG, "Purged {} unused cached resources", unused_requests.size());
+}
+
 RefPtr<Resource> ResourceLoader::load_resource(Resource::Type type, const LoadRequest& request)
 {
     if (!request.is_valid())
         return nullptr;
 
-    bool use_cache = request.url().protocol() != "file";
+    bool use_cache = is_cacheable(request);
 
     if (use_cache) {
         auto it = s_resource_cache.find(request);
@@ -104,17 +116,44 @@ RefPtr<Resource> ResourceLoader::load_resource(Resource::Type type, const LoadRe
         },
         [=](auto& error) {
             const_cast<Resource&>(*resource).did_fail({}, error);
+        },
+        [=](auto chunk, auto& headers) {
+            const_cast<Resource&>(*resource).did_receive_data({}, chunk, headers);
         });
 
     return resource;
 }
 
-void ResourceLoader::load(const LoadRequest& request, Function<void(ReadonlyBytes, const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers)> success_callback, Function<void(const String&)> error_callback)
+RefPtr<Resource> ResourceLoader::load_resource_sync(Resource::Type type, const LoadRequest& request)
+{
+    auto resource = load_resource(type, request);
+    if (!resource)
+        return nullptr;
+
+    Core::EventLoop loop;
+    while (!resource->is_loaded() && !resource->is_failed())
+        loop.pump();
+    return resource;
+}
+
+void ResourceLoader::prefetch_dns(const URL& url)
+{
+    if (url.protocol() != "http" && url.protocol() != "https" && url.protocol() != "gemini")
+        return;
+    if (url.host().is_empty() || m_prefetched_host_names.contains(url.host()))
+        return;
+    m_prefetched_host_names.set(url.host());
+    protocol_client().prefetch_host_name(url.host());
+}
+
+void ResourceLoader::load(const LoadRequest& request, Function<void(ReadonlyBytes, const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers)> success_callback, Function<void(const String&)> error_callback, Function<void(ReadonlyBytes, const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers)> data_received_callback)
 {
     auto& url = request.url();
 
     if (is_port_blocked(url.port())) {
         dbgln("ResourceLoader::load: Error: blocked port {} from URL {}", url.port(), url);
+        if (error_callback)
+            error_callback("Port is blocked");
         return;
     }
 
@@ -202,6 +241,14 @@ void ResourceLoader::load(const LoadRequest& request, Function<void(ReadonlyByte
             });
             success_callback(payload, response_headers);
         };
+        if (data_received_callback) {
+            download->on_buffered_data_received = [data_received_callback = move(data_received_callback)](auto& response_headers, auto status_code, ReadonlyBytes chunk) {
+                // Error pages are reported through the error callback once the download finishes.
+                if (status_code.has_value() && status_code.value() >= 400 && status_code.value() <= 499)
+                    return;
+                data_received_callback(chunk, response_headers);
+            };
+        }
         download->set_should_buffer_all_input(true);
         download->on_certificate_requested = []() -> Protocol::Download::CertificateAndKey {
             return {};
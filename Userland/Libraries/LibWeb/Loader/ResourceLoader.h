@@ -27,6 +27,7 @@
 #pragma once
 
 #include <AK/Function.h>
+#include <AK/HashTable.h>
 #include <AK/URL.h>
 #include <LibCore/Object.h>
 #include <LibWeb/Loader/Resource.h>
@@ -44,7 +45,17 @@ public:
 
     RefPtr<Resource> load_resource(Resource::Type, const LoadRequest&);
 
-    void load(const LoadRequest&, Function<void(ReadonlyBytes, const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers)> success_callback, Function<void(const String&)> error_callback = nullptr);
+    // Like load_resource(), but doesn't return until the resource has loaded or failed to. Returns null for invalid requests.
+    RefPtr<Resource> load_resource_sync(Resource::Type, const LoadRequest&);
+
+    // Resources loaded through load_resource() are shared with later requests for the same thing,
+    // which is what makes it worth loading them before they're needed.
+    static bool is_cacheable(const LoadRequest& request) { return request.url().protocol() != "file"; }
+
+    // Resolves the URL's host name ahead of time, so that loading from it later doesn't wait for DNS.
+    void prefetch_dns(const URL&);
+
+    void load(const LoadRequest&, Function<void(ReadonlyBytes, const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers)> success_callback, Function<void(const String&)> error_callback = nullptr, Function<void(ReadonlyBytes, const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers)> data_received_callback = nullptr);
     void load(const URL&, Function<void(ReadonlyBytes, const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers)> success_callback, Function<void(const String&)> error_callback = nullptr);
     void load_sync(const URL&, Function<void(ReadonlyBytes, const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers)> success_callback, Function<void(const String&)> error_callback = nullptr);
 
@@ -56,6 +67,9 @@ public:
 
     const String& user_agent() const { return m_user_agent; }
 
+    // Drops cached resources that nobody but the cache is holding on to.
+    void purge_unused_cached_resources();
+
 private:
     ResourceLoader();
     static bool is_port_blocked(int port);
@@ -63,6 +77,7 @@ private:
     int m_pending_loads { 0 };
 
     RefPtr<Protocol::Client> m_protocol_client;
+    HashTable<String> m_prefetched_host_names;
     String m_user_agent;
 };
 
@@ -153,15 +153,16 @@ void Frame::set_viewport_scroll_offset(const Gfx::IntPoint& offset)
 
 void Frame::set_needs_display(const Gfx::IntRect& rect)
 {
-    if (!viewport_rect().intersects(rect))
-        return;
-
     if (is_main_frame()) {
+        // NOTE: The client is told about off-screen invalidations too, since it may be caching painted content there.
         if (m_page)
             m_page->client().page_did_invalidate(to_main_frame_rect(rect));
         return;
     }
 
+    if (!viewport_rect().intersects(rect))
+        return;
+
     if (host_element() && host_element()->layout_node())
         host_element()->layout_node()->set_needs_display();
 }
@@ -30,6 +30,7 @@
 #include <LibWeb/Layout/Box.h>
 #include <LibWeb/Layout/InitialContainingBlockBox.h>
 #include <LibWeb/Painting/StackingContext.h>
+#include <LibWeb/RenderingStatistics.h>
 
 namespace Web::Layout {
 
@@ -50,6 +51,7 @@ StackingContext::StackingContext(Box& box, StackingContext* parent)
 
 void StackingContext::paint(PaintContext& context, PaintPhase phase)
 {
+    RenderingStatistics::Scope statistics_scope(RenderingStatistics::Phase::Paint);
     if (!is<InitialContainingBlockBox>(m_box)) {
         m_box.paint(context, phase);
     } else {
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Assertions.h>
+#include <LibWeb/RenderingStatistics.h>
+#include <stdlib.h>
+#include <time.h>
+
+namespace Web {
+
+RenderingStatistics& RenderingStatistics::the()
+{
+    static RenderingStatistics s_the;
+    return s_the;
+}
+
+const char* RenderingStatistics::phase_name(Phase phase)
+{
+    switch (phase) {
+    case Phase::Parse:
+        return "Parse";
+    case Phase::Style:
+        return "Style";
+    case Phase::Layout:
+        return "Layout";
+    case Phase::Paint:
+        return "Paint";
+    case Phase::__Count:
+        break;
+    }
+    VERIFY_NOT_REACHED();
+}
+
+static u64 now_in_us()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1'000'000 + ts.tv_nsec / 1000;
+}
+
+static size_t allocation_count()
+{
+#ifdef __serenity__
+    return serenity_allocation_count();
+#else
+    return 0;
+#endif
+}
+
+void RenderingStatistics::reset()
+{
+    m_phases = {};
+}
+
+void RenderingStatistics::charge_current_phase()
+{
+    auto now = now_in_us();
+    auto allocations = allocation_count();
+    if (m_current_phase.has_value()) {
+        auto& phase = m_phases[(size_t)m_current_phase.value()];
+        phase.total_us += now - m_last_mark_us;
+        phase.allocations += allocations - m_last_mark_allocations;
+    }
+    m_last_mark_us = now;
+    m_last_mark_allocations = allocations;
+}
+
+void RenderingStatistics::enter(Phase phase, Optional<Phase>& outer_phase)
+{
+    charge_current_phase();
+    outer_phase = m_current_phase;
+    // Recursion within a phase (like painting nested stacking contexts) is still one call.
+    if (!m_current_phase.has_value() || m_current_phase.value() != phase)
+        ++m_phases[(size_t)phase].count;
+    m_current_phase = phase;
+}
+
+void RenderingStatistics::leave(Optional<Phase> outer_phase)
+{
+    charge_current_phase();
+    m_current_phase = outer_phase;
+}
+
+RenderingStatistics::Scope::Scope(Phase phase)
+{
+    auto& statistics = RenderingStatistics::the();
+    if (!statistics.is_enabled())
+        return;
+    m_recording = true;
+    statistics.enter(phase, m_outer_phase);
+}
+
+RenderingStatistics::Scope::~Scope()
+{
+    if (m_recording)
+        RenderingStatistics::the().leave(m_outer_phase);
+}
+
+}
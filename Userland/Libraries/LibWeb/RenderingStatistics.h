@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Array.h>
+#include <AK/Optional.h>
+#include <AK/Types.h>
+
+namespace Web {
+
+// Where the time goes when rendering pages, split into phases. Nested phases are charged
+// exclusively, so styles resolved while building the layout tree count as Style, not Layout.
+// Recording reads the clock around every resolved style, so it's off unless a tool (like
+// `test-web --benchmark`) turns it on.
+class RenderingStatistics {
+public:
+    enum class Phase {
+        Parse,
+        Style,
+        Layout,
+        Paint,
+        __Count,
+    };
+
+    struct PhaseStatistics {
+        size_t count { 0 };
+        u64 total_us { 0 };
+        size_t allocations { 0 };
+    };
+
+    static RenderingStatistics& the();
+    static const char* phase_name(Phase);
+
+    bool is_enabled() const { return m_enabled; }
+    void set_enabled(bool enabled) { m_enabled = enabled; }
+
+    const PhaseStatistics& statistics_for(Phase phase) const { return m_phases[(size_t)phase]; }
+    void reset();
+
+    // Charges the time and allocations between construction and destruction to the phase.
+    class Scope {
+    public:
+        explicit Scope(Phase);
+        ~Scope();
+
+    private:
+        bool m_recording { false };
+        Optional<Phase> m_outer_phase;
+    };
+
+private:
+    RenderingStatistics() { }
+
+    void enter(Phase, Optional<Phase>& outer_phase);
+    void leave(Optional<Phase> outer_phase);
+    void charge_current_phase();
+
+    bool m_enabled { false };
+    Array<PhaseStatistics, (size_t)Phase::__Count> m_phases;
+    Optional<Phase> m_current_phase;
+    u64 m_last_mark_us { 0 };
+    size_t m_last_mark_allocations { 0 };
+};
+
+}
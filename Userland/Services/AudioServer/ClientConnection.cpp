@@ -147,6 +147,11 @@ OwnPtr<Messages::AudioServer::GetPlayingBufferResponse> ClientConnection::handle
     return make<Messages::AudioServer::GetPlayingBufferResponse>(id);
 }
 
+OwnPtr<Messages::AudioServer::GetLatencyResponse> ClientConnection::handle(const Messages::AudioServer::GetLatency&)
+{
+    return make<Messages::AudioServer::GetLatencyResponse>(m_mixer.average_latency_us());
+}
+
 OwnPtr<Messages::AudioServer::GetMutedResponse> ClientConnection::handle(const Messages::AudioServer::GetMuted&)
 {
     return make<Messages::AudioServer::GetMutedResponse>(m_mixer.is_muted());
@@ -25,16 +25,46 @@
  */
 
 #include <AK/Array.h>
-#include <AK/MemoryStream.h>
+#include <AK/Endian.h>
 #include <AK/NumericLimits.h>
+#include <AK/SIMD.h>
 #include <AudioServer/ClientConnection.h>
 #include <AudioServer/Mixer.h>
 #include <pthread.h>
-#include <strings.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <time.h>
 
 namespace AudioServer {
 
-Mixer::Mixer()
+using AK::SIMD::f64x2;
+using AK::SIMD::i32x2;
+
+static u64 now_in_us()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1'000'000 + ts.tv_nsec / 1'000;
+}
+
+// A sample is a pair of doubles, which is exactly one f64x2. Samples are only guaranteed
+// to be aligned like a double though, so they're loaded and stored with memcpy.
+ALWAYS_INLINE static f64x2 load(const Audio::Sample& sample)
+{
+    f64x2 value;
+    __builtin_memcpy(&value, static_cast<const void*>(&sample), sizeof(value));
+    return value;
+}
+
+ALWAYS_INLINE static void store(Audio::Sample& sample, f64x2 value)
+{
+    __builtin_memcpy(static_cast<void*>(&sample), &value, sizeof(value));
+}
+
+static_assert(sizeof(Audio::Sample) == sizeof(f64x2));
+
+Mixer::Mixer(int period_sample_count)
     : m_device(Core::File::construct("/dev/audio", this))
     , m_sound_thread(LibThread::Thread::construct(
           [this] {
@@ -42,17 +72,23 @@ Mixer::Mixer()
               return 0;
           },
           "AudioServer[mixer]"))
+    , m_period_sample_count(min(max(period_sample_count, 64), max_period_sample_count))
 {
+    pthread_mutex_init(&m_latency_mutex, nullptr);
+
     if (!m_device->open(Core::IODevice::WriteOnly)) {
         dbgln("Can't open audio device: {}", m_device->error_string());
         return;
     }
 
+    // Only keep two periods queued in the device: one playing, and the next one. Writes block until
+    // the device is done with a period, so we mix the next period just in time.
+    if (ioctl(m_device->fd(), SOUNDCARD_IOCTL_SET_QUEUE_LIMIT, 2 * m_period_sample_count * 2 * sizeof(i16)) < 0)
+        perror("ioctl(SOUNDCARD_IOCTL_SET_QUEUE_LIMIT)");
+
     pthread_mutex_init(&m_pending_mutex, nullptr);
     pthread_cond_init(&m_pending_cond, nullptr);
 
-    m_zero_filled_buffer = (u8*)malloc(4096);
-    bzero(m_zero_filled_buffer, 4096);
     m_sound_thread->start();
 }
 
@@ -86,8 +122,8 @@ void Mixer::mix()
 
         active_mix_queues.remove_all_matching([&](auto& entry) { return !entry->client(); });
 
-        Audio::Sample mixed_buffer[1024];
-        auto mixed_buffer_length = (int)(sizeof(mixed_buffer) / sizeof(Audio::Sample));
+        Audio::Sample mixed_buffer[max_period_sample_count];
+        int mixed_buffer_length = m_period_sample_count;
 
         // Mix the buffers together into the output
         for (auto& queue : active_mix_queues) {
@@ -95,43 +131,66 @@ void Mixer::mix()
                 queue->clear();
                 continue;
             }
-
-            for (int i = 0; i < mixed_buffer_length; ++i) {
-                auto& mixed_sample = mixed_buffer[i];
-                Audio::Sample sample;
-                if (!queue->get_next_sample(sample))
-                    break;
-                mixed_sample += sample;
-            }
+            queue->mix_into(mixed_buffer, mixed_buffer_length);
         }
 
+        Array<LittleEndian<i16>, max_period_sample_count * 2> buffer;
+        size_t buffer_size = mixed_buffer_length * 2 * sizeof(i16);
+
         if (m_muted) {
-            m_device->write(m_zero_filled_buffer, 4096);
+            for (int i = 0; i < mixed_buffer_length * 2; ++i)
+                buffer[i] = 0;
         } else {
-            Array<u8, 4096> buffer;
-            OutputMemoryStream stream { buffer };
+            f64x2 volume = f64x2 { 1, 1 } * ((double)m_main_volume / 100);
+            f64x2 lower_limit = { -1, -1 };
+            f64x2 upper_limit = { 1, 1 };
+            f64x2 to_i16 = f64x2 { 1, 1 } * (double)NumericLimits<i16>::max();
 
             for (int i = 0; i < mixed_buffer_length; ++i) {
-                auto& mixed_sample = mixed_buffer[i];
-
-                mixed_sample.scale(m_main_volume);
-                mixed_sample.clip();
-
-                LittleEndian<i16> out_sample;
-                out_sample = mixed_sample.left * NumericLimits<i16>::max();
-                stream << out_sample;
-
-                out_sample = mixed_sample.right * NumericLimits<i16>::max();
-                stream << out_sample;
+                auto sample = load(mixed_buffer[i]) * volume;
+                sample = sample < lower_limit ? lower_limit : sample;
+                sample = sample > upper_limit ? upper_limit : sample;
+                auto out_sample = __builtin_convertvector(sample * to_i16, i32x2);
+                buffer[i * 2] = out_sample[0];
+                buffer[i * 2 + 1] = out_sample[1];
             }
+        }
+
+        u64 mixed_at_us = now_in_us();
+        m_device->write((const u8*)buffer.data(), buffer_size);
 
-            VERIFY(stream.is_end());
-            VERIFY(!stream.has_any_error());
-            m_device->write(stream.data(), stream.size());
+        // Once the write goes through, this period plays after whatever the device still has queued before it.
+        // So a buffer's latency is how long it waited to be mixed, how long it took until the device took
+        // the period, how long until the device gets to the period, and where it starts in the period.
+        size_t queued_bytes = 0;
+        if (ioctl(m_device->fd(), SOUNDCARD_IOCTL_GET_QUEUED_BYTES, &queued_bytes) < 0)
+            queued_bytes = buffer_size;
+        u64 device_latency_us = (now_in_us() - mixed_at_us) + (u64)(max(queued_bytes, buffer_size) - buffer_size) / 4 * 1'000'000 / 44100;
+        for (auto& queue : active_mix_queues) {
+            if (auto wait_time_us = queue->take_wait_time_of_started_buffer_us(); wait_time_us.has_value())
+                did_measure_latency(wait_time_us.value() + device_latency_us);
         }
     }
 }
 
+void Mixer::did_measure_latency(u64 latency_us)
+{
+    pthread_mutex_lock(&m_latency_mutex);
+    m_latencies_us.enqueue(latency_us);
+    pthread_mutex_unlock(&m_latency_mutex);
+}
+
+u64 Mixer::average_latency_us() const
+{
+    pthread_mutex_lock(&m_latency_mutex);
+    u64 total_us = 0;
+    for (auto latency_us : m_latencies_us)
+        total_us += latency_us;
+    u64 average_us = m_latencies_us.is_empty() ? 0 : total_us / m_latencies_us.size();
+    pthread_mutex_unlock(&m_latency_mutex);
+    return average_us;
+}
+
 void Mixer::set_main_volume(int volume)
 {
     if (volume > 100)
@@ -161,6 +220,42 @@ BufferQueue::BufferQueue(ClientConnection& client)
 void BufferQueue::enqueue(NonnullRefPtr<Audio::Buffer>&& buffer)
 {
     m_remaining_samples += buffer->sample_count();
-    m_queue.enqueue(move(buffer));
+    m_queue.enqueue({ move(buffer), now_in_us() });
+}
+
+int BufferQueue::mix_into(Audio::Sample* mixed, int count)
+{
+    if (m_paused)
+        return 0;
+
+    int mixed_count = 0;
+    while (mixed_count < count) {
+        if (!m_current) {
+            if (m_queue.is_empty())
+                break;
+            auto queued_buffer = m_queue.dequeue();
+            m_current = move(queued_buffer.buffer);
+            u64 offset_in_period_us = (u64)mixed_count * 1'000'000 / 44100;
+            m_wait_time_of_started_buffer_us = now_in_us() - queued_buffer.enqueued_at_us + offset_in_period_us;
+        }
+
+        int chunk_count = min(count - mixed_count, m_current->sample_count() - m_position);
+        auto* samples = m_current->samples() + m_position;
+        auto* destination = mixed + mixed_count;
+        for (int i = 0; i < chunk_count; ++i)
+            store(destination[i], load(destination[i]) + load(samples[i]));
+
+        mixed_count += chunk_count;
+        m_position += chunk_count;
+        m_remaining_samples -= chunk_count;
+        m_played_samples += chunk_count;
+
+        if (m_position >= m_current->sample_count()) {
+            m_client->did_finish_playing_buffer({}, m_current->id());
+            m_current = nullptr;
+            m_position = 0;
+        }
+    }
+    return mixed_count;
 }
 }
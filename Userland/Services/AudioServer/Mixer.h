@@ -30,7 +30,9 @@
 #include <AK/Atomic.h>
 #include <AK/Badge.h>
 #include <AK/ByteBuffer.h>
+#include <AK/CircularQueue.h>
 #include <AK/NonnullRefPtrVector.h>
+#include <AK/Optional.h>
 #include <AK/Queue.h>
 #include <AK/RefCounted.h>
 #include <AK/WeakPtr.h>
@@ -51,27 +53,16 @@ public:
     bool is_full() const { return m_queue.size() >= 3; }
     void enqueue(NonnullRefPtr<Audio::Buffer>&&);
 
-    bool get_next_sample(Audio::Sample& sample)
-    {
-        if (m_paused)
-            return false;
-
-        while (!m_current && !m_queue.is_empty())
-            m_current = m_queue.dequeue();
-
-        if (!m_current)
-            return false;
+    // Adds up to count samples to mixed, and returns how many there were.
+    int mix_into(Audio::Sample* mixed, int count);
 
-        sample = m_current->samples()[m_position++];
-        --m_remaining_samples;
-        ++m_played_samples;
-
-        if (m_position >= m_current->sample_count()) {
-            m_client->did_finish_playing_buffer({}, m_current->id());
-            m_current = nullptr;
-            m_position = 0;
-        }
-        return true;
+    // How long it took from enqueuing the buffer that most recently started playing until its first
+    // sample got mixed, or nothing if no buffer started playing since the last call.
+    Optional<u64> take_wait_time_of_started_buffer_us()
+    {
+        auto wait_time_us = m_wait_time_of_started_buffer_us;
+        m_wait_time_of_started_buffer_us = {};
+        return wait_time_us;
     }
 
     ClientConnection* client() { return m_client.ptr(); }
@@ -101,8 +92,14 @@ public:
     }
 
 private:
+    struct QueuedBuffer {
+        NonnullRefPtr<Audio::Buffer> buffer;
+        u64 enqueued_at_us;
+    };
+
     RefPtr<Audio::Buffer> m_current;
-    Queue<NonnullRefPtr<Audio::Buffer>> m_queue;
+    Queue<QueuedBuffer> m_queue;
+    Optional<u64> m_wait_time_of_started_buffer_us;
     int m_position { 0 };
     int m_remaining_samples { 0 };
     int m_played_samples { 0 };
@@ -113,9 +110,11 @@ private:
 class Mixer : public Core::Object {
     C_OBJECT(Mixer)
 public:
-    Mixer();
     virtual ~Mixer() override;
 
+    // The device takes at most a page of 16-bit stereo samples at a time.
+    static constexpr int max_period_sample_count = 1024;
+
     NonnullRefPtr<BufferQueue> create_queue(ClientConnection&);
 
     int main_volume() const { return m_main_volume; }
@@ -124,7 +123,18 @@ public:
     bool is_muted() const { return m_muted; }
     void set_muted(bool);
 
+    int period_sample_count() const { return m_period_sample_count; }
+
+    // The average time from a buffer being enqueued to its first sample being played, over the
+    // last few buffers. This includes waiting for the buffers ahead of it, so it depends on how
+    // much audio the clients queue up.
+    u64 average_latency_us() const;
+
 private:
+    explicit Mixer(int period_sample_count);
+
+    void did_measure_latency(u64 latency_us);
+
     Vector<NonnullRefPtr<BufferQueue>> m_pending_mixing;
     Atomic<bool> m_added_queue { false };
     pthread_mutex_t m_pending_mutex;
@@ -137,7 +147,10 @@ private:
     bool m_muted { false };
     int m_main_volume { 100 };
 
-    u8* m_zero_filled_buffer { nullptr };
+    int m_period_sample_count { max_period_sample_count };
+
+    mutable pthread_mutex_t m_latency_mutex;
+    CircularQueue<u64, 16> m_latencies_us;
 
     void mix();
 };
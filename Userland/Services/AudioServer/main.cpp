@@ -25,6 +25,7 @@
  */
 
 #include "Mixer.h"
+#include <LibCore/ConfigFile.h>
 #include <LibCore/File.h>
 #include <LibCore/LocalServer.h>
 
@@ -35,8 +36,12 @@ int main(int, char**)
         return 1;
     }
 
+    auto config = Core::ConfigFile::get_for_system("AudioServer");
+    // Smaller periods lower the latency, but the mixer has to wake up more often to fill them.
+    int period_sample_count = config->read_num_entry("Mixer", "PeriodSamples", 512);
+
     Core::EventLoop event_loop;
-    AudioServer::Mixer mixer;
+    auto mixer = AudioServer::Mixer::construct(period_sample_count);
 
     auto server = Core::LocalServer::construct();
     bool ok = server->take_over_from_system_server();
@@ -49,7 +54,7 @@ int main(int, char**)
         }
         static int s_next_client_id = 0;
         int client_id = ++s_next_client_id;
-        IPC::new_client_connection<AudioServer::ClientConnection>(client_socket.release_nonnull(), client_id, mixer);
+        IPC::new_client_connection<AudioServer::ClientConnection>(client_socket.release_nonnull(), client_id, *mixer);
     };
 
     if (pledge("stdio recvfd thread accept", nullptr) < 0) {
@@ -28,6 +28,7 @@
 #include "MCTSTree.h"
 #include <AK/Debug.h>
 #include <LibCore/ElapsedTimer.h>
+#include <LibThread/ThreadPool.h>
 
 using namespace Chess::UCI;
 
@@ -59,17 +60,33 @@ void ChessEngine::handle_go(const GoCommand& command)
     Core::ElapsedTimer elapsed_time;
     elapsed_time.start();
 
-    MCTSTree mcts(m_board);
-
-    // FIXME: optimize simulations enough for use.
-    mcts.set_eval_method(MCTSTree::EvalMethod::Heuristic);
+    // Every worker searches a tree of its own, and their results are merged at the end (root parallelization).
+    // Unlike sharing a single tree, that needs no locking, and the trees still explore somewhat different lines.
+    auto& thread_pool = LibThread::ThreadPool::the();
+    NonnullOwnPtrVector<MCTSTree> trees;
+    for (size_t i = 0; i < thread_pool.worker_count(); ++i) {
+        auto tree = make<MCTSTree>(m_board);
+        // FIXME: optimize simulations enough for use.
+        tree->set_eval_method(MCTSTree::EvalMethod::Heuristic);
+        trees.append(move(tree));
+    }
 
-    int rounds = 0;
-    while (elapsed_time.elapsed() <= command.movetime.value()) {
-        mcts.do_round();
-        ++rounds;
+    {
+        LibThread::TaskGroup search(thread_pool);
+        for (auto& tree : trees) {
+            search.spawn([&tree, &elapsed_time, movetime = command.movetime.value()] {
+                while (elapsed_time.elapsed() <= movetime)
+                    tree.do_round();
+            });
+        }
     }
-    dbgln("MCTS finished {} rounds.", rounds);
+
+    auto& mcts = trees.first();
+    for (size_t i = 1; i < trees.size(); ++i)
+        mcts.merge(trees[i]);
+
+    auto rounds = mcts.simulations();
+    dbgln("MCTS finished {} rounds in {} trees, {} rounds per second.", rounds, trees.size(), rounds * 1000ll / max(elapsed_time.elapsed(), 1));
     dbgln("MCTS evaluation {}", mcts.expected_value());
     auto best_move = mcts.best_move();
     dbgln("MCTS best move {}", best_move.to_long_algebraic());
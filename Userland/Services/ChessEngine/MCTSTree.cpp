@@ -35,6 +35,32 @@ MCTSTree::MCTSTree(const Chess::Board& board, double exploration_parameter, MCTS
 {
     if (m_parent)
         m_eval_method = m_parent->eval_method();
+    else
+        m_random_state = max(arc4random(), 1u);
+}
+
+u32 MCTSTree::random()
+{
+    auto* root = this;
+    while (root->m_parent)
+        root = root->m_parent;
+    // xorshift32
+    auto& state = root->m_random_state;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+void MCTSTree::generate_children()
+{
+    m_board.generate_moves([&](Chess::Move move) {
+        Chess::Board clone = m_board;
+        clone.apply_move(move);
+        m_children.append(make<MCTSTree>(clone, m_exploration_parameter, this));
+        return IterationDecision::Continue;
+    });
+    m_moves_generated = true;
 }
 
 MCTSTree& MCTSTree::select_leaf()
@@ -59,15 +85,8 @@ MCTSTree& MCTSTree::expand()
 {
     VERIFY(!expanded() || m_children.size() == 0);
 
-    if (!m_moves_generated) {
-        m_board.generate_moves([&](Chess::Move move) {
-            Chess::Board clone = m_board;
-            clone.apply_move(move);
-            m_children.append(make<MCTSTree>(clone, m_exploration_parameter, this));
-            return IterationDecision::Continue;
-        });
-        m_moves_generated = true;
-    }
+    if (!m_moves_generated)
+        generate_children();
 
     if (m_children.size() == 0) {
         return *this;
@@ -91,14 +110,14 @@ int MCTSTree::simulate_game() const
     return clone.game_score();
 }
 
-int MCTSTree::heuristic() const
+int MCTSTree::heuristic()
 {
     if (m_board.game_finished())
         return m_board.game_score();
 
     double winchance = max(min(double(m_board.material_imbalance()) / 6, 1.0), -1.0);
 
-    double random = double(rand()) / RAND_MAX;
+    double random = double(this->random()) / NumericLimits<u32>::max();
     if (winchance >= random)
         return 1;
     if (winchance <= -random)
@@ -129,6 +148,24 @@ void MCTSTree::do_round()
     node.apply_result(result);
 }
 
+void MCTSTree::merge(const MCTSTree& other)
+{
+    m_simulations += other.m_simulations;
+    m_white_points += other.m_white_points;
+
+    if (!other.m_moves_generated)
+        return;
+    if (!m_moves_generated)
+        generate_children();
+
+    // Both trees generated the children from the same position, so they come in the same order.
+    VERIFY(m_children.size() == other.m_children.size());
+    for (size_t i = 0; i < m_children.size(); ++i) {
+        m_children[i].m_simulations += other.m_children[i].m_simulations;
+        m_children[i].m_white_points += other.m_children[i].m_white_points;
+    }
+}
+
 Chess::Move MCTSTree::best_move() const
 {
     int score_multiplier = (m_board.turn() == Chess::Color::White) ? 1 : -1;
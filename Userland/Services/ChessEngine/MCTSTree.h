@@ -43,10 +43,16 @@ public:
     MCTSTree& select_leaf();
     MCTSTree& expand();
     int simulate_game() const;
-    int heuristic() const;
+    int heuristic();
     void apply_result(int game_score);
     void do_round();
 
+    // Adds the results of another tree that searched the same position, so that several trees can be
+    // searched in parallel. Only the root and its children are merged, that's all best_move() looks at.
+    void merge(const MCTSTree& other);
+
+    int simulations() const { return m_simulations; }
+
     Chess::Move best_move() const;
     double expected_value() const;
     double uct(Chess::Color color) const;
@@ -56,6 +62,9 @@ public:
     void set_eval_method(EvalMethod method) { m_eval_method = method; }
 
 private:
+    void generate_children();
+    u32 random();
+
     NonnullOwnPtrVector<MCTSTree> m_children;
     MCTSTree* m_parent { nullptr };
     int m_white_points { 0 };
@@ -63,5 +72,7 @@ private:
     bool m_moves_generated { false };
     double m_exploration_parameter;
     EvalMethod m_eval_method { EvalMethod::Simulation };
+    // Only used in the root, every tree has its own so that trees can be searched on different threads.
+    u32 m_random_state { 0 };
     Chess::Board m_board;
 };
@@ -26,9 +26,8 @@
 
 #include <AK/Badge.h>
 #include <ImageDecoder/ClientConnection.h>
+#include <ImageDecoder/DecodeQueue.h>
 #include <ImageDecoder/ImageDecoderClientEndpoint.h>
-#include <LibGfx/Bitmap.h>
-#include <LibGfx/ImageDecoder.h>
 #include <LibGfx/SystemTheme.h>
 
 namespace ImageDecoder {
@@ -47,6 +46,7 @@ ClientConnection::~ClientConnection()
 
 void ClientConnection::die()
 {
+    DecodeQueue::the().cancel_decodes_for_client(client_id());
     s_connections.remove(client_id());
     exit(0);
 }
@@ -58,42 +58,21 @@ OwnPtr<Messages::ImageDecoderServer::GreetResponse> ClientConnection::handle(con
 
 OwnPtr<Messages::ImageDecoderServer::DecodeImageResponse> ClientConnection::handle(const Messages::ImageDecoderServer::DecodeImage& message)
 {
-    auto encoded_buffer = message.data();
-    if (!encoded_buffer.is_valid()) {
-#if IMAGE_DECODER_DEBUG
-        dbgln("Encoded data is invalid");
-#endif
+    auto result = decode_image(message.data());
+    if (!result.has_value())
         return {};
-    }
-
-    auto decoder = Gfx::ImageDecoder::create(encoded_buffer.data<u8>(), encoded_buffer.size());
-
-    if (!decoder->frame_count()) {
-#if IMAGE_DECODER_DEBUG
-        dbgln("Could not decode image from encoded data");
-#endif
-        return make<Messages::ImageDecoderServer::DecodeImageResponse>(false, 0, Vector<Gfx::ShareableBitmap> {}, Vector<u32> {});
-    }
+    return make<Messages::ImageDecoderServer::DecodeImageResponse>(result->is_animated, result->loop_count, result->bitmaps, result->durations);
+}
 
-    Vector<Gfx::ShareableBitmap> bitmaps;
-    Vector<u32> durations;
-    for (size_t i = 0; i < decoder->frame_count(); ++i) {
-        // FIXME: All image decoder plugins should be rewritten to return frame() instead of bitmap().
-        //        Non-animated images can simply return 1 frame.
-        Gfx::ImageFrameDescriptor frame;
-        if (decoder->is_animated()) {
-            frame = decoder->frame(i);
-        } else {
-            frame.image = decoder->bitmap();
+void ClientConnection::handle(const Messages::ImageDecoderServer::DecodeImageAsync& message)
+{
+    DecodeQueue::the().enqueue(client_id(), message.data(), [this, request_id = message.request_id()](auto& result) {
+        if (!result.has_value()) {
+            post_message(Messages::ImageDecoderClient::DidDecodeImage(request_id, false, false, 0, {}, {}));
+            return;
         }
-        if (frame.image)
-            bitmaps.append(frame.image->to_shareable_bitmap());
-        else
-            bitmaps.append(Gfx::ShareableBitmap {});
-        durations.append(frame.duration);
-    }
-
-    return make<Messages::ImageDecoderServer::DecodeImageResponse>(decoder->is_animated(), decoder->loop_count(), bitmaps, durations);
+        post_message(Messages::ImageDecoderClient::DidDecodeImage(request_id, true, result->is_animated, result->loop_count, result->bitmaps, result->durations));
+    });
 }
 
 }
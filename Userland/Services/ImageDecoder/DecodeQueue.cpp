@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Debug.h>
+#include <ImageDecoder/DecodeQueue.h>
+#include <LibCore/Event.h>
+#include <LibCore/EventLoop.h>
+#include <LibGfx/Bitmap.h>
+#include <LibGfx/ImageDecoder.h>
+#include <LibThread/ThreadPool.h>
+#include <string.h>
+
+namespace ImageDecoder {
+
+Optional<DecodeResult> decode_image(const Core::AnonymousBuffer& encoded_buffer)
+{
+    if (!encoded_buffer.is_valid()) {
+#if IMAGE_DECODER_DEBUG
+        dbgln("Encoded data is invalid");
+#endif
+        return {};
+    }
+
+    auto decoder = Gfx::ImageDecoder::create(encoded_buffer.data<u8>(), encoded_buffer.size());
+
+    DecodeResult result;
+    if (!decoder->frame_count()) {
+#if IMAGE_DECODER_DEBUG
+        dbgln("Could not decode image from encoded data");
+#endif
+        return result;
+    }
+
+    result.is_animated = decoder->is_animated();
+    result.loop_count = decoder->loop_count();
+    for (size_t i = 0; i < decoder->frame_count(); ++i) {
+        // FIXME: All image decoder plugins should be rewritten to return frame() instead of bitmap().
+        //        Non-animated images can simply return 1 frame.
+        Gfx::ImageFrameDescriptor frame;
+        if (decoder->is_animated()) {
+            frame = decoder->frame(i);
+        } else {
+            frame.image = decoder->bitmap();
+        }
+        if (frame.image)
+            result.bitmaps.append(frame.image->to_shareable_bitmap());
+        else
+            result.bitmaps.append(Gfx::ShareableBitmap {});
+        result.durations.append(frame.duration);
+    }
+    return result;
+}
+
+DecodeQueue& DecodeQueue::the()
+{
+    // This is never destroyed, as decodes may still be running on the thread pool when the process exits.
+    static DecodeQueue* s_the;
+    if (!s_the)
+        s_the = &DecodeQueue::construct().leak_ref();
+    return *s_the;
+}
+
+DecodeQueue::DecodeQueue()
+{
+    // The thread pool posts the results to us, which needs a weak pointer to us. Creating the first one
+    // isn't thread-safe, so do it now.
+    [[maybe_unused]] auto weak_this = make_weak_ptr();
+}
+
+static u32 hash_data(const Core::AnonymousBuffer& data)
+{
+    if (!data.is_valid())
+        return 0;
+    return string_hash(data.data<char>(), data.size());
+}
+
+static bool has_same_data(const Core::AnonymousBuffer& a, const Core::AnonymousBuffer& b)
+{
+    if (!a.is_valid() || !b.is_valid())
+        return false;
+    return a.size() == b.size() && !memcmp(a.data<void>(), b.data<void>(), a.size());
+}
+
+void DecodeQueue::enqueue(int client_id, const Core::AnonymousBuffer& data, Callback callback)
+{
+    auto hash = hash_data(data);
+    for (auto& job : m_jobs) {
+        if (job.hash == hash && has_same_data(job.data, data)) {
+            dbgln_if(IMAGE_DECODER_DEBUG, "Joining a decode of the same {} bytes", data.size());
+            job.waiters.append({ client_id, move(callback) });
+            return;
+        }
+    }
+
+    auto job = adopt(*new Job);
+    job->data = data;
+    job->hash = hash;
+    job->waiters.append({ client_id, move(callback) });
+    m_jobs.append(job);
+
+    LibThread::ThreadPool::the().submit([this, job = move(job)] {
+        decode(job);
+    });
+}
+
+void DecodeQueue::cancel_decodes_for_client(int client_id)
+{
+    for (size_t i = 0; i < m_jobs.size();) {
+        auto& job = m_jobs[i];
+        job.waiters.remove_all_matching([&](auto& waiter) { return waiter.client_id == client_id; });
+        if (!job.waiters.is_empty()) {
+            ++i;
+            continue;
+        }
+        // A worker skips the job if it hasn't started on it yet, and we'll ignore the result otherwise.
+        job.cancelled = true;
+        m_jobs.remove(i);
+    }
+}
+
+// This runs on the thread pool.
+void DecodeQueue::decode(NonnullRefPtr<Job> job)
+{
+    if (job->cancelled)
+        return;
+
+    job->result = decode_image(job->data);
+    Core::EventLoop::main().post_event(*this, make<Core::DeferredInvocationEvent>([this, job = move(job)](auto&) {
+        did_finish(job);
+    }));
+    Core::EventLoop::wake();
+}
+
+void DecodeQueue::did_finish(NonnullRefPtr<Job> job)
+{
+    if (job->cancelled)
+        return;
+
+    m_jobs.remove_first_matching([&](auto& other) { return other.ptr() == job.ptr(); });
+    // Failing to post to a client cancels its decodes, so don't go through the list while calling back.
+    auto waiters = move(job->waiters);
+    for (auto& waiter : waiters)
+        waiter.callback(job->result);
+}
+
+}
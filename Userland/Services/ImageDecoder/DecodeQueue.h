@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/Function.h>
+#include <AK/NonnullRefPtrVector.h>
+#include <AK/Optional.h>
+#include <AK/RefCounted.h>
+#include <AK/Vector.h>
+#include <LibCore/AnonymousBuffer.h>
+#include <LibCore/Object.h>
+#include <LibGfx/ShareableBitmap.h>
+
+namespace ImageDecoder {
+
+struct DecodeResult {
+    bool is_animated { false };
+    u32 loop_count { 0 };
+    Vector<Gfx::ShareableBitmap> bitmaps;
+    Vector<u32> durations;
+};
+
+Optional<DecodeResult> decode_image(const Core::AnonymousBuffer&);
+
+// Decodes images on the thread pool, so that the images a client sends us one after the other
+// (like the ones on a web page) don't have to wait for each other. Requests for the same image
+// data share a single decode. Everything but the decoding itself happens on the main thread.
+class DecodeQueue final : public Core::Object {
+    C_OBJECT(DecodeQueue);
+
+public:
+    using Callback = Function<void(const Optional<DecodeResult>&)>;
+
+    static DecodeQueue& the();
+
+    void enqueue(int client_id, const Core::AnonymousBuffer&, Callback);
+
+    // Drops the client's callbacks, and the decodes nobody else is waiting for.
+    void cancel_decodes_for_client(int client_id);
+
+private:
+    struct Waiter {
+        int client_id { 0 };
+        Callback callback;
+    };
+
+    struct Job : public RefCounted<Job> {
+        Core::AnonymousBuffer data;
+        u32 hash { 0 };
+        Vector<Waiter> waiters;
+        Optional<DecodeResult> result;
+        Atomic<bool> cancelled { false };
+    };
+
+    DecodeQueue();
+
+    void decode(NonnullRefPtr<Job>);
+    void did_finish(NonnullRefPtr<Job>);
+
+    // Jobs that haven't finished yet, either queued or being decoded.
+    NonnullRefPtrVector<Job> m_jobs;
+};
+
+}
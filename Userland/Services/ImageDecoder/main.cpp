@@ -32,7 +32,7 @@
 int main(int, char**)
 {
     Core::EventLoop event_loop;
-    if (pledge("stdio recvfd sendfd unix", nullptr) < 0) {
+    if (pledge("stdio recvfd sendfd unix thread", nullptr) < 0) {
         perror("pledge");
         return 1;
     }
@@ -43,7 +43,7 @@ int main(int, char**)
 
     auto socket = Core::LocalSocket::take_over_accepted_socket_from_system_server();
     IPC::new_client_connection<ImageDecoder::ClientConnection>(socket.release_nonnull(), 1);
-    if (pledge("stdio recvfd sendfd", nullptr) < 0) {
+    if (pledge("stdio recvfd sendfd thread", nullptr) < 0) {
         perror("pledge");
         return 1;
     }
@@ -43,6 +43,8 @@ public:
     const String& record_data() const { return m_record_data; }
 
     bool has_expired() const;
+    // How many of the seconds in the TTL are left, for passing on cached answers.
+    u32 remaining_ttl() const;
 
 private:
     DNSName m_name;
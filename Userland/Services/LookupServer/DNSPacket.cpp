@@ -137,10 +137,6 @@ Optional<DNSPacket> DNSPacket::from_raw_packet(const u8* raw_data, size_t raw_si
     packet.m_query_or_response = header.is_response();
     packet.m_code = header.response_code();
 
-    // FIXME: Should we parse further in this case?
-    if (packet.code() != Code::NOERROR)
-        return packet;
-
     size_t offset = sizeof(DNSPacketHeader);
 
     for (u16 i = 0; i < header.question_count(); i++) {
@@ -158,6 +154,10 @@ Optional<DNSPacket> DNSPacket::from_raw_packet(const u8* raw_data, size_t raw_si
 #endif
     }
 
+    // FIXME: Should we parse further in this case?
+    if (packet.code() != Code::NOERROR && packet.code() != Code::NXDOMAIN)
+        return packet;
+
     for (u16 i = 0; i < header.answer_count(); ++i) {
         auto name = DNSName::parse(raw_data, offset, raw_size);
 
@@ -183,6 +183,29 @@ Optional<DNSPacket> DNSPacket::from_raw_packet(const u8* raw_data, size_t raw_si
         offset += record.data_length();
     }
 
+    // A negative answer comes with the SOA record of the zone in the authority section, which says for how long it may be cached.
+    for (u16 i = 0; i < header.authority_count(); ++i) {
+        DNSName::parse(raw_data, offset, raw_size);
+        if (offset + sizeof(DNSRecordWithoutName) > raw_size)
+            break;
+        auto& record = *(const DNSRecordWithoutName*)(&raw_data[offset]);
+        offset += sizeof(DNSRecordWithoutName);
+        size_t next_record_offset = offset + record.data_length();
+
+        if (record.type() == T_SOA) {
+            // Skip the names of the primary nameserver and of the responsible mailbox.
+            DNSName::parse(raw_data, offset, raw_size);
+            DNSName::parse(raw_data, offset, raw_size);
+            // This is followed by the serial, refresh, retry and expire times, and then the minimum TTL.
+            size_t minimum_offset = offset + 4 * sizeof(u32);
+            if (minimum_offset + sizeof(u32) <= raw_size && minimum_offset + sizeof(u32) <= next_record_offset) {
+                auto minimum = *(const NetworkOrdered<u32>*)(&raw_data[minimum_offset]);
+                packet.m_negative_answer_ttl = min(record.ttl(), (u32)minimum);
+            }
+        }
+        offset = next_record_offset;
+    }
+
     return packet;
 }
 
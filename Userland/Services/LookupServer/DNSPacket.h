@@ -98,12 +98,16 @@ public:
     Code code() const { return (Code)m_code; }
     void set_code(Code code) { m_code = (u8)code; }
 
+    // How long the absence of an answer may be cached, if the response said so.
+    Optional<u32> negative_answer_ttl() const { return m_negative_answer_ttl; }
+
 private:
     u16 m_id { 0 };
     u8 m_code { 0 };
     bool m_query_or_response { false };
     Vector<DNSQuestion> m_questions;
     Vector<DNSAnswer> m_answers;
+    Optional<u32> m_negative_answer_ttl;
 };
 
 }
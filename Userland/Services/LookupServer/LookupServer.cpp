@@ -27,6 +27,8 @@
 #include "LookupServer.h"
 #include "ClientConnection.h"
 #include "DNSPacket.h"
+#include <AK/AllOf.h>
+#include <AK/AnyOf.h>
 #include <AK/ByteBuffer.h>
 #include <AK/Debug.h>
 #include <AK/HashMap.h>
@@ -37,8 +39,11 @@
 #include <LibCore/LocalServer.h>
 #include <LibCore/LocalSocket.h>
 #include <LibCore/UDPSocket.h>
+#include <errno.h>
+#include <poll.h>
 #include <stdio.h>
 #include <sys/time.h>
+#include <time.h>
 #include <unistd.h>
 
 namespace LookupServer {
@@ -138,12 +143,12 @@ Vector<DNSAnswer> LookupServer::lookup(const DNSName& name, unsigned short recor
 #endif
 
     Vector<DNSAnswer> answers;
-    auto add_answer = [&](const DNSAnswer& answer) {
+    auto add_answer = [&](const DNSAnswer& answer, u32 ttl) {
         DNSAnswer answer_with_original_case {
             name,
             answer.type(),
             answer.class_code(),
-            answer.ttl(),
+            ttl,
             answer.record_data()
         };
         answers.append(answer_with_original_case);
@@ -153,102 +158,180 @@ Vector<DNSAnswer> LookupServer::lookup(const DNSName& name, unsigned short recor
     if (auto local_answers = m_etc_hosts.get(name); local_answers.has_value()) {
         for (auto& answer : local_answers.value()) {
             if (answer.type() == record_type)
-                add_answer(answer);
+                add_answer(answer, answer.ttl());
         }
         if (!answers.is_empty())
             return answers;
     }
 
     // Second, try our cache.
+    remove_expired_answers(name);
     if (auto cached_answers = m_lookup_cache.get(name); cached_answers.has_value()) {
         for (auto& answer : cached_answers.value()) {
-            // TODO: Actually remove expired answers from the cache.
-            if (answer.type() == record_type && !answer.has_expired()) {
+            if (answer.type() == record_type) {
 #if LOOKUPSERVER_DEBUG
                 dbgln("Cache hit: {} -> {}", name.as_string(), answer.record_data());
 #endif
-                add_answer(answer);
+                add_answer(answer, answer.remaining_ttl());
             }
         }
         if (!answers.is_empty())
             return answers;
     }
-
-    // Third, ask the upstream nameservers.
-    for (auto& nameserver : m_nameservers) {
+    if (is_in_negative_cache(name, record_type)) {
 #if LOOKUPSERVER_DEBUG
-        dbgln("Doing lookup using nameserver '{}'", nameserver);
+        dbgln("Negative cache hit: {}", name.as_string());
 #endif
-        bool did_get_response = false;
-        int retries = 3;
-        Vector<DNSAnswer> upstream_answers;
-        do {
-            upstream_answers = lookup(name, nameserver, did_get_response, record_type);
-            if (did_get_response)
-                break;
-        } while (--retries);
-        if (!upstream_answers.is_empty()) {
-            for (auto& answer : upstream_answers)
-                add_answer(answer);
-            break;
-        } else {
-            if (!did_get_response)
-                dbgln("Never got a response from '{}', trying next nameserver", nameserver);
-            else
-                dbgln("Received response from '{}' but no result(s), trying next nameserver", nameserver);
-        }
-    }
-    if (answers.is_empty()) {
-        dbgln("Tried all nameservers but never got a response :(");
         return {};
     }
 
-    return move(answers);
+    // Third, ask the upstream nameservers.
+    for (auto& answer : lookup_upstream(name, record_type))
+        add_answer(answer, answer.ttl());
+    return answers;
 }
 
-Vector<DNSAnswer> LookupServer::lookup(const DNSName& name, const String& nameserver, bool& did_get_response, unsigned short record_type, ShouldRandomizeCase should_randomize_case)
+// A question that was sent to one of the upstream nameservers, and that's waiting for an answer.
+struct LookupServer::UpstreamQuery {
+    DNSName name;
+    unsigned short record_type { 0 };
+    String nameserver;
+    RefPtr<Core::UDPSocket> socket {};
+    DNSPacket request {};
+    ShouldRandomizeCase should_randomize_case { ShouldRandomizeCase::Yes };
+    bool is_done { false };
+};
+
+static u64 now_in_ms()
 {
-    DNSPacket request;
-    request.set_is_query();
-    request.set_id(arc4random_uniform(UINT16_MAX));
-    DNSName name_in_question = name;
-    if (should_randomize_case == ShouldRandomizeCase::Yes)
-        name_in_question.randomize_case();
-    request.add_question({ name_in_question, record_type, C_IN });
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000 + ts.tv_nsec / 1'000'000;
+}
 
-    auto buffer = request.to_byte_buffer();
+Vector<DNSAnswer> LookupServer::lookup_upstream(const DNSName& name, unsigned short record_type)
+{
+    // How long to cache that we couldn't reach any nameserver. Lookups of the same name that
+    // were waiting behind this one then fail right away instead of waiting all over again.
+    static constexpr u32 unreachable_ttl = 5;
+    // How long to cache that a name doesn't exist if the nameserver didn't say.
+    static constexpr u32 default_negative_ttl = 60;
+
+    static constexpr int attempt_count = 3;
+    static constexpr u64 attempt_timeout_ms = 1000;
+
+    // Ask all nameservers at once and go with whichever answers first, so that a slow or
+    // unreachable nameserver doesn't hold up the lookup.
+    Vector<UpstreamQuery> queries;
+    for (auto& nameserver : m_nameservers) {
+        UpstreamQuery query { name, record_type, nameserver };
+        if (send_query(query, name, record_type))
+            queries.append(move(query));
+    }
 
-    auto udp_socket = Core::UDPSocket::construct();
-    udp_socket->set_blocking(true);
+    for (int attempt = 0; attempt < attempt_count; ++attempt) {
+        if (attempt > 0) {
+            // Ask again whoever hasn't answered yet, in case a packet got lost.
+            for (auto& query : queries) {
+                if (!query.is_done && !send_query(query, name, record_type))
+                    query.is_done = true;
+            }
+        }
 
-    struct timeval timeout {
-        1, 0
-    };
+        u64 deadline_ms = now_in_ms() + attempt_timeout_ms;
+        for (;;) {
+            Vector<pollfd, 4> fds;
+            Vector<size_t, 4> query_indices;
+            for (size_t i = 0; i < queries.size(); ++i) {
+                if (queries[i].is_done)
+                    continue;
+                fds.append({ queries[i].socket->fd(), POLLIN, 0 });
+                query_indices.append(i);
+            }
+            if (fds.is_empty()) {
+                dbgln("LookupServer: None of the nameservers could answer for '{}'", name.as_string());
+                return {};
+            }
 
-    int rc = setsockopt(udp_socket->fd(), SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
-    if (rc < 0) {
-        perror("setsockopt(SOL_SOCKET, SO_RCVTIMEO)");
-        return {};
+            u64 now_ms = now_in_ms();
+            if (now_ms >= deadline_ms)
+                break;
+            int rc = poll(fds.data(), fds.size(), deadline_ms - now_ms);
+            if (rc < 0) {
+                if (errno == EINTR)
+                    continue;
+                perror("poll");
+                return {};
+            }
+            if (rc == 0)
+                break;
+
+            for (size_t i = 0; i < fds.size(); ++i) {
+                if (!(fds[i].revents & POLLIN))
+                    continue;
+                auto& query = queries[query_indices[i]];
+                auto response = receive_response(query);
+                if (!response.has_value())
+                    continue;
+
+#if LOOKUPSERVER_DEBUG
+                dbgln("Got the answer for '{}' from '{}'", name.as_string(), query.nameserver);
+#endif
+                Vector<DNSAnswer> answers;
+                if (response->code() == DNSPacket::Code::NOERROR) {
+                    put_in_cache(response->answers());
+                    for (auto& answer : response->answers()) {
+                        if (answer.type() == record_type)
+                            answers.append(answer);
+                    }
+                }
+                if (answers.is_empty())
+                    put_in_negative_cache(name, record_type, response->negative_answer_ttl().value_or(default_negative_ttl));
+                return answers;
+            }
+        }
     }
 
-    if (!udp_socket->connect(nameserver, 53))
-        return {};
+    dbgln("LookupServer: Never got a response for '{}' from any nameserver :(", name.as_string());
+    put_in_negative_cache(name, record_type, unreachable_ttl);
+    return {};
+}
 
-    if (!udp_socket->write(buffer))
-        return {};
+bool LookupServer::send_query(UpstreamQuery& query, const DNSName& name, unsigned short record_type)
+{
+    if (!query.socket) {
+        query.socket = Core::UDPSocket::construct();
+        query.socket->set_blocking(true);
+        if (!query.socket->connect(query.nameserver, 53))
+            return false;
+    }
+
+    // Retries reuse the request, so a late answer to an earlier one still counts.
+    if (query.request.question_count() == 0) {
+        query.request.set_is_query();
+        query.request.set_id(arc4random_uniform(UINT16_MAX));
+        DNSName name_in_question = name;
+        if (query.should_randomize_case == ShouldRandomizeCase::Yes)
+            name_in_question.randomize_case();
+        query.request.add_question({ name_in_question, record_type, C_IN });
+    }
 
+    return query.socket->write(query.request.to_byte_buffer());
+}
+
+Optional<DNSPacket> LookupServer::receive_response(UpstreamQuery& query)
+{
     u8 response_buffer[4096];
-    int nrecv = udp_socket->read(response_buffer, sizeof(response_buffer));
-    if (nrecv == 0)
+    int nrecv = query.socket->read(response_buffer, sizeof(response_buffer));
+    if (nrecv <= 0)
         return {};
 
-    did_get_response = true;
-
     auto o_response = DNSPacket::from_raw_packet(response_buffer, nrecv);
     if (!o_response.has_value())
         return {};
 
     auto& response = o_response.value();
+    auto& request = query.request;
 
     if (response.id() != request.id()) {
         dbgln("LookupServer: ID mismatch ({} vs {}) :(", response.id(), request.id());
@@ -256,10 +339,21 @@ Vector<DNSAnswer> LookupServer::lookup(const DNSName& name, const String& namese
     }
 
     if (response.code() == DNSPacket::Code::REFUSED) {
-        if (should_randomize_case == ShouldRandomizeCase::Yes) {
+        if (query.should_randomize_case == ShouldRandomizeCase::Yes) {
             // Retry with 0x20 case randomization turned off.
-            return lookup(name, nameserver, did_get_response, record_type, ShouldRandomizeCase::No);
+            query.should_randomize_case = ShouldRandomizeCase::No;
+            query.request = {};
+            if (!send_query(query, query.name, query.record_type))
+                query.is_done = true;
+            return {};
         }
+        query.is_done = true;
+        return {};
+    }
+
+    if (response.code() != DNSPacket::Code::NOERROR && response.code() != DNSPacket::Code::NXDOMAIN) {
+        dbgln("LookupServer: '{}' failed to answer with code {}", query.nameserver, (int)response.code());
+        query.is_done = true;
         return {};
     }
 
@@ -283,37 +377,104 @@ Vector<DNSAnswer> LookupServer::lookup(const DNSName& name, const String& namese
         }
     }
 
-    if (response.answer_count() < 1) {
-        dbgln("LookupServer: No answers :(");
-        return {};
-    }
+    query.is_done = true;
+    return o_response;
+}
 
-    Vector<DNSAnswer, 8> answers;
-    for (auto& answer : response.answers()) {
-        put_in_cache(answer);
-        if (answer.type() != record_type)
+void LookupServer::put_in_cache(const Vector<DNSAnswer>& answers)
+{
+    // A response replaces whatever we had cached for the same names and types.
+    for (auto& answer : answers) {
+        auto it = m_lookup_cache.find(answer.name());
+        if (it == m_lookup_cache.end())
             continue;
-        answers.append(answer);
+        it->value.remove_all_matching([&](auto& cached_answer) { return cached_answer.type() == answer.type(); });
     }
 
-    return move(answers);
+    for (auto& answer : answers) {
+        if (answer.has_expired())
+            continue;
+        auto it = m_lookup_cache.find(answer.name());
+        if (it == m_lookup_cache.end()) {
+            make_room_in_cache();
+            m_lookup_cache.set(answer.name(), { answer });
+        } else {
+            it->value.append(answer);
+        }
+        if (auto negative_it = m_negative_cache.find(answer.name()); negative_it != m_negative_cache.end())
+            negative_it->value.remove_all_matching([&](auto& negative_answer) { return negative_answer.record_type == answer.type(); });
+    }
 }
 
-void LookupServer::put_in_cache(const DNSAnswer& answer)
+void LookupServer::remove_expired_answers(const DNSName& name)
 {
-    if (answer.has_expired())
+    auto it = m_lookup_cache.find(name);
+    if (it == m_lookup_cache.end())
         return;
+    it->value.remove_all_matching([](auto& answer) { return answer.has_expired(); });
+    if (it->value.is_empty())
+        m_lookup_cache.remove(it);
+}
 
-    // Prevent the cache from growing too big.
+void LookupServer::make_room_in_cache()
+{
+    // Prevent the caches from growing too big.
+    static constexpr size_t max_cached_names = 256;
+
+    if (m_lookup_cache.size() >= max_cached_names) {
+        Vector<DNSName> expired_names;
+        for (auto& it : m_lookup_cache) {
+            if (all_of(it.value.begin(), it.value.end(), [](auto& answer) { return answer.has_expired(); }))
+                expired_names.append(it.key);
+        }
+        for (auto& name : expired_names)
+            m_lookup_cache.remove(name);
+    }
     // TODO: Evict least used entries.
-    if (m_lookup_cache.size() >= 256)
+    if (m_lookup_cache.size() >= max_cached_names)
         m_lookup_cache.remove(m_lookup_cache.begin());
 
-    auto it = m_lookup_cache.find(answer.name());
-    if (it == m_lookup_cache.end())
-        m_lookup_cache.set(answer.name(), { answer });
-    else
-        it->value.append(answer);
+    if (m_negative_cache.size() >= max_cached_names) {
+        auto now = time(nullptr);
+        Vector<DNSName> expired_names;
+        for (auto& it : m_negative_cache) {
+            if (all_of(it.value.begin(), it.value.end(), [now](auto& negative_answer) { return negative_answer.expiration_time <= now; }))
+                expired_names.append(it.key);
+        }
+        for (auto& name : expired_names)
+            m_negative_cache.remove(name);
+    }
+    if (m_negative_cache.size() >= max_cached_names)
+        m_negative_cache.remove(m_negative_cache.begin());
+}
+
+void LookupServer::put_in_negative_cache(const DNSName& name, unsigned short record_type, u32 ttl)
+{
+    if (ttl == 0)
+        return;
+    NegativeAnswer negative_answer { record_type, time(nullptr) + ttl };
+    auto it = m_negative_cache.find(name);
+    if (it == m_negative_cache.end()) {
+        make_room_in_cache();
+        m_negative_cache.set(name, { negative_answer });
+        return;
+    }
+    it->value.remove_all_matching([&](auto& other) { return other.record_type == record_type; });
+    it->value.append(negative_answer);
+}
+
+bool LookupServer::is_in_negative_cache(const DNSName& name, unsigned short record_type)
+{
+    auto it = m_negative_cache.find(name);
+    if (it == m_negative_cache.end())
+        return false;
+    auto now = time(nullptr);
+    it->value.remove_all_matching([now](auto& negative_answer) { return negative_answer.expiration_time <= now; });
+    if (it->value.is_empty()) {
+        m_negative_cache.remove(it);
+        return false;
+    }
+    return any_of(it->value.begin(), it->value.end(), [&](auto& negative_answer) { return negative_answer.record_type == record_type; });
 }
 
 }
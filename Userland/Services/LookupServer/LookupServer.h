@@ -45,16 +45,30 @@ public:
 private:
     LookupServer();
 
+    struct UpstreamQuery;
+    struct NegativeAnswer {
+        unsigned short record_type { 0 };
+        time_t expiration_time { 0 };
+    };
+
     void load_etc_hosts();
-    void put_in_cache(const DNSAnswer&);
+    void put_in_cache(const Vector<DNSAnswer>&);
+    void put_in_negative_cache(const DNSName&, unsigned short record_type, u32 ttl);
+    bool is_in_negative_cache(const DNSName&, unsigned short record_type);
+    void remove_expired_answers(const DNSName&);
+    void make_room_in_cache();
 
-    Vector<DNSAnswer> lookup(const DNSName& hostname, const String& nameserver, bool& did_get_response, unsigned short record_type, ShouldRandomizeCase = ShouldRandomizeCase::Yes);
+    Vector<DNSAnswer> lookup_upstream(const DNSName&, unsigned short record_type);
+    bool send_query(UpstreamQuery&, const DNSName&, unsigned short record_type);
+    Optional<DNSPacket> receive_response(UpstreamQuery&);
 
     RefPtr<Core::LocalServer> m_local_server;
     RefPtr<DNSServer> m_dns_server;
     Vector<String> m_nameservers;
     HashMap<DNSName, Vector<DNSAnswer>, DNSName::Traits> m_etc_hosts;
     HashMap<DNSName, Vector<DNSAnswer>, DNSName::Traits> m_lookup_cache;
+    // Names that are known not to exist, or to have no records of some type.
+    HashMap<DNSName, Vector<NegativeAnswer>, DNSName::Traits> m_negative_cache;
 };
 
 }
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <LibCore/Timer.h>
+#include <ProtocolServer/CachedDownload.h>
+
+namespace ProtocolServer {
+
+CachedDownload::CachedDownload(ClientConnection& client, HttpCache::Entry&& entry, NonnullOwnPtr<OutputFileStream>&& output_stream)
+    : Download(client, move(output_stream))
+    , m_entry(move(entry))
+{
+    // The client only learns about this download once we return from StartDownload, so hold off on telling it anything until then.
+    m_start_timer = Core::Timer::create_single_shot(0, [this] { start(); });
+    m_start_timer->start();
+}
+
+CachedDownload::~CachedDownload()
+{
+}
+
+NonnullOwnPtr<CachedDownload> CachedDownload::create(ClientConnection& client, HttpCache::Entry&& entry, NonnullOwnPtr<OutputFileStream>&& output_stream)
+{
+    return adopt_own(*new CachedDownload(client, move(entry), move(output_stream)));
+}
+
+void CachedDownload::start()
+{
+    set_status_code(200);
+    set_response_headers(m_entry.headers);
+    send_body_and_finish(move(m_entry.body));
+}
+
+}
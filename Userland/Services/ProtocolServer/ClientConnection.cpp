@@ -25,10 +25,13 @@
  */
 
 #include <AK/Badge.h>
+#include <AK/Debug.h>
+#include <LibHTTP/ConnectionPool.h>
 #include <ProtocolServer/ClientConnection.h>
 #include <ProtocolServer/Download.h>
 #include <ProtocolServer/Protocol.h>
 #include <ProtocolServer/ProtocolClientEndpoint.h>
+#include <netdb.h>
 
 namespace ProtocolServer {
 
@@ -47,8 +50,15 @@ ClientConnection::~ClientConnection()
 void ClientConnection::die()
 {
     s_connections.remove(client_id());
-    if (s_connections.is_empty())
+    if (s_connections.is_empty()) {
+        if constexpr (HTTP_CONNECTION_POOL_DEBUG) {
+            auto& http = HTTP::ConnectionPool<Core::TCPSocket>::the().statistics();
+            auto& https = HTTP::ConnectionPool<TLS::TLSv12>::the().statistics();
+            dbgln("ProtocolServer: HTTP connections opened {}, reused {}, discarded {}", http.connections_opened, http.connections_reused, http.connections_discarded);
+            dbgln("ProtocolServer: HTTPS connections opened {}, reused {}, discarded {}", https.connections_opened, https.connections_reused, https.connections_discarded);
+        }
         Core::EventLoop::current().quit(0);
+    }
 }
 
 OwnPtr<Messages::ProtocolServer::IsSupportedProtocolResponse> ClientConnection::handle(const Messages::ProtocolServer::IsSupportedProtocol& message)
@@ -136,4 +146,12 @@ OwnPtr<Messages::ProtocolServer::SetCertificateResponse> ClientConnection::handl
     return make<Messages::ProtocolServer::SetCertificateResponse>(success);
 }
 
+void ClientConnection::handle(const Messages::ProtocolServer::PrefetchHostName& message)
+{
+    // LookupServer caches what it resolves, so connecting to the host later won't have to wait for DNS.
+    // The answer itself isn't needed.
+    if (!message.host().is_empty())
+        gethostbyname(message.host().characters());
+}
+
 }
@@ -56,6 +56,7 @@ private:
     virtual OwnPtr<Messages::ProtocolServer::StartDownloadResponse> handle(const Messages::ProtocolServer::StartDownload&) override;
     virtual OwnPtr<Messages::ProtocolServer::StopDownloadResponse> handle(const Messages::ProtocolServer::StopDownload&) override;
     virtual OwnPtr<Messages::ProtocolServer::SetCertificateResponse> handle(const Messages::ProtocolServer::SetCertificate&) override;
+    virtual void handle(const Messages::ProtocolServer::PrefetchHostName&) override;
 
     HashMap<i32, OwnPtr<Download>> m_downloads;
 };
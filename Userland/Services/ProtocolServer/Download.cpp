@@ -25,6 +25,7 @@
  */
 
 #include <AK/Badge.h>
+#include <LibCore/Notifier.h>
 #include <ProtocolServer/ClientConnection.h>
 #include <ProtocolServer/Download.h>
 
@@ -71,6 +72,45 @@ void Download::did_progress(Optional<u32> total_size, u32 downloaded_size)
     m_client.did_progress_download({}, *this);
 }
 
+void Download::send_body_and_finish(ByteBuffer body)
+{
+    VERIFY(m_write_fd != -1);
+    m_body_to_send = move(body);
+    m_body_bytes_sent = 0;
+    m_body_notifier = Core::Notifier::construct(m_write_fd, Core::Notifier::Event::Write);
+    m_body_notifier->on_ready_to_write = [this] {
+        auto remaining = m_body_to_send.bytes().slice(m_body_bytes_sent);
+        m_body_bytes_sent += m_output_stream->write(remaining);
+        m_output_stream->handle_any_error();
+        if (m_body_bytes_sent < m_body_to_send.size())
+            return;
+
+        m_body_notifier->set_enabled(false);
+        did_progress(m_body_to_send.size(), m_body_to_send.size());
+        set_downloaded_size(m_body_to_send.size());
+        // NOTE: This may destroy us.
+        did_finish(true);
+    };
+}
+
+void Download::when_output_drains(Function<void()> callback)
+{
+    VERIFY(m_write_fd != -1);
+    m_on_output_drained = move(callback);
+    if (!m_output_drain_notifier) {
+        m_output_drain_notifier = Core::Notifier::construct(m_write_fd, Core::Notifier::Event::Write);
+        m_output_drain_notifier->on_ready_to_write = [this] {
+            m_output_drain_notifier->set_enabled(false);
+            m_output_stream->handle_any_error();
+            // The callback may well ask to be called again.
+            auto on_output_drained = move(m_on_output_drained);
+            if (on_output_drained)
+                on_output_drained();
+        };
+    }
+    m_output_drain_notifier->set_enabled(true);
+}
+
 void Download::did_request_certificates()
 {
     m_client.did_request_certificates({}, *this);
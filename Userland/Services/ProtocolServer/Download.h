@@ -26,13 +26,17 @@
 
 #pragma once
 
+#include <AK/ByteBuffer.h>
 #include <AK/FileStream.h>
+#include <AK/Function.h>
 #include <AK/HashMap.h>
 #include <AK/NonnullOwnPtr.h>
 #include <AK/Optional.h>
 #include <AK/RefCounted.h>
 #include <AK/URL.h>
+#include <LibCore/Forward.h>
 #include <ProtocolServer/Forward.h>
+#include <ProtocolServer/HttpCache.h>
 
 namespace ProtocolServer {
 
@@ -54,6 +58,20 @@ public:
     // FIXME: Want Badge<Protocol>, but can't make one from HttpProtocol, etc.
     void set_download_fd(int fd) { m_download_fd = fd; }
     int download_fd() const { return m_download_fd; }
+    void set_write_fd(int fd) { m_write_fd = fd; }
+    void set_url(const URL& url) { m_url = url; }
+
+    // Sends a body we already have (e.g. from the HTTP cache) to the client as the pipe drains, then finishes the download.
+    void send_body_and_finish(ByteBuffer);
+
+    // Calls the callback once the client has read enough that we can write to the pipe again.
+    void when_output_drains(Function<void()>);
+
+    void set_caching_stream(NonnullOwnPtr<CachingOutputStream>&& stream) { m_caching_stream = move(stream); }
+    CachingOutputStream* caching_stream() { return m_caching_stream.ptr(); }
+
+    void set_cache_entry_being_revalidated(HttpCache::Entry&& entry) { m_cache_entry_being_revalidated = move(entry); }
+    Optional<HttpCache::Entry>& cache_entry_being_revalidated() { return m_cache_entry_being_revalidated; }
 
     void did_finish(bool success);
     void did_progress(Optional<u32> total_size, u32 downloaded_size);
@@ -70,12 +88,20 @@ private:
     ClientConnection& m_client;
     i32 m_id { 0 };
     int m_download_fd { -1 }; // Passed to client.
+    int m_write_fd { -1 };
     URL m_url;
     Optional<u32> m_status_code;
     Optional<u32> m_total_size {};
     size_t m_downloaded_size { 0 };
     NonnullOwnPtr<OutputFileStream> m_output_stream;
     HashMap<String, String, CaseInsensitiveStringTraits> m_response_headers;
+    ByteBuffer m_body_to_send;
+    size_t m_body_bytes_sent { 0 };
+    RefPtr<Core::Notifier> m_body_notifier;
+    RefPtr<Core::Notifier> m_output_drain_notifier;
+    Function<void()> m_on_output_drained;
+    OwnPtr<CachingOutputStream> m_caching_stream;
+    Optional<HttpCache::Entry> m_cache_entry_being_revalidated;
 };
 
 }
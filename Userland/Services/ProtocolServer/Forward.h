@@ -28,9 +28,11 @@
 
 namespace ProtocolServer {
 
+class CachedDownload;
 class ClientConnection;
 class Download;
 class GeminiProtocol;
+class HttpCache;
 class HttpDownload;
 class HttpProtocol;
 class HttpsDownload;
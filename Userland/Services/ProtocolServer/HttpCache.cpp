@@ -0,0 +1,296 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Debug.h>
+#include <AK/QuickSort.h>
+#include <AK/StringBuilder.h>
+#include <LibCore/DateTime.h>
+#include <LibCore/DirIterator.h>
+#include <LibCore/File.h>
+#include <ProtocolServer/HttpCache.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+namespace ProtocolServer {
+
+// The on-disk format is a small text preamble followed by the raw response body:
+//
+//     SerenityOS HTTP cache entry v1
+//     <url>
+//     <time the response was stored, in seconds since the epoch>
+//     <number of headers>
+//     <name>: <value> (once per header)
+//     <body bytes until the end of the file>
+static constexpr const char* entry_magic = "SerenityOS HTTP cache entry v1";
+
+HttpCache& HttpCache::the()
+{
+    static HttpCache cache;
+    return cache;
+}
+
+static Optional<String> cache_control_directive(const HttpCache::Headers& headers, const StringView& name)
+{
+    auto cache_control = headers.get("Cache-Control");
+    if (!cache_control.has_value())
+        return {};
+    for (auto& directive : cache_control.value().split(',')) {
+        auto trimmed = directive.trim_whitespace();
+        if (trimmed.equals_ignoring_case(name))
+            return String::empty();
+        if (trimmed.length() > name.length() && trimmed[name.length()] == '=' && trimmed.substring_view(0, name.length()).equals_ignoring_case(name))
+            return trimmed.substring(name.length() + 1);
+    }
+    return {};
+}
+
+// Parses the IMF-fixdate format HTTP uses for Expires (e.g. "Sun, 06 Nov 1994 08:49:37 GMT".)
+static Optional<time_t> parse_http_date(const String& date)
+{
+    static const char* months[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+    unsigned day = 0, year = 0, hour = 0, minute = 0, second = 0;
+    char month_name[4] {};
+    if (sscanf(date.characters(), "%*3s, %u %3s %u %u:%u:%u GMT", &day, month_name, &year, &hour, &minute, &second) != 6)
+        return {};
+    for (unsigned month = 0; month < 12; ++month) {
+        if (StringView(month_name) == months[month])
+            return Core::DateTime::create(year, month + 1, day, hour, minute, second).timestamp();
+    }
+    return {};
+}
+
+bool HttpCache::Entry::is_fresh() const
+{
+    if (cache_control_directive(headers, "no-cache").has_value())
+        return false;
+
+    time_t freshness_lifetime = 0;
+    if (auto max_age = cache_control_directive(headers, "max-age"); max_age.has_value()) {
+        freshness_lifetime = max_age.value().to_uint().value_or(0);
+    } else if (auto expires = headers.get("Expires"); expires.has_value()) {
+        auto expires_at = parse_http_date(expires.value());
+        if (!expires_at.has_value())
+            return false;
+        freshness_lifetime = expires_at.value() - stored_at;
+    }
+
+    time_t age = time(nullptr) - stored_at;
+    if (auto age_header = headers.get("Age"); age_header.has_value())
+        age += age_header.value().to_uint().value_or(0);
+    return age < freshness_lifetime;
+}
+
+bool HttpCache::Entry::has_validators() const
+{
+    return headers.contains("ETag") || headers.contains("Last-Modified");
+}
+
+void HttpCache::Entry::add_validators_to(HashMap<String, String>& request_headers) const
+{
+    if (auto etag = headers.get("ETag"); etag.has_value())
+        request_headers.set("If-None-Match", etag.value());
+    if (auto last_modified = headers.get("Last-Modified"); last_modified.has_value())
+        request_headers.set("If-Modified-Since", last_modified.value());
+}
+
+bool HttpCache::is_cacheable_request(const String& method, const HashMap<String, String>& request_headers)
+{
+    if (!method.equals_ignoring_case("GET"))
+        return false;
+    for (auto& it : request_headers) {
+        // Requests the client wants to control themselves (or that carry credentials) go straight to the network.
+        if (it.key.equals_ignoring_case("Authorization") || it.key.equals_ignoring_case("Cookie") || it.key.equals_ignoring_case("Range")
+            || it.key.equals_ignoring_case("If-None-Match") || it.key.equals_ignoring_case("If-Modified-Since"))
+            return false;
+        if ((it.key.equals_ignoring_case("Cache-Control") || it.key.equals_ignoring_case("Pragma")) && it.value.contains("no-cache"))
+            return false;
+    }
+    return true;
+}
+
+bool HttpCache::is_cacheable_response(u32 status_code, const Headers& headers)
+{
+    if (status_code != 200)
+        return false;
+    // This cache is shared between all users of the system, so "private" responses can't go in it.
+    if (cache_control_directive(headers, "no-store").has_value() || cache_control_directive(headers, "private").has_value())
+        return false;
+    // Neither can responses that set cookies, which are likely to be someone's session.
+    if (headers.contains("Set-Cookie"))
+        return false;
+    // We don't remember the request headers, so we can't tell variants apart.
+    if (headers.contains("Vary"))
+        return false;
+    return true;
+}
+
+String HttpCache::path_for(const URL& url) const
+{
+    return String::formatted("{}/{:08x}", directory, url.to_string().hash());
+}
+
+Optional<HttpCache::Entry> HttpCache::lookup(const String& method, const URL& url, const HashMap<String, String>& request_headers)
+{
+    if (!is_cacheable_request(method, request_headers))
+        return {};
+
+    auto path = path_for(url);
+    auto file_or_error = Core::File::open(path, Core::IODevice::ReadOnly);
+    if (file_or_error.is_error())
+        return {};
+    auto& file = *file_or_error.value();
+
+    if (file.read_line() != entry_magic)
+        return {};
+
+    Entry entry;
+    entry.url = URL(file.read_line());
+    if (entry.url != url) {
+        dbgln_if(CACHE_DEBUG, "HttpCache: Entry {} belongs to {}, not {}", path, entry.url, url);
+        return {};
+    }
+
+    auto stored_at = file.read_line().to_uint();
+    auto header_count = file.read_line().to_uint();
+    if (!stored_at.has_value() || !header_count.has_value())
+        return {};
+    entry.stored_at = stored_at.value();
+
+    for (unsigned i = 0; i < header_count.value(); ++i) {
+        auto line = file.read_line();
+        auto colon = line.index_of(":");
+        if (!colon.has_value())
+            return {};
+        auto name = line.substring(0, colon.value());
+        if (name.equals_ignoring_case("Set-Cookie"))
+            continue;
+        entry.headers.set(move(name), line.substring(colon.value() + 1).trim_whitespace());
+    }
+    entry.body = file.read_all();
+
+    // Touch the entry, so eviction can tell which entries were used recently.
+    utime(path.characters(), nullptr);
+
+    dbgln_if(CACHE_DEBUG, "HttpCache: Found {} byte entry for {}", entry.body.size(), url);
+    return entry;
+}
+
+bool HttpCache::write_entry(const Entry& entry)
+{
+    StringBuilder builder;
+    builder.appendff("{}\n", entry_magic);
+    builder.appendff("{}\n{}\n{}\n", entry.url, entry.stored_at, entry.headers.size());
+    for (auto& it : entry.headers)
+        builder.appendff("{}: {}\n", it.key, it.value);
+
+    // Write to a temporary file first, so other ProtocolServer instances never see a half-written entry.
+    auto path = path_for(entry.url);
+    auto temporary_path = String::formatted("{}.{}", path, getpid());
+    auto file_or_error = Core::File::open(temporary_path, Core::IODevice::WriteOnly);
+    if (file_or_error.is_error()) {
+        dbgln_if(CACHE_DEBUG, "HttpCache: Couldn't open {}: {}", temporary_path, file_or_error.error());
+        return false;
+    }
+    auto& file = *file_or_error.value();
+    bool success = file.write(builder.string_view()) && file.write(entry.body.data(), entry.body.size());
+    file.close();
+
+    if (!success || rename(temporary_path.characters(), path.characters()) < 0) {
+        unlink(temporary_path.characters());
+        return false;
+    }
+    return true;
+}
+
+void HttpCache::store(const URL& url, const Headers& headers, ReadonlyBytes body)
+{
+    if (body.size() > max_entry_size)
+        return;
+
+    Entry entry;
+    entry.url = url;
+    entry.headers = headers;
+    // Cookies belong to whoever got the response, never to the cache.
+    entry.headers.remove("Set-Cookie");
+    entry.body = ByteBuffer::copy(body.data(), body.size());
+    entry.stored_at = time(nullptr);
+    if (!write_entry(entry))
+        return;
+
+    dbgln_if(CACHE_DEBUG, "HttpCache: Stored {} byte entry for {}", body.size(), url);
+    evict_if_needed();
+}
+
+void HttpCache::did_revalidate(Entry& entry, const Headers& new_headers)
+{
+    // A 304 response carries updated metadata (like a new max-age) that replaces what we had stored.
+    for (auto& it : new_headers) {
+        if (it.key.equals_ignoring_case("Content-Length") || it.key.equals_ignoring_case("Transfer-Encoding") || it.key.equals_ignoring_case("Content-Encoding")
+            || it.key.equals_ignoring_case("Set-Cookie"))
+            continue;
+        entry.headers.set(it.key, it.value);
+    }
+    entry.stored_at = time(nullptr);
+    write_entry(entry);
+}
+
+void HttpCache::evict_if_needed()
+{
+    struct FileInfo {
+        String path;
+        size_t size { 0 };
+        time_t last_used { 0 };
+    };
+
+    Vector<FileInfo> files;
+    size_t total_size = 0;
+    Core::DirIterator it(directory, Core::DirIterator::SkipDots);
+    while (it.has_next()) {
+        auto path = it.next_full_path();
+        struct stat st;
+        if (stat(path.characters(), &st) < 0)
+            continue;
+        files.append({ path, (size_t)st.st_size, st.st_mtime });
+        total_size += st.st_size;
+    }
+
+    if (total_size <= size_budget)
+        return;
+
+    quick_sort(files, [](auto& a, auto& b) { return a.last_used < b.last_used; });
+    for (auto& file : files) {
+        if (total_size <= size_budget)
+            break;
+        if (unlink(file.path.characters()) < 0)
+            continue;
+        total_size -= file.size;
+        dbgln_if(CACHE_DEBUG, "HttpCache: Evicted {}", file.path);
+    }
+}
+
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/ByteBuffer.h>
+#include <AK/HashMap.h>
+#include <AK/Optional.h>
+#include <AK/Stream.h>
+#include <AK/String.h>
+#include <AK/URL.h>
+#include <time.h>
+
+namespace ProtocolServer {
+
+// An on-disk cache of HTTP responses, shared by all ProtocolServer instances.
+// Entries live in one file each below HttpCache::directory, and the least recently
+// used ones are removed once the whole cache grows beyond its size budget.
+class HttpCache {
+public:
+    using Headers = HashMap<String, String, CaseInsensitiveStringTraits>;
+
+    static constexpr const char* directory = "/var/cache/protocol";
+    static constexpr size_t size_budget = 64 * MiB;
+    static constexpr size_t max_entry_size = 8 * MiB;
+
+    struct Entry {
+        URL url;
+        Headers headers;
+        ByteBuffer body;
+        time_t stored_at { 0 };
+
+        bool is_fresh() const;
+        bool has_validators() const;
+        void add_validators_to(HashMap<String, String>& request_headers) const;
+    };
+
+    static HttpCache& the();
+
+    // Returns the stored response for the request, if the request may be answered from the cache at all.
+    Optional<Entry> lookup(const String& method, const URL&, const HashMap<String, String>& request_headers);
+
+    void store(const URL&, const Headers&, ReadonlyBytes body);
+    void did_revalidate(Entry&, const Headers& new_headers);
+
+    static bool is_cacheable_request(const String& method, const HashMap<String, String>& request_headers);
+    static bool is_cacheable_response(u32 status_code, const Headers&);
+
+private:
+    HttpCache() { }
+
+    String path_for(const URL&) const;
+    bool write_entry(const Entry&);
+    void evict_if_needed();
+};
+
+// Passes everything through to another stream, and keeps a copy of it for the cache
+// as long as it's small enough to be worth caching.
+class CachingOutputStream final : public OutputStream {
+public:
+    explicit CachingOutputStream(OutputStream& stream)
+        : m_stream(stream)
+    {
+    }
+
+    virtual size_t write(ReadonlyBytes bytes) override
+    {
+        auto nwritten = m_stream.write(bytes);
+        if (!m_overflowed) {
+            if (m_buffer.size() + nwritten > HttpCache::max_entry_size) {
+                m_overflowed = true;
+                m_buffer.clear();
+            } else {
+                m_buffer.append(bytes.data(), nwritten);
+            }
+        }
+        return nwritten;
+    }
+
+    virtual bool write_or_error(ReadonlyBytes bytes) override
+    {
+        auto nwritten = write(bytes);
+        if (nwritten < bytes.size()) {
+            set_recoverable_error();
+            return false;
+        }
+        return true;
+    }
+
+    virtual bool handle_any_error() override
+    {
+        m_stream.handle_any_error();
+        return Stream::handle_any_error();
+    }
+
+    bool has_complete_copy() const { return !m_overflowed; }
+    const ByteBuffer& buffer() const { return m_buffer; }
+
+private:
+    OutputStream& m_stream;
+    ByteBuffer m_buffer;
+    bool m_overflowed { false };
+};
+
+}
@@ -34,8 +34,10 @@
 #include <AK/String.h>
 #include <AK/Types.h>
 #include <LibHTTP/HttpRequest.h>
+#include <ProtocolServer/CachedDownload.h>
 #include <ProtocolServer/ClientConnection.h>
 #include <ProtocolServer/Download.h>
+#include <ProtocolServer/HttpCache.h>
 
 namespace ProtocolServer::Detail {
 
@@ -43,16 +45,45 @@ template<typename TSelf, typename TJob>
 void init(TSelf* self, TJob job)
 {
     job->on_headers_received = [self](auto& headers, auto response_code) {
+        auto& cache_entry = self->cache_entry_being_revalidated();
+        if (cache_entry.has_value() && response_code.value_or(0) == 304) {
+            // Our copy is still good, so hand that to the client as if the server had sent it.
+            HttpCache::the().did_revalidate(cache_entry.value(), headers);
+            self->set_status_code(200);
+            // The cache never keeps cookies, but the client still gets the ones meant for it.
+            auto response_headers = cache_entry.value().headers;
+            if (auto set_cookie = headers.get("Set-Cookie"); set_cookie.has_value())
+                response_headers.set("Set-Cookie", set_cookie.value());
+            self->set_response_headers(response_headers);
+            return;
+        }
+        cache_entry.clear();
         if (response_code.has_value())
             self->set_status_code(response_code.value());
         self->set_response_headers(headers);
     };
 
     job->on_finish = [self](bool success) {
+        auto& cache_entry = self->cache_entry_being_revalidated();
+        if (success && cache_entry.has_value()) {
+            self->send_body_and_finish(move(cache_entry.value().body));
+            return;
+        }
+
         if (auto* response = self->job().response()) {
             self->set_status_code(response->code());
             self->set_response_headers(response->headers());
             self->set_downloaded_size(self->output_stream().size());
+
+            auto* caching_stream = self->caching_stream();
+            if (success && caching_stream && caching_stream->has_complete_copy() && HttpCache::is_cacheable_response(response->code(), response->headers())) {
+                // The job has already undone any Content-Encoding, so the headers describing it no longer apply to what we store.
+                auto headers = response->headers();
+                headers.remove("Content-Encoding");
+                headers.remove("Content-Length");
+                headers.remove("Transfer-Encoding");
+                HttpCache::the().store(self->url(), headers, caching_stream->buffer());
+            }
         }
 
         // if we didn't know the total size, pretend that the download finished successfully
@@ -65,6 +96,10 @@ void init(TSelf* self, TJob job)
     job->on_progress = [self](Optional<u32> total, u32 current) {
         self->did_progress(total, current);
     };
+    job->on_output_blocked = [self] {
+        // The client isn't keeping up, so let the job stop reading from the server until it does.
+        self->when_output_drains([self] { self->job().resume_output(); });
+    };
     if constexpr (requires { job->on_certificate_requested; }) {
         job->on_certificate_requested = [self](auto&) {
             self->did_request_certificates();
@@ -82,20 +117,44 @@ OwnPtr<Download> start_download(TBadgedProtocol&& protocol, ClientConnection& cl
         return {};
     }
 
+    auto output_stream = make<OutputFileStream>(pipe_result.value().write_fd);
+    output_stream->make_unbuffered();
+
+    auto cache_entry = HttpCache::the().lookup(method, url, headers);
+    if (cache_entry.has_value() && cache_entry.value().is_fresh()) {
+        auto download = CachedDownload::create(client, cache_entry.release_value(), move(output_stream));
+        download->set_url(url);
+        download->set_download_fd(pipe_result.value().read_fd);
+        download->set_write_fd(pipe_result.value().write_fd);
+        return download;
+    }
+
+    auto request_headers = headers;
+    if (cache_entry.has_value()) {
+        if (cache_entry.value().has_validators())
+            cache_entry.value().add_validators_to(request_headers);
+        else
+            cache_entry.clear();
+    }
+
     HTTP::HttpRequest request;
     if (method.equals_ignoring_case("post"))
         request.set_method(HTTP::HttpRequest::Method::POST);
     else
         request.set_method(HTTP::HttpRequest::Method::GET);
     request.set_url(url);
-    request.set_headers(headers);
+    request.set_headers(request_headers);
     request.set_body(body);
 
-    auto output_stream = make<OutputFileStream>(pipe_result.value().write_fd);
-    output_stream->make_unbuffered();
-    auto job = TJob::construct(request, *output_stream);
+    auto caching_stream = make<CachingOutputStream>(*output_stream);
+    auto job = TJob::construct(request, *caching_stream);
     auto download = TDownload::create_with_job(forward<TBadgedProtocol>(protocol), client, (TJob&)*job, move(output_stream));
+    download->set_url(url);
     download->set_download_fd(pipe_result.value().read_fd);
+    download->set_write_fd(pipe_result.value().write_fd);
+    download->set_caching_stream(move(caching_stream));
+    if (cache_entry.has_value())
+        download->set_cache_entry_being_revalidated(cache_entry.release_value());
     job->start();
     return download;
 }
@@ -42,6 +42,7 @@ HttpDownload::~HttpDownload()
 {
     m_job->on_finish = nullptr;
     m_job->on_progress = nullptr;
+    m_job->on_output_blocked = nullptr;
     m_job->shutdown();
 }
 
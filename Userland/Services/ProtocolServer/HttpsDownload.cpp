@@ -47,6 +47,7 @@ HttpsDownload::~HttpsDownload()
 {
     m_job->on_finish = nullptr;
     m_job->on_progress = nullptr;
+    m_job->on_output_blocked = nullptr;
     m_job->shutdown();
 }
 
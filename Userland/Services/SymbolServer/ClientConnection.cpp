@@ -32,14 +32,87 @@
 
 namespace SymbolServer {
 
-struct CachedELF {
+struct CachedELF : public RefCounted<CachedELF> {
+    CachedELF(NonnullRefPtr<MappedFile> mapped_file, Debug::DebugInfo&& debug_info)
+        : mapped_file(move(mapped_file))
+        , debug_info(move(debug_info))
+    {
+    }
+
     NonnullRefPtr<MappedFile> mapped_file;
     Debug::DebugInfo debug_info;
+    u64 last_used { 0 };
 };
 
-static HashMap<String, OwnPtr<CachedELF>> s_cache;
+// Symbol tables and debug info of the most recently used ELF files. Files that couldn't be
+// loaded are in here too (as null), so we don't keep trying.
+static HashMap<String, RefPtr<CachedELF>> s_cache;
+static constexpr size_t max_cached_elf_count = 32;
+static u64 s_use_counter;
 static HashMap<int, RefPtr<ClientConnection>> s_connections;
 
+static void make_room_in_cache()
+{
+    while (s_cache.size() >= max_cached_elf_count) {
+        auto least_recently_used = s_cache.begin();
+        for (auto it = s_cache.begin(); it != s_cache.end(); ++it) {
+            u64 last_used = it->value ? it->value->last_used : 0;
+            u64 least_recently_used_last_used = least_recently_used->value ? least_recently_used->value->last_used : 0;
+            if (last_used < least_recently_used_last_used)
+                least_recently_used = it;
+        }
+        s_cache.remove(least_recently_used);
+    }
+}
+
+static RefPtr<CachedELF> cached_elf_for_path(const String& path)
+{
+    if (auto it = s_cache.find(path); it != s_cache.end()) {
+        if (it->value)
+            it->value->last_used = ++s_use_counter;
+        return it->value;
+    }
+
+    make_room_in_cache();
+
+    auto mapped_file = MappedFile::map(path);
+    if (mapped_file.is_error()) {
+        dbgln("Failed to map {}: {}", path, mapped_file.error().string());
+        s_cache.set(path, {});
+        return nullptr;
+    }
+    auto elf = make<ELF::Image>(mapped_file.value()->bytes());
+    if (!elf->is_valid()) {
+        dbgln("ELF not valid: {}", path);
+        s_cache.set(path, {});
+        return nullptr;
+    }
+    Debug::DebugInfo debug_info(move(elf));
+    auto cached_elf = adopt(*new CachedELF(mapped_file.release_value(), move(debug_info)));
+    cached_elf->last_used = ++s_use_counter;
+    s_cache.set(path, cached_elf);
+    return cached_elf;
+}
+
+struct SymbolicationResult {
+    String name;
+    u32 offset { 0 };
+    String filename;
+    u32 line_number { 0 };
+};
+
+static SymbolicationResult symbolicate(CachedELF& cached_elf, u32 address)
+{
+    SymbolicationResult result;
+    result.name = cached_elf.debug_info.elf().symbolicate(address, &result.offset);
+    auto source_position = cached_elf.debug_info.get_source_position(address);
+    if (source_position.has_value()) {
+        result.filename = source_position.value().file_path;
+        result.line_number = source_position.value().line_number;
+    }
+    return result;
+}
+
 ClientConnection::ClientConnection(NonnullRefPtr<Core::LocalSocket> socket, int client_id)
     : IPC::ClientConnection<SymbolClientEndpoint, SymbolServerEndpoint>(*this, move(socket), client_id)
 {
@@ -62,43 +135,63 @@ OwnPtr<Messages::SymbolServer::GreetResponse> ClientConnection::handle(const Mes
 
 OwnPtr<Messages::SymbolServer::SymbolicateResponse> ClientConnection::handle(const Messages::SymbolServer::Symbolicate& message)
 {
-    auto path = message.path();
-    if (!s_cache.contains(path)) {
-        auto mapped_file = MappedFile::map(path);
-        if (mapped_file.is_error()) {
-            dbgln("Failed to map {}: {}", path, mapped_file.error().string());
-            s_cache.set(path, {});
-            return make<Messages::SymbolServer::SymbolicateResponse>(false, String {}, 0, String {}, 0);
-        }
-        auto elf = make<ELF::Image>(mapped_file.value()->bytes());
-        if (!elf->is_valid()) {
-            dbgln("ELF not valid: {}", path);
-            s_cache.set(path, {});
-            return make<Messages::SymbolServer::SymbolicateResponse>(false, String {}, 0, String {}, 0);
-        }
-        Debug::DebugInfo debug_info(move(elf));
-        auto cached_elf = make<CachedELF>(mapped_file.release_value(), move(debug_info));
-        s_cache.set(path, move(cached_elf));
+    auto cached_elf = cached_elf_for_path(message.path());
+    if (!cached_elf)
+        return make<Messages::SymbolServer::SymbolicateResponse>(false, String {}, 0, String {}, 0);
+
+    auto result = symbolicate(*cached_elf, message.address());
+    return make<Messages::SymbolServer::SymbolicateResponse>(true, result.name, result.offset, result.filename, result.line_number);
+}
+
+OwnPtr<Messages::SymbolServer::SymbolicateBatchResponse> ClientConnection::handle(const Messages::SymbolServer::SymbolicateBatch& message)
+{
+    auto& paths = message.paths();
+    auto& path_indices = message.path_indices();
+    auto& addresses = message.addresses();
+    if (path_indices.size() != addresses.size()) {
+        did_misbehave("SymbolicateBatch: Mismatched path index and address counts");
+        return {};
     }
 
-    auto it = s_cache.find(path);
-    VERIFY(it != s_cache.end());
-    auto& cached_elf = it->value;
+    Vector<bool> successes;
+    Vector<String> names;
+    Vector<u32> offsets;
+    Vector<String> filenames;
+    Vector<u32> lines;
+    successes.ensure_capacity(addresses.size());
+    names.ensure_capacity(addresses.size());
+    offsets.ensure_capacity(addresses.size());
+    filenames.ensure_capacity(addresses.size());
+    lines.ensure_capacity(addresses.size());
 
-    if (!cached_elf)
-        return make<Messages::SymbolServer::SymbolicateResponse>(false, String {}, 0, String {}, 0);
+    // Look each file up only once, and hold on to it even if it gets evicted halfway through the batch.
+    Vector<RefPtr<CachedELF>> cached_elfs;
+    for (auto& path : paths)
+        cached_elfs.append(cached_elf_for_path(path));
 
-    u32 offset = 0;
-    auto symbol = cached_elf->debug_info.elf().symbolicate(message.address(), &offset);
-    auto source_position = cached_elf->debug_info.get_source_position(message.address());
-    String filename;
-    u32 line_number = 0;
-    if (source_position.has_value()) {
-        filename = source_position.value().file_path;
-        line_number = source_position.value().line_number;
+    for (size_t i = 0; i < addresses.size(); ++i) {
+        if (path_indices[i] >= paths.size()) {
+            did_misbehave("SymbolicateBatch: Path index out of range");
+            return {};
+        }
+        auto& cached_elf = cached_elfs[path_indices[i]];
+        if (!cached_elf) {
+            successes.unchecked_append(false);
+            names.unchecked_append({});
+            offsets.unchecked_append(0);
+            filenames.unchecked_append({});
+            lines.unchecked_append(0);
+            continue;
+        }
+        auto result = symbolicate(*cached_elf, addresses[i]);
+        successes.unchecked_append(true);
+        names.unchecked_append(move(result.name));
+        offsets.unchecked_append(result.offset);
+        filenames.unchecked_append(move(result.filename));
+        lines.unchecked_append(result.line_number);
     }
 
-    return make<Messages::SymbolServer::SymbolicateResponse>(true, symbol, offset, filename, line_number);
+    return make<Messages::SymbolServer::SymbolicateBatchResponse>(move(successes), move(names), move(offsets), move(filenames), move(lines));
 }
 
 }
@@ -39,10 +39,18 @@
 #include <stdio.h>
 #include <sys/ioctl.h>
 #include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 
 static HashMap<pid_t, Service*> s_service_map;
 
+u64 milliseconds_since_boot()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000 + ts.tv_nsec / 1'000'000;
+}
+
 Service* Service::find_by_pid(pid_t pid)
 {
     auto it = s_service_map.find(pid);
@@ -146,6 +154,11 @@ void Service::spawn(int socket_fd)
 {
     dbgln_if(SERVICE_DEBUG, "Spawning {}", name());
 
+    if (!m_has_been_spawned) {
+        m_has_been_spawned = true;
+        dbgln("Boot timeline: {} {} at {} ms", m_lazy ? "Socket-activated" : "Spawned", name(), milliseconds_since_boot());
+    }
+
     m_run_timer.start();
     pid_t pid = fork();
 
@@ -305,6 +318,12 @@ Service::Service(const Core::ConfigFile& config, const StringView& name)
     m_boot_modes = config.read_entry(name, "BootModes", "graphical").split(',');
     m_multi_instance = config.read_bool_entry(name, "MultiInstance");
     m_accept_socket_connections = config.read_bool_entry(name, "AcceptSocketConnections");
+    for (auto& dependency : config.read_entry(name, "Dependencies").split(',')) {
+        if (!config.has_group(dependency))
+            warnln("Service {} depends on unknown service {}", this->name(), dependency);
+        else
+            m_dependencies.append(dependency);
+    }
 
     m_socket_path = config.read_entry(name, "Socket");
 
@@ -43,6 +43,9 @@ public:
 
     static Service* find_by_pid(pid_t);
 
+    int priority() const { return m_priority; }
+    const Vector<String>& dependencies() const { return m_dependencies; }
+
     // FIXME: Port to Core::Property
     void save_to(JsonObject&);
 
@@ -80,6 +83,8 @@ private:
     bool m_multi_instance { false };
     // Environment variables to pass to the service.
     Vector<String> m_environment;
+    // Services that should be activated before this one.
+    Vector<String> m_dependencies;
 
     // The resolved user account to run this service as.
     Optional<Core::Account> m_account;
@@ -92,6 +97,8 @@ private:
 
     // Timer since we last spawned the service.
     Core::ElapsedTimer m_run_timer;
+    // Whether we have spawned the service since booting, for the boot timeline.
+    bool m_has_been_spawned { false };
     // How many times we have tried to restart this service, only counting those
     // times where it has exited unsuccessfully and too quickly.
     int m_restart_attempts { 0 };
@@ -100,3 +107,6 @@ private:
     void setup_notifier();
     void handle_socket_connection();
 };
+
+// Milliseconds since the system booted, for the boot timeline.
+u64 milliseconds_since_boot();
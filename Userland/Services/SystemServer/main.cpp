@@ -25,9 +25,11 @@
  */
 
 #include "Service.h"
+#include <AK/AllOf.h>
 #include <AK/Assertions.h>
 #include <AK/ByteBuffer.h>
 #include <AK/Debug.h>
+#include <AK/HashTable.h>
 #include <LibCore/ConfigFile.h>
 #include <LibCore/Event.h>
 #include <LibCore/EventLoop.h>
@@ -193,8 +195,44 @@ static void create_tmp_coredump_directory()
     umask(old_umask);
 }
 
+// Orders the services so that each one comes after the services it depends on. Among the
+// services whose dependencies have been taken care of, higher priority ones go first.
+static NonnullRefPtrVector<Service> order_by_dependencies(NonnullRefPtrVector<Service> services)
+{
+    HashTable<String> enabled;
+    for (auto& service : services)
+        enabled.set(service.name());
+
+    HashTable<String> activated;
+    auto is_ready = [&](const Service& service) {
+        return all_of(service.dependencies().begin(), service.dependencies().end(), [&](auto& dependency) {
+            // Dependencies that aren't enabled in this boot mode are never going to be activated.
+            return !enabled.contains(dependency) || activated.contains(dependency);
+        });
+    };
+
+    NonnullRefPtrVector<Service> ordered;
+    while (!services.is_empty()) {
+        Optional<size_t> index;
+        for (size_t i = 0; i < services.size(); ++i) {
+            if (is_ready(services[i]) && (!index.has_value() || services[i].priority() > services[index.value()].priority()))
+                index = i;
+        }
+        if (!index.has_value()) {
+            dbgln("Services have circular dependencies, activating {} anyway", services.first().name());
+            index = 0;
+        }
+        auto service = services.take(index.value());
+        activated.set(service->name());
+        ordered.append(move(service));
+    }
+    return ordered;
+}
+
 int main(int, char**)
 {
+    dbgln("Boot timeline: SystemServer started at {} ms", milliseconds_since_boot());
+
     prepare_devfs();
 
     if (pledge("stdio proc exec tty accept unix rpath wpath cpath chown fattr id sigaction", nullptr) < 0) {
@@ -206,6 +244,7 @@ int main(int, char**)
     create_tmp_rpc_directory();
     create_tmp_coredump_directory();
     parse_boot_mode();
+    dbgln("Boot timeline: Mounted filesystems at {} ms", milliseconds_since_boot());
 
     Core::EventLoop event_loop;
 
@@ -221,10 +260,14 @@ int main(int, char**)
             services.append(service);
     }
 
-    // After we've set them all up, activate them!
+    // After we've set them all up, activate them! All the sockets exist by now, so a service that
+    // connects to another one before it's up will just wait for it to accept. Spawning doesn't wait
+    // for anything either, so the services start up in parallel; the order only decides who gets
+    // to run first.
     dbgln("Activating {} services...", services.size());
-    for (auto& service : services)
+    for (auto& service : order_by_dependencies(move(services)))
         service.activate();
+    dbgln("Boot timeline: Activated all services at {} ms", milliseconds_since_boot());
 
     return event_loop.exec();
 }
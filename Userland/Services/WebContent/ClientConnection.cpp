@@ -50,6 +50,7 @@ ClientConnection::ClientConnection(NonnullRefPtr<Core::LocalSocket> socket, int
 {
     s_connections.set(client_id, *this);
     m_paint_flush_timer = Core::Timer::create_single_shot(0, [this] { flush_pending_paint_requests(); });
+    set_batching_enabled(true);
 }
 
 ClientConnection::~ClientConnection()
@@ -202,6 +203,10 @@ void ClientConnection::handle(const Messages::WebContentServer::DebugRequest& me
         Web::Bindings::main_thread_vm().heap().collect_garbage(JS::Heap::CollectionType::CollectGarbage, true);
     }
 
+    if (message.request() == "dump-gc-statistics") {
+        Web::Bindings::main_thread_vm().heap().dump_statistics();
+    }
+
     if (message.request() == "set-line-box-borders") {
         bool state = message.argument() == "on";
         m_page_host->set_should_show_line_box_borders(state);
@@ -26,6 +26,7 @@
 
 #include "PageHost.h"
 #include "ClientConnection.h"
+#include <LibCore/Trace.h>
 #include <LibGfx/Painter.h>
 #include <LibGfx/SystemTheme.h>
 #include <LibWeb/Layout/InitialContainingBlockBox.h>
@@ -63,6 +64,7 @@ Gfx::Palette PageHost::palette() const
 void PageHost::set_palette_impl(const Gfx::PaletteImpl& impl)
 {
     m_palette_impl = impl;
+    invalidate_all_tiles();
 }
 
 Web::Layout::InitialContainingBlockBox* PageHost::layout_root()
@@ -73,31 +75,106 @@ Web::Layout::InitialContainingBlockBox* PageHost::layout_root()
     return document->layout_node();
 }
 
+static int tile_index_for(int coordinate, int tile_size)
+{
+    if (coordinate >= 0)
+        return coordinate / tile_size;
+    return -((-coordinate + tile_size - 1) / tile_size);
+}
+
 void PageHost::paint(const Gfx::IntRect& content_rect, Gfx::Bitmap& target)
 {
+    TRACE_SCOPE("webcontent", "PageHost::paint");
     Gfx::Painter painter(target);
     Gfx::IntRect bitmap_rect { {}, content_rect.size() };
 
-    auto* layout_root = this->layout_root();
-    if (!layout_root) {
+    if (!layout_root()) {
         painter.fill_rect(bitmap_rect, Color::White);
         return;
     }
 
-    painter.fill_rect(bitmap_rect, layout_root->document().background_color(palette()));
+    int first_column = tile_index_for(content_rect.left(), tile_size);
+    int last_column = tile_index_for(content_rect.right(), tile_size);
+    int first_row = tile_index_for(content_rect.top(), tile_size);
+    int last_row = tile_index_for(content_rect.bottom(), tile_size);
+
+    for (int row = first_row; row <= last_row; ++row) {
+        for (int column = first_column; column <= last_column; ++column) {
+            Gfx::IntRect tile_rect { column * tile_size, row * tile_size, tile_size, tile_size };
+            auto& tile = m_tiles.ensure(tile_key(column, row));
+            if (!tile.bitmap || tile.needs_repaint)
+                paint_tile(tile, tile_rect, target.format());
+            if (!tile.bitmap)
+                continue;
+            auto visible_rect = tile_rect.intersected(content_rect);
+            painter.blit(visible_rect.location().translated(-content_rect.location()), *tile.bitmap, visible_rect.translated(-tile_rect.location()));
+        }
+    }
+
+    evict_tiles_far_from(content_rect);
+}
 
-    if (auto background_bitmap = layout_root->document().background_image()) {
-        painter.draw_tiled_bitmap(bitmap_rect, *background_bitmap);
+void PageHost::paint_tile(Tile& tile, const Gfx::IntRect& tile_rect, Gfx::BitmapFormat format)
+{
+    if (!tile.bitmap) {
+        tile.bitmap = Gfx::Bitmap::create(format, tile_rect.size());
+        if (!tile.bitmap)
+            return;
     }
+    tile.needs_repaint = false;
+
+    auto* layout_root = this->layout_root();
+    VERIFY(layout_root);
+
+    Gfx::Painter painter(*tile.bitmap);
+    Gfx::IntRect bitmap_rect { {}, tile_rect.size() };
+    painter.fill_rect(bitmap_rect, layout_root->document().background_color(palette()));
 
-    painter.translate(-content_rect.x(), -content_rect.y());
+    painter.translate(-tile_rect.x(), -tile_rect.y());
+
+    // NOTE: Passing the tile's content rect keeps the background image aligned across tiles.
+    if (auto background_bitmap = layout_root->document().background_image())
+        painter.draw_tiled_bitmap(tile_rect, *background_bitmap);
 
     Web::PaintContext context(painter, palette(), Gfx::IntPoint());
     context.set_should_show_line_box_borders(m_should_show_line_box_borders);
-    context.set_viewport_rect(content_rect);
+    context.set_viewport_rect(tile_rect);
     layout_root->paint_all_phases(context);
 }
 
+void PageHost::invalidate_tiles(const Gfx::IntRect& content_rect)
+{
+    for (auto& it : m_tiles) {
+        auto column = (int)(i32)(it.key >> 32);
+        auto row = (int)(i32)(it.key & 0xffffffff);
+        Gfx::IntRect tile_rect { column * tile_size, row * tile_size, tile_size, tile_size };
+        if (tile_rect.intersects(content_rect))
+            it.value.needs_repaint = true;
+    }
+}
+
+void PageHost::evict_tiles_far_from(const Gfx::IntRect& content_rect)
+{
+    // Keep one screenful above and below the visible rect around, so scrolling back and forth stays cheap.
+    auto keep_rect = content_rect.inflated(tile_size * 2, content_rect.height() * 2);
+    Vector<u64> keys_to_evict;
+    for (auto& it : m_tiles) {
+        auto column = (int)(i32)(it.key >> 32);
+        auto row = (int)(i32)(it.key & 0xffffffff);
+        Gfx::IntRect tile_rect { column * tile_size, row * tile_size, tile_size, tile_size };
+        if (!tile_rect.intersects(keep_rect))
+            keys_to_evict.append(it.key);
+    }
+    for (auto key : keys_to_evict)
+        m_tiles.remove(key);
+}
+
+void PageHost::set_should_show_line_box_borders(bool b)
+{
+    m_should_show_line_box_borders = b;
+    invalidate_all_tiles();
+}
+
 void PageHost::set_viewport_rect(const Gfx::IntRect& rect)
 {
     page().main_frame().set_viewport_rect(rect);
@@ -105,6 +182,10 @@ void PageHost::set_viewport_rect(const Gfx::IntRect& rect)
 
 void PageHost::page_did_invalidate(const Gfx::IntRect& content_rect)
 {
+    invalidate_tiles(content_rect);
+    // Tiles outside of the viewport are repainted lazily once they're scrolled into view.
+    if (!page().main_frame().viewport_rect().intersects(content_rect))
+        return;
     m_client.post_message(Messages::WebContentClient::DidInvalidateContentRect(content_rect));
 }
 
@@ -115,6 +196,9 @@ void PageHost::page_did_change_selection()
 
 void PageHost::page_did_layout()
 {
+    // Boxes may have moved anywhere on the page, so none of the tiles can be trusted anymore.
+    invalidate_all_tiles();
+
     auto* layout_root = this->layout_root();
     VERIFY(layout_root);
     auto content_size = enclosing_int_rect(layout_root->absolute_rect()).size();
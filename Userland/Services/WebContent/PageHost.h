@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <AK/HashMap.h>
 #include <LibWeb/Page/Page.h>
 
 namespace WebContent {
@@ -48,7 +49,7 @@ public:
     void set_palette_impl(const Gfx::PaletteImpl&);
     void set_viewport_rect(const Gfx::IntRect&);
 
-    void set_should_show_line_box_borders(bool b) { m_should_show_line_box_borders = b; }
+    void set_should_show_line_box_borders(bool);
 
 private:
     // ^PageClient
@@ -76,10 +77,27 @@ private:
     Web::Layout::InitialContainingBlockBox* layout_root();
     void setup_palette();
 
+    // The page is rasterized into fixed-size tiles in content coordinates. Tiles are kept
+    // across paint requests, so scrolling and small invalidations only repaint the tiles
+    // that were damaged or newly exposed, and everything else is blitted from the cache.
+    static constexpr int tile_size = 256;
+
+    struct Tile {
+        RefPtr<Gfx::Bitmap> bitmap;
+        bool needs_repaint { true };
+    };
+
+    static u64 tile_key(int column, int row) { return ((u64)(u32)column << 32) | (u32)row; }
+    void paint_tile(Tile&, const Gfx::IntRect& tile_rect, Gfx::BitmapFormat);
+    void invalidate_tiles(const Gfx::IntRect& content_rect);
+    void invalidate_all_tiles() { m_tiles.clear(); }
+    void evict_tiles_far_from(const Gfx::IntRect& content_rect);
+
     ClientConnection& m_client;
     NonnullOwnPtr<Web::Page> m_page;
     RefPtr<Gfx::PaletteImpl> m_palette_impl;
     bool m_should_show_line_box_borders { false };
+    HashMap<u64, Tile> m_tiles;
 };
 
 }
@@ -27,11 +27,17 @@
 #include <LibCore/EventLoop.h>
 #include <LibCore/LocalServer.h>
 #include <LibIPC/ClientConnection.h>
+#include <LibWeb/Loader/ResourceLoader.h>
 #include <WebContent/ClientConnection.h>
 
 int main(int, char**)
 {
     Core::EventLoop event_loop;
+    // This opens /dev/mempressure, so it has to happen before we unveil.
+    Core::EventLoop::register_memory_pressure_handler([](auto level) {
+        if (level != Core::EventLoop::MemoryPressure::Low)
+            Web::ResourceLoader::the().purge_unused_cached_resources();
+    });
     if (pledge("stdio recvfd sendfd accept unix rpath", nullptr) < 0) {
         perror("pledge");
         return 1;
@@ -25,6 +25,7 @@
  */
 
 #include "Client.h"
+#include "CompressedFileCache.h"
 #include <AK/Base64.h>
 #include <AK/LexicalPath.h>
 #include <AK/MappedFile.h>
@@ -34,16 +35,45 @@
 #include <LibCore/DateTime.h>
 #include <LibCore/DirIterator.h>
 #include <LibCore/File.h>
-#include <LibCore/FileStream.h>
 #include <LibCore/MimeData.h>
+#include <LibCompress/Gzip.h>
 #include <LibHTTP/HttpRequest.h>
+#include <errno.h>
 #include <stdio.h>
+#include <sys/sendfile.h>
 #include <sys/stat.h>
 #include <time.h>
 #include <unistd.h>
 
 namespace WebServer {
 
+static bool accepts_gzip(const HTTP::HttpRequest& request)
+{
+    for (auto& header : request.headers()) {
+        if (!header.name.equals_ignoring_case("Accept-Encoding"))
+            continue;
+        for (auto& coding : header.value.split(',')) {
+            auto parts = coding.split(';');
+            if (parts.is_empty() || !parts[0].trim_whitespace().equals_ignoring_case("gzip"))
+                continue;
+            // "gzip;q=0" explicitly turns it off.
+            for (size_t i = 1; i < parts.size(); ++i) {
+                auto parameter = parts[i].trim_whitespace();
+                if (parameter.starts_with("q=") && parameter.substring_view(2).trim_whitespace().is_one_of("0", "0.0", "0.00", "0.000"))
+                    return false;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool is_compressible(const String& content_type)
+{
+    return content_type.starts_with("text/")
+        || content_type.is_one_of("application/javascript", "application/json", "application/xml", "image/svg+xml");
+}
+
 Client::Client(NonnullRefPtr<Core::TCPSocket> socket, const String& root, Core::Object* parent)
     : Core::Object(parent)
     , m_socket(socket)
@@ -53,23 +83,178 @@ Client::Client(NonnullRefPtr<Core::TCPSocket> socket, const String& root, Core::
 
 void Client::die()
 {
-    remove_from_parent();
+    if (m_dead)
+        return;
+    m_dead = true;
+    m_idle_timer->stop();
+    m_write_notifier->close();
+    m_socket->close();
+    deferred_invoke([this](auto&) {
+        remove_from_parent();
+    });
 }
 
 void Client::start()
 {
+    m_socket->set_blocking(false);
     m_socket->on_ready_to_read = [this] {
-        auto raw_request = m_socket->read_all();
-        if (raw_request.is_null()) {
+        did_become_readable();
+    };
+
+    m_write_notifier = Core::Notifier::construct(m_socket->fd(), Core::Notifier::Write, this);
+    m_write_notifier->set_enabled(false);
+    m_write_notifier->on_ready_to_write = [this] {
+        if (!flush_output())
+            return;
+        did_finish_response();
+        handle_buffered_requests();
+    };
+
+    // Clients that are slow to send a request, or that sit idle between requests, just hold on to resources.
+    m_idle_timer = Core::Timer::create_single_shot(
+        idle_timeout_ms, [this] { die(); }, this);
+    m_idle_timer->start();
+}
+
+void Client::did_become_readable()
+{
+    if (m_dead)
+        return;
+
+    while (m_request_buffer.size() <= max_request_size) {
+        u8 buffer[PAGE_SIZE];
+        auto nread = ::read(m_socket->fd(), buffer, sizeof(buffer));
+        if (nread < 0) {
+            if (errno == EAGAIN)
+                break;
+            perror("read");
             die();
             return;
         }
+        if (nread == 0) {
+            // Requests that already arrived still get their responses.
+            m_peer_closed = true;
+            m_socket->set_read_notifications_enabled(false);
+            break;
+        }
+        m_request_buffer.append(buffer, nread);
+    }
+
+    handle_buffered_requests();
+}
+
+static Optional<size_t> find_end_of_request(ReadonlyBytes bytes)
+{
+    for (size_t i = 3; i < bytes.size(); ++i) {
+        if (bytes[i - 3] == '\r' && bytes[i - 2] == '\n' && bytes[i - 1] == '\r' && bytes[i] == '\n')
+            return i + 1;
+    }
+    return {};
+}
+
+void Client::handle_buffered_requests()
+{
+    while (!m_dead) {
+        auto request_size = find_end_of_request(m_request_buffer.bytes());
+        if (!request_size.has_value()) {
+            if (m_peer_closed || m_request_buffer.size() > max_request_size)
+                die();
+            return;
+        }
+
+        auto raw_request = m_request_buffer.slice(0, request_size.value());
+        m_request_buffer = ByteBuffer::copy(m_request_buffer.bytes().slice(request_size.value()));
 
         dbgln("Got raw request: '{}'", String::copy(raw_request));
 
+        m_keep_alive = false;
         handle_request(raw_request.bytes());
-        die();
+        if (!flush_output())
+            return;
+        did_finish_response();
+    }
+}
+
+void Client::queue_output(ReadonlyBytes bytes)
+{
+    m_output_buffer.append(bytes.data(), bytes.size());
+}
+
+// Returns true once the whole response has been written, or false if we have to wait for the socket
+// (or if the client went away.)
+bool Client::flush_output()
+{
+    auto wait_until_writable = [this] {
+        m_socket->set_read_notifications_enabled(false);
+        m_write_notifier->set_enabled(true);
+        m_idle_timer->restart();
     };
+
+    while (m_output_offset < m_output_buffer.size()) {
+        auto nwritten = ::write(m_socket->fd(), m_output_buffer.data() + m_output_offset, m_output_buffer.size() - m_output_offset);
+        if (nwritten < 0) {
+            if (errno == EAGAIN) {
+                wait_until_writable();
+                return false;
+            }
+            perror("write");
+            die();
+            return false;
+        }
+        m_output_offset += nwritten;
+    }
+    m_output_buffer.clear();
+    m_output_offset = 0;
+
+    // Let the kernel move the file contents to the socket directly.
+    while (m_file_to_send && m_file_bytes_left > 0) {
+        auto nsent = sendfile(m_socket->fd(), m_file_to_send->fd(), nullptr, min(m_file_bytes_left, (size_t)64 * KiB));
+        if (nsent < 0) {
+            if (errno == EAGAIN) {
+                wait_until_writable();
+                return false;
+            }
+            perror("sendfile");
+            die();
+            return false;
+        }
+        if (nsent == 0) {
+            // The file shrank since we sent its size, so the client can only tell where the response ends by the connection closing.
+            m_keep_alive = false;
+            break;
+        }
+        m_file_bytes_left -= nsent;
+    }
+    m_file_to_send = nullptr;
+    m_file_bytes_left = 0;
+    return true;
+}
+
+void Client::did_finish_response()
+{
+    if (!m_keep_alive) {
+        die();
+        return;
+    }
+    m_write_notifier->set_enabled(false);
+    if (!m_peer_closed)
+        m_socket->set_read_notifications_enabled(true);
+    m_idle_timer->restart();
+}
+
+static bool wants_keep_alive(const HTTP::HttpRequest& request)
+{
+    for (auto& header : request.headers()) {
+        if (!header.name.equals_ignoring_case("Connection"))
+            continue;
+        auto value = header.value.to_lowercase();
+        if (value.contains("close"))
+            return false;
+        if (value.contains("keep-alive"))
+            return true;
+    }
+    // Connections are persistent by default from HTTP/1.1 on.
+    return request.protocol() == "HTTP/1.1";
 }
 
 void Client::handle_request(ReadonlyBytes raw_request)
@@ -78,6 +263,8 @@ void Client::handle_request(ReadonlyBytes raw_request)
     if (!request_or_error.has_value())
         return;
     auto& request = request_or_error.value();
+    // Anything else might come with a body, which we would mistake for the next request.
+    m_keep_alive = request.method() == HTTP::HttpRequest::Method::GET && wants_keep_alive(request);
 
     dbgln("Got HTTP request: {} {}", request.method_name(), request.resource());
     for (auto& header : request.headers()) {
@@ -127,44 +314,97 @@ void Client::handle_request(ReadonlyBytes raw_request)
         return;
     }
 
-    Core::InputFileStream stream { file };
+    auto content_type = Core::guess_mime_type_based_on_filename(real_path);
+    if (should_compress(request, content_type)) {
+        if (auto compressed = CompressedFileCache::the().get(real_path, file->fd()); compressed.has_value()) {
+            send_response_header(request, content_type, compressed.value().size(), true);
+            queue_output(compressed.value());
+            return;
+        }
+    }
 
-    send_response(stream, request, Core::guess_mime_type_based_on_filename(real_path));
+    send_file_response(file, request, content_type);
 }
 
-void Client::send_response(InputStream& response, const HTTP::HttpRequest& request, const String& content_type)
+bool Client::should_compress(const HTTP::HttpRequest& request, const String& content_type) const
+{
+    return is_compressible(content_type) && accepts_gzip(request);
+}
+
+void Client::send_response_header(const HTTP::HttpRequest& request, const String& content_type, size_t content_length, bool gzip_encoded)
 {
     StringBuilder builder;
-    builder.append("HTTP/1.0 200 OK\r\n");
+    builder.append("HTTP/1.1 200 OK\r\n");
     builder.append("Server: WebServer (SerenityOS)\r\n");
     builder.append("Content-Type: ");
     builder.append(content_type);
     builder.append("\r\n");
+    builder.appendff("Content-Length: {}\r\n", content_length);
+    if (gzip_encoded)
+        builder.append("Content-Encoding: gzip\r\n");
+    if (is_compressible(content_type))
+        builder.append("Vary: Accept-Encoding\r\n");
+    builder.append(m_keep_alive ? "Connection: keep-alive\r\n" : "Connection: close\r\n");
     builder.append("\r\n");
 
-    m_socket->write(builder.to_string());
+    queue_output(builder.string_view().bytes());
     log_response(200, request);
+}
 
-    char buffer[PAGE_SIZE];
+void Client::send_response(InputStream& response, const HTTP::HttpRequest& request, const String& content_type)
+{
+    bool gzip_encoded = should_compress(request, content_type);
+
+    // The body has to be complete before we can tell its length, so compress it into memory as it is read.
+    DuplexMemoryStream body;
+    Optional<Compress::GzipCompressor> gzip_stream;
+    if (gzip_encoded)
+        gzip_stream.emplace(body, Compress::DeflateCompressor::CompressionLevel::Fast);
+    OutputStream& output = gzip_encoded ? static_cast<OutputStream&>(gzip_stream.value()) : body;
+
+    u8 buffer[PAGE_SIZE];
     do {
         auto size = response.read({ buffer, sizeof(buffer) });
         if (response.unreliable_eof() && size == 0)
             break;
 
-        m_socket->write({ buffer, size });
+        output.write_or_error({ buffer, size });
     } while (true);
+
+    if (gzip_stream.has_value())
+        gzip_stream->final_flush();
+
+    auto bytes = body.copy_into_contiguous_buffer();
+    send_response_header(request, content_type, bytes.size(), gzip_encoded);
+    queue_output(bytes);
+}
+
+void Client::send_file_response(NonnullRefPtr<Core::File> file, const HTTP::HttpRequest& request, const String& content_type)
+{
+    struct stat st;
+    if (fstat(file->fd(), &st) < 0) {
+        perror("fstat");
+        send_error_response(500, "Internal server error!", request);
+        return;
+    }
+
+    send_response_header(request, content_type, st.st_size);
+    m_file_to_send = move(file);
+    m_file_bytes_left = st.st_size;
 }
 
 void Client::send_redirect(StringView redirect_path, const HTTP::HttpRequest& request)
 {
     StringBuilder builder;
-    builder.append("HTTP/1.0 301 Moved Permanently\r\n");
+    builder.append("HTTP/1.1 301 Moved Permanently\r\n");
     builder.append("Location: ");
     builder.append(redirect_path);
     builder.append("\r\n");
+    builder.append("Content-Length: 0\r\n");
+    builder.append(m_keep_alive ? "Connection: keep-alive\r\n" : "Connection: close\r\n");
     builder.append("\r\n");
 
-    m_socket->write(builder.to_string());
+    queue_output(builder.string_view().bytes());
 
     log_response(301, request);
 }
@@ -258,15 +498,23 @@ void Client::handle_directory_listing(const String& requested_path, const String
 
 void Client::send_error_response(unsigned code, const StringView& message, const HTTP::HttpRequest& request)
 {
+    StringBuilder body_builder;
+    body_builder.append("<!DOCTYPE html><html><body><h1>");
+    body_builder.appendf("%u ", code);
+    body_builder.append(message);
+    body_builder.append("</h1></body></html>");
+    auto body = body_builder.to_string();
+
     StringBuilder builder;
-    builder.appendf("HTTP/1.0 %u ", code);
-    builder.append(message);
-    builder.append("\r\n\r\n");
-    builder.append("<!DOCTYPE html><html><body><h1>");
-    builder.appendf("%u ", code);
+    builder.appendf("HTTP/1.1 %u ", code);
     builder.append(message);
-    builder.append("</h1></body></html>");
-    m_socket->write(builder.to_string());
+    builder.append("\r\n");
+    builder.append("Content-Type: text/html\r\n");
+    builder.appendff("Content-Length: {}\r\n", body.length());
+    builder.append(m_keep_alive ? "Connection: keep-alive\r\n" : "Connection: close\r\n");
+    builder.append("\r\n");
+    builder.append(body);
+    queue_output(builder.string_view().bytes());
 
     log_response(code, request);
 }
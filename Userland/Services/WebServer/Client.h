@@ -26,12 +26,19 @@
 
 #pragma once
 
+#include <AK/ByteBuffer.h>
+#include <LibCore/File.h>
+#include <LibCore/Notifier.h>
 #include <LibCore/Object.h>
 #include <LibCore/TCPSocket.h>
+#include <LibCore/Timer.h>
 #include <LibHTTP/Forward.h>
 
 namespace WebServer {
 
+// A connection that may carry any number of requests (with keep-alive.) The socket is
+// non-blocking: requests are accumulated as data arrives, and responses are queued up
+// and written out whenever the socket can take more, so no client can stall the others.
 class Client final : public Core::Object {
     C_OBJECT(Client);
 
@@ -41,16 +48,40 @@ public:
 private:
     Client(NonnullRefPtr<Core::TCPSocket>, const String&, Core::Object* parent);
 
+    static constexpr size_t max_request_size = 64 * KiB;
+    static constexpr int idle_timeout_ms = 10000;
+
+    void did_become_readable();
+    void handle_buffered_requests();
+    bool flush_output();
+    void did_finish_response();
+    void queue_output(ReadonlyBytes);
+
     void handle_request(ReadonlyBytes);
+    void send_response_header(const HTTP::HttpRequest&, const String& content_type, size_t content_length, bool gzip_encoded = false);
     void send_response(InputStream&, const HTTP::HttpRequest&, const String& content_type);
+    void send_file_response(NonnullRefPtr<Core::File>, const HTTP::HttpRequest&, const String& content_type);
     void send_redirect(StringView redirect, const HTTP::HttpRequest& request);
     void send_error_response(unsigned code, const StringView& message, const HTTP::HttpRequest&);
     void die();
     void log_response(unsigned code, const HTTP::HttpRequest&);
     void handle_directory_listing(const String& requested_path, const String& real_path, const HTTP::HttpRequest&);
+    bool should_compress(const HTTP::HttpRequest&, const String& content_type) const;
 
     NonnullRefPtr<Core::TCPSocket> m_socket;
+    RefPtr<Core::Notifier> m_write_notifier;
+    RefPtr<Core::Timer> m_idle_timer;
     String m_root_path;
+
+    ByteBuffer m_request_buffer;
+    ByteBuffer m_output_buffer;
+    size_t m_output_offset { 0 };
+    RefPtr<Core::File> m_file_to_send;
+    size_t m_file_bytes_left { 0 };
+
+    bool m_keep_alive { false };
+    bool m_peer_closed { false };
+    bool m_dead { false };
 };
 
 }
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "CompressedFileCache.h"
+#include <AK/MappedFile.h>
+#include <LibCompress/Gzip.h>
+#include <sys/stat.h>
+
+namespace WebServer {
+
+CompressedFileCache& CompressedFileCache::the()
+{
+    static CompressedFileCache cache;
+    return cache;
+}
+
+Optional<ByteBuffer> CompressedFileCache::get(const String& path, int fd)
+{
+    struct stat st;
+    if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode))
+        return {};
+    if ((size_t)st.st_size < min_file_size || (size_t)st.st_size > max_file_size)
+        return {};
+
+    if (auto it = m_entries.find(path); it != m_entries.end()) {
+        auto& entry = it->value;
+        if (entry.mtime == st.st_mtime && entry.size == st.st_size) {
+            entry.last_used = ++m_use_counter;
+            return entry.compressed;
+        }
+        m_total_size -= entry.compressed.size();
+        m_entries.remove(it);
+    }
+
+    auto file_or_error = MappedFile::map(path);
+    if (file_or_error.is_error())
+        return {};
+    auto compressed = Compress::GzipCompressor::compress_all(file_or_error.value()->bytes(), Compress::DeflateCompressor::CompressionLevel::Best);
+    if (!compressed.has_value())
+        return {};
+
+    dbgln("CompressedFileCache: Compressed {} from {} to {} bytes", path, st.st_size, compressed.value().size());
+    m_total_size += compressed.value().size();
+    m_entries.set(path, { st.st_mtime, st.st_size, compressed.value(), ++m_use_counter });
+    evict_if_needed();
+    return compressed.release_value();
+}
+
+void CompressedFileCache::evict_if_needed()
+{
+    while (m_total_size > size_budget) {
+        auto oldest = m_entries.begin();
+        for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+            if (it->value.last_used < oldest->value.last_used)
+                oldest = it;
+        }
+        dbgln("CompressedFileCache: Evicted {}", oldest->key);
+        m_total_size -= oldest->value.compressed.size();
+        m_entries.remove(oldest);
+    }
+}
+
+}
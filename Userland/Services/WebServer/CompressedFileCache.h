@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/ByteBuffer.h>
+#include <AK/HashMap.h>
+#include <AK/Optional.h>
+#include <AK/String.h>
+#include <time.h>
+
+namespace WebServer {
+
+// Keeps gzip-compressed copies of recently served static files in memory, so every
+// request for the same file doesn't have to compress it again. Entries are keyed on
+// the file's path and remember its mtime and size, so a modified file gets recompressed.
+class CompressedFileCache {
+public:
+    static constexpr size_t size_budget = 32 * MiB;
+    static constexpr size_t max_file_size = 8 * MiB;
+    // Anything smaller than this doesn't gain enough to be worth the gzip header and trailer.
+    static constexpr size_t min_file_size = 256;
+
+    static CompressedFileCache& the();
+
+    // Returns the compressed contents of the open file at path, or nothing if it should be sent as is.
+    Optional<ByteBuffer> get(const String& path, int fd);
+
+private:
+    CompressedFileCache() { }
+
+    void evict_if_needed();
+
+    struct Entry {
+        time_t mtime { 0 };
+        off_t size { 0 };
+        ByteBuffer compressed;
+        u64 last_used { 0 };
+    };
+
+    HashMap<String, Entry> m_entries;
+    size_t m_total_size { 0 };
+    u64 m_use_counter { 0 };
+};
+
+}
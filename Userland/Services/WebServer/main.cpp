@@ -30,6 +30,7 @@
 #include <LibCore/EventLoop.h>
 #include <LibCore/File.h>
 #include <LibCore/TCPServer.h>
+#include <signal.h>
 #include <stdio.h>
 #include <unistd.h>
 
@@ -39,9 +40,11 @@ int main(int argc, char** argv)
     const char* root_path = "/www";
 
     int port = default_port;
+    int worker_count = 1;
 
     Core::ArgsParser args_parser;
     args_parser.add_option(port, "Port to listen on", "port", 'p', "port");
+    args_parser.add_option(worker_count, "Number of processes handling connections", "workers", 'w', "count");
     args_parser.add_positional_argument(root_path, "Path to serve the contents of", "path", Core::ArgsParser::Required::No);
     args_parser.parse(argc, argv);
 
@@ -50,6 +53,11 @@ int main(int argc, char** argv)
         port = default_port;
     }
 
+    if (worker_count < 1) {
+        printf("Warning: invalid worker count: %d\n", worker_count);
+        worker_count = 1;
+    }
+
     auto real_root_path = Core::File::real_path_for(root_path);
 
     if (!Core::File::exists(real_root_path)) {
@@ -57,18 +65,22 @@ int main(int argc, char** argv)
         return 1;
     }
 
-    if (pledge("stdio accept rpath inet unix cpath fattr", nullptr) < 0) {
+    if (pledge("stdio accept rpath inet unix cpath fattr proc", nullptr) < 0) {
         perror("pledge");
         return 1;
     }
 
+    // Clients going away mid-response are handled where we write to them.
+    signal(SIGPIPE, SIG_IGN);
+
     Core::EventLoop loop;
 
     auto server = Core::TCPServer::construct();
 
     server->on_ready_to_accept = [&] {
         auto client_socket = server->accept();
-        VERIFY(client_socket);
+        if (!client_socket)
+            return;
         auto client = WebServer::Client::construct(client_socket.release_nonnull(), real_root_path, server);
         client->start();
     };
@@ -92,6 +104,25 @@ int main(int argc, char** argv)
 
     unveil(nullptr, nullptr);
 
+    // All workers share the listening socket, and whichever one gets to a new connection first handles it.
+    for (int i = 1; i < worker_count; ++i) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            break;
+        }
+        if (pid == 0) {
+            Core::EventLoop::notify_forked(Core::EventLoop::ForkEvent::Child);
+            Core::EventLoop worker_loop;
+            server->resume_accepting_after_fork();
+            if (pledge("stdio accept rpath", nullptr) < 0) {
+                perror("pledge");
+                return 1;
+            }
+            return worker_loop.exec();
+        }
+    }
+
     if (pledge("stdio accept rpath", nullptr) < 0) {
         perror("pledge");
         return 1;
@@ -25,6 +25,7 @@
  */
 
 #include <AK/Badge.h>
+#include <AK/Time.h>
 #include <LibGfx/Bitmap.h>
 #include <LibGfx/StandardCursor.h>
 #include <LibGfx/SystemTheme.h>
@@ -42,6 +43,7 @@
 #include <errno.h>
 #include <serenity.h>
 #include <stdio.h>
+#include <time.h>
 #include <unistd.h>
 
 namespace WindowServer {
@@ -73,6 +75,9 @@ ClientConnection::ClientConnection(NonnullRefPtr<Core::LocalSocket> client_socke
     if (!s_connections)
         s_connections = new HashMap<int, NonnullRefPtr<ClientConnection>>;
     s_connections->set(client_id, *this);
+
+    // Events and paint requests tend to come in bursts, send them off together.
+    set_batching_enabled(true);
 }
 
 ClientConnection::~ClientConnection()
@@ -603,6 +608,17 @@ void ClientConnection::handle(const Messages::WindowServer::DidFinishPainting& m
     auto& window = *(*it).value;
     for (auto& rect : message.rects())
         window.invalidate(rect);
+
+    if (m_has_unanswered_mouse_move) {
+        m_has_unanswered_mouse_move = false;
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        timespec latency;
+        timespec_sub(now, m_first_unanswered_mouse_move_time, latency);
+        // Anything slower than this was most likely a repaint for some other reason.
+        if (latency.tv_sec < 1)
+            Compositor::the().did_measure_input_latency({}, latency.tv_nsec / 1000);
+    }
     if (window.has_alpha_channel() && window.alpha_hit_threshold() > 0.0)
         WindowManager::the().reevaluate_hovered_window(&window);
 
@@ -897,6 +913,22 @@ void ClientConnection::handle(const Messages::WindowServer::DisableDisplayLink&)
     Compositor::the().decrement_display_link_count({});
 }
 
+void ClientConnection::post_mouse_move(const Messages::WindowClient::MouseMove& message)
+{
+    if (!m_has_unanswered_mouse_move) {
+        clock_gettime(CLOCK_MONOTONIC, &m_first_unanswered_mouse_move_time);
+        m_has_unanswered_mouse_move = true;
+    }
+
+    // A mouse move that hasn't been sent yet is replaced by a newer one, unless something
+    // other than the position changed in between.
+    u64 coalescing_key = (u64)(u32)message.window_id() << 32
+        | (message.modifiers() & 0xff) << 16
+        | (message.buttons() & 0xff) << 8
+        | message.is_drag();
+    post_message(message, coalescing_key);
+}
+
 void ClientConnection::notify_display_link(Badge<Compositor>)
 {
     if (!m_has_display_link)
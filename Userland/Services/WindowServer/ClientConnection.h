@@ -62,6 +62,7 @@ public:
 
     void notify_about_new_screen_rect(const Gfx::IntRect&);
     void post_paint_message(Window&, bool ignore_occlusion = false);
+    void post_mouse_move(const Messages::WindowClient::MouseMove&);
 
     Menu* find_menu_by_id(int menu_id)
     {
@@ -169,6 +170,10 @@ private:
 
     bool m_has_display_link { false };
     bool m_unresponsive { false };
+
+    // When we sent the first mouse move the client hasn't repainted in response to yet.
+    timespec m_first_unanswered_mouse_move_time {};
+    bool m_has_unanswered_mouse_move { false };
 };
 
 }
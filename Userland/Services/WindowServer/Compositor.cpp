@@ -34,7 +34,9 @@
 #include <AK/Debug.h>
 #include <AK/Memory.h>
 #include <AK/ScopeGuard.h>
+#include <AK/Time.h>
 #include <LibCore/Timer.h>
+#include <LibCore/Trace.h>
 #include <LibGfx/Font.h>
 #include <LibGfx/Painter.h>
 #include <LibGfx/StylePainter.h>
@@ -114,6 +116,7 @@ void Compositor::did_construct_window_manager(Badge<WindowManager>)
     auto& wm = WindowManager::the();
     m_wallpaper_mode = mode_to_enum(wm.config()->read_entry("Background", "Mode", "simple"));
     m_custom_background_color = Color::from_string(wm.config()->read_entry("Background", "Color", ""));
+    m_show_frame_times = wm.config()->read_bool_entry("Compositor", "ShowFrameTimes", false);
 
     invalidate_screen();
     invalidate_occlusions();
@@ -122,6 +125,7 @@ void Compositor::did_construct_window_manager(Badge<WindowManager>)
 
 void Compositor::compose()
 {
+    TRACE_SCOPE("windowserver", "Compositor::compose");
     auto& wm = WindowManager::the();
     auto& ws = Screen::the();
 
@@ -138,6 +142,10 @@ void Compositor::compose()
         return;
     }
 
+    timespec frame_start {};
+    if (m_show_frame_times)
+        clock_gettime(CLOCK_MONOTONIC, &frame_start);
+
     if (m_occlusions_dirty) {
         m_occlusions_dirty = false;
         recompute_occlusions();
@@ -146,6 +154,7 @@ void Compositor::compose()
     auto dirty_screen_rects = move(m_dirty_screen_rects);
     dirty_screen_rects.add(m_last_geometry_label_damage_rect.intersected(ws.rect()));
     dirty_screen_rects.add(m_last_dnd_rect.intersected(ws.rect()));
+    dirty_screen_rects.add(m_last_frame_times_damage_rect.intersected(ws.rect()));
     if (m_invalidated_cursor) {
         if (wm.dnd_client())
             dirty_screen_rects.add(wm.dnd_rect().intersected(ws.rect()));
@@ -153,6 +162,11 @@ void Compositor::compose()
 
     // Mark window regions as dirty that need to be re-rendered
     wm.for_each_visible_window_from_back_to_front([&](Window& window) {
+        if (!window.has_visible_rects()) {
+            // Nothing of this window will be painted, so don't bother collecting damage for it.
+            window.prepare_dirty_rects();
+            return IterationDecision::Continue;
+        }
         auto frame_rect = window.frame().render_rect();
         for (auto& dirty_rect : dirty_screen_rects.rects()) {
             auto invalidate_rect = dirty_rect.intersected(frame_rect);
@@ -178,7 +192,7 @@ void Compositor::compose()
         auto frame_rect = window.frame().render_rect();
         auto& dirty_rects = window.dirty_rects();
         wm.for_each_visible_window_from_back_to_front([&](Window& w) {
-            if (&w == &window)
+            if (&w == &window || w.dirty_rects().is_empty())
                 return IterationDecision::Continue;
             auto frame_rect2 = w.frame().render_rect();
             if (!frame_rect2.intersects(frame_rect))
@@ -205,26 +219,15 @@ void Compositor::compose()
     Gfx::DisjointRectSet flush_rects;
     Gfx::DisjointRectSet flush_transparent_rects;
     Gfx::DisjointRectSet flush_special_rects;
-    auto cursor_rect = current_cursor_rect();
-    bool need_to_draw_cursor = false;
 
     auto back_painter = *m_back_painter;
     auto temp_painter = *m_temp_painter;
 
-    auto check_restore_cursor_back = [&](const Gfx::IntRect& rect) {
-        if (!need_to_draw_cursor && rect.intersects(cursor_rect)) {
-            // Restore what's behind the cursor if anything touches the area of the cursor
-            need_to_draw_cursor = true;
-            restore_cursor_back();
-        }
-    };
-
     auto prepare_rect = [&](const Gfx::IntRect& rect) {
         dbgln_if(COMPOSE_DEBUG, "    -> flush opaque: {}", rect);
         VERIFY(!flush_rects.intersects(rect));
         VERIFY(!flush_transparent_rects.intersects(rect));
         flush_rects.add(rect);
-        check_restore_cursor_back(rect);
     };
 
     auto prepare_transparency_rect = [&](const Gfx::IntRect& rect) {
@@ -236,12 +239,8 @@ void Compositor::compose()
         }
 
         flush_transparent_rects.add(rect);
-        check_restore_cursor_back(rect);
     };
 
-    if (!m_cursor_back_bitmap || m_invalidated_cursor)
-        check_restore_cursor_back(cursor_rect);
-
     auto paint_wallpaper = [&](Gfx::Painter& painter, const Gfx::IntRect& rect) {
         // FIXME: If the wallpaper is opaque and covers the whole rect, no need to fill with color!
         painter.fill_rect(rect, background_color);
@@ -274,6 +273,10 @@ void Compositor::compose()
     });
 
     auto compose_window = [&](Window& window) -> IterationDecision {
+        // Only the damaged parts of a window that are still visible after occlusion get painted,
+        // so windows without damage and fully covered ones can be skipped altogether.
+        if (window.dirty_rects().is_empty() || !window.has_visible_rects())
+            return IterationDecision::Continue;
         auto frame_rect = window.frame().render_rect();
         if (!frame_rect.intersects(ws.rect()))
             return IterationDecision::Continue;
@@ -499,11 +502,14 @@ void Compositor::compose()
 
     run_animations(flush_special_rects);
 
-    if (need_to_draw_cursor) {
-        flush_rects.add(cursor_rect);
-        if (cursor_rect != m_last_cursor_rect)
-            flush_rects.add(m_last_cursor_rect);
-        draw_cursor(cursor_rect);
+    if (m_show_frame_times) {
+        auto frame_times_rect = frame_times_overlay_rect();
+        draw_frame_times(frame_times_rect);
+        flush_special_rects.add(frame_times_rect);
+        m_last_frame_times_damage_rect = frame_times_rect;
+    } else if (!m_last_frame_times_damage_rect.is_empty()) {
+        invalidate_screen(m_last_frame_times_damage_rect);
+        m_last_frame_times_damage_rect = {};
     }
 
     if (m_flash_flush) {
@@ -520,20 +526,65 @@ void Compositor::compose()
         flush(rect);
     for (auto& rect : flush_special_rects.rects())
         flush(rect);
+
+    // The cursor only ever lives in the front buffer. When flipping, this takes it out of
+    // the previous front buffer (our new back buffer), otherwise it erases what the flushes
+    // above have left of it.
+    flush(m_last_cursor_rect);
+    draw_cursor(current_cursor_rect());
+
+    if (m_show_frame_times) {
+        // This is shown by the next frame, as painting the overlay is part of what we measure.
+        timespec frame_end;
+        clock_gettime(CLOCK_MONOTONIC, &frame_end);
+        timespec frame_time;
+        timespec_sub(frame_end, frame_start, frame_time);
+        m_frame_times_us.enqueue(frame_time.tv_sec * 1'000'000 + frame_time.tv_nsec / 1000);
+    }
 }
 
-void Compositor::flush(const Gfx::IntRect& a_rect)
+Gfx::IntRect Compositor::frame_times_overlay_rect() const
 {
-    auto rect = Gfx::IntRect::intersection(a_rect, Screen::the().rect());
+    auto& wm = WindowManager::the();
+    auto desktop_rect = wm.desktop_rect();
+    int width = wm.font().width("compose: 0000.0 ms avg, 0000.0 ms max") + 16;
+    int height = wm.font().glyph_height() * 2 + 14;
+    return { desktop_rect.right() - width - 4, desktop_rect.top() + 4, width, height };
+}
 
-    // Almost everything in Compositor is in logical coordinates, with the painters having
-    // a scale applied. But this routine accesses the backbuffer pixels directly, so it
-    // must work in physical coordinates.
-    rect = rect * Screen::the().scale_factor();
-    Gfx::RGBA32* front_ptr = m_front_bitmap->scanline(rect.y()) + rect.x();
-    Gfx::RGBA32* back_ptr = m_back_bitmap->scanline(rect.y()) + rect.x();
-    size_t pitch = m_back_bitmap->pitch();
+void Compositor::did_measure_input_latency(Badge<ClientConnection>, u64 latency_us)
+{
+    if (m_show_frame_times)
+        m_input_latencies_us.enqueue(latency_us);
+}
+
+static String format_times(const char* label, const CircularQueue<u64, 60>& times_us)
+{
+    u64 total_us = 0;
+    u64 max_us = 0;
+    for (auto time_us : times_us) {
+        total_us += time_us;
+        max_us = max(max_us, time_us);
+    }
+    u64 average_us = times_us.is_empty() ? 0 : total_us / times_us.size();
+    return String::formatted("{}: {}.{} ms avg, {}.{} ms max", label, average_us / 1000, average_us % 1000 / 100, max_us / 1000, max_us % 1000 / 100);
+}
 
+void Compositor::draw_frame_times(const Gfx::IntRect& rect)
+{
+    auto& back_painter = *m_back_painter;
+    back_painter.fill_rect(rect, Color(Color::Black).with_alpha(192));
+
+    auto line_rect = rect.shrunken(0, 8);
+    line_rect.set_height(line_rect.height() / 2);
+    back_painter.draw_text(line_rect, format_times("compose", m_frame_times_us), Gfx::TextAlignment::Center, Color::White);
+    line_rect.move_by(0, line_rect.height());
+    back_painter.draw_text(line_rect, format_times("input", m_input_latencies_us), Gfx::TextAlignment::Center, Color::White);
+}
+
+void Compositor::flush(const Gfx::IntRect& rect)
+{
+    TRACE_SCOPE("windowserver", "Compositor::flush");
     // NOTE: The meaning of a flush depends on whether we can flip buffers or not.
     //
     //       If flipping is supported, flushing means that we've flipped, and now we
@@ -542,17 +593,23 @@ void Compositor::flush(const Gfx::IntRect& a_rect)
     //
     //       If flipping is not supported, flushing means that we copy the changed
     //       rects from the backing bitmap to the display framebuffer.
+    if (m_screen_can_set_buffer)
+        copy_rect(*m_back_bitmap, *m_front_bitmap, rect);
+    else
+        copy_rect(*m_front_bitmap, *m_back_bitmap, rect);
+}
 
-    Gfx::RGBA32* to_ptr;
-    const Gfx::RGBA32* from_ptr;
+void Compositor::copy_rect(Gfx::Bitmap& to, const Gfx::Bitmap& from, const Gfx::IntRect& a_rect)
+{
+    auto rect = Gfx::IntRect::intersection(a_rect, Screen::the().rect());
 
-    if (m_screen_can_set_buffer) {
-        to_ptr = back_ptr;
-        from_ptr = front_ptr;
-    } else {
-        to_ptr = front_ptr;
-        from_ptr = back_ptr;
-    }
+    // Almost everything in Compositor is in logical coordinates, with the painters having
+    // a scale applied. But this routine accesses the backbuffer pixels directly, so it
+    // must work in physical coordinates.
+    rect = rect * Screen::the().scale_factor();
+    Gfx::RGBA32* to_ptr = to.scanline(rect.y()) + rect.x();
+    const Gfx::RGBA32* from_ptr = from.scanline(rect.y()) + rect.x();
+    size_t pitch = to.pitch();
 
     for (int y = 0; y < rect.height(); ++y) {
         fast_u32_copy(to_ptr, from_ptr, rect.width());
@@ -729,6 +786,14 @@ void Compositor::invalidate_cursor(bool compose_immediately)
 {
     if (m_invalidated_cursor)
         return;
+
+    // The drag-and-drop rect moves with the cursor, so that still needs a compose pass.
+    // Otherwise, moving or animating the cursor doesn't touch the back buffer at all.
+    if (!WindowManager::the().dnd_client()) {
+        update_cursor();
+        return;
+    }
+
     m_invalidated_cursor = true;
     m_invalidated_any = true;
 
@@ -800,26 +865,22 @@ void Compositor::change_cursor(const Cursor* cursor)
 
 void Compositor::draw_cursor(const Gfx::IntRect& cursor_rect)
 {
+    // We don't have any hardware cursor support, so this is the next best thing: the cursor is
+    // drawn on top of the front buffer only, and the back buffer always holds what's below it.
     auto& wm = WindowManager::the();
-
-    if (!m_cursor_back_bitmap || m_cursor_back_bitmap->size() != cursor_rect.size() || m_cursor_back_bitmap->scale() != Screen::the().scale_factor()) {
-        m_cursor_back_bitmap = Gfx::Bitmap::create(Gfx::BitmapFormat::RGB32, cursor_rect.size(), Screen::the().scale_factor());
-        m_cursor_back_painter = make<Gfx::Painter>(*m_cursor_back_bitmap);
-    }
-
     auto& current_cursor = m_current_cursor ? *m_current_cursor : wm.active_cursor();
-    m_cursor_back_painter->blit({ 0, 0 }, *m_back_bitmap, current_cursor.rect().translated(cursor_rect.location()).intersected(Screen::the().rect()));
-    m_back_painter->blit(cursor_rect.location(), current_cursor.bitmap(), current_cursor.source_rect(m_current_cursor_frame));
+    m_front_painter->blit(cursor_rect.location(), current_cursor.bitmap(), current_cursor.source_rect(m_current_cursor_frame));
     m_last_cursor_rect = cursor_rect;
 }
 
-void Compositor::restore_cursor_back()
+void Compositor::update_cursor()
 {
-    if (!m_cursor_back_bitmap || m_cursor_back_bitmap->scale() != m_back_bitmap->scale())
-        return;
+    auto& current_cursor = WindowManager::the().active_cursor();
+    if (m_current_cursor != &current_cursor)
+        change_cursor(&current_cursor);
 
-    auto last_cursor_rect = m_last_cursor_rect.intersected(Screen::the().rect());
-    m_back_painter->blit(last_cursor_rect.location(), *m_cursor_back_bitmap, { { 0, 0 }, last_cursor_rect.size() });
+    copy_rect(*m_front_bitmap, *m_back_bitmap, m_last_cursor_rect);
+    draw_cursor(current_cursor_rect());
 }
 
 void Compositor::notify_display_links()
@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <AK/CircularQueue.h>
 #include <AK/OwnPtr.h>
 #include <AK/RefPtr.h>
 #include <LibCore/Object.h>
@@ -74,6 +75,8 @@ public:
 
     void invalidate_occlusions() { m_occlusions_dirty = true; }
 
+    void did_measure_input_latency(Badge<ClientConnection>, u64 latency_us);
+
     void did_construct_window_manager(Badge<WindowManager>);
 
 private:
@@ -81,6 +84,7 @@ private:
     void init_bitmaps();
     void flip_buffers();
     void flush(const Gfx::IntRect&);
+    void copy_rect(Gfx::Bitmap& to, const Gfx::Bitmap& from, const Gfx::IntRect&);
     void draw_menubar();
     void run_animations(Gfx::DisjointRectSet&);
     void notify_display_links();
@@ -89,12 +93,15 @@ private:
     bool any_opaque_window_above_this_one_contains_rect(const Window&, const Gfx::IntRect&);
     void change_cursor(const Cursor*);
     void draw_cursor(const Gfx::IntRect&);
-    void restore_cursor_back();
+    void update_cursor();
     bool draw_geometry_label(Gfx::IntRect&);
+    Gfx::IntRect frame_times_overlay_rect() const;
+    void draw_frame_times(const Gfx::IntRect&);
 
     RefPtr<Core::Timer> m_compose_timer;
     RefPtr<Core::Timer> m_immediate_compose_timer;
     bool m_flash_flush { false };
+    bool m_show_frame_times { false };
     bool m_buffers_are_flipped { false };
     bool m_screen_can_set_buffer { false };
     bool m_occlusions_dirty { true };
@@ -112,11 +119,15 @@ private:
     Gfx::DisjointRectSet m_dirty_screen_rects;
     Gfx::DisjointRectSet m_opaque_wallpaper_rects;
 
-    RefPtr<Gfx::Bitmap> m_cursor_back_bitmap;
-    OwnPtr<Gfx::Painter> m_cursor_back_painter;
     Gfx::IntRect m_last_cursor_rect;
     Gfx::IntRect m_last_dnd_rect;
     Gfx::IntRect m_last_geometry_label_damage_rect;
+    Gfx::IntRect m_last_frame_times_damage_rect;
+
+    // How long the last few calls to compose() took, in microseconds.
+    CircularQueue<u64, 60> m_frame_times_us;
+    // How long clients took to repaint after the last few mouse moves, in microseconds.
+    CircularQueue<u64, 60> m_input_latencies_us;
 
     String m_wallpaper_path { "" };
     WallpaperMode m_wallpaper_mode { WallpaperMode::Unchecked };
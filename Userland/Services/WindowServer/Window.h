@@ -326,6 +326,9 @@ public:
     Gfx::DisjointRectSet& transparency_rects() { return m_transparency_rects; }
     Gfx::DisjointRectSet& transparency_wallpaper_rects() { return m_transparency_wallpaper_rects; }
 
+    // False if other windows (or the screen edges) hide all of this window, as of the last occlusion pass.
+    bool has_visible_rects() const { return !m_opaque_rects.is_empty() || !m_transparency_rects.is_empty(); }
+
 private:
     void handle_mouse_event(const MouseEvent&);
     void update_menu_item_text(PopupMenuItem item);
@@ -29,6 +29,7 @@
 #include "Forward.h"
 #include "Job.h"
 #include "NodeVisitor.h"
+#include <AK/BumpAllocator.h>
 #include <AK/Format.h>
 #include <AK/InlineLinkedList.h>
 #include <AK/NonnullRefPtr.h>
@@ -401,6 +402,7 @@ private:
 };
 
 class Node : public RefCounted<Node> {
+    AK_MAKE_BUMP_ALLOCATED(Node)
 public:
     virtual void dump(int level) const = 0;
     virtual void for_each_entry(RefPtr<Shell> shell, Function<IterationDecision(NonnullRefPtr<Value>)> callback);
@@ -930,6 +930,8 @@ bool Shell::run_builtin(const AST::Command& command, const NonnullRefPtrVector<A
 #define __ENUMERATE_SHELL_BUILTIN(builtin)                               \
     if (name == #builtin) {                                              \
         retval = builtin_##builtin(argv.size() - 1, argv.data());        \
+        fflush(stdout);                                                  \
+        fflush(stderr);                                                  \
         if (!has_error(ShellError::None))                                \
             raise_error(m_error, m_error_description, command.position); \
         return true;                                                     \
@@ -954,4 +956,22 @@ bool Shell::has_builtin(const StringView& name) const
     return false;
 }
 
+bool Shell::can_run_builtin_as_pipe_source(const AST::Command& command) const
+{
+    // A pipeline's commands run in their own processes, so builtins that change the shell's state must not run in ours.
+    // These ones only print a little: nobody reads from the pipe until the next command starts, so a builtin
+    // that fills it up would never finish.
+    if (command.argv.is_empty())
+        return false;
+    auto& name = command.argv.first();
+    if (name == "pwd")
+        return true;
+    if (name == "jobs")
+        return true;
+    // With arguments, these change things instead.
+    if (name == "dirs" || name == "umask")
+        return command.argv.size() == 1;
+    return false;
+}
+
 }
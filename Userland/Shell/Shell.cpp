@@ -275,13 +275,11 @@ Vector<String> Shell::expand_globs(Vector<StringView> path_segments, const Strin
     if (is_glob(first_segment)) {
         Vector<String> result;
 
-        Core::DirIterator di(base, Core::DirIterator::SkipParentAndBaseDir);
-        if (di.has_error())
+        auto entries = directory_entries_for_glob(base);
+        if (!entries.has_value())
             return {};
 
-        while (di.has_next()) {
-            String path = di.next_path();
-
+        for (auto& path : entries.value()) {
             // Dotfiles have to be explicitly requested
             if (path[0] == '.' && first_segment[0] != '.')
                 continue;
@@ -308,6 +306,22 @@ Vector<String> Shell::expand_globs(Vector<StringView> path_segments, const Strin
     }
 }
 
+Optional<Vector<String>> Shell::directory_entries_for_glob(const String& path)
+{
+    if (auto entries = m_glob_directory_cache.get(path); entries.has_value())
+        return entries;
+
+    Core::DirIterator di(path, Core::DirIterator::SkipParentAndBaseDir);
+    if (di.has_error())
+        return {};
+
+    Vector<String> entries;
+    while (di.has_next())
+        entries.append(di.next_path());
+    m_glob_directory_cache.set(path, entries);
+    return entries;
+}
+
 Vector<AST::Command> Shell::expand_aliases(Vector<AST::Command> initial_commands)
 {
     Vector<AST::Command> commands;
@@ -610,6 +624,8 @@ RefPtr<Job> Shell::run_command(const AST::Command& command)
     if (options.verbose)
         warnln("+ {}", command);
 
+    m_glob_directory_cache.clear();
+
     // If the command is empty, store the redirections and apply them to all later commands.
     if (command.argv.is_empty() && !command.should_immediately_execute_next) {
         m_global_redirections.append(command.redirections);
@@ -712,6 +728,13 @@ RefPtr<Job> Shell::run_command(const AST::Command& command)
         return nullptr;
     }
 
+    // The pipeline's other commands see this one's output once our end of the pipe gets closed on the way out.
+    if (command.is_pipe_source && can_run_builtin_as_pipe_source(command) && run_builtin(command, rewirings, last_return_code)) {
+        for (auto& next_in_chain : command.next_chain)
+            run_tail(command, next_in_chain, last_return_code);
+        return nullptr;
+    }
+
     auto can_be_run_in_current_process = command.should_wait && !command.pipeline && !command.argv.is_empty();
     if (can_be_run_in_current_process && has_function(command.argv.first())) {
         SavedFileDescriptors fds { rewirings };
@@ -100,13 +100,14 @@ public:
     bool run_file(const String&, bool explicitly_invoked = true);
     bool run_builtin(const AST::Command&, const NonnullRefPtrVector<AST::Rewiring>&, int& retval);
     bool has_builtin(const StringView&) const;
+    bool can_run_builtin_as_pipe_source(const AST::Command&) const;
     void block_on_job(RefPtr<Job>);
     void block_on_pipeline(RefPtr<AST::Pipeline>);
     String prompt() const;
 
     static String expand_tilde(const String&);
-    static Vector<String> expand_globs(const StringView& path, StringView base);
-    static Vector<String> expand_globs(Vector<StringView> path_segments, const StringView& base);
+    Vector<String> expand_globs(const StringView& path, StringView base);
+    Vector<String> expand_globs(Vector<StringView> path_segments, const StringView& base);
     Vector<AST::Command> expand_aliases(Vector<AST::Command>);
     String resolve_path(String) const;
     String resolve_alias(const String&) const;
@@ -274,6 +275,7 @@ private:
 
     void cache_path();
     void add_entry_to_cache(const String&);
+    Optional<Vector<String>> directory_entries_for_glob(const String& path);
     void stop_all_jobs();
     const Job* m_current_job { nullptr };
     LocalFrame* find_frame_containing_local_variable(const String& name);
@@ -314,6 +316,11 @@ private:
     NonnullRefPtrVector<AST::Redirection> m_global_redirections;
 
     HashMap<String, String> m_aliases;
+
+    // Directory listings read while expanding globs, so a command line with several globs in the same
+    // directory only reads it once. Any command that runs may change them, so this is dropped whenever one does.
+    HashMap<String, Vector<String>> m_glob_directory_cache;
+
     bool m_is_interactive { true };
     bool m_is_subshell { false };
     bool m_should_reinstall_signal_handlers { true };
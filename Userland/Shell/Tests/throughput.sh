@@ -0,0 +1,44 @@
+#!/bin/sh
+
+source test-commons.inc
+
+# Runs many globs and short pipelines, and prints how long that took.
+# Along the way, makes sure the shortcuts the shell takes for them (reusing directory
+# listings, running simple builtins without forking) don't change the results.
+
+rm -rf shell-throughput-test
+mkdir shell-throughput-test
+cd shell-throughput-test
+
+touch file{1..50}.txt file{1..50}.log
+
+if not test $(echo *.txt | wc -w) -eq 50 { fail glob found the wrong number of files }
+if not test $(echo *.txt *.log *.txt | wc -w) -eq 150 { fail repeated globs found the wrong number of files }
+
+# Commands that run in between may change the directory, even on the same line.
+touch new.txt; if not test $(echo *.txt | wc -w) -eq 51 { fail glob saw an outdated directory listing }
+rm new.txt
+if not test $(echo *.txt | wc -w) -eq 50 { fail glob saw a removed file }
+
+if not test "$(pwd | cat)" = "$(pwd)" { fail builtin at the start of a pipeline printed the wrong thing }
+if not test "$(umask | cat)" = "$(umask)" { fail umask at the start of a pipeline printed the wrong thing }
+
+# Piped builtins that change the shell's state must not do so.
+cd ..
+cd shell-throughput-test | cat
+if test "$(basename $(pwd))" = shell-throughput-test { fail cd at the start of a pipeline changed the directory }
+cd shell-throughput-test
+
+run_globs_and_pipelines() {
+    for i in {1..100} {
+        files=(*.txt *.log)
+        pwd | cat > /dev/null
+    }
+}
+
+time run_globs_and_pipelines
+
+cd ..
+rm -rf shell-throughput-test
+
+echo PASS
@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Format.h>
+#include <AK/HashTable.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
+#include <time.h>
+
+// Compares AK::HashTable with the table it replaced, which kept three bools per
+// bucket and probed one bucket at a time with double hashing.
+
+namespace Previous {
+
+template<typename T, typename TraitsForT = Traits<T>>
+class HashTable {
+    static constexpr size_t load_factor_in_percent = 60;
+
+    struct Bucket {
+        bool used;
+        bool deleted;
+        bool end;
+        alignas(T) u8 storage[sizeof(T)];
+
+        T* slot() { return reinterpret_cast<T*>(storage); }
+    };
+
+public:
+    ~HashTable()
+    {
+        for (size_t i = 0; i < m_capacity; ++i) {
+            if (m_buckets[i].used)
+                m_buckets[i].slot()->~T();
+        }
+        kfree(m_buckets);
+    }
+
+    size_t size() const { return m_size; }
+
+    void set(const T& value)
+    {
+        auto& bucket = lookup_for_writing(value);
+        if (bucket.used) {
+            *bucket.slot() = value;
+            return;
+        }
+        new (bucket.slot()) T(value);
+        bucket.used = true;
+        if (bucket.deleted) {
+            bucket.deleted = false;
+            --m_deleted_count;
+        }
+        ++m_size;
+    }
+
+    bool contains(const T& value) const { return lookup(value); }
+
+    bool remove(const T& value)
+    {
+        auto* bucket = lookup(value);
+        if (!bucket)
+            return false;
+        bucket->slot()->~T();
+        bucket->used = false;
+        bucket->deleted = true;
+        --m_size;
+        ++m_deleted_count;
+        return true;
+    }
+
+private:
+    void rehash(size_t new_capacity)
+    {
+        new_capacity = max(new_capacity, static_cast<size_t>(4));
+        auto* old_buckets = m_buckets;
+        auto old_capacity = m_capacity;
+        m_buckets = (Bucket*)kmalloc(sizeof(Bucket) * (new_capacity + 1));
+        __builtin_memset(m_buckets, 0, sizeof(Bucket) * (new_capacity + 1));
+        m_capacity = new_capacity;
+        m_deleted_count = 0;
+        m_buckets[m_capacity].end = true;
+        for (size_t i = 0; i < old_capacity; ++i) {
+            if (old_buckets[i].used) {
+                auto& bucket = lookup_for_writing(*old_buckets[i].slot());
+                new (bucket.slot()) T(move(*old_buckets[i].slot()));
+                bucket.used = true;
+                old_buckets[i].slot()->~T();
+            }
+        }
+        kfree(old_buckets);
+    }
+
+    Bucket* lookup(const T& value, Bucket** usable_bucket_for_writing = nullptr) const
+    {
+        if (!m_size)
+            return nullptr;
+        auto hash = TraitsForT::hash(value);
+        size_t bucket_index = hash % m_capacity;
+        for (;;) {
+            auto& bucket = m_buckets[bucket_index];
+            if (usable_bucket_for_writing && !*usable_bucket_for_writing && !bucket.used)
+                *usable_bucket_for_writing = &bucket;
+            if (bucket.used && TraitsForT::equals(*bucket.slot(), value))
+                return &bucket;
+            if (!bucket.used && !bucket.deleted)
+                return nullptr;
+            hash = double_hash(hash);
+            bucket_index = hash % m_capacity;
+        }
+    }
+
+    Bucket& lookup_for_writing(const T& value)
+    {
+        Bucket* usable_bucket_for_writing = nullptr;
+        if (auto* bucket = lookup(value, &usable_bucket_for_writing))
+            return *bucket;
+        if ((m_size + m_deleted_count + 1) * 100 >= m_capacity * load_factor_in_percent)
+            rehash(m_capacity * 2);
+        else if (usable_bucket_for_writing)
+            return *usable_bucket_for_writing;
+        auto hash = TraitsForT::hash(value);
+        size_t bucket_index = hash % m_capacity;
+        for (;;) {
+            auto& bucket = m_buckets[bucket_index];
+            if (!bucket.used)
+                return bucket;
+            hash = double_hash(hash);
+            bucket_index = hash % m_capacity;
+        }
+    }
+
+    Bucket* m_buckets { nullptr };
+    size_t m_size { 0 };
+    size_t m_capacity { 0 };
+    size_t m_deleted_count { 0 };
+};
+
+}
+
+static u64 now_in_us()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1'000'000 + ts.tv_nsec / 1'000;
+}
+
+static int s_failures;
+
+// Inserts all keys, looks each of them up along with as many missing keys, then removes
+// and re-inserts half of them a few times to exercise tombstones.
+template<typename Table, typename T>
+static u64 run(const Vector<T>& keys, const Vector<T>& missing_keys)
+{
+    u64 start = now_in_us();
+    Table table;
+    for (auto& key : keys)
+        table.set(key);
+
+    size_t found = 0;
+    for (int round = 0; round < 4; ++round) {
+        for (auto& key : keys)
+            found += table.contains(key);
+        for (auto& key : missing_keys)
+            found += table.contains(key);
+    }
+
+    for (int round = 0; round < 4; ++round) {
+        for (size_t i = round % 2; i < keys.size(); i += 2)
+            table.remove(keys[i]);
+        for (size_t i = round % 2; i < keys.size(); i += 2)
+            table.set(keys[i]);
+    }
+    u64 elapsed = now_in_us() - start;
+
+    if (found != 4 * keys.size() || table.size() != keys.size()) {
+        warnln("FAIL: found {} of {} keys, size {}", found, 4 * keys.size(), table.size());
+        ++s_failures;
+    }
+    return elapsed;
+}
+
+template<typename T>
+static void compare(const char* name, const Vector<T>& keys, const Vector<T>& missing_keys)
+{
+    u64 previous = run<Previous::HashTable<T>>(keys, missing_keys);
+    u64 current = run<HashTable<T>>(keys, missing_keys);
+    outln("{:>8} x {:>7}: previous {:>8} us, current {:>8} us ({}%)", name, keys.size(), previous, current, current * 100 / max(previous, (u64)1));
+}
+
+int main()
+{
+    for (size_t count : { 100, 10'000, 1'000'000 }) {
+        Vector<u32> keys;
+        Vector<u32> missing_keys;
+        for (size_t i = 0; i < count; ++i) {
+            keys.append(i * 2);
+            missing_keys.append(i * 2 + 1);
+        }
+        compare("u32", keys, missing_keys);
+
+        Vector<String> string_keys;
+        Vector<String> missing_string_keys;
+        for (size_t i = 0; i < count; ++i) {
+            string_keys.append(String::formatted("key{}", i * 2));
+            missing_string_keys.append(String::formatted("key{}", i * 2 + 1));
+        }
+        compare("String", string_keys, missing_string_keys);
+    }
+
+    if (s_failures)
+        return 1;
+    outln("PASS");
+    return 0;
+}
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <AK/Format.h>
+#include <AK/JsonArray.h>
+#include <AK/JsonDocument.h>
+#include <AK/JsonObject.h>
+#include <AK/JsonStreamParser.h>
+#include <AK/MappedFile.h>
+#include <AK/StringBuilder.h>
+#include <time.h>
+
+// Compares JsonParser, which builds a JsonValue tree, with JsonStreamParser and
+// JsonDocument. Each of them is used to sum the "pid" members of an array of
+// /proc/all-style objects. Pass a file to benchmark it instead; then the number
+// of values is counted.
+
+static u64 now_in_us()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1'000'000 + ts.tv_nsec / 1'000;
+}
+
+static String generate_processes(size_t count)
+{
+    StringBuilder builder;
+    builder.append('[');
+    for (size_t i = 0; i < count; ++i) {
+        if (i)
+            builder.append(',');
+        builder.appendff("{{\"pid\":{},\"ppid\":1,\"name\":\"Process {}\",\"executable\":\"/bin/proc\\/{}\",\"amount_virtual\":{},\"cpu_percent\":{}.{},\"kernel\":false,\"pledge\":null,", i, i, i, i * 4096, i % 100, i % 10);
+        builder.append("\"threads\":[");
+        for (size_t j = 0; j < 4; ++j)
+            builder.appendff("{}{{\"tid\":{},\"state\":\"Runnable\",\"times_scheduled\":{}}}", j ? "," : "", i * 4 + j, j * 1000);
+        builder.append("]}");
+    }
+    builder.append(']');
+    return builder.to_string();
+}
+
+class PidSummer final : public JsonStreamVisitor {
+public:
+    virtual bool on_object_start() override
+    {
+        ++m_depth;
+        return true;
+    }
+    virtual bool on_object_end() override
+    {
+        --m_depth;
+        return true;
+    }
+    virtual bool on_object_key(const JsonRawString& key) override
+    {
+        m_next_is_pid = m_depth == 1 && key == "pid";
+        return true;
+    }
+    virtual bool on_number(const StringView& literal) override
+    {
+        ++values;
+        if (m_next_is_pid)
+            sum += literal.to_uint<u64>().value_or(0);
+        m_next_is_pid = false;
+        return true;
+    }
+    virtual bool on_string(const JsonRawString&) override { return count_value(); }
+    virtual bool on_bool(bool) override { return count_value(); }
+    virtual bool on_null() override { return count_value(); }
+
+    u64 sum { 0 };
+    u64 values { 0 };
+
+private:
+    bool count_value()
+    {
+        ++values;
+        m_next_is_pid = false;
+        return true;
+    }
+
+    int m_depth { 0 };
+    bool m_next_is_pid { false };
+};
+
+static u64 count_values(const JsonValue& value)
+{
+    if (value.is_array()) {
+        u64 count = 0;
+        value.as_array().for_each([&](auto& element) { count += count_values(element); });
+        return count;
+    }
+    if (value.is_object()) {
+        u64 count = 0;
+        value.as_object().for_each_member([&](auto&, auto& member) { count += count_values(member); });
+        return count;
+    }
+    return 1;
+}
+
+static u64 count_values(JsonElement element)
+{
+    if (element.is_array()) {
+        u64 count = 0;
+        element.for_each([&](auto child) { count += count_values(child); });
+        return count;
+    }
+    if (element.is_object()) {
+        u64 count = 0;
+        element.for_each_member([&](auto&, auto child) { count += count_values(child); });
+        return count;
+    }
+    return 1;
+}
+
+static int s_failures;
+
+static void run(const StringView& input)
+{
+    u64 start = now_in_us();
+    auto json = JsonValue::from_string(input);
+    u64 values_from_tree = 0;
+    u64 sum_from_tree = 0;
+    if (json.has_value()) {
+        values_from_tree = count_values(json.value());
+        if (json->is_array()) {
+            json->as_array().for_each([&](const JsonValue& process) {
+                if (process.is_object())
+                    sum_from_tree += process.as_object().get("pid").to_number<u64>();
+            });
+        }
+    }
+    u64 tree_time = now_in_us() - start;
+    bool tree_ok = json.has_value();
+    json.clear();
+
+    start = now_in_us();
+    PidSummer summer;
+    bool stream_ok = JsonStreamParser(input).parse(summer);
+    u64 stream_time = now_in_us() - start;
+
+    start = now_in_us();
+    auto document = JsonDocument::parse(input);
+    u64 values_from_document = 0;
+    u64 sum_from_document = 0;
+    if (document.has_value()) {
+        auto root = document->root();
+        values_from_document = count_values(root);
+        if (root.is_array()) {
+            root.for_each([&](auto process) {
+                if (!process.is_object())
+                    return;
+                if (auto pid = process.get("pid"); pid.has_value() && pid->is_number())
+                    sum_from_document += pid->to_u64().value_or(0);
+            });
+        }
+    }
+    u64 document_time = now_in_us() - start;
+
+    if (tree_ok != stream_ok || tree_ok != document.has_value()) {
+        warnln("FAIL: parsers disagree about whether the input is valid");
+        ++s_failures;
+        return;
+    }
+    if (values_from_tree != summer.values || values_from_tree != values_from_document
+        || sum_from_tree != summer.sum || sum_from_tree != sum_from_document) {
+        warnln("FAIL: values {}/{}/{}, pid sums {}/{}/{}", values_from_tree, summer.values, values_from_document, sum_from_tree, summer.sum, sum_from_document);
+        ++s_failures;
+    }
+
+    outln("{:>10} bytes, {:>9} values: JsonParser {:>8} us, JsonStreamParser {:>8} us, JsonDocument {:>8} us ({} bytes of nodes)",
+        input.length(), values_from_tree, tree_time, stream_time, document_time, document.has_value() ? document->memory_usage() : 0);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1) {
+        auto file_or_error = MappedFile::map(argv[1]);
+        if (file_or_error.is_error()) {
+            warnln("Failed to map {}: {}", argv[1], file_or_error.error());
+            return 1;
+        }
+        auto file = file_or_error.release_value();
+        run({ static_cast<const char*>(file->data()), file->size() });
+    } else {
+        for (size_t count : { 100, 10'000, 200'000 })
+            run(generate_processes(count));
+    }
+
+    if (s_failures)
+        return 1;
+    outln("PASS");
+    return 0;
+}
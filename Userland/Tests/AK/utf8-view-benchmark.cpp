@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Format.h>
+#include <AK/String.h>
+#include <AK/StringBuilder.h>
+#include <AK/Utf8View.h>
+#include <time.h>
+
+// Times validating, measuring and iterating over UTF-8 text that is all ASCII, mostly
+// ASCII (like markup or source code), and mostly not.
+
+static u64 now_in_us()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1'000'000 + ts.tv_nsec / 1'000;
+}
+
+static String repeat(const StringView& text, size_t byte_count)
+{
+    StringBuilder builder;
+    while (builder.length() < byte_count)
+        builder.append(text);
+    return builder.to_string();
+}
+
+static int s_failures;
+
+static void run(const StringView& name, const String& text, size_t iterations)
+{
+    u64 start = now_in_us();
+    bool valid = true;
+    for (size_t i = 0; i < iterations; ++i)
+        valid &= Utf8View(text).validate();
+    u64 validate_time = now_in_us() - start;
+
+    start = now_in_us();
+    size_t length = 0;
+    for (size_t i = 0; i < iterations; ++i)
+        length = Utf8View(text).length();
+    u64 length_time = now_in_us() - start;
+
+    start = now_in_us();
+    size_t code_points = 0;
+    u32 checksum = 0;
+    for (size_t i = 0; i < iterations; ++i) {
+        // Count into locals, so that the loop isn't timing stores to the variables that get printed.
+        size_t count = 0;
+        u32 sum = 0;
+        for (auto code_point : Utf8View(text)) {
+            sum += code_point;
+            ++count;
+        }
+        code_points = count;
+        checksum += sum;
+    }
+    u64 iterate_time = now_in_us() - start;
+
+    if (!valid || code_points != length) {
+        warnln("FAIL: {}: valid={}, length {} but iterated over {} code points", name, valid, length, code_points);
+        ++s_failures;
+    }
+
+    outln("{:>14}: {:>8} bytes x {}: validate {:>7} us, length {:>7} us, iterate {:>7} us (checksum {})",
+        name, text.length(), iterations, validate_time, length_time, iterate_time, checksum);
+}
+
+int main()
+{
+    constexpr size_t size = 1 * MiB;
+    constexpr size_t iterations = 20;
+
+    run("ascii", repeat("The quick brown fox jumps over the lazy dog. ", size), iterations);
+    run("mostly ascii", repeat("<p class=\"greeting\">Grüße, naïve café! — “quoted”</p>\n", size), iterations);
+    run("mostly not", repeat("Привет, мир! γειά σου κόσμος こんにちは世界 😀 ", size), iterations);
+
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,491 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/AnyOf.h>
+#include <AK/Function.h>
+#include <AK/JsonArray.h>
+#include <AK/JsonObject.h>
+#include <AK/Vector.h>
+#include <LibCore/ArgsParser.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+// Microbenchmarks for the kernel's hot paths. Every benchmark prints one line in the same
+// shape (or one JSON object with -j), so runs on two kernels can be compared with diff.
+
+static constexpr size_t page_size = 4096;
+static constexpr size_t stream_chunk_size = 64 * KiB;
+
+struct Result {
+    double value { 0 };
+    const char* unit { "" };
+    u64 iterations { 0 };
+};
+
+struct Benchmark {
+    const char* name;
+    Function<Result(u64 scale_percent)> run;
+};
+
+// Core::ElapsedTimer only has millisecond resolution, which is too coarse for the shorter runs.
+class Stopwatch {
+public:
+    Stopwatch() { m_start = now(); }
+    i64 elapsed_ns() const { return now() - m_start; }
+
+private:
+    static i64 now()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (i64)ts.tv_sec * 1'000'000'000 + ts.tv_nsec;
+    }
+
+    i64 m_start { 0 };
+};
+
+static u64 scaled(u64 iterations, u64 scale_percent)
+{
+    return max<u64>(1, iterations * scale_percent / 100);
+}
+
+static Result nanoseconds_per_operation(u64 iterations, i64 elapsed_ns)
+{
+    return { (double)elapsed_ns / iterations, "ns/op", iterations };
+}
+
+static Result mebibytes_per_second(u64 bytes, i64 elapsed_ns)
+{
+    return { (double)bytes / MiB * 1'000'000'000 / max<i64>(elapsed_ns, 1), "MiB/s", bytes / stream_chunk_size };
+}
+
+[[noreturn]] static void fail(const char* what)
+{
+    perror(what);
+    exit(1);
+}
+
+static void wait_for(pid_t pid)
+{
+    int status;
+    if (waitpid(pid, &status, 0) < 0)
+        fail("waitpid");
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        warnln("child {} did not exit cleanly", pid);
+        exit(1);
+    }
+}
+
+static Result null_syscall(u64 scale_percent)
+{
+    auto iterations = scaled(1'000'000, scale_percent);
+    Stopwatch stopwatch;
+    for (u64 i = 0; i < iterations; ++i)
+        syscall(SC_getuid);
+    return nanoseconds_per_operation(iterations, stopwatch.elapsed_ns());
+}
+
+// Two processes pass one byte back and forth through a pair of pipes, so every
+// round trip blocks and wakes each side once.
+static Result context_switch(u64 scale_percent)
+{
+    auto round_trips = scaled(100'000, scale_percent);
+    int ping[2], pong[2];
+    if (pipe(ping) < 0 || pipe(pong) < 0)
+        fail("pipe");
+
+    pid_t pid = fork();
+    if (pid < 0)
+        fail("fork");
+    if (pid == 0) {
+        char byte;
+        for (u64 i = 0; i < round_trips; ++i) {
+            if (read(ping[0], &byte, 1) != 1 || write(pong[1], &byte, 1) != 1)
+                _exit(1);
+        }
+        _exit(0);
+    }
+
+    Stopwatch stopwatch;
+    char byte = 'x';
+    for (u64 i = 0; i < round_trips; ++i) {
+        if (write(ping[1], &byte, 1) != 1 || read(pong[0], &byte, 1) != 1)
+            fail("ping-pong");
+    }
+    auto elapsed_ns = stopwatch.elapsed_ns();
+    wait_for(pid);
+    for (int fd : { ping[0], ping[1], pong[0], pong[1] })
+        close(fd);
+    return nanoseconds_per_operation(round_trips * 2, elapsed_ns);
+}
+
+static Result thread_create_join(u64 scale_percent)
+{
+    auto iterations = scaled(2'000, scale_percent);
+    Stopwatch stopwatch;
+    for (u64 i = 0; i < iterations; ++i) {
+        pthread_t thread;
+        int rc = pthread_create(
+            &thread, nullptr, [](void*) -> void* { return nullptr; }, nullptr);
+        if (rc != 0) {
+            errno = rc;
+            fail("pthread_create");
+        }
+        pthread_join(thread, nullptr);
+    }
+    return nanoseconds_per_operation(iterations, stopwatch.elapsed_ns());
+}
+
+static Result fork_exec(u64 scale_percent)
+{
+    auto iterations = scaled(200, scale_percent);
+    const char* argv[] = { "/bin/true", nullptr };
+    Stopwatch stopwatch;
+    for (u64 i = 0; i < iterations; ++i) {
+        pid_t pid;
+        int rc = posix_spawn(&pid, argv[0], nullptr, nullptr, const_cast<char**>(argv), environ);
+        if (rc != 0) {
+            errno = rc;
+            fail("posix_spawn");
+        }
+        wait_for(pid);
+    }
+    return nanoseconds_per_operation(iterations, stopwatch.elapsed_ns());
+}
+
+static u8* map_anonymous(size_t size)
+{
+    auto* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0);
+    if (memory == MAP_FAILED)
+        fail("mmap");
+    return (u8*)memory;
+}
+
+static Result zero_page_fault(u64 scale_percent)
+{
+    auto pages = scaled(16'384, scale_percent);
+    auto* memory = map_anonymous(pages * page_size);
+    Stopwatch stopwatch;
+    for (size_t i = 0; i < pages; ++i)
+        memory[i * page_size] = 1;
+    auto elapsed_ns = stopwatch.elapsed_ns();
+    munmap(memory, pages * page_size);
+    return nanoseconds_per_operation(pages, elapsed_ns);
+}
+
+// The child writes to every page it shares with its parent, and sends back how long that took.
+static Result cow_page_fault(u64 scale_percent)
+{
+    auto pages = scaled(16'384, scale_percent);
+    auto* memory = map_anonymous(pages * page_size);
+    memset(memory, 1, pages * page_size);
+
+    int fds[2];
+    if (pipe(fds) < 0)
+        fail("pipe");
+    pid_t pid = fork();
+    if (pid < 0)
+        fail("fork");
+    if (pid == 0) {
+        Stopwatch stopwatch;
+        for (size_t i = 0; i < pages; ++i)
+            memory[i * page_size] = 2;
+        i64 elapsed_ns = stopwatch.elapsed_ns();
+        _exit(write(fds[1], &elapsed_ns, sizeof(elapsed_ns)) == sizeof(elapsed_ns) ? 0 : 1);
+    }
+
+    i64 elapsed_ns = 0;
+    if (read(fds[0], &elapsed_ns, sizeof(elapsed_ns)) != sizeof(elapsed_ns))
+        fail("read");
+    wait_for(pid);
+    close(fds[0]);
+    close(fds[1]);
+    munmap(memory, pages * page_size);
+    return nanoseconds_per_operation(pages, elapsed_ns);
+}
+
+static Result file_page_fault(u64 scale_percent)
+{
+    auto pages = scaled(4'096, scale_percent);
+    char path[] = "/tmp/kernel-bench.XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0)
+        fail("mkstemp");
+    unlink(path);
+
+    u8 page[page_size];
+    memset(page, 1, sizeof(page));
+    for (size_t i = 0; i < pages; ++i) {
+        if (write(fd, page, sizeof(page)) != sizeof(page))
+            fail("write");
+    }
+
+    auto* memory = (volatile u8*)mmap(nullptr, pages * page_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (memory == MAP_FAILED)
+        fail("mmap");
+    Stopwatch stopwatch;
+    u8 sum = 0;
+    for (size_t i = 0; i < pages; ++i)
+        sum += memory[i * page_size];
+    auto elapsed_ns = stopwatch.elapsed_ns();
+    if (sum != (u8)pages)
+        warnln("file mapping read back the wrong contents");
+    munmap((void*)memory, pages * page_size);
+    close(fd);
+    return nanoseconds_per_operation(pages, elapsed_ns);
+}
+
+static Result mmap_munmap(u64 scale_percent)
+{
+    auto iterations = scaled(20'000, scale_percent);
+    constexpr size_t size = 64 * KiB;
+    Stopwatch stopwatch;
+    for (u64 i = 0; i < iterations; ++i) {
+        auto* memory = map_anonymous(size);
+        memory[0] = 1;
+        munmap(memory, size);
+    }
+    return nanoseconds_per_operation(iterations, stopwatch.elapsed_ns());
+}
+
+static void write_stream(int fd, size_t total_size)
+{
+    static u8 chunk[stream_chunk_size];
+    memset(chunk, 'x', sizeof(chunk));
+    for (size_t written = 0; written < total_size;) {
+        auto nwritten = write(fd, chunk, min(sizeof(chunk), total_size - written));
+        if (nwritten <= 0)
+            _exit(1);
+        written += nwritten;
+    }
+}
+
+static size_t read_stream(int fd)
+{
+    static u8 chunk[stream_chunk_size];
+    size_t total_size = 0;
+    for (;;) {
+        auto nread = read(fd, chunk, sizeof(chunk));
+        if (nread < 0)
+            fail("read");
+        if (nread == 0)
+            return total_size;
+        total_size += nread;
+    }
+}
+
+static size_t stream_size(u64 scale_percent)
+{
+    return scaled(256, scale_percent) * MiB;
+}
+
+static Result pipe_throughput(u64 scale_percent)
+{
+    auto total_size = stream_size(scale_percent);
+    int fds[2];
+    if (pipe(fds) < 0)
+        fail("pipe");
+
+    Stopwatch stopwatch;
+    pid_t pid = fork();
+    if (pid < 0)
+        fail("fork");
+    if (pid == 0) {
+        close(fds[0]);
+        write_stream(fds[1], total_size);
+        _exit(0);
+    }
+    close(fds[1]);
+    auto received = read_stream(fds[0]);
+    auto elapsed_ns = stopwatch.elapsed_ns();
+    wait_for(pid);
+    close(fds[0]);
+    if (received != total_size)
+        warnln("pipe delivered {} of {} bytes", received, total_size);
+    return mebibytes_per_second(received, elapsed_ns);
+}
+
+// Runs a writer child that connects to the listening socket with connect_to(), and reads everything it sends.
+static Result socket_throughput(int listen_fd, size_t total_size, Function<int()> connect_to)
+{
+    Stopwatch stopwatch;
+    pid_t pid = fork();
+    if (pid < 0)
+        fail("fork");
+    if (pid == 0) {
+        close(listen_fd);
+        int fd = connect_to();
+        if (fd < 0)
+            _exit(1);
+        write_stream(fd, total_size);
+        _exit(0);
+    }
+
+    int fd = accept(listen_fd, nullptr, nullptr);
+    if (fd < 0)
+        fail("accept");
+    auto received = read_stream(fd);
+    auto elapsed_ns = stopwatch.elapsed_ns();
+    wait_for(pid);
+    close(fd);
+    close(listen_fd);
+    if (received != total_size)
+        warnln("socket delivered {} of {} bytes", received, total_size);
+    return mebibytes_per_second(received, elapsed_ns);
+}
+
+static Result local_socket_throughput(u64 scale_percent)
+{
+    sockaddr_un address {};
+    address.sun_family = AF_LOCAL;
+    snprintf(address.sun_path, sizeof(address.sun_path), "/tmp/kernel-bench.%d.socket", getpid());
+    unlink(address.sun_path);
+
+    int listen_fd = socket(AF_LOCAL, SOCK_STREAM, 0);
+    if (listen_fd < 0)
+        fail("socket");
+    if (bind(listen_fd, (const sockaddr*)&address, sizeof(address)) < 0)
+        fail("bind");
+    if (listen(listen_fd, 1) < 0)
+        fail("listen");
+
+    auto result = socket_throughput(listen_fd, stream_size(scale_percent), [&] {
+        int fd = socket(AF_LOCAL, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, (const sockaddr*)&address, sizeof(address)) < 0)
+            return -1;
+        return fd;
+    });
+    unlink(address.sun_path);
+    return result;
+}
+
+static Result tcp_loopback_throughput(u64 scale_percent)
+{
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd < 0)
+        fail("socket");
+    if (bind(listen_fd, (const sockaddr*)&address, sizeof(address)) < 0)
+        fail("bind");
+    if (listen(listen_fd, 1) < 0)
+        fail("listen");
+    socklen_t address_size = sizeof(address);
+    if (getsockname(listen_fd, (sockaddr*)&address, &address_size) < 0)
+        fail("getsockname");
+
+    return socket_throughput(listen_fd, stream_size(scale_percent), [&] {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, (const sockaddr*)&address, sizeof(address)) < 0)
+            return -1;
+        return fd;
+    });
+}
+
+int main(int argc, char** argv)
+{
+    Vector<Benchmark> benchmarks;
+    benchmarks.append({ "null-syscall", null_syscall });
+    benchmarks.append({ "context-switch", context_switch });
+    benchmarks.append({ "thread-create-join", thread_create_join });
+    benchmarks.append({ "fork-exec", fork_exec });
+    benchmarks.append({ "page-fault-zero", zero_page_fault });
+    benchmarks.append({ "page-fault-cow", cow_page_fault });
+    benchmarks.append({ "page-fault-file", file_page_fault });
+    benchmarks.append({ "mmap-munmap", mmap_munmap });
+    benchmarks.append({ "pipe-throughput", pipe_throughput });
+    benchmarks.append({ "local-socket-throughput", local_socket_throughput });
+    benchmarks.append({ "tcp-loopback-throughput", tcp_loopback_throughput });
+
+    bool output_json = false;
+    bool list_only = false;
+    int scale_percent = 100;
+    Vector<const char*> selected_names;
+
+    Core::ArgsParser args_parser;
+    args_parser.set_general_help("Run microbenchmarks of the kernel's hot paths.");
+    args_parser.add_option(output_json, "Print the results as JSON", "json", 'j');
+    args_parser.add_option(list_only, "List the benchmarks and exit", "list", 'l');
+    args_parser.add_option(scale_percent, "Scale the iteration counts, in percent (default 100)", "scale", 's', "percent");
+    args_parser.add_positional_argument(selected_names, "Benchmarks to run (default: all)", "benchmarks", Core::ArgsParser::Required::No);
+    args_parser.parse(argc, argv);
+
+    if (scale_percent <= 0) {
+        warnln("The scale must be positive");
+        return 1;
+    }
+
+    for (auto* name : selected_names) {
+        if (!any_of(benchmarks.begin(), benchmarks.end(), [&](auto& benchmark) { return !strcmp(benchmark.name, name); })) {
+            warnln("Unknown benchmark '{}', try --list", name);
+            return 1;
+        }
+    }
+
+    if (list_only) {
+        for (auto& benchmark : benchmarks)
+            outln("{}", benchmark.name);
+        return 0;
+    }
+
+    JsonArray results;
+    for (auto& benchmark : benchmarks) {
+        if (!selected_names.is_empty() && !any_of(selected_names.begin(), selected_names.end(), [&](auto* name) { return !strcmp(benchmark.name, name); }))
+            continue;
+
+        auto result = benchmark.run(scale_percent);
+        if (output_json) {
+            JsonObject object;
+            object.set("name", benchmark.name);
+            object.set("value", result.value);
+            object.set("unit", result.unit);
+            object.set("iterations", result.iterations);
+            results.append(move(object));
+        } else {
+            outln("{:<24} {:>12.1} {:<6} ({} iterations)", benchmark.name, result.value, result.unit, result.iterations);
+        }
+    }
+
+    if (output_json)
+        outln("{}", results.to_string());
+    return 0;
+}
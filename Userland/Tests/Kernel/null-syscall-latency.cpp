@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Format.h>
+#include <LibCore/ElapsedTimer.h>
+#include <stdlib.h>
+#include <syscall.h>
+
+// Measures the round-trip latency of a syscall that does (almost) no work in the kernel.
+// libsystem uses SYSENTER when the CPU supports it and falls back to `int 0x82` otherwise.
+
+static bool cpu_has_sep()
+{
+    u32 eax, ebx, ecx, edx;
+    asm volatile("cpuid"
+                 : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+                 : "a"(1), "c"(0));
+    return edx & (1 << 11);
+}
+
+static void report(const char* name, int iterations, i64 elapsed_ms)
+{
+    outln("{}: {} calls in {} ms, {} ns/call", name, iterations, elapsed_ms, elapsed_ms * 1'000'000 / iterations);
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = 1'000'000;
+    if (argc > 1)
+        iterations = atoi(argv[1]);
+    if (iterations <= 0) {
+        warnln("usage: {} [iterations]", argv[0]);
+        return 1;
+    }
+
+    outln("CPU {} SYSENTER", cpu_has_sep() ? "supports" : "does not support");
+
+    Core::ElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; ++i)
+        syscall(SC_getuid);
+    report("getuid", iterations, timer.elapsed());
+
+    return 0;
+}
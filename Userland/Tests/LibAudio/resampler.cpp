@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Format.h>
+#include <AK/Vector.h>
+#include <LibAudio/Buffer.h>
+#include <math.h>
+
+// Resamples sine waves between common rates, and checks that they come out as the same
+// sine wave at the new rate, and that frequencies above the new Nyquist frequency are removed.
+
+static Vector<double> resample(double source_rate, double target_rate, double frequency, size_t input_count)
+{
+    Audio::ResampleHelper resampler(source_rate, target_rate);
+    Vector<double> output;
+    double l = 0;
+    double r = 0;
+    for (size_t i = 0; i < input_count; ++i) {
+        while (resampler.read_sample(l, r))
+            output.append(l);
+        double sample = sin(2 * M_PI * frequency * i / source_rate);
+        resampler.process_sample(sample, sample);
+    }
+    while (resampler.read_sample(l, r))
+        output.append(l);
+    return output;
+}
+
+// The largest difference from a sine wave of the given frequency, ignoring the start where
+// the filter still sees silence.
+static double max_error(const Vector<double>& output, double rate, double frequency)
+{
+    double error = 0;
+    for (size_t i = 64; i < output.size(); ++i) {
+        double expected = sin(2 * M_PI * frequency * i / rate);
+        error = max(error, fabs(output[i] - expected));
+    }
+    return error;
+}
+
+static double peak(const Vector<double>& output)
+{
+    double peak = 0;
+    for (size_t i = 64; i < output.size(); ++i)
+        peak = max(peak, fabs(output[i]));
+    return peak;
+}
+
+static int s_failures;
+
+static void expect(bool condition, const char* description)
+{
+    if (!condition) {
+        warnln("FAIL: {}", description);
+        ++s_failures;
+    }
+}
+
+int main()
+{
+    auto same_rate = resample(44100, 44100, 1000, 4410);
+    expect(same_rate.size() == 4410, "The same rate gives one output sample per input sample");
+    expect(max_error(same_rate, 44100, 1000) < 1e-12, "The same rate passes samples through unchanged");
+
+    // The last few output samples can't be produced, as the filter would need input past the end.
+    for (double source_rate : { 8000.0, 22050.0, 48000.0, 96000.0 }) {
+        auto output = resample(source_rate, 44100, 440, (size_t)source_rate);
+        double error = max_error(output, 44100, 440);
+        double missing_output_count = 16 * 44100 / source_rate;
+        outln("{} Hz -> 44100 Hz: {} samples, max error {}", source_rate, output.size(), error);
+        expect(fabs((double)output.size() + missing_output_count - 44100) <= 1, "Resampling a second of audio gives about a second of audio");
+        expect(error < 0.01, "A 440 Hz tone stays the same");
+    }
+
+    // 30 kHz can be represented at 96 kHz, but not at 44.1 kHz.
+    auto aliased = resample(96000, 44100, 30000, 96000);
+    outln("30 kHz tone from 96000 Hz -> 44100 Hz: peak {}", peak(aliased));
+    expect(peak(aliased) < 0.01, "Frequencies above the new Nyquist frequency are filtered out");
+
+    return s_failures ? 1 : 0;
+}
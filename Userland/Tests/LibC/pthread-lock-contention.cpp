@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Format.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Hammers a pthread mutex, a condition variable and a rwlock from several threads,
+// checking that nothing got lost and printing how long each took.
+
+const int NUM_THREADS = 4;
+const int NUM_ITERATIONS = 100000;
+
+static pthread_mutex_t s_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_cond = PTHREAD_COND_INITIALIZER;
+static pthread_rwlock_t s_rwlock = PTHREAD_RWLOCK_INITIALIZER;
+static u64 s_counter;
+static int s_ready_threads;
+static int s_generation;
+
+static u64 now_in_us()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1'000'000 + ts.tv_nsec / 1'000;
+}
+
+static void* mutex_worker(void*)
+{
+    for (int i = 0; i < NUM_ITERATIONS; ++i) {
+        pthread_mutex_lock(&s_mutex);
+        ++s_counter;
+        pthread_mutex_unlock(&s_mutex);
+    }
+    return nullptr;
+}
+
+static void* broadcast_waiter(void*)
+{
+    for (int round = 0; round < NUM_ITERATIONS / 100; ++round) {
+        pthread_mutex_lock(&s_mutex);
+        int generation = s_generation;
+        ++s_ready_threads;
+        while (generation == s_generation)
+            pthread_cond_wait(&s_cond, &s_mutex);
+        ++s_counter;
+        pthread_mutex_unlock(&s_mutex);
+    }
+    return nullptr;
+}
+
+static void* rwlock_worker(void*)
+{
+    for (int i = 0; i < NUM_ITERATIONS; ++i) {
+        // One write for every sixteen reads.
+        if (i % 16 == 0) {
+            pthread_rwlock_wrlock(&s_rwlock);
+            ++s_counter;
+            pthread_rwlock_unlock(&s_rwlock);
+        } else {
+            pthread_rwlock_rdlock(&s_rwlock);
+            [[maybe_unused]] volatile u64 value = s_counter;
+            pthread_rwlock_unlock(&s_rwlock);
+        }
+    }
+    return nullptr;
+}
+
+static bool run(const char* name, void* (*worker)(void*), u64 expected_count, void (*driver)() = nullptr)
+{
+    s_counter = 0;
+    pthread_t threads[NUM_THREADS];
+    auto start = now_in_us();
+    for (auto& thread : threads) {
+        if (pthread_create(&thread, nullptr, worker, nullptr) != 0) {
+            perror("pthread_create");
+            exit(1);
+        }
+    }
+    if (driver)
+        driver();
+    for (auto& thread : threads)
+        pthread_join(thread, nullptr);
+    auto elapsed = now_in_us() - start;
+
+    if (s_counter != expected_count) {
+        warnln("FAIL: {}: counter is {}, expected {}", name, s_counter, expected_count);
+        return false;
+    }
+    outln("{}: {} threads took {} ms", name, NUM_THREADS, elapsed / 1000);
+    return true;
+}
+
+static void broadcast_driver()
+{
+    for (int round = 0; round < NUM_ITERATIONS / 100; ++round) {
+        pthread_mutex_lock(&s_mutex);
+        while (s_ready_threads < NUM_THREADS) {
+            pthread_mutex_unlock(&s_mutex);
+            sched_yield();
+            pthread_mutex_lock(&s_mutex);
+        }
+        s_ready_threads = 0;
+        ++s_generation;
+        pthread_cond_broadcast(&s_cond);
+        pthread_mutex_unlock(&s_mutex);
+    }
+}
+
+int main()
+{
+    bool ok = true;
+    ok &= run("mutex", mutex_worker, (u64)NUM_THREADS * NUM_ITERATIONS);
+    ok &= run("cond broadcast", broadcast_waiter, (u64)NUM_THREADS * (NUM_ITERATIONS / 100), broadcast_driver);
+    ok &= run("rwlock", rwlock_worker, (u64)NUM_THREADS * ((NUM_ITERATIONS + 15) / 16));
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Format.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Checks memcpy, memset, strlen and memchr against simple byte loops for a range of
+// sizes and misalignments, and prints how fast each of them is.
+
+static constexpr size_t sizes[] = { 8, 16, 32, 64, 128, 256, 1024, 4096, 65536, 1048576, 4194304 };
+static constexpr size_t misalignments[] = { 0, 1, 7, 15 };
+static constexpr size_t bytes_per_measurement = 64 * 1048576;
+static constexpr size_t guard_size = 64;
+
+static u8* s_source;
+static u8* s_destination;
+static int s_failures;
+
+static u64 now_in_us()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1'000'000 + ts.tv_nsec / 1'000;
+}
+
+static void fail(const char* function, size_t size, size_t misalignment)
+{
+    warnln("FAIL: {} with size {} at misalignment {}", function, size, misalignment);
+    ++s_failures;
+}
+
+template<typename Callback>
+static void measure(const char* function, size_t size, size_t misalignment, Callback callback)
+{
+    size_t iterations = max(bytes_per_measurement / size, (size_t)1);
+    u64 start = now_in_us();
+    for (size_t i = 0; i < iterations; ++i)
+        callback();
+    u64 elapsed = max(now_in_us() - start, (u64)1);
+    outln("{:>7} {:>8} +{:<2} {:>8} MB/s", function, size, misalignment, (u64)size * iterations / elapsed);
+}
+
+static void test_memcpy(size_t size, size_t misalignment)
+{
+    u8* source = s_source + guard_size + misalignment;
+    u8* destination = s_destination + guard_size + (misalignment * 3) % 16;
+    for (size_t i = 0; i < size + 2 * guard_size; ++i) {
+        s_source[i] = (u8)(i * 7 + 1);
+        s_destination[i] = 0xaa;
+    }
+    memcpy(destination, source, size);
+    for (size_t i = 0; i < size; ++i) {
+        if (destination[i] != source[i])
+            return fail("memcpy", size, misalignment);
+    }
+    if (destination[-1] != 0xaa || destination[size] != 0xaa)
+        return fail("memcpy", size, misalignment);
+    measure("memcpy", size, misalignment, [&] {
+        memcpy(destination, source, size);
+        asm volatile("" ::
+                         : "memory");
+    });
+}
+
+static void test_memset(size_t size, size_t misalignment)
+{
+    u8* destination = s_destination + guard_size + misalignment;
+    memset(s_destination, 0xaa, size + 2 * guard_size);
+    memset(destination, 0x5c, size);
+    for (size_t i = 0; i < size; ++i) {
+        if (destination[i] != 0x5c)
+            return fail("memset", size, misalignment);
+    }
+    if (destination[-1] != 0xaa || destination[size] != 0xaa)
+        return fail("memset", size, misalignment);
+    measure("memset", size, misalignment, [&] {
+        memset(destination, 0x5c, size);
+        asm volatile("" ::
+                         : "memory");
+    });
+}
+
+static void test_strlen(size_t size, size_t misalignment)
+{
+    char* string = (char*)s_source + guard_size + misalignment;
+    memset(s_source, 'x', size + 2 * guard_size);
+    string[size] = '\0';
+    if (strlen(string) != size)
+        return fail("strlen", size, misalignment);
+    measure("strlen", size, misalignment, [&] {
+        size_t length = strlen(string);
+        asm volatile("" ::"r"(length)
+                     : "memory");
+    });
+}
+
+static void test_memchr(size_t size, size_t misalignment)
+{
+    u8* haystack = s_source + guard_size + misalignment;
+    memset(s_source, 'x', size + 2 * guard_size);
+    // A match right before and right after the range must not be found.
+    haystack[-1] = 'y';
+    haystack[size] = 'y';
+    if (memchr(haystack, 'y', size))
+        return fail("memchr", size, misalignment);
+    haystack[size - 1] = 'y';
+    if (memchr(haystack, 'y', size) != haystack + size - 1)
+        return fail("memchr", size, misalignment);
+    measure("memchr", size, misalignment, [&] {
+        void* match = memchr(haystack, 'y', size);
+        asm volatile("" ::"r"(match)
+                     : "memory");
+    });
+}
+
+int main()
+{
+    size_t buffer_size = sizes[array_size(sizes) - 1] + 4 * guard_size;
+    s_source = (u8*)malloc(buffer_size);
+    s_destination = (u8*)malloc(buffer_size);
+    if (!s_source || !s_destination) {
+        warnln("Failed to allocate buffers");
+        return 1;
+    }
+
+    for (auto size : sizes) {
+        for (auto misalignment : misalignments) {
+            test_memcpy(size, misalignment);
+            test_memset(size, misalignment);
+            test_strlen(size, misalignment);
+            test_memchr(size, misalignment);
+        }
+    }
+
+    free(s_source);
+    free(s_destination);
+
+    if (s_failures) {
+        warnln("{} checks failed", s_failures);
+        return 1;
+    }
+    outln("PASS");
+    return 0;
+}
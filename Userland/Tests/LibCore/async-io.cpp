@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/ByteBuffer.h>
+#include <AK/Format.h>
+#include <LibCore/Async.h>
+#include <LibCore/EventLoop.h>
+#include <LibCore/File.h>
+#include <LibCore/TCPServer.h>
+#include <LibCore/TCPSocket.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+// Streams data through a pipe and a TCP connection with Core::Task coroutines, checks that it
+// arrives intact, and reports how long that takes.
+
+static u64 now_in_us()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1'000'000 + ts.tv_nsec / 1'000;
+}
+
+static int s_failures;
+
+static void fail(const char* message)
+{
+    warnln("FAIL: {}", message);
+    ++s_failures;
+}
+
+static ByteBuffer make_test_data(size_t size)
+{
+    auto data = ByteBuffer::create_uninitialized(size);
+    for (size_t i = 0; i < size; ++i)
+        data[i] = (u8)(i * 7 + (i >> 11));
+    return data;
+}
+
+static Core::Task<size_t> receive_and_check(Core::IODevice& device, ReadonlyBytes expected)
+{
+    u8 chunk[4096];
+    size_t received = 0;
+    for (;;) {
+        int nread = co_await Core::async_read(device, { chunk, sizeof(chunk) });
+        if (nread < 0) {
+            fail("read failed");
+            break;
+        }
+        if (!nread)
+            break;
+        if (received + nread > expected.size() || memcmp(chunk, expected.offset(received), nread))
+            fail("received the wrong data");
+        received += nread;
+    }
+    co_return received;
+}
+
+static Core::Task<> send_and_close(Core::IODevice& device, ReadonlyBytes data)
+{
+    bool sent = co_await Core::async_write_all(device, data);
+    if (!sent)
+        fail("write failed");
+    device.close();
+}
+
+static void stream_through_pipe(Core::EventLoop& loop)
+{
+    int fds[2];
+    if (pipe2(fds, O_NONBLOCK) < 0) {
+        fail("pipe2 failed");
+        return;
+    }
+    auto reader = Core::File::construct();
+    reader->open(fds[0], Core::IODevice::ReadOnly, Core::File::ShouldCloseFileDescriptor::Yes);
+    auto writer = Core::File::construct();
+    writer->open(fds[1], Core::IODevice::WriteOnly, Core::File::ShouldCloseFileDescriptor::Yes);
+
+    auto data = make_test_data(8 * MiB);
+    Optional<size_t> received;
+
+    u64 start = now_in_us();
+    receive_and_check(reader, data).start([&](size_t& size) { received = size; });
+    send_and_close(writer, data).start();
+    while (!received.has_value())
+        loop.pump();
+    u64 elapsed = now_in_us() - start;
+
+    if (received.value() != data.size())
+        fail("pipe lost data");
+    outln("{} KiB through a pipe: {} us", data.size() / KiB, elapsed);
+}
+
+static Core::Task<> connect_and_send(Core::TCPSocket& socket, u16 port, ReadonlyBytes data)
+{
+    bool connected = co_await Core::async_connect(socket, IPv4Address(127, 0, 0, 1), port);
+    if (!connected) {
+        fail("connect failed");
+        co_return;
+    }
+    co_await send_and_close(socket, data);
+}
+
+static void stream_through_tcp(Core::EventLoop& loop)
+{
+    auto server = Core::TCPServer::construct();
+    if (!server->listen(IPv4Address(127, 0, 0, 1), 0)) {
+        fail("listen failed");
+        return;
+    }
+
+    auto data = make_test_data(8 * MiB);
+    Optional<size_t> received;
+    RefPtr<Core::TCPSocket> accepted;
+    server->on_ready_to_accept = [&] {
+        accepted = server->accept();
+        receive_and_check(*accepted, data).start([&](size_t& size) { received = size; });
+    };
+
+    u64 start = now_in_us();
+    auto client = Core::TCPSocket::construct();
+    connect_and_send(client, server->local_port().value(), data).start();
+    while (!received.has_value())
+        loop.pump();
+    u64 elapsed = now_in_us() - start;
+
+    if (received.value() != data.size())
+        fail("TCP connection lost data");
+    outln("{} KiB through a TCP connection: {} us", data.size() / KiB, elapsed);
+}
+
+static Core::Task<int> sleep_and_count(int milliseconds, int& counter)
+{
+    co_await Core::async_sleep(milliseconds);
+    co_return ++counter;
+}
+
+static Core::Task<> sleeps_wake_in_order(bool& done)
+{
+    int counter = 0;
+    u64 start = now_in_us();
+    int first = co_await sleep_and_count(20, counter);
+    int second = co_await sleep_and_count(10, counter);
+    if (first != 1 || second != 2)
+        fail("sleeps resumed out of order");
+    if (now_in_us() - start < 30'000)
+        fail("sleeps were too short");
+    done = true;
+}
+
+int main()
+{
+    Core::EventLoop loop;
+
+    bool sleeps_done = false;
+    sleeps_wake_in_order(sleeps_done).start();
+    while (!sleeps_done)
+        loop.pump();
+
+    stream_through_pipe(loop);
+    stream_through_tcp(loop);
+
+    if (!s_failures)
+        outln("PASS");
+    return s_failures ? 1 : 0;
+}
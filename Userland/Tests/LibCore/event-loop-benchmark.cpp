@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Format.h>
+#include <AK/Vector.h>
+#include <LibCore/Event.h>
+#include <LibCore/EventLoop.h>
+#include <LibCore/Timer.h>
+#include <LibThread/Thread.h>
+#include <time.h>
+
+// Runs an event loop with many idle timers, checks that timers fire in the right order and that
+// events posted from another thread arrive in order, and reports how long all of that takes.
+
+static u64 now_in_us()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1'000'000 + ts.tv_nsec / 1'000;
+}
+
+class Receiver final : public Core::Object {
+    C_OBJECT(Receiver);
+};
+
+static int s_failures;
+
+static void fail(const char* message)
+{
+    warnln("FAIL: {}", message);
+    ++s_failures;
+}
+
+static void timers_fire_in_order(Core::EventLoop& loop)
+{
+    NonnullRefPtrVector<Core::Timer> timers;
+    Vector<int> fired;
+    // Registered in reverse, so that the order they fire in has nothing to do with the order they were created in.
+    for (int interval = 50; interval > 0; interval -= 5)
+        timers.append(Core::Timer::create_single_shot(interval, [&fired, interval] { fired.append(interval); }));
+    for (auto& timer : timers)
+        timer.start();
+
+    auto stopped_timer = Core::Timer::create_single_shot(10, [] { fail("stopped timer fired"); });
+    stopped_timer->start();
+    stopped_timer->stop();
+
+    while (fired.size() < timers.size())
+        loop.pump();
+
+    for (size_t i = 1; i < fired.size(); ++i) {
+        if (fired[i - 1] > fired[i])
+            fail("timers fired out of order");
+    }
+}
+
+static void pump_with_idle_timers(Core::EventLoop& loop, int idle_timer_count)
+{
+    NonnullRefPtrVector<Core::Timer> idle_timers;
+    for (int i = 0; i < idle_timer_count; ++i) {
+        idle_timers.append(Core::Timer::construct(60'000 + i, [] { fail("idle timer fired"); }));
+    }
+
+    static constexpr int tick_count = 1000;
+    int ticks = 0;
+    auto ticker = Core::Timer::construct(0, [&] { ++ticks; });
+
+    u64 start = now_in_us();
+    while (ticks < tick_count)
+        loop.pump();
+    u64 elapsed = now_in_us() - start;
+    ticker->stop();
+
+    outln("{:>5} idle timers: {:>8} ns per tick", idle_timer_count, elapsed * 1000 / tick_count);
+}
+
+static void events_from_another_thread_arrive_in_order(Core::EventLoop& loop)
+{
+    static constexpr int event_count = 10'000;
+    auto receiver = Receiver::construct();
+    int received = 0;
+    u64 total_latency = 0;
+
+    auto thread = LibThread::Thread::construct([&] {
+        for (int i = 0; i < event_count; ++i) {
+            u64 posted_at = now_in_us();
+            loop.post_event(*receiver, make<Core::DeferredInvocationEvent>([&, i, posted_at](auto&) {
+                total_latency += now_in_us() - posted_at;
+                if (received != i)
+                    fail("events from another thread arrived out of order");
+                ++received;
+            }));
+            if (i % 100 == 0)
+                Core::EventLoop::wake();
+        }
+        Core::EventLoop::wake();
+        return 0;
+    });
+    thread->start();
+
+    while (received < event_count)
+        loop.pump();
+    (void)thread->join();
+
+    outln("{} events from another thread: {} us average latency", event_count, total_latency / event_count);
+}
+
+int main()
+{
+    Core::EventLoop loop;
+
+    timers_fire_in_order(loop);
+    for (int idle_timer_count : { 0, 100, 1000, 10000 })
+        pump_with_idle_timers(loop, idle_timer_count);
+    events_from_another_thread_arrive_in_order(loop);
+
+    if (!s_failures)
+        outln("PASS");
+    return s_failures ? 1 : 0;
+}
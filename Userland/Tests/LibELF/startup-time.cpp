@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Format.h>
+#include <AK/NumericLimits.h>
+#include <AK/Vector.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// Measures how long it takes from exec() to the point where main() would be called,
+// i.e. mapping, relocating and initializing all libraries. The dynamic loader exits
+// right before the entry point when _LOADER_EXIT_BEFORE_ENTRY=1 is set, so no windows
+// actually open. Each program is timed with lazy PLT binding and with LD_BIND_NOW=1.
+
+static const char* s_default_programs[] = {
+    "/bin/Browser",
+    "/bin/HackStudio",
+    "/bin/Spreadsheet",
+    "/bin/PixelPaint",
+    "/bin/FileManager",
+    "/bin/TextEditor",
+};
+
+static u64 now_in_us()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1'000'000 + ts.tv_nsec / 1'000;
+}
+
+static bool spawn_until_entry(const char* path, bool bind_now)
+{
+    Vector<char*> envp;
+    for (char** env = environ; *env; ++env)
+        envp.append(*env);
+    envp.append(const_cast<char*>("_LOADER_EXIT_BEFORE_ENTRY=1"));
+    if (bind_now)
+        envp.append(const_cast<char*>("LD_BIND_NOW=1"));
+    envp.append(nullptr);
+
+    char* argv[] = { const_cast<char*>(path), nullptr };
+    pid_t pid;
+    if (int rc = posix_spawn(&pid, path, nullptr, nullptr, argv, envp.data()); rc != 0) {
+        warnln("posix_spawn {}: {}", path, strerror(rc));
+        return false;
+    }
+    int status;
+    if (waitpid(pid, &status, 0) < 0) {
+        perror("waitpid");
+        return false;
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        warnln("{} didn't make it to its entry point", path);
+        return false;
+    }
+    return true;
+}
+
+static bool run(const char* path, bool bind_now, int iterations)
+{
+    // The first launch pulls everything into the page cache, don't count it.
+    if (!spawn_until_entry(path, bind_now))
+        return false;
+
+    u64 total = 0;
+    u64 fastest = NumericLimits<u64>::max();
+    for (int i = 0; i < iterations; ++i) {
+        auto start = now_in_us();
+        if (!spawn_until_entry(path, bind_now))
+            return false;
+        auto elapsed = now_in_us() - start;
+        total += elapsed;
+        fastest = min(fastest, elapsed);
+    }
+    outln("{} ({}): average {} us, fastest {} us", path, bind_now ? "bind now" : "lazy", total / iterations, fastest);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = 10;
+    if (argc > 1)
+        iterations = atoi(argv[1]);
+    if (iterations <= 0) {
+        warnln("usage: {} [iterations] [program...]", argv[0]);
+        return 1;
+    }
+
+    Vector<const char*> programs;
+    for (int i = 2; i < argc; ++i)
+        programs.append(argv[i]);
+    if (programs.is_empty()) {
+        for (auto* program : s_default_programs)
+            programs.append(program);
+    }
+
+    bool ok = true;
+    for (auto* program : programs) {
+        ok &= run(program, false, iterations);
+        ok &= run(program, true, iterations);
+    }
+    return ok ? 0 : 1;
+}
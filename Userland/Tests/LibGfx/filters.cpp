@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/String.h>
+#include <AK/Vector.h>
+#include <LibCore/ElapsedTimer.h>
+#include <LibGfx/Bitmap.h>
+#include <LibGfx/CPUFeatures.h>
+#include <LibGfx/Filters/BoxBlurFilter.h>
+#include <LibGfx/Filters/GenericConvolutionFilter.h>
+#include <LibGfx/Filters/SeparableBlur.h>
+#include <LibGfx/Filters/SpatialGaussianBlurFilter.h>
+#include <LibGfx/JPGLoader.h>
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Checks the separable blurs against convolving with the whole 2D kernel, and then times them.
+
+static NonnullRefPtr<Gfx::Bitmap> load_photo()
+{
+    auto bitmap = Gfx::load_jpg("/res/html/misc/jpgsuite_files/non-subsampled-lena.jpg");
+    assert(bitmap);
+    return bitmap.release_nonnull();
+}
+
+static NonnullRefPtr<Gfx::Bitmap> create_target(const Gfx::Bitmap& source)
+{
+    auto bitmap = Gfx::Bitmap::create(source.format(), source.size());
+    assert(bitmap);
+    return bitmap.release_nonnull();
+}
+
+// The largest difference of any color channel, ignoring `border` pixels along the edges
+// (where the 2D convolution leaves out the pixels outside the image instead of repeating the edge.)
+static int max_difference(const Gfx::Bitmap& a, const Gfx::Bitmap& b, int border)
+{
+    assert(a.size() == b.size());
+    int difference = 0;
+    for (int y = border; y < a.height() - border; ++y) {
+        for (int x = border; x < a.width() - border; ++x) {
+            auto color_a = a.get_pixel(x, y);
+            auto color_b = b.get_pixel(x, y);
+            difference = max(difference, abs(color_a.red() - color_b.red()));
+            difference = max(difference, abs(color_a.green() - color_b.green()));
+            difference = max(difference, abs(color_a.blue() - color_b.blue()));
+            assert(color_a.alpha() == color_b.alpha());
+        }
+    }
+    return difference;
+}
+
+// The average difference of all color channels, in the 0-255 range.
+static float mean_difference(const Gfx::Bitmap& a, const Gfx::Bitmap& b)
+{
+    assert(a.size() == b.size());
+    u64 total = 0;
+    for (int y = 0; y < a.height(); ++y) {
+        for (int x = 0; x < a.width(); ++x) {
+            auto color_a = a.get_pixel(x, y);
+            auto color_b = b.get_pixel(x, y);
+            total += abs(color_a.red() - color_b.red()) + abs(color_a.green() - color_b.green()) + abs(color_a.blue() - color_b.blue());
+        }
+    }
+    return (float)total / (a.width() * a.height() * 3);
+}
+
+template<size_t N>
+static Gfx::Matrix<N, float> gaussian_kernel(float sigma)
+{
+    constexpr ssize_t offset = N / 2;
+    Gfx::Matrix<N, float> kernel;
+    for (ssize_t x = -offset; x <= offset; ++x) {
+        for (ssize_t y = -offset; y <= offset; ++y)
+            kernel.elements()[x + offset][y + offset] = expf(-(x * x + y * y) / (2 * sigma * sigma));
+    }
+    Gfx::normalize(kernel);
+    return kernel;
+}
+
+static void test_box_blur_matches_convolution()
+{
+    auto source = load_photo();
+    Gfx::Matrix<5, float> kernel;
+    for (size_t i = 0; i < 5; ++i) {
+        for (size_t j = 0; j < 5; ++j)
+            kernel.elements()[i][j] = 1;
+    }
+    Gfx::normalize(kernel);
+
+    auto expected = create_target(source);
+    Gfx::GenericConvolutionFilter<5>().apply(*expected, source->rect(), *source, source->rect(), Gfx::GenericConvolutionFilter<5>::Parameters(kernel));
+    auto blurred = create_target(source);
+    Gfx::BoxBlurFilter<5>().apply(*blurred, source->rect(), *source, source->rect(), Gfx::GenericConvolutionFilter<5>::Parameters(kernel));
+    assert(max_difference(*expected, *blurred, 2) <= 1);
+}
+
+static void test_gaussian_blur_matches_convolution()
+{
+    auto source = load_photo();
+    Gfx::GenericConvolutionFilter<5>::Parameters parameters(gaussian_kernel<5>(1.0f));
+
+    auto expected = create_target(source);
+    Gfx::GenericConvolutionFilter<5>().apply(*expected, source->rect(), *source, source->rect(), parameters);
+    auto blurred = create_target(source);
+    Gfx::SpatialGaussianBlurFilter<5>().apply(*blurred, source->rect(), *source, source->rect(), parameters);
+    assert(max_difference(*expected, *blurred, 2) <= 1);
+
+    // Blurring part of a bitmap in place leaves the rest alone.
+    auto in_place = load_photo();
+    Gfx::IntRect rect { 100, 50, 200, 300 };
+    Gfx::SpatialGaussianBlurFilter<5>().apply(*in_place, rect, *in_place, in_place->rect(), parameters);
+    for (int y = 0; y < source->height(); ++y) {
+        for (int x = 0; x < source->width(); ++x) {
+            auto& expected_bitmap = rect.contains(x, y) ? *blurred : *source;
+            assert(in_place->get_pixel(x, y) == expected_bitmap.get_pixel(x, y));
+        }
+    }
+}
+
+static void test_three_box_blurs_approximate_gaussian()
+{
+    auto source = load_photo();
+    for (float sigma : { 2.0f, 5.0f, 12.0f }) {
+        int radius = ceilf(3 * sigma);
+        Vector<float> kernel;
+        float sum = 0;
+        for (int i = -radius; i <= radius; ++i) {
+            kernel.append(expf(-(i * i) / (2 * sigma * sigma)));
+            sum += kernel.last();
+        }
+        for (auto& weight : kernel)
+            weight /= sum;
+
+        auto expected = create_target(source);
+        Gfx::separable_convolution(*expected, source->rect(), *source, source->rect(), kernel, kernel);
+        auto approximated = create_target(source);
+        Gfx::gaussian_blur(*approximated, source->rect(), *source, source->rect(), sigma);
+        assert(mean_difference(*expected, *approximated) < 0.5f);
+    }
+}
+
+static void test_scalar_and_vectorized_blurs_match()
+{
+    auto source = load_photo();
+    auto blur = [&](auto& target) {
+        Gfx::box_blur(target, source->rect(), *source, source->rect(), 3);
+        Gfx::gaussian_blur(target, source->rect(), target, source->rect(), 1.5f, true);
+        Gfx::gaussian_blur(target, source->rect(), target, source->rect(), 4.0f);
+    };
+    auto vectorized = create_target(source);
+    blur(*vectorized);
+    Gfx::set_hardware_acceleration_enabled(false);
+    auto scalar = create_target(source);
+    blur(*scalar);
+    Gfx::set_hardware_acceleration_enabled(true);
+    assert(max_difference(*vectorized, *scalar, 0) == 0);
+}
+
+template<typename Callback>
+static void benchmark(const char* name, Callback callback)
+{
+    constexpr int iterations = 10;
+    Core::ElapsedTimer timer(true);
+    timer.start();
+    for (int i = 0; i < iterations; ++i)
+        callback();
+    printf("%-36s %6.2f ms\n", name, (float)timer.elapsed() / iterations);
+}
+
+static void run_benchmarks()
+{
+    auto source = Gfx::Bitmap::create(Gfx::BitmapFormat::RGBA32, { 1024, 768 });
+    assert(source);
+    auto photo = load_photo();
+    for (int y = 0; y < source->height(); ++y) {
+        for (int x = 0; x < source->width(); ++x)
+            source->set_pixel(x, y, photo->get_pixel(x % photo->width(), y % photo->height()));
+    }
+    auto target = create_target(*source);
+    auto rect = source->rect();
+
+    Gfx::GenericConvolutionFilter<5>::Parameters parameters(gaussian_kernel<5>(1.0f));
+    benchmark("5x5 convolution 1024x768", [&] { Gfx::GenericConvolutionFilter<5>().apply(*target, rect, *source, rect, parameters); });
+    benchmark("5x5 gaussian 1024x768", [&] { Gfx::SpatialGaussianBlurFilter<5>().apply(*target, rect, *source, rect, parameters); });
+    benchmark("box radius 2 1024x768", [&] { Gfx::box_blur(*target, rect, *source, rect, 2); });
+    benchmark("box radius 20 1024x768", [&] { Gfx::box_blur(*target, rect, *source, rect, 20); });
+    benchmark("gaussian sigma 10 1024x768", [&] { Gfx::gaussian_blur(*target, rect, *source, rect, 10); });
+}
+
+int main(int, char**)
+{
+#define RUNTEST(x)                      \
+    {                                   \
+        printf("Running " #x " ...\n"); \
+        x();                            \
+        printf("Success!\n");           \
+    }
+    RUNTEST(test_box_blur_matches_convolution);
+    RUNTEST(test_gaussian_blur_matches_convolution);
+    RUNTEST(test_three_box_blurs_approximate_gaussian);
+    RUNTEST(test_scalar_and_vectorized_blurs_match);
+    printf("PASS\n");
+
+    run_benchmarks();
+
+    return 0;
+}
@@ -26,6 +26,8 @@
 
 #include <LibGfx/BitmapFont.h>
 #include <LibGfx/FontDatabase.h>
+#include <LibTTF/Font.h>
+#include <LibTTF/GlyphAtlas.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -185,6 +187,55 @@ static void test_write_to_file()
     unlink(path);
 }
 
+static void assert_glyph_matches_rasterized(const TTF::Font& font, const TTF::ScaledFont& scaled_font, u32 glyph_id, float scale)
+{
+    auto coverage = scaled_font.glyph_coverage(glyph_id);
+    auto bitmap = font.raster_glyph(glyph_id, scale, scale);
+    assert(bitmap);
+    assert(coverage.size() == bitmap->size());
+    for (int y = 0; y < bitmap->height(); ++y) {
+        for (int x = 0; x < bitmap->width(); ++x)
+            assert(coverage.coverage_at(x, y) == bitmap->get_pixel(x, y).alpha());
+    }
+}
+
+static void test_ttf_glyphs_are_shared()
+{
+    auto font = TTF::Font::load_from_file("/res/fonts/SerenitySans-Regular.ttf");
+    assert(font);
+    auto first = adopt(*new TTF::ScaledFont(*font, 12, 12));
+    auto second = adopt(*new TTF::ScaledFont(*font, 12, 12));
+    auto larger = adopt(*new TTF::ScaledFont(*font, 24, 24));
+
+    u32 glyph_id = font->glyph_id_for_codepoint('g');
+    auto coverage = first->glyph_coverage(glyph_id);
+    assert(!coverage.is_null());
+    assert(second->glyph_coverage(glyph_id).scanline(0) == coverage.scanline(0));
+    assert(larger->glyph_coverage(glyph_id).scanline(0) != coverage.scanline(0));
+    assert(larger->glyph_coverage(glyph_id).height() > coverage.height());
+
+    float scale = (12.0f * DEFAULT_DPI) / (POINTS_PER_INCH * font->units_per_em());
+    assert_glyph_matches_rasterized(*font, *first, glyph_id, scale);
+}
+
+static void test_ttf_glyph_atlas_stays_within_budget()
+{
+    auto font = TTF::Font::load_from_file("/res/fonts/SerenitySans-Regular.ttf");
+    assert(font);
+    // Enough sizes to fill the atlas a few times over, including some glyphs too big for a page.
+    for (int size = 8; size < 200; size += 3) {
+        auto scaled_font = adopt(*new TTF::ScaledFont(*font, size, size));
+        for (u32 code_point = 'A'; code_point <= 'z'; ++code_point)
+            (void)scaled_font->glyph(code_point);
+        assert(TTF::GlyphAtlas::the().size_in_bytes() <= TTF::GlyphAtlas::size_budget);
+    }
+
+    auto scaled_font = adopt(*new TTF::ScaledFont(*font, 10, 10));
+    float scale = (10.0f * DEFAULT_DPI) / (POINTS_PER_INCH * font->units_per_em());
+    for (u32 code_point = 'A'; code_point <= 'z'; ++code_point)
+        assert_glyph_matches_rasterized(*font, *scaled_font, font->glyph_id_for_codepoint(code_point), scale);
+}
+
 int main(int, char**)
 {
 #define RUNTEST(x)                      \
@@ -210,6 +261,8 @@ int main(int, char**)
     RUNTEST(test_glyph_or_emoji_width);
     RUNTEST(test_load_from_file);
     RUNTEST(test_write_to_file);
+    RUNTEST(test_ttf_glyphs_are_shared);
+    RUNTEST(test_ttf_glyph_atlas_stays_within_budget);
     printf("PASS\n");
 
     return 0;
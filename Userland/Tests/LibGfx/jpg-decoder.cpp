@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/String.h>
+#include <LibCore/ElapsedTimer.h>
+#include <LibGfx/BMPLoader.h>
+#include <LibGfx/Bitmap.h>
+#include <LibGfx/CPUFeatures.h>
+#include <LibGfx/JPGLoader.h>
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Checks the JPEG decoder against the images it was made from, and then times decoding a few photos.
+
+static const char* lena_variants[] = {
+    "/res/html/misc/jpgsuite_files/non-subsampled-lena.jpg",
+    "/res/html/misc/jpgsuite_files/horizontally-halved-lena.jpg",
+    "/res/html/misc/jpgsuite_files/vertically-halved-lena.jpg",
+    "/res/html/misc/jpgsuite_files/chroma-quartered-lena.jpg",
+};
+
+static NonnullRefPtr<Gfx::Bitmap> load(const char* path)
+{
+    auto bitmap = Gfx::load_jpg(path);
+    if (!bitmap) {
+        fprintf(stderr, "Failed to decode %s\n", path);
+        assert(false);
+    }
+    return bitmap.release_nonnull();
+}
+
+// The average difference of all color channels, in the 0-255 range.
+static float mean_difference(const Gfx::Bitmap& a, const Gfx::Bitmap& b)
+{
+    assert(a.size() == b.size());
+    u64 total = 0;
+    for (int y = 0; y < a.height(); ++y) {
+        for (int x = 0; x < a.width(); ++x) {
+            auto color_a = a.get_pixel(x, y);
+            auto color_b = b.get_pixel(x, y);
+            total += abs(color_a.red() - color_b.red()) + abs(color_a.green() - color_b.green()) + abs(color_a.blue() - color_b.blue());
+        }
+    }
+    return (float)total / (a.width() * a.height() * 3);
+}
+
+static void test_jpg_matches_original()
+{
+    // 127x64, so the last column and row of blocks are only partially inside the image.
+    auto jpg = load("/res/html/misc/bmpsuite_files/rgb24.jpg");
+    auto bmp = Gfx::load_bmp("/res/html/misc/bmpsuite_files/rgb24.bmp");
+    assert(bmp);
+    assert(mean_difference(*jpg, *bmp) < 4.0f);
+    for (int y = 0; y < jpg->height(); ++y) {
+        for (int x = 0; x < jpg->width(); ++x)
+            assert(jpg->get_pixel(x, y).alpha() == 255);
+    }
+}
+
+static void test_jpg_subsampled_images_agree()
+{
+    auto full_resolution = load(lena_variants[0]);
+    for (size_t i = 1; i < sizeof(lena_variants) / sizeof(lena_variants[0]); ++i)
+        assert(mean_difference(*full_resolution, load(lena_variants[i])) < 1.0f);
+}
+
+static void test_jpg_scalar_and_vectorized_decoding_match()
+{
+    const char* paths[] = {
+        "/res/html/misc/bmpsuite_files/rgb24.jpg",
+        "/res/html/misc/jpgsuite_files/oh-lena.jpg",
+        lena_variants[1],
+        lena_variants[3],
+    };
+    for (auto* path : paths) {
+        auto vectorized = load(path);
+        Gfx::set_hardware_acceleration_enabled(false);
+        auto scalar = load(path);
+        Gfx::set_hardware_acceleration_enabled(true);
+        assert(mean_difference(*vectorized, *scalar) == 0.0f);
+    }
+}
+
+template<typename Callback>
+static void benchmark(const char* name, Callback callback)
+{
+    constexpr int iterations = 10;
+    Core::ElapsedTimer timer(true);
+    timer.start();
+    for (int i = 0; i < iterations; ++i)
+        callback();
+    printf("%-36s %6.2f ms\n", name, (float)timer.elapsed() / iterations);
+}
+
+static void run_benchmarks()
+{
+    for (bool accelerated : { true, false }) {
+        Gfx::set_hardware_acceleration_enabled(accelerated);
+        const char* suffix = accelerated ? "" : " (scalar)";
+        benchmark(String::formatted("lena 512x512 4:4:4{}", suffix).characters(), [] { load(lena_variants[0]); });
+        benchmark(String::formatted("lena 512x512 4:2:0{}", suffix).characters(), [] { load(lena_variants[3]); });
+        benchmark(String::formatted("oh-lena 1200x822{}", suffix).characters(), [] { load("/res/html/misc/jpgsuite_files/oh-lena.jpg"); });
+    }
+    Gfx::set_hardware_acceleration_enabled(true);
+}
+
+int main(int, char**)
+{
+#define RUNTEST(x)                      \
+    {                                   \
+        printf("Running " #x " ...\n"); \
+        x();                            \
+        printf("Success!\n");           \
+    }
+    RUNTEST(test_jpg_matches_original);
+    RUNTEST(test_jpg_subsampled_images_agree);
+    RUNTEST(test_jpg_scalar_and_vectorized_decoding_match);
+    printf("PASS\n");
+
+    run_benchmarks();
+
+    return 0;
+}
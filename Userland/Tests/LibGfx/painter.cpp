@@ -0,0 +1,583 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <LibCore/ElapsedTimer.h>
+#include <LibGfx/Bitmap.h>
+#include <LibGfx/Font.h>
+#include <LibGfx/FontDatabase.h>
+#include <LibGfx/Painter.h>
+#include <LibGfx/Path.h>
+#include <LibGfx/TextRunCache.h>
+#include <LibTTF/Font.h>
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+
+// Checks that the vectorized blending in Painter matches blending every pixel with Color::blend(),
+// and then times the blending operations WindowServer uses most.
+
+static u32 s_random_state = 0x12345678;
+
+static u32 next_random()
+{
+    // xorshift32, so every run paints the same pixels.
+    s_random_state ^= s_random_state << 13;
+    s_random_state ^= s_random_state >> 17;
+    s_random_state ^= s_random_state << 5;
+    return s_random_state;
+}
+
+static NonnullRefPtr<Gfx::Bitmap> create_random_bitmap(Gfx::BitmapFormat format, const Gfx::IntSize& size)
+{
+    auto bitmap = Gfx::Bitmap::create(format, size);
+    assert(bitmap);
+    for (int y = 0; y < size.height(); ++y) {
+        for (int x = 0; x < size.width(); ++x) {
+            u32 pixel = next_random();
+            // Make sure the fully opaque and fully transparent special cases come up a lot.
+            switch (pixel % 4) {
+            case 0:
+                pixel |= 0xff000000;
+                break;
+            case 1:
+                pixel &= 0x00ffffff;
+                break;
+            }
+            bitmap->scanline(y)[x] = pixel;
+        }
+    }
+    return bitmap.release_nonnull();
+}
+
+static void assert_same_pixels(const Gfx::Bitmap& a, const Gfx::Bitmap& b)
+{
+    assert(a.physical_size() == b.physical_size());
+    for (int y = 0; y < a.physical_height(); ++y) {
+        for (int x = 0; x < a.physical_width(); ++x) {
+            if (a.scanline(y)[x] != b.scanline(y)[x]) {
+                fprintf(stderr, "Mismatch at %d,%d: %08x != %08x\n", x, y, a.scanline(y)[x], b.scanline(y)[x]);
+                assert(false);
+            }
+        }
+    }
+}
+
+// Odd sizes, so the rows don't line up with the vector width.
+static const Gfx::IntSize test_size { 67, 13 };
+static const Gfx::IntPoint test_position { 3, 2 };
+
+template<typename Callback>
+static void for_each_overlapping_pixel(Gfx::Bitmap& target, const Gfx::Bitmap& source, Callback callback)
+{
+    for (int y = 0; y < source.height(); ++y) {
+        for (int x = 0; x < source.width(); ++x) {
+            int target_x = test_position.x() + x;
+            int target_y = test_position.y() + y;
+            if (target.rect().contains(target_x, target_y))
+                callback(target.scanline(target_y)[target_x], source.scanline(y)[x]);
+        }
+    }
+}
+
+static void test_fill_rect_translucent()
+{
+    for (u8 alpha : { 1, 77, 128, 254 }) {
+        auto target = create_random_bitmap(Gfx::BitmapFormat::RGBA32, test_size);
+        auto expected = target->clone();
+        auto color = Color::from_rgba(next_random()).with_alpha(alpha);
+
+        Gfx::IntRect rect { test_position, { 50, 9 } };
+        Gfx::Painter(*target).fill_rect(rect, color);
+
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            for (int x = rect.left(); x <= rect.right(); ++x)
+                expected->scanline(y)[x] = Color::from_rgba(expected->scanline(y)[x]).blend(color).value();
+        }
+        assert_same_pixels(*target, *expected);
+    }
+}
+
+static void test_blit_with_alpha()
+{
+    for (float opacity : { 1.0f, 0.7f, 0.5f, 0.01f }) {
+        auto target = create_random_bitmap(Gfx::BitmapFormat::RGBA32, test_size);
+        auto source = create_random_bitmap(Gfx::BitmapFormat::RGBA32, test_size);
+        auto expected = target->clone();
+
+        Gfx::Painter(*target).blit(test_position, *source, source->rect(), opacity);
+
+        for_each_overlapping_pixel(*expected, *source, [&](Gfx::RGBA32& dst, Gfx::RGBA32 src) {
+            Color color = Color::from_rgba(src);
+            float pixel_opacity = color.alpha() / 255.0;
+            color.set_alpha(255 * (opacity * pixel_opacity));
+            dst = Color::from_rgba(dst).blend(color).value();
+        });
+        assert_same_pixels(*target, *expected);
+    }
+}
+
+static void test_blit_with_opacity()
+{
+    for (float opacity : { 0.9f, 0.5f, 0.1f }) {
+        auto target = create_random_bitmap(Gfx::BitmapFormat::RGB32, test_size);
+        auto source = create_random_bitmap(Gfx::BitmapFormat::RGB32, test_size);
+        auto expected = target->clone();
+
+        Gfx::Painter(*target).blit(test_position, *source, source->rect(), opacity);
+
+        u8 alpha = 255 * opacity;
+        for_each_overlapping_pixel(*expected, *source, [&](Gfx::RGBA32& dst, Gfx::RGBA32 src) {
+            dst = Color::from_rgb(dst).blend(Color::from_rgb(src).with_alpha(alpha)).value();
+        });
+        assert_same_pixels(*target, *expected);
+    }
+}
+
+template<typename Filter>
+static void expect_filtered_blit(const Gfx::Bitmap& target, Gfx::Bitmap& expected, const Gfx::Bitmap& source, Filter filter)
+{
+    for_each_overlapping_pixel(expected, source, [&](Gfx::RGBA32& dst, Gfx::RGBA32 src) {
+        if (Color::from_rgba(src).alpha())
+            dst = Color::from_rgba(dst).blend(filter(Color::from_rgba(src))).value();
+    });
+    assert_same_pixels(target, expected);
+}
+
+static void test_blit_brightened()
+{
+    auto target = create_random_bitmap(Gfx::BitmapFormat::RGBA32, test_size);
+    auto source = create_random_bitmap(Gfx::BitmapFormat::RGBA32, test_size);
+    auto expected = target->clone();
+
+    Gfx::Painter(*target).blit_brightened(test_position, *source, source->rect());
+    expect_filtered_blit(*target, *expected, *source, [](Color color) { return color.lightened(); });
+}
+
+static void test_blit_dimmed()
+{
+    auto target = create_random_bitmap(Gfx::BitmapFormat::RGBA32, test_size);
+    auto source = create_random_bitmap(Gfx::BitmapFormat::RGBA32, test_size);
+    auto expected = target->clone();
+
+    Gfx::Painter(*target).blit_dimmed(test_position, *source, source->rect());
+    expect_filtered_blit(*target, *expected, *source, [](Color color) { return color.to_grayscale().lightened(); });
+}
+
+static void test_blend_all_alpha_combinations()
+{
+    // Every pair of destination and source alpha, in one 256x256 blit.
+    auto target = create_random_bitmap(Gfx::BitmapFormat::RGBA32, { 256, 256 });
+    auto source = create_random_bitmap(Gfx::BitmapFormat::RGBA32, { 256, 256 });
+    for (int y = 0; y < 256; ++y) {
+        for (int x = 0; x < 256; ++x) {
+            target->scanline(y)[x] = (target->scanline(y)[x] & 0xffffff) | y << 24;
+            source->scanline(y)[x] = (source->scanline(y)[x] & 0xffffff) | x << 24;
+        }
+    }
+    auto expected = target->clone();
+
+    Gfx::Painter(*target).blit({}, *source, source->rect());
+
+    for (int y = 0; y < 256; ++y) {
+        for (int x = 0; x < 256; ++x)
+            expected->scanline(y)[x] = Color::from_rgba(expected->scanline(y)[x]).blend(Color::from_rgba(source->scanline(y)[x])).value();
+    }
+    assert_same_pixels(*target, *expected);
+}
+
+static void test_draw_glyph_coverage()
+{
+    u8 coverage[13 * 7];
+    for (auto& value : coverage)
+        value = next_random() % 3 ? next_random() : (next_random() % 2) * 255;
+    Gfx::GlyphCoverage glyph { coverage, 13, { 13, 7 } };
+
+    for (int scale : { 1, 2 }) {
+        for (u8 alpha : { 255, 100 }) {
+            auto target = Gfx::Bitmap::create(Gfx::BitmapFormat::RGBA32, { 40, 30 }, scale);
+            for (int y = 0; y < target->physical_height(); ++y) {
+                for (int x = 0; x < target->physical_width(); ++x)
+                    target->scanline(y)[x] = next_random();
+            }
+            auto expected = target->clone();
+            auto color = Color::from_rgba(next_random()).with_alpha(alpha);
+            Gfx::IntPoint position { 11, 5 };
+            Gfx::Painter(*target).draw_bitmap(position, glyph, color);
+
+            for (int y = 0; y < 7 * scale; ++y) {
+                for (int x = 0; x < 13 * scale; ++x) {
+                    u8 value = coverage[(y / scale) * 13 + x / scale];
+                    if (!value)
+                        continue;
+                    auto& pixel = expected->scanline(position.y() * scale + y)[position.x() * scale + x];
+                    pixel = Color::from_rgba(pixel).blend(color.with_alpha(color.alpha() * value / 255)).value();
+                }
+            }
+            assert_same_pixels(*target, *expected);
+        }
+    }
+}
+
+static void test_scaling_keeps_solid_colors()
+{
+    for (auto mode : { Gfx::Painter::ScalingMode::BilinearBlend, Gfx::Painter::ScalingMode::BoxSampling }) {
+        auto source = Gfx::Bitmap::create(Gfx::BitmapFormat::RGBA32, { 37, 23 });
+        source->fill(Color(12, 200, 99, 180));
+        for (Gfx::IntSize size : { Gfx::IntSize { 11, 7 }, Gfx::IntSize { 100, 61 }, Gfx::IntSize { 37, 50 } }) {
+            auto target = Gfx::Bitmap::create(Gfx::BitmapFormat::RGBA32, size);
+            target->fill(Color::Transparent);
+            Gfx::Painter(*target).draw_scaled_bitmap(target->rect(), *source, source->rect(), 1.0f, mode);
+            for (int y = 0; y < size.height(); ++y) {
+                for (int x = 0; x < size.width(); ++x)
+                    assert(target->get_pixel(x, y) == Color(12, 200, 99, 180));
+            }
+        }
+    }
+}
+
+static void test_box_sampling_averages()
+{
+    // A black and white checkerboard turns gray when halved.
+    auto source = Gfx::Bitmap::create(Gfx::BitmapFormat::RGB32, { 16, 16 });
+    for (int y = 0; y < 16; ++y) {
+        for (int x = 0; x < 16; ++x)
+            source->set_pixel(x, y, (x + y) % 2 ? Color::White : Color::Black);
+    }
+    auto target = Gfx::Bitmap::create(Gfx::BitmapFormat::RGB32, { 8, 8 });
+    Gfx::Painter(*target).draw_scaled_bitmap(target->rect(), *source, source->rect(), 1.0f, Gfx::Painter::ScalingMode::BoxSampling);
+    for (int y = 0; y < 8; ++y) {
+        for (int x = 0; x < 8; ++x) {
+            auto color = target->get_pixel(x, y);
+            assert(color.red() >= 127 && color.red() <= 128);
+            assert(color.red() == color.green() && color.green() == color.blue());
+        }
+    }
+}
+
+static void test_scaling_ignores_color_of_transparent_pixels()
+{
+    auto source = Gfx::Bitmap::create(Gfx::BitmapFormat::RGBA32, { 2, 1 });
+    source->set_pixel(0, 0, Color::Red);
+    source->set_pixel(1, 0, Color(0, 255, 0, 0));
+    auto target = Gfx::Bitmap::create(Gfx::BitmapFormat::RGBA32, { 1, 1 });
+    target->fill(Color::Transparent);
+    Gfx::Painter(*target).draw_scaled_bitmap(target->rect(), *source, source->rect(), 1.0f, Gfx::Painter::ScalingMode::BoxSampling);
+    auto color = target->get_pixel(0, 0);
+    assert(color.red() == 255 && color.green() == 0 && color.blue() == 0);
+    assert(color.alpha() == 128);
+}
+
+static void test_bilinear_upscaling_interpolates()
+{
+    auto source = Gfx::Bitmap::create(Gfx::BitmapFormat::RGB32, { 2, 1 });
+    source->set_pixel(0, 0, Color::Black);
+    source->set_pixel(1, 0, Color::White);
+    auto target = Gfx::Bitmap::create(Gfx::BitmapFormat::RGB32, { 8, 1 });
+    Gfx::Painter(*target).draw_scaled_bitmap(target->rect(), *source, source->rect(), 1.0f, Gfx::Painter::ScalingMode::BilinearBlend);
+    // The outer quarters lie beyond the source pixel centers, and the middle ramps up from black to white.
+    assert(target->get_pixel(0, 0) == Color::Black);
+    assert(target->get_pixel(7, 0) == Color::White);
+    for (int x = 1; x < 8; ++x)
+        assert(target->get_pixel(x, 0).red() >= target->get_pixel(x - 1, 0).red());
+    assert(target->get_pixel(3, 0).red() > 0 && target->get_pixel(3, 0).red() < 128);
+    assert(target->get_pixel(4, 0).red() > 128 && target->get_pixel(4, 0).red() < 255);
+}
+
+static void test_scaling_with_clip_rect()
+{
+    // Painting only part of the destination must give the same pixels as painting all of it.
+    for (auto mode : { Gfx::Painter::ScalingMode::BilinearBlend, Gfx::Painter::ScalingMode::BoxSampling }) {
+        auto source = create_random_bitmap(Gfx::BitmapFormat::RGBA32, { 41, 29 });
+        auto whole = create_random_bitmap(Gfx::BitmapFormat::RGBA32, { 90, 70 });
+        auto clipped = whole->clone();
+        Gfx::IntRect dst_rect { 5, 3, 80, 60 };
+        Gfx::IntRect clip_rect { 20, 17, 33, 21 };
+
+        Gfx::Painter(*whole).draw_scaled_bitmap(dst_rect, *source, source->rect(), 1.0f, mode);
+        Gfx::Painter clipped_painter(*clipped);
+        clipped_painter.add_clip_rect(clip_rect);
+        clipped_painter.draw_scaled_bitmap(dst_rect, *source, source->rect(), 1.0f, mode);
+
+        auto expected = clipped->clone();
+        for (int y = clip_rect.top(); y <= clip_rect.bottom(); ++y) {
+            for (int x = clip_rect.left(); x <= clip_rect.right(); ++x)
+                expected->scanline(y)[x] = whole->scanline(y)[x];
+        }
+        assert_same_pixels(*clipped, *expected);
+    }
+}
+
+static void append_rect(Gfx::Path& path, const Gfx::FloatRect& rect, bool clockwise = true)
+{
+    // Unlike FloatRect::right() and bottom(), these are the edges of the rectangle.
+    Gfx::FloatPoint top_right { rect.x() + rect.width(), rect.y() };
+    Gfx::FloatPoint bottom_right { rect.x() + rect.width(), rect.y() + rect.height() };
+    Gfx::FloatPoint bottom_left { rect.x(), rect.y() + rect.height() };
+    path.move_to(rect.location());
+    path.line_to(clockwise ? top_right : bottom_left);
+    path.line_to(bottom_right);
+    path.line_to(clockwise ? bottom_left : top_right);
+    path.close();
+}
+
+static void test_fill_path_on_pixel_grid()
+{
+    // A path that runs along pixel edges covers whole pixels only, so no anti-aliasing happens.
+    auto target = Gfx::Bitmap::create(Gfx::BitmapFormat::RGBA32, { 20, 20 });
+    target->fill(Color::White);
+    Gfx::Path path;
+    append_rect(path, { 3, 4, 10, 7 });
+    Gfx::Painter(*target).fill_path(path, Color::Black);
+    for (int y = 0; y < 20; ++y) {
+        for (int x = 0; x < 20; ++x) {
+            bool inside = x >= 3 && x < 13 && y >= 4 && y < 11;
+            assert(target->get_pixel(x, y) == (inside ? Color::Black : Color::White));
+        }
+    }
+}
+
+static void test_fill_path_partial_coverage()
+{
+    // Edges halfway through a pixel blend the color in at half strength.
+    auto target = Gfx::Bitmap::create(Gfx::BitmapFormat::RGBA32, { 20, 20 });
+    target->fill(Color::White);
+    Gfx::Path path;
+    append_rect(path, { 2.5f, 2, 10, 10 });
+    Gfx::Painter(*target).fill_path(path, Color::Black);
+    for (int y = 2; y < 12; ++y) {
+        assert(target->get_pixel(1, y) == Color::White);
+        assert(target->get_pixel(2, y).red() >= 126 && target->get_pixel(2, y).red() <= 129);
+        assert(target->get_pixel(7, y) == Color::Black);
+        assert(target->get_pixel(12, y).red() >= 126 && target->get_pixel(12, y).red() <= 129);
+        assert(target->get_pixel(13, y) == Color::White);
+    }
+}
+
+static void test_fill_path_winding_rules()
+{
+    // Two nested rectangles drawn in the same direction: the nonzero rule fills the inner one, even-odd leaves a hole.
+    Gfx::Path path;
+    append_rect(path, { 2, 2, 16, 16 });
+    append_rect(path, { 6, 6, 8, 8 });
+
+    for (auto rule : { Gfx::Painter::WindingRule::Nonzero, Gfx::Painter::WindingRule::EvenOdd }) {
+        auto target = Gfx::Bitmap::create(Gfx::BitmapFormat::RGBA32, { 20, 20 });
+        target->fill(Color::White);
+        Gfx::Painter(*target).fill_path(path, Color::Black, rule);
+        assert(target->get_pixel(3, 3) == Color::Black);
+        assert(target->get_pixel(10, 10) == (rule == Gfx::Painter::WindingRule::Nonzero ? Color::Black : Color::White));
+        assert(target->get_pixel(1, 1) == Color::White);
+    }
+
+    // With the inner rectangle reversed, both rules leave a hole.
+    Gfx::Path reversed_path;
+    append_rect(reversed_path, { 2, 2, 16, 16 });
+    append_rect(reversed_path, { 6, 6, 8, 8 }, false);
+    auto target = Gfx::Bitmap::create(Gfx::BitmapFormat::RGBA32, { 20, 20 });
+    target->fill(Color::White);
+    Gfx::Painter(*target).fill_path(reversed_path, Color::Black);
+    assert(target->get_pixel(10, 10) == Color::White);
+}
+
+static void test_fill_path_closes_open_subpaths()
+{
+    Gfx::Path open_path;
+    open_path.move_to({ 2, 2 });
+    open_path.line_to({ 15, 3 });
+    open_path.line_to({ 9, 17 });
+    Gfx::Path closed_path;
+    closed_path.move_to({ 2, 2 });
+    closed_path.line_to({ 15, 3 });
+    closed_path.line_to({ 9, 17 });
+    closed_path.close();
+
+    auto open_target = Gfx::Bitmap::create(Gfx::BitmapFormat::RGBA32, { 20, 20 });
+    open_target->fill(Color::White);
+    auto closed_target = open_target->clone();
+    Gfx::Painter(*open_target).fill_path(open_path, Color::Black);
+    Gfx::Painter(*closed_target).fill_path(closed_path, Color::Black);
+    assert_same_pixels(*open_target, *closed_target);
+    assert(open_target->get_pixel(9, 8) == Color::Black);
+}
+
+static void test_fill_path_with_clip_rect()
+{
+    // Painting only part of a path must give the same pixels as painting all of it, even where it leaves the bitmap.
+    Gfx::Path path;
+    path.move_to({ -20, 10 });
+    path.quadratic_bezier_curve_to({ 40, -30 }, { 95, 30 });
+    path.line_to({ 60, 90 });
+    path.quadratic_bezier_curve_to({ 10, 40 }, { -20, 10 });
+
+    auto whole = create_random_bitmap(Gfx::BitmapFormat::RGBA32, { 80, 70 });
+    auto clipped = whole->clone();
+    Gfx::IntRect clip_rect { 20, 13, 31, 27 };
+    Gfx::Painter(*whole).fill_path(path, Color(0x33, 0x66, 0x99, 0xc0));
+    Gfx::Painter clipped_painter(*clipped);
+    clipped_painter.add_clip_rect(clip_rect);
+    clipped_painter.fill_path(path, Color(0x33, 0x66, 0x99, 0xc0));
+
+    auto expected = clipped->clone();
+    for (int y = clip_rect.top(); y <= clip_rect.bottom(); ++y) {
+        for (int x = clip_rect.left(); x <= clip_rect.right(); ++x)
+            expected->scanline(y)[x] = whole->scanline(y)[x];
+    }
+    assert_same_pixels(*clipped, *expected);
+}
+
+static void test_draw_text_from_text_run_cache()
+{
+    // Text laid out for a rect of the same size elsewhere must end up exactly where laying it out from scratch puts it.
+    auto& font = Gfx::FontDatabase::default_font();
+    using Gfx::TextAlignment;
+    for (auto alignment : { TextAlignment::TopLeft, TextAlignment::CenterLeft, TextAlignment::Center, TextAlignment::CenterRight, TextAlignment::TopRight, TextAlignment::BottomRight }) {
+        for (auto elision : { Gfx::TextElision::None, Gfx::TextElision::Right }) {
+            for (const char* text : { "Hello friends!", "A line that is too long to fit", "Two\nlines" }) {
+                Gfx::IntSize size { 87, 33 };
+                Gfx::TextRunCache::the().forget(font);
+                auto cached = Gfx::Bitmap::create(Gfx::BitmapFormat::RGBA32, { 200, 100 });
+                cached->fill(Color::White);
+                Gfx::Painter(*cached).draw_text({ { 3, 4 }, size }, text, font, alignment, Color::Black, elision);
+                assert(Gfx::TextRunCache::the().size() > 0);
+                Gfx::Painter(*cached).draw_text({ { 101, 57 }, size }, text, font, alignment, Color::Black, elision);
+
+                auto expected = Gfx::Bitmap::create(Gfx::BitmapFormat::RGBA32, { 200, 100 });
+                expected->fill(Color::White);
+                Gfx::TextRunCache::the().forget(font);
+                Gfx::Painter(*expected).draw_text({ { 3, 4 }, size }, text, font, alignment, Color::Black, elision);
+                Gfx::TextRunCache::the().forget(font);
+                Gfx::Painter(*expected).draw_text({ { 101, 57 }, size }, text, font, alignment, Color::Black, elision);
+                assert_same_pixels(*cached, *expected);
+            }
+        }
+    }
+}
+
+template<typename Callback>
+static void benchmark(const char* name, Callback callback)
+{
+    constexpr int iterations = 20;
+    Core::ElapsedTimer timer(true);
+    timer.start();
+    for (int i = 0; i < iterations; ++i)
+        callback();
+    printf("%-36s %6.2f ms\n", name, (float)timer.elapsed() / iterations);
+}
+
+static void run_benchmarks()
+{
+    Gfx::IntSize size { 1024, 768 };
+    auto target = create_random_bitmap(Gfx::BitmapFormat::RGBA32, size);
+    auto source = create_random_bitmap(Gfx::BitmapFormat::RGBA32, size);
+    auto opaque_source = create_random_bitmap(Gfx::BitmapFormat::RGB32, size);
+    Gfx::Painter painter(*target);
+
+    benchmark("fill_rect (opaque)", [&] { painter.fill_rect(target->rect(), Color::from_rgb(0x336699)); });
+    benchmark("fill_rect (translucent)", [&] { painter.fill_rect(target->rect(), Color(0x33, 0x66, 0x99, 0x80)); });
+    benchmark("blit (opaque)", [&] { painter.blit({}, *opaque_source, opaque_source->rect()); });
+    benchmark("blit (source alpha)", [&] { painter.blit({}, *source, source->rect()); });
+    benchmark("blit (source alpha, opacity 0.5)", [&] { painter.blit({}, *source, source->rect(), 0.5f); });
+    benchmark("blit (opacity 0.5)", [&] { painter.blit({}, *opaque_source, opaque_source->rect(), 0.5f); });
+    benchmark("blit_brightened", [&] { painter.blit_brightened({}, *source, source->rect()); });
+    benchmark("blit_dimmed", [&] { painter.blit_dimmed({}, *source, source->rect()); });
+
+    auto small_source = create_random_bitmap(Gfx::BitmapFormat::RGBA32, { 320, 240 });
+    Gfx::IntRect smaller_rect { 0, 0, 640, 480 };
+    using ScalingMode = Gfx::Painter::ScalingMode;
+    benchmark("scale down (nearest neighbor)", [&] { painter.draw_scaled_bitmap(smaller_rect, *source, source->rect(), 1.0f, ScalingMode::NearestNeighbor); });
+    benchmark("scale down (bilinear)", [&] { painter.draw_scaled_bitmap(smaller_rect, *source, source->rect(), 1.0f, ScalingMode::BilinearBlend); });
+    benchmark("scale down (box)", [&] { painter.draw_scaled_bitmap(smaller_rect, *source, source->rect(), 1.0f, ScalingMode::BoxSampling); });
+    benchmark("scale up (nearest neighbor)", [&] { painter.draw_scaled_bitmap(target->rect(), *small_source, small_source->rect(), 1.0f, ScalingMode::NearestNeighbor); });
+    benchmark("scale up (bilinear)", [&] { painter.draw_scaled_bitmap(target->rect(), *small_source, small_source->rect(), 1.0f, ScalingMode::BilinearBlend); });
+    benchmark("scale up (box)", [&] { painter.draw_scaled_bitmap(target->rect(), *small_source, small_source->rect(), 1.0f, ScalingMode::BoxSampling); });
+
+    // Lots of small shapes with curved edges, like an SVG icon set.
+    Gfx::Path circles;
+    for (int i = 0; i < 200; ++i) {
+        Gfx::FloatPoint center { (float)(i % 20) * 50 + 25, (float)(i / 20) * 70 + 35 };
+        circles.move_to(center.translated(20, 0));
+        circles.elliptical_arc_to(center.translated(-20, 0), center, { 20, 20 }, 0, 0, M_PI);
+        circles.elliptical_arc_to(center.translated(20, 0), center, { 20, 20 }, 0, M_PI, M_PI);
+    }
+    // One big star whose edges cross every scanline, in both winding rules.
+    Gfx::Path star;
+    for (int i = 0; i < 5; ++i) {
+        float angle = i * 4 * M_PI / 5;
+        Gfx::FloatPoint point { 512 + 380 * sinf(angle), 384 - 380 * cosf(angle) };
+        if (i == 0)
+            star.move_to(point);
+        else
+            star.line_to(point);
+    }
+    star.close();
+    benchmark("draw_text (60 labels)", [&] {
+        for (int line = 0; line < 60; ++line)
+            painter.draw_text({ 0, line * 12, 300, 12 }, "The quick brown fox jumps over the lazy dog, 0123456789 times!", Gfx::TextAlignment::CenterLeft, Color::Black, Gfx::TextElision::Right);
+    });
+    if (auto ttf_font = TTF::Font::load_from_file("/res/fonts/SerenitySans-Regular.ttf")) {
+        auto font = adopt(*new TTF::ScaledFont(*ttf_font, 12, 12));
+        benchmark("draw_text (TTF, 60 lines)", [&] {
+            for (int line = 0; line < 60; ++line)
+                painter.draw_text({ 0, line * 12, 1024, 12 }, "The quick brown fox jumps over the lazy dog, 0123456789 times!", *font, Gfx::TextAlignment::TopLeft, Color::Black);
+        });
+    }
+    benchmark("fill_path (200 circles)", [&] { painter.fill_path(circles, Color(0x33, 0x66, 0x99)); });
+    benchmark("fill_path (star, nonzero)", [&] { painter.fill_path(star, Color(0x33, 0x66, 0x99)); });
+    benchmark("fill_path (star, even-odd)", [&] { painter.fill_path(star, Color(0x33, 0x66, 0x99, 0x80), Gfx::Painter::WindingRule::EvenOdd); });
+}
+
+int main(int, char**)
+{
+#define RUNTEST(x)                      \
+    {                                   \
+        printf("Running " #x " ...\n"); \
+        x();                            \
+        printf("Success!\n");           \
+    }
+    RUNTEST(test_fill_rect_translucent);
+    RUNTEST(test_blit_with_alpha);
+    RUNTEST(test_blit_with_opacity);
+    RUNTEST(test_blit_brightened);
+    RUNTEST(test_blit_dimmed);
+    RUNTEST(test_blend_all_alpha_combinations);
+    RUNTEST(test_draw_glyph_coverage);
+    RUNTEST(test_scaling_keeps_solid_colors);
+    RUNTEST(test_box_sampling_averages);
+    RUNTEST(test_scaling_ignores_color_of_transparent_pixels);
+    RUNTEST(test_bilinear_upscaling_interpolates);
+    RUNTEST(test_scaling_with_clip_rect);
+    RUNTEST(test_fill_path_on_pixel_grid);
+    RUNTEST(test_fill_path_partial_coverage);
+    RUNTEST(test_fill_path_winding_rules);
+    RUNTEST(test_fill_path_closes_open_subpaths);
+    RUNTEST(test_fill_path_with_clip_rect);
+    RUNTEST(test_draw_text_from_text_run_cache);
+    printf("PASS\n");
+
+    run_benchmarks();
+
+    return 0;
+}
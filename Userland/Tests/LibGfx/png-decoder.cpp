@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/String.h>
+#include <LibCore/ElapsedTimer.h>
+#include <LibGfx/BMPLoader.h>
+#include <LibGfx/Bitmap.h>
+#include <LibGfx/CPUFeatures.h>
+#include <LibGfx/PNGLoader.h>
+#include <assert.h>
+#include <stdio.h>
+
+// Checks the PNG decoder against other renditions of the same images, and then times decoding a few big ones.
+
+static NonnullRefPtr<Gfx::Bitmap> load(const char* path)
+{
+    auto bitmap = Gfx::load_png(path);
+    if (!bitmap) {
+        fprintf(stderr, "Failed to decode %s\n", path);
+        assert(false);
+    }
+    return bitmap.release_nonnull();
+}
+
+static bool pixels_equal(const Gfx::Bitmap& a, const Gfx::Bitmap& b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (int y = 0; y < a.height(); ++y) {
+        for (int x = 0; x < a.width(); ++x) {
+            if (a.get_pixel(x, y) != b.get_pixel(x, y))
+                return false;
+        }
+    }
+    return true;
+}
+
+static void test_png_matches_bmp()
+{
+    // The rest of the suite isn't a pixel-exact match, e.g. pal8.png was saved with a slightly different palette.
+    const char* names[] = { "rgb24", "pal4", "pal1" };
+    for (auto* name : names) {
+        auto png = load(String::formatted("/res/html/misc/bmpsuite_files/{}.png", name).characters());
+        auto bmp = Gfx::load_bmp(String::formatted("/res/html/misc/bmpsuite_files/{}.bmp", name));
+        assert(bmp);
+        assert(pixels_equal(*png, *bmp));
+    }
+}
+
+static void test_png_scalar_and_vectorized_decoding_match()
+{
+    // Between them, these use every filter type with 1, 3 and 4 bytes per pixel.
+    const char* paths[] = {
+        "/res/html/misc/bmpsuite_files/rgb24.png",
+        "/res/html/misc/bmpsuite_files/pal8.png",
+        "/res/html/misc/90s-bg.png",
+        "/res/wallpapers/grid.png",
+        "/res/wallpapers/sunset-retro.png",
+        "/res/icons/32x32/app-browser.png",
+    };
+    for (auto* path : paths) {
+        auto vectorized = load(path);
+        Gfx::set_hardware_acceleration_enabled(false);
+        auto scalar = load(path);
+        Gfx::set_hardware_acceleration_enabled(true);
+        assert(pixels_equal(*vectorized, *scalar));
+    }
+}
+
+template<typename Callback>
+static void benchmark(const char* name, Callback callback)
+{
+    constexpr int iterations = 10;
+    Core::ElapsedTimer timer(true);
+    timer.start();
+    for (int i = 0; i < iterations; ++i)
+        callback();
+    printf("%-36s %6.2f ms\n", name, (float)timer.elapsed() / iterations);
+}
+
+static void run_benchmarks()
+{
+    bool settings[] = { true, false };
+    for (bool accelerated : settings) {
+        Gfx::set_hardware_acceleration_enabled(accelerated);
+        const char* suffix = accelerated ? "" : " (scalar)";
+        benchmark(String::formatted("grid 1024x768{}", suffix).characters(), [] { load("/res/wallpapers/grid.png"); });
+        benchmark(String::formatted("sunset-retro 1024x768{}", suffix).characters(), [] { load("/res/wallpapers/sunset-retro.png"); });
+    }
+    Gfx::set_hardware_acceleration_enabled(true);
+}
+
+int main(int, char**)
+{
+#define RUNTEST(x)                      \
+    {                                   \
+        printf("Running " #x " ...\n"); \
+        x();                            \
+        printf("Success!\n");           \
+    }
+    RUNTEST(test_png_matches_bmp);
+    RUNTEST(test_png_scalar_and_vectorized_decoding_match);
+    printf("PASS\n");
+
+    run_benchmarks();
+
+    return 0;
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Format.h>
+#include <AK/Vector.h>
+#include <LibCore/EventLoop.h>
+#include <LibThread/ParallelSort.h>
+#include <LibThread/ThreadPool.h>
+#include <time.h>
+
+// Checks that the thread pool runs every task exactly once, that tasks can wait for tasks they
+// started themselves even when there are fewer workers than waiting tasks, and that results get
+// back to the event loop. Also reports how long it takes to run lots of tiny tasks.
+
+static u64 now_in_us()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1'000'000 + ts.tv_nsec / 1'000;
+}
+
+static int s_failures;
+
+static void fail(const char* message)
+{
+    warnln("FAIL: {}", message);
+    ++s_failures;
+}
+
+static void parallel_for_visits_every_index_once(LibThread::ThreadPool& pool)
+{
+    static constexpr size_t count = 100'000;
+    Vector<u32> visits;
+    visits.ensure_capacity(count);
+    for (size_t i = 0; i < count; ++i)
+        visits.unchecked_append(0);
+    pool.parallel_for(0, count, 64, [&](size_t i) { AK::atomic_fetch_add(&visits[i], 1u); });
+    for (auto visit_count : visits) {
+        if (visit_count != 1) {
+            fail("parallel_for didn't visit every index exactly once");
+            return;
+        }
+    }
+}
+
+static u64 fibonacci(LibThread::ThreadPool& pool, u64 n)
+{
+    if (n < 2)
+        return n;
+    u64 a = 0;
+    LibThread::TaskGroup group(pool);
+    group.spawn([&] { a = fibonacci(pool, n - 1); });
+    u64 b = fibonacci(pool, n - 2);
+    group.wait();
+    return a + b;
+}
+
+static void nested_task_groups_finish(LibThread::ThreadPool& pool)
+{
+    u64 start = now_in_us();
+    auto result = fibonacci(pool, 20);
+    u64 elapsed = now_in_us() - start;
+    if (result != 6765)
+        fail("nested task groups computed the wrong result");
+    outln("{} workers: ~22000 nested tasks took {} us", pool.worker_count(), elapsed);
+}
+
+static void futures_deliver_results(Core::EventLoop& loop, LibThread::ThreadPool& pool)
+{
+    auto future = LibThread::Future<int>::run([] { return 42; }, {}, pool);
+    if (future->await() != 42)
+        fail("awaiting a future returned the wrong result");
+
+    Vector<int> results;
+    for (int i = 0; i < 10; ++i)
+        LibThread::Future<int>::run([i] { return i * i; }, [&](int& result) { results.append(result); }, pool);
+    while (results.size() < 10)
+        loop.pump();
+    quick_sort(results);
+    for (int i = 0; i < 10; ++i) {
+        if (results[i] != i * i)
+            fail("future completion callback got the wrong result");
+    }
+}
+
+static void parallel_sort_sorts()
+{
+    Vector<u32> items;
+    u32 state = 1;
+    for (size_t i = 0; i < 500'000; ++i) {
+        state = state * 1103515245 + 12345;
+        items.append(state >> 8);
+    }
+    u64 start = now_in_us();
+    LibThread::parallel_sort(items, [](auto a, auto b) { return a < b; });
+    u64 elapsed = now_in_us() - start;
+    for (size_t i = 1; i < items.size(); ++i) {
+        if (items[i - 1] > items[i]) {
+            fail("parallel_sort didn't sort");
+            break;
+        }
+    }
+    outln("parallel_sort of {} items took {} us", items.size(), elapsed);
+}
+
+int main()
+{
+    Core::EventLoop loop;
+
+    {
+        LibThread::ThreadPool two_workers(2);
+        parallel_for_visits_every_index_once(two_workers);
+        nested_task_groups_finish(two_workers);
+        futures_deliver_results(loop, two_workers);
+    }
+
+    auto& pool = LibThread::ThreadPool::the();
+    parallel_for_visits_every_index_once(pool);
+    nested_task_groups_finish(pool);
+    futures_deliver_results(loop, pool);
+    parallel_sort_sorts();
+
+    if (!s_failures)
+        outln("PASS");
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Format.h>
+#include <AK/StringBuilder.h>
+#include <LibVT/Terminal.h>
+#include <time.h>
+
+// Feeds typical program output through VT::Terminal, once in bulk the way TerminalWidget reads it
+// from the PTY and once a byte at a time, checks that both end up with the same screen and history,
+// and reports how many bytes per second make it to the screen.
+
+static u64 now_in_us()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1'000'000 + ts.tv_nsec / 1'000;
+}
+
+class NullClient final : public VT::TerminalClient {
+public:
+    virtual void beep() override { }
+    virtual void set_window_title(const StringView&) override { }
+    virtual void set_window_progress(int, int) override { }
+    virtual void terminal_did_resize(u16, u16) override { }
+    virtual void terminal_history_changed() override { }
+    virtual void emit(const u8*, size_t) override { }
+};
+
+static u32 hash_contents(VT::Terminal& terminal)
+{
+    u32 hash = pair_int_hash(terminal.cursor_row(), terminal.cursor_column());
+    for (size_t i = 0; i < terminal.line_count(); ++i) {
+        auto& line = terminal.line(i);
+        for (size_t column = 0; column < line.length(); ++column) {
+            auto& attribute = line.attribute_at(column);
+            hash = pair_int_hash(hash, line.code_point(column));
+            hash = pair_int_hash(hash, attribute.foreground_color ^ attribute.background_color ^ attribute.flags);
+        }
+    }
+    return hash;
+}
+
+static int s_failures;
+
+static void run(const char* name, const ByteBuffer& input)
+{
+    static constexpr size_t chunk_size = 4096;
+
+    NullClient bulk_client;
+    VT::Terminal bulk_terminal(bulk_client);
+    bulk_terminal.set_size(80, 25);
+    u64 start = now_in_us();
+    for (size_t offset = 0; offset < input.size(); offset += chunk_size)
+        bulk_terminal.on_input(input.data() + offset, min(chunk_size, input.size() - offset));
+    u64 bulk_time = max(now_in_us() - start, (u64)1);
+
+    NullClient bytewise_client;
+    VT::Terminal bytewise_terminal(bytewise_client);
+    bytewise_terminal.set_size(80, 25);
+    start = now_in_us();
+    for (size_t i = 0; i < input.size(); ++i)
+        bytewise_terminal.on_input(input[i]);
+    u64 bytewise_time = max(now_in_us() - start, (u64)1);
+
+    if (hash_contents(bulk_terminal) != hash_contents(bytewise_terminal)) {
+        warnln("FAIL: {}: bulk input gave a different screen than bytewise input", name);
+        ++s_failures;
+    }
+
+    outln("{:>10}: {:>8} bytes, bulk {:>8} kB/s, bytewise {:>8} kB/s", name, input.size(),
+        input.size() * 1000 / bulk_time, input.size() * 1000 / bytewise_time);
+}
+
+int main()
+{
+    StringBuilder plain;
+    for (int i = 0; i < 50000; ++i)
+        plain.appendff("{:>6}: The quick brown fox jumps over the lazy dog.\r\n", i);
+
+    StringBuilder long_lines;
+    for (int i = 0; i < 5000; ++i) {
+        for (int j = 0; j < 500; ++j)
+            long_lines.append((char)('a' + (i + j) % 26));
+        long_lines.append("\r\n");
+    }
+
+    StringBuilder colored;
+    for (int i = 0; i < 50000; ++i)
+        colored.appendff("\e[1;3{}m{:>6}\e[0m  \e[4mfile_{}.cpp\e[0m  \e[32mOK\e[0m\r\n", i % 8, i, i);
+
+    StringBuilder utf8;
+    for (int i = 0; i < 50000; ++i)
+        utf8.appendff("{:>6}: Ærøskøbing — “quoted” ★ text\r\n", i);
+
+    StringBuilder full_screen;
+    for (int frame = 0; frame < 500; ++frame) {
+        full_screen.append("\e[H");
+        for (int row = 0; row < 25; ++row)
+            full_screen.appendff("\e[{};1H\e[K\e[7m{:>4}\e[0m {:<70}", row + 1, frame + row, "a status line of some full screen application");
+    }
+
+    run("plain", plain.to_byte_buffer());
+    run("long lines", long_lines.to_byte_buffer());
+    run("colored", colored.to_byte_buffer());
+    run("utf-8", utf8.to_byte_buffer());
+    run("redraws", full_screen.to_byte_buffer());
+
+    return s_failures ? 1 : 0;
+}
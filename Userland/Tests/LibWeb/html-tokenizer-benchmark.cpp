@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Format.h>
+#include <AK/MappedFile.h>
+#include <AK/Utf8View.h>
+#include <LibCore/DirIterator.h>
+#include <LibCore/File.h>
+#include <LibWeb/HTML/Parser/HTMLTokenizer.h>
+#include <time.h>
+
+// Tokenizes HTML files, once with the whole file as input and once fed in small chunks
+// the way documents arrive from the network, and checks that both agree on the tokens.
+// Without arguments, every page below /res/html is used.
+
+using Web::HTML::HTMLToken;
+using Web::HTML::HTMLTokenizer;
+
+static u64 now_in_us()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1'000'000 + ts.tv_nsec / 1'000;
+}
+
+struct TokenizerResult {
+    size_t token_count { 0 };
+    size_t code_point_count { 0 };
+    u32 hash { 0 };
+};
+
+// Runs of characters may be split into tokens differently depending on how the input arrives,
+// so characters are accounted for one code point at a time.
+static void account(TokenizerResult& result, const HTMLToken& token)
+{
+    ++result.token_count;
+    if (token.is_character()) {
+        for (auto code_point : Utf8View(token.characters())) {
+            result.hash = pair_int_hash(result.hash, code_point);
+            ++result.code_point_count;
+        }
+        return;
+    }
+    result.hash = pair_int_hash(result.hash, token.to_string().hash());
+}
+
+static TokenizerResult tokenize(ReadonlyBytes input)
+{
+    TokenizerResult result;
+    HTMLTokenizer tokenizer(StringView(input), "utf-8");
+    for (auto token = tokenizer.next_token(); token.has_value(); token = tokenizer.next_token())
+        account(result, token.value());
+    return result;
+}
+
+static TokenizerResult tokenize_in_chunks(ReadonlyBytes input, size_t chunk_size)
+{
+    TokenizerResult result;
+    HTMLTokenizer tokenizer(String("utf-8"));
+    for (size_t offset = 0; offset < input.size(); offset += chunk_size) {
+        tokenizer.append_input(input.slice(offset, min(chunk_size, input.size() - offset)));
+        for (auto token = tokenizer.next_token(); token.has_value(); token = tokenizer.next_token())
+            account(result, token.value());
+    }
+    tokenizer.close_input();
+    for (auto token = tokenizer.next_token(); token.has_value(); token = tokenizer.next_token())
+        account(result, token.value());
+    return result;
+}
+
+static int s_failures;
+
+static void run(const String& path)
+{
+    auto file_or_error = MappedFile::map(path);
+    if (file_or_error.is_error()) {
+        warnln("Couldn't map {}: {}", path, file_or_error.error());
+        return;
+    }
+    auto input = file_or_error.value()->bytes();
+
+    u64 start = now_in_us();
+    auto whole = tokenize(input);
+    u64 whole_time = now_in_us() - start;
+
+    start = now_in_us();
+    auto chunked = tokenize_in_chunks(input, 4096);
+    u64 chunked_time = now_in_us() - start;
+
+    if (whole.code_point_count != chunked.code_point_count || whole.hash != chunked.hash) {
+        warnln("FAIL: {}: tokenizing in chunks gave different tokens", path);
+        ++s_failures;
+    }
+
+    outln("{:>10} bytes, {:>8} tokens: whole {:>8} us, in chunks {:>8} us  {}", input.size(), whole.token_count, whole_time, chunked_time, path);
+}
+
+static void run_on_directory(const String& path)
+{
+    Core::DirIterator iterator(path, Core::DirIterator::SkipDots);
+    while (iterator.has_next()) {
+        auto entry = iterator.next_full_path();
+        if (entry.ends_with(".html"))
+            run(entry);
+        else if (Core::File::is_directory(entry))
+            run_on_directory(entry);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1) {
+        for (int i = 1; i < argc; ++i)
+            run(argv[i]);
+    } else {
+        run_on_directory("/res/html");
+    }
+    return s_failures ? 1 : 0;
+}
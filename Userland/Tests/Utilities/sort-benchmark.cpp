@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <AK/Format.h>
+#include <AK/MappedFile.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// Sorts a generated file of random lines (1 GiB unless another size in MiB is given) with
+// /bin/sort, once with its default buffer and once with a small one, which makes it go through
+// temporary run files. Checks that the output is the sorted input, and prints how long it took.
+
+static constexpr const char* input_path = "/tmp/sort-benchmark.in";
+static constexpr const char* output_path = "/tmp/sort-benchmark.out";
+
+static u64 now_in_us()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1'000'000 + ts.tv_nsec / 1'000;
+}
+
+static bool generate_input(size_t size)
+{
+    auto* file = fopen(input_path, "w");
+    if (!file) {
+        perror(input_path);
+        return false;
+    }
+    srand(1);
+    static constexpr const char* words[] = { "alpha", "beta", "gamma", "delta", "epsilon", "zeta", "eta", "theta" };
+    char line[128];
+    size_t written = 0;
+    while (written < size) {
+        int length = snprintf(line, sizeof(line), "%s %d %08x%08x\n", words[rand() % 8], rand() % 100000, rand(), rand());
+        fwrite(line, 1, length, file);
+        written += length;
+    }
+    if (fclose(file) != 0) {
+        perror("fclose");
+        return false;
+    }
+    return true;
+}
+
+static size_t count_lines(const StringView& text)
+{
+    size_t count = 0;
+    for (char c : text)
+        count += c == '\n';
+    return count;
+}
+
+static bool run_sort(const char* buffer_size)
+{
+    posix_spawn_file_actions_t file_actions;
+    posix_spawn_file_actions_init(&file_actions);
+    posix_spawn_file_actions_addopen(&file_actions, STDOUT_FILENO, output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    Vector<const char*> arguments { "sort" };
+    if (buffer_size) {
+        arguments.append("-S");
+        arguments.append(buffer_size);
+    }
+    arguments.append(input_path);
+    arguments.append(nullptr);
+
+    pid_t pid;
+    u64 start = now_in_us();
+    if ((errno = posix_spawn(&pid, "/bin/sort", &file_actions, nullptr, const_cast<char**>(arguments.data()), environ))) {
+        perror("posix_spawn");
+        return false;
+    }
+    posix_spawn_file_actions_destroy(&file_actions);
+    int status;
+    if (waitpid(pid, &status, 0) < 0) {
+        perror("waitpid");
+        return false;
+    }
+    u64 time = now_in_us() - start;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        warnln("FAIL: sort -S {} exited with status {}", buffer_size ? buffer_size : "(default)", status);
+        return false;
+    }
+
+    auto input = MappedFile::map(input_path);
+    auto output = MappedFile::map(output_path);
+    if (input.is_error() || output.is_error()) {
+        warnln("FAIL: could not map the input and output");
+        return false;
+    }
+    StringView input_view { static_cast<const char*>(input.value()->data()), input.value()->size() };
+    StringView output_view { static_cast<const char*>(output.value()->data()), output.value()->size() };
+    if (input_view.length() != output_view.length() || count_lines(input_view) != count_lines(output_view)) {
+        warnln("FAIL: sort -S {} changed the size of the input", buffer_size ? buffer_size : "(default)");
+        return false;
+    }
+    StringView previous;
+    for (size_t start = 0; start < output_view.length();) {
+        auto* newline = static_cast<const char*>(memchr(output_view.characters_without_null_termination() + start, '\n', output_view.length() - start));
+        size_t end = newline ? newline - output_view.characters_without_null_termination() : output_view.length();
+        auto line = output_view.substring_view(start, end - start);
+        if (line < previous) {
+            warnln("FAIL: sort -S {} put '{}' after '{}'", buffer_size ? buffer_size : "(default)", line, previous);
+            return false;
+        }
+        previous = line;
+        start = end + 1;
+    }
+
+    outln("sort -S {:>9}: {:>10} bytes in {:>10} us ({} MiB/s)", buffer_size ? buffer_size : "(default)", input_view.length(),
+        time, input_view.length() * 1'000'000 / MiB / max(time, (u64)1));
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    size_t size_in_mib = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1024;
+    if (!generate_input(size_in_mib * MiB))
+        return 1;
+
+    bool ok = run_sort(nullptr) && run_sort("16");
+
+    unlink(input_path);
+    unlink(output_path);
+    if (!ok)
+        return 1;
+    outln("PASS");
+    return 0;
+}
@@ -73,5 +73,6 @@ int main(int argc, char** argv)
         }
     }
     printf("\n");
+    printf("\033[34;1m Latency\033[0m: %d ms\n", audio_client->get_latency_us() / 1000);
     return 0;
 }
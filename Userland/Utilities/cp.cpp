@@ -25,8 +25,10 @@
  */
 
 #include <LibCore/ArgsParser.h>
+#include <LibCore/ElapsedTimer.h>
 #include <LibCore/File.h>
 #include <stdio.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 int main(int argc, char** argv)
@@ -52,6 +54,8 @@ int main(int argc, char** argv)
     args_parser.parse(argc, argv);
 
     for (auto& source : sources) {
+        Core::ElapsedTimer timer;
+        timer.start();
         auto result = Core::File::copy_file_or_directory(
             destination, source,
             recursion_allowed ? Core::File::RecursionMode::Allowed : Core::File::RecursionMode::Disallowed,
@@ -66,8 +70,15 @@ int main(int argc, char** argv)
             return 1;
         }
 
-        if (verbose)
-            printf("'%s' -> '%s'\n", source, destination);
+        if (verbose) {
+            struct stat source_stat;
+            if (lstat(source, &source_stat) == 0 && S_ISREG(source_stat.st_mode)) {
+                auto elapsed_ms = max(timer.elapsed(), 1);
+                printf("'%s' -> '%s' (%lld bytes in %d ms, %lld KiB/s)\n", source, destination, (long long)source_stat.st_size, elapsed_ms, (long long)source_stat.st_size * 1000 / 1024 / elapsed_ms);
+            } else {
+                printf("'%s' -> '%s'\n", source, destination);
+            }
+        }
     }
     return 0;
 }
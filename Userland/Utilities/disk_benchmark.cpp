@@ -24,78 +24,506 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <AK/ByteBuffer.h>
+#include <AK/Assertions.h>
+#include <AK/Atomic.h>
+#include <AK/JsonArray.h>
+#include <AK/JsonObject.h>
+#include <AK/QuickSort.h>
 #include <AK/ScopeGuard.h>
 #include <AK/String.h>
 #include <AK/Types.h>
 #include <AK/Vector.h>
-#include <LibCore/ElapsedTimer.h>
 #include <fcntl.h>
 #include <getopt.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/io_ring.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 
-struct Result {
-    u64 write_bps {};
-    u64 read_bps {};
+enum class Workload {
+    SequentialWrite,
+    SequentialRead,
+    RandomRead,
+    RandomWrite,
+    Mixed,
 };
 
-static Result average_result(const Vector<Result>& results)
-{
-    Result average;
+static constexpr struct {
+    Workload workload;
+    const char* name;
+} s_workload_names[] = {
+    { Workload::SequentialWrite, "seqwrite" },
+    { Workload::SequentialRead, "seqread" },
+    { Workload::RandomRead, "randread" },
+    { Workload::RandomWrite, "randwrite" },
+    { Workload::Mixed, "mixed" },
+};
 
-    for (auto& res : results) {
-        average.write_bps += res.write_bps;
-        average.read_bps += res.read_bps;
+static const char* workload_name(Workload workload)
+{
+    for (auto& entry : s_workload_names) {
+        if (entry.workload == workload)
+            return entry.name;
     }
+    VERIFY_NOT_REACHED();
+}
+
+struct Options {
+    String directory { "." };
+    int time_per_benchmark { 10 };
+    bool allow_cache { false };
+    bool fsync_each_write { false };
+    int queue_depth { 1 };
+    int read_percentage { 70 };
+    bool json { false };
+};
+
+static Options s_options;
+
+struct Result {
+    Workload workload;
+    size_t file_size { 0 };
+    size_t block_size { 0 };
+    u64 reads { 0 };
+    u64 writes { 0 };
+    u64 elapsed_ns { 0 };
+    // How long every operation took, from when it was issued until it completed.
+    Vector<u64> latencies_ns {};
+};
 
-    average.write_bps /= results.size();
-    average.read_bps /= results.size();
+static u64 now_in_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1'000'000'000 + ts.tv_nsec;
+}
 
-    return average;
+[[noreturn]] static void fail(const char* what)
+{
+    perror(what);
+    exit(1);
 }
 
 static void exit_with_usage(int rc)
 {
-    warnln("Usage: disk_benchmark [-h] [-d directory] [-t time_per_benchmark] [-f file_size1,file_size2,...] [-b block_size1,block_size2,...]");
+    warnln("Usage: disk_benchmark [-h] [-c] [-s] [-j] [-d directory] [-t time_per_benchmark] [-f file_size1,file_size2,...] [-b block_size1,block_size2,...]");
+    warnln("                      [-w workload1,workload2,...] [-m read_percentage] [-q queue_depth]");
+    warnln("  -c  Go through the file system cache (default: O_DIRECT)");
+    warnln("  -s  fsync() after every write");
+    warnln("  -j  Print the results as JSON");
+    warnln("  -w  Workloads: seqwrite, seqread, randread, randwrite, mixed (default: seqwrite,seqread)");
+    warnln("  -m  How many percent of the operations in the mixed workload are reads (default: 70)");
+    warnln("  -q  Keep this many operations in flight through an io_ring (default: 1, plain read()/write())");
     exit(rc);
 }
 
-static Optional<Result> benchmark(const String& filename, int file_size, int block_size, ByteBuffer& buffer, bool allow_cache);
+// Picks the offsets (and for the mixed workload, the kind) of the operations.
+class OperationPicker {
+public:
+    OperationPicker(Workload workload, size_t file_size, size_t block_size)
+        : m_workload(workload)
+        , m_block_size(block_size)
+        , m_block_count(max(file_size / block_size, (size_t)1))
+    {
+    }
+
+    struct Operation {
+        bool is_write { false };
+        off_t offset { 0 };
+        // Sequential writes start over in an empty file after they reach the end.
+        bool starts_new_file { false };
+    };
+
+    Operation next()
+    {
+        Operation operation;
+        switch (m_workload) {
+        case Workload::SequentialWrite:
+        case Workload::SequentialRead:
+            operation.is_write = m_workload == Workload::SequentialWrite;
+            operation.starts_new_file = operation.is_write && m_next_block == 0 && m_wrapped;
+            operation.offset = m_next_block * m_block_size;
+            if (++m_next_block == m_block_count) {
+                m_next_block = 0;
+                m_wrapped = true;
+            }
+            break;
+        case Workload::RandomRead:
+        case Workload::RandomWrite:
+            operation.is_write = m_workload == Workload::RandomWrite;
+            operation.offset = (random() % m_block_count) * m_block_size;
+            break;
+        case Workload::Mixed:
+            operation.is_write = (int)(random() % 100) >= s_options.read_percentage;
+            operation.offset = (random() % m_block_count) * m_block_size;
+            break;
+        }
+        return operation;
+    }
+
+private:
+    // A cheap generator (xorshift64), so picking offsets doesn't show up in the latencies.
+    u64 random()
+    {
+        m_random_state ^= m_random_state << 13;
+        m_random_state ^= m_random_state >> 7;
+        m_random_state ^= m_random_state << 17;
+        return m_random_state;
+    }
+
+    Workload m_workload;
+    size_t m_block_size { 0 };
+    size_t m_block_count { 0 };
+    size_t m_next_block { 0 };
+    bool m_wrapped { false };
+    u64 m_random_state { 0x9e3779b97f4a7c15 };
+};
+
+// Page-aligned, as O_DIRECT wants.
+static u8* allocate_buffers(size_t size)
+{
+    auto* buffers = (u8*)mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (buffers == MAP_FAILED)
+        fail("mmap");
+    for (size_t i = 0; i < size; ++i)
+        buffers[i] = i;
+    return buffers;
+}
+
+static void record(Result& result, bool is_write, u64 issued_at)
+{
+    result.latencies_ns.append(now_in_ns() - issued_at);
+    if (is_write)
+        ++result.writes;
+    else
+        ++result.reads;
+}
+
+static void run_synchronously(int fd, Result& result, OperationPicker& picker, u8* buffer, u64 deadline)
+{
+    while (now_in_ns() < deadline) {
+        auto operation = picker.next();
+        if (operation.starts_new_file && ftruncate(fd, 0) < 0)
+            fail("ftruncate");
+
+        u64 issued_at = now_in_ns();
+        if (operation.is_write) {
+            if (pwrite(fd, buffer, result.block_size, operation.offset) != (ssize_t)result.block_size)
+                fail("pwrite");
+            if (s_options.fsync_each_write && fsync(fd) < 0)
+                fail("fsync");
+        } else {
+            if (pread(fd, buffer, result.block_size, operation.offset) < 0)
+                fail("pread");
+        }
+        record(result, operation.is_write, issued_at);
+    }
+}
+
+class Ring {
+public:
+    explicit Ring(unsigned entries)
+    {
+        io_ring_params params {};
+        m_fd = io_ring_create(entries, &params, IO_RING_CLOEXEC);
+        if (m_fd < 0)
+            fail("io_ring_create");
+        m_size = params.ring_size;
+        m_base = (u8*)mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+        if (m_base == MAP_FAILED)
+            fail("mmap");
+        m_sqes = (io_ring_sqe*)(m_base + params.sqes_offset);
+        m_cqes = (io_ring_cqe*)(m_base + params.cqes_offset);
+    }
+
+    ~Ring()
+    {
+        munmap(m_base, m_size);
+        close(m_fd);
+    }
+
+    void queue(const io_ring_sqe& sqe)
+    {
+        m_sqes[m_sq_tail & header().sq_mask] = sqe;
+        AK::atomic_store(&header().sq_tail, ++m_sq_tail, AK::memory_order_release);
+        ++m_unsubmitted;
+    }
+
+    // Submits what's queued, and waits until at least one operation has completed.
+    void enter()
+    {
+        int submitted = io_ring_enter(m_fd, m_unsubmitted, 1, nullptr);
+        if (submitted < 0)
+            fail("io_ring_enter");
+        m_unsubmitted -= submitted;
+    }
+
+    template<typename Callback>
+    void for_each_completion(Callback callback)
+    {
+        u32 cq_tail = AK::atomic_load(&header().cq_tail, AK::memory_order_acquire);
+        while (m_cq_head != cq_tail) {
+            auto cqe = m_cqes[m_cq_head & header().cq_mask];
+            AK::atomic_store(&header().cq_head, ++m_cq_head, AK::memory_order_release);
+            callback(cqe);
+        }
+    }
+
+private:
+    io_ring_header& header() { return *(io_ring_header*)m_base; }
+
+    int m_fd { -1 };
+    u8* m_base { nullptr };
+    size_t m_size { 0 };
+    io_ring_sqe* m_sqes { nullptr };
+    io_ring_cqe* m_cqes { nullptr };
+    u32 m_sq_tail { 0 };
+    u32 m_cq_head { 0 };
+    unsigned m_unsubmitted { 0 };
+};
+
+// Keeps queue_depth operations in flight. Every one of them has its own buffer, and with -s,
+// a write is followed by an fsync and only counts as done when that has completed too.
+static void run_through_ring(int fd, Result& result, OperationPicker& picker, u8* buffers, u64 deadline)
+{
+    struct Slot {
+        bool in_use { false };
+        bool is_write { false };
+        int pending { 0 };
+        u64 issued_at { 0 };
+    };
+    Vector<Slot> slots;
+    slots.resize(s_options.queue_depth);
+    Ring ring(s_options.queue_depth * 2);
+    size_t in_flight = 0;
+    Optional<OperationPicker::Operation> deferred_operation;
+
+    for (;;) {
+        bool can_issue = now_in_ns() < deadline;
+        for (size_t i = 0; can_issue && i < slots.size(); ++i) {
+            auto& slot = slots[i];
+            if (slot.in_use)
+                continue;
+            auto operation = deferred_operation.has_value() ? deferred_operation.release_value() : picker.next();
+            // Wait for the last pass to finish before starting over.
+            if (operation.starts_new_file) {
+                if (in_flight) {
+                    deferred_operation = operation;
+                    break;
+                }
+                if (ftruncate(fd, 0) < 0)
+                    fail("ftruncate");
+            }
+
+            io_ring_sqe sqe {};
+            sqe.opcode = operation.is_write ? IO_RING_OP_WRITE : IO_RING_OP_READ;
+            sqe.fd = fd;
+            sqe.offset = operation.offset;
+            sqe.addr = (FlatPtr)(buffers + i * result.block_size);
+            sqe.len = result.block_size;
+            sqe.user_data = i;
+            slot = { true, operation.is_write, 1, now_in_ns() };
+            ring.queue(sqe);
+            if (operation.is_write && s_options.fsync_each_write) {
+                io_ring_sqe fsync_sqe {};
+                fsync_sqe.opcode = IO_RING_OP_FSYNC;
+                fsync_sqe.fd = fd;
+                fsync_sqe.user_data = i;
+                ring.queue(fsync_sqe);
+                ++slot.pending;
+            }
+            ++in_flight;
+        }
+        if (!in_flight)
+            break;
+
+        ring.enter();
+        ring.for_each_completion([&](const io_ring_cqe& cqe) {
+            if (cqe.result < 0) {
+                errno = -cqe.result;
+                fail("io_ring operation");
+            }
+            auto& slot = slots[cqe.user_data];
+            if (--slot.pending)
+                return;
+            record(result, slot.is_write, slot.issued_at);
+            slot.in_use = false;
+            --in_flight;
+        });
+    }
+}
+
+static Result benchmark(const String& filename, Workload workload, size_t file_size, size_t block_size)
+{
+    int flags = O_CREAT | O_TRUNC | O_RDWR;
+    if (!s_options.allow_cache)
+        flags |= O_DIRECT;
+
+    int fd = open(filename.characters(), flags, 0644);
+    if (fd == -1)
+        fail("open");
+
+    auto fd_cleanup = ScopeGuard([fd, filename] {
+        if (close(fd) < 0)
+            perror("close");
+        if (unlink(filename.characters()) < 0)
+            perror("unlink");
+    });
+
+    size_t buffers_size = block_size * s_options.queue_depth;
+    auto* buffers = allocate_buffers(buffers_size);
+    ScopeGuard unmap_buffers([&] { munmap(buffers, buffers_size); });
+
+    // Everything but sequential writes works on a file that's already there.
+    if (workload != Workload::SequentialWrite) {
+        for (size_t offset = 0; offset + block_size <= file_size; offset += block_size) {
+            if (write(fd, buffers, block_size) != (ssize_t)block_size)
+                fail("write");
+        }
+        if (fsync(fd) < 0)
+            fail("fsync");
+    }
+
+    Result result { workload, file_size, block_size };
+    OperationPicker picker(workload, file_size, block_size);
+    u64 start = now_in_ns();
+    u64 deadline = start + (u64)s_options.time_per_benchmark * 1'000'000'000;
+    if (s_options.queue_depth > 1)
+        run_through_ring(fd, result, picker, buffers, deadline);
+    else
+        run_synchronously(fd, result, picker, buffers, deadline);
+    result.elapsed_ns = now_in_ns() - start;
+    return result;
+}
+
+struct Summary {
+    u64 bytes_per_second { 0 };
+    u64 operations_per_second { 0 };
+    u64 min_us { 0 };
+    u64 p50_us { 0 };
+    u64 p99_us { 0 };
+    u64 p999_us { 0 };
+    u64 max_us { 0 };
+};
+
+static Summary summarize(Result& result)
+{
+    Summary summary;
+    auto& latencies = result.latencies_ns;
+    if (latencies.is_empty() || !result.elapsed_ns)
+        return summary;
+
+    quick_sort(latencies);
+    auto percentile = [&](size_t per_mille) {
+        return latencies[min(latencies.size() * per_mille / 1000, latencies.size() - 1)] / 1000;
+    };
+    u64 operations = result.reads + result.writes;
+    summary.bytes_per_second = operations * result.block_size * 1'000'000'000 / result.elapsed_ns;
+    summary.operations_per_second = operations * 1'000'000'000 / result.elapsed_ns;
+    summary.min_us = latencies.first() / 1000;
+    summary.p50_us = percentile(500);
+    summary.p99_us = percentile(990);
+    summary.p999_us = percentile(999);
+    summary.max_us = latencies.last() / 1000;
+    return summary;
+}
+
+static JsonObject to_json(const Result& result, const Summary& summary)
+{
+    JsonObject latency;
+    latency.set("min", summary.min_us);
+    latency.set("p50", summary.p50_us);
+    latency.set("p99", summary.p99_us);
+    latency.set("p999", summary.p999_us);
+    latency.set("max", summary.max_us);
+
+    JsonObject object;
+    object.set("workload", workload_name(result.workload));
+    object.set("file_size", result.file_size);
+    object.set("block_size", result.block_size);
+    object.set("queue_depth", s_options.queue_depth);
+    object.set("direct", !s_options.allow_cache);
+    object.set("fsync_each_write", s_options.fsync_each_write);
+    if (result.workload == Workload::Mixed)
+        object.set("read_percentage", s_options.read_percentage);
+    object.set("reads", result.reads);
+    object.set("writes", result.writes);
+    object.set("elapsed_ms", result.elapsed_ns / 1'000'000);
+    object.set("bytes_per_second", summary.bytes_per_second);
+    object.set("operations_per_second", summary.operations_per_second);
+    object.set("latency_us", move(latency));
+    return object;
+}
+
+static Vector<size_t> parse_sizes(const char* list)
+{
+    Vector<size_t> sizes;
+    for (const auto& size : String(list).split(',')) {
+        auto number = size.to_uint();
+        if (!number.has_value() || !number.value())
+            exit_with_usage(1);
+        sizes.append(number.value());
+    }
+    return sizes;
+}
 
 int main(int argc, char** argv)
 {
-    String directory = ".";
-    int time_per_benchmark = 10;
     Vector<size_t> file_sizes;
     Vector<size_t> block_sizes;
-    bool allow_cache = false;
+    Vector<Workload> workloads;
 
     int opt;
-    while ((opt = getopt(argc, argv, "chd:t:f:b:")) != -1) {
+    while ((opt = getopt(argc, argv, "chsjd:t:f:b:w:m:q:")) != -1) {
         switch (opt) {
         case 'h':
             exit_with_usage(0);
             break;
         case 'c':
-            allow_cache = true;
+            s_options.allow_cache = true;
+            break;
+        case 's':
+            s_options.fsync_each_write = true;
+            break;
+        case 'j':
+            s_options.json = true;
             break;
         case 'd':
-            directory = optarg;
+            s_options.directory = optarg;
             break;
         case 't':
-            time_per_benchmark = atoi(optarg);
+            s_options.time_per_benchmark = atoi(optarg);
             break;
         case 'f':
-            for (const auto& size : String(optarg).split(','))
-                file_sizes.append(atoi(size.characters()));
+            file_sizes = parse_sizes(optarg);
             break;
         case 'b':
-            for (const auto& size : String(optarg).split(','))
-                block_sizes.append(atoi(size.characters()));
+            block_sizes = parse_sizes(optarg);
+            break;
+        case 'w':
+            for (const auto& name : String(optarg).split(',')) {
+                bool found = false;
+                for (auto& entry : s_workload_names) {
+                    if (name == entry.name) {
+                        workloads.append(entry.workload);
+                        found = true;
+                    }
+                }
+                if (!found)
+                    exit_with_usage(1);
+            }
+            break;
+        case 'm':
+            s_options.read_percentage = clamp(atoi(optarg), 0, 100);
+            break;
+        case 'q':
+            s_options.queue_depth = clamp(atoi(optarg), 1, IO_RING_MAX_ENTRIES / 2);
             break;
+        default:
+            exit_with_usage(1);
         }
     }
 
@@ -105,93 +533,38 @@ int main(int argc, char** argv)
     if (block_sizes.size() == 0) {
         block_sizes = { 8192, 32768, 65536 };
     }
+    if (workloads.size() == 0) {
+        workloads = { Workload::SequentialWrite, Workload::SequentialRead };
+    }
 
     umask(0644);
 
-    auto filename = String::formatted("{}/disk_benchmark.tmp", directory);
+    auto filename = String::formatted("{}/disk_benchmark.tmp", s_options.directory);
+    JsonArray json_results;
 
     for (auto file_size : file_sizes) {
         for (auto block_size : block_sizes) {
             if (block_size > file_size)
                 continue;
 
-            auto buffer = ByteBuffer::create_uninitialized(block_size);
-            Vector<Result> results;
-
-            outln("Running: file_size={} block_size={}", file_size, block_size);
-            Core::ElapsedTimer timer;
-            timer.start();
-            while (timer.elapsed() < time_per_benchmark * 1000) {
-                out(".");
-                fflush(stdout);
-                auto result = benchmark(filename, file_size, block_size, buffer, allow_cache);
-                if (!result.has_value())
-                    return 1;
-                results.append(result.release_value());
-                usleep(100);
+            for (auto workload : workloads) {
+                if (!s_options.json)
+                    outln("Running: workload={} file_size={} block_size={} queue_depth={}", workload_name(workload), file_size, block_size, s_options.queue_depth);
+                auto result = benchmark(filename, workload, file_size, block_size);
+                auto summary = summarize(result);
+                if (s_options.json) {
+                    json_results.append(to_json(result, summary));
+                } else {
+                    outln("Finished: reads={} writes={} time={}ms bps={} iops={} latency_us: min={} p50={} p99={} p999={} max={}",
+                        result.reads, result.writes, result.elapsed_ns / 1'000'000, summary.bytes_per_second, summary.operations_per_second,
+                        summary.min_us, summary.p50_us, summary.p99_us, summary.p999_us, summary.max_us);
+                }
             }
-            auto average = average_result(results);
-            outln("Finished: runs={} time={}ms write_bps={} read_bps={}", results.size(), timer.elapsed(), average.write_bps, average.read_bps);
-
-            sleep(1);
-        }
-    }
-
-    return 0;
-}
-
-Optional<Result> benchmark(const String& filename, int file_size, int block_size, ByteBuffer& buffer, bool allow_cache)
-{
-    int flags = O_CREAT | O_TRUNC | O_RDWR;
-    if (!allow_cache)
-        flags |= O_DIRECT;
-
-    int fd = open(filename.characters(), flags, 0644);
-    if (fd == -1) {
-        perror("open");
-        exit(1);
-    }
-
-    auto fd_cleanup = ScopeGuard([fd, filename] {
-        if (close(fd) < 0)
-            perror("close");
-        if (unlink(filename.characters()) < 0)
-            perror("unlink");
-    });
-
-    Result result;
-
-    Core::ElapsedTimer timer;
-    timer.start();
-
-    ssize_t total_written = 0;
-    for (ssize_t j = 0; j < file_size; j += block_size) {
-        auto nwritten = write(fd, buffer.data(), block_size);
-        if (nwritten < 0) {
-            perror("write");
-            return {};
         }
-        total_written += nwritten;
-    }
-
-    result.write_bps = (u64)(timer.elapsed() ? (file_size / timer.elapsed()) : file_size) * 1000;
-
-    if (lseek(fd, 0, SEEK_SET) < 0) {
-        perror("lseek");
-        return {};
     }
 
-    timer.start();
-    ssize_t total_read = 0;
-    while (total_read < file_size) {
-        auto nread = read(fd, buffer.data(), block_size);
-        if (nread < 0) {
-            perror("read");
-            return {};
-        }
-        total_read += nread;
-    }
+    if (s_options.json)
+        outln("{}", json_results.to_string());
 
-    result.read_bps = (u64)(timer.elapsed() ? (file_size / timer.elapsed()) : file_size) * 1000;
-    return result;
+    return 0;
 }
@@ -30,9 +30,10 @@
 #include <AK/Vector.h>
 #include <LibCore/ArgsParser.h>
 #include <LibCore/DateTime.h>
-#include <LibCore/DirIterator.h>
+#include <LibCore/DirectoryWalker.h>
 #include <LibCore/File.h>
 #include <LibCore/Object.h>
+#include <errno.h>
 #include <limits.h>
 #include <math.h>
 #include <stdio.h>
@@ -56,7 +57,7 @@ struct DuOption {
 };
 
 static int parse_args(int argc, char** argv, Vector<String>& files, DuOption& du_option, int& max_depth);
-static int print_space_usage(const String& path, const DuOption& du_option, int max_depth);
+static int print_space_usage(Core::DirectoryWalker&, const String& path, const struct stat& path_stat, const DuOption& du_option, int max_depth);
 
 int main(int argc, char** argv)
 {
@@ -67,8 +68,17 @@ int main(int argc, char** argv)
     if (parse_args(argc, argv, files, du_option, max_depth))
         return 1;
 
+    Core::DirectoryWalker::Options walker_options;
+    walker_options.stat_entries = true;
+    Core::DirectoryWalker walker(walker_options);
+
     for (const auto& file : files) {
-        if (print_space_usage(file, du_option, max_depth))
+        struct stat path_stat;
+        if (lstat(file.characters(), &path_stat) < 0) {
+            perror("lstat");
+            return 1;
+        }
+        if (print_space_usage(walker, file, path_stat, du_option, max_depth))
             return 1;
     }
 
@@ -142,24 +152,43 @@ int parse_args(int argc, char** argv, Vector<String>& files, DuOption& du_option
     return 0;
 }
 
-int print_space_usage(const String& path, const DuOption& du_option, int max_depth)
+// Symlinks to directories are listed (but not followed) even without --all.
+static bool is_directory_or_link_to_one(const String& path, const Core::DirectoryWalker::Entry& entry)
 {
-    struct stat path_stat;
-    if (lstat(path.characters(), &path_stat) < 0) {
-        perror("lstat");
-        return 1;
-    }
+    if (S_ISLNK(entry.metadata.st_mode))
+        return Core::File::is_directory(path);
+    return S_ISDIR(entry.metadata.st_mode);
+}
 
+int print_space_usage(Core::DirectoryWalker& walker, const String& path, const struct stat& path_stat, const DuOption& du_option, int max_depth)
+{
     if (--max_depth >= 0 && S_ISDIR(path_stat.st_mode)) {
-        auto di = Core::DirIterator(path, Core::DirIterator::SkipParentAndBaseDir);
-        if (di.has_error()) {
-            fprintf(stderr, "DirIterator: %s\n", di.error_string());
+        auto listing = walker.list(path);
+        if (listing.error) {
+            fprintf(stderr, "DirIterator: %s\n", strerror(listing.error));
             return 1;
         }
-        while (di.has_next()) {
-            const auto child_path = di.next_full_path();
-            if (du_option.all || Core::File::is_directory(child_path)) {
-                if (print_space_usage(child_path, du_option, max_depth))
+
+        Vector<String> child_paths;
+        Vector<String> subdirectory_paths;
+        for (auto& entry : listing.entries) {
+            child_paths.append(String::formatted("{}/{}", path, entry.name));
+            if (max_depth > 0 && entry.has_metadata && S_ISDIR(entry.metadata.st_mode))
+                subdirectory_paths.append(child_paths.last());
+        }
+        walker.prefetch(subdirectory_paths);
+
+        for (size_t i = 0; i < listing.entries.size(); ++i) {
+            auto& entry = listing.entries[i];
+            if (!entry.has_metadata) {
+                if (!du_option.all)
+                    continue;
+                errno = entry.metadata_error;
+                perror("lstat");
+                return 1;
+            }
+            if (du_option.all || is_directory_or_link_to_one(child_paths[i], entry)) {
+                if (print_space_usage(walker, child_paths[i], entry.metadata, du_option, max_depth))
                     return 1;
             }
         }
@@ -26,13 +26,16 @@
 
 #include <AK/LexicalPath.h>
 #include <AK/NonnullOwnPtr.h>
+#include <AK/Optional.h>
 #include <AK/OwnPtr.h>
 #include <AK/Vector.h>
-#include <LibCore/DirIterator.h>
+#include <LibCore/DirectoryWalker.h>
+#include <errno.h>
 #include <getopt.h>
 #include <grp.h>
 #include <pwd.h>
 #include <stdio.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -54,28 +57,39 @@ bool g_have_seen_action_command = false;
     exit(1);
 }
 
+struct FileData {
+    const char* full_path { nullptr };
+    // Filled in by whoever gets the metadata first: the directory walker, or a StatCommand.
+    Optional<struct stat> metadata;
+};
+
 class Command {
 public:
     virtual ~Command() { }
-    virtual bool evaluate(const char* file_path) const = 0;
+    virtual bool evaluate(FileData&) const = 0;
+    virtual bool needs_metadata() const { return false; }
 };
 
 class StatCommand : public Command {
 public:
     virtual bool evaluate(const struct stat&) const = 0;
+    virtual bool needs_metadata() const override { return true; }
 
 private:
-    virtual bool evaluate(const char* file_path) const override
+    virtual bool evaluate(FileData& file_data) const override
     {
-        struct stat stat;
-        auto stat_func = g_follow_symlinks ? ::stat : ::lstat;
-        int rc = stat_func(file_path, &stat);
-        if (rc < 0) {
-            perror(file_path);
-            g_there_was_an_error = true;
-            return false;
+        if (!file_data.metadata.has_value()) {
+            struct stat stat;
+            auto stat_func = g_follow_symlinks ? ::stat : ::lstat;
+            int rc = stat_func(file_data.full_path, &stat);
+            if (rc < 0) {
+                perror(file_data.full_path);
+                g_there_was_an_error = true;
+                return false;
+            }
+            file_data.metadata = stat;
         }
-        return evaluate(stat);
+        return evaluate(file_data.metadata.value());
     }
 };
 
@@ -222,9 +236,9 @@ public:
     }
 
 private:
-    virtual bool evaluate(const char* file_path) const override
+    virtual bool evaluate(FileData& file_data) const override
     {
-        LexicalPath path { file_path };
+        LexicalPath path { file_data.full_path };
         return path.basename().matches(m_pattern, m_case_sensitivity);
     }
 
@@ -240,9 +254,9 @@ public:
     }
 
 private:
-    virtual bool evaluate(const char* file_path) const override
+    virtual bool evaluate(FileData& file_data) const override
     {
-        printf("%s%c", file_path, m_terminator);
+        printf("%s%c", file_data.full_path, m_terminator);
         return true;
     }
 
@@ -257,7 +271,7 @@ public:
     }
 
 private:
-    virtual bool evaluate(const char* file_path) const override
+    virtual bool evaluate(FileData& file_data) const override
     {
         pid_t pid = fork();
 
@@ -272,7 +286,7 @@ private:
             auto argv = const_cast<Vector<char*>&>(m_argv);
             for (auto& arg : argv) {
                 if (StringView(arg) == "{}")
-                    arg = const_cast<char*>(file_path);
+                    arg = const_cast<char*>(file_data.full_path);
             }
             argv.append(nullptr);
             execvp(m_argv[0], argv.data());
@@ -302,11 +316,13 @@ public:
     }
 
 private:
-    virtual bool evaluate(const char* file_path) const override
+    virtual bool evaluate(FileData& file_data) const override
     {
-        return m_lhs->evaluate(file_path) && m_rhs->evaluate(file_path);
+        return m_lhs->evaluate(file_data) && m_rhs->evaluate(file_data);
     }
 
+    virtual bool needs_metadata() const override { return m_lhs->needs_metadata() || m_rhs->needs_metadata(); }
+
     NonnullOwnPtr<Command> m_lhs;
     NonnullOwnPtr<Command> m_rhs;
 };
@@ -320,11 +336,13 @@ public:
     }
 
 private:
-    virtual bool evaluate(const char* file_path) const override
+    virtual bool evaluate(FileData& file_data) const override
     {
-        return m_lhs->evaluate(file_path) || m_rhs->evaluate(file_path);
+        return m_lhs->evaluate(file_data) || m_rhs->evaluate(file_data);
     }
 
+    virtual bool needs_metadata() const override { return m_lhs->needs_metadata() || m_rhs->needs_metadata(); }
+
     NonnullOwnPtr<Command> m_lhs;
     NonnullOwnPtr<Command> m_rhs;
 };
@@ -466,19 +484,33 @@ static const char* parse_options(int argc, char* argv[])
     }
 }
 
-static void walk_tree(const char* root_path, Command& command)
+// Evaluates the command for everything below the directory. Only actual directories are
+// descended into, or whatever they point to with -L.
+static void walk_directory(Core::DirectoryWalker& walker, const String& path, Command& command)
 {
-    command.evaluate(root_path);
-
-    Core::DirIterator dir_iterator(root_path, Core::DirIterator::SkipParentAndBaseDir);
-    if (dir_iterator.has_error() && dir_iterator.error() == ENOTDIR)
-        return;
-
-    while (dir_iterator.has_next())
-        walk_tree(dir_iterator.next_full_path().characters(), command);
+    auto listing = walker.list(path);
+
+    Vector<String> child_paths;
+    Vector<String> subdirectory_paths;
+    for (auto& entry : listing.entries) {
+        child_paths.append(String::formatted("{}/{}", path, entry.name));
+        if (entry.is_directory())
+            subdirectory_paths.append(child_paths.last());
+    }
+    walker.prefetch(subdirectory_paths);
+
+    for (size_t i = 0; i < listing.entries.size(); ++i) {
+        auto& entry = listing.entries[i];
+        FileData file_data { child_paths[i].characters(), {} };
+        if (entry.has_metadata)
+            file_data.metadata = entry.metadata;
+        command.evaluate(file_data);
+        if (entry.is_directory())
+            walk_directory(walker, child_paths[i], command);
+    }
 
-    if (dir_iterator.has_error()) {
-        fprintf(stderr, "%s: %s\n", root_path, dir_iterator.error_string());
+    if (listing.error && listing.error != ENOTDIR) {
+        fprintf(stderr, "%s: %s\n", path.characters(), strerror(listing.error));
         g_there_was_an_error = true;
     }
 }
@@ -487,6 +519,14 @@ int main(int argc, char* argv[])
 {
     auto root_path = parse_options(argc, argv);
     auto command = parse_all_commands(argv);
-    walk_tree(root_path, *command);
+
+    Core::DirectoryWalker::Options options;
+    options.stat_entries = command->needs_metadata();
+    options.follow_symlinks = g_follow_symlinks;
+    Core::DirectoryWalker walker(options);
+
+    FileData root_data { root_path, {} };
+    command->evaluate(root_data);
+    walk_directory(walker, root_path, *command);
     return g_there_was_an_error ? 1 : 0;
 }
@@ -25,17 +25,30 @@
  */
 
 #include <AK/ByteBuffer.h>
+#include <AK/MappedFile.h>
+#include <AK/NonnullRefPtrVector.h>
 #include <AK/ScopeGuard.h>
 #include <AK/String.h>
+#include <AK/StringBuilder.h>
 #include <AK/Utf8View.h>
 #include <AK/Vector.h>
 #include <LibCore/ArgsParser.h>
 #include <LibCore/DirIterator.h>
 #include <LibCore/File.h>
 #include <LibRegex/Regex.h>
+#include <LibThread/ThreadPool.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
+#if defined(__SSE2__)
+#    include <emmintrin.h>
+#endif
+
 enum class BinaryFileMode {
     Binary,
     Text,
@@ -51,9 +64,150 @@ void fail(StringView format, Ts... args)
     abort();
 }
 
+// Finds the longest piece of text that every match of the (extended) pattern has to contain.
+// Lines without it can't match, so we don't have to run the regex on them.
+static String required_literal(StringView pattern)
+{
+    // Any of the alternatives could match, and they needn't have anything in common.
+    if (pattern.contains('|'))
+        return {};
+
+    String longest;
+    StringBuilder current;
+    auto end_run = [&] {
+        if (current.length() > longest.length())
+            longest = current.to_string();
+        current.clear();
+    };
+
+    size_t group_depth = 0;
+    for (size_t i = 0; i < pattern.length(); ++i) {
+        char ch = pattern[i];
+        char next = i + 1 < pattern.length() ? pattern[i + 1] : 0;
+        if (ch == '\\') {
+            end_run();
+            ++i;
+            continue;
+        }
+        if (ch == '[') {
+            // A bracket expression may start with ']' (after an optional '^'), which doesn't end it.
+            end_run();
+            ++i;
+            if (i < pattern.length() && pattern[i] == '^')
+                ++i;
+            if (i < pattern.length() && pattern[i] == ']')
+                ++i;
+            while (i < pattern.length() && pattern[i] != ']')
+                ++i;
+            continue;
+        }
+        if (ch == '(') {
+            // A group may be optional or repeated, so don't look inside.
+            end_run();
+            ++group_depth;
+            continue;
+        }
+        if (ch == ')') {
+            if (group_depth)
+                --group_depth;
+            continue;
+        }
+        if (group_depth)
+            continue;
+        if (ch == '{') {
+            end_run();
+            while (i < pattern.length() && pattern[i] != '}')
+                ++i;
+            continue;
+        }
+        if (strchr(".^$*+?}", ch)) {
+            end_run();
+            continue;
+        }
+        // This character may not be there at all.
+        if (next == '*' || next == '?' || next == '{') {
+            end_run();
+            continue;
+        }
+        current.append(ch);
+        // The character may be repeated, so nothing after it is right next to it.
+        if (next == '+')
+            end_run();
+    }
+    end_run();
+    return longest;
+}
+
+static bool bytes_equal(const u8* a, const u8* b, size_t length, CaseSensitivity case_sensitivity)
+{
+    if (case_sensitivity == CaseSensitivity::CaseSensitive)
+        return !memcmp(a, b, length);
+    for (size_t i = 0; i < length; ++i) {
+        if (tolower(a[i]) != tolower(b[i]))
+            return false;
+    }
+    return true;
+}
+
+static const u8* find_literal(const u8* haystack, size_t length, StringView literal, CaseSensitivity case_sensitivity)
+{
+    auto* needle = reinterpret_cast<const u8*>(literal.characters_without_null_termination());
+    size_t needle_length = literal.length();
+    VERIFY(needle_length > 0);
+    if (length < needle_length)
+        return nullptr;
+    // The last offset the needle could start at.
+    size_t last_offset = length - needle_length;
+    size_t offset = 0;
+
+#if defined(__SSE2__)
+    // Look for the needle's first and last byte at the right distance, 16 offsets at a time.
+    // Only where both are there do we have to compare the rest.
+    if (needle_length > 1) {
+        // Setting 0x20 turns ASCII letters into lowercase. It also turns a few other bytes into letters,
+        // but the candidates are checked properly anyway.
+        auto fold_mask = [&](u8 byte) {
+            return _mm_set1_epi8(case_sensitivity == CaseSensitivity::CaseInsensitive && isalpha(byte) ? 0x20 : 0);
+        };
+        auto first_fold_mask = fold_mask(needle[0]);
+        auto last_fold_mask = fold_mask(needle[needle_length - 1]);
+        auto first_byte = _mm_or_si128(_mm_set1_epi8(needle[0]), first_fold_mask);
+        auto last_byte = _mm_or_si128(_mm_set1_epi8(needle[needle_length - 1]), last_fold_mask);
+        for (; offset + 16 <= last_offset + 1; offset += 16) {
+            auto first_block = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + offset)), first_fold_mask);
+            auto last_block = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + offset + needle_length - 1)), last_fold_mask);
+            auto mask = (unsigned)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first_byte, first_block), _mm_cmpeq_epi8(last_byte, last_block)));
+            while (mask) {
+                auto candidate = offset + __builtin_ctz(mask);
+                if (bytes_equal(haystack + candidate, needle, needle_length, case_sensitivity))
+                    return haystack + candidate;
+                mask &= mask - 1;
+            }
+        }
+    }
+#endif
+
+    if (case_sensitivity == CaseSensitivity::CaseInsensitive) {
+        for (; offset <= last_offset; ++offset) {
+            if (bytes_equal(haystack + offset, needle, needle_length, case_sensitivity))
+                return haystack + offset;
+        }
+        return nullptr;
+    }
+    while (offset <= last_offset) {
+        auto* candidate = static_cast<const u8*>(memchr(haystack + offset, needle[0], last_offset - offset + 1));
+        if (!candidate)
+            return nullptr;
+        if (!memcmp(candidate, needle, needle_length))
+            return candidate;
+        offset = candidate - haystack + 1;
+    }
+    return nullptr;
+}
+
 int main(int argc, char** argv)
 {
-    if (pledge("stdio rpath", nullptr) < 0) {
+    if (pledge("stdio rpath thread", nullptr) < 0) {
         perror("pledge");
         return 1;
     }
@@ -128,7 +282,13 @@ int main(int argc, char** argv)
         return 1;
     }
 
-    auto matches = [&](StringView str, StringView filename = "", bool print_filename = false, bool is_binary = false) {
+    // Selecting the lines that don't match means looking at all of them anyway.
+    String literal;
+    if (!invert_match)
+        literal = required_literal(pattern);
+    auto literal_case_sensitivity = case_insensitive ? CaseSensitivity::CaseInsensitive : CaseSensitivity::CaseSensitive;
+
+    auto matches = [&](Regex<PosixExtended>& re, StringBuilder& output, StringView str, StringView filename = "", bool print_filename = false, bool is_binary = false) {
         size_t last_printed_char_pos { 0 };
         if (is_binary && binary_mode == BinaryFileMode::Skip)
             return false;
@@ -136,20 +296,20 @@ int main(int argc, char** argv)
         auto result = re.match(str, PosixFlags::Global);
         if (result.success ^ invert_match) {
             if (is_binary && binary_mode == BinaryFileMode::Binary) {
-                outln("binary file \x1B[34m{}\x1B[0m matches", filename);
+                output.appendff("binary file \x1B[34m{}\x1B[0m matches\n", filename);
             } else {
                 if ((result.matches.size() || invert_match) && print_filename) {
-                    out("\x1B[34m{}:\x1B[0m", filename);
+                    output.appendff("\x1B[34m{}:\x1B[0m", filename);
                 }
 
                 for (auto& match : result.matches) {
 
-                    out("{}\x1B[32m{}\x1B[0m",
+                    output.appendff("{}\x1B[32m{}\x1B[0m",
                         StringView(&str[last_printed_char_pos], match.global_offset - last_printed_char_pos),
                         match.view.to_string());
                     last_printed_char_pos = match.global_offset + match.view.length();
                 }
-                outln("{}", StringView(&str[last_printed_char_pos], str.length() - last_printed_char_pos));
+                output.appendff("{}\n", StringView(&str[last_printed_char_pos], str.length() - last_printed_char_pos));
             }
 
             return true;
@@ -158,32 +318,101 @@ int main(int argc, char** argv)
         return false;
     };
 
-    auto handle_file = [&matches, binary_mode](StringView filename, bool print_filename) -> bool {
-        auto file = Core::File::construct(filename);
-        if (!file->open(Core::IODevice::ReadOnly)) {
-            warnln("Failed to open {}: {}", filename, file->error_string());
-            return false;
+    struct FileResult {
+        String output;
+        bool matched { false };
+        bool failed { false };
+    };
+
+    auto handle_file = [&](String filename, bool print_filename) -> FileResult {
+        FileResult result;
+        // This runs on the thread pool, so it sticks to plain syscalls rather than Core::File.
+        int fd = open(filename.characters(), O_RDONLY);
+        if (fd < 0) {
+            warnln("Failed to open {}: {}", filename, strerror(errno));
+            result.failed = true;
+            return result;
+        }
+        ScopeGuard close_fd = [fd] { close(fd); };
+
+        ReadonlyBytes contents;
+        RefPtr<MappedFile> mapped_file;
+        ByteBuffer read_contents;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+            if (auto file_or_error = MappedFile::map(filename); !file_or_error.is_error()) {
+                mapped_file = file_or_error.release_value();
+                contents = mapped_file->bytes();
+            }
+        }
+        // FIFOs and devices can only be read once, so they are never mapped. Empty files and most
+        // of /proc can't be mapped either, so all of those are read instead.
+        if (!mapped_file) {
+            for (;;) {
+                u8 chunk[4096];
+                ssize_t nread = read(fd, chunk, sizeof(chunk));
+                if (nread < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    warnln("Failed to read {}: {}", filename, strerror(errno));
+                    result.failed = true;
+                    return result;
+                }
+                if (nread == 0)
+                    break;
+                read_contents.append(chunk, nread);
+            }
+            contents = read_contents;
         }
 
-        while (file->can_read_line()) {
-            auto line = file->read_line();
-            auto is_binary = memchr(line.characters(), 0, line.length()) != nullptr;
+        // The regex isn't safe to share between threads, so every file gets its own.
+        Regex<PosixExtended> re(pattern, options);
+        StringBuilder output;
+        auto handle_line = [&](size_t start, size_t end) {
+            StringView line { contents.offset_pointer(start), end - start };
+            auto is_binary = memchr(line.characters_without_null_termination(), 0, line.length()) != nullptr;
+            if (!matches(re, output, line, filename, print_filename, is_binary))
+                return IterationDecision::Continue;
+            result.matched = true;
+            if (is_binary && binary_mode == BinaryFileMode::Binary)
+                return IterationDecision::Break;
+            return IterationDecision::Continue;
+        };
+        auto end_of_line = [&](size_t offset) {
+            auto* newline = static_cast<const u8*>(memchr(contents.offset_pointer(offset), '\n', contents.size() - offset));
+            return newline ? newline - contents.data() : contents.size();
+        };
 
-            if (matches(line, filename, print_filename, is_binary) && is_binary && binary_mode == BinaryFileMode::Binary)
-                return true;
+        size_t offset = 0;
+        while (offset < contents.size()) {
+            size_t line_start = offset;
+            if (!literal.is_empty()) {
+                auto* hit = find_literal(contents.offset_pointer(offset), contents.size() - offset, literal, literal_case_sensitivity);
+                if (!hit)
+                    break;
+                line_start = hit - contents.data();
+                while (line_start > offset && contents[line_start - 1] != '\n')
+                    --line_start;
+            }
+            size_t line_end = end_of_line(line_start);
+            if (handle_line(line_start, line_end) == IterationDecision::Break)
+                break;
+            offset = line_end + 1;
         }
-        return true;
+
+        result.output = output.to_string();
+        return result;
     };
 
-    auto add_directory = [&handle_file](String base, Optional<String> recursive, auto handle_directory) -> void {
+    auto add_directory = [](String base, Optional<String> recursive, Vector<String>& paths, auto handle_directory) -> void {
         Core::DirIterator it(recursive.value_or(base), Core::DirIterator::Flags::SkipDots);
         while (it.has_next()) {
             auto path = it.next_full_path();
             if (!Core::File::is_directory(path)) {
                 auto key = path.substring_view(base.length() + 1, path.length() - base.length() - 1);
-                handle_file(key, true);
+                paths.append(key);
             } else {
-                handle_directory(base, path, handle_directory);
+                handle_directory(base, path, paths, handle_directory);
             }
         }
     };
@@ -194,6 +423,7 @@ int main(int argc, char** argv)
         size_t line_len = 0;
         ssize_t nread = 0;
         ScopeGuard free_line = [line] { free(line); };
+        StringBuilder output;
         while ((nread = getline(&line, &line_len, stdin)) != -1) {
             VERIFY(nread > 0);
             StringView line_view(line, nread - 1);
@@ -202,20 +432,46 @@ int main(int argc, char** argv)
             if (is_binary && binary_mode == BinaryFileMode::Skip)
                 return 1;
 
-            auto matched = matches(line_view, "stdin", false, is_binary);
+            auto matched = matches(re, output, line_view, "stdin", false, is_binary);
+            out("{}", output.string_view());
+            output.clear();
             did_match_something = did_match_something || matched;
             if (matched && is_binary && binary_mode == BinaryFileMode::Binary)
                 return 0;
         }
     } else {
+        Vector<String> paths;
+        bool print_filename { true };
         if (recursive) {
-            add_directory(".", {}, add_directory);
+            add_directory(".", {}, paths, add_directory);
+        } else {
+            for (auto& filename : files)
+                paths.append(filename);
+            print_filename = files.size() > 1;
+        }
 
+        auto print_result = [&](FileResult& result) {
+            out("{}", result.output);
+            did_match_something = did_match_something || result.matched;
+            return !result.failed;
+        };
+
+        if (paths.size() == 1) {
+            auto result = handle_file(paths.first(), print_filename);
+            if (!print_result(result))
+                return 1;
         } else {
-            bool print_filename { files.size() > 1 };
-            for (auto& filename : files) {
-                if (!handle_file(filename, print_filename))
+            // Search the files on all cores, but print what we found in the order the files were given in.
+            NonnullRefPtrVector<LibThread::Future<FileResult>> results;
+            for (auto& path : paths)
+                results.append(LibThread::Future<FileResult>::run([&handle_file, path, print_filename] { return handle_file(path, print_filename); }));
+            for (auto& result : results) {
+                if (!print_result(result.await())) {
+                    // The other searches are still using our state, so let them finish.
+                    for (auto& other_result : results)
+                        other_result.await();
                     return 1;
+                }
             }
         }
     }
@@ -78,6 +78,8 @@ private:
 };
 
 static bool s_dump_ast = false;
+static bool s_run_bytecode = false;
+static bool s_dump_bytecode = false;
 static bool s_print_last_result = false;
 static RefPtr<Line::Editor> s_editor;
 static String s_history_path = String::formatted("{}/.js-history", Core::StandardPaths::home_directory());
@@ -667,14 +669,18 @@ public:
 int main(int argc, char** argv)
 {
     bool gc_on_every_allocation = false;
+    bool dump_gc_statistics = false;
     bool disable_syntax_highlight = false;
     const char* script_path = nullptr;
 
     Core::ArgsParser args_parser;
     args_parser.set_general_help("This is a JavaScript interpreter.");
     args_parser.add_option(s_dump_ast, "Dump the AST", "dump-ast", 'A');
+    args_parser.add_option(s_run_bytecode, "Run the bytecode interpreter where possible", "run-bytecode", 'b');
+    args_parser.add_option(s_dump_bytecode, "Dump the bytecode", "dump-bytecode", 'd');
     args_parser.add_option(s_print_last_result, "Print last result", "print-last-result", 'l');
     args_parser.add_option(gc_on_every_allocation, "GC on every allocation", "gc-on-every-allocation", 'g');
+    args_parser.add_option(dump_gc_statistics, "Dump GC statistics on exit", "dump-gc-statistics", 'G');
     args_parser.add_option(disable_syntax_highlight, "Disable live syntax highlighting", "no-syntax-highlight", 's');
     args_parser.add_positional_argument(script_path, "Path to script file", "script", Core::ArgsParser::Required::No);
     args_parser.parse(argc, argv);
@@ -695,6 +701,8 @@ int main(int argc, char** argv)
         ReplConsoleClient console_client(interpreter->global_object().console());
         interpreter->global_object().console().set_client(console_client);
         interpreter->heap().set_should_collect_on_every_allocation(gc_on_every_allocation);
+        interpreter->set_bytecode_enabled(s_run_bytecode || s_dump_bytecode);
+        interpreter->set_dump_bytecode(s_dump_bytecode);
         interpreter->vm().set_underscore_is_last_value(true);
 
         s_editor = Line::Editor::construct();
@@ -892,11 +900,15 @@ int main(int argc, char** argv)
         s_editor->on_tab_complete = move(complete);
         repl(*interpreter);
         s_editor->save_history(s_history_path);
+        if (dump_gc_statistics)
+            interpreter->heap().dump_statistics();
     } else {
         interpreter = JS::Interpreter::create<JS::GlobalObject>(*vm);
         ReplConsoleClient console_client(interpreter->global_object().console());
         interpreter->global_object().console().set_client(console_client);
         interpreter->heap().set_should_collect_on_every_allocation(gc_on_every_allocation);
+        interpreter->set_bytecode_enabled(s_run_bytecode || s_dump_bytecode);
+        interpreter->set_dump_bytecode(s_dump_bytecode);
 
         signal(SIGINT, [](int) {
             sigint_handler();
@@ -916,7 +928,10 @@ int main(int argc, char** argv)
             source = file_contents;
         }
 
-        if (!parse_and_run(*interpreter, source))
+        bool success = parse_and_run(*interpreter, source);
+        if (dump_gc_statistics)
+            interpreter->heap().dump_statistics();
+        if (!success)
             return 1;
     }
 
@@ -28,23 +28,51 @@
 #include <AK/JsonArray.h>
 #include <AK/JsonObject.h>
 #include <AK/String.h>
+#include <LibCore/ArgsParser.h>
 #include <LibCore/File.h>
 #include <stdio.h>
 
-int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv)
+int main(int argc, char** argv)
 {
-    if (pledge("stdio rpath", nullptr) < 0) {
+    if (pledge("stdio rpath wpath", nullptr) < 0) {
         perror("pledge");
         return 1;
     }
 
-    if (unveil("/proc/interrupts", "r") < 0) {
+    int interrupt_line = -1;
+    int cpu = -1;
+
+    Core::ArgsParser args_parser;
+    args_parser.add_option(interrupt_line, "Interrupt line to route to another processor", "irq", 'i', "irq");
+    args_parser.add_option(cpu, "Processor to deliver the interrupt to", "cpu", 'c', "cpu");
+    args_parser.parse(argc, argv);
+
+    if ((interrupt_line < 0) != (cpu < 0)) {
+        fprintf(stderr, "Error: --irq and --cpu have to be given together\n");
+        return 1;
+    }
+    bool set_affinity = interrupt_line >= 0;
+
+    if (unveil("/proc/interrupts", set_affinity ? "rw" : "r") < 0) {
         perror("unveil");
         return 1;
     }
 
     unveil(nullptr, nullptr);
 
+    if (set_affinity) {
+        auto proc_interrupts = Core::File::construct("/proc/interrupts");
+        if (!proc_interrupts->open(Core::IODevice::WriteOnly)) {
+            fprintf(stderr, "Error: %s\n", proc_interrupts->error_string());
+            return 1;
+        }
+        if (!proc_interrupts->write(String::formatted("{} {}", interrupt_line, cpu))) {
+            fprintf(stderr, "Error: Can't route interrupt %d to cpu %d: %s\n", interrupt_line, cpu, proc_interrupts->error_string());
+            return 1;
+        }
+        return 0;
+    }
+
     auto proc_interrupts = Core::File::construct("/proc/interrupts");
     if (!proc_interrupts->open(Core::IODevice::ReadOnly)) {
         fprintf(stderr, "Error: %s\n", proc_interrupts->error_string());
@@ -56,7 +84,7 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv)
         return 1;
     }
 
-    printf("%4s  %-10s\n", " ", "CPU0");
+    printf("%4s  %-3s  %-10s  %-10s  %-30s\n", "IRQ", "CPU", "Calls", "Controller", "Purpose");
     auto file_contents = proc_interrupts->read_all();
     auto json = JsonValue::from_string(file_contents);
     VERIFY(json.has_value());
@@ -64,11 +92,12 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv)
         auto handler = value.as_object();
         auto purpose = handler.get("purpose").to_string();
         auto interrupt = handler.get("interrupt_line").to_string();
+        auto cpu_handler = handler.get("cpu_handler").to_string();
         auto controller = handler.get("controller").to_string();
         auto call_count = handler.get("call_count").to_string();
 
-        printf("%4s: %-10s %-10s  %-30s\n",
-            interrupt.characters(), call_count.characters(), controller.characters(), purpose.characters());
+        printf("%4s  %-3s  %-10s  %-10s  %-30s\n",
+            interrupt.characters(), cpu_handler.characters(), call_count.characters(), controller.characters(), purpose.characters());
     });
 
     return 0;
@@ -24,11 +24,57 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <Kernel/API/Perfcore.h>
 #include <LibCore/ArgsParser.h>
+#include <fcntl.h>
 #include <serenity.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+
+static Optional<int> sample_source_from_name(const StringView& name)
+{
+    if (name == "timer")
+        return PROFILING_SAMPLE_TIMER;
+    if (name == "cycles")
+        return PROFILING_SAMPLE_CYCLES;
+    if (name == "instructions")
+        return PROFILING_SAMPLE_INSTRUCTIONS;
+    if (name == "cache-misses")
+        return PROFILING_SAMPLE_CACHE_MISSES;
+    if (name == "branch-misses")
+        return PROFILING_SAMPLE_BRANCH_MISSES;
+    return {};
+}
+
+static int stream_system_samples()
+{
+    int fd = open("/dev/profile", O_RDONLY);
+    if (fd < 0) {
+        perror("open /dev/profile");
+        return 1;
+    }
+
+    Kernel::SystemProfileSample samples[64];
+    for (;;) {
+        ssize_t nread = read(fd, samples, sizeof(samples));
+        if (nread < 0) {
+            perror("read");
+            return 1;
+        }
+        for (size_t i = 0; i < nread / sizeof(Kernel::SystemProfileSample); ++i) {
+            auto& sample = samples[i];
+            if (sample.lost_samples)
+                printf("# cpu %u lost %u samples\n", sample.cpu, sample.lost_samples);
+            printf("%llu %u %u %u", sample.timestamp_ns, sample.cpu, sample.pid, sample.tid);
+            for (size_t j = 0; j < sample.stack_size; ++j)
+                printf(" %#x", (unsigned)sample.stack[j]);
+            putchar('\n');
+        }
+        fflush(stdout);
+    }
+}
 
 int main(int argc, char** argv)
 {
@@ -38,14 +84,27 @@ int main(int argc, char** argv)
     const char* cmd_argument = nullptr;
     bool enable = false;
     bool disable = false;
+    bool all_processes = false;
+    const char* sample_source_name = "timer";
 
     args_parser.add_option(pid_argument, "Target PID", nullptr, 'p', "PID");
     args_parser.add_option(enable, "Enable", nullptr, 'e');
     args_parser.add_option(disable, "Disable", nullptr, 'd');
     args_parser.add_option(cmd_argument, "Command", nullptr, 'c', "command");
+    args_parser.add_option(all_processes, "Sample all processes and print the samples until interrupted", nullptr, 'a');
+    args_parser.add_option(sample_source_name, "Sample on timer ticks (default), or every so many cycles, instructions, cache-misses or branch-misses", "sample", 's', "event");
 
     args_parser.parse(argc, argv);
 
+    auto sample_source = sample_source_from_name(sample_source_name);
+    if (!sample_source.has_value()) {
+        fprintf(stderr, "Unknown sample source '%s'\n", sample_source_name);
+        return 1;
+    }
+
+    if (all_processes)
+        return stream_system_samples();
+
     if (!pid_argument && !cmd_argument) {
         args_parser.print_usage(stdout, argv[0]);
         return 0;
@@ -60,7 +119,7 @@ int main(int argc, char** argv)
         pid_t pid = atoi(pid_argument);
 
         if (enable) {
-            if (profiling_enable(pid) < 0) {
+            if (profiling_enable(pid, sample_source.value()) < 0) {
                 perror("profiling_enable");
                 return 1;
             }
@@ -84,7 +143,10 @@ int main(int argc, char** argv)
     cmd_argv.append(nullptr);
 
     dbgln("Enabling profiling for PID {}", getpid());
-    profiling_enable(getpid());
+    if (profiling_enable(getpid(), sample_source.value()) < 0) {
+        perror("profiling_enable");
+        return 1;
+    }
     if (execvp(cmd_argv[0], const_cast<char**>(cmd_argv.data())) < 0) {
         perror("execv");
         return 1;
@@ -45,7 +45,7 @@ int main(int argc, char** argv)
         return 1;
     }
 
-    if (unveil("/proc/all", "r") < 0) {
+    if (unveil("/proc/stats", "r") < 0) {
         perror("unveil");
         return 1;
     }
@@ -71,10 +71,12 @@ int main(int argc, char** argv)
 
     bool every_process_flag = false;
     bool full_format_flag = false;
+    bool statistics_flag = false;
 
     Core::ArgsParser args_parser;
     args_parser.add_option(every_process_flag, "Show every process", nullptr, 'e');
     args_parser.add_option(full_format_flag, "Full format", nullptr, 'f');
+    args_parser.add_option(statistics_flag, "Show fault, context switch and wait time statistics", nullptr, 's');
     args_parser.parse(argc, argv);
 
     Vector<Column> columns;
@@ -84,6 +86,12 @@ int main(int argc, char** argv)
     int ppid_column = -1;
     int state_column = -1;
     int tty_column = -1;
+    int minor_faults_column = -1;
+    int major_faults_column = -1;
+    int voluntary_context_switches_column = -1;
+    int involuntary_context_switches_column = -1;
+    int block_io_wait_column = -1;
+    int scheduler_latency_column = -1;
     int cmd_column = -1;
 
     auto add_column = [&](auto title, auto alignment, auto width) {
@@ -97,12 +105,19 @@ int main(int argc, char** argv)
         ppid_column = add_column("PPID", Alignment::Right, 5);
         state_column = add_column("STATE", Alignment::Left, 12);
         tty_column = add_column("TTY", Alignment::Left, 6);
-        cmd_column = add_column("CMD", Alignment::Left, 0);
     } else {
         pid_column = add_column("PID", Alignment::Right, 5);
         tty_column = add_column("TTY", Alignment::Left, 6);
-        cmd_column = add_column("CMD", Alignment::Left, 0);
     }
+    if (statistics_flag) {
+        minor_faults_column = add_column("MINFLT", Alignment::Right, 7);
+        major_faults_column = add_column("MAJFLT", Alignment::Right, 6);
+        voluntary_context_switches_column = add_column("VCSW", Alignment::Right, 7);
+        involuntary_context_switches_column = add_column("ICSW", Alignment::Right, 7);
+        block_io_wait_column = add_column("IOWAIT", Alignment::Right, 8);
+        scheduler_latency_column = add_column("SCHWAIT", Alignment::Right, 8);
+    }
+    cmd_column = add_column("CMD", Alignment::Left, 0);
 
     auto print_column = [](auto& column, auto& string) {
         if (!column.width) {
@@ -147,6 +162,24 @@ int main(int argc, char** argv)
             columns[tty_column].buffer = tty;
         if (state_column != -1)
             columns[state_column].buffer = state;
+        if (statistics_flag) {
+            unsigned minor_faults = 0, major_faults = 0, voluntary_context_switches = 0, involuntary_context_switches = 0;
+            u64 block_io_wait_us = 0, scheduler_latency_us = 0;
+            for (auto& thread : proc.threads) {
+                minor_faults += thread.minor_faults;
+                major_faults += thread.major_faults;
+                voluntary_context_switches += thread.voluntary_context_switches;
+                involuntary_context_switches += thread.involuntary_context_switches;
+                block_io_wait_us += thread.block_io_wait_us;
+                scheduler_latency_us += thread.scheduler_latency_us;
+            }
+            columns[minor_faults_column].buffer = String::number(minor_faults);
+            columns[major_faults_column].buffer = String::number(major_faults);
+            columns[voluntary_context_switches_column].buffer = String::number(voluntary_context_switches);
+            columns[involuntary_context_switches_column].buffer = String::number(involuntary_context_switches);
+            columns[block_io_wait_column].buffer = String::formatted("{}ms", block_io_wait_us / 1000);
+            columns[scheduler_latency_column].buffer = String::formatted("{}ms", scheduler_latency_us / 1000);
+        }
         if (cmd_column != -1)
             columns[cmd_column].buffer = proc.name;
 
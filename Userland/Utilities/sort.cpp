@@ -24,46 +24,361 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <AK/QuickSort.h>
 #include <AK/String.h>
 #include <AK/Vector.h>
+#include <LibCore/ArgsParser.h>
+#include <LibThread/ParallelSort.h>
+#include <ctype.h>
 #include <errno.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
-int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv)
+// Input that doesn't fit in the memory budget is sorted one chunk at a time (using all cores),
+// and each sorted chunk is written to a temporary "run" file. The runs are merged at the end,
+// at most max_merge_fan_in at a time so we don't run out of file descriptors.
+
+static constexpr size_t max_merge_fan_in = 16;
+// Roughly what a Line costs in addition to its characters.
+static constexpr size_t line_overhead = sizeof(String) + sizeof(StringView) + sizeof(double) + 32;
+
+struct Options {
+    // 1-based fields; 0 means the start or end of the line.
+    size_t key_start_field { 0 };
+    size_t key_end_field { 0 };
+    Optional<char> field_separator;
+    bool numeric { false };
+    bool reverse { false };
+};
+
+static Options s_options;
+
+struct Line {
+    String text;
+    StringView key;
+    double number { 0 };
+};
+
+static bool is_blank(char c)
 {
-    if (pledge("stdio", nullptr) > 0) {
-        perror("pledge");
-        return 1;
+    return c == ' ' || c == '\t';
+}
+
+// Returns where the field starts (fields are 1-based), or the end of the text if there aren't that many.
+// Without a separator, a field is any leading blanks followed by non-blanks, like in other sorts.
+static size_t find_field_start(const StringView& text, size_t field)
+{
+    size_t i = 0;
+    for (size_t current = 1; current < field && i < text.length(); ++current) {
+        if (s_options.field_separator.has_value()) {
+            while (i < text.length() && text[i] != s_options.field_separator.value())
+                ++i;
+            if (i < text.length())
+                ++i;
+        } else {
+            while (i < text.length() && is_blank(text[i]))
+                ++i;
+            while (i < text.length() && !is_blank(text[i]))
+                ++i;
+        }
     }
+    return i;
+}
 
-    Vector<String> lines;
+static size_t find_field_end(const StringView& text, size_t field_start)
+{
+    size_t i = field_start;
+    if (s_options.field_separator.has_value()) {
+        while (i < text.length() && text[i] != s_options.field_separator.value())
+            ++i;
+    } else {
+        while (i < text.length() && is_blank(text[i]))
+            ++i;
+        while (i < text.length() && !is_blank(text[i]))
+            ++i;
+    }
+    return i;
+}
 
-    for (;;) {
-        char* buffer = nullptr;
-        ssize_t buflen = 0;
-        size_t n;
+static double parse_number(const StringView& text)
+{
+    size_t i = 0;
+    while (i < text.length() && is_blank(text[i]))
+        ++i;
+    bool negative = i < text.length() && text[i] == '-';
+    if (negative)
+        ++i;
+    double value = 0;
+    for (; i < text.length() && isdigit(text[i]); ++i)
+        value = value * 10 + (text[i] - '0');
+    if (i < text.length() && text[i] == '.') {
+        double scale = 0.1;
+        for (++i; i < text.length() && isdigit(text[i]); ++i, scale /= 10)
+            value += (text[i] - '0') * scale;
+    }
+    return negative ? -value : value;
+}
+
+static Line make_line(String text)
+{
+    Line line { move(text), {}, 0 };
+    StringView view = line.text;
+    size_t start = s_options.key_start_field ? find_field_start(view, s_options.key_start_field) : 0;
+    size_t end = view.length();
+    if (s_options.key_end_field)
+        end = max(start, find_field_end(view, find_field_start(view, s_options.key_end_field)));
+    line.key = view.substring_view(start, end - start);
+    if (s_options.numeric)
+        line.number = parse_number(line.key);
+    return line;
+}
+
+static int compare_bytes(const StringView& a, const StringView& b)
+{
+    if (int result = memcmp(a.characters_without_null_termination(), b.characters_without_null_termination(), min(a.length(), b.length())))
+        return result;
+    return a.length() == b.length() ? 0 : (a.length() < b.length() ? -1 : 1);
+}
+
+// Lines with equal keys are ordered by their whole text.
+static bool line_less_than(const Line& a, const Line& b)
+{
+    int result = 0;
+    if (s_options.numeric)
+        result = a.number < b.number ? -1 : (a.number > b.number ? 1 : 0);
+    else if (s_options.key_start_field)
+        result = compare_bytes(a.key, b.key);
+    if (!result)
+        result = compare_bytes(a.text, b.text);
+    return s_options.reverse ? result > 0 : result < 0;
+}
+
+class LineReader {
+public:
+    explicit LineReader(FILE* file)
+        : m_file(file)
+    {
+    }
+
+    ~LineReader() { free(m_buffer); }
+
+    // Returns false at the end of the input; exits on errors.
+    bool read_line(String& line)
+    {
         errno = 0;
-        buflen = getline(&buffer, &n, stdin);
-        if (buflen == -1 && errno != 0) {
+        ssize_t length = getline(&m_buffer, &m_capacity, m_file);
+        if (length == -1 && errno != 0) {
             perror("getline");
             exit(1);
         }
-        if (buflen == -1)
+        if (length == -1)
+            return false;
+        if (length > 0 && m_buffer[length - 1] == '\n')
+            --length;
+        line = String(m_buffer, length);
+        return true;
+    }
+
+private:
+    FILE* m_file { nullptr };
+    char* m_buffer { nullptr };
+    size_t m_capacity { 0 };
+};
+
+static void write_line(FILE* file, const String& line)
+{
+    fwrite(line.characters(), 1, line.length(), file);
+    fputc('\n', file);
+}
+
+static const char* s_temporary_directory = "/tmp";
+
+// The file is unlinked right away, so it goes away with us no matter how we exit.
+static FILE* create_run_file()
+{
+    auto path = String::formatted("{}/sort.XXXXXX", s_temporary_directory);
+    char buffer[PATH_MAX];
+    if (!path.copy_characters_to_buffer(buffer, sizeof(buffer))) {
+        warnln("sort: temporary directory path is too long");
+        exit(1);
+    }
+    int fd = mkstemp(buffer);
+    if (fd < 0) {
+        perror("mkstemp");
+        exit(1);
+    }
+    unlink(buffer);
+    auto* file = fdopen(fd, "w+");
+    if (!file) {
+        perror("fdopen");
+        exit(1);
+    }
+    return file;
+}
+
+static void finish_writing(FILE* file)
+{
+    if (fflush(file) != 0 || ferror(file)) {
+        perror("write");
+        exit(1);
+    }
+}
+
+// Merges already sorted files into output. Equal lines are taken from the earlier file first,
+// which keeps the whole sort stable.
+static void merge_runs(Vector<FILE*>& runs, FILE* output)
+{
+    Vector<OwnPtr<LineReader>> readers;
+    Vector<Optional<Line>> heads;
+    for (auto* run : runs) {
+        rewind(run);
+        readers.append(make<LineReader>(run));
+        String text;
+        if (readers.last()->read_line(text))
+            heads.append(make_line(move(text)));
+        else
+            heads.append(Optional<Line> {});
+    }
+
+    for (;;) {
+        Optional<size_t> smallest;
+        for (size_t i = 0; i < heads.size(); ++i) {
+            if (heads[i].has_value() && (!smallest.has_value() || line_less_than(heads[i].value(), heads[smallest.value()].value())))
+                smallest = i;
+        }
+        if (!smallest.has_value())
             break;
-        lines.append({ buffer, AK::ShouldChomp::Chomp });
+        write_line(output, heads[smallest.value()]->text);
+        String text;
+        if (readers[smallest.value()]->read_line(text))
+            heads[smallest.value()] = make_line(move(text));
+        else
+            heads[smallest.value()].clear();
+    }
+
+    for (auto* run : runs)
+        fclose(run);
+    runs.clear();
+}
+
+int main(int argc, char** argv)
+{
+    if (pledge("stdio rpath wpath cpath thread", nullptr) < 0) {
+        perror("pledge");
+        return 1;
     }
 
-    quick_sort(lines, [](auto& a, auto& b) {
-        return strcmp(a.characters(), b.characters()) < 0;
-    });
+    const char* key = nullptr;
+    const char* separator = nullptr;
+    int buffer_size_in_mib = 64;
+    Vector<const char*> paths;
 
-    for (auto& line : lines) {
-        fputs(line.characters(), stdout);
-        fputc('\n', stdout);
+    Core::ArgsParser args_parser;
+    args_parser.set_general_help("Sort lines of text. Input that doesn't fit in the buffer is sorted in temporary files.");
+    args_parser.add_option(key, "Sort by fields START to END (1-based, END defaults to the end of the line)", "key", 'k', "START[,END]");
+    args_parser.add_option(separator, "Separate fields with this character instead of blanks", "field-separator", 't', "char");
+    args_parser.add_option(s_options.numeric, "Compare keys as numbers", "numeric-sort", 'n');
+    args_parser.add_option(s_options.reverse, "Reverse the order", "reverse", 'r');
+    args_parser.add_option(buffer_size_in_mib, "Use at most this much memory for lines (default 64)", "buffer-size", 'S', "MiB");
+    args_parser.add_option(s_temporary_directory, "Put temporary files here (default /tmp)", "temporary-directory", 'T', "directory");
+    args_parser.add_positional_argument(paths, "Files to sort (default: standard input)", "file", Core::ArgsParser::Required::No);
+    args_parser.parse(argc, argv);
+
+    if (key) {
+        auto parts = StringView(key).split_view(',', true);
+        auto start = parts.size() >= 1 ? parts[0].to_uint() : Optional<unsigned> {};
+        auto end = parts.size() == 2 ? parts[1].to_uint() : Optional<unsigned> {};
+        if (!start.has_value() || start.value() == 0 || parts.size() > 2 || (parts.size() == 2 && (!end.has_value() || end.value() < start.value()))) {
+            warnln("sort: invalid key '{}'", key);
+            return 1;
+        }
+        s_options.key_start_field = start.value();
+        s_options.key_end_field = end.value_or(0);
+    }
+    if (separator) {
+        if (strlen(separator) != 1) {
+            warnln("sort: the field separator must be a single character");
+            return 1;
+        }
+        s_options.field_separator = separator[0];
+    }
+    if (buffer_size_in_mib <= 0) {
+        warnln("sort: invalid buffer size");
+        return 1;
+    }
+    size_t buffer_size = (size_t)buffer_size_in_mib * MiB;
+
+    Vector<FILE*> inputs;
+    if (paths.is_empty())
+        inputs.append(stdin);
+    for (auto* path : paths) {
+        auto* file = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+        if (!file) {
+            perror(path);
+            return 1;
+        }
+        inputs.append(file);
+    }
+
+    Vector<Line> lines;
+    size_t bytes_in_lines = 0;
+    Vector<FILE*> runs;
+
+    auto sort_lines = [&] {
+        LibThread::parallel_sort(lines.span(), [](auto& a, auto& b) { return line_less_than(a, b); });
+    };
+    auto write_run = [&] {
+        sort_lines();
+        auto* run = create_run_file();
+        for (auto& line : lines)
+            write_line(run, line.text);
+        finish_writing(run);
+        runs.append(run);
+        lines.clear();
+        bytes_in_lines = 0;
+    };
+
+    for (auto* input : inputs) {
+        LineReader reader(input);
+        String text;
+        while (reader.read_line(text)) {
+            bytes_in_lines += text.length() + line_overhead;
+            lines.append(make_line(move(text)));
+            if (bytes_in_lines >= buffer_size)
+                write_run();
+        }
+        if (input != stdin)
+            fclose(input);
+    }
+
+    if (runs.is_empty()) {
+        sort_lines();
+        for (auto& line : lines)
+            write_line(stdout, line.text);
+        return 0;
+    }
+
+    if (!lines.is_empty())
+        write_run();
+    // Free the buffer before merging; we won't need it anymore.
+    lines = {};
+
+    while (runs.size() > max_merge_fan_in) {
+        Vector<FILE*> merged_runs;
+        for (size_t i = 0; i < runs.size(); i += max_merge_fan_in) {
+            Vector<FILE*> group;
+            for (size_t j = i; j < min(i + max_merge_fan_in, runs.size()); ++j)
+                group.append(runs[j]);
+            auto* merged = create_run_file();
+            merge_runs(group, merged);
+            finish_writing(merged);
+            merged_runs.append(merged);
+        }
+        runs = move(merged_runs);
     }
+    merge_runs(runs, stdout);
 
     return 0;
 }
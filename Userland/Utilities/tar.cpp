@@ -24,9 +24,13 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Buffered.h>
 #include <AK/LogStream.h>
+#include <AK/MappedFile.h>
+#include <AK/OwnPtr.h>
 #include <AK/Vector.h>
 #include <LibCompress/Gzip.h>
+#include <LibCompress/ParallelGzip.h>
 #include <LibCore/ArgsParser.h>
 #include <LibCore/FileStream.h>
 #include <LibTar/TarStream.h>
@@ -34,7 +38,7 @@
 #include <stdio.h>
 #include <sys/stat.h>
 
-constexpr size_t buffer_size = 4096;
+constexpr size_t buffer_size = 64 * KiB;
 
 int main(int argc, char** argv)
 {
@@ -73,11 +77,22 @@ int main(int argc, char** argv)
             file = maybe_file.value();
         }
 
-        Core::InputFileStream file_stream(file);
+        Buffered<Core::InputFileStream, 64 * KiB> file_stream(file);
         Compress::GzipDecompressor gzip_stream(file_stream);
 
+        // Archives made of many small gzip members (e.g. by bgzip) can be decompressed on all cores.
+        RefPtr<MappedFile> mapped_archive;
+        OwnPtr<Compress::ParallelGzipDecompressor> parallel_gzip_stream;
+        if (gzip && archive_file) {
+            if (auto mapped_file_or_error = MappedFile::map(archive_file); !mapped_file_or_error.is_error()) {
+                mapped_archive = mapped_file_or_error.release_value();
+                if (auto members = Compress::ParallelGzipDecompressor::split_into_members(mapped_archive->bytes()); members.has_value() && members->size() > 1)
+                    parallel_gzip_stream = make<Compress::ParallelGzipDecompressor>(members.release_value());
+            }
+        }
+
         InputStream& file_input_stream = file_stream;
-        InputStream& gzip_input_stream = gzip_stream;
+        InputStream& gzip_input_stream = parallel_gzip_stream ? static_cast<InputStream&>(*parallel_gzip_stream) : gzip_stream;
         Tar::TarStream tar_stream((gzip) ? gzip_input_stream : file_input_stream);
         if (!tar_stream.valid()) {
             warnln("the provided file is not a well-formatted ustar file");
@@ -124,7 +139,6 @@ int main(int argc, char** argv)
                 }
             }
         }
-        file_stream.close();
         return 0;
     }
 
@@ -28,6 +28,7 @@
 
 #include <AK/Array.h>
 #include <AK/MemoryStream.h>
+#include <AK/StringBuilder.h>
 #include <LibCompress/Deflate.h>
 #include <LibCompress/Gzip.h>
 #include <LibCompress/Zlib.h>
@@ -131,6 +132,106 @@ TEST_CASE(deflate_decompress_zeroes)
     EXPECT(uncompressed == decompressed.value().bytes());
 }
 
+// 128 lines of text compressed into a single block with dynamic Huffman codes, mixing literals and back-references.
+static const Array<u8, 596> compressed_text {
+        0x7d, 0xd6, 0x4b, 0x76, 0xdb, 0x30, 0x0c, 0x05, 0xd0, 0x79, 0x57, 0xc1,
+        0x15, 0xf4, 0x90, 0xe0, 0x5f, 0x6b, 0xc8, 0x26, 0x94, 0x44, 0x8d, 0x95,
+        0xb8, 0x56, 0x6a, 0x27, 0xb6, 0x9b, 0xd5, 0x57, 0x90, 0xc8, 0x0c, 0x7a,
+        0xf0, 0x30, 0xf0, 0x04, 0x90, 0xf8, 0xc1, 0x3d, 0xb6, 0xdf, 0xc3, 0x7c,
+        0x9a, 0x8c, 0x1d, 0xcc, 0xc7, 0x61, 0xea, 0x9f, 0x9f, 0x3f, 0x1e, 0xb8,
+        0xe8, 0x06, 0xf3, 0xe7, 0x73, 0x7e, 0x7a, 0x33, 0xc7, 0xf1, 0xeb, 0xaf,
+        0x39, 0x4c, 0xf7, 0x56, 0xa7, 0xc1, 0x3c, 0x9e, 0x97, 0xdb, 0xc9, 0xbc,
+        0x2e, 0xd7, 0x79, 0x3c, 0x9a, 0xdb, 0x61, 0x3e, 0xf6, 0x77, 0xfc, 0x60,
+        0x7e, 0x2d, 0x77, 0xf3, 0xfa, 0xf9, 0xfb, 0xfd, 0x62, 0x96, 0xeb, 0x74,
+        0x6e, 0xf5, 0x30, 0xb4, 0xda, 0x6d, 0xfe, 0x1a, 0xcf, 0xcf, 0x97, 0x7d,
+        0xe5, 0xd6, 0x8c, 0xc3, 0xf6, 0x68, 0xdb, 0x6d, 0x5f, 0xb5, 0xb5, 0xd2,
+        0x60, 0x46, 0xf3, 0xbc, 0xbc, 0x98, 0xcb, 0x74, 0x9d, 0x4e, 0xad, 0x98,
+        0x87, 0xfd, 0x48, 0xef, 0xe3, 0xd3, 0xdb, 0x7c, 0x7a, 0x31, 0x63, 0xab,
+        0x97, 0x61, 0x7b, 0x74, 0x5b, 0x6b, 0x3b, 0x61, 0xab, 0xd7, 0x61, 0x3f,
+        0x23, 0x6f, 0x30, 0x7d, 0x1c, 0xbf, 0x5f, 0xec, 0xf7, 0x5c, 0x6f, 0xbf,
+        0x2d, 0xdf, 0xae, 0xd5, 0x8e, 0xd8, 0xbb, 0xeb, 0x18, 0xfa, 0xa1, 0xf7,
+        0x55, 0x78, 0xef, 0xde, 0xa4, 0xe1, 0x7b, 0xd1, 0xc7, 0xe5, 0x3e, 0x5d,
+        0xf8, 0xf6, 0xbd, 0xb7, 0xce, 0x62, 0x1d, 0xda, 0x7a, 0xfe, 0xad, 0xd3,
+        0xab, 0x3c, 0x89, 0x7d, 0x6e, 0xdc, 0x6c, 0x2f, 0xf7, 0xe6, 0x3a, 0x89,
+        0x7e, 0x29, 0x1e, 0xe3, 0x7a, 0x9b, 0xde, 0x59, 0x07, 0xb1, 0x6f, 0xb0,
+        0x9f, 0x74, 0x1b, 0x66, 0xef, 0x65, 0x51, 0xaf, 0x00, 0x3e, 0x57, 0x15,
+        0x3f, 0xb2, 0x00, 0x90, 0x9c, 0x26, 0x48, 0x84, 0x09, 0xc9, 0x4b, 0x86,
+        0x14, 0x00, 0x22, 0x45, 0xa0, 0x48, 0x49, 0x67, 0xa4, 0xac, 0x31, 0x52,
+        0x51, 0x18, 0xa9, 0x62, 0x46, 0x6f, 0x25, 0x46, 0xef, 0x14, 0x46, 0x4f,
+        0x88, 0xd1, 0x7b, 0xcc, 0xe8, 0x83, 0xc4, 0xe8, 0x23, 0x60, 0xf4, 0x49,
+        0xfb, 0x1a, 0x66, 0xc0, 0xe8, 0x8b, 0xc6, 0xe8, 0x2b, 0x66, 0x0c, 0x56,
+        0x62, 0x0c, 0x0e, 0x30, 0x06, 0x02, 0x8c, 0xc1, 0xeb, 0x8c, 0x21, 0x68,
+        0x8c, 0x21, 0x2a, 0x8c, 0x21, 0x61, 0xc6, 0x90, 0x25, 0xc6, 0x50, 0x14,
+        0xc6, 0x50, 0x11, 0x63, 0xb4, 0x98, 0x31, 0x3a, 0x89, 0x31, 0x12, 0x60,
+        0x8c, 0x5e, 0x61, 0x8c, 0x01, 0x30, 0xc6, 0xa8, 0xfe, 0x9e, 0x26, 0xcc,
+        0x18, 0xb3, 0xc4, 0x18, 0x0b, 0x60, 0x8c, 0x15, 0x30, 0x26, 0xab, 0x33,
+        0x26, 0xa7, 0x31, 0x26, 0x52, 0x18, 0x93, 0xc7, 0x8c, 0x29, 0x48, 0x8c,
+        0x29, 0x2a, 0x8c, 0x29, 0x21, 0xc6, 0x94, 0x31, 0x63, 0x2a, 0x12, 0x63,
+        0xaa, 0x80, 0x31, 0x5b, 0x85, 0x31, 0x3b, 0xc0, 0x98, 0x49, 0x63, 0xcc,
+        0x1e, 0x33, 0xe6, 0x20, 0xfe, 0x31, 0x46, 0xc0, 0x98, 0x13, 0x60, 0xcc,
+        0x59, 0x67, 0xcc, 0x45, 0x63, 0xcc, 0x55, 0x61, 0x2c, 0x16, 0x33, 0x16,
+        0x27, 0x31, 0x16, 0x52, 0x18, 0x8b, 0x47, 0x8c, 0x25, 0x60, 0xc6, 0x12,
+        0x25, 0xc6, 0x92, 0x00, 0x63, 0xc9, 0x0a, 0x63, 0x29, 0x80, 0xb1, 0x54,
+        0x8d, 0xb1, 0x5a, 0xcc, 0x58, 0x9d, 0xc4, 0x58, 0x09, 0x30, 0x56, 0x8f,
+        0x12, 0x4e, 0xd0, 0x19, 0x6b, 0xd4, 0x18, 0x6b, 0x52, 0x18, 0x6b, 0xc6,
+        0x8c, 0xb5, 0x48, 0x8c, 0xb5, 0x6a, 0x11, 0xc7, 0x5a, 0x98, 0x71, 0xac,
+        0x53, 0x42, 0x8e, 0x25, 0x31, 0xe5, 0x58, 0x8f, 0x62, 0x8e, 0x0d, 0x8a,
+        0xa5, 0xb3, 0x11, 0x60, 0x3a, 0x9b, 0x34, 0x4d, 0x67, 0x33, 0xe6, 0x74,
+        0xb6, 0x48, 0x9e, 0xce, 0x56, 0x00, 0xea, 0x38, 0x7b, 0x8a, 0xa2, 0x6e,
+        0xcb, 0x9d, 0x5a, 0x6a, 0xe5, 0xec, 0xa9, 0xc5, 0x56, 0xaf, 0xe5, 0x56,
+        0x8e, 0xa1, 0x30, 0xb8, 0x72, 0x0c, 0x15, 0x92, 0x2b, 0x67, 0x50, 0xec,
+        0xca, 0x29, 0x14, 0xb8, 0x72, 0x14, 0x85, 0xae, 0x1c, 0x47, 0x05, 0x57,
+        0xb2, 0xc8, 0x95, 0x93, 0x28, 0x76, 0xe5, 0x24, 0x2a, 0xbb, 0x72, 0x0e,
+        0x55, 0x5c, 0x39, 0x90, 0x42, 0x57, 0x0e, 0xa5, 0x82, 0x2b, 0x47, 0x52,
+        0xd9, 0x95, 0xc3, 0xe8, 0xff, 0xae, 0xff, 0x00
+};
+
+static String expected_text()
+{
+    static const char* words[] = {
+        "the", "quick", "brown", "fox", "jumps", "over", "a", "lazy", "dog", "while", "seven", "wizards",
+        "quietly", "hex", "jovial", "packing", "boxes"
+    };
+    constexpr size_t word_count = sizeof(words) / sizeof(words[0]);
+
+    StringBuilder builder;
+    for (size_t i = 0; i < 128; ++i)
+        builder.appendff("Line {}: {} {} {}.\n", i, words[i % word_count], words[(i * 7) % word_count], words[(i * 13) % word_count]);
+    return builder.to_string();
+}
+
+TEST_CASE(deflate_decompress_dynamic_codes)
+{
+    const auto uncompressed = expected_text();
+
+    const auto decompressed = Compress::DeflateDecompressor::decompress_all(compressed_text);
+    EXPECT(decompressed.value().bytes() == uncompressed.bytes());
+}
+
+BENCHMARK_CASE(deflate_decompress_dynamic_codes)
+{
+    const auto uncompressed = expected_text();
+
+    for (size_t i = 0; i < 5000; ++i) {
+        const auto decompressed = Compress::DeflateDecompressor::decompress_all(compressed_text);
+        EXPECT_EQ(decompressed.value().size(), uncompressed.length());
+    }
+}
+
+BENCHMARK_CASE(deflate_decompress_zeroes)
+{
+    // 4 KiB of zeroes, which decode to little more than a chain of overlapping back-references.
+    const Array<u8, 20> compressed {
+        0xed, 0xc1, 0x01, 0x0d, 0x00, 0x00, 0x00, 0xc2, 0xa0, 0xf7, 0x4f, 0x6d,
+        0x0f, 0x07, 0x14, 0x00, 0x00, 0x00, 0xf0, 0x6e
+    };
+
+    for (size_t i = 0; i < 20000; ++i) {
+        const auto decompressed = Compress::DeflateDecompressor::decompress_all(compressed);
+        EXPECT_EQ(decompressed.value().size(), 4096u);
+    }
+}
+
 TEST_CASE(zlib_decompress_simple)
 {
     const Array<u8, 40> compressed {
@@ -176,6 +277,22 @@ TEST_CASE(gzip_decompress_multiple_members)
     EXPECT(decompressed.value().bytes() == (ReadonlyBytes { uncompressed, sizeof(uncompressed) - 1 }));
 }
 
+TEST_CASE(gzip_decompress_extra_field)
+{
+    // A BGZF member (as written by bgzip), with its size in a "BC" extra subfield.
+    const Array<u8, 41> compressed {
+        0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x06, 0x00,
+        0x42, 0x43, 0x02, 0x00, 0x28, 0x00, 0x2b, 0xcf, 0x2f, 0x4a, 0x31, 0x54,
+        0x48, 0x4c, 0x4a, 0x56, 0x28, 0x07, 0xb2, 0x8c, 0x00, 0xc2, 0x1d, 0x22,
+        0x15, 0x0f, 0x00, 0x00, 0x00
+    };
+
+    const u8 uncompressed[] = "word1 abc word2";
+
+    const auto decompressed = Compress::GzipDecompressor::decompress_all(compressed);
+    EXPECT(decompressed.value().bytes() == (ReadonlyBytes { uncompressed, sizeof(uncompressed) - 1 }));
+}
+
 TEST_CASE(gzip_decompress_zeroes)
 {
     const Array<u8, 161> compressed {
@@ -221,4 +338,84 @@ TEST_CASE(gzip_decompress_repeat_around_buffer)
     EXPECT(uncompressed == decompressed.value().bytes());
 }
 
+// Text, noise and runs of zeroes, spread over several compressor blocks.
+static ByteBuffer compression_test_data()
+{
+    const auto text = expected_text();
+
+    ByteBuffer data;
+    for (size_t i = 0; i < 16; ++i)
+        data.append(text.characters(), text.length());
+
+    u32 state = 0x12345678;
+    for (size_t i = 0; i < 40000; ++i) {
+        state = state * 1103515245 + 12345;
+        u8 byte = state >> 24;
+        data.append(&byte, 1);
+    }
+
+    auto zeroes = ByteBuffer::create_zeroed(70000);
+    data.append(zeroes.data(), zeroes.size());
+    data.append(text.characters(), text.length());
+    return data;
+}
+
+TEST_CASE(deflate_compress_round_trip)
+{
+    using Level = Compress::DeflateCompressor::CompressionLevel;
+
+    const auto original = compression_test_data();
+    for (auto level : { Level::Store, Level::Fast, Level::Good, Level::Best }) {
+        const auto compressed = Compress::DeflateCompressor::compress_all(original, level);
+        const auto decompressed = Compress::DeflateDecompressor::decompress_all(compressed.value());
+        EXPECT(decompressed.value() == original);
+
+        if (level != Level::Store)
+            EXPECT(compressed.value().size() < original.size() / 2);
+    }
+}
+
+TEST_CASE(deflate_compress_empty)
+{
+    const auto compressed = Compress::DeflateCompressor::compress_all({});
+    const auto decompressed = Compress::DeflateDecompressor::decompress_all(compressed.value());
+    EXPECT(decompressed.value().is_empty());
+}
+
+TEST_CASE(deflate_compress_streaming)
+{
+    const auto original = compression_test_data();
+
+    DuplexMemoryStream output_stream;
+    Compress::DeflateCompressor deflate_stream { output_stream };
+    for (size_t offset = 0; offset < original.size(); offset += 1000)
+        EXPECT(deflate_stream.write_or_error(original.bytes().slice(offset, min<size_t>(1000, original.size() - offset))));
+    deflate_stream.final_flush();
+    EXPECT(!deflate_stream.handle_any_error());
+
+    const auto decompressed = Compress::DeflateDecompressor::decompress_all(output_stream.copy_into_contiguous_buffer());
+    EXPECT(decompressed.value() == original);
+}
+
+TEST_CASE(gzip_compress_round_trip)
+{
+    const auto original = compression_test_data();
+    const auto compressed = Compress::GzipCompressor::compress_all(original);
+    const auto decompressed = Compress::GzipDecompressor::decompress_all(compressed.value());
+    EXPECT(decompressed.value() == original);
+}
+
+BENCHMARK_CASE(deflate_compress)
+{
+    using Level = Compress::DeflateCompressor::CompressionLevel;
+
+    const auto original = compression_test_data();
+    for (auto level : { Level::Fast, Level::Good, Level::Best }) {
+        size_t compressed_size = 0;
+        for (size_t i = 0; i < 10; ++i)
+            compressed_size = Compress::DeflateCompressor::compress_all(original, level).value().size();
+        EXPECT(compressed_size < original.size());
+    }
+}
+
 TEST_MAIN(Compress)
@@ -29,6 +29,7 @@
 #include <LibCore/ConfigFile.h>
 #include <LibCore/EventLoop.h>
 #include <LibCore/File.h>
+#include <LibCrypto/CPUFeatures.h>
 #include <LibCrypto/Authentication/GHash.h>
 #include <LibCrypto/Authentication/HMAC.h>
 #include <LibCrypto/BigInt/SignedBigInteger.h>
@@ -36,6 +37,7 @@
 #include <LibCrypto/Checksum/Adler32.h>
 #include <LibCrypto/Checksum/CRC32.h>
 #include <LibCrypto/Cipher/AES.h>
+#include <LibCrypto/Curves/X25519.h>
 #include <LibCrypto/Hash/MD5.h>
 #include <LibCrypto/Hash/SHA1.h>
 #include <LibCrypto/Hash/SHA2.h>
@@ -57,6 +59,7 @@ static bool interactive = false;
 static bool run_tests = false;
 static int port = 443;
 static bool in_ci = false;
+static bool no_hardware_acceleration = false;
 
 static struct timeval start_time {
     0, 0
@@ -93,6 +96,7 @@ static int ghash_tests();
 
 // Public-Key
 static int rsa_tests();
+static int x25519_tests();
 
 // TLS
 static int tls_tests();
@@ -104,6 +108,9 @@ static int bigint_tests();
 static int adler32_tests();
 static int crc32_tests();
 
+// Benchmarks
+static int benchmarks();
+
 // stop listing tests
 
 static void print_buffer(ReadonlyBytes buffer, int split)
@@ -323,8 +330,12 @@ auto main(int argc, char** argv) -> int
     parser.add_option(port, "Set the port to talk to (only for `tls')", "port", 'p', "port");
     parser.add_option(ca_certs_file, "INI file to read root CA certificates from (only for `tls')", "ca-certs-file", 0, "file");
     parser.add_option(in_ci, "CI Test mode", "ci-mode", 'c');
+    parser.add_option(no_hardware_acceleration, "Only use the portable implementations, even if the CPU could do better", "no-hardware-acceleration", 0);
     parser.parse(argc, argv);
 
+    if (no_hardware_acceleration)
+        Crypto::set_hardware_acceleration_enabled(false);
+
     StringView mode_sv { mode };
     if (mode_sv == "list") {
         puts("test-crypto modes");
@@ -339,6 +350,7 @@ auto main(int argc, char** argv) -> int
         puts("\ttest -- Run every test suite");
         puts("\tbigint -- Run big integer test suite");
         puts("\tpk -- Run Public-key system tests");
+        puts("\tbench -- Measure the throughput of the ciphers and MACs");
         return 0;
     }
 
@@ -420,11 +432,16 @@ auto main(int argc, char** argv) -> int
         return 1;
     }
     if (mode_sv == "pk") {
-        return rsa_tests();
+        rsa_tests();
+        x25519_tests();
+        return g_some_test_failed ? 1 : 0;
     }
     if (mode_sv == "bigint") {
         return bigint_tests();
     }
+    if (mode_sv == "bench") {
+        return benchmarks();
+    }
     if (mode_sv == "tls") {
         if (!Core::File::exists(ca_certs_file)) {
             warnln("Nonexistent CA certs file '{}'", ca_certs_file);
@@ -465,7 +482,11 @@ auto main(int argc, char** argv) -> int
 
         ghash_tests();
 
+        adler32_tests();
+        crc32_tests();
+
         rsa_tests();
+        x25519_tests();
 
         if (!in_ci) {
             // Do not run these in CI to avoid tests with variables outside our control.
@@ -600,7 +621,11 @@ static void rsa_test_encrypt_decrypt();
 static void rsa_emsa_pss_test_create();
 static void bigint_test_number_theory(); // FIXME: we should really move these num theory stuff out
 
+static void x25519_test_scalar_multiplication();
+static void x25519_test_key_agreement();
+
 static void tls_test_client_hello();
+static void tls_test_session_resumption();
 
 static void bigint_test_fibo500();
 static void bigint_addition_edgecases();
@@ -1515,8 +1540,65 @@ static void ghash_test_process()
         } else
             PASS;
     }
-    // TODO: Add some GHash tests?
-    //       Kinda hard, as there are no vectors and existing tools don't have an interface to it.
+    {
+        I_TEST((GHash | Hardware and software agree));
+        if (!Crypto::cpu_supports_pclmulqdq()) {
+            printf("skipped, no PCLMULQDQ\n");
+        } else {
+            auto key = ByteBuffer::create_uninitialized(16);
+            auto data = ByteBuffer::create_uninitialized(1000);
+            fill_with_random(key.data(), key.size());
+            fill_with_random(data.data(), data.size());
+            Crypto::Authentication::GHash ghash(key.bytes());
+
+            bool ok = true;
+            for (size_t aad_size : { 0, 13, 16, 40 }) {
+                for (size_t cipher_size : { 0, 1, 16, 31, 960 }) {
+                    auto aad = data.bytes().slice(0, aad_size);
+                    auto cipher = data.bytes().slice(aad_size, cipher_size);
+                    auto hardware_tag = ghash.process(aad, cipher);
+                    Crypto::set_hardware_acceleration_enabled(false);
+                    auto software_tag = ghash.process(aad, cipher);
+                    Crypto::set_hardware_acceleration_enabled(true);
+                    if (memcmp(hardware_tag.data, software_tag.data, sizeof(hardware_tag.data)) != 0)
+                        ok = false;
+                }
+            }
+            if (!ok) {
+                FAIL(Tags differ);
+            } else {
+                PASS;
+            }
+        }
+    }
+}
+
+// Hashes random data of various lengths (in various pieces) with and without the SHA extensions.
+template<typename HashType>
+static void test_hardware_and_software_hashes_agree()
+{
+    if (!Crypto::cpu_supports_sha_ni()) {
+        printf("skipped, no SHA extensions\n");
+        return;
+    }
+    u8 data[1000];
+    fill_with_random(data, sizeof(data));
+    for (size_t length : { 0, 55, 56, 64, 65, 200, 1000 }) {
+        typename HashType::DigestType digests[2];
+        for (auto& digest : digests) {
+            HashType hasher;
+            hasher.update(data, length / 3);
+            hasher.update(data + length / 3, length - length / 3);
+            digest = hasher.digest();
+            Crypto::set_hardware_acceleration_enabled(false);
+        }
+        Crypto::set_hardware_acceleration_enabled(true);
+        if (memcmp(digests[0].data, digests[1].data, HashType::digest_size()) != 0) {
+            FAIL(Digests differ);
+            return;
+        }
+    }
+    PASS;
 }
 
 static int sha1_tests()
@@ -1589,6 +1671,10 @@ static void sha1_test_hash()
         } else
             PASS;
     }
+    {
+        I_TEST((SHA1 Hashing | Hardware and software agree));
+        test_hardware_and_software_hashes_agree<Crypto::Hash::SHA1>();
+    }
 }
 
 static int sha256_tests()
@@ -1635,6 +1721,10 @@ static void sha256_test_hash()
         } else
             PASS;
     }
+    {
+        I_TEST((SHA256 Hashing | Hardware and software agree));
+        test_hardware_and_software_hashes_agree<Crypto::Hash::SHA256>();
+    }
 }
 
 static void hmac_sha256_test_name()
@@ -1880,6 +1970,18 @@ static void bigint_test_number_theory()
             }
         }
     }
+    {
+        I_TEST((Number Theory | Modular Power with a big prime));
+        // 2^1279 - 1 is a Mersenne prime, so Fermat's little theorem applies.
+        auto prime = Crypto::UnsignedBigInteger(1).shift_left(1279).minus(1);
+        auto base = Crypto::NumberTheory::Power(Crypto::UnsignedBigInteger(3), Crypto::UnsignedBigInteger(1000));
+        auto base_mod_prime = base.divided_by(prime).remainder;
+        if (Crypto::NumberTheory::ModularPower(base, prime.minus(1), prime) == 1 && Crypto::NumberTheory::ModularPower(base, prime, prime) == base_mod_prime) {
+            PASS;
+        } else {
+            FAIL(Wrong result);
+        }
+    }
     {
         struct {
             Crypto::UnsignedBigInteger candidate;
@@ -2066,9 +2168,76 @@ static void rsa_test_encrypt_decrypt()
     }
 }
 
+static int x25519_tests()
+{
+    x25519_test_scalar_multiplication();
+    x25519_test_key_agreement();
+    return g_some_test_failed ? 1 : 0;
+}
+
+// Test vectors from RFC 7748, section 5.2 and 6.1
+static void x25519_test_scalar_multiplication()
+{
+    I_TEST((X25519 | Scalar Multiplication));
+    u8 scalar[] { 0xa5, 0x46, 0xe3, 0x6b, 0xf0, 0x52, 0x7c, 0x9d, 0x3b, 0x16, 0x15, 0x4b, 0x82, 0x46, 0x5e, 0xdd, 0x62, 0x14, 0x4c, 0x0a, 0xc1, 0xfc, 0x5a, 0x18, 0x50, 0x6a, 0x22, 0x44, 0xba, 0x44, 0x9a, 0xc4 };
+    u8 point[] { 0xe6, 0xdb, 0x68, 0x67, 0x58, 0x30, 0x30, 0xdb, 0x35, 0x94, 0xc1, 0xa4, 0x24, 0xb1, 0x5f, 0x7c, 0x72, 0x66, 0x24, 0xec, 0x26, 0xb3, 0x35, 0x3b, 0x10, 0xa9, 0x03, 0xa6, 0xd0, 0xab, 0x1c, 0x4c };
+    u8 expected[] { 0xc3, 0xda, 0x55, 0x37, 0x9d, 0xe9, 0xc6, 0x90, 0x8e, 0x94, 0xea, 0x4d, 0xf2, 0x8d, 0x08, 0x4f, 0x32, 0xec, 0xcf, 0x03, 0x49, 0x1c, 0x71, 0xf7, 0x54, 0xb4, 0x07, 0x55, 0x77, 0xa2, 0x85, 0x52 };
+    u8 result[Crypto::Curves::X25519::key_size];
+    if (!Crypto::Curves::X25519::compute_shared_secret({ scalar, sizeof(scalar) }, { point, sizeof(point) }, { result, sizeof(result) }))
+        FAIL(Rejected valid point);
+    else if (memcmp(result, expected, sizeof(expected)) != 0)
+        FAIL(Invalid result);
+    else
+        PASS;
+}
+
+static void x25519_test_key_agreement()
+{
+    u8 alice_private_key[] { 0x77, 0x07, 0x6d, 0x0a, 0x73, 0x18, 0xa5, 0x7d, 0x3c, 0x16, 0xc1, 0x72, 0x51, 0xb2, 0x66, 0x45, 0xdf, 0x4c, 0x2f, 0x87, 0xeb, 0xc0, 0x99, 0x2a, 0xb1, 0x77, 0xfb, 0xa5, 0x1d, 0xb9, 0x2c, 0x2a };
+    u8 alice_public_key[] { 0x85, 0x20, 0xf0, 0x09, 0x89, 0x30, 0xa7, 0x54, 0x74, 0x8b, 0x7d, 0xdc, 0xb4, 0x3e, 0xf7, 0x5a, 0x0d, 0xbf, 0x3a, 0x0d, 0x26, 0x38, 0x1a, 0xf4, 0xeb, 0xa4, 0xa9, 0x8e, 0xaa, 0x9b, 0x4e, 0x6a };
+    u8 bob_private_key[] { 0x5d, 0xab, 0x08, 0x7e, 0x62, 0x4a, 0x8a, 0x4b, 0x79, 0xe1, 0x7f, 0x8b, 0x83, 0x80, 0x0e, 0xe6, 0x6f, 0x3b, 0xb1, 0x29, 0x26, 0x18, 0xb6, 0xfd, 0x1c, 0x2f, 0x8b, 0x27, 0xff, 0x88, 0xe0, 0xeb };
+    u8 bob_public_key[] { 0xde, 0x9e, 0xdb, 0x7d, 0x7b, 0x7d, 0xc1, 0xb4, 0xd3, 0x5b, 0x61, 0xc2, 0xec, 0xe4, 0x35, 0x37, 0x3f, 0x83, 0x43, 0xc8, 0x5b, 0x78, 0x67, 0x4d, 0xad, 0xfc, 0x7e, 0x14, 0x6f, 0x88, 0x2b, 0x4f };
+    u8 shared_secret[] { 0x4a, 0x5d, 0x9d, 0x5b, 0xa4, 0xce, 0x2d, 0xe1, 0x72, 0x8e, 0x3b, 0xf4, 0x80, 0x35, 0x0f, 0x25, 0xe0, 0x7e, 0x21, 0xc9, 0x47, 0xd1, 0x9e, 0x33, 0x76, 0xf0, 0x9b, 0x3c, 0x1e, 0x16, 0x17, 0x42 };
+    u8 result[Crypto::Curves::X25519::key_size];
+
+    {
+        I_TEST((X25519 | Public Key));
+        Crypto::Curves::X25519::compute_public_key({ alice_private_key, sizeof(alice_private_key) }, { result, sizeof(result) });
+        if (memcmp(result, alice_public_key, sizeof(result)) != 0) {
+            FAIL(Invalid public key for Alice);
+        } else {
+            Crypto::Curves::X25519::compute_public_key({ bob_private_key, sizeof(bob_private_key) }, { result, sizeof(result) });
+            if (memcmp(result, bob_public_key, sizeof(result)) != 0)
+                FAIL(Invalid public key for Bob);
+            else
+                PASS;
+        }
+    }
+    {
+        I_TEST((X25519 | Shared Secret));
+        bool alice_ok = Crypto::Curves::X25519::compute_shared_secret({ alice_private_key, sizeof(alice_private_key) }, { bob_public_key, sizeof(bob_public_key) }, { result, sizeof(result) })
+            && memcmp(result, shared_secret, sizeof(result)) == 0;
+        bool bob_ok = Crypto::Curves::X25519::compute_shared_secret({ bob_private_key, sizeof(bob_private_key) }, { alice_public_key, sizeof(alice_public_key) }, { result, sizeof(result) })
+            && memcmp(result, shared_secret, sizeof(result)) == 0;
+        if (!alice_ok || !bob_ok)
+            FAIL(Invalid shared secret);
+        else
+            PASS;
+    }
+    {
+        I_TEST((X25519 | Reject Low Order Point));
+        u8 zero_point[Crypto::Curves::X25519::key_size] {};
+        if (Crypto::Curves::X25519::compute_shared_secret({ alice_private_key, sizeof(alice_private_key) }, { zero_point, sizeof(zero_point) }, { result, sizeof(result) }))
+            FAIL(Accepted all-zero shared secret);
+        else
+            PASS;
+    }
+}
+
 static int tls_tests()
 {
     tls_test_client_hello();
+    tls_test_session_resumption();
     return g_some_test_failed ? 1 : 0;
 }
 
@@ -2123,10 +2292,80 @@ static void tls_test_client_hello()
     loop.exec();
 }
 
+static void tls_test_session_resumption()
+{
+    // This relies on tls_test_client_hello() having connected to the same server before.
+    I_TEST((TLS | Session Resumption));
+    Core::EventLoop loop;
+    RefPtr<TLS::TLSv12> tls = TLS::TLSv12::construct(nullptr);
+    tls->set_root_certificates(s_root_ca_certificates);
+    bool sent_request = false;
+    size_t received_size = 0;
+    tls->on_tls_ready_to_write = [&](TLS::TLSv12& tls) {
+        if (sent_request)
+            return;
+        sent_request = true;
+        if (!tls.is_session_resumed()) {
+            FAIL(Session was not resumed);
+            loop.quit(1);
+            return;
+        }
+        if (!tls.write("GET / HTTP/1.1\r\nConnection : close\r\n\r\n"_b)) {
+            FAIL(write() failed);
+            loop.quit(1);
+        }
+    };
+    tls->on_tls_ready_to_read = [&](TLS::TLSv12& tls) {
+        if (auto data = tls.read(); data.has_value())
+            received_size += data.value().size();
+    };
+    tls->on_tls_finished = [&] {
+        if (received_size) {
+            PASS;
+        } else {
+            FAIL(No data received);
+        }
+        loop.quit(0);
+    };
+    tls->on_tls_error = [&](TLS::AlertDescription) {
+        FAIL(Connection failure);
+        loop.quit(1);
+    };
+    if (!tls->connect(server ?: DEFAULT_SERVER, port)) {
+        FAIL(connect() failed);
+        return;
+    }
+    loop.exec();
+}
+
+template<typename ChecksumType>
+static void test_hardware_and_software_checksums_agree()
+{
+    auto data = ByteBuffer::create_uninitialized(100000);
+    fill_with_random(data.data(), data.size());
+    for (size_t length : { 0, 1, 31, 32, 33, 63, 64, 65, 100, 1000, 5552, 100000 }) {
+        u32 checksums[2];
+        for (auto& checksum : checksums) {
+            // Split the input at an odd offset, so that the second half isn't aligned.
+            ChecksumType checksum_function;
+            checksum_function.update(data.bytes().slice(0, length / 3));
+            checksum_function.update(data.bytes().slice(length / 3, length - length / 3));
+            checksum = checksum_function.digest();
+            Crypto::set_hardware_acceleration_enabled(false);
+        }
+        Crypto::set_hardware_acceleration_enabled(true);
+        if (checksums[0] != checksums[1]) {
+            FAIL(Checksums differ);
+            return;
+        }
+    }
+    PASS;
+}
+
 static int adler32_tests()
 {
     auto do_test = [](ReadonlyBytes input, u32 expected_result) {
-        I_TEST((CRC32));
+        I_TEST((Adler32));
 
         auto pass = Crypto::Checksum::Adler32(input).digest() == expected_result;
 
@@ -2142,6 +2381,14 @@ static int adler32_tests()
     do_test(String("abc").bytes(), 0x024d0127);
     do_test(String("message digest").bytes(), 0x29750586);
     do_test(String("abcdefghijklmnopqrstuvwxyz").bytes(), 0x90860b20);
+    do_test(String::repeated('a', 1000).bytes(), 0xf9d87af8);
+    // All bytes at their maximum value push the sums as close to overflowing as they get.
+    do_test(String::repeated('\xff', 100000).bytes(), 0x149a302c);
+
+    {
+        I_TEST((Adler32 | Hardware and software agree));
+        test_hardware_and_software_checksums_agree<Crypto::Checksum::Adler32>();
+    }
 
     return g_some_test_failed ? 1 : 0;
 }
@@ -2149,7 +2396,7 @@ static int adler32_tests()
 static int crc32_tests()
 {
     auto do_test = [](ReadonlyBytes input, u32 expected_result) {
-        I_TEST((Adler32));
+        I_TEST((CRC32));
 
         auto pass = Crypto::Checksum::CRC32(input).digest() == expected_result;
 
@@ -2163,6 +2410,13 @@ static int crc32_tests()
     do_test(String("").bytes(), 0x0);
     do_test(String("The quick brown fox jumps over the lazy dog").bytes(), 0x414FA339);
     do_test(String("various CRC algorithms input data").bytes(), 0x9BD366AE);
+    do_test(String::repeated('a', 1000).bytes(), 0x9a38da03);
+    do_test(String::repeated('\xff', 100000).bytes(), 0x68c6cec4);
+
+    {
+        I_TEST((CRC32 | Hardware and software agree));
+        test_hardware_and_software_checksums_agree<Crypto::Checksum::CRC32>();
+    }
 
     return g_some_test_failed ? 1 : 0;
 }
@@ -2357,6 +2611,19 @@ static void bigint_multiplication()
             FAIL(Incorrect Result);
         }
     }
+    {
+        I_TEST((BigInteger | Karatsuba Multiplication));
+        auto num1 = Crypto::NumberTheory::Power(Crypto::UnsignedBigInteger(3), Crypto::UnsignedBigInteger(1500));
+        auto num2 = Crypto::NumberTheory::Power(Crypto::UnsignedBigInteger(7), Crypto::UnsignedBigInteger(900));
+        auto result = num1.multiplied_by(num2);
+        auto by_num1 = result.divided_by(num1);
+        auto by_num2 = result.divided_by(num2);
+        if (by_num1.quotient == num2 && by_num1.remainder == 0 && by_num2.quotient == num1 && by_num2.remainder == 0) {
+            PASS;
+        } else {
+            FAIL(Wrong result);
+        }
+    }
 }
 static void bigint_division()
 {
@@ -2779,3 +3046,71 @@ static void bigint_signed_bitwise()
         }
     }
 }
+
+static void benchmark(const char* name, size_t size, Function<void()> fn)
+{
+    struct timeval begin, end;
+    gettimeofday(&begin, nullptr);
+    fn();
+    gettimeofday(&end, nullptr);
+    double seconds = (end.tv_sec - begin.tv_sec) + (end.tv_usec - begin.tv_usec) / 1000000.0;
+    printf("%-28s %10.2f MiB/s\n", name, (double)size / MiB / seconds);
+    fflush(stdout);
+}
+
+static void run_benchmarks()
+{
+    constexpr size_t size = 16 * MiB;
+    auto key = ByteBuffer::create_uninitialized(16);
+    auto iv = ByteBuffer::create_zeroed(16);
+    auto in = ByteBuffer::create_uninitialized(size);
+    auto out = ByteBuffer::create_uninitialized(size + 16);
+    fill_with_random(key.data(), key.size());
+    fill_with_random(in.data(), in.size());
+    auto out_span = out.bytes();
+
+    {
+        Crypto::Cipher::AESCipher::CBCMode cipher(key, 128, Crypto::Cipher::Intent::Encryption);
+        benchmark("AES-128-CBC encrypt", size, [&] { cipher.encrypt(in, out_span, iv); });
+    }
+    {
+        Crypto::Cipher::AESCipher::CBCMode cipher(key, 128, Crypto::Cipher::Intent::Decryption);
+        auto decrypted = ByteBuffer::create_uninitialized(size);
+        auto decrypted_span = decrypted.bytes();
+        auto encrypted = out_span.slice(0, size);
+        benchmark("AES-128-CBC decrypt", size, [&] { cipher.decrypt(encrypted, decrypted_span, iv); });
+    }
+    {
+        Crypto::Cipher::AESCipher::CTRMode cipher(key, 128, Crypto::Cipher::Intent::Encryption);
+        benchmark("AES-128-CTR", size, [&] { cipher.encrypt(in, out_span, iv); });
+    }
+    {
+        Crypto::Cipher::AESCipher::GCMMode cipher(key, 128, Crypto::Cipher::Intent::Encryption);
+        auto tag = ByteBuffer::create_uninitialized(16);
+        auto gcm_out = out_span.slice(0, size);
+        benchmark("AES-128-GCM encrypt", size, [&] { cipher.encrypt(in, gcm_out, iv, {}, tag); });
+    }
+    {
+        Crypto::Authentication::GHash ghash(key.bytes());
+        benchmark("GHASH", size, [&] { (void)ghash.process({}, in); });
+    }
+    benchmark("MD5", size, [&] { (void)Crypto::Hash::MD5::hash(in.data(), in.size()); });
+    benchmark("SHA1", size, [&] { (void)Crypto::Hash::SHA1::hash(in.data(), in.size()); });
+    benchmark("SHA256", size, [&] { (void)Crypto::Hash::SHA256::hash(in.data(), in.size()); });
+    benchmark("SHA512", size, [&] { (void)Crypto::Hash::SHA512::hash(in.data(), in.size()); });
+    benchmark("CRC32", size, [&] { (void)Crypto::Checksum::CRC32(in).digest(); });
+    benchmark("Adler32", size, [&] { (void)Crypto::Checksum::Adler32(in).digest(); });
+}
+
+static int benchmarks()
+{
+    bool has_hardware_acceleration = Crypto::cpu_supports_aes_ni() || Crypto::cpu_supports_pclmulqdq() || Crypto::cpu_supports_sha_ni();
+    printf("AES-NI: %s, PCLMULQDQ: %s, SHA: %s\n", Crypto::cpu_supports_aes_ni() ? "yes" : "no", Crypto::cpu_supports_pclmulqdq() ? "yes" : "no", Crypto::cpu_supports_sha_ni() ? "yes" : "no");
+    run_benchmarks();
+    if (has_hardware_acceleration) {
+        puts("Without hardware acceleration:");
+        Crypto::set_hardware_acceleration_enabled(false);
+        run_benchmarks();
+    }
+    return 0;
+}
@@ -34,6 +34,7 @@
 #include <LibCore/ArgsParser.h>
 #include <LibCore/DirIterator.h>
 #include <LibCore/File.h>
+#include <LibJS/Heap/HeapBlock.h>
 #include <LibJS/Interpreter.h>
 #include <LibJS/Lexer.h>
 #include <LibJS/Parser.h>
@@ -134,8 +135,9 @@ protected:
 
     virtual Vector<String> get_test_paths() const;
     virtual JSFileResult run_file_test(const String& test_path);
+    virtual void did_run_file(JS::Interpreter&, const JSFileResult&) { }
     void print_file_result(const JSFileResult& file_result) const;
-    void print_test_results() const;
+    virtual void print_test_results() const;
 
     String m_test_root;
     bool m_print_times;
@@ -383,6 +385,8 @@ JSFileResult TestRunner::run_file_test(const String& test_path)
     file_result.time_taken = get_time_in_ms() - start_time;
     m_total_elapsed_time_in_ms += file_result.time_taken;
 
+    did_run_file(*interpreter, file_result);
+
     return file_result;
 }
 
@@ -684,6 +688,142 @@ JSFileResult Test262ParserTestRunner::run_file_test(const String& test_path)
     return file_result;
 }
 
+// Runs the workloads that the files in benchmarks/ register with benchmark(). Each file runs once as
+// a test first, which doubles as the first warmup; workloads that fail it aren't timed.
+class BenchmarkRunner final : public TestRunner {
+public:
+    BenchmarkRunner(String test_root, bool print_times, int warmup_runs, int timed_runs)
+        : TestRunner(move(test_root), print_times)
+        , m_warmup_runs(warmup_runs)
+        , m_timed_runs(timed_runs)
+    {
+    }
+
+private:
+    struct BenchmarkResult {
+        String name;
+        bool failed { false };
+        double mean_time_in_ms { 0 };
+        double min_time_in_ms { 0 };
+        size_t collections { 0 };
+        u64 total_pause_us { 0 };
+        size_t peak_heap_size { 0 };
+    };
+
+    virtual Vector<String> get_test_paths() const override;
+    virtual void did_run_file(JS::Interpreter&, const JSFileResult&) override;
+    virtual void print_test_results() const override;
+
+    BenchmarkResult run_benchmark(JS::Interpreter&, const String& name, JS::Function&);
+
+    int m_warmup_runs { 0 };
+    int m_timed_runs { 0 };
+    Vector<BenchmarkResult> m_results;
+};
+
+Vector<String> BenchmarkRunner::get_test_paths() const
+{
+    Vector<String> paths;
+    for (auto& path : TestRunner::get_test_paths()) {
+        if (path.contains("/benchmarks/"))
+            paths.append(path);
+    }
+    return paths;
+}
+
+static bool test_passed(const JSFileResult& file_result, const String& test_name)
+{
+    for (auto& suite : file_result.suites) {
+        for (auto& test : suite.tests) {
+            if (test.name == test_name)
+                return test.result == TestResult::Pass;
+        }
+    }
+    return false;
+}
+
+void BenchmarkRunner::did_run_file(JS::Interpreter& interpreter, const JSFileResult& file_result)
+{
+    auto& global_object = interpreter.global_object();
+    auto benchmarks = interpreter.vm().get_variable("__Benchmarks__", global_object);
+    if (!benchmarks.is_object())
+        return;
+
+    for (auto& entry : benchmarks.as_array().indexed_properties()) {
+        auto& benchmark = entry.value_and_attributes(&global_object).value.as_object();
+        auto name = benchmark.get("name").to_string_without_side_effects();
+        auto callback = benchmark.get("callback");
+        if (!callback.is_function() || !test_passed(file_result, name)) {
+            m_results.append({ name, true });
+            continue;
+        }
+        m_results.append(run_benchmark(interpreter, name, callback.as_function()));
+    }
+}
+
+BenchmarkRunner::BenchmarkResult BenchmarkRunner::run_benchmark(JS::Interpreter& interpreter, const String& name, JS::Function& callback)
+{
+    auto& vm = interpreter.vm();
+    auto& heap = interpreter.heap();
+    BenchmarkResult result { name };
+
+    auto run_once = [&] {
+        [[maybe_unused]] auto rc = vm.call(callback, JS::js_undefined());
+        if (!vm.exception())
+            return true;
+        vm.clear_exception();
+        return false;
+    };
+
+    for (int i = 0; i < m_warmup_runs; ++i) {
+        if (!run_once()) {
+            result.failed = true;
+            return result;
+        }
+    }
+
+    // Start from a clean heap, so the garbage left behind by the warmup runs isn't counted.
+    heap.collect_garbage();
+    heap.block_allocator().reset_peak_live_block_count();
+    auto statistics_before = heap.statistics();
+
+    double total_time_in_ms = 0;
+    for (int i = 0; i < m_timed_runs; ++i) {
+        auto start_time = get_time_in_ms();
+        if (!run_once()) {
+            result.failed = true;
+            return result;
+        }
+        auto time_in_ms = get_time_in_ms() - start_time;
+        total_time_in_ms += time_in_ms;
+        result.min_time_in_ms = i == 0 ? time_in_ms : min(result.min_time_in_ms, time_in_ms);
+    }
+
+    auto& statistics_after = heap.statistics();
+    result.mean_time_in_ms = total_time_in_ms / m_timed_runs;
+    result.collections = statistics_after.collections - statistics_before.collections;
+    result.total_pause_us = statistics_after.total_pause_us - statistics_before.total_pause_us;
+    result.peak_heap_size = heap.block_allocator().peak_live_block_count() * JS::HeapBlock::block_size;
+    return result;
+}
+
+void BenchmarkRunner::print_test_results() const
+{
+    TestRunner::print_test_results();
+
+    outln("Benchmarks ({} warmup runs, {} timed runs):", m_warmup_runs, m_timed_runs);
+    outln("{:<40} {:>10} {:>10} {:>5} {:>10} {:>10}", "Name", "Mean ms", "Min ms", "GCs", "GC ms", "Peak KiB");
+    for (auto& result : m_results) {
+        if (result.failed) {
+            outln("{:<40} {:>10}", result.name, "FAILED");
+            continue;
+        }
+        outln("{:<40} {:>10.2} {:>10.2} {:>5} {:>10.2} {:>10}",
+            result.name, result.mean_time_in_ms, result.min_time_in_ms, result.collections,
+            result.total_pause_us / 1000.0, result.peak_heap_size / KiB);
+    }
+}
+
 int main(int argc, char** argv)
 {
     struct sigaction act;
@@ -707,12 +847,18 @@ int main(int argc, char** argv)
 
     bool print_times = false;
     bool test262_parser_tests = false;
+    bool run_benchmarks = false;
+    int warmup_runs = 2;
+    int timed_runs = 5;
     const char* specified_test_root = nullptr;
 
     Core::ArgsParser args_parser;
     args_parser.add_option(print_times, "Show duration of each test", "show-time", 't');
     args_parser.add_option(collect_on_every_allocation, "Collect garbage after every allocation", "collect-often", 'g');
     args_parser.add_option(test262_parser_tests, "Run test262 parser tests", "test262-parser-tests", 0);
+    args_parser.add_option(run_benchmarks, "Time the workloads in benchmarks/ instead of running the tests", "benchmark", 'b');
+    args_parser.add_option(warmup_runs, "Untimed runs of each benchmark (default 2)", "warmup-runs", 0, "count");
+    args_parser.add_option(timed_runs, "Timed runs of each benchmark (default 5)", "runs", 0, "count");
     args_parser.add_positional_argument(specified_test_root, "Tests root directory", "path", Core::ArgsParser::Required::No);
     args_parser.parse(argc, argv);
 
@@ -727,6 +873,17 @@ int main(int argc, char** argv)
         }
     }
 
+    if (run_benchmarks) {
+        if (test262_parser_tests) {
+            warnln("--benchmark and --test262-parser-tests options must not be used together");
+            return 1;
+        }
+        if (warmup_runs < 0 || timed_runs <= 0) {
+            warnln("Benchmarks need at least one timed run");
+            return 1;
+        }
+    }
+
     if (getenv("DISABLE_DBG_OUTPUT")) {
         AK::set_debug_enabled(false);
     }
@@ -756,6 +913,8 @@ int main(int argc, char** argv)
 
     if (test262_parser_tests)
         Test262ParserTestRunner(test_root, print_times).run();
+    else if (run_benchmarks)
+        BenchmarkRunner(test_root, print_times, warmup_runs, timed_runs).run();
     else
         TestRunner(test_root, print_times).run();
 
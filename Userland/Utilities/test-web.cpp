@@ -27,6 +27,7 @@
 #include <AK/Function.h>
 #include <AK/JsonObject.h>
 #include <AK/JsonValue.h>
+#include <AK/LexicalPath.h>
 #include <AK/QuickSort.h>
 #include <AK/URL.h>
 #include <LibCore/ArgsParser.h>
@@ -36,14 +37,20 @@
 #include <LibGUI/BoxLayout.h>
 #include <LibGUI/Widget.h>
 #include <LibGUI/Window.h>
+#include <LibGfx/Bitmap.h>
+#include <LibGfx/Painter.h>
 #include <LibJS/Interpreter.h>
 #include <LibJS/Lexer.h>
 #include <LibJS/Parser.h>
 #include <LibJS/Runtime/Array.h>
 #include <LibJS/Runtime/JSONObject.h>
+#include <LibWeb/DOM/Document.h>
 #include <LibWeb/HTML/Parser/HTMLDocumentParser.h>
 #include <LibWeb/InProcessWebView.h>
+#include <LibWeb/Layout/InitialContainingBlockBox.h>
 #include <LibWeb/Loader/ResourceLoader.h>
+#include <LibWeb/Painting/PaintContext.h>
+#include <LibWeb/RenderingStatistics.h>
 #include <signal.h>
 #include <sys/time.h>
 
@@ -658,10 +665,127 @@ void TestRunner::print_test_results() const
     }
 }
 
+// Loads saved pages over and over, and reports how long each rendering phase took on average.
+class PageBenchmarkRunner {
+public:
+    PageBenchmarkRunner(Vector<String> page_paths, Web::InProcessWebView& page_view, int runs)
+        : m_page_paths(move(page_paths))
+        , m_page_view(page_view)
+        , m_runs(runs)
+    {
+    }
+
+    void run();
+
+private:
+    static constexpr int viewport_width = 800;
+    static constexpr int viewport_height = 600;
+
+    void run_page(const String& page_path);
+    void paint(Web::DOM::Document&);
+
+    Vector<String> m_page_paths;
+    RefPtr<Web::InProcessWebView> m_page_view;
+    int m_runs { 0 };
+};
+
+void PageBenchmarkRunner::run()
+{
+    m_page_view->resize(viewport_width, viewport_height);
+
+    auto& statistics = Web::RenderingStatistics::the();
+    statistics.set_enabled(true);
+    for (auto& page_path : m_page_paths)
+        run_page(page_path);
+    statistics.set_enabled(false);
+}
+
+void PageBenchmarkRunner::run_page(const String& page_path)
+{
+    using Phase = Web::RenderingStatistics::Phase;
+    constexpr size_t phase_count = (size_t)Phase::__Count;
+
+    auto file = Core::File::construct(page_path);
+    if (!file->open(Core::IODevice::ReadOnly)) {
+        printf("Failed to open page %s: %s\n", page_path.characters(), file->error_string());
+        return;
+    }
+    auto data = file->read_all();
+    auto url = URL::create_with_file_protocol(page_path);
+
+    auto& statistics = Web::RenderingStatistics::the();
+    Array<Web::RenderingStatistics::PhaseStatistics, phase_count> totals {};
+    double total_time_in_ms = 0;
+
+    for (int i = 0; i < m_runs; ++i) {
+        statistics.reset();
+        auto start_time = get_time_in_ms();
+
+        auto document = Web::DOM::Document::create(url);
+        Web::HTML::HTMLDocumentParser parser(document, data, "utf-8");
+        parser.run(url);
+        m_page_view->set_document(document.ptr());
+        paint(*document);
+
+        total_time_in_ms += get_time_in_ms() - start_time;
+        for (size_t phase = 0; phase < phase_count; ++phase) {
+            auto& phase_statistics = statistics.statistics_for((Phase)phase);
+            totals[phase].count += phase_statistics.count;
+            totals[phase].total_us += phase_statistics.total_us;
+            totals[phase].allocations += phase_statistics.allocations;
+        }
+    }
+    m_page_view->set_document(nullptr);
+
+    printf("%s: %d runs, %.2f ms per run\n", LexicalPath(page_path).basename().characters(), m_runs, total_time_in_ms / m_runs);
+    printf("    %-8s %10s %10s %14s\n", "Phase", "Calls", "ms/run", "Allocs/run");
+    for (size_t phase = 0; phase < phase_count; ++phase) {
+        auto& total = totals[phase];
+        printf("    %-8s %10zu %10.2f %14zu\n", Web::RenderingStatistics::phase_name((Phase)phase),
+            total.count / m_runs, total.total_us / 1000.0 / m_runs, total.allocations / m_runs);
+    }
+}
+
+void PageBenchmarkRunner::paint(Web::DOM::Document& document)
+{
+    auto* layout_root = document.layout_node();
+    if (!layout_root)
+        return;
+
+    // Paint what a window of the viewport's size would show, but into a bitmap of our own.
+    auto bitmap = Gfx::Bitmap::create(Gfx::BitmapFormat::RGB32, { viewport_width, viewport_height });
+    Gfx::Painter painter(*bitmap);
+    Web::PaintContext context(painter, GUI::Application::the()->palette(), {});
+    context.set_viewport_rect({ 0, 0, viewport_width, viewport_height });
+    layout_root->paint_all_phases(context);
+}
+
+static Vector<String> get_benchmark_page_paths(const Vector<const char*>& paths)
+{
+    Vector<String> page_paths;
+    for (auto* path : paths) {
+        if (!Core::File::is_directory(path)) {
+            page_paths.append(path);
+            continue;
+        }
+        Vector<String> paths_in_directory;
+        iterate_directory_recursively(path, [&](const String& file_path) {
+            if (file_path.ends_with(".html"))
+                paths_in_directory.append(file_path);
+        });
+        quick_sort(paths_in_directory);
+        page_paths.append(move(paths_in_directory));
+    }
+    return page_paths;
+}
+
 int main(int argc, char** argv)
 {
     bool print_times = false;
     bool show_window = false;
+    bool run_benchmarks = false;
+    int benchmark_runs = 5;
+    Vector<const char*> benchmark_paths;
 
 #if 0
     struct sigaction act;
@@ -678,6 +802,9 @@ int main(int argc, char** argv)
     Core::ArgsParser args_parser;
     args_parser.add_option(print_times, "Show duration of each test", "show-time", 't');
     args_parser.add_option(show_window, "Show window while running tests", "window", 'w');
+    args_parser.add_option(run_benchmarks, "Time parsing, style, layout and painting of saved pages instead of running the tests", "benchmark", 'b');
+    args_parser.add_option(benchmark_runs, "How many times to load each page (default 5)", "runs", 0, "count");
+    args_parser.add_positional_argument(benchmark_paths, "Pages or directories of pages to benchmark (default: the Benchmarks directory of the tests)", "pages", Core::ArgsParser::Required::No);
     args_parser.parse(argc, argv);
 
     auto app = GUI::Application::construct(argc, argv);
@@ -696,14 +823,30 @@ int main(int argc, char** argv)
     }
 
 #ifdef __serenity__
-    TestRunner("/home/anon/web-tests", "/home/anon/js-tests", view, print_times).run();
+    String web_test_root = "/home/anon/web-tests";
+    String js_test_root = "/home/anon/js-tests";
 #else
     char* serenity_root = getenv("SERENITY_ROOT");
     if (!serenity_root) {
         printf("test-web requires the SERENITY_ROOT environment variable to be set");
         return 1;
     }
-    TestRunner(String::format("%s/Userland/Libraries/LibWeb/Tests", serenity_root), String::format("%s/Userland/Libraries/LibJS/Tests", serenity_root), view, print_times).run();
+    String web_test_root = String::format("%s/Userland/Libraries/LibWeb/Tests", serenity_root);
+    String js_test_root = String::format("%s/Userland/Libraries/LibJS/Tests", serenity_root);
 #endif
+
+    if (run_benchmarks) {
+        if (benchmark_runs <= 0) {
+            printf("Benchmarks need at least one run\n");
+            return 1;
+        }
+        auto default_benchmark_path = String::formatted("{}/Benchmarks", web_test_root);
+        if (benchmark_paths.is_empty())
+            benchmark_paths.append(default_benchmark_path.characters());
+        PageBenchmarkRunner(get_benchmark_page_paths(benchmark_paths), view, benchmark_runs).run();
+        return 0;
+    }
+
+    TestRunner(web_test_root, js_test_root, view, print_times).run();
     return 0;
 }
@@ -58,9 +58,17 @@ struct ThreadData {
     unsigned inode_faults;
     unsigned zero_faults;
     unsigned cow_faults;
+    unsigned major_faults;
+    unsigned context_switches;
+    u64 block_io_wait_us;
+    u64 scheduler_latency_us;
     unsigned times_scheduled;
 
     unsigned times_scheduled_since_prev { 0 };
+    unsigned major_faults_since_prev { 0 };
+    unsigned context_switches_since_prev { 0 };
+    u64 block_io_wait_us_since_prev { 0 };
+    u64 scheduler_latency_us_since_prev { 0 };
     unsigned cpu_percent { 0 };
     unsigned cpu_percent_decimal { 0 };
 
@@ -92,7 +100,9 @@ struct Snapshot {
 
 static Snapshot get_snapshot()
 {
-    auto all_processes = Core::ProcessStatisticsReader::get_all();
+    // Keep the file open between snapshots so we don't have to look it up again every time.
+    static RefPtr<Core::File> s_proc_stats;
+    auto all_processes = Core::ProcessStatisticsReader::get_all(s_proc_stats);
     if (!all_processes.has_value())
         return {};
 
@@ -120,6 +130,10 @@ static Snapshot get_snapshot()
             thread_data.inode_faults = thread.inode_faults;
             thread_data.zero_faults = thread.zero_faults;
             thread_data.cow_faults = thread.cow_faults;
+            thread_data.major_faults = thread.major_faults;
+            thread_data.context_switches = thread.voluntary_context_switches + thread.involuntary_context_switches;
+            thread_data.block_io_wait_us = thread.block_io_wait_us;
+            thread_data.scheduler_latency_us = thread.scheduler_latency_us;
             thread_data.times_scheduled = thread.times_scheduled;
             thread_data.priority = thread.priority;
             thread_data.state = thread.state;
@@ -142,7 +156,7 @@ int main(int, char**)
         return 1;
     }
 
-    if (unveil("/proc/all", "r") < 0) {
+    if (unveil("/proc/stats", "r") < 0) {
         perror("unveil");
         return 1;
     }
@@ -180,7 +194,7 @@ int main(int, char**)
         auto sum_diff = current.sum_times_scheduled - prev.sum_times_scheduled;
 
         printf("\033[3J\033[H\033[2J");
-        printf("\033[47;30m%6s %3s %3s  %-9s  %-10s  %6s  %6s  %4s  %s\033[K\033[0m\n",
+        printf("\033[47;30m%6s %3s %3s  %-9s  %-10s  %6s  %6s  %4s  %4s  %5s  %5s  %5s  %s\033[K\033[0m\n",
             "PID",
             "TID",
             "PRI",
@@ -189,6 +203,10 @@ int main(int, char**)
             "VIRT",
             "PHYS",
             "%CPU",
+            "MAJF",
+            "CSW",
+            "IOW",
+            "SCHW",
             "NAME");
         for (auto& it : current.map) {
             auto pid_and_tid = it.key;
@@ -198,9 +216,13 @@ int main(int, char**)
             auto jt = prev.map.find(pid_and_tid);
             if (jt == prev.map.end())
                 continue;
-            u32 times_scheduled_before = (*jt).value.times_scheduled;
-            u32 times_scheduled_diff = times_scheduled_now - times_scheduled_before;
+            auto& before = (*jt).value;
+            u32 times_scheduled_diff = times_scheduled_now - before.times_scheduled;
             it.value.times_scheduled_since_prev = times_scheduled_diff;
+            it.value.major_faults_since_prev = it.value.major_faults - before.major_faults;
+            it.value.context_switches_since_prev = it.value.context_switches - before.context_switches;
+            it.value.block_io_wait_us_since_prev = it.value.block_io_wait_us - before.block_io_wait_us;
+            it.value.scheduler_latency_us_since_prev = it.value.scheduler_latency_us - before.scheduler_latency_us;
             it.value.cpu_percent = ((times_scheduled_diff * 100) / sum_diff);
             it.value.cpu_percent_decimal = (((times_scheduled_diff * 1000) / sum_diff) % 10);
             threads.append(&it.value);
@@ -212,7 +234,7 @@ int main(int, char**)
 
         int row = 0;
         for (auto* thread : threads) {
-            int nprinted = printf("%6d %3d %2u   %-9s  %-10s  %6zu  %6zu  %2u.%1u  ",
+            int nprinted = printf("%6d %3d %2u   %-9s  %-10s  %6zu  %6zu  %2u.%1u  %4u  %5u  %5llu  %5llu  ",
                 thread->pid,
                 thread->tid,
                 thread->priority,
@@ -221,7 +243,11 @@ int main(int, char**)
                 thread->amount_virtual / 1024,
                 thread->amount_resident / 1024,
                 thread->cpu_percent,
-                thread->cpu_percent_decimal);
+                thread->cpu_percent_decimal,
+                thread->major_faults_since_prev,
+                thread->context_switches_since_prev,
+                thread->block_io_wait_us_since_prev / 1000,
+                thread->scheduler_latency_us_since_prev / 1000);
 
             int remaining = g_window_size.ws_col - nprinted;
             fwrite(thread->name.characters(), 1, max(0, min(remaining, (int)thread->name.length())), stdout);
@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2021, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/JsonArray.h>
+#include <AK/JsonObject.h>
+#include <AK/JsonValue.h>
+#include <AK/String.h>
+#include <LibCore/ArgsParser.h>
+#include <LibCore/File.h>
+#include <LibCore/LocalSocket.h>
+#include <stdio.h>
+#include <unistd.h>
+
+// Talks to the RPC socket every Core::EventLoop listens on to turn TRACE_SCOPE tracing on and off,
+// and to collect the traces of several processes into one Chrome trace.
+
+static RefPtr<Core::LocalSocket> connect_to(pid_t pid)
+{
+    auto socket = Core::LocalSocket::construct();
+    socket->set_blocking(true);
+    if (!socket->connect(Core::SocketAddress::local(String::formatted("/tmp/rpc/{}", pid)))) {
+        warnln("Couldn't connect to PID {}", pid);
+        return nullptr;
+    }
+    return socket;
+}
+
+static bool send_request(Core::LocalSocket& socket, const JsonObject& request)
+{
+    auto serialized = request.to_string();
+    u32 length = serialized.length();
+    return socket.write((const u8*)&length, sizeof(length)) && socket.write(serialized);
+}
+
+static Optional<JsonObject> receive_response(Core::LocalSocket& socket)
+{
+    u32 length;
+    if (socket.read((u8*)&length, sizeof(length)) != sizeof(length))
+        return {};
+    auto buffer = ByteBuffer::create_uninitialized(length);
+    size_t nread = 0;
+    while (nread < length) {
+        int rc = socket.read(buffer.data() + nread, length - nread);
+        if (rc <= 0)
+            return {};
+        nread += rc;
+    }
+    auto json = JsonValue::from_string(buffer);
+    if (!json.has_value() || !json.value().is_object())
+        return {};
+    return json.value().as_object();
+}
+
+static void disconnect(Core::LocalSocket& socket)
+{
+    JsonObject request;
+    request.set("type", "Disconnect");
+    send_request(socket, request);
+}
+
+static bool set_tracing_enabled(pid_t pid, bool enabled)
+{
+    auto socket = connect_to(pid);
+    if (!socket)
+        return false;
+    JsonObject request;
+    request.set("type", "SetTracingEnabled");
+    request.set("enabled", enabled);
+    bool success = send_request(*socket, request);
+    disconnect(*socket);
+    return success;
+}
+
+static bool append_trace_events(pid_t pid, JsonArray& events)
+{
+    auto socket = connect_to(pid);
+    if (!socket)
+        return false;
+    JsonObject request;
+    request.set("type", "GetTrace");
+    if (!send_request(*socket, request))
+        return false;
+    auto response = receive_response(*socket);
+    disconnect(*socket);
+    if (!response.has_value()) {
+        warnln("PID {} sent an invalid response", pid);
+        return false;
+    }
+    auto trace = JsonValue::from_string(response.value().get("trace").to_string());
+    if (!trace.has_value() || !trace.value().is_object()) {
+        warnln("PID {} sent an invalid trace", pid);
+        return false;
+    }
+    for (auto& event : trace.value().as_object().get("traceEvents").as_array().values())
+        events.append(event);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if (pledge("stdio unix rpath wpath cpath", nullptr) < 0) {
+        perror("pledge");
+        return 1;
+    }
+
+    const char* command = nullptr;
+    Vector<const char*> pids;
+    const char* output_path = nullptr;
+
+    Core::ArgsParser args_parser;
+    args_parser.set_general_help("Control scoped tracing in running processes and collect their traces.");
+    args_parser.add_option(output_path, "Where to write the trace for the dump command (default: standard output)", "output", 'o', "path");
+    args_parser.add_positional_argument(command, "One of start, stop or dump", "command");
+    args_parser.add_positional_argument(pids, "Processes to control", "pids");
+    args_parser.parse(argc, argv);
+
+    String command_string = command;
+    if (command_string != "start" && command_string != "stop" && command_string != "dump") {
+        warnln("Unknown command '{}'", command);
+        return 1;
+    }
+
+    Vector<pid_t> pid_values;
+    for (auto* pid : pids) {
+        auto value = String(pid).to_int();
+        if (!value.has_value()) {
+            warnln("Invalid PID '{}'", pid);
+            return 1;
+        }
+        pid_values.append(value.value());
+    }
+
+    if (command_string != "dump") {
+        bool success = true;
+        for (auto pid : pid_values)
+            success &= set_tracing_enabled(pid, command_string == "start");
+        return success ? 0 : 1;
+    }
+
+    // Every process timestamps its events with the same monotonic clock, so their
+    // events can simply be put together to follow a request from process to process.
+    JsonArray events;
+    for (auto pid : pid_values) {
+        if (!append_trace_events(pid, events))
+            return 1;
+    }
+    JsonObject trace;
+    trace.set("traceEvents", move(events));
+    auto serialized = trace.to_string();
+
+    if (!output_path) {
+        out("{}", serialized);
+        return 0;
+    }
+    auto file_or_error = Core::File::open(output_path, Core::IODevice::WriteOnly);
+    if (file_or_error.is_error()) {
+        warnln("Failed to open {}: {}", output_path, file_or_error.error());
+        return 1;
+    }
+    if (!file_or_error.value()->write(serialized)) {
+        warnln("Failed to write {}", output_path);
+        return 1;
+    }
+    return 0;
+}
@@ -24,131 +24,237 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Atomic.h>
 #include <AK/MappedFile.h>
+#include <AK/MemoryStream.h>
+#include <AK/NonnullRefPtrVector.h>
 #include <AK/NumberFormat.h>
+#include <LibCompress/Deflate.h>
 #include <LibCore/ArgsParser.h>
 #include <LibCore/File.h>
+#include <LibCrypto/Checksum/CRC32.h>
+#include <LibThread/Thread.h>
+#include <errno.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
-static const u8 central_directory_file_header_sig[] = "\x50\x4b\x01\x02";
+static constexpr u32 end_of_central_directory_signature = 0x06054b50;
+static constexpr u32 central_directory_file_header_signature = 0x02014b50;
+static constexpr u32 local_file_header_signature = 0x04034b50;
 
-static bool seek_and_read(u8* buffer, const MappedFile& file, off_t seek_to, size_t bytes_to_read)
-{
-    if (!buffer)
-        return false;
+enum CompressionMethod {
+    None = 0,
+    Shrunk = 1,
+    Factor1 = 2,
+    Factor2 = 3,
+    Factor3 = 4,
+    Factor4 = 5,
+    Implode = 6,
+    Deflate = 8,
+    EnhancedDeflate = 9,
+    PKWareDCLImplode = 10,
+    BZIP2 = 12,
+    LZMA = 14,
+    TERSE = 18,
+    LZ77 = 19,
+};
 
-    if ((size_t)seek_to >= file.size())
-        return false;
+struct Entry {
+    String name;
+    u16 compression_method { 0 };
+    u32 crc32 { 0 };
+    u32 compressed_size { 0 };
+    u32 uncompressed_size { 0 };
+    u32 local_file_header_offset { 0 };
 
-    memcpy(buffer, (const char*)file.data() + seek_to, bytes_to_read);
+    bool is_directory() const { return name.ends_with("/"); }
+};
 
-    return true;
+static u16 read_u16(ReadonlyBytes bytes, size_t offset)
+{
+    return bytes[offset] | bytes[offset + 1] << 8;
 }
 
-static bool find_next_central_directory(off_t file_size, const MappedFile& file, off_t current_index, off_t& return_index)
+static u32 read_u32(ReadonlyBytes bytes, size_t offset)
 {
-    off_t start_index = current_index == 0 ? current_index : current_index + 1;
-    for (off_t index = start_index; index < file_size - 4; index++) {
-        u8 buffer[4];
-        if (!seek_and_read(buffer, file, index, 4))
-            return false;
-
-        if (!memcmp(buffer, central_directory_file_header_sig, 4)) {
-            return_index = index;
-            return true;
-        }
-    }
-    return false;
+    return bytes[offset] | bytes[offset + 1] << 8 | bytes[offset + 2] << 16 | (u32)bytes[offset + 3] << 24;
 }
 
-static bool unpack_file_for_central_directory_index(off_t central_directory_index, const MappedFile& file)
+// The central directory at the end of the archive lists every entry along with its sizes,
+// which the local file headers don't always have (when they are followed by a data descriptor.)
+static Optional<Vector<Entry>> read_central_directory(ReadonlyBytes archive)
 {
+    enum EndOfCentralDirectoryOffsets {
+        EOCDEntryCountOffset = 10,
+        EOCDCentralDirectorySizeOffset = 12,
+        EOCDCentralDirectoryOffsetOffset = 16,
+        EOCDSize = 22,
+    };
     enum CentralFileDirectoryHeaderOffsets {
         CFDHCompressionMethodOffset = 10,
+        CFDHCRC32Offset = 16,
+        CFDHCompressedSizeOffset = 20,
+        CFDHUncompressedSizeOffset = 24,
+        CFDHFileNameLengthOffset = 28,
+        CFDHExtraFieldLengthOffset = 30,
+        CFDHFileCommentLengthOffset = 32,
         CFDHLocalFileHeaderIndexOffset = 42,
+        CFDHFileNameBaseOffset = 46,
     };
+
+    if (archive.size() < EOCDSize)
+        return {};
+
+    // The end of central directory record is only followed by a comment of at most 64 KiB.
+    size_t lowest_offset = archive.size() > EOCDSize + 0xffff ? archive.size() - EOCDSize - 0xffff : 0;
+    Optional<size_t> end_offset;
+    for (size_t offset = archive.size() - EOCDSize + 1; offset-- > lowest_offset;) {
+        if (read_u32(archive, offset) == end_of_central_directory_signature) {
+            end_offset = offset;
+            break;
+        }
+    }
+    if (!end_offset.has_value())
+        return {};
+
+    size_t entry_count = read_u16(archive, end_offset.value() + EOCDEntryCountOffset);
+    size_t directory_size = read_u32(archive, end_offset.value() + EOCDCentralDirectorySizeOffset);
+    size_t directory_offset = read_u32(archive, end_offset.value() + EOCDCentralDirectoryOffsetOffset);
+    if (directory_offset > archive.size() || directory_size > archive.size() - directory_offset)
+        return {};
+    auto directory = archive.slice(directory_offset, directory_size);
+
+    Vector<Entry> entries;
+    size_t offset = 0;
+    for (size_t i = 0; i < entry_count; ++i) {
+        if (offset + CFDHFileNameBaseOffset > directory.size() || read_u32(directory, offset) != central_directory_file_header_signature)
+            return {};
+
+        size_t file_name_length = read_u16(directory, offset + CFDHFileNameLengthOffset);
+        size_t extra_field_length = read_u16(directory, offset + CFDHExtraFieldLengthOffset);
+        size_t file_comment_length = read_u16(directory, offset + CFDHFileCommentLengthOffset);
+        if (offset + CFDHFileNameBaseOffset + file_name_length > directory.size())
+            return {};
+
+        Entry entry;
+        entry.name = String((const char*)directory.offset(offset + CFDHFileNameBaseOffset), file_name_length);
+        entry.compression_method = read_u16(directory, offset + CFDHCompressionMethodOffset);
+        entry.crc32 = read_u32(directory, offset + CFDHCRC32Offset);
+        entry.compressed_size = read_u32(directory, offset + CFDHCompressedSizeOffset);
+        entry.uncompressed_size = read_u32(directory, offset + CFDHUncompressedSizeOffset);
+        entry.local_file_header_offset = read_u32(directory, offset + CFDHLocalFileHeaderIndexOffset);
+        entries.append(move(entry));
+
+        offset += CFDHFileNameBaseOffset + file_name_length + extra_field_length + file_comment_length;
+    }
+    return entries;
+}
+
+// Entries must not be able to write anywhere outside of the directory we're extracting into.
+static bool is_safe_path(const String& name)
+{
+    if (name.is_empty() || name.starts_with("/"))
+        return false;
+    for (auto& part : name.split_view('/')) {
+        if (part == "..")
+            return false;
+    }
+    return true;
+}
+
+static bool create_directory(const String& path)
+{
+    if (mkdir(path.characters(), 0755) < 0 && errno != EEXIST) {
+        perror("mkdir");
+        return false;
+    }
+    return true;
+}
+
+static bool create_parent_directories(const String& name)
+{
+    for (size_t i = 0; i < name.length(); ++i) {
+        if (name[i] == '/' && i > 0 && !create_directory(name.substring(0, i)))
+            return false;
+    }
+    return true;
+}
+
+static bool extract_file(const Entry& entry, ReadonlyBytes archive)
+{
     enum LocalFileHeaderOffsets {
-        LFHCompressionMethodOffset = 8,
-        LFHCompressedSizeOffset = 18,
         LFHFileNameLengthOffset = 26,
         LFHExtraFieldLengthOffset = 28,
         LFHFileNameBaseOffset = 30,
     };
-    enum CompressionMethod {
-        None = 0,
-        Shrunk = 1,
-        Factor1 = 2,
-        Factor2 = 3,
-        Factor3 = 4,
-        Factor4 = 5,
-        Implode = 6,
-        Deflate = 8,
-        EnhancedDeflate = 9,
-        PKWareDCLImplode = 10,
-        BZIP2 = 12,
-        LZMA = 14,
-        TERSE = 18,
-        LZ77 = 19,
-    };
-
-    u8 buffer[4];
-    if (!seek_and_read(buffer, file, central_directory_index + CFDHLocalFileHeaderIndexOffset, 4))
-        return false;
-    off_t local_file_header_index = buffer[3] << 24 | buffer[2] << 16 | buffer[1] << 8 | buffer[0];
 
-    if (!seek_and_read(buffer, file, local_file_header_index + LFHCompressionMethodOffset, 2))
+    size_t header_offset = entry.local_file_header_offset;
+    if (header_offset + LFHFileNameBaseOffset > archive.size() || read_u32(archive, header_offset) != local_file_header_signature) {
+        warnln("Could not find local file header for {}", entry.name);
         return false;
-    auto compression_method = buffer[1] << 8 | buffer[0];
-    // FIXME: Remove once any decompression is supported.
-    VERIFY(compression_method == None);
-
-    if (!seek_and_read(buffer, file, local_file_header_index + LFHCompressedSizeOffset, 4))
+    }
+    size_t data_offset = header_offset + LFHFileNameBaseOffset + read_u16(archive, header_offset + LFHFileNameLengthOffset) + read_u16(archive, header_offset + LFHExtraFieldLengthOffset);
+    if (data_offset > archive.size() || entry.compressed_size > archive.size() - data_offset) {
+        warnln("Contents of {} are out of bounds", entry.name);
         return false;
-    off_t compressed_file_size = buffer[3] << 24 | buffer[2] << 16 | buffer[1] << 8 | buffer[0];
+    }
+    auto compressed_contents = archive.slice(data_offset, entry.compressed_size);
 
-    if (!seek_and_read(buffer, file, local_file_header_index + LFHFileNameLengthOffset, 2))
+    if (entry.compression_method != CompressionMethod::None && entry.compression_method != CompressionMethod::Deflate) {
+        warnln("Can't extract {}: compression method {} is not supported", entry.name, entry.compression_method);
         return false;
-    off_t file_name_length = buffer[1] << 8 | buffer[0];
+    }
 
-    if (!seek_and_read(buffer, file, local_file_header_index + LFHExtraFieldLengthOffset, 2))
+    auto new_file = Core::File::construct(entry.name);
+    if (!new_file->open(Core::IODevice::WriteOnly)) {
+        warnln("Can't write file {}: {}", entry.name, new_file->error_string());
         return false;
-    off_t extra_field_length = buffer[1] << 8 | buffer[0];
+    }
 
-    char file_name[file_name_length + 1];
-    if (!seek_and_read((u8*)file_name, file, local_file_header_index + LFHFileNameBaseOffset, file_name_length))
-        return false;
-    file_name[file_name_length] = '\0';
+    outln(" extracting: {}", entry.name);
 
-    if (file_name[file_name_length - 1] == '/') {
-        if (mkdir(file_name, 0755) < 0) {
-            perror("mkdir");
+    Crypto::Checksum::CRC32 checksum;
+    size_t total_size = 0;
+    auto write_contents = [&](ReadonlyBytes bytes) {
+        checksum.update(bytes);
+        total_size += bytes.size();
+        if (!new_file->write(bytes.data(), bytes.size())) {
+            warnln("Can't write file contents in {}: {}", entry.name, new_file->error_string());
             return false;
         }
-    } else {
-        auto new_file = Core::File::construct(String { file_name });
-        if (!new_file->open(Core::IODevice::WriteOnly)) {
-            fprintf(stderr, "Can't write file %s: %s\n", file_name, new_file->error_string());
-            return false;
-        }
-
-        printf(" extracting: %s\n", file_name);
-        u8 raw_file_contents[compressed_file_size];
-        if (!seek_and_read(raw_file_contents, file, local_file_header_index + LFHFileNameBaseOffset + file_name_length + extra_field_length, compressed_file_size))
-            return false;
+        return true;
+    };
 
-        // FIXME: Try to uncompress data here. We're just ignoring it as no decompression methods are implemented yet.
-        if (!new_file->write(raw_file_contents, compressed_file_size)) {
-            fprintf(stderr, "Can't write file contents in %s: %s\n", file_name, new_file->error_string());
+    if (entry.compression_method == CompressionMethod::None) {
+        if (!write_contents(compressed_contents))
             return false;
+    } else {
+        // Decompress in chunks, so memory use doesn't depend on the size of the file.
+        InputMemoryStream memory_stream { compressed_contents };
+        Compress::DeflateDecompressor deflate_stream { memory_stream };
+        u8 buffer[16 * KiB];
+        while (!deflate_stream.unreliable_eof()) {
+            auto nread = deflate_stream.read({ buffer, sizeof(buffer) });
+            if (deflate_stream.handle_any_error()) {
+                warnln("Contents of {} are corrupted", entry.name);
+                return false;
+            }
+            if (!write_contents({ buffer, nread }))
+                return false;
         }
+        memory_stream.handle_any_error();
+    }
 
-        if (!new_file->close()) {
-            fprintf(stderr, "Can't close file %s: %s\n", file_name, new_file->error_string());
-            return false;
-        }
+    if (checksum.digest() != entry.crc32 || total_size != entry.uncompressed_size) {
+        warnln("Checksum mismatch in {}", entry.name);
+        return false;
     }
 
+    if (!new_file->close()) {
+        warnln("Can't close file {}: {}", entry.name, new_file->error_string());
+        return false;
+    }
     return true;
 }
 
@@ -186,18 +292,61 @@ int main(int argc, char** argv)
         warnln("Failed to open {}: {}", zip_file_path, file_or_error.error());
         return 1;
     }
-    auto& mapped_file = *file_or_error.value();
+    auto archive = file_or_error.value()->bytes();
 
     printf("Archive: %s\n", zip_file_path.characters());
 
-    off_t index = 0;
-    while (find_next_central_directory(st.st_size, mapped_file, index, index)) {
-        bool success = unpack_file_for_central_directory_index(index, mapped_file);
-        if (!success) {
-            printf("Could not find local file header for a file.\n");
+    auto entries_or_error = read_central_directory(archive);
+    if (!entries_or_error.has_value()) {
+        printf("Could not find the central directory.\n");
+        return 4;
+    }
+    auto& entries = entries_or_error.value();
+
+    // Create all directories up front, so files can be extracted in any order.
+    Vector<const Entry*> files;
+    for (auto& entry : entries) {
+        if (!is_safe_path(entry.name)) {
+            warnln("Refusing to extract {}", entry.name);
             return 4;
         }
+        if (!create_parent_directories(entry.name))
+            return 4;
+        if (entry.is_directory()) {
+            if (!create_directory(entry.name))
+                return 4;
+        } else {
+            files.append(&entry);
+        }
+    }
+
+    // Entries are compressed independently of each other, so we can extract them on all cores at once.
+    Atomic<size_t> next_file_index { 0 };
+    Atomic<bool> failed { false };
+    auto extract_files = [&] {
+        for (;;) {
+            size_t index = next_file_index.fetch_add(1);
+            if (index >= files.size())
+                return;
+            if (!extract_file(*files[index], archive))
+                failed.store(true);
+        }
+    };
+
+    long processor_count = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t thread_count = min((size_t)max(processor_count, 1l), files.size());
+    NonnullRefPtrVector<LibThread::Thread> threads;
+    for (size_t i = 1; i < thread_count; ++i) {
+        threads.append(LibThread::Thread::construct([&extract_files] {
+            extract_files();
+            return 0;
+        },
+            "Unzip"));
+        threads.last().start();
     }
+    extract_files();
+    for (auto& thread : threads)
+        [[maybe_unused]] auto result = thread.join();
 
-    return 0;
+    return failed.load() ? 4 : 0;
 }
@@ -74,7 +74,7 @@ static Count get_count(const String& file_specifier)
     }
 
     bool start_a_new_word = true;
-    for (int ch = fgetc(file_pointer); ch != EOF; ch = fgetc(file_pointer)) {
+    for (int ch = getc_unlocked(file_pointer); ch != EOF; ch = getc_unlocked(file_pointer)) {
         count.bytes++;
         if (isspace(ch)) {
             start_a_new_word = true;